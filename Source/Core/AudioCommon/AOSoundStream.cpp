@@ -7,12 +7,14 @@
 
 #include "AOSoundStream.h"
 #include "Mixer.h"
+#include "ThreadPlacement.h"
 
 #if defined(HAVE_AO) && HAVE_AO
 
 void AOSound::SoundLoop()
 {
 	Common::SetCurrentThreadName("Audio thread - ao");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	uint_32 numBytesToRender = 256;
 	ao_initialize();
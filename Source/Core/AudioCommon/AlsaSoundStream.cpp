@@ -6,6 +6,7 @@
 
 #include "Common.h"
 #include "Thread.h"
+#include "ThreadPlacement.h"
 #include "AlsaSoundStream.h"
 
 #define FRAME_COUNT_MIN 256
@@ -48,6 +49,7 @@ void AlsaSound::SoundLoop()
 		return;
 	}
 	Common::SetCurrentThreadName("Audio thread - alsa");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 	while (!thread_data)
 	{
 		m_mixer->Mix(reinterpret_cast<short *>(mix_buffer), frames_to_deliver);
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "AudioCommon.h"
 #include "FileUtil.h"
 #include "Mixer.h"
@@ -66,7 +68,7 @@ namespace AudioCommon
 			{
 				if (SConfig::GetInstance().m_DumpAudio)
 				{
-					std::string audio_file_name = File::GetUserPath(D_DUMPAUDIO_IDX) + "audiodump.wav";
+					std::string audio_file_name = File::GetUserPath(D_DUMPAUDIO_IDX) + (SConfig::GetInstance().m_DumpAudioFLAC ? "audiodump.flac" : "audiodump.wav");
 					File::CreateFullPath(audio_file_name);
 					mixer->StartLogAudio(audio_file_name.c_str());
 				}
@@ -156,8 +158,11 @@ namespace AudioCommon
 	{
 		if (soundStream)
 		{
-			soundStream->GetMixer()->SetThrottle(SConfig::GetInstance().m_Framelimit == 2);
-			soundStream->SetVolume(SConfig::GetInstance().m_Volume);
+			// Movie verification runs as fast as it can, without the noise
+			const bool verifying = Movie::IsVerifying();
+			soundStream->GetMixer()->SetThrottle(SConfig::GetInstance().m_Framelimit == 2 && !verifying);
+			soundStream->GetMixer()->SetTargetLatency(std::max(SConfig::GetInstance().m_AudioTargetLatency, 1));
+			soundStream->SetVolume(verifying ? 0 : SConfig::GetInstance().m_Volume);
 		}
 	}
 }
@@ -0,0 +1,177 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "AudioStretcher.h"
+
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define STRETCH_SIMD_SSE
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STRETCH_SIMD_NEON
+#endif
+
+// Tempos this close to 1 are played unstretched
+static const float PASSTHROUGH_TOLERANCE = 0.02f;
+
+static float DotProduct(const float* a, const float* b, u32 count)
+{
+	u32 i = 0;
+	float sum = 0.0f;
+
+#if defined(STRETCH_SIMD_SSE)
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	for (; i + 8 <= count; i += 8)
+	{
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+	sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(STRETCH_SIMD_NEON)
+	float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+	for (; i + 8 <= count; i += 8)
+	{
+		acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+		acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+	}
+	const float32x4_t acc = vaddq_f32(acc0, acc1);
+	sum = (vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1)) + (vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3));
+#endif
+
+	for (; i < count; ++i)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+AudioStretcher::AudioStretcher(unsigned int sample_rate)
+	: m_sample_rate(sample_rate)
+	, m_tempo(1.0f)
+	, m_position(0.0)
+	, m_continuation(0)
+	, m_stretching(false)
+{
+	SetWindow(10);
+}
+
+void AudioStretcher::SetWindow(unsigned int ms)
+{
+	m_segment = std::max<u32>(m_sample_rate * ms / 1000, 64);
+	m_overlap = m_segment / 4;
+	m_seek = m_segment / 4;
+}
+
+void AudioStretcher::SetTempo(float tempo)
+{
+	m_tempo = std::min(std::max(tempo, 0.1f), 10.0f);
+	m_stretching = std::abs(m_tempo - 1.0f) > PASSTHROUGH_TOLERANCE;
+}
+
+void AudioStretcher::PutSamples(const float* samples, u32 num_samples)
+{
+	m_input.insert(m_input.end(), samples, samples + num_samples * 2);
+	ProcessSegments();
+}
+
+u32 AudioStretcher::ReceiveSamples(float* out, u32 max_samples)
+{
+	const u32 count = std::min<u32>((u32)(m_output.size() / 2), max_samples);
+	memcpy(out, m_output.data(), count * 2 * sizeof(float));
+	m_output.erase(m_output.begin(), m_output.begin() + count * 2);
+	return count;
+}
+
+void AudioStretcher::Clear()
+{
+	m_input.clear();
+	m_output.clear();
+	m_position = 0.0;
+	m_continuation = 0;
+}
+
+// The offset within [start, start + count) whose first m_overlap sample pairs
+// are the most similar to the ones at m_continuation
+u32 AudioStretcher::FindBestOffset(u32 start, u32 count) const
+{
+	const u32 length = m_overlap * 2;
+	const float* reference = &m_input[m_continuation * 2];
+
+	float energy = DotProduct(&m_input[start * 2], &m_input[start * 2], length);
+	u32 best = start;
+	float best_score = -1e30f;
+	for (u32 offset = start; offset < start + count; ++offset)
+	{
+		const float* candidate = &m_input[offset * 2];
+		const float correlation = DotProduct(reference, candidate, length);
+		// Normalized on the candidate only, the reference is the same for all
+		const float score = correlation / std::sqrt(std::max(energy, 1e-9f));
+		if (score > best_score)
+		{
+			best_score = score;
+			best = offset;
+		}
+
+		// Slide the energy window along by one pair
+		const float* leaving = candidate;
+		const float* entering = candidate + length;
+		energy += entering[0] * entering[0] + entering[1] * entering[1]
+		        - leaving[0] * leaving[0] - leaving[1] * leaving[1];
+	}
+	return best;
+}
+
+void AudioStretcher::ProcessSegments()
+{
+	if (!m_stretching)
+	{
+		// Resume right where the last segment would have continued
+		m_output.insert(m_output.end(), m_input.begin() + m_continuation * 2, m_input.end());
+		m_input.clear();
+		m_position = 0.0;
+		m_continuation = 0;
+		return;
+	}
+
+	const u32 available = (u32)(m_input.size() / 2);
+	const u32 hop = m_segment - m_overlap;
+	for (;;)
+	{
+		const u32 nominal = (u32)m_position;
+		const u32 start = nominal > m_seek ? nominal - m_seek : 0;
+		const u32 end = nominal + m_seek;
+		if (end + m_segment > available)
+			break;
+
+		const u32 offset = FindBestOffset(start, end - start + 1);
+
+		const size_t out_pos = m_output.size();
+		m_output.resize(out_pos + hop * 2);
+		float* dst = &m_output[out_pos];
+		const float* from = &m_input[m_continuation * 2];
+		const float* to = &m_input[offset * 2];
+
+		for (u32 i = 0; i < m_overlap * 2; i += 2)
+		{
+			const float weight = (i / 2 + 0.5f) / m_overlap;
+			dst[i] = from[i] + (to[i] - from[i]) * weight;
+			dst[i + 1] = from[i + 1] + (to[i + 1] - from[i + 1]) * weight;
+		}
+		memcpy(dst + m_overlap * 2, to + m_overlap * 2, (hop - m_overlap) * 2 * sizeof(float));
+
+		m_continuation = offset + hop;
+		m_position += hop * m_tempo;
+	}
+
+	// Drop what neither the crossfade nor the next search can reach
+	const u32 nominal = (u32)m_position;
+	const u32 consumed = std::min(m_continuation, nominal > m_seek ? nominal - m_seek : 0);
+	m_input.erase(m_input.begin(), m_input.begin() + consumed * 2);
+	m_continuation -= consumed;
+	m_position -= consumed;
+}
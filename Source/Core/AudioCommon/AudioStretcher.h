@@ -0,0 +1,61 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "CommonTypes.h"
+
+// Changes the tempo of interleaved stereo float samples without changing their
+// pitch, so that the audio of an emulation running below or above full speed
+// stays in sync instead of stuttering.
+//
+// This is a WSOLA stretcher: the output is assembled from segments of one
+// window length taken from the input, each one chosen within a small search
+// range around its nominal position so that it best continues the previous
+// one, and crossfaded into it. It holds back less than one and a half
+// windows of samples, and passes the samples through untouched while the
+// tempo is close to 1.
+class AudioStretcher
+{
+public:
+	AudioStretcher(unsigned int sample_rate);
+
+	// Length of a segment, a shorter window reduces the latency but makes
+	// low tempos sound rougher
+	void SetWindow(unsigned int ms);
+
+	// 1.0 is unchanged, 0.5 plays the samples at half their speed
+	void SetTempo(float tempo);
+
+	void PutSamples(const float* samples, u32 num_samples);
+	// Returns the number of sample pairs written, up to max_samples
+	u32 ReceiveSamples(float* out, u32 max_samples);
+
+	void Clear();
+
+private:
+	void ProcessSegments();
+	u32 FindBestOffset(u32 start, u32 count) const;
+
+	unsigned int m_sample_rate;
+	float m_tempo;
+
+	// In sample pairs
+	u32 m_segment;
+	u32 m_overlap;
+	u32 m_seek;
+
+	// Interleaved input not consumed yet and output not received yet
+	std::vector<float> m_input;
+	std::vector<float> m_output;
+
+	// Nominal input position of the next segment, relative to m_input
+	double m_position;
+	// Where the previous segment would have continued, the next one is
+	// crossfaded from there
+	u32 m_continuation;
+	bool m_stretching;
+};
@@ -15,6 +15,12 @@
 #include "DPL2Decoder.h"
 #include "MathUtil.h"
 
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -30,47 +36,50 @@ float l_fwr, r_fwr, lpr_fwr, lmr_fwr;
 std::vector<float> fwrbuf_l, fwrbuf_r;
 float adapt_l_gain, adapt_r_gain, adapt_lpr_gain, adapt_lmr_gain;
 std::vector<float> lf, rf, lr, rr, cf, cr;
-float LFE_buf[256];
+// The LFE history is stored twice in a row, so that the filter window starting
+// at any position is contiguous
+float LFE_buf[256 * 2];
 unsigned int lfe_pos;
 float *filter_coefs_lfe;
 unsigned int len125;
 
-template<class T,class _ftype_t> static _ftype_t dotproduct(int count,const T *buf,const _ftype_t *coefficients)
+static float dotproduct(int count, const float *buf, const float *coefficients)
 {
-	float sum0=0,sum1=0,sum2=0,sum3=0;
-	for (;count>=4;buf+=4,coefficients+=4,count-=4)
+	int i = 0;
+	float sum;
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+	for (; i + 8 <= count; i += 8)
 	{
-		sum0+=buf[0]*coefficients[0];
-		sum1+=buf[1]*coefficients[1];
-		sum2+=buf[2]*coefficients[2];
-		sum3+=buf[3]*coefficients[3];
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(buf + i), _mm_loadu_ps(coefficients + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(buf + i + 4), _mm_loadu_ps(coefficients + i + 4)));
 	}
-	while (count--) sum0+= *buf++ * *coefficients++;
-	return sum0+sum1+sum2+sum3;
-}
-
-template<class T> static T firfilter(const T *buf, int pos, int len, int count, const float *coefficients)
-{
-	int count1, count2;
-
-	if (pos >= count)
+	float sums[4];
+	_mm_storeu_ps(sums, _mm_add_ps(sum0, sum1));
+	sum = sums[0] + sums[1] + sums[2] + sums[3];
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+	float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f);
+	for (; i + 8 <= count; i += 8)
 	{
-		pos -= count;
-		count1 = count; count2 = 0;
+		sum0 = vmlaq_f32(sum0, vld1q_f32(buf + i), vld1q_f32(coefficients + i));
+		sum1 = vmlaq_f32(sum1, vld1q_f32(buf + i + 4), vld1q_f32(coefficients + i + 4));
 	}
-	else
+	const float32x4_t sums = vaddq_f32(sum0, sum1);
+	sum = vgetq_lane_f32(sums, 0) + vgetq_lane_f32(sums, 1) + vgetq_lane_f32(sums, 2) + vgetq_lane_f32(sums, 3);
+#else
+	float sum0=0,sum1=0,sum2=0,sum3=0;
+	for (;i+4<=count;i+=4)
 	{
-		count2 = pos;
-		count1 = count - pos;
-		pos = len - count1;
+		sum0+=buf[i+0]*coefficients[i+0];
+		sum1+=buf[i+1]*coefficients[i+1];
+		sum2+=buf[i+2]*coefficients[i+2];
+		sum3+=buf[i+3]*coefficients[i+3];
 	}
-
-	// high part of window
-	const T *ptr = &buf[pos];
-
-	float r1=dotproduct(count1,ptr,coefficients);coefficients+=count1;
-	float r2=dotproduct(count2,buf,coefficients);
-	return T(r1+r2);
+	sum = sum0+sum1+sum2+sum3;
+#endif
+	for (; i < count; ++i)
+		sum += buf[i] * coefficients[i];
+	return sum;
 }
 
 /*
@@ -332,7 +341,10 @@ void dpl2decode(float *samples, int numsamples, float *out)
 	{
 		const int k = cyc_pos;
 
-		const int fwr_pos = (k + FWRDURATION) % dlbuflen;
+		// FWRDURATION is at most dlbuflen, one wrap is enough
+		int fwr_pos = k + FWRDURATION;
+		if (fwr_pos >= (int)dlbuflen)
+			fwr_pos -= dlbuflen;
 		/* Update the full wave rectified total amplitude */
 		/* Input matrix decoder */
 		l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
@@ -353,8 +365,8 @@ void dpl2decode(float *samples, int numsamples, float *out)
 		out[cur + 0] = lf[k];
 		out[cur + 1] = rf[k];
 		out[cur + 2] = cf[k];
-		LFE_buf[lfe_pos] = (out[0] + out[1]) / 2;
-		out[cur + 3] = firfilter(LFE_buf, lfe_pos, len125, len125, filter_coefs_lfe);
+		LFE_buf[lfe_pos] = LFE_buf[lfe_pos + len125] = (out[cur + 0] + out[cur + 1]) / 2;
+		out[cur + 3] = dotproduct(len125, &LFE_buf[lfe_pos], filter_coefs_lfe);
 		lfe_pos++;
 		if (lfe_pos == len125)
 		{
@@ -9,6 +9,7 @@
 
 #include "AudioCommon.h"
 #include "DSoundStream.h"
+#include "ThreadPlacement.h"
 
 bool DSound::CreateBuffer()
 {
@@ -83,6 +84,7 @@ bool DSound::WriteDataToBuffer(DWORD dwOffset,                  // Our own write
 void DSound::SoundLoop()
 {
 	Common::SetCurrentThreadName("Audio thread - dsound");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	currentPos = 0;
 	lastPos = 0;
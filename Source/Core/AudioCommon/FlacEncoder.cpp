@@ -0,0 +1,294 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "Common.h"
+#include "FlacEncoder.h"
+
+// Bits of the partition order field limit it to 15, more than 256 partitions
+// would never pay for their parameters with 4096 sample blocks though
+static const int MAX_PARTITION_ORDER = 8;
+static const int MAX_RICE_PARAMETER = 14;
+static const int BITS_PER_SAMPLE = 16;
+
+static u8 Crc8(const u8* data, size_t size)
+{
+	u8 crc = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; ++bit)
+			crc = (crc & 0x80) ? (u8)((crc << 1) ^ 0x07) : (u8)(crc << 1);
+	}
+	return crc;
+}
+
+static u16 Crc16(const u8* data, size_t size)
+{
+	u16 crc = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc ^= (u16)data[i] << 8;
+		for (int bit = 0; bit < 8; ++bit)
+			crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x8005) : (u16)(crc << 1);
+	}
+	return crc;
+}
+
+FlacEncoder::FlacEncoder()
+	: m_bit_buffer(0)
+	, m_bit_count(0)
+	, m_sample_rate(0)
+	, m_frame_number(0)
+	, m_total_samples(0)
+{
+	m_channels[0].resize(BLOCK_SIZE);
+	m_channels[1].resize(BLOCK_SIZE);
+	m_residual.resize(BLOCK_SIZE);
+	m_frame.reserve(BLOCK_SIZE * 2 * 3);
+}
+
+void FlacEncoder::PutBits(u32 value, int bits)
+{
+	if (!bits)
+		return;
+
+	m_bit_buffer = (m_bit_buffer << bits) | (value & (u32)((1ull << bits) - 1));
+	m_bit_count += bits;
+	while (m_bit_count >= 8)
+	{
+		m_bit_count -= 8;
+		m_frame.push_back((u8)(m_bit_buffer >> m_bit_count));
+	}
+}
+
+void FlacEncoder::PutSigned(s32 value, int bits)
+{
+	PutBits((u32)value, bits);
+}
+
+void FlacEncoder::PutRice(u32 value, int k)
+{
+	u32 quotient = value >> k;
+	for (; quotient >= 32; quotient -= 32)
+		PutBits(0, 32);
+	PutBits(1, quotient + 1);
+	PutBits(value, k);
+}
+
+void FlacEncoder::AlignToByte()
+{
+	if (m_bit_count)
+		PutBits(0, 8 - m_bit_count);
+}
+
+bool FlacEncoder::Start(File::IOFile& file, u32 sample_rate)
+{
+	m_sample_rate = sample_rate;
+	m_frame_number = 0;
+	m_total_samples = 0;
+
+	// "fLaC" and a STREAMINFO block, the only and therefore last metadata block
+	static const u8 header[] = {
+		'f', 'L', 'a', 'C', 0x80, 0x00, 0x00, 34,
+		BLOCK_SIZE >> 8, BLOCK_SIZE & 0xFF, BLOCK_SIZE >> 8, BLOCK_SIZE & 0xFF,
+		0, 0, 0, 0, 0, 0, // frame sizes unknown
+	};
+	u8 info[8 + 16] = {}; // rate, channels, bits and length, then an unset MD5
+	const u64 packed = ((u64)sample_rate << 44) | (1ull << 41) | ((u64)(BITS_PER_SAMPLE - 1) << 36);
+	for (int i = 0; i < 8; ++i)
+		info[i] = (u8)(packed >> (56 - i * 8));
+
+	return file.WriteBytes(header, sizeof(header)) && file.WriteBytes(info, sizeof(info));
+}
+
+bool FlacEncoder::Finish(File::IOFile& file)
+{
+	const u64 packed = ((u64)m_sample_rate << 44) | (1ull << 41) | ((u64)(BITS_PER_SAMPLE - 1) << 36) |
+		(m_total_samples & 0xFFFFFFFFFull);
+	u8 info[8];
+	for (int i = 0; i < 8; ++i)
+		info[i] = (u8)(packed >> (56 - i * 8));
+
+	return file.Seek(18, SEEK_SET) && file.WriteBytes(info, sizeof(info)) && file.Seek(0, SEEK_END);
+}
+
+void FlacEncoder::EncodeSubframe(const s32* x, u32 count)
+{
+	if (std::all_of(x, x + count, [x](s32 sample) { return sample == x[0]; }))
+	{
+		// CONSTANT, mostly silence
+		PutBits(0x00, 8);
+		PutSigned(x[0], BITS_PER_SAMPLE);
+		return;
+	}
+
+	// Pick the FIXED predictor with the smallest residual
+	u64 error[5] = {};
+	for (u32 i = 4; i < count; ++i)
+	{
+		const s32 e0 = x[i];
+		const s32 e1 = e0 - x[i - 1];
+		const s32 e2 = e1 - (x[i - 1] - x[i - 2]);
+		const s32 e3 = e2 - (x[i - 1] - 2 * x[i - 2] + x[i - 3]);
+		const s32 e4 = e3 - (x[i - 1] - 3 * x[i - 2] + 3 * x[i - 3] - x[i - 4]);
+		error[0] += std::abs(e0);
+		error[1] += std::abs(e1);
+		error[2] += std::abs(e2);
+		error[3] += std::abs(e3);
+		error[4] += std::abs(e4);
+	}
+	u32 order = (u32)(std::min_element(error, error + 5) - error);
+	if (count <= 4)
+		order = 0;
+
+	for (u32 i = order; i < count; ++i)
+	{
+		s32 e;
+		switch (order)
+		{
+		case 0: e = x[i]; break;
+		case 1: e = x[i] - x[i - 1]; break;
+		case 2: e = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+		case 3: e = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+		default: e = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+		}
+		// Zigzag, so that the Rice codes only deal with unsigned values
+		m_residual[i] = (s32)(((u32)e << 1) ^ (u32)(e >> 31));
+	}
+
+	// Sizes of every Rice parameter for the smallest partitions, which add
+	// up to the sizes for the bigger ones
+	int max_order = 0;
+	while (max_order < MAX_PARTITION_ORDER && (count % (2u << max_order)) == 0 &&
+	       (count >> (max_order + 1)) > order)
+		++max_order;
+
+	const u32 partitions = 1u << max_order;
+	const u32 partition_size = count >> max_order;
+	std::vector<u64> bits(partitions * (MAX_RICE_PARAMETER + 1));
+	for (u32 p = 0; p < partitions; ++p)
+	{
+		const u32 begin = p ? p * partition_size : order;
+		const u32 end = (p + 1) * partition_size;
+		u64* partition_bits = &bits[p * (MAX_RICE_PARAMETER + 1)];
+		for (int k = 0; k <= MAX_RICE_PARAMETER; ++k)
+			partition_bits[k] = (u64)(end - begin) * (k + 1);
+		for (u32 i = begin; i < end; ++i)
+		{
+			const u32 value = (u32)m_residual[i];
+			for (int k = 0; k <= MAX_RICE_PARAMETER; ++k)
+				partition_bits[k] += value >> k;
+		}
+	}
+
+	u64 best_size = ~0ull;
+	int best_order = 0;
+	std::vector<int> best_parameters, parameters;
+	for (int partition_order = max_order; partition_order >= 0; --partition_order)
+	{
+		const u32 merged = 1u << (max_order - partition_order);
+		u64 size = 0;
+		parameters.clear();
+		for (u32 p = 0; p < (1u << partition_order); ++p)
+		{
+			u64 best_partition = ~0ull;
+			int best_k = 0;
+			for (int k = 0; k <= MAX_RICE_PARAMETER; ++k)
+			{
+				u64 partition = 4;
+				for (u32 m = 0; m < merged; ++m)
+					partition += bits[(p * merged + m) * (MAX_RICE_PARAMETER + 1) + k];
+				if (partition < best_partition)
+				{
+					best_partition = partition;
+					best_k = k;
+				}
+			}
+			size += best_partition;
+			parameters.push_back(best_k);
+		}
+
+		if (size < best_size)
+		{
+			best_size = size;
+			best_order = partition_order;
+			best_parameters = parameters;
+		}
+	}
+
+	// FIXED with the chosen order, no wasted bits
+	PutBits(0x10 | (order << 1), 8);
+	for (u32 i = 0; i < order; ++i)
+		PutSigned(x[i], BITS_PER_SAMPLE);
+
+	// Rice coding with 4 bit parameters
+	PutBits(0, 2);
+	PutBits(best_order, 4);
+	const u32 size = count >> best_order;
+	for (u32 p = 0; p < (1u << best_order); ++p)
+	{
+		const int k = best_parameters[p];
+		PutBits(k, 4);
+		for (u32 i = p ? p * size : order; i < (p + 1) * size; ++i)
+			PutRice((u32)m_residual[i], k);
+	}
+}
+
+bool FlacEncoder::EncodeBlock(File::IOFile& file, const s16* samples, u32 count)
+{
+	if (!count)
+		return true;
+
+	_assert_(count <= BLOCK_SIZE);
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		m_channels[0][i] = samples[i * 2];
+		m_channels[1][i] = samples[i * 2 + 1];
+	}
+
+	m_frame.clear();
+	m_bit_buffer = 0;
+	m_bit_count = 0;
+
+	// Frame header: fixed block size, block size in a 16 bit field after the
+	// header, sample rate from STREAMINFO, independent stereo, 16 bits
+	PutBits(0xFFF8, 16);
+	PutBits(0x70, 8);
+	PutBits(0x18, 8);
+
+	// The frame number, in the extended UTF-8 encoding
+	const u32 n = m_frame_number;
+	if (n < 0x80)
+	{
+		PutBits(n, 8);
+	}
+	else
+	{
+		int extra = 1;
+		while (extra < 5 && n >= (1u << (6 + 5 * extra)))
+			++extra;
+		const u32 lead_mask = (0xFF00u >> (extra + 1)) & 0xFF;
+		PutBits(lead_mask | (n >> (6 * extra)), 8);
+		for (int i = extra - 1; i >= 0; --i)
+			PutBits(0x80 | ((n >> (6 * i)) & 0x3F), 8);
+	}
+
+	PutBits(count - 1, 16);
+	PutBits(Crc8(m_frame.data(), m_frame.size()), 8);
+
+	EncodeSubframe(m_channels[0].data(), count);
+	EncodeSubframe(m_channels[1].data(), count);
+
+	AlignToByte();
+	const u16 crc = Crc16(m_frame.data(), m_frame.size());
+	PutBits(crc, 16);
+
+	++m_frame_number;
+	m_total_samples += count;
+	return file.WriteBytes(m_frame.data(), m_frame.size());
+}
@@ -0,0 +1,49 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "CommonTypes.h"
+#include "FileUtil.h"
+
+// Minimal FLAC encoder for 16 bit stereo: every block of up to BLOCK_SIZE
+// sample pairs becomes one frame with two independent FIXED subframes, using
+// the fixed predictor order and Rice partitioning that need the fewest bits.
+// That compresses game audio about as well as "flac -1" without any of the
+// LPC analysis, so it is cheap enough to run while recording.
+class FlacEncoder
+{
+public:
+	enum { BLOCK_SIZE = 4096 };
+
+	FlacEncoder();
+
+	// Writes the stream header, the total length is filled in by Finish()
+	bool Start(File::IOFile& file, u32 sample_rate);
+	// Encodes up to BLOCK_SIZE little endian sample pairs, only the last
+	// block of a stream may be shorter
+	bool EncodeBlock(File::IOFile& file, const s16* samples, u32 count);
+	bool Finish(File::IOFile& file);
+
+private:
+	void PutBits(u32 value, int bits);
+	void PutSigned(s32 value, int bits);
+	void PutRice(u32 value, int k);
+	void AlignToByte();
+
+	void EncodeSubframe(const s32* channel, u32 count);
+
+	std::vector<u8> m_frame;
+	u64 m_bit_buffer;
+	int m_bit_count;
+
+	std::vector<s32> m_channels[2];
+	std::vector<s32> m_residual;
+
+	u32 m_sample_rate;
+	u32 m_frame_number;
+	u64 m_total_samples;
+};
@@ -2,7 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include "Atomic.h"
+#include <algorithm>
+
 #include "Mixer.h"
 #include "AudioCommon.h"
 #include "CPUDetect.h"
@@ -25,9 +26,11 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 	if (!samples)
 		return 0;
 
-	std::lock_guard<std::mutex> lk(m_csMixing);
+	// Don't stall the audio thread while the emulation is paused and locked,
+	// playing silence instead is what it would get after the pause anyway
+	std::unique_lock<std::mutex> lk(m_csMixing, std::try_to_lock);
 
-	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+	if (!lk.owns_lock() || PowerPC::GetState() != PowerPC::CPU_RUNNING)
 	{
 		// Silence
 		memset(samples, 0, numSamples * 4);
@@ -36,24 +39,18 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 
 	unsigned int currentSample = 0;
 
-	// Cache access in non-volatile variable
-	// This is the only function changing the read value, so it's safe to
-	// cache it locally although it's written here.
-	// The writing pointer will be modified outside, but it will only increase,
-	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
-	u32 indexR = Common::AtomicLoad(m_indexR);
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
-	float numLeft = ((indexW - indexR) & INDEX_MASK) / 2;
+	// The producer only ever adds samples, so anything pushed while
+	// interpolating is simply left for the next call.
+	const u32 available = m_samples.Size();
+
+	float numLeft = available / 2;
 	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG-1)) / CONTROL_AVG;
-	float offset = (m_numLeftI - LOW_WATERMARK) * CONTROL_FACTOR;
+	float offset = (m_numLeftI - GetLowWatermark()) * CONTROL_FACTOR;
 	if(offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if(offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
 	//render numleft sample pairs to samples[]
-	//advance indexR with sample position
+	//advance the read position with sample position
 	//remember fractional offset
 
 	u32 framelimit = SConfig::GetInstance().m_Framelimit;
@@ -63,42 +60,44 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 		aid_sample_rate = aid_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	static u32 frac = 0;
+	u32 frac = m_frac;
 	const u32 ratio = (u32)( 65536.0f * aid_sample_rate / (float)m_sampleRate );
 
 	if(ratio > 0x10000)
 		ERROR_LOG(AUDIO, "ratio out of range");
 
-	for (; currentSample < numSamples*2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample+=2) {
-		u32 indexR2 = indexR + 2; //next sample
-
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
+	u32 pos = 0;
+	for (; currentSample < numSamples*2 && pos + 2 < available; currentSample+=2) {
+		s16 l1 = Common::swap16(m_samples.Peek(pos)); //current
+		s16 l2 = Common::swap16(m_samples.Peek(pos + 2)); //next
 		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
 		samples[currentSample+1] = sampleL;
 
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
+		s16 r1 = Common::swap16(m_samples.Peek(pos + 1)); //current
+		s16 r2 = Common::swap16(m_samples.Peek(pos + 3)); //next
 		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)frac)  >> 16;
 		samples[currentSample] = sampleR;
 
 		frac += ratio;
-		indexR += 2 * (u16)(frac >> 16);
+		pos += 2 * (u16)(frac >> 16);
 		frac &= 0xffff;
 	}
+	m_frac = frac;
 
-	// Padding
-	unsigned short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
+	// Padding, with the last pair that was stepped over
+	pos = std::min(pos, available);
+	if (pos >= 2)
+	{
+		m_padding[0] = Common::swap16(m_samples.Peek(pos - 1));
+		m_padding[1] = Common::swap16(m_samples.Peek(pos - 2));
+	}
 	for (; currentSample < numSamples*2; currentSample+=2)
 	{
-		samples[currentSample] = s[0];
-		samples[currentSample+1] = s[1];
+		samples[currentSample] = m_padding[0];
+		samples[currentSample+1] = m_padding[1];
 	}
 
-	// Flush cached variable
-	Common::AtomicStore(m_indexR, indexR);
+	m_samples.Discard(pos);
 
 	// Add the DSPHLE sound, re-sampling is done inside
 	Premix(samples, numSamples);
@@ -113,17 +112,22 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 }
 
 
-void CMixer::PushSamples(const short *samples, unsigned int num_samples)
+unsigned int CMixer::GetLowWatermark() const
 {
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
+	const u64 pairs = (u64)AudioInterface::GetAIDSampleRate() * m_target_latency / 1000;
+	return (unsigned int)std::max<u64>(std::min<u64>(pairs, MAX_SAMPLES * 3 / 4), 32);
+}
 
+void CMixer::PushSamples(const short *samples, unsigned int num_samples)
+{
 	if (m_throttle)
 	{
 		// The auto throttle function. This loop will put a ceiling on the CPU MHz.
-		while (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+		// It holds the emulation back once the target fill level is reached
+		// rather than when the ring is full, so that audio throttling doesn't
+		// add the whole ring to the latency.
+		const unsigned int limit = std::max(std::min(GetLowWatermark() * 3 / 2, (unsigned int)MAX_SAMPLES), num_samples) * 2;
+		while (num_samples * 2 + m_samples.Size() > limit)
 		{
 			if (*PowerPC::GetStatePtr() != PowerPC::CPU_RUNNING || soundStream->IsMuted())
 				break;
@@ -135,27 +139,9 @@ void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 		}
 	}
 
-	// Check if we have enough free space
-	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
-		return;
-
 	// AyuanX: Actual re-sampling work has been moved to sound thread
 	// to alleviate the workload on main thread
-	// and we simply store raw data here to make fast mem copy
-	int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0)
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
-		memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
-	}
-	else
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
-	}
-
-	Common::AtomicAdd(m_indexW, num_samples * 2);
-
-	return;
+	// and we simply store raw data here to make fast mem copy.
+	// Samples that don't fit are dropped.
+	m_samples.Push(samples, num_samples * 2);
 }
-
@@ -4,14 +4,14 @@
 
 #pragma once
 
-#include "WaveFile.h"
+#include "SPSCRing.h"
 #include "StdMutex.h"
+#include "WaveFile.h"
 
 // 16 bit Stereo
 #define MAX_SAMPLES     (1024 * 2) // 64ms
-#define INDEX_MASK      (MAX_SAMPLES * 2 - 1)
 
-#define LOW_WATERMARK   1280 // 40 ms
+#define LOW_WATERMARK   40   // default fill level in ms the resampler aims for
 #define MAX_FREQ_SHIFT  200  // per 32000 Hz
 #define CONTROL_FACTOR  0.2  // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
@@ -26,15 +26,16 @@ public:
 		, m_channels(2)
 		, m_HLEready(false)
 		, m_logAudio(0)
-		, m_indexW(0)
-		, m_indexR(0)
+		, m_throttle(false)
+		, m_target_latency(LOW_WATERMARK)
 		, m_numLeftI(0.0f)
+		, m_frac(0)
 	{
 		// AyuanX: The internal (Core & DSP) sample rate is fixed at 32KHz
 		// So when AI/DAC sample rate differs than 32KHz, we have to do re-sampling
 		m_sampleRate = BackendSampleRate;
 
-		memset(m_buffer, 0, sizeof(m_buffer));
+		m_padding[0] = m_padding[1] = 0;
 
 		INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized (AISampleRate:%i, DACSampleRate:%i)", AISampleRate, DACSampleRate);
 	}
@@ -50,6 +51,9 @@ public:
 	unsigned int GetSampleRate() const {return m_sampleRate;}
 
 	void SetThrottle(bool use) { m_throttle = use;}
+	// How many milliseconds of samples to keep queued, lower values cut the
+	// latency but underrun sooner when the emulation speed varies
+	void SetTargetLatency(unsigned int ms) { m_target_latency = ms; }
 
 	// TODO: do we need this
 	bool IsHLEReady() const { return m_HLEready;}
@@ -97,14 +101,22 @@ protected:
 
 	bool m_throttle;
 
-	short m_buffer[MAX_SAMPLES * 2];
-	volatile u32 m_indexW;
-	volatile u32 m_indexR;
+	volatile unsigned int m_target_latency;
+
+	// Interleaved big endian samples, pushed by the emulation and popped by
+	// the audio thread without taking a lock
+	Common::SPSCRing<short, MAX_SAMPLES * 2> m_samples;
 
+	// Held by Mix(), and by PauseAndLock() to keep the audio thread away
+	// while the emulation state changes
 	std::mutex m_csMixing;
 	float m_numLeftI;
+	u32 m_frac;
+	short m_padding[2];
 
 	volatile float m_speed; // Current rate of the emulation (1.0 = 100% speed)
 private:
+	// The target fill level in sample pairs
+	unsigned int GetLowWatermark() const;
 
 };
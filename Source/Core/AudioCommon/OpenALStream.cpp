@@ -5,11 +5,10 @@
 #include "aldlist.h"
 #include "OpenALStream.h"
 #include "DPL2Decoder.h"
+#include "ThreadPlacement.h"
 
 #if defined HAVE_OPENAL && HAVE_OPENAL
 
-soundtouch::SoundTouch soundTouch;
-
 //
 // AyuanX: Spec says OpenAL1.1 is thread safe already
 //
@@ -62,7 +61,7 @@ bool OpenALStream::Start()
 	// Initialize DPL2 parameters
 	dpl2reset();
 
-	soundTouch.clear();
+	m_stretcher.Clear();
 	return bReturn;
 }
 
@@ -72,7 +71,7 @@ void OpenALStream::Stop()
 	// kick the thread if it's waiting
 	soundSyncEvent.Set();
 
-	soundTouch.clear();
+	m_stretcher.Clear();
 
 	thread.join();
 
@@ -111,7 +110,7 @@ void OpenALStream::Clear(bool mute)
 
 	if(m_muted)
 	{
-		soundTouch.clear();
+		m_stretcher.Clear();
 		alSourceStop(uiSource);
 	}
 	else
@@ -123,6 +122,7 @@ void OpenALStream::Clear(bool mute)
 void OpenALStream::SoundLoop()
 {
 	Common::SetCurrentThreadName("Audio thread - openal");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	bool surround_capable = Core::g_CoreStartupParameter.bDPL2Decoder;
 #if defined(__APPLE__)
@@ -170,14 +170,8 @@ void OpenALStream::SoundLoop()
 	ALint iState = 0;
 	ALuint uiBufferTemp[OAL_MAX_BUFFERS] = {0};
 
-	soundTouch.setChannels(2);
-	soundTouch.setSampleRate(ulFrequency);
-	soundTouch.setTempo(1.0);
-	soundTouch.setSetting(SETTING_USE_QUICKSEEK, 0);
-	soundTouch.setSetting(SETTING_USE_AA_FILTER, 0);
-	soundTouch.setSetting(SETTING_SEQUENCE_MS, 1);
-	soundTouch.setSetting(SETTING_SEEKWINDOW_MS, 28);
-	soundTouch.setSetting(SETTING_OVERLAP_MS, 12);
+	m_stretcher.SetWindow(Core::g_CoreStartupParameter.iStretchWindow);
+	m_stretcher.SetTempo(1.0f);
 
 	while (!threadData)
 	{
@@ -199,7 +193,7 @@ void OpenALStream::SoundLoop()
 		for (u32 i = 0; i < numSamples * STEREO_CHANNELS; ++i)
 			dest[i] = (float)realtimeBuffer[i] / (1 << 16);
 
-		soundTouch.putSamples(dest, numSamples);
+		m_stretcher.PutSamples(dest, numSamples);
 
 		if (iBuffersProcessed == iBuffersFilled)
 		{
@@ -220,16 +214,14 @@ void OpenALStream::SoundLoop()
 			// many silence samples.  These do not need to be timestretched.
 			if (rate > 0.10)
 			{
-				// Adjust SETTING_SEQUENCE_MS to balance between lag vs hollow audio
-				soundTouch.setSetting(SETTING_SEQUENCE_MS, (int)(1 / (rate * rate)));
-				soundTouch.setTempo(rate);
+				m_stretcher.SetTempo(rate);
 				if (rate > 10)
 				{
-					soundTouch.clear();
+					m_stretcher.Clear();
 				}
 			}
 
-			unsigned int nSamples = soundTouch.receiveSamples(sampleBuffer, OAL_MAX_SAMPLES * numBuffers);
+			unsigned int nSamples = m_stretcher.ReceiveSamples(sampleBuffer, OAL_MAX_SAMPLES * numBuffers);
 
 			if (nSamples <= minSamples)
 				continue;
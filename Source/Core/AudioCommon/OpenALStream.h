@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "AudioStretcher.h"
 #include "SoundStream.h"
 #include "Thread.h"
 
@@ -24,8 +25,6 @@
 #include "Core.h"
 #include "HW/SystemTimers.h"
 #include "HW/AudioInterface.h"
-#include <soundtouch/SoundTouch.h>
-#include <soundtouch/STTypes.h>
 
 // 16 bit Stereo
 #define SFX_MAX_SOURCE			1
@@ -47,6 +46,7 @@ public:
 	OpenALStream(CMixer *mixer, void *hWnd = NULL)
 		: SoundStream(mixer)
 		, uiSource(0)
+		, m_stretcher(mixer->GetSampleRate())
 	{}
 
 	virtual ~OpenALStream() {}
@@ -65,10 +65,11 @@ private:
 	Common::Event soundSyncEvent;
 
 	short realtimeBuffer[OAL_MAX_SAMPLES * STEREO_CHANNELS];
-	soundtouch::SAMPLETYPE sampleBuffer[OAL_MAX_SAMPLES * SURROUND_CHANNELS * OAL_MAX_BUFFERS];
+	float sampleBuffer[OAL_MAX_SAMPLES * SURROUND_CHANNELS * OAL_MAX_BUFFERS];
 	ALuint uiBuffers[OAL_MAX_BUFFERS];
 	ALuint uiSource;
 	ALfloat fVolume;
+	AudioStretcher m_stretcher;
 
 	u8 numBuffers;
 #else
@@ -6,6 +6,7 @@
 
 #include "Common.h"
 #include "Thread.h"
+#include "ThreadPlacement.h"
 
 #include "PulseAudioStream.h"
 
@@ -44,6 +45,7 @@ void PulseAudio::Update()
 void PulseAudio::SoundLoop()
 {
 	Common::SetCurrentThreadName("Audio thread - pulse");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	if (PulseInit())
 	{
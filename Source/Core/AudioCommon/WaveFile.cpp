@@ -2,30 +2,29 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <string>
+
 #include "Common.h"
 #include "WaveFile.h"
 #include "../Core/ConfigManager.h"
 
-enum {BUF_SIZE = 32*1024};
-
 WaveFileWriter::WaveFileWriter():
 	skip_silence(false),
 	audio_size(0),
-	conv_buffer(NULL)
+	current_block(nullptr),
+	dropped_samples(0),
+	stop_writer(0)
 {
 }
 
 WaveFileWriter::~WaveFileWriter()
 {
-	delete [] conv_buffer;
 	Stop();
 }
 
 bool WaveFileWriter::Start(const char *filename, unsigned int HLESampleRate)
 {
-	if (!conv_buffer)
-		conv_buffer = new short[BUF_SIZE];
-
 	// Check if the file is already open
 	if (file)
 	{
@@ -42,42 +41,95 @@ bool WaveFileWriter::Start(const char *filename, unsigned int HLESampleRate)
 
 	audio_size = 0;
 
-	// -----------------
-	// Write file header
-	// -----------------
-	Write4("RIFF");
-	Write(100 * 1000 * 1000);  // write big value in case the file gets truncated
-	Write4("WAVE");
-	Write4("fmt ");
-
-	Write(16);  // size of fmt block
-	Write(0x00020001); //two channels, uncompressed
-
-	const u32 sample_rate = HLESampleRate;
-	Write(sample_rate);
-	Write(sample_rate * 2 * 2); //two channels, 16bit
-
-	Write(0x00100004);
-	Write4("data");
-	Write(100 * 1000 * 1000 - 32);
+	const std::string name = filename;
+	if (name.size() >= 5 && !strcasecmp(name.c_str() + name.size() - 5, ".flac"))
+	{
+		flac.reset(new FlacEncoder);
+		if (!flac->Start(file, HLESampleRate))
+		{
+			PanicAlertT("The file %s could not be written.", filename);
+			flac.reset();
+			file.Close();
+			return false;
+		}
+	}
+	else
+	{
+		flac.reset();
+
+		// -----------------
+		// Write file header
+		// -----------------
+		Write4("RIFF");
+		Write(100 * 1000 * 1000);  // write big value in case the file gets truncated
+		Write4("WAVE");
+		Write4("fmt ");
+
+		Write(16);  // size of fmt block
+		Write(0x00020001); //two channels, uncompressed
+
+		const u32 sample_rate = HLESampleRate;
+		Write(sample_rate);
+		Write(sample_rate * 2 * 2); //two channels, 16bit
+
+		Write(0x00100004);
+		Write4("data");
+		Write(100 * 1000 * 1000 - 32);
+
+		// We are now at offset 44
+		if (file.Tell() != 44)
+			PanicAlert("Wrong offset: %lld", (long long)file.Tell());
+	}
 
-	// We are now at offset 44
-	if (file.Tell() != 44)
-		PanicAlert("Wrong offset: %lld", (long long)file.Tell());
+	if (!blocks)
+		blocks.reset(new Block[BUFFER_BLOCKS]);
+	free_blocks.Clear();
+	full_blocks.Clear();
+	for (int i = 0; i < BUFFER_BLOCKS; ++i)
+	{
+		Block* block = &blocks[i];
+		free_blocks.Push(&block, 1);
+	}
+	current_block = nullptr;
+	dropped_samples = 0;
+	stop_writer = 0;
+	writer_event.Reset();
+	writer_thread = std::thread(&WaveFileWriter::WriterThread, this);
 
 	return true;
 }
 
 void WaveFileWriter::Stop()
 {
-	// u32 file_size = (u32)ftello(file);
-	file.Seek(4, SEEK_SET);
-	Write(audio_size + 36);
+	if (!writer_thread.joinable())
+		return;
+
+	if (current_block && current_block->count)
+		full_blocks.Push(&current_block, 1);
+	current_block = nullptr;
 
-	file.Seek(40, SEEK_SET);
-	Write(audio_size);
+	Common::AtomicStoreRelease(stop_writer, 1);
+	writer_event.Set();
+	writer_thread.join();
+
+	if (flac)
+	{
+		flac->Finish(file);
+		flac.reset();
+	}
+	else
+	{
+		file.Seek(4, SEEK_SET);
+		Write(audio_size + 36);
+
+		file.Seek(40, SEEK_SET);
+		Write(audio_size);
+	}
 
 	file.Close();
+
+	if (dropped_samples)
+		WARN_LOG(AUDIO, "WaveFileWriter: the disk couldn't keep up, %u samples were dropped", dropped_samples);
 }
 
 void WaveFileWriter::Write(u32 value)
@@ -90,54 +142,100 @@ void WaveFileWriter::Write4(const char *ptr)
 	file.WriteBytes(ptr, 4);
 }
 
-void WaveFileWriter::AddStereoSamples(const short *sample_data, u32 count)
+void WaveFileWriter::WriterThread()
 {
-	if (!file)
-		PanicAlertT("WaveFileWriter - file not open.");
+	Common::SetCurrentThreadName("Audio dump writer");
 
-	if (skip_silence)
+	for (;;)
 	{
-		bool all_zero = true;
+		writer_event.Wait();
+		// Everything queued before the stop request is in full_blocks by now
+		const bool stopping = Common::AtomicLoadAcquire(stop_writer) != 0;
 
-		for (u32 i = 0; i < count * 2; i++)
+		Block* block;
+		while (full_blocks.Pop(&block, 1))
 		{
-			if (sample_data[i])
-				all_zero = false;
+			if (flac)
+				flac->EncodeBlock(file, block->samples, block->count);
+			else
+				file.WriteBytes(block->samples, block->count * 4);
+			audio_size += block->count * 4;
+			free_blocks.Push(&block, 1);
 		}
 
-		if (all_zero)
-			return;
+		if (stopping)
+			break;
 	}
-
-	file.WriteBytes(sample_data, count * 4);
-	audio_size += count * 4;
 }
 
-void WaveFileWriter::AddStereoSamplesBE(const short *sample_data, u32 count)
+void WaveFileWriter::Queue(const short *sample_data, u32 count, bool swap)
 {
-	if (!file)
-		PanicAlertT("WaveFileWriter - file not open.");
-
-	if (count > BUF_SIZE * 2)
-		PanicAlert("WaveFileWriter - buffer too small (count = %u).", count);
-
-	if (skip_silence)
+	while (count)
 	{
-		bool all_zero = true;
+		if (!current_block)
+		{
+			if (!free_blocks.Pop(&current_block, 1))
+			{
+				current_block = nullptr;
+				dropped_samples += count;
+				return;
+			}
+			current_block->count = 0;
+		}
 
-		for (u32 i = 0; i < count * 2; i++)
+		const u32 n = std::min<u32>(count, BLOCK_SAMPLES - current_block->count);
+		short* dst = &current_block->samples[current_block->count * 2];
+		if (swap)
 		{
-			if (sample_data[i])
-				all_zero = false;
+			for (u32 i = 0; i < n * 2; i++)
+				dst[i] = Common::swap16((u16)sample_data[i]);
+		}
+		else
+		{
+			memcpy(dst, sample_data, n * 4);
 		}
 
-		if (all_zero)
-			return;
+		current_block->count += n;
+		sample_data += n * 2;
+		count -= n;
+
+		if (current_block->count == BLOCK_SAMPLES)
+		{
+			full_blocks.Push(&current_block, 1);
+			current_block = nullptr;
+			writer_event.Set();
+		}
 	}
+}
 
+static bool IsSilence(const short *sample_data, u32 count)
+{
 	for (u32 i = 0; i < count * 2; i++)
-		conv_buffer[i] = Common::swap16((u16)sample_data[i]);
+	{
+		if (sample_data[i])
+			return false;
+	}
+	return true;
+}
+
+void WaveFileWriter::AddStereoSamples(const short *sample_data, u32 count)
+{
+	if (!file)
+		PanicAlertT("WaveFileWriter - file not open.");
+
+	if (skip_silence && IsSilence(sample_data, count))
+		return;
+
+	Queue(sample_data, count, false);
+}
+
+void WaveFileWriter::AddStereoSamplesBE(const short *sample_data, u32 count)
+{
+	if (!file)
+		PanicAlertT("WaveFileWriter - file not open.");
+
+	if (skip_silence && IsSilence(sample_data, count))
+		return;
 
-	file.WriteBytes(conv_buffer, count * 4);
-	audio_size += count * 4;
+	Queue(sample_data, count, true);
 }
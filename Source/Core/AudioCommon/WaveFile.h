@@ -10,21 +10,59 @@
 // The float variant will convert from -1.0-1.0 range and clamp.
 // Alternatively, AddSamplesBE for big endian wave data.
 // If Stop is not called when it destructs, the destructor will call Stop().
+//
+// The samples are only copied into preallocated blocks by the Add functions,
+// a writer thread encodes and writes them, so a slow disk never stalls the
+// audio thread. Should the writer fall more than BUFFER_BLOCKS behind, the
+// samples are dropped instead. A filename ending in .flac writes FLAC
+// instead of WAV.
 // ---------------------------------------------------------------------------------
 
 #pragma once
 
+#include <memory>
+
 #include "FileUtil.h"
+#include "FlacEncoder.h"
+#include "SPSCRing.h"
+#include "Thread.h"
 
 class WaveFileWriter
 {
+	enum
+	{
+		BLOCK_SAMPLES = FlacEncoder::BLOCK_SIZE,
+		BUFFER_BLOCKS = 256, // about 20 seconds at 48 kHz
+	};
+
+	struct Block
+	{
+		u32 count;
+		short samples[BLOCK_SAMPLES * 2];
+	};
+
 	File::IOFile file;
 	bool skip_silence;
 	u32 audio_size;
-	short *conv_buffer;
 	void Write(u32 value);
 	void Write4(const char *ptr);
 
+	void Queue(const short *sample_data, u32 count, bool swap);
+	void WriterThread();
+
+	std::unique_ptr<FlacEncoder> flac;
+	std::unique_ptr<Block[]> blocks;
+	// Blocks go from free_blocks to the Add functions, which fill them and
+	// pass them to the writer thread through full_blocks and get them back
+	Common::SPSCRing<Block*, BUFFER_BLOCKS> free_blocks;
+	Common::SPSCRing<Block*, BUFFER_BLOCKS> full_blocks;
+	Block *current_block;
+	u32 dropped_samples;
+
+	std::thread writer_thread;
+	Common::Event writer_event;
+	volatile u32 stop_writer;
+
 	WaveFileWriter& operator=(const WaveFileWriter&)/* = delete*/;
 
 public:
@@ -38,5 +76,6 @@ public:
 
 	void AddStereoSamples(const short *sample_data, u32 count);
 	void AddStereoSamplesBE(const short *sample_data, u32 count);  // big endian
+	// Only up to date after Stop()
 	u32 GetAudioSize() const { return audio_size; }
 };
@@ -0,0 +1,625 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include "BinaryLog.h"
+#include "Log.h"
+#include "StringUtil.h"
+#include "Timer.h"
+
+namespace BinaryLog
+{
+
+static const char BINARY_LOG_MAGIC[4] = { 'D', 'B', 'L', 'G' };
+static const u32 BINARY_LOG_VERSION = 1;
+
+enum
+{
+	TAG_STRING = 1,
+	TAG_MESSAGE,
+	TAG_DROPPED,
+};
+
+// The buffered messages are written once they take this much
+static const size_t WRITE_BUFFER_SIZE = 0x10000;
+
+enum Length
+{
+	LEN_NONE,
+	LEN_HH,
+	LEN_H,
+	LEN_L,
+	LEN_LL,
+	LEN_J,
+	LEN_Z,
+	LEN_T,
+	LEN_LONG_DOUBLE,
+};
+
+// A conversion of a printf format, the ranges point into the format
+struct Spec
+{
+	const char* flags;
+	size_t flags_size;
+	const char* width; // "*" if it is an argument
+	size_t width_size;
+	const char* precision; // NULL if there is none, "*" if it is an argument
+	size_t precision_size;
+	Length length;
+	char conversion; // 0 at the end of the format
+};
+
+static bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// p points to the '%', returns the character after the conversion
+static const char* ParseSpec(const char* p, Spec* spec)
+{
+	p++;
+	spec->flags = p;
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	spec->flags_size = p - spec->flags;
+
+	spec->width = p;
+	if (*p == '*')
+		p++;
+	else
+		while (IsDigit(*p))
+			p++;
+	spec->width_size = p - spec->width;
+
+	spec->precision = NULL;
+	spec->precision_size = 0;
+	if (*p == '.')
+	{
+		spec->precision = ++p;
+		if (*p == '*')
+			p++;
+		else
+			while (IsDigit(*p))
+				p++;
+		spec->precision_size = p - spec->precision;
+	}
+
+	spec->length = LEN_NONE;
+	switch (*p)
+	{
+	case 'h':
+		spec->length = p[1] == 'h' ? LEN_HH : LEN_H;
+		p += p[1] == 'h' ? 2 : 1;
+		break;
+	case 'l':
+		spec->length = p[1] == 'l' ? LEN_LL : LEN_L;
+		p += p[1] == 'l' ? 2 : 1;
+		break;
+	case 'q':
+		spec->length = LEN_LL;
+		p++;
+		break;
+	case 'j':
+		spec->length = LEN_J;
+		p++;
+		break;
+	case 'z':
+		spec->length = LEN_Z;
+		p++;
+		break;
+	case 't':
+		spec->length = LEN_T;
+		p++;
+		break;
+	case 'L':
+		spec->length = LEN_LONG_DOUBLE;
+		p++;
+		break;
+	case 'I': // MSVC's sizes, which PRIx64 and friends use there
+		if (p[1] == '6' && p[2] == '4')
+		{
+			spec->length = LEN_LL;
+			p += 3;
+		}
+		else if (p[1] == '3' && p[2] == '2')
+		{
+			p += 3;
+		}
+		else
+		{
+			spec->length = LEN_Z;
+			p++;
+		}
+		break;
+	}
+
+	spec->conversion = *p;
+	return *p ? p + 1 : p;
+}
+
+static bool IsStar(const char* range, size_t size)
+{
+	return size == 1 && *range == '*';
+}
+
+static s64 GetSigned(va_list& args, Length length)
+{
+	switch (length)
+	{
+	case LEN_HH: return (s8)va_arg(args, int);
+	case LEN_H: return (s16)va_arg(args, int);
+	case LEN_L: return va_arg(args, long);
+	case LEN_LL: return va_arg(args, long long);
+	case LEN_J: return va_arg(args, intmax_t);
+	case LEN_Z:
+	case LEN_T: return va_arg(args, ptrdiff_t);
+	default: return va_arg(args, int);
+	}
+}
+
+static u64 GetUnsigned(va_list& args, Length length)
+{
+	switch (length)
+	{
+	case LEN_HH: return (u8)va_arg(args, unsigned int);
+	case LEN_H: return (u16)va_arg(args, unsigned int);
+	case LEN_L: return va_arg(args, unsigned long);
+	case LEN_LL: return va_arg(args, unsigned long long);
+	case LEN_J: return va_arg(args, uintmax_t);
+	case LEN_Z:
+	case LEN_T: return va_arg(args, size_t);
+	default: return va_arg(args, unsigned int);
+	}
+}
+
+static bool PutValue(u8** pos, u8* end, u64 value)
+{
+	if (end - *pos < 8)
+		return false;
+	memcpy(*pos, &value, 8);
+	*pos += 8;
+	return true;
+}
+
+static bool GetValue(const u8** pos, const u8* end, u64* value)
+{
+	if (end - *pos < 8)
+		return false;
+	memcpy(value, *pos, 8);
+	*pos += 8;
+	return true;
+}
+
+u32 CaptureArgs(const char* format, va_list args_in, u8* out, u32 max_size)
+{
+	va_list args;
+	va_copy(args, args_in);
+
+	u8* pos = out;
+	u8* const end = out + max_size;
+	const char* p = format;
+	while (*p)
+	{
+		if (*p != '%')
+		{
+			p++;
+			continue;
+		}
+		if (p[1] == '%')
+		{
+			p += 2;
+			continue;
+		}
+
+		Spec spec;
+		p = ParseSpec(p, &spec);
+
+		if (IsStar(spec.width, spec.width_size) && !PutValue(&pos, end, (u64)(s64)va_arg(args, int)))
+			break;
+		s64 precision = -1;
+		if (spec.precision)
+		{
+			if (IsStar(spec.precision, spec.precision_size))
+			{
+				precision = va_arg(args, int);
+				if (!PutValue(&pos, end, (u64)precision))
+					break;
+			}
+			else
+			{
+				precision = atoi(std::string(spec.precision, spec.precision_size).c_str());
+			}
+		}
+
+		u64 value;
+		switch (spec.conversion)
+		{
+		case 'd': case 'i':
+			value = (u64)GetSigned(args, spec.length);
+			break;
+
+		case 'u': case 'o': case 'x': case 'X':
+			value = GetUnsigned(args, spec.length);
+			break;
+
+		case 'c':
+			value = (u64)(s64)va_arg(args, int);
+			break;
+
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+		{
+			const double d = spec.length == LEN_LONG_DOUBLE ? (double)va_arg(args, long double) : va_arg(args, double);
+			memcpy(&value, &d, 8);
+			break;
+		}
+
+		case 'p':
+			value = (u64)(uintptr_t)va_arg(args, void*);
+			break;
+
+		case 'n':
+			va_arg(args, void*);
+			continue;
+
+		case 's': case 'S':
+		{
+			const char* str;
+			if (spec.conversion == 'S' || spec.length == LEN_L)
+			{
+				va_arg(args, wchar_t*);
+				str = "(wide string)";
+			}
+			else
+			{
+				str = va_arg(args, const char*);
+				if (!str)
+					str = "(null)";
+			}
+
+			// With a precision the string doesn't need to be terminated
+			size_t length = 0;
+			while ((precision < 0 || length < (size_t)precision) && str[length])
+				length++;
+
+			if (end - pos < 2)
+				goto done;
+			length = std::min<size_t>(length, std::min<size_t>(end - pos - 2, 0xFFFF));
+			const u16 length16 = (u16)length;
+			memcpy(pos, &length16, 2);
+			memcpy(pos + 2, str, length);
+			pos += 2 + length;
+			continue;
+		}
+
+		default:
+			// Nothing after an unknown conversion can be read
+			goto done;
+		}
+
+		if (!PutValue(&pos, end, value))
+			break;
+	}
+
+done:
+	va_end(args);
+	return (u32)(pos - out);
+}
+
+std::string FormatArgs(const char* format, const u8* args, u32 args_size)
+{
+	std::string out;
+	const u8* pos = args;
+	const u8* const end = args + args_size;
+	const char* p = format;
+
+	while (*p)
+	{
+		const char* const percent = strchr(p, '%');
+		if (!percent)
+		{
+			out += p;
+			break;
+		}
+		out.append(p, percent);
+		if (percent[1] == '%')
+		{
+			out += '%';
+			p = percent + 2;
+			continue;
+		}
+
+		Spec spec;
+		const char* const next = ParseSpec(percent, &spec);
+
+		// Rebuilt with the length the value was stored with
+		std::string conversion = "%" + std::string(spec.flags, spec.flags_size);
+		u64 value;
+		if (IsStar(spec.width, spec.width_size))
+		{
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			conversion += StringFromFormat("%d", (int)value);
+		}
+		else
+		{
+			conversion.append(spec.width, spec.width_size);
+		}
+		if (spec.precision)
+		{
+			conversion += '.';
+			if (IsStar(spec.precision, spec.precision_size))
+			{
+				if (!GetValue(&pos, end, &value))
+					goto unformatted;
+				conversion += StringFromFormat("%d", (int)value);
+			}
+			else
+			{
+				conversion.append(spec.precision, spec.precision_size);
+			}
+		}
+
+		switch (spec.conversion)
+		{
+		case 'd': case 'i':
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			conversion += "ll";
+			conversion += spec.conversion;
+			out += StringFromFormat(conversion.c_str(), (long long)value);
+			break;
+
+		case 'u': case 'o': case 'x': case 'X':
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			conversion += "ll";
+			conversion += spec.conversion;
+			out += StringFromFormat(conversion.c_str(), (unsigned long long)value);
+			break;
+
+		case 'c':
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			conversion += 'c';
+			out += StringFromFormat(conversion.c_str(), (int)value);
+			break;
+
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+		{
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			double d;
+			memcpy(&d, &value, 8);
+			conversion += spec.conversion;
+			out += StringFromFormat(conversion.c_str(), d);
+			break;
+		}
+
+		case 'p':
+			if (!GetValue(&pos, end, &value))
+				goto unformatted;
+			conversion += 'p';
+			out += StringFromFormat(conversion.c_str(), (void*)(uintptr_t)value);
+			break;
+
+		case 'n':
+			break;
+
+		case 's': case 'S':
+		{
+			u16 length;
+			if (end - pos < 2)
+				goto unformatted;
+			memcpy(&length, pos, 2);
+			if (end - pos - 2 < length)
+				goto unformatted;
+			const std::string str((const char*)pos + 2, length);
+			pos += 2 + length;
+			conversion += 's';
+			out += StringFromFormat(conversion.c_str(), str.c_str());
+			break;
+		}
+
+		default:
+			goto unformatted;
+		}
+
+		p = next;
+		continue;
+
+	unformatted:
+		// Out of arguments, the message was cut short
+		out += percent;
+		break;
+	}
+
+	return out;
+}
+
+u64 GetLocalTimeUs()
+{
+	const time_t now = time(NULL);
+	const s64 offset_s = (s64)Common::Timer::GetLocalTimeSinceJan1970() - (s64)now;
+	const s64 us = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	return (u64)(us + offset_s * 1000000);
+}
+
+std::string FormatLine(u64 local_time_us, const char* file, u32 line, u8 level,
+	const char* type_name, const std::string& message)
+{
+	const u64 seconds = local_time_us / 1000000;
+	return StringFromFormat("%02u:%02u:%03u %s:%u %c[%s]: %s\n",
+		(u32)(seconds / 60 % 60), (u32)(seconds % 60), (u32)(local_time_us / 1000 % 1000),
+		file, line, level < sizeof(LogTypes::LOG_LEVEL_TO_CHAR) ? LogTypes::LOG_LEVEL_TO_CHAR[level] : '?',
+		type_name, message.c_str());
+}
+
+bool Writer::Open(const std::string& filename, const char* const* type_names, u32 num_types,
+	u64 time_us, u64 local_time_us)
+{
+	Close();
+	if (!m_file.Open(filename, "wb"))
+		return false;
+
+	Append(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+	Append(&BINARY_LOG_VERSION, 4);
+	Append(&time_us, 8);
+	Append(&local_time_us, 8);
+	Append(&num_types, 4);
+	for (u32 i = 0; i < num_types; ++i)
+	{
+		const u8 length = (u8)std::min<size_t>(strlen(type_names[i]), 0xFF);
+		Append(&length, 1);
+		Append(type_names[i], length);
+	}
+	Flush();
+	return true;
+}
+
+void Writer::Close()
+{
+	if (m_file.IsOpen())
+	{
+		Flush();
+		m_file.Close();
+	}
+	m_string_ids.clear();
+}
+
+void Writer::Append(const void* data, size_t size)
+{
+	m_buffer.insert(m_buffer.end(), (const u8*)data, (const u8*)data + size);
+}
+
+u32 Writer::GetStringID(const char* str)
+{
+	std::map<const char*, u32>::iterator it = m_string_ids.find(str);
+	if (it != m_string_ids.end())
+		return it->second;
+
+	const u32 id = (u32)m_string_ids.size();
+	m_string_ids[str] = id;
+
+	const u8 tag = TAG_STRING;
+	const u16 length = (u16)std::min<size_t>(strlen(str), 0xFFFF);
+	Append(&tag, 1);
+	Append(&id, 4);
+	Append(&length, 2);
+	Append(str, length);
+	return id;
+}
+
+void Writer::Write(const MessageHeader& header, const u8* args)
+{
+	MessageHeader stored = header;
+	stored.format = GetStringID((const char*)(uintptr_t)header.format);
+	stored.file = GetStringID((const char*)(uintptr_t)header.file);
+
+	const u8 tag = TAG_MESSAGE;
+	Append(&tag, 1);
+	Append(&stored, sizeof(stored));
+	Append(args, header.args_size);
+
+	if (m_buffer.size() >= WRITE_BUFFER_SIZE)
+		Flush();
+}
+
+void Writer::WriteDropped(u32 count)
+{
+	const u8 tag = TAG_DROPPED;
+	Append(&tag, 1);
+	Append(&count, 4);
+}
+
+void Writer::Flush()
+{
+	if (!m_buffer.empty() && m_file.IsOpen())
+		m_file.WriteBytes(m_buffer.data(), m_buffer.size());
+	m_buffer.clear();
+	m_file.Flush();
+}
+
+bool DecodeBinaryLog(const std::string& filename, File::IOFile& out)
+{
+	File::IOFile file(filename, "rb");
+	char magic[4];
+	u32 version, num_types;
+	u64 time_us, local_time_us;
+	if (!file.ReadArray(magic, 4) || memcmp(magic, BINARY_LOG_MAGIC, 4) ||
+	    !file.ReadArray(&version, 1) || version != BINARY_LOG_VERSION ||
+	    !file.ReadArray(&time_us, 1) || !file.ReadArray(&local_time_us, 1) || !file.ReadArray(&num_types, 1))
+		return false;
+
+	std::vector<std::string> type_names(num_types);
+	for (std::string& name : type_names)
+	{
+		u8 length;
+		if (!file.ReadArray(&length, 1))
+			return false;
+		name.resize(length);
+		if (length && !file.ReadBytes(&name[0], length))
+			return false;
+	}
+
+	std::vector<std::string> strings;
+	std::vector<u8> args(MAX_ARGS_SIZE);
+	u8 tag;
+	while (file.ReadArray(&tag, 1))
+	{
+		switch (tag)
+		{
+		case TAG_STRING:
+		{
+			u32 id;
+			u16 length;
+			if (!file.ReadArray(&id, 1) || !file.ReadArray(&length, 1) || id != strings.size())
+				return false;
+			std::string str(length, '\0');
+			if (length && !file.ReadBytes(&str[0], length))
+				return false;
+			strings.push_back(str);
+			break;
+		}
+
+		case TAG_MESSAGE:
+		{
+			MessageHeader header;
+			if (!file.ReadArray(&header, 1) || header.args_size > MAX_ARGS_SIZE ||
+			    header.format >= strings.size() || header.file >= strings.size() ||
+			    (header.args_size && !file.ReadBytes(args.data(), header.args_size)))
+				return false;
+
+			const std::string message = FormatArgs(strings[(size_t)header.format].c_str(), args.data(), header.args_size);
+			const std::string line = FormatLine(local_time_us + (header.time_us - time_us),
+				strings[(size_t)header.file].c_str(), header.line, header.level,
+				header.type < num_types ? type_names[header.type].c_str() : "?", message);
+			out.WriteBytes(line.data(), line.size());
+			break;
+		}
+
+		case TAG_DROPPED:
+		{
+			u32 count;
+			if (!file.ReadArray(&count, 1))
+				return false;
+			const std::string line = StringFromFormat("[%u log messages were dropped here]\n", count);
+			out.WriteBytes(line.data(), line.size());
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+}  // namespace BinaryLog
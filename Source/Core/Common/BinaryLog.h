@@ -0,0 +1,85 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// The pieces of the asynchronous logging in LogManager. A message is captured
+// as its format string and a copy of its arguments, which is quick enough to
+// do on the emulation threads, and is formatted later on the log thread.
+//
+// The binary log keeps the messages in that form. Each format and file name
+// is stored once, and the messages refer to them by ID, so it stays small even
+// with the most verbose logging. DecodeBinaryLog turns it back into the text
+// the file log would have held.
+
+#pragma once
+
+#include <cstdarg>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "FileUtil.h"
+
+namespace BinaryLog
+{
+
+// The arguments of a message take at most this many bytes, longer strings
+// are cut short
+const u32 MAX_ARGS_SIZE = 1024;
+
+struct MessageHeader // 32 bytes
+{
+	u64 time_us; // Common::Timer::GetTimeUs
+	// In memory the format and file name strings, in the binary log their IDs
+	u64 format;
+	u64 file;
+	u32 line;
+	u8 level;
+	u8 type;
+	u16 args_size;
+};
+
+// Copies the arguments the format refers to, with the contents of strings,
+// and returns how many bytes they took.
+u32 CaptureArgs(const char* format, va_list args, u8* out, u32 max_size);
+
+// Formats a message from the arguments copied by CaptureArgs
+std::string FormatArgs(const char* format, const u8* args, u32 args_size);
+
+// The current local time, in microseconds since 1970
+u64 GetLocalTimeUs();
+
+// A line as the file log writes it, with the time given as local time
+std::string FormatLine(u64 local_time_us, const char* file, u32 line, u8 level,
+	const char* type_name, const std::string& message);
+
+class Writer
+{
+public:
+	// time_us and local_time_us tell the local time of the timestamps
+	bool Open(const std::string& filename, const char* const* type_names, u32 num_types,
+		u64 time_us, u64 local_time_us);
+	void Close();
+	bool IsOpen() { return m_file.IsOpen(); }
+
+	void Write(const MessageHeader& header, const u8* args);
+	// Notes that messages were lost because a thread ran out of buffer space
+	void WriteDropped(u32 count);
+	void Flush();
+
+private:
+	u32 GetStringID(const char* str);
+	void Append(const void* data, size_t size);
+
+	File::IOFile m_file;
+	std::vector<u8> m_buffer;
+	// The strings are literals, so each address stands for one string
+	std::map<const char*, u32> m_string_ids;
+};
+
+// Writes the messages of a binary log to out as text, returns false if the
+// log is damaged or in an unknown format
+bool DecodeBinaryLog(const std::string& filename, File::IOFile& out);
+
+}  // namespace BinaryLog
@@ -5,24 +5,21 @@
 #include "Common.h"
 #include "DebugInterface.h"
 #include "BreakPoints.h"
+#include "../Core/HW/Memmap.h"
 #include "../Core/PowerPC/JitCommon/JitBase.h"
 
+#include <algorithm>
 #include <sstream>
 
 bool BreakPoints::IsAddressBreakPoint(u32 _iAddress)
 {
-	for (const TBreakPoint& bp : m_BreakPoints)
-		if (bp.iAddress == _iAddress)
-			return true;
-	return false;
+	return m_Addresses.Find(_iAddress) != nullptr;
 }
 
 bool BreakPoints::IsTempBreakPoint(u32 _iAddress)
 {
-	for (const TBreakPoint& bp : m_BreakPoints)
-		if (bp.iAddress == _iAddress && bp.bTemporary)
-			return true;
-	return false;
+	const bool* temp = m_Addresses.Find(_iAddress);
+	return temp && *temp;
 }
 
 BreakPoints::TBreakPointsStr BreakPoints::GetStrings() const
@@ -60,6 +57,7 @@ void BreakPoints::Add(const TBreakPoint& bp)
 	if (!IsAddressBreakPoint(bp.iAddress))
 	{
 		m_BreakPoints.push_back(bp);
+		m_Addresses[bp.iAddress] = bp.bTemporary;
 		if (jit)
 			jit->GetBlockCache()->InvalidateICache(bp.iAddress, 4);
 	}
@@ -75,6 +73,7 @@ void BreakPoints::Add(u32 em_address, bool temp)
 		pt.iAddress = em_address;
 
 		m_BreakPoints.push_back(pt);
+		m_Addresses[em_address] = temp;
 
 		if (jit)
 			jit->GetBlockCache()->InvalidateICache(em_address, 4);
@@ -83,6 +82,9 @@ void BreakPoints::Add(u32 em_address, bool temp)
 
 void BreakPoints::Remove(u32 em_address)
 {
+	if (!m_Addresses.Erase(em_address))
+		return;
+
 	for (auto i = m_BreakPoints.begin(); i != m_BreakPoints.end(); ++i)
 	{
 		if (i->iAddress == em_address)
@@ -106,6 +108,7 @@ void BreakPoints::Clear()
 	}
 
 	m_BreakPoints.clear();
+	m_Addresses.Clear();
 }
 
 MemChecks::TMemChecksStr MemChecks::GetStrings() const
@@ -141,14 +144,22 @@ void MemChecks::AddFromStrings(const TMemChecksStr& mcstrs)
 			ss >> mc.EndAddress;
 		else
 			mc.EndAddress = mc.StartAddress;
-		Add(mc);
+		if (GetMemCheck(mc.StartAddress) == 0)
+		{
+			m_MemChecks.push_back(mc);
+			UpdateIndex();
+		}
 	}
+	Memory::UpdateMemChecks();
 }
 
 void MemChecks::Add(const TMemCheck& _rMemoryCheck)
 {
 	if (GetMemCheck(_rMemoryCheck.StartAddress) == 0)
+	{
 		m_MemChecks.push_back(_rMemoryCheck);
+		Update();
+	}
 }
 
 void MemChecks::Remove(u32 _Address)
@@ -158,22 +169,61 @@ void MemChecks::Remove(u32 _Address)
 		if (i->StartAddress == _Address)
 		{
 			m_MemChecks.erase(i);
+			Update();
 			return;
 		}
 	}
 }
 
+void MemChecks::Clear()
+{
+	m_MemChecks.clear();
+	Update();
+}
+
+void MemChecks::Update()
+{
+	UpdateIndex();
+	Memory::UpdateMemChecks();
+}
+
+void MemChecks::UpdateIndex()
+{
+	m_Index.clear();
+	for (u32 i = 0; i < m_MemChecks.size(); ++i)
+	{
+		const TMemCheck& mc = m_MemChecks[i];
+		IndexEntry entry;
+		entry.start = mc.StartAddress;
+		entry.end = mc.bRange ? mc.EndAddress : mc.StartAddress;
+		entry.check = i;
+		m_Index.push_back(entry);
+	}
+	std::stable_sort(m_Index.begin(), m_Index.end(),
+		[](const IndexEntry& a, const IndexEntry& b) { return a.start < b.start; });
+
+	u32 max_end = 0;
+	for (IndexEntry& entry : m_Index)
+	{
+		max_end = std::max(max_end, entry.end);
+		entry.max_end = max_end;
+	}
+}
+
 TMemCheck *MemChecks::GetMemCheck(u32 address)
 {
-	for (TMemCheck& bp : m_MemChecks)
+	if (m_Index.empty())
+		return 0;
+
+	auto it = std::upper_bound(m_Index.begin(), m_Index.end(), address,
+		[](u32 a, const IndexEntry& entry) { return a < entry.start; });
+	while (it != m_Index.begin())
 	{
-		if (bp.bRange)
-		{
-			if (address >= bp.StartAddress && address <= bp.EndAddress)
-				return &(bp);
-		}
-		else if (bp.StartAddress == address)
-			return &(bp);
+		--it;
+		if (it->max_end < address)
+			break;
+		if (it->end >= address)
+			return &m_MemChecks[it->check];
 	}
 
 	// none found
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "CommonTypes.h"
+#include "FlatHashMap.h"
 
 class DebugInterface;
 
@@ -70,6 +71,9 @@ public:
 
 private:
 	TBreakPoints m_BreakPoints;
+	// Address -> temporary, for the lookups done while the code runs.
+	// m_BreakPoints keeps the order the UI shows them in.
+	FlatHashMap<u32, bool> m_Addresses;
 	u32 m_iBreakOnCount;
 };
 
@@ -94,5 +98,24 @@ public:
 	TMemCheck *GetMemCheck(u32 address);
 	void Remove(u32 _Address);
 
-	void Clear() { m_MemChecks.clear(); };
+	void Clear();
+
+private:
+	// The checks sorted by their start, each with the highest end of it and
+	// the checks before it, so a lookup only walks back over the checks
+	// which can contain the address
+	struct IndexEntry
+	{
+		u32 start;
+		u32 end;
+		u32 max_end;
+		u32 check;
+	};
+
+	// Rebuilds the index and has the memory system protect the pages the
+	// checks are on
+	void Update();
+	void UpdateIndex();
+
+	std::vector<IndexEntry> m_Index;
 };
@@ -40,8 +40,10 @@ struct CPUInfo
 	bool bLZCNT;
 	bool bSSE4A;
 	bool bAVX;
+	bool bAVX2;
 	bool bFMA;
 	bool bAES;
+	bool bPCLMUL;
 	// FXSAVE/FXRSTOR
 	bool bFXSR;
 	// This flag indicates that the hardware supports some mode
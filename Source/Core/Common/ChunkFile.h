@@ -45,6 +45,24 @@ struct LinkedListItem : public T
 	LinkedListItem<T> *next;
 };
 
+// A large array which a state written with regions refers to instead of
+// holding a copy of it. Its bytes go before those at offset in the buffer.
+struct StateRegion
+{
+	size_t offset;
+	const u8* data;
+	size_t size;
+};
+
+// A copy of a large array out of a state being loaded, which was put off so
+// that the copies could run in parallel once the rest of the state is read
+struct StateCopy
+{
+	u8* dest;
+	const u8* src;
+	size_t size;
+};
+
 // Wrapper class
 class PointerWrap
 {
@@ -61,9 +79,21 @@ public:
 	Mode mode;
 
 public:
-	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
+	PointerWrap(u8 **ptr_, Mode mode_)
+		: ptr(ptr_), mode(mode_), m_end(NULL), m_buffer(NULL), m_regions(NULL), m_copies(NULL) {}
+
+	// Writes by appending to the buffer, so there's no need to measure the
+	// state first. With regions, the arrays passed to DoRegion are only
+	// recorded, and must stay as they are until the state has been used.
+	PointerWrap(std::vector<u8>* buffer, std::vector<StateRegion>* regions = NULL)
+		: ptr(&m_end), mode(MODE_WRITE), m_end(NULL), m_buffer(buffer), m_regions(regions), m_copies(NULL) {}
 
 	void SetMode(Mode mode_) { mode = mode_; }
+
+	// While reading, DoRegion only adds the copies to the list, and nothing may
+	// look at the arrays until the caller has made them. The buffer has to stay
+	// around until then.
+	void SetDeferredCopies(std::vector<StateCopy>* copies) { m_copies = copies; }
 	Mode GetMode() const { return mode; }
 	u8** GetPPtr() { return ptr; }
 
@@ -174,6 +204,52 @@ public:
 			Do(x[i]);
 	}
 
+	// For RAM and the other large arrays, which a state written with regions
+	// doesn't copy
+	void DoRegion(u8* data, u32 size)
+	{
+		switch (mode)
+		{
+		case MODE_READ:
+			if (m_copies)
+			{
+				StateCopy copy = { data, *ptr, size };
+				m_copies->push_back(copy);
+			}
+			else
+			{
+				memcpy(data, *ptr, size);
+			}
+			*ptr += size;
+			break;
+
+		case MODE_WRITE:
+			if (m_regions)
+			{
+				StateRegion region = { m_buffer->size(), data, size };
+				m_regions->push_back(region);
+			}
+			else if (m_buffer)
+			{
+				m_buffer->insert(m_buffer->end(), data, data + size);
+			}
+			else
+			{
+				memcpy(*ptr, data, size);
+				*ptr += size;
+			}
+			break;
+
+		case MODE_MEASURE:
+			*ptr += size;
+			break;
+
+		default:
+			DoVoid(data, size);
+			break;
+		}
+	}
+
 	template <typename T>
 	void Do(T& x)
 	{
@@ -274,6 +350,13 @@ public:
 	}
 
 private:
+	// What ptr points to when writing to a buffer, it only counts bytes if a
+	// DoState changes the mode
+	u8* m_end;
+	std::vector<u8>* m_buffer;
+	std::vector<StateRegion>* m_regions;
+	std::vector<StateCopy>* m_copies;
+
 	__forceinline void DoByte(u8& x)
 	{
 		switch (mode)
@@ -304,6 +387,12 @@ private:
 
 	void DoVoid(void *data, u32 size)
 	{
+		if (mode == MODE_WRITE && m_buffer)
+		{
+			m_buffer->insert(m_buffer->end(), (u8*)data, (u8*)data + size);
+			return;
+		}
+
 		for(u32 i = 0; i != size; ++i)
 			DoByte(reinterpret_cast<u8*>(data)[i]);
 	}
@@ -391,14 +480,10 @@ public:
 		}
 
 		// Get data
-		u8 *ptr = 0;
-		PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-		_class.DoState(p);
-		size_t const sz = (size_t)ptr;
-		std::vector<u8> buffer(sz);
-		ptr = &buffer[0];
-		p.SetMode(PointerWrap::MODE_WRITE);
+		std::vector<u8> buffer;
+		PointerWrap p(&buffer);
 		_class.DoState(p);
+		size_t const sz = buffer.size();
 
 		// Create header
 		SChunkHeader header;
@@ -412,7 +497,7 @@ public:
 			return false;
 		}
 
-		if (!pFile.WriteArray(&buffer[0], sz))
+		if (!pFile.WriteArray(buffer.data(), sz))
 		{
 			ERROR_LOG(COMMON,"ChunkReader: Failed writing data");
 			return false;
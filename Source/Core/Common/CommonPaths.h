@@ -86,6 +86,7 @@
 
 // Files in the directory returned by GetUserPath(D_LOGS_IDX)
 #define MAIN_LOG	"dolphin.log"
+#define BINARY_LOG	"dolphin.binlog"
 
 // Files in the directory returned by GetUserPath(D_WIISYSCONF_IDX)
 #define WII_SYSCONF	"SYSCONF"
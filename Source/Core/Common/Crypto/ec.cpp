@@ -11,8 +11,20 @@
 #include <time.h>
 #include <stdlib.h>
 
+#include <map>
+#include <mutex>
+#include <string>
+
 #include "../Common.h"
+#include "../CPUDetect.h"
 #include "tools.h"
+
+// PCLMULQDQ needs compiler support: MSVC always has it, GCC only with -mpclmul.
+#if !defined(_M_GENERIC) && !defined(_M_ARM) && (defined(_MSC_VER) || defined(__PCLMUL__))
+#define USE_PCLMUL 1
+#include <wmmintrin.h>
+#endif
+
 // y**2 + x*y = x**3 + x + b
 /*
 static u8 ec_b[30] =
@@ -73,93 +85,146 @@ static void elt_add(u8 *d, u8 *a, u8 *b)
 		d[i] = a[i] ^ b[i];
 }
 
-static void elt_mul_x(u8 *d, u8 *a)
+// The field elements are 233 bit polynomials over GF(2), stored big endian
+// in 30 bytes. For multiplying they're converted to four 64-bit words, least
+// significant first, and reduced with x**233 = x**74 + 1.
+static void elt_to_words(u64 *w, const u8 *a)
 {
-	u8 carry, x, y;
 	u32 i;
 
-	carry = a[0] & 1;
-
-	x = 0;
-	for (i = 0; i < 29; i++) {
-		y = a[i + 1];
-		d[i] = x ^ (y >> 7);
-		x = y << 1;
+	w[0] = w[1] = w[2] = w[3] = 0;
+	for (i = 0; i < 30; i++) {
+		const u32 bit = (29 - i) * 8;
+		w[bit / 64] |= (u64)a[i] << (bit % 64);
 	}
-	d[29] = x ^ carry;
-
-	d[20] ^= carry << 2;
 }
 
-static void elt_mul(u8 *d, u8 *a, u8 *b)
+static void words_to_elt(u8 *d, const u64 *w)
 {
-	u32 i, n;
-	u8 mask;
-
-	elt_zero(d);
-
-	i = 0;
-	mask = 1;
-	for (n = 0; n < 233; n++) {
-		elt_mul_x(d, d);
-
-		if ((a[i] & mask) != 0)
-			elt_add(d, d, b);
+	u32 i;
 
-		mask >>= 1;
-		if (mask == 0) {
-			mask = 0x80;
-			i++;
-		}
+	for (i = 0; i < 30; i++) {
+		const u32 bit = (29 - i) * 8;
+		d[i] = (u8)(w[bit / 64] >> (bit % 64));
 	}
 }
 
-static const u8 square[16] =
-{0x00,0x01,0x04,0x05,0x10,0x11,0x14,0x15,0x40,0x41,0x44,0x45,0x50,0x51,0x54,0x55};
-
-static void elt_square_to_wide(u8 *d, u8 *a)
+static void wide_words_reduce(u64 *w)
 {
 	u32 i;
+	u64 t;
 
-	for (i = 0; i < 30; i++) {
-		d[2*i] = square[a[i] >> 4];
-		d[2*i + 1] = square[a[i] & 15];
+	for (i = 7; i >= 4; i--) {
+		t = w[i];
+		w[i - 4] ^= t << 23;
+		w[i - 3] ^= (t >> 41) ^ (t << 33);
+		w[i - 2] ^= t >> 31;
 	}
+
+	t = w[3] >> 41;
+	w[0] ^= t;
+	w[1] ^= t << 10;
+	w[3] &= (1ULL << 41) - 1;
 }
 
-static void wide_reduce(u8 *d)
+// Carry-less 64x64 bit multiply, four bits of a at a time
+static void clmul64(u64 *r, u64 a, u64 b)
 {
+	u64 t[16];
+	u64 lo, hi;
 	u32 i;
-	u8 x;
 
-	for (i = 0; i < 30; i++) {
-		x = d[i];
+	// The products in the table must fit in 64 bits, the top bits of b are
+	// added separately below
+	const u64 bl = b & ((1ULL << 61) - 1);
+	t[0] = 0;
+	t[1] = bl;
+	for (i = 2; i < 16; i += 2) {
+		t[i] = t[i / 2] << 1;
+		t[i + 1] = t[i] ^ bl;
+	}
 
-		d[i + 19] ^= x >> 7;
-		d[i + 20] ^= x << 1;
+	lo = hi = 0;
+	for (i = 64; i != 0; i -= 4) {
+		hi = (hi << 4) | (lo >> 60);
+		lo = (lo << 4) ^ t[(a >> (i - 4)) & 15];
+	}
 
-		d[i + 29] ^= x >> 1;
-		d[i + 30] ^= x << 7;
+	for (i = 61; i < 64; i++) {
+		if ((b >> i) & 1) {
+			lo ^= a << i;
+			hi ^= a >> (64 - i);
+		}
 	}
 
-	x = d[30] & ~1;
+	r[0] = lo;
+	r[1] = hi;
+}
+
+#ifdef USE_PCLMUL
+static void clmul64_pclmul(u64 *r, u64 a, u64 b)
+{
+	const __m128i p = _mm_clmulepi64_si128(_mm_loadl_epi64((const __m128i*)&a),
+	                                       _mm_loadl_epi64((const __m128i*)&b), 0);
+	_mm_storeu_si128((__m128i*)r, p);
+}
+#endif
 
-	d[49] ^= x >> 7;
-	d[50] ^= x << 1;
+static void elt_mul(u8 *d, u8 *a, u8 *b)
+{
+	u64 x[4], y[4], w[8], r[2];
+	u32 i, j;
+
+	elt_to_words(x, a);
+	elt_to_words(y, b);
+	memset(w, 0, sizeof(w));
+
+#ifdef USE_PCLMUL
+	const bool pclmul = cpu_info.bPCLMUL;
+#endif
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++) {
+#ifdef USE_PCLMUL
+			if (pclmul)
+				clmul64_pclmul(r, x[i], y[j]);
+			else
+#endif
+				clmul64(r, x[i], y[j]);
+			w[i + j] ^= r[0];
+			w[i + j + 1] ^= r[1];
+		}
+	}
 
-	d[59] ^= x >> 1;
+	wide_words_reduce(w);
+	words_to_elt(d, w);
+}
 
-	d[30] &= 1;
+// Squaring only spreads the bits out, the one between every two is zero
+static u64 spread32(u32 v)
+{
+	u64 x = v;
+
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+	x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x << 2)) & 0x3333333333333333ULL;
+	x = (x | (x << 1)) & 0x5555555555555555ULL;
+	return x;
 }
 
 static void elt_square(u8 *d, u8 *a)
 {
-	u8 wide[60];
+	u64 x[4], w[8];
+	u32 i;
 
-	elt_square_to_wide(wide, a);
-	wide_reduce(wide);
+	elt_to_words(x, a);
+	for (i = 0; i < 4; i++) {
+		w[2 * i] = spread32((u32)x[i]);
+		w[2 * i + 1] = spread32((u32)(x[i] >> 32));
+	}
 
-	elt_copy(d, wide + 30);
+	wide_words_reduce(w);
+	words_to_elt(d, w);
 }
 
 static void itoh_tsujii(u8 *d, u8 *a, u8 *b, u32 j)
@@ -400,5 +465,22 @@ int check_ecdsa(u8 *Q, u8 *R, u8 *S, u8 *hash)
 
 void ec_priv_to_pub(const u8 *k, u8 *Q)
 {
+	// The same few keys, like the console's own, are asked for over and over
+	static std::mutex s_lock;
+	static std::map<std::string, std::string> s_public_keys;
+
+	const std::string key((const char*)k, 30);
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		auto it = s_public_keys.find(key);
+		if (it != s_public_keys.end()) {
+			memcpy(Q, it->second.data(), 60);
+			return;
+		}
+	}
+
 	point_mul(Q, k, ec_G);
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_public_keys[key] = std::string((const char*)Q, 60);
 }
@@ -12,90 +12,181 @@
 #include <windows.h>
 #endif
 
-#include <algorithm>
+#include <memory>
+#include <set>
 
 #include "FileSearch.h"
+#include "FileUtil.h"
 #include "StringUtil.h"
+#include "ThreadPool.h"
 
+namespace
+{
+
+struct SearchedDirectory
+{
+	std::string path;
+	// The full names of the matches, with the first search string they match
+	std::vector<std::pair<size_t, std::string>> matches;
+	std::vector<std::unique_ptr<SearchedDirectory>> subdirectories;
+};
+
+// Names are compared the way the file system of the host does
+bool CharsMatch(char a, char b)
+{
+#ifdef _WIN32
+	return tolower((u8)a) == tolower((u8)b);
+#else
+	return a == b;
+#endif
+}
 
-CFileSearch::CFileSearch(const CFileSearch::XStringVector& _rSearchStrings, const CFileSearch::XStringVector& _rDirectories)
+bool MatchesGlob(const char* name, const char* pattern)
 {
-	// Reverse the loop order for speed?
-	for (auto& _rSearchString : _rSearchStrings)
+	// Where to go on from after the last '*'
+	const char* star = NULL;
+	const char* star_name = NULL;
+	while (*name)
 	{
-		for (auto& _rDirectory : _rDirectories)
+		if (*pattern == '*')
+		{
+			star = ++pattern;
+			star_name = name;
+		}
+		else if (*pattern == '?' || (*pattern && CharsMatch(*pattern, *name)))
+		{
+			++pattern;
+			++name;
+		}
+		else if (star)
+		{
+			pattern = star;
+			name = ++star_name;
+		}
+		else
 		{
-			FindFiles(_rSearchString, _rDirectory);
+			return false;
 		}
 	}
+	while (*pattern == '*')
+		++pattern;
+	return *pattern == '\0';
 }
 
-
-void CFileSearch::FindFiles(const std::string& _searchString, const std::string& _strPath)
+// Directory entries carry their type on most file systems, so the search
+// only falls back to a stat for the entries that don't, and for symlinks
+void SearchDirectory(SearchedDirectory* dir, const CFileSearch::XStringVector& patterns,
+	bool recursive, Common::TaskGroup& group)
 {
-	std::string GCMSearchPath;
-	BuildCompleteFilename(GCMSearchPath, _strPath, _searchString);
 #ifdef _WIN32
 	WIN32_FIND_DATA findData;
-	HANDLE FindFirst = FindFirstFile(UTF8ToTStr(GCMSearchPath).c_str(), &findData);
+	std::string search_path;
+	BuildCompleteFilename(search_path, dir->path, "*");
+	HANDLE FindFirst = FindFirstFile(UTF8ToTStr(search_path).c_str(), &findData);
+	if (FindFirst == INVALID_HANDLE_VALUE)
+		return;
 
-	if (FindFirst != INVALID_HANDLE_VALUE)
+	do
 	{
-		bool bkeepLooping = true;
+		const std::string found(TStrToUTF8(findData.cFileName));
+		if (found[0] == '.')
+			continue;
+#else
+	DIR* dirp = opendir(dir->path.c_str());
+	if (!dirp)
+		return;
+
+	while (auto const dp = readdir(dirp))
+	{
+		const std::string found(dp->d_name);
+		if (found == "." || found == "..")
+			continue;
+#endif
+		std::string full_name;
+		BuildCompleteFilename(full_name, dir->path, found);
 
-		while (bkeepLooping)
+		for (size_t i = 0; i < patterns.size(); ++i)
 		{
-			if (findData.cFileName[0] != '.')
+			if (MatchesGlob(found.c_str(), patterns[i].c_str()))
 			{
-				std::string strFilename;
-				BuildCompleteFilename(strFilename, _strPath, TStrToUTF8(findData.cFileName));
-				m_FileNames.push_back(strFilename);
+				dir->matches.push_back(std::make_pair(i, full_name));
+				break;
 			}
+		}
 
-			bkeepLooping = FindNextFile(FindFirst, &findData) ? true : false;
+		if (recursive)
+		{
+#ifdef _WIN32
+			const bool is_directory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#elif defined(DT_DIR)
+			const bool is_directory = dp->d_type == DT_DIR ||
+				((dp->d_type == DT_UNKNOWN || dp->d_type == DT_LNK) && File::IsDirectory(full_name));
+#else
+			const bool is_directory = File::IsDirectory(full_name);
+#endif
+			if (is_directory)
+			{
+				dir->subdirectories.emplace_back(new SearchedDirectory);
+				dir->subdirectories.back()->path = full_name;
+			}
 		}
-	}
+#ifdef _WIN32
+	} while (FindNextFile(FindFirst, &findData));
 	FindClose(FindFirst);
-
-
 #else
-	// TODO: super lame/broken
-
-	auto end_match(_searchString);
-
-	// assuming we have a "*.blah"-like pattern
-	if (!end_match.empty() && end_match[0] == '*')
-		end_match.erase(0, 1);
+	}
+	closedir(dirp);
+#endif
 
-	// ugly
-	if (end_match == ".*")
-		end_match.clear();
+	// The list is complete, so the tasks never see it move
+	for (auto& subdirectory : dir->subdirectories)
+	{
+		SearchedDirectory* sub = subdirectory.get();
+		group.Run([sub, &patterns, &group] { SearchDirectory(sub, patterns, true, group); });
+	}
+}
 
-	DIR* dir = opendir(_strPath.c_str());
+void CollectMatches(const SearchedDirectory& dir, size_t pattern, std::set<std::string>* seen,
+	CFileSearch::XStringVector* names)
+{
+	for (auto& match : dir.matches)
+	{
+		if (match.first == pattern && seen->insert(match.second).second)
+			names->push_back(match.second);
+	}
+	for (auto& subdirectory : dir.subdirectories)
+		CollectMatches(*subdirectory, pattern, seen, names);
+}
 
-	if (!dir)
-		return;
+}
 
-	while (auto const dp = readdir(dir))
+CFileSearch::CFileSearch(const CFileSearch::XStringVector& _rSearchStrings, const CFileSearch::XStringVector& _rDirectories, bool recursive)
+{
+	XStringVector patterns(_rSearchStrings);
+	for (auto& pattern : patterns)
 	{
-		std::string found(dp->d_name);
-
-		if ((found != ".") && (found != "..")
-			&& (found.size() >= end_match.size())
-			&& std::equal(end_match.rbegin(), end_match.rend(), found.rbegin()))
-		{
-			std::string full_name;
-			if (_strPath.c_str()[_strPath.size()-1] == DIR_SEP_CHR)
-				full_name = _strPath + found;
-			else
-				full_name = _strPath + DIR_SEP + found;
+		// Matches names without a dot as well, as on Windows
+		if (pattern == "*.*")
+			pattern = "*";
+	}
 
-			m_FileNames.push_back(full_name);
-		}
+	std::vector<SearchedDirectory> dirs(_rDirectories.size());
+	Common::TaskGroup group;
+	for (size_t i = 0; i < dirs.size(); ++i)
+	{
+		SearchedDirectory* dir = &dirs[i];
+		dir->path = _rDirectories[i];
+		group.Run([dir, &patterns, recursive, &group] { SearchDirectory(dir, patterns, recursive, group); });
 	}
+	group.Wait();
 
-	closedir(dir);
-#endif
+	// A file is only listed once, even where the directories overlap
+	std::set<std::string> seen;
+	for (size_t i = 0; i < patterns.size(); ++i)
+	{
+		for (auto& dir : dirs)
+			CollectMatches(dir, i, &seen, &m_FileNames);
+	}
 }
 
 const CFileSearch::XStringVector& CFileSearch::GetFileNames() const
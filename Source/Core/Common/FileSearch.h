@@ -12,13 +12,16 @@ class CFileSearch
 public:
 	typedef std::vector<std::string>XStringVector;
 
-	CFileSearch(const XStringVector& _rSearchStrings, const XStringVector& _rDirectories);
+	// Finds the files and directories whose names match any of the search
+	// strings, which may hold '*' and '?'. Each directory is read once for
+	// all of them, and the directories are read on the thread pool. With
+	// recursive set the subdirectories are searched as well.
+	CFileSearch(const XStringVector& _rSearchStrings, const XStringVector& _rDirectories, bool recursive = false);
+	// In the order of the search strings, then of the directories
 	const XStringVector& GetFileNames() const;
 
 private:
 
-	void FindFiles(const std::string& _searchString, const std::string& _strPath);
-
 	XStringVector m_FileNames;
 };
 
@@ -5,6 +5,7 @@
 
 #include "CommonPaths.h"
 #include "FileUtil.h"
+#include "ThreadPool.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -35,6 +36,9 @@
 #ifndef S_ISDIR
 #define S_ISDIR(m)  (((m)&S_IFMT) == S_IFDIR)
 #endif
+#ifndef S_ISREG
+#define S_ISREG(m)  (((m)&S_IFMT) == S_IFREG)
+#endif
 
 #ifdef BSD4_4
 #define stat64 stat
@@ -436,6 +440,24 @@ u64 GetSize(FILE *f)
 	return size;
 }
 
+bool GetSizeAndModificationTime(const std::string &filename, u64 *size, u64 *mtime)
+{
+	struct stat64 buf;
+#ifdef _WIN32
+	if (_tstat64(UTF8ToTStr(filename).c_str(), &buf) != 0)
+#else
+	if (stat64(filename.c_str(), &buf) != 0)
+#endif
+		return false;
+
+	if (!S_ISREG(buf.st_mode))
+		return false;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return true;
+}
+
 // creates an empty file filename, returns true on success
 bool CreateEmptyFile(const std::string &filename)
 {
@@ -452,13 +474,11 @@ bool CreateEmptyFile(const std::string &filename)
 }
 
 
-// Scans the directory tree gets, starting from _Directory and adds the
-// results into parentEntry. Returns the number of files+directories found
-u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
+// Adds the files and directories in directory to entries, without going into
+// the directories. The type of an entry usually comes with the entry, so only
+// files are stat'ed for their size, and entries of unknown type for both.
+static void ListDirectory(const std::string &directory, std::vector<FSTEntry>* entries)
 {
-	INFO_LOG(COMMON, "ScanDirectoryTree: directory %s", directory.c_str());
-	// How many files + directories we found
-	u32 foundEntries = 0;
 #ifdef _WIN32
 	// Find the first file in the directory.
 	WIN32_FIND_DATA ffd;
@@ -467,7 +487,7 @@ u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
 	if (hFind == INVALID_HANDLE_VALUE)
 	{
 		FindClose(hFind);
-		return foundEntries;
+		return;
 	}
 	// windows loop
 	do
@@ -479,7 +499,7 @@ u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
 
 	DIR *dirp = opendir(directory.c_str());
 	if (!dirp)
-		return 0;
+		return;
 
 	// non windows loop
 	while (!readdir_r(dirp, &dirent, &result) && result)
@@ -496,21 +516,31 @@ u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
 		entry.physicalName = directory;
 		entry.physicalName += DIR_SEP + entry.virtualName;
 
-		if (IsDirectory(entry.physicalName))
+#ifdef _WIN32
+		entry.isDirectory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		entry.size = entry.isDirectory ? 0 : ((u64)ffd.nFileSizeHigh << 32) | ffd.nFileSizeLow;
+#else
+#ifdef DT_DIR
+		if (result->d_type == DT_DIR)
 		{
 			entry.isDirectory = true;
-			// is a directory, lets go inside
-			entry.size = ScanDirectoryTree(entry.physicalName, entry);
-			foundEntries += (u32)entry.size;
+			entry.size = 0;
+			entries->push_back(entry);
+			continue;
 		}
-		else
-		{ // is a file
-			entry.isDirectory = false;
-			entry.size = GetSize(entry.physicalName.c_str());
+#endif
+		struct stat64 file_info;
+		if (stat64(entry.physicalName.c_str(), &file_info) < 0)
+		{
+			WARN_LOG(COMMON, "ListDirectory: stat failed on %s: %s",
+					 entry.physicalName.c_str(), GetLastErrorMsg());
+			file_info.st_mode = 0;
+			file_info.st_size = 0;
 		}
-		++foundEntries;
-		// Push into the tree
-		parentEntry.children.push_back(entry);
+		entry.isDirectory = S_ISDIR(file_info.st_mode);
+		entry.size = entry.isDirectory ? 0 : file_info.st_size;
+#endif
+		entries->push_back(entry);
 #ifdef _WIN32
 	} while (FindNextFile(hFind, &ffd) != 0);
 	FindClose(hFind);
@@ -518,10 +548,81 @@ u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
 	}
 	closedir(dirp);
 #endif
+}
+
+// Scans the directory tree gets, starting from _Directory and adds the
+// results into parentEntry. Returns the number of files+directories found
+u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry)
+{
+	INFO_LOG(COMMON, "ScanDirectoryTree: directory %s", directory.c_str());
+	// How many files + directories we found
+	u32 foundEntries = 0;
+
+	const size_t first = parentEntry.children.size();
+	ListDirectory(directory, &parentEntry.children);
+	for (size_t i = first; i < parentEntry.children.size(); ++i)
+	{
+		FSTEntry& entry = parentEntry.children[i];
+		if (entry.isDirectory)
+		{
+			// is a directory, lets go inside
+			entry.size = ScanDirectoryTree(entry.physicalName, entry);
+			foundEntries += (u32)entry.size;
+		}
+		++foundEntries;
+	}
+
 	// Return number of entries found.
 	return foundEntries;
 }
 
+// Lists a directory and queues the scans of its subdirectories. The children
+// are all in place before any task starts, so the tasks never see them move.
+static void QueueDirectoryScans(FSTEntry& entry, size_t first, Common::TaskGroup& group)
+{
+	for (size_t i = first; i < entry.children.size(); ++i)
+	{
+		FSTEntry& child = entry.children[i];
+		if (!child.isDirectory)
+			continue;
+		group.Run([&child, &group]
+		{
+			ListDirectory(child.physicalName, &child.children);
+			QueueDirectoryScans(child, 0, group);
+		});
+	}
+}
+
+static u32 CountEntries(FSTEntry& parentEntry, size_t first)
+{
+	u32 foundEntries = 0;
+	for (size_t i = first; i < parentEntry.children.size(); ++i)
+	{
+		FSTEntry& entry = parentEntry.children[i];
+		if (entry.isDirectory)
+		{
+			entry.size = CountEntries(entry, 0);
+			foundEntries += (u32)entry.size;
+		}
+		++foundEntries;
+	}
+	return foundEntries;
+}
+
+u32 ScanDirectoryTreeParallel(const std::string &directory, FSTEntry& parentEntry)
+{
+	INFO_LOG(COMMON, "ScanDirectoryTreeParallel: directory %s", directory.c_str());
+
+	const size_t first = parentEntry.children.size();
+	ListDirectory(directory, &parentEntry.children);
+
+	Common::TaskGroup group;
+	QueueDirectoryScans(parentEntry, first, group);
+	group.Wait();
+
+	return CountEntries(parentEntry, first);
+}
+
 
 // Deletes the given directory and anything under it. Returns true on success.
 bool DeleteDirRecursively(const std::string &directory)
@@ -78,6 +78,10 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE *f);
 
+// Gets the size and the time of the last modification in seconds of a
+// regular file with a single stat, returns false if there is no such file
+bool GetSizeAndModificationTime(const std::string &filename, u64 *size, u64 *mtime);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string &filename);
 
@@ -107,6 +111,9 @@ bool CreateEmptyFile(const std::string &filename);
 // results into parentEntry. Returns the number of files+directories found
 u32 ScanDirectoryTree(const std::string &directory, FSTEntry& parentEntry);
 
+// Same as ScanDirectoryTree, with the subdirectories scanned on the thread pool
+u32 ScanDirectoryTreeParallel(const std::string &directory, FSTEntry& parentEntry);
+
 // deletes the given directory and anything under it. Returns true on success.
 bool DeleteDirRecursively(const std::string &directory);
 
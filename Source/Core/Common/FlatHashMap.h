@@ -0,0 +1,153 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// Hash map with integer keys stored in a single array with linear probing,
+// for lookups on hot paths where std::map and std::unordered_map spend their
+// time chasing nodes.
+//
+// Growing the table moves the values, so pointers and references returned by
+// Find() and operator[] are only valid until the next insertion or erase.
+
+#include <utility>
+#include <vector>
+
+#include "CommonTypes.h"
+
+template <typename K, typename V>
+class FlatHashMap
+{
+public:
+	FlatHashMap() : m_size(0) {}
+
+	V* Find(K key)
+	{
+		if (m_slots.empty())
+			return nullptr;
+
+		for (size_t i = Home(key); m_slots[i].used; i = (i + 1) & Mask())
+		{
+			if (m_slots[i].key == key)
+				return &m_slots[i].value;
+		}
+		return nullptr;
+	}
+
+	const V* Find(K key) const
+	{
+		return const_cast<FlatHashMap*>(this)->Find(key);
+	}
+
+	// Inserts a value initialized V if the key isn't present yet
+	V& operator[](K key)
+	{
+		if ((m_size + 1) * 2 > m_slots.size())
+			Grow();
+
+		size_t i = Home(key);
+		for (; m_slots[i].used; i = (i + 1) & Mask())
+		{
+			if (m_slots[i].key == key)
+				return m_slots[i].value;
+		}
+
+		m_slots[i].used = true;
+		m_slots[i].key = key;
+		m_slots[i].value = V();
+		++m_size;
+		return m_slots[i].value;
+	}
+
+	bool Erase(K key)
+	{
+		if (m_slots.empty())
+			return false;
+
+		size_t i = Home(key);
+		for (; m_slots[i].used; i = (i + 1) & Mask())
+		{
+			if (m_slots[i].key == key)
+				break;
+		}
+		if (!m_slots[i].used)
+			return false;
+
+		// Shift the following entries of the run back, so that no lookup
+		// stops at the hole before reaching its key
+		m_slots[i].used = false;
+		for (size_t j = (i + 1) & Mask(); m_slots[j].used; j = (j + 1) & Mask())
+		{
+			const size_t home = Home(m_slots[j].key);
+			const bool between = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+			if (between)
+				continue;
+
+			m_slots[i] = std::move(m_slots[j]);
+			m_slots[j].used = false;
+			i = j;
+		}
+		--m_size;
+		return true;
+	}
+
+	// Calls f(key, value) for every entry, which must not insert or erase
+	template <typename F>
+	void ForEach(F f)
+	{
+		for (Slot& slot : m_slots)
+		{
+			if (slot.used)
+				f(slot.key, slot.value);
+		}
+	}
+
+	void Clear()
+	{
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	size_t Size() const { return m_size; }
+	bool Empty() const { return m_size == 0; }
+
+private:
+	struct Slot
+	{
+		Slot() : key(), value(), used(false) {}
+
+		K key;
+		V value;
+		bool used;
+	};
+
+	size_t Mask() const { return m_slots.size() - 1; }
+
+	size_t Home(K key) const
+	{
+		// Fibonacci hashing, the high bits are the best mixed
+		return (size_t)(((u64)key * 0x9E3779B97F4A7C15ULL) >> 32) & Mask();
+	}
+
+	void Grow()
+	{
+		std::vector<Slot> old;
+		old.swap(m_slots);
+		m_slots.resize(old.empty() ? 16 : old.size() * 2);
+
+		for (Slot& slot : old)
+		{
+			if (!slot.used)
+				continue;
+
+			size_t i = Home(slot.key);
+			while (m_slots[i].used)
+				i = (i + 1) & Mask();
+			m_slots[i] = std::move(slot);
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size;
+};
@@ -3,13 +3,23 @@
 // Refer to the license.txt file included.
 
 
+#include <algorithm>
+
+#include "CPUDetect.h"
 #include "Hash.h"
 #if _M_SSE >= 0x402
-#include "CPUDetect.h"
 #include <nmmintrin.h>
 #endif
+#if (defined(_M_X64) || defined(_M_IX86)) && !defined(_M_GENERIC)
+#define STRIPE_HASH_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
-static u64 (*ptrHashFunction)(const u8 *src, int len, u32 samples) = &GetMurmurHash3;
+static u64 (*ptrHashFunction)(const u8 *src, int len, u32 samples) = &GetStripeHash64;
 
 // uint32_t
 // WARNING - may read one more byte!
@@ -492,6 +502,328 @@ u64 GetHashHiresTexture(const u8 *src, int len, u32 samples)
 }
 #endif
 
+//-----------------------------------------------------------------------------
+// The stripe hash. Eight 64-bit lanes take 64 bytes at a time: each lane adds
+// its word, to the neighbouring lane, and the product of the two halves of the
+// word mixed with a key. Every 16 stripes the lanes are scrambled, and at the
+// end they are merged into one value.
+
+namespace
+{
+
+const u64 STRIPE_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const u64 STRIPE_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const u64 STRIPE_PRIME64_3 = 0x165667B19E3779F9ULL;
+const u64 STRIPE_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const u64 STRIPE_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+const u32 STRIPE_PRIME32_1 = 0x9E3779B1U;
+const u32 STRIPE_PRIME32_2 = 0x85EBCA77U;
+const u32 STRIPE_PRIME32_3 = 0xC2B2AE3DU;
+
+const u32 STRIPE_SIZE = 64;
+const u32 STRIPES_PER_BLOCK = 16;
+
+const u64 s_stripe_keys[8] = {
+	0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+	0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+
+const u64 s_scramble_keys[8] = {
+	0xCB00C391BB52283CULL, 0xA32E531B8B65D088ULL, 0x4EF90DA297486471ULL, 0xD8ACDEA946EF1938ULL,
+	0x3F349CE33F76FAA8ULL, 0x1D4F0BC7C7BBDCF9ULL, 0x3159B4CD4BE0518AULL, 0x647378D9C97E9FC8ULL,
+};
+
+typedef void (*AccumulateStripesFunc)(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys);
+
+void AccumulateStripesGeneric(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys)
+{
+	for (u32 s = 0; s < num_stripes; s++, data += stride)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			u64 word;
+			memcpy(&word, data + i * 8, 8);
+			const u64 keyed = word ^ keys[i];
+			acc[i ^ 1] += word;
+			acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+		}
+	}
+}
+
+#ifdef STRIPE_HASH_X86
+void AccumulateStripesSSE2(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys)
+{
+	__m128i a[4], k[4];
+	for (int i = 0; i < 4; i++)
+	{
+		a[i] = _mm_loadu_si128((const __m128i*)acc + i);
+		k[i] = _mm_loadu_si128((const __m128i*)keys + i);
+	}
+	for (u32 s = 0; s < num_stripes; s++, data += stride)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const __m128i word = _mm_loadu_si128((const __m128i*)data + i);
+			const __m128i keyed = _mm_xor_si128(word, k[i]);
+			const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+			const __m128i swapped = _mm_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2));
+			a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+		}
+	}
+	for (int i = 0; i < 4; i++)
+		_mm_storeu_si128((__m128i*)acc + i, a[i]);
+}
+
+// Built for AVX2 whatever the rest of the file is built for, it's only
+// called once the CPU is known to have it
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+TARGET_AVX2 void AccumulateStripesAVX2(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys)
+{
+	__m256i a[2], k[2];
+	for (int i = 0; i < 2; i++)
+	{
+		a[i] = _mm256_loadu_si256((const __m256i*)acc + i);
+		k[i] = _mm256_loadu_si256((const __m256i*)keys + i);
+	}
+	for (u32 s = 0; s < num_stripes; s++, data += stride)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			const __m256i word = _mm256_loadu_si256((const __m256i*)data + i);
+			const __m256i keyed = _mm256_xor_si256(word, k[i]);
+			const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+			const __m256i swapped = _mm256_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2));
+			a[i] = _mm256_add_epi64(a[i], _mm256_add_epi64(product, swapped));
+		}
+	}
+	for (int i = 0; i < 2; i++)
+		_mm256_storeu_si256((__m256i*)acc + i, a[i]);
+}
+#endif
+
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+void AccumulateStripesNEON(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys)
+{
+	uint64x2_t a[4], k[4];
+	for (int i = 0; i < 4; i++)
+	{
+		a[i] = vld1q_u64(acc + i * 2);
+		k[i] = vld1q_u64(keys + i * 2);
+	}
+	for (u32 s = 0; s < num_stripes; s++, data += stride)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const uint64x2_t word = vreinterpretq_u64_u8(vld1q_u8(data + i * 16));
+			const uint64x2_t keyed = veorq_u64(word, k[i]);
+			const uint64x2_t product = vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+			const uint64x2_t swapped = vextq_u64(word, word, 1);
+			a[i] = vaddq_u64(a[i], vaddq_u64(product, swapped));
+		}
+	}
+	for (int i = 0; i < 4; i++)
+		vst1q_u64(acc + i * 2, a[i]);
+}
+#endif
+
+void AccumulateStripesDetect(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys);
+
+AccumulateStripesFunc s_accumulate_stripes = &AccumulateStripesDetect;
+
+// Picked on first use, cpu_info may not be set up yet when this file's
+// statics are
+void AccumulateStripesDetect(u64* acc, const u8* data, u32 num_stripes, size_t stride, const u64* keys)
+{
+	SetStripeHashImpl(STRIPE_HASH_BEST);
+	s_accumulate_stripes(acc, data, num_stripes, stride, keys);
+}
+
+void ScrambleAccumulators(u64* acc)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		u64 a = acc[i];
+		a ^= a >> 47;
+		a ^= s_scramble_keys[i];
+		acc[i] = a * STRIPE_PRIME32_1;
+	}
+}
+
+u64 Avalanche(u64 h)
+{
+	h ^= h >> 33;
+	h *= STRIPE_PRIME64_2;
+	h ^= h >> 29;
+	h *= STRIPE_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+void InitAccumulators(u64* acc, u64* keys, u64 seed)
+{
+	const u64 init[8] = {
+		STRIPE_PRIME32_3, STRIPE_PRIME64_1, STRIPE_PRIME64_2, STRIPE_PRIME64_3,
+		STRIPE_PRIME64_4, STRIPE_PRIME32_2, STRIPE_PRIME64_5, STRIPE_PRIME32_1,
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		acc[i] = init[i];
+		keys[i] = (i & 1) ? s_stripe_keys[i] - seed : s_stripe_keys[i] + seed;
+	}
+}
+
+// Takes the stripes of data in blocks, so that the lanes are scrambled after
+// every 16th stripe whatever the stripes are split into
+void AccumulateStripes(u64* acc, u32* stripes_in_block, const u8* data, u32 num_stripes, size_t stride,
+	const u64* keys)
+{
+	while (num_stripes)
+	{
+		const u32 count = std::min(num_stripes, STRIPES_PER_BLOCK - *stripes_in_block);
+		s_accumulate_stripes(acc, data, count, stride, keys);
+		data += count * stride;
+		num_stripes -= count;
+		*stripes_in_block += count;
+		if (*stripes_in_block == STRIPES_PER_BLOCK)
+		{
+			ScrambleAccumulators(acc);
+			*stripes_in_block = 0;
+		}
+	}
+}
+
+// The last stripe is padded with zeroes, the length tells it apart
+void AccumulateLastStripe(u64* acc, const u8* data, u32 size, const u64* keys)
+{
+	GC_ALIGNED16(u8 stripe[STRIPE_SIZE]) = {};
+	memcpy(stripe, data, size);
+	s_accumulate_stripes(acc, stripe, 1, STRIPE_SIZE, keys);
+}
+
+u64 MergeAccumulators(const u64* acc, u64 length, u64 seed)
+{
+	u64 h = length * STRIPE_PRIME64_1 ^ seed;
+	for (int i = 0; i < 8; i++)
+	{
+		h ^= Avalanche(acc[i] + s_stripe_keys[(i + 3) & 7]);
+		h = ((h << 27) | (h >> 37)) * STRIPE_PRIME64_1 + STRIPE_PRIME64_4;
+	}
+	return Avalanche(h);
+}
+
+}
+
+bool SetStripeHashImpl(StripeHashImpl impl)
+{
+	AccumulateStripesFunc func = NULL;
+	switch (impl)
+	{
+	case STRIPE_HASH_GENERIC:
+		func = &AccumulateStripesGeneric;
+		break;
+#ifdef STRIPE_HASH_X86
+	case STRIPE_HASH_SSE2:
+		func = &AccumulateStripesSSE2;
+		break;
+	case STRIPE_HASH_AVX2:
+		if (cpu_info.bAVX2)
+			func = &AccumulateStripesAVX2;
+		break;
+#endif
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+	case STRIPE_HASH_NEON:
+		if (cpu_info.bNEON)
+			func = &AccumulateStripesNEON;
+		break;
+#endif
+	case STRIPE_HASH_BEST:
+		func = &AccumulateStripesGeneric;
+#ifdef STRIPE_HASH_X86
+		func = cpu_info.bAVX2 ? &AccumulateStripesAVX2 : &AccumulateStripesSSE2;
+#endif
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+		if (cpu_info.bNEON)
+			func = &AccumulateStripesNEON;
+#endif
+		break;
+	default:
+		break;
+	}
+
+	if (!func)
+		return false;
+	s_accumulate_stripes = func;
+	return true;
+}
+
+u64 GetStripeHash64(const u8 *src, int len, u32 samples)
+{
+	u64 acc[8], keys[8];
+	InitAccumulators(acc, keys, 0);
+
+	const u32 num_stripes = (u32)len / STRIPE_SIZE;
+	u32 step = 1;
+	if (samples != 0 && num_stripes > samples)
+		step = num_stripes / samples;
+
+	u32 stripes_in_block = 0;
+	AccumulateStripes(acc, &stripes_in_block, src, (num_stripes + step - 1) / step, (size_t)step * STRIPE_SIZE, keys);
+	if (len % STRIPE_SIZE)
+		AccumulateLastStripe(acc, src + num_stripes * STRIPE_SIZE, len % STRIPE_SIZE, keys);
+
+	return MergeAccumulators(acc, len, 0);
+}
+
+void StripeHash64::Reset(u64 seed)
+{
+	InitAccumulators(m_acc, m_keys, seed);
+	m_seed = seed;
+	m_length = 0;
+	m_buffered = 0;
+	m_stripes_in_block = 0;
+}
+
+void StripeHash64::Update(const void* data, size_t len)
+{
+	const u8* ptr = (const u8*)data;
+	m_length += len;
+
+	if (m_buffered)
+	{
+		const u32 count = (u32)std::min<size_t>(len, STRIPE_SIZE - m_buffered);
+		memcpy(m_buffer + m_buffered, ptr, count);
+		m_buffered += count;
+		ptr += count;
+		len -= count;
+		if (m_buffered < STRIPE_SIZE)
+			return;
+		AccumulateStripes(m_acc, &m_stripes_in_block, m_buffer, 1, STRIPE_SIZE, m_keys);
+		m_buffered = 0;
+	}
+
+	const u32 num_stripes = (u32)(len / STRIPE_SIZE);
+	AccumulateStripes(m_acc, &m_stripes_in_block, ptr, num_stripes, STRIPE_SIZE, m_keys);
+	ptr += (size_t)num_stripes * STRIPE_SIZE;
+	len -= (size_t)num_stripes * STRIPE_SIZE;
+
+	memcpy(m_buffer, ptr, len);
+	m_buffered = (u32)len;
+}
+
+u64 StripeHash64::Finish() const
+{
+	u64 acc[8];
+	memcpy(acc, m_acc, sizeof(acc));
+	if (m_buffered)
+		AccumulateLastStripe(acc, m_buffer, m_buffered, m_keys);
+	return MergeAccumulators(acc, m_length, m_seed);
+}
+
 u64 GetHash64(const u8 *src, int len, u32 samples)
 {
 	return ptrHashFunction(src, len, samples);
@@ -504,15 +836,9 @@ void SetHash64Function(bool useHiresTextures)
 	{
 		ptrHashFunction = &GetHashHiresTexture;
 	}
-#if _M_SSE >= 0x402
-	else if (cpu_info.bSSE4_2 && !useHiresTextures) // sse crc32 version
-	{
-		ptrHashFunction = &GetCRC32;
-	}
-#endif
 	else
 	{
-		ptrHashFunction = &GetMurmurHash3;
+		ptrHashFunction = &GetStripeHash64;
 	}
 }
 
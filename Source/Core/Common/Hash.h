@@ -13,5 +13,43 @@ u32 HashEctor(const u8* ptr, int length);            // JUNK. DO NOT USE FOR NEW
 u64 GetCRC32(const u8 *src, int len, u32 samples);   // SSE4.2 version of CRC32
 u64 GetHashHiresTexture(const u8 *src, int len, u32 samples);
 u64 GetMurmurHash3(const u8 *src, int len, u32 samples);
+// The fastest of them, using AVX2, SSE2 or NEON, with the same results on every
+// host. With samples set it takes that many of its 64 byte stripes.
+u64 GetStripeHash64(const u8 *src, int len, u32 samples);
 u64 GetHash64(const u8 *src, int len, u32 samples);
 void SetHash64Function(bool useHiresTextures);
+
+// The stripe hash of data given in pieces. Gives the same as GetStripeHash64
+// without samples for seed 0.
+class StripeHash64
+{
+public:
+	StripeHash64(u64 seed = 0) { Reset(seed); }
+
+	void Reset(u64 seed = 0);
+	void Update(const void* data, size_t len);
+	// The hash of the data so far, more may be added afterwards
+	u64 Finish() const;
+
+private:
+	u64 m_acc[8];
+	u64 m_keys[8];
+	u64 m_seed;
+	u64 m_length;
+	u8 m_buffer[64];
+	u32 m_buffered;
+	u32 m_stripes_in_block;
+};
+
+enum StripeHashImpl
+{
+	STRIPE_HASH_GENERIC,
+	STRIPE_HASH_SSE2,
+	STRIPE_HASH_AVX2,
+	STRIPE_HASH_NEON,
+	STRIPE_HASH_BEST,
+};
+
+// Picks the implementation of the stripe hash, for the tests and benchmarks.
+// Returns false if the host can't run it.
+bool SetStripeHashImpl(StripeHashImpl impl);
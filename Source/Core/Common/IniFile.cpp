@@ -17,6 +17,7 @@
 #include "FileUtil.h"
 #include "StringUtil.h"
 #include "IniFile.h"
+#include "StdMutex.h"
 
 namespace {
 
@@ -35,6 +36,53 @@ void ParseLine(const std::string& line, std::string* keyOut, std::string* valueO
 	}
 }
 
+// A file split into its sections, which are parsed later
+struct LoadedFile
+{
+	u64 size;
+	u64 mtime;
+	std::vector<std::pair<std::string, std::string>> sections;
+};
+
+// The same INIs are loaded many times, the game INIs several times at every
+// boot and for the game list
+std::mutex s_loaded_files_lock;
+std::map<std::string, LoadedFile> s_loaded_files;
+
+bool SplitFile(const std::string& filename, LoadedFile* file)
+{
+	std::string contents;
+	if (!File::ReadFileToString(filename.c_str(), contents))
+		return false;
+
+	std::string* current_section = NULL;
+	size_t pos = 0;
+	while (pos < contents.size())
+	{
+		size_t end = contents.find('\n', pos);
+		if (end == std::string::npos)
+			end = contents.size();
+
+		if (contents[pos] == '[')
+		{
+			const size_t endpos = contents.find(']', pos);
+			if (endpos < end)
+			{
+				// New section!
+				file->sections.push_back(std::make_pair(contents.substr(pos + 1, endpos - pos - 1), std::string()));
+				current_section = &file->sections.back().second;
+			}
+		}
+		else if (current_section && end > pos)
+		{
+			current_section->append(contents, pos, end - pos);
+			*current_section += '\n';
+		}
+		pos = end + 1;
+	}
+	return true;
+}
+
 }
 
 const std::string& IniFile::NULL_STRING = "";
@@ -194,6 +242,42 @@ bool IniFile::Section::Exists(const std::string& key) const
 	return values.find(key) != values.end();
 }
 
+void IniFile::Section::ParseLine(const std::string& line)
+{
+	std::string key, value;
+	::ParseLine(line, &key, &value);
+
+	// Lines starting with '$', '*' or '+' are kept verbatim.
+	// Kind of a hack, but the support for raw lines inside an
+	// INI is a hack anyway.
+	if ((key == "" && value == "")
+	        || (line.size() >= 1 && (line[0] == '$' || line[0] == '+' || line[0] == '*')))
+		lines.push_back(line);
+	else
+		Set(key, value);
+}
+
+void IniFile::Section::Parse()
+{
+	if (unparsed.empty())
+		return;
+
+	std::string text;
+	text.swap(unparsed);
+	size_t pos = 0;
+	while (pos < text.size())
+	{
+		const size_t end = text.find('\n', pos);
+		std::string line = text.substr(pos, end - pos);
+		// Check for CRLF eol and convert it to LF
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (!line.empty())
+			ParseLine(line);
+		pos = end + 1;
+	}
+}
+
 bool IniFile::Section::Delete(const std::string& key)
 {
 	auto it = values.find(key);
@@ -207,15 +291,21 @@ bool IniFile::Section::Delete(const std::string& key)
 
 // IniFile
 
+// Parsing a section doesn't change what the INI holds
 const IniFile::Section* IniFile::GetSection(const std::string& sectionName) const
 {
-	for (const Section& sect : sections)
-		if (!strcasecmp(sect.name.c_str(), sectionName.c_str()))
-			return (&(sect));
-	return 0;
+	return const_cast<IniFile*>(this)->GetSection(sectionName);
 }
 
 IniFile::Section* IniFile::GetSection(const std::string& sectionName)
+{
+	Section* section = FindSection(sectionName);
+	if (section)
+		section->Parse();
+	return section;
+}
+
+IniFile::Section* IniFile::FindSection(const std::string& sectionName)
 {
 	for (Section& sect : sections)
 		if (!strcasecmp(sect.name.c_str(), sectionName.c_str()))
@@ -322,68 +412,51 @@ void IniFile::SortSections()
 
 bool IniFile::Load(const std::string& filename, bool keep_current_data)
 {
-	// Maximum number of letters in a line
-	static const int MAX_BYTES = 1024*32;
-
 	if (!keep_current_data)
 		sections.clear();
 	// first section consists of the comments before the first real section
 
-	// Open file
-	std::ifstream in;
-	OpenFStream(in, filename, std::ios::in);
-
-	if (in.fail()) return false;
+	u64 size, mtime;
+	if (!File::GetSizeAndModificationTime(filename, &size, &mtime))
+		return false;
 
-	Section* current_section = NULL;
-	while (!in.eof())
+	std::vector<std::pair<std::string, std::string>> loaded_sections;
+	bool cached = false;
 	{
-		char templine[MAX_BYTES];
-		in.getline(templine, MAX_BYTES);
-		std::string line = templine;
-
-#ifndef _WIN32
-		// Check for CRLF eol and convert it to LF
-		if (!line.empty() && line.at(line.size()-1) == '\r')
+		std::lock_guard<std::mutex> lk(s_loaded_files_lock);
+		auto it = s_loaded_files.find(filename);
+		if (it != s_loaded_files.end() && it->second.size == size && it->second.mtime == mtime)
 		{
-			line.erase(line.size()-1);
+			loaded_sections = it->second.sections;
+			cached = true;
 		}
-#endif
+	}
+
+	if (!cached)
+	{
+		LoadedFile file;
+		file.size = size;
+		file.mtime = mtime;
+		if (!SplitFile(filename, &file))
+			return false;
+		loaded_sections = file.sections;
+
+		std::lock_guard<std::mutex> lk(s_loaded_files_lock);
+		s_loaded_files[filename] = std::move(file);
+	}
 
-		if (line.size() > 0)
+	// The lines are parsed after those already in the section, so they
+	// replace its keys as before
+	for (auto& loaded_section : loaded_sections)
+	{
+		Section* section = FindSection(loaded_section.first);
+		if (!section)
 		{
-			if (line[0] == '[')
-			{
-				size_t endpos = line.find("]");
-
-				if (endpos != std::string::npos)
-				{
-					// New section!
-					std::string sub = line.substr(1, endpos - 1);
-					current_section = GetOrCreateSection(sub);
-				}
-			}
-			else
-			{
-				if (current_section)
-				{
-					std::string key, value;
-					ParseLine(line, &key, &value);
-
-					// Lines starting with '$', '*' or '+' are kept verbatim.
-					// Kind of a hack, but the support for raw lines inside an
-					// INI is a hack anyway.
-					if ((key == "" && value == "")
-					        || (line.size() >= 1 && (line[0] == '$' || line[0] == '+' || line[0] == '*')))
-						current_section->lines.push_back(line);
-					else
-						current_section->Set(key, value);
-				}
-			}
+			sections.push_back(Section(loaded_section.first));
+			section = &sections.back();
 		}
+		section->unparsed += loaded_section.second;
 	}
-
-	in.close();
 	return true;
 }
 
@@ -398,8 +471,15 @@ bool IniFile::Save(const std::string& filename)
 		return false;
 	}
 
-	for (const Section& section : sections)
 	{
+		std::lock_guard<std::mutex> lk(s_loaded_files_lock);
+		s_loaded_files.erase(filename);
+	}
+
+	for (Section& section : sections)
+	{
+		section.Parse();
+
 		if (section.keys_order.size() != 0 || section.lines.size() != 0)
 			out << "[" << section.name << "]" << std::endl;
 
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <cctype>
 #include <map>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "StringUtil.h"
@@ -19,6 +21,26 @@ struct CaseInsensitiveStringCompare
 	}
 };
 
+struct CaseInsensitiveStringHash
+{
+	size_t operator() (const std::string& s) const
+	{
+		// FNV-1a of the lower case string
+		size_t hash = 2166136261u;
+		for (char c : s)
+			hash = (hash ^ (u8)tolower((u8)c)) * 16777619u;
+		return hash;
+	}
+};
+
+struct CaseInsensitiveStringEqual
+{
+	bool operator() (const std::string& a, const std::string& b) const
+	{
+		return a.size() == b.size() && strcasecmp(a.c_str(), b.c_str()) == 0;
+	}
+};
+
 class IniFile
 {
 public:
@@ -72,16 +94,25 @@ public:
 		}
 
 	protected:
+		void Parse();
+		void ParseLine(const std::string& line);
+
 		std::string name;
 
 		std::vector<std::string> keys_order;
-		std::map<std::string, std::string, CaseInsensitiveStringCompare> values;
+		std::unordered_map<std::string, std::string, CaseInsensitiveStringHash, CaseInsensitiveStringEqual> values;
 
 		std::vector<std::string> lines;
+
+		// The lines of the files loaded into the section, which are only
+		// parsed once the section is looked up. Game INIs hold many sections
+		// of patches and cheats that most users of the INI never look at.
+		std::string unparsed;
 	};
 
 	/**
-	 * Loads sections and keys.
+	 * Loads sections and keys. The contents of each file are kept until it
+	 * changes, so loading it again is cheap.
 	 * @param filename filename of the ini file which should be loaded
 	 * @param keep_current_data If true, "extends" the currently loaded list of sections and keys with the loaded data (and replaces existing entries). If false, existing data will be erased.
 	 * @warning Using any other operations than "Get*" and "Exists" is untested and will behave unexpectedly
@@ -142,6 +173,8 @@ private:
 
 	const Section* GetSection(const std::string& section) const;
 	Section* GetSection(const std::string& section);
+	// Doesn't parse the section
+	Section* FindSection(const std::string& section);
 	std::string* GetLine(const std::string& section, const std::string& key);
 	void CreateSection(const std::string& section);
 	
@@ -0,0 +1,209 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "Common.h"
+#include "FileUtil.h"
+#include "JitRegister.h"
+#include "StringUtil.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+namespace JitRegister
+{
+
+volatile bool g_enabled = false;
+
+static std::mutex s_lock;
+static File::IOFile s_perf_map;
+
+#ifdef __linux__
+// The format is described in tools/perf/Documentation/jitdump-specification.txt
+// of the Linux sources.
+enum
+{
+	JITDUMP_MAGIC = 0x4A695444,
+	JITDUMP_VERSION = 1,
+	JIT_CODE_LOAD = 0,
+};
+
+struct JitDumpHeader
+{
+	u32 magic;
+	u32 version;
+	u32 total_size;
+	u32 elf_mach;
+	u32 pad1;
+	u32 pid;
+	u64 timestamp;
+	u64 flags;
+};
+
+struct JitDumpCodeLoad
+{
+	u32 id;
+	u32 total_size;
+	u64 timestamp;
+	u32 pid;
+	u32 tid;
+	u64 vma;
+	u64 code_addr;
+	u64 code_size;
+	u64 code_index;
+	// Followed by the name with its terminator and the code
+};
+
+static File::IOFile s_jit_dump;
+static void* s_jit_dump_marker = nullptr;
+static long s_page_size;
+static u64 s_code_index;
+
+// perf record -k mono puts its samples on this clock
+static u64 GetTimestamp()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u64)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static bool OpenJitDump()
+{
+	const std::string filename = StringFromFormat("%sjit-%d.dump",
+		File::GetUserPath(D_DUMP_IDX).c_str(), getpid());
+	if (!s_jit_dump.Open(filename, "w+b"))
+		return false;
+
+	JitDumpHeader header = {};
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.total_size = sizeof(header);
+#if defined _M_X64
+	header.elf_mach = EM_X86_64;
+#elif defined _M_IX86
+	header.elf_mach = EM_386;
+#elif defined _M_ARM
+	header.elf_mach = EM_ARM;
+#endif
+	header.pid = getpid();
+	header.timestamp = GetTimestamp();
+	s_jit_dump.WriteArray(&header, 1);
+	s_jit_dump.Flush();
+
+	// perf finds the file through this mapping showing up in the record
+	s_page_size = sysconf(_SC_PAGESIZE);
+	s_jit_dump_marker = mmap(nullptr, s_page_size, PROT_READ | PROT_EXEC, MAP_PRIVATE,
+		fileno(s_jit_dump.GetHandle()), 0);
+	if (s_jit_dump_marker == MAP_FAILED)
+	{
+		s_jit_dump_marker = nullptr;
+		s_jit_dump.Close();
+		File::Delete(filename);
+		return false;
+	}
+	s_code_index = 0;
+	return true;
+}
+
+static void CloseJitDump()
+{
+	if (s_jit_dump_marker)
+		munmap(s_jit_dump_marker, s_page_size);
+	s_jit_dump_marker = nullptr;
+	s_jit_dump.Close();
+}
+
+static void WriteJitDump(const void* start, size_t size, const char* name)
+{
+	const size_t name_size = strlen(name) + 1;
+	JitDumpCodeLoad record = {};
+	record.id = JIT_CODE_LOAD;
+	record.total_size = (u32)(sizeof(record) + name_size + size);
+	record.timestamp = GetTimestamp();
+	record.pid = getpid();
+	record.tid = (u32)syscall(SYS_gettid);
+	record.vma = (u64)start;
+	record.code_addr = (u64)start;
+	record.code_size = size;
+	record.code_index = s_code_index++;
+	s_jit_dump.WriteArray(&record, 1);
+	s_jit_dump.WriteBytes(name, name_size);
+	s_jit_dump.WriteBytes(start, size);
+	s_jit_dump.Flush();
+}
+#endif
+
+void Init(bool perf_map, bool jit_dump)
+{
+	Shutdown();
+
+#ifndef _WIN32
+	// Neither format means anything to the profilers on Windows
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (perf_map)
+	{
+		const std::string filename = StringFromFormat("/tmp/perf-%d.map", getpid());
+		if (!s_perf_map.Open(filename, "w"))
+			ERROR_LOG(COMMON, "Couldn't open %s", filename.c_str());
+	}
+#ifdef __linux__
+	if (jit_dump && !OpenJitDump())
+		ERROR_LOG(COMMON, "Couldn't create the jitdump in %s", File::GetUserPath(D_DUMP_IDX).c_str());
+#endif
+	g_enabled = s_perf_map.IsOpen()
+#ifdef __linux__
+		|| s_jit_dump.IsOpen()
+#endif
+		;
+#endif
+}
+
+void Shutdown()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	g_enabled = false;
+	s_perf_map.Close();
+#ifdef __linux__
+	CloseJitDump();
+#endif
+}
+
+void Register(const void* start, size_t size, const char* format, ...)
+{
+	if (!IsEnabled() || size == 0)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	char name[256];
+	CharArrayFromFormatV(name, sizeof(name), format, args);
+	va_end(args);
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_perf_map.IsOpen())
+	{
+		fprintf(s_perf_map.GetHandle(), "%lx %lx %s\n",
+			(unsigned long)(uintptr_t)start, (unsigned long)size, name);
+		// perf only reads the map after we're gone, but a crash shouldn't lose it
+		s_perf_map.Flush();
+	}
+#ifdef __linux__
+	if (s_jit_dump.IsOpen())
+		WriteJitDump(start, size, name);
+#endif
+}
+
+}  // namespace
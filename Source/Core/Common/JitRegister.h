@@ -0,0 +1,41 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "CommonTypes.h"
+
+// Tells host profilers what the code the emitters generate at runtime is.
+//
+// Without this perf and friends only see anonymous executable memory. The perf
+// map (/tmp/perf-<pid>.map) is picked up by "perf report" as it is. The jitdump
+// (jit-<pid>.dump in the dump directory) also holds a copy of the code, so
+// "perf annotate" works after recording with "perf record -k mono" and running
+// "perf inject --jit" on the result.
+
+namespace JitRegister
+{
+
+extern volatile bool g_enabled;
+
+inline bool IsEnabled()
+{
+	return g_enabled;
+}
+
+// Both can be called again with other settings, which closes the old files.
+void Init(bool perf_map, bool jit_dump);
+void Shutdown();
+
+// The name is a printf format. Code can be registered again when it's
+// rewritten, the newest name is the one that counts.
+void Register(const void* start, size_t size, const char* format, ...)
+#ifdef __GNUC__
+	__attribute__((format(printf, 3, 4)))
+#endif
+	;
+
+}  // namespace
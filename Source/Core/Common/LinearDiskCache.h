@@ -44,17 +44,22 @@ template <typename K, typename V>
 class LinearDiskCache
 {
 public:
+	LinearDiskCache() : m_num_entries(0), m_read_only(false) {}
+
 	// return number of read entries
-	u32 OpenAndRead(const char *filename, LinearDiskCacheReader<K, V> &reader)
+	// A read-only cache is never written or recreated, so any number of
+	// processes can share the file.
+	u32 OpenAndRead(const char *filename, LinearDiskCacheReader<K, V> &reader, bool read_only = false)
 	{
 		using std::ios_base;
 
 		// close any currently opened file
 		Close();
 		m_num_entries = 0;
+		m_read_only = read_only;
 
 		// try opening for reading/writing
-		OpenFStream(m_file, filename, ios_base::in | ios_base::out | ios_base::binary);
+		OpenFStream(m_file, filename, read_only ? (ios_base::in | ios_base::binary) : (ios_base::in | ios_base::out | ios_base::binary));
 
 		m_file.seekg(0, std::ios::end);
 		std::fstream::pos_type end_pos = m_file.tellg();
@@ -108,6 +113,8 @@ public:
 		// failed to open file for reading or bad header
 		// close and recreate file
 		Close();
+		if (read_only)
+			return 0;
 		m_file.open(filename, ios_base::out | ios_base::trunc | ios_base::binary);
 		WriteHeader();
 		return 0;
@@ -130,6 +137,8 @@ public:
 	void Append(const K &key, const V *value, u32 value_size)
 	{
 		// TODO: Should do a check that we don't already have "key"? (I think each caller does that already.)
+		if (m_read_only)
+			return;
 		Write(&value_size);
 		Write(&key);
 		Write(value, value_size);
@@ -181,4 +190,5 @@ private:
 
 	std::fstream m_file;
 	u32 m_num_entries;
+	bool m_read_only;
 };
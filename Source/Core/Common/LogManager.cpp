@@ -4,14 +4,90 @@
 
 #include <algorithm>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #ifdef ANDROID
 #include "Host.h"
 #endif
+#include "BinaryLog.h"
+#include "CommonPaths.h"
 #include "LogManager.h"
+#include "SPSCRing.h"
 #include "Timer.h"
 #include "Thread.h"
 #include "FileUtil.h"
 
+enum
+{
+	LOG_RING_SIZE = 0x10000,
+	// Threads come and go with every boot, and their rings are never freed.
+	// Threads past this many log synchronously.
+	MAX_LOG_THREADS = 64,
+	// How long the log thread sleeps when it has drained the rings
+	LOG_THREAD_PERIOD_MS = 5,
+};
+
+struct LogRing
+{
+	Common::SPSCRing<u8, LOG_RING_SIZE> data;
+	// Counted by the thread which owns the ring, reported by the log thread
+	volatile u32 dropped;
+	u32 reported_dropped;
+};
+
+static std::mutex s_rings_lock;
+static std::vector<LogRing*> s_rings;
+
+static LogRing* CreateLogRing()
+{
+	std::lock_guard<std::mutex> lk(s_rings_lock);
+	if (s_rings.size() >= MAX_LOG_THREADS)
+		return NULL;
+
+	LogRing* ring = new LogRing;
+	ring->dropped = 0;
+	ring->reported_dropped = 0;
+	s_rings.push_back(ring);
+	return ring;
+}
+
+#ifdef _WIN32
+
+static LogRing* GetLogRing()
+{
+	static __declspec(thread) LogRing* ring = NULL;
+	if (!ring)
+		ring = CreateLogRing();
+	return ring;
+}
+
+#else
+
+// __thread isn't available on every platform we build for
+static pthread_key_t s_ring_key;
+static pthread_once_t s_ring_key_once = PTHREAD_ONCE_INIT;
+
+static void CreateRingKey()
+{
+	pthread_key_create(&s_ring_key, NULL);
+}
+
+static LogRing* GetLogRing()
+{
+	pthread_once(&s_ring_key_once, CreateRingKey);
+	LogRing* ring = (LogRing*)pthread_getspecific(s_ring_key);
+	if (!ring)
+	{
+		ring = CreateLogRing();
+		pthread_setspecific(s_ring_key, ring);
+	}
+	return ring;
+}
+
+#endif
+
 void GenericLog(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 		const char *file, int line, const char* fmt, ...)
 {
@@ -26,6 +102,7 @@ void GenericLog(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 LogManager *LogManager::m_logManager = NULL;
 
 LogManager::LogManager()
+	: m_async(false), m_binary_log(false)
 {
 	// create log files
 	m_Log[LogTypes::MASTER_LOG]			= new LogContainer("*",				"Master Log");
@@ -86,6 +163,8 @@ LogManager::LogManager()
 
 LogManager::~LogManager()
 {
+	SetAsync(false);
+
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
 	{
 		m_logManager->RemoveListener((LogTypes::LOG_TYPE)i, m_fileLog);
@@ -103,7 +182,33 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 	char temp[MAX_MSGLEN];
 	LogContainer *log = m_Log[type];
 
-	if (!log->IsEnabled() || level > log->GetLevel() || ! log->HasListeners())
+	if (!log->IsEnabled() || level > log->GetLevel() || (!log->HasListeners() && !m_binary_log))
+		return;
+
+	if (m_async)
+	{
+		LogRing* ring = GetLogRing();
+		if (ring)
+		{
+			u8 record[sizeof(BinaryLog::MessageHeader) + BinaryLog::MAX_ARGS_SIZE];
+			BinaryLog::MessageHeader header;
+			header.time_us = Common::Timer::GetTimeUs();
+			header.format = (u64)(uintptr_t)format;
+			header.file = (u64)(uintptr_t)file;
+			header.line = (u32)line;
+			header.level = (u8)level;
+			header.type = (u8)type;
+			header.args_size = (u16)BinaryLog::CaptureArgs(format, args, record + sizeof(header), BinaryLog::MAX_ARGS_SIZE);
+			memcpy(record, &header, sizeof(header));
+
+			// Never wait for the log thread
+			if (!ring->data.Push(record, sizeof(header) + header.args_size))
+				Common::AtomicIncrement(ring->dropped);
+			return;
+		}
+	}
+
+	if (!log->HasListeners())
 		return;
 
 	CharArrayFromFormatV(temp, MAX_MSGLEN, format, args);
@@ -119,6 +224,142 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 	log->Trigger(level, msg.c_str());
 }
 
+void LogManager::SetAsync(bool async)
+{
+	if (async == m_async)
+		return;
+
+	if (async)
+	{
+		m_async = true;
+		m_log_thread = std::thread(&LogManager::LogThread, this);
+	}
+	else
+	{
+		// The log thread drains the rings once more before it quits
+		m_async = false;
+		m_log_thread.join();
+		m_binary_log = false;
+	}
+}
+
+void LogManager::SetBinaryLog(bool enable)
+{
+	m_binary_log = enable;
+	if (enable)
+		SetAsync(true);
+}
+
+void LogManager::LogThread()
+{
+	Common::SetCurrentThreadName("Log thread");
+
+	// Ties the timestamps of the messages to the local time
+	const u64 anchor_time_us = Common::Timer::GetTimeUs();
+	const u64 anchor_local_us = BinaryLog::GetLocalTimeUs();
+
+	BinaryLog::Writer writer;
+	while (m_async)
+	{
+		DrainMessages(&writer, anchor_time_us, anchor_local_us);
+		Common::SleepCurrentThread(LOG_THREAD_PERIOD_MS);
+	}
+	DrainMessages(&writer, anchor_time_us, anchor_local_us);
+	writer.Close();
+}
+
+struct PendingMessage
+{
+	BinaryLog::MessageHeader header;
+	size_t args_offset;
+};
+
+void LogManager::DrainMessages(BinaryLog::Writer* writer, u64 anchor_time_us, u64 anchor_local_us)
+{
+	if (m_binary_log && !writer->IsOpen())
+	{
+		const char* type_names[LogTypes::NUMBER_OF_LOGS];
+		for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
+			type_names[i] = m_Log[i]->GetShortName();
+		const std::string filename = File::GetUserPath(D_LOGS_IDX) + BINARY_LOG;
+		File::CreateFullPath(filename);
+		if (!writer->Open(filename, type_names, LogTypes::NUMBER_OF_LOGS, anchor_time_us, anchor_local_us))
+			m_binary_log = false;
+	}
+	else if (!m_binary_log && writer->IsOpen())
+	{
+		writer->Close();
+	}
+
+	std::vector<LogRing*> rings;
+	{
+		std::lock_guard<std::mutex> lk(s_rings_lock);
+		rings = s_rings;
+	}
+
+	std::vector<PendingMessage> messages;
+	std::vector<u8> args;
+	u32 num_dropped = 0;
+	for (LogRing* ring : rings)
+	{
+		const u32 dropped = Common::AtomicLoadAcquire(ring->dropped);
+		num_dropped += dropped - ring->reported_dropped;
+		ring->reported_dropped = dropped;
+
+		// Each message is pushed as a whole, so a header means its arguments are there too
+		PendingMessage message;
+		while (ring->data.Size() >= sizeof(message.header))
+		{
+			ring->data.Pop((u8*)&message.header, sizeof(message.header));
+			message.args_offset = args.size();
+			args.resize(args.size() + message.header.args_size);
+			ring->data.Pop(args.data() + message.args_offset, message.header.args_size);
+			messages.push_back(message);
+		}
+	}
+
+	if (messages.empty() && !num_dropped)
+		return;
+
+	// The rings are drained one after another, the timestamps put the threads back in order
+	std::stable_sort(messages.begin(), messages.end(), [](const PendingMessage& a, const PendingMessage& b)
+	{
+		return a.header.time_us < b.header.time_us;
+	});
+
+	for (const PendingMessage& message : messages)
+	{
+		const BinaryLog::MessageHeader& header = message.header;
+		const u8* message_args = args.data() + message.args_offset;
+		if (writer->IsOpen())
+			writer->Write(header, message_args);
+
+		LogContainer* log = m_Log[header.type];
+		if (!log->HasListeners())
+			continue;
+
+		const char* format = (const char*)(uintptr_t)header.format;
+		const std::string msg = BinaryLog::FormatLine(anchor_local_us + (header.time_us - anchor_time_us),
+			(const char*)(uintptr_t)header.file, header.line, header.level, log->GetShortName(),
+			BinaryLog::FormatArgs(format, message_args, header.args_size));
+#ifdef ANDROID
+		Host_SysMessage(msg.c_str());
+#endif
+		log->Trigger((LogTypes::LOG_LEVELS)header.level, msg.c_str());
+	}
+
+	if (num_dropped)
+	{
+		if (writer->IsOpen())
+			writer->WriteDropped(num_dropped);
+		const std::string msg = StringFromFormat("[%u log messages were dropped here]\n", num_dropped);
+		m_Log[LogTypes::MASTER_LOG]->Trigger(LogTypes::LWARNING, msg.c_str());
+	}
+
+	if (writer->IsOpen())
+		writer->Flush();
+}
+
 void LogManager::Init()
 {
 	m_logManager = new LogManager();
@@ -11,10 +11,16 @@
 
 #include <set>
 #include <string.h>
+#include <vector>
 
 #define MAX_MESSAGES 8000
 #define MAX_MSGLEN  1024
 
+namespace BinaryLog
+{
+class Writer;
+}
+
 
 // pure virtual interface
 class LogListener
@@ -82,8 +88,17 @@ private:
 	FileLogListener *m_fileLog;
 	static LogManager *m_logManager;  // Singleton. Ugh.
 
+	// With asynchronous logging the emulation threads only copy their messages
+	// to a ring of their own, and this thread formats them and passes them on
+	std::thread m_log_thread;
+	volatile bool m_async;
+	volatile bool m_binary_log;
+
 	LogManager();
 	~LogManager();
+
+	void LogThread();
+	void DrainMessages(BinaryLog::Writer* writer, u64 anchor_time_us, u64 anchor_local_us);
 public:
 
 	static u32 GetMaxLevel() { return MAX_LOGLEVEL;	}
@@ -131,6 +146,18 @@ public:
 		return m_fileLog;
 	}
 
+	// Messages are dropped instead of waiting when a thread logs faster than
+	// the log thread keeps up, and the listeners are called on the log thread.
+	// The format strings and file names must outlive the log thread, which the
+	// string literals of the log macros do.
+	void SetAsync(bool async);
+	bool IsAsync() const { return m_async; }
+
+	// Writes every enabled message to the binary log in the logs directory,
+	// even those no listener takes. Turns on asynchronous logging.
+	void SetBinaryLog(bool enable);
+	bool IsBinaryLogEnabled() const { return m_binary_log; }
+
 	static LogManager* GetInstance()
 	{
 		return m_logManager;
@@ -0,0 +1,96 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "MappedFile.h"
+
+namespace File
+{
+
+MappedFile::MappedFile()
+	: m_data(NULL), m_size(0), m_mapped(false)
+#ifdef _WIN32
+	, m_mapping_handle(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	if (!m_file.Open(filename, "rb"))
+		return false;
+	m_size = m_file.GetSize();
+	if (m_size == 0 || m_size != (size_t)m_size)
+	{
+		Close();
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(m_file.GetHandle()));
+	m_mapping_handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping_handle)
+	{
+		m_data = (const u8*)MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		if (!m_data)
+		{
+			CloseHandle(m_mapping_handle);
+			m_mapping_handle = NULL;
+		}
+	}
+#else
+	void* data = mmap(NULL, (size_t)m_size, PROT_READ, MAP_PRIVATE, fileno(m_file.GetHandle()), 0);
+	if (data != MAP_FAILED)
+		m_data = (const u8*)data;
+#endif
+	if (m_data)
+	{
+		m_mapped = true;
+		return true;
+	}
+
+	INFO_LOG(COMMON, "Could not map %s, reading it instead", filename.c_str());
+	m_buffer.resize((size_t)m_size);
+	if (!m_file.ReadBytes(m_buffer.data(), m_buffer.size()))
+	{
+		Close();
+		return false;
+	}
+	m_data = m_buffer.data();
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping_handle);
+		m_mapping_handle = NULL;
+#else
+		munmap(const_cast<u8*>(m_data), (size_t)m_size);
+#endif
+		m_mapped = false;
+	}
+	m_data = NULL;
+	m_size = 0;
+	std::vector<u8>().swap(m_buffer);
+	m_file.Close();
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "FileUtil.h"
+
+namespace File
+{
+
+// A read-only view of a whole file. The file is mapped where possible, so
+// only the pages that are actually read are loaded, and read into memory
+// otherwise. The data stays valid until Close or destruction.
+class MappedFile : NonCopyable
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const { return m_data != NULL; }
+	const u8* GetData() const { return m_data; }
+	u64 GetSize() const { return m_size; }
+
+private:
+	IOFile m_file;
+	const u8* m_data;
+	u64 m_size;
+	bool m_mapped;
+#ifdef _WIN32
+	void* m_mapping_handle;
+#endif
+	std::vector<u8> m_buffer;
+};
+
+}  // namespace
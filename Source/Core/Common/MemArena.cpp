@@ -124,6 +124,25 @@ void MemArena::ReleaseView(void* view, size_t size)
 }
 
 
+void MemArena::ZeroView(void* view, size_t size)
+{
+#if !defined(_WIN32) && !defined(ANDROID) && defined(MADV_REMOVE)
+	// Punches a hole into the shared memory file, every view of the range
+	// reads zeroes afterwards
+	const uintptr_t page_mask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+	const uintptr_t start = ((uintptr_t)view + page_mask) & ~page_mask;
+	const uintptr_t end = ((uintptr_t)view + size) & ~page_mask;
+	if (start < end && madvise((void*)start, end - start, MADV_REMOVE) == 0)
+	{
+		memset(view, 0, start - (uintptr_t)view);
+		memset((void*)end, 0, (uintptr_t)view + size - end);
+		return;
+	}
+#endif
+	memset(view, 0, size);
+}
+
+
 u8* MemArena::Find4GBBase()
 {
 #ifdef _M_X64
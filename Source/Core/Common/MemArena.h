@@ -21,6 +21,10 @@ public:
 	void ReleaseSpace();
 	void *CreateView(s64 offset, size_t size, void *base = nullptr);
 	void ReleaseView(void *view, size_t size);
+	// Zeroes a range of a view. Where the OS allows it the pages are given
+	// back instead of written, so they stop counting towards the RSS until
+	// they are touched again
+	void ZeroView(void *view, size_t size);
 
 	// This only finds 1 GB in 32-bit
 	static u8 *Find4GBBase();
@@ -3,8 +3,12 @@
 // Refer to the license.txt file included.
 
 
+#include <atomic>
+#include <vector>
+
 #include "Common.h"
 #include "MemoryUtil.h"
+#include "StdMutex.h"
 #include "StringUtil.h"
 
 #ifdef _WIN32
@@ -12,7 +16,9 @@
 #include <psapi.h>
 #else
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <unistd.h>
 #endif
 
 #if !defined(_WIN32) && defined(__x86_64__) && !defined(MAP_32BIT)
@@ -24,11 +30,13 @@
 // This is purposely not a full wrapper for virtualalloc/mmap, but it
 // provides exactly the primitive operations that Dolphin needs.
 
-void* AllocateExecutableMemory(size_t size, bool low)
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+#if !defined(_WIN32)
+// Maps memory the JITs can reach with 32-bit displacements if low is set.
+// Returns NULL on failure.
+static void* MapCodeMemory(size_t size, int prot, int flags, int fd, bool low)
 {
-#if defined(_WIN32)
-	void* ptr = VirtualAlloc(0, size, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
-#else
 	static char *map_hint = 0;
 #if defined(__x86_64__) && !defined(MAP_32BIT)
 	// This OS has no flag to enforce allocation below the 4 GB boundary,
@@ -40,39 +48,192 @@ void* AllocateExecutableMemory(size_t size, bool low)
 	if (low && (!map_hint))
 		map_hint = (char*)round_page(512*1024*1024); /* 0.5 GB rounded up to the next page */
 #endif
-	void* ptr = mmap(map_hint, size, PROT_READ | PROT_WRITE | PROT_EXEC,
-		MAP_ANON | MAP_PRIVATE
+	void* ptr = mmap(map_hint, size, prot,
+		flags
 #if defined(__x86_64__) && defined(MAP_32BIT)
 		| (low ? MAP_32BIT : 0)
 #endif
-		, -1, 0);
-#endif /* defined(_WIN32) */
+		, fd, 0);
 
 	// printf("Mapped executable memory at %p (size %ld)\n", ptr,
 	//	(unsigned long)size);
-	
-#if defined(__FreeBSD__)
+
 	if (ptr == MAP_FAILED)
+		return NULL;
+#if defined(__x86_64__) && !defined(MAP_32BIT)
+	if (low)
 	{
-		ptr = NULL;
+		map_hint += size;
+		map_hint = (char*)round_page(map_hint); /* round up to the next page */
+		// printf("Next map will (hopefully) be at %p\n", map_hint);
+	}
+#endif
+	return ptr;
+}
+#endif
+
+// Returns NULL if the host doesn't allow writable and executable memory
+static void* AllocateWritableExecutableMemory(size_t size, bool low)
+{
+#if defined(_WIN32)
+	// Large pages need the privilege to lock memory, which most users don't
+	// have, so this usually falls back to normal pages
+	const size_t large_page_size = GetLargePageMinimum();
+	if (large_page_size && size >= large_page_size && size % large_page_size == 0)
+	{
+		void* ptr = VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_EXECUTE_READWRITE);
+		if (ptr)
+			return ptr;
+	}
+	return VirtualAlloc(0, size, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+#elif defined(MADV_HUGEPAGE)
+	// Transparent huge pages need an aligned range, so a larger one is
+	// mapped and trimmed
+	if (size >= HUGE_PAGE_SIZE)
+	{
+		u8* ptr = (u8*)MapCodeMemory(size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+			MAP_ANON | MAP_PRIVATE, -1, low);
+		if (!ptr)
+			return NULL;
+		u8* aligned = (u8*)(((uintptr_t)ptr + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+		if (aligned != ptr)
+			munmap(ptr, aligned - ptr);
+		munmap(aligned + size, ptr + HUGE_PAGE_SIZE - aligned);
+		madvise(aligned, size, MADV_HUGEPAGE);
+		return aligned;
+	}
+	return MapCodeMemory(size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, low);
 #else
+	return MapCodeMemory(size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, low);
+#endif
+}
+
+void* AllocateExecutableMemory(size_t size, bool low)
+{
+	void* ptr = AllocateWritableExecutableMemory(size, low);
 	if (ptr == NULL)
-	{
-#endif	
 		PanicAlert("Failed to allocate executable memory");
+
+#if defined(_M_X64)
+	if ((u64)ptr >= 0x80000000 && low == true)
+		PanicAlert("Executable memory ended up above 2GB!");
+#endif
+
+	return ptr;
+}
+
+struct DualMapping
+{
+	u8* code;
+	u8* writable;
+	size_t size;
+};
+
+static std::mutex s_dual_mappings_lock;
+static std::vector<DualMapping> s_dual_mappings;
+static std::atomic<bool> s_have_dual_mappings(false);
+// Set once the host has refused writable and executable memory
+static std::atomic<bool> s_wx_only(false);
+
+static void* AllocateDualMappedMemory(size_t size, u8** writable, bool low)
+{
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_EXECUTE_READWRITE,
+		(DWORD)((u64)size >> 32), (DWORD)size, NULL);
+	if (!mapping)
+		return NULL;
+	void* code = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, size);
+	void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+	// The views keep the mapping alive
+	CloseHandle(mapping);
+	if (!code || !data)
+	{
+		if (code)
+			UnmapViewOfFile(code);
+		if (data)
+			UnmapViewOfFile(data);
+		return NULL;
 	}
-#if !defined(_WIN32) && defined(__x86_64__) && !defined(MAP_32BIT)
-	else
+#else
+	int fd = -1;
+	for (int i = 0; i < 10000; i++)
 	{
-		if (low)
+		std::string file_name = StringFromFormat("dolphincode.%d", i);
+		fd = shm_open(file_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd != -1)
+		{
+			shm_unlink(file_name.c_str());
+			break;
+		}
+		else if (errno != EEXIST)
 		{
-			map_hint += size;
-			map_hint = (char*)round_page(map_hint); /* round up to the next page */
-			// printf("Next map will (hopefully) be at %p\n", map_hint);
+			ERROR_LOG(MEMMAP, "shm_open failed: %s", strerror(errno));
+			return NULL;
 		}
 	}
+	if (fd == -1)
+		return NULL;
+
+	void* code = NULL;
+	void* data = NULL;
+	if (ftruncate(fd, size) == 0)
+	{
+		code = MapCodeMemory(size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, low);
+		data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+			data = NULL;
+	}
+	// The views keep the memory alive
+	close(fd);
+	if (!code || !data)
+	{
+		if (code)
+			munmap(code, size);
+		if (data)
+			munmap(data, size);
+		return NULL;
+	}
 #endif
 
+	*writable = (u8*)data;
+	return code;
+}
+
+void* AllocateCodeMemory(size_t size, u8** writable, bool low)
+{
+	void* ptr = NULL;
+	if (!s_wx_only)
+	{
+		ptr = AllocateWritableExecutableMemory(size, low);
+		if (ptr)
+		{
+			*writable = (u8*)ptr;
+		}
+		else
+		{
+			NOTICE_LOG(MEMMAP, "Writable and executable memory was refused, mapping code memory twice");
+			s_wx_only = true;
+		}
+	}
+
+	if (!ptr)
+	{
+		ptr = AllocateDualMappedMemory(size, writable, low);
+		if (ptr)
+		{
+			std::lock_guard<std::mutex> lk(s_dual_mappings_lock);
+			DualMapping mapping = { (u8*)ptr, *writable, size };
+			s_dual_mappings.push_back(mapping);
+			s_have_dual_mappings = true;
+		}
+	}
+
+	if (!ptr)
+	{
+		*writable = NULL;
+		PanicAlert("Failed to allocate executable memory");
+	}
+
 #if defined(_M_X64)
 	if ((u64)ptr >= 0x80000000 && low == true)
 		PanicAlert("Executable memory ended up above 2GB!");
@@ -81,6 +242,55 @@ void* AllocateExecutableMemory(size_t size, bool low)
 	return ptr;
 }
 
+void FreeCodeMemory(void* ptr, size_t size)
+{
+	if (!ptr)
+		return;
+
+	if (s_have_dual_mappings)
+	{
+		std::lock_guard<std::mutex> lk(s_dual_mappings_lock);
+		for (auto it = s_dual_mappings.begin(); it != s_dual_mappings.end(); ++it)
+		{
+			if (it->code == ptr)
+			{
+#ifdef _WIN32
+				UnmapViewOfFile(it->code);
+				UnmapViewOfFile(it->writable);
+#else
+				munmap(it->code, it->size);
+				munmap(it->writable, it->size);
+#endif
+				s_dual_mappings.erase(it);
+				return;
+			}
+		}
+	}
+
+	FreeMemoryPages(ptr, size);
+}
+
+ptrdiff_t GetCodeWriteOffset(const void* ptr)
+{
+	if (!s_have_dual_mappings)
+		return 0;
+
+	std::lock_guard<std::mutex> lk(s_dual_mappings_lock);
+	for (const DualMapping& mapping : s_dual_mappings)
+	{
+		if (ptr >= mapping.code && ptr < mapping.code + mapping.size)
+			return mapping.writable - mapping.code;
+	}
+	// An emitter may be left at the end of a region once it's full. Another
+	// region may start right there, which takes precedence.
+	for (const DualMapping& mapping : s_dual_mappings)
+	{
+		if (ptr == mapping.code + mapping.size)
+			return mapping.writable - mapping.code;
+	}
+	return 0;
+}
+
 void* AllocateMemoryPages(size_t size)
 {
 #ifdef _WIN32
@@ -172,6 +382,17 @@ void UnWriteProtectMemory(void* ptr, size_t size, bool allowExecute)
 #endif
 }
 
+void ReadProtectMemory(void* ptr, size_t size)
+{
+#ifdef _WIN32
+	DWORD oldValue;
+	if (!VirtualProtect(ptr, size, PAGE_NOACCESS, &oldValue))
+		PanicAlert("ReadProtectMemory failed!\n%s", GetLastErrorMsg());
+#else
+	mprotect(ptr, size, PROT_NONE);
+#endif
+}
+
 std::string MemUsage()
 {
 #ifdef _WIN32
@@ -4,19 +4,34 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 
+#include "CommonTypes.h"
+
 #ifndef _WIN32
 #include <sys/mman.h>
 #endif
 
 void* AllocateExecutableMemory(size_t size, bool low = true);
+// Memory for the JITs to emit code into. Where the host allows memory to be
+// writable and executable at once *writable is the returned address. On
+// hosts which don't, the memory is mapped twice, executable at the returned
+// address and writable at *writable. Large regions use huge pages if the
+// host has them.
+void* AllocateCodeMemory(size_t size, u8** writable, bool low = true);
+void FreeCodeMemory(void* ptr, size_t size);
+// Where code memory at ptr is written, relative to ptr. Zero for any other
+// memory.
+ptrdiff_t GetCodeWriteOffset(const void* ptr);
 void* AllocateMemoryPages(size_t size);
 void FreeMemoryPages(void* ptr, size_t size);
 void* AllocateAlignedMemory(size_t size,size_t alignment);
 void FreeAlignedMemory(void* ptr);
 void WriteProtectMemory(void* ptr, size_t size, bool executable = false);
 void UnWriteProtectMemory(void* ptr, size_t size, bool allowExecute = false);
+// Makes any access fault, UnWriteProtectMemory allows them again
+void ReadProtectMemory(void* ptr, size_t size);
 std::string MemUsage();
 
 inline int GetPageSize() { return 4096; }
@@ -0,0 +1,256 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "Atomic.h"
+#include "FileUtil.h"
+#include "PerfTrace.h"
+#include "StringUtil.h"
+#include "Thread.h"
+
+namespace PerfTrace
+{
+
+enum
+{
+	EVENTS_PER_THREAD = 4096,
+	// Threads come and go with every boot, and their buffers are never
+	// freed, so bound what tracing can use.
+	MAX_THREADS = 64,
+};
+
+static const char* const s_category_names[NUM_CATEGORIES] =
+{
+	"Frame",
+	"JIT compile",
+	"Shader compile",
+	"Texture decode",
+	"EFB access",
+	"FIFO wait",
+};
+
+struct Event
+{
+	u64 start_us;
+	u32 duration_us;
+	u32 category;
+};
+
+struct ThreadBuffer
+{
+	// Only contended while exporting.
+	std::mutex lock;
+	u32 index;
+	u64 count;
+	Event events[EVENTS_PER_THREAD];
+};
+
+volatile bool g_enabled;
+
+static std::mutex s_threads_lock;
+static std::vector<ThreadBuffer*> s_threads;
+
+static volatile u32 s_frame_totals[NUM_CATEGORIES];
+static std::mutex s_history_lock;
+static FrameTimes s_history[FRAME_HISTORY_SIZE];
+static u32 s_history_count;
+static u64 s_last_frame_us;
+static FrameCallback s_frame_callback;
+
+static ThreadBuffer* CreateThreadBuffer()
+{
+	std::lock_guard<std::mutex> lk(s_threads_lock);
+	if (s_threads.size() >= MAX_THREADS)
+		return nullptr;
+
+	ThreadBuffer* buffer = new ThreadBuffer;
+	buffer->index = (u32)s_threads.size();
+	buffer->count = 0;
+	s_threads.push_back(buffer);
+	return buffer;
+}
+
+#ifdef _WIN32
+
+static ThreadBuffer* GetThreadBuffer()
+{
+	static __declspec(thread) ThreadBuffer* buffer = nullptr;
+	if (!buffer)
+		buffer = CreateThreadBuffer();
+	return buffer;
+}
+
+#else
+
+// __thread isn't available on every platform we build for
+static pthread_key_t s_buffer_key;
+static pthread_once_t s_buffer_key_once = PTHREAD_ONCE_INIT;
+
+static void CreateBufferKey()
+{
+	pthread_key_create(&s_buffer_key, nullptr);
+}
+
+static ThreadBuffer* GetThreadBuffer()
+{
+	pthread_once(&s_buffer_key_once, CreateBufferKey);
+	ThreadBuffer* buffer = (ThreadBuffer*)pthread_getspecific(s_buffer_key);
+	if (!buffer)
+	{
+		buffer = CreateThreadBuffer();
+		pthread_setspecific(s_buffer_key, buffer);
+	}
+	return buffer;
+}
+
+#endif
+
+void SetEnabled(bool enabled)
+{
+	if (enabled && !g_enabled)
+		s_last_frame_us = Common::Timer::GetTimeUs();
+	g_enabled = enabled;
+}
+
+void Clear()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_threads_lock);
+		for (ThreadBuffer* buffer : s_threads)
+		{
+			std::lock_guard<std::mutex> buffer_lk(buffer->lock);
+			buffer->count = 0;
+		}
+	}
+
+	std::lock_guard<std::mutex> lk(s_history_lock);
+	for (int i = 0; i < NUM_CATEGORIES; ++i)
+		Common::AtomicStore(s_frame_totals[i], 0);
+	s_history_count = 0;
+	s_last_frame_us = Common::Timer::GetTimeUs();
+}
+
+const char* GetCategoryName(Category category)
+{
+	return s_category_names[category];
+}
+
+static void AddEvent(Category category, u64 start_us, u32 duration_us)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	if (!buffer)
+		return;
+
+	std::lock_guard<std::mutex> lk(buffer->lock);
+	Event& event = buffer->events[buffer->count++ % EVENTS_PER_THREAD];
+	event.start_us = start_us;
+	event.duration_us = duration_us;
+	event.category = category;
+}
+
+void Record(Category category, u64 start_us, u64 end_us)
+{
+	const u32 duration_us = (u32)(end_us - start_us);
+	Common::AtomicAdd(s_frame_totals[category], duration_us);
+	AddEvent(category, start_us, duration_us);
+}
+
+void EndFrame()
+{
+	const bool enabled = IsEnabled();
+	if (!enabled && !s_frame_callback)
+		return;
+
+	const u64 now = Common::Timer::GetTimeUs();
+
+	FrameTimes frame = {};
+	frame.us[CAT_FRAME] = (u32)(now - s_last_frame_us);
+	for (int i = CAT_FRAME + 1; enabled && i < NUM_CATEGORIES; ++i)
+	{
+		// Subtract what was read rather than storing zero, so that time
+		// added in between carries over to the next frame.
+		frame.us[i] = Common::AtomicLoad(s_frame_totals[i]);
+		Common::AtomicAdd(s_frame_totals[i], 0u - frame.us[i]);
+	}
+
+	if (enabled)
+		AddEvent(CAT_FRAME, s_last_frame_us, frame.us[CAT_FRAME]);
+	s_last_frame_us = now;
+
+	if (s_frame_callback)
+		s_frame_callback(frame);
+
+	if (enabled)
+	{
+		std::lock_guard<std::mutex> lk(s_history_lock);
+		s_history[s_history_count++ % FRAME_HISTORY_SIZE] = frame;
+	}
+}
+
+void SetFrameCallback(FrameCallback callback)
+{
+	s_frame_callback = callback;
+	s_last_frame_us = Common::Timer::GetTimeUs();
+}
+
+int GetFrameHistory(FrameTimes* frames, int max_frames)
+{
+	std::lock_guard<std::mutex> lk(s_history_lock);
+	const int count = std::min<int>(std::min<u32>(s_history_count, FRAME_HISTORY_SIZE), max_frames);
+	for (int i = 0; i < count; ++i)
+		frames[i] = s_history[(s_history_count - count + i) % FRAME_HISTORY_SIZE];
+	return count;
+}
+
+bool ExportChromeTrace(const std::string& filename)
+{
+	File::IOFile file(filename, "w");
+	if (!file)
+		return false;
+
+	std::vector<Event> events;
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+
+	std::lock_guard<std::mutex> lk(s_threads_lock);
+	for (ThreadBuffer* buffer : s_threads)
+	{
+		u64 count;
+		{
+			std::lock_guard<std::mutex> buffer_lk(buffer->lock);
+			count = buffer->count;
+			const u64 kept = std::min<u64>(count, EVENTS_PER_THREAD);
+			events.clear();
+			for (u64 i = count - kept; i < count; ++i)
+				events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+		}
+		if (events.empty())
+			continue;
+
+		for (const Event& event : events)
+		{
+			json += StringFromFormat("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+				"\"ts\":%llu,\"dur\":%u}", first ? "" : ",\n", s_category_names[event.category],
+				buffer->index, (unsigned long long)event.start_us, event.duration_us);
+			first = false;
+		}
+
+		if (json.size() > 0x100000)
+		{
+			file.WriteBytes(json.data(), json.size());
+			json.clear();
+		}
+	}
+
+	json += "\n]}\n";
+	return file.WriteBytes(json.data(), json.size());
+}
+
+} // namespace PerfTrace
@@ -0,0 +1,95 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "CommonTypes.h"
+#include "Timer.h"
+
+// Lightweight timing of the subsystems that eat into the frame budget.
+//
+// Timed scopes are kept in a ring buffer per thread, which can be exported as a
+// Chrome trace (chrome://tracing), and are summed per frame for the on-screen
+// frame time graph. While tracing is disabled a scope only costs a flag check.
+
+namespace PerfTrace
+{
+
+enum Category
+{
+	CAT_FRAME,
+	CAT_JIT_COMPILE,
+	CAT_SHADER_COMPILE,
+	CAT_TEXTURE_DECODE,
+	CAT_EFB_ACCESS,
+	CAT_FIFO_WAIT,
+	NUM_CATEGORIES
+};
+
+enum
+{
+	FRAME_HISTORY_SIZE = 128,
+};
+
+struct FrameTimes
+{
+	// CAT_FRAME holds the time between two frames, the others the time spent
+	// in each category during that frame, summed over all threads.
+	u32 us[NUM_CATEGORIES];
+};
+
+extern volatile bool g_enabled;
+
+inline bool IsEnabled()
+{
+	return g_enabled;
+}
+
+void SetEnabled(bool enabled);
+
+// Drops all recorded events and frames.
+void Clear();
+
+const char* GetCategoryName(Category category);
+
+void Record(Category category, u64 start_us, u64 end_us);
+
+// Called on the video thread once per presented frame.
+void EndFrame();
+
+// Called from EndFrame with the times of the frame that just ended, even while
+// tracing is disabled, in which case only CAT_FRAME is filled in.
+typedef void (*FrameCallback)(const FrameTimes& frame);
+void SetFrameCallback(FrameCallback callback);
+
+// Copies up to max_frames of the newest frames, oldest first, and returns how
+// many were copied.
+int GetFrameHistory(FrameTimes* frames, int max_frames);
+
+// Writes the events that are still in the ring buffers as Chrome trace JSON.
+bool ExportChromeTrace(const std::string& filename);
+
+class ScopedTimer
+{
+public:
+	ScopedTimer(Category category)
+		: m_category(category), m_start(IsEnabled() ? Common::Timer::GetTimeUs() : 0)
+	{}
+
+	~ScopedTimer()
+	{
+		if (m_start)
+			Record(m_category, m_start, Common::Timer::GetTimeUs());
+	}
+
+private:
+	Category m_category;
+	u64 m_start;
+};
+
+} // namespace PerfTrace
+
+#define PERF_SCOPE(category) PerfTrace::ScopedTimer perf_scope_timer(PerfTrace::category)
@@ -0,0 +1,106 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// Wait-free ring buffer of a fixed power of two size for one producer thread
+// and one consumer thread.
+//
+// The read and write positions run freely and are only masked on access, so
+// the whole capacity is usable and Size() is just their difference. The
+// producer publishes a batch with a release store of the write position after
+// copying it, the consumer hands slots back the same way with the read
+// position, so neither side ever waits for the other.
+//
+// Push() and Free() may only be called by the producer, Peek(), Pop() and
+// Discard() only by the consumer. Size() is safe on both sides, but only a
+// lower bound on the consumer side and an upper bound on the producer side.
+
+#include <cstring>
+
+#include "Atomic.h"
+#include "CommonTypes.h"
+
+namespace Common
+{
+
+template <typename T, u32 N>
+class SPSCRing
+{
+	static_assert(N && (N & (N - 1)) == 0, "the size of an SPSCRing must be a power of two");
+
+public:
+	SPSCRing() : m_read(0), m_write(0)
+	{
+		memset(m_data, 0, sizeof(m_data));
+	}
+
+	static u32 Capacity() { return N; }
+
+	u32 Size() const
+	{
+		return AtomicLoadAcquire(const_cast<volatile u32&>(m_write)) - AtomicLoadAcquire(const_cast<volatile u32&>(m_read));
+	}
+
+	u32 Free() const { return N - Size(); }
+
+	// Adds all of the items or, if they don't fit, none of them
+	bool Push(const T* items, u32 count)
+	{
+		const u32 write = AtomicLoad(m_write);
+		if (count > N - (write - AtomicLoadAcquire(m_read)))
+			return false;
+
+		const u32 start = write & (N - 1);
+		const u32 first = count < N - start ? count : N - start;
+		memcpy(&m_data[start], items, first * sizeof(T));
+		memcpy(&m_data[0], items + first, (count - first) * sizeof(T));
+
+		AtomicStoreRelease(m_write, write + count);
+		return true;
+	}
+
+	// The item at the given offset from the oldest one, which must be below
+	// the Size() seen before
+	const T& Peek(u32 offset) const
+	{
+		return m_data[(m_read + offset) & (N - 1)];
+	}
+
+	// Copies up to count of the oldest items out and releases their slots
+	u32 Pop(T* items, u32 count)
+	{
+		const u32 read = AtomicLoad(m_read);
+		const u32 available = AtomicLoadAcquire(m_write) - read;
+		if (count > available)
+			count = available;
+
+		const u32 start = read & (N - 1);
+		const u32 first = count < N - start ? count : N - start;
+		memcpy(items, &m_data[start], first * sizeof(T));
+		memcpy(items + first, &m_data[0], (count - first) * sizeof(T));
+
+		AtomicStoreRelease(m_read, read + count);
+		return count;
+	}
+
+	// Releases the slots of the oldest items after they were read with Peek()
+	void Discard(u32 count)
+	{
+		AtomicStoreRelease(m_read, AtomicLoad(m_read) + count);
+	}
+
+	// Only when neither side is running
+	void Clear()
+	{
+		m_read = m_write = 0;
+	}
+
+private:
+	T m_data[N];
+	volatile u32 m_read;
+	volatile u32 m_write;
+};
+
+}
@@ -9,6 +9,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "Common.h"
@@ -69,7 +70,7 @@ class SymbolDB
 {
 public:
 	typedef std::map<u32, Symbol>  XFuncMap;
-	typedef std::map<u32, Symbol*> XFuncPtrMap;
+	typedef std::unordered_map<u32, Symbol*> XFuncPtrMap;
 
 protected:
 	XFuncMap    functions;
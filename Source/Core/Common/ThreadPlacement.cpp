@@ -0,0 +1,169 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "Common.h"
+#include "CPUDetect.h"
+#include "FileUtil.h"
+#include "StringUtil.h"
+#include "Thread.h"
+#include "ThreadPlacement.h"
+#include "ThreadPool.h"
+
+namespace Common
+{
+namespace ThreadPlacement
+{
+
+// The affinity masks only have room for this many logical CPUs.
+static const int MAX_LOGICAL_CPUS = 32;
+
+static bool s_enabled;
+static u32 s_cpu_mask;
+static u32 s_gpu_mask;
+// Zero if the CPU and GPU cores are all there is, helpers then run anywhere
+static u32 s_helper_mask;
+
+#if defined __linux__ && !defined ANDROID
+static int ReadTopologyValue(int cpu, const char* name, int default_value)
+{
+	// sysfs reports a page as the size of every file, so don't go by it
+	File::IOFile file(StringFromFormat("/sys/devices/system/cpu/cpu%d/%s", cpu, name), "r");
+	int value;
+	if (!file.IsOpen() || fscanf(file.GetHandle(), "%d", &value) != 1)
+		return default_value;
+	return value;
+}
+#endif
+
+std::vector<u32> GetPhysicalCores()
+{
+	std::vector<u32> cores;
+
+#ifdef _WIN32
+	DWORD length = 0;
+	GetLogicalProcessorInformation(NULL, &length);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (!info.empty() && GetLogicalProcessorInformation(info.data(), &length))
+	{
+		for (const auto& entry : info)
+		{
+			if (entry.Relationship == RelationProcessorCore && (u32)entry.ProcessorMask)
+				cores.push_back((u32)entry.ProcessorMask);
+		}
+	}
+#elif defined __linux__ && !defined ANDROID
+	// Keyed by (package, core) so that the cores of one NUMA node stay together,
+	// with the capacity of mixed big.LITTLE hosts kept alongside
+	std::map<std::pair<int, int>, std::pair<u32, int>> by_core;
+	for (int cpu = 0; cpu < MAX_LOGICAL_CPUS; ++cpu)
+	{
+		if (!File::Exists(StringFromFormat("/sys/devices/system/cpu/cpu%d/topology", cpu)))
+			continue;
+		const int package = ReadTopologyValue(cpu, "topology/physical_package_id", 0);
+		const int core = ReadTopologyValue(cpu, "topology/core_id", cpu);
+		auto& entry = by_core[std::make_pair(package, core)];
+		entry.first |= 1u << cpu;
+		entry.second = std::max(entry.second, ReadTopologyValue(cpu, "cpu_capacity", 1024));
+	}
+
+	std::vector<std::pair<u32, int>> sorted;
+	for (const auto& entry : by_core)
+		sorted.push_back(entry.second);
+	std::stable_sort(sorted.begin(), sorted.end(),
+		[](const std::pair<u32, int>& a, const std::pair<u32, int>& b) { return a.second > b.second; });
+	for (const auto& entry : sorted)
+		cores.push_back(entry.first);
+#endif
+
+	if (cores.empty())
+	{
+		// No topology from the OS: assume SMT siblings are numbered next to each other
+		const int logical = std::min(std::max(cpu_info.logical_cpu_count, 1), MAX_LOGICAL_CPUS);
+		const int per_core = (cpu_info.HTT && cpu_info.num_cores > 0 && logical >= 2 * cpu_info.num_cores) ? 2 : 1;
+		for (int cpu = 0; cpu < logical; cpu += per_core)
+			cores.push_back(((1u << per_core) - 1) << cpu);
+	}
+
+	return cores;
+}
+
+void Init(bool enabled, bool dual_core, int cpu_core, int gpu_core)
+{
+	s_enabled = false;
+	s_cpu_mask = s_gpu_mask = s_helper_mask = 0;
+	if (!enabled)
+		return;
+
+	const std::vector<u32> cores = GetPhysicalCores();
+	const int needed = dual_core ? 2 : 1;
+	if ((int)cores.size() < needed + (dual_core ? 0 : 1))
+	{
+		INFO_LOG(COMMON, "Thread placement: only %d physical cores, leaving threads alone", (int)cores.size());
+		return;
+	}
+
+	// Core 0 takes most of the OS's interrupts, so skip it when there's room
+	const int first = ((int)cores.size() > needed) ? 1 : 0;
+	if (cpu_core < 0 || cpu_core >= (int)cores.size())
+		cpu_core = first;
+	if (gpu_core < 0 || gpu_core >= (int)cores.size() || gpu_core == cpu_core)
+	{
+		gpu_core = first;
+		while (gpu_core == cpu_core)
+			gpu_core = (gpu_core + 1) % (int)cores.size();
+	}
+
+	u32 all = 0;
+	for (u32 core : cores)
+		all |= core;
+
+	s_cpu_mask = cores[cpu_core];
+	s_gpu_mask = dual_core ? cores[gpu_core] : 0;
+	s_helper_mask = all & ~(s_cpu_mask | s_gpu_mask);
+	s_enabled = true;
+
+	ThreadPool::SetReservedCores(s_helper_mask ? (s_cpu_mask | s_gpu_mask) : 0);
+	INFO_LOG(COMMON, "Thread placement: CPU %08x, GPU %08x, helpers %08x", s_cpu_mask, s_gpu_mask, s_helper_mask);
+}
+
+void Shutdown()
+{
+	if (!s_enabled)
+		return;
+	s_enabled = false;
+	ThreadPool::SetReservedCores(0);
+}
+
+void PlaceCurrentThread(Role role)
+{
+	if (!s_enabled)
+		return;
+
+	u32 mask;
+	switch (role)
+	{
+	case ROLE_CPU:
+		mask = s_cpu_mask;
+		break;
+	case ROLE_GPU:
+		mask = s_gpu_mask;
+		break;
+	default:
+		mask = s_helper_mask;
+		break;
+	}
+	if (mask)
+		SetCurrentThreadAffinity(mask);
+}
+
+} // namespace ThreadPlacement
+} // namespace Common
@@ -0,0 +1,44 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "CommonTypes.h"
+
+// Decides which host cores the emulation threads run on. The CPU and GPU
+// threads each get a physical core of their own, SMT sibling included, and
+// the helper threads (thread pool, DSP LLE, audio, wiimotes) are kept off
+// both. When placement is off, nothing is pinned.
+
+namespace Common
+{
+namespace ThreadPlacement
+{
+
+enum Role
+{
+	ROLE_CPU,    // The emulated CPU, which also does the GPU in single core mode
+	ROLE_GPU,    // The video thread in dual core mode
+	ROLE_HELPER, // Everything else that runs alongside emulation
+};
+
+// Picks the cores for this emulation session. cpu_core and gpu_core are
+// indices into GetPhysicalCores(), or -1 to choose automatically.
+void Init(bool enabled, bool dual_core, int cpu_core = -1, int gpu_core = -1);
+// Lets every thread run anywhere again.
+void Shutdown();
+
+// Pins the calling thread for its role. Does nothing when placement is off
+// or the host has too few cores for it to matter.
+void PlaceCurrentThread(Role role);
+
+// The logical CPU mask of each physical core of the host, faster cores
+// first on hosts that mix core types. Only the first 32 logical CPUs are
+// considered.
+std::vector<u32> GetPhysicalCores();
+
+} // namespace ThreadPlacement
+} // namespace Common
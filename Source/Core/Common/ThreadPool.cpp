@@ -0,0 +1,295 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Atomic.h"
+#include "ThreadPool.h"
+
+namespace Common
+{
+
+struct ThreadPoolTask
+{
+	std::function<void()> func;
+	TaskGroup* group;
+
+	void Execute()
+	{
+		func();
+		func = nullptr;
+		group->FinishTask();
+	}
+};
+
+namespace ThreadPool
+{
+
+// The affinity mask only has room for this many cores.
+static const int MAX_WORKERS = 32;
+
+struct Worker
+{
+	std::thread thread;
+	std::mutex lock;
+	std::deque<ThreadPoolTask> tasks;
+};
+
+static std::mutex s_init_lock;
+static std::vector<std::unique_ptr<Worker>> s_workers;
+static volatile bool s_initialized;
+static u32 s_reserved_cores;
+// Bumped by every thread that submits tasks
+static std::atomic<u32> s_next_worker;
+
+// Sleeping workers wait for s_queued to become non-zero.
+static std::mutex s_sleep_lock;
+static std::condition_variable s_sleep_cond;
+static volatile u32 s_queued;
+static bool s_quit;
+
+static void ApplyAffinity(Worker& worker)
+{
+	const u32 num_cores = std::min<u32>(std::thread::hardware_concurrency(), MAX_WORKERS);
+	const u32 all_cores = (num_cores >= 32) ? 0xFFFFFFFF : ((1u << num_cores) - 1);
+	u32 mask = all_cores & ~s_reserved_cores;
+	if (!mask)
+		mask = all_cores;
+	SetThreadAffinity(worker.thread.native_handle(), mask);
+}
+
+// Index of the worker running on the calling thread, or -1.
+static int GetCurrentWorker()
+{
+	const std::thread::id id = std::this_thread::get_id();
+	for (size_t i = 0; i < s_workers.size(); ++i)
+	{
+		if (s_workers[i]->thread.get_id() == id)
+			return (int)i;
+	}
+	return -1;
+}
+
+// Takes the newest task of worker `self`, or steals the oldest task of
+// another worker. `self` may be -1 for a thread outside the pool.
+static bool PopTask(int self, ThreadPoolTask& task)
+{
+	if (self >= 0)
+	{
+		Worker& worker = *s_workers[self];
+		std::lock_guard<std::mutex> lk(worker.lock);
+		if (!worker.tasks.empty())
+		{
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			AtomicDecrement(s_queued);
+			return true;
+		}
+	}
+
+	const int num_workers = (int)s_workers.size();
+	const int start = self < 0 ? 0 : self + 1;
+	for (int i = 0; i < num_workers; ++i)
+	{
+		Worker& victim = *s_workers[(start + i) % num_workers];
+		std::lock_guard<std::mutex> lk(victim.lock);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			AtomicDecrement(s_queued);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void PushTask(int worker_index, ThreadPoolTask&& task)
+{
+	{
+		std::lock_guard<std::mutex> sleep_lk(s_sleep_lock);
+		Worker& worker = *s_workers[worker_index];
+		std::lock_guard<std::mutex> lk(worker.lock);
+		worker.tasks.push_back(std::move(task));
+		// Counted under the deque lock so that PopTask never sees the
+		// task without the count.
+		AtomicIncrement(s_queued);
+	}
+	s_sleep_cond.notify_one();
+}
+
+static void WorkerThread(int index)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "Pool worker %d", index);
+	SetCurrentThreadName(name);
+
+	while (true)
+	{
+		ThreadPoolTask task;
+		if (PopTask(index, task))
+		{
+			task.Execute();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(s_sleep_lock);
+		s_sleep_cond.wait(lk, []{ return s_quit || AtomicLoad(s_queued) != 0; });
+		if (s_quit)
+			break;
+	}
+}
+
+void Init(int num_workers)
+{
+	std::lock_guard<std::mutex> lk(s_init_lock);
+	if (s_initialized)
+		return;
+
+	if (num_workers <= 0)
+		num_workers = (int)std::thread::hardware_concurrency() - 2;
+	num_workers = std::min(std::max(num_workers, 0), MAX_WORKERS);
+
+	s_quit = false;
+	s_queued = 0;
+	s_next_worker.store(0);
+	for (int i = 0; i < num_workers; ++i)
+		s_workers.push_back(std::unique_ptr<Worker>(new Worker));
+
+	// The vector must be complete before any worker looks at it.
+	for (int i = 0; i < num_workers; ++i)
+	{
+		s_workers[i]->thread = std::thread(WorkerThread, i);
+		if (s_reserved_cores)
+			ApplyAffinity(*s_workers[i]);
+	}
+
+	AtomicStoreRelease(s_initialized, true);
+}
+
+void Shutdown()
+{
+	std::lock_guard<std::mutex> lk(s_init_lock);
+	if (!s_initialized)
+		return;
+
+	{
+		std::lock_guard<std::mutex> sleep_lk(s_sleep_lock);
+		s_quit = true;
+	}
+	s_sleep_cond.notify_all();
+
+	for (auto& worker : s_workers)
+		worker->thread.join();
+	s_workers.clear();
+
+	s_initialized = false;
+}
+
+// Joins the workers before the statics above are destroyed.
+static struct ShutdownAtExit
+{
+	~ShutdownAtExit() { Shutdown(); }
+} s_shutdown_at_exit;
+
+static void EnsureInitialized()
+{
+	if (!AtomicLoadAcquire(s_initialized))
+		Init();
+}
+
+int GetNumWorkers()
+{
+	EnsureInitialized();
+	return (int)s_workers.size();
+}
+
+void SetReservedCores(u32 mask)
+{
+	std::lock_guard<std::mutex> lk(s_init_lock);
+	s_reserved_cores = mask;
+	if (s_initialized)
+	{
+		for (auto& worker : s_workers)
+			ApplyAffinity(*worker);
+	}
+}
+
+} // namespace ThreadPool
+
+TaskGroup::TaskGroup()
+	: m_pending(0)
+{
+	ThreadPool::EnsureInitialized();
+}
+
+TaskGroup::~TaskGroup()
+{
+	Wait();
+}
+
+void TaskGroup::Run(std::function<void()> task, int worker_hint)
+{
+	using namespace ThreadPool;
+
+	const int num_workers = (int)s_workers.size();
+	if (num_workers == 0)
+	{
+		task();
+		return;
+	}
+
+	int worker_index = worker_hint;
+	if (worker_index < 0)
+		worker_index = GetCurrentWorker();
+	if (worker_index < 0)
+		worker_index = (int)(s_next_worker.fetch_add(1) % num_workers);
+
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		++m_pending;
+	}
+
+	ThreadPoolTask pool_task;
+	pool_task.func = std::move(task);
+	pool_task.group = this;
+	PushTask(worker_index % num_workers, std::move(pool_task));
+}
+
+void TaskGroup::Wait()
+{
+	const int self = ThreadPool::GetCurrentWorker();
+
+	// Help out instead of blocking while there is anything queued. Once
+	// nothing is left, the remaining tasks of this group are running on
+	// other threads.
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			if (m_pending == 0)
+				return;
+		}
+
+		ThreadPoolTask task;
+		if (!ThreadPool::PopTask(self, task))
+			break;
+		task.Execute();
+	}
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_done.wait(lk, [this]{ return m_pending == 0; });
+}
+
+void TaskGroup::FinishTask()
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	if (--m_pending == 0)
+		m_done.notify_all();
+}
+
+} // namespace Common
@@ -0,0 +1,100 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+
+#include "CommonTypes.h"
+#include "Thread.h"
+
+// A process-wide pool of worker threads for subsystems that want to spread
+// work over the host cores without starting threads of their own.
+//
+// Every worker owns a deque of tasks. A worker takes new work from the back
+// of its own deque and, when that is empty, steals from the front of the
+// others. By default there are two fewer workers than host threads so that
+// the CPU and GPU emulation threads keep a core each.
+
+namespace Common
+{
+
+class TaskGroup;
+
+namespace ThreadPool
+{
+
+// Starts the workers. Called implicitly by the first task, so it only has
+// to be called explicitly to pick the worker count (0 means the default).
+void Init(int num_workers = 0);
+// Joins the workers. Every task group must have been waited on.
+void Shutdown();
+
+// Number of worker threads, not counting the thread that waits on a group.
+// Zero on hosts with too few cores, in which case tasks run inline.
+int GetNumWorkers();
+
+// Keeps the workers off the host cores in the mask, for threads that have
+// pinned themselves there with SetCurrentThreadAffinity. Pass 0 to let the
+// workers run anywhere again.
+void SetReservedCores(u32 mask);
+
+// Runs func(begin, end) over [0, count) split into at most one range per
+// worker plus one for the calling thread, and returns when all are done.
+template <typename Func>
+void ParallelFor(int count, Func func);
+
+} // namespace ThreadPool
+
+// A set of tasks that can be waited on together. Tasks may start more tasks,
+// on their own group or on a new one that they wait on before returning.
+class TaskGroup
+{
+public:
+	TaskGroup();
+	~TaskGroup();
+
+	// Queues a task. The hint picks the worker whose deque gets the task,
+	// otherwise tasks started by a worker stay on that worker and tasks
+	// from other threads are spread round-robin. Another worker may still
+	// steal it.
+	void Run(std::function<void()> task, int worker_hint = -1);
+
+	// Runs queued tasks on the calling thread until every task of the
+	// group has finished.
+	void Wait();
+
+private:
+	friend struct ThreadPoolTask;
+	void FinishTask();
+
+	std::mutex m_lock;
+	std::condition_variable m_done;
+	int m_pending;
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(int count, Func func)
+{
+	const int num_ranges = std::min(GetNumWorkers() + 1, count);
+	if (num_ranges <= 1)
+	{
+		if (count > 0)
+			func(0, count);
+		return;
+	}
+
+	const int per_range = (count + num_ranges - 1) / num_ranges;
+	TaskGroup group;
+	for (int begin = per_range; begin < count; begin += per_range)
+	{
+		const int end = std::min(begin + per_range, count);
+		group.Run([=]{ func(begin, end); });
+	}
+	func(0, per_range);
+	group.Wait();
+}
+
+} // namespace Common
@@ -33,6 +33,11 @@ public:
 	u64 GetTimeElapsed();
 
 	static u32 GetTimeMs();
+	// Monotonic time for measuring short intervals
+	static u64 GetTimeUs();
+	// Sleeps until GetTimeUs() reaches deadline. The OS sleep only gets within
+	// spin_us of it, the rest is spun away so that oversleeping doesn't add jitter.
+	static void SleepUntilUs(u64 deadline, u64 spin_us);
 
 private:
 	u64 m_LastTime;
@@ -41,7 +41,8 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		  "=S" (*ebx),
 		  "=c" (*ecx),
 		  "=d" (*edx)
-		: "a"  (*eax)
+		: "a"  (*eax),
+		  "c"  (*ecx)
 		: "rbx"
 		);
 #else
@@ -52,7 +53,8 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		  "=S" (*ebx),
 		  "=c" (*ecx),
 		  "=d" (*edx)
-		: "a"  (*eax)
+		: "a"  (*eax),
+		  "c"  (*ecx)
 		: "ebx"
 		);
 #endif
@@ -73,6 +75,21 @@ static void __cpuid(int info[4], int x)
 #endif
 }
 
+// For the functions with subleaves
+static void __cpuidex(int info[4], int x, int count)
+{
+#if defined __FreeBSD__
+	cpuid_count((unsigned int)x, (unsigned int)count, (unsigned int*)info);
+#else
+	unsigned int eax = x, ebx = 0, ecx = count, edx = 0;
+	do_cpuid(&eax, &ebx, &ecx, &edx);
+	info[0] = eax;
+	info[1] = ebx;
+	info[2] = ecx;
+	info[3] = edx;
+#endif
+}
+
 #define _XCR_XFEATURE_ENABLED_MASK 0
 static unsigned long long _xgetbv(unsigned int index)
 {
@@ -161,6 +178,7 @@ void CPUInfo::Detect()
 		if ((cpu_id[2] >> 19) & 1) bSSE4_1 = true;
 		if ((cpu_id[2] >> 20) & 1) bSSE4_2 = true;
 		if ((cpu_id[2] >> 25) & 1) bAES = true;
+		if ((cpu_id[2] >> 1)  & 1) bPCLMUL = true;
 
 		// To check DAZ support, we first need to check FXSAVE support.
 		if ((cpu_id[3] >> 24) & 1)
@@ -204,6 +222,10 @@ void CPUInfo::Detect()
 			}
 		}
 	}
+	if (max_std_fn >= 7 && bAVX) {
+		__cpuidex(cpu_id, 0x00000007, 0);
+		if ((cpu_id[1] >> 5) & 1) bAVX2 = true;
+	}
 	if (max_ex_fn >= 0x80000004) {
 		// Extract brand string
 		__cpuid(cpu_id, 0x80000002);
@@ -262,8 +284,10 @@ std::string CPUInfo::Summarize()
 	if (bSSE4_2) sum += ", SSE4.2";
 	if (HTT) sum += ", HTT";
 	if (bAVX) sum += ", AVX";
+	if (bAVX2) sum += ", AVX2";
 	if (bFMA) sum += ", FMA";
 	if (bAES) sum += ", AES";
+	if (bPCLMUL) sum += ", PCLMUL";
 	if (bLongMode) sum += ", 64-bit support";
 	return sum;
 }
@@ -70,6 +70,7 @@ enum NormalSSEOps
 void XEmitter::SetCodePtr(u8 *ptr)
 {
 	code = ptr;
+	code_write_offset = GetCodeWriteOffset(ptr);
 }
 
 const u8 *XEmitter::GetCodePtr() const
@@ -85,7 +86,7 @@ u8 *XEmitter::GetWritableCodePtr()
 void XEmitter::ReserveCodeSpace(int bytes)
 {
 	for (int i = 0; i < bytes; i++)
-		*code++ = 0xCC;
+		Write8(0xCC);
 }
 
 const u8 *XEmitter::AlignCode4()
@@ -156,22 +157,16 @@ void OpArg::WriteRex(XEmitter *emit, int opBits, int bits, int customOp) const
 #endif
 }
 
-void OpArg::WriteVex(XEmitter* emit, int size, int packed, Gen::X64Reg regOp1, Gen::X64Reg regOp2) const
+// pp selects the implied prefix: 0 = none, 1 = 0x66, 2 = 0xF3, 3 = 0xF2.
+// mmmmm (map_select in AMD manuals) the opcode map: 1 = 0x0F, 2 = 0x0F38,
+// 3 = 0x0F3A.
+void OpArg::WriteVex(XEmitter* emit, Gen::X64Reg regOp1, Gen::X64Reg regOp2, int L, int pp, int mmmmm, int W) const
 {
 	int R = !(regOp1 & 8);
 	int X = !(indexReg & 8);
 	int B = !(offsetOrBaseReg & 8);
 
-	// not so sure about this one...
-	int W = 0;
-
-	// aka map_select in AMD manuals
-	// only support VEX opcode map 1 for now (analog to secondary opcode map)
-	int mmmmm = 1;
-
 	int vvvv = (regOp2 == X64Reg::INVALID_REG) ? 0xf : (regOp2 ^ 0xf);
-	int L = size == 256;
-	int pp = (packed << 1) | (size == 64);
 
 	// do we need any VEX fields that only appear in the three-byte form?
 	if (X == 1 && B == 1 && W == 0 && mmmmm == 1)
@@ -473,13 +468,13 @@ void XEmitter::SetJumpTarget(const FixupBranch &branch)
 	{
 		s64 distance = (s64)(code - branch.ptr);
 		_assert_msg_(DYNA_REC, distance >= -0x80 && distance < 0x80, "Jump target too far away, needs force5Bytes = true");
-		branch.ptr[-1] = (u8)(s8)distance;
+		branch.ptr[code_write_offset - 1] = (u8)(s8)distance;
 	}
 	else if (branch.type == 1)
 	{
 		s64 distance = (s64)(code - branch.ptr);
 		_assert_msg_(DYNA_REC, distance >= -0x80000000LL && distance < 0x80000000LL, "Jump target too far away, needs indirect register");
-		((s32*)branch.ptr)[-1] = (s32)distance;
+		((s32*)(branch.ptr + code_write_offset))[-1] = (s32)distance;
 	}
 }
 
@@ -550,6 +545,8 @@ void XEmitter::XCHG_AHAL()
 void XEmitter::LAHF() {Write8(0x9F);}
 void XEmitter::SAHF() {Write8(0x9E);}
 
+void XEmitter::RDTSC() {Write8(0x0F); Write8(0x31);}
+
 void XEmitter::PUSHF() {Write8(0x9C);}
 void XEmitter::POPF()  {Write8(0x9D);}
 
@@ -1184,11 +1181,23 @@ void XEmitter::WriteAVXOp(int size, u8 sseOp, bool packed, X64Reg regOp, OpArg a
 
 void XEmitter::WriteAVXOp(int size, u8 sseOp, bool packed, X64Reg regOp1, X64Reg regOp2, OpArg arg, int extrabytes)
 {
-	arg.WriteVex(this, size, packed, regOp1, regOp2);
+	// Same implied prefixes as WriteSSEOp
+	int pp = packed ? (size == 64 ? 1 : 0) : (size == 64 ? 3 : 2);
+	arg.WriteVex(this, regOp1, regOp2, 0, pp, 1);
 	Write8(sseOp);
 	arg.WriteRest(this, extrabytes, regOp1);
 }
 
+// The FMA3 instructions are in the 0x0F38 map with a 0x66 prefix, VEX.W
+// selects double precision.
+void XEmitter::WriteFMA3Op(int size, u8 op, bool packed, X64Reg regOp1, X64Reg regOp2, OpArg arg)
+{
+	arg.WriteVex(this, regOp1, regOp2, 0, 1, 2, size == 64);
+	// The scalar forms are the packed opcode + 1
+	Write8(packed ? op : op + 1);
+	arg.WriteRest(this, 0, regOp1);
+}
+
 void XEmitter::MOVD_xmm(X64Reg dest, const OpArg &arg) {WriteSSEOp(64, 0x6E, true, dest, arg, 0);}
 void XEmitter::MOVD_xmm(const OpArg &arg, X64Reg src) {WriteSSEOp(64, 0x7E, true, src, arg, 0);}
 
@@ -1441,6 +1450,20 @@ void XEmitter::PSHUFB(X64Reg dest, OpArg arg) {
 	arg.WriteRest(this, 0);
 }
 
+void XEmitter::BLENDPD(X64Reg dest, OpArg arg, u8 blend) {
+	if (!cpu_info.bSSE4_1) {
+		PanicAlert("Trying to use BLENDPD on a system that doesn't support it. Bad programmer.");
+	}
+	Write8(0x66);
+	arg.operandReg = dest;
+	arg.WriteRex(this, 0, 0);
+	Write8(0x0f);
+	Write8(0x3a);
+	Write8(0x0d);
+	arg.WriteRest(this, 1);
+	Write8(blend);
+}
+
 void XEmitter::PAND(X64Reg dest, OpArg arg)     {WriteSSEOp(64, 0xDB, true, dest, arg);}
 void XEmitter::PANDN(X64Reg dest, OpArg arg)    {WriteSSEOp(64, 0xDF, true, dest, arg);}
 void XEmitter::PXOR(X64Reg dest, OpArg arg)     {WriteSSEOp(64, 0xEF, true, dest, arg);}
@@ -1498,6 +1521,23 @@ void XEmitter::VSUBSD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64,
 void XEmitter::VMULSD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseMUL, false, regOp1, regOp2, arg);}
 void XEmitter::VDIVSD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseDIV, false, regOp1, regOp2, arg);}
 void XEmitter::VSQRTSD(X64Reg regOp1, X64Reg regOp2, OpArg arg)  {WriteAVXOp(64, sseSQRT, false, regOp1, regOp2, arg);}
+void XEmitter::VADDPD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseADD, true, regOp1, regOp2, arg);}
+void XEmitter::VSUBPD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseSUB, true, regOp1, regOp2, arg);}
+void XEmitter::VMULPD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseMUL, true, regOp1, regOp2, arg);}
+void XEmitter::VDIVPD(X64Reg regOp1, X64Reg regOp2, OpArg arg)   {WriteAVXOp(64, sseDIV, true, regOp1, regOp2, arg);}
+
+void XEmitter::VFMADD132PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0x98, true, regOp1, regOp2, arg);}
+void XEmitter::VFMADD213PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xA8, true, regOp1, regOp2, arg);}
+void XEmitter::VFMADD231PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xB8, true, regOp1, regOp2, arg);}
+void XEmitter::VFMADD132SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0x98, false, regOp1, regOp2, arg);}
+void XEmitter::VFMADD213SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xA8, false, regOp1, regOp2, arg);}
+void XEmitter::VFMADD231SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xB8, false, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB132PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0x9A, true, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB213PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xAA, true, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB231PD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xBA, true, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB132SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0x9A, false, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB213SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xAA, false, regOp1, regOp2, arg);}
+void XEmitter::VFMSUB231SD(X64Reg regOp1, X64Reg regOp2, OpArg arg) {WriteFMA3Op(64, 0xBA, false, regOp1, regOp2, arg);}
 
 // Prefixes
 
@@ -113,7 +113,7 @@ struct OpArg
 		offset = _offset;
 	}
 	void WriteRex(XEmitter *emit, int opBits, int bits, int customOp = -1) const;
-	void WriteVex(XEmitter* emit, int size, int packed, Gen::X64Reg regOp1, X64Reg regOp2) const;
+	void WriteVex(XEmitter* emit, X64Reg regOp1, X64Reg regOp2, int L, int pp, int mmmmm, int W = 0) const;
 	void WriteRest(XEmitter *emit, int extraBytes=0, X64Reg operandReg=(X64Reg)0xFF, bool warn_64bit_offset = true) const;
 	void WriteSingleByteOp(XEmitter *emit, u8 op, X64Reg operandReg, int bits);
 	// This one is public - must be written to
@@ -232,6 +232,9 @@ class XEmitter
 	friend struct OpArg;  // for Write8 etc
 private:
 	u8 *code;
+	// Where the code is written relative to where it runs, see
+	// AllocateCodeMemory
+	ptrdiff_t code_write_offset;
 
 	void Rex(int w, int r, int x, int b);
 	void WriteSimple1Byte(int bits, u8 byte, X64Reg reg);
@@ -244,17 +247,18 @@ private:
 	void WriteSSEOp(int size, u8 sseOp, bool packed, X64Reg regOp, OpArg arg, int extrabytes = 0);
 	void WriteAVXOp(int size, u8 sseOp, bool packed, X64Reg regOp, OpArg arg, int extrabytes = 0);
 	void WriteAVXOp(int size, u8 sseOp, bool packed, X64Reg regOp1, X64Reg regOp2, OpArg arg, int extrabytes = 0);
+	void WriteFMA3Op(int size, u8 op, bool packed, X64Reg regOp1, X64Reg regOp2, OpArg arg);
 	void WriteNormalOp(XEmitter *emit, int bits, NormalOp op, const OpArg &a1, const OpArg &a2);
 
 protected:
-	inline void Write8(u8 value)   {*code++ = value;}
-	inline void Write16(u16 value) {*(u16*)code = (value); code += 2;}
-	inline void Write32(u32 value) {*(u32*)code = (value); code += 4;}
-	inline void Write64(u64 value) {*(u64*)code = (value); code += 8;}
+	inline void Write8(u8 value)   {code[code_write_offset] = value; code++;}
+	inline void Write16(u16 value) {*(u16*)(code + code_write_offset) = (value); code += 2;}
+	inline void Write32(u32 value) {*(u32*)(code + code_write_offset) = (value); code += 4;}
+	inline void Write64(u64 value) {*(u64*)(code + code_write_offset) = (value); code += 8;}
 
 public:
-	XEmitter() { code = NULL; }
-	XEmitter(u8 *code_ptr) { code = code_ptr; }
+	XEmitter() { code = NULL; code_write_offset = 0; }
+	XEmitter(u8 *code_ptr) { SetCodePtr(code_ptr); }
 	virtual ~XEmitter() {}
 
 	void WriteModRM(int mod, int rm, int reg);
@@ -292,6 +296,8 @@ public:
 	void LAHF(); // 3 cycle vector path
 	void SAHF(); // direct path fast
 
+	// Time stamp counter into EDX:EAX
+	void RDTSC();
 
 	// Stack control
 	void PUSH(X64Reg reg);
@@ -599,6 +605,7 @@ public:
 
 	void PMOVMSKB(X64Reg dest, OpArg arg);
 	void PSHUFB(X64Reg dest, OpArg arg);
+	void BLENDPD(X64Reg dest, OpArg arg, u8 blend);
 
 	void PSHUFLW(X64Reg dest, OpArg arg, u8 shuffle);
 
@@ -619,6 +626,27 @@ public:
 	void VMULSD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
 	void VDIVSD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
 	void VSQRTSD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VADDPD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VSUBPD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VMULPD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VDIVPD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+
+	// FMA3, the number gives the order of the operands:
+	// 132: regOp1 = regOp1 * arg + regOp2
+	// 213: regOp1 = regOp2 * regOp1 + arg
+	// 231: regOp1 = regOp2 * arg + regOp1
+	void VFMADD132PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMADD213PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMADD231PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMADD132SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMADD213SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMADD231SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB132PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB213PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB231PD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB132SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB213SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
+	void VFMSUB231SD(X64Reg regOp1, X64Reg regOp2, OpArg arg);
 
 	void RTDSC();
 
@@ -710,17 +738,20 @@ class XCodeBlock : public XEmitter
 {
 protected:
 	u8 *region;
+	// The same memory as region, where the host doesn't allow it to be
+	// writable and executable at once
+	u8 *writable_region;
 	size_t region_size;
 
 public:
-	XCodeBlock() : region(NULL), region_size(0) {}
+	XCodeBlock() : region(NULL), writable_region(NULL), region_size(0) {}
 	virtual ~XCodeBlock() { if (region) FreeCodeSpace(); }
 
 	// Call this before you generate any code.
 	void AllocCodeSpace(int size)
 	{
 		region_size = size;
-		region = (u8*)AllocateExecutableMemory(region_size);
+		region = (u8*)AllocateCodeMemory(region_size, &writable_region);
 		SetCodePtr(region);
 	}
 
@@ -729,18 +760,25 @@ public:
 	void ClearCodeSpace()
 	{
 		// x86/64: 0xCC = breakpoint
-		memset(region, 0xCC, region_size);
+		memset(writable_region, 0xCC, region_size);
 		ResetCodePtr();
 	}
 
 	// Call this when shutting down. Don't rely on the destructor, even though it'll do the job.
 	void FreeCodeSpace()
 	{
-		FreeMemoryPages(region, region_size);
+		FreeCodeMemory(region, region_size);
 		region = NULL;
+		writable_region = NULL;
 		region_size = 0;
 	}
 
+	// For writing to the code space other than through the emitter
+	u8 *GetWritableView(const u8 *ptr)
+	{
+		return writable_region + (ptr - region);
+	}
+
 	bool IsInSpace(u8 *ptr)
 	{
 		return ptr >= region && ptr < region + region_size;
@@ -750,7 +788,10 @@ public:
 	// Start over if you need to change the code (call FreeCodeSpace(), AllocCodeSpace()).
 	void WriteProtect()
 	{
-		WriteProtectMemory(region, region_size, true);
+		if (writable_region != region)
+			WriteProtectMemory(writable_region, region_size, false);
+		else
+			WriteProtectMemory(region, region_size, true);
 	}
 
 	void ResetCodePtr()
@@ -21,6 +21,17 @@ const u32 EXCEPTION_MASK = 0x1F80;
 const u32 DAZ = 0x40;
 // Flush-To-Zero (non-IEEE mode: denormal outputs are set to +/- 0)
 const u32 FTZ = 0x8000;
+// Sticky exception flags, which say nothing about the mode
+const u32 EXCEPTION_FLAGS = 0x3F;
+
+// ldmxcsr serializes the pipeline while stmxcsr is cheap, so only write
+// MXCSR when the mode really changes. Reading it back rather than caching
+// the last value keeps this right on every thread.
+static inline void SetCSR(u32 csr)
+{
+	if ((_mm_getcsr() & ~EXCEPTION_FLAGS) != (csr & ~EXCEPTION_FLAGS))
+		_mm_setcsr(csr);
+}
 
 namespace FPURoundMode
 {
@@ -52,6 +63,8 @@ namespace FPURoundMode
 			};
 			unsigned short _mode;
 			asm ("fstcw %0" : "=m" (_mode) : );
+			if ((_mode & FPU_ROUND_MASK) == table[mode])
+				return;
 			_mode = (_mode & ~FPU_ROUND_MASK) | table[mode];
 			asm ("fldcw %0" : : "m" (_mode));
 		#endif
@@ -106,7 +119,7 @@ namespace FPURoundMode
 		{
 			csr |= denormalLUT[cpu_info.bFlushToZero];
 		}
-		_mm_setcsr(csr);
+		SetCSR(csr);
 	}
 
 	void SaveSIMDState()
@@ -115,10 +128,10 @@ namespace FPURoundMode
 	}
 	void LoadSIMDState()
 	{
-		_mm_setcsr(saved_sse_state);
+		SetCSR(saved_sse_state);
 	}
 	void LoadDefaultSIMDState()
 	{
-		_mm_setcsr(default_sse_state);
+		SetCSR(default_sse_state);
 	}
 }
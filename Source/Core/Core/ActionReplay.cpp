@@ -79,6 +79,45 @@ static std::vector<ARCode> activeCodes;
 static bool logSelf = false;
 static std::vector<std::string> arLog;
 
+// The active codes decoded once for the runs after the first one, which
+// don't log anything. There's one line per line of the code, so skipping
+// lines works the same. Codes with lines other than RAM writes, pointer
+// writes, adds and conditionals are left to RunCode.
+struct CompiledLine
+{
+	enum Kind : u8
+	{
+		LINE_END,
+		LINE_NOP,
+		LINE_WRITE,
+		LINE_WRITE_POINTER,
+		LINE_ADD,
+		LINE_CONDITIONAL,
+	};
+
+	Kind kind;
+	u8 size;
+	u8 type;
+	u8 subtype;
+	u32 cmd_addr;
+	u32 data;
+	u32 address;
+	// Repeat count of a write, the value to compare for a conditional
+	u32 count;
+	// The whole range the line accesses in host memory, NULL when it isn't in
+	// one block of RAM
+	u8* ptr;
+};
+
+struct CompiledCode
+{
+	bool compiled;
+	std::vector<CompiledLine> lines;
+};
+
+static std::vector<CompiledCode> compiledCodes;
+static bool codesCompiled = false;
+
 struct ARAddr
 {
 	union
@@ -108,6 +147,8 @@ bool ZeroCode_MemoryCopy(const u32 val_last, const ARAddr addr, const u32 data);
 bool NormalCode(const ARAddr addr, const u32 data);
 bool ConditionalCode(const ARAddr addr, const u32 data, int* const pSkipCount);
 bool CompareValues(const u32 val1, const u32 val2, const int type);
+static void CompileActiveCodes();
+static bool RunCompiledCode(const CompiledCode& code);
 
 // ----------------------
 // AR Remote Functions
@@ -252,11 +293,26 @@ void RunAllActive()
 {
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableCheats)
 	{
-		for (auto& activeCode : activeCodes)
+		// The first run logs what the codes do, the compiled codes don't, and
+		// they write to RAM directly which skips the memory checks
+		const bool run_compiled = b_RanOnce && !Memory::HasMemChecks();
+		if (run_compiled && !codesCompiled)
+			CompileActiveCodes();
+
+		for (size_t i = 0; i < activeCodes.size(); ++i)
 		{
+			ARCode& activeCode = activeCodes[i];
 			if (activeCode.active)
 			{
-				activeCode.active = RunCode(activeCode);
+				if (run_compiled && compiledCodes[i].compiled)
+				{
+					current_code = &activeCode;
+					activeCode.active = RunCompiledCode(compiledCodes[i]);
+				}
+				else
+				{
+					activeCode.active = RunCode(activeCode);
+				}
 				LogInfo("\n");
 			}
 		}
@@ -461,6 +517,8 @@ void UpdateActiveList()
 	SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableCheats = false;
 	b_RanOnce = false;
 	activeCodes.clear();
+	compiledCodes.clear();
+	codesCompiled = false;
 	for (auto& arCode : arCodes)
 	{
 		if (arCode.active)
@@ -938,4 +996,260 @@ bool CompareValues(const u32 val1, const u32 val2, const int type)
 	}
 }
 
+// ----------------------
+// Compiled Codes
+static bool CompileLine(const AREntry& entry, CompiledLine* line)
+{
+	const ARAddr addr(entry.cmd_addr);
+	const u32 data = entry.value;
+
+	line->cmd_addr = entry.cmd_addr;
+	line->data = data;
+	line->address = addr.GCAddress();
+	line->size = addr.size;
+	line->type = addr.type;
+	line->subtype = addr.subtype;
+	line->count = 0;
+	line->ptr = NULL;
+
+	if (entry.cmd_addr >= 0x00002000 && entry.cmd_addr < 0x00003000)
+		return false;
+
+	if (entry.cmd_addr == 0)
+	{
+		switch (data >> 29)
+		{
+		case ZCODE_END:
+			line->kind = CompiledLine::LINE_END;
+			return true;
+		case ZCODE_NORM:
+			line->kind = CompiledLine::LINE_NOP;
+			return true;
+		default:
+			// The codes reading the next line, and the errors
+			return false;
+		}
+	}
+
+	static const u32 access_sizes[] = {1, 2, 4, 4};
+	u32 bytes = access_sizes[addr.size];
+	if (addr.type != 0)
+	{
+		line->kind = CompiledLine::LINE_CONDITIONAL;
+		static const u32 masks[] = {0xFF, 0xFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+		line->count = data & masks[addr.size];
+	}
+	else
+	{
+		switch (addr.subtype)
+		{
+		case SUB_RAM_WRITE:
+			line->kind = CompiledLine::LINE_WRITE;
+			if (addr.size == DATATYPE_8BIT)
+				line->count = (data >> 8) + 1;
+			else if (addr.size == DATATYPE_16BIT)
+				line->count = (data >> 16) + 1;
+			else
+				line->count = 1;
+			bytes *= line->count;
+			break;
+		case SUB_WRITE_POINTER:
+			line->kind = CompiledLine::LINE_WRITE_POINTER;
+			bytes = 4;
+			break;
+		case SUB_ADD_CODE:
+			line->kind = CompiledLine::LINE_ADD;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	line->ptr = Memory::GetRangePointer(line->address, bytes);
+	return true;
+}
+
+static void CompileActiveCodes()
+{
+	compiledCodes.resize(activeCodes.size());
+	for (size_t i = 0; i < activeCodes.size(); ++i)
+	{
+		CompiledCode& code = compiledCodes[i];
+		code.compiled = true;
+		code.lines.resize(activeCodes[i].ops.size());
+		for (size_t j = 0; j < code.lines.size() && code.compiled; ++j)
+			code.compiled = CompileLine(activeCodes[i].ops[j], &code.lines[j]);
+		if (!code.compiled)
+			code.lines.clear();
+	}
+	codesCompiled = true;
+}
+
+static u32 ReadCompiled(const CompiledLine& line)
+{
+	if (line.ptr)
+	{
+		switch (line.size)
+		{
+		case DATATYPE_8BIT:  return *line.ptr;
+		case DATATYPE_16BIT: return Common::swap16(*(u16*)line.ptr);
+		default:             return Common::swap32(*(u32*)line.ptr);
+		}
+	}
+
+	switch (line.size)
+	{
+	case DATATYPE_8BIT:  return Memory::Read_U8(line.address);
+	case DATATYPE_16BIT: return Memory::Read_U16(line.address);
+	default:             return Memory::Read_U32(line.address);
+	}
+}
+
+static void WriteCompiled(const CompiledLine& line, u32 value)
+{
+	if (line.ptr)
+	{
+		switch (line.size)
+		{
+		case DATATYPE_8BIT:  *line.ptr = (u8)value; break;
+		case DATATYPE_16BIT: *(u16*)line.ptr = Common::swap16((u16)value); break;
+		default:             *(u32*)line.ptr = Common::swap32(value); break;
+		}
+		return;
+	}
+
+	switch (line.size)
+	{
+	case DATATYPE_8BIT:  Memory::Write_U8((u8)value, line.address); break;
+	case DATATYPE_16BIT: Memory::Write_U16((u16)value, line.address); break;
+	default:             Memory::Write_U32(value, line.address); break;
+	}
+}
+
+static void RunCompiledWrite(const CompiledLine& line)
+{
+	switch (line.size)
+	{
+	case DATATYPE_8BIT:
+		if (line.ptr)
+		{
+			memset(line.ptr, line.data & 0xFF, line.count);
+		}
+		else
+		{
+			for (u32 i = 0; i < line.count; ++i)
+				Memory::Write_U8(line.data & 0xFF, line.address + i);
+		}
+		break;
+
+	case DATATYPE_16BIT:
+		if (line.ptr)
+		{
+			const u16 value = Common::swap16(line.data & 0xFFFF);
+			for (u32 i = 0; i < line.count; ++i)
+				((u16*)line.ptr)[i] = value;
+		}
+		else
+		{
+			for (u32 i = 0; i < line.count; ++i)
+				Memory::Write_U16(line.data & 0xFFFF, line.address + i * 2);
+		}
+		break;
+
+	default:
+		WriteCompiled(line, line.data);
+		break;
+	}
+}
+
+// Same as Subtype_WriteToPointer
+static void RunCompiledWritePointer(const CompiledLine& line)
+{
+	const u32 ptr = line.ptr ? Common::swap32(*(u32*)line.ptr) : Memory::Read_U32(line.address);
+
+	switch (line.size)
+	{
+	case DATATYPE_8BIT:
+		Memory::Write_U8(line.data & 0xFF, ptr + (line.data >> 8));
+		break;
+	case DATATYPE_16BIT:
+		Memory::Write_U16(line.data & 0xFFFF, ptr + ((line.data >> 16) << 1));
+		break;
+	default:
+		Memory::Write_U32(line.data, ptr);
+		break;
+	}
+}
+
+// Same as Subtype_AddCode
+static void RunCompiledAdd(const CompiledLine& line)
+{
+	if (line.size == DATATYPE_32BIT_FLOAT)
+	{
+		const u32 read = ReadCompiled(line);
+		const float fread = *((float*)&read) + (float)line.data;
+		WriteCompiled(line, *((u32*)&fread));
+	}
+	else
+	{
+		WriteCompiled(line, ReadCompiled(line) + line.data);
+	}
+}
+
+static bool RunCompiledCode(const CompiledCode& code)
+{
+	int skip_count = 0;
+
+	for (const CompiledLine& line : code.lines)
+	{
+		// after a conditional code, skip lines if needed, as in RunCode
+		if (skip_count)
+		{
+			if (skip_count > 0)
+				--skip_count;
+			else if (-CONDTIONAL_ALL_LINES == skip_count)
+				return true;
+			else if (-CONDTIONAL_ALL_LINES_UNTIL == skip_count)
+			{
+				if (0 == line.cmd_addr && 0x40000000 == line.data)
+					skip_count = 0;
+			}
+			continue;
+		}
+
+		switch (line.kind)
+		{
+		case CompiledLine::LINE_END:
+			return true;
+
+		case CompiledLine::LINE_NOP:
+			break;
+
+		case CompiledLine::LINE_WRITE:
+			RunCompiledWrite(line);
+			break;
+
+		case CompiledLine::LINE_WRITE_POINTER:
+			RunCompiledWritePointer(line);
+			break;
+
+		case CompiledLine::LINE_ADD:
+			RunCompiledAdd(line);
+			break;
+
+		case CompiledLine::LINE_CONDITIONAL:
+			if (!CompareValues(ReadCompiled(line), line.count, line.type))
+			{
+				if (line.subtype == CONDTIONAL_ONE_LINE || line.subtype == CONDTIONAL_TWO_LINES)
+					skip_count = line.subtype + 1;
+				else
+					skip_count = -(int)line.subtype;
+			}
+			break;
+		}
+	}
+
+	return true;
+}
+
 } // namespace ActionReplay
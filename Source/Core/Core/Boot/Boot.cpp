@@ -26,6 +26,7 @@
 #include "../Host.h"
 #include "../VolumeHandler.h"
 #include "../PatchEngine.h"
+#include "../State.h"
 #include "../PowerPC/SignatureDB.h"
 #include "../PowerPC/PPCSymbolDB.h"
 
@@ -188,6 +189,29 @@ bool CBoot::Load_BS2(const std::string& _rBootROMFilename)
 
 
 // Third boot step after BootManager and Core. See Call schedule in BootManager.cpp
+void CBoot::PatchFunctions()
+{
+	const SCoreStartupParameter& _StartupPara = SConfig::GetInstance().m_LocalCoreStartupParameter;
+
+	// Scan for common HLE functions
+	if (_StartupPara.bSkipIdle && !_StartupPara.bEnableDebugging)
+	{
+		PPCAnalyst::FindFunctionsCached(0x80004000, 0x811fffff, &g_symbolDB);
+		SignatureDB db;
+		if (db.Load((File::GetSysDirectory() + TOTALDB).c_str()))
+		{
+			db.Apply(&g_symbolDB);
+			HLE::PatchFunctions();
+			db.Clear();
+		}
+	}
+
+	/* Try to load the symbol map if there is one, and then scan it for
+		and eventually replace code */
+	if (LoadMapFromFilename())
+		HLE::PatchFunctions();
+}
+
 bool CBoot::BootUp()
 {
 	SCoreStartupParameter& _StartupPara =
@@ -196,6 +220,8 @@ bool CBoot::BootUp()
 	NOTICE_LOG(BOOT, "Booting %s", _StartupPara.m_strFilename.c_str());
 
 	g_symbolDB.Clear();
+	s_boot_snapshot.clear();
+	s_restore_boot_snapshot = false;
 	VideoInterface::Preset(_StartupPara.bNTSC);
 	switch (_StartupPara.m_BootType)
 	{
@@ -233,10 +259,21 @@ bool CBoot::BootUp()
 
 		_StartupPara.bWii = VolumeHandler::IsWii();
 
+		s_boot_snapshot = GetBootSnapshotPath(pVolume);
+		s_restore_boot_snapshot = !s_boot_snapshot.empty() && State::IsSnapshotUsable(s_boot_snapshot);
+
 		// HLE BS2 or not
-		if (_StartupPara.bHLE_BS2)
+		if (s_restore_boot_snapshot)
 		{
-			EmulatedBS2(_StartupPara.bWii);
+			// The memory and the CPU are set up by restoring the snapshot, the
+			// patches are all that's left of what the apploader run does
+			NOTICE_LOG(BOOT, "Booting from the snapshot %s", s_boot_snapshot.c_str());
+			PatchEngine::LoadPatches();
+		}
+		else if (_StartupPara.bHLE_BS2)
+		{
+			if (!EmulatedBS2(_StartupPara.bWii))
+				s_boot_snapshot.clear();
 		}
 		else if (!Load_BS2(_StartupPara.m_strBootROM))
 		{
@@ -244,23 +281,9 @@ bool CBoot::BootUp()
 			EmulatedBS2(_StartupPara.bWii);
 		}
 
-		// Scan for common HLE functions
-		if (_StartupPara.bSkipIdle && !_StartupPara.bEnableDebugging)
-		{
-			PPCAnalyst::FindFunctions(0x80004000, 0x811fffff, &g_symbolDB);
-			SignatureDB db;
-			if (db.Load((File::GetSysDirectory() + TOTALDB).c_str()))
-			{
-				db.Apply(&g_symbolDB);
-				HLE::PatchFunctions();
-				db.Clear();
-			}
-		}
-
-		/* Try to load the symbol map if there is one, and then scan it for
-			and eventually replace code */
-		if (LoadMapFromFilename())
-			HLE::PatchFunctions();
+		// Done on the restored code instead
+		if (!s_restore_boot_snapshot)
+			PatchFunctions();
 
 		// We don't need the volume any more
 		delete pVolume;
@@ -40,12 +40,19 @@ public:
 	static bool FindMapFile(std::string* existing_map_file,
 	                        std::string* writable_map_file);
 
+	// Called by the CPU thread before it starts running. Restores the boot
+	// snapshot if BootUp skipped the apploader for it, or saves one if the
+	// boot can be cached.
+	static void FinishBootSnapshot();
+
 private:
 	static void RunFunction(u32 _iAddr);
 
 	static void UpdateDebugger_MapLoaded(const char* _gameID = NULL);
 
 	static bool LoadMapFromFilename();
+	// Finds the functions to HLE in the code in memory and patches them
+	static void PatchFunctions();
 	static bool Boot_ELF(const char *filename);
 	static bool Boot_WiiWAD(const char *filename);
 
@@ -56,4 +63,10 @@ private:
 	static void Load_FST(bool _bIsWii);
 
 	static bool SetupWiiMemory(IVolume::ECountry country);
+
+	// Empty if the boot can't be cached
+	static std::string GetBootSnapshotPath(const IVolume* volume);
+	static std::string s_boot_snapshot;
+	// BootUp skipped the apploader, the CPU thread has to restore the snapshot
+	static bool s_restore_boot_snapshot;
 };
@@ -4,10 +4,11 @@
 
 #include "Boot_DOL.h"
 #include "FileUtil.h"
+#include "MappedFile.h"
 #include "../HW/Memmap.h"
 #include "CommonFuncs.h"
 
-CDolLoader::CDolLoader(u8* _pBuffer, u32 _Size)
+CDolLoader::CDolLoader(const u8* _pBuffer, u32 _Size)
 	: m_isWii(false)
 {
 	Initialize(_pBuffer, _Size);
@@ -16,16 +17,20 @@ CDolLoader::CDolLoader(u8* _pBuffer, u32 _Size)
 CDolLoader::CDolLoader(const char* _szFilename)
 	: m_isWii(false)
 {
-	const u64 size = File::GetSize(_szFilename);
-	u8* const tmpBuffer = new u8[(size_t)size];
-
+	// The sections are copied straight out of the mapping
+	File::MappedFile file;
+	if (file.Open(_szFilename))
 	{
-	File::IOFile pStream(_szFilename, "rb");
-	pStream.ReadBytes(tmpBuffer, (size_t)size);
+		Initialize(file.GetData(), (u32)file.GetSize());
+	}
+	else
+	{
+		memset(&m_dolheader, 0, sizeof(m_dolheader));
+		for (auto& sect : text_section)
+			sect = NULL;
+		for (auto& sect : data_section)
+			sect = NULL;
 	}
-
-	Initialize(tmpBuffer, (u32)size);
-	delete[] tmpBuffer;
 }
 
 CDolLoader::~CDolLoader()
@@ -43,7 +48,7 @@ CDolLoader::~CDolLoader()
 	}
 }
 
-void CDolLoader::Initialize(u8* _pBuffer, u32 _Size)
+void CDolLoader::Initialize(const u8* _pBuffer, u32 _Size)
 {
 	memcpy(&m_dolheader, _pBuffer, sizeof(SDolHeader));
 
@@ -88,25 +93,34 @@ void CDolLoader::Initialize(u8* _pBuffer, u32 _Size)
 	}
 }
 
+// A section in RAM is copied in one go, anything else goes through the
+// regular memory writes
+static void WriteSection(const u8* data, u32 address, u32 size)
+{
+	u8* dst = Memory::GetRangePointer(address, size);
+	if (dst)
+	{
+		memcpy(dst, data, size);
+		return;
+	}
+
+	for (u32 num = 0; num < size; num++)
+		Memory::Write_U8(data[num], address + num);
+}
+
 void CDolLoader::Load()
 {
 	// load all text (code) sections
 	for (int i = 0; i < DOL_NUM_TEXT; i++)
 	{
 		if (m_dolheader.textOffset[i] != 0)
-		{
-			for (u32 num = 0; num < m_dolheader.textSize[i]; num++)
-				Memory::Write_U8(text_section[i][num], m_dolheader.textAddress[i] + num);
-		}
+			WriteSection(text_section[i], m_dolheader.textAddress[i], m_dolheader.textSize[i]);
 	}
 
 	// load all data sections
 	for (int i = 0; i < DOL_NUM_DATA; i++)
 	{
 		if (m_dolheader.dataOffset[i] != 0)
-		{
-			for (u32 num = 0; num < m_dolheader.dataSize[i]; num++)
-				Memory::Write_U8(data_section[i][num], m_dolheader.dataAddress[i] + num);
-		}
+			WriteSection(data_section[i], m_dolheader.dataAddress[i], m_dolheader.dataSize[i]);
 	}
 }
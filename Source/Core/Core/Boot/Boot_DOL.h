@@ -10,7 +10,7 @@ class CDolLoader
 {
 public:
 	CDolLoader(const char* _szFilename);
-	CDolLoader(u8* _pBuffer, u32 _Size);
+	CDolLoader(const u8* _pBuffer, u32 _Size);
 	~CDolLoader();
 
 	bool IsWii()        { return m_isWii; }
@@ -50,5 +50,5 @@ private:
 	bool m_isWii;
 
 	// Copy sections to internal buffers
-	void Initialize(u8* _pBuffer, u32 _Size);
+	void Initialize(const u8* _pBuffer, u32 _Size);
 };
@@ -8,19 +8,14 @@
 #include "Boot_ELF.h"
 #include "ElfReader.h"
 #include "FileUtil.h"
+#include "MappedFile.h"
 
 bool CBoot::IsElfWii(const char *filename)
 {
-	/* We already check if filename existed before we called this function, so
-	   there is no need for another check, just read the file right away */
-
-	const u64 filesize = File::GetSize(filename);
-	u8 *const mem = new u8[(size_t)filesize];
-
-	{
-	File::IOFile f(filename, "rb");
-	f.ReadBytes(mem, (size_t)filesize);
-	}
+	// Only the code sections are read from the mapping
+	File::MappedFile file;
+	if (!file.Open(filename))
+		return false;
 
 	// Use the same method as the DOL loader uses: search for mfspr from HID4,
 	// which should only be used in Wii ELFs.
@@ -30,10 +25,10 @@ bool CBoot::IsElfWii(const char *filename)
 
 	u32 HID4_pattern = 0x7c13fba6;
 	u32 HID4_mask = 0xfc1fffff;
-	ElfReader reader(mem);
+	ElfReader reader(file.GetData());
 	bool isWii = false;
 
-	for (int i = 0; i < reader.GetNumSections(); ++i)
+	for (int i = 0; i < reader.GetNumSections() && !isWii; ++i)
 	{
 		if (reader.IsCodeSection(i))
 		{
@@ -49,22 +44,17 @@ bool CBoot::IsElfWii(const char *filename)
 		}
 	}
 
-	delete[] mem;
 	return isWii;
 }
 
 
 bool CBoot::Boot_ELF(const char *filename)
 {
-	const u64 filesize = File::GetSize(filename);
-	u8 *mem = new u8[(size_t)filesize];
-
-	{
-	File::IOFile f(filename, "rb");
-	f.ReadBytes(mem, (size_t)filesize);
-	}
+	File::MappedFile file;
+	if (!file.Open(filename))
+		return false;
 
-	ElfReader reader(mem);
+	ElfReader reader(file.GetData());
 	reader.LoadInto(0x80000000);
 	if (!reader.LoadSymbols())
 	{
@@ -77,7 +67,6 @@ bool CBoot::Boot_ELF(const char *filename)
 	}
 
 	PC = reader.GetEntryPoint();
-	delete[] mem;
 
 	return true;
 }
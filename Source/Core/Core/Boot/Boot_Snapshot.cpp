@@ -0,0 +1,107 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// The boot snapshot cache. Booting a disc with the emulated BS2 always ends
+// in the same state for the same disc and settings, so that state is saved
+// once and restored on later boots instead of running the apploader again.
+
+#include "Common.h"
+#include "CommonPaths.h"
+#include "FileUtil.h"
+#include "Hash.h"
+#include "StringUtil.h"
+
+#include "Boot.h"
+#include "../ConfigManager.h"
+#include "../Core.h"
+#include "../HW/EXI.h"
+#include "../HW/SI.h"
+#include "../Movie.h"
+#include "../NetPlayProto.h"
+#include "../State.h"
+#include "SysConf.h"
+
+std::string CBoot::s_boot_snapshot;
+bool CBoot::s_restore_boot_snapshot = false;
+
+static void AppendFile(std::string* data, const std::string& filename)
+{
+	std::string contents;
+	if (!filename.empty() && File::ReadFileToString(filename.c_str(), contents))
+		*data += contents;
+	*data += '\0';
+}
+
+std::string CBoot::GetBootSnapshotPath(const IVolume* volume)
+{
+	const SCoreStartupParameter& _StartupPara = SConfig::GetInstance().m_LocalCoreStartupParameter;
+
+	// Anything that records or syncs input has to see the boot happen
+	if (!_StartupPara.bBootSnapshotCache || !_StartupPara.bHLE_BS2 || !Core::GetStateFileName().empty() ||
+	    NetPlay::IsNetPlayRunning() || Movie::IsRecordingInput() || Movie::IsPlayingInput())
+		return "";
+
+	const std::string unique_id = volume->GetUniqueID();
+	if (unique_id.size() != 6)
+		return "";
+
+	// Everything the state after the apploader depends on besides the disc.
+	// The build is part of it, the emulation may change without the state
+	// version changing.
+	std::string config = StringFromFormat("%s %d %d %d %d %d %d %d %d %d %d",
+		scm_rev_git_str, _StartupPara.bWii, _StartupPara.bNTSC, _StartupPara.bForceNTSCJ,
+		_StartupPara.SelectedLanguage, _StartupPara.bDSPHLE, _StartupPara.bMMU, _StartupPara.bTLBHack,
+		_StartupPara.bProgressive, _StartupPara.bFastDiscSpeed, _StartupPara.bEnableCheats);
+	for (int i = 0; i < MAX_SI_CHANNELS; ++i)
+		config += StringFromFormat(" %d", SConfig::GetInstance().m_SIDevice[i]);
+	for (int i = 0; i < MAX_EXI_CHANNELS; ++i)
+		config += StringFromFormat(" %d", SConfig::GetInstance().m_EXIDevice[i]);
+	if (_StartupPara.bWii)
+	{
+		SysConf* sysconf = SConfig::GetInstance().m_SYSCONF;
+		config += StringFromFormat(" %d %d %d %d", sysconf->GetData<u8>("IPL.LNG"),
+			sysconf->GetData<u8>("IPL.AR"), sysconf->GetData<u8>("IPL.PGS"),
+			sysconf->GetData<u8>("IPL.E60"));
+	}
+	// The patches applied at boot come from the game INIs
+	AppendFile(&config, _StartupPara.m_strGameIniDefault);
+	AppendFile(&config, _StartupPara.m_strGameIniDefaultRevisionSpecific);
+	AppendFile(&config, _StartupPara.m_strGameIniLocal);
+
+	const u64 hash = GetHash64((const u8*)config.data(), (int)config.size(), 0);
+	return File::GetUserPath(D_CACHE_IDX) + "BootSnapshots" DIR_SEP +
+		StringFromFormat("%s_%02x_%016llx.sav", unique_id.c_str(), volume->GetRevision(), (unsigned long long)hash);
+}
+
+void CBoot::FinishBootSnapshot()
+{
+	if (s_boot_snapshot.empty())
+		return;
+
+	if (s_restore_boot_snapshot)
+	{
+		if (State::LoadSnapshot(s_boot_snapshot))
+		{
+			PatchFunctions();
+		}
+		else
+		{
+			// BootUp skipped the apploader, so there's nothing to fall back to
+			File::Delete(s_boot_snapshot);
+			PanicAlertT("The boot snapshot %s couldn't be loaded and was deleted. Please restart the game.",
+				s_boot_snapshot.c_str());
+		}
+	}
+	else
+	{
+		File::CreateFullPath(s_boot_snapshot);
+		if (State::SaveSnapshot(s_boot_snapshot))
+			NOTICE_LOG(BOOT, "Saved the boot snapshot %s", s_boot_snapshot.c_str());
+		else
+			WARN_LOG(BOOT, "Couldn't save the boot snapshot %s", s_boot_snapshot.c_str());
+	}
+
+	s_boot_snapshot.clear();
+	s_restore_boot_snapshot = false;
+}
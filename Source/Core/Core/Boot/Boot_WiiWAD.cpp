@@ -94,9 +94,12 @@ bool CBoot::Boot_WiiWAD(const char* _pFilename)
 	WII_IPC_HLE_Interface::SetDefaultContentFile(_pFilename);
 
 	std::unique_ptr<CDolLoader> pDolLoader;
-	if (pContent->m_pData)
+	if (pContent->IsInMemory())
 	{
-		pDolLoader.reset(new CDolLoader(pContent->m_pData, pContent->m_Size));
+		const u8* pData = pContent->GetData();
+		if (pData == NULL)
+			return false;
+		pDolLoader.reset(new CDolLoader(pData, pContent->m_Size));
 	}
 	else
 	{
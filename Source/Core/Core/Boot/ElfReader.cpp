@@ -2,9 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <string>
 
 #include "Common.h"
+#include "ThreadPool.h"
 #include "../Debugger/Debugger_SymbolMap.h"
 #include "../HW/Memmap.h"
 #include "../PowerPC/PPCSymbolDB.h"
@@ -56,26 +58,55 @@ static void byteswapSection(Elf32_Shdr &sec)
 	bswap(sec.sh_type);
 }
 
-ElfReader::ElfReader(void *ptr)
-{
-	base = (char*)ptr;
-	base32 = (u32 *)ptr;
-	header = (Elf32_Ehdr*)ptr;
-	byteswapHeader(*header);
-
-	segments = (Elf32_Phdr *)(base + header->e_phoff);
-	sections = (Elf32_Shdr *)(base + header->e_shoff);
+// Segments at least this big are copied by several threads, which also
+// spreads out the page faults of a mapped file
+static const u32 PARALLEL_COPY_SIZE = 0x400000;
+static const u32 COPY_CHUNK_SIZE = 0x100000;
 
-	for (int i = 0; i < GetNumSegments(); i++)
+ElfReader::ElfReader(const void *ptr)
+{
+	base = (const char*)ptr;
+	base32 = (const u32 *)ptr;
+	memcpy(&header, ptr, sizeof(header));
+	byteswapHeader(header);
+
+	segments.resize(header.e_phnum);
+	if (!segments.empty())
+		memcpy(segments.data(), base + header.e_phoff, segments.size() * sizeof(Elf32_Phdr));
+	sections.resize(header.e_shnum);
+	if (!sections.empty())
+		memcpy(sections.data(), base + header.e_shoff, sections.size() * sizeof(Elf32_Shdr));
+
+	for (auto& segment : segments)
 	{
-		byteswapSegment(segments[i]);
+		byteswapSegment(segment);
 	}
 
-	for (int i = 0; i < GetNumSections(); i++)
+	sectionAddrs.resize(sections.size());
+	for (size_t i = 0; i < sections.size(); i++)
 	{
 		byteswapSection(sections[i]);
+		sectionAddrs[i] = sections[i].sh_addr;
 	}
-	entryPoint = header->e_entry;
+	bRelocate = false;
+	entryPoint = header.e_entry;
+}
+
+static void CopySegment(u8 *dst, const u8 *src, u32 size)
+{
+	if (size < PARALLEL_COPY_SIZE)
+	{
+		memcpy(dst, src, size);
+		return;
+	}
+
+	const int num_chunks = (int)((size + COPY_CHUNK_SIZE - 1) / COPY_CHUNK_SIZE);
+	Common::ThreadPool::ParallelFor(num_chunks, [=](int begin, int end)
+	{
+		const u32 first = begin * COPY_CHUNK_SIZE;
+		const u32 last = std::min<u32>(end * COPY_CHUNK_SIZE, size);
+		memcpy(dst + first, src + first, last - first);
+	});
 }
 
 const char *ElfReader::GetSectionName(int section) const
@@ -84,7 +115,7 @@ const char *ElfReader::GetSectionName(int section) const
 		return NULL;
 
 	int nameOffset = sections[section].sh_name;
-	char *ptr = (char*)GetSectionDataPtr(header->e_shstrndx);
+	const char *ptr = (const char*)GetSectionDataPtr(header.e_shstrndx);
 
 	if (ptr)
 		return ptr + nameOffset;
@@ -94,13 +125,10 @@ const char *ElfReader::GetSectionName(int section) const
 
 bool ElfReader::LoadInto(u32 vaddr)
 {
-	DEBUG_LOG(MASTER_LOG,"String section: %i", header->e_shstrndx);
-
-//	sectionOffsets = new u32[GetNumSections()];
-//	sectionAddrs = new u32[GetNumSections()];
+	DEBUG_LOG(MASTER_LOG,"String section: %i", header.e_shstrndx);
 
 	// Should we relocate?
-	bRelocate = (header->e_type != ET_EXEC);
+	bRelocate = (header.e_type != ET_EXEC);
 
 	if (bRelocate)
 	{
@@ -112,32 +140,30 @@ bool ElfReader::LoadInto(u32 vaddr)
 		DEBUG_LOG(MASTER_LOG,"Prerelocated executable");
 	}
 
-	INFO_LOG(MASTER_LOG,"%i segments:", header->e_phnum);
+	INFO_LOG(MASTER_LOG,"%i segments:", header.e_phnum);
 
 	// First pass : Get the bits into RAM
-	u32 segmentVAddr[32];
-
 	u32 baseAddress = bRelocate?vaddr:0;
-	for (int i = 0; i < header->e_phnum; i++)
+	for (int i = 0; i < header.e_phnum; i++)
 	{
-		Elf32_Phdr *p = segments + i;
+		const Elf32_Phdr *p = &segments[i];
 
 		INFO_LOG(MASTER_LOG, "Type: %i Vaddr: %08x Filesz: %i Memsz: %i ", p->p_type, p->p_vaddr, p->p_filesz, p->p_memsz);
 
 		if (p->p_type == PT_LOAD)
 		{
-			segmentVAddr[i] = baseAddress + p->p_vaddr;
-			u32 writeAddr = segmentVAddr[i];
+			u32 writeAddr = baseAddress + p->p_vaddr;
 
 			const u8 *src = GetSegmentPtr(i);
-			u8 *dst = Memory::GetPointer(writeAddr);
 			u32 srcSize = p->p_filesz;
 			u32 dstSize = p->p_memsz;
-			u32 *s = (u32*)src;
-			u32 *d = (u32*)dst;
-			for (int j = 0; j < (int)(srcSize + 3) / 4; j++)
+			if (srcSize)
 			{
-				*d++ = /*_byteswap_ulong*/(*s++);
+				u8 *dst = Memory::GetRangePointer(writeAddr, srcSize);
+				if (dst)
+					CopySegment(dst, src, srcSize);
+				else
+					ERROR_LOG(MASTER_LOG, "Segment at %08x, size %08x doesn't fit in RAM", writeAddr, srcSize);
 			}
 			if (srcSize < dstSize)
 			{
@@ -147,36 +173,16 @@ bool ElfReader::LoadInto(u32 vaddr)
 		}
 	}
 
-	/*
-	LOG(MASTER_LOG,"%i sections:", header->e_shnum);
-
-	for (int i=0; i<GetNumSections(); i++)
-	{
-		Elf32_Shdr *s = &sections[i];
-		const char *name = GetSectionName(i);
-
-		u32 writeAddr = s->sh_addr + baseAddress;
-		sectionOffsets[i] = writeAddr - vaddr;
-		sectionAddrs[i] = writeAddr;
-
-		if (s->sh_flags & SHF_ALLOC)
-		{
-			LOG(MASTER_LOG,"Data Section found: %s     Sitting at %08x, size %08x", name, writeAddr, s->sh_size);
+	for (size_t i = 0; i < sections.size(); i++)
+		sectionAddrs[i] = sections[i].sh_addr + baseAddress;
 
-		}
-		else
-		{
-			LOG(MASTER_LOG,"NonData Section found: %s     Ignoring (size=%08x) (flags=%08x)", name, s->sh_size, s->sh_flags);
-		}
-	}
-*/
 	INFO_LOG(MASTER_LOG,"Done loading.");
 	return true;
 }
 
 SectionID ElfReader::GetSectionByName(const char *name, int firstSection) const
 {
-	for (int i = firstSection; i < header->e_shnum; i++)
+	for (int i = firstSection; i < header.e_shnum; i++)
 	{
 		const char *secname = GetSectionName(i);
 
@@ -196,7 +202,9 @@ bool ElfReader::LoadSymbols()
 		const char *stringBase = (const char *)GetSectionDataPtr(stringSection);
 
 		//We have a symbol table!
-		Elf32_Sym *symtab = (Elf32_Sym *)(GetSectionDataPtr(sec));
+		// Only the pages of the tables themselves are read, not the
+		// debug sections that make up most of a debug build
+		const Elf32_Sym *symtab = (const Elf32_Sym *)(GetSectionDataPtr(sec));
 		int numSymbols = sections[sec].sh_size / sizeof(Elf32_Sym);
 		for (int sym = 0; sym < numSymbols; sym++)
 		{
@@ -209,7 +217,7 @@ bool ElfReader::LoadSymbols()
 			int sectionIndex = Common::swap16(symtab[sym].st_shndx);
 			int value = Common::swap32(symtab[sym].st_value);
 			const char *name = stringBase + Common::swap32(symtab[sym].st_name);
-			if (bRelocate)
+			if (bRelocate && sectionIndex < (int)sectionAddrs.size())
 				value += sectionAddrs[sectionIndex];
 
 			int symtype = Symbol::SYMBOL_DATA;
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "ElfTypes.h"
 
 enum KnownElfTypes
@@ -19,38 +21,42 @@ typedef int SectionID;
 class ElfReader
 {
 private:
-	char *base;
-	u32 *base32;
+	// The file itself is only read, so it can be a read-only mapping. The
+	// headers are swapped into copies of their own.
+	const char *base;
+	const u32 *base32;
 
-	Elf32_Ehdr *header;
-	Elf32_Phdr *segments;
-	Elf32_Shdr *sections;
+	Elf32_Ehdr header;
+	std::vector<Elf32_Phdr> segments;
+	std::vector<Elf32_Shdr> sections;
 
-	u32 *sectionAddrs;
+	std::vector<u32> sectionAddrs;
 	bool bRelocate;
 	u32 entryPoint;
 
 public:
-	ElfReader(void *ptr);
+	ElfReader(const void *ptr);
 	~ElfReader() { }
 
 	u32 Read32(int off) const { return base32[off>>2]; }
 
 	// Quick accessors
-	ElfType GetType() const { return (ElfType)(header->e_type); }
-	ElfMachine GetMachine() const { return (ElfMachine)(header->e_machine); }
+	ElfType GetType() const { return (ElfType)(header.e_type); }
+	ElfMachine GetMachine() const { return (ElfMachine)(header.e_machine); }
 	u32 GetEntryPoint() const { return entryPoint; }
-	u32 GetFlags() const { return (u32)(header->e_flags); }
+	u32 GetFlags() const { return (u32)(header.e_flags); }
+	// Copies the loadable segments straight into emulated memory, big ones
+	// on several threads
 	bool LoadInto(u32 vaddr);
 	bool LoadSymbols();
 
-	int GetNumSegments() const { return (int)(header->e_phnum); }
-	int GetNumSections() const { return (int)(header->e_shnum); }
+	int GetNumSegments() const { return (int)(header.e_phnum); }
+	int GetNumSections() const { return (int)(header.e_shnum); }
 	const u8 *GetPtr(int offset) const { return (u8*)base + offset; }
 	const char *GetSectionName(int section) const;
 	const u8 *GetSectionDataPtr(int section) const
 	{
-		if (section < 0 || section >= header->e_shnum)
+		if (section < 0 || section >= header.e_shnum)
 			return 0;
 		if (sections[section].sh_type != SHT_NOBITS)
 			return GetPtr(sections[section].sh_offset);
@@ -61,7 +67,7 @@ public:
 	{
 		return sections[section].sh_type == SHT_PROGBITS;
 	}
-	const u8 *GetSegmentPtr(int segment)
+	const u8 *GetSegmentPtr(int segment) const
 	{
 		return GetPtr(segments[segment].p_offset);
 	}
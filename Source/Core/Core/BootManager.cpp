@@ -48,7 +48,7 @@ namespace BootManager
 struct ConfigCache
 {
 	bool valid, bCPUThread, bSkipIdle, bEnableFPRF, bMMU, bDCBZOFF, m_EnableJIT, bDSPThread,
-		bVBeamSpeedHack, bSyncGPU, bFastDiscSpeed, bMergeBlocks, bDSPHLE, bHLE_BS2, bTLBHack, bUseFPS;
+		bVBeamSpeedHack, bSyncGPU, bDeterministicDualCore, bFastDiscSpeed, bMergeBlocks, bDSPHLE, bHLE_BS2, bTLBHack, bUseFPS;
 	int iCPUCore, Volume;
 	int iWiimoteSource[MAX_BBMOTES];
 	SIDevices Pads[MAX_SI_CHANNELS];
@@ -104,6 +104,7 @@ bool BootCore(const std::string& _rFilename)
 		config_cache.bTLBHack = StartUp.bTLBHack;
 		config_cache.bVBeamSpeedHack = StartUp.bVBeamSpeedHack;
 		config_cache.bSyncGPU = StartUp.bSyncGPU;
+		config_cache.bDeterministicDualCore = StartUp.bDeterministicDualCore;
 		config_cache.bFastDiscSpeed = StartUp.bFastDiscSpeed;
 		config_cache.bMergeBlocks = StartUp.bMergeBlocks;
 		config_cache.bDSPHLE = StartUp.bDSPHLE;
@@ -223,6 +224,19 @@ bool BootCore(const std::string& _rFilename)
 		config_cache.bSetEXIDevice[1] = true;
 	}
 
+	// Only movies and netplay need dual core to run the same every time, and
+	// then its sync points take over from SyncGPU
+	if (NetPlay::IsNetPlayRunning())
+		StartUp.bDeterministicDualCore = true;
+	else if (Movie::IsPlayingInput() && Movie::IsConfigSaved())
+		StartUp.bDeterministicDualCore = Movie::IsDeterministicDualCore();
+	else if (!Movie::IsRecordingInput())
+		StartUp.bDeterministicDualCore = false;
+	if (!StartUp.bCPUThread)
+		StartUp.bDeterministicDualCore = false;
+	if (StartUp.bDeterministicDualCore)
+		StartUp.bSyncGPU = false;
+
 	// Run the game
 	// Init the core
 	if (!Core::Init())
@@ -253,6 +267,7 @@ void Stop()
 		StartUp.bTLBHack = config_cache.bTLBHack;
 		StartUp.bVBeamSpeedHack = config_cache.bVBeamSpeedHack;
 		StartUp.bSyncGPU = config_cache.bSyncGPU;
+		StartUp.bDeterministicDualCore = config_cache.bDeterministicDualCore;
 		StartUp.bFastDiscSpeed = config_cache.bFastDiscSpeed;
 		StartUp.bMergeBlocks = config_cache.bMergeBlocks;
 		StartUp.bDSPHLE = config_cache.bDSPHLE;
@@ -229,9 +229,29 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "CPUCore",          m_LocalCoreStartupParameter.iCPUCore);
 	ini.Set("Core", "Fastmem",          m_LocalCoreStartupParameter.bFastmem);
 	ini.Set("Core", "CPUThread",        m_LocalCoreStartupParameter.bCPUThread);
+	ini.Set("Core", "ThreadPlacement",  m_LocalCoreStartupParameter.bThreadPlacement);
+	ini.Set("Core", "CPUThreadCore",    m_LocalCoreStartupParameter.iCPUThreadCore);
+	ini.Set("Core", "GPUThreadCore",    m_LocalCoreStartupParameter.iGPUThreadCore);
 	ini.Set("Core", "DSPThread",        m_LocalCoreStartupParameter.bDSPThread);
+	ini.Set("Core", "DSPThreadBatched", m_LocalCoreStartupParameter.bDSPThreadBatched);
 	ini.Set("Core", "DSPHLE",           m_LocalCoreStartupParameter.bDSPHLE);
+	ini.Set("Core", "ParallelAXVoices", m_LocalCoreStartupParameter.bParallelAXVoices);
 	ini.Set("Core", "SkipIdle",         m_LocalCoreStartupParameter.bSkipIdle);
+	ini.Set("Core", "JITPersistentCache", m_LocalCoreStartupParameter.bJITPersistentCache);
+	ini.Set("Core", "ReadOnlyCaches",   m_LocalCoreStartupParameter.bReadOnlyCaches);
+	ini.Set("Core", "JITTieredCompilation", m_LocalCoreStartupParameter.bJITTieredCompilation);
+	ini.Set("Core", "JITInlineLeafFunctions", m_LocalCoreStartupParameter.bJITInlineLeafFunctions);
+	ini.Set("Core", "JITFastInterrupts", m_LocalCoreStartupParameter.bJITFastInterrupts);
+	ini.Set("Core", "RewindSeconds",    m_LocalCoreStartupParameter.iRewindSeconds);
+	ini.Set("Core", "RewindSnapshotsPerSecond", m_LocalCoreStartupParameter.iRewindSnapshotsPerSecond);
+	ini.Set("Core", "NetPlayRollbackFrames", m_LocalCoreStartupParameter.iNetPlayRollbackFrames);
+	ini.Set("Core", "InputPollInterval", m_LocalCoreStartupParameter.iInputPollInterval);
+	ini.Set("Core", "LateInputSampling", m_LocalCoreStartupParameter.bLateInputSampling);
+	ini.Set("Core", "DumpPerfTrace",    m_LocalCoreStartupParameter.bDumpPerfTrace);
+	ini.Set("Core", "PerfMap",          m_LocalCoreStartupParameter.bPerfMap);
+	ini.Set("Core", "JitDump",          m_LocalCoreStartupParameter.bJitDump);
+	ini.Set("Core", "TraceEntries",     m_LocalCoreStartupParameter.iTraceEntries);
+	ini.Set("Core", "BlockStatsInterval", m_LocalCoreStartupParameter.iBlockStatsInterval);
 	ini.Set("Core", "DefaultGCM",       m_LocalCoreStartupParameter.m_strDefaultGCM);
 	ini.Set("Core", "DVDRoot",          m_LocalCoreStartupParameter.m_strDVDRoot);
 	ini.Set("Core", "Apploader",        m_LocalCoreStartupParameter.m_strApploader);
@@ -239,6 +259,7 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "SelectedLanguage", m_LocalCoreStartupParameter.SelectedLanguage);
 	ini.Set("Core", "DPL2Decoder",      m_LocalCoreStartupParameter.bDPL2Decoder);
 	ini.Set("Core", "Latency",          m_LocalCoreStartupParameter.iLatency);
+	ini.Set("Core", "StretchWindow",    m_LocalCoreStartupParameter.iStretchWindow);
 	ini.Set("Core", "MemcardAPath",     m_strMemoryCardA);
 	ini.Set("Core", "MemcardBPath",     m_strMemoryCardB);
 	ini.Set("Core", "SlotA",            m_EXIDevice[0]);
@@ -263,12 +284,16 @@ void SConfig::SaveSettings()
 	// Movie
 	ini.Set("Movie", "PauseMovie", m_PauseMovie);
 	ini.Set("Movie", "Author", m_strMovieAuthor);
+	ini.Set("Movie", "VerifyInterval", m_MovieVerifyInterval);
+	ini.Set("Movie", "VerifySkipEFB", m_MovieVerifySkipEFB);
 
 	// DSP
 	ini.Set("DSP", "EnableJIT", m_EnableJIT);
 	ini.Set("DSP", "DumpAudio", m_DumpAudio);
+	ini.Set("DSP", "DumpAudioFLAC", m_DumpAudioFLAC);
 	ini.Set("DSP", "Backend", sBackend);
 	ini.Set("DSP", "Volume", m_Volume);
+	ini.Set("DSP", "TargetLatency", m_AudioTargetLatency);
 
 	// Fifo Player
 	ini.Set("FifoPlayer", "LoopReplay", m_LocalCoreStartupParameter.bLoopFifoReplay);
@@ -381,9 +406,29 @@ void SConfig::LoadSettings()
 #endif
 		ini.Get("Core", "Fastmem",           &m_LocalCoreStartupParameter.bFastmem,      true);
 		ini.Get("Core", "DSPThread",         &m_LocalCoreStartupParameter.bDSPThread,    false);
+		ini.Get("Core", "DSPThreadBatched",  &m_LocalCoreStartupParameter.bDSPThreadBatched, false);
 		ini.Get("Core", "DSPHLE",            &m_LocalCoreStartupParameter.bDSPHLE,       true);
+		ini.Get("Core", "ParallelAXVoices",  &m_LocalCoreStartupParameter.bParallelAXVoices, false);
 		ini.Get("Core", "CPUThread",         &m_LocalCoreStartupParameter.bCPUThread,    true);
+		ini.Get("Core", "ThreadPlacement",   &m_LocalCoreStartupParameter.bThreadPlacement, false);
+		ini.Get("Core", "CPUThreadCore",     &m_LocalCoreStartupParameter.iCPUThreadCore, -1);
+		ini.Get("Core", "GPUThreadCore",     &m_LocalCoreStartupParameter.iGPUThreadCore, -1);
 		ini.Get("Core", "SkipIdle",          &m_LocalCoreStartupParameter.bSkipIdle,     true);
+		ini.Get("Core", "JITPersistentCache", &m_LocalCoreStartupParameter.bJITPersistentCache, false);
+		ini.Get("Core", "ReadOnlyCaches",    &m_LocalCoreStartupParameter.bReadOnlyCaches, false);
+		ini.Get("Core", "JITTieredCompilation", &m_LocalCoreStartupParameter.bJITTieredCompilation, false);
+		ini.Get("Core", "JITInlineLeafFunctions", &m_LocalCoreStartupParameter.bJITInlineLeafFunctions, false);
+		ini.Get("Core", "JITFastInterrupts", &m_LocalCoreStartupParameter.bJITFastInterrupts, false);
+		ini.Get("Core", "RewindSeconds",     &m_LocalCoreStartupParameter.iRewindSeconds, 0);
+		ini.Get("Core", "RewindSnapshotsPerSecond", &m_LocalCoreStartupParameter.iRewindSnapshotsPerSecond, 60);
+		ini.Get("Core", "NetPlayRollbackFrames", &m_LocalCoreStartupParameter.iNetPlayRollbackFrames, 0);
+		ini.Get("Core", "InputPollInterval", &m_LocalCoreStartupParameter.iInputPollInterval, 0);
+		ini.Get("Core", "LateInputSampling", &m_LocalCoreStartupParameter.bLateInputSampling, false);
+		ini.Get("Core", "DumpPerfTrace",     &m_LocalCoreStartupParameter.bDumpPerfTrace, false);
+		ini.Get("Core", "PerfMap",           &m_LocalCoreStartupParameter.bPerfMap, false);
+		ini.Get("Core", "JitDump",           &m_LocalCoreStartupParameter.bJitDump, false);
+		ini.Get("Core", "TraceEntries",      &m_LocalCoreStartupParameter.iTraceEntries, 0);
+		ini.Get("Core", "BlockStatsInterval", &m_LocalCoreStartupParameter.iBlockStatsInterval, 0);
 		ini.Get("Core", "DefaultGCM",        &m_LocalCoreStartupParameter.m_strDefaultGCM);
 		ini.Get("Core", "DVDRoot",           &m_LocalCoreStartupParameter.m_strDVDRoot);
 		ini.Get("Core", "Apploader",         &m_LocalCoreStartupParameter.m_strApploader);
@@ -391,6 +436,7 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "SelectedLanguage",  &m_LocalCoreStartupParameter.SelectedLanguage, 0);
 		ini.Get("Core", "DPL2Decoder",       &m_LocalCoreStartupParameter.bDPL2Decoder, false);
 		ini.Get("Core", "Latency",           &m_LocalCoreStartupParameter.iLatency, 2);
+		ini.Get("Core", "StretchWindow",     &m_LocalCoreStartupParameter.iStretchWindow, 10);
 		ini.Get("Core", "MemcardAPath",      &m_strMemoryCardA);
 		ini.Get("Core", "MemcardBPath",      &m_strMemoryCardB);
 		ini.Get("Core", "SlotA",       (int*)&m_EXIDevice[0], EXIDEVICE_MEMORYCARD);
@@ -399,6 +445,9 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "BBA_MAC",           &m_bba_mac);
 		ini.Get("Core", "TimeProfiling",     &m_LocalCoreStartupParameter.bJITILTimeProfiling, false);
 		ini.Get("Core", "OutputIR",          &m_LocalCoreStartupParameter.bJITILOutputIR,      false);
+		ini.Get("Core", "ILCommonSubexpressions", &m_LocalCoreStartupParameter.bJITILCommonSubexpressions, true);
+		ini.Get("Core", "ILStoreForwarding", &m_LocalCoreStartupParameter.bJITILStoreForwarding, false);
+		ini.Get("Core", "ILDeadStores",      &m_LocalCoreStartupParameter.bJITILDeadStores,    true);
 		for (int i = 0; i < MAX_SI_CHANNELS; ++i)
 		{
 			ini.Get("Core", StringFromFormat("SIDevice%i", i), (u32*)&m_SIDevice[i], (i == 0) ? SIDEVICE_GC_CONTROLLER : SIDEVICE_NONE);
@@ -414,7 +463,12 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "BBDumpPort",                &m_LocalCoreStartupParameter.iBBDumpPort,       -1);
 		ini.Get("Core", "VBeam",                     &m_LocalCoreStartupParameter.bVBeamSpeedHack,   false);
 		ini.Get("Core", "SyncGPU",                   &m_LocalCoreStartupParameter.bSyncGPU,          false);
+		ini.Get("Core", "SyncGpuMaxDistance",        &m_LocalCoreStartupParameter.iSyncGpuMaxDistance, 0);
+		ini.Get("Core", "DeterministicDualCore",     &m_LocalCoreStartupParameter.bDeterministicDualCore, true);
 		ini.Get("Core", "FastDiscSpeed",             &m_LocalCoreStartupParameter.bFastDiscSpeed,    false);
+		ini.Get("Core", "SharedDiscCache",           &m_LocalCoreStartupParameter.bSharedDiscCache,  false);
+		ini.Get("Core", "NANDTiming",                &m_LocalCoreStartupParameter.bNANDTiming,       false);
+		ini.Get("Core", "BootSnapshotCache",         &m_LocalCoreStartupParameter.bBootSnapshotCache, false);
 		ini.Get("Core", "DCBZ",                      &m_LocalCoreStartupParameter.bDCBZOFF,          false);
 		ini.Get("Core", "FrameLimit",                &m_Framelimit,                                  1); // auto frame limit by default
 
@@ -424,10 +478,13 @@ void SConfig::LoadSettings()
 		// Movie
 		ini.Get("Movie", "PauseMovie", &m_PauseMovie, false);
 		ini.Get("Movie", "Author", &m_strMovieAuthor, "");
+		ini.Get("Movie", "VerifyInterval", &m_MovieVerifyInterval, 60);
+		ini.Get("Movie", "VerifySkipEFB", &m_MovieVerifySkipEFB, false);
 
 		// DSP
 		ini.Get("DSP", "EnableJIT", &m_EnableJIT, true);
 		ini.Get("DSP", "DumpAudio", &m_DumpAudio, false);
+		ini.Get("DSP", "DumpAudioFLAC", &m_DumpAudioFLAC, false);
 	#if defined __linux__ && HAVE_ALSA
 		ini.Get("DSP", "Backend", &sBackend, BACKEND_ALSA);
 	#elif defined __APPLE__
@@ -440,6 +497,7 @@ void SConfig::LoadSettings()
 		ini.Get("DSP", "Backend", &sBackend, BACKEND_NULLSOUND);
 	#endif
 		ini.Get("DSP", "Volume", &m_Volume, 100);
+		ini.Get("DSP", "TargetLatency", &m_AudioTargetLatency, 40);
 
 		ini.Get("FifoPlayer", "LoopReplay", &m_LocalCoreStartupParameter.bLoopFifoReplay, true);
 	}
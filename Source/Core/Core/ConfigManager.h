@@ -75,11 +75,17 @@ struct SConfig : NonCopyable
 	bool m_PauseMovie;
 	bool m_ShowLag;
 	std::string m_strMovieAuthor;
+	int m_MovieVerifyInterval;
+	bool m_MovieVerifySkipEFB;
 
 	// DSP settings
 	bool m_EnableJIT;
 	bool m_DumpAudio;
+	// Dump to audiodump.flac instead of audiodump.wav
+	bool m_DumpAudioFLAC;
 	int m_Volume;
+	// Milliseconds of audio the mixer keeps queued
+	int m_AudioTargetLatency;
 	std::string sBackend;
 
 	SysConf* m_SYSCONF;
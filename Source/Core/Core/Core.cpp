@@ -14,7 +14,11 @@
 #include "CommonPaths.h"
 #include "StringUtil.h"
 #include "MathUtil.h"
+#include "JitRegister.h"
 #include "MemoryUtil.h"
+#include "PerfTrace.h"
+#include "ThreadPlacement.h"
+#include "ThreadPool.h"
 
 #include "Core.h"
 #include "CPUDetect.h"
@@ -39,6 +43,7 @@
 #include "IPC_HLE/WII_IPC_HLE_Device_usb.h"
 
 #include "PowerPC/PowerPC.h"
+#include "PowerPC/Profiler.h"
 #ifdef USE_GDBSTUB
 #include "PowerPC/GDBStub.h"
 #endif
@@ -47,6 +52,7 @@
 #include "ConfigManager.h"
 #include "VideoBackendBase.h"
 #include "AudioCommon.h"
+#include "ControllerInterface/ControllerInterface.h"
 #include "OnScreenDisplay.h"
 
 #include "VolumeHandler.h"
@@ -60,6 +66,7 @@
 #include "Movie.h"
 #include "NetPlayProto.h"
 #include "PatchEngine.h"
+#include "Tracer.h"
 
 // TODO: ugly, remove
 bool g_aspect_wide;
@@ -224,16 +231,22 @@ bool Init()
 // Called from GUI thread
 void Stop()  // - Hammertime!
 {
+	const SCoreStartupParameter& _CoreParameter =
+		SConfig::GetInstance().m_LocalCoreStartupParameter;
+
 	if (PowerPC::GetState() == PowerPC::CPU_POWERDOWN)
 	{
 		if (g_EmuThread.joinable())
+		{
+			// The CPU stopped by itself, like the FIFO player does at the end
+			// of a log, but the video loop still runs until it is told to exit.
+			if (_CoreParameter.bCPUThread)
+				g_video_backend->Video_ExitLoop();
 			g_EmuThread.join();
+		}
 		return;
 	}
 
-	const SCoreStartupParameter& _CoreParameter =
-		SConfig::GetInstance().m_LocalCoreStartupParameter;
-
 	g_bStopping = true;
 
 	g_video_backend->EmuStateChange(EMUSTATE_CHANGE_STOP);
@@ -299,14 +312,19 @@ void CpuThread()
 		Common::SetCurrentThreadName("CPU-GPU thread");
 		g_video_backend->Video_Prepare();
 	}
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_CPU);
 
 	#if defined(_M_X64) || _M_ARM
 	if (_CoreParameter.bFastmem)
 		EMM::InstallExceptionHandler(); // Let's run under memory watch
 	#endif
 
+	Profiler::InitCPUThread();
+
 	if (!g_stateFileName.empty())
 		State::LoadAs(g_stateFileName);
+	else
+		CBoot::FinishBootSnapshot();
 
 	g_bStarted = true;
 
@@ -323,6 +341,8 @@ void CpuThread()
 	// Enter CPU run loop. When we leave it - we are done.
 	CCPU::Run();
 
+	Profiler::ShutdownCPUThread();
+
 	g_bStarted = false;
 
 	if (!_CoreParameter.bCPUThread)
@@ -344,6 +364,7 @@ void FifoPlayerThread()
 		g_video_backend->Video_Prepare();
 		Common::SetCurrentThreadName("FIFO-GPU thread");
 	}
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_CPU);
 
 	g_bStarted = true;
 
@@ -382,9 +403,32 @@ void EmuThread()
 
 	Movie::Init();
 
-	HW::Init();
-
-	if (!g_video_backend->Initialize(g_pWindowHandle))
+	// Before anything starts threads, so that the thread pool is kept off the
+	// CPU and GPU cores from its first task
+	Common::ThreadPlacement::Init(_CoreParameter.bThreadPlacement, _CoreParameter.bCPUThread,
+		_CoreParameter.iCPUThreadCore, _CoreParameter.iGPUThreadCore);
+
+	// The video backend keeps this up to date with its frame time overlay
+	PerfTrace::Clear();
+	PerfTrace::SetEnabled(_CoreParameter.bDumpPerfTrace);
+	JitRegister::Init(_CoreParameter.bPerfMap, _CoreParameter.bJitDump);
+	if (_CoreParameter.iTraceEntries > 0)
+		Tracer::Start(_CoreParameter.iTraceEntries);
+	// The blocks are only timed if they are compiled with profiling
+	if (_CoreParameter.iBlockStatsInterval > 0)
+		Profiler::g_ProfileBlocks = true;
+
+	// The subsystems are started at the same time where they don't depend on
+	// each other. The hardware doesn't need the video backend, which has to
+	// stay on this thread for its context and only needs the window. Input and
+	// the DSP emulator both need the hardware and the render window the
+	// backend opens, but not each other.
+	Common::TaskGroup hw_init;
+	hw_init.Run([] { HW::Init(); });
+
+	const bool video_initialized = g_video_backend->Initialize(g_pWindowHandle);
+	hw_init.Wait();
+	if (!video_initialized)
 	{
 		PanicAlert("Failed to initialize video backend!");
 		Host_Message(WM_USER_STOP);
@@ -393,9 +437,32 @@ void EmuThread()
 
 	OSD::AddMessage("Dolphin " + g_video_backend->GetName() + " Video Backend.", 5000);
 
-	if (!DSP::GetDSPEmulator()->Initialize(g_pWindowHandle,
-		_CoreParameter.bWii, _CoreParameter.bDSPThread))
+	Common::TaskGroup input_init;
+	input_init.Run([&_CoreParameter]
 	{
+		g_controller_interface.SetPollInterval(std::max(_CoreParameter.iInputPollInterval, 0));
+		Pad::Initialize(g_pWindowHandle);
+		// Load and Init Wiimotes - only if we are booting in wii mode
+		if (g_CoreStartupParameter.bWii)
+		{
+			Wiimote::Initialize(g_pWindowHandle, !g_stateFileName.empty());
+
+			// Activate wiimotes which don't have source set to "None"
+			for (unsigned int i = 0; i != MAX_BBMOTES; ++i)
+				if (g_wiimote_sources[i])
+					GetUsbPointer()->AccessWiiMote(i | 0x100)->Activate(true);
+
+		}
+	});
+
+	const bool dsp_initialized = DSP::GetDSPEmulator()->Initialize(g_pWindowHandle,
+		_CoreParameter.bWii, _CoreParameter.bDSPThread);
+	input_init.Wait();
+	if (!dsp_initialized)
+	{
+		Pad::Shutdown();
+		Wiimote::Shutdown();
+		g_controller_interface.SetPollInterval(0);
 		HW::Shutdown();
 		g_video_backend->Shutdown();
 		PanicAlert("Failed to initialize DSP emulator!");
@@ -403,19 +470,6 @@ void EmuThread()
 		return;
 	}
 
-	Pad::Initialize(g_pWindowHandle);
-	// Load and Init Wiimotes - only if we are booting in wii mode
-	if (g_CoreStartupParameter.bWii)
-	{
-		Wiimote::Initialize(g_pWindowHandle, !g_stateFileName.empty());
-
-		// Activate wiimotes which don't have source set to "None"
-		for (unsigned int i = 0; i != MAX_BBMOTES; ++i)
-			if (g_wiimote_sources[i])
-				GetUsbPointer()->AccessWiiMote(i | 0x100)->Activate(true);
-
-	}
-
 	// The hardware is initialized.
 	g_bHwInit = true;
 
@@ -451,6 +505,7 @@ void EmuThread()
 		// This thread, after creating the EmuWindow, spawns a CPU
 		// thread, and then takes over and becomes the video thread
 		Common::SetCurrentThreadName("Video thread");
+		Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_GPU);
 
 		g_video_backend->Video_Prepare();
 
@@ -512,7 +567,28 @@ void EmuThread()
 	INFO_LOG(CONSOLE, "%s", StopMessage(false, "HW shutdown").c_str());
 	Pad::Shutdown();
 	Wiimote::Shutdown();
+	// The GUI polls by itself when the game isn't running
+	g_controller_interface.SetPollInterval(0);
 	g_video_backend->Shutdown();
+
+	if (_CoreParameter.bDumpPerfTrace)
+	{
+		const std::string filename = File::GetUserPath(D_DUMP_IDX) + "perftrace.json";
+		if (PerfTrace::ExportChromeTrace(filename))
+			NOTICE_LOG(CONSOLE, "Wrote performance trace to %s", filename.c_str());
+	}
+	PerfTrace::SetEnabled(false);
+	JitRegister::Shutdown();
+	Common::ThreadPlacement::Shutdown();
+
+	if (Tracer::IsRecording())
+	{
+		Tracer::Stop();
+		const std::string filename = StringFromFormat("%s%s_cpu%d.trace", File::GetUserPath(D_DUMP_IDX).c_str(),
+			_CoreParameter.m_strUniqueID.c_str(), _CoreParameter.iCPUCore);
+		if (Tracer::Save(filename))
+			NOTICE_LOG(CONSOLE, "Wrote CPU trace to %s", filename.c_str());
+	}
 }
 
 // Set or get the running state
@@ -10,6 +10,7 @@
 #include "NANDContentLoader.h"
 
 #include "VolumeCreator.h" // DiscIO
+#include "SharedBlockCache.h"
 
 #include "Boot/Boot.h" // Core
 #include "Boot/Boot_DOL.h"
@@ -32,15 +33,23 @@ SCoreStartupParameter::SCoreStartupParameter()
   bJITPairedOff(false), bJITSystemRegistersOff(false),
   bJITBranchOff(false),
   bJITILTimeProfiling(false), bJITILOutputIR(false),
+  bJITILCommonSubexpressions(true), bJITILStoreForwarding(false),
+  bJITILDeadStores(true),
+  bJITPersistentCache(false), bReadOnlyCaches(false), bJITTieredCompilation(false),
+  bJITInlineLeafFunctions(false), bJITFastInterrupts(false),
   bEnableFPRF(false),
-  bCPUThread(true), bDSPThread(false), bDSPHLE(true),
+  bCPUThread(true), bThreadPlacement(false), iCPUThreadCore(-1), iGPUThreadCore(-1), bDSPThread(false), bDSPThreadBatched(false), bDSPHLE(true), bParallelAXVoices(false),
   bSkipIdle(true), bNTSC(false), bForceNTSCJ(false),
   bHLE_BS2(true), bEnableCheats(false),
   bMergeBlocks(false), bEnableMemcardSaving(true),
-  bDPL2Decoder(false), iLatency(14),
+  bDPL2Decoder(false), iLatency(14), iStretchWindow(10),
   bRunCompareServer(false), bRunCompareClient(false),
   bMMU(false), bDCBZOFF(false), bTLBHack(false), iBBDumpPort(0), bVBeamSpeedHack(false),
-  bSyncGPU(false), bFastDiscSpeed(false),
+  bSyncGPU(false), iSyncGpuMaxDistance(0), bDeterministicDualCore(true), bFastDiscSpeed(false), bSharedDiscCache(false), bNANDTiming(false),
+  bBootSnapshotCache(false),
+  iRewindSeconds(0), iRewindSnapshotsPerSecond(60), iNetPlayRollbackFrames(0),
+  iInputPollInterval(0), bLateInputSampling(false),
+  bDumpPerfTrace(false), bPerfMap(false), bJitDump(false), iTraceEntries(0), iBlockStatsInterval(0),
   SelectedLanguage(0), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -79,13 +88,29 @@ void SCoreStartupParameter::LoadDefaults()
 	iBBDumpPort = -1;
 	bVBeamSpeedHack = false;
 	bSyncGPU = false;
+	iSyncGpuMaxDistance = 0;
+	bDeterministicDualCore = true;
 	bFastDiscSpeed = false;
+	bSharedDiscCache = false;
+	bNANDTiming = false;
+	bBootSnapshotCache = false;
+	iRewindSeconds = 0;
+	iRewindSnapshotsPerSecond = 60;
+	iNetPlayRollbackFrames = 0;
+	iInputPollInterval = 0;
+	bLateInputSampling = false;
+	bDumpPerfTrace = false;
+	bPerfMap = false;
+	bJitDump = false;
+	iTraceEntries = 0;
+	iBlockStatsInterval = 0;
 	bMergeBlocks = false;
 	bEnableMemcardSaving = true;
 	SelectedLanguage = 0;
 	bWii = false;
 	bDPL2Decoder = false;
 	iLatency = 14;
+	iStretchWindow = 10;
 
 	iPosX = 100;
 	iPosY = 100;
@@ -111,6 +136,9 @@ bool SCoreStartupParameter::AutoSetup(EBootBS2 _BootBS2)
 {
 	std::string Region(EUR_DIR);
 
+	DiscIO::SharedBlockCache::SetDirectory(bSharedDiscCache ?
+		File::GetUserPath(D_CACHE_IDX) + "SharedDisc" DIR_SEP : "");
+
 	switch (_BootBS2)
 	{
 	case BOOT_DEFAULT:
@@ -131,6 +159,7 @@ bool SCoreStartupParameter::AutoSetup(EBootBS2 _BootBS2)
 				!strcasecmp(Extension.c_str(), ".wbfs") ||
 				!strcasecmp(Extension.c_str(), ".ciso") ||
 				!strcasecmp(Extension.c_str(), ".gcz") ||
+				!strcasecmp(Extension.c_str(), ".dcz") ||
 				bootDrive)
 			{
 				m_BootType = BOOT_ISO;
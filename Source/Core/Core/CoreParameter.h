@@ -112,13 +112,29 @@ struct SCoreStartupParameter
 	bool bJITBranchOff;
 	bool bJITILTimeProfiling;
 	bool bJITILOutputIR;
+	bool bJITILCommonSubexpressions;
+	bool bJITILStoreForwarding;
+	bool bJITILDeadStores;
+	bool bJITPersistentCache;
+	// Only read the shader and JIT caches, so that instances can share them
+	bool bReadOnlyCaches;
+	bool bJITTieredCompilation;
+	bool bJITInlineLeafFunctions;
+	bool bJITFastInterrupts;
 
 	bool bFastmem;
 	bool bEnableFPRF;
 
 	bool bCPUThread;
+	// Pin the CPU and GPU threads to physical cores of their own; the core
+	// indices are -1 to pick them automatically
+	bool bThreadPlacement;
+	int iCPUThreadCore;
+	int iGPUThreadCore;
 	bool bDSPThread;
+	bool bDSPThreadBatched;
 	bool bDSPHLE;
+	bool bParallelAXVoices;
 	bool bSkipIdle;
 	bool bNTSC;
 	bool bForceNTSCJ;
@@ -129,6 +145,8 @@ struct SCoreStartupParameter
 
 	bool bDPL2Decoder;
 	int iLatency;
+	// Segment length in ms of the time stretching
+	int iStretchWindow;
 
 	bool bRunCompareServer;
 	bool bRunCompareClient;
@@ -139,7 +157,38 @@ struct SCoreStartupParameter
 	int iBBDumpPort;
 	bool bVBeamSpeedHack;
 	bool bSyncGPU;
+	// How many CPU cycles the CPU may run ahead of the GPU with bSyncGPU,
+	// 0 keeps them in lockstep
+	int iSyncGpuMaxDistance;
+	// Dual core only passes GPU results to the CPU at fixed sync points, so
+	// movies and netplay stay in sync with the CPU thread on
+	bool bDeterministicDualCore;
 	bool bFastDiscSpeed;
+	// Share decompressed and decrypted disc blocks with other instances
+	bool bSharedDiscCache;
+	// Delay NAND file and SD card reads and writes by about as long as the Wii takes
+	bool bNANDTiming;
+	// Save the state after the emulated apploader and restore it on later boots of the same disc
+	bool bBootSnapshotCache;
+	int iRewindSeconds;
+	int iRewindSnapshotsPerSecond;
+	// NetPlay predicts remote pads and rolls back up to this many polls, 0 waits for them
+	int iNetPlayRollbackFrames;
+	// Poll the input devices from their own thread every this many ms, 0 polls
+	// them from the CPU thread
+	int iInputPollInterval;
+	// Still poll from the CPU thread right before the pads are read, if the
+	// poll thread isn't busy
+	bool bLateInputSampling;
+	bool bDumpPerfTrace;
+	// Name the generated code for host profilers, see JitRegister.h
+	bool bPerfMap;
+	bool bJitDump;
+	// Record the last this many CPU states into the dump directory, see Tracer.h
+	int iTraceEntries;
+	// Rewrite the JIT block stats JSON every this many emulated seconds,
+	// see Profiler::ExportBlockStats
+	int iBlockStatsInterval;
 
 	int SelectedLanguage;
 
@@ -2,8 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include <vector>
+#include <algorithm>
 #include <cinttypes>
+#include <functional>
+#include <tuple>
+#include <vector>
 
 #include "Thread.h"
 #include "PowerPC/PowerPC.h"
@@ -22,26 +25,40 @@ struct EventType
 {
 	TimedCallback callback;
 	const char *name;
+	int slack;
 };
 
 std::vector<EventType> event_types;
 
-struct BaseEvent
+struct Event
 {
 	s64 time;
+	u64 fifo_order;
 	u64 userdata;
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+// Sort by time, then by insertion order so events scheduled for the same
+// cycle run in the order they were scheduled in.
+static bool operator>(const Event& left, const Event& right)
+{
+	return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
+}
 
 // STATE_TO_SAVE
-static Event *first;
+// Binary min-heap ordered by operator> above, the next event is at the front.
+static std::vector<Event> event_queue;
+static u64 event_fifo_id;
 static std::mutex tsWriteLock;
-Common::FifoQueue<BaseEvent, false> tsQueue;
+Common::FifoQueue<Event, false> tsQueue;
 
-// event pools
-Event *eventPool = 0;
+// The queue in execution order, for savestates and logging.
+static std::vector<Event> GetSortedEvents()
+{
+	std::vector<Event> sorted(event_queue);
+	std::sort(sorted.begin(), sorted.end(), [](const Event& left, const Event& right) { return right > left; });
+	return sorted;
+}
 
 int downcount, slicelength;
 int maxSliceLength = MAX_SLICE_LENGTH;
@@ -59,29 +76,14 @@ int ev_lost;
 
 void (*advanceCallback)(int cyclesExecuted) = NULL;
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
 
-int RegisterEvent(const char *name, TimedCallback callback)
+int RegisterEvent(const char *name, TimedCallback callback, int slack)
 {
 	EventType type;
 	type.name = name;
 	type.callback = callback;
+	type.slack = slack;
 
 	// check for existing type with same name.
 	// we want event type names to remain unique so that we can use them for serialization.
@@ -103,7 +105,7 @@ int RegisterEvent(const char *name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-	if (first)
+	if (!event_queue.empty())
 		PanicAlertT("Cannot unregister events with events pending");
 	event_types.clear();
 }
@@ -124,16 +126,9 @@ void Shutdown()
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while(eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
 }
 
-void EventDoState(PointerWrap &p, BaseEvent* ev)
+static void EventDoState(PointerWrap &p, Event* ev)
 {
 	p.Do(ev->time);
 
@@ -182,7 +177,36 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// Stored in the same layout as the sorted linked list this used to be:
+	// each event prefixed by a 1, terminated by a 0.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		event_queue.clear();
+		while (true)
+		{
+			u8 shouldExist = 0;
+			p.Do(shouldExist);
+			if (shouldExist != 1)
+				break;
+
+			Event ev;
+			EventDoState(p, &ev);
+			ev.fifo_order = event_fifo_id++;
+			event_queue.push_back(ev);
+		}
+		std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+	}
+	else
+	{
+		for (Event& ev : GetSortedEvents())
+		{
+			u8 shouldExist = 1;
+			p.Do(shouldExist);
+			EventDoState(p, &ev);
+		}
+		u8 shouldExist = 0;
+		p.Do(shouldExist);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -203,6 +227,7 @@ void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata
 	std::lock_guard<std::mutex> lk(tsWriteLock);
 	Event ne;
 	ne.time = globalTimer + cyclesIntoFuture;
+	ne.fifo_order = 0; // assigned in MoveEvents
 	ne.type = event_type;
 	ne.userdata = userdata;
 	tsQueue.Push(ne);
@@ -224,30 +249,23 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
+	event_queue.clear();
 }
 
-void AddEventToQueue(Event* ne)
+static void AddEventToQueue(Event ne)
 {
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	ne.fifo_order = event_fifo_id++;
+	event_queue.push_back(ne);
+	std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+}
+
+// Removes the next event from the queue and runs it.
+static void RunNextEvent()
+{
+	std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+	Event evt = event_queue.back();
+	event_queue.pop_back();
+	event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 }
 
 // This must be run ONLY from within the cpu thread
@@ -255,10 +273,10 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
+	Event ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = globalTimer + cyclesIntoFuture;
 	AddEventToQueue(ne);
 }
 
@@ -269,54 +287,18 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return std::any_of(event_queue.begin(), event_queue.end(),
+		[event_type](const Event& e) { return e.type == event_type; });
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-
-	if (!first)
-		return;
-
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
+	auto it = std::remove_if(event_queue.begin(), event_queue.end(),
+		[event_type](const Event& e) { return e.type == event_type; });
+	if (it != event_queue.end())
 	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+		event_queue.erase(it, event_queue.end());
+		std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
 	}
 }
 
@@ -351,36 +333,15 @@ void ProcessFifoWaitEvents()
 {
 	MoveEvents();
 
-	if (!first)
-		return;
-
-	while (first)
-	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
-	}
+	while (!event_queue.empty() && event_queue.front().time <= globalTimer)
+		RunNextEvent();
 }
 
 void MoveEvents()
 {
-	BaseEvent sevt;
+	Event sevt;
 	while (tsQueue.Pop(sevt))
-	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
-		AddEventToQueue(evt);
-	}
+		AddEventToQueue(sevt);
 }
 
 void Advance()
@@ -391,33 +352,29 @@ void Advance()
 	globalTimer += cyclesExecuted;
 	downcount = slicelength;
 
-	while (first)
+	while (!event_queue.empty() && event_queue.front().time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-//			LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-//				event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+//		LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
+//			event_types[event_queue.front().type].name ? event_types[event_queue.front().type].name : "?", (u64)globalTimer, (u64)event_queue.front().time);
+		RunNextEvent();
 	}
 
-	if (!first)
+	if (event_queue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		downcount += 10000;
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
-		if (slicelength > maxSliceLength)
-			slicelength = maxSliceLength;
+		// The slice only has to end once the first event runs out of slack
+		s64 deadline = event_queue.front().time + event_types[event_queue.front().type].slack;
+		if (deadline != event_queue.front().time)
+		{
+			for (const Event& ev : event_queue)
+				deadline = std::min(deadline, ev.time + event_types[ev.type].slack);
+		}
+
+		slicelength = (int)std::min<s64>(deadline - globalTimer, maxSliceLength);
 		downcount = slicelength;
 	}
 
@@ -427,12 +384,8 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
-	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
-	}
+	for (const Event& ev : GetSortedEvents())
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 }
 
 void Idle()
@@ -456,21 +409,19 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const char *name = event_types[ptr->type].name;
+		const char *name = event_types[ev.type].name;
 		if (!name)
 			name = "[unknown]";
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name, ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name, ev.time, ev.userdata);
 	}
 	return text;
 }
@@ -37,7 +37,9 @@ u64 GetIdleTicks();
 void DoState(PointerWrap &p);
 
 // Returns the event_type identifier. if name is not unique, an existing event_type will be discarded.
-int RegisterEvent(const char *name, TimedCallback callback);
+// Events of a type with slack may run up to that many cycles late, which lets the scheduler
+// merge them into the Advance of a later event instead of ending a slice for each of them.
+int RegisterEvent(const char *name, TimedCallback callback, int slack = 0);
 void UnregisterAllEvents();
 
 // userdata MAY NOT CONTAIN POINTERS. userdata might get written and reloaded from disk,
@@ -10,39 +10,97 @@
 #include "DSPHWInterface.h"
 #include "DSPInterpreter.h"
 
-// The hardware adpcm decoder :)
-static s16 ADPCM_Step(u32& _rSamplePos)
+void dsp_decode_adpcm(const u8* frame, u32 first, u32 count, u16 pred_scale, const s16* coefs, s16* yn1, s16* yn2, s16* out)
 {
-	const s16 *pCoefTable = (const s16 *)&g_dsp.ifx_regs[DSP_COEF_A1_0];
-
-	if (((_rSamplePos) & 15) == 0)
+	const int scale = 1 << (pred_scale & 0xF);
+	const int coef_idx = (pred_scale >> 4) & 0x7;
+	const s32 coef1 = coefs[coef_idx * 2 + 0];
+	const s32 coef2 = coefs[coef_idx * 2 + 1];
+
+	s32 hist1 = *yn1;
+	s32 hist2 = *yn2;
+	for (u32 i = 0; i < count; ++i)
 	{
-		g_dsp.ifx_regs[DSP_PRED_SCALE] = DSPHost_ReadHostMemory((_rSamplePos & ~15) >> 1);
-		_rSamplePos += 2;
+		const u32 nibble = first + i;
+		int temp = (nibble & 1) ? (frame[nibble >> 1] & 0xF) : (frame[nibble >> 1] >> 4);
+		if (temp >= 8)
+			temp -= 16;
+
+		// 0x400 = 0.5  in 11-bit fixed point
+		int val = (scale * temp) + ((0x400 + coef1 * hist1 + coef2 * hist2) >> 11);
+		MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
+
+		out[i] = val;
+		hist2 = hist1;
+		hist1 = val;
 	}
 
-	int scale = 1 << (g_dsp.ifx_regs[DSP_PRED_SCALE] & 0xF);
-	int coef_idx = (g_dsp.ifx_regs[DSP_PRED_SCALE] >> 4) & 0x7;
-
-	s32 coef1 = pCoefTable[coef_idx * 2 + 0];
-	s32 coef2 = pCoefTable[coef_idx * 2 + 1];
-
-	int temp = (_rSamplePos & 1) ?
-		   (DSPHost_ReadHostMemory(_rSamplePos >> 1) & 0xF) :
-		   (DSPHost_ReadHostMemory(_rSamplePos >> 1) >> 4);
+	*yn1 = hist1;
+	*yn2 = hist2;
+}
 
-	if (temp >= 8)
-		temp -= 16;
+// The rest of the ADPCM frame being read, decoded when its first sample is
+// read. It is used for as long as the ucode reads on from there without
+// touching the registers the decoding depends on.
+static struct
+{
+	u32 address;       // of the next sample
+	u32 end;           // after the last sample
+	u16 pred_scale;
+	u16 coefs[2];
+	u16 yn1, yn2;      // the history expected for the next sample
+	s16 samples[16];   // indexed by nibble
+} s_adpcm_cache;
+
+void dsp_invalidate_accelerator()
+{
+	s_adpcm_cache.end = 0;
+}
 
-	// 0x400 = 0.5  in 11-bit fixed point
-	int val = (scale * temp) + ((0x400 + coef1 * (s16)g_dsp.ifx_regs[DSP_YN1] + coef2 * (s16)g_dsp.ifx_regs[DSP_YN2]) >> 11);
+// The hardware adpcm decoder :)
+static s16 ADPCM_Step(u32& _rSamplePos)
+{
+	const u16 pred_scale = g_dsp.ifx_regs[DSP_PRED_SCALE];
+	const u16* coefs = &g_dsp.ifx_regs[DSP_COEF_A1_0 + ((pred_scale >> 4) & 0x7) * 2];
 
-	MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
+	if (_rSamplePos != s_adpcm_cache.address || _rSamplePos >= s_adpcm_cache.end ||
+	    pred_scale != s_adpcm_cache.pred_scale || coefs[0] != s_adpcm_cache.coefs[0] ||
+	    coefs[1] != s_adpcm_cache.coefs[1] || g_dsp.ifx_regs[DSP_YN1] != s_adpcm_cache.yn1 ||
+	    g_dsp.ifx_regs[DSP_YN2] != s_adpcm_cache.yn2)
+	{
+		if (((_rSamplePos) & 15) == 0)
+		{
+			g_dsp.ifx_regs[DSP_PRED_SCALE] = DSPHost_ReadHostMemory((_rSamplePos & ~15) >> 1);
+			_rSamplePos += 2;
+		}
+
+		u8 frame[8];
+		const u32 frame_addr = (_rSamplePos & ~15) >> 1;
+		for (u32 i = 0; i < 8; ++i)
+			frame[i] = DSPHost_ReadHostMemory(frame_addr + i);
+
+		const u32 first = _rSamplePos & 15;
+		s16 yn1 = g_dsp.ifx_regs[DSP_YN1];
+		s16 yn2 = g_dsp.ifx_regs[DSP_YN2];
+		s_adpcm_cache.pred_scale = g_dsp.ifx_regs[DSP_PRED_SCALE];
+		const u16* new_coefs = &g_dsp.ifx_regs[DSP_COEF_A1_0 + ((s_adpcm_cache.pred_scale >> 4) & 0x7) * 2];
+		s_adpcm_cache.coefs[0] = new_coefs[0];
+		s_adpcm_cache.coefs[1] = new_coefs[1];
+		dsp_decode_adpcm(frame, first, 16 - first, s_adpcm_cache.pred_scale, (const s16*)&g_dsp.ifx_regs[DSP_COEF_A1_0],
+		                 &yn1, &yn2, &s_adpcm_cache.samples[first]);
+
+		s_adpcm_cache.address = _rSamplePos;
+		s_adpcm_cache.end = (_rSamplePos | 15) + 1;
+	}
 
+	const s16 val = s_adpcm_cache.samples[_rSamplePos & 15];
 	g_dsp.ifx_regs[DSP_YN2] = g_dsp.ifx_regs[DSP_YN1];
 	g_dsp.ifx_regs[DSP_YN1] = val;
 
 	_rSamplePos++;
+	s_adpcm_cache.address = _rSamplePos;
+	s_adpcm_cache.yn1 = g_dsp.ifx_regs[DSP_YN1];
+	s_adpcm_cache.yn2 = g_dsp.ifx_regs[DSP_YN2];
 
 	// The advanced interpolation (linear, polyphase,...) is done by the UCode,
 	// so we don't need to bother with it here.
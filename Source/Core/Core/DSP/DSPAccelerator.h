@@ -4,7 +4,17 @@
 
 #pragma once
 
+#include "CommonTypes.h"
+
 u16 dsp_read_accelerator();
+// Forgets the ADPCM frame decoded ahead, after the registers were loaded
+void dsp_invalidate_accelerator();
+
+// Decodes <count> samples of an 8 byte ADPCM frame (the predictor/scale
+// byte and 14 nibbles) starting at nibble <first>, updating the history.
+// This is what the accelerator does for every sample, without the header
+// and address checks in between; shared with the HLE ucodes.
+void dsp_decode_adpcm(const u8* frame, u32 first, u32 count, u16 pred_scale, const s16* coefs, s16* yn1, s16* yn2, s16* out);
 
 u16 dsp_read_aram_d3();
 void dsp_write_aram_d3(u16 value);
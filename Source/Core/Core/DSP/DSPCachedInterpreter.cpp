@@ -0,0 +1,112 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "DSPAnalyzer.h"
+#include "DSPCachedInterpreter.h"
+#include "DSPCore.h"
+#include "DSPHost.h"
+#include "DSPIntExtOps.h"
+#include "DSPInterpreter.h"
+#include "DSPMemoryMap.h"
+#include "DSPTables.h"
+
+namespace DSPCachedInterpreter
+{
+
+struct DecodedInstruction
+{
+	dspIntFunc func;     // NULL until decoded
+	dspIntFunc ext_func; // NULL unless extended with something other than a NOP
+	UDSPInstruction inst;
+};
+
+// Indexed by address, like DSPAnalyzer::code_flags. Only IRAM is ever
+// rewritten, everything else is the same until the ROMs are reloaded.
+static DecodedInstruction s_code[ISPACE];
+
+void ClearCache()
+{
+	memset(s_code, 0, sizeof(s_code));
+}
+
+void ClearIRAM()
+{
+	memset(s_code, 0, DSP_IRAM_SIZE * sizeof(DecodedInstruction));
+}
+
+static const DecodedInstruction& Decode(u16 addr)
+{
+	DecodedInstruction& decoded = s_code[addr];
+	const UDSPInstruction inst = dsp_imem_read(addr);
+	const DSPOPCTemplate *tinst = GetOpTemplate(inst);
+
+	decoded.inst = inst;
+	decoded.ext_func = NULL;
+	if (tinst->extended)
+	{
+		// Only the ext ops fill the write back log, so a NOP leaves nothing
+		// to apply
+		const dspIntFunc ext_func = extOpTable[inst & (((inst >> 12) == 0x3) ? 0x7F : 0xFF)]->intFunc;
+		if (ext_func != DSPInterpreter::Ext::nop)
+			decoded.ext_func = ext_func;
+	}
+	decoded.func = tinst->intFunc;
+	return decoded;
+}
+
+int RunCycles(int cycles)
+{
+	// Like the interpreter, run a few instructions before idle skipping so
+	// that things can progress a bit
+	int no_idle_skip = 8;
+	const bool idle_skip = !DSPHost_OnThread();
+
+	// The same checks as DSPInterpreter::Step, without fetching and looking
+	// up every instruction again
+	while (cycles > 0)
+	{
+		if (g_dsp.cr & CR_HALT)
+			return 0;
+
+		if (g_dsp.external_interrupt_waiting)
+		{
+			DSPCore_CheckExternalInterrupt();
+			DSPCore_SetExternalInterrupt(false);
+		}
+
+		if (idle_skip && no_idle_skip <= 0 &&
+			(DSPAnalyzer::code_flags[g_dsp.pc] & DSPAnalyzer::CODE_IDLE_SKIP))
+			return 0;
+
+		if (g_dsp.exceptions)
+			DSPCore_CheckExceptions();
+
+		g_dsp.step_counter++;
+
+		const u16 pc = g_dsp.pc;
+		const DecodedInstruction& decoded = s_code[pc].func ? s_code[pc] : Decode(pc);
+		g_dsp.pc = pc + 1;
+		if (decoded.ext_func)
+		{
+			decoded.ext_func(decoded.inst);
+			decoded.func(decoded.inst);
+			applyWriteBackLog();
+		}
+		else
+		{
+			decoded.func(decoded.inst);
+		}
+
+		if (DSPAnalyzer::code_flags[g_dsp.pc - 1] & DSPAnalyzer::CODE_LOOP_END)
+			DSPInterpreter::HandleLoop();
+
+		cycles--;
+		no_idle_skip--;
+	}
+	return 0;
+}
+
+}  // namespace
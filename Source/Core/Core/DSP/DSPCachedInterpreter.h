@@ -0,0 +1,24 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "CommonTypes.h"
+
+// The interpreter, run from instructions that are decoded once instead of on
+// every step. It stands in for the JIT on hosts that don't have one, it has
+// no idea of breakpoints or stepping.
+namespace DSPCachedInterpreter
+{
+
+// Throws away all decoded code, after the ROMs are loaded or the DSP resets
+void ClearCache();
+// Throws away the decoded IRAM, after a new ucode is uploaded
+void ClearIRAM();
+
+// Works like DSPInterpreter::RunCycles, except that idle loops only end the
+// time slice when not running on the DSP thread.
+int RunCycles(int cycles);
+
+}  // namespace
@@ -29,7 +29,9 @@
 #include "DSPCore.h"
 #include "DSPEmitter.h"
 #include "DSPHost.h"
+#include "DSPAccelerator.h"
 #include "DSPAnalyzer.h"
+#include "DSPCachedInterpreter.h"
 #include "MemoryUtil.h"
 #include "FileUtil.h"
 
@@ -42,6 +44,7 @@ DSPCoreState core_state = DSPCORE_STOP;
 u16 cyclesLeft = 0;
 bool init_hax = false;
 DSPEmitter *dspjit = NULL;
+bool dsp_cached_interpreter = false;
 Common::Event step_event;
 
 static bool LoadRom(const char *fname, int size_in_words, u16 *rom)
@@ -143,6 +146,7 @@ bool DSPCore_Init(const char *irom_filename, const char *coef_filename,
 	cyclesLeft = 0;
 	init_hax = false;
 	dspjit = NULL;
+	dsp_cached_interpreter = false;
 
 	g_dsp.irom = (u16*)AllocateMemoryPages(DSP_IROM_BYTE_SIZE);
 	g_dsp.iram = (u16*)AllocateMemoryPages(DSP_IRAM_BYTE_SIZE);
@@ -203,7 +207,16 @@ bool DSPCore_Init(const char *irom_filename, const char *coef_filename,
 
 	// Initialize JIT, if necessary
 	if(bUsingJIT)
+	{
+#ifdef _M_X64
 		dspjit = new DSPEmitter();
+#else
+		// The JIT only emits x86-64 code, elsewhere the cached interpreter
+		// is the fast option
+		DSPCachedInterpreter::ClearCache();
+		dsp_cached_interpreter = true;
+#endif
+	}
 
 	core_state = DSPCORE_RUNNING;
 	return true;
@@ -220,6 +233,7 @@ void DSPCore_Shutdown()
 		delete dspjit;
 		dspjit = NULL;
 	}
+	dsp_cached_interpreter = false;
 	DSPCore_FreeMemoryPages();
 }
 
@@ -232,6 +246,7 @@ void DSPCore_Reset()
 	g_dsp.r.wr[2] = 0xffff;
 	g_dsp.r.wr[3] = 0xffff;
 
+	dsp_invalidate_accelerator();
 	DSPAnalyzer::Analyze();
 }
 
@@ -322,6 +337,11 @@ int DSPCore_RunCycles(int cycles)
 		switch (core_state)
 		{
 		case DSPCORE_RUNNING:
+			if (dsp_cached_interpreter)
+			{
+				cycles = DSPCachedInterpreter::RunCycles(cycles);
+				break;
+			}
 			// Seems to slow things down
 #if defined(_DEBUG) || defined(DEBUGFAST)
 			cycles = DSPInterpreter::RunCyclesDebug(cycles);
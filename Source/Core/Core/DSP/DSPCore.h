@@ -265,6 +265,8 @@ struct SDSP
 extern SDSP g_dsp;
 extern DSPBreakpoints dsp_breakpoints;
 extern DSPEmitter *dspjit;
+// Set instead of dspjit when the host has no JIT
+extern bool dsp_cached_interpreter;
 extern u16 cyclesLeft;
 extern bool init_hax;
 
@@ -10,6 +10,7 @@
 #include "DSPHost.h"
 #include "DSPInterpreter.h"
 #include "DSPAnalyzer.h"
+#include "JitRegister.h"
 
 #define MAX_BLOCK_SIZE 250
 #define DSP_IDLE_SKIP_CYCLES 0x1000
@@ -58,6 +59,7 @@ void DSPEmitter::ClearIRAM()
 		blockLinks[i] = 0;
 		blockSize[i] = 0;
 		unresolvedJumps[i].clear();
+		waitingBlocks[i].clear();
 	}
 	g_dsp.reset_dspjit_codespace = true;
 }
@@ -74,6 +76,7 @@ void DSPEmitter::ClearIRAMandDSPJITCodespaceReset()
 		blockLinks[i] = 0;
 		blockSize[i] = 0;
 		unresolvedJumps[i].clear();
+		waitingBlocks[i].clear();
 	}
 	g_dsp.reset_dspjit_codespace = false;
 }
@@ -198,6 +201,48 @@ void DSPEmitter::EmitInstruction(UDSPInstruction inst)
 	}
 }
 
+void DSPEmitter::WriteBlockLink(u16 dest, u16 cycles, bool wait_for_dest)
+{
+	Block target;
+	u16 target_size;
+	if (dest == startAddr)
+	{
+		// Loop back to the start of this block. Idle skipping blocks have to
+		// go through the dispatcher to report the skipped cycles.
+		if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+			return;
+		target = blockLinkEntry;
+		target_size = cycles;
+	}
+	else if (blockLinks[dest] != 0)
+	{
+		target = blockLinks[dest];
+		target_size = blockSize[dest];
+	}
+	else
+	{
+		// The destination has not been compiled yet. Add it to the list of
+		// blocks that this block is waiting on, unless it's in this block.
+		if (wait_for_dest && !(dest >= startAddr && dest <= compilePC))
+		{
+			unresolvedJumps[startAddr].push_back(dest);
+			waitingBlocks[dest].push_back(startAddr);
+		}
+		return;
+	}
+
+	gpr.flushRegs();
+	// Check if we have enough cycles to execute the next block
+	MOV(16, R(ECX), M(&cyclesLeft));
+	CMP(16, R(ECX), Imm16(cycles + target_size));
+	FixupBranch notEnoughCycles = J_CC(CC_BE);
+
+	SUB(16, R(ECX), Imm16(cycles));
+	MOV(16, M(&cyclesLeft), R(ECX));
+	JMP(target, true);
+	SetJumpTarget(notEnoughCycles);
+}
+
 void DSPEmitter::Compile(u16 start_addr)
 {
 	// Remember the current block address for later
@@ -263,6 +308,23 @@ void DSPEmitter::Compile(u16 start_addr)
 			// end of each block and in this order
 			DSPJitRegCache c(gpr);
 			HandleLoop();
+
+			// If the loop is over, carry on with the rest of the block.
+			FixupBranch rLoopDone;
+			if (!opcode->branch)
+			{
+				CMP(16, M(&g_dsp.pc), Imm16(compilePC));
+				rLoopDone = J_CC(CC_E, true);
+			}
+
+			// If the loop body starts this block, loop in host code until the
+			// loop is over or the cycles run out.
+			gpr.flushRegs();
+			CMP(16, M(&g_dsp.pc), Imm16(start_addr));
+			FixupBranch rNotThisBlock = J_CC(CC_NE, true);
+			WriteBlockLink(start_addr, blockSize[start_addr], false);
+			SetJumpTarget(rNotThisBlock);
+
 			gpr.saveRegs();
 			if (!DSPHost_OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
 			{
@@ -278,6 +340,8 @@ void DSPEmitter::Compile(u16 start_addr)
 
 			SetJumpTarget(rLoopAddressExit);
 			SetJumpTarget(rLoopCounterExit);
+			if (!opcode->branch)
+				SetJumpTarget(rLoopDone);
 		}
 
 		if (opcode->branch)
@@ -324,6 +388,11 @@ void DSPEmitter::Compile(u16 start_addr)
 	if (fixup_pc)
 	{
 		MOV(16, M(&(g_dsp.pc)), Imm16(compilePC));
+
+		// Fall through to the next block if it's already compiled, without
+		// waiting for it: blocks that end here are often entered by the next
+		// one, and waiting on each other would never resolve.
+		WriteBlockLink(compilePC, blockSize[start_addr], false);
 	}
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
@@ -334,22 +403,20 @@ void DSPEmitter::Compile(u16 start_addr)
 	{
 		blockLinks[start_addr] = blockLinkEntry;
 
-		for(u16 i = 0x0000; i < 0xffff; ++i)
+		for (u16 i : waitingBlocks[start_addr])
 		{
-			if (!unresolvedJumps[i].empty())
+			// Check if the block is still waiting for this block to be linkable
+			size_t size = unresolvedJumps[i].size();
+			unresolvedJumps[i].remove(start_addr);
+			if (unresolvedJumps[i].size() < size)
 			{
-				// Check if there were any blocks waiting for this block to be linkable
-				size_t size = unresolvedJumps[i].size();
-				unresolvedJumps[i].remove(start_addr);
-				if (unresolvedJumps[i].size() < size)
-				{
-					// Mark the block to be recompiled again
-					blocks[i] = (DSPCompiledCode)stubEntryPoint;
-					blockLinks[i] = 0;
-					blockSize[i] = 0;
-				}
+				// Mark the block to be recompiled again
+				blocks[i] = (DSPCompiledCode)stubEntryPoint;
+				blockLinks[i] = 0;
+				blockSize[i] = 0;
 			}
 		}
+		waitingBlocks[start_addr].clear();
 	}
 
 	if (blockSize[start_addr] == 0)
@@ -370,6 +437,8 @@ void DSPEmitter::Compile(u16 start_addr)
 		MOV(16, R(EAX), Imm16(blockSize[start_addr]));
 	}
 	JMP(returnDispatcher, true);
+
+	JitRegister::Register(entryPoint, GetCodePtr() - entryPoint, "JIT_DSP_%04x", start_addr);
 }
 
 const u8 *DSPEmitter::CompileStub()
@@ -378,6 +447,7 @@ const u8 *DSPEmitter::CompileStub()
 	ABI_CallFunction((void *)&CompileCurrent);
 	XOR(32, R(EAX), R(EAX)); // Return 0 cycles executed
 	JMP(returnDispatcher);
+	JitRegister::Register(entryPoint, GetCodePtr() - entryPoint, "JIT_DSP_Stub");
 	return entryPoint;
 }
 
@@ -427,4 +497,6 @@ void DSPEmitter::CompileDispatcher()
 	//MOV(32, M(&cyclesLeft), Imm32(0));
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
+
+	JitRegister::Register(enterDispatcher, GetCodePtr() - enterDispatcher, "JIT_DSP_Dispatcher");
 }
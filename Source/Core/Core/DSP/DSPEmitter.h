@@ -35,6 +35,12 @@ public:
 	void Compile(u16 start_addr);
 	void ClearCallFlag();
 
+	// Jumps straight to the block at dest when it's compiled and there are
+	// enough cycles left to run it. <cycles> is what the current block has
+	// used up to this point. If wait_for_dest is set, a destination that
+	// isn't compiled yet makes this block get recompiled once it is.
+	void WriteBlockLink(u16 dest, u16 cycles, bool wait_for_dest);
+
 	bool FlagsNeeded();
 
 	void Default(UDSPInstruction inst);
@@ -251,6 +257,9 @@ public:
 	Block *blockLinks;
 	u16 *blockSize;
 	std::list<u16> unresolvedJumps[MAX_BLOCKS];
+	// The other way around: the blocks that have dest in their unresolvedJumps.
+	// May contain stale entries.
+	std::list<u16> waitingBlocks[MAX_BLOCKS];
 
 	DSPJitRegCache gpr;
 private:
@@ -28,6 +28,8 @@ public:
 	virtual unsigned short DSP_WriteControlRegister(unsigned short) = 0;
 	virtual void DSP_SendAIBuffer(unsigned int address, unsigned int num_samples) = 0;
 	virtual void DSP_Update(int cycles) = 0;
+	// Called before the CPU side touches memory the DSP may be working on
+	virtual void DSP_Sync() {}
 	virtual void DSP_StopSoundStream() = 0;
 	virtual void DSP_ClearAudioBuffer(bool mute) = 0;
 	virtual u32 DSP_UpdateRate() = 0;
@@ -0,0 +1,183 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+#include "CPUDetect.h"
+#include "FileUtil.h"
+#include "PerfTrace.h"
+#include "StringUtil.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "ConfigManager.h"
+#include "Core.h"
+#include "FifoBenchmark.h"
+#include "FifoDataFile.h"
+#include "FifoPlaybackAnalyzer.h"
+#include "FifoPlayer.h"
+#include "VideoBackendBase.h"
+
+namespace FifoBenchmark
+{
+
+static std::mutex s_lock;
+static std::vector<u32> s_cpu_frames;
+static std::vector<u32> s_gpu_frames;
+static u64 s_last_cpu_frame;
+static u64 s_start_time;
+static std::string s_report;
+
+static unsigned int s_saved_framelimit;
+static bool s_saved_loop;
+
+// Called by the FIFO player before it writes a frame, so the time since the
+// previous call is what writing the previous frame took.
+static void FrameWritten()
+{
+	const u64 now = Common::Timer::GetTimeUs();
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_last_cpu_frame)
+		s_cpu_frames.push_back((u32)(now - s_last_cpu_frame));
+	s_last_cpu_frame = now;
+}
+
+static void FramePresented(const PerfTrace::FrameTimes& frame)
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_gpu_frames.push_back(frame.us[PerfTrace::CAT_FRAME]);
+}
+
+void Start()
+{
+	SConfig& config = SConfig::GetInstance();
+	s_saved_framelimit = config.m_Framelimit;
+	s_saved_loop = config.m_LocalCoreStartupParameter.bLoopFifoReplay;
+	config.m_Framelimit = 0;
+	config.m_LocalCoreStartupParameter.bLoopFifoReplay = false;
+	// Same as holding the unthrottle key, which also turns vsync off.
+	Core::isTabPressed = true;
+
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		s_cpu_frames.clear();
+		s_gpu_frames.clear();
+		s_last_cpu_frame = 0;
+	}
+	s_start_time = Common::Timer::GetTimeUs();
+
+	FifoPlayer::GetInstance().SetFrameWrittenCallback(FrameWritten);
+	PerfTrace::SetFrameCallback(FramePresented);
+}
+
+// Mean, percentiles and maximum of a set of frame times, in milliseconds.
+static std::string SummarizeFrames(std::vector<u32> frames)
+{
+	if (frames.empty())
+		return "null";
+
+	std::sort(frames.begin(), frames.end());
+
+	u64 total = 0;
+	for (u32 us : frames)
+		total += us;
+
+	// nearest-rank percentile
+	auto percentile = [&](int p) -> double {
+		const size_t rank = (frames.size() * p + 99) / 100;
+		return frames[std::max<size_t>(rank, 1) - 1] / 1000.0;
+	};
+
+	return StringFromFormat("{\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+		total / 1000.0 / frames.size(), percentile(50), percentile(90), percentile(95), percentile(99),
+		frames.back() / 1000.0);
+}
+
+void Stop(const std::string& name)
+{
+	PerfTrace::SetFrameCallback(nullptr);
+	FifoPlayer::GetInstance().SetFrameWrittenCallback(nullptr);
+
+	SConfig& config = SConfig::GetInstance();
+	config.m_Framelimit = s_saved_framelimit;
+	config.m_LocalCoreStartupParameter.bLoopFifoReplay = s_saved_loop;
+	Core::isTabPressed = false;
+
+	const double seconds = (Common::Timer::GetTimeUs() - s_start_time) / 1000000.0;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	const std::string escaped_name = ReplaceAll(ReplaceAll(name, "\\", "\\\\"), "\"", "\\\"");
+
+	if (!s_report.empty())
+		s_report += ",\n";
+	s_report += StringFromFormat("\t\t{\"file\": \"%s\", \"seconds\": %.3f, \"cpu_frames\": %u, \"gpu_frames\": %u,\n"
+		"\t\t \"cpu_ms\": %s,\n\t\t \"gpu_ms\": %s}", escaped_name.c_str(), seconds,
+		(u32)s_cpu_frames.size(), (u32)s_gpu_frames.size(),
+		SummarizeFrames(s_cpu_frames).c_str(), SummarizeFrames(s_gpu_frames).c_str());
+}
+
+bool WriteReport(const std::string& filename)
+{
+	const std::string backend = g_video_backend ? g_video_backend->GetName() : "";
+	const std::string json = StringFromFormat("{\n\t\"backend\": \"%s\",\n\t\"cpu\": \"%s\",\n\t\"results\": [\n%s\n\t]\n}\n",
+		backend.c_str(), cpu_info.brand_string, s_report.c_str());
+	s_report.clear();
+
+	File::IOFile file(filename, "w");
+	return file.WriteBytes(json.data(), json.size());
+}
+
+static std::string FormatStats(const FifoFrameStats& stats)
+{
+	return StringFromFormat("{\"draws\": %u, \"primitives\": [%u, %u, %u, %u, %u, %u, %u, %u], "
+		"\"vertices\": %u, \"vertex_bytes\": %u, \"bp\": %u, \"cp\": %u, \"xf\": %u, \"xf_words\": %u, "
+		"\"xf_indexed\": %u, \"efb_copies\": %u, \"xfb_copies\": %u, \"tlut_loads\": %u, \"tmem_preloads\": %u, "
+		"\"memory_updates\": %u, \"memory_bytes\": %u, \"texture_updates\": %u, \"texture_bytes\": %u}",
+		stats.drawCalls, stats.primitives[0], stats.primitives[1], stats.primitives[2], stats.primitives[3],
+		stats.primitives[4], stats.primitives[5], stats.primitives[6], stats.primitives[7],
+		stats.vertices, stats.vertexBytes, stats.bpWrites, stats.cpWrites, stats.xfWrites, stats.xfWords,
+		stats.indexedXFLoads, stats.efbCopies, stats.xfbCopies, stats.tlutLoads, stats.tmemPreloads,
+		stats.memoryUpdates, stats.memoryUpdateBytes, stats.textureUpdates, stats.textureUpdateBytes);
+}
+
+bool WriteCommandReport(const std::string& filename, const std::vector<std::string>& logs)
+{
+	bool ok = true;
+	std::string results;
+	for (const std::string& log : logs)
+	{
+		std::unique_ptr<FifoDataFile> file(FifoDataFile::Load(log, false, true));
+		if (!file)
+		{
+			ERROR_LOG(VIDEO, "Could not load the FIFO log %s", log.c_str());
+			ok = false;
+			continue;
+		}
+
+		std::vector<AnalyzedFrameInfo> frames;
+		FifoPlaybackAnalyzer analyzer;
+		analyzer.AnalyzeFrames(file.get(), frames);
+
+		const std::string escaped_name = ReplaceAll(ReplaceAll(log, "\\", "\\\\"), "\"", "\\\"");
+		if (!results.empty())
+			results += ",\n";
+		results += StringFromFormat("\t\t{\"file\": \"%s\", \"frames\": [\n", escaped_name.c_str());
+		for (size_t i = 0; i < frames.size(); ++i)
+			results += "\t\t\t" + FormatStats(frames[i].stats) + (i + 1 < frames.size() ? ",\n" : "\n");
+		results += "\t\t]}";
+	}
+
+	// The order of the primitive types is that of GX_DRAW_*
+	const std::string json = StringFromFormat("{\n\t\"primitive_types\": [\"quads\", \"quads_2\", \"triangles\", "
+		"\"triangle_strip\", \"triangle_fan\", \"lines\", \"line_strip\", \"points\"],\n\t\"results\": [\n%s\n\t]\n}\n",
+		results.c_str());
+
+	File::IOFile file(filename, "w");
+	return file.WriteBytes(json.data(), json.size()) && ok;
+}
+
+} // namespace FifoBenchmark
@@ -0,0 +1,34 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Replays FIFO logs with the frame limiter and vsync off and collects
+// per-frame timings of every replay into a JSON report.
+//
+// The CPU time of a frame is how long the FIFO player took to write it to
+// the emulated GPU, the GPU time is the time between two frames presented by
+// the video thread.
+namespace FifoBenchmark
+{
+
+// Overrides the throttling settings and starts timing frames. Call before
+// booting a log.
+void Start();
+
+// Restores the settings and adds the timings collected since Start() to the
+// report under the given name. Call once the replay has stopped.
+void Stop(const std::string& name);
+
+// Writes the report of every replay since the last call.
+bool WriteReport(const std::string& filename);
+
+// Writes what each frame of the logs makes the GPU do, counted from the
+// recorded commands without replaying them (see FifoFrameStats), as JSON.
+bool WriteCommandReport(const std::string& filename, const std::vector<std::string>& logs);
+
+} // namespace FifoBenchmark
@@ -2,28 +2,68 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <map>
+
+#include <lzo/lzo1x.h>
+
 #include "FifoDataFile.h"
 #include "FifoFileStruct.h"
 
 #include "FileUtil.h"
+#include "Hash.h"
 
 using namespace FifoFileStruct;
 using namespace std;
 
+// Writes the data blocks of a version 2 file
+struct FifoDataFile::DataWriter
+{
+	DataWriter(File::IOFile &_file) :
+		file(_file),
+		wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t))
+	{
+	}
+
+	// Returns the offset of the block, which may have been written before
+	u64 Write(const u8 *data, u32 size)
+	{
+		// The whole contents are hashed, so the hash and size tell a block apart
+		const pair<u64, u32> key(GetStripeHash64(data, size, 0), size);
+		auto found = blocks.find(key);
+		if (found != blocks.end())
+			return found->second;
+
+		buffer.resize(size + size / 16 + 64 + 3);
+		lzo_uint compressedSize = 0;
+		const bool compressed = lzo1x_1_compress(data, size, buffer.data(), &compressedSize, wrkmem.data()) == LZO_E_OK &&
+			compressedSize < size;
+		const u32 storedSize = compressed ? (u32)compressedSize : size;
+
+		file.Seek(0, SEEK_END);
+		const u64 offset = file.Tell();
+		file.WriteArray(&storedSize, 1);
+		file.WriteBytes(compressed ? buffer.data() : data, storedSize);
+
+		blocks[key] = offset;
+		return offset;
+	}
+
+	File::IOFile &file;
+	map<pair<u64, u32>, u64> blocks;
+	vector<lzo_align_t> wrkmem;
+	vector<u8> buffer;
+};
+
 FifoDataFile::FifoDataFile() :
-	m_Flags(0)
+	m_Flags(0),
+	m_Version(VERSION_NUMBER)
 {
 }
 
 FifoDataFile::~FifoDataFile()
 {
-	for (auto& frame : m_Frames)
-	{
-		for (auto& update : frame.memoryUpdates)
-			delete []update.data;
-
-		delete []frame.fifoData;
-	}
+	for (size_t i = 0; i < m_Frames.size(); ++i)
+		FreeFrameData(i);
 }
 
 void FifoDataFile::SetIsWii(bool isWii)
@@ -41,12 +81,61 @@ void FifoDataFile::AddFrame(const FifoFrameInfo &frameInfo)
 	m_Frames.push_back(frameInfo);
 }
 
+bool FifoDataFile::PinFrame(size_t frame)
+{
+	if (!m_File)
+		return true;
+
+	std::lock_guard<std::mutex> lk(m_FileLock);
+	if (m_Locations[frame].pins++ > 0)
+		return m_Frames[frame].fifoData != NULL;
+
+	if (ReadFrameData(frame))
+		return true;
+
+	ERROR_LOG(VIDEO, "Couldn't read the data of frame %u of the FIFO log", (u32)frame);
+	FreeFrameData(frame);
+	return false;
+}
+
+void FifoDataFile::UnpinFrame(size_t frame)
+{
+	if (!m_File)
+		return;
+
+	std::lock_guard<std::mutex> lk(m_FileLock);
+	if (--m_Locations[frame].pins == 0)
+		FreeFrameData(frame);
+}
+
+bool FifoDataFile::ReadFifoData(size_t frame, std::vector<u8> &data)
+{
+	const u32 size = m_Frames[frame].fifoDataSize;
+	std::vector<u8> stored;
+	{
+		// Only the reading is serialized, the frames are decompressed in parallel
+		std::lock_guard<std::mutex> lk(m_FileLock);
+		if (!ReadStoredData(m_Locations[frame].fifoDataOffset, size, stored))
+			return false;
+	}
+
+	if (stored.size() == size)
+	{
+		data.swap(stored);
+		return true;
+	}
+	data.resize(size);
+	return DecompressData(stored, data.data(), size);
+}
+
 bool FifoDataFile::Save(const char *filename)
 {
 	File::IOFile file;
 	if (!file.Open(filename, "wb"))
 		return false;
 
+	DataWriter writer(file);
+
 	// Add space for header
 	PadFile(sizeof(FileHeader), file);
 
@@ -94,16 +183,21 @@ bool FifoDataFile::Save(const char *filename)
 	file.WriteBytes(&header, sizeof(FileHeader));
 
 	// Write frames list
+	bool dataOk = true;
 	for (unsigned int i = 0; i < m_Frames.size(); ++i)
 	{
 		const FifoFrameInfo &srcFrame = m_Frames[i];
+		if (!PinFrame(i))
+		{
+			UnpinFrame(i);
+			dataOk = false;
+			break;
+		}
 
 		// Write FIFO data
-		file.Seek(0, SEEK_END);
-		u64 dataOffset = file.Tell();
-		file.WriteBytes(srcFrame.fifoData, srcFrame.fifoDataSize);
+		u64 dataOffset = writer.Write(srcFrame.fifoData, srcFrame.fifoDataSize);
 
-		u64 memoryUpdatesOffset = WriteMemoryUpdates(srcFrame.memoryUpdates, file);
+		u64 memoryUpdatesOffset = WriteMemoryUpdates(srcFrame.memoryUpdates, writer);
 
 		FileFrameInfo dstFrame;
 		dstFrame.fifoDataSize = srcFrame.fifoDataSize;
@@ -117,80 +211,86 @@ bool FifoDataFile::Save(const char *filename)
 		u64 frameOffset = frameListOffset + (i * sizeof(FileFrameInfo));
 		file.Seek(frameOffset, SEEK_SET);
 		file.WriteBytes(&dstFrame, sizeof(FileFrameInfo));
+
+		UnpinFrame(i);
 	}
 
-	if (!file.Close())
+	if (!file.Close() || !dataOk)
 		return false;
 
 	return true;
 }
 
-FifoDataFile *FifoDataFile::Load(const std::string &filename, bool flagsOnly)
+FifoDataFile *FifoDataFile::Load(const std::string &filename, bool flagsOnly, bool streaming)
 {
-	File::IOFile file;
-	file.Open(filename, "rb");
-	if (!file)
+	std::unique_ptr<File::IOFile> file(new File::IOFile(filename, "rb"));
+	if (!*file)
 		return NULL;
 
 	FileHeader header;
-	file.ReadBytes(&header, sizeof(header));
+	file->ReadBytes(&header, sizeof(header));
 
 	if (header.fileId != FILE_ID || header.min_loader_version > VERSION_NUMBER)
-	{
-		file.Close();
 		return NULL;
-	}
 
 	FifoDataFile* dataFile = new FifoDataFile;
 
 	dataFile->m_Flags = header.flags;
+	dataFile->m_Version = header.file_version;
 
 	if (flagsOnly)
-	{
-		file.Close();
 		return dataFile;
-	}
 
 	u32 size = std::min((u32)BP_MEM_SIZE, header.bpMemSize);
-	file.Seek(header.bpMemOffset, SEEK_SET);
-	file.ReadArray(dataFile->m_BPMem, size);
+	file->Seek(header.bpMemOffset, SEEK_SET);
+	file->ReadArray(dataFile->m_BPMem, size);
 
 	size = std::min((u32)CP_MEM_SIZE, header.cpMemSize);
-	file.Seek(header.cpMemOffset, SEEK_SET);
-	file.ReadArray(dataFile->m_CPMem, size);
+	file->Seek(header.cpMemOffset, SEEK_SET);
+	file->ReadArray(dataFile->m_CPMem, size);
 
 	size = std::min((u32)XF_MEM_SIZE, header.xfMemSize);
-	file.Seek(header.xfMemOffset, SEEK_SET);
-	file.ReadArray(dataFile->m_XFMem, size);
+	file->Seek(header.xfMemOffset, SEEK_SET);
+	file->ReadArray(dataFile->m_XFMem, size);
 
 	size = std::min((u32)XF_REGS_SIZE, header.xfRegsSize);
-	file.Seek(header.xfRegsOffset, SEEK_SET);
-	file.ReadArray(dataFile->m_XFRegs, size);
+	file->Seek(header.xfRegsOffset, SEEK_SET);
+	file->ReadArray(dataFile->m_XFRegs, size);
 
 	// Read frames
+	std::vector<FileFrameInfo> srcFrames(header.frameCount);
+	file->Seek(header.frameListOffset, SEEK_SET);
+	file->ReadArray(srcFrames.data(), srcFrames.size());
+
+	dataFile->m_Frames.resize(header.frameCount);
+	dataFile->m_Locations.resize(header.frameCount);
 	for (u32 i = 0; i < header.frameCount; ++i)
 	{
-		u64 frameOffset = header.frameListOffset + (i * sizeof(FileFrameInfo));
-		file.Seek(frameOffset, SEEK_SET);
-		FileFrameInfo srcFrame;
-		file.ReadBytes(&srcFrame, sizeof(FileFrameInfo));
+		const FileFrameInfo &srcFrame = srcFrames[i];
+		FifoFrameInfo &dstFrame = dataFile->m_Frames[i];
+		FrameLocation &location = dataFile->m_Locations[i];
 
-		FifoFrameInfo dstFrame;
-		dstFrame.fifoData = new u8[srcFrame.fifoDataSize];
+		dstFrame.fifoData = NULL;
 		dstFrame.fifoDataSize = srcFrame.fifoDataSize;
 		dstFrame.fifoStart = srcFrame.fifoStart;
 		dstFrame.fifoEnd = srcFrame.fifoEnd;
 
-		file.Seek(srcFrame.fifoDataOffset, SEEK_SET);
-		file.ReadBytes(dstFrame.fifoData, srcFrame.fifoDataSize);
-
-		ReadMemoryUpdates(srcFrame.memoryUpdatesOffset, srcFrame.numMemoryUpdates, dstFrame.memoryUpdates, file);
+		location.fifoDataOffset = srcFrame.fifoDataOffset;
+		location.pins = 0;
 
-		dataFile->AddFrame(dstFrame);
+		ReadMemoryUpdates(srcFrame.memoryUpdatesOffset, srcFrame.numMemoryUpdates, dstFrame.memoryUpdates,
+			location.memoryUpdateOffsets, *file);
 	}
 
-	file.Close();
+	dataFile->m_File = std::move(file);
+	if (streaming)
+		return dataFile;
+
+	for (size_t i = 0; i < dataFile->m_Frames.size(); ++i)
+		dataFile->ReadFrameData(i);
 
+	dataFile->m_File.reset();
+	dataFile->m_Locations.clear();
 	return dataFile;
 }
 
@@ -215,9 +315,12 @@ bool FifoDataFile::GetFlag(u32 flag) const
 	return !!(m_Flags & flag);
 }
 
-u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates, File::IOFile &file)
+u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates, DataWriter &writer)
 {
+	File::IOFile &file = writer.file;
+
 	// Add space for memory update list
+	file.Seek(0, SEEK_END);
 	u64 updateListOffset = file.Tell();
 	for (size_t i = 0; i < memUpdates.size(); i++)
 		PadFile(sizeof(FileMemoryUpdate), file);
@@ -227,9 +330,7 @@ u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates
 		const MemoryUpdate &srcUpdate = memUpdates[i];
 
 		// Write memory
-		file.Seek(0, SEEK_END);
-		u64 dataOffset = file.Tell();
-		file.WriteBytes(srcUpdate.data, srcUpdate.size);
+		u64 dataOffset = writer.Write(srcUpdate.data, srcUpdate.size);
 
 		FileMemoryUpdate dstUpdate;
 		dstUpdate.address = srcUpdate.address;
@@ -246,25 +347,96 @@ u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates
 	return updateListOffset;
 }
 
-void FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, std::vector<MemoryUpdate> &memUpdates, File::IOFile &file)
+void FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, std::vector<MemoryUpdate> &memUpdates,
+	std::vector<u64> &dataOffsets, File::IOFile &file)
 {
+	std::vector<FileMemoryUpdate> srcUpdates(numUpdates);
+	file.Seek(fileOffset, SEEK_SET);
+	file.ReadArray(srcUpdates.data(), numUpdates);
+
 	memUpdates.resize(numUpdates);
+	dataOffsets.resize(numUpdates);
 
 	for (u32 i = 0; i < numUpdates; ++i)
 	{
-		u64 updateOffset = fileOffset + (i * sizeof(FileMemoryUpdate));
-		file.Seek(updateOffset, SEEK_SET);
-		FileMemoryUpdate srcUpdate;
-		file.ReadBytes(&srcUpdate, sizeof(FileMemoryUpdate));
+		const FileMemoryUpdate &srcUpdate = srcUpdates[i];
 
 		MemoryUpdate &dstUpdate = memUpdates[i];
 		dstUpdate.address = srcUpdate.address;
 		dstUpdate.fifoPosition = srcUpdate.fifoPosition;
 		dstUpdate.size = srcUpdate.dataSize;
-		dstUpdate.data = new u8[srcUpdate.dataSize];
+		dstUpdate.data = NULL;
 		dstUpdate.type = (MemoryUpdate::Type)srcUpdate.type;
 
-		file.Seek(srcUpdate.dataOffset, SEEK_SET);
-		file.ReadBytes(dstUpdate.data, srcUpdate.dataSize);
+		dataOffsets[i] = srcUpdate.dataOffset;
 	}
 }
+
+bool FifoDataFile::ReadStoredData(u64 offset, u32 size, std::vector<u8> &stored)
+{
+	if (!m_File->Seek(offset, SEEK_SET))
+		return false;
+
+	u32 storedSize = size;
+	if (m_Version >= 2 && (!m_File->ReadArray(&storedSize, 1) || storedSize > size))
+		return false;
+
+	stored.resize(storedSize);
+	return m_File->ReadBytes(stored.data(), storedSize);
+}
+
+bool FifoDataFile::DecompressData(const std::vector<u8> &stored, u8 *data, u32 size)
+{
+	lzo_uint decompressedSize = size;
+	return lzo1x_decompress_safe(stored.data(), (lzo_uint)stored.size(), data, &decompressedSize, NULL) == LZO_E_OK &&
+		decompressedSize == size;
+}
+
+bool FifoDataFile::ReadData(u64 offset, u32 size, u8 *data)
+{
+	if (!m_File->Seek(offset, SEEK_SET))
+		return false;
+
+	if (m_Version < 2)
+		return m_File->ReadBytes(data, size);
+
+	u32 storedSize = 0;
+	if (!m_File->ReadArray(&storedSize, 1) || storedSize > size)
+		return false;
+	if (storedSize == size)
+		return m_File->ReadBytes(data, size);
+
+	std::vector<u8> compressed(storedSize);
+	return m_File->ReadBytes(compressed.data(), storedSize) && DecompressData(compressed, data, size);
+}
+
+bool FifoDataFile::ReadFrameData(size_t frame)
+{
+	FifoFrameInfo &frameInfo = m_Frames[frame];
+	const FrameLocation &location = m_Locations[frame];
+
+	frameInfo.fifoData = new u8[frameInfo.fifoDataSize];
+	bool ok = ReadData(location.fifoDataOffset, frameInfo.fifoDataSize, frameInfo.fifoData);
+
+	for (size_t i = 0; i < frameInfo.memoryUpdates.size(); ++i)
+	{
+		MemoryUpdate &update = frameInfo.memoryUpdates[i];
+		update.data = new u8[update.size];
+		ok = ReadData(location.memoryUpdateOffsets[i], update.size, update.data) && ok;
+	}
+
+	return ok;
+}
+
+void FifoDataFile::FreeFrameData(size_t frame)
+{
+	FifoFrameInfo &frameInfo = m_Frames[frame];
+	for (auto& update : frameInfo.memoryUpdates)
+	{
+		delete []update.data;
+		update.data = NULL;
+	}
+
+	delete []frameInfo.fifoData;
+	frameInfo.fifoData = NULL;
+}
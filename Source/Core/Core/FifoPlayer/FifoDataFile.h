@@ -5,6 +5,9 @@
 #pragma once
 
 #include "Common.h"
+#include "StdMutex.h"
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace File
@@ -67,9 +70,20 @@ public:
 	const FifoFrameInfo &GetFrame(size_t frame) const { return m_Frames[frame]; }
 	size_t GetFrameCount() { return m_Frames.size(); }
 
+	// A file loaded for streaming keeps only the frame lists in memory. The
+	// FIFO data and memory updates of a frame are read from the file while
+	// the frame is pinned, and are NULL otherwise. Pins are counted and may
+	// come from any thread. PinFrame returns false if the data couldn't be
+	// read, the frame must be unpinned either way.
+	bool IsStreaming() const { return m_File != nullptr; }
+	bool PinFrame(size_t frame);
+	void UnpinFrame(size_t frame);
+	// Reads only the FIFO data of a frame of a streamed file
+	bool ReadFifoData(size_t frame, std::vector<u8> &data);
+
 	bool Save(const char *filename);
 
-	static FifoDataFile *Load(const std::string &filename, bool flagsOnly);
+	static FifoDataFile *Load(const std::string &filename, bool flagsOnly, bool streaming = false);
 
 private:
 	enum
@@ -77,13 +91,31 @@ private:
 		FLAG_IS_WII = 1
 	};
 
+	struct DataWriter;
+
+	// Where the data of a frame is in the file
+	struct FrameLocation
+	{
+		u64 fifoDataOffset;
+		std::vector<u64> memoryUpdateOffsets;
+		u32 pins;
+	};
+
 	void PadFile(u32 numBytes, File::IOFile &file);
 
 	void SetFlag(u32 flag, bool set);
 	bool GetFlag(u32 flag) const;
 
-	u64 WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates, File::IOFile &file);
-	static void ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, std::vector<MemoryUpdate> &memUpdates, File::IOFile &file);
+	u64 WriteMemoryUpdates(const std::vector<MemoryUpdate> &memUpdates, DataWriter &writer);
+	static void ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, std::vector<MemoryUpdate> &memUpdates,
+		std::vector<u64> &dataOffsets, File::IOFile &file);
+
+	// A block as it is stored, which is the data itself if it has its size
+	bool ReadStoredData(u64 offset, u32 size, std::vector<u8> &stored);
+	static bool DecompressData(const std::vector<u8> &stored, u8 *data, u32 size);
+	bool ReadData(u64 offset, u32 size, u8 *data);
+	bool ReadFrameData(size_t frame);
+	void FreeFrameData(size_t frame);
 
 	u32 m_BPMem[BP_MEM_SIZE];
 	u32 m_CPMem[CP_MEM_SIZE];
@@ -93,4 +125,10 @@ private:
 	u32 m_Flags;
 
 	std::vector<FifoFrameInfo> m_Frames;
+
+	// Only kept while the data is read from the file
+	u32 m_Version;
+	std::vector<FrameLocation> m_Locations;
+	std::unique_ptr<File::IOFile> m_File;
+	std::mutex m_FileLock;
 };
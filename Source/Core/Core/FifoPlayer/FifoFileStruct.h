@@ -12,10 +12,16 @@ namespace FifoFileStruct
 enum
 {
 	FILE_ID            = 0x0d01f1f0,
-	VERSION_NUMBER     = 1,
-	MIN_LOADER_VERSION = 1,
+	VERSION_NUMBER     = 2,
+	MIN_LOADER_VERSION = 2,
 };
 
+// Since version 2 the FIFO data and memory update offsets point at blocks: a
+// u32 with the stored size followed by the data, which is compressed with
+// LZO1X unless the stored size is the size of the data. Blocks with the same
+// contents are only stored once, so the data of memory which keeps changing
+// back and forth doesn't add up.
+
 #pragma pack(push, 4)
 
 union FileHeader
@@ -7,6 +7,7 @@
 #include "FifoPlaybackAnalyzer.h"
 
 #include "Common.h"
+#include "ThreadPool.h"
 
 #include "OpcodeDecoding.h"
 #include "TextureDecoder.h"
@@ -15,15 +16,256 @@
 using namespace std;
 using namespace FifoAnalyzer;
 
-// For debugging
-#define LOG_FIFO_CMDS 0
-struct CmdData
+// The CP registers the vertex sizes depend on, as bits of FrameScan::cpRead
+// and cpWritten
+enum
 {
-	u32 size;
-	u32 offset;
-	u8 *ptr;
+	CP_VTXDESC_LOW = 0,
+	CP_VTXDESC_HIGH = 1,
+	CP_VAT = 2, // three for each of the eight formats
+	NUM_CP_REGISTERS = 2 + 8 * 3,
 };
 
+// What the first pass finds in the commands of a frame
+struct FrameScan
+{
+	vector<u32> objectStarts;
+	vector<u32> objectEnds;
+	// The BP writes, which are replayed in order afterwards
+	vector<u32> bpPositions;
+	vector<u32> bpValues;
+	// Memory updates after the last command that was decoded aren't written
+	u32 lastCommand;
+	u8 badOpcode;
+	bool error;
+	bool readFailed;
+
+	// The state the frame was gone through with, and the registers whose
+	// values at the start of the frame it depends on
+	CPMemory startCp;
+	CPMemory cp;
+	u32 cpRead;
+	u32 cpWritten;
+
+	FifoFrameStats stats;
+};
+
+static u32 GetCPRegister(const CPMemory &cpMem, int reg)
+{
+	if (reg == CP_VTXDESC_LOW)
+		return (u32)(cpMem.vtxDesc.Hex & 0x1FFFF);
+	if (reg == CP_VTXDESC_HIGH)
+		return (u32)(cpMem.vtxDesc.Hex >> 17);
+
+	const VAT &vat = cpMem.vtxAttr[(reg - CP_VAT) / 3];
+	switch ((reg - CP_VAT) % 3)
+	{
+	case 0:  return vat.g0.Hex;
+	case 1:  return vat.g1.Hex;
+	default: return vat.g2.Hex;
+	}
+}
+
+static void SetCPRegister(CPMemory &cpMem, int reg, u32 value)
+{
+	if (reg == CP_VTXDESC_LOW)
+		cpMem.vtxDesc.Hex = (cpMem.vtxDesc.Hex & ~0x1FFFFULL) | value;
+	else if (reg == CP_VTXDESC_HIGH)
+		cpMem.vtxDesc.Hex = (cpMem.vtxDesc.Hex & 0x1FFFF) | ((u64)value << 17);
+	else
+		LoadCPReg(0x70 + ((reg - CP_VAT) % 3) * 0x10 + (reg - CP_VAT) / 3, value, cpMem);
+}
+
+// Returns the size of the command, or 0 for an unknown opcode
+static u32 ScanCommand(u8 *data, u32 position, bool &drawing, FrameScan &scan)
+{
+	u8 *dataStart = data;
+
+	int cmd = ReadFifo8(data);
+
+	switch(cmd)
+	{
+	case GX_NOP:
+	case 0x44:
+	case GX_CMD_INVL_VC:
+		break;
+
+	case GX_LOAD_CP_REG:
+		{
+			drawing = false;
+
+			u32 cmd2 = ReadFifo8(data);
+			u32 value = ReadFifo32(data);
+			LoadCPReg(cmd2, value, scan.cp);
+
+			switch (cmd2 & 0xF0)
+			{
+			case 0x50:
+				// The value isn't masked, higher bits end up in the upper part
+				if (value >> 17)
+				{
+					scan.cpRead |= (1 << CP_VTXDESC_HIGH) & ~scan.cpWritten;
+					scan.cpWritten |= 1 << CP_VTXDESC_HIGH;
+				}
+				scan.cpWritten |= 1 << CP_VTXDESC_LOW;
+				break;
+			case 0x60:
+				scan.cpWritten |= 1 << CP_VTXDESC_HIGH;
+				break;
+			case 0x70:
+			case 0x80:
+			case 0x90:
+				scan.cpWritten |= 1 << (CP_VAT + (cmd2 & 7) * 3 + ((cmd2 >> 4) - 7));
+				break;
+			}
+			scan.stats.cpWrites++;
+		}
+		break;
+
+	case GX_LOAD_XF_REG:
+		{
+			drawing = false;
+
+			u32 cmd2 = ReadFifo32(data);
+			u8 streamSize = ((cmd2 >> 16) & 15) + 1;
+
+			data += streamSize * 4;
+			scan.stats.xfWrites++;
+			scan.stats.xfWords += streamSize;
+		}
+		break;
+
+	case GX_LOAD_INDX_A:
+	case GX_LOAD_INDX_B:
+	case GX_LOAD_INDX_C:
+	case GX_LOAD_INDX_D:
+		drawing = false;
+		data += 4;
+		scan.stats.indexedXFLoads++;
+		break;
+
+	case GX_CMD_CALL_DL:
+		// The recorder should have expanded display lists into the fifo stream and skipped the call to start them
+		// That is done to make it easier to track where memory is updated
+		_assert_(false);
+		data += 8;
+		break;
+
+	case GX_LOAD_BP_REG:
+		{
+			drawing = false;
+
+			u32 cmd2 = ReadFifo32(data);
+			scan.bpPositions.push_back(position);
+			scan.bpValues.push_back(cmd2);
+			scan.stats.bpWrites++;
+		}
+		break;
+
+	default:
+		if (cmd & 0x80)
+		{
+			drawing = true;
+
+			u32 vtxAttrGroup = cmd & GX_VAT_MASK;
+			const u32 needed = (1 << CP_VTXDESC_LOW) | (1 << CP_VTXDESC_HIGH) | (7 << (CP_VAT + vtxAttrGroup * 3));
+			scan.cpRead |= needed & ~scan.cpWritten;
+			int vertexSize = CalculateVertexSize(vtxAttrGroup, scan.cp);
+
+			u16 streamSize = ReadFifo16(data);
+
+			data += streamSize * vertexSize;
+
+			scan.stats.drawCalls++;
+			scan.stats.primitives[(cmd & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT]++;
+			scan.stats.vertices += streamSize;
+			scan.stats.vertexBytes += streamSize * vertexSize;
+		}
+		else
+		{
+			scan.badOpcode = cmd;
+			return 0;
+		}
+		break;
+	}
+
+	return (u32)(data - dataStart);
+}
+
+// Goes through the commands of a frame, starting with the given CP state.
+// The data buffer is reused for the frames of a streamed file.
+static void ScanFrame(FifoDataFile *file, size_t frameIdx, const CPMemory &startCp, vector<u8> &data, FrameScan &scan)
+{
+	scan.objectStarts.clear();
+	scan.objectEnds.clear();
+	scan.bpPositions.clear();
+	scan.bpValues.clear();
+	scan.lastCommand = 0;
+	scan.badOpcode = 0;
+	scan.error = false;
+	scan.readFailed = false;
+	scan.startCp = startCp;
+	scan.cp = startCp;
+	scan.cpRead = 0;
+	scan.cpWritten = 0;
+	memset(&scan.stats, 0, sizeof(scan.stats));
+
+	const FifoFrameInfo &frame = file->GetFrame(frameIdx);
+	u8 *fifoData = frame.fifoData;
+	if (file->IsStreaming())
+	{
+		if (!file->ReadFifoData(frameIdx, data))
+		{
+			scan.readFailed = true;
+			return;
+		}
+		fifoData = data.data();
+	}
+
+	bool drawing = false;
+	u32 cmdStart = 0;
+	while (cmdStart < frame.fifoDataSize)
+	{
+		scan.lastCommand = cmdStart;
+
+		bool wasDrawing = drawing;
+
+		u32 cmdSize = ScanCommand(&fifoData[cmdStart], cmdStart, drawing, scan);
+
+		// Check for error
+		if (cmdSize == 0)
+		{
+			scan.error = true;
+			return;
+		}
+
+		if (wasDrawing != drawing)
+		{
+			if (drawing)
+				scan.objectStarts.push_back(cmdStart);
+			else
+				scan.objectEnds.push_back(cmdStart);
+		}
+
+		cmdStart += cmdSize;
+	}
+
+	if (scan.objectEnds.size() < scan.objectStarts.size())
+		scan.objectEnds.push_back(cmdStart);
+}
+
+// Whether the frame was gone through with the values that the registers it
+// depends on have at its start
+static bool ScanMatchesState(const FrameScan &scan, const CPMemory &cpMem)
+{
+	for (int reg = 0; reg < NUM_CP_REGISTERS; ++reg)
+	{
+		if ((scan.cpRead & (1 << reg)) && GetCPRegister(scan.startCp, reg) != GetCPRegister(cpMem, reg))
+			return false;
+	}
+	return true;
+}
+
 FifoPlaybackAnalyzer::FifoPlaybackAnalyzer()
 {
 	FifoAnalyzer::Init();
@@ -46,70 +288,99 @@ void FifoPlaybackAnalyzer::AnalyzeFrames(FifoDataFile *file, std::vector<Analyze
 		FifoAnalyzer::LoadCPReg(0x90 + i, cpMem[0x90 + i], m_CpMem);
 	}
 
+	const size_t frameCount = file->GetFrameCount();
 	frameInfo.clear();
-	frameInfo.resize(file->GetFrameCount());
+	frameInfo.resize(frameCount);
 
-	for (size_t frameIdx = 0; frameIdx < file->GetFrameCount(); ++frameIdx)
+	vector<FrameScan> scans(frameCount);
+	const CPMemory startCp = m_CpMem;
+	Common::ThreadPool::ParallelFor((int)frameCount, [&](int begin, int end)
 	{
-		const FifoFrameInfo& frame = file->GetFrame(frameIdx);
-		AnalyzedFrameInfo& analyzed = frameInfo[frameIdx];
+		vector<u8> data;
+		for (int i = begin; i < end; ++i)
+			ScanFrame(file, i, startCp, data, scans[i]);
+	});
 
-		m_DrawingObject = false;
+	vector<u8> data;
+	for (size_t frameIdx = 0; frameIdx < frameCount; ++frameIdx)
+	{
+		FrameScan &scan = scans[frameIdx];
+		if (!scan.readFailed && !ScanMatchesState(scan, m_CpMem))
+			ScanFrame(file, frameIdx, m_CpMem, data, scan);
+		if (scan.readFailed)
+			return;
 
-		u32 cmdStart = 0;
-		u32 nextMemUpdate = 0;
+		for (int reg = 0; reg < NUM_CP_REGISTERS; ++reg)
+		{
+			if (scan.cpWritten & (1 << reg))
+				SetCPRegister(m_CpMem, reg, GetCPRegister(scan.cp, reg));
+		}
 
-		// Debugging
-		vector<CmdData> prevCmds;
+		const FifoFrameInfo &frame = file->GetFrame(frameIdx);
+		AnalyzedFrameInfo &analyzed = frameInfo[frameIdx];
+		analyzed.stats = scan.stats;
 
-		while (cmdStart < frame.fifoDataSize)
+		// Replay the BP writes, the memory updates that happen before each
+		// one are cut down to the memory that the EFB copies so far haven't
+		// written
+		u32 nextMemUpdate = 0;
+		auto addMemoryUpdates = [&](u32 position)
 		{
-			// Add memory updates that have occurred before this point in the frame
-			while (nextMemUpdate < frame.memoryUpdates.size() && frame.memoryUpdates[nextMemUpdate].fifoPosition <= cmdStart)
+			while (nextMemUpdate < frame.memoryUpdates.size() && frame.memoryUpdates[nextMemUpdate].fifoPosition <= position)
 			{
-				AddMemoryUpdate(frame.memoryUpdates[nextMemUpdate], analyzed);
+				const MemoryUpdate &memUpdate = frame.memoryUpdates[nextMemUpdate];
+				AnalyzedMemoryUpdate part = { nextMemUpdate, 0, memUpdate.address, memUpdate.size, memUpdate.fifoPosition };
+				AddMemoryUpdate(part, analyzed);
+
+				analyzed.stats.memoryUpdates++;
+				analyzed.stats.memoryUpdateBytes += memUpdate.size;
+				if (memUpdate.type == MemoryUpdate::TEXTURE_MAP || memUpdate.type == MemoryUpdate::TMEM)
+				{
+					analyzed.stats.textureUpdates++;
+					analyzed.stats.textureUpdateBytes += memUpdate.size;
+				}
 				++nextMemUpdate;
 			}
+		};
 
-			bool wasDrawing = m_DrawingObject;
-
-			u32 cmdSize = DecodeCommand(&frame.fifoData[cmdStart]);
-
-#if (LOG_FIFO_CMDS)
-			CmdData cmdData;
-			cmdData.offset = cmdStart;
-			cmdData.ptr = &frame.fifoData[cmdStart];
-			cmdData.size = cmdSize;
-			prevCmds.push_back(cmdData);
-#endif
-
-			// Check for error
-			if (cmdSize == 0)
-			{
-				// Clean up frame analysis
-				analyzed.objectStarts.clear();
-				analyzed.objectEnds.clear();
+		for (size_t i = 0; i < scan.bpValues.size(); ++i)
+		{
+			addMemoryUpdates(scan.bpPositions[i]);
 
-				return;
-			}
+			BPCmd bp = FifoAnalyzer::DecodeBPCmd(scan.bpValues[i], m_BpMem);
+			FifoAnalyzer::LoadBPReg(bp, m_BpMem);
 
-			if (wasDrawing != m_DrawingObject)
+			switch (bp.address)
 			{
-				if (m_DrawingObject)
-					analyzed.objectStarts.push_back(cmdStart);
+			case BPMEM_TRIGGER_EFB_COPY:
+				StoreEfbCopyRegion();
+				if (m_BpMem.triggerEFBCopy.copy_to_xfb)
+					analyzed.stats.xfbCopies++;
 				else
-					analyzed.objectEnds.push_back(cmdStart);
+					analyzed.stats.efbCopies++;
+				break;
+			case BPMEM_LOADTLUT1:
+				analyzed.stats.tlutLoads++;
+				break;
+			case BPMEM_PRELOAD_MODE:
+				analyzed.stats.tmemPreloads++;
+				break;
 			}
+		}
+		addMemoryUpdates(scan.lastCommand);
 
-			cmdStart += cmdSize;
+		if (scan.error)
+		{
+			PanicAlert("FifoPlayer: Unknown Opcode (0x%x).\nAborting frame analysis.\n", scan.badOpcode);
+			return;
 		}
 
-		if (analyzed.objectEnds.size() < analyzed.objectStarts.size())
-			analyzed.objectEnds.push_back(cmdStart);
+		analyzed.objectStarts.swap(scan.objectStarts);
+		analyzed.objectEnds.swap(scan.objectEnds);
 	}
 }
 
-void FifoPlaybackAnalyzer::AddMemoryUpdate(MemoryUpdate memUpdate, AnalyzedFrameInfo &frameInfo)
+void FifoPlaybackAnalyzer::AddMemoryUpdate(AnalyzedMemoryUpdate memUpdate, AnalyzedFrameInfo &frameInfo)
 {
 	u32 begin = memUpdate.address;
 	u32 end = memUpdate.address + memUpdate.size;
@@ -132,7 +403,7 @@ void FifoPlaybackAnalyzer::AddMemoryUpdate(MemoryUpdate memUpdate, AnalyzedFrame
 				}
 
 				u32 bytesToRangeEnd = range.end - memUpdate.address;
-				memUpdate.data += bytesToRangeEnd;
+				memUpdate.dataOffset += bytesToRangeEnd;
 				memUpdate.size = postSize;
 				memUpdate.address = range.end;
 			}
@@ -151,99 +422,13 @@ void FifoPlaybackAnalyzer::AddMemoryUpdate(MemoryUpdate memUpdate, AnalyzedFrame
 	frameInfo.memoryUpdates.push_back(memUpdate);
 }
 
-u32 FifoPlaybackAnalyzer::DecodeCommand(u8 *data)
-{
-	u8 *dataStart = data;
-
-	int cmd = ReadFifo8(data);
-
-	switch(cmd)
-	{
-	case GX_NOP:
-	case 0x44:
-	case GX_CMD_INVL_VC:
-		break;
-
-	case GX_LOAD_CP_REG:
-		{
-			m_DrawingObject = false;
-
-			u32 cmd2 = ReadFifo8(data);
-			u32 value = ReadFifo32(data);
-			FifoAnalyzer::LoadCPReg(cmd2, value, m_CpMem);
-		}
-		break;
-
-	case GX_LOAD_XF_REG:
-		{
-			m_DrawingObject = false;
-
-			u32 cmd2 = ReadFifo32(data);
-			u8 streamSize = ((cmd2 >> 16) & 15) + 1;
-
-			data += streamSize * 4;
-		}
-		break;
-
-	case GX_LOAD_INDX_A:
-	case GX_LOAD_INDX_B:
-	case GX_LOAD_INDX_C:
-	case GX_LOAD_INDX_D:
-		m_DrawingObject = false;
-		data += 4;
-		break;
-
-	case GX_CMD_CALL_DL:
-		// The recorder should have expanded display lists into the fifo stream and skipped the call to start them
-		// That is done to make it easier to track where memory is updated
-		_assert_(false);
-		data += 8;
-		break;
-
-	case GX_LOAD_BP_REG:
-		{
-			m_DrawingObject = false;
-
-			u32 cmd2 = ReadFifo32(data);
-			BPCmd bp = FifoAnalyzer::DecodeBPCmd(cmd2, m_BpMem);
-
-			FifoAnalyzer::LoadBPReg(bp, m_BpMem);
-
-			if (bp.address == BPMEM_TRIGGER_EFB_COPY)
-				StoreEfbCopyRegion();
-		}
-		break;
-
-	default:
-		if (cmd & 0x80)
-		{
-			m_DrawingObject = true;
-
-			u32 vtxAttrGroup = cmd & GX_VAT_MASK;
-			int vertexSize = FifoAnalyzer::CalculateVertexSize(vtxAttrGroup, m_CpMem);
-
-			u16 streamSize = ReadFifo16(data);
-
-			data += streamSize * vertexSize;
-		}
-		else
-		{
-			PanicAlert("FifoPlayer: Unknown Opcode (0x%x).\nAborting frame analysis.\n", cmd);
-			return 0;
-		}
-		break;
-	}
-
-	return (u32)(data - dataStart);
-}
-
 void FifoPlaybackAnalyzer::StoreEfbCopyRegion()
 {
 	UPE_Copy peCopy = m_BpMem.triggerEFBCopy;
 
 	u32 copyfmt = peCopy.tp_realFormat();
 	bool bFromZBuffer = m_BpMem.zcontrol.pixel_format == PIXELFMT_Z24;
-	u32 address = bpmem.copyTexDest << 5;
+	u32 address = m_BpMem.copyTexDest << 5;
 
 	u32 format = copyfmt;
 
@@ -10,11 +10,46 @@
 #include <string>
 #include <vector>
 
+// The part of a memory update that the player writes, memory the GPU writes
+// itself during the frame is left out. Refers to the update by index, so it
+// stays valid while the data of a streamed file isn't in memory.
+struct AnalyzedMemoryUpdate
+{
+	u32 update; // in FifoFrameInfo::memoryUpdates
+	u32 dataOffset;
+	u32 address;
+	u32 size;
+	u32 fifoPosition;
+};
+
+// What a frame makes the GPU do, counted from the recorded commands
+struct FifoFrameStats
+{
+	u32 drawCalls;
+	u32 primitives[8]; // draw calls by GX_DRAW_* type
+	u32 vertices;
+	u32 vertexBytes;
+	u32 bpWrites;
+	u32 cpWrites;
+	u32 xfWrites;
+	u32 xfWords;
+	u32 indexedXFLoads;
+	u32 efbCopies; // to textures in RAM
+	u32 xfbCopies;
+	u32 tlutLoads;
+	u32 tmemPreloads;
+	u32 memoryUpdates;
+	u32 memoryUpdateBytes;
+	u32 textureUpdates; // memory updates of textures and preloaded TMEM
+	u32 textureUpdateBytes;
+};
+
 struct AnalyzedFrameInfo
 {
 	std::vector<u32> objectStarts;
 	std::vector<u32> objectEnds;
-	std::vector<MemoryUpdate> memoryUpdates;
+	std::vector<AnalyzedMemoryUpdate> memoryUpdates;
+	FifoFrameStats stats;
 };
 
 class FifoPlaybackAnalyzer
@@ -22,6 +57,10 @@ class FifoPlaybackAnalyzer
 public:
 	FifoPlaybackAnalyzer();
 
+	// The commands of the frames are gone through on the thread pool, with
+	// the CP state at the start of the log. Frames whose vertices depend on
+	// CP registers that an earlier frame changed are gone through again, in
+	// order, together with what depends on the BP registers.
 	void AnalyzeFrames(FifoDataFile *file, std::vector<AnalyzedFrameInfo> &frameInfo);
 
 private:
@@ -31,16 +70,11 @@ private:
 		u32 end;
 	};
 
-	void AddMemoryUpdate(MemoryUpdate memUpdate, AnalyzedFrameInfo &frameInfo);
-
-	u32 DecodeCommand(u8 *data);
-	void LoadBP(u32 value0);
+	void AddMemoryUpdate(AnalyzedMemoryUpdate memUpdate, AnalyzedFrameInfo &frameInfo);
 
 	void StoreEfbCopyRegion();
 	void StoreWrittenRegion(u32 address, u32 size);
 
-	bool m_DrawingObject;
-
 	std::vector<MemoryRange> m_WrittenMemory;
 
 	BPMemory m_BpMem;
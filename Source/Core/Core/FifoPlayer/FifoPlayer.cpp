@@ -27,7 +27,7 @@ bool FifoPlayer::Open(const std::string& filename)
 {
 	Close();
 
-	m_File = FifoDataFile::Load(filename, false);
+	m_File = FifoDataFile::Load(filename, false, true);
 
 	if (m_File)
 	{
@@ -45,6 +45,7 @@ bool FifoPlayer::Open(const std::string& filename)
 
 void FifoPlayer::Close()
 {
+	CancelPrefetch();
 	delete m_File;
 	m_File = NULL;
 
@@ -92,16 +93,67 @@ bool FifoPlayer::Play()
 				if (m_EarlyMemoryUpdates && m_CurrentFrame == m_FrameRangeStart)
 					WriteAllMemoryUpdates();
 
-				WriteFrame(m_File->GetFrame(m_CurrentFrame), m_FrameInfo[m_CurrentFrame]);
+				const u32 frame = m_CurrentFrame;
+				if (!PinFrameToWrite(frame))
+				{
+					m_File->UnpinFrame(frame);
+					PanicAlertT("Couldn't read frame %u of the FIFO log.", frame);
+					PowerPC::Stop();
+					Host_Message(WM_USER_STOP);
+					continue;
+				}
+
+				u32 next = frame + 1;
+				if (next >= m_FrameRangeEnd && m_Loop)
+					next = m_FrameRangeStart;
+				if (next < m_FrameRangeEnd)
+					PrefetchFrame(next);
+
+				WriteFrame(m_File->GetFrame(frame), m_FrameInfo[frame]);
+				m_File->UnpinFrame(frame);
 
 				++m_CurrentFrame;
 			}
 		}
 	}
 
+	CancelPrefetch();
+
 	return true;
 }
 
+bool FifoPlayer::PinFrameToWrite(u32 frame)
+{
+	m_Prefetch.Wait();
+	if (m_PrefetchedFrame == frame)
+	{
+		m_PrefetchedFrame = (u32)-1;
+		return m_PrefetchOk;
+	}
+
+	// The frame range changed since the prefetch was started
+	CancelPrefetch();
+	return m_File->PinFrame(frame);
+}
+
+void FifoPlayer::PrefetchFrame(u32 frame)
+{
+	if (!m_File->IsStreaming())
+		return;
+
+	FifoDataFile* file = m_File;
+	m_PrefetchedFrame = frame;
+	m_Prefetch.Run([this, file, frame] { m_PrefetchOk = file->PinFrame(frame); });
+}
+
+void FifoPlayer::CancelPrefetch()
+{
+	m_Prefetch.Wait();
+	if (m_PrefetchedFrame != (u32)-1)
+		m_File->UnpinFrame(m_PrefetchedFrame);
+	m_PrefetchedFrame = (u32)-1;
+}
+
 u32 FifoPlayer::GetFrameObjectCount()
 {
 	if (m_CurrentFrame < m_FrameInfo.size())
@@ -161,7 +213,9 @@ FifoPlayer::FifoPlayer() :
 	m_EarlyMemoryUpdates(false),
 	m_FileLoadedCb(NULL),
 	m_FrameWrittenCb(NULL),
-	m_File(NULL)
+	m_File(NULL),
+	m_PrefetchedFrame((u32)-1),
+	m_PrefetchOk(false)
 {
 	m_Loop = SConfig::GetInstance().m_LocalCoreStartupParameter.bLoopFifoReplay;
 }
@@ -184,7 +238,7 @@ void FifoPlayer::WriteFrame(const FifoFrameInfo &frame, const AnalyzedFrameInfo
 	// Skip memory updates during frame if true
 	if (m_EarlyMemoryUpdates)
 	{
-		memoryUpdate = (u32)(frame.memoryUpdates.size());
+		memoryUpdate = (u32)(info.memoryUpdates.size());
 	}
 
 	if (numObjects > 0)
@@ -229,9 +283,9 @@ void FifoPlayer::WriteFramePart(u32 dataStart, u32 dataEnd, u32 &nextMemUpdate,
 {
 	u8 *data = frame.fifoData;
 
-	while (nextMemUpdate < frame.memoryUpdates.size() && dataStart < dataEnd)
+	while (nextMemUpdate < info.memoryUpdates.size() && dataStart < dataEnd)
 	{
-		const MemoryUpdate &memUpdate = info.memoryUpdates[nextMemUpdate];
+		const AnalyzedMemoryUpdate &memUpdate = info.memoryUpdates[nextMemUpdate];
 
 		if (memUpdate.fifoPosition < dataEnd)
 		{
@@ -241,7 +295,7 @@ void FifoPlayer::WriteFramePart(u32 dataStart, u32 dataEnd, u32 &nextMemUpdate,
 				dataStart = memUpdate.fifoPosition;
 			}
 
-			WriteMemory(memUpdate);
+			WriteMemory(memUpdate.address, frame.memoryUpdates[memUpdate.update].data + memUpdate.dataOffset, memUpdate.size);
 
 			++nextMemUpdate;
 		}
@@ -262,24 +316,28 @@ void FifoPlayer::WriteAllMemoryUpdates()
 
 	for (size_t frameNum = 0; frameNum < m_File->GetFrameCount(); ++frameNum)
 	{
-		const FifoFrameInfo &frame = m_File->GetFrame(frameNum);
-		for (auto& update : frame.memoryUpdates)
+		if (m_File->PinFrame(frameNum))
 		{
-			WriteMemory(update);
+			const FifoFrameInfo &frame = m_File->GetFrame(frameNum);
+			for (auto& update : frame.memoryUpdates)
+			{
+				WriteMemory(update.address, update.data, update.size);
+			}
 		}
+		m_File->UnpinFrame(frameNum);
 	}
 }
 
-void FifoPlayer::WriteMemory(const MemoryUpdate& memUpdate)
+void FifoPlayer::WriteMemory(u32 address, const u8 *data, u32 size)
 {
 	u8 *mem = NULL;
 
-	if (memUpdate.address & 0x10000000)
-		mem = &Memory::m_pEXRAM[memUpdate.address & Memory::EXRAM_MASK];
+	if (address & 0x10000000)
+		mem = &Memory::m_pEXRAM[address & Memory::EXRAM_MASK];
 	else
-		mem = &Memory::m_pRAM[memUpdate.address & Memory::RAM_MASK];
+		mem = &Memory::m_pRAM[address & Memory::RAM_MASK];
 
-	memcpy(mem, memUpdate.data, memUpdate.size);
+	memcpy(mem, data, size);
 }
 
 void FifoPlayer::WriteFifo(u8 *data, u32 start, u32 end)
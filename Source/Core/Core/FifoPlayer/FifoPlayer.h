@@ -5,6 +5,7 @@
 #pragma once
 
 #include "FifoPlaybackAnalyzer.h"
+#include "ThreadPool.h"
 #include <string>
 #include <vector>
 
@@ -63,7 +64,13 @@ private:
 	void WriteFramePart(u32 dataStart, u32 dataEnd, u32 &nextMemUpdate, const FifoFrameInfo &frame, const AnalyzedFrameInfo &info);
 
 	void WriteAllMemoryUpdates();
-	void WriteMemory(const MemoryUpdate &memUpdate);
+	void WriteMemory(u32 address, const u8 *data, u32 size);
+
+	// The file is streamed, the frame after the one that is written is read
+	// in the meantime on the thread pool
+	bool PinFrameToWrite(u32 frame);
+	void PrefetchFrame(u32 frame);
+	void CancelPrefetch();
 
 	// writes a range of data to the fifo
 	// start and end must be relative to frame's fifo data so elapsed cycles are figured correctly
@@ -106,4 +113,8 @@ private:
 	FifoDataFile *m_File;
 
 	std::vector<AnalyzedFrameInfo> m_FrameInfo;
+
+	Common::TaskGroup m_Prefetch;
+	u32 m_PrefetchedFrame; // pinned by the prefetch, or -1
+	bool m_PrefetchOk;
 };
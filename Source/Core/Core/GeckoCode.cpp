@@ -48,11 +48,73 @@ static bool code_handler_installed = false;
 std::vector<GeckoCode> active_codes;
 static std::mutex active_codes_lock;
 
+// A constant write to RAM relative to the base address, which the code
+// handler sets to 0x80000000 on every run
+struct DirectWrite
+{
+	u32 address;
+	u32 value;
+	u32 count;
+	u8 size;
+};
+
+// When the active codes are only direct writes they are done here, instead
+// of copying the code handler into the game's memory and running it in the
+// interpreter every frame
+static std::vector<DirectWrite> direct_writes;
+static bool direct_writes_only = false;
+
+static bool DecodeDirectWrite(const GeckoCode::Code& code, DirectWrite* write)
+{
+	// The low bit of the code type is bit 24 of the address, 0x10 would make
+	// the address relative to the pointer instead
+	write->address = 0x80000000 | (code.address & 0x01FFFFFF);
+	switch (code.address >> 25)
+	{
+	case 0x00 >> 1:
+		write->size = 1;
+		write->value = code.data & 0xFF;
+		write->count = (code.data >> 16) + 1;
+		return true;
+	case 0x02 >> 1:
+		write->size = 2;
+		write->value = code.data & 0xFFFF;
+		write->count = (code.data >> 16) + 1;
+		return true;
+	case 0x04 >> 1:
+		write->size = 4;
+		write->value = code.data;
+		write->count = 1;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void RunDirectWrites()
+{
+	for (const DirectWrite& write : direct_writes)
+	{
+		for (u32 i = 0; i < write.count; ++i)
+		{
+			const u32 address = write.address + i * write.size;
+			switch (write.size)
+			{
+			case 1: Memory::Write_U8((u8)write.value, address); break;
+			case 2: Memory::Write_U16((u16)write.value, address); break;
+			default: Memory::Write_U32(write.value, address); break;
+			}
+		}
+	}
+}
+
 void SetActiveCodes(const std::vector<GeckoCode>& gcodes)
 {
 	std::lock_guard<std::mutex> lk(active_codes_lock);
 
 	active_codes.clear();
+	direct_writes.clear();
+	direct_writes_only = true;
 
 	// add enabled codes
 	for (const GeckoCode& gecko_code : gcodes)
@@ -62,9 +124,21 @@ void SetActiveCodes(const std::vector<GeckoCode>& gcodes)
 			// TODO: apply modifiers
 			// TODO: don't need description or creator string, just takin up memory
 			active_codes.push_back(gecko_code);
+
+			for (const GeckoCode::Code& code : gecko_code.codes)
+			{
+				DirectWrite write;
+				if (direct_writes_only && DecodeDirectWrite(code, &write))
+					direct_writes.push_back(write);
+				else
+					direct_writes_only = false;
+			}
 		}
 	}
 
+	if (!direct_writes_only)
+		direct_writes.clear();
+
 	code_handler_installed = false;
 }
 
@@ -132,6 +206,13 @@ void RunCodeHandler()
 {
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableCheats && active_codes.size() > 0)
 	{
+		if (direct_writes_only)
+		{
+			std::lock_guard<std::mutex> lk(active_codes_lock);
+			RunDirectWrites();
+			return;
+		}
+
 		if (!code_handler_installed || Memory::Read_U32(0x80001800) - 0xd01f1bad > 5)
 			code_handler_installed = InstallCodeHandler();
 
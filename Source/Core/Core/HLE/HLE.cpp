@@ -12,6 +12,7 @@
 #include "../Debugger/Debugger_SymbolMap.h"
 
 #include "HLE_OS.h"
+#include "HLE_Memory.h"
 #include "HLE_Misc.h"
 #include "IPC_HLE/WII_IPC_HLE_Device_es.h"
 #include "ConfigManager.h"
@@ -64,6 +65,18 @@ static const SPatch OSPatches[] =
 	{ "___blank",             HLE_OS::HLE_GeneralDebugPrint,   HLE_HOOK_REPLACE, HLE_TYPE_DEBUG },
 	{ "__write_console",      HLE_OS::HLE_write_console,       HLE_HOOK_REPLACE, HLE_TYPE_DEBUG }, // used by sysmenu (+more?)
 	{ "GeckoCodehandler",     HLE_Misc::HLEGeckoCodehandler,   HLE_HOOK_START,   HLE_TYPE_GENERIC },
+
+	// Memory and cache routines, off with the MMU
+	{ "memcpy",               HLE_Memory::Memcpy,              HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "memmove",              HLE_Memory::Memmove,             HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "memset",               HLE_Memory::Memset,              HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "strlen",               HLE_Memory::Strlen,              HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCFlushRange",         HLE_Memory::DCFlushRange,        HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCFlushRangeNoSync",   HLE_Memory::DCFlushRange,        HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCStoreRange",         HLE_Memory::DCFlushRange,        HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCStoreRangeNoSync",   HLE_Memory::DCFlushRange,        HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCInvalidateRange",    HLE_Memory::DCFlushRange,        HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
+	{ "DCZeroRange",          HLE_Memory::DCZeroRange,         HLE_HOOK_REPLACE, HLE_TYPE_MEMORY },
 };
 
 static const SPatch OSBreakPoints[] =
@@ -0,0 +1,166 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common.h"
+#include "HLE_Memory.h"
+
+#include "../Core.h"
+#include "../PowerPC/PowerPC.h"
+#include "../HW/Memmap.h"
+#include "../PowerPC/JitInterface.h"
+
+namespace HLE_Memory
+{
+
+// Host pointer to a range the guest could have accessed with plain loads and
+// stores, or NULL if the slow path has to do it
+static u8* GetHostRange(u32 address, u32 size)
+{
+	if (Memory::HasMemChecks())
+		return NULL;
+	return Memory::GetRangePointer(address, size);
+}
+
+// Copies front to back one byte at a time like the guest's byte loop, which
+// is also what an overlapping memcpy does there
+static void CopySlow(u32 dst, u32 src, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+		Memory::Write_U8(Memory::Read_U8(src + i), dst + i);
+}
+
+// void* memcpy(void* dst, const void* src, size_t n)
+void Memcpy()
+{
+	const u32 dst = GPR(3);
+	const u32 src = GPR(4);
+	const u32 size = GPR(5);
+
+	u8* dst_ptr = GetHostRange(dst, size);
+	const u8* src_ptr = GetHostRange(src, size);
+	if (dst_ptr && src_ptr && (dst_ptr + size <= src_ptr || src_ptr + size <= dst_ptr))
+		std::memcpy(dst_ptr, src_ptr, size);
+	else
+		CopySlow(dst, src, size);
+
+	// r3 already holds dst, the return value
+	NPC = LR;
+}
+
+// void* memmove(void* dst, const void* src, size_t n)
+void Memmove()
+{
+	const u32 dst = GPR(3);
+	const u32 src = GPR(4);
+	const u32 size = GPR(5);
+
+	u8* dst_ptr = GetHostRange(dst, size);
+	const u8* src_ptr = GetHostRange(src, size);
+	if (dst_ptr && src_ptr)
+	{
+		std::memmove(dst_ptr, src_ptr, size);
+	}
+	else if (dst > src && dst - src < size)
+	{
+		// Back to front, so the overlap isn't overwritten before it's read
+		for (u32 i = size; i-- > 0;)
+			Memory::Write_U8(Memory::Read_U8(src + i), dst + i);
+	}
+	else
+	{
+		CopySlow(dst, src, size);
+	}
+
+	NPC = LR;
+}
+
+// void* memset(void* dst, int c, size_t n)
+void Memset()
+{
+	const u32 dst = GPR(3);
+	const u8 value = (u8)GPR(4);
+	const u32 size = GPR(5);
+
+	if (!Memory::HasMemChecks())
+	{
+		Memory::Memset(dst, value, size);
+	}
+	else
+	{
+		for (u32 i = 0; i < size; i++)
+			Memory::Write_U8(value, dst + i);
+	}
+
+	NPC = LR;
+}
+
+// size_t strlen(const char* s)
+void Strlen()
+{
+	const u32 str = GPR(3);
+	u32 length = 0;
+	while (true)
+	{
+		// Look at the string a page at a time, so that one ending right before
+		// the end of RAM doesn't send it to the slow path
+		const u32 address = str + length;
+		const u32 chunk = 0x1000 - (address & 0xfff);
+		const u8* ptr = GetHostRange(address, chunk);
+		if (!ptr)
+		{
+			while (Memory::Read_U8(str + length) != 0)
+				length++;
+			break;
+		}
+
+		const u8* end = (const u8*)std::memchr(ptr, 0, chunk);
+		if (end)
+		{
+			length += (u32)(end - ptr);
+			break;
+		}
+		length += chunk;
+	}
+
+	GPR(3) = length;
+	NPC = LR;
+}
+
+// The lines DCFlushRange(void* addr, u32 n) and friends work on
+static bool GetCacheLines(u32* start, u32* size)
+{
+	const u32 address = GPR(3);
+	const u32 length = GPR(4);
+	if (length == 0)
+		return false;
+
+	*start = address & ~31;
+	*size = ((address & 31) + length + 31) & ~31;
+	return true;
+}
+
+// Also DCStoreRange, DCInvalidateRange and their NoSync versions. We don't
+// emulate the data cache, dcbf, dcbst and dcbi only throw away the JIT
+// blocks in the line, which is done here for the whole range at once.
+void DCFlushRange()
+{
+	u32 start, size;
+	if (GetCacheLines(&start, &size))
+		JitInterface::InvalidateICache(start, size);
+	NPC = LR;
+}
+
+// void DCZeroRange(void* addr, u32 n), a dcbz loop
+void DCZeroRange()
+{
+	u32 start, size;
+	// Like dcbz, which doesn't trigger memory checks either
+	if (GetCacheLines(&start, &size) && !Core::g_CoreStartupParameter.bDCBZOFF)
+		Memory::Memset(start, 0, size);
+	NPC = LR;
+}
+
+}  // namespace
@@ -0,0 +1,18 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// Native versions of the SDK's memory and cache routines, found through the
+// signature database. They work on RAM directly and go through the slow
+// memory path for anything else and while memory checks are set.
+namespace HLE_Memory
+{
+	void Memcpy();
+	void Memmove();
+	void Memset();
+	void Strlen();
+	void DCFlushRange();
+	void DCZeroRange();
+}
@@ -66,7 +66,7 @@ void ExecuteDOL(u8* dolFile, u32 fileSize)
 	if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging)
 	{
 		g_symbolDB.Clear();
-		PPCAnalyst::FindFunctions(0x80004000, 0x811fffff, &g_symbolDB);
+		PPCAnalyst::FindFunctionsCached(0x80004000, 0x811fffff, &g_symbolDB);
 		SignatureDB db;
 		if (db.Load((File::GetSysDirectory() + TOTALDB).c_str()))
 		{
@@ -20,6 +20,7 @@
 #include "../EXI_DeviceEthernet.h"
 
 #ifdef __linux__
+#include <cerrno>
 #include <fcntl.h>
 #include <linux/if_tun.h>
 #include <net/if.h>
@@ -27,6 +28,7 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
 #define NOTIMPLEMENTED(Name) \
@@ -63,6 +65,9 @@ bool CEXIETHERNET::Activate()
 	}
 	ioctl(fd, TUNSETNOCSUM, 1);
 
+	// The read thread drains every frame that is queued before it waits again
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
 	readEnabled = false;
 
 	INFO_LOG(SP1, "BBA initialized with associated tap %s", ifr.ifr_name);
@@ -119,6 +124,28 @@ bool CEXIETHERNET::SendFrame(u8* frame, u32 size)
 #endif
 }
 
+// Frames are read straight into the receive ring when a whole one fits in
+// front of RRP, so they aren't copied again. A frame is never split across
+// reads, so if it might not fit it goes to mRecvBuffer.
+static int ReadFrame(CEXIETHERNET* self, bool* in_ring)
+{
+	u8* seg[2];
+	u32 seg_size[2];
+	if (self->readEnabled && self->RecvRingSpace(seg, seg_size) >= BBA_RECV_SIZE)
+	{
+		struct iovec iov[2];
+		iov[0].iov_base = seg[0];
+		iov[0].iov_len = seg_size[0];
+		iov[1].iov_base = seg[1];
+		iov[1].iov_len = seg_size[1];
+		*in_ring = true;
+		return readv(self->fd, iov, seg_size[1] ? 2 : 1);
+	}
+
+	*in_ring = false;
+	return read(self->fd, self->mRecvBuffer, BBA_RECV_SIZE);
+}
+
 void ReadThreadHandler(CEXIETHERNET* self)
 {
 	while (true)
@@ -136,16 +163,21 @@ void ReadThreadHandler(CEXIETHERNET* self)
 		if (select(self->fd + 1, &rfds, NULL, NULL, &timeout) <= 0)
 			continue;
 
-		int readBytes = read(self->fd, self->mRecvBuffer, BBA_RECV_SIZE);
-		if (readBytes < 0)
-		{
-			ERROR_LOG(SP1, "Failed to read from BBA, err=%d", readBytes);
-		}
-		else if (self->readEnabled)
+		while (self->fd >= 0)
 		{
-			INFO_LOG(SP1, "Read data: %s", ArrayToString(self->mRecvBuffer, readBytes, 0x10).c_str());
-			self->mRecvBufferLength = readBytes;
-			self->RecvHandlePacket();
+			bool in_ring;
+			int readBytes = ReadFrame(self, &in_ring);
+			if (readBytes < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+					ERROR_LOG(SP1, "Failed to read from BBA, err=%d", errno);
+				break;
+			}
+			else if (self->readEnabled)
+			{
+				self->mRecvBufferLength = readBytes;
+				self->RecvHandlePacket(in_ring);
+			}
 		}
 	}
 }
@@ -212,7 +212,7 @@ static const int DSP_MAIL_SLICE=72;
 void DoState(PointerWrap &p)
 {
 	if (!g_ARAM.wii_mode)
-		p.DoArray(g_ARAM.ptr, g_ARAM.size);
+		p.DoRegion(g_ARAM.ptr, g_ARAM.size);
 	p.DoPOD(g_dspState);
 	p.DoPOD(g_audioDMA);
 	p.DoPOD(g_arDMA);
@@ -522,8 +522,23 @@ void UpdateAudioDMA()
 	}
 }
 
+// Main RAM for the current ARAM DMA if it can be done as one copy: the
+// transfer must not wrap around in ARAM, lie in RAM as a whole and not be
+// watched by memory breakpoints
+static u8* GetBulkDMAPointer()
+{
+	const u32 count = g_arDMA.Cnt.count;
+	if (Memory::AreMemoryBreakpointsActivated() || (count & 7) ||
+	    (g_arDMA.ARAddr & g_ARAM.mask) + count > g_ARAM.size)
+		return NULL;
+	return Memory::GetRangePointer(g_arDMA.MMAddr, count);
+}
+
 void Do_ARAM_DMA()
 {
+	// A DSP thread running behind must not see the transfer early
+	dsp_emulator->DSP_Sync();
+
 	if (g_arDMA.Cnt.count == 32)
 	{
 		// Beyond Good and Evil (GGEE41) sends count 32
@@ -561,6 +576,17 @@ void Do_ARAM_DMA()
 
 		if (g_arDMA.ARAddr < g_ARAM.size)
 		{
+			// The mapping modes don't change anything for reads, so whole
+			// transfers within RAM are one copy
+			u8* dst = GetBulkDMAPointer();
+			if (dst)
+			{
+				Memory::StreamCopy(dst, &g_ARAM.ptr[g_arDMA.ARAddr & g_ARAM.mask], g_arDMA.Cnt.count);
+				g_arDMA.MMAddr += g_arDMA.Cnt.count;
+				g_arDMA.ARAddr += g_arDMA.Cnt.count;
+				g_arDMA.Cnt.count = 0;
+			}
+
 			while (g_arDMA.Cnt.count)
 			{
 				// These are logically seperated in code to show that a memory map has been set up
@@ -607,6 +633,16 @@ void Do_ARAM_DMA()
 
 		if (g_arDMA.ARAddr < g_ARAM.size)
 		{
+			// Mode 4 mirrors writes below 4MB, those take the slow path
+			const u8* src = GetBulkDMAPointer();
+			if (src && ((g_ARAM_Info.Hex & 0xf) != 4 || g_arDMA.ARAddr >= 0x400000))
+			{
+				Memory::StreamCopy(&g_ARAM.ptr[g_arDMA.ARAddr & g_ARAM.mask], src, g_arDMA.Cnt.count);
+				g_arDMA.MMAddr += g_arDMA.Cnt.count;
+				g_arDMA.ARAddr += g_arDMA.Cnt.count;
+				g_arDMA.Cnt.count = 0;
+			}
+
 			while (g_arDMA.Cnt.count)
 			{
 				if ((g_ARAM_Info.Hex & 0xf) == 3)
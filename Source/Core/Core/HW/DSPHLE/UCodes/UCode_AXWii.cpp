@@ -4,6 +4,9 @@
 
 #include "MathUtil.h"
 #include "StringUtil.h"
+#include "ThreadPool.h"
+
+#include "ConfigManager.h"
 
 #include "../MailHandler.h"
 #include "Mixer.h"
@@ -425,38 +428,68 @@ void CUCode_AXWii::ReinjectUpdatesFields(AXPBWii& pb, u16* num_updates, u32 upda
 	pb_mem[45] = updates_addr & 0xFFFF;
 }
 
-void CUCode_AXWii::ProcessPBList(u32 pb_addr)
+// Mixing buffers of a thread processing voices in parallel with others, in
+// the order of AXBuffers.
+struct AXWiiMixBuffers
 {
-	AXPBWii pb;
+	int main[12][32 * 3];
+	int wm[8][6 * 3];
 
-	while (pb_addr)
+	AXBuffers Get()
 	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround,
-			m_samples_auxC_left,
-			m_samples_auxC_right,
-			m_samples_auxC_surround,
-			m_samples_wm0,
-			m_samples_aux0,
-			m_samples_wm1,
-			m_samples_aux1,
-			m_samples_wm2,
-			m_samples_aux2,
-			m_samples_wm3,
-			m_samples_aux3
-		}};
+		AXBuffers buffers;
+		for (int i = 0; i < 12; ++i)
+			buffers.ptrs[i] = main[i];
+		for (int i = 0; i < 8; ++i)
+			buffers.ptrs[12 + i] = wm[i];
+		return buffers;
+	}
 
-		if (!ReadPB(pb_addr, pb))
-			break;
+	void AddTo(const AXBuffers& buffers) const
+	{
+		for (int i = 0; i < 12; ++i)
+			for (int j = 0; j < 32 * 3; ++j)
+				buffers.ptrs[i][j] += main[i][j];
+		for (int i = 0; i < 8; ++i)
+			for (int j = 0; j < 6 * 3; ++j)
+				buffers.ptrs[12 + i][j] += wm[i][j];
+	}
+};
+
+void CUCode_AXWii::ProcessPBList(u32 pb_addr)
+{
+	// Below this many voices, the workers cost more than they save.
+	const int MIN_PARALLEL_PBS = 8;
+	// Never read ahead more than that, in case the chain is corrupted.
+	const size_t MAX_PARALLEL_PBS = 1024;
 
+	const AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround,
+		m_samples_auxC_left,
+		m_samples_auxC_right,
+		m_samples_auxC_surround,
+		m_samples_wm0,
+		m_samples_aux0,
+		m_samples_wm1,
+		m_samples_aux1,
+		m_samples_wm2,
+		m_samples_aux2,
+		m_samples_wm3,
+		m_samples_aux3
+	}};
+
+	const s16* coeffs = m_coeffs_available ? m_coeffs : NULL;
+
+	auto process_pb = [this, coeffs](AXPBWii& pb, AXBuffers buffers)
+	{
 		u16 num_updates[3];
 		u16 updates[1024];
 		u32 updates_addr;
@@ -467,11 +500,12 @@ void CUCode_AXWii::ProcessPBList(u32 pb_addr)
 				ApplyUpdatesForMs(curr_ms, (u16*)&pb, num_updates, updates);
 				ProcessVoice(pb, buffers, 32,
 				             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
-				             m_coeffs_available ? m_coeffs : NULL);
+				             coeffs);
 
-				// Forward the buffers
+				// Forward the buffers, the Wiimote ones only get 6 samples
+				// per ms.
 				for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
-					buffers.ptrs[i] += 32;
+					buffers.ptrs[i] += i < 12 ? 32 : 6;
 			}
 			ReinjectUpdatesFields(pb, num_updates, updates_addr);
 		}
@@ -479,8 +513,67 @@ void CUCode_AXWii::ProcessPBList(u32 pb_addr)
 		{
 			ProcessVoice(pb, buffers, 96,
 			             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
-			             m_coeffs_available ? m_coeffs : NULL);
+			             coeffs);
 		}
+	};
+
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bParallelAXVoices &&
+	    Common::ThreadPool::GetNumWorkers() > 0)
+	{
+		// Read the whole chain first, then process the voices on the thread
+		// pool. Voices only share the mixing buffers, so every thread mixes
+		// into its own and they are summed at the end. Integer sums don't
+		// depend on the order, so the result is the same as mixing the voices
+		// one after the other.
+		m_pb_addrs.clear();
+		while (pb_addr && m_pb_addrs.size() < MAX_PARALLEL_PBS)
+		{
+			if (m_pbs.size() == m_pb_addrs.size())
+				m_pbs.resize(m_pbs.size() + 32);
+
+			AXPBWii& pb = m_pbs[m_pb_addrs.size()];
+			if (!ReadPB(pb_addr, pb))
+			{
+				pb_addr = 0;
+				break;
+			}
+			m_pb_addrs.push_back(pb_addr);
+			pb_addr = HILO_TO_32(pb.next_pb);
+		}
+
+		const int num_pbs = (int)m_pb_addrs.size();
+		if (num_pbs >= MIN_PARALLEL_PBS)
+		{
+			std::mutex mix_lock;
+			Common::ThreadPool::ParallelFor(num_pbs, [&](int begin, int end)
+			{
+				AXWiiMixBuffers mix;
+				memset(&mix, 0, sizeof (mix));
+				for (int i = begin; i < end; ++i)
+					process_pb(m_pbs[i], mix.Get());
+
+				std::lock_guard<std::mutex> lk(mix_lock);
+				mix.AddTo(buffers);
+			});
+		}
+		else
+		{
+			for (int i = 0; i < num_pbs; ++i)
+				process_pb(m_pbs[i], buffers);
+		}
+
+		for (int i = 0; i < num_pbs; ++i)
+			WritePB(m_pb_addrs[i], m_pbs[i]);
+	}
+
+	// Also finishes overly long chains in parallel mode.
+	AXPBWii pb;
+	while (pb_addr)
+	{
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		process_pb(pb, buffers);
 
 		WritePB(pb_addr, pb);
 		pb_addr = HILO_TO_32(pb.next_pb);
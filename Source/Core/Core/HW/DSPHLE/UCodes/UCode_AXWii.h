@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "UCode_AX.h"
 
 class CUCode_AXWii : public CUCode_AX
@@ -39,6 +41,11 @@ protected:
 	u16 m_last_main_volume;
 	u16 m_last_aux_volumes[3];
 
+	// PB chain read ahead of processing when voices are processed in
+	// parallel, kept around to avoid reallocating every frame.
+	std::vector<u32> m_pb_addrs;
+	std::vector<AXPBWii> m_pbs;
+
 	// If needed, extract the updates related fields from a PB. We need to
 	// reinject them afterwards so that the correct PB typs is written to RAM.
 	bool ExtractUpdatesFields(AXPBWii& pb, u16* num_updates, u16* updates,
@@ -16,8 +16,18 @@
 #include "MathUtil.h"
 #include "UCode_AXStructs.h"
 #include "../../DSP.h"
+#include "DSP/DSPAccelerator.h"
 
-#include <functional>
+#include <algorithm>
+#include <vector>
+
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#define AX_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+#define AX_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 #ifdef AX_GC
 # define PB_TYPE AXPB
@@ -125,26 +135,30 @@ void DumpPB(const PB_TYPE& pb)
 }
 #endif
 
-// Simulated accelerator state.
-static u32 acc_loop_addr, acc_end_addr;
-static u32* acc_cur_addr;
-static PB_TYPE* acc_pb;
-static bool acc_end_reached;
+// Simulated accelerator state. Kept per voice rather than global so that
+// voices can be processed on several threads.
+struct AcceleratorState
+{
+	u32 loop_addr, end_addr;
+	u32* cur_addr;
+	PB_TYPE* pb;
+	bool end_reached;
+};
 
 // Sets up the simulated accelerator.
-void AcceleratorSetup(PB_TYPE* pb, u32* cur_addr)
+void AcceleratorSetup(AcceleratorState* acc, PB_TYPE* pb, u32* cur_addr)
 {
-	acc_pb = pb;
-	acc_loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
-	acc_end_addr = HILO_TO_32(pb->audio_addr.end_addr);
-	acc_cur_addr = cur_addr;
-	acc_end_reached = false;
+	acc->pb = pb;
+	acc->loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
+	acc->end_addr = HILO_TO_32(pb->audio_addr.end_addr);
+	acc->cur_addr = cur_addr;
+	acc->end_reached = false;
 }
 
 // Reads a sample from the simulated accelerator. Also handles looping and
 // disabling streams that reached the end (this is done by an exception raised
 // by the accelerator on real hardware).
-u16 AcceleratorGetSample()
+u16 AcceleratorGetSample(AcceleratorState* acc)
 {
 	u16 ret;
 
@@ -152,29 +166,29 @@ u16 AcceleratorGetSample()
 	//
 	// On real hardware, this would raise an interrupt that is handled by the
 	// UCode. We simulate what this interrupt does here.
-	if ((*acc_cur_addr & ~1) == (acc_end_addr & ~1))
+	if ((*acc->cur_addr & ~1) == (acc->end_addr & ~1))
 	{
 		// loop back to loop_addr.
-		*acc_cur_addr = acc_loop_addr;
+		*acc->cur_addr = acc->loop_addr;
 
-		if (acc_pb->audio_addr.looping)
+		if (acc->pb->audio_addr.looping)
 		{
 			// Set the ADPCM infos to continue processing at loop_addr.
 			//
 			// For some reason, yn1 and yn2 aren't set if the voice is not of
 			// stream type. This is what the AX UCode does and I don't really
 			// know why.
-			acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
-			if (!acc_pb->is_stream)
+			acc->pb->adpcm.pred_scale = acc->pb->adpcm_loop_info.pred_scale;
+			if (!acc->pb->is_stream)
 			{
-				acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
-				acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
+				acc->pb->adpcm.yn1 = acc->pb->adpcm_loop_info.yn1;
+				acc->pb->adpcm.yn2 = acc->pb->adpcm_loop_info.yn2;
 			}
 		}
 		else
 		{
 			// Non looping voice reached the end -> running = 0.
-			acc_pb->running = 0;
+			acc->pb->running = 0;
 
 #ifdef AX_WII
 			// One of the few meaningful differences between AXGC and AXWii:
@@ -182,71 +196,251 @@ u16 AcceleratorGetSample()
 			// samples at the loop address, AXWii has the 0000 samples
 			// internally in DRAM and use an internal pointer to it (loop addr
 			// does not contain 0000 samples on AXWii!).
-			acc_end_reached = true;
+			acc->end_reached = true;
 #endif
 		}
 	}
 
-	// See above for explanations about acc_end_reached.
-	if (acc_end_reached)
+	// See above for explanations about end_reached.
+	if (acc->end_reached)
 		return 0;
 
-	switch (acc_pb->audio_addr.sample_format)
+	switch (acc->pb->audio_addr.sample_format)
 	{
 		case 0x00:	// ADPCM
 		{
 			// ADPCM decoding, not much to explain here.
-			if ((*acc_cur_addr & 15) == 0)
+			if ((*acc->cur_addr & 15) == 0)
 			{
-				acc_pb->adpcm.pred_scale = DSP::ReadARAM((*acc_cur_addr & ~15) >> 1);
-				*acc_cur_addr += 2;
+				acc->pb->adpcm.pred_scale = DSP::ReadARAM((*acc->cur_addr & ~15) >> 1);
+				*acc->cur_addr += 2;
 			}
 
-			int scale = 1 << (acc_pb->adpcm.pred_scale & 0xF);
-			int coef_idx = (acc_pb->adpcm.pred_scale >> 4) & 0x7;
+			int scale = 1 << (acc->pb->adpcm.pred_scale & 0xF);
+			int coef_idx = (acc->pb->adpcm.pred_scale >> 4) & 0x7;
 
-			s32 coef1 = acc_pb->adpcm.coefs[coef_idx * 2 + 0];
-			s32 coef2 = acc_pb->adpcm.coefs[coef_idx * 2 + 1];
+			s32 coef1 = acc->pb->adpcm.coefs[coef_idx * 2 + 0];
+			s32 coef2 = acc->pb->adpcm.coefs[coef_idx * 2 + 1];
 
-			int temp = (*acc_cur_addr & 1) ?
-					(DSP::ReadARAM(*acc_cur_addr >> 1) & 0xF) :
-					(DSP::ReadARAM(*acc_cur_addr >> 1) >> 4);
+			int temp = (*acc->cur_addr & 1) ?
+					(DSP::ReadARAM(*acc->cur_addr >> 1) & 0xF) :
+					(DSP::ReadARAM(*acc->cur_addr >> 1) >> 4);
 
 			if (temp >= 8)
 				temp -= 16;
 
-			int val = (scale * temp) + ((0x400 + coef1 * acc_pb->adpcm.yn1 + coef2 * acc_pb->adpcm.yn2) >> 11);
+			int val = (scale * temp) + ((0x400 + coef1 * acc->pb->adpcm.yn1 + coef2 * acc->pb->adpcm.yn2) >> 11);
 			MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
 
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = val;
-			*acc_cur_addr += 1;
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = val;
+			*acc->cur_addr += 1;
 			ret = val;
 			break;
 		}
 
 		case 0x0A:	// 16-bit PCM audio
-			ret = (DSP::ReadARAM(*acc_cur_addr * 2) << 8) | DSP::ReadARAM(*acc_cur_addr * 2 + 1);
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
+			ret = (DSP::ReadARAM(*acc->cur_addr * 2) << 8) | DSP::ReadARAM(*acc->cur_addr * 2 + 1);
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = ret;
+			*acc->cur_addr += 1;
 			break;
 
 		case 0x19:	// 8-bit PCM audio
-			ret = DSP::ReadARAM(*acc_cur_addr) << 8;
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
+			ret = DSP::ReadARAM(*acc->cur_addr) << 8;
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = ret;
+			*acc->cur_addr += 1;
 			break;
 
 		default:
-			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc_pb->audio_addr.sample_format);
+			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc->pb->audio_addr.sample_format);
 			return 0;
 	}
 
 	return ret;
 }
 
+// Multiplies <count> samples by a volume ramping by <delta> each sample, and
+// updates the volume. The volume is 1.15 fixed point and the 32 bit product
+// is truncated to 16 bits after the shift, like the UCode does.
+void ApplyVolumeRamp(s16* out, const s16* in, u32 count, u16& volume, u16 delta)
+{
+	u32 i = 0;
+
+#if defined(AX_SIMD_SSE2)
+	const __m128i lane_steps = _mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0);
+	const __m128i vol_step = _mm_set1_epi16((s16)(delta * 8));
+	__m128i vol = _mm_add_epi16(_mm_set1_epi16((s16)volume),
+	                            _mm_mullo_epi16(_mm_set1_epi16((s16)delta), lane_steps));
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)&in[i]);
+
+		// pmulhw treats the volume as signed: add the sample back to the high
+		// half where the top bit of the volume is set.
+		const __m128i lo = _mm_mullo_epi16(s, vol);
+		__m128i hi = _mm_mulhi_epi16(s, vol);
+		hi = _mm_add_epi16(hi, _mm_and_si128(s, _mm_srai_epi16(vol, 15)));
+
+		// Bits 15-30 of the product.
+		_mm_storeu_si128((__m128i*)&out[i], _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15)));
+		vol = _mm_add_epi16(vol, vol_step);
+	}
+#elif defined(AX_SIMD_NEON)
+	static const u16 lane_steps[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	const uint16x8_t vol_step = vdupq_n_u16((u16)(delta * 8));
+	uint16x8_t vol = vmlaq_u16(vdupq_n_u16(volume), vld1q_u16(lane_steps), vdupq_n_u16(delta));
+	for (; i + 8 <= count; i += 8)
+	{
+		const int16x8_t s = vld1q_s16(&in[i]);
+		const int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(s)), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vol))));
+		const int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(s)), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(vol))));
+		vst1q_s16(&out[i], vcombine_s16(vshrn_n_s32(lo, 15), vshrn_n_s32(hi, 15)));
+		vol = vaddq_u16(vol, vol_step);
+	}
+#endif
+
+	volume += (u16)(i * delta);
+	for (; i < count; ++i)
+	{
+		out[i] = ((s32)in[i] * volume) >> 15;
+		volume += delta;
+	}
+}
+
+// Adds <count> samples to a 32 bit output buffer.
+void AccumulateSamples(int* out, const s16* in, u32 count)
+{
+	u32 i = 0;
+
+#if defined(AX_SIMD_SSE2)
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)&in[i]);
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+		__m128i* dst = (__m128i*)&out[i];
+		_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), lo));
+		_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), hi));
+	}
+#elif defined(AX_SIMD_NEON)
+	for (; i + 8 <= count; i += 8)
+	{
+		const int16x8_t s = vld1q_s16(&in[i]);
+		vst1q_s32(&out[i], vaddw_s16(vld1q_s32(&out[i]), vget_low_s16(s)));
+		vst1q_s32(&out[i + 4], vaddw_s16(vld1q_s32(&out[i + 4]), vget_high_s16(s)));
+	}
+#endif
+
+	for (; i < count; ++i)
+		out[i] += in[i];
+}
+
+// Reads <count> samples from the simulated accelerator. ADPCM is decoded a
+// frame at a time where no end address check falls within the samples read,
+// everything else goes through AcceleratorGetSample.
+void AcceleratorGetSamples(AcceleratorState* acc, s16* out, u32 count)
+{
+	while (count)
+	{
+		const u32 addr = *acc->cur_addr;
+		const u32 nibble = addr & 15;
+		if (acc->end_reached || acc->pb->audio_addr.sample_format != 0x00 || nibble == 1)
+		{
+			*out++ = AcceleratorGetSample(acc);
+			--count;
+			continue;
+		}
+
+		// The frame header is skipped without an end address check
+		const u32 first = nibble ? addr : addr + 2;
+		const u32 run = std::min<u32>(count, 16 - (first & 15));
+		const u32 end = acc->end_addr & ~1;
+		if (end >= (addr & ~1) && end <= ((first + run - 1) & ~1))
+		{
+			*out++ = AcceleratorGetSample(acc);
+			--count;
+			continue;
+		}
+
+		const u32 frame_addr = (addr & ~15) >> 1;
+		u8 frame[8];
+		for (u32 i = 0; i < 8; ++i)
+			frame[i] = DSP::ReadARAM(frame_addr + i);
+		if (!nibble)
+			acc->pb->adpcm.pred_scale = frame[0];
+
+		dsp_decode_adpcm(frame, first & 15, run, acc->pb->adpcm.pred_scale, acc->pb->adpcm.coefs,
+		                 &acc->pb->adpcm.yn1, &acc->pb->adpcm.yn2, out);
+		*acc->cur_addr = first + run;
+		out += run;
+		count -= run;
+	}
+}
+
+// Linear interpolation between s0 and s1, frac being the 0.16 fixed point
+// position between them:
+//   out = (s0 * (0x10000 - frac) + s1 * frac) >> 16
+// which is computed as (s0 << 16) + s1 * frac - s0 * frac. The intermediate
+// products can overflow but the sum can't, so wrapping arithmetic works.
+void InterpolateLinear(s16* out, const s16* s0, const s16* s1, const u16* frac, u32 count)
+{
+	u32 i = 0;
+
+#if defined(AX_SIMD_SSE2)
+	const __m128i sign_bit = _mm_set1_epi16((s16)0x8000);
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)&s0[i]);
+		const __m128i b = _mm_loadu_si128((const __m128i*)&s1[i]);
+		const __m128i f = _mm_loadu_si128((const __m128i*)&frac[i]);
+		const __m128i f_high = _mm_srai_epi16(f, 15);
+
+		// Signed * unsigned products, see ApplyVolumeRamp.
+		const __m128i a_lo = _mm_mullo_epi16(a, f);
+		const __m128i a_hi = _mm_add_epi16(_mm_mulhi_epi16(a, f), _mm_and_si128(a, f_high));
+		const __m128i b_lo = _mm_mullo_epi16(b, f);
+		const __m128i b_hi = _mm_add_epi16(_mm_mulhi_epi16(b, f), _mm_and_si128(b, f_high));
+
+		// Only the high half of the sum is needed, but the low half can
+		// borrow from it (unsigned b_lo < a_lo, mask is -1 then).
+		const __m128i borrow = _mm_cmplt_epi16(_mm_xor_si128(b_lo, sign_bit), _mm_xor_si128(a_lo, sign_bit));
+		const __m128i sum = _mm_add_epi16(_mm_add_epi16(a, _mm_sub_epi16(b_hi, a_hi)), borrow);
+		_mm_storeu_si128((__m128i*)&out[i], sum);
+	}
+#elif defined(AX_SIMD_NEON)
+	for (; i + 8 <= count; i += 8)
+	{
+		const int16x8_t a = vld1q_s16(&s0[i]);
+		const int16x8_t b = vld1q_s16(&s1[i]);
+		const uint16x8_t f = vld1q_u16(&frac[i]);
+
+		const int32x4_t a_lo = vmovl_s16(vget_low_s16(a));
+		const int32x4_t a_hi = vmovl_s16(vget_high_s16(a));
+		const int32x4_t f_lo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(f)));
+		const int32x4_t f_hi = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(f)));
+
+		int32x4_t lo = vshlq_n_s32(a_lo, 16);
+		lo = vmlaq_s32(lo, vmovl_s16(vget_low_s16(b)), f_lo);
+		lo = vmlsq_s32(lo, a_lo, f_lo);
+		int32x4_t hi = vshlq_n_s32(a_hi, 16);
+		hi = vmlaq_s32(hi, vmovl_s16(vget_high_s16(b)), f_hi);
+		hi = vmlsq_s32(hi, a_hi, f_hi);
+
+		vst1q_s16(&out[i], vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		if (frac[i])
+			out[i] = ((s32)s0[i] * (u16)-frac[i] + (s32)s1[i] * frac[i]) >> 16;
+		else
+			out[i] = s0[i];
+	}
+}
+
 // Reads samples from the input callback, resamples them to <count> samples at
 // the wanted sample rate (computed from the ratio, see below).
 //
@@ -267,12 +461,12 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count,
+// <input_callback>(s16* samples, u32 count) reads the next <count> samples.
+template <typename F>
+u32 ResampleAudio(F input_callback, s16* output, u32 count,
                   s16* last_samples, u32 curr_pos, u32 ratio, int srctype,
                   const s16* coeffs)
 {
-	int read_samples_count = 0;
-
 	// TODO(delroth): find out why the polyphase resampling algorithm causes
 	// audio glitches in Wii games with non integral ratios.
 
@@ -292,7 +486,7 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 			curr_pos += ratio;
 			while (curr_pos >= 0x10000)
 			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
+				input_callback(&temp[idx++ & 3], 1);
 				curr_pos -= 0x10000;
 			}
 
@@ -316,66 +510,49 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 	}
 	else if (srctype == SRCTYPE_LINEAR || srctype == SRCTYPE_POLYPHASE)
 	{
-		// This is the circular buffer containing samples to use for the
-		// interpolation. It is initialized with the values from the PB, and it
-		// will be stored back to the PB at the end.
-		s16 temp[4];
-		u32 idx = 0;
+		// The samples read from the input don't depend on the output, so read
+		// all of them first and interpolate the whole frame at once. The input
+		// buffer starts with the four values from the PB, which will be stored
+		// back from the end of it. Output samples interpolate between the
+		// oldest two of the four last samples read.
+		u64 pos = curr_pos;
+		const u32 read_count = (u32)((pos + (u64)count * ratio) >> 16);
+
+		s16 stack_input[4 + MAX_SAMPLES_PER_FRAME * 8];
+		std::vector<s16> heap_input;
+		s16* input = stack_input;
+		if (4 + read_count > ArraySize(stack_input))
+		{
+			heap_input.resize(4 + read_count);
+			input = heap_input.data();
+		}
 
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
+		memcpy(input, last_samples, 4 * sizeof (s16));
+		input_callback(input + 4, read_count);
 
+		s16 s0[MAX_SAMPLES_PER_FRAME];
+		s16 s1[MAX_SAMPLES_PER_FRAME];
+		u16 frac[MAX_SAMPLES_PER_FRAME];
 		for (u32 i = 0; i < count; ++i)
 		{
-			curr_pos += ratio;
-
-			// While our current position is >= 1.0, push new samples to the
-			// circular buffer.
-			while (curr_pos >= 0x10000)
-			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
-			}
-
-			// Get our current fractional position, used to know how much of
-			// curr0 and how much of curr1 the output sample should be.
-			u16 curr_frac = curr_pos & 0xFFFF;
-			u16 inv_curr_frac = -curr_frac;
-
-			// Interpolate! If curr_frac is 0, we can simply take the last
-			// sample without any multiplying.
-			s16 sample;
-			if (curr_frac)
-			{
-				s32 s0 = temp[idx++ & 3];
-				s32 s1 = temp[idx++ & 3];
-
-				sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
-				idx += 2;
-			}
-			else
-			{
-				sample = temp[idx++ & 3];
-				idx += 3;
-			}
-
-			output[i] = sample;
+			pos += ratio;
+			const u32 idx = (u32)(pos >> 16);
+			s0[i] = input[idx];
+			s1[i] = input[idx + 1];
+			frac[i] = pos & 0xFFFF;
 		}
+		curr_pos = pos & 0xFFFF;
+
+		InterpolateLinear(output, s0, s1, frac, count);
 
 		// Update the four last_samples values.
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
+		memcpy(last_samples, input + read_count, 4 * sizeof (s16));
 	}
 	else // SRCTYPE_NEAREST
 	{
 		// No sample rate conversion here: simply read samples from the
 		// accelerator to the output buffer.
-		for (u32 i = 0; i < count; ++i)
-			output[i] = input_callback(i);
+		input_callback(output, count);
 
 		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
 	}
@@ -388,11 +565,12 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 {
 	u32 cur_addr = HILO_TO_32(pb.audio_addr.cur_addr);
-	AcceleratorSetup(&pb, &cur_addr);
+	AcceleratorState acc;
+	AcceleratorSetup(&acc, &pb, &cur_addr);
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
+	u32 curr_pos = ResampleAudio([&acc](s16* out, u32 n) { AcceleratorGetSamples(&acc, out, n); },
 	                             samples, count, pb.src.last_samples,
 	                             pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio),
 	                             pb.src_type, coeffs);
@@ -415,17 +593,12 @@ void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ra
 	if (!ramp)
 		volume_delta = 0;
 
-	for (u32 i = 0; i < count; ++i)
-	{
-		s64 sample = input[i];
-		sample *= volume;
-		sample >>= 15;
-
-		out[i] += (s16)sample;
-		volume += volume_delta;
+	s16 samples[MAX_SAMPLES_PER_FRAME];
+	ApplyVolumeRamp(samples, input, count, volume, volume_delta);
+	AccumulateSamples(out, samples, count);
 
-		*dpop = (s16)sample;
-	}
+	if (count)
+		*dpop = samples[count - 1];
 }
 
 // Execute a low pass filter on the samples using one history value. Returns
@@ -450,11 +623,7 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 	GetInputSamples(pb, samples, count, coeffs);
 
 	// Apply a global volume ramp using the volume envelope parameters.
-	for (u32 i = 0; i < count; ++i)
-	{
-		samples[i] = ((s32)samples[i] * pb.vol_env.cur_volume) >> 15;
-		pb.vol_env.cur_volume += pb.vol_env.cur_volume_delta;
-	}
+	ApplyVolumeRamp(samples, samples, count, pb.vol_env.cur_volume, pb.vol_env.cur_volume_delta);
 
 	// Optionally, execute a low pass filter
 	// TODO: LPF code is currently broken, causing Super Monkey Ball sound
@@ -521,7 +690,8 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 
 		// We use ratio 0x55555 == (5 * 65536 + 21845) / 65536 == 5.3333 which
 		// is the nearest we can get to 96/18
-		u32 curr_pos = ResampleAudio([&samples](u32 i) { return samples[i]; },
+		const s16* wm_input = samples;
+		u32 curr_pos = ResampleAudio([&wm_input](s16* out, u32 n) { memcpy(out, wm_input, n * sizeof (s16)); wm_input += n; },
 		                             wm_samples, wm_count, pb.remote_src.last_samples,
 		                             pb.remote_src.cur_addr_frac, 0x55555,
 		                             SRCTYPE_POLYPHASE, coeffs);
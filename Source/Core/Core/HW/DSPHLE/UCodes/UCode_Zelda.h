@@ -147,6 +147,25 @@ public:
 		return res;
 	}
 
+	// Sample kernels, vectorized where possible. Public for the unit tests.
+
+	// AFC decoder
+	static void AFCdecodebuffer(const s16 *coef, const char *input, signed short *out, short *histp, short *hist2p, int type);
+
+	// Linear interpolation of <size> samples, starting at the 16.16 fixed
+	// point <position> relative to in - 3 and stepping by <ratio>. Returns
+	// the position reached.
+	static int ResampleLinear(const s16 *in, s32 *out, int size, int position, int ratio);
+
+	// Adds bits 29-60 of the 64 bit products of the samples and the ramp to
+	// out, stepping the ramp by <delta> after every even sample of the first
+	// 64 like 0ca9_RampedMultiplyAddBuffer. The ramp is a u32 or, with a
+	// delta of 0, an s32. Returns the ramp reached.
+	static u32 MixAddRamped(s32 *out, const s32 *in, int size, s64 ramp, s32 delta);
+
+	// Adds the mix buffers to the interleaved stereo output, clamping
+	static void MixToOutput(short *buffer, const s32 *left, const s32 *right, int size);
+
 private:
 	// These map CRC to behaviour.
 
@@ -266,9 +285,6 @@ private:
 
 	u8 *GetARAMPointer(u32 address);
 
-	// AFC decoder
-	static void AFCdecodebuffer(const s16 *coef, const char *input, signed short *out, short *histp, short *hist2p, int type);
-
 	void ReadVoicePB(u32 _Addr, ZeldaVoicePB& PB);
 	void WritebackVoicePB(u32 _Addr, ZeldaVoicePB& PB);
 
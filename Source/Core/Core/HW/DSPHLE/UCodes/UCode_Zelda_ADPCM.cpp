@@ -2,30 +2,30 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common.h"
-#include "MathUtil.h"
 #include "UCode_Zelda.h"
 
 void CUCode_Zelda::AFCdecodebuffer(const s16 *coef, const char *src, signed short *out, short *histp, short *hist2p, int type)
 {
 	// First 2 nibbles are ADPCM scale etc.
-	short delta = 1 << (((*src) >> 4) & 0xf);
-	short idx = (*src) & 0xf;
-	src++;
+	// The scale is a power of two, which as a short is negative for 1 << 15
+	const int delta = (short)(1 << (((*src) >> 4) & 0xf));
+	const int idx = (*src) & 0xf;
+	const int coef1 = coef[idx * 2];
+	const int coef2 = coef[idx * 2 + 1];
+	const u8 *data = (const u8*)src + 1;
 
-	short nibbles[16];
+	// The sign extended nibbles, scaled up front so that the filter loop
+	// below is nothing but its serial dependency
+	int residual[16];
 	if (type == 9)
 	{
-		for (int i = 0; i < 16; i += 2)
+		for (int i = 0; i < 8; i++)
 		{
-			nibbles[i + 0] = *src >> 4;
-			nibbles[i + 1] = *src & 15;
-			src++;
-		}
-		for (auto& nibble : nibbles) {
-			if (nibble >= 8)
-				nibble = nibble - 16;
-			nibble <<= 11;
+			residual[i * 2 + 0] = ((s32)(data[i] << 24) >> 28) * delta << 11;
+			residual[i * 2 + 1] = ((s32)(data[i] << 28) >> 28) * delta << 11;
 		}
 	}
 	else
@@ -33,33 +33,19 @@ void CUCode_Zelda::AFCdecodebuffer(const s16 *coef, const char *src, signed shor
 		// In Pikmin, Dolphin's engine sound is using AFC type 5, even though such a sound is hard
 		// to compare, it seems like to sound exactly like a real GC
 		// In Super Mario Sunshine, you can get such a sound by talking to/jumping on anyone
-		for (int i = 0; i < 16; i += 4)
-		{
-			nibbles[i + 0] = (*src >> 6) & 0x03;
-			nibbles[i + 1] = (*src >> 4) & 0x03;
-			nibbles[i + 2] = (*src >> 2) & 0x03;
-			nibbles[i + 3] = (*src >> 0) & 0x03;
-			src++;
-		}
-
-		for (auto& nibble : nibbles)
-		{
-			if (nibble >= 2)
-				nibble = nibble - 4;
-			nibble <<= 13;
-		}
+		for (int i = 0; i < 16; i++)
+			residual[i] = ((s32)(data[i >> 2] << (24 + (i & 3) * 2)) >> 30) * delta << 13;
 	}
 
-	short hist = *histp;
-	short hist2 = *hist2p;
+	int hist = *histp;
+	int hist2 = *hist2p;
 	for (int i = 0; i < 16; i++)
 	{
-		int sample = delta * nibbles[i] + ((int)hist * coef[idx * 2]) + ((int)hist2 * coef[idx * 2 + 1]);
-		sample >>= 11;
-		MathUtil::Clamp(&sample, -32768, 32767);
+		int sample = (residual[i] + hist * coef1 + hist2 * coef2) >> 11;
+		sample = std::max(std::min(sample, 32767), -32768);
 		out[i] = sample;
 		hist2 = hist;
-		hist = (short)sample;
+		hist = sample;
 	}
 	*histp = hist;
 	*hist2p = hist2;
@@ -87,15 +87,14 @@ _lRestart:
 void CUCode_Zelda::RenderSynth_SawWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size)
 {
 	s32 ratio = (s32)ceil((float)PB.RatioInt / 3);
-	s64 pos = PB.CurSampleFrac;
+	u32 pos = PB.CurSampleFrac;
 
+	// Computed from the start position, so that no sample depends on the
+	// previous one and the compiler can vectorize this
 	for (int i = 0; i < _Size; i++)
-	{
-		pos += ratio;
-		_Buffer[i] = pos & 0xFFFF;
-	}
+		_Buffer[i] = (pos + (i + 1) * ratio) & 0xFFFF;
 
-	PB.CurSampleFrac = pos & 0xFFFF;
+	PB.CurSampleFrac = (pos + _Size * ratio) & 0xFFFF;
 }
 
 void CUCode_Zelda::RenderSynth_Constant(ZeldaVoicePB &PB, s32* _Buffer, int _Size)
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <sstream>
 
 #include "UCodes.h"
@@ -13,6 +14,14 @@
 #include "../../Memmap.h"
 #include "../../DSP.h"
 
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#define ZELDA_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+#define ZELDA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 void CUCode_Zelda::ReadVoicePB(u32 _Addr, ZeldaVoicePB& PB)
 {
 	u16 *memory = (u16*)Memory::GetPointer(_Addr);
@@ -60,6 +69,177 @@ int CUCode_Zelda::SizeForResampling(ZeldaVoicePB &PB, int size, int ratio) {
 	return (PB.CurSampleFrac + size * ConvertRatio(PB.RatioInt)) >> 16;
 }
 
+int CUCode_Zelda::ResampleLinear(const s16 *in, s32 *out, int size, int position, int ratio)
+{
+	int i = 0;
+
+#if defined(ZELDA_SIMD_SSE2)
+	// Every output sample reads the pair of input samples in[int_pos - 3]
+	// and in[int_pos - 2] with one 32 bit load, pmaddwd then weighs both
+	// halves at once.
+	const __m128i frac_mask = _mm_set1_epi32(0xFFFF);
+	const __m128i inv_frac = _mm_set1_epi32(0x7FFF);
+	for (; i + 4 <= size; i += 4)
+	{
+		const int p0 = position;
+		const int p1 = p0 + ratio;
+		const int p2 = p1 + ratio;
+		const int p3 = p2 + ratio;
+		position = p3 + ratio;
+
+		const __m128i pairs = _mm_set_epi32(*(const s32*)&in[(p3 >> 16) - 3], *(const s32*)&in[(p2 >> 16) - 3],
+		                                    *(const s32*)&in[(p1 >> 16) - 3], *(const s32*)&in[(p0 >> 16) - 3]);
+		const __m128i frac = _mm_srli_epi32(_mm_and_si128(_mm_set_epi32(p3, p2, p1, p0), frac_mask), 1);
+		const __m128i weights = _mm_or_si128(_mm_slli_epi32(frac, 16), _mm_xor_si128(frac, inv_frac));
+		_mm_storeu_si128((__m128i*)&out[i], _mm_srai_epi32(_mm_madd_epi16(pairs, weights), 15));
+	}
+#elif defined(ZELDA_SIMD_NEON)
+	for (; i + 4 <= size; i += 4)
+	{
+		s16 s0[4], s1[4], frac[4];
+		for (int j = 0; j < 4; j++)
+		{
+			const int int_pos = position >> 16;
+			s0[j] = in[int_pos - 3];
+			s1[j] = in[int_pos - 2];
+			frac[j] = (position & 0xFFFF) >> 1;
+			position += ratio;
+		}
+
+		const int16x4_t f = vld1_s16(frac);
+		int32x4_t sum = vmull_s16(vld1_s16(s0), veor_s16(f, vdup_n_s16(0x7FFF)));
+		sum = vmlal_s16(sum, vld1_s16(s1), f);
+		vst1q_s32(&out[i], vshrq_n_s32(sum, 15));
+	}
+#endif
+
+	for (; i < size; i++)
+	{
+		int int_pos = (position >> 16);
+		int frac = ((position & 0xFFFF) >> 1);
+		out[i] = (in[int_pos - 3] * (frac ^ 0x7FFF) + in[int_pos - 2] * frac) >> 15;
+		position += ratio;
+	}
+
+	return position;
+}
+
+u32 CUCode_Zelda::MixAddRamped(s32 *out, const s32 *in, int size, s64 ramp, s32 delta)
+{
+	const bool negative = ramp < 0;
+	u32 r = (u32)ramp;
+	int i = 0;
+
+#if defined(ZELDA_SIMD_SSE2)
+	// pmuludq only multiplies unsigned: the 64 bit product of the signed
+	// sample and the ramp is the unsigned one minus (sample < 0 ? ramp : 0)
+	// and (ramp < 0 ? sample : 0) << 32, that is 8 times those after the
+	// shift by 29.
+	const __m128i low_mask = _mm_set_epi32(0, -1, 0, -1);
+	const __m128i negative_mask = _mm_set1_epi32(negative ? -1 : 0);
+	__m128i ramps = _mm_set_epi32(r + 2 * delta, r + delta, r + delta, r);
+	const __m128i ramp_step = _mm_set1_epi32(2 * delta);
+	for (; i + 4 <= size; i += 4)
+	{
+		if (i == 64)
+			ramps = _mm_set1_epi32(r + 32 * delta);
+
+		const __m128i v = _mm_loadu_si128((const __m128i*)&in[i]);
+		const __m128i even = _mm_srli_epi64(_mm_mul_epu32(v, ramps), 29);
+		const __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(v, 32), _mm_srli_epi64(ramps, 32)), 29);
+		__m128i product = _mm_or_si128(_mm_and_si128(even, low_mask), _mm_slli_epi64(odd, 32));
+
+		const __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(v, 31), ramps), _mm_and_si128(v, negative_mask));
+		product = _mm_sub_epi32(product, _mm_slli_epi32(correction, 3));
+
+		__m128i* dst = (__m128i*)&out[i];
+		_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), product));
+
+		if (i < 64)
+			ramps = _mm_add_epi32(ramps, ramp_step);
+	}
+#elif defined(ZELDA_SIMD_NEON)
+	// Same as SSE2, vmull_u32 is unsigned too
+	const uint32x4_t negative_mask = vdupq_n_u32(negative ? 0xFFFFFFFF : 0);
+	const u32 first_ramps[4] = { r, r + delta, r + delta, r + 2 * delta };
+	uint32x4_t ramps = vld1q_u32(first_ramps);
+	const uint32x4_t ramp_step = vdupq_n_u32(2 * delta);
+	for (; i + 4 <= size; i += 4)
+	{
+		if (i == 64)
+			ramps = vdupq_n_u32(r + 32 * delta);
+
+		const uint32x4_t v = vreinterpretq_u32_s32(vld1q_s32(&in[i]));
+		uint32x4_t product = vcombine_u32(vshrn_n_u64(vmull_u32(vget_low_u32(v), vget_low_u32(ramps)), 29),
+		                                  vshrn_n_u64(vmull_u32(vget_high_u32(v), vget_high_u32(ramps)), 29));
+
+		const uint32x4_t sign = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(v), 31));
+		const uint32x4_t correction = vaddq_u32(vandq_u32(sign, ramps), vandq_u32(v, negative_mask));
+		product = vsubq_u32(product, vshlq_n_u32(correction, 3));
+
+		vst1q_s32(&out[i], vaddq_s32(vld1q_s32(&out[i]), vreinterpretq_s32_u32(product)));
+
+		if (i < 64)
+			ramps = vaddq_u32(ramps, ramp_step);
+	}
+#endif
+
+	// Catch up with the samples done above
+	r += delta * ((std::min(i, 64) + 1) / 2);
+	const u64 high = negative ? 0xFFFFFFFF00000000ULL : 0;
+	for (; i < size; i++)
+	{
+		out[i] += (u64)in[i] * (high | r) >> 29;
+		if (((i & 1) == 0) && i < 64)
+			r += delta;
+	}
+
+	return r;
+}
+
+void CUCode_Zelda::MixToOutput(short *buffer, const s32 *left, const s32 *right, int size)
+{
+	int i = 0;
+
+#if defined(ZELDA_SIMD_SSE2)
+	for (; i + 4 <= size; i += 4)
+	{
+		__m128i* dst = (__m128i*)&buffer[i * 2];
+		const __m128i samples = _mm_loadu_si128(dst);
+		const __m128i l = _mm_loadu_si128((const __m128i*)&left[i]);
+		const __m128i r = _mm_loadu_si128((const __m128i*)&right[i]);
+
+		const __m128i lo = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16), _mm_unpacklo_epi32(l, r));
+		const __m128i hi = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16), _mm_unpackhi_epi32(l, r));
+		// packssdw clamps to the s16 range
+		_mm_storeu_si128(dst, _mm_packs_epi32(lo, hi));
+	}
+#elif defined(ZELDA_SIMD_NEON)
+	for (; i + 4 <= size; i += 4)
+	{
+		int16x4x2_t samples = vld2_s16(&buffer[i * 2]);
+		samples.val[0] = vqmovn_s32(vaddw_s16(vld1q_s32(&left[i]), samples.val[0]));
+		samples.val[1] = vqmovn_s32(vaddw_s16(vld1q_s32(&right[i]), samples.val[1]));
+		vst2_s16(&buffer[i * 2], samples);
+	}
+#endif
+
+	buffer += i * 2;
+	for (; i < size; i++)
+	{
+		s32 l = (s32)buffer[0] + left[i];
+		s32 r = (s32)buffer[1] + right[i];
+
+		MathUtil::Clamp(&l, -32768, 32767);
+		buffer[0] = (short)l;
+
+		MathUtil::Clamp(&r, -32768, 32767);
+		buffer[1] = (short)r;
+
+		buffer += 2;
+	}
+}
+
 // Simple resampler, linear interpolation.
 // Any future state should be stored in PB.raw[0x3c to 0x3f].
 // In must point 4 samples into a buffer.
@@ -79,14 +259,7 @@ void CUCode_Zelda::Resample(ZeldaVoicePB &PB, int size, s16 *in, s32 *out, bool
 	int ratio = ConvertRatio(PB.RatioInt);
 	int in_size = SizeForResampling(PB, size, ratio);
 
-	int position = PB.CurSampleFrac;
-	for (int i = 0; i < size; i++)
-	{
-		int int_pos = (position >> 16);
-		int frac = ((position & 0xFFFF) >> 1);
-		out[i] = (in[int_pos - 3] * (frac ^ 0x7FFF) + in[int_pos - 2] * frac) >> 15;
-		position += ratio;
-	}
+	int position = ResampleLinear(in, out, size, PB.CurSampleFrac, ratio);
 
 	for (int i = 0; i < 4; i++)
 	{
@@ -336,11 +509,17 @@ restart:
 	u32 SamplePosition = PB.Length - PB.RemLength;
 	while (sampleCount < _RealSize)
 	{
-		_Buffer[sampleCount] = outbuf[SamplePosition & 15];
-		sampleCount++;
-
-		SamplePosition++;
-		PB.RemLength--;
+		// Copy up to the end of the block, the buffer or the sound at once.
+		// A RemLength of 0 wraps around like the DSP's counter does.
+		const u32 offset = SamplePosition & 15;
+		u32 count = std::min<u32>(16 - offset, _RealSize - sampleCount);
+		if (PB.RemLength)
+			count = std::min(count, PB.RemLength);
+		memcpy(&_Buffer[sampleCount], &outbuf[offset], count * sizeof(short));
+		sampleCount += count;
+
+		SamplePosition += count;
+		PB.RemLength -= count;
 		if (PB.RemLength == 0)
 		{
 			PB.ReachedEnd = 1;
@@ -644,24 +823,11 @@ ContinueWithBlock:
 			b00[i + 0x10] = (s16)b00[i + 0xc] * PB.raw[0x29];
 		}
 
-		for (int count = 0; count < 8; count++)
-		{
-			// The 8 buffers to mix to: 0d00, 0d60, 0f40 0ca0 0e80 0ee0 0c00 0c50
-			// We just mix to the first two and call it stereo :p
-			int value = b00[0x4 + count];
-			//int delta = b00[0xC + count] << 11; // Unused?
-
-			int ramp = value << 16;
-			for (int i = 0; i < _Size; i++)
-			{
-				int unmixed_audio = m_VoiceBuffer[i];
-				switch (count) {
-				case 0: _LeftBuffer[i] += (u64)unmixed_audio * ramp >> 29; break;
-				case 1: _RightBuffer[i] += (u64)unmixed_audio * ramp >> 29; break;
-					break;
-				}
-			}
-		}
+		// The 8 buffers to mix to: 0d00, 0d60, 0f40 0ca0 0e80 0ee0 0c00 0c50
+		// We just mix to the first two and call it stereo :p
+		//int delta = b00[0xC + count] << 11; // Unused?
+		MixAddRamped(_LeftBuffer, m_VoiceBuffer, _Size, (s32)(b00[0x4] << 16), 0);
+		MixAddRamped(_RightBuffer, m_VoiceBuffer, _Size, (s32)(b00[0x5] << 16), 0);
 	}
 	else
 	{
@@ -707,22 +873,13 @@ ContinueWithBlock:
 			if (mix)
 			{
 				// 0ca9_RampedMultiplyAddBuffer
-				for (int i = 0; i < _Size; i++)
+				// TODO - add to buffer specified by dest_buffer_address
+				switch (count)
 				{
-					int value = m_VoiceBuffer[i];
-
-					// TODO - add to buffer specified by dest_buffer_address
-					switch (count)
-					{
-						// These really should be 32.
-						case 0: _LeftBuffer[i] += (u64)value * ramp >> 29; break;
-						case 1: _RightBuffer[i] += (u64)value * ramp >> 29; break;
-					}
-
-					if (((i & 1) == 0) && i < 64)
-					{
-						ramp += delta;
-					}
+					// These really should be 32.
+					case 0: ramp = MixAddRamped(_LeftBuffer, m_VoiceBuffer, _Size, ramp, delta); break;
+					case 1: ramp = MixAddRamped(_RightBuffer, m_VoiceBuffer, _Size, ramp, delta); break;
+					default: ramp += delta * ((std::min(_Size, 64) + 1) / 2); break;
 				}
 				if (_Size < 32)
 				{
@@ -776,17 +933,5 @@ void CUCode_Zelda::MixAdd(short *_Buffer, int _Size)
 	}
 
 	// Post processing, final conversion.
-	for (int i = 0; i < _Size; i++)
-	{
-		s32 left  = (s32)_Buffer[0] + m_LeftBuffer[i];
-		s32 right = (s32)_Buffer[1] + m_RightBuffer[i];
-
-		MathUtil::Clamp(&left, -32768, 32767);
-		_Buffer[0] = (short)left;
-
-		MathUtil::Clamp(&right, -32768, 32767);
-		_Buffer[1] = (short)right;
-
-		_Buffer += 2;
-	}
+	MixToOutput(_Buffer, m_LeftBuffer, m_RightBuffer, _Size);
 }
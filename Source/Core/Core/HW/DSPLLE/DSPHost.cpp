@@ -5,6 +5,7 @@
 #include "Common.h"
 #include "Hash.h"
 #include "DSP/DSPAnalyzer.h"
+#include "DSP/DSPCachedInterpreter.h"
 #include "DSP/DSPCore.h"
 #include "DSP/DSPHost.h"
 #include "DSPSymbols.h"
@@ -96,6 +97,8 @@ void DSPHost_CodeLoaded(const u8 *ptr, int size)
 
 	if (dspjit)
 		dspjit->ClearIRAM();
+	else if (dsp_cached_interpreter)
+		DSPCachedInterpreter::ClearIRAM();
 
 	DSPAnalyzer::Analyze();
 }
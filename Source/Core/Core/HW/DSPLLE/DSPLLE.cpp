@@ -9,6 +9,7 @@
 #include "CommonTypes.h"
 #include "LogManager.h"
 #include "Thread.h"
+#include "ThreadPlacement.h"
 #include "ChunkFile.h"
 #include "IniFile.h"
 #include "ConfigManager.h"
@@ -17,7 +18,9 @@
 
 #include "DSPLLEGlobals.h" // Local
 #include "DSP/DSPHost.h"
+#include "DSP/DSPCachedInterpreter.h"
 #include "DSP/DSPInterpreter.h"
+#include "DSP/DSPAccelerator.h"
 #include "DSP/DSPHWInterface.h"
 #include "DSP/disassemble.h"
 #include "DSPSymbols.h"
@@ -37,9 +40,16 @@ DSPLLE::DSPLLE() {
 	soundStream = NULL;
 	m_InitMixer = false;
 	m_bIsRunning = false;
+	m_bBatched = false;
 	m_cycle_count = 0;
+	m_thread_sleeping = 0;
 }
 
+// Cycles the CPU can get ahead of the batched DSP thread, about 16 updates
+static const u32 BATCH_CYCLE_BUDGET = 16 * 2100;
+// Times the idle batched DSP thread yields before it sleeps on dspEvent
+static const int BATCH_SPIN_COUNT = 2000;
+
 Common::Event dspEvent;
 Common::Event ppcEvent;
 
@@ -76,7 +86,10 @@ void DSPLLE::DoState(PointerWrap &p)
 	p.DoArray(g_dsp.iram, DSP_IRAM_SIZE);
 	WriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
 	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
 		DSPHost_CodeLoaded((const u8*)g_dsp.iram, DSP_IRAM_BYTE_SIZE);
+		dsp_invalidate_accelerator();
+	}
 	p.DoArray(g_dsp.dram, DSP_DRAM_SIZE);
 	p.Do(cyclesLeft);
 	p.Do(init_hax);
@@ -105,6 +118,7 @@ void DSPLLE::DoState(PointerWrap &p)
 void DSPLLE::dsp_thread(DSPLLE *dsp_lle)
 {
 	Common::SetCurrentThreadName("DSP thread");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	while (dsp_lle->m_bIsRunning)
 	{
@@ -116,6 +130,10 @@ void DSPLLE::dsp_thread(DSPLLE *dsp_lle)
 			{
 				DSPCore_RunCycles(cycles);
 			}
+			else if (dsp_cached_interpreter)
+			{
+				DSPCachedInterpreter::RunCycles(cycles);
+			}
 			else
 			{
 				DSPInterpreter::RunCyclesThread(cycles);
@@ -130,11 +148,64 @@ void DSPLLE::dsp_thread(DSPLLE *dsp_lle)
 	}
 }
 
+// Batched thread: runs whatever cycles have piled up, spins for a while when
+// there are none and only then goes to sleep
+void DSPLLE::dsp_thread_batched(DSPLLE *dsp_lle)
+{
+	Common::SetCurrentThreadName("DSP thread");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
+
+	while (dsp_lle->m_bIsRunning)
+	{
+		if ((int)Common::AtomicLoad(dsp_lle->m_cycle_count) > 0)
+		{
+			// Read again under the lock, a savestate may have replaced the count
+			std::lock_guard<std::mutex> lk(dsp_lle->m_csDSPThreadActive);
+			const int cycles = (int)Common::AtomicLoad(dsp_lle->m_cycle_count);
+			if (cycles > 0)
+			{
+				if (dspjit)
+					DSPCore_RunCycles(cycles);
+				else if (dsp_cached_interpreter)
+					DSPCachedInterpreter::RunCycles(cycles);
+				else
+					DSPInterpreter::RunCyclesThread(cycles);
+				Common::AtomicAdd(dsp_lle->m_cycle_count, (u32)-cycles);
+			}
+			continue;
+		}
+
+		int spins = 0;
+		while (spins < BATCH_SPIN_COUNT && (int)Common::AtomicLoad(dsp_lle->m_cycle_count) <= 0 && dsp_lle->m_bIsRunning)
+		{
+			Common::YieldCPU();
+			++spins;
+		}
+
+		if (spins == BATCH_SPIN_COUNT)
+		{
+			// The increment is a full barrier: either DSP_Update sees the flag
+			// and sets the event, or the count it added is seen here
+			Common::AtomicIncrement(dsp_lle->m_thread_sleeping);
+			if ((int)Common::AtomicLoad(dsp_lle->m_cycle_count) <= 0 && dsp_lle->m_bIsRunning)
+				dspEvent.Wait();
+			Common::AtomicDecrement(dsp_lle->m_thread_sleeping);
+		}
+	}
+}
+
+void DSPLLE::WaitForDSPThread(u32 max_pending)
+{
+	while ((int)Common::AtomicLoad(m_cycle_count) > (int)max_pending && m_bIsRunning)
+		Common::YieldCPU();
+}
+
 bool DSPLLE::Initialize(void *hWnd, bool bWii, bool bDSPThread)
 {
 	m_hWnd = hWnd;
 	m_bWii = bWii;
 	m_bDSPThread = bDSPThread;
+	m_bBatched = bDSPThread && SConfig::GetInstance().m_LocalCoreStartupParameter.bDSPThreadBatched;
 	m_InitMixer = false;
 
 	std::string irom_file = File::GetUserPath(D_GCUSER_IDX) + DSP_IROM;
@@ -155,7 +226,7 @@ bool DSPLLE::Initialize(void *hWnd, bool bWii, bool bDSPThread)
 	InitInstructionTable();
 
 	if (m_bDSPThread)
-		m_hDSPThread = std::thread(dsp_thread, this);
+		m_hDSPThread = std::thread(m_bBatched ? dsp_thread_batched : dsp_thread, this);
 
 	Host_RefreshDSPDebuggerWindow();
 
@@ -193,6 +264,7 @@ void DSPLLE::InitMixer()
 
 u16 DSPLLE::DSP_WriteControlRegister(u16 _uFlag)
 {
+	DSP_Sync();
 	UDSPControl Temp(_uFlag);
 	if (!m_InitMixer)
 	{
@@ -229,6 +301,9 @@ u16 DSPLLE::DSP_ReadControlRegister()
 
 u16 DSPLLE::DSP_ReadMailBoxHigh(bool _CPUMailbox)
 {
+	// Polling loops read the high half first, let the DSP catch up so
+	// they see its mail as early as in lock-step
+	DSP_Sync();
 	if (_CPUMailbox)
 		return gdsp_mbox_read_h(GDSP_MBOX_CPU);
 	else
@@ -245,6 +320,7 @@ u16 DSPLLE::DSP_ReadMailBoxLow(bool _CPUMailbox)
 
 void DSPLLE::DSP_WriteMailBoxHigh(bool _CPUMailbox, u16 _uHighMail)
 {
+	DSP_Sync();
 	if (_CPUMailbox)
 	{
 		if (gdsp_mbox_peek(GDSP_MBOX_CPU) & 0x80000000)
@@ -309,6 +385,14 @@ void DSPLLE::DSP_Update(int cycles)
 		// ~1/6th as many cycles as the period PPC-side.
 		DSPCore_RunCycles(dsp_cycles);
 	}
+	else if (m_bBatched)
+	{
+		// The add is a full barrier, see dsp_thread_batched
+		Common::AtomicAdd(m_cycle_count, dsp_cycles);
+		if (Common::AtomicLoad(m_thread_sleeping))
+			dspEvent.Set();
+		WaitForDSPThread(BATCH_CYCLE_BUDGET);
+	}
 	else
 	{
 		// Wait for dsp thread to complete its cycle. Note: this logic should be thought through.
@@ -319,6 +403,12 @@ void DSPLLE::DSP_Update(int cycles)
 	}
 }
 
+void DSPLLE::DSP_Sync()
+{
+	if (m_bBatched)
+		WaitForDSPThread(0);
+}
+
 u32 DSPLLE::DSP_UpdateRate()
 {
 	return 12600; // TO BE TWEAKED
@@ -29,12 +29,16 @@ public:
 	virtual unsigned short DSP_WriteControlRegister(unsigned short);
 	virtual void DSP_SendAIBuffer(unsigned int address, unsigned int num_samples);
 	virtual void DSP_Update(int cycles);
+	virtual void DSP_Sync();
 	virtual void DSP_StopSoundStream();
 	virtual void DSP_ClearAudioBuffer(bool mute);
 	virtual u32 DSP_UpdateRate();
 
 private:
 	static void dsp_thread(DSPLLE* lpParameter);
+	static void dsp_thread_batched(DSPLLE* lpParameter);
+	// Spins until the DSP thread has at most max_pending cycles left to run
+	void WaitForDSPThread(u32 max_pending);
 	void InitMixer();
 
 	std::thread m_hDSPThread;
@@ -42,6 +46,11 @@ private:
 	bool m_InitMixer;
 	bool m_bWii;
 	bool m_bDSPThread;
+	// The DSP thread lags behind by up to a cycle budget instead of running
+	// in lock-step, and only catches up on mailbox and ARAM DMA accesses
+	bool m_bBatched;
 	bool m_bIsRunning;
+	// In batched mode, the cycles handed to the DSP thread that it hasn't run yet
 	volatile u32 m_cycle_count;
+	volatile u32 m_thread_sleeping;
 };
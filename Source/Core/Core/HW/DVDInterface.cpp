@@ -19,6 +19,8 @@
 #include "../Movie.h"
 #include "MMIO.h"
 
+#include <vector>
+
 // Disc transfer rate measured in bytes per second
 static const u32 DISC_TRANSFER_RATE_GC = 5 * 1024 * 1024;
 
@@ -211,6 +213,36 @@ static std::mutex dvdread_section;
 static int ejectDisc;
 static int insertDisc;
 
+// Sector reads started by a DMA are done on a separate thread while the emulated
+// transfer time passes. ExecuteCommand copies the data to RAM when TransferComplete
+// fires, so the emulated timing doesn't change. Not savestated: after a load the
+// read is simply done again on the CPU thread.
+static std::thread s_prefetch_thread;
+static std::mutex s_prefetch_lock;
+static std::condition_variable s_prefetch_cond;
+static bool s_prefetch_quit;
+static bool s_prefetch_pending;
+static bool s_prefetch_done;
+static bool s_prefetch_result;
+static u32 s_prefetch_offset;
+static u32 s_prefetch_length;
+static std::vector<u8> s_prefetch_buffer;
+
+// DTK streaming reads 32 bytes at a time from the audio thread. It's served from
+// s_stream_buffer, which only the audio thread touches, while the prefetch thread
+// reads the chunk after it into s_stream_next_buffer.
+static const u32 STREAM_CHUNK_SIZE = 0x8000;
+static std::vector<u8> s_stream_buffer;
+static u32 s_stream_offset;
+static u32 s_stream_length;
+// Guarded by s_prefetch_lock
+static bool s_stream_flush;
+static bool s_stream_pending;
+static bool s_stream_done;
+static bool s_stream_result;
+static u32 s_stream_next_offset;
+static std::vector<u8> s_stream_next_buffer;
+
 void EjectDiscCallback(u64 userdata, int cyclesLate);
 void InsertDiscCallback(u64 userdata, int cyclesLate);
 
@@ -218,6 +250,171 @@ void UpdateInterrupts();
 void GenerateDIInterrupt(DI_InterruptType _DVDInterrupt);
 void ExecuteCommand(UDICR& _DICR);
 
+static void PrefetchThread()
+{
+	Common::SetCurrentThreadName("DVD prefetch thread");
+
+	std::unique_lock<std::mutex> lk(s_prefetch_lock);
+	while (true)
+	{
+		while (!s_prefetch_quit && (!s_prefetch_pending || s_prefetch_done) && (!s_stream_pending || s_stream_done))
+			s_prefetch_cond.wait(lk);
+		if (s_prefetch_quit)
+			return;
+
+		// DMA reads hold up the CPU, streaming has a whole chunk of slack
+		if (!s_prefetch_pending || s_prefetch_done)
+		{
+			const u32 stream_offset = s_stream_next_offset;
+			lk.unlock();
+
+			s_stream_next_buffer.resize(STREAM_CHUNK_SIZE);
+			bool result;
+			{
+				std::lock_guard<std::mutex> read_lk(dvdread_section);
+				result = VolumeHandler::ReadToPtr(s_stream_next_buffer.data(), stream_offset, STREAM_CHUNK_SIZE);
+			}
+
+			lk.lock();
+			s_stream_result = result;
+			s_stream_done = true;
+			s_prefetch_cond.notify_all();
+			continue;
+		}
+
+		const u32 offset = s_prefetch_offset;
+		const u32 length = s_prefetch_length;
+		lk.unlock();
+
+		// Only this thread touches the buffer until s_prefetch_done is set.
+		s_prefetch_buffer.resize(length);
+		bool result;
+		{
+			std::lock_guard<std::mutex> read_lk(dvdread_section);
+			result = VolumeHandler::ReadToPtr(s_prefetch_buffer.data(), offset, length);
+		}
+
+		lk.lock();
+		s_prefetch_result = result;
+		s_prefetch_done = true;
+		s_prefetch_cond.notify_all();
+	}
+}
+
+// Must be called with s_prefetch_lock held.
+static void WaitForPrefetch(std::unique_lock<std::mutex>& lk)
+{
+	while (s_prefetch_pending && !s_prefetch_done)
+		s_prefetch_cond.wait(lk);
+}
+
+static void StartPrefetch(u32 offset, u32 length)
+{
+	std::unique_lock<std::mutex> lk(s_prefetch_lock);
+	WaitForPrefetch(lk);
+	s_prefetch_offset = offset;
+	s_prefetch_length = length;
+	s_prefetch_pending = true;
+	s_prefetch_done = false;
+	s_prefetch_cond.notify_all();
+}
+
+static void CancelPrefetch()
+{
+	std::unique_lock<std::mutex> lk(s_prefetch_lock);
+	WaitForPrefetch(lk);
+	s_prefetch_pending = false;
+	// The disc is going away, drop whatever was read ahead for streaming
+	s_stream_flush = true;
+}
+
+// Must be called with s_prefetch_lock held.
+static void WaitForStreamPrefetch(std::unique_lock<std::mutex>& lk)
+{
+	while (s_stream_pending && !s_stream_done)
+		s_prefetch_cond.wait(lk);
+}
+
+// WARNING - called from audio thread
+static bool ReadStreamData(u8* _pDestBuffer, u32 _iDVDOffset, u32 _iLength)
+{
+	std::unique_lock<std::mutex> lk(s_prefetch_lock);
+	if (s_stream_flush)
+	{
+		WaitForStreamPrefetch(lk);
+		s_stream_pending = false;
+		s_stream_length = 0;
+		s_stream_flush = false;
+	}
+
+	if (_iDVDOffset < s_stream_offset || _iDVDOffset + _iLength > s_stream_offset + s_stream_length)
+	{
+		// Only wait for the read ahead if it's the chunk we're after, a seek makes it useless
+		const bool next = s_stream_pending && _iDVDOffset >= s_stream_next_offset &&
+			_iDVDOffset + _iLength <= s_stream_next_offset + STREAM_CHUNK_SIZE;
+		if (next)
+			WaitForStreamPrefetch(lk);
+
+		if (next && s_stream_result)
+		{
+			s_stream_buffer.swap(s_stream_next_buffer);
+			s_stream_offset = s_stream_next_offset;
+			s_stream_length = STREAM_CHUNK_SIZE;
+			s_stream_pending = false;
+		}
+		else
+		{
+			WaitForStreamPrefetch(lk);
+			s_stream_pending = false;
+			s_stream_length = 0;
+			lk.unlock();
+
+			s_stream_buffer.resize(STREAM_CHUNK_SIZE);
+			{
+				std::lock_guard<std::mutex> read_lk(dvdread_section);
+				if (!VolumeHandler::ReadToPtr(s_stream_buffer.data(), _iDVDOffset, STREAM_CHUNK_SIZE))
+				{
+					// Too close to the end of the disc for a whole chunk
+					return VolumeHandler::ReadToPtr(_pDestBuffer, _iDVDOffset, _iLength);
+				}
+			}
+			s_stream_offset = _iDVDOffset;
+			s_stream_length = STREAM_CHUNK_SIZE;
+			lk.lock();
+		}
+
+		s_stream_next_offset = s_stream_offset + s_stream_length;
+		s_stream_pending = true;
+		s_stream_done = false;
+		s_prefetch_cond.notify_all();
+	}
+
+	memcpy(_pDestBuffer, s_stream_buffer.data() + (_iDVDOffset - s_stream_offset), _iLength);
+	return true;
+}
+
+// Uses the data read by StartPrefetch if it matches, falls back to DVDRead otherwise.
+static bool DVDReadPrefetched(u32 _iDVDOffset, u32 _iRamAddress, u32 _iLength)
+{
+	{
+		std::unique_lock<std::mutex> lk(s_prefetch_lock);
+		WaitForPrefetch(lk);
+		if (s_prefetch_pending)
+		{
+			s_prefetch_pending = false;
+
+			u8* ptr = Memory::GetPointer(_iRamAddress);
+			if (s_prefetch_offset == _iDVDOffset && s_prefetch_length == _iLength && s_prefetch_result && ptr)
+			{
+				memcpy(ptr, s_prefetch_buffer.data(), _iLength);
+				return true;
+			}
+		}
+	}
+
+	return DVDRead(_iDVDOffset, _iRamAddress, _iLength);
+}
+
 void DoState(PointerWrap &p)
 {
 	p.DoPOD(m_DISR);
@@ -239,6 +436,9 @@ void DoState(PointerWrap &p)
 
 	p.Do(CurrentStart);
 	p.Do(CurrentLength);
+
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		CancelPrefetch();
 }
 
 void TransferComplete(u64 userdata, int cyclesLate)
@@ -273,10 +473,32 @@ void Init()
 	insertDisc = CoreTiming::RegisterEvent("InsertDisc", InsertDiscCallback);
 
 	tc = CoreTiming::RegisterEvent("TransferComplete", TransferComplete);
+
+	s_prefetch_quit = false;
+	s_prefetch_pending = false;
+	s_stream_pending = false;
+	s_stream_flush = true;
+	s_prefetch_thread = std::thread(PrefetchThread);
 }
 
 void Shutdown()
 {
+	{
+		std::lock_guard<std::mutex> lk(s_prefetch_lock);
+		s_prefetch_quit = true;
+		s_prefetch_cond.notify_all();
+	}
+	if (s_prefetch_thread.joinable())
+		s_prefetch_thread.join();
+	s_prefetch_pending = false;
+	std::vector<u8>().swap(s_prefetch_buffer);
+	// s_stream_buffer belongs to the audio thread, which may still be running
+	{
+		std::lock_guard<std::mutex> lk(s_prefetch_lock);
+		s_stream_pending = false;
+		s_stream_flush = true;
+		std::vector<u8>().swap(s_stream_next_buffer);
+	}
 }
 
 void SetDiscInside(bool _DiscInside)
@@ -296,6 +518,7 @@ bool IsDiscInside()
 void EjectDiscCallback(u64 userdata, int cyclesLate)
 {
 	// Empty the drive
+	CancelPrefetch();
 	SetDiscInside(false);
 	SetLidOpen();
 	VolumeHandler::EjectVolume();
@@ -306,6 +529,7 @@ void InsertDiscCallback(u64 userdata, int cyclesLate)
 	std::string& SavedFileName = SConfig::GetInstance().m_LocalCoreStartupParameter.m_strFilename;
 	std::string *_FileName = (std::string *)userdata;
 
+	CancelPrefetch();
 	if (!VolumeHandler::SetVolumeName(*_FileName))
 	{
 		// Put back the old one
@@ -369,8 +593,7 @@ bool DVDReadADPCM(u8* _pDestBuffer, u32 _iNumSamples)
 	}
 	else
 	{
-		std::lock_guard<std::mutex> lk(dvdread_section);
-		VolumeHandler::ReadToPtr(_pDestBuffer, AudioPos, _iNumSamples);
+		ReadStreamData(_pDestBuffer, AudioPos, _iNumSamples);
 	}
 
 	// loop check
@@ -480,6 +703,10 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 						(SystemTimers::GetTicksPerSecond() / (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii ? 1 : DISC_TRANSFER_RATE_GC)) +
 						(SystemTimers::GetTicksPerSecond() * DISC_ACCESS_TIME_MS / 1000);
 					CoreTiming::ScheduleEvent((int)ticksUntilTC, tc);
+
+					// Read the disc on the prefetch thread in the meantime.
+					if (g_bDiscInside && m_DICMDBUF[0].CMDBYTE0 == 0xA8 && m_DICMDBUF[0].CMDBYTE3 == 0x00)
+						StartPrefetch(m_DICMDBUF[1].Hex << 2, m_DILENGTH.Length);
 				}
 				else
 				{
@@ -651,7 +878,7 @@ void ExecuteCommand(UDICR& _DICR)
 					}
 
 					// Here is the actual Disk Reading
-					if (!DVDRead(iDVDOffset, m_DIMAR.Address, m_DILENGTH.Length))
+					if (!DVDReadPrefetched(iDVDOffset, m_DIMAR.Address, m_DILENGTH.Length))
 					{
 						PanicAlertT("Can't read from DVD_Plugin - DVD-Interface: Fatal Error");
 					}
@@ -474,7 +474,7 @@ void CEXIETHERNET::SendComplete()
 	mBbaMem[BBA_LTPS] = 0;
 }
 
-inline u8 CEXIETHERNET::HashIndex(u8 *dest_eth_addr)
+inline u8 CEXIETHERNET::HashIndex(const u8 *dest_eth_addr)
 {
 	// Calculate CRC
 	u32 crc = 0xffffffff;
@@ -496,7 +496,7 @@ inline u8 CEXIETHERNET::HashIndex(u8 *dest_eth_addr)
 	return crc >> 26;
 }
 
-inline bool CEXIETHERNET::RecvMACFilter()
+inline bool CEXIETHERNET::RecvMACFilter(const u8 *dest_eth_addr)
 {
 	static u8 const broadcast[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 
@@ -505,11 +505,11 @@ inline bool CEXIETHERNET::RecvMACFilter()
 		return true;
 
 	// Unicast?
-	if ((mRecvBuffer[0] & 0x01) == 0)
+	if ((dest_eth_addr[0] & 0x01) == 0)
 	{
-		return memcmp(mRecvBuffer, &mBbaMem[BBA_NAFR_PAR0], 6) == 0;
+		return memcmp(dest_eth_addr, &mBbaMem[BBA_NAFR_PAR0], 6) == 0;
 	}
-	else if (memcmp(mRecvBuffer, broadcast, 6) == 0)
+	else if (memcmp(dest_eth_addr, broadcast, 6) == 0)
 	{
 		// Accept broadcast?
 		return !!(mBbaMem[BBA_NCRB] & NCRB_AB);
@@ -522,7 +522,7 @@ inline bool CEXIETHERNET::RecvMACFilter()
 	else
 	{
 		// Lookup the dest eth address in the hashmap
-		u16 index = HashIndex(mRecvBuffer);
+		u16 index = HashIndex(dest_eth_addr);
 		return !!(mBbaMem[BBA_NAFR_MAR0 + index / 8] & (1 << (index % 8)));
 	}
 }
@@ -537,18 +537,61 @@ inline void CEXIETHERNET::inc_rwp()
 		(*rwp)++;
 }
 
+// The free part of the receive ring, from behind the descriptor at RWP up
+// to RRP. The second segment is the part after wrapping around to BP.
+u32 CEXIETHERNET::RecvRingSpace(u8 *seg[2], u32 seg_size[2])
+{
+	u8 *const base_ptr  = ptr_from_page_ptr(BBA_BP);
+	u8 *const end_ptr   = ptr_from_page_ptr(BBA_RHBP);
+	u8 *const read_ptr  = ptr_from_page_ptr(BBA_RRP);
+	u8 *const start_ptr = ptr_from_page_ptr(BBA_RWP) + 4;
+
+	seg[0] = start_ptr;
+	seg[1] = base_ptr;
+	seg_size[0] = seg_size[1] = 0;
+
+	if (end_ptr > mBbaMem + BBA_MEM_SIZE || base_ptr >= end_ptr ||
+	    start_ptr < base_ptr || start_ptr >= end_ptr ||
+	    read_ptr < base_ptr || read_ptr >= end_ptr)
+		return 0;
+
+	if (read_ptr > start_ptr)
+	{
+		seg_size[0] = (u32)(read_ptr - start_ptr);
+	}
+	else
+	{
+		seg_size[0] = (u32)(end_ptr - start_ptr);
+		seg_size[1] = (u32)(read_ptr - base_ptr);
+	}
+	return seg_size[0] + seg_size[1];
+}
+
 // This function is on the critical path for receiving data.
 // Be very careful about calling into the logger and other slow things
-bool CEXIETHERNET::RecvHandlePacket()
+bool CEXIETHERNET::RecvHandlePacket(bool in_ring)
 {
-	u8 *write_ptr;
-	u8 *end_ptr;
-	u8 *read_ptr;
+	u8 *seg[2];
+	u32 seg_size[2];
+	u8 dest_eth_addr[6];
 	Descriptor *descriptor;
 	u32 status = 0;
+	u32 free_size, written, first, pages;
 	u16 rwp_initial = page_ptr(BBA_RWP);
 
-	if (!RecvMACFilter())
+	free_size = RecvRingSpace(seg, seg_size);
+
+	if (in_ring)
+	{
+		for (u32 i = 0; i < 6; ++i)
+			dest_eth_addr[i] = i < seg_size[0] ? seg[0][i] : seg[1][i - seg_size[0]];
+	}
+	else
+	{
+		memcpy(dest_eth_addr, mRecvBuffer, 6);
+	}
+
+	if (!RecvMACFilter(dest_eth_addr))
 		goto wait_for_next;
 
 #ifdef BBA_TRACK_PAGE_PTRS
@@ -562,47 +605,40 @@ bool CEXIETHERNET::RecvHandlePacket()
 		page_ptr(BBA_RHBP));
 #endif
 
-	write_ptr = ptr_from_page_ptr(BBA_RWP);
-	end_ptr   = ptr_from_page_ptr(BBA_RHBP);
-	read_ptr  = ptr_from_page_ptr(BBA_RRP);
-
-	descriptor = (Descriptor *)write_ptr;
-	write_ptr += 4;
+	descriptor = (Descriptor *)ptr_from_page_ptr(BBA_RWP);
 
-	for (u32 i = 0, off = 4; i < mRecvBufferLength; ++i, ++off)
+	// The copy stops when it reaches RRP, a frame read into the ring
+	// always fit
+	written = std::min(mRecvBufferLength, free_size);
+	if (!in_ring)
 	{
-		*write_ptr++ = mRecvBuffer[i];
-
-		if (off == 0xff)
-		{
-			off = 0;
-			inc_rwp();
-		}
-
-		if (write_ptr == end_ptr)
-			write_ptr = ptr_from_page_ptr(BBA_BP);
+		first = std::min(written, seg_size[0]);
+		memcpy(seg[0], mRecvBuffer, first);
+		memcpy(seg[1], mRecvBuffer + first, written - first);
+	}
 
-		if (write_ptr == read_ptr)
-		{
-			/*
-			halt copy
-			if (cur_packet_size >= PAGE_SIZE)
-				desc.status |= FO | BF
-			if (RBFIM)
-				raise RBFI
-			if (AUTORCVR)
-				discard bad packet
-			else
-				inc MPC instead of receiving packets
-			*/
-			status |= DESC_FO | DESC_BF;
-			mBbaMem[BBA_IR] |= mBbaMem[BBA_IMR] & INT_RBF;
-			break;
-		}
+	if (written == free_size)
+	{
+		/*
+		halt copy
+		if (cur_packet_size >= PAGE_SIZE)
+			desc.status |= FO | BF
+		if (RBFIM)
+			raise RBFI
+		if (AUTORCVR)
+			discard bad packet
+		else
+			inc MPC instead of receiving packets
+		*/
+		status |= DESC_FO | DESC_BF;
+		mBbaMem[BBA_IR] |= mBbaMem[BBA_IMR] & INT_RBF;
 	}
 
-	// Align up to next page
+	// One page for each one that was filled, and align up to next page
+	pages = (written + 4) / 256;
 	if ((mRecvBufferLength + 4) % 256)
+		pages++;
+	while (pages--)
 		inc_rwp();
 
 #ifdef BBA_TRACK_PAGE_PTRS
@@ -614,7 +650,7 @@ bool CEXIETHERNET::RecvHandlePacket()
 #endif
 
 	// Is the current frame multicast?
-	if (mRecvBuffer[0] & 0x01)
+	if (dest_eth_addr[0] & 0x01)
 		status |= DESC_MF;
 
 	if (status & DESC_BF)
@@ -294,10 +294,13 @@ public:
 	void SendFromDirectFIFO();
 	void SendFromPacketBuffer();
 	void SendComplete();
-	u8 HashIndex(u8 *dest_eth_addr);
-	bool RecvMACFilter();
+	u8 HashIndex(const u8 *dest_eth_addr);
+	bool RecvMACFilter(const u8 *dest_eth_addr);
 	void inc_rwp();
-	bool RecvHandlePacket();
+	u32 RecvRingSpace(u8 *seg[2], u32 seg_size[2]);
+	// in_ring: the TAP code already read the frame into the ring behind
+	// the descriptor at RWP, instead of into mRecvBuffer
+	bool RecvHandlePacket(bool in_ring = false);
 
 	u8 *tx_fifo;
 	u8 *mBbaMem;
@@ -2,6 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "Common.h"
 #include "FileUtil.h"
 #include "StringUtil.h"
@@ -15,6 +21,7 @@
 #include "EXI_DeviceMemoryCard.h"
 #include "Sram.h"
 #include "GCMemcard.h"
+#include "GCMemcardDirectory.h"
 
 #define MC_STATUS_BUSY              0x80
 #define MC_STATUS_UNLOCKED          0x40
@@ -24,6 +31,7 @@
 #define MC_STATUS_READY             0x01
 #define SIZE_TO_Mb (1024 * 8 * 16)
 #define MC_HDR_SIZE 0xA000
+#define MC_BLOCK_SIZE 0x2000
 
 void CEXIMemoryCard::FlushCallback(u64 userdata, int cyclesLate)
 {
@@ -75,8 +83,22 @@ CEXIMemoryCard::CEXIMemoryCard(const int index)
 
 	card_id = 0xc221; // It's a Nintendo brand memcard
 
-	File::IOFile pFile(m_strFilename, "rb");
-	if (pFile)
+	const bool is_directory = File::IsDirectory(m_strFilename);
+	File::IOFile pFile;
+	if (!is_directory)
+		pFile.Open(m_strFilename, "rb");
+
+	if (is_directory)
+	{
+		// The saves are only read when the game gets to them
+		nintendo_card_id = 0x00000080;
+		memory_card_size = nintendo_card_id * SIZE_TO_Mb;
+
+		memory_card_content = new u8[memory_card_size];
+		m_pDirectory.reset(new GCMemcardDirectory(m_strFilename, memory_card_content, nintendo_card_id,
+			m_strFilename.find("JAP") != std::string::npos));
+	}
+	else if (pFile)
 	{
 		// Measure size of the memcard file.
 		memory_card_size = (int)pFile.GetSize();
@@ -100,10 +122,59 @@ CEXIMemoryCard::CEXIMemoryCard(const int index)
 		WARN_LOG(EXPANSIONINTERFACE, "No memory card found. Will create a new one.");
 	}
 	SetCardFlashID(memory_card_content, card_index);
+
+	// A new card is written whole by the first flush
+	m_dirty_blocks.assign(memory_card_size / MC_BLOCK_SIZE, !is_directory && !pFile);
+}
+
+void CEXIMemoryCard::SetBlocksDirty(u32 offset, u32 size)
+{
+	for (u32 block = offset / MC_BLOCK_SIZE; block < (offset + size + MC_BLOCK_SIZE - 1) / MC_BLOCK_SIZE; ++block)
+	{
+		if (block < m_dirty_blocks.size())
+			m_dirty_blocks[block] = true;
+	}
+}
+
+static void SyncFile(File::IOFile& file)
+{
+	file.Flush();
+#ifdef _WIN32
+	_commit(_fileno(file.GetHandle()));
+#else
+	fsync(fileno(file.GetHandle()));
+#endif
+}
+
+static void innerFlushDirectory(FlushData* data)
+{
+	for (auto& file : data->files)
+	{
+		File::IOFile gci(file.first, "wb");
+		if (!gci.WriteBytes(file.second.data(), file.second.size()))
+		{
+			PanicAlertT("Could not write memory card file %s.", file.first.c_str());
+			continue;
+		}
+		SyncFile(gci);
+	}
+
+	for (auto& filename : data->deleted)
+		File::Delete(filename);
+
+	if (!data->bExiting)
+		Core::DisplayMessage(StringFromFormat("Wrote %u saves of memory card %c to %s",
+			(unsigned)data->files.size(), data->memcardIndex ? 'B' : 'A', data->filename.c_str()).c_str(), 4000);
 }
 
 void innerFlush(FlushData* data)
 {
+	if (data->bDirectory)
+	{
+		innerFlushDirectory(data);
+		return;
+	}
+
 	File::IOFile pFile(data->filename, "r+b");
 	if (!pFile)
 	{
@@ -123,7 +194,17 @@ void innerFlush(FlushData* data)
 		return;
 	}
 
-	pFile.WriteBytes(data->memcardContent, data->memcardSize);
+	for (auto& run : data->blocks)
+	{
+		if (!pFile.Seek(run.first, SEEK_SET) || !pFile.WriteBytes(run.second.data(), run.second.size()))
+		{
+			PanicAlertT("Could not write memory card file %s.", data->filename.c_str());
+			return;
+		}
+	}
+
+	// One sync for all the blocks of a flush
+	SyncFile(pFile);
 
 	if (!data->bExiting)
 		Core::DisplayMessage(StringFromFormat("Wrote memory card %c contents to %s",
@@ -145,20 +226,53 @@ void CEXIMemoryCard::Flush(bool exiting)
 		flushThread.join();
 	}
 
-	if(!exiting)
-		Core::DisplayMessage(StringFromFormat("Writing to memory card %c", card_index ? 'B' : 'A'), 1000);
-
 	flushData.filename = m_strFilename;
-	flushData.memcardContent = memory_card_content;
 	flushData.memcardIndex = card_index;
-	flushData.memcardSize = memory_card_size;
 	flushData.bExiting = exiting;
+	flushData.bDirectory = m_pDirectory != nullptr;
+	flushData.blocks.clear();
+	flushData.files.clear();
+	flushData.deleted.clear();
+
+	if (m_pDirectory)
+	{
+		m_pDirectory->GetChanges(m_dirty_blocks, &flushData.files, &flushData.deleted);
+		m_dirty_blocks.assign(m_dirty_blocks.size(), false);
+	}
+	// Without the file, only writing the changed blocks would leave holes
+	else if (!File::Exists(m_strFilename))
+	{
+		m_dirty_blocks.assign(m_dirty_blocks.size(), true);
+	}
+
+	for (u32 block = 0; !m_pDirectory && block < m_dirty_blocks.size(); )
+	{
+		if (!m_dirty_blocks[block])
+		{
+			++block;
+			continue;
+		}
+
+		u32 end = block;
+		while (end < m_dirty_blocks.size() && m_dirty_blocks[end])
+			m_dirty_blocks[end++] = false;
+
+		const u8* start = memory_card_content + block * MC_BLOCK_SIZE;
+		flushData.blocks.emplace_back(block * MC_BLOCK_SIZE,
+			std::vector<u8>(start, start + (end - block) * MC_BLOCK_SIZE));
+		block = end;
+	}
+
+	m_bDirty = false;
+	if (flushData.blocks.empty() && flushData.files.empty() && flushData.deleted.empty())
+		return;
+
+	if(!exiting)
+		Core::DisplayMessage(StringFromFormat("Writing to memory card %c", card_index ? 'B' : 'A'), 1000);
 
 	flushThread = std::thread(innerFlush, &flushData);
 	if (exiting)
 		flushThread.join();
-
-	m_bDirty = false;
 }
 
 CEXIMemoryCard::~CEXIMemoryCard()
@@ -196,12 +310,6 @@ void CEXIMemoryCard::CmdDoneLater(u64 cycles)
 
 void CEXIMemoryCard::SetCS(int cs)
 {
-	// So that memory card won't be invalidated during flushing
-	if (flushThread.joinable())
-	{
-		flushThread.join();
-	}
-
 	if (cs)  // not-selected to selected
 	{
 		m_uPosition = 0;
@@ -213,7 +321,21 @@ void CEXIMemoryCard::SetCS(int cs)
 		case cmdSectorErase:
 			if (m_uPosition > 2)
 			{
+				if (m_pDirectory)
+				{
+					const u32 offset = address & (memory_card_size-1);
+					if (offset % MC_BLOCK_SIZE)
+					{
+						m_pDirectory->LoadBlock(offset / MC_BLOCK_SIZE);
+						m_pDirectory->LoadBlock(offset / MC_BLOCK_SIZE + 1);
+					}
+					else
+					{
+						m_pDirectory->ClearBlock(offset / MC_BLOCK_SIZE);
+					}
+				}
 				memset(memory_card_content + (address & (memory_card_size-1)), 0xFF, 0x2000);
+				SetBlocksDirty(address & (memory_card_size-1), 0x2000);
 				status |= MC_STATUS_BUSY;
 				status &= ~MC_STATUS_READY;
 
@@ -226,7 +348,10 @@ void CEXIMemoryCard::SetCS(int cs)
 		case cmdChipErase:
 			if (m_uPosition > 2)
 			{
+				if (m_pDirectory)
+					m_pDirectory->ClearAll();
 				memset(memory_card_content, 0xFF, memory_card_size);
+				SetBlocksDirty(0, memory_card_size);
 				status &= ~MC_STATUS_BUSY;
 				m_bDirty = true;
 			}
@@ -239,12 +364,17 @@ void CEXIMemoryCard::SetCS(int cs)
 				int i=0;
 				status &= ~0x80;
 
+				if (m_pDirectory)
+					m_pDirectory->LoadBlock((address & (memory_card_size-1)) / MC_BLOCK_SIZE);
+
 				while (count--)
 				{
 					memory_card_content[address] = programming_buffer[i++];
 					i &= 127;
 					address = (address & ~0x1FF) | ((address+1) & 0x1FF);
 				}
+				// The address wraps within its page
+				SetBlocksDirty(address & ~0x1FF, 0x200);
 
 				CmdDoneLater(5000);
 			}
@@ -361,6 +491,8 @@ void CEXIMemoryCard::TransferByte(u8 &byte)
 			}
 			if (m_uPosition > 1) // not specified for 1..8, anyway
 			{
+				if (m_pDirectory)
+					m_pDirectory->LoadBlock((address & (memory_card_size-1)) / MC_BLOCK_SIZE);
 				byte = memory_card_content[address & (memory_card_size-1)];
 				// after 9 bytes, we start incrementing the address,
 				// but only the sector offset - the pointer wraps around
@@ -474,8 +606,17 @@ void CEXIMemoryCard::DoState(PointerWrap &p)
 		p.Do(nintendo_card_id);
 		p.Do(card_id);
 		p.Do(memory_card_size);
-		p.DoArray(memory_card_content, memory_card_size);
+		if (m_pDirectory && p.GetMode() != PointerWrap::MODE_READ)
+			m_pDirectory->LoadAll();
+		p.DoRegion(memory_card_content, memory_card_size);
 		p.Do(card_index);
+
+		if (p.GetMode() == PointerWrap::MODE_READ)
+		{
+			if (m_pDirectory)
+				m_pDirectory->ClearAll();
+			m_dirty_blocks.assign(memory_card_size / MC_BLOCK_SIZE, true);
+		}
 	}
 }
 
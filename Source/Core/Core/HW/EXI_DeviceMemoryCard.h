@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "Thread.h"
 
 // Data structure to be passed to the flushing thread.
@@ -11,10 +16,18 @@ struct FlushData
 {
 	bool bExiting;
 	std::string filename;
-	u8 *memcardContent;
-	int memcardSize, memcardIndex;
+	// Runs of changed blocks and where they go in the file, copied so the
+	// card can be written to while they're flushed
+	std::vector<std::pair<u32, std::vector<u8>>> blocks;
+	// For a GCI folder, the files to write and the ones to delete
+	bool bDirectory;
+	std::vector<std::pair<std::string, std::vector<u8>>> files;
+	std::vector<std::string> deleted;
+	int memcardIndex;
 };
 
+class GCMemcardDirectory;
+
 class CEXIMemoryCard : public IEXIDevice
 {
 public:
@@ -39,6 +52,9 @@ private:
 	// Flushes the memory card contents to disk.
 	void Flush(bool exiting = false);
 
+	// Marks the erase blocks in [offset, offset + size) as changed since the last flush.
+	void SetBlocksDirty(u32 offset, u32 size);
+
 	// Signals that the command that was previously executed is now done.
 	void CmdDone();
 
@@ -83,6 +99,10 @@ private:
 	unsigned int address;
 	int memory_card_size; //! in bytes, must be power of 2.
 	u8 *memory_card_content;
+	// One per erase block, only the changed ones are written by Flush
+	std::vector<bool> m_dirty_blocks;
+	// Set when m_strFilename is a directory of GCI files instead of a card image
+	std::unique_ptr<GCMemcardDirectory> m_pDirectory;
 
 	FlushData flushData;
 	std::thread flushThread;
@@ -0,0 +1,263 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <set>
+
+#include "FileSearch.h"
+#include "FileUtil.h"
+#include "GCMemcard.h"
+#include "GCMemcardDirectory.h"
+
+// Where things are in the system blocks and the directory entries
+enum
+{
+	DIR_BLOCK            = 1,
+	DIR_BACKUP_BLOCK     = 2,
+	BAT_BLOCK            = 3,
+	BAT_BACKUP_BLOCK     = 4,
+
+	DIR_UPDATE_COUNTER   = 0x1ffa,
+	DIR_CHECKSUM         = 0x1ffc,
+	BAT_UPDATE_COUNTER   = 0x04,
+	BAT_FREE_BLOCKS      = 0x06,
+	BAT_LAST_ALLOCATED   = 0x08,
+	BAT_MAP              = 0x0a,
+
+	DENTRY_GAMECODE      = 0x00,
+	DENTRY_FILENAME      = 0x08,
+	DENTRY_FIRST_BLOCK   = 0x36,
+	DENTRY_BLOCK_COUNT   = 0x38,
+};
+
+static u16 Read16(const u8* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static void Write16(u8* p, u16 value)
+{
+	p[0] = value >> 8;
+	p[1] = value & 0xff;
+}
+
+static void FixDirChecksums(u8* dir)
+{
+	GCMemcard::calc_checksumsBE((u16*)dir, 0xFFE, (u16*)(dir + DIR_CHECKSUM), (u16*)(dir + DIR_CHECKSUM + 2));
+}
+
+static void FixBatChecksums(u8* bat)
+{
+	GCMemcard::calc_checksumsBE((u16*)(bat + 4), 0xFFE, (u16*)bat, (u16*)(bat + 2));
+}
+
+GCMemcardDirectory::GCMemcardDirectory(const std::string& directory, u8* card, u16 size_mbits, bool sjis)
+	: m_directory(directory)
+	, m_card(card)
+	, m_num_blocks((u32)size_mbits * MBIT_TO_BLOCKS)
+	, m_sources(m_num_blocks, -1)
+{
+	if (m_directory.empty() || m_directory[m_directory.size() - 1] != DIR_SEP_CHR)
+		m_directory += DIR_SEP;
+
+	GCMemcard::Format(m_card, sjis, size_mbits);
+	memset(m_card + MC_FST_BLOCKS * BLOCK_SIZE, 0xFF, (m_num_blocks - MC_FST_BLOCKS) * BLOCK_SIZE);
+
+	u8* const dir = m_card + DIR_BLOCK * BLOCK_SIZE;
+	u8* const bat = m_card + BAT_BLOCK * BLOCK_SIZE;
+	u32 next_block = MC_FST_BLOCKS;
+	u32 num_entries = 0;
+
+	CFileSearch::XStringVector extensions(1, "*.gci");
+	CFileSearch::XStringVector directories(1, m_directory);
+	CFileSearch search(extensions, directories);
+	CFileSearch::XStringVector filenames = search.GetFileNames();
+	std::sort(filenames.begin(), filenames.end());
+
+	// Only the directory entries are read here
+	for (const std::string& filename : filenames)
+	{
+		File::IOFile gci(filename, "rb");
+		u8 dentry[DENTRY_SIZE];
+		if (!gci.ReadBytes(dentry, DENTRY_SIZE) || Read16(dentry + DENTRY_GAMECODE) == 0xFFFF)
+		{
+			WARN_LOG(EXPANSIONINTERFACE, "%s isn't a GCI file", filename.c_str());
+			continue;
+		}
+
+		const u16 block_count = Read16(dentry + DENTRY_BLOCK_COUNT);
+		const std::string card_filename = GetCardFilename(dentry);
+		if (block_count == 0 || gci.GetSize() < DENTRY_SIZE + (u64)block_count * BLOCK_SIZE)
+		{
+			WARN_LOG(EXPANSIONINTERFACE, "%s is shorter than its %u blocks", filename.c_str(), block_count);
+			continue;
+		}
+		if (m_saves.count(card_filename))
+		{
+			WARN_LOG(EXPANSIONINTERFACE, "%s has the same save as %s", filename.c_str(),
+				m_saves[card_filename].filename.c_str());
+			continue;
+		}
+		if (num_entries == DIRLEN || next_block + block_count > m_num_blocks)
+		{
+			WARN_LOG(EXPANSIONINTERFACE, "%s doesn't fit on the memory card", filename.c_str());
+			continue;
+		}
+
+		// The blocks of each save follow each other
+		Write16(dentry + DENTRY_FIRST_BLOCK, next_block);
+		for (u32 i = 0; i < block_count; ++i)
+		{
+			const u32 block = next_block + i;
+			Write16(bat + BAT_MAP + (block - MC_FST_BLOCKS) * 2, i + 1 < block_count ? block + 1 : 0xFFFF);
+			m_sources[block] = (s32)m_files.size();
+		}
+		memcpy(dir + num_entries * DENTRY_SIZE, dentry, DENTRY_SIZE);
+
+		GCIFile file = { filename, (u16)next_block, block_count };
+		m_files.push_back(file);
+		SaveEntry& save = m_saves[card_filename];
+		save.filename = filename;
+		save.dentry.assign(dentry, dentry + DENTRY_SIZE);
+
+		next_block += block_count;
+		num_entries++;
+	}
+
+	Write16(bat + BAT_FREE_BLOCKS, m_num_blocks - next_block);
+	Write16(bat + BAT_LAST_ALLOCATED, next_block - 1);
+
+	// Both copies of the directory and the block map are the same, the
+	// update counters set by the format tell the second one is current
+	memcpy(m_card + DIR_BACKUP_BLOCK * BLOCK_SIZE, dir, DIR_UPDATE_COUNTER);
+	memcpy(m_card + BAT_BACKUP_BLOCK * BLOCK_SIZE + BAT_FREE_BLOCKS, bat + BAT_FREE_BLOCKS, BLOCK_SIZE - BAT_FREE_BLOCKS);
+	for (u32 block : { DIR_BLOCK, DIR_BACKUP_BLOCK })
+		FixDirChecksums(m_card + block * BLOCK_SIZE);
+	for (u32 block : { BAT_BLOCK, BAT_BACKUP_BLOCK })
+		FixBatChecksums(m_card + block * BLOCK_SIZE);
+
+	INFO_LOG(EXPANSIONINTERFACE, "Using %u saves from %s", num_entries, m_directory.c_str());
+}
+
+std::string GCMemcardDirectory::GetCardFilename(const u8* dentry) const
+{
+	std::string filename((const char*)dentry + DENTRY_GAMECODE, 4);
+	filename += '_';
+	for (u32 i = 0; i < DENTRY_STRLEN && dentry[DENTRY_FILENAME + i]; ++i)
+	{
+		const char c = dentry[DENTRY_FILENAME + i];
+		filename += (c < 0x20 || c > 0x7e || strchr("\\/:*?\"<>|", c)) ? '_' : c;
+	}
+	return filename + ".gci";
+}
+
+void GCMemcardDirectory::LoadFile(s32 file)
+{
+	const GCIFile& gci = m_files[file];
+	std::vector<u8> data((size_t)gci.block_count * BLOCK_SIZE);
+
+	File::IOFile gci_file(gci.filename, "rb");
+	if (!gci_file.Seek(DENTRY_SIZE, SEEK_SET) || !gci_file.ReadBytes(data.data(), data.size()))
+		ERROR_LOG(EXPANSIONINTERFACE, "Couldn't read the save from %s", gci.filename.c_str());
+
+	// Blocks the game erased since are left alone
+	for (u32 i = 0; i < gci.block_count; ++i)
+	{
+		const u32 block = gci.first_block + i;
+		if (m_sources[block] != file)
+			continue;
+		memcpy(m_card + block * BLOCK_SIZE, &data[i * BLOCK_SIZE], BLOCK_SIZE);
+		m_sources[block] = -1;
+	}
+}
+
+void GCMemcardDirectory::ClearBlock(u32 block)
+{
+	if (block < m_sources.size())
+		m_sources[block] = -1;
+}
+
+void GCMemcardDirectory::LoadAll()
+{
+	for (u32 block = 0; block < m_num_blocks; ++block)
+		LoadBlock(block);
+}
+
+void GCMemcardDirectory::ClearAll()
+{
+	m_sources.assign(m_num_blocks, -1);
+}
+
+void GCMemcardDirectory::GetChanges(const std::vector<bool>& dirty_blocks,
+                                    std::vector<std::pair<std::string, std::vector<u8>>>* files,
+                                    std::vector<std::string>* deleted)
+{
+	// The current copies are the ones with the higher update counter
+	const u8* dir = m_card + DIR_BLOCK * BLOCK_SIZE;
+	const u8* dir_backup = m_card + DIR_BACKUP_BLOCK * BLOCK_SIZE;
+	if (Read16(dir_backup + DIR_UPDATE_COUNTER) >= Read16(dir + DIR_UPDATE_COUNTER))
+		dir = dir_backup;
+	const u8* bat = m_card + BAT_BLOCK * BLOCK_SIZE;
+	const u8* bat_backup = m_card + BAT_BACKUP_BLOCK * BLOCK_SIZE;
+	if (Read16(bat_backup + BAT_UPDATE_COUNTER) >= Read16(bat + BAT_UPDATE_COUNTER))
+		bat = bat_backup;
+
+	std::set<std::string> present;
+	for (u32 i = 0; i < DIRLEN; ++i)
+	{
+		const u8* dentry = dir + i * DENTRY_SIZE;
+		if (Read16(dentry + DENTRY_GAMECODE) == 0xFFFF && Read16(dentry + DENTRY_GAMECODE + 2) == 0xFFFF)
+			continue;
+
+		const std::string card_filename = GetCardFilename(dentry);
+		present.insert(card_filename);
+
+		std::vector<u32> blocks;
+		u32 block = Read16(dentry + DENTRY_FIRST_BLOCK);
+		for (u32 count = Read16(dentry + DENTRY_BLOCK_COUNT); count; --count)
+		{
+			if (block < MC_FST_BLOCKS || block >= m_num_blocks)
+				break;
+			blocks.push_back(block);
+			block = Read16(bat + BAT_MAP + (block - MC_FST_BLOCKS) * 2);
+		}
+		if (blocks.size() != Read16(dentry + DENTRY_BLOCK_COUNT))
+		{
+			// Most likely the game is in the middle of writing it
+			WARN_LOG(EXPANSIONINTERFACE, "The blocks of %s are broken, not writing it", card_filename.c_str());
+			continue;
+		}
+
+		SaveEntry& save = m_saves[card_filename];
+		bool changed = save.dentry.size() != DENTRY_SIZE || memcmp(save.dentry.data(), dentry, DENTRY_SIZE) != 0;
+		for (u32 b : blocks)
+			changed |= b < dirty_blocks.size() && dirty_blocks[b];
+		if (!changed)
+			continue;
+
+		if (save.filename.empty())
+			save.filename = m_directory + card_filename;
+		save.dentry.assign(dentry, dentry + DENTRY_SIZE);
+
+		std::vector<u8> data(dentry, dentry + DENTRY_SIZE);
+		data.reserve(DENTRY_SIZE + blocks.size() * BLOCK_SIZE);
+		for (u32 b : blocks)
+		{
+			LoadBlock(b);
+			data.insert(data.end(), m_card + b * BLOCK_SIZE, m_card + (b + 1) * BLOCK_SIZE);
+		}
+		files->emplace_back(save.filename, std::move(data));
+	}
+
+	for (auto it = m_saves.begin(); it != m_saves.end(); )
+	{
+		if (present.count(it->first))
+		{
+			++it;
+			continue;
+		}
+		deleted->push_back(it->second.filename);
+		m_saves.erase(it++);
+	}
+}
@@ -0,0 +1,66 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+
+// A memory card that keeps every save as a GCI file in a directory. The
+// system blocks are made up from the headers of the GCI files when the card
+// is inserted, the blocks of a save are only read once the game gets to them.
+class GCMemcardDirectory : NonCopyable
+{
+public:
+	// Fills in the system blocks of card, which has size_mbits * MBIT_TO_BLOCKS blocks
+	GCMemcardDirectory(const std::string& directory, u8* card, u16 size_mbits, bool sjis);
+
+	// Has to be called before the game reads the block or writes part of it
+	void LoadBlock(u32 block)
+	{
+		if (block < m_sources.size() && m_sources[block] >= 0)
+			LoadFile(m_sources[block]);
+	}
+	// The game erases the whole block, so its save doesn't have to be read
+	void ClearBlock(u32 block);
+	void LoadAll();
+	void ClearAll();
+
+	// The GCI files of the saves that were added, or had their entry or one
+	// of their blocks changed, and the files of the saves that were deleted
+	void GetChanges(const std::vector<bool>& dirty_blocks,
+	                std::vector<std::pair<std::string, std::vector<u8>>>* files,
+	                std::vector<std::string>* deleted);
+
+private:
+	struct GCIFile
+	{
+		std::string filename;
+		u16 first_block;
+		u16 block_count;
+	};
+
+	struct SaveEntry
+	{
+		std::string filename;
+		std::vector<u8> dentry;
+	};
+
+	void LoadFile(s32 file);
+	std::string GetCardFilename(const u8* dentry) const;
+
+	std::string m_directory;
+	u8* m_card;
+	u32 m_num_blocks;
+
+	std::vector<GCIFile> m_files;
+	// Which of m_files the data of each block still has to be read from, -1 if none
+	std::vector<s32> m_sources;
+	// The entry of each save as it is in its file, by the name it has on the card
+	std::map<std::string, SaveEntry> m_saves;
+};
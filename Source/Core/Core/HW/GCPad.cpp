@@ -67,7 +67,8 @@ void GetStatus(u8 _numPAD, SPADStatus* _pPADStatus)
 	if (_numPAD <= _last_numPAD)
 	{
 		g_controller_interface.UpdateOutput();
-		g_controller_interface.UpdateInput();
+		if (!g_controller_interface.IsPolling() || SConfig::GetInstance().m_LocalCoreStartupParameter.bLateInputSampling)
+			g_controller_interface.UpdateInput();
 	}
 	_last_numPAD = _numPAD;
 
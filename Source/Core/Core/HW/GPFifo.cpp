@@ -85,7 +85,7 @@ void STACKALIGN CheckGatherPipe()
 		memmove(m_gatherPipe, m_gatherPipe + cnt, m_gatherPipeCount);
 
 		// Profile where the FIFO writes are occurring.
-		if (jit && PC != 0 && (jit->js.fifoWriteAddresses.find(PC)) == (jit->js.fifoWriteAddresses.end()))
+		if (jit && !jit->jo.fastInterrupts && PC != 0 && (jit->js.fifoWriteAddresses.find(PC)) == (jit->js.fifoWriteAddresses.end()))
 		{
 			// Log only stores, fp stores and ps stores, filtering out other instructions arrived via optimizeGatherPipe
 			int type = GetOpInfo(Memory::ReadUnchecked_U32(PC))->type;
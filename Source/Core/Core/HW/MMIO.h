@@ -45,6 +45,15 @@ inline u32 UniqueID(u32 address)
 	return (1 + ((address >> 24) & 1)) * (address & 0xFFFF);
 }
 
+// Whether the address is in one of the MMIO blocks, and can be passed to
+// UniqueID().
+inline bool IsMMIOAddress(u32 address)
+{
+	return ((address & 0xFFFF0000) == 0xCC000000) ||
+	       ((address & 0xFFFF0000) == 0xCD000000) ||
+	       ((address & 0xFFFF0000) == 0xCD800000);
+}
+
 // Some utilities functions to define MMIO mappings.
 namespace Utils
 {
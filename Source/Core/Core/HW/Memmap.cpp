@@ -9,6 +9,13 @@
 // may be redirected here (for example to Read_U32()).
 
 
+#include <algorithm>
+#include <map>
+#include <vector>
+#if _M_SSE >= 0x200
+#include <emmintrin.h>
+#endif
+
 #include "Common.h"
 #include "MemoryUtil.h"
 #include "MemArena.h"
@@ -18,6 +25,7 @@
 #include "../Core.h"
 #include "../PowerPC/PowerPC.h"
 #include "../PowerPC/JitCommon/JitBase.h"
+#include "../PowerPC/JitInterface.h"
 #include "../HLE/HLE.h"
 #include "CPU.h"
 #include "ProcessorInterface.h"
@@ -59,6 +67,23 @@ u8*	base = NULL;
 MemArena g_arena;
 // ==============
 
+// MMU fastmem, every mirrored page is a view of its own, so there is a
+// limit to stay well clear of the host's limit on mappings
+static const u32 MAX_FASTMEM_MAPPED_PAGES = 8192;
+bool bMMUFastmem = false;
+u8 fastmem_pages[FASTMEM_PAGE_COUNT];
+static std::vector<u32> s_fastmem_mapped;
+
+bool bPagedMemChecks = false;
+bool bSlowMemChecks = false;
+#ifdef ENABLE_MEM_CHECK
+static const u32 MEMCHECK_PAGE_SHIFT = 12;
+// The pages protected for the memory checks, and whether their reads are
+// checked as well
+static std::map<u32, bool> s_memcheck_pages;
+static void ApplyMemChecks();
+#endif
+
 // STATE_TO_SAVE
 bool m_IsInitialized = false; // Save the Init(), Shutdown() state
 // END STATE_TO_SAVE
@@ -150,6 +175,15 @@ void Init()
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	base = MemoryMap_Setup(views, num_views, flags, &g_arena);
 
+	// Windows can only map views at 64 KB boundaries, and the JIT addresses
+	// fastmem_pages with a 32 bit displacement
+#if defined(_M_X64) && !defined(_WIN32)
+	bMMUFastmem = bMMU && SConfig::GetInstance().m_LocalCoreStartupParameter.bFastmem &&
+		(u64)fastmem_pages + sizeof(fastmem_pages) <= 0x80000000;
+#else
+	bMMUFastmem = false;
+#endif
+
 	mmio_mapping = new MMIO::Mapping();
 
 	if (wii)
@@ -160,20 +194,68 @@ void Init()
 	INFO_LOG(MEMMAP, "Memory system initialized. RAM at %p (mirrors at 0 @ %p, 0x80000000 @ %p , 0xC0000000 @ %p)",
 		m_pRAM, m_pPhysicalRAM, m_pVirtualCachedRAM, m_pVirtualUncachedRAM);
 	m_IsInitialized = true;
+
+#ifdef ENABLE_MEM_CHECK
+	// The checks outlive the emulation, nothing runs yet to pause
+	ApplyMemChecks();
+#endif
+}
+
+// Pages which are all zero in a loaded state are cleared through the arena
+// instead of copied, which keeps the unused parts of RAM and EXRAM from
+// being committed
+static void DoRAM(PointerWrap &p, u8* data, u32 size)
+{
+	if (p.GetMode() != PointerWrap::MODE_READ)
+	{
+		p.DoRegion(data, size);
+		return;
+	}
+
+	const u32 page_size = 0x1000;
+	const u8* const src = *p.GetPPtr();
+	auto is_zero_page = [&](u32 offset)
+	{
+		const u64* page = (const u64*)(src + offset);
+		const u32 length = std::min(page_size, size - offset);
+		return !std::any_of(page, page + length / 8, [](u64 v) { return v != 0; });
+	};
+
+	// The runs of pages which aren't zero are copied as regions, so the
+	// state can copy them in parallel
+	u32 offset = 0;
+	while (offset < size)
+	{
+		const bool zero = is_zero_page(offset);
+		u32 end = offset;
+		while (end < size && is_zero_page(end) == zero)
+			end += std::min(page_size, size - end);
+
+		if (zero)
+		{
+			g_arena.ZeroView(data + offset, end - offset);
+			*p.GetPPtr() += end - offset;
+		}
+		else
+		{
+			p.DoRegion(data + offset, end - offset);
+		}
+		offset = end;
+	}
 }
 
 void DoState(PointerWrap &p)
 {
 	bool wii = SConfig::GetInstance().m_LocalCoreStartupParameter.bWii;
-	p.DoArray(m_pPhysicalRAM, RAM_SIZE);
+	DoRAM(p, m_pPhysicalRAM, RAM_SIZE);
 //	p.DoArray(m_pVirtualEFB, EFB_SIZE);
-	p.DoArray(m_pVirtualL1Cache, L1_CACHE_SIZE);
+	p.DoRegion(m_pVirtualL1Cache, L1_CACHE_SIZE);
 	p.DoMarker("Memory RAM");
 	if (bFakeVMEM)
-		p.DoArray(m_pVirtualFakeVMEM, FAKEVMEM_SIZE);
+		p.DoRegion(m_pVirtualFakeVMEM, FAKEVMEM_SIZE);
 	p.DoMarker("Memory FakeVMEM");
 	if (wii)
-		p.DoArray(m_pEXRAM, EXRAM_SIZE);
+		DoRAM(p, m_pEXRAM, EXRAM_SIZE);
 	p.DoMarker("Memory EXRAM");
 }
 
@@ -183,6 +265,11 @@ void Shutdown()
 	u32 flags = 0;
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
+	ClearFastmemPages();
+#ifdef ENABLE_MEM_CHECK
+	s_memcheck_pages.clear();
+	bPagedMemChecks = bSlowMemChecks = false;
+#endif
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
 	g_arena.ReleaseSpace();
 	base = NULL;
@@ -190,14 +277,54 @@ void Shutdown()
 	INFO_LOG(MEMMAP, "Memory system shut down.");
 }
 
+void MapFastmemPage(u32 effective_address, u32 physical_address)
+{
+	const u32 page = effective_address >> FASTMEM_PAGE_SHIFT;
+	if (fastmem_pages[page] || s_fastmem_mapped.size() >= MAX_FASTMEM_MAPPED_PAGES)
+		return;
+
+	// The MMU paths only ever translate to MEM1, which is at the start of
+	// the arena
+	const u32 page_size = 1 << FASTMEM_PAGE_SHIFT;
+	u8* view = base + (page << FASTMEM_PAGE_SHIFT);
+	if (g_arena.CreateView(physical_address & RAM_MASK & ~(page_size - 1), page_size, view) != view)
+		return;
+
+	fastmem_pages[page] = 1;
+	s_fastmem_mapped.push_back(page);
+}
+
+void UnmapFastmemPage(u32 effective_address)
+{
+	const u32 page = effective_address >> FASTMEM_PAGE_SHIFT;
+	if (!fastmem_pages[page])
+		return;
+
+	g_arena.ReleaseView(base + (page << FASTMEM_PAGE_SHIFT), 1 << FASTMEM_PAGE_SHIFT);
+	fastmem_pages[page] = 0;
+	auto it = std::find(s_fastmem_mapped.begin(), s_fastmem_mapped.end(), page);
+	*it = s_fastmem_mapped.back();
+	s_fastmem_mapped.pop_back();
+}
+
+void ClearFastmemPages()
+{
+	for (u32 page : s_fastmem_mapped)
+	{
+		g_arena.ReleaseView(base + (page << FASTMEM_PAGE_SHIFT), 1 << FASTMEM_PAGE_SHIFT);
+		fastmem_pages[page] = 0;
+	}
+	s_fastmem_mapped.clear();
+}
+
 void Clear()
 {
 	if (m_pRAM)
-		memset(m_pRAM, 0, RAM_SIZE);
+		g_arena.ZeroView(m_pRAM, RAM_SIZE);
 	if (m_pL1Cache)
-		memset(m_pL1Cache, 0, L1_CACHE_SIZE);
+		g_arena.ZeroView(m_pL1Cache, L1_CACHE_SIZE);
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii && m_pEXRAM)
-		memset(m_pEXRAM, 0, EXRAM_SIZE);
+		g_arena.ZeroView(m_pEXRAM, EXRAM_SIZE);
 }
 
 bool AreMemoryBreakpointsActivated()
@@ -209,6 +336,98 @@ bool AreMemoryBreakpointsActivated()
 #endif
 }
 
+#ifdef ENABLE_MEM_CHECK
+// Pages of the cached and uncached mirrors. The physical views are left
+// alone, GetPointer hands them out to everything that accesses RAM directly.
+static bool CanProtectPage(u32 page)
+{
+	const u32 address = page << MEMCHECK_PAGE_SHIFT;
+	const u32 offset = address & 0x0FFFFFFF;
+	switch (address >> 28)
+	{
+	case 0x8:
+	case 0xC:
+		return offset < RAM_SIZE;
+	case 0x9:
+	case 0xD:
+		return SConfig::GetInstance().m_LocalCoreStartupParameter.bWii && offset < EXRAM_SIZE;
+	default:
+		return false;
+	}
+}
+
+static void ApplyMemChecks()
+{
+	const SCoreStartupParameter& startup = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	// Jit64 is the core which backpatches its fastmem accesses
+	bool can_protect = false;
+#ifdef _M_X64
+	can_protect = startup.iCPUCore == 1 && startup.bFastmem && !bMMU;
+#endif
+
+	std::map<u32, bool> pages;
+	bool slow = false;
+	for (const TMemCheck& mc : PowerPC::memchecks.GetMemChecks())
+	{
+		if (!mc.OnRead && !mc.OnWrite)
+			continue;
+
+		const u32 start = mc.StartAddress >> MEMCHECK_PAGE_SHIFT;
+		const u32 end = (mc.bRange ? mc.EndAddress : mc.StartAddress) >> MEMCHECK_PAGE_SHIFT;
+		for (u32 page = start; page <= end && !slow; ++page)
+		{
+			if (can_protect && CanProtectPage(page))
+				pages[page] |= mc.OnRead;
+			else
+				slow = true;
+		}
+		if (slow)
+			break;
+	}
+	// The JIT checks every access anyway
+	if (slow)
+		pages.clear();
+
+	const u32 page_size = 1 << MEMCHECK_PAGE_SHIFT;
+	for (const auto& old_page : s_memcheck_pages)
+	{
+		auto it = pages.find(old_page.first);
+		if (it == pages.end() || it->second != old_page.second)
+			UnWriteProtectMemory(base + (old_page.first << MEMCHECK_PAGE_SHIFT), page_size);
+	}
+	for (const auto& new_page : pages)
+	{
+		auto it = s_memcheck_pages.find(new_page.first);
+		if (it != s_memcheck_pages.end() && it->second == new_page.second)
+			continue;
+		u8* ptr = base + (new_page.first << MEMCHECK_PAGE_SHIFT);
+		if (new_page.second)
+			ReadProtectMemory(ptr, page_size);
+		else
+			WriteProtectMemory(ptr, page_size);
+	}
+
+	s_memcheck_pages.swap(pages);
+	bPagedMemChecks = !s_memcheck_pages.empty();
+	bSlowMemChecks = slow;
+}
+#endif
+
+void UpdateMemChecks()
+{
+#ifdef ENABLE_MEM_CHECK
+	if (!m_IsInitialized)
+		return;
+
+	const bool was_unpaused = Core::PauseAndLock(true);
+	ApplyMemChecks();
+	// The code compiled for the old checks may access the new pages
+	// directly, or still take the slow paths for the old ones
+	JitInterface::ClearCache();
+	Core::PauseAndLock(false, was_unpaused);
+#endif
+}
+
 u32 Read_Instruction(const u32 em_address)
 {
 	UGeckoInstruction inst = ReadUnchecked_U32(em_address);
@@ -220,12 +439,106 @@ void WriteBigEData(const u8 *_pData, const u32 _Address, const size_t _iSize)
 	memcpy(GetPointer(_Address), _pData, _iSize);
 }
 
+// Transfers at least this big skip the host caches, they would only push
+// out the data the emulator is actually working with
+static const size_t STREAM_THRESHOLD = 0x8000;
+
+void StreamCopy(void* dst, const void* src, size_t size)
+{
+#if _M_SSE >= 0x200
+	if (size >= STREAM_THRESHOLD)
+	{
+		u8* d = (u8*)dst;
+		const u8* s = (const u8*)src;
+		const size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+		memcpy(d, s, head);
+		d += head;
+		s += head;
+		size -= head;
+		for (; size >= 64; size -= 64, d += 64, s += 64)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)s);
+			const __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+			const __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+			const __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+			_mm_stream_si128((__m128i*)d, a);
+			_mm_stream_si128((__m128i*)(d + 16), b);
+			_mm_stream_si128((__m128i*)(d + 32), c);
+			_mm_stream_si128((__m128i*)(d + 48), e);
+		}
+		_mm_sfence();
+		memcpy(d, s, size);
+		return;
+	}
+#endif
+	memcpy(dst, src, size);
+}
+
+void StreamFill(void* dst, u8 value, size_t size)
+{
+#if _M_SSE >= 0x200
+	if (size >= STREAM_THRESHOLD)
+	{
+		u8* d = (u8*)dst;
+		const size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+		memset(d, value, head);
+		d += head;
+		size -= head;
+		const __m128i v = _mm_set1_epi8((char)value);
+		for (; size >= 64; size -= 64, d += 64)
+		{
+			_mm_stream_si128((__m128i*)d, v);
+			_mm_stream_si128((__m128i*)(d + 16), v);
+			_mm_stream_si128((__m128i*)(d + 32), v);
+			_mm_stream_si128((__m128i*)(d + 48), v);
+		}
+		_mm_sfence();
+		memset(d, value, size);
+		return;
+	}
+#endif
+	memset(dst, value, size);
+}
+
+u8* GetRangePointer(const u32 _Address, const u32 size)
+{
+	if (size == 0)
+		return NULL;
+	const u32 last = _Address + size - 1;
+	if (last < _Address || (last >> 28) != (_Address >> 28))
+		return NULL;
+
+	switch (_Address >> 28)
+	{
+	case 0x0:
+	case 0x8:
+	case 0xc:
+		// Also keeps out the EFB and the IO bridge at 0xc8 and 0xcc
+		if ((last & 0xfffffff) < REALRAM_SIZE)
+			return m_pPhysicalRAM + (_Address & RAM_MASK);
+		break;
+
+	case 0x1:
+	case 0x9:
+	case 0xd:
+		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii && (last & 0xfffffff) < EXRAM_SIZE)
+			return m_pPhysicalEXRAM + (_Address & EXRAM_MASK);
+		break;
+
+	case 0xe:
+		if (last < 0xE0000000 + L1_CACHE_SIZE)
+			return GetCachePtr() + (_Address & L1_CACHE_MASK);
+		break;
+	}
+	return NULL;
+}
+
 void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
 {
-	u8 *ptr = GetPointer(_Address);
+	u8 *ptr = GetRangePointer(_Address, _iLength);
 	if (ptr != NULL)
 	{
-		memset(ptr,_iValue,_iLength);
+		StreamFill(ptr, _iValue, _iLength);
 	}
 	else
 	{
@@ -237,11 +550,11 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
 void DMA_LCToMemory(const u32 _MemAddr, const u32 _CacheAddr, const u32 _iNumBlocks)
 {
 	const u8 *src = GetCachePtr() + (_CacheAddr & 0x3FFFF);
-	u8 *dst = GetPointer(_MemAddr);
+	u8 *dst = GetRangePointer(_MemAddr, 32 * _iNumBlocks);
 
-	if ((dst != NULL) && (src != NULL) && (_MemAddr & 3) == 0 && (_CacheAddr & 3) == 0)
+	if ((dst != NULL) && (_CacheAddr & 0x3FFFF) + 32 * _iNumBlocks <= L1_CACHE_SIZE)
 	{
-		memcpy(dst, src, 32 * _iNumBlocks);
+		StreamCopy(dst, src, 32 * _iNumBlocks);
 	}
 	else
 	{
@@ -255,11 +568,12 @@ void DMA_LCToMemory(const u32 _MemAddr, const u32 _CacheAddr, const u32 _iNumBlo
 
 void DMA_MemoryToLC(const u32 _CacheAddr, const u32 _MemAddr, const u32 _iNumBlocks)
 {
-	const u8 *src = GetPointer(_MemAddr);
+	const u8 *src = GetRangePointer(_MemAddr, 32 * _iNumBlocks);
 	u8 *dst = GetCachePtr() + (_CacheAddr & 0x3FFFF);
 
-	if ((dst != NULL) && (src != NULL) && (_MemAddr & 3) == 0 && (_CacheAddr & 3) == 0)
+	if ((src != NULL) && (_CacheAddr & 0x3FFFF) + 32 * _iNumBlocks <= L1_CACHE_SIZE)
 	{
+		// The locked cache is read right away, keep it in the host caches
 		memcpy(dst, src, 32 * _iNumBlocks);
 	}
 	else
@@ -86,6 +86,20 @@ void DoState(PointerWrap &p);
 void Clear();
 bool AreMemoryBreakpointsActivated();
 
+// Memory checks on RAM protect the pages they're on in the mirrors at
+// 0x80000000 and 0xC0000000 (and their EXRAM counterparts). The JIT's
+// fastmem accesses fault on them and get backpatched into calls to the
+// Memory functions, which do the checks, so everything else keeps running
+// at full speed. While bPagedMemChecks is set the JIT must not reach RAM
+// through any other direct access. bSlowMemChecks means some check couldn't
+// be done with page protection, and the JIT does all accesses through the
+// Memory functions.
+extern bool bPagedMemChecks;
+extern bool bSlowMemChecks;
+inline bool HasMemChecks() { return bPagedMemChecks || bSlowMemChecks; }
+// Picks up a change of PowerPC::memchecks, pauses the emulation to do it
+void UpdateMemChecks();
+
 // ONLY for use by GUI
 u8 ReadUnchecked_U8(const u32 _Address);
 u32 ReadUnchecked_U32(const u32 _Address);
@@ -158,6 +172,14 @@ void DMA_LCToMemory(const u32 _iMemAddr, const u32 _iCacheAddr, const u32 _iNumB
 void DMA_MemoryToLC(const u32 _iCacheAddr, const u32 _iMemAddr, const u32 _iNumBlocks);
 void Memset(const u32 _Address, const u8 _Data, const u32 _iLength);
 
+// Like GetPointer, but for the whole range, and NULL instead of an error
+// when it doesn't lie in one block of RAM, EXRAM or the locked cache
+u8* GetRangePointer(const u32 _Address, const u32 size);
+// memcpy and memset which use non-temporal stores for the big transfers of
+// DMAs, so they don't flush the host caches
+void StreamCopy(void* dst, const void* src, size_t size);
+void StreamFill(void* dst, u8 value, size_t size);
+
 // TLB functions
 void SDRUpdated();
 enum XCheckTLBFlag
@@ -169,6 +191,23 @@ enum XCheckTLBFlag
 };
 u32 TranslateAddress(u32 _Address, XCheckTLBFlag _Flag);
 void InvalidateTLBEntry(u32 _Address);
+// Needed after the BATs, HID4 or the whole MMU state changed
+void InvalidateTranslationCache();
+
+// MMU fastmem: the pages which the guest page table maps to RAM get
+// mirrored at their effective address in the fastmem area as they are
+// translated, and the JIT checks fastmem_pages before it accesses an
+// address outside the static views directly
+enum
+{
+	FASTMEM_PAGE_SHIFT = 12,
+	FASTMEM_PAGE_COUNT = 1 << (32 - FASTMEM_PAGE_SHIFT),
+};
+extern bool bMMUFastmem;
+extern u8 fastmem_pages[FASTMEM_PAGE_COUNT];
+void MapFastmemPage(u32 effective_address, u32 physical_address);
+void UnmapFastmemPage(u32 effective_address);
+void ClearFastmemPages();
 void GenerateDSIException(u32 _EffectiveAdress, bool _bWrite);
 void GenerateISIException(u32 _EffectiveAdress);
 extern u32 pagetable_base;
@@ -572,6 +572,8 @@ void GenerateISIException(u32 _EffectiveAddress)
 
 void SDRUpdated()
 {
+	InvalidateTranslationCache();
+
 	u32 htabmask = SDR1_HTABMASK(PowerPC::ppcState.spr[SPR_SDR]);
 	u32 x = 1;
 	u32 xx = 0;
@@ -597,52 +599,37 @@ void SDRUpdated()
 
 
 // TLB cache
-//#define FAST_TLB_CACHE
-
-#define TLB_SIZE 128
-#define TLB_WAYS 2
 #define NUM_TLBS 2
 
 #define HW_PAGE_SIZE 4096
 #define HW_PAGE_INDEX_SHIFT 12
-#define HW_PAGE_INDEX_MASK 0x3f
-#define HW_PAGE_TAG_SHIFT 18
 
-#define TLB_FLAG_MOST_RECENT 0x01
-#define TLB_FLAG_INVALID 0x02
+// Host side direct mapped cache of the final BAT or page table translations,
+// TranslateAddress looks here before it scans the BATs and the TLB. A tag
+// holds the effective page, MSR[PR] (which selects the valid BATs) and a
+// valid bit. The segment register the translation was made with is stored
+// along, so that the JITs can keep writing those directly.
+#define TRANSLATION_CACHE_SIZE 1024
+#define TRANSLATION_TAG_PR 0x2
+#define TRANSLATION_TAG_VALID 0x1
 
-typedef struct tlb_entry
+struct TranslationCacheEntry
 {
 	u32 tag;
+	u32 sr;
 	u32 paddr;
-	u8 flags;
-} tlb_entry;
+};
 
-// TODO: tlb needs to be in ppcState for save-state purposes.
-#ifdef FAST_TLB_CACHE
-static tlb_entry tlb[NUM_TLBS][TLB_SIZE/TLB_WAYS][TLB_WAYS];
-#endif
+static TranslationCacheEntry s_translation_cache[NUM_TLBS][TRANSLATION_CACHE_SIZE];
+
+void InvalidateTranslationCache()
+{
+	memset(s_translation_cache, 0, sizeof(s_translation_cache));
+	ClearFastmemPages();
+}
 
 u32 LookupTLBPageAddress(const XCheckTLBFlag _Flag, const u32 vpa, u32 *paddr)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[_Flag == FLAG_OPCODE][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if(tlbe[0].tag == (vpa & ~0xfff) && !(tlbe[0].flags & TLB_FLAG_INVALID))
-	{
-		tlbe[0].flags |= TLB_FLAG_MOST_RECENT;
-		tlbe[1].flags &= ~TLB_FLAG_MOST_RECENT;
-		*paddr = tlbe[0].paddr | (vpa & 0xfff);
-		return 1;
-	}
-	if(tlbe[1].tag == (vpa & ~0xfff) && !(tlbe[1].flags & TLB_FLAG_INVALID))
-	{
-		tlbe[1].flags |= TLB_FLAG_MOST_RECENT;
-		tlbe[0].flags &= ~TLB_FLAG_MOST_RECENT;
-		*paddr = tlbe[1].paddr | (vpa & 0xfff);
-		return 1;
-	}
-	return 0;
-#else
 	u32 _Address = vpa;
 	if (_Flag == FLAG_OPCODE)
 	{
@@ -669,28 +656,10 @@ u32 LookupTLBPageAddress(const XCheckTLBFlag _Flag, const u32 vpa, u32 *paddr)
 		}
 	}
 	return 0;
-#endif
 }
 
 void UpdateTLBEntry(const XCheckTLBFlag _Flag, UPTE2 PTE2, const u32 vpa)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[_Flag == FLAG_OPCODE][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if((tlbe[0].flags & TLB_FLAG_MOST_RECENT) == 0)
-	{
-		tlbe[0].flags = TLB_FLAG_MOST_RECENT;
-		tlbe[1].flags &= ~TLB_FLAG_MOST_RECENT;
-		tlbe[0].paddr = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		tlbe[0].tag = vpa & ~0xfff;
-	}
-	else
-	{
-		tlbe[1].flags = TLB_FLAG_MOST_RECENT;
-		tlbe[0].flags &= ~TLB_FLAG_MOST_RECENT;
-		tlbe[1].paddr = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		tlbe[1].tag = vpa & ~0xfff;
-	}
-#else
 	if (_Flag == FLAG_OPCODE)
 	{
 		// ITLB cache
@@ -707,31 +676,18 @@ void UpdateTLBEntry(const XCheckTLBFlag _Flag, UPTE2 PTE2, const u32 vpa)
 		PowerPC::ppcState.dtlb_pa[PowerPC::ppcState.dtlb_last] = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
 		PowerPC::ppcState.dtlb_va[PowerPC::ppcState.dtlb_last] = vpa & ~0xfff;
 	}
-#endif
 }
 
 void InvalidateTLBEntry(u32 vpa)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[0][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if(tlbe[0].tag == (vpa & ~0xfff))
+	for (int i = 0; i < NUM_TLBS; i++)
 	{
-		tlbe[0].flags |= TLB_FLAG_INVALID;
+		TranslationCacheEntry& cached = s_translation_cache[i][(vpa >> HW_PAGE_INDEX_SHIFT) & (TRANSLATION_CACHE_SIZE - 1)];
+		if ((cached.tag & ~0xfff) == (vpa & ~0xfff))
+			cached.tag = 0;
 	}
-	if(tlbe[1].tag == (vpa & ~0xfff))
-	{
-		tlbe[1].flags |= TLB_FLAG_INVALID;
-	}
-	tlb_entry *tlbe_i = tlb[1][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if(tlbe_i[0].tag == (vpa & ~0xfff))
-	{
-		tlbe_i[0].flags |= TLB_FLAG_INVALID;
-	}
-	if(tlbe_i[1].tag == (vpa & ~0xfff))
-	{
-		tlbe_i[1].flags |= TLB_FLAG_INVALID;
-	}
-#else
+	UnmapFastmemPage(vpa);
+
 	u32 _Address = vpa;
 	for (int i = 0; i < 128; i++)
 	{
@@ -746,7 +702,6 @@ void InvalidateTLBEntry(u32 vpa)
 			PowerPC::ppcState.itlb_va[(PowerPC::ppcState.itlb_last + i) & 127] = 0;
 		}
 	}
-#endif
 }
 
 // Page Address Translation
@@ -911,20 +866,28 @@ u32 TranslateAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 	// Check MSR[DR] bit before translating data addresses
 	//if (((_Flag == FLAG_READ) || (_Flag == FLAG_WRITE)) && !(MSR & (1 << (31 - 27)))) return _Address;
 
+	const u32 tag = (_Address & ~0xfff) | (((UReg_MSR&)PowerPC::ppcState.msr).PR ? TRANSLATION_TAG_PR : 0) | TRANSLATION_TAG_VALID;
+	const u32 sr = PowerPC::ppcState.sr[EA_SR(_Address)];
+	TranslationCacheEntry& cached = s_translation_cache[_Flag == FLAG_OPCODE][(_Address >> HW_PAGE_INDEX_SHIFT) & (TRANSLATION_CACHE_SIZE - 1)];
+	if (cached.tag == tag && cached.sr == sr)
+		return cached.paddr | (_Address & 0xfff);
+
 	u32 tlb_addr = TranslateBlockAddress(_Address, _Flag);
 	if (tlb_addr == 0)
 	{
 		tlb_addr = TranslatePageAddress(_Address, _Flag);
-		if (tlb_addr != 0)
-		{
-			return tlb_addr;
-		}
-	}
-	else
-	{
-		return tlb_addr;
+		if (tlb_addr == 0)
+			return 0;
+
+		// Only the loads and stores which went through the MMU paths of
+		// ReadFromHardware/WriteToHardware arrive here with these flags
+		if (bMMUFastmem && (_Flag == FLAG_READ || _Flag == FLAG_WRITE))
+			MapFastmemPage(_Address, tlb_addr);
 	}
 
-	return 0;
+	cached.tag = tag;
+	cached.sr = sr;
+	cached.paddr = tlb_addr & ~0xfff;
+	return tlb_addr;
 }
 } // namespace
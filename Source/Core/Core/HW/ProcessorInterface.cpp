@@ -10,10 +10,12 @@
 #include "../PowerPC/PowerPC.h"
 
 #include "CPU.h"
+#include "../Core.h"
 #include "../CoreTiming.h"
 #include "ProcessorInterface.h"
 #include "GPFifo.h"
 #include "VideoBackendBase.h"
+#include "CommandProcessor.h"
 #include "MMIO.h"
 
 namespace ProcessorInterface
@@ -94,7 +96,11 @@ void Init()
 void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 {
 	mmio->Register(base | PI_INTERRUPT_CAUSE,
-		MMIO::DirectRead<u32>(&m_InterruptCause),
+		MMIO::ComplexRead<u32>([](u32) {
+			// Games poll for the PE finish and token interrupts here
+			CommandProcessor::SyncGPU();
+			return m_InterruptCause;
+		}),
 		MMIO::ComplexWrite<u32>([](u32, u32 val) {
 			Common::AtomicAnd(m_InterruptCause, ~val);
 			UpdateException();
@@ -158,7 +164,15 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 void UpdateException()
 {
 	if ((m_InterruptCause & m_InterruptMask) != 0)
+	{
 		Common::AtomicOr(PowerPC::ppcState.Exceptions, EXCEPTION_EXTERNAL_INT);
+
+		// Without the checks after FIFO stores the JIT only tests for external
+		// exceptions between slices, so end the current one right away. Off the
+		// CPU thread the interrupt waits for the next slice.
+		if (Core::g_CoreStartupParameter.bJITFastInterrupts && Core::IsCPUThread())
+			CoreTiming::ForceExceptionCheck(0);
+	}
 	else
 		Common::AtomicAnd(PowerPC::ppcState.Exceptions, ~EXCEPTION_EXTERNAL_INT);
 }
@@ -13,28 +13,22 @@ static s32 histl2;
 static s32 histr1;
 static s32 histr2;
 
-s16 ADPDecodeSample(s32 bits, s32 q, s32& hist1, s32& hist2)
+// Predictor coefficients, picked once per block by the top bits of the header byte
+static const s32 coefficients[4][2] =
 {
-	s32 hist = 0;
-	switch (q >> 4)
-	{
-	case 0:
-		hist = 0;
-		break;
-	case 1:
-		hist = (hist1 * 0x3c);
-		break;
-	case 2:
-		hist = (hist1 * 0x73) - (hist2 * 0x34);
-		break;
-	case 3:
-		hist = (hist1 * 0x62) - (hist2 * 0x37);
-		break;
-	}
+	{ 0x00, 0x00 },
+	{ 0x3c, 0x00 },
+	{ 0x73, -0x34 },
+	{ 0x62, -0x37 },
+};
+
+static inline s16 ADPDecodeSample(s32 bits, s32 shift, const s32* coef, s32& hist1, s32& hist2)
+{
+	s32 hist = (hist1 * coef[0]) + (hist2 * coef[1]);
 	hist = (hist + 0x20) >> 6;
 	MathUtil::Clamp(&hist, -0x200000, 0x1fffff);
 
-	s32 cur = (((s16)(bits << 12) >> (q & 0xf)) << 6) + hist;
+	s32 cur = (((s16)(bits << 12) >> shift) << 6) + hist;
 
 	hist2 = hist1;
 	hist1 = cur;
@@ -55,9 +49,17 @@ void NGCADPCM::InitFilter()
 
 void NGCADPCM::DecodeBlock(s16 *pcm, const u8 *adpcm)
 {
+	// The header is the same for the whole block, so only decode it once
+	// Unknown predictors don't predict anything
+	const s32* coefl = coefficients[(adpcm[0] >> 4) < 4 ? (adpcm[0] >> 4) : 0];
+	const s32* coefr = coefficients[(adpcm[1] >> 4) < 4 ? (adpcm[1] >> 4) : 0];
+	const s32 shiftl = adpcm[0] & 0xf;
+	const s32 shiftr = adpcm[1] & 0xf;
+	const u8* data = adpcm + (ONE_BLOCK_SIZE - SAMPLES_PER_BLOCK);
+
 	for (int i = 0; i < SAMPLES_PER_BLOCK; i++)
 	{
-		pcm[i * 2]     = ADPDecodeSample(adpcm[i + (ONE_BLOCK_SIZE - SAMPLES_PER_BLOCK)] & 0xf, adpcm[0], histl1, histl2);
-		pcm[i * 2 + 1] = ADPDecodeSample(adpcm[i + (ONE_BLOCK_SIZE - SAMPLES_PER_BLOCK)] >> 4,  adpcm[1], histr1, histr2);
+		pcm[i * 2]     = ADPDecodeSample(data[i] & 0xf, shiftl, coefl, histl1, histl2);
+		pcm[i * 2 + 1] = ADPDecodeSample(data[i] >> 4,  shiftr, coefr, histr1, histr2);
 	}
 }
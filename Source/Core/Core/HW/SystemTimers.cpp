@@ -59,6 +59,7 @@ IPC_HLE_PERIOD: For the Wiimote this is the call schedule:
 
 #include "Common.h"
 #include "Atomic.h"
+#include "FileUtil.h"
 #include "../PatchEngine.h"
 #include "SystemTimers.h"
 #include "DSP.h"
@@ -67,8 +68,10 @@ IPC_HLE_PERIOD: For the Wiimote this is the call schedule:
 #include "SI.h"
 #include "EXI_DeviceIPL.h"
 #include "../PowerPC/PowerPC.h"
+#include "../PowerPC/Profiler.h"
 #include "../CoreTiming.h"
 #include "../ConfigManager.h"
+#include "../Movie.h"
 #include "../IPC_HLE/WII_IPC_HLE.h"
 #include "../DSPEmulator.h"
 #include "Thread.h"
@@ -117,6 +120,7 @@ int et_DSP;
 int et_IPC_HLE;
 int et_PatchEngine;	// PatchEngine updates every 1/60th of a second by default
 int et_Throttle;
+int et_BlockStats;
 
 // These are badly educated guesses
 // Feel free to experiment. Set these in Init below.
@@ -231,27 +235,48 @@ void PatchEngineCallback(u64 userdata, int cyclesLate)
 	CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerFrame() - cyclesLate, et_PatchEngine);
 }
 
+// last_time is in microseconds, it advances by 1 ms of real time per event
 void ThrottleCallback(u64 last_time, int cyclesLate)
 {
-	u32 time = Common::Timer::GetTimeMs();
+	u64 time = Common::Timer::GetTimeUs();
 
-	int diff = (u32)last_time - time;
-	bool frame_limiter = SConfig::GetInstance().m_Framelimit && SConfig::GetInstance().m_Framelimit != 2 && !Host_GetKeyState('\t');
+	s64 diff = (s64)(last_time - time);
+	bool frame_limiter = SConfig::GetInstance().m_Framelimit && SConfig::GetInstance().m_Framelimit != 2 &&
+		!Host_GetKeyState('\t') && !Movie::IsVerifying();
 	u32 next_event = GetTicksPerSecond()/1000;
 	if (SConfig::GetInstance().m_Framelimit > 2)
 	{
 		next_event = next_event * (SConfig::GetInstance().m_Framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	const int max_fallback = 40; // 40 ms for one frame on 25 fps games
-	if (frame_limiter && abs(diff) > max_fallback)
+	const s64 max_fallback = 40000; // 40 ms for one frame on 25 fps games
+	// Only wait once a couple of ms have built up, so most of it can be slept and
+	// only the tail is spun. Smaller leads stay in last_time for a later event.
+	const s64 min_wait = 2000;
+	const u64 spin_tail = 500;
+	const s64 abs_diff = diff < 0 ? -diff : diff;
+	if (frame_limiter && abs_diff > max_fallback)
 	{
-		DEBUG_LOG(COMMON, "system too %s, %d ms skipped", diff<0 ? "slow" : "fast", abs(diff) - max_fallback);
+		DEBUG_LOG(COMMON, "system too %s, %d ms skipped", diff<0 ? "slow" : "fast", (int)((abs_diff - max_fallback) / 1000));
 		last_time = time - max_fallback;
 	}
-	else if (frame_limiter && diff > 0)
-		Common::SleepCurrentThread(diff);
-	CoreTiming::ScheduleEvent(next_event - cyclesLate, et_Throttle, last_time + 1);
+	else if (frame_limiter && diff >= min_wait)
+		Common::Timer::SleepUntilUs(last_time, spin_tail);
+	CoreTiming::ScheduleEvent(next_event - cyclesLate, et_Throttle, last_time + 1000);
+}
+
+// Runs every second, the userdata counts them up to the export interval
+void BlockStatsCallback(u64 seconds, int cyclesLate)
+{
+	const SCoreStartupParameter& param = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	if (++seconds >= (u64)param.iBlockStatsInterval)
+	{
+		const std::string filename = File::GetUserPath(D_DUMP_IDX) + param.m_strUniqueID + "_blockstats.json";
+		if (!Profiler::ExportBlockStats(filename))
+			WARN_LOG(POWERPC, "Failed to write %s", filename.c_str());
+		seconds = 0;
+	}
+	CoreTiming::ScheduleEvent(GetTicksPerSecond() - cyclesLate, et_BlockStats, seconds);
 }
 
 // split from Init to break a circular dependency between VideoInterface::Init and SystemTimers::Init
@@ -290,24 +315,38 @@ void Init()
 	CoreTiming::SetFakeDecStartValue(0xFFFFFFFF);
 	CoreTiming::SetFakeDecStartTicks(CoreTiming::GetTicks());
 
+	// The periodic updates which don't have to hit their cycle may run up to
+	// a scanline (but no more than 50us) late, so they mostly run in the
+	// Advance of a VI update. The DSP LLE slices shrink when they run late,
+	// so they stay exact.
+	const int slack = std::min<int>(VideoInterface::GetTicksPerLine(), GetTicksPerSecond() / 20000);
+	const int dsp_slack = DSP::GetDSPEmulator()->IsLLE() ? 0 : slack;
+
 	et_Dec = CoreTiming::RegisterEvent("DecCallback", DecrementerCallback);
 	et_VI = CoreTiming::RegisterEvent("VICallback", VICallback);
-	et_SI = CoreTiming::RegisterEvent("SICallback", SICallback);
-	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bSyncGPU)
+	et_SI = CoreTiming::RegisterEvent("SICallback", SICallback, slack);
+	// The deterministic dual core mode syncs with the GPU every CP_PERIOD
+	const SCoreStartupParameter& param = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	const bool cp_events = param.bSyncGPU || (param.bCPUThread && param.bDeterministicDualCore);
+	if (cp_events)
 		et_CP = CoreTiming::RegisterEvent("CPCallback", CPCallback);
-	et_DSP = CoreTiming::RegisterEvent("DSPCallback", DSPCallback);
-	et_AudioDMA = CoreTiming::RegisterEvent("AudioDMACallback", AudioDMACallback);
-	et_IPC_HLE = CoreTiming::RegisterEvent("IPC_HLE_UpdateCallback", IPC_HLE_UpdateCallback);
-	et_PatchEngine = CoreTiming::RegisterEvent("PatchEngine", PatchEngineCallback);
-	et_Throttle = CoreTiming::RegisterEvent("Throttle", ThrottleCallback);
+	et_DSP = CoreTiming::RegisterEvent("DSPCallback", DSPCallback, dsp_slack);
+	et_AudioDMA = CoreTiming::RegisterEvent("AudioDMACallback", AudioDMACallback, slack);
+	et_IPC_HLE = CoreTiming::RegisterEvent("IPC_HLE_UpdateCallback", IPC_HLE_UpdateCallback, slack);
+	et_PatchEngine = CoreTiming::RegisterEvent("PatchEngine", PatchEngineCallback, slack);
+	et_Throttle = CoreTiming::RegisterEvent("Throttle", ThrottleCallback, slack);
+	if (param.iBlockStatsInterval > 0)
+		et_BlockStats = CoreTiming::RegisterEvent("BlockStats", BlockStatsCallback, slack);
 
 	CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerLine(), et_VI);
 	CoreTiming::ScheduleEvent(0, et_DSP);
 	CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerFrame(), et_SI);
 	CoreTiming::ScheduleEvent(AUDIO_DMA_PERIOD, et_AudioDMA);
-	CoreTiming::ScheduleEvent(0, et_Throttle, Common::Timer::GetTimeMs());
-	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bSyncGPU)
+	CoreTiming::ScheduleEvent(0, et_Throttle, Common::Timer::GetTimeUs());
+	if (cp_events)
 		CoreTiming::ScheduleEvent(CP_PERIOD, et_CP);
+	if (param.iBlockStatsInterval > 0)
+		CoreTiming::ScheduleEvent(GetTicksPerSecond(), et_BlockStats);
 
 	CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerFrame(), et_PatchEngine);
 
@@ -121,7 +121,8 @@ void Update(int _number)
 	if (_number <= _last_number)
 	{
 		g_controller_interface.UpdateOutput();
-		g_controller_interface.UpdateInput();
+		if (!g_controller_interface.IsPolling() || SConfig::GetInstance().m_LocalCoreStartupParameter.bLateInputSampling)
+			g_controller_interface.UpdateInput();
 	}
 	_last_number = _number;
 
@@ -149,14 +150,10 @@ unsigned int GetAttached()
 // ___________________________________________________________________________
 // Function: DoState
 // Purpose:  Saves/load state
-// input/output: ptr: [Description Needed]
-// input: mode        [Description needed]
+// input/output: p: the state being saved or loaded
 //
-void DoState(u8 **ptr, PointerWrap::Mode mode)
+void DoState(PointerWrap &p)
 {
-	// TODO:
-
-	PointerWrap p(ptr, mode);
 	for (unsigned int i=0; i<MAX_BBMOTES; ++i)
 		((WiimoteEmu::Wiimote*)g_plugin.controllers[i])->DoState(p);
 }
@@ -235,6 +235,7 @@ void Wiimote::Reset()
 	// set up the register
 	memset(&m_reg_speaker, 0, sizeof(m_reg_speaker));
 	memset(&m_reg_ir, 0, sizeof(m_reg_ir));
+	m_ir_cache.valid = false;
 	memset(&m_reg_ext, 0, sizeof(m_reg_ext));
 	memset(&m_reg_motion_plus, 0, sizeof(m_reg_motion_plus));
 
@@ -443,12 +444,12 @@ void Wiimote::GetIRData(u8* const data, bool use_accel)
 {
 	const bool has_focus = HAS_FOCUS;
 
-	u16 x[4], y[4];
-	memset(x, 0xFF, sizeof(x));
+	float xx = 10000, yy = 0, zz = 0;
 
+	// The pointer and filter state have to be updated even when the camera
+	// is off or the section is cached
 	if (has_focus)
 	{
-		float xx = 10000, yy = 0, zz = 0;
 		double nsin,ncos;
 
 		if (use_accel)
@@ -484,7 +485,29 @@ void Wiimote::GetIRData(u8* const data, bool use_accel)
 
 		m_ir->GetState(&xx, &yy, &zz, true);
 		UDPTLayer::GetIR(m_udp, &xx, &yy, &zz);
+	}
+
+	// Fill report with valid data when full handshake was done
+	if (!m_reg_ir.data[0x30])
+		return;
+
+	const unsigned int ir_size = (m_reg_ir.mode == 1) ? 10 : (m_reg_ir.mode == 3) ? 12 : 0;
+
+	// Nothing moved since the last report, the section comes out the same
+	IRCache& cache = m_ir_cache;
+	if (cache.valid && cache.focus == has_focus && cache.mode == m_reg_ir.mode &&
+	    (!has_focus || (cache.x == xx && cache.y == yy && cache.z == zz &&
+	                    cache.sin == ir_sin && cache.cos == ir_cos)))
+	{
+		memcpy(data, cache.data, ir_size);
+		return;
+	}
+
+	u16 x[4], y[4];
+	memset(x, 0xFF, sizeof(x));
 
+	if (has_focus)
+	{
 		Vertex v[4];
 
 		static const int camWidth=1024;
@@ -517,6 +540,7 @@ void Wiimote::GetIRData(u8* const data, bool use_accel)
 		{
 			MatrixScale(scale,1,camWidth/camHeight,1);
 			//MatrixIdentity(scale);
+			isscale=true;
 		}
 		MatrixRotationByZ(rot,ir_sin,ir_cos);
 		//MatrixIdentity(rot);
@@ -534,8 +558,6 @@ void Wiimote::GetIRData(u8* const data, bool use_accel)
 	//		v[0].x,v[0].y,v[1].x,v[1].y,v[2].x,v[2].y,v[3].x,v[3].y,
 	//		x[0],y[0],x[1],y[1],x[2],y[2],x[3],y[38]);
 	}
-	// Fill report with valid data when full handshake was done
-	if (m_reg_ir.data[0x30])
 	// ir mode
 	switch (m_reg_ir.mode)
 	{
@@ -589,6 +611,16 @@ void Wiimote::GetIRData(u8* const data, bool use_accel)
 		// UNSUPPORTED
 		break;
 	}
+
+	cache.valid = true;
+	cache.focus = has_focus;
+	cache.mode = m_reg_ir.mode;
+	cache.x = xx;
+	cache.y = yy;
+	cache.z = zz;
+	cache.sin = ir_sin;
+	cache.cos = ir_cos;
+	memcpy(cache.data, data, ir_size);
 }
 
 void Wiimote::GetExtData(u8* const data)
@@ -179,6 +179,18 @@ private:
 
 	double ir_sin, ir_cos; //for the low pass filter
 
+	// The last IR section and what it was made from, it only changes when
+	// the pointer moves or the filtered tilt does
+	struct IRCache
+	{
+		bool valid;
+		bool focus;
+		u8 mode;
+		float x, y, z;
+		double sin, cos;
+		u8 data[12];
+	} m_ir_cache;
+
 	UDPWrapper* m_udp;
 
 	bool m_rumble_on;
@@ -15,6 +15,12 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/hci.h>
 #include <bluetooth/hci_lib.h>
@@ -133,26 +139,234 @@ void WiimoteScanner::FindWiimotes(std::vector<Wiimote*> & found_wiimotes, Wiimot
 
 }
 
-void Wiimote::InitInternal()
+// Every connected Wiimote is read and written by this one thread, which
+// poll()s all of their interrupt sockets, instead of one thread each
+class IOThread
 {
-	cmd_sock = -1;
-	int_sock = -1;
+public:
+	IOThread()
+		: m_run(false)
+	{
+		if (pipe(m_wakeup_pipe))
+		{
+			ERROR_LOG(WIIMOTE, "pipe failed");
+			abort();
+		}
+		fcntl(m_wakeup_pipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(m_wakeup_pipe[1], F_SETFL, O_NONBLOCK);
+	}
+
+	~IOThread()
+	{
+		Stop();
+		close(m_wakeup_pipe[0]);
+		close(m_wakeup_pipe[1]);
+	}
 
-	int fds[2];
-	if (pipe(fds))
+	void Add(Wiimote* wm)
 	{
-		ERROR_LOG(WIIMOTE, "pipe failed");
-		abort();
+		std::lock_guard<std::mutex> control_lk(m_control_lock);
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			m_wiimotes.push_back(wm);
+		}
+
+		if (!m_run)
+		{
+			m_run = true;
+			m_thread = std::thread(&IOThread::ThreadFunc, this);
+		}
+		Wakeup();
+	}
+
+	// Once this returns the thread doesn't touch the Wiimote anymore
+	void Remove(Wiimote* wm)
+	{
+		std::lock_guard<std::mutex> control_lk(m_control_lock);
+		bool empty;
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			m_wiimotes.erase(std::remove(m_wiimotes.begin(), m_wiimotes.end(), wm), m_wiimotes.end());
+			empty = m_wiimotes.empty();
+		}
+
+		if (empty)
+			Stop();
+		else
+			Wakeup();
+	}
+
+	void Wakeup()
+	{
+		// A full pipe already wakes the thread up
+		char c = 0;
+		if (write(m_wakeup_pipe[1], &c, 1) != 1 && errno != EAGAIN)
+			ERROR_LOG(WIIMOTE, "Unable to write to wakeup pipe.");
+	}
+
+private:
+	void Stop()
+	{
+		if (!m_thread.joinable())
+			return;
+
+		m_run = false;
+		Wakeup();
+		m_thread.join();
+	}
+
+	void ThreadFunc()
+	{
+		Common::SetCurrentThreadName("Wiimote I/O Thread");
+
+		std::vector<pollfd> fds;
+		std::vector<Wiimote*> polled;
+		int timeout = -1;
+
+		while (m_run)
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_lock);
+
+				fds.resize(1);
+				fds[0].fd = m_wakeup_pipe[0];
+				fds[0].events = POLLIN;
+				polled.clear();
+				for (Wiimote* wm : m_wiimotes)
+				{
+					if (!wm->IsConnected())
+						continue;
+					pollfd fd = { wm->int_sock, POLLIN, 0 };
+					fds.push_back(fd);
+					polled.push_back(wm);
+				}
+			}
+
+			// Pending writes and rumbles are retried every ms, the rest waits
+			// for a report or a wakeup
+			if (poll(fds.data(), fds.size(), timeout) == -1 && errno != EINTR)
+			{
+				ERROR_LOG(WIIMOTE, "Unable to poll the Wiimote sockets.");
+				Common::SleepCurrentThread(10);
+			}
+
+			if (fds[0].revents & POLLIN)
+			{
+				char buf[16];
+				while (read(m_wakeup_pipe[0], buf, sizeof(buf)) > 0)
+				{}
+			}
+
+			std::lock_guard<std::mutex> lk(m_lock);
+
+			timeout = -1;
+			for (size_t i = 0; i != polled.size(); ++i)
+			{
+				// Wiimotes removed while polling are gone, their socket might
+				// even be reused by now
+				Wiimote* const wm = polled[i];
+				if (std::find(m_wiimotes.begin(), m_wiimotes.end(), wm) == m_wiimotes.end() ||
+				    wm->int_sock != fds[i + 1].fd)
+					continue;
+
+				if (wm->ServiceIO(fds[i + 1].revents != 0))
+					timeout = 1;
+			}
+
+			// Newly added Wiimotes get their first turn without waiting
+			for (Wiimote* wm : m_wiimotes)
+			{
+				if (wm->IsConnected() && std::find(polled.begin(), polled.end(), wm) == polled.end())
+					timeout = 0;
+			}
+		}
 	}
-	wakeup_pipe_w = fds[1];
-	wakeup_pipe_r = fds[0];
+
+	std::thread m_thread;
+	volatile bool m_run;
+	int m_wakeup_pipe[2];
+
+	// m_lock guards the list and is held while the Wiimotes are served,
+	// m_control_lock keeps Add and Remove from starting and stopping the
+	// thread at the same time
+	std::mutex m_lock;
+	std::mutex m_control_lock;
+	std::vector<Wiimote*> m_wiimotes;
+};
+
+static IOThread s_io_thread;
+
+void Wiimote::InitInternal()
+{
+	cmd_sock = -1;
+	int_sock = -1;
+	prepare_rumble_end = 0;
+	prepare_rumble = false;
 	bdaddr = (bdaddr_t){{0, 0, 0, 0, 0, 0}};
 }
 
 void Wiimote::TeardownInternal()
 {
-	close(wakeup_pipe_w);
-	close(wakeup_pipe_r);
+}
+
+bool Wiimote::Connect()
+{
+	if (!ConnectInternal())
+		return false;
+
+	s_io_thread.Add(this);
+	return true;
+}
+
+void Wiimote::StartThread()
+{
+	s_io_thread.Add(this);
+}
+
+void Wiimote::StopThread()
+{
+	s_io_thread.Remove(this);
+	DisconnectInternal();
+}
+
+bool Wiimote::ServiceIO(bool readable)
+{
+	if (m_need_prepare)
+	{
+		m_need_prepare = false;
+		if (!StartPrepare())
+		{
+			ERROR_LOG(WIIMOTE, "Wiimote::PrepareOnThread failed.  Disconnecting Wiimote %d.", index + 1);
+			DisconnectInternal();
+			return false;
+		}
+		prepare_rumble_end = Common::Timer::GetTimeMs() + 200;
+		prepare_rumble = true;
+	}
+
+	if (prepare_rumble && (s32)(Common::Timer::GetTimeMs() - prepare_rumble_end) >= 0)
+	{
+		prepare_rumble = false;
+		if (!FinishPrepare())
+		{
+			ERROR_LOG(WIIMOTE, "Wiimote::PrepareOnThread failed.  Disconnecting Wiimote %d.", index + 1);
+			DisconnectInternal();
+			return false;
+		}
+	}
+
+	while (Write())
+	{}
+
+	// Read everything that is there, ProcessReadQueue only keeps the
+	// newest data report of it
+	if (readable)
+	{
+		while (IsConnected() && Read())
+		{}
+	}
+
+	return IsConnected() && (prepare_rumble || !m_write_reports.Empty());
 }
 
 // Connect to a wiimote with a known address.
@@ -186,6 +400,9 @@ bool Wiimote::ConnectInternal()
 		return false;
 	}
 
+	// The I/O thread reads until the socket is empty
+	fcntl(int_sock, F_SETFL, fcntl(int_sock, F_GETFL) | O_NONBLOCK);
+
 	return true;
 }
 
@@ -205,11 +422,7 @@ bool Wiimote::IsConnected() const
 
 void Wiimote::IOWakeup()
 {
-	char c = 0;
-	if (write(wakeup_pipe_w, &c, 1) != 1)
-	{
-		ERROR_LOG(WIIMOTE, "Unable to write to wakeup pipe.");
-	}
+	s_io_thread.Wakeup();
 }
 
 // positive = read packet
@@ -217,36 +430,13 @@ void Wiimote::IOWakeup()
 // zero = error
 int Wiimote::IORead(u8* buf)
 {
-	// Block select for 1/2000th of a second
-
-	fd_set fds;
-	FD_ZERO(&fds);
-	FD_SET(int_sock, &fds);
-	FD_SET(wakeup_pipe_r, &fds);
-
-	if (select(int_sock + 1, &fds, NULL, NULL, NULL) == -1)
-	{
-		ERROR_LOG(WIIMOTE, "Unable to select wiimote %i input socket.", index + 1);
-		return -1;
-	}
-
-	if (FD_ISSET(wakeup_pipe_r, &fds))
-	{
-		char c;
-		if (read(wakeup_pipe_r, &c, 1) != 1)
-		{
-			ERROR_LOG(WIIMOTE, "Unable to read from wakeup pipe.");
-		}
-		return -1;
-	}
-
-	if (!FD_ISSET(int_sock, &fds))
-		return -1;
-
 	// Read the pending message into the buffer
 	int r = read(int_sock, buf, MAX_PAYLOAD);
 	if (r == -1)
 	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return -1;
+
 		// Error reading data
 		ERROR_LOG(WIIMOTE, "Receiving data from wiimote %i.", index + 1);
 
@@ -9,6 +9,7 @@
 #include "Common.h"
 #include "IniFile.h"
 #include "StringUtil.h"
+#include "ThreadPlacement.h"
 #include "Timer.h"
 #include "Host.h"
 #include "ConfigManager.h"
@@ -305,16 +306,28 @@ void Wiimote::Prepare(int _index)
 {
 	index = _index;
 	m_need_prepare = true;
+	IOWakeup();
 }
 
 bool Wiimote::PrepareOnThread()
+{
+	return StartPrepare() && (SLEEP(200), FinishPrepare());
+}
+
+bool Wiimote::StartPrepare()
 {
 	// core buttons, no continuous reporting
 	u8 static const mode_report[] = {WM_SET_REPORT | WM_BT_OUTPUT, WM_REPORT_MODE, 0, WM_REPORT_CORE};
 
 	// Set the active LEDs and turn on rumble.
-	u8 static const led_report[] = {WM_SET_REPORT | WM_BT_OUTPUT, WM_LEDS, u8(WIIMOTE_LED_1 << (index%WIIMOTE_BALANCE_BOARD) | 0x1)};
+	u8 const led_report[] = {WM_SET_REPORT | WM_BT_OUTPUT, WM_LEDS, u8(WIIMOTE_LED_1 << (index%WIIMOTE_BALANCE_BOARD) | 0x1)};
 
+	return IOWrite(mode_report, sizeof(mode_report))
+	       && IOWrite(led_report, sizeof(led_report));
+}
+
+bool Wiimote::FinishPrepare()
+{
 	// Turn off rumble
 	u8 static const rumble_report[] = {WM_SET_REPORT | WM_BT_OUTPUT, WM_RUMBLE, 0};
 
@@ -322,10 +335,8 @@ bool Wiimote::PrepareOnThread()
 	u8 static const req_status_report[] = {WM_SET_REPORT | WM_BT_OUTPUT, WM_REQUEST_STATUS, 0};
 	// TODO: check for sane response?
 
-	return (IOWrite(mode_report, sizeof(mode_report))
-	        && IOWrite(led_report, sizeof(led_report))
-	        && (SLEEP(200), IOWrite(rumble_report, sizeof(rumble_report)))
-	        && IOWrite(req_status_report, sizeof(req_status_report)));
+	return IOWrite(rumble_report, sizeof(rumble_report))
+	       && IOWrite(req_status_report, sizeof(req_status_report));
 }
 
 void Wiimote::EmuStart()
@@ -477,6 +488,8 @@ void WiimoteScanner::ThreadFunc()
 	NOTICE_LOG(WIIMOTE, "Wiimote scanning has stopped.");
 }
 
+// BlueZ Wiimotes share an I/O thread instead, see IONix.cpp
+#if !(defined(__linux__) && HAVE_BLUEZ)
 bool Wiimote::Connect()
 {
 	m_thread_ready = false;
@@ -525,6 +538,7 @@ void Wiimote::WaitReady()
 void Wiimote::ThreadFunc()
 {
 	Common::SetCurrentThreadName("Wiimote Device Thread");
+	Common::ThreadPlacement::PlaceCurrentThread(Common::ThreadPlacement::ROLE_HELPER);
 
 	bool ok = ConnectInternal();
 
@@ -553,6 +567,7 @@ void Wiimote::ThreadFunc()
 
 	DisconnectInternal();
 }
+#endif
 
 void LoadSettings()
 {
@@ -85,7 +85,14 @@ public:
 	bdaddr_t bdaddr;                    // Bluetooth address
 	int cmd_sock;                       // Command socket
 	int int_sock;                       // Interrupt socket
-	int wakeup_pipe_w, wakeup_pipe_r;
+	// All Wiimotes share one I/O thread, which can't sleep through the
+	// rumble of PrepareOnThread and stops it at this time instead
+	u32 prepare_rumble_end;
+	bool prepare_rumble;
+
+	// Called from the I/O thread, true while it has to come back before
+	// the socket becomes readable
+	bool ServiceIO(bool readable);
 
 #elif defined(_WIN32)
 	std::basic_string<TCHAR> devicepath; // Unique wiimote reference
@@ -111,6 +118,9 @@ private:
 	void SetReady();
 	void WaitReady();
 
+	bool StartPrepare();
+	bool FinishPrepare();
+
 	bool m_rumble_state;
 
 	std::thread               m_wiimote_thread;
@@ -20,6 +20,7 @@ in case of success they are
 They will also generate a true or false return for UpdateInterrupts() in WII_IPC.cpp.
 */
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <list>
@@ -60,6 +61,8 @@ namespace WII_IPC_HLE_Interface
 
 typedef std::map<u32, IWII_IPC_HLE_Device*> TDeviceMap;
 TDeviceMap g_DeviceMap;
+// The same devices by name, the first one for names used more than once
+static std::map<std::string, IWII_IPC_HLE_Device*> s_DeviceNames;
 
 // STATE_TO_SAVE
 typedef std::map<u32, std::string> TFileNameMap;
@@ -75,6 +78,9 @@ typedef std::deque<u32> ipc_msg_queue;
 static ipc_msg_queue request_queue;	// ppc -> arm
 static ipc_msg_queue reply_queue;	// arm -> ppc
 static std::mutex s_reply_queue;
+// Replies that aren't due yet with the tick they're due at, earliest first.
+// Only one event is scheduled for all of them, for the earliest.
+static std::deque<std::pair<u64, u32>> pending_replies;
 
 static int enque_reply;
 
@@ -86,6 +92,22 @@ void EnqueReplyCallback(u64 userdata, int)
 	reply_queue.push_back((u32)userdata);
 }
 
+static void DeliverRepliesCallback(u64 userdata, int)
+{
+	const u64 now = CoreTiming::GetTicks();
+	{
+		std::lock_guard<std::mutex> lk(s_reply_queue);
+		while (!pending_replies.empty() && pending_replies.front().first <= now)
+		{
+			reply_queue.push_back(pending_replies.front().second);
+			pending_replies.pop_front();
+		}
+	}
+
+	if (!pending_replies.empty())
+		CoreTiming::ScheduleEvent((int)(pending_replies.front().first - now), enque_reply);
+}
+
 void Init()
 {
 
@@ -130,7 +152,10 @@ void Init()
 	g_DeviceMap[i] = new CWII_IPC_HLE_Device_stub(i, std::string("/dev/usb/oh1")); i++;
 	g_DeviceMap[i] = new IWII_IPC_HLE_Device(i, std::string("_Unimplemented_Device_")); i++;
 
-	enque_reply = CoreTiming::RegisterEvent("IPCReply", EnqueReplyCallback);
+	for (const auto& entry : g_DeviceMap)
+		s_DeviceNames.insert(std::make_pair(entry.second->GetDeviceName(), entry.second));
+
+	enque_reply = CoreTiming::RegisterEvent("IPCReply", DeliverRepliesCallback);
 }
 
 void Reset(bool _bHard)
@@ -171,6 +196,7 @@ void Reset(bool _bHard)
 	if (_bHard)
 	{
 		g_DeviceMap.erase(g_DeviceMap.begin(), g_DeviceMap.end());
+		s_DeviceNames.clear();
 	}
 	request_queue.clear();
 
@@ -178,6 +204,7 @@ void Reset(bool _bHard)
 	{
 		std::lock_guard<std::mutex> lk(s_reply_queue);
 		reply_queue.clear();
+		pending_replies.clear();
 	}
 	last_reply_time = 0;
 }
@@ -227,23 +254,14 @@ int getFreeDeviceId()
 
 IWII_IPC_HLE_Device* GetDeviceByName(const std::string& _rDeviceName)
 {
-	TDeviceMap::const_iterator itr = g_DeviceMap.begin();
-	while (itr != g_DeviceMap.end())
-	{
-		if (itr->second && itr->second->GetDeviceName() == _rDeviceName)
-			return itr->second;
-		++itr;
-	}
-
-	return NULL;
+	auto itr = s_DeviceNames.find(_rDeviceName);
+	return itr != s_DeviceNames.end() ? itr->second : NULL;
 }
 
 IWII_IPC_HLE_Device* AccessDeviceByID(u32 _ID)
 {
-	if (g_DeviceMap.find(_ID) != g_DeviceMap.end())
-		return g_DeviceMap[_ID];
-
-		return NULL;
+	auto itr = g_DeviceMap.find(_ID);
+	return itr != g_DeviceMap.end() ? itr->second : NULL;
 }
 
 // This is called from ExecuteCommand() COMMAND_OPEN_DEVICE
@@ -265,6 +283,7 @@ void DoState(PointerWrap &p)
 
 	p.Do(request_queue);
 	p.Do(reply_queue);
+	p.Do(pending_replies);
 	p.Do(last_reply_time);
 
 	TDeviceMap::const_iterator itr;
@@ -566,7 +585,18 @@ void EnqRequest(u32 _Address)
 // Called when IOS module has some reply
 void EnqReply(u32 _Address, int cycles_in_future)
 {
-	CoreTiming::ScheduleEvent(cycles_in_future, enque_reply, _Address);
+	const u64 due = CoreTiming::GetTicks() + cycles_in_future;
+	auto it = std::upper_bound(pending_replies.begin(), pending_replies.end(), due,
+		[](u64 ticks, const std::pair<u64, u32>& reply) { return ticks < reply.first; });
+	const bool earliest = it == pending_replies.begin();
+	pending_replies.insert(it, std::make_pair(due, _Address));
+
+	// The event for the reply that was first until now would be too late
+	if (earliest)
+	{
+		CoreTiming::RemoveEvent(enque_reply);
+		CoreTiming::ScheduleEvent(cycles_in_future, enque_reply);
+	}
 }
 
 // This is called every IPC_HLE_PERIOD from SystemTimers.cpp
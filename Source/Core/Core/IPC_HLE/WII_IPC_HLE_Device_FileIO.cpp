@@ -10,7 +10,14 @@
 #include "WII_IPC_HLE_Device_fs.h"
 #include "WII_IPC_HLE_Device_FileIO.h"
 #include "NandPaths.h"
+#include "Thread.h"
+#include "../ConfigManager.h"
+#include "../HW/SystemTimers.h"
+
 #include <algorithm>
+#include <deque>
+#include <set>
+#include <vector>
 
 
 static Common::replace_v replacements;
@@ -65,21 +72,118 @@ void HLE_IPC_CreateVirtualFATFilesystem()
 	}
 }
 
+// Rough NAND speeds, including what IOS spends on the file system
+static const u32 NAND_READ_BYTES_PER_SECOND = 4 * 1024 * 1024;
+static const u32 NAND_WRITE_BYTES_PER_SECOND = 2 * 1024 * 1024;
+static const u32 NAND_COMMANDS_PER_SECOND = 4000;
+
+// Writes are copied and done by the writer thread, the device only waits
+// for them when it reads, closes or gets released
+struct FileIOWrite
+{
+	CWII_IPC_HLE_Device_FileIO* device;
+	u32 offset;
+	std::vector<u8> data;
+};
+
+static std::thread s_writer_thread;
+static std::mutex s_writer_lock;
+static std::condition_variable s_writer_cond;
+static std::condition_variable s_writer_done_cond;
+static std::deque<FileIOWrite> s_writes;
+static bool s_writer_stop = false;
+static std::set<CWII_IPC_HLE_Device_FileIO*> s_devices;
+
+void CWII_IPC_HLE_Device_FileIO::WriterThread()
+{
+	Common::SetCurrentThreadName("NAND writer");
+
+	std::unique_lock<std::mutex> lk(s_writer_lock);
+	while (true)
+	{
+		s_writer_cond.wait(lk, []{ return s_writer_stop || !s_writes.empty(); });
+		if (s_writes.empty())
+			break;
+
+		FileIOWrite& write = s_writes.front();
+		CWII_IPC_HLE_Device_FileIO* const device = write.device;
+		lk.unlock();
+
+		// Flushed right away so other handles of the file see it
+		File::IOFile& file = device->m_file;
+		file.Clear();
+		file.Seek(write.offset, SEEK_SET);
+		if (!file.WriteBytes(write.data.data(), write.data.size()) || !file.Flush())
+			ERROR_LOG(WII_IPC_FILEIO, "FileIO: Failed to write 0x%x bytes to %s", (u32)write.data.size(), device->m_filepath.c_str());
+
+		lk.lock();
+		s_writes.pop_front();
+		device->m_pending_writes--;
+		s_writer_done_cond.notify_all();
+	}
+}
+
 CWII_IPC_HLE_Device_FileIO::CWII_IPC_HLE_Device_FileIO(u32 _DeviceID, const std::string& _rDeviceName)
 	: IWII_IPC_HLE_Device(_DeviceID, _rDeviceName, false)	// not a real hardware
 	, m_Mode(0)
 	, m_SeekPos(0)
+	, m_file_size(0)
+	, m_pending_writes(0)
+	, m_reply_delay(0)
 {
 	Common::ReadReplacements(replacements);
+
+	std::lock_guard<std::mutex> lk(s_writer_lock);
+	s_devices.insert(this);
 }
 
 CWII_IPC_HLE_Device_FileIO::~CWII_IPC_HLE_Device_FileIO()
 {
+	FinishWrites();
+
+	// The writer thread only runs while there are devices
+	std::thread writer_thread;
+	{
+		std::lock_guard<std::mutex> lk(s_writer_lock);
+		s_devices.erase(this);
+		if (s_devices.empty() && s_writer_thread.joinable())
+		{
+			s_writer_stop = true;
+			s_writer_cond.notify_one();
+			writer_thread = std::move(s_writer_thread);
+		}
+	}
+	if (writer_thread.joinable())
+		writer_thread.join();
+}
+
+void CWII_IPC_HLE_Device_FileIO::FinishWrites()
+{
+	std::unique_lock<std::mutex> lk(s_writer_lock);
+	s_writer_done_cond.wait(lk, [this]{ return m_pending_writes == 0; });
+}
+
+void CWII_IPC_HLE_Device_FileIO::ReleaseFile()
+{
+	FinishWrites();
+	m_file.Close();
+}
+
+void CWII_IPC_HLE_Device_FileIO::ReleaseAllFiles()
+{
+	std::vector<CWII_IPC_HLE_Device_FileIO*> devices;
+	{
+		std::lock_guard<std::mutex> lk(s_writer_lock);
+		devices.assign(s_devices.begin(), s_devices.end());
+	}
+	for (CWII_IPC_HLE_Device_FileIO* device : devices)
+		device->ReleaseFile();
 }
 
 bool CWII_IPC_HLE_Device_FileIO::Close(u32 _CommandAddress, bool _bForce)
 {
 	INFO_LOG(WII_IPC_FILEIO, "FileIO: Close %s (DeviceID=%08x)", m_Name.c_str(), m_DeviceID);
+	ReleaseFile();
 	m_Mode = 0;
 
 	// Close always return 0 for success
@@ -91,6 +195,7 @@ bool CWII_IPC_HLE_Device_FileIO::Close(u32 _CommandAddress, bool _bForce)
 
 bool CWII_IPC_HLE_Device_FileIO::Open(u32 _CommandAddress, u32 _Mode)
 {
+	ReleaseFile();
 	m_Mode = _Mode;
 	u32 ReturnValue = 0;
 
@@ -123,8 +228,21 @@ bool CWII_IPC_HLE_Device_FileIO::Open(u32 _CommandAddress, u32 _Mode)
 	return true;
 }
 
-File::IOFile CWII_IPC_HLE_Device_FileIO::OpenFile()
+bool CWII_IPC_HLE_Device_FileIO::OpenFile()
 {
+	if (m_file.IsOpen())
+	{
+		// Another handle may have changed the size. With writes queued the
+		// file belongs to the writer thread though.
+		std::lock_guard<std::mutex> lk(s_writer_lock);
+		if (m_pending_writes == 0)
+		{
+			m_file_size = (u32)m_file.GetSize();
+			m_file.Clear();
+		}
+		return true;
+	}
+
 	const char* open_mode = "";
 
 	switch (m_Mode)
@@ -143,7 +261,17 @@ File::IOFile CWII_IPC_HLE_Device_FileIO::OpenFile()
 		break;
 	}
 
-	return File::IOFile(m_filepath, open_mode);
+	if (!m_file.Open(m_filepath, open_mode))
+		return false;
+	m_file_size = (u32)m_file.GetSize();
+	return true;
+}
+
+int CWII_IPC_HLE_Device_FileIO::GetCmdDelay(u32)
+{
+	const int delay = m_reply_delay;
+	m_reply_delay = 0;
+	return delay;
 }
 
 bool CWII_IPC_HLE_Device_FileIO::Seek(u32 _CommandAddress)
@@ -152,11 +280,11 @@ bool CWII_IPC_HLE_Device_FileIO::Seek(u32 _CommandAddress)
 	const s32 SeekPosition = Memory::Read_U32(_CommandAddress + 0xC);
 	const s32 Mode = Memory::Read_U32(_CommandAddress + 0x10);
 
-	if (auto file = OpenFile())
+	if (OpenFile())
 	{
 		ReturnValue = FS_RESULT_FATAL;
 
-		const s32 fileSize = (s32) file.GetSize();
+		const s32 fileSize = (s32) m_file_size;
 		INFO_LOG(WII_IPC_FILEIO, "FileIO: Seek Pos: 0x%08x, Mode: %i (%s, Length=0x%08x)", SeekPosition, Mode, m_Name.c_str(), fileSize);
 
 		switch (Mode)
@@ -213,8 +341,10 @@ bool CWII_IPC_HLE_Device_FileIO::Read(u32 _CommandAddress)
 	const u32 Address	= Memory::Read_U32(_CommandAddress + 0xC); // Read to this memory address
 	const u32 Size	= Memory::Read_U32(_CommandAddress + 0x10);
 
+	// The data the writer thread hasn't written yet has to be read back
+	FinishWrites();
 
-	if (auto file = OpenFile())
+	if (OpenFile())
 	{
 		if (m_Mode == ISFS_OPEN_WRITE)
 		{
@@ -223,9 +353,9 @@ bool CWII_IPC_HLE_Device_FileIO::Read(u32 _CommandAddress)
 		else
 		{
 			INFO_LOG(WII_IPC_FILEIO, "FileIO: Read 0x%x bytes to 0x%08x from %s", Size, Address, m_Name.c_str());
-			file.Seek(m_SeekPos, SEEK_SET);
-			ReturnValue = (u32)fread(Memory::GetPointer(Address), 1, Size, file.GetHandle());
-			if (ReturnValue != Size && ferror(file.GetHandle()))
+			m_file.Seek(m_SeekPos, SEEK_SET);
+			ReturnValue = (u32)fread(Memory::GetPointer(Address), 1, Size, m_file.GetHandle());
+			if (ReturnValue != Size && ferror(m_file.GetHandle()))
 			{
 				ReturnValue = FS_EACCESS;
 			}
@@ -234,6 +364,11 @@ bool CWII_IPC_HLE_Device_FileIO::Read(u32 _CommandAddress)
 				m_SeekPos += Size;
 			}
 
+			if (SConfig::GetInstance().m_LocalCoreStartupParameter.bNANDTiming)
+			{
+				m_reply_delay = (int)(SystemTimers::GetTicksPerSecond() / NAND_COMMANDS_PER_SECOND +
+					(u64)SystemTimers::GetTicksPerSecond() * Size / NAND_READ_BYTES_PER_SECOND);
+			}
 		}
 	}
 	else
@@ -253,7 +388,7 @@ bool CWII_IPC_HLE_Device_FileIO::Write(u32 _CommandAddress)
 	const u32 Size	= Memory::Read_U32(_CommandAddress + 0x10);
 
 
-	if (auto file = OpenFile())
+	if (OpenFile())
 	{
 		if (m_Mode == ISFS_OPEN_READ)
 		{
@@ -262,11 +397,34 @@ bool CWII_IPC_HLE_Device_FileIO::Write(u32 _CommandAddress)
 		else
 		{
 			INFO_LOG(WII_IPC_FILEIO, "FileIO: Write 0x%04x bytes from 0x%08x to %s", Size, Address, m_Name.c_str());
-			file.Seek(m_SeekPos, SEEK_SET);
-			if (file.WriteBytes(Memory::GetPointer(Address), Size))
+
+			// The host write happens in the background, failures only get
+			// logged
+			FileIOWrite write;
+			write.device = this;
+			write.offset = m_SeekPos;
+			const u8* const src = Memory::GetPointer(Address);
+			write.data.assign(src, src + Size);
 			{
-				ReturnValue = Size;
-				m_SeekPos += Size;
+				std::lock_guard<std::mutex> lk(s_writer_lock);
+				if (!s_writer_thread.joinable())
+				{
+					s_writer_stop = false;
+					s_writer_thread = std::thread(WriterThread);
+				}
+				m_pending_writes++;
+				s_writes.push_back(std::move(write));
+				s_writer_cond.notify_one();
+			}
+
+			ReturnValue = Size;
+			m_SeekPos += Size;
+			m_file_size = std::max(m_file_size, m_SeekPos);
+
+			if (SConfig::GetInstance().m_LocalCoreStartupParameter.bNANDTiming)
+			{
+				m_reply_delay = (int)(SystemTimers::GetTicksPerSecond() / NAND_COMMANDS_PER_SECOND +
+					(u64)SystemTimers::GetTicksPerSecond() * Size / NAND_WRITE_BYTES_PER_SECOND);
 			}
 		}
 	}
@@ -293,9 +451,9 @@ bool CWII_IPC_HLE_Device_FileIO::IOCtl(u32 _CommandAddress)
 	{
 	case ISFS_IOCTL_GETFILESTATS:
 		{
-			if (auto file = OpenFile())
+			if (OpenFile())
 			{
-				u32 m_FileLength = (u32)file.GetSize();
+				u32 m_FileLength = m_file_size;
 
 				const u32 BufferOut = Memory::Read_U32(_CommandAddress + 0x18);
 				INFO_LOG(WII_IPC_FILEIO, "  File: %s, Length: %i, Pos: %i", m_Name.c_str(), m_FileLength, m_SeekPos);
@@ -325,6 +483,9 @@ bool CWII_IPC_HLE_Device_FileIO::IOCtl(u32 _CommandAddress)
 
 void CWII_IPC_HLE_Device_FileIO::DoState(PointerWrap &p)
 {
+	// The NAND files are saved as they are on the host
+	ReleaseFile();
+
 	DoStateShared(p);
 
 	p.Do(m_Mode);
@@ -23,11 +23,21 @@ public:
 	bool Read(u32 _CommandAddress);
 	bool Write(u32 _CommandAddress);
 	bool IOCtl(u32 _CommandAddress);
+	int GetCmdDelay(u32 _CommandAddress);
 	void DoState(PointerWrap &p);
 
-	File::IOFile OpenFile();
+	// Writes back and closes the host files all devices keep open, before
+	// /dev/fs deletes or renames files
+	static void ReleaseAllFiles();
 
 private:
+	// The host file stays open until the device is closed or released
+	bool OpenFile();
+	void ReleaseFile();
+	// Waits until the writer thread has written what this device queued
+	void FinishWrites();
+	static void WriterThread();
+
 	enum
 	{
 		ISFS_OPEN_READ  = 1,
@@ -65,4 +75,11 @@ private:
 	u32 m_SeekPos;
 
 	std::string m_filepath;
+
+	File::IOFile m_file;
+	// Size including the queued writes
+	u32 m_file_size;
+	u32 m_pending_writes;
+	int m_reply_delay;
+
 };
@@ -226,7 +226,7 @@ u32 CWII_IPC_HLE_Device_es::OpenTitleContent(u32 CFD, u64 TitleID, u16 Index)
 	Access.m_TitleID = TitleID;
 	Access.m_pFile = NULL;
 
-	if (!pContent->m_pData)
+	if (!pContent->IsInMemory())
 	{
 		std::string Filename = pContent->m_Filename;
 		INFO_LOG(WII_IPC_ES, "ES: load %s", Filename.c_str());
@@ -394,8 +394,6 @@ bool CWII_IPC_HLE_Device_es::IOCtlV(u32 _CommandAddress)
 			}
 			SContentAccess& rContent = itr->second;
 
-			_dbg_assert_(WII_IPC_ES, rContent.m_pContent->m_pData != NULL);
-
 			u8* pDest = Memory::GetPointer(Addr);
 
 			if (rContent.m_Position + Size > rContent.m_pContent->m_Size)
@@ -407,10 +405,11 @@ bool CWII_IPC_HLE_Device_es::IOCtlV(u32 _CommandAddress)
 			{
 				if (pDest)
 				{
-					if (rContent.m_pContent->m_pData)
+					if (rContent.m_pContent->IsInMemory())
 					{
-						u8* pSrc = &rContent.m_pContent->m_pData[rContent.m_Position];
-						memcpy(pDest, pSrc, Size);
+						const u8* pSrc = rContent.m_pContent->GetData();
+						if (pSrc)
+							memcpy(pDest, pSrc + rContent.m_Position, Size);
 					}
 					else
 					{
@@ -913,13 +912,13 @@ bool CWII_IPC_HLE_Device_es::IOCtlV(u32 _CommandAddress)
 				{
 					u32 bootInd = ContentLoader.GetBootIndex();
 					const DiscIO::SNANDContent* pContent = ContentLoader.GetContentByIndex(bootInd);
-					if (pContent)
+					if (pContent && (!pContent->IsInMemory() || pContent->GetData()))
 					{
 						LoadWAD(Common::GetTitleContentPath(TitleID));
 						std::unique_ptr<CDolLoader> pDolLoader;
-						if (pContent->m_pData)
+						if (pContent->IsInMemory())
 						{
-							pDolLoader.reset(new CDolLoader(pContent->m_pData, pContent->m_Size));
+							pDolLoader.reset(new CDolLoader(pContent->GetData(), pContent->m_Size));
 						}
 						else
 						{
@@ -34,6 +34,7 @@ CWII_IPC_HLE_Device_fs::~CWII_IPC_HLE_Device_fs()
 bool CWII_IPC_HLE_Device_fs::Open(u32 _CommandAddress, u32 _Mode)
 {
 	// clear tmp folder
+	CWII_IPC_HLE_Device_FileIO::ReleaseAllFiles();
 	{
 		std::string Path = File::GetUserPath(D_WIIUSER_IDX) + "tmp";
 		File::DeleteDirRecursively(Path);
@@ -168,6 +169,9 @@ bool CWII_IPC_HLE_Device_fs::IOCtlV(u32 _CommandAddress)
 
 	case IOCTLV_GETUSAGE:
 		{
+			// The sizes have to include the writes still queued
+			CWII_IPC_HLE_Device_FileIO::ReleaseAllFiles();
+
 			_dbg_assert_(WII_IPC_FILEIO, CommandBuffer.PayloadBuffer.size() == 2);
 			_dbg_assert_(WII_IPC_FILEIO, CommandBuffer.PayloadBuffer[0].m_Size == 4);
 			_dbg_assert_(WII_IPC_FILEIO, CommandBuffer.PayloadBuffer[1].m_Size == 4);
@@ -255,6 +259,10 @@ bool CWII_IPC_HLE_Device_fs::IOCtl(u32 _CommandAddress)
 
 s32 CWII_IPC_HLE_Device_fs::ExecuteCommand(u32 _Parameter, u32 _BufferIn, u32 _BufferInSize, u32 _BufferOut, u32 _BufferOutSize)
 {
+	// Open files can't be deleted or renamed everywhere
+	if (_Parameter == IOCTL_DELETE_FILE || _Parameter == IOCTL_RENAME_FILE)
+		CWII_IPC_HLE_Device_FileIO::ReleaseAllFiles();
+
 	switch(_Parameter)
 	{
 	case IOCTL_GET_STATS:
@@ -504,6 +512,7 @@ void CWII_IPC_HLE_Device_fs::DoState(PointerWrap& p)
 	// handle /tmp
 
 	std::string Path = File::GetUserPath(D_WIIUSER_IDX) + "tmp";
+	CWII_IPC_HLE_Device_FileIO::ReleaseAllFiles();
 	if (p.GetMode() == PointerWrap::MODE_READ)
 	{
 		File::DeleteDirRecursively(Path);
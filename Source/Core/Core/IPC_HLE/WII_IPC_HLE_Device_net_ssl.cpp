@@ -2,12 +2,80 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <deque>
+
+#include "Atomic.h"
 #include "FileUtil.h"
+#include "Thread.h"
 #include "WII_IPC_HLE_Device_net_ssl.h"
 #include "WII_Socket.h"
 
 WII_SSL CWII_IPC_HLE_Device_net_ssl::_SSL[NET_SSL_MAXINSTANCES];
 
+static std::thread s_ssl_thread;
+static std::mutex s_ssl_lock;
+static std::condition_variable s_ssl_cond;
+static std::condition_variable s_ssl_idle_cond;
+// The front job is the one running
+static std::deque<std::shared_ptr<SSLJob> > s_ssl_jobs;
+static bool s_ssl_thread_stop = false;
+
+void CWII_IPC_HLE_Device_net_ssl::SSLThread()
+{
+	Common::SetCurrentThreadName("SSL thread");
+
+	std::unique_lock<std::mutex> lk(s_ssl_lock);
+	while (true)
+	{
+		s_ssl_cond.wait(lk, []{ return s_ssl_thread_stop || !s_ssl_jobs.empty(); });
+		if (s_ssl_jobs.empty())
+			break;
+
+		std::shared_ptr<SSLJob> job = s_ssl_jobs.front();
+		lk.unlock();
+
+		ssl_context* ctx = &_SSL[job->ssl_id].ctx;
+		switch (job->type)
+		{
+		case IOCTLV_NET_SSL_DOHANDSHAKE:
+			job->result = ssl_handshake(ctx);
+			break;
+		case IOCTLV_NET_SSL_WRITE:
+			job->result = ssl_write(ctx, job->data.empty() ? NULL : &job->data[0], job->data.size());
+			break;
+		case IOCTLV_NET_SSL_READ:
+			job->result = ssl_read(ctx, job->data.empty() ? NULL : &job->data[0], job->data.size());
+			break;
+		default:
+			break;
+		}
+		Common::AtomicStoreRelease(job->done, true);
+
+		lk.lock();
+		s_ssl_jobs.pop_front();
+		if (s_ssl_jobs.empty())
+			s_ssl_idle_cond.notify_all();
+	}
+}
+
+void CWII_IPC_HLE_Device_net_ssl::QueueJob(const std::shared_ptr<SSLJob>& job)
+{
+	std::lock_guard<std::mutex> lk(s_ssl_lock);
+	if (!s_ssl_thread.joinable())
+	{
+		s_ssl_thread_stop = false;
+		s_ssl_thread = std::thread(SSLThread);
+	}
+	s_ssl_jobs.push_back(job);
+	s_ssl_cond.notify_one();
+}
+
+void CWII_IPC_HLE_Device_net_ssl::FinishJobs()
+{
+	std::unique_lock<std::mutex> lk(s_ssl_lock);
+	s_ssl_idle_cond.wait(lk, []{ return s_ssl_jobs.empty(); });
+}
+
 CWII_IPC_HLE_Device_net_ssl::CWII_IPC_HLE_Device_net_ssl(u32 _DeviceID, const std::string& _rDeviceName)
 	: IWII_IPC_HLE_Device(_DeviceID, _rDeviceName)
 {
@@ -19,6 +87,17 @@ CWII_IPC_HLE_Device_net_ssl::CWII_IPC_HLE_Device_net_ssl(u32 _DeviceID, const st
 
 CWII_IPC_HLE_Device_net_ssl::~CWII_IPC_HLE_Device_net_ssl()
 {
+	if (s_ssl_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lk(s_ssl_lock);
+			s_ssl_thread_stop = true;
+			s_ssl_cond.notify_one();
+		}
+		// The thread finishes the queued jobs first
+		s_ssl_thread.join();
+	}
+
 	// Cleanup sessions
 	for (int i = 0; i < NET_SSL_MAXINSTANCES; i++)
 	{
@@ -128,6 +207,11 @@ bool CWII_IPC_HLE_Device_net_ssl::IOCtlV(u32 _CommandAddress)
 		BufferOutSize3 = CommandBuffer.PayloadBuffer.at(2).m_Size;
 	}
 
+	if (CommandBuffer.Parameter != IOCTLV_NET_SSL_DOHANDSHAKE &&
+	    CommandBuffer.Parameter != IOCTLV_NET_SSL_WRITE &&
+	    CommandBuffer.Parameter != IOCTLV_NET_SSL_READ)
+		FinishJobs();
+
 	switch (CommandBuffer.Parameter)
 	{
 	case IOCTLV_NET_SSL_NEW:
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "WII_IPC_HLE_Device.h"
 
 #include <polarssl/net.h>
@@ -66,6 +69,19 @@ typedef struct
 	bool active;
 } WII_SSL;
 
+// A handshake, read or write for the SSL thread. WiiSocket copies the guest
+// buffers in and out on the CPU thread, the SSL thread only uses the context.
+struct SSLJob
+{
+	int ssl_id;
+	SSL_IOCTL type;
+	std::vector<u8> data;
+	int result;
+	volatile bool done;
+
+	SSLJob() : ssl_id(0), type(IOCTLV_NET_SSL_DOHANDSHAKE), result(0), done(false) {}
+};
+
 class CWII_IPC_HLE_Device_net_ssl : public IWII_IPC_HLE_Device
 {
 public:
@@ -83,4 +99,14 @@ public:
 	int getSSLFreeID();
 
 	static WII_SSL _SSL[NET_SSL_MAXINSTANCES];
+
+	// Handshakes and record I/O run on the SSL thread in the order they were
+	// queued, so they don't hold up the CPU thread
+	static void QueueJob(const std::shared_ptr<SSLJob>& job);
+	// Waits for the queued jobs, anything else that uses a context calls it
+	// first
+	static void FinishJobs();
+
+private:
+	static void SSLThread();
 };
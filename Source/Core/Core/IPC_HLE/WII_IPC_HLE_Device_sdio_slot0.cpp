@@ -2,6 +2,10 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include "Common.h"
 #include "../ConfigManager.h"
 
@@ -12,21 +16,36 @@
 
 #include "../HW/CPU.h"
 #include "../HW/Memmap.h"
+#include "../HW/SystemTimers.h"
 #include "../Core.h"
 
+// About what a Wii gets out of a class 4 card, only used with bNANDTiming
+static const u32 SD_READ_BYTES_PER_SECOND = 8 * 1024 * 1024;
+static const u32 SD_WRITE_BYTES_PER_SECOND = 4 * 1024 * 1024;
+static const u32 SD_COMMANDS_PER_SECOND = 2000;
+
 CWII_IPC_HLE_Device_sdio_slot0::CWII_IPC_HLE_Device_sdio_slot0(u32 _DeviceID, const std::string& _rDeviceName)
 	: IWII_IPC_HLE_Device(_DeviceID, _rDeviceName)
 	, m_Status(CARD_NOT_EXIST)
 	, m_BlockLength(0)
 	, m_BusWidth(0)
 	, m_Card(NULL)
+	, m_pCardData(NULL)
+	, m_CardSize(0)
+	, m_reply_delay(0)
 {}
 
+CWII_IPC_HLE_Device_sdio_slot0::~CWII_IPC_HLE_Device_sdio_slot0()
+{
+	CloseInternal();
+}
+
 void CWII_IPC_HLE_Device_sdio_slot0::DoState(PointerWrap& p)
 {
 	DoStateShared(p);
 	if (p.GetMode() == PointerWrap::MODE_READ)
 	{
+		CloseInternal();
 		OpenInternal();
 	}
 	p.Do(m_Status);
@@ -62,14 +81,52 @@ void CWII_IPC_HLE_Device_sdio_slot0::OpenInternal()
 		if (!m_Card)
 		{
 			ERROR_LOG(WII_IPC_SD, "Could not open SD Card image or create a new one, are you running from a read-only directory?");
+			return;
 		}
 	}
+
+#ifndef _WIN32
+	// Reads are copies out of the page cache and writes are gathered there,
+	// the kernel reads ahead and writes back on its own
+	m_CardSize = m_Card.GetSize();
+	void* data = MAP_FAILED;
+	if (m_CardSize && m_CardSize == (size_t)m_CardSize)
+		data = mmap(NULL, (size_t)m_CardSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(m_Card.GetHandle()), 0);
+	if (data != MAP_FAILED)
+	{
+		m_pCardData = (u8*)data;
+		madvise(m_pCardData, (size_t)m_CardSize, MADV_SEQUENTIAL);
+	}
+	else
+	{
+		WARN_LOG(WII_IPC_SD, "Couldn't map the SD Card image, reading it directly");
+	}
+#endif
+}
+
+void CWII_IPC_HLE_Device_sdio_slot0::CloseInternal()
+{
+#ifndef _WIN32
+	if (m_pCardData)
+		munmap(m_pCardData, (size_t)m_CardSize);
+#endif
+	m_pCardData = NULL;
+	m_CardSize = 0;
+	m_Card.Close();
+}
+
+int CWII_IPC_HLE_Device_sdio_slot0::GetCmdDelay(u32)
+{
+	const int delay = m_reply_delay;
+	m_reply_delay = 0;
+	return delay;
 }
 
 bool CWII_IPC_HLE_Device_sdio_slot0::Open(u32 _CommandAddress, u32 _Mode)
 {
 	INFO_LOG(WII_IPC_SD, "Open");
 
+	CloseInternal();
 	OpenInternal();
 
 	Memory::Write_U32(GetDeviceID(), _CommandAddress + 0x4);
@@ -82,7 +139,7 @@ bool CWII_IPC_HLE_Device_sdio_slot0::Close(u32 _CommandAddress, bool _bForce)
 {
 	INFO_LOG(WII_IPC_SD, "Close");
 
-	m_Card.Close();
+	CloseInternal();
 	m_BlockLength = 0;
 	m_BusWidth = 0;
 
@@ -380,7 +437,27 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 		DEBUG_LOG(WII_IPC_SD, "%sRead %i Block(s) from 0x%08x bsize %i into 0x%08x!",
 			req.isDMA ? "DMA " : "", req.blocks, req.arg, req.bsize, req.addr);
 
-		if (m_Card)
+		if (m_pCardData)
+		{
+			u32 size = req.bsize * req.blocks;
+
+			if ((u64)req.arg + size <= m_CardSize)
+			{
+				Memory::WriteBigEData(m_pCardData + req.arg, req.addr, size);
+#ifndef _WIN32
+				// Streaming reads are mostly followed by the next blocks
+				const u64 next_size = std::min<u64>(size, m_CardSize - req.arg - size);
+				if (next_size)
+					madvise(m_pCardData + ((req.arg + size) & ~0xFFF), (size_t)next_size, MADV_WILLNEED);
+#endif
+			}
+			else
+			{
+				ERROR_LOG(WII_IPC_SD, "Read past the end of the SD Card image at 0x%08x", req.arg);
+				ret = RET_FAIL;
+			}
+		}
+		else if (m_Card)
 		{
 			u32 size = req.bsize * req.blocks;
 
@@ -391,12 +468,8 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 
 			if (m_Card.ReadBytes(buffer, req.bsize * req.blocks))
 			{
-				u32 i;
-				for (i = 0; i < size; ++i)
-				{
-					Memory::Write_U8((u8)buffer[i], req.addr++);
-				}
-				DEBUG_LOG(WII_IPC_SD, "Outbuffer size %i got %i", _rwBufferSize, i);
+				Memory::WriteBigEData(buffer, req.addr, size);
+				DEBUG_LOG(WII_IPC_SD, "Outbuffer size %i got %i", _rwBufferSize, size);
 			}
 			else
 			{
@@ -407,6 +480,12 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 
 			delete[] buffer;
 		}
+
+		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bNANDTiming)
+		{
+			m_reply_delay = (int)(SystemTimers::GetTicksPerSecond() / SD_COMMANDS_PER_SECOND +
+				(u64)SystemTimers::GetTicksPerSecond() * req.bsize * req.blocks / SD_READ_BYTES_PER_SECOND);
+		}
 		}
 		Memory::Write_U32(0x900, _BufferOut);
 		break;
@@ -418,7 +497,21 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 		DEBUG_LOG(WII_IPC_SD, "%sWrite %i Block(s) from 0x%08x bsize %i to offset 0x%08x!",
 			req.isDMA ? "DMA " : "", req.blocks, req.addr, req.bsize, req.arg);
 
-		if (m_Card)
+		if (m_pCardData)
+		{
+			u32 size = req.bsize * req.blocks;
+
+			if ((u64)req.arg + size <= m_CardSize)
+			{
+				Memory::ReadBigEData(m_pCardData + req.arg, req.addr, size);
+			}
+			else
+			{
+				ERROR_LOG(WII_IPC_SD, "Write past the end of the SD Card image at 0x%08x", req.arg);
+				ret = RET_FAIL;
+			}
+		}
+		else if (m_Card)
 		{
 			u32 size = req.bsize * req.blocks;
 
@@ -427,10 +520,7 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 
 			u8* buffer = new u8[size];
 
-			for (u32 i = 0; i < size; ++i)
-			{
-				buffer[i] = Memory::Read_U8(req.addr++);
-			}
+			Memory::ReadBigEData(buffer, req.addr, size);
 
 			if (!m_Card.WriteBytes(buffer, req.bsize * req.blocks))
 			{
@@ -441,6 +531,12 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 
 			delete[] buffer;
 		}
+
+		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bNANDTiming)
+		{
+			m_reply_delay = (int)(SystemTimers::GetTicksPerSecond() / SD_COMMANDS_PER_SECOND +
+				(u64)SystemTimers::GetTicksPerSecond() * req.bsize * req.blocks / SD_WRITE_BYTES_PER_SECOND);
+		}
 		}
 		Memory::Write_U32(0x900, _BufferOut);
 		break;
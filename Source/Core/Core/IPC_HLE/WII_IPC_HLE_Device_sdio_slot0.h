@@ -13,6 +13,7 @@ class CWII_IPC_HLE_Device_sdio_slot0 : public IWII_IPC_HLE_Device
 public:
 
 	CWII_IPC_HLE_Device_sdio_slot0(u32 _DeviceID, const std::string& _rDeviceName);
+	virtual ~CWII_IPC_HLE_Device_sdio_slot0();
 
 	virtual void DoState(PointerWrap& p);
 
@@ -20,6 +21,7 @@ public:
 	bool Close(u32 _CommandAddress, bool _bForce);
 	bool IOCtl(u32 _CommandAddress);
 	bool IOCtlV(u32 _CommandAddress);
+	int GetCmdDelay(u32 _CommandAddress);
 
 	void EventNotify();
 
@@ -118,9 +120,15 @@ private:
 	u32 m_Registers[0x200/4];
 
 	File::IOFile m_Card;
+	// The card image mapped into memory, NULL if that isn't possible and
+	// m_Card is read and written instead
+	u8* m_pCardData;
+	u64 m_CardSize;
+	int m_reply_delay;
 
 	u32 ExecuteCommand(u32 BufferIn, u32 BufferInSize,
 		u32 BufferIn2, u32 BufferInSize2,
 		u32 _BufferOut, u32 BufferOutSize);
 	void OpenInternal();
+	void CloseInternal();
 };
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "Atomic.h"
 #include "WII_Socket.h"
 #include "WII_IPC_HLE.h"
 #include "WII_IPC_HLE_Device.h"
@@ -9,6 +10,15 @@
 #include "NetPlayProto.h"
 #include "Movie.h"
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#elif defined(__APPLE__)
+#include <sys/event.h>
+#include <sys/time.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
 using WII_IPC_HLE_Interface::ECommandType;
 using WII_IPC_HLE_Interface::COMMAND_IOCTL;
 using WII_IPC_HLE_Interface::COMMAND_IOCTLV;
@@ -173,8 +183,16 @@ s32 WiiSocket::_fcntl(u32 cmd, u32 arg)
 	return ret;
 }
 
-void WiiSocket::update(bool read, bool write, bool except)
+void WiiSocket::update()
 {
+	// Events that come in while the SSL thread works on the socket have to
+	// be kept for the next try
+	bool in_flight = false;
+	for (const sockop& op : pending_sockops)
+		in_flight |= op.ssl_job != NULL;
+	if (!in_flight)
+		ready = false;
+
 	auto it = pending_sockops.begin();
 	while (it != pending_sockops.end())
 	{
@@ -305,12 +323,40 @@ void WiiSocket::update(bool read, bool write, bool except)
 				int sslID = Memory::Read_U32(BufferOut) - 1;
 				if (SSLID_VALID(sslID))
 				{
+					// The polarssl calls run on the SSL thread, the guest
+					// buffers are only copied here
+					if (it->ssl_type == IOCTLV_NET_SSL_DOHANDSHAKE ||
+					    it->ssl_type == IOCTLV_NET_SSL_WRITE ||
+					    it->ssl_type == IOCTLV_NET_SSL_READ)
+					{
+						if (!it->ssl_job)
+						{
+							it->ssl_job = std::make_shared<SSLJob>();
+							it->ssl_job->ssl_id = sslID;
+							it->ssl_job->type = it->ssl_type;
+							if (it->ssl_type == IOCTLV_NET_SSL_WRITE)
+							{
+								const u8* src = Memory::GetPointer(BufferOut2);
+								it->ssl_job->data.assign(src, src + BufferOutSize2);
+							}
+							else if (it->ssl_type == IOCTLV_NET_SSL_READ)
+							{
+								it->ssl_job->data.resize(BufferInSize2);
+							}
+							CWII_IPC_HLE_Device_net_ssl::QueueJob(it->ssl_job);
+						}
+						if (!Common::AtomicLoadAcquire(it->ssl_job->done))
+						{
+							++it;
+							continue;
+						}
+					}
+
 					switch(it->ssl_type)
 					{
 					case IOCTLV_NET_SSL_DOHANDSHAKE:
 					{
-
-						int ret = ssl_handshake(&CWII_IPC_HLE_Device_net_ssl::_SSL[sslID].ctx);
+						int ret = it->ssl_job->result;
 						switch (ret)
 						{
 						case 0:
@@ -341,7 +387,7 @@ void WiiSocket::update(bool read, bool write, bool except)
 					}
 					case IOCTLV_NET_SSL_WRITE:
 					{
-						int ret = ssl_write(&CWII_IPC_HLE_Device_net_ssl::_SSL[sslID].ctx, Memory::GetPointer(BufferOut2), BufferOutSize2);
+						int ret = it->ssl_job->result;
 
 #ifdef DEBUG_SSL
 						File::IOFile("ssl_write.bin", "ab").WriteBytes(Memory::GetPointer(BufferOut2), BufferOutSize2);
@@ -374,7 +420,9 @@ void WiiSocket::update(bool read, bool write, bool except)
 					}
 					case IOCTLV_NET_SSL_READ:
 					{
-						int ret = ssl_read(&CWII_IPC_HLE_Device_net_ssl::_SSL[sslID].ctx, Memory::GetPointer(BufferIn2), BufferInSize2);
+						int ret = it->ssl_job->result;
+						if (ret > 0)
+							memcpy(Memory::GetPointer(BufferIn2), &it->ssl_job->data[0], ret);
 #ifdef DEBUG_SSL
 						if (ret > 0)
 						{
@@ -522,9 +570,16 @@ void WiiSocket::update(bool read, bool write, bool except)
 		}
 		else
 		{
+			// A blocking IOCTL starts a new job when it is tried again
+			it->ssl_job.reset();
 			++it;
 		}
 	}
+
+	// Sockets with jobs on the SSL thread are checked on every update
+	waiting = !pending_sockops.empty();
+	for (const sockop& op : pending_sockops)
+		waiting &= op.ssl_job == NULL;
 }
 
 void WiiSocket::doSock(u32 _CommandAddress, NET_IOCTL type)
@@ -532,6 +587,7 @@ void WiiSocket::doSock(u32 _CommandAddress, NET_IOCTL type)
 	sockop so = {_CommandAddress, false};
 	so.net_type = type;
 	pending_sockops.push_back(so);
+	waiting = false;
 }
 
 void WiiSocket::doSock(u32 _CommandAddress, SSL_IOCTL type)
@@ -539,6 +595,7 @@ void WiiSocket::doSock(u32 _CommandAddress, SSL_IOCTL type)
 	sockop so = {_CommandAddress, true};
 	so.ssl_type = type;
 	pending_sockops.push_back(so);
+	waiting = false;
 }
 
 void WiiSockMan::addSocket(s32 fd)
@@ -547,9 +604,37 @@ void WiiSockMan::addSocket(s32 fd)
 	{
 		WiiSocket& sock = WiiSockets[fd];
 		sock.setFd(fd);
+
+		// Edge triggered, so a socket that stays writable isn't reported on
+		// every update. Closing the socket removes it again.
+#if defined(__linux__)
+		if (poll_fd < 0)
+			poll_fd = epoll_create(16);
+		epoll_event ev = {};
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLET;
+		ev.data.fd = fd;
+		if (poll_fd >= 0 && epoll_ctl(poll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+			ERROR_LOG(WII_IPC_NET, "Can't watch socket %d: %s", fd, DecodeError(errno));
+#elif defined(__APPLE__)
+		if (poll_fd < 0)
+			poll_fd = kqueue();
+		struct kevent changes[2];
+		EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, NULL);
+		EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, NULL);
+		if (poll_fd >= 0 && kevent(poll_fd, changes, 2, NULL, 0, NULL) < 0)
+			ERROR_LOG(WII_IPC_NET, "Can't watch socket %d: %s", fd, DecodeError(errno));
+#endif
 	}
 }
 
+WiiSockMan::~WiiSockMan()
+{
+#if defined(__linux__) || defined(__APPLE__)
+	if (poll_fd >= 0)
+		close(poll_fd);
+#endif
+}
+
 s32 WiiSockMan::newSocket(s32 af, s32 type, s32 protocol)
 {
 	if (NetPlay::IsNetPlayRunning()
@@ -572,50 +657,100 @@ s32 WiiSockMan::delSocket(s32 s)
 	return ReturnValue;
 }
 
-void WiiSockMan::Update()
+void WiiSockMan::PollWaitingSockets()
 {
-	s32 nfds = 0;
-	fd_set read_fds, write_fds, except_fds;
-	struct timeval t = {0,0};
-	FD_ZERO(&read_fds);
-	FD_ZERO(&write_fds);
-	FD_ZERO(&except_fds);
-	for (auto& entry : WiiSockets)
+#if defined(__linux__) || defined(__APPLE__)
+	// Without the instance the waiting IOCTLs are simply tried every update
+	if (poll_fd < 0)
 	{
-		WiiSocket& sock = entry.second;
-		if (sock.valid())
+		for (auto& entry : WiiSockets)
+			entry.second.ready = true;
+		return;
+	}
+#endif
+
+#if defined(__linux__)
+	epoll_event events[64];
+	int count;
+	do
+	{
+		count = epoll_wait(poll_fd, events, ArraySize(events), 0);
+		for (int i = 0; i < count; ++i)
 		{
-			FD_SET(sock.fd, &read_fds);
-			FD_SET(sock.fd, &write_fds);
-			FD_SET(sock.fd, &except_fds);
-			nfds = max(nfds, sock.fd+1);
+			auto it = WiiSockets.find(events[i].data.fd);
+			if (it != WiiSockets.end())
+				it->second.ready = true;
 		}
-		else
+	} while (count == (int)ArraySize(events));
+#elif defined(__APPLE__)
+	struct kevent events[64];
+	const struct timespec timeout = {0, 0};
+	int count;
+	do
+	{
+		count = kevent(poll_fd, NULL, 0, events, ArraySize(events), &timeout);
+		for (int i = 0; i < count; ++i)
 		{
-			// Good time to clean up invalid sockets.
-			WiiSockets.erase(sock.fd);
+			auto it = WiiSockets.find((s32)events[i].ident);
+			if (it != WiiSockets.end())
+				it->second.ready = true;
+		}
+	} while (count == (int)ArraySize(events));
+#else
+	std::vector<pollfd_t> fds;
+	for (auto& entry : WiiSockets)
+	{
+		if (entry.second.waiting)
+		{
+			pollfd_t pfd = {entry.second.fd, POLLIN | POLLOUT | POLLPRI, 0};
+			fds.push_back(pfd);
 		}
 	}
-	s32 ret = select(nfds, &read_fds, &write_fds, &except_fds, &t);
-
-	if (ret >= 0)
+	if (poll(fds.data(), (int)fds.size(), 0) > 0)
 	{
-		for (auto& pair : WiiSockets)
+		for (const pollfd_t& pfd : fds)
 		{
-			WiiSocket& sock = pair.second;
-			sock.update(
-				FD_ISSET(sock.fd, &read_fds) != 0,
-				FD_ISSET(sock.fd, &write_fds) != 0,
-				FD_ISSET(sock.fd, &except_fds) != 0
-			);
+			if (pfd.revents)
+				WiiSockets[pfd.fd].ready = true;
 		}
 	}
-	else
+#endif
+}
+
+void WiiSockMan::Update()
+{
+	bool any_waiting = false;
+	bool any_pending = false;
+	for (auto it = WiiSockets.begin(); it != WiiSockets.end();)
 	{
-		for (auto& elem : WiiSockets)
+		WiiSocket& sock = it->second;
+		if (!sock.valid())
+		{
+			// Good time to clean up invalid sockets.
+			it = WiiSockets.erase(it);
+			continue;
+		}
+		if (!sock.pending_sockops.empty())
 		{
-			elem.second.update(false, false, false);
+			any_pending = true;
+			any_waiting |= sock.waiting;
 		}
+		++it;
+	}
+
+	// Sockets without IOCTLs cost nothing here, idle games don't make any
+	// system calls at all
+	if (!any_pending)
+		return;
+
+	if (any_waiting)
+		PollWaitingSockets();
+
+	for (auto& entry : WiiSockets)
+	{
+		WiiSocket& sock = entry.second;
+		if (!sock.pending_sockops.empty() && (!sock.waiting || sock.ready))
+			sock.update();
 	}
 }
 
@@ -44,6 +44,7 @@ typedef struct pollfd pollfd_t;
 #include <stdio.h>
 #include <string>
 #include <list>
+#include <memory>
 
 #include "FileUtil.h"
 #include "WII_IPC_HLE.h"
@@ -169,11 +170,16 @@ class WiiSocket
 			NET_IOCTL net_type;
 			SSL_IOCTL ssl_type;
 		};
+		std::shared_ptr<SSLJob> ssl_job;
 	};
 private:
 	s32 fd;
 	bool nonBlock;
 	std::list<sockop> pending_sockops;
+	// The pending IOCTLs would block, they only get tried again once the
+	// socket is ready
+	bool waiting;
+	bool ready;
 
 	friend class WiiSockMan;
 	void setFd(s32 s);
@@ -182,10 +188,10 @@ private:
 
 	void doSock(u32 _CommandAddress, NET_IOCTL type);
 	void doSock(u32 _CommandAddress, SSL_IOCTL type);
-	void update(bool read, bool write, bool except);
+	void update();
 	bool valid() {return fd >= 0;}
 public:
-	WiiSocket() : fd(-1), nonBlock(false) {}
+	WiiSocket() : fd(-1), nonBlock(false), waiting(false), ready(false) {}
 	~WiiSocket();
 	void operator=(WiiSocket const&);	// Don't implement
 
@@ -210,6 +216,7 @@ public:
 	s32 newSocket(s32 af, s32 type, s32 protocol);
 	void addSocket(s32 fd);
 	s32 delSocket(s32 s);
+	~WiiSockMan();
 	s32 getLastNetError() {return errono_last;}
 	void setLastNetError(s32 error) {errono_last = error;}
 
@@ -235,10 +242,14 @@ public:
 	}
 
 private:
-	WiiSockMan() {};                   // Constructor? (the {} brackets) are needed here.
+	WiiSockMan() : poll_fd(-1) {};     // Constructor? (the {} brackets) are needed here.
 	WiiSockMan(WiiSockMan const&);     // Don't Implement
 	void operator=(WiiSockMan const&); // Don't implement
+	void PollWaitingSockets();
 	std::unordered_map<s32, WiiSocket> WiiSockets;
+	// The epoll or kqueue instance every socket stays registered with, the
+	// other systems poll the waiting sockets on each update
+	int poll_fd;
 
 	s32 errono_last;
 };
@@ -2,13 +2,22 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "Movie.h"
 
+#include "AudioCommon.h"
 #include "Core.h"
 #include "ConfigManager.h"
 #include "Thread.h"
 #include "FileUtil.h"
+#include "Hash.h"
+#include "Host.h"
+#include "StringUtil.h"
 #include "PowerPC/PowerPC.h"
+#include "HW/Memmap.h"
 #include "HW/SI.h"
 #include "HW/Wiimote.h"
 #include "HW/WiimoteEmu/WiimoteEmu.h"
@@ -26,7 +35,8 @@
 #include "NetPlayProto.h"
 
 // The chunk to allocate movie data in multiples of.
-#define DTM_BASE_LENGTH (1024)
+#define DTM_CHUNK_SHIFT (16)
+#define DTM_CHUNK_LENGTH (1 << DTM_CHUNK_SHIFT)
 
 std::mutex cs_frameSkip;
 
@@ -43,15 +53,118 @@ u32 g_framesToSkip = 0, g_frameSkipCounter = 0;
 u8 g_numPads = 0;
 ControllerState g_padState;
 DTMHeader tmpHeader;
-u8* tmpInput = NULL;
-size_t tmpInputAllocated = 0;
+
+// The input is kept in fixed size chunks, so a long recording is never
+// reallocated and copied, and files are read and written a chunk at a time
+// instead of through one more copy of the whole movie.
+class InputBuffer
+{
+public:
+	bool IsEmpty() const { return m_chunks.empty(); }
+
+	void Clear()
+	{
+		m_chunks.clear();
+	}
+
+	void Reserve(u64 size)
+	{
+		while ((u64)m_chunks.size() << DTM_CHUNK_SHIFT < size)
+			m_chunks.emplace_back(new u8[DTM_CHUNK_LENGTH]);
+	}
+
+	void Read(u64 offset, void* data, size_t size) const
+	{
+		u8* dst = (u8*)data;
+		while (size)
+		{
+			const size_t pos = (size_t)(offset & (DTM_CHUNK_LENGTH - 1));
+			const size_t len = std::min<size_t>(size, DTM_CHUNK_LENGTH - pos);
+			memcpy(dst, &m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)][pos], len);
+			dst += len;
+			offset += len;
+			size -= len;
+		}
+	}
+
+	u8 ReadByte(u64 offset) const
+	{
+		return m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)][offset & (DTM_CHUNK_LENGTH - 1)];
+	}
+
+	void Write(u64 offset, const void* data, size_t size)
+	{
+		Reserve(offset + size);
+		const u8* src = (const u8*)data;
+		while (size)
+		{
+			const size_t pos = (size_t)(offset & (DTM_CHUNK_LENGTH - 1));
+			const size_t len = std::min<size_t>(size, DTM_CHUNK_LENGTH - pos);
+			memcpy(&m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)][pos], src, len);
+			src += len;
+			offset += len;
+			size -= len;
+		}
+	}
+
+	bool ReadFromFile(File::IOFile& file, u64 size)
+	{
+		Reserve(size);
+		for (u64 offset = 0; offset < size; offset += DTM_CHUNK_LENGTH)
+		{
+			const size_t len = (size_t)std::min<u64>(size - offset, DTM_CHUNK_LENGTH);
+			if (!file.ReadBytes(m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)].get(), len))
+				return false;
+		}
+		return true;
+	}
+
+	bool WriteToFile(File::IOFile& file, u64 size) const
+	{
+		for (u64 offset = 0; offset < size; offset += DTM_CHUNK_LENGTH)
+		{
+			const size_t len = (size_t)std::min<u64>(size - offset, DTM_CHUNK_LENGTH);
+			if (!file.WriteBytes(m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)].get(), len))
+				return false;
+		}
+		return true;
+	}
+
+	// Returns the offset of the first of the next size bytes of the file that
+	// differs from the buffer, or size if they all match
+	u64 FindMismatch(File::IOFile& file, u64 size) const
+	{
+		std::unique_ptr<u8[]> chunk(new u8[DTM_CHUNK_LENGTH]);
+		for (u64 offset = 0; offset < size; offset += DTM_CHUNK_LENGTH)
+		{
+			const size_t len = (size_t)std::min<u64>(size - offset, DTM_CHUNK_LENGTH);
+			if (!file.ReadBytes(chunk.get(), len))
+				return offset;
+
+			const u8* cur = m_chunks[(size_t)(offset >> DTM_CHUNK_SHIFT)].get();
+			if (memcmp(chunk.get(), cur, len))
+			{
+				size_t i = 0;
+				while (chunk[i] == cur[i])
+					i++;
+				return offset + i;
+			}
+		}
+		return size;
+	}
+
+private:
+	std::vector<std::unique_ptr<u8[]> > m_chunks;
+};
+
+static InputBuffer tmpInput;
 u64 g_currentByte = 0, g_totalBytes = 0;
 u64 g_currentFrame = 0, g_totalFrames = 0; // VI
 u64 g_currentLagCount = 0, g_totalLagCount = 0; // just stats
 u64 g_currentInputCount = 0, g_totalInputCount = 0; // just stats
 u64 g_recordingStartTime; // seconds since 1970 that recording started
 bool bSaveConfig = false, bSkipIdle = false, bDualCore = false, bProgressive = false, bDSPHLE = false, bFastDiscSpeed = false;
-bool bMemcard = false, g_bClearSave = false, bSyncGPU = false, bNetPlay = false;
+bool bMemcard = false, g_bClearSave = false, bSyncGPU = false, bNetPlay = false, bDeterministicDualCore = false;
 std::string videoBackend = "unknown";
 int iCPUCore = 1;
 bool g_bDiscChange = false;
@@ -72,26 +185,12 @@ std::string g_InputDisplay[8];
 
 ManipFunction mfunc = NULL;
 
-void EnsureTmpInputSize(size_t bound)
-{
-	if (tmpInputAllocated >= bound)
-		return;
-	// The buffer expands in powers of two of DTM_BASE_LENGTH
-	// (standard exponential buffer growth).
-	size_t newAlloc = DTM_BASE_LENGTH;
-	while (newAlloc < bound)
-		newAlloc *= 2;
-
-	u8* newTmpInput = new u8[newAlloc];
-	tmpInputAllocated = newAlloc;
-	if (tmpInput != NULL)
-	{
-		if (g_totalBytes > 0)
-			memcpy(newTmpInput, tmpInput, (size_t)g_totalBytes);
-		delete[] tmpInput;
-	}
-	tmpInput = newTmpInput;
-}
+// Verification playback, s_verifyInterval is 0 when it isn't running
+static u32 s_verifyInterval = 0;
+static bool s_verifySkipEFB = false;
+static File::IOFile s_verifyLog;
+
+static void VerifyFrame();
 
 std::string GetInputDisplay()
 {
@@ -140,6 +239,9 @@ void FrameUpdate()
 	if(g_framesToSkip)
 		FrameSkipping();
 
+	if (IsVerifying())
+		VerifyFrame();
+
 	g_bPolled = false;
 }
 
@@ -213,6 +315,59 @@ void SetFrameSkipping(unsigned int framesToSkip)
 		g_video_backend->Video_SetRendering(true);
 }
 
+bool BeginVerification(const std::string& hash_log, u32 present_interval, bool skip_efb)
+{
+	EndVerification();
+
+	if (!s_verifyLog.Open(hash_log, "w"))
+	{
+		PanicAlertT("Failed to open the hash log %s", hash_log.c_str());
+		return false;
+	}
+
+	s_verifyInterval = std::max<u32>(present_interval, 1);
+	s_verifySkipEFB = skip_efb;
+	AudioCommon::UpdateSoundStream();
+	return true;
+}
+
+void EndVerification()
+{
+	if (!IsVerifying())
+		return;
+
+	s_verifyInterval = 0;
+	s_verifyLog.Close();
+	g_video_backend->Video_SetRendering(true);
+	g_video_backend->Video_SetPresenting(true);
+	AudioCommon::UpdateSoundStream();
+}
+
+bool IsVerifying()
+{
+	return s_verifyInterval != 0;
+}
+
+// Logs a hash of RAM for the frame that just ended and picks whether the
+// next one is drawn. The hash is only stable between runs in single core
+// mode, in dual core mode this runs on the GPU thread while the CPU goes on.
+static void VerifyFrame()
+{
+	// Not GetHash64, which depends on the texture hashing setting
+	std::string line = StringFromFormat("%llu %016llx", (unsigned long long)g_currentFrame,
+		(unsigned long long)GetMurmurHash3(Memory::m_pRAM, Memory::REALRAM_SIZE, 0));
+	if (Core::g_CoreStartupParameter.bWii && Memory::m_pEXRAM)
+		line += StringFromFormat(" %016llx", (unsigned long long)GetMurmurHash3(Memory::m_pEXRAM, Memory::EXRAM_SIZE, 0));
+	line += '\n';
+	s_verifyLog.WriteBytes(line.data(), line.size());
+
+	const bool present = (g_currentFrame % s_verifyInterval) == 0;
+	if (s_verifySkipEFB)
+		g_video_backend->Video_SetRendering(present);
+	else
+		g_video_backend->Video_SetPresenting(present);
+}
+
 void SetPolledDevice()
 {
 	g_bPolled = true;
@@ -360,6 +515,11 @@ bool IsSyncGPU()
 	return bSyncGPU;
 }
 
+bool IsDeterministicDualCore()
+{
+	return bDeterministicDualCore;
+}
+
 bool IsNetPlayRecording()
 {
 	return bNetPlay;
@@ -451,7 +611,7 @@ bool BeginRecordingInput(int controllers)
 	}
 	g_playMode = MODE_RECORDING;
 	author = SConfig::GetInstance().m_strMovieAuthor;
-	EnsureTmpInputSize(1);
+	tmpInput.Reserve(1);
 
 	g_currentByte = g_totalBytes = 0;
 
@@ -644,8 +804,7 @@ void RecordInput(SPADStatus *PadStatus, int controllerID)
 		g_bDiscChange = false;
 	}
 
-	EnsureTmpInputSize((size_t)(g_currentByte + 8));
-	memcpy(&(tmpInput[g_currentByte]), &g_padState, 8);
+	tmpInput.Write(g_currentByte, &g_padState, 8);
 	g_currentByte += 8;
 	g_totalBytes = g_currentByte;
 }
@@ -668,9 +827,8 @@ void RecordWiimote(int wiimote, u8 *data, u8 size)
 		return;
 
 	InputUpdate();
-	EnsureTmpInputSize((size_t)(g_currentByte + size + 1));
-	tmpInput[g_currentByte++] = size;
-	memcpy(&(tmpInput[g_currentByte]), data, size);
+	tmpInput.Write(g_currentByte++, &size, 1);
+	tmpInput.Write(g_currentByte, data, size);
 	g_currentByte += size;
 	g_totalBytes = g_currentByte;
 }
@@ -696,6 +854,7 @@ void ReadHeader()
 		bongos = tmpHeader.bongos;
 		bSyncGPU = tmpHeader.bSyncGPU;
 		bNetPlay = tmpHeader.bNetPlay;
+		bDeterministicDualCore = tmpHeader.bDeterministicDualCore;
 		memcpy(revision, tmpHeader.revision, ArraySize(revision));
 	}
 	else
@@ -740,8 +899,7 @@ bool PlayInput(const char *filename)
 	g_playMode = MODE_PLAYING;
 
 	g_totalBytes = g_recordfd.GetSize() - 256;
-	EnsureTmpInputSize((size_t)g_totalBytes);
-	g_recordfd.ReadArray(tmpInput, (size_t)g_totalBytes);
+	tmpInput.ReadFromFile(g_recordfd, g_totalBytes);
 	g_currentByte = 0;
 	g_recordfd.Close();
 
@@ -817,15 +975,14 @@ void LoadInput(const char *filename)
 		afterEnd = true;
 	}
 
-	if (!g_bReadOnly || tmpInput == NULL)
+	if (!g_bReadOnly || tmpInput.IsEmpty())
 	{
 		g_totalFrames = tmpHeader.frameCount;
 		g_totalLagCount = tmpHeader.lagCount;
 		g_totalInputCount = tmpHeader.inputCount;
 
-		EnsureTmpInputSize((size_t)totalSavedBytes);
 		g_totalBytes = totalSavedBytes;
-		t_record.ReadArray(tmpInput, (size_t)g_totalBytes);
+		tmpInput.ReadFromFile(t_record, g_totalBytes);
 	}
 	else if (g_currentByte > 0)
 	{
@@ -839,48 +996,46 @@ void LoadInput(const char *filename)
 		else if(g_currentByte > 0 && g_totalBytes > 0)
 		{
 			// verify identical from movie start to the save's current frame
-			u32 len = (u32)g_currentByte;
-			u8* movInput = new u8[len];
-			t_record.ReadArray(movInput, (size_t)len);
-			for (u32 i = 0; i < len; ++i)
+			const u64 len = g_currentByte;
+			const u64 mismatch = tmpInput.FindMismatch(t_record, len);
+			if (mismatch < len)
 			{
-				if (movInput[i] != tmpInput[i])
+				const u32 i = (u32)mismatch;
+				const u32 frame = i/8;
+				ControllerState curPadState;
+				if (!IsUsingWiimote(0))
+					tmpInput.Read(frame*8, &curPadState, 8);
+
+				// the savestate's movie replaces the current one up to the save
+				t_record.Seek(256, SEEK_SET);
+				tmpInput.ReadFromFile(t_record, len);
+
+				// this is a "you did something wrong" alert for the user's benefit.
+				// we'll try to say what's going on in excruciating detail, otherwise the user might not believe us.
+				if(IsUsingWiimote(0))
 				{
-					// this is a "you did something wrong" alert for the user's benefit.
-					// we'll try to say what's going on in excruciating detail, otherwise the user might not believe us.
-					if(IsUsingWiimote(0))
-					{
-						// TODO: more detail
-						PanicAlertT("Warning: You loaded a save whose movie mismatches on byte %d (0x%X). You should load another save before continuing, or load this state with read-only mode off. Otherwise you'll probably get a desync.", i+256, i+256);
-						memcpy(tmpInput, movInput, g_currentByte);
-					}
-					else
-					{
-						int frame = i/8;
-						ControllerState curPadState;
-						memcpy(&curPadState, &(tmpInput[frame*8]), 8);
-						ControllerState movPadState;
-						memcpy(&movPadState, &(movInput[frame*8]), 8);
-						PanicAlertT("Warning: You loaded a save whose movie mismatches on frame %d. You should load another save before continuing, or load this state with read-only mode off. Otherwise you'll probably get a desync.\n\n"
-							"More information: The current movie is %d frames long and the savestate's movie is %d frames long.\n\n"
-							"On frame %d, the current movie presses:\n"
-							"Start=%d, A=%d, B=%d, X=%d, Y=%d, Z=%d, DUp=%d, DDown=%d, DLeft=%d, DRight=%d, L=%d, R=%d, LT=%d, RT=%d, AnalogX=%d, AnalogY=%d, CX=%d, CY=%d"
-							"\n\n"
-							"On frame %d, the savestate's movie presses:\n"
-							"Start=%d, A=%d, B=%d, X=%d, Y=%d, Z=%d, DUp=%d, DDown=%d, DLeft=%d, DRight=%d, L=%d, R=%d, LT=%d, RT=%d, AnalogX=%d, AnalogY=%d, CX=%d, CY=%d",
-							(int)frame,
-							(int)g_totalFrames, (int)tmpHeader.frameCount,
-							(int)frame,
-							(int)curPadState.Start, (int)curPadState.A, (int)curPadState.B, (int)curPadState.X, (int)curPadState.Y, (int)curPadState.Z, (int)curPadState.DPadUp, (int)curPadState.DPadDown, (int)curPadState.DPadLeft, (int)curPadState.DPadRight, (int)curPadState.L, (int)curPadState.R, (int)curPadState.TriggerL, (int)curPadState.TriggerR, (int)curPadState.AnalogStickX, (int)curPadState.AnalogStickY, (int)curPadState.CStickX, (int)curPadState.CStickY,
-							(int)frame,
-							(int)movPadState.Start, (int)movPadState.A, (int)movPadState.B, (int)movPadState.X, (int)movPadState.Y, (int)movPadState.Z, (int)movPadState.DPadUp, (int)movPadState.DPadDown, (int)movPadState.DPadLeft, (int)movPadState.DPadRight, (int)movPadState.L, (int)movPadState.R, (int)movPadState.TriggerL, (int)movPadState.TriggerR, (int)movPadState.AnalogStickX, (int)movPadState.AnalogStickY, (int)movPadState.CStickX, (int)movPadState.CStickY);
-
-						memcpy(tmpInput, movInput, g_currentByte);
-					}
-					break;
+					// TODO: more detail
+					PanicAlertT("Warning: You loaded a save whose movie mismatches on byte %d (0x%X). You should load another save before continuing, or load this state with read-only mode off. Otherwise you'll probably get a desync.", i+256, i+256);
+				}
+				else
+				{
+					ControllerState movPadState;
+					tmpInput.Read(frame*8, &movPadState, 8);
+					PanicAlertT("Warning: You loaded a save whose movie mismatches on frame %d. You should load another save before continuing, or load this state with read-only mode off. Otherwise you'll probably get a desync.\n\n"
+						"More information: The current movie is %d frames long and the savestate's movie is %d frames long.\n\n"
+						"On frame %d, the current movie presses:\n"
+						"Start=%d, A=%d, B=%d, X=%d, Y=%d, Z=%d, DUp=%d, DDown=%d, DLeft=%d, DRight=%d, L=%d, R=%d, LT=%d, RT=%d, AnalogX=%d, AnalogY=%d, CX=%d, CY=%d"
+						"\n\n"
+						"On frame %d, the savestate's movie presses:\n"
+						"Start=%d, A=%d, B=%d, X=%d, Y=%d, Z=%d, DUp=%d, DDown=%d, DLeft=%d, DRight=%d, L=%d, R=%d, LT=%d, RT=%d, AnalogX=%d, AnalogY=%d, CX=%d, CY=%d",
+						(int)frame,
+						(int)g_totalFrames, (int)tmpHeader.frameCount,
+						(int)frame,
+						(int)curPadState.Start, (int)curPadState.A, (int)curPadState.B, (int)curPadState.X, (int)curPadState.Y, (int)curPadState.Z, (int)curPadState.DPadUp, (int)curPadState.DPadDown, (int)curPadState.DPadLeft, (int)curPadState.DPadRight, (int)curPadState.L, (int)curPadState.R, (int)curPadState.TriggerL, (int)curPadState.TriggerR, (int)curPadState.AnalogStickX, (int)curPadState.AnalogStickY, (int)curPadState.CStickX, (int)curPadState.CStickY,
+						(int)frame,
+						(int)movPadState.Start, (int)movPadState.A, (int)movPadState.B, (int)movPadState.X, (int)movPadState.Y, (int)movPadState.Z, (int)movPadState.DPadUp, (int)movPadState.DPadDown, (int)movPadState.DPadLeft, (int)movPadState.DPadRight, (int)movPadState.L, (int)movPadState.R, (int)movPadState.TriggerL, (int)movPadState.TriggerR, (int)movPadState.AnalogStickX, (int)movPadState.AnalogStickY, (int)movPadState.CStickX, (int)movPadState.CStickY);
 				}
 			}
-			delete [] movInput;
 		}
 	}
 	t_record.Close();
@@ -924,7 +1079,7 @@ void PlayController(SPADStatus *PadStatus, int controllerID)
 {
 	// Correct playback is entirely dependent on the emulator polling the controllers
 	// in the same order done during recording
-	if (!IsPlayingInput() || !IsUsingPad(controllerID) || tmpInput == NULL)
+	if (!IsPlayingInput() || !IsUsingPad(controllerID) || tmpInput.IsEmpty())
 		return;
 
 	if (g_currentByte + 8 > g_totalBytes)
@@ -940,7 +1095,7 @@ void PlayController(SPADStatus *PadStatus, int controllerID)
 	PadStatus->err = e;
 
 
-	memcpy(&g_padState, &(tmpInput[g_currentByte]), 8);
+	tmpInput.Read(g_currentByte, &g_padState, 8);
 	g_currentByte += 8;
 
 	PadStatus->triggerLeft = g_padState.TriggerL;
@@ -1020,7 +1175,7 @@ void PlayController(SPADStatus *PadStatus, int controllerID)
 
 bool PlayWiimote(int wiimote, u8 *data, const WiimoteEmu::ReportFeatures& rptf, int irMode)
 {
-	if(!IsPlayingInput() || !IsUsingWiimote(wiimote) || tmpInput == NULL)
+	if(!IsPlayingInput() || !IsUsingWiimote(wiimote) || tmpInput.IsEmpty())
 		return false;
 
 	if (g_currentByte > g_totalBytes)
@@ -1035,7 +1190,7 @@ bool PlayWiimote(int wiimote, u8 *data, const WiimoteEmu::ReportFeatures& rptf,
 	u8* const irData = rptf.ir?(data+rptf.ir):NULL;
 	u8 size = rptf.size;
 
-	u8 sizeInMovie = tmpInput[g_currentByte];
+	u8 sizeInMovie = tmpInput.ReadByte(g_currentByte);
 
 	if (size != sizeInMovie)
 	{
@@ -1054,7 +1209,7 @@ bool PlayWiimote(int wiimote, u8 *data, const WiimoteEmu::ReportFeatures& rptf,
 		return false;
 	}
 
-	memcpy(data, &(tmpInput[g_currentByte]), size);
+	tmpInput.Read(g_currentByte, data, size);
 	g_currentByte += size;
 
 	SetWiiInputDisplayString(wiimote, coreData, accelData, irData);
@@ -1079,10 +1234,15 @@ void EndPlayInput(bool cont)
 		g_playMode = MODE_NONE;
 		Core::DisplayMessage("Movie End.", 2000);
 		g_bRecordingFromSaveState = false;
+		if (IsVerifying())
+		{
+			// There is nothing left to verify, leave it to batch mode to exit
+			EndVerification();
+			Host_Message(WM_USER_STOP);
+		}
 		// we don't clear these things because otherwise we can't resume playback if we load a movie state later
 		//g_totalFrames = g_totalBytes = 0;
-		//delete tmpInput;
-		//tmpInput = NULL;
+		//tmpInput.Clear();
 	}
 }
 
@@ -1124,6 +1284,7 @@ void SaveRecording(const char *filename)
 	header.bClearSave = g_bClearSave;
 	header.bSyncGPU = bSyncGPU;
 	header.bNetPlay = bNetPlay;
+	header.bDeterministicDualCore = bDeterministicDualCore;
 	strncpy((char *)header.discChange, g_discChange.c_str(),ArraySize(header.discChange));
 	strncpy((char *)header.author, author.c_str(),ArraySize(header.author));
 	memcpy(header.md5,MD5,16);
@@ -1136,7 +1297,7 @@ void SaveRecording(const char *filename)
 
 	save_record.WriteArray(&header, 1);
 
-	bool success = save_record.WriteArray(tmpInput, (size_t)g_totalBytes);
+	bool success = tmpInput.WriteToFile(save_record, g_totalBytes);
 
 	if (success && g_bRecordingFromSaveState)
 	{
@@ -1185,6 +1346,8 @@ void GetSettings()
 	bSyncGPU = SConfig::GetInstance().m_LocalCoreStartupParameter.bSyncGPU;
 	iCPUCore = SConfig::GetInstance().m_LocalCoreStartupParameter.iCPUCore;
 	bNetPlay = NetPlay::IsNetPlayRunning();
+	bDeterministicDualCore = SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread &&
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bDeterministicDualCore;
 	if (!Core::g_CoreStartupParameter.bWii)
 		g_bClearSave = !File::Exists(SConfig::GetInstance().m_strMemoryCardA);
 	bMemcard = SConfig::GetInstance().m_EXIDevice[0] == EXIDEVICE_MEMORYCARD;
@@ -1232,8 +1395,7 @@ void GetMD5()
 void Shutdown()
 {
 	g_currentInputCount = g_totalInputCount = g_totalFrames = g_totalBytes = 0;
-	delete [] tmpInput;
-	tmpInput = NULL;
-	tmpInputAllocated = 0;
+	tmpInput.Clear();
+	EndVerification();
 }
 };
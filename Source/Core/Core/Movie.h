@@ -107,7 +107,8 @@ struct DTMHeader {
 	u8 bongos;
 	bool bSyncGPU;
 	bool bNetPlay;
-	u8 reserved[13];        // Padding for any new config options
+	bool bDeterministicDualCore;
+	u8 reserved[12];        // Padding for any new config options
 	u8 discChange[40];      // Name of iso file to switch to, for two disc games.
 	u8 revision[20];        // Git hash
 	u8 reserved2[27];       // Make heading 256 bytes, just because we can
@@ -140,6 +141,7 @@ int GetCPUMode();
 bool IsStartingFromClearSave();
 bool IsUsingMemcard();
 bool IsSyncGPU();
+bool IsDeterministicDualCore();
 void SetGraphicsConfig();
 void GetSettings();
 bool IsNetPlayRecording();
@@ -157,6 +159,15 @@ void SetReadOnly(bool bEnabled);
 void SetFrameSkipping(unsigned int framesToSkip);
 void FrameSkipping();
 
+// Verification plays a movie back unthrottled and muted, only putting
+// every present_interval-th frame on screen, and logs a hash of RAM for
+// every frame to hash_log so desyncs can be bisected. With skip_efb the
+// skipped frames aren't rendered into the EFB either, which is faster but
+// can change games that read the EFB back.
+bool BeginVerification(const std::string& hash_log, u32 present_interval, bool skip_efb);
+void EndVerification();
+bool IsVerifying();
+
 bool BeginRecordingInput(int controllers);
 void RecordInput(SPADStatus *PadStatus, int controllerID);
 void RecordWiimote(int wiimote, u8 *data, u8 size);
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "NetPlayClient.h"
 
 // for wiimote
@@ -19,7 +21,10 @@
 #include "Core.h"
 #include "ConfigManager.h"
 #include "Movie.h"
+#include "State.h"
 #include "HW/WiimoteEmu/WiimoteEmu.h"
+// for rendering off while rolling back
+#include "VideoBackendBase.h"
 
 std::mutex crit_netplay_client;
 static NetPlayClient * netplay_client = NULL;
@@ -27,6 +32,11 @@ NetSettings g_NetPlaySettings;
 
 #define RPT_SIZE_HACK  (1 << 16)
 
+static const u32 NO_ROLLBACK = 0xFFFFFFFF;
+// Local pads are still sent this many polls ahead in rollback mode, which
+// saves most of the rollbacks on a fast connection
+static const u32 ROLLBACK_INPUT_DELAY = 1;
+
 NetPad::NetPad()
 {
 	nHi = 0x00808080;
@@ -56,13 +66,17 @@ NetPlayClient::~NetPlayClient()
 	{
 		m_do_loop = false;
 		m_thread.join();
+		if (m_udp_thread.joinable())
+			m_udp_thread.join();
 	}
 }
 
 // called from ---GUI--- thread
-NetPlayClient::NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name) : m_dialog(dialog), m_is_running(false), m_do_loop(true)
+NetPlayClient::NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name) : m_dialog(dialog), m_is_running(false), m_do_loop(true), m_udp_ready(false), m_use_udp(false)
 {
+	std::fill(m_udp_received, m_udp_received + 4, 0);
 	m_target_buffer_size = 20;
+	m_rollback_frames = 0;
 	ClearBuffers();
 
 	is_connected = false;
@@ -122,6 +136,18 @@ NetPlayClient::NetPlayClient(const std::string& address, const u16 port, NetPlay
 
 			m_selector.Add(m_socket);
 			m_thread = std::thread(std::mem_fun(&NetPlayClient::ThreadFunc), this);
+
+			// The server learns our UDP address from the hello, so any free port does
+			m_server_address = sf::IPAddress(address);
+			m_server_port = port;
+			for (u16 udp_port = port + 1; udp_port != (u16)(port + 64); ++udp_port)
+			{
+				if (m_udp_socket.Bind(udp_port))
+				{
+					m_udp_thread = std::thread(std::mem_fun(&NetPlayClient::UDPThreadFunc), this);
+					break;
+				}
+			}
 		}
 	}
 	else
@@ -248,6 +274,22 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
 		}
 		break;
 
+	case NP_MSG_PAD_UDP :
+		{
+			// sent right before the game starts
+			bool use_udp = false;
+			packet >> use_udp;
+
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				m_udp_pads[i] = NetPadWindow();
+				m_udp_received[i] = 0;
+			}
+			m_use_udp = use_udp;
+		}
+		break;
+
 	case NP_MSG_CHANGE_GAME :
 		{
 			{
@@ -365,6 +407,120 @@ void NetPlayClient::ThreadFunc()
 	return;
 }
 
+// called from ---NETPLAY UDP--- thread
+void NetPlayClient::OnUDPData(sf::Packet& packet)
+{
+	MessageId mid = 0;
+	packet >> mid;
+
+	switch (mid)
+	{
+	case NP_MSG_UDP_HELLO :
+		m_udp_ready = true;
+		break;
+
+	case NP_MSG_PAD_DATA :
+		{
+			u32 game = 0, first = 0;
+			PadMapping map = -1;
+			u8 count = 0;
+			packet >> game >> map >> first >> count;
+			if (!packet || game != m_current_game || map < 0 || map >= 4)
+				break;
+
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+
+			// Every packet repeats the pads that weren't acked yet
+			for (u32 i = 0; i < count; ++i)
+			{
+				NetPad np;
+				packet >> np.nHi >> np.nLo;
+				if (!packet)
+					break;
+
+				if (first + i == m_udp_received[map])
+				{
+					m_pad_buffer[map].Push(np);
+					m_udp_received[map]++;
+				}
+			}
+
+			sf::Packet spac;
+			spac << (MessageId)NP_MSG_PAD_ACK;
+			spac << game << map << m_udp_received[map];
+			m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), m_server_address, m_server_port);
+		}
+		break;
+
+	case NP_MSG_PAD_ACK :
+		{
+			u32 game = 0, next = 0;
+			PadMapping map = -1;
+			packet >> game >> map >> next;
+			if (!packet || game != m_current_game || map < 0 || map >= 4)
+				break;
+
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			m_udp_pads[map].Ack(next);
+		}
+		break;
+
+	default :
+		break;
+	}
+}
+
+// called from ---NETPLAY UDP--- thread
+void NetPlayClient::UDPThreadFunc()
+{
+	sf::Selector<sf::SocketUDP> selector;
+	selector.Add(m_udp_socket);
+
+	Common::Timer hello_timer;
+	bool hello_sent = false;
+
+	while (m_do_loop)
+	{
+		if (!m_udp_ready && (!hello_sent || hello_timer.GetTimeElapsed() > 100))
+		{
+			sf::Packet spac;
+			spac << (MessageId)NP_MSG_UDP_HELLO;
+			spac << m_pid;
+			m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), m_server_address, m_server_port);
+
+			hello_timer.Start();
+			hello_sent = true;
+		}
+
+		if (selector.Wait(0.01f))
+		{
+			char data[1024];
+			std::size_t size = 0;
+			sf::IPAddress address;
+			unsigned short port = 0;
+			if (m_udp_socket.Receive(data, sizeof(data), size, address, port) == sf::Socket::Done &&
+			    address == m_server_address && port == m_server_port)
+			{
+				sf::Packet rpac;
+				rpac.Append(data, size);
+				OnUDPData(rpac);
+			}
+		}
+		else if (m_use_udp && m_is_running)
+		{
+			// Nothing came in for a while, so the last pads or their acks may be lost
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			for (PadMapping i = 0; i < 4; i++)
+			{
+				if (!m_udp_pads[i].pads.empty())
+					SendUDPPads(i);
+			}
+		}
+	}
+
+	m_udp_socket.Close();
+}
+
 // called from ---GUI--- thread
 void NetPlayClient::GetPlayerList(std::string& list, std::vector<int>& pid_list)
 {
@@ -429,6 +585,14 @@ void NetPlayClient::SendChatMessage(const std::string& msg)
 // called from ---CPU--- thread
 void NetPlayClient::SendPadState(const PadMapping in_game_pad, const NetPad& np)
 {
+	if (m_use_udp)
+	{
+		std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+		m_udp_pads[in_game_pad].pads.push_back(std::make_pair(np.nHi, np.nLo));
+		SendUDPPads(in_game_pad);
+		return;
+	}
+
 	// send to server
 	sf::Packet spac;
 	spac << (MessageId)NP_MSG_PAD_DATA;
@@ -439,6 +603,21 @@ void NetPlayClient::SendPadState(const PadMapping in_game_pad, const NetPad& np)
 	m_socket.Send(spac);
 }
 
+// called from ---CPU--- thread and ---NETPLAY UDP--- thread, with m_crit.send locked
+void NetPlayClient::SendUDPPads(const PadMapping in_game_pad)
+{
+	const NetPadWindow& window = m_udp_pads[in_game_pad];
+	const u8 count = (u8)std::min<size_t>(window.pads.size(), NETPLAY_UDP_MAX_PADS);
+
+	sf::Packet spac;
+	spac << (MessageId)NP_MSG_PAD_DATA;
+	spac << m_current_game << in_game_pad << window.first << count;
+	for (u8 i = 0; i < count; ++i)
+		spac << window.pads[i].first << window.pads[i].second;
+
+	m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), m_server_address, m_server_port);
+}
+
 // called from ---CPU--- thread
 void NetPlayClient::SendWiimoteState(const PadMapping in_game_pad, const NetWiimote& nw)
 {
@@ -481,6 +660,9 @@ bool NetPlayClient::StartGame(const std::string &path)
 	m_is_running = true;
 	NetPlay_Enable(this);
 
+	// Movies would record the rolled back polls twice
+	m_rollback_frames = m_dialog->IsRecording() ? 0 :
+		(unsigned int)std::max(SConfig::GetInstance().m_LocalCoreStartupParameter.iNetPlayRollbackFrames, 0);
 	ClearBuffers();
 
 	if (m_dialog->IsRecording())
@@ -554,6 +736,232 @@ void NetPlayClient::ClearBuffers()
 
 		while (m_wiimote_buffer[i].Size())
 			m_wiimote_buffer[i].Pop();
+
+		m_pad_confirmed[i].clear();
+		m_pad_confirmed_base[i] = 0;
+		m_pad_confirmed_count[i] = 0;
+		m_pad_predicted[i].clear();
+		m_pad_read[i] = 0;
+		m_pad_sent[i] = 0;
+		m_rollback_to[i] = NO_ROLLBACK;
+		m_resimulate_until[i] = 0;
+	}
+
+	m_resimulating = false;
+	m_rollback_snapshots.clear();
+	std::vector<u8>().swap(m_rollback_spare);
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::UpdateRollbackPads()
+{
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		NetPad np;
+		while (m_pad_buffer[i].Pop(np))
+		{
+			// Pads arrive in order, so the first wrong guess is where to roll back to
+			if (!m_pad_predicted[i].empty())
+			{
+				const NetPad& guess = m_pad_predicted[i].front();
+				if ((guess.nHi != np.nHi || guess.nLo != np.nLo) && m_rollback_to[i] == NO_ROLLBACK)
+					m_rollback_to[i] = m_pad_confirmed_count[i];
+				m_pad_predicted[i].pop_front();
+			}
+
+			m_pad_confirmed[i].push_back(np);
+			m_pad_confirmed_count[i]++;
+		}
+	}
+}
+
+// called from ---CPU--- thread
+bool NetPlayClient::CanPredictPad(const u8 pad_nb) const
+{
+	const u32 index = m_pad_read[pad_nb];
+	return index - m_pad_confirmed_count[pad_nb] < m_rollback_frames &&
+		!m_rollback_snapshots.empty() && m_rollback_snapshots.back().pad_read[pad_nb] <= index;
+}
+
+// called from ---CPU--- thread
+bool NetPlayClient::GetRollbackPad(const u8 pad_nb, NetPad* const netvalues)
+{
+	UpdateRollbackPads();
+
+	// Wait like without rollback once the pad is too far ahead
+	const u32 index = m_pad_read[pad_nb];
+	while (index >= m_pad_confirmed_count[pad_nb] && !CanPredictPad(pad_nb))
+	{
+		if (!m_is_running)
+			return false;
+
+		Common::SleepCurrentThread(1);
+		UpdateRollbackPads();
+	}
+
+	if (index < m_pad_confirmed_count[pad_nb])
+	{
+		*netvalues = m_pad_confirmed[pad_nb][index - m_pad_confirmed_base[pad_nb]];
+	}
+	else
+	{
+		if (!m_pad_confirmed[pad_nb].empty())
+			*netvalues = m_pad_confirmed[pad_nb].back();
+		else
+			*netvalues = NetPad();
+		m_pad_predicted[pad_nb].push_back(*netvalues);
+	}
+
+	m_pad_read[pad_nb]++;
+	return true;
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::TrimRollbackHistory()
+{
+	// A snapshot is only needed while no later one was taken before every
+	// pad that can still be mispredicted
+	while (m_rollback_snapshots.size() >= 2)
+	{
+		const RollbackSnapshot& next = m_rollback_snapshots[1];
+		bool needed = false;
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			if (next.pad_read[i] > m_pad_confirmed_count[i])
+				needed = true;
+		}
+		if (needed)
+			break;
+
+		m_rollback_spare.swap(m_rollback_snapshots.front().state);
+		m_rollback_snapshots.pop_front();
+	}
+
+	// Keep the pads the oldest snapshot reads again, and the last one for predicting
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		u32 oldest = m_pad_read[i];
+		if (!m_rollback_snapshots.empty())
+			oldest = std::min(oldest, m_rollback_snapshots.front().pad_read[i]);
+
+		while (m_pad_confirmed[i].size() > 1 && m_pad_confirmed_base[i] < oldest)
+		{
+			m_pad_confirmed[i].pop_front();
+			m_pad_confirmed_base[i]++;
+		}
+	}
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::TakeRollbackSnapshot()
+{
+	RollbackSnapshot snapshot;
+	if (m_rollback_snapshots.size() > m_rollback_frames)
+	{
+		snapshot.state.swap(m_rollback_snapshots.front().state);
+		m_rollback_snapshots.pop_front();
+	}
+	else
+	{
+		snapshot.state.swap(m_rollback_spare);
+	}
+
+	State::SaveToBuffer(snapshot.state);
+	std::copy(m_pad_read, m_pad_read + 4, snapshot.pad_read);
+	m_rollback_snapshots.push_back(std::move(snapshot));
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::Rollback()
+{
+	// Find the newest snapshot from before every mispredicted pad was read
+	auto snapshot = m_rollback_snapshots.rbegin();
+	for (; snapshot != m_rollback_snapshots.rend(); ++snapshot)
+	{
+		bool before = true;
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			if (m_rollback_to[i] != NO_ROLLBACK && snapshot->pad_read[i] > m_rollback_to[i])
+				before = false;
+		}
+		if (before)
+			break;
+	}
+
+	if (snapshot == m_rollback_snapshots.rend())
+	{
+		ERROR_LOG(NETPLAY, "No snapshot to roll back to, the game may desync");
+		std::fill(m_rollback_to, m_rollback_to + 4, NO_ROLLBACK);
+		return;
+	}
+
+	// A rollback while running again still has to catch up with the first one
+	if (!m_resimulating)
+	{
+		std::copy(m_pad_read, m_pad_read + 4, m_resimulate_until);
+		m_resimulating = true;
+		g_video_backend->Video_SetRendering(false);
+	}
+
+	DEBUG_LOG(NETPLAY, "Rolling back %u polls", m_pad_read[0] - snapshot->pad_read[0]);
+	State::LoadFromBuffer(snapshot->state);
+
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		m_pad_read[i] = snapshot->pad_read[i];
+		m_pad_predicted[i].resize(m_pad_read[i] > m_pad_confirmed_count[i] ? m_pad_read[i] - m_pad_confirmed_count[i] : 0);
+		m_rollback_to[i] = NO_ROLLBACK;
+	}
+
+	// The snapshot rolled back to stays for the next misprediction
+	m_rollback_snapshots.erase(snapshot.base(), m_rollback_snapshots.end());
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::OnAdvance()
+{
+	if (!m_rollback_frames || !m_is_running)
+		return;
+
+	UpdateRollbackPads();
+
+	bool mispredicted = false;
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		if (m_rollback_to[i] != NO_ROLLBACK)
+			mispredicted = true;
+	}
+	if (mispredicted)
+		Rollback();
+
+	if (m_resimulating)
+	{
+		bool caught_up = true;
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			if (m_pad_read[i] < m_resimulate_until[i])
+				caught_up = false;
+		}
+		if (caught_up)
+		{
+			m_resimulating = false;
+			g_video_backend->Video_SetRendering(true);
+		}
+	}
+
+	TrimRollbackHistory();
+
+	// Only the polls that have to predict a remote pad need a snapshot
+	bool predicts = false;
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		if (m_pad_map[i] > 0 && m_pad_map[i] != m_local_player->pid && m_pad_read[i] >= m_pad_confirmed_count[i])
+			predicts = true;
+	}
+	if (predicts && (m_rollback_snapshots.empty() ||
+	    !std::equal(m_pad_read, m_pad_read + 4, m_rollback_snapshots.back().pad_read)))
+	{
+		TakeRollbackSnapshot();
 	}
 }
 
@@ -589,7 +997,19 @@ bool NetPlayClient::GetNetPads(const u8 pad_nb, const SPADStatus* const pad_stat
 
 	// If this in-game pad is one of ours, then update from the
 	// information given.
-	if (in_game_num < 4)
+	if (in_game_num < 4 && m_rollback_frames)
+	{
+		NetPad np(pad_status);
+
+		// Polls that run again after a rollback already sent their pad
+		while (m_pad_sent[in_game_num] <= m_pad_read[in_game_num] + ROLLBACK_INPUT_DELAY)
+		{
+			m_pad_buffer[in_game_num].Push(np);
+			SendPadState(in_game_num, np);
+			m_pad_sent[in_game_num]++;
+		}
+	}
+	else if (in_game_num < 4)
 	{
 		NetPad np(pad_status);
 
@@ -609,13 +1029,21 @@ bool NetPlayClient::GetNetPads(const u8 pad_nb, const SPADStatus* const pad_stat
 	// retrieved from NetPlay. This could be the value we pushed
 	// above if we're configured as P1 and the code is trying
 	// to retrieve data for slot 1.
-	while (!m_pad_buffer[pad_nb].Pop(*netvalues))
+	if (m_rollback_frames)
 	{
-		if (!m_is_running)
+		if (!GetRollbackPad(pad_nb, netvalues))
 			return false;
+	}
+	else
+	{
+		while (!m_pad_buffer[pad_nb].Pop(*netvalues))
+		{
+			if (!m_is_running)
+				return false;
 
-		// TODO: use a condition instead of sleeping
-		Common::SleepCurrentThread(1);
+			// TODO: use a condition instead of sleeping
+			Common::SleepCurrentThread(1);
+		}
 	}
 
 	SPADStatus tmp;
@@ -911,6 +1339,15 @@ bool NetPlay::IsNetPlayRunning()
 	return netplay_client != NULL;
 }
 
+// called from ---CPU--- thread
+void NetPlay::OnAdvance()
+{
+	std::lock_guard<std::mutex> lk(crit_netplay_client);
+
+	if (netplay_client)
+		netplay_client->OnAdvance();
+}
+
 void NetPlay_Enable(NetPlayClient* const np)
 {
 	std::lock_guard<std::mutex> lk(crit_netplay_client);
@@ -14,6 +14,7 @@
 #include "NetPlayProto.h"
 #include "GCPadStatus.h"
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <queue>
@@ -61,6 +62,7 @@ class NetPlayClient
 {
 public:
 	void ThreadFunc();
+	void UDPThreadFunc();
 
 	NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name);
 	~NetPlayClient();
@@ -85,9 +87,45 @@ public:
 
 	u8 LocalWiimoteToInGameWiimote(u8 local_pad);
 
+	// Takes rollback snapshots and rolls back mispredicted pads
+	void OnAdvance();
+
 protected:
 	void ClearBuffers();
 
+	// In rollback mode remote pads that haven't arrived yet are predicted
+	// from their last value. A snapshot is taken before every poll that
+	// predicts, and once a pad turns out to be mispredicted the emulation is
+	// rolled back and runs up to the current poll again with rendering off.
+	// Everything below is only touched on the CPU thread.
+	struct RollbackSnapshot
+	{
+		std::vector<u8> state;
+		u32 pad_read[4];
+	};
+
+	bool GetRollbackPad(const u8 pad_nb, NetPad* const netvalues);
+	void UpdateRollbackPads();
+	bool CanPredictPad(const u8 pad_nb) const;
+	void TrimRollbackHistory();
+	void TakeRollbackSnapshot();
+	void Rollback();
+
+	unsigned int m_rollback_frames;
+	std::deque<NetPad> m_pad_confirmed[4];
+	u32 m_pad_confirmed_base[4];
+	u32 m_pad_confirmed_count[4];
+	// predictions for the pads read from m_pad_confirmed_count on
+	std::deque<NetPad> m_pad_predicted[4];
+	u32 m_pad_read[4];
+	u32 m_pad_sent[4];
+	// the first mispredicted pad, or NO_ROLLBACK
+	u32 m_rollback_to[4];
+	u32 m_resimulate_until[4];
+	bool m_resimulating;
+	std::deque<RollbackSnapshot> m_rollback_snapshots;
+	std::vector<u8> m_rollback_spare;
+
 	struct
 	{
 		std::recursive_mutex game;
@@ -103,6 +141,17 @@ protected:
 	std::thread   m_thread;
 	sf::Selector<sf::SocketTCP> m_selector;
 
+	// Pads go over UDP while the server says so, everything else over TCP
+	sf::SocketUDP m_udp_socket;
+	std::thread   m_udp_thread;
+	sf::IPAddress m_server_address;
+	u16           m_server_port;
+	volatile bool m_udp_ready;
+	volatile bool m_use_udp;
+	// guarded by m_crit.send
+	NetPadWindow  m_udp_pads[4];
+	u32           m_udp_received[4];
+
 	std::string   m_selected_game;
 	volatile bool m_is_running;
 	volatile bool m_do_loop;
@@ -121,8 +170,10 @@ protected:
 private:
 	void UpdateDevices();
 	void SendPadState(const PadMapping in_game_pad, const NetPad& np);
+	void SendUDPPads(const PadMapping in_game_pad);
 	void SendWiimoteState(const PadMapping in_game_pad, const NetWiimote& nw);
 	unsigned int OnData(sf::Packet& packet);
+	void OnUDPData(sf::Packet& packet);
 
 	PlayerId m_pid;
 	std::map<PlayerId, Player> m_players;
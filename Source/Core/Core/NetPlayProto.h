@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "Common.h"
 #include "CommonTypes.h"
 #include "HW/EXI_Device.h"
@@ -27,10 +29,42 @@ struct Rpt : public std::vector<u8>
 
 typedef std::vector<u8> NetWiimote;
 
-#define NETPLAY_VERSION  "Dolphin NetPlay 2014-01-08"
+#define NETPLAY_VERSION  "Dolphin NetPlay 2014-04-20"
 
 const int NETPLAY_INITIAL_GCTIME = 1272737767;
 
+// The automatic pad buffer takes this percentile of the last pings of every
+// client, and assumes the SI polls the pads about once per frame
+const unsigned int NETPLAY_PING_SAMPLES = 30;
+const unsigned int NETPLAY_PING_PERCENTILE = 95;
+const unsigned int NETPLAY_POLLS_PER_SECOND = 60;
+const unsigned int NETPLAY_MAX_PAD_BUFFER = 200;
+// pings in a row that have to allow a smaller buffer before it shrinks
+const unsigned int NETPLAY_PAD_BUFFER_SHRINK_DELAY = 5;
+
+// Pads sent over UDP are resent until they are acked, this many per packet
+const unsigned int NETPLAY_UDP_MAX_PADS = 32;
+
+// The pads of one in-game pad that haven't been acked yet
+struct NetPadWindow
+{
+	NetPadWindow() : first(0) {}
+
+	void Ack(u32 next)
+	{
+		while (!pads.empty() && (s32)(next - first) > 0)
+		{
+			pads.pop_front();
+			first++;
+		}
+	}
+
+	// sequence number of pads.front()
+	u32 first;
+	// hi and lo words of every pad
+	std::deque<std::pair<u32, u32> > pads;
+};
+
 
 // messages
 enum
@@ -43,6 +77,8 @@ enum
 	NP_MSG_PAD_DATA         = 0x60,
 	NP_MSG_PAD_MAPPING      = 0x61,
 	NP_MSG_PAD_BUFFER       = 0x62,
+	NP_MSG_PAD_ACK          = 0x63,
+	NP_MSG_PAD_UDP          = 0x64,
 
 	NP_MSG_WIIMOTE_DATA     = 0x70,
 	NP_MSG_WIIMOTE_MAPPING  = 0x71,
@@ -58,6 +94,7 @@ enum
 	NP_MSG_PING             = 0xE0,
 	NP_MSG_PONG             = 0xE1,
 	NP_MSG_PLAYER_PING_DATA = 0xE2,
+	NP_MSG_UDP_HELLO        = 0xE3,
 };
 
 typedef u8	MessageId;
@@ -74,4 +111,6 @@ enum
 
 namespace NetPlay {
 	bool IsNetPlayRunning();
+	// Called on the CPU thread at the end of every CoreTiming slice
+	void OnAdvance();
 };
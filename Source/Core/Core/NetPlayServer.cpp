@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "NetPlayServer.h"
 
 NetPlayServer::~NetPlayServer()
@@ -10,6 +12,8 @@ NetPlayServer::~NetPlayServer()
 	{
 		m_do_loop = false;
 		m_thread.join();
+		if (m_udp_thread.joinable())
+			m_udp_thread.join();
 		m_socket.Close();
 	}
 
@@ -22,7 +26,7 @@ NetPlayServer::~NetPlayServer()
 }
 
 // called from ---GUI--- thread
-NetPlayServer::NetPlayServer(const u16 port) : is_connected(false), m_is_running(false)
+NetPlayServer::NetPlayServer(const u16 port) : is_connected(false), m_is_running(false), m_auto_buffer(false), m_auto_buffer_shrink_count(0)
 {
 	memset(m_pad_map, -1, sizeof(m_pad_map));
 	memset(m_wiimote_map, -1, sizeof(m_wiimote_map));
@@ -33,6 +37,10 @@ NetPlayServer::NetPlayServer(const u16 port) : is_connected(false), m_is_running
 		m_selector.Add(m_socket);
 		m_thread = std::thread(std::mem_fun(&NetPlayServer::ThreadFunc), this);
 		m_target_buffer_size = 20;
+
+		// Without UDP the pads just stay on TCP
+		if (m_udp_socket.Bind(port))
+			m_udp_thread = std::thread(std::mem_fun(&NetPlayServer::UDPThreadFunc), this);
 	}
 }
 
@@ -41,11 +49,15 @@ void NetPlayServer::ThreadFunc()
 {
 	while (m_do_loop)
 	{
-		// update pings every so many seconds
-		if ((m_ping_timer.GetTimeElapsed() > (10 * 1000)) || m_update_pings)
+		// update pings every so many seconds, the automatic pad buffer needs more of them
+		const u64 ping_interval = m_auto_buffer ? 1000 : 10 * 1000;
+		if ((m_ping_timer.GetTimeElapsed() > ping_interval) || m_update_pings)
 		{
 			//PanicAlertT("Sending pings");
 
+			if (m_auto_buffer)
+				UpdateAutoPadBuffer();
+
 			m_ping_key = Common::Timer::GetTimeMs();
 
 			sf::Packet spac;
@@ -69,12 +81,13 @@ void NetPlayServer::ThreadFunc()
 			if (ready_socket == m_socket)
 			{
 				sf::SocketTCP accept_socket;
-				m_socket.Accept(accept_socket);
+				sf::IPAddress address;
+				m_socket.Accept(accept_socket, &address);
 
 				unsigned int error;
 				{
 				std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
-				error = OnConnect(accept_socket);
+				error = OnConnect(accept_socket, address);
 				}
 
 				if (error)
@@ -123,8 +136,142 @@ void NetPlayServer::ThreadFunc()
 	return;
 }
 
+// called from ---NETPLAY UDP--- thread
+void NetPlayServer::UDPThreadFunc()
+{
+	sf::Selector<sf::SocketUDP> selector;
+	selector.Add(m_udp_socket);
+
+	while (m_do_loop)
+	{
+		if (selector.Wait(0.01f))
+		{
+			char data[1024];
+			std::size_t size = 0;
+			sf::IPAddress address;
+			unsigned short port = 0;
+			if (m_udp_socket.Receive(data, sizeof(data), size, address, port) == sf::Socket::Done)
+			{
+				sf::Packet rpac;
+				rpac.Append(data, size);
+				OnUDPData(rpac, address, port);
+			}
+		}
+		else if (m_is_running)
+		{
+			// Nothing came in for a while, so the last pads or their acks may be lost
+			std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			for (auto& p : m_players)
+			{
+				for (PadMapping map = 0; p.second.use_udp && map < 4; map++)
+				{
+					if (!p.second.udp_pads[map].pads.empty())
+						SendUDPPads(p.second, map);
+				}
+			}
+		}
+	}
+
+	m_udp_socket.Close();
+}
+
+// called from ---NETPLAY UDP--- thread
+void NetPlayServer::OnUDPData(sf::Packet& packet, const sf::IPAddress& address, const unsigned short port)
+{
+	MessageId mid = 0;
+	packet >> mid;
+
+	std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+
+	if (mid == NP_MSG_UDP_HELLO)
+	{
+		PlayerId pid = 0;
+		packet >> pid;
+
+		// Only believe the hello from where the player connected from
+		for (auto& p : m_players)
+		{
+			if (p.second.pid == pid && p.second.address == address)
+			{
+				p.second.udp_address = address;
+				p.second.udp_port = port;
+
+				sf::Packet spac;
+				spac << (MessageId)NP_MSG_UDP_HELLO;
+
+				std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+				m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), address, port);
+				break;
+			}
+		}
+		return;
+	}
+
+	Client* player = NULL;
+	for (auto& p : m_players)
+	{
+		if (p.second.udp_port == port && p.second.udp_address == address)
+			player = &p.second;
+	}
+	if (!player)
+		return;
+
+	switch (mid)
+	{
+	case NP_MSG_PAD_DATA :
+		{
+			u32 game = 0, first = 0;
+			PadMapping map = -1;
+			u8 count = 0;
+			packet >> game >> map >> first >> count;
+			if (!packet || game != m_current_game || map < 0 || map >= 4 || m_pad_map[map] != player->pid)
+				break;
+
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+
+			// Every packet repeats the pads that weren't acked yet
+			for (u32 i = 0; i < count; ++i)
+			{
+				u32 hi = 0, lo = 0;
+				packet >> hi >> lo;
+				if (!packet)
+					break;
+
+				if (first + i == player->udp_received[map])
+				{
+					RelayPadData(map, hi, lo, player->pid);
+					player->udp_received[map]++;
+				}
+			}
+
+			sf::Packet spac;
+			spac << (MessageId)NP_MSG_PAD_ACK;
+			spac << game << map << player->udp_received[map];
+			m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), address, port);
+		}
+		break;
+
+	case NP_MSG_PAD_ACK :
+		{
+			u32 game = 0, next = 0;
+			PadMapping map = -1;
+			packet >> game >> map >> next;
+			if (!packet || game != m_current_game || map < 0 || map >= 4)
+				break;
+
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			player->udp_pads[map].Ack(next);
+		}
+		break;
+
+	default :
+		break;
+	}
+}
+
 // called from ---NETPLAY--- thread
-unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
+unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket, const sf::IPAddress& address)
 {
 	sf::Packet rpac;
 	// TODO: make this not hang / check if good packet
@@ -149,6 +296,10 @@ unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
 
 	Client player;
 	player.socket = socket;
+	player.address = address;
+	player.udp_port = 0;
+	player.use_udp = false;
+	std::fill(player.udp_received, player.udp_received + 4, 0);
 	rpac >> player.revision;
 	rpac >> player.name;
 
@@ -339,6 +490,75 @@ void NetPlayServer::AdjustPadBufferSize(unsigned int size)
 	SendToClients(spac);
 }
 
+// called from ---GUI--- thread
+void NetPlayServer::SetAutoPadBuffer(bool enable)
+{
+	m_auto_buffer_shrink_count = 0;
+	m_auto_buffer = enable;
+	m_update_pings = true;
+}
+
+// called from ---NETPLAY--- thread
+void NetPlayServer::UpdateAutoPadBuffer()
+{
+	// A pad goes from one client through the server to another, so the two
+	// slowest clients decide. A high percentile covers their jitter.
+	u32 slowest[2] = {0, 0};
+	for (const auto& p : m_players)
+	{
+		if (p.second.ping_samples.empty())
+			continue;
+
+		std::vector<u32> samples(p.second.ping_samples.begin(), p.second.ping_samples.end());
+		std::sort(samples.begin(), samples.end());
+		const u32 ping = samples[(samples.size() - 1) * NETPLAY_PING_PERCENTILE / 100];
+
+		if (ping > slowest[0])
+		{
+			slowest[1] = slowest[0];
+			slowest[0] = ping;
+		}
+		else if (ping > slowest[1])
+		{
+			slowest[1] = ping;
+		}
+	}
+
+	// One pad per poll, plus one for the polls not lining up
+	const u32 latency = (slowest[0] + slowest[1]) / 2;
+	const unsigned int size = std::min<unsigned int>(
+		(latency * NETPLAY_POLLS_PER_SECOND + 999) / 1000 + 1, NETPLAY_MAX_PAD_BUFFER);
+
+	// Grow at once so nobody waits for pads, shrink one pad at a time once the
+	// pings stayed low for a while. Every client's pads stay in order either
+	// way; a bigger buffer repeats the current pad and a smaller one skips
+	// sending until the buffer drained.
+	unsigned int new_size = m_target_buffer_size;
+	if (size > m_target_buffer_size)
+	{
+		new_size = size;
+		m_auto_buffer_shrink_count = 0;
+	}
+	else if (size < m_target_buffer_size && ++m_auto_buffer_shrink_count >= NETPLAY_PAD_BUFFER_SHRINK_DELAY)
+	{
+		new_size = m_target_buffer_size - 1;
+		m_auto_buffer_shrink_count = 0;
+	}
+	else if (size == m_target_buffer_size)
+	{
+		m_auto_buffer_shrink_count = 0;
+	}
+
+	if (new_size != m_target_buffer_size)
+	{
+		AdjustPadBufferSize(new_size);
+
+		std::ostringstream ss;
+		ss << "< Pad Buffer: " << new_size << " >";
+		SendChatMessage(ss.str());
+	}
+}
+
 // called from ---NETPLAY--- thread
 unsigned int NetPlayServer::OnData(sf::Packet& packet, sf::SocketTCP& socket)
 {
@@ -385,12 +605,9 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, sf::SocketTCP& socket)
 				return 1;
 
 			// Relay to clients
-			sf::Packet spac;
-			spac << (MessageId)NP_MSG_PAD_DATA;
-			spac << map << hi << lo;
-
+			std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
 			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
-			SendToClients(spac, player.pid);
+			RelayPadData(map, (u32)hi, (u32)lo, player.pid);
 		}
 		break;
 
@@ -439,6 +656,10 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, sf::SocketTCP& socket)
 			if (m_ping_key == ping_key)
 			{
 				player.ping = ping;
+
+				player.ping_samples.push_back(ping);
+				if (player.ping_samples.size() > NETPLAY_PING_SAMPLES)
+					player.ping_samples.pop_front();
 			}
 
 			sf::Packet spac;
@@ -528,6 +749,27 @@ bool NetPlayServer::StartGame(const std::string &path)
 	// no change, just update with clients
 	AdjustPadBufferSize(m_target_buffer_size);
 
+	// Clients that said hello over UDP get their pads over UDP this game
+	{
+	std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+	for (auto& p : m_players)
+	{
+		Client& client = p.second;
+		client.use_udp = client.udp_port != 0;
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			client.udp_pads[i] = NetPadWindow();
+			client.udp_received[i] = 0;
+		}
+
+		sf::Packet spac;
+		spac << (MessageId)NP_MSG_PAD_UDP;
+		spac << client.use_udp;
+		client.socket.Send(spac);
+	}
+	}
+
 	// tell clients to start game
 	sf::Packet spac;
 	spac << (MessageId)NP_MSG_START_GAME;
@@ -560,6 +802,46 @@ void NetPlayServer::SendToClients(sf::Packet& packet, const PlayerId skip_pid)
 			i->second.socket.Send(packet);
 }
 
+// called from ---NETPLAY--- thread and ---NETPLAY UDP--- thread, with players and send locked
+void NetPlayServer::RelayPadData(const PadMapping map, const u32 hi, const u32 lo, const PlayerId skip_pid)
+{
+	sf::Packet spac;
+	spac << (MessageId)NP_MSG_PAD_DATA;
+	spac << map << hi << lo;
+
+	for (auto& p : m_players)
+	{
+		Client& client = p.second;
+		if (!client.pid || client.pid == skip_pid)
+			continue;
+
+		if (client.use_udp)
+		{
+			client.udp_pads[map].pads.push_back(std::make_pair(hi, lo));
+			SendUDPPads(client, map);
+		}
+		else
+		{
+			client.socket.Send(spac);
+		}
+	}
+}
+
+// called with send locked
+void NetPlayServer::SendUDPPads(Client& client, const PadMapping map)
+{
+	const NetPadWindow& window = client.udp_pads[map];
+	const u8 count = (u8)std::min<size_t>(window.pads.size(), NETPLAY_UDP_MAX_PADS);
+
+	sf::Packet spac;
+	spac << (MessageId)NP_MSG_PAD_DATA;
+	spac << m_current_game << map << window.first << count;
+	for (u8 i = 0; i < count; ++i)
+		spac << window.pads[i].first << window.pads[i].second;
+
+	m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), client.udp_address, client.udp_port);
+}
+
 #ifdef USE_UPNP
 #include <miniwget.h>
 #include <miniupnpc.h>
@@ -688,6 +970,12 @@ bool NetPlayServer::UPnPMapPort(const std::string& addr, const u16 port)
 	if(result != 0)
 		return false;
 
+	// The pads fall back to TCP without this one
+	UPNP_AddPortMapping(m_upnp_urls.controlURL, m_upnp_data.first.servicetype,
+	                    port_str, port_str, addr.c_str(),
+	                    (std::string("dolphin-emu UDP on ") + addr).c_str(),
+	                    "UDP", NULL, NULL);
+
 	m_upnp_mapped = port;
 
 	return true;
@@ -708,6 +996,8 @@ bool NetPlayServer::UPnPUnmapPort(const u16 port)
 	sprintf(port_str, "%d", port);
 	UPNP_DeletePortMapping(m_upnp_urls.controlURL, m_upnp_data.first.servicetype,
 	                       port_str, "TCP", NULL);
+	UPNP_DeletePortMapping(m_upnp_urls.controlURL, m_upnp_data.first.servicetype,
+	                       port_str, "UDP", NULL);
 
 	return true;
 }
@@ -13,6 +13,7 @@
 
 #include "NetPlayProto.h"
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <queue>
@@ -22,6 +23,7 @@ class NetPlayServer
 {
 public:
 	void ThreadFunc();
+	void UDPThreadFunc();
 
 	NetPlayServer(const u16 port);
 	~NetPlayServer();
@@ -40,6 +42,8 @@ public:
 	void SetWiimoteMapping(const PadMapping map[]);
 
 	void AdjustPadBufferSize(unsigned int size);
+	// Size the pad buffer from the measured pings instead
+	void SetAutoPadBuffer(bool enable);
 
 	bool is_connected;
 
@@ -56,16 +60,31 @@ private:
 		std::string revision;
 
 		sf::SocketTCP socket;
+		sf::IPAddress address;
 		u32 ping;
 		u32 current_game;
+		// recent pings for sizing the pad buffer
+		std::deque<u32> ping_samples;
+
+		// udp_port stays 0 until the client said hello over UDP
+		sf::IPAddress udp_address;
+		unsigned short udp_port;
+		bool use_udp;
+		// pads relayed to the client and pads received from it
+		NetPadWindow udp_pads[4];
+		u32 udp_received[4];
 	};
 
 	void SendToClients(sf::Packet& packet, const PlayerId skip_pid = 0);
-	unsigned int OnConnect(sf::SocketTCP& socket);
+	void RelayPadData(const PadMapping map, const u32 hi, const u32 lo, const PlayerId skip_pid);
+	void SendUDPPads(Client& client, const PadMapping map);
+	unsigned int OnConnect(sf::SocketTCP& socket, const sf::IPAddress& address);
 	unsigned int OnDisconnect(sf::SocketTCP& socket);
 	unsigned int OnData(sf::Packet& packet, sf::SocketTCP& socket);
+	void OnUDPData(sf::Packet& packet, const sf::IPAddress& address, const unsigned short port);
 	void UpdatePadMapping();
 	void UpdateWiimoteMapping();
+	void UpdateAutoPadBuffer();
 
 	NetSettings     m_settings;
 
@@ -76,6 +95,8 @@ private:
 	bool            m_update_pings;
 	u32             m_current_game;
 	unsigned int    m_target_buffer_size;
+	volatile bool   m_auto_buffer;
+	unsigned int    m_auto_buffer_shrink_count;
 	PadMapping      m_pad_map[4];
 	PadMapping      m_wiimote_map[4];
 
@@ -94,6 +115,10 @@ private:
 	std::thread m_thread;
 	sf::Selector<sf::SocketTCP> m_selector;
 
+	// bound to the same port as m_socket, only carries pads
+	sf::SocketUDP m_udp_socket;
+	std::thread m_udp_thread;
+
 #ifdef USE_UPNP
 	static void mapPortThread(const u16 port);
 	static void unmapPortThread();
@@ -19,8 +19,10 @@
 
 #include "GDBStub.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <string>
 #include <fcntl.h>
 #include <unistd.h>
 #ifdef _WIN32
@@ -31,18 +33,22 @@
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #endif
 #include <stdarg.h>
 
+#include "ConfigManager.h"
 #include "Host.h"
 
-#define GDB_BFR_MAX  10000
+// Big enough for gdb to move 32KB of memory per packet
+#define GDB_BFR_MAX  0x10000
 #define GDB_MAX_BP   10
 
-#define GDB_STUB_START '$'
-#define GDB_STUB_END   '#'
-#define GDB_STUB_ACK   '+'
-#define GDB_STUB_NAK   '-'
+#define GDB_STUB_START  '$'
+#define GDB_STUB_END    '#'
+#define GDB_STUB_ACK    '+'
+#define GDB_STUB_NAK    '-'
+#define GDB_STUB_ESCAPE '}'
 
 
 static int tmpsock = -1;
@@ -52,6 +58,11 @@ static struct sockaddr_in saddr_server, saddr_client;
 static u8 cmd_bfr[GDB_BFR_MAX];
 static u32 cmd_len;
 
+// The socket is non-blocking and read a whole chunk at a time, not a
+// system call per byte
+static u8 recv_bfr[GDB_BFR_MAX];
+static u32 recv_pos, recv_len;
+
 static u32 sig = 0;
 static u32 send_signal = 0;
 static u32 step_break = 0;
@@ -109,19 +120,80 @@ static void hex2mem(u8 *dst, u8 *src, u32 len)
 	}
 }
 
-static u8 gdb_read_byte()
+static bool gdb_would_block()
 {
-	ssize_t res;
-	u8 c = '+';
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+// Waits at most timeout_usec, or forever if it's negative
+static bool gdb_wait_socket(bool write, long timeout_usec)
+{
+	struct timeval t;
+	fd_set _fds, *fds = &_fds;
+
+	FD_ZERO(fds);
+	FD_SET(sock, fds);
 
-	res = recv(sock, &c, 1, MSG_WAITALL);
-	if (res != 1)
+	t.tv_sec = timeout_usec / 1000000;
+	t.tv_usec = timeout_usec % 1000000;
+
+	if (select(sock + 1, write ? NULL : fds, write ? fds : NULL, NULL, timeout_usec < 0 ? NULL : &t) < 0)
 	{
-		ERROR_LOG(GDB_STUB, "recv failed : %ld", res);
-		gdb_deinit();
+		ERROR_LOG(GDB_STUB, "select failed");
+		return false;
 	}
 
-	return c;
+	return FD_ISSET(sock, fds) != 0;
+}
+
+static u8 gdb_read_byte()
+{
+	while (recv_pos == recv_len)
+	{
+		if (sock == -1)
+			return GDB_STUB_ACK;
+
+		ssize_t res = recv(sock, (char *)recv_bfr, sizeof recv_bfr, 0);
+		if (res > 0)
+		{
+			recv_pos = 0;
+			recv_len = (u32)res;
+		}
+		else if (res < 0 && gdb_would_block())
+		{
+			gdb_wait_socket(false, -1);
+		}
+		else
+		{
+			ERROR_LOG(GDB_STUB, "recv failed : %ld", (long)res);
+			gdb_deinit();
+			return GDB_STUB_ACK;
+		}
+	}
+
+	return recv_bfr[recv_pos++];
+}
+
+static bool gdb_send(const u8 *ptr, u32 left)
+{
+	while (left > 0)
+	{
+		ssize_t n = send(sock, (const char *)ptr, left, 0);
+		if (n < 0 && gdb_would_block())
+		{
+			gdb_wait_socket(true, -1);
+			continue;
+		}
+		if (n < 0)
+			return false;
+		left -= (u32)n;
+		ptr += n;
+	}
+	return true;
 }
 
 static u8 gdb_calc_chksum()
@@ -222,21 +294,17 @@ static int gdb_bp_check(u32 addr, u32 type)
 
 static void gdb_nak()
 {
-	const char nak = GDB_STUB_NAK;
-	ssize_t res;
+	const u8 nak = GDB_STUB_NAK;
 
-	res = send(sock, &nak, 1, 0);
-	if (res != 1)
+	if (!gdb_send(&nak, 1))
 		ERROR_LOG(GDB_STUB, "send failed");
 }
 
 static void gdb_ack()
 {
-	const char ack = GDB_STUB_ACK;
-	ssize_t res;
+	const u8 ack = GDB_STUB_ACK;
 
-	res = send(sock, &ack, 1, 0);
-	if (res != 1)
+	if (!gdb_send(&ack, 1))
 		ERROR_LOG(GDB_STUB, "send failed");
 }
 
@@ -266,6 +334,11 @@ static void gdb_read_command()
 	}
 
 	while ((c = gdb_read_byte()) != GDB_STUB_END) {
+		if (sock == -1)
+		{
+			cmd_len = 0;
+			return;
+		}
 		cmd_bfr[cmd_len++] = c;
 		if (cmd_len == sizeof cmd_bfr)
 		{
@@ -293,32 +366,16 @@ static void gdb_read_command()
 }
 
 static int gdb_data_available() {
-	struct timeval t;
-	fd_set _fds, *fds = &_fds;
-
-	FD_ZERO(fds);
-	FD_SET(sock, fds);
-
-	t.tv_sec = 0;
-	t.tv_usec = 20;
-
-	if (select(sock + 1, fds, NULL, NULL, &t) < 0)
-	{
-		ERROR_LOG(GDB_STUB, "select failed");
-		return 0;
-	}
-
-	if (FD_ISSET(sock, fds))
+	if (recv_pos < recv_len)
 		return 1;
-	return 0;
+
+	// Sleep in select instead of spinning while gdb has the emulation stopped
+	return gdb_wait_socket(false, 10000) ? 1 : 0;
 }
 
 static void gdb_reply(const char *reply)
 {
 	u8 chk;
-	u32 left;
-	u8 *ptr;
-	int n;
 
 	if(!gdb_active())
 		return;
@@ -327,7 +384,10 @@ static void gdb_reply(const char *reply)
 
 	cmd_len = strlen(reply);
 	if (cmd_len + 4 > sizeof cmd_bfr)
+	{
 		ERROR_LOG(GDB_STUB, "cmd_bfr overflow in gdb_reply");
+		return gdb_reply("E01");
+	}
 
 	memcpy(cmd_bfr + 1, reply, cmd_len);
 
@@ -341,28 +401,75 @@ static void gdb_reply(const char *reply)
 
 	DEBUG_LOG(GDB_STUB, "gdb: reply (len: %d): %s\n", cmd_len, cmd_bfr);
 
-	ptr = cmd_bfr;
-	left = cmd_len + 4;
-	while (left > 0) {
-		n = send(sock, ptr, left, 0);
-		if (n < 0)
-		{
-			ERROR_LOG(GDB_STUB, "gdb: send failed");
-			return gdb_deinit();
-		}
-		left -= n;
-		ptr += n;
+	if (!gdb_send(cmd_bfr, cmd_len + 4))
+	{
+		ERROR_LOG(GDB_STUB, "gdb: send failed");
+		return gdb_deinit();
 	}
 }
 
+static u32 gdb_read_hex(u32 *i, u8 end)
+{
+	u32 value = 0;
+	while (*i < cmd_len && cmd_bfr[*i] != end)
+		value = (value << 4) | hex2char(cmd_bfr[(*i)++]);
+	++*i;
+	return value;
+}
+
+// Lets gdb (and IDA) know which ranges it can read, instead of probing
+static void gdb_read_memory_map(u32 i)
+{
+	char bfr[128];
+	std::string map =
+		"<?xml version=\"1.0\"?>"
+		"<!DOCTYPE memory-map PUBLIC \"+//IDN gnu.org//DTD GDB Memory Map V1.0//EN\" "
+		"\"http://sourceware.org/gdb/gdb-memory-map.dtd\">"
+		"<memory-map>";
+	const u32 starts[] = {0x80000000, 0xC0000000, 0x90000000, 0xD0000000};
+	for (u32 j = 0; j < 4; j++)
+	{
+		if (j >= 2 && !SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
+			break;
+		sprintf(bfr, "<memory type=\"ram\" start=\"0x%08x\" length=\"0x%x\"/>",
+			starts[j], j < 2 ? (u32)Memory::REALRAM_SIZE : (u32)Memory::EXRAM_SIZE);
+		map += bfr;
+	}
+	sprintf(bfr, "<memory type=\"ram\" start=\"0xe0000000\" length=\"0x%x\"/>", (u32)Memory::L1_CACHE_SIZE);
+	map += bfr;
+	map += "</memory-map>";
+
+	const u32 offset = gdb_read_hex(&i, ',');
+	const u32 length = gdb_read_hex(&i, '\0');
+	if (offset > map.size())
+		return gdb_reply("E01");
+
+	// The map has nothing that needs to be escaped for the binary reply
+	std::string reply = map.substr(offset, length);
+	reply.insert(0, offset + length >= map.size() ? "l" : "m");
+	gdb_reply(reply.c_str());
+}
+
 static void gdb_handle_query()
 {
 	DEBUG_LOG(GDB_STUB, "gdb: query '%s'\n", cmd_bfr+1);
 
-	if (!strcmp((const char *)(cmd_bfr+1), "TStatus"))
+	const char *query = (const char *)(cmd_bfr + 1);
+	if (!strcmp(query, "TStatus"))
 	{
 		return gdb_reply("T0");
 	}
+	if (!strncmp(query, "Supported", 9))
+	{
+		char bfr[64];
+		sprintf(bfr, "PacketSize=%x;qXfer:memory-map:read+", GDB_BFR_MAX - 4);
+		return gdb_reply(bfr);
+	}
+	static const char xfer_map[] = "Xfer:memory-map:read::";
+	if (!strncmp(query, xfer_map, sizeof xfer_map - 1))
+	{
+		return gdb_read_memory_map(sizeof xfer_map);
+	}
 
 	gdb_reply("");
 }
@@ -591,9 +698,9 @@ static void gdb_read_mem()
 		len = (len << 4) | hex2char(cmd_bfr[i++]);
 	DEBUG_LOG(GDB_STUB, "gdb: read memory: %08x bytes from %08x\n", len, addr);
 
-	if (len*2 > sizeof reply)
-		gdb_reply("E01");
-	u8 * data = Memory::GetPointer(addr);
+	if (len >= sizeof reply / 2)
+		return gdb_reply("E01");
+	u8 * data = Memory::GetRangePointer(addr, len);
 	if (!data)
 		return gdb_reply("E0");
 	mem2hex(reply, data, len);
@@ -617,13 +724,49 @@ static void gdb_write_mem()
 		len = (len << 4) | hex2char(cmd_bfr[i++]);
 	DEBUG_LOG(GDB_STUB, "gdb: write memory: %08x bytes to %08x\n", len, addr);
 
-	u8 * dst = Memory::GetPointer(addr);
+	if (i + 1 + len * 2 > cmd_len)
+		return gdb_reply("E01");
+	u8 * dst = Memory::GetRangePointer(addr, len);
 	if (!dst)
 		return gdb_reply("E00");
 	hex2mem(dst, cmd_bfr + i + 1, len);
 	gdb_reply("OK");
 }
 
+// Like gdb_write_mem, with the data in binary, which halves the size of
+// uploads
+static void gdb_write_mem_binary()
+{
+	u32 i = 1;
+	const u32 addr = gdb_read_hex(&i, ',');
+	const u32 len = gdb_read_hex(&i, ':');
+	DEBUG_LOG(GDB_STUB, "gdb: binary write memory: %08x bytes to %08x\n", len, addr);
+
+	// gdb checks whether the packet is supported with an empty one
+	if (len == 0)
+		return gdb_reply("OK");
+
+	u8 * dst = Memory::GetRangePointer(addr, len);
+	if (!dst)
+		return gdb_reply("E00");
+
+	u32 written = 0;
+	while (written < len && i < cmd_len)
+	{
+		u8 c = cmd_bfr[i++];
+		if (c == GDB_STUB_ESCAPE)
+		{
+			if (i == cmd_len)
+				break;
+			c = cmd_bfr[i++] ^ 0x20;
+		}
+		dst[written++] = c;
+	}
+	if (written != len)
+		return gdb_reply("E01");
+	gdb_reply("OK");
+}
+
 // forces a break on next instruction check
 void gdb_break()
 {
@@ -774,6 +917,11 @@ void gdb_handle_exception()
 				PowerPC::ppcState.iCache.Reset();
 				Host_UpdateDisasmDialog();
 				break;
+			case 'X':
+				gdb_write_mem_binary();
+				PowerPC::ppcState.iCache.Reset();
+				Host_UpdateDisasmDialog();
+				break;
 			case 's':
 				gdb_step();
 				return;
@@ -812,6 +960,7 @@ void gdb_init(u32 port)
 	memset(bp_r, 0, sizeof bp_r);
 	memset(bp_w, 0, sizeof bp_w);
 	memset(bp_a, 0, sizeof bp_a);
+	recv_pos = recv_len = 0;
 
 	tmpsock = socket(AF_INET, SOCK_STREAM, 0);
 	if (tmpsock == -1)
@@ -834,11 +983,24 @@ void gdb_init(u32 port)
 
 	INFO_LOG(GDB_STUB, "Waiting for gdb to connect...\n");
 
+	len = sizeof saddr_client;
 	sock = accept(tmpsock, (struct sockaddr *)&saddr_client, &len);
 	if (sock < 0)
 		ERROR_LOG(GDB_STUB, "Failed to accept gdb client");
 	INFO_LOG(GDB_STUB, "Client connected.\n");
 
+	// The ack and the reply are sent separately, without this they wait
+	// for the delayed ack of the host
+	on = 1;
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof on) < 0)
+		ERROR_LOG(GDB_STUB, "Failed to set TCP_NODELAY");
+#ifdef _WIN32
+	u_long nonblocking = 1;
+	ioctlsocket(sock, FIONBIO, &nonblocking);
+#else
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+#endif
+
 	saddr_client.sin_addr.s_addr = ntohl(saddr_client.sin_addr.s_addr);
 	/*if (((saddr_client.sin_addr.s_addr >> 24) & 0xff) != 127 ||
 	 *	    ((saddr_client.sin_addr.s_addr >> 16) & 0xff) !=   0 ||
@@ -9,6 +9,7 @@
 #include "../../Debugger/Debugger_SymbolMap.h"
 #include "../../Host.h"
 #include "../../IPC_HLE/WII_IPC_HLE.h"
+#include "../../Tracer.h"
 
 #ifdef USE_GDBSTUB
 #include "../GDBStub.h"
@@ -18,6 +19,29 @@
 
 namespace {
 	u32 last_pc;
+
+	// Basic blocks decoded for the fast loop of Run(), each instruction
+	// with its handler already looked up through the subtables. They are
+	// kept in a direct mapped table and invalidated like the JIT blocks.
+	const u32 BLOCK_CACHE_SIZE = 0x1000;
+	const u32 MAX_BLOCK_INSTRUCTIONS = 32;
+
+	struct DecodedInstruction
+	{
+		Interpreter::_interpreterInstruction handler;
+		UGeckoInstruction inst;
+		int cycles;
+		bool uses_fpu;
+	};
+
+	struct DecodedBlock
+	{
+		u32 address;
+		u32 num_instructions; // 0 for an empty slot
+		DecodedInstruction instructions[MAX_BLOCK_INSTRUCTIONS];
+	};
+
+	DecodedBlock block_cache[BLOCK_CACHE_SIZE];
 }
 
 bool Interpreter::m_EndBlock;
@@ -40,6 +64,7 @@ void Interpreter::Init()
 {
 	g_bReserve = false;
 	m_EndBlock = false;
+	ClearBlockCache();
 }
 
 void Interpreter::Shutdown()
@@ -92,6 +117,9 @@ void Trace( UGeckoInstruction &instCode )
 int Interpreter::SingleStepInner(void)
 {
 	static UGeckoInstruction instCode;
+	if (Tracer::IsRecording())
+		Tracer::Record();
+
 	u32 function = m_EndBlock ? HLE::GetFunctionIndex(PC) : 0; // Check for HLE functions after branches
 	if (function != 0)
 	{
@@ -196,6 +224,100 @@ int Interpreter::SingleStepInner(void)
 	return opinfo->numCyclesMinusOne + 1;
 }
 
+static const DecodedBlock& GetBlock(u32 address)
+{
+	DecodedBlock& block = block_cache[(address >> 2) & (BLOCK_CACHE_SIZE - 1)];
+	if (block.num_instructions && block.address == address)
+		return block;
+
+	block.address = address;
+	block.num_instructions = 0;
+	for (u32 pc = address; block.num_instructions < MAX_BLOCK_INSTRUCTIONS; pc += sizeof(UGeckoInstruction))
+	{
+		UGeckoInstruction inst(Memory::Read_Opcode(pc));
+		const GekkoOPInfo *opinfo = GetOpInfo(inst);
+		// Fetch failures and invalid instructions are left to SingleStepInner
+		if (inst.hex == 0 || !opinfo)
+			break;
+
+		DecodedInstruction& op = block.instructions[block.num_instructions++];
+		op.handler = GetInterpreterOp(inst);
+		op.inst = inst;
+		op.cycles = opinfo->numCyclesMinusOne + 1;
+		op.uses_fpu = PPCTables::UsesFPU(inst);
+		if (opinfo->flags & FL_ENDBLOCK)
+			break;
+	}
+	return block;
+}
+
+int Interpreter::RunBlock()
+{
+	const DecodedBlock& block = GetBlock(PC);
+	if (block.num_instructions == 0)
+		return SingleStepInner();
+
+	// Same as SingleStepInner, minus the HLE and debugging checks which
+	// don't apply in the fast loop. An instruction which invalidates the
+	// block empties it, that ends the loop as well.
+	int cycles = 0;
+	for (u32 i = 0; i < block.num_instructions; i++)
+	{
+		const DecodedInstruction& op = block.instructions[i];
+		const u32 next_pc = PC + sizeof(UGeckoInstruction);
+		NPC = next_pc;
+
+		if (op.uses_fpu && !((UReg_MSR&)MSR).FP)
+		{
+			Common::AtomicOr(PowerPC::ppcState.Exceptions, EXCEPTION_FPU_UNAVAILABLE);
+			PowerPC::CheckExceptions();
+			m_EndBlock = true;
+		}
+		else
+		{
+			op.handler(op.inst);
+			if (PowerPC::ppcState.Exceptions & EXCEPTION_DSI)
+			{
+				PowerPC::CheckExceptions();
+				m_EndBlock = true;
+			}
+		}
+
+		cycles += op.cycles;
+		last_pc = PC;
+		PC = NPC;
+		if (m_EndBlock || PC != next_pc)
+			break;
+	}
+	return cycles;
+}
+
+void Interpreter::InvalidateBlockCache(u32 address, u32 size)
+{
+	if (size > BLOCK_CACHE_SIZE * sizeof(UGeckoInstruction))
+	{
+		ClearBlockCache();
+		return;
+	}
+
+	// Blocks which start a little before the range can still reach into it
+	const u32 start = (address & ~3) - (MAX_BLOCK_INSTRUCTIONS - 1) * sizeof(UGeckoInstruction);
+	const u32 count = (size + 3) / 4 + MAX_BLOCK_INSTRUCTIONS - 1;
+	for (u32 i = 0; i < count; i++)
+	{
+		const u32 block_address = start + i * sizeof(UGeckoInstruction);
+		DecodedBlock& block = block_cache[(block_address >> 2) & (BLOCK_CACHE_SIZE - 1)];
+		if (block.address == block_address)
+			block.num_instructions = 0;
+	}
+}
+
+void Interpreter::ClearBlockCache()
+{
+	for (DecodedBlock& block : block_cache)
+		block.num_instructions = 0;
+}
+
 void Interpreter::SingleStep()
 {
 	SingleStepInner();
@@ -283,7 +405,10 @@ void Interpreter::Run()
 		}
 		else
 		{
-			// "fast" version of inner loop. well, it's not so fast.
+			// "fast" version of inner loop, which runs predecoded blocks.
+			// Instruction translation can change under them with the MMU.
+			const bool use_blocks = !SConfig::GetInstance().m_LocalCoreStartupParameter.bMMU && !startTrace &&
+				!Tracer::IsRecording();
 			while (CoreTiming::downcount > 0)
 			{
 				m_EndBlock = false;
@@ -291,7 +416,7 @@ void Interpreter::Run()
 				int cycles = 0;
 				while (!m_EndBlock)
 				{
-					cycles += SingleStepInner();
+					cycles += use_blocks ? RunBlock() : SingleStepInner();
 				}
 				CoreTiming::downcount -= cycles;
 			}
@@ -322,7 +447,7 @@ void Interpreter::unknown_instruction(UGeckoInstruction _inst)
 
 void Interpreter::ClearCache()
 {
-	// Do nothing.
+	ClearBlockCache();
 }
 
 const char *Interpreter::GetName()
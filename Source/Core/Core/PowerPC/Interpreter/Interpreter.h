@@ -23,9 +23,14 @@ public:
 	void Reset();
 	void SingleStep() override;
 	int SingleStepInner();
+	// Runs a predecoded basic block, for the fast loop of Run()
+	int RunBlock();
 
 	void Run() override;
 	void ClearCache() override;
+	// The predecoded blocks have to go whenever the code may have changed
+	static void InvalidateBlockCache(u32 address, u32 size);
+	static void ClearBlockCache();
 	const char *GetName() override;
 
 	typedef void (*_interpreterInstruction)(UGeckoInstruction instCode);
@@ -443,6 +443,8 @@ void Interpreter::icbi(UGeckoInstruction _inst)
 {
 	u32 address = Helper_Get_EA_X(_inst);
 	PowerPC::ppcState.iCache.Invalidate(address);
+	// That one doesn't get to the block caches when the cache is disabled
+	InvalidateBlockCache(address & ~0x1f, 32);
 }
 
 void Interpreter::lbzux(UGeckoInstruction _inst)
@@ -175,6 +175,9 @@ void Interpreter::mtmsr(UGeckoInstruction _inst)
 
 static void SetSR(int index, u32 value) {
 	DEBUG_LOG(POWERPC, "%08x: MMU: Segment register %i set to %08x", PowerPC::ppcState.pc, index, value);
+	// The translation cache copes on its own, but not the fastmem mirrors
+	if (Memory::bMMUFastmem && PowerPC::ppcState.sr[index] != value)
+		Memory::InvalidateTranslationCache();
 	PowerPC::ppcState.sr[index] = value;
 }
 
@@ -370,6 +373,14 @@ void Interpreter::mtspr(UGeckoInstruction _inst)
 		Memory::SDRUpdated();
 		break;
 	}
+
+	// The BATs (the upper four of which sit behind 560) and HID4, which
+	// enables those upper ones on the Wii
+	if ((iIndex == SPR_HID4 || (iIndex >= SPR_IBAT0U && iIndex < SPR_IBAT0U + 48)) &&
+	    oldValue != rSPR(iIndex))
+	{
+		Memory::InvalidateTranslationCache();
+	}
 }
 
 void Interpreter::crand(UGeckoInstruction _inst)
@@ -139,8 +139,8 @@ static GekkoOPTemplate table4_3[] =
 {
 	{6,  Interpreter::psq_lx,       {"psq_lx",   OPTYPE_PS, FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 	{7,  Interpreter::psq_stx,      {"psq_stx",  OPTYPE_PS, FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{38, Interpreter::psq_lux,      {"psq_lux",  OPTYPE_PS, FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{39, Interpreter::psq_stux,     {"psq_stux", OPTYPE_PS, FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{38, Interpreter::psq_lux,      {"psq_lux",  OPTYPE_PS, FL_OUT_A | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{39, Interpreter::psq_stux,     {"psq_stux", OPTYPE_PS, FL_OUT_A | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 };
 
 static GekkoOPTemplate table19[] =
@@ -241,14 +241,14 @@ static GekkoOPTemplate table31[] =
 
 	// fp load/store
 	{535, Interpreter::lfsx,        {"lfsx",  OPTYPE_LOADFP, FL_IN_A0 | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{567, Interpreter::lfsux,       {"lfsux", OPTYPE_LOADFP, FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{567, Interpreter::lfsux,       {"lfsux", OPTYPE_LOADFP, FL_OUT_A | FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 	{599, Interpreter::lfdx,        {"lfdx",  OPTYPE_LOADFP, FL_IN_A0 | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{631, Interpreter::lfdux,       {"lfdux", OPTYPE_LOADFP, FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{631, Interpreter::lfdux,       {"lfdux", OPTYPE_LOADFP, FL_OUT_A | FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 
 	{663, Interpreter::stfsx,       {"stfsx",  OPTYPE_STOREFP, FL_IN_A0 | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{695, Interpreter::stfsux,      {"stfsux", OPTYPE_STOREFP, FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{695, Interpreter::stfsux,      {"stfsux", OPTYPE_STOREFP, FL_OUT_A | FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 	{727, Interpreter::stfdx,       {"stfdx",  OPTYPE_STOREFP, FL_IN_A0 | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
-	{759, Interpreter::stfdux,      {"stfdux", OPTYPE_STOREFP, FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
+	{759, Interpreter::stfdux,      {"stfdux", OPTYPE_STOREFP, FL_OUT_A | FL_IN_A | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 	{983, Interpreter::stfiwx,      {"stfiwx", OPTYPE_STOREFP, FL_IN_A0 | FL_IN_B | FL_USE_FPU | FL_LOADSTORE, 0, 0, 0, 0}},
 
 	{19,  Interpreter::mfcr,        {"mfcr",   OPTYPE_SYSTEM, FL_OUT_D, 0, 0, 0, 0}},
@@ -269,7 +269,7 @@ static GekkoOPTemplate table31[] =
 	{982, Interpreter::icbi,        {"icbi",   OPTYPE_SYSTEM, FL_ENDBLOCK, 3, 0, 0, 0}},
 
 	// Unused instructions on GC
-	{310, Interpreter::eciwx,       {"eciwx",   OPTYPE_INTEGER, FL_RC_BIT, 0, 0, 0, 0}},
+	{310, Interpreter::eciwx,       {"eciwx",   OPTYPE_INTEGER, FL_OUT_D | FL_RC_BIT, 0, 0, 0, 0}},
 	{438, Interpreter::ecowx,       {"ecowx",   OPTYPE_INTEGER, FL_RC_BIT, 0, 0, 0, 0}},
 	{854, Interpreter::eieio,       {"eieio",   OPTYPE_INTEGER, FL_RC_BIT, 0, 0, 0, 0}},
 	{306, Interpreter::tlbie,       {"tlbie",   OPTYPE_SYSTEM, 0, 0, 0, 0, 0}},
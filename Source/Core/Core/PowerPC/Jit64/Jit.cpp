@@ -10,8 +10,12 @@
 #endif
 
 #include "Common.h"
+#include "PerfTrace.h"
+#include "FileUtil.h"
+#include "StringUtil.h"
 #include "../../HLE/HLE.h"
 #include "../../PatchEngine.h"
+#include "../../Tracer.h"
 #include "../Profiler.h"
 #include "Jit.h"
 #include "JitAsm.h"
@@ -140,11 +144,53 @@ ps_adds1
 
 static int CODE_SIZE = 1024*1024*32;
 
+enum
+{
+	NUM_CODE_REGIONS = 8,
+};
+static const int CODE_REGION_SIZE = CODE_SIZE / NUM_CODE_REGIONS;
+
+// Runs of a quickly compiled block before it gets the full compile
+static const int TIER_UP_RUNS = 128;
+
+// Bumped by every block on entry, to find the coldest region.
+// Halved on every eviction, so recent use weighs more.
+static u64 s_region_entries[NUM_CODE_REGIONS];
+
 namespace CPUCompare
 {
 	extern u32 m_BlockStart;
 }
 
+// Identifies the settings that change the code generated for a block, so the
+// persistent block cache only replays blocks compiled the same way.
+static u32 GetPersistentCacheSettings()
+{
+	const SCoreStartupParameter& p = Core::g_CoreStartupParameter;
+	u32 settings = 1; // version
+	settings |= p.bEnableFPRF << 8;
+	settings |= p.bFastmem << 9;
+	settings |= p.bMergeBlocks << 10;
+	settings |= p.bSkipIdle << 11;
+	settings |= p.bJITBlockLinking << 12;
+	settings |= p.bJITOff << 13;
+	settings |= p.bJITLoadStoreOff << 14;
+	settings |= p.bJITLoadStorelXzOff << 15;
+	settings |= p.bJITLoadStorelwzOff << 16;
+	settings |= p.bJITLoadStorelbzxOff << 17;
+	settings |= p.bJITLoadStoreFloatingOff << 18;
+	settings |= p.bJITLoadStorePairedOff << 19;
+	settings |= p.bJITFloatingPointOff << 20;
+	settings |= p.bJITIntegerOff << 21;
+	settings |= p.bJITPairedOff << 22;
+	settings |= p.bJITSystemRegistersOff << 23;
+	settings |= p.bJITBranchOff << 24;
+	settings |= p.bWii << 25;
+	settings |= p.bJITInlineLeafFunctions << 26;
+	settings |= p.bJITFastInterrupts << 27;
+	return settings;
+}
+
 void Jit64::Init()
 {
 	jo.optimizeStack = true;
@@ -152,24 +198,21 @@ void Jit64::Init()
 	   be as stable as the alternative (to not link the blocks). However, I have not heard about any good examples
 	   where this cause problems, so I'm enabling this by default, since I seem to get perhaps as much as 20% more
 	   fps with this option enabled. If you suspect that this option cause problems you can also disable it from the
-	   debugging window. */
+	   debugging window. Linking stays on when debugging: breakpoint checks are only compiled in at the
+	   breakpointed instructions, and adding or removing one destroys and unlinks the blocks containing it. */
 	if (Core::g_CoreStartupParameter.bEnableDebugging)
+		Core::g_CoreStartupParameter.bSkipIdle = false;
+	if (!Core::g_CoreStartupParameter.bJITBlockLinking)
 	{
 		jo.enableBlocklink = false;
-		Core::g_CoreStartupParameter.bSkipIdle = false;
 	}
 	else
-	{
-		if (!Core::g_CoreStartupParameter.bJITBlockLinking)
-		{
-			jo.enableBlocklink = false;
-		}
-		else
-			jo.enableBlocklink = !Core::g_CoreStartupParameter.bMMU;
-	}
+		jo.enableBlocklink = !Core::g_CoreStartupParameter.bMMU;
 	jo.fpAccurateFcmp = Core::g_CoreStartupParameter.bEnableFPRF;
 	jo.optimizeGatherPipe = true;
-	jo.fastInterrupts = false;
+	// External interrupts force the slice to end when they are raised
+	// instead of being tested after every store to the FIFO
+	jo.fastInterrupts = Core::g_CoreStartupParameter.bJITFastInterrupts;
 	jo.accurateSinglePrecision = true;
 	js.memcheck = Core::g_CoreStartupParameter.bMMU;
 
@@ -178,9 +221,50 @@ void Jit64::Init()
 
 	trampolines.Init();
 	AllocCodeSpace(CODE_SIZE);
+	code_region = 0;
+	memset(s_region_entries, 0, sizeof(s_region_entries));
 
 	blocks.Init();
 	asm_routines.Init();
+
+	// The block list is replayed on the first compile, once the game code is in memory.
+	warm_up_pending = false;
+	if (Core::g_CoreStartupParameter.bJITPersistentCache &&
+	    !Core::g_CoreStartupParameter.bMMU && !Core::g_CoreStartupParameter.bEnableDebugging &&
+	    !Core::g_CoreStartupParameter.m_strUniqueID.empty())
+	{
+		if (!File::Exists(File::GetUserPath(D_CACHE_IDX)))
+			File::CreateDir(File::GetUserPath(D_CACHE_IDX).c_str());
+
+		std::string filename = StringFromFormat("%sjit64-%s-blocks.cache", File::GetUserPath(D_CACHE_IDX).c_str(),
+			Core::g_CoreStartupParameter.m_strUniqueID.c_str());
+		blocks.OpenPersistentCache(filename, GetPersistentCacheSettings());
+		warm_up_pending = true;
+	}
+}
+
+void Jit64::WarmUpBlockCache()
+{
+	std::vector<u32> addresses;
+	blocks.GetPersistentBlocks(addresses);
+
+	u32 compiled = 0;
+	for (u32 address : addresses)
+	{
+		// Never let the warm-up flush the cache, whatever didn't fit is compiled on demand.
+		if (GetRegionSpaceLeft() < 0x20000 || blocks.IsFull())
+			break;
+
+		if (blocks.GetBlockNumberFromStartAddress(address) != -1)
+			continue;
+
+		int block_num = blocks.AllocateBlock(address);
+		JitBlock *b = blocks.GetBlock(block_num);
+		blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(address, &code_buffer, b));
+		compiled++;
+	}
+
+	NOTICE_LOG(DYNA_REC, "JIT64: warmed up %u of %u persistent blocks", compiled, (u32)addresses.size());
 }
 
 void Jit64::ClearCache()
@@ -188,10 +272,81 @@ void Jit64::ClearCache()
 	blocks.Clear();
 	trampolines.ClearCodeSpace();
 	ClearCodeSpace();
+	code_region = 0;
+	memset(s_region_entries, 0, sizeof(s_region_entries));
+	hot_blocks.clear();
+}
+
+static void TierUpBlock(u32 em_address)
+{
+	static_cast<Jit64*>(jit)->TierUpBlock(em_address);
+}
+
+void Jit64::TierUpBlock(u32 em_address)
+{
+	hot_blocks.insert(em_address);
+	int block_num = blocks.GetBlockNumberFromStartAddress(em_address);
+	if (block_num != -1)
+		blocks.DestroyBlock(block_num, false);
+}
+
+// Instructions which neither end a block nor need anything from the block
+// around them, so they can go to the interpreter in a quick block.
+static bool IsInterpretedInQuickBlock(const GekkoOPInfo* opinfo)
+{
+	if (opinfo->flags & FL_ENDBLOCK)
+		return false;
+
+	switch (opinfo->type)
+	{
+	case OPTYPE_INTEGER:
+	case OPTYPE_CR:
+	case OPTYPE_LOAD:
+	case OPTYPE_STORE:
+	case OPTYPE_LOADFP:
+	case OPTYPE_STOREFP:
+	case OPTYPE_FPU:
+	case OPTYPE_PS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+size_t Jit64::GetRegionSpaceLeft() const
+{
+	return region + (code_region + 1) * CODE_REGION_SIZE - GetCodePtr();
+}
+
+void Jit64::EvictColdRegion()
+{
+	int coldest = -1;
+	for (int i = 0; i < NUM_CODE_REGIONS; i++)
+	{
+		if (i != code_region && (coldest == -1 || s_region_entries[i] < s_region_entries[coldest]))
+			coldest = i;
+	}
+
+	u8* start = region + coldest * CODE_REGION_SIZE;
+	int evicted = blocks.EvictBlocks(start, start + CODE_REGION_SIZE);
+	DEBUG_LOG(DYNA_REC, "JIT64: evicted %d blocks of code region %d", evicted, coldest);
+
+	memset(GetWritableView(start), 0xCC, CODE_REGION_SIZE);
+	SetCodePtr(start);
+	code_region = coldest;
+
+	for (u64& entries : s_region_entries)
+		entries /= 2;
+	s_region_entries[coldest] = 0;
+
+	// Only happens if the region held hardly any blocks
+	if (blocks.IsFull())
+		ClearCache();
 }
 
 void Jit64::Shutdown()
 {
+	blocks.ClosePersistentCache();
 	FreeCodeSpace();
 
 	blocks.Shutdown();
@@ -211,6 +366,8 @@ void Jit64::WriteCallInterpreter(UGeckoInstruction inst)
 	}
 	Interpreter::_interpreterInstruction instr = GetInterpreterOp(inst);
 	ABI_CallFunctionC((void*)instr, inst.hex);
+	// The interpreter may have switched the FPU mode behind our back
+	js.fpuMode = -1;
 }
 
 void Jit64::unknown_instruction(UGeckoInstruction inst)
@@ -228,6 +385,7 @@ void Jit64::HLEFunction(UGeckoInstruction _inst)
 	gpr.Flush(FLUSH_ALL);
 	fpr.Flush(FLUSH_ALL);
 	ABI_CallFunctionCC((void*)&HLE::Execute, js.compilerPC, _inst.hex);
+	js.fpuMode = -1;
 }
 
 void Jit64::DoNothing(UGeckoInstruction _inst)
@@ -289,21 +447,28 @@ void Jit64::WriteExit(u32 destination)
 	linkData.exitPtrs = GetWritableCodePtr();
 	linkData.linkStatus = false;
 
-	// Link opportunity!
-	int block; 
-	if (jo.enableBlocklink && (block = blocks.GetBlockNumberFromStartAddress(destination)) >= 0)
-	{
-		// It exists! Joy of joy!
-		JMP(blocks.GetBlock(block)->checkedEntry, true);
-		linkData.linkStatus = true;
-	}
-	else
+	// Always emit the unlinked exit, FinalizeBlock links it. This leaves room
+	// to unlink it again when the destination block is evicted.
+	MOV(32, M(&PC), Imm32(destination));
+	JMP(asm_routines.dispatcher, true);
+
+	b->linkData.push_back(linkData);
+}
+
+// Exit of a taken guest branch. A busy-wait loop that branches back to its
+// start waits for the next event, which gives the same result as spinning
+// until it happens.
+void Jit64::WriteBranchExit(u32 destination)
+{
+	if (!js.st.isIdleLoop || destination != js.blockStart)
 	{
-		MOV(32, M(&PC), Imm32(destination));
-		JMP(asm_routines.dispatcher, true);
+		WriteExit(destination);
+		return;
 	}
 
-	b->linkData.push_back(linkData);
+	ABI_CallFunction((void *)&CoreTiming::Idle);
+	MOV(32, M(&PC), Imm32(destination));
+	WriteExceptionExit();
 }
 
 void Jit64::WriteExitDestInEAX()
@@ -352,8 +517,12 @@ void STACKALIGN Jit64::Run()
 
 void Jit64::SingleStep()
 {
+	// The block for a step holds a single instruction and no breakpoint
+	// check, don't keep it around for when the game runs again
+	const u32 address = PC;
 	CompiledCode pExecAddr = (CompiledCode)asm_routines.enterCode;
 	pExecAddr();
+	blocks.InvalidateICache(address, 4);
 }
 
 void Jit64::Trace()
@@ -387,14 +556,33 @@ void Jit64::Trace()
 
 void STACKALIGN Jit64::Jit(u32 em_address)
 {
-	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
+	PERF_SCOPE(CAT_JIT_COMPILE);
+
+	if (warm_up_pending)
+	{
+		warm_up_pending = false;
+		WarmUpBlockCache();
+
+		// The block we were asked for may be among the warmed up ones.
+		if (blocks.GetBlockNumberFromStartAddress(em_address) != -1)
+			return;
+	}
+
+	// The trampolines of backpatched blocks can't be evicted with them
+	if (trampolines.GetSpaceLeft() < 0x10000 || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
 	}
+	else if (GetRegionSpaceLeft() < 0x10000 || blocks.IsFull())
+	{
+		EvictColdRegion();
+	}
 
 	int block_num = blocks.AllocateBlock(em_address);
 	JitBlock *b = blocks.GetBlock(block_num);
-	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b));
+	// A block compiled for a single step must return to the dispatcher after it
+	const bool link = jo.enableBlocklink && GetState() != CPU_STEPPING;
+	blocks.FinalizeBlock(block_num, link, DoJit(em_address, &code_buffer, b));
 }
 
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlock *b)
@@ -474,16 +662,44 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	if (ImHereDebug)
 		ABI_CallFunction((void *)&ImHere); //Used to get a trace of the last few blocks before a crash, sometimes VERY useful
 
+	// Nothing is cached in host registers yet
+	if (Tracer::IsRecording())
+	{
+		MOV(32, M(&PC), Imm32(js.blockStart));
+		ABI_CallFunction((void *)&Tracer::Record);
+	}
+
+#ifdef _M_X64
+	ADD(64, M(&s_region_entries[code_region]), Imm8(1));
+#else
+	ADD(32, M(&s_region_entries[code_region]), Imm8(1));
+	ADC(32, M((u8*)&s_region_entries[code_region] + 4), Imm8(0));
+#endif
+
+	quick_block = Core::g_CoreStartupParameter.bJITTieredCompilation &&
+		!Core::g_CoreStartupParameter.bEnableDebugging && !hot_blocks.count(em_address);
+	if (quick_block)
+	{
+		b->tierUpCounter = TIER_UP_RUNS;
+#ifdef _M_X64
+		MOV(64, R(RAX), ImmPtr(&b->tierUpCounter));
+		SUB(32, MatR(RAX), Imm8(1));
+#else
+		SUB(32, M(&b->tierUpCounter), Imm8(1));
+#endif
+		FixupBranch cold = J_CC(CC_NZ);
+		ABI_CallFunctionC((void *)&::TierUpBlock, js.blockStart);
+		MOV(32, M(&PC), Imm32(js.blockStart));
+		JMP(asm_routines.dispatcherNoCheck, true);
+		SetJumpTarget(cold);
+	}
+
 	// Conditionally add profiling code.
 	if (Profiler::g_ProfileBlocks) {
-		ADD(32, M(&b->runCount), Imm8(1));
-#ifdef _WIN32
+		PROFILER_INCREMENT(&b->runCount);
 		b->ticCounter = 0;
 		b->ticStart = 0;
 		b->ticStop = 0;
-#else
-//TODO
-#endif
 		// get start tic
 		PROFILER_QUERY_PERFORMANCE_COUNTER(&b->ticStart);
 	}
@@ -508,6 +724,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	}
 
 	js.skipnext = false;
+	js.fpuMode = -1;
 	js.blockSize = size;
 	js.compilerPC = nextPC;
 	// Translate instructions
@@ -541,9 +758,11 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 			js.next_compilerPC = ops[i + 1].address;
 		}
 
-		if (jo.optimizeGatherPipe && js.fifoBytesThisBlock >= 32)
+		// The pipe has room for GATHER_PIPE_SIZE * 16 bytes, so the inlined writes can
+		// let a few bursts pile up before paying for the call.
+		if (jo.optimizeGatherPipe && js.fifoBytesThisBlock >= GPFifo::GATHER_PIPE_SIZE * 4)
 		{
-			js.fifoBytesThisBlock -= 32;
+			js.fifoBytesThisBlock = 0;
 			MOV(32, M(&PC), Imm32(jit->js.compilerPC)); // Helps external systems know which instruction triggered the write
 			u32 registersInUse = RegistersInUse();
 			ABI_PushRegistersAndAdjustStack(registersInUse, false);
@@ -595,7 +814,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 			}
 
 			// Add an external exception check if the instruction writes to the FIFO.
-			if (jit->js.fifoWriteAddresses.find(ops[i].address) != jit->js.fifoWriteAddresses.end())
+			if (!jo.fastInterrupts && jit->js.fifoWriteAddresses.find(ops[i].address) != jit->js.fifoWriteAddresses.end())
 			{
 				gpr.Flush(FLUSH_ALL);
 				fpr.Flush(FLUSH_ALL);
@@ -628,11 +847,16 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 				TEST(32, M((void*)PowerPC::GetStatePtr()), Imm32(0xFFFFFFFF));
 				FixupBranch noBreakpoint = J_CC(CC_Z);
 
-				WriteExit(ops[i].address);
+				// Not a linkable exit, that would jump straight back into the breakpoint
+				MOV(32, R(EAX), Imm32(ops[i].address));
+				WriteExitDestInEAX();
 				SetJumpTarget(noBreakpoint);
 			}
 
-			Jit64Tables::CompileInstruction(ops[i]);
+			if (quick_block && IsInterpretedInQuickBlock(opinfo))
+				Default(ops[i].inst);
+			else
+				Jit64Tables::CompileInstruction(ops[i]);
 
 			if (js.memcheck && (opinfo->flags & FL_LOADSTORE))
 			{
@@ -716,6 +940,8 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	b->flags = js.block_flags;
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = size;
+	blocks.FindInlinedRanges(*b, ops, size);
+	b->downcountAmount = js.downcountAmount;
 
 #ifdef JIT_LOG_X86
 	LogGeneratedX86(size, code_buf, normalEntry, b);
@@ -18,6 +18,8 @@
 // ----------
 #pragma once
 
+#include <set>
+
 #include "../JitCommon/JitBackpatch.h"
 #include "../JitCommon/JitBase.h"
 #include "../JitCommon/JitCache.h"
@@ -47,8 +49,25 @@ private:
 	PPCAnalyst::CodeBuffer code_buffer;
 	Jit64AsmRoutineManager asm_routines;
 
+	// Set when the persistent block cache still has to be replayed.
+	bool warm_up_pending;
+	void WarmUpBlockCache();
+
+	// The code space is split into regions which are filled one after the
+	// other. Once the current one is full, the least used of the others is
+	// evicted and filled next, so that the hot blocks survive.
+	int code_region;
+	size_t GetRegionSpaceLeft() const;
+	void EvictColdRegion();
+
+	// With tiered compilation, blocks are first compiled quickly with most
+	// instructions falling back to the interpreter, and get the full compile
+	// once they ran often enough.
+	bool quick_block;
+	std::set<u32> hot_blocks; // start addresses of the blocks which tiered up
+
 public:
-	Jit64() : code_buffer(32000) {}
+	Jit64() : code_buffer(32000), warm_up_pending(false), code_region(0), quick_block(false) {}
 	~Jit64() {}
 
 	void Init() override;
@@ -67,6 +86,10 @@ public:
 
 	void ClearCache() override;
 
+	// Called by a quickly compiled block when it's hot, destroys it so that
+	// it gets the full compile on the next dispatch.
+	void TierUpBlock(u32 em_address);
+
 	const u8 *GetDispatcher() {
 		return asm_routines.dispatcher;
 	}
@@ -89,6 +112,7 @@ public:
 	// Utilities for use by opcodes
 
 	void WriteExit(u32 destination);
+	void WriteBranchExit(u32 destination);
 	void WriteExitDestInEAX();
 	void WriteExceptionExit();
 	void WriteExternalExceptionExit();
@@ -104,11 +128,15 @@ public:
 	void GenerateCarry();
 	void GenerateRC();
 	void ComputeRC(const Gen::OpArg & arg);
+	void GenQuantizedLoad(bool single, EQuantizeType type, int scale);
+	void SetFPUMode(int mode);
 
-	void tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg));
+	void tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg),
+	            void (XEmitter::*avxOp)(Gen::X64Reg, Gen::X64Reg, Gen::OpArg));
 	typedef u32 (*Operation)(u32 a, u32 b);
 	void regimmop(int d, int a, bool binary, u32 value, Operation doop, void (XEmitter::*op)(int, const Gen::OpArg&, const Gen::OpArg&), bool Rc = false, bool carry = false);
-	void fp_tri_op(int d, int a, int b, bool reversible, bool single, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg));
+	void fp_tri_op(int d, int a, int b, bool reversible, bool single, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg),
+	               void (XEmitter::*avxOp)(Gen::X64Reg, Gen::X64Reg, Gen::OpArg));
 
 	// OPCODES
 	void unknown_instruction(UGeckoInstruction _inst);
@@ -155,6 +183,9 @@ public:
 	void mfcr(UGeckoInstruction inst);
 	void mcrf(UGeckoInstruction inst);
 	void mcrxr(UGeckoInstruction inst);
+	void mtfsb0x(UGeckoInstruction inst);
+	void mtfsb1x(UGeckoInstruction inst);
+	void mtfsfix(UGeckoInstruction inst);
 
 	void boolX(UGeckoInstruction inst);
 	void crXXX(UGeckoInstruction inst);
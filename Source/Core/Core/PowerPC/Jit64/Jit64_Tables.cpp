@@ -346,9 +346,9 @@ static GekkoOPTemplate table63[] =
 
 	{64,  &Jit64::Default}, //"mcrfs",   OPTYPE_SYSTEMFP, 0}},
 	{583, &Jit64::Default}, //"mffsx",   OPTYPE_SYSTEMFP, 0}},
-	{70,  &Jit64::Default}, //"mtfsb0x", OPTYPE_SYSTEMFP, 0, 2}},
-	{38,  &Jit64::Default}, //"mtfsb1x", OPTYPE_SYSTEMFP, 0, 2}},
-	{134, &Jit64::Default}, //"mtfsfix", OPTYPE_SYSTEMFP, 0, 2}},
+	{70,  &Jit64::mtfsb0x}, //"mtfsb0x", OPTYPE_SYSTEMFP, 0, 2}},
+	{38,  &Jit64::mtfsb1x}, //"mtfsb1x", OPTYPE_SYSTEMFP, 0, 2}},
+	{134, &Jit64::mtfsfix}, //"mtfsfix", OPTYPE_SYSTEMFP, 0, 2}},
 	{711, &Jit64::Default}, //"mtfsfx",  OPTYPE_SYSTEMFP, 0, 2}},
 };
 
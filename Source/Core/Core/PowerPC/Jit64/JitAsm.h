@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "JitRegister.h"
 #include "../JitCommon/JitAsmCommon.h"
 
 // In Dolphin, we don't use inline assembly. Instead, we generate all machine-near
@@ -30,6 +31,7 @@ public:
 	void Init() {
 		AllocCodeSpace(8192);
 		Generate();
+		JitRegister::Register(region, GetCodePtr() - region, "JIT_Asm_Jit64");
 		WriteProtect();
 	}
 
@@ -13,7 +13,8 @@ static const u64 GC_ALIGNED16(psAbsMask2[2])  = {0x7FFFFFFFFFFFFFFFULL, 0x7FFFFF
 static const double GC_ALIGNED16(psOneOne2[2]) = {1.0, 1.0};
 static const double one_const = 1.0f;
 
-void Jit64::fp_tri_op(int d, int a, int b, bool reversible, bool single, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg))
+void Jit64::fp_tri_op(int d, int a, int b, bool reversible, bool single, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg),
+                      void (XEmitter::*avxOp)(Gen::X64Reg, Gen::X64Reg, Gen::OpArg))
 {
 	fpr.Lock(d, a, b);
 	if (d == a)
@@ -25,24 +26,29 @@ void Jit64::fp_tri_op(int d, int a, int b, bool reversible, bool single, void (X
 		}
 		(this->*op)(fpr.RX(d), fpr.R(b));
 	}
-	else if (d == b)
+	else if (d == b && reversible)
 	{
-		if (reversible)
-		{
-			fpr.BindToRegister(d, true);
-			if(!single)
-			{
-				fpr.BindToRegister(a, true, false);
-			}
-			(this->*op)(fpr.RX(d), fpr.R(a));
-		}
-		else
+		fpr.BindToRegister(d, true);
+		if(!single)
 		{
-			MOVSD(XMM0, fpr.R(b));
-			fpr.BindToRegister(d, !single);
-			MOVSD(fpr.RX(d), fpr.R(a));
-			(this->*op)(fpr.RX(d), Gen::R(XMM0));
+			fpr.BindToRegister(a, true, false);
 		}
+		(this->*op)(fpr.RX(d), fpr.R(a));
+	}
+	else if (single && cpu_info.bAVX)
+	{
+		// The three operand form copies the upper half of a, which doesn't
+		// matter as single results get duplicated below
+		fpr.BindToRegister(a, true, false);
+		fpr.BindToRegister(d, d == b);
+		(this->*avxOp)(fpr.RX(d), fpr.RX(a), fpr.R(b));
+	}
+	else if (d == b)
+	{
+		MOVSD(XMM0, fpr.R(b));
+		fpr.BindToRegister(d, !single);
+		MOVSD(fpr.RX(d), fpr.R(a));
+		(this->*op)(fpr.RX(d), Gen::R(XMM0));
 	}
 	else
 	{
@@ -88,10 +94,10 @@ void Jit64::fp_arith(UGeckoInstruction inst)
 	bool single = inst.OPCD == 59;
 	switch (inst.SUBOP5)
 	{
-	case 18: fp_tri_op(inst.FD, inst.FA, inst.FB, false, single, &XEmitter::DIVSD); break; //div
-	case 20: fp_tri_op(inst.FD, inst.FA, inst.FB, false, single, &XEmitter::SUBSD); break; //sub
-	case 21: fp_tri_op(inst.FD, inst.FA, inst.FB, true,  single, &XEmitter::ADDSD); break; //add
-	case 25: fp_tri_op(inst.FD, inst.FA, inst.FC, true, single, &XEmitter::MULSD); break; //mul
+	case 18: fp_tri_op(inst.FD, inst.FA, inst.FB, false, single, &XEmitter::DIVSD, &XEmitter::VDIVSD); break; //div
+	case 20: fp_tri_op(inst.FD, inst.FA, inst.FB, false, single, &XEmitter::SUBSD, &XEmitter::VSUBSD); break; //sub
+	case 21: fp_tri_op(inst.FD, inst.FA, inst.FB, true,  single, &XEmitter::ADDSD, &XEmitter::VADDSD); break; //add
+	case 25: fp_tri_op(inst.FD, inst.FA, inst.FC, true,  single, &XEmitter::MULSD, &XEmitter::VMULSD); break; //mul
 	default:
 		_assert_msg_(DYNA_REC, 0, "fp_arith WTF!!!");
 	}
@@ -132,27 +138,42 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
 	int d = inst.FD;
 
 	fpr.Lock(a, b, c, d);
-	MOVSD(XMM0, fpr.R(a));
-	switch (inst.SUBOP5)
+	if (cpu_info.bFMA)
 	{
-	case 28: //msub
-		MULSD(XMM0, fpr.R(c));
-		SUBSD(XMM0, fpr.R(b));
-		break;
-	case 29: //madd
-		MULSD(XMM0, fpr.R(c));
-		ADDSD(XMM0, fpr.R(b));
-		break;
-	case 30: //nmsub
-		MULSD(XMM0, fpr.R(c));
-		SUBSD(XMM0, fpr.R(b));
-		XORPD(XMM0, M((void*)&psSignBits2));
-		break;
-	case 31: //nmadd
-		MULSD(XMM0, fpr.R(c));
-		ADDSD(XMM0, fpr.R(b));
-		XORPD(XMM0, M((void*)&psSignBits2));
-		break;
+		// Rounded once, like on the real CPU
+		fpr.BindToRegister(c, true, false);
+		MOVSD(XMM0, fpr.R(a));
+		if (inst.SUBOP5 == 28 || inst.SUBOP5 == 30)
+			VFMSUB213SD(XMM0, fpr.RX(c), fpr.R(b));
+		else
+			VFMADD213SD(XMM0, fpr.RX(c), fpr.R(b));
+		if (inst.SUBOP5 == 30 || inst.SUBOP5 == 31)
+			XORPD(XMM0, M((void*)&psSignBits2));
+	}
+	else
+	{
+		MOVSD(XMM0, fpr.R(a));
+		switch (inst.SUBOP5)
+		{
+		case 28: //msub
+			MULSD(XMM0, fpr.R(c));
+			SUBSD(XMM0, fpr.R(b));
+			break;
+		case 29: //madd
+			MULSD(XMM0, fpr.R(c));
+			ADDSD(XMM0, fpr.R(b));
+			break;
+		case 30: //nmsub
+			MULSD(XMM0, fpr.R(c));
+			SUBSD(XMM0, fpr.R(b));
+			XORPD(XMM0, M((void*)&psSignBits2));
+			break;
+		case 31: //nmadd
+			MULSD(XMM0, fpr.R(c));
+			ADDSD(XMM0, fpr.R(b));
+			XORPD(XMM0, M((void*)&psSignBits2));
+			break;
+		}
 	}
 	fpr.BindToRegister(d, false);
 	//YES it is necessary to dupe the result :(
@@ -400,7 +400,7 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 						destination = SignExt16(js.next_inst.BD << 2);
 					else
 						destination = js.next_compilerPC + SignExt16(js.next_inst.BD << 2);
-					WriteExit(destination);
+					WriteBranchExit(destination);
 				}
 				else if ((js.next_inst.OPCD == 19) && (js.next_inst.SUBOP10 == 528)) // bcctrx
 				{
@@ -482,22 +482,32 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 
 			gpr.Flush(FLUSH_ALL);
 			fpr.Flush(FLUSH_ALL);
-			FixupBranch pLesser  = J_CC(less_than);
-			FixupBranch pGreater = J_CC(greater_than);
-			MOV(8, M(&PowerPC::ppcState.cr_fast[crf]), Imm8(0x2));  //  == 0
-			FixupBranch continue1 = J();
 
-			SetJumpTarget(pGreater);
-			MOV(8, M(&PowerPC::ppcState.cr_fast[crf]), Imm8(0x4));  //  > 0
-			FixupBranch continue2 = J();
+			// The branch exits the block, so the CR field still has to be written, but
+			// MOV and CMOV leave the flags alone: build it without branching and then
+			// branch once on the flags of the compare.
+			MOV(32, R(EAX), Imm32(0x2));  //  == 0
+			MOV(32, R(ECX), Imm32(0x4));  //  > 0
+			CMOVcc(32, EAX, R(ECX), greater_than);
+			MOV(32, R(ECX), Imm32(0x8));  //  < 0
+			CMOVcc(32, EAX, R(ECX), less_than);
+			MOV(8, M(&PowerPC::ppcState.cr_fast[crf]), R(AL));
+
+			// SO is never set by the compare, so a branch on it is decided here.
+			bool test_so = test_bit == 1;
+			FixupBranch not_taken;
+			if (!test_so)
+			{
+				CCFlags bit_set = test_bit == 8 ? less_than : (test_bit == 4 ? greater_than : CC_E);
+				// condition is true when branching needs the bit clear
+				not_taken = J_CC(condition ? bit_set : (CCFlags)(bit_set ^ 1), true);
+			}
 
-			SetJumpTarget(pLesser);
-			MOV(8, M(&PowerPC::ppcState.cr_fast[crf]), Imm8(0x8));  //  < 0
-			FixupBranch continue3;
-			if (!!(8 & test_bit) == condition) continue3 = J();
-			if (!!(4 & test_bit) != condition) SetJumpTarget(continue2);
-			if (!!(2 & test_bit) != condition) SetJumpTarget(continue1);
-			if (js.next_inst.OPCD == 16) // bcx
+			if (test_so && !condition)
+			{
+				// Never taken
+			}
+			else if (js.next_inst.OPCD == 16) // bcx
 			{
 				if (js.next_inst.LK)
 					MOV(32, M(&LR), Imm32(js.compilerPC + 4));
@@ -507,7 +517,7 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 					destination = SignExt16(js.next_inst.BD << 2);
 				else
 					destination = js.next_compilerPC + SignExt16(js.next_inst.BD << 2);
-				WriteExit(destination);
+				WriteBranchExit(destination);
 			}
 			else if ((js.next_inst.OPCD == 19) && (js.next_inst.SUBOP10 == 528)) // bcctrx
 			{
@@ -530,9 +540,8 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 				PanicAlert("WTF invalid branch");
 			}
 
-			if (!!(8 & test_bit) == condition) SetJumpTarget(continue3);
-			if (!!(4 & test_bit) == condition) SetJumpTarget(continue2);
-			if (!!(2 & test_bit) == condition) SetJumpTarget(continue1);
+			if (!test_so)
+				SetJumpTarget(not_taken);
 
 			WriteExit(js.next_compilerPC + 4);
 
@@ -163,9 +163,11 @@ void Jit64::lXXx(UGeckoInstruction inst)
 	}
 	else
 	{
-		if ((inst.OPCD != 31) && gpr.R(a).IsImm() && !js.memcheck)
+		// The analyst may know RA even after the register cache flushed its immediate
+		bool constA = gpr.R(a).IsImm() || js.op->hasConstA;
+		if ((inst.OPCD != 31) && constA && !js.memcheck)
 		{
-			u32 val = (u32)gpr.R(a).offset + (s32)inst.SIMM_16;
+			u32 val = (gpr.R(a).IsImm() ? (u32)gpr.R(a).offset : js.op->constA) + (s32)inst.SIMM_16;
 			opAddress = Imm32(val);
 			if (update && !js.memcheck)
 				gpr.SetImmediate32(a, val);
@@ -274,11 +276,13 @@ void Jit64::stX(UGeckoInstruction inst)
 		default: _assert_msg_(DYNA_REC, 0, "AWETKLJASDLKF"); return;
 		}
 
-		if ((a == 0) || gpr.R(a).IsImm())
+		// The analyst may know RA even after the register cache flushed its immediate
+		bool constA = a && (gpr.R(a).IsImm() || js.op->hasConstA);
+		if ((a == 0) || constA)
 		{
 			// If we already know the address through constant folding, we can do some
 			// fun tricks...
-			u32 addr = ((a == 0) ? 0 : (u32)gpr.R(a).offset);
+			u32 addr = ((a == 0) ? 0 : (gpr.R(a).IsImm() ? (u32)gpr.R(a).offset : js.op->constA));
 			addr += offset;
 			if ((addr & 0xFFFFF000) == 0xCC008000 && jo.optimizeGatherPipe)
 			{
@@ -287,19 +291,13 @@ void Jit64::stX(UGeckoInstruction inst)
 				MOV(32, R(ABI_PARAM1), gpr.R(s));
 				if (update)
 					gpr.SetImmediate32(a, addr);
-				switch (accessSize)
-				{
-					// No need to protect these, they don't touch any state
-					// question - should we inline them instead? Pro: Lose a CALL   Con: Code bloat
-				case 8:  CALL((void *)asm_routines.fifoDirectWrite8);  break;
-				case 16: CALL((void *)asm_routines.fifoDirectWrite16); break;
-				case 32: CALL((void *)asm_routines.fifoDirectWrite32); break;
-				}
+				// No need to protect this, it doesn't touch any state
+				WriteToGatherPipe(accessSize, ABI_PARAM1);
 				js.fifoBytesThisBlock += accessSize >> 3;
 				gpr.UnlockAllX();
 				return;
 			}
-			else if (Memory::IsRAMAddress(addr))
+			else if (Memory::IsRAMAddress(addr) && !Memory::HasMemChecks())
 			{
 				MOV(32, R(EAX), gpr.R(s));
 				BSWAP(accessSize, EAX);
@@ -327,7 +325,8 @@ void Jit64::stX(UGeckoInstruction inst)
 		}
 
 		// Optimized stack access?
-		if (accessSize == 32 && !gpr.R(a).IsImm() && a == 1 && js.st.isFirstBlockOfFunction && jo.optimizeStack)
+		if (accessSize == 32 && !gpr.R(a).IsImm() && a == 1 && js.st.isFirstBlockOfFunction && jo.optimizeStack &&
+		    !Memory::HasMemChecks())
 		{
 			gpr.FlushLockX(ABI_PARAM1);
 			MOV(32, R(ABI_PARAM1), gpr.R(a));
@@ -437,6 +436,9 @@ void Jit64::lmw(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStoreOff)
 
+	// These access RAM directly
+	if (Memory::HasMemChecks()) { Default(inst); return; }
+
 #ifdef _M_X64
 	gpr.FlushLockX(ECX);
 	MOV(32, R(EAX), Imm32((u32)(s32)inst.SIMM_16));
@@ -460,6 +462,9 @@ void Jit64::stmw(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStoreOff)
 
+	// These access RAM directly
+	if (Memory::HasMemChecks()) { Default(inst); return; }
+
 #ifdef _M_X64
 	gpr.FlushLockX(ECX);
 	MOV(32, R(EAX), Imm32((u32)(s32)inst.SIMM_16));
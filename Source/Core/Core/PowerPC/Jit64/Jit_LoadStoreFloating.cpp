@@ -63,7 +63,7 @@ void Jit64::lfd(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStoreFloatingOff)
 
-	if (js.memcheck) { Default(inst); return; }
+	if (js.memcheck || Memory::HasMemChecks()) { Default(inst); return; }
 
 	int d = inst.RD;
 	int a = inst.RA;
@@ -147,12 +147,9 @@ void Jit64::stfd(UGeckoInstruction inst)
 		Core::g_CoreStartupParameter.bTLBHack) {
 			mem_mask |= Memory::ADDR_MASK_MEM1;
 	}
-#ifdef ENABLE_MEM_CHECK
-	if (Core::g_CoreStartupParameter.bEnableDebugging)
-	{
-		mem_mask |= Memory::EXRAM_MASK;
-	}
-#endif
+	// The fast routine isn't backpatched
+	if (Memory::HasMemChecks())
+		mem_mask = 0xFFFFFFFF;
 
 	gpr.FlushLockX(ABI_PARAM1);
 	gpr.Lock(a);
@@ -226,10 +223,10 @@ void Jit64::stfs(UGeckoInstruction inst)
 		return;
 	}
 
-	if (gpr.R(a).IsImm())
+	if (gpr.R(a).IsImm() || js.op->hasConstA)
 	{
-		u32 addr = (u32)(gpr.R(a).offset + offset);
-		if (Memory::IsRAMAddress(addr))
+		u32 addr = (gpr.R(a).IsImm() ? (u32)gpr.R(a).offset : js.op->constA) + offset;
+		if (Memory::IsRAMAddress(addr) && !Memory::HasMemChecks())
 		{
 			if (cpu_info.bSSSE3) {
 				CVTSD2SS(XMM0, fpr.R(s));
@@ -242,8 +239,7 @@ void Jit64::stfs(UGeckoInstruction inst)
 		{
 			// Float directly to write gather pipe! Fun!
 			CVTSD2SS(XMM0, fpr.R(s));
-			CALL((void*)asm_routines.fifoDirectWriteFloat);
-			// TODO
+			WriteFloatToGatherPipe(XMM0);
 			js.fifoBytesThisBlock += 4;
 			return;
 		}
@@ -304,7 +300,7 @@ void Jit64::lfsx(UGeckoInstruction inst)
 	{
 		ADD(32, R(EAX), gpr.R(inst.RA));
 	}
-	if (cpu_info.bSSSE3 && !js.memcheck) {
+	if (cpu_info.bSSSE3 && !js.memcheck && !Memory::HasMemChecks()) {
 		fpr.Lock(inst.RS);
 		fpr.BindToRegister(inst.RS, false, true);
 		X64Reg r = fpr.R(inst.RS).GetSimpleReg();
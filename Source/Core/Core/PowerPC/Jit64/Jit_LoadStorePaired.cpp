@@ -5,6 +5,9 @@
 // TODO(ector): Tons of pshufb optimization of the loads/stores, for SSSE3+, possibly SSE4, only.
 // Should give a very noticeable speed boost to paired single heavy code.
 
+#include <cmath>
+#include <cstring>
+
 #include "Common.h"
 #include "CPUDetect.h"
 
@@ -13,6 +16,106 @@
 #include "JitRegCache.h"
 
 const u8 GC_ALIGNED16(pbswapShuffle2x4[16]) = {3, 2, 1, 0, 7, 6, 5, 4, 8, 9, 10, 11, 12, 13, 14, 15};
+static const float GC_ALIGNED16(m_one[]) = {1.0f, 0.0f, 0.0f, 0.0f};
+
+// GQRs are almost always set once and left alone, so psq_l and psq_st are compiled
+// for the value the GQR holds when the block is built, behind a guard that falls
+// back to the generic table call if it has changed since.
+static bool IsSpecializable(u32 gqr_half)
+{
+	u32 type = gqr_half & 7;
+	return type == QUANTIZE_FLOAT || type >= QUANTIZE_U8;
+}
+
+// Inline version of the pairedLoadQuantized routines for a known type and scale:
+// ECX holds the address, the result is left in XMM0.
+void Jit64::GenQuantizedLoad(bool single, EQuantizeType type, int scale)
+{
+	if (type == QUANTIZE_FLOAT)
+	{
+#ifdef _M_X64
+		if (cpu_info.bSSSE3)
+		{
+			if (single)
+				MOVD_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
+			else
+				MOVQ_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
+			PSHUFB(XMM0, M((void *)pbswapShuffle2x4));
+			if (single)
+				UNPCKLPS(XMM0, M((void *)m_one));
+			return;
+		}
+#endif
+		ABI_AlignStack(0);
+		CALL((void *)asm_routines.pairedLoadQuantized[type + (single ? 8 : 0)]);
+		ABI_RestoreStack(0);
+		return;
+	}
+
+	if (single)
+	{
+		int size = (type == QUANTIZE_U8 || type == QUANTIZE_S8) ? 8 : 16;
+		UnsafeLoadRegToReg(ECX, ECX, size, 0, type == QUANTIZE_S8 || type == QUANTIZE_S16);
+		MOVD_xmm(XMM0, R(ECX));
+	}
+	else
+	{
+		switch (type)
+		{
+		case QUANTIZE_U8:
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
+			MOVD_xmm(XMM0, R(ECX));
+			PXOR(XMM1, R(XMM1));
+			PUNPCKLBW(XMM0, R(XMM1));
+			PUNPCKLWD(XMM0, R(XMM1));
+			break;
+		case QUANTIZE_S8:
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
+			MOVD_xmm(XMM0, R(ECX));
+			PUNPCKLBW(XMM0, R(XMM0));
+			PUNPCKLWD(XMM0, R(XMM0));
+			PSRAD(XMM0, 24);
+			break;
+		case QUANTIZE_U16:
+			UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
+			ROL(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+			PXOR(XMM1, R(XMM1));
+			PUNPCKLWD(XMM0, R(XMM1));
+			break;
+		default: // QUANTIZE_S16
+			UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
+			ROL(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+			PUNPCKLWD(XMM0, R(XMM0));
+			PSRAD(XMM0, 16);
+			break;
+		}
+	}
+	CVTDQ2PS(XMM0, R(XMM0));
+
+	// The scale is a signed 6-bit power of two, so the factor is an immediate
+	// rather than a m_dequantizeTableS lookup, and scale 0 needs no multiply.
+	if (scale)
+	{
+		float factor = ldexpf(1.0f, -((scale ^ 0x20) - 0x20));
+		u32 factor_bits;
+		memcpy(&factor_bits, &factor, sizeof(factor_bits));
+		MOV(32, R(EAX), Imm32(factor_bits));
+		MOVD_xmm(XMM1, R(EAX));
+		if (single)
+		{
+			MULSS(XMM0, R(XMM1));
+		}
+		else
+		{
+			PUNPCKLDQ(XMM1, R(XMM1));
+			MULPS(XMM0, R(XMM1));
+		}
+	}
+	if (single)
+		UNPCKLPS(XMM0, M((void *)m_one));
+}
 
 // The big problem is likely instructions that set the quantizers in the same block.
 // We will have to break block after quantizers are written to.
@@ -21,7 +124,8 @@ void Jit64::psq_st(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStorePairedOff)
 
-	if (js.memcheck) { Default(inst); return; }
+	// The quantized loads and stores access RAM directly
+	if (js.memcheck || Memory::HasMemChecks()) { Default(inst); return; }
 
 	if (!inst.RA)
 	{
@@ -46,6 +150,32 @@ void Jit64::psq_st(UGeckoInstruction inst)
 		ADD(32, R(ECX), Imm32((u32)offset));
 	if (update && offset)
 		MOV(32, gpr.R(a), R(ECX));
+
+	u32 gqr = GQR(inst.I) & 0xFFFF;
+	bool specialize = IsSpecializable(gqr);
+	FixupBranch generic, done;
+	if (specialize)
+	{
+		CMP(16, M(&PowerPC::ppcState.spr[SPR_GQR0 + inst.I]), Imm16((u16)gqr));
+		generic = J_CC(CC_NZ, true);
+		// The store routines are too large to inline, but with the GQR known the
+		// table lookup and the indirect call go away.
+		MOV(32, R(EAX), Imm32(gqr));
+		if (inst.W)
+		{
+			XORPS(XMM0, R(XMM0));
+			CVTSD2SS(XMM0, fpr.R(s));
+			CALL((void *)asm_routines.singleStoreQuantized[gqr & 7]);
+		}
+		else
+		{
+			CVTPD2PS(XMM0, fpr.R(s));
+			CALL((void *)asm_routines.pairedStoreQuantized[gqr & 7]);
+		}
+		done = J(true);
+		SetJumpTarget(generic);
+	}
+
 	MOVZX(32, 16, EAX, M(&PowerPC::ppcState.spr[SPR_GQR0 + inst.I]));
 	MOVZX(32, 8, EDX, R(AL));
 	// FIXME: Fix ModR/M encoding to allow [EDX*4+disp32] without a base register!
@@ -64,6 +194,8 @@ void Jit64::psq_st(UGeckoInstruction inst)
 		CVTPD2PS(XMM0, fpr.R(s));
 		CALLptr(MScaled(EDX, addr_scale, (u32)(u64)asm_routines.pairedStoreQuantized));
 	}
+	if (specialize)
+		SetJumpTarget(done);
 	gpr.UnlockAll();
 	gpr.UnlockAllX();
 }
@@ -73,7 +205,8 @@ void Jit64::psq_l(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStorePairedOff)
 
-	if (js.memcheck) { Default(inst); return; }
+	// The quantized loads and stores access RAM directly
+	if (js.memcheck || Memory::HasMemChecks()) { Default(inst); return; }
 
 	if (!inst.RA)
 	{
@@ -94,6 +227,19 @@ void Jit64::psq_l(UGeckoInstruction inst)
 		MOV(32, R(ECX), gpr.R(inst.RA));
 	if (update && offset)
 		MOV(32, gpr.R(inst.RA), R(ECX));
+
+	u32 gqr = GQR(inst.I) >> 16;
+	bool specialize = IsSpecializable(gqr);
+	FixupBranch generic, done;
+	if (specialize)
+	{
+		CMP(16, M(((char *)&GQR(inst.I)) + 2), Imm16((u16)gqr));
+		generic = J_CC(CC_NZ, true);
+		GenQuantizedLoad(inst.W != 0, (EQuantizeType)(gqr & 7), (gqr >> 8) & 0x3F);
+		done = J(true);
+		SetJumpTarget(generic);
+	}
+
 	MOVZX(32, 16, EAX, M(((char *)&GQR(inst.I)) + 2));
 	MOVZX(32, 8, EDX, R(AL));
 	if (inst.W)
@@ -106,6 +252,8 @@ void Jit64::psq_l(UGeckoInstruction inst)
 	ABI_AlignStack(0);
 	CALLptr(MScaled(EDX, addr_scale, (u32)(u64)asm_routines.pairedLoadQuantized));
 	ABI_RestoreStack(0);
+	if (specialize)
+		SetJumpTarget(done);
 
 //	MEMCHECK_START // FIXME: MMU does not work here because of unsafe memory access
 
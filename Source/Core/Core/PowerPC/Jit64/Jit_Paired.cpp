@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "Common.h"
+#include "CPUDetect.h"
 
 #include "Jit.h"
 #include "JitRegCache.h"
@@ -146,7 +147,8 @@ add a,b,a
 */
 
 //There's still a little bit more optimization that can be squeezed out of this
-void Jit64::tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(X64Reg, OpArg))
+void Jit64::tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(X64Reg, OpArg),
+                   void (XEmitter::*avxOp)(X64Reg, X64Reg, OpArg))
 {
 	fpr.Lock(d, a, b);
 
@@ -155,20 +157,24 @@ void Jit64::tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(X6
 		fpr.BindToRegister(d, true);
 		(this->*op)(fpr.RX(d), fpr.R(b));
 	}
+	else if (d == b && reversible)
+	{
+		fpr.BindToRegister(d, true);
+		(this->*op)(fpr.RX(d), fpr.R(a));
+	}
+	else if (cpu_info.bAVX)
+	{
+		// The three operand form needs no copies
+		fpr.BindToRegister(a, true, false);
+		fpr.BindToRegister(d, d == b);
+		(this->*avxOp)(fpr.RX(d), fpr.RX(a), fpr.R(b));
+	}
 	else if (d == b)
 	{
-		if (reversible)
-		{
-			fpr.BindToRegister(d, true);
-			(this->*op)(fpr.RX(d), fpr.R(a));
-		}
-		else
-		{
-			MOVAPD(XMM0, fpr.R(b));
-			fpr.BindToRegister(d, false);
-			MOVAPD(fpr.RX(d), fpr.R(a));
-			(this->*op)(fpr.RX(d), Gen::R(XMM0));
-		}
+		MOVAPD(XMM0, fpr.R(b));
+		fpr.BindToRegister(d, false);
+		MOVAPD(fpr.RX(d), fpr.R(a));
+		(this->*op)(fpr.RX(d), Gen::R(XMM0));
 	}
 	else
 	{
@@ -190,10 +196,10 @@ void Jit64::ps_arith(UGeckoInstruction inst)
 	}
 	switch (inst.SUBOP5)
 	{
-	case 18: tri_op(inst.FD, inst.FA, inst.FB, false, &XEmitter::DIVPD); break; //div
-	case 20: tri_op(inst.FD, inst.FA, inst.FB, false, &XEmitter::SUBPD); break; //sub
-	case 21: tri_op(inst.FD, inst.FA, inst.FB, true,  &XEmitter::ADDPD); break; //add
-	case 25: tri_op(inst.FD, inst.FA, inst.FC, true, &XEmitter::MULPD); break; //mul
+	case 18: tri_op(inst.FD, inst.FA, inst.FB, false, &XEmitter::DIVPD, &XEmitter::VDIVPD); break; //div
+	case 20: tri_op(inst.FD, inst.FA, inst.FB, false, &XEmitter::SUBPD, &XEmitter::VSUBPD); break; //sub
+	case 21: tri_op(inst.FD, inst.FA, inst.FB, true,  &XEmitter::ADDPD, &XEmitter::VADDPD); break; //add
+	case 25: tri_op(inst.FD, inst.FA, inst.FC, true,  &XEmitter::MULPD, &XEmitter::VMULPD); break; //mul
 	default:
 		_assert_msg_(DYNA_REC, 0, "ps_arith WTF!!!");
 	}
@@ -224,6 +230,16 @@ void Jit64::ps_sum(UGeckoInstruction inst)
 		MOVAPD(fpr.R(d), XMM0);
 		break;
 	case 11:
+		if (cpu_info.bSSE4_1)
+		{
+			// The upper half of a0 + b gives ps1, only ps0 of c has to be
+			// blended in
+			MOVDDUP(XMM0, fpr.R(a));
+			ADDPD(XMM0, fpr.R(b));
+			BLENDPD(XMM0, fpr.R(c), 1);
+			MOVAPD(fpr.R(d), XMM0);
+			break;
+		}
 		// Do the sum in lower subregisters, merge lowers
 		MOVAPD(XMM0, fpr.R(a));
 		MOVAPD(XMM1, fpr.R(b));
@@ -330,6 +346,48 @@ void Jit64::ps_maddXX(UGeckoInstruction inst)
 	int d = inst.FD;
 	fpr.Lock(a,b,c,d);
 
+	if (cpu_info.bFMA)
+	{
+		// Fused, so the product isn't rounded before the addition, like on
+		// the real CPU
+		X64Reg factor = XMM1;
+		if (inst.SUBOP5 == 14)
+		{
+			MOVDDUP(XMM1, fpr.R(c));
+		}
+		else if (inst.SUBOP5 == 15)
+		{
+			MOVAPD(XMM1, fpr.R(c));
+			SHUFPD(XMM1, R(XMM1), 3); // copy higher to lower
+		}
+		else
+		{
+			fpr.BindToRegister(c, true, false);
+			factor = fpr.RX(c);
+		}
+
+		MOVAPD(XMM0, fpr.R(a));
+		switch (inst.SUBOP5)
+		{
+		case 28: //msub
+		case 30: //nmsub
+			VFMSUB213PD(XMM0, factor, fpr.R(b));
+			break;
+		default: //madds0, madds1, madd, nmadd
+			VFMADD213PD(XMM0, factor, fpr.R(b));
+			break;
+		}
+		// The negation comes last to get the sign of zero results right
+		if (inst.SUBOP5 == 30 || inst.SUBOP5 == 31)
+			XORPD(XMM0, M((void*)&psSignBits));
+
+		fpr.BindToRegister(d, false);
+		MOVAPD(fpr.RX(d), Gen::R(XMM0));
+		ForceSinglePrecisionP(fpr.RX(d));
+		fpr.UnlockAll();
+		return;
+	}
+
 	MOVAPD(XMM0, fpr.R(a));
 	switch (inst.SUBOP5)
 	{
@@ -3,13 +3,42 @@
 // Refer to the license.txt file included.
 
 #include "Common.h"
+#include "FPURoundMode.h"
 
 #include "../../HW/SystemTimers.h"
 #include "HW/ProcessorInterface.h"
+#include "../Interpreter/Interpreter_FPUtils.h"
 
 #include "Jit.h"
 #include "JitRegCache.h"
 
+// The FPSCR bits the host FPU mode is derived from: RN and NI
+static const u32 FPSCR_MODE_BITS = 0x7;
+
+// Same as the interpreter's FPSCRtoFPUSettings, minus the unused exception enables
+static void UpdateFPUMode(u32 fpscr)
+{
+	FPURoundMode::SetRoundMode(fpscr & 3);
+	FPURoundMode::SetSIMDMode(fpscr & 3, (fpscr >> 2) & 1);
+}
+
+// Switches the host FPU to the given RN|NI mode, or to whatever FPSCR holds
+// at run time if mode is -1. Nothing is emitted when the block already
+// switched to that mode.
+void Jit64::SetFPUMode(int mode)
+{
+	if (mode >= 0 && mode == js.fpuMode)
+		return;
+
+	gpr.Flush(FLUSH_ALL);
+	fpr.Flush(FLUSH_ALL);
+	if (mode >= 0)
+		ABI_CallFunctionC((void *)&UpdateFPUMode, mode);
+	else
+		ABI_CallFunctionA((void *)&UpdateFPUMode, M(&PowerPC::ppcState.fpscr));
+	js.fpuMode = mode;
+}
+
 void Jit64::mtspr(UGeckoInstruction inst)
 {
 	INSTRUCTION_START
@@ -236,6 +265,60 @@ void Jit64::mcrxr(UGeckoInstruction inst)
 	AND(32, M(&PowerPC::ppcState.spr[SPR_XER]), Imm32(0x0FFFFFFF));
 }
 
+void Jit64::mtfsb0x(UGeckoInstruction inst)
+{
+	INSTRUCTION_START
+	JITDISABLE(bJITSystemRegistersOff)
+	if (inst.Rc)
+	{
+		Default(inst);
+		return;
+	}
+
+	u32 b = 0x80000000 >> inst.CRBD;
+	AND(32, M(&PowerPC::ppcState.fpscr), Imm32(~b));
+	if (b & FPSCR_MODE_BITS)
+		SetFPUMode(js.fpuMode >= 0 ? (js.fpuMode & ~b) : -1);
+}
+
+void Jit64::mtfsb1x(UGeckoInstruction inst)
+{
+	INSTRUCTION_START
+	JITDISABLE(bJITSystemRegistersOff)
+	u32 b = 0x80000000 >> inst.CRBD;
+	// Exception bits also have to update FX and VX, leave them to the interpreter
+	if (inst.Rc || (b & FPSCR_ANY_X))
+	{
+		Default(inst);
+		return;
+	}
+
+	OR(32, M(&PowerPC::ppcState.fpscr), Imm32(b));
+	if (b & FPSCR_MODE_BITS)
+		SetFPUMode(js.fpuMode >= 0 ? (js.fpuMode | b) : -1);
+}
+
+void Jit64::mtfsfix(UGeckoInstruction inst)
+{
+	INSTRUCTION_START
+	JITDISABLE(bJITSystemRegistersOff)
+	if (inst.Rc)
+	{
+		Default(inst);
+		return;
+	}
+
+	u32 imm = (inst.hex >> 12) & 0xF;
+	int shift = 28 - 4 * inst.CRFD;
+	AND(32, M(&PowerPC::ppcState.fpscr), Imm32(~(0xFu << shift)));
+	if (imm)
+		OR(32, M(&PowerPC::ppcState.fpscr), Imm32(imm << shift));
+
+	// Only the last field holds RN and NI
+	if (inst.CRFD == 7)
+		SetFPUMode(imm & FPSCR_MODE_BITS);
+}
+
 void Jit64::crXXX(UGeckoInstruction inst)
 {
 	INSTRUCTION_START
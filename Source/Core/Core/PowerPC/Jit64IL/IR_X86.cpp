@@ -1206,12 +1206,8 @@ static void DoWriteCode(IRBuilder* ibuild, JitIL* Jit, u32 exitAddress) {
 				Core::g_CoreStartupParameter.bTLBHack) {
 				mem_mask |= Memory::ADDR_MASK_MEM1;
 			}
-#ifdef ENABLE_MEM_CHECK
-			if (Core::g_CoreStartupParameter.bEnableDebugging)
-			{
-				mem_mask |= Memory::EXRAM_MASK;
-			}
-#endif
+			if (Memory::HasMemChecks())
+				mem_mask = 0xFFFFFFFF;
 			Jit->TEST(32, regLocForInst(RI, getOp2(I)), Imm32(mem_mask));
 			FixupBranch safe = Jit->J_CC(CC_NZ);
 				// Fast routine
@@ -7,6 +7,7 @@
 #include <cinttypes>
 
 #include "Common.h"
+#include "PerfTrace.h"
 #include "../../HLE/HLE.h"
 #include "../../PatchEngine.h"
 #include "../Profiler.h"
@@ -488,6 +489,8 @@ void JitIL::Trace()
 
 void STACKALIGN JitIL::Jit(u32 em_address)
 {
+	PERF_SCOPE(CAT_JIT_COMPILE);
+
 	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
@@ -711,11 +714,15 @@ const u8* JitIL::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 		ibuild.EmitISIException(ibuild.EmitIntConst(em_address));
 	}
 
+	ibuild.RunPasses();
+
 	// Perform actual code generation
 	WriteCode(exitAddress);
 
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = size;
+	blocks.FindInlinedRanges(*b, ops, size);
+	b->downcountAmount = js.downcountAmount;
 
 #ifdef JIT_LOG_X86
 	LogGeneratedX86(size, code_buf, normalEntry, b);
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "JitRegister.h"
 #include "x64Emitter.h"
 #include "../JitCommon/JitAsmCommon.h"
 
@@ -31,6 +32,7 @@ public:
 	void Init() {
 		AllocCodeSpace(8192);
 		Generate();
+		JitRegister::Register(region, GetCodePtr() - region, "JIT_Asm_Jit64IL");
 		WriteProtect();
 	}
 
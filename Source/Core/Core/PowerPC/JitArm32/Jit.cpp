@@ -18,6 +18,7 @@
 #include <map>
 
 #include "Common.h"
+#include "PerfTrace.h"
 #include "../../HLE/HLE.h"
 #include "../../Core.h"
 #include "../../PatchEngine.h"
@@ -52,6 +53,7 @@ void JitArm::Init()
 	fpr.Init(this);
 	jo.enableBlocklink = true;
 	jo.optimizeGatherPipe = true;
+	jo.fastInterrupts = false;
 }
 
 void JitArm::ClearCache()
@@ -288,6 +290,8 @@ void JitArm::PrintDebug(UGeckoInstruction inst, u32 level)
 
 void STACKALIGN JitArm::Jit(u32 em_address)
 {
+	PERF_SCOPE(CAT_JIT_COMPILE);
+
 	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
@@ -506,6 +510,8 @@ const u8* JitArm::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlo
 	b->flags = js.block_flags;
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = size;
+	blocks.FindInlinedRanges(*b, ops, size);
+	b->downcountAmount = js.downcountAmount;
 	FlushIcache();
 	return start;
 }
@@ -102,11 +102,9 @@ const u8 *JitArm::BackPatch(u8 *codePtr, u32, void *ctx_void)
 		{
 			case 8: // 8bit
 				emitter.MOVI2R(R14, (u32)&Memory::Write_U8, false); // 1-2
-				return 0;
 			break;
 			case 16: // 16bit
 				emitter.MOVI2R(R14, (u32)&Memory::Write_U16, false); // 1-2
-				return 0;
 			break;
 			case 32: // 32bit
 				emitter.MOVI2R(R14, (u32)&Memory::Write_U32, false); // 1-2
@@ -144,7 +142,8 @@ const u8 *JitArm::BackPatch(u8 *codePtr, u32, void *ctx_void)
 		emitter.MOV(R14, R0); // 6
 		emitter.POP(4, R0, R1, R2, R3); // 7
 		emitter.MOV(rD, R14); // 8
-		ctx->CTX_PC -= ARMREGOFFSET + (4 * 4);
+		// Restart at the three instructions computing the address
+		ctx->CTX_PC -= ARMREGOFFSET + (3 * 4);
 		emitter.FlushIcache();
 		return (u8*)ctx->CTX_PC;
 	}
@@ -148,6 +148,7 @@ void JitArm::stX(UGeckoInstruction inst)
 		case 45: // sthu
 			update = true;
 		case 44: // sth
+			fastmem = true;
 			accessSize = 16;
 		break;
 		case 31:
@@ -165,6 +166,7 @@ void JitArm::stX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 215: // stbx
+					fastmem = true;
 					accessSize = 8;
 					regOffset = b;
 				break;
@@ -172,6 +174,7 @@ void JitArm::stX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 407: // sthx
+					fastmem = true;
 					accessSize = 16;
 					regOffset = b;
 				break;
@@ -186,6 +189,7 @@ void JitArm::stX(UGeckoInstruction inst)
 		case 39: // stbu
 			update = true;
 		case 38: // stb
+			fastmem = true;
 			accessSize = 8;
 		break;
 	}
@@ -219,11 +223,9 @@ void JitArm::stX(UGeckoInstruction inst)
 	}
 }
 
-void JitArm::UnsafeLoadToReg(ARMReg dest, ARMReg addr, int accessSize, s32 offset)
+void JitArm::UnsafeLoadToReg(ARMReg dest, ARMReg addr, int accessSize, bool signExtend)
 {
 	ARMReg rA = gpr.GetReg();
-	MOVI2R(rA, offset, false); // -3
-	ADD(addr, addr, rA); // - 1
 
 	// All this gets replaced on backpatch
 	Operand2 mask(3, 1); // ~(Memory::MEMVIEW32_MASK)
@@ -256,6 +258,9 @@ void JitArm::UnsafeLoadToReg(ARMReg dest, ARMReg addr, int accessSize, s32 offse
 
 	}
 	NOP(2); // 7-8
+	// Left alone by the backpatcher, so it applies to both paths
+	if (signExtend)
+		SXTH(dest, dest);
 	gpr.Unlock(rA);
 }
 
@@ -264,12 +269,28 @@ void JitArm::SafeLoadToReg(bool fastmem, u32 dest, s32 addr, s32 offsetReg, int
 	ARMReg RD = gpr.R(dest);
 	if (Core::g_CoreStartupParameter.bFastmem && fastmem)
 	{
+		ARMReg RA;
+		ARMReg RB;
+		if (addr != -1)
+			RA = gpr.R(addr);
+
+		// The address is always computed in three instructions, the
+		// backpatcher restarts from here
+		if (offsetReg != -1)
+		{
+			RB = gpr.R(offsetReg);
+			MOV(R10, RB);
+			NOP(1);
+		}
+		else
+			MOVI2R(R10, (u32)offset, false);
+
 		if (addr != -1)
-			MOV(R10, gpr.R(addr));
+			ADD(R10, R10, RA);
 		else
-			MOV(R10, 0);
+			NOP(1);
 
-		UnsafeLoadToReg(RD, R10, accessSize, offset);
+		UnsafeLoadToReg(RD, R10, accessSize, signExtend);
 		return;
 	}
 	ARMReg rA = gpr.GetReg();
@@ -337,6 +358,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 23: // lwzx
+					fastmem = true;
 					accessSize = 32;
 					offsetReg = b;
 				break;
@@ -344,6 +366,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 87: // lbzx
+					fastmem = true;
 					accessSize = 8;
 					offsetReg = b;
 				break;
@@ -351,6 +374,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 279: // lhzx
+					fastmem = true;
 					accessSize = 16;
 					offsetReg = b;
 				break;
@@ -358,6 +382,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 					zeroA = false;
 					update = true;
 				case 343: // lhax
+					fastmem = true;
 					accessSize = 16;
 					signExtend = true;
 					offsetReg = b;
@@ -365,10 +390,12 @@ void JitArm::lXX(UGeckoInstruction inst)
 				case 534: // lwbrx
 					accessSize = 32;
 					reverse = true;
+					offsetReg = b;
 				break;
 				case 790: // lhbrx
 					accessSize = 16;
 					reverse = true;
+					offsetReg = b;
 				break;
 			}
 		break;
@@ -397,6 +424,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 			zeroA = false;
 			update = true;
 		case 42: // lha
+			fastmem = true;
 			signExtend = true;
 			accessSize = 16;
 		break;
@@ -418,7 +446,7 @@ void JitArm::lXX(UGeckoInstruction inst)
 		if (offsetReg == -1)
 			MOVI2R(rA, offset);
 		else
-			MOV(RA, gpr.R(offsetReg));
+			MOV(rA, gpr.R(offsetReg));
 		ADD(RA, RA, rA);
 	}
 
@@ -5,6 +5,7 @@
 #include <map>
 
 #include "Common.h"
+#include "PerfTrace.h"
 #include "../../HLE/HLE.h"
 #include "../../Core.h"
 #include "../../PatchEngine.h"
@@ -185,6 +186,8 @@ void JitArmIL::SingleStep()
 }
 void STACKALIGN JitArmIL::Jit(u32 em_address)
 {
+	PERF_SCOPE(CAT_JIT_COMPILE);
+
 	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
@@ -354,12 +357,15 @@ const u8* JitArmIL::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitB
 		WriteExit(nextPC);
 	}
 
+	ibuild.RunPasses();
+
 	// Perform actual code generation
 
 	WriteCode(nextPC);
 	b->flags = js.block_flags;
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = size;
+	blocks.FindInlinedRanges(*b, ops, size);
 
 	{
 	}
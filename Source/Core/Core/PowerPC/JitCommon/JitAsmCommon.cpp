@@ -267,15 +267,17 @@ void CommonAsmRoutines::GenQuantizedStores()
 
 	pairedStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(8 * sizeof(u8*));
-
-	pairedStoreQuantized[0] = storePairedFloat;
-	pairedStoreQuantized[1] = storePairedIllegal;
-	pairedStoreQuantized[2] = storePairedIllegal;
-	pairedStoreQuantized[3] = storePairedIllegal;
-	pairedStoreQuantized[4] = storePairedU8;
-	pairedStoreQuantized[5] = storePairedU16;
-	pairedStoreQuantized[6] = storePairedS8;
-	pairedStoreQuantized[7] = storePairedS16;
+	// Written through the writable view of the code space
+	const u8** table = reinterpret_cast<const u8**>(GetWritableView(reinterpret_cast<const u8*>(pairedStoreQuantized)));
+
+	table[0] = storePairedFloat;
+	table[1] = storePairedIllegal;
+	table[2] = storePairedIllegal;
+	table[3] = storePairedIllegal;
+	table[4] = storePairedU8;
+	table[5] = storePairedU16;
+	table[6] = storePairedS8;
+	table[7] = storePairedS16;
 }
 
 // See comment in header for in/outs.
@@ -345,15 +347,17 @@ void CommonAsmRoutines::GenQuantizedSingleStores()
 
 	singleStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(8 * sizeof(u8*));
-
-	singleStoreQuantized[0] = storeSingleFloat;
-	singleStoreQuantized[1] = storeSingleIllegal;
-	singleStoreQuantized[2] = storeSingleIllegal;
-	singleStoreQuantized[3] = storeSingleIllegal;
-	singleStoreQuantized[4] = storeSingleU8;
-	singleStoreQuantized[5] = storeSingleU16;
-	singleStoreQuantized[6] = storeSingleS8;
-	singleStoreQuantized[7] = storeSingleS16;
+	// Written through the writable view of the code space
+	const u8** table = reinterpret_cast<const u8**>(GetWritableView(reinterpret_cast<const u8*>(singleStoreQuantized)));
+
+	table[0] = storeSingleFloat;
+	table[1] = storeSingleIllegal;
+	table[2] = storeSingleIllegal;
+	table[3] = storeSingleIllegal;
+	table[4] = storeSingleU8;
+	table[5] = storeSingleU16;
+	table[6] = storeSingleS8;
+	table[7] = storeSingleS16;
 }
 
 void CommonAsmRoutines::GenQuantizedLoads()
@@ -526,22 +530,24 @@ void CommonAsmRoutines::GenQuantizedLoads()
 
 	pairedLoadQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(16 * sizeof(u8*));
-
-	pairedLoadQuantized[0] = loadPairedFloatTwo;
-	pairedLoadQuantized[1] = loadPairedIllegal;
-	pairedLoadQuantized[2] = loadPairedIllegal;
-	pairedLoadQuantized[3] = loadPairedIllegal;
-	pairedLoadQuantized[4] = loadPairedU8Two;
-	pairedLoadQuantized[5] = loadPairedU16Two;
-	pairedLoadQuantized[6] = loadPairedS8Two;
-	pairedLoadQuantized[7] = loadPairedS16Two;
-
-	pairedLoadQuantized[8] = loadPairedFloatOne;
-	pairedLoadQuantized[9] = loadPairedIllegal;
-	pairedLoadQuantized[10] = loadPairedIllegal;
-	pairedLoadQuantized[11] = loadPairedIllegal;
-	pairedLoadQuantized[12] = loadPairedU8One;
-	pairedLoadQuantized[13] = loadPairedU16One;
-	pairedLoadQuantized[14] = loadPairedS8One;
-	pairedLoadQuantized[15] = loadPairedS16One;
+	// Written through the writable view of the code space
+	const u8** table = reinterpret_cast<const u8**>(GetWritableView(reinterpret_cast<const u8*>(pairedLoadQuantized)));
+
+	table[0] = loadPairedFloatTwo;
+	table[1] = loadPairedIllegal;
+	table[2] = loadPairedIllegal;
+	table[3] = loadPairedIllegal;
+	table[4] = loadPairedU8Two;
+	table[5] = loadPairedU16Two;
+	table[6] = loadPairedS8Two;
+	table[7] = loadPairedS16Two;
+
+	table[8] = loadPairedFloatOne;
+	table[9] = loadPairedIllegal;
+	table[10] = loadPairedIllegal;
+	table[11] = loadPairedIllegal;
+	table[12] = loadPairedU8One;
+	table[13] = loadPairedU16One;
+	table[14] = loadPairedS8One;
+	table[15] = loadPairedS16One;
 }
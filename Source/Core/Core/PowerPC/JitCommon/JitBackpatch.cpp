@@ -7,6 +7,7 @@
 
 #include "Common.h"
 #include "disasm.h"
+#include "JitRegister.h"
 #include "JitBase.h"
 #include "JitBackpatch.h"
 
@@ -93,6 +94,7 @@ const u8 *TrampolineCache::GetReadTrampoline(const InstructionInfo &info, u32 re
 	ABI_PopRegistersAndAdjustStack(registersInUse, true);
 	RET();
 #endif
+	JitRegister::Register(trampoline, GetCodePtr() - trampoline, "JIT_ReadTrampoline");
 	return trampoline;
 }
 
@@ -156,6 +158,7 @@ const u8 *TrampolineCache::GetWriteTrampoline(const InstructionInfo &info, u32 r
 	RET();
 #endif
 
+	JitRegister::Register(trampoline, GetCodePtr() - trampoline, "JIT_WriteTrampoline");
 	return trampoline;
 }
 
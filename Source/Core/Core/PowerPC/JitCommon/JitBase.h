@@ -70,6 +70,9 @@ protected:
 		int block_flags;
 
 		int fifoBytesThisBlock;
+		// FPSCR RN and NI bits the host FPU was last set up for in this block,
+		// -1 when unknown
+		int fpuMode;
 
 		PPCAnalyst::BlockStats st;
 		PPCAnalyst::BlockRegStats gpa;
@@ -9,7 +9,15 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
+#include <set>
+
 #include "Common.h"
+#include "FileUtil.h"
+#include "Hash.h"
+#include "JitRegister.h"
+#include "LinearDiskCache.h"
+#include "Timer.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -20,6 +28,7 @@
 #include "disasm.h"
 
 #include "../JitInterface.h"
+#include "../PPCSymbolDB.h"
 
 #if defined USE_OPROFILE && USE_OPROFILE
 #include <opagent.h>
@@ -35,9 +44,50 @@ op_agent_t agent;
 
 using namespace Gen;
 
+namespace
+{
+struct PersistentBlockKey
+{
+	u32 address;
+	u32 settings;
+};
+
+class PersistentBlockReader : public LinearDiskCacheReader<PersistentBlockKey, u32>
+{
+public:
+	PersistentBlockReader(std::map<u32, JitPersistentBlock>& blocks, u32 settings)
+		: m_blocks(blocks), m_settings(settings) {}
+
+	void Read(const PersistentBlockKey& key, const u32* value, u32 value_size) override
+	{
+		if (key.settings != m_settings || value_size != 2)
+			return;
+
+		JitPersistentBlock& b = m_blocks[key.address];
+		b.size = value[0];
+		b.codeHash = value[1];
+	}
+
+private:
+	std::map<u32, JitPersistentBlock>& m_blocks;
+	u32 m_settings;
+};
+
+// Returns false if the block's guest code isn't plain RAM we can hash.
+bool HashGuestCode(u32 address, u32 size, u32* hash)
+{
+	if (size == 0 || (address & JIT_ICACHE_VMEM_BIT) ||
+	    !Memory::IsRAMAddress(address) || !Memory::IsRAMAddress(address + 4 * size - 1))
+		return false;
+
+	*hash = HashAdler32(Memory::GetPointer(address), 4 * size);
+	return true;
+}
+} // namespace
+
 	bool JitBaseBlockCache::IsFull() const
 	{
-		return GetNumBlocks() >= MAX_NUM_BLOCKS - 1;
+		return GetNumBlocks() >= MAX_NUM_BLOCKS - 1 && free_blocks.empty();
 	}
 
 	void JitBaseBlockCache::Init()
@@ -64,6 +114,8 @@ using namespace Gen;
 		memset(iCache, JIT_ICACHE_INVALID_BYTE, JIT_ICACHE_SIZE);
 		memset(iCacheEx, JIT_ICACHE_INVALID_BYTE, JIT_ICACHEEX_SIZE);
 		memset(iCacheVMEM, JIT_ICACHE_INVALID_BYTE, JIT_ICACHE_SIZE);
+		total_compile_us = 0;
+		total_compiled = 0;
 		Clear();
 	}
 
@@ -103,14 +155,19 @@ using namespace Gen;
 			Core::DisplayMessage("Clearing code cache.", 3000);
 #endif
 
+		links_to.Clear();
+		block_map.Clear();
 		for (int i = 0; i < num_blocks; i++)
 		{
 			DestroyBlock(i, false);
 		}
-		links_to.clear();
-		block_map.clear();
 		valid_block.reset();
+		free_blocks.clear();
 		num_blocks = 0;
+		{
+			std::lock_guard<std::mutex> lk(code_map_lock);
+			code_map.clear();
+		}
 		memset(blockCodePointers, 0, sizeof(u8*)*MAX_NUM_BLOCKS);
 	}
 
@@ -160,20 +217,64 @@ using namespace Gen;
 			return false;
 	}
 
+	// Calls f(first, last) with the physical byte range of the block and of
+	// everything inlined into it
+	template <typename F>
+	static void ForEachRange(const JitBlock &b, F f)
+	{
+		const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+		f(pAddr, pAddr + 4 * b.originalSize - 1);
+		for (const auto& range : b.inlinedRanges)
+			f(range.first, range.second);
+	}
+
 	int JitBaseBlockCache::AllocateBlock(u32 em_address)
 	{
-		JitBlock &b = blocks[num_blocks];
+		int block_num;
+		if (!free_blocks.empty())
+		{
+			block_num = free_blocks.back();
+			free_blocks.pop_back();
+		}
+		else
+		{
+			block_num = num_blocks;
+			num_blocks++; //commit the current block
+		}
+
+		JitBlock &b = blocks[block_num];
 		b.invalid = false;
 		b.originalAddress = em_address;
 		b.linkData.clear();
-		num_blocks++; //commit the current block
-		return num_blocks - 1;
+		b.inlinedRanges.clear();
+		compile_start_us = Common::Timer::GetTimeUs();
+		return block_num;
+	}
+
+	void JitBaseBlockCache::FindInlinedRanges(JitBlock &b, const PPCAnalyst::CodeOp *ops, u32 size)
+	{
+		const u32 start = b.originalAddress & 0x1FFFFFFF;
+		b.inlinedRanges.clear();
+		for (u32 i = 0; i < size; i++)
+		{
+			const u32 pAddr = ops[i].address & 0x1FFFFFFF;
+			if (pAddr >= start && pAddr < start + 4 * b.originalSize)
+				continue;
+
+			if (!b.inlinedRanges.empty() && b.inlinedRanges.back().second + 1 == pAddr)
+				b.inlinedRanges.back().second = pAddr + 3;
+			else
+				b.inlinedRanges.push_back(std::make_pair(pAddr, pAddr + 3));
+		}
 	}
 
 	void JitBaseBlockCache::FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr)
 	{
 		blockCodePointers[block_num] = code_ptr;
 		JitBlock &b = blocks[block_num];
+		b.compileTimeUs = (u32)(Common::Timer::GetTimeUs() - compile_start_us);
+		total_compile_us += b.compileTimeUs;
+		total_compiled++;
 		u32* icp = GetICachePtr(b.originalAddress);
 		*icp = block_num;
 
@@ -182,19 +283,50 @@ using namespace Gen;
 
 		for (u32 i = 0; i < (b.originalSize + 7) / 8; ++i)
 			valid_block[pAddr / 32 + i] = true;
+		for (const auto& range : b.inlinedRanges)
+		{
+			for (u32 line = range.first / 32; line <= range.second / 32; ++line)
+				valid_block[line] = true;
+		}
+
+		AddToBlockMap(block_num);
+
+		{
+			std::lock_guard<std::mutex> lk(code_map_lock);
+			code_map[b.checkedEntry] = block_num;
+		}
+
+		if (persistent_enabled)
+		{
+			JitPersistentBlock pb;
+			pb.size = b.originalSize;
+			if (HashGuestCode(b.originalAddress, pb.size, &pb.codeHash))
+				persistent_blocks[b.originalAddress] = pb;
+		}
 
-		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
 		if (block_link)
 		{
 			for (const auto& e : b.linkData)
 			{
-				links_to.insert(std::pair<u32, int>(e.exitAddress, block_num));
+				links_to[e.exitAddress].push_back(block_num);
 			}
 
 			LinkBlock(block_num);
 			LinkBlockExits(block_num);
 		}
 
+		if (JitRegister::IsEnabled())
+		{
+			const u8* code_end = b.normalEntry + b.codeSize;
+			const Symbol* symbol = g_symbolDB.GetSymbolFromAddr(b.originalAddress);
+			if (symbol)
+				JitRegister::Register(b.checkedEntry, code_end - b.checkedEntry, "JIT_PPC_%08x_%s",
+				                      b.originalAddress, symbol->name.c_str());
+			else
+				JitRegister::Register(b.checkedEntry, code_end - b.checkedEntry, "JIT_PPC_%08x",
+				                      b.originalAddress);
+		}
+
 #if defined USE_OPROFILE && USE_OPROFILE
 		char buf[100];
 		sprintf(buf, "EmuCode%x", b.originalAddress);
@@ -248,6 +380,21 @@ using namespace Gen;
 		return inst;
 	}
 
+	bool JitBaseBlockCache::GetBlockAddressFromCodePointer(const u8* ptr, u32* em_address)
+	{
+		std::lock_guard<std::mutex> lk(code_map_lock);
+		auto it = code_map.upper_bound(ptr);
+		if (it == code_map.begin())
+			return false;
+		--it;
+
+		const JitBlock &b = blocks[it->second];
+		if (ptr >= b.normalEntry + b.codeSize)
+			return false;
+		*em_address = b.originalAddress;
+		return true;
+	}
+
 	CompiledCode JitBaseBlockCache::GetCompiledCodeFromBlock(int block_num)
 	{
 		return (CompiledCode)blockCodePointers[block_num];
@@ -281,40 +428,65 @@ using namespace Gen;
 		}
 	}
 
-	using namespace std;
-
 	void JitBaseBlockCache::LinkBlock(int i)
 	{
 		LinkBlockExits(i);
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		// equal_range(b) returns pair<iterator,iterator> representing the range
-		// of element with key b
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
+		const std::vector<int>* sources = links_to.Find(b.originalAddress);
+		if (!sources)
 			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			// PanicAlert("Linking block %i to block %i", iter->second, i);
-			LinkBlockExits(iter->second);
+		for (int source : *sources)
+		{
+			// PanicAlert("Linking block %i to block %i", source, i);
+			LinkBlockExits(source);
 		}
 	}
 
 	void JitBaseBlockCache::UnlinkBlock(int i)
 	{
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
+		const std::vector<int>* sources = links_to.Find(b.originalAddress);
+		if (!sources)
 			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			JitBlock &sourceBlock = blocks[iter->second];
+		for (int source : *sources)
+		{
+			JitBlock &sourceBlock = blocks[source];
 			for (auto& e : sourceBlock.linkData)
 			{
 				if (e.exitAddress == b.originalAddress)
 					e.linkStatus = false;
 			}
 		}
-		links_to.erase(b.originalAddress);
+		// The sources are kept so that they get linked to the block which
+		// replaces this one.
+	}
+
+	void JitBaseBlockCache::AddToBlockMap(int i)
+	{
+		ForEachRange(blocks[i], [&](u32 first, u32 last) {
+			for (u32 key = first >> BLOCK_MAP_SHIFT; key <= last >> BLOCK_MAP_SHIFT; ++key)
+			{
+				// Inlined code may share a range with the block itself
+				std::vector<int>& overlapping = block_map[key];
+				if (overlapping.empty() || overlapping.back() != i)
+					overlapping.push_back(i);
+			}
+		});
+	}
+
+	void JitBaseBlockCache::RemoveFromBlockMap(int i)
+	{
+		ForEachRange(blocks[i], [&](u32 first, u32 last) {
+			for (u32 key = first >> BLOCK_MAP_SHIFT; key <= last >> BLOCK_MAP_SHIFT; ++key)
+			{
+				std::vector<int>* overlapping = block_map.Find(key);
+				if (!overlapping)
+					continue;
+				overlapping->erase(std::remove(overlapping->begin(), overlapping->end(), i), overlapping->end());
+				if (overlapping->empty())
+					block_map.Erase(key);
+			}
+		});
 	}
 
 	void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -334,6 +506,7 @@ using namespace Gen;
 		b.invalid = true;
 		*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
 
+		RemoveFromBlockMap(block_num);
 		UnlinkBlock(block_num);
 
 		// Send anyone who tries to run this block back to the dispatcher.
@@ -342,6 +515,90 @@ using namespace Gen;
 		WriteDestroyBlock(b.checkedEntry, b.originalAddress);
 	}
 
+	int JitBaseBlockCache::EvictBlocks(const u8* start, const u8* end)
+	{
+		auto in_range = [&](const JitBlock& b) {
+			return b.checkedEntry && b.checkedEntry >= start && b.checkedEntry < end;
+		};
+
+		// Blocks destroyed earlier still count, other blocks may jump to the
+		// stub WriteDestroyBlock left at their entry.
+		std::set<u32> evicted_addresses;
+		for (int i = 0; i < num_blocks; i++)
+		{
+			if (in_range(blocks[i]))
+				evicted_addresses.insert(blocks[i].originalAddress);
+		}
+		if (evicted_addresses.empty())
+			return 0;
+
+		for (int i = 0; i < num_blocks; i++)
+		{
+			JitBlock &b = blocks[i];
+			if (b.invalid || in_range(b))
+				continue;
+
+			for (auto& e : b.linkData)
+			{
+				if (!evicted_addresses.count(e.exitAddress))
+					continue;
+
+				// A linked exit may go to a newer block outside of the range,
+				// an unlinked one may still jump to the stub of a destroyed block.
+				if (e.linkStatus)
+				{
+					int destination = GetBlockNumberFromStartAddress(e.exitAddress);
+					if (destination != -1 && !in_range(blocks[destination]))
+						continue;
+				}
+				WriteDestroyBlock(e.exitPtrs, e.exitAddress);
+				e.linkStatus = false;
+			}
+		}
+
+		int evicted = 0;
+		for (int i = 0; i < num_blocks; i++)
+		{
+			JitBlock &b = blocks[i];
+			if (!in_range(b))
+				continue;
+
+			u32* icp = GetICachePtr(b.originalAddress);
+			if (*icp == (u32)i)
+				*icp = JIT_ICACHE_INVALID_WORD;
+
+			// Destroyed blocks were removed already
+			if (!b.invalid)
+				RemoveFromBlockMap(i);
+
+			// The sources of links into the block are kept, so that they get
+			// linked again once it's recompiled.
+			for (const auto& e : b.linkData)
+			{
+				std::vector<int>* sources = links_to.Find(e.exitAddress);
+				if (!sources)
+					continue;
+				sources->erase(std::remove(sources->begin(), sources->end(), i), sources->end());
+				if (sources->empty())
+					links_to.Erase(e.exitAddress);
+			}
+
+			{
+				std::lock_guard<std::mutex> lk(code_map_lock);
+				code_map.erase(b.checkedEntry);
+			}
+
+			b.invalid = true;
+			b.checkedEntry = NULL;
+			b.normalEntry = NULL;
+			b.linkData.clear();
+			blockCodePointers[i] = NULL;
+			free_blocks.push_back(i);
+			evicted++;
+		}
+		return evicted;
+	}
+
 	void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length)
 	{
 		// Convert the logical address to a physical address for the block map
@@ -358,23 +615,68 @@ using namespace Gen;
 		}
 
 		// destroy JIT blocks
-		// !! this works correctly under assumption that any two overlapping blocks end at the same address
 		if (destroy_block)
 		{
-			std::map<pair<u32,u32>, u32>::iterator it1 = block_map.lower_bound(std::make_pair(pAddr, 0)), it2 = it1;
-			while (it2 != block_map.end() && it2->first.second < pAddr + length)
-		{
-				JitBlock &b = blocks[it2->second];
-				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
-				DestroyBlock(it2->second, true);
-				++it2;
+			const u32 pEnd = pAddr + length - 1;
+			auto overlaps = [&](int i) {
+				bool result = false;
+				ForEachRange(blocks[i], [&](u32 first, u32 last) {
+					result |= first <= pEnd && last >= pAddr;
+				});
+				return result;
+			};
+
+			// Blocks are listed under every range they overlap, so collect
+			// them before destroying any
+			std::vector<int> destroyed;
+			const u32 first_key = pAddr >> BLOCK_MAP_SHIFT, last_key = pEnd >> BLOCK_MAP_SHIFT;
+			if (last_key - first_key < block_map.Size())
+			{
+				for (u32 key = first_key; key <= last_key; ++key)
+				{
+					if (const std::vector<int>* overlapping = block_map.Find(key))
+					{
+						for (int i : *overlapping)
+						{
+							if (overlaps(i))
+								destroyed.push_back(i);
+						}
+					}
+				}
 			}
-			if (it1 != it2)
+			else
+			{
+				// Huge ranges, like whole DMA transfers, are quicker to check
+				// against every listed block
+				block_map.ForEach([&](u32 key, std::vector<int>& overlapping) {
+					if (key < first_key || key > last_key)
+						return;
+					for (int i : overlapping)
+					{
+						if (overlaps(i))
+							destroyed.push_back(i);
+					}
+				});
+			}
+			std::sort(destroyed.begin(), destroyed.end());
+			destroyed.erase(std::unique(destroyed.begin(), destroyed.end()), destroyed.end());
+
+			for (int i : destroyed)
 			{
-				block_map.erase(it1, it2);
+				JitBlock &b = blocks[i];
+				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
+				DestroyBlock(i, true);
 			}
 		}
 
+		// Forget remembered blocks that start in the invalidated range, they
+		// must not be warmed up again unless they get recompiled.
+		if (persistent_enabled && !persistent_blocks.empty())
+		{
+			persistent_blocks.erase(persistent_blocks.lower_bound(address),
+			                        persistent_blocks.lower_bound(address + length));
+		}
+
 		// invalidate iCache.
 		// icbi can be called with any address, so we should check
 		if ((address & ~JIT_ICACHE_MASK) != 0x80000000 && (address & ~JIT_ICACHE_MASK) != 0x00000000 &&
@@ -399,6 +701,80 @@ using namespace Gen;
 			memset(iCache + cacheaddr, JIT_ICACHE_INVALID_BYTE, length);
 		}
 	}
+	void JitBaseBlockCache::OpenPersistentCache(const std::string& filename, u32 settings)
+	{
+		persistent_blocks.clear();
+		persistent_filename = filename;
+		persistent_settings = settings;
+		persistent_enabled = true;
+
+		LinearDiskCache<PersistentBlockKey, u32> disk_cache;
+		PersistentBlockReader reader(persistent_blocks, settings);
+		disk_cache.OpenAndRead(filename.c_str(), reader, true);
+		disk_cache.Close();
+
+		INFO_LOG(DYNA_REC, "Loaded %u persistent JIT blocks from %s",
+		         (u32)persistent_blocks.size(), filename.c_str());
+	}
+
+	void JitBaseBlockCache::ClosePersistentCache()
+	{
+		if (!persistent_enabled)
+			return;
+		persistent_enabled = false;
+
+		if (Core::g_CoreStartupParameter.bReadOnlyCaches)
+		{
+			persistent_blocks.clear();
+			return;
+		}
+
+		// The disk cache is append-only, so rewrite it from scratch to drop
+		// entries that were invalidated during this session.
+		File::Delete(persistent_filename);
+
+		LinearDiskCache<PersistentBlockKey, u32> disk_cache;
+		PersistentBlockReader reader(persistent_blocks, persistent_settings);
+		disk_cache.OpenAndRead(persistent_filename.c_str(), reader);
+
+		for (const auto& entry : persistent_blocks)
+		{
+			PersistentBlockKey key;
+			key.address = entry.first;
+			key.settings = persistent_settings;
+			const u32 value[2] = { entry.second.size, entry.second.codeHash };
+			disk_cache.Append(key, value, 2);
+		}
+		disk_cache.Sync();
+		disk_cache.Close();
+
+		persistent_blocks.clear();
+	}
+
+	void JitBaseBlockCache::GetPersistentBlocks(std::vector<u32>& addresses)
+	{
+		addresses.clear();
+		if (!persistent_enabled)
+			return;
+
+		auto it = persistent_blocks.begin();
+		while (it != persistent_blocks.end())
+		{
+			u32 hash;
+			if (HashGuestCode(it->first, it->second.size, &hash) && hash == it->second.codeHash)
+			{
+				addresses.push_back(it->first);
+				++it;
+			}
+			else
+			{
+				// Code got replaced since the entry was recorded (e.g. a different
+				// REL is loaded at this point); it'll be re-added if it's compiled.
+				persistent_blocks.erase(it++);
+			}
+		}
+	}
+
 	void JitBlockCache::WriteLinkBlock(u8* location, const u8* address)
 	{
 		XEmitter emit(location);
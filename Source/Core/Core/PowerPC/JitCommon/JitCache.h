@@ -6,8 +6,13 @@
 
 #include <bitset>
 #include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "FlatHashMap.h"
+#include "StdMutex.h"
+
 #include "../Gekko.h"
 #include "../PPCAnalyst.h"
 
@@ -38,6 +43,8 @@ struct JitBlock
 	u32 codeSize;
 	u32 originalSize;
 	int runCount;  // for profiling.
+	u32 downcountAmount;  // emulated cycles of one run, for profiling.
+	int tierUpCounter;  // runs left before a quickly compiled block gets recompiled.
 	int flags;
 
 	bool invalid;
@@ -49,13 +56,16 @@ struct JitBlock
 	};
 	std::vector<LinkData> linkData;
 
-#ifdef _WIN32
+	// First and last physical byte of every run of code that was compiled
+	// into the block from outside its own range, like inlined functions
+	std::vector<std::pair<u32, u32>> inlinedRanges;
+
 	// we don't really need to save start and stop
 	// TODO (mb2): ticStart and ticStop -> "local var" mean "in block" ... low priority ;)
 	u64 ticStart;		// for profiling - time.
 	u64 ticStop;		// for profiling - time.
 	u64 ticCounter;	// for profiling - time.
-#endif
+	u32 compileTimeUs;  // host time from AllocateBlock to FinalizeBlock
 
 #ifdef USE_VTUNE
 	char blockName[32];
@@ -64,21 +74,49 @@ struct JitBlock
 
 typedef void (*CompiledCode)();
 
+// A block entry point remembered across sessions. Only the guest side is
+// stored; the host code is regenerated on the next boot since it is full of
+// absolute pointers into this process.
+struct JitPersistentBlock
+{
+	u32 size;      // in instructions
+	u32 codeHash;  // hash of the guest instructions at compile time
+};
+
 
 class JitBaseBlockCache
 {
 	const u8 **blockCodePointers;
 	JitBlock *blocks;
 	int num_blocks;
-	std::multimap<u32, int> links_to;
-	std::map<std::pair<u32,u32>, u32> block_map; // (end_addr, start_addr) -> number
+	// exit address -> blocks with an exit to it
+	FlatHashMap<u32, std::vector<int>> links_to;
+	// physical address >> BLOCK_MAP_SHIFT -> blocks overlapping that range
+	FlatHashMap<u32, std::vector<int>> block_map;
 	std::bitset<0x20000000 / 32> valid_block;
+	std::vector<int> free_blocks; // numbers of evicted blocks, reused before num_blocks grows
+	// host code start -> block, for looking up code pointers from other threads
+	std::map<const u8*, int> code_map;
+	std::mutex code_map_lock;
 	enum
 	{
-		MAX_NUM_BLOCKS = 65536*2
+		MAX_NUM_BLOCKS = 65536*2,
+		BLOCK_MAP_SHIFT = 8
 	};
 
+	std::map<u32, JitPersistentBlock> persistent_blocks; // start_addr -> info
+	std::string persistent_filename;
+	u32 persistent_settings;
+	bool persistent_enabled;
+
+	// For the block stats, kept across Clear()
+	u64 compile_start_us;
+	u64 total_compile_us;
+	u32 total_compiled;
+
 	bool RangeIntersect(int s1, int e1, int s2, int e2) const;
+	void AddToBlockMap(int i);
+	void RemoveFromBlockMap(int i);
 	void LinkBlockExits(int i);
 	void LinkBlock(int i);
 	void UnlinkBlock(int i);
@@ -90,9 +128,15 @@ class JitBaseBlockCache
 public:
 	JitBaseBlockCache() :
 		blockCodePointers(0), blocks(0), num_blocks(0),
+		persistent_settings(0), persistent_enabled(false),
+		compile_start_us(0), total_compile_us(0), total_compiled(0),
 		iCache(0), iCacheEx(0), iCacheVMEM(0) {}
 	int AllocateBlock(u32 em_address);
 	void FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr);
+	// Records the code that PPCAnalyst::Flatten() merged into the block from
+	// outside its own range, so that writes to it invalidate the block.
+	// Call once originalSize is set.
+	static void FindInlinedRanges(JitBlock &b, const PPCAnalyst::CodeOp *ops, u32 size);
 
 	void Clear();
 	void ClearSafe();
@@ -105,6 +149,10 @@ public:
 	// Code Cache
 	JitBlock *GetBlock(int block_num);
 	int GetNumBlocks() const;
+	// Blocks compiled and the host time spent on them since Init, including
+	// the ones that were evicted or cleared since
+	u32 GetNumCompiledBlocks() const { return total_compiled; }
+	u64 GetTotalCompileTimeUs() const { return total_compile_us; }
 	const u8 **GetCodePointers();
 	u8 *iCache;
 	u8 *iCacheEx;
@@ -115,6 +163,10 @@ public:
 	// Fast way to get a block. Only works on the first ppc instruction of a block.
 	int GetBlockNumberFromStartAddress(u32 em_address);
 
+	// Finds the start address of the block whose host code contains ptr.
+	// Thread safe, for the sampling profiler.
+	bool GetBlockAddressFromCodePointer(const u8* ptr, u32* em_address);
+
 	u32 GetOriginalFirstOp(int block_num);
 	CompiledCode GetCompiledCodeFromBlock(int block_num);
 
@@ -122,6 +174,20 @@ public:
 	void InvalidateICache(u32 address, const u32 length);
 	void DestroyBlock(int block_num, bool invalidate);
 
+	// Throws away every block whose code is in [start, end), so that the
+	// memory can be reused while the rest of the cache stays intact. Exits of
+	// other blocks which jump into the range are sent back to the dispatcher,
+	// so the unlinked exit sequence must have room for WriteDestroyBlock.
+	// Returns the number of blocks evicted.
+	int EvictBlocks(const u8* start, const u8* end);
+
+	// Persistent block list. settings identifies the JIT configuration the
+	// blocks were compiled with; entries recorded under a different one are ignored.
+	void OpenPersistentCache(const std::string& filename, u32 settings);
+	void ClosePersistentCache();
+	// Returns the start addresses of remembered blocks whose guest code is unchanged.
+	void GetPersistentBlocks(std::vector<u32>& addresses);
+
 	// Not currently used
 	//void DestroyBlocksWithFlag(BlockFlag death_flag);
 };
@@ -8,6 +8,9 @@
 #include "JitBase.h"
 #include "Jit_Util.h"
 
+#include "../../HW/GPFifo.h"
+#include "../../HW/MMIO.h"
+
 using namespace Gen;
 
 static const u8 GC_ALIGNED16(pbswapShuffle1x4[16]) = {3, 2, 1, 0, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
@@ -117,6 +120,103 @@ u8 *EmuCodeBlock::UnsafeLoadToReg(X64Reg reg_value, Gen::OpArg opAddress, int ac
 	return result;
 }
 
+// Emits the code of a read handling method that doesn't need a call
+template <typename T>
+class MMIOReadCodeGenerator : public MMIO::ReadHandlingMethodVisitor<T>
+{
+public:
+	MMIOReadCodeGenerator(EmuCodeBlock* code, X64Reg reg_value, bool sign_extend)
+		: m_code(code), m_reg_value(reg_value), m_sign_extend(sign_extend), m_generated(false)
+	{
+	}
+
+	bool IsGenerated() const { return m_generated; }
+
+	void VisitConstant(T value) override
+	{
+		u32 imm = value;
+		if (m_sign_extend && sizeof(T) == 1)
+			imm = (u32)(s32)(s8)value;
+		else if (m_sign_extend && sizeof(T) == 2)
+			imm = (u32)(s32)(s16)value;
+		m_code->MOV(32, R(m_reg_value), Imm32(imm));
+		m_generated = true;
+	}
+
+	void VisitDirect(const T* addr, u32 mask) override
+	{
+		const int size = sizeof(T) * 8;
+#ifdef _M_X64
+		// The variable may be anywhere in the address space
+		m_code->MOV(64, R(m_reg_value), ImmPtr((void*)addr));
+		m_code->MOVZX(32, size, m_reg_value, MatR(m_reg_value));
+#else
+		m_code->MOVZX(32, size, m_reg_value, M((void*)addr));
+#endif
+		const u32 all_bits = (u32)(T)0xFFFFFFFF;
+		if ((mask & all_bits) != all_bits)
+			m_code->AND(32, R(m_reg_value), Imm32(mask & all_bits));
+		if (m_sign_extend && size < 32)
+			m_code->MOVSX(32, size, m_reg_value, R(m_reg_value));
+		m_generated = true;
+	}
+
+	void VisitComplex(std::function<T(u32)> lambda) override
+	{
+	}
+
+private:
+	EmuCodeBlock* m_code;
+	X64Reg m_reg_value;
+	bool m_sign_extend;
+	bool m_generated;
+};
+
+template <typename T>
+static bool GenerateMMIORead(EmuCodeBlock* code, const MMIO::ReadHandler<T>& handler, X64Reg reg_value, bool signExtend)
+{
+	MMIOReadCodeGenerator<T> generator(code, reg_value, signExtend);
+	handler.Visit(generator);
+	return generator.IsGenerated();
+}
+
+bool EmuCodeBlock::MMIOLoadToReg(X64Reg reg_value, u32 address, int accessSize, bool signExtend)
+{
+	if (!MMIO::IsMMIOAddress(address) || (address & (accessSize / 8 - 1)))
+		return false;
+	// Memory checks are only done by the Memory:: functions
+	if (Memory::bSlowMemChecks)
+		return false;
+
+	switch (accessSize)
+	{
+	case 32: return GenerateMMIORead(this, Memory::mmio_mapping->GetHandlerForRead32(address), reg_value, signExtend);
+	case 16: return GenerateMMIORead(this, Memory::mmio_mapping->GetHandlerForRead16(address), reg_value, signExtend);
+	case 8:  return GenerateMMIORead(this, Memory::mmio_mapping->GetHandlerForRead8(address), reg_value, signExtend);
+	}
+	return false;
+}
+
+#ifdef _M_X64
+FixupBranch EmuCodeBlock::CheckMMUFastmemPage(const OpArg& opAddress, X64Reg reg_keep)
+{
+	// RAX is free in the safe loads and stores unless it holds one of the
+	// operands, otherwise RCX or RDX gets saved instead
+	X64Reg scratch = RAX;
+	if (opAddress.IsSimpleReg(RAX) || reg_keep == RAX)
+		scratch = (opAddress.IsSimpleReg(RCX) || reg_keep == RCX) ? RDX : RCX;
+
+	if (scratch != RAX)
+		PUSH(64, R(scratch));
+	MOV(32, R(scratch), opAddress);
+	SHR(32, R(scratch), Imm8(Memory::FASTMEM_PAGE_SHIFT));
+	CMP(8, MDisp(scratch, (u32)(u64)Memory::fastmem_pages), Imm8(0));
+	if (scratch != RAX)
+		POP(64, R(scratch));
+	return J_CC(CC_NZ, true);
+}
+#endif
+
 void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress, int accessSize, s32 offset, u32 registersInUse, bool signExtend, int flags)
 {
 	if (!jit->js.memcheck)
@@ -127,12 +227,12 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 	if (!Core::g_CoreStartupParameter.bMMU &&
 	    Core::g_CoreStartupParameter.bFastmem &&
 	    !opAddress.IsImm() &&
-	    !(flags & (SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_FASTMEM))
-#ifdef ENABLE_MEM_CHECK
-	    && !Core::g_CoreStartupParameter.bEnableDebugging
-#endif
-	    )
+	    !(flags & (SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_FASTMEM)) &&
+	    !Memory::bSlowMemChecks)
 	{
+		// For the log of a memory check, if the load gets backpatched
+		if (Memory::bPagedMemChecks)
+			MOV(32, M(&PC), Imm32(jit->js.compilerPC));
 		u8 *mov = UnsafeLoadToReg(reg_value, opAddress, accessSize, offset, signExtend);
 
 		registersInUseAtLoc[mov] = registersInUse;
@@ -146,12 +246,9 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 			mem_mask |= Memory::ADDR_MASK_MEM1;
 		}
 
-#ifdef ENABLE_MEM_CHECK
-		if (Core::g_CoreStartupParameter.bEnableDebugging)
-		{
-			mem_mask |= Memory::EXRAM_MASK;
-		}
-#endif
+		// The direct accesses below aren't backpatched
+		if (Memory::HasMemChecks())
+			mem_mask = 0xFFFFFFFF;
 
 		if (opAddress.IsImm())
 		{
@@ -160,7 +257,7 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 			{
 				UnsafeLoadToReg(reg_value, opAddress, accessSize, offset, signExtend);
 			}
-			else
+			else if (!MMIOLoadToReg(reg_value, address, accessSize, signExtend))
 			{
 				ABI_PushRegistersAndAdjustStack(registersInUse, false);
 				switch (accessSize)
@@ -194,6 +291,11 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 				ADD(32, R(EAX), Imm32(offset));
 				TEST(32, R(EAX), Imm32(mem_mask));
 				FixupBranch fast = J_CC(CC_Z, true);
+#ifdef _M_X64
+				FixupBranch mapped;
+				if (Memory::bMMUFastmem)
+					mapped = CheckMMUFastmemPage(R(EAX));
+#endif
 
 				ABI_PushRegistersAndAdjustStack(registersInUse, false);
 				switch (accessSize)
@@ -220,6 +322,10 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 
 				FixupBranch exit = J();
 				SetJumpTarget(fast);
+#ifdef _M_X64
+				if (Memory::bMMUFastmem)
+					SetJumpTarget(mapped);
+#endif
 				UnsafeLoadToReg(reg_value, R(EAX), accessSize, 0, signExtend);
 				SetJumpTarget(exit);
 			}
@@ -227,6 +333,11 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 			{
 				TEST(32, opAddress, Imm32(mem_mask));
 				FixupBranch fast = J_CC(CC_Z, true);
+#ifdef _M_X64
+				FixupBranch mapped;
+				if (Memory::bMMUFastmem)
+					mapped = CheckMMUFastmemPage(opAddress);
+#endif
 
 				ABI_PushRegistersAndAdjustStack(registersInUse, false);
 				switch (accessSize)
@@ -253,6 +364,10 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 
 				FixupBranch exit = J();
 				SetJumpTarget(fast);
+#ifdef _M_X64
+				if (Memory::bMMUFastmem)
+					SetJumpTarget(mapped);
+#endif
 				UnsafeLoadToReg(reg_value, opAddress, accessSize, offset, signExtend);
 				SetJumpTarget(exit);
 			}
@@ -285,11 +400,8 @@ void EmuCodeBlock::SafeWriteRegToReg(X64Reg reg_value, X64Reg reg_addr, int acce
 #if defined(_M_X64)
 	if (!Core::g_CoreStartupParameter.bMMU &&
 	    Core::g_CoreStartupParameter.bFastmem &&
-	    !(flags & (SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_FASTMEM))
-#ifdef ENABLE_MEM_CHECK
-	    && !Core::g_CoreStartupParameter.bEnableDebugging
-#endif
-	    )
+	    !(flags & (SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_FASTMEM)) &&
+	    !Memory::bSlowMemChecks)
 	{
 		MOV(32, M(&PC), Imm32(jit->js.compilerPC)); // Helps external systems know which instruction triggered the write
 		u8 *mov = UnsafeWriteRegToReg(reg_value, reg_addr, accessSize, offset, !(flags & SAFE_LOADSTORE_NO_SWAP));
@@ -314,16 +426,18 @@ void EmuCodeBlock::SafeWriteRegToReg(X64Reg reg_value, X64Reg reg_addr, int acce
 		mem_mask |= Memory::ADDR_MASK_MEM1;
 	}
 
-#ifdef ENABLE_MEM_CHECK
-	if (Core::g_CoreStartupParameter.bEnableDebugging)
-	{
-		mem_mask |= Memory::EXRAM_MASK;
-	}
-#endif
+	// The direct access below isn't backpatched
+	if (Memory::HasMemChecks())
+		mem_mask = 0xFFFFFFFF;
 
 	MOV(32, M(&PC), Imm32(jit->js.compilerPC)); // Helps external systems know which instruction triggered the write
 	TEST(32, R(reg_addr), Imm32(mem_mask));
 	FixupBranch fast = J_CC(CC_Z, true);
+#ifdef _M_X64
+	FixupBranch mapped;
+	if (Memory::bMMUFastmem)
+		mapped = CheckMMUFastmemPage(R(reg_addr), reg_value);
+#endif
 	bool noProlog = (0 != (flags & SAFE_LOADSTORE_NO_PROLOG));
 	bool swap = !(flags & SAFE_LOADSTORE_NO_SWAP);
 	ABI_PushRegistersAndAdjustStack(registersInUse, noProlog);
@@ -336,6 +450,10 @@ void EmuCodeBlock::SafeWriteRegToReg(X64Reg reg_value, X64Reg reg_addr, int acce
 	ABI_PopRegistersAndAdjustStack(registersInUse, noProlog);
 	FixupBranch exit = J();
 	SetJumpTarget(fast);
+#ifdef _M_X64
+	if (Memory::bMMUFastmem)
+		SetJumpTarget(mapped);
+#endif
 	UnsafeWriteRegToReg(reg_value, reg_addr, accessSize, 0, swap);
 	SetJumpTarget(exit);
 }
@@ -349,10 +467,8 @@ void EmuCodeBlock::SafeWriteFloatToReg(X64Reg xmm_value, X64Reg reg_addr, u32 re
 		if (Core::g_CoreStartupParameter.bMMU || Core::g_CoreStartupParameter.bTLBHack)
 			mem_mask |= Memory::ADDR_MASK_MEM1;
 
-#ifdef ENABLE_MEM_CHECK
-		if (Core::g_CoreStartupParameter.bEnableDebugging)
-			mem_mask |= Memory::EXRAM_MASK;
-#endif
+		if (Memory::HasMemChecks())
+			mem_mask = 0xFFFFFFFF;
 		TEST(32, R(reg_addr), Imm32(mem_mask));
 		FixupBranch argh = J_CC(CC_Z);
 		MOVSS(M(&float_buffer), xmm_value);
@@ -398,6 +514,34 @@ void EmuCodeBlock::WriteFloatToConstRamAddress(const Gen::X64Reg& xmm_reg, u32 a
 #endif
 }
 
+void EmuCodeBlock::WriteToGatherPipe(int accessSize, X64Reg reg_value)
+{
+	BSWAP(accessSize, reg_value);
+	MOV(32, R(EAX), M(&GPFifo::m_gatherPipeCount));
+	MOV(accessSize, MDisp(EAX, (u32)(u64)GPFifo::m_gatherPipe), R(reg_value));
+	ADD(32, R(EAX), Imm8(accessSize >> 3));
+	MOV(32, M(&GPFifo::m_gatherPipeCount), R(EAX));
+}
+
+void EmuCodeBlock::WriteFloatToGatherPipe(X64Reg xmm_value)
+{
+	if (cpu_info.bSSSE3)
+	{
+		PSHUFB(xmm_value, M((void *)pbswapShuffle1x4));
+	}
+	else
+	{
+		MOVSS(M(&float_buffer), xmm_value);
+		MOV(32, R(EAX), M(&float_buffer));
+		BSWAP(32, EAX);
+		MOVD_xmm(xmm_value, R(EAX));
+	}
+	MOV(32, R(EAX), M(&GPFifo::m_gatherPipeCount));
+	MOVSS(MDisp(EAX, (u32)(u64)GPFifo::m_gatherPipe), xmm_value);
+	ADD(32, R(EAX), Imm8(4));
+	MOV(32, M(&GPFifo::m_gatherPipeCount), R(EAX));
+}
+
 void EmuCodeBlock::ForceSinglePrecisionS(X64Reg xmm) {
 	// Most games don't need these. Zelda requires it though - some platforms get stuck without them.
 	if (jit->jo.accurateSinglePrecision)
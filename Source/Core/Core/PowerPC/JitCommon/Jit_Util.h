@@ -35,12 +35,25 @@ public:
 	};
 	void SafeLoadToReg(Gen::X64Reg reg_value, const Gen::OpArg & opAddress, int accessSize, s32 offset, u32 registersInUse, bool signExtend, int flags = 0);
 	void SafeWriteRegToReg(Gen::X64Reg reg_value, Gen::X64Reg reg_addr, int accessSize, s32 offset, u32 registersInUse, int flags = 0);
+#ifdef _M_X64
+	// For MMU fastmem, jumps if the page of the address is mirrored at its
+	// effective address (see Memory::MapFastmemPage). Trashes EAX, or saves
+	// another register if EAX is the address or reg_keep.
+	Gen::FixupBranch CheckMMUFastmemPage(const Gen::OpArg& opAddress, Gen::X64Reg reg_keep = Gen::INVALID_REG);
+#endif
+	// Inlines the read of a hardware register at a constant address, if its
+	// handler is a constant or a variable. Returns false if it must be called.
+	bool MMIOLoadToReg(Gen::X64Reg reg_value, u32 address, int accessSize, bool signExtend);
 
 	// Trashes both inputs and EAX.
 	void SafeWriteFloatToReg(Gen::X64Reg xmm_value, Gen::X64Reg reg_addr, u32 registersInUse, int flags = 0);
 
 	void WriteToConstRamAddress(int accessSize, const Gen::OpArg& arg, u32 address);
 	void WriteFloatToConstRamAddress(const Gen::X64Reg& xmm_reg, u32 address);
+	// Append to the gather pipe inline; the caller is responsible for getting
+	// CheckGatherPipe called. Both byteswap the value in place and trash EAX.
+	void WriteToGatherPipe(int accessSize, Gen::X64Reg reg_value);
+	void WriteFloatToGatherPipe(Gen::X64Reg xmm_value);
 	void JitClearCA();
 	void JitSetCA();
 	void JitClearCAOV(bool oe);
@@ -95,7 +95,6 @@ Scheduling to reduce register pressure: PowerPC	compilers like to push
 	uses far away from definitions, but it's rather unfriendly to modern
 	x86 processors, which are short on registers and extremely good at
 	instruction reordering.
-Common subexpression elimination
 Optimize load/store of sum using complex addressing (partially implemented)
 Loop optimizations (loop-carried registers, LICM)
 Code refactoring/cleanup
@@ -139,6 +138,13 @@ InstLoc IRBuilder::EmitZeroOp(unsigned Opcode, unsigned extra = 0) {
 }
 
 InstLoc IRBuilder::EmitUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
+	const u64 key = GetCSEKey(Opcode, Op1, nullptr, extra);
+	if (key) {
+		auto it = CSETable.find(key);
+		if (it != CSETable.end())
+			return it->second;
+	}
+
 	InstLoc curIndex = InstList.data() + InstList.size();
 	unsigned backOp1 = (s32)(curIndex - 1 - Op1);
 	if (backOp1 >= 256) {
@@ -149,10 +155,19 @@ InstLoc IRBuilder::EmitUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
 	}
 	InstList.push_back(Opcode | (backOp1 << 8) | (extra << 16));
 	MarkUsed.push_back(false);
+	if (key)
+		CSETable[key] = curIndex;
 	return curIndex;
 }
 
 InstLoc IRBuilder::EmitBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned extra) {
+	const u64 key = GetCSEKey(Opcode, Op1, Op2, extra);
+	if (key) {
+		auto it = CSETable.find(key);
+		if (it != CSETable.end())
+			return it->second;
+	}
+
 	InstLoc curIndex = InstList.data() + InstList.size();
 	unsigned backOp1 = (s32)(curIndex - 1 - Op1);
 	if (backOp1 >= 255) {
@@ -171,9 +186,34 @@ InstLoc IRBuilder::EmitBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned
 	}
 	InstList.push_back(Opcode | (backOp1 << 8) | (backOp2 << 16) | (extra << 24));
 	MarkUsed.push_back(false);
+	if (key)
+		CSETable[key] = curIndex;
 	return curIndex;
 }
 
+// Instructions which only compute a value from their operands, and so can be
+// reused instead of computed again
+static bool IsPure(unsigned Opcode) {
+	return (Opcode >= SExt8 && Opcode <= Not) ||
+	       (Opcode >= Add && Opcode <= ICmpSle) ||
+	       (Opcode >= DoubleToSingle && Opcode <= CompactMRegToPacked) ||
+	       (Opcode >= FSMul && Opcode <= FPDup1) ||
+	       Opcode == FDCmpCR;
+}
+
+// Zero if the instruction can't be looked up in the CSE table
+u64 IRBuilder::GetCSEKey(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned extra) const {
+	if (!UseCSE || !IsPure(Opcode) || extra > 255)
+		return 0;
+
+	const u64 index1 = Op1 - InstList.data() + 1;
+	const u64 index2 = Op2 ? Op2 - InstList.data() + 1 : 0;
+	if (index1 >= (1 << 24) || index2 >= (1 << 24))
+		return 0;
+
+	return Opcode | (extra << 8) | (index1 << 16) | (index2 << 40);
+}
+
 #if 0
 InstLoc IRBuilder::EmitTriOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, InstLoc Op3) {
 	InstLoc curIndex = InstList.data() + InstList.size();
@@ -349,6 +389,12 @@ InstLoc IRBuilder::FoldUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
 			return getOp1(Op1);
 		}
 	}
+	if (Opcode == Load8 || Opcode == Load16 || Opcode == Load32) {
+		return FoldLoad(Opcode, Op1);
+	}
+	if (Opcode == SystemCall) {
+		MemCacheAddr = 0;
+	}
 
 	return EmitUOp(Opcode, Op1, extra);
 }
@@ -1008,9 +1054,42 @@ InstLoc IRBuilder::FoldInterpreterFallback(InstLoc Op1, InstLoc Op2) {
 	}
 	CTRCache = 0;
 	CTRCacheStore = 0;
+	// The interpreter can change the rounding mode and write memory
+	CSETable.clear();
+	MemCacheAddr = 0;
 	return EmitBiOp(InterpreterFallback, Op1, Op2);
 }
 
+// Store forwarding: a load from the address of the previous load or store of
+// the same size, with no other store in between, gives the same value. This
+// doesn't hold for MMIO, whose registers can change between two reads.
+InstLoc IRBuilder::FoldLoad(unsigned Opcode, InstLoc Op1) {
+	if (UseStoreForwarding && MemCacheAddr == Op1 && MemCacheOpcode == Opcode) {
+		if (!MemCacheFromStore || Opcode == Load32)
+			return MemCacheValue;
+		return FoldAnd(MemCacheValue, EmitIntConst(Opcode == Load8 ? 0xFF : 0xFFFF));
+	}
+
+	InstLoc value = EmitUOp(Opcode, Op1);
+	MemCacheAddr = Op1;
+	MemCacheValue = value;
+	MemCacheOpcode = Opcode;
+	MemCacheFromStore = false;
+	return value;
+}
+
+InstLoc IRBuilder::FoldStore(unsigned Opcode, InstLoc Op1, InstLoc Op2) {
+	// Any store can alias the cached access
+	MemCacheAddr = 0;
+	if (Opcode == Store8 || Opcode == Store16 || Opcode == Store32) {
+		MemCacheAddr = Op2;
+		MemCacheValue = Op1;
+		MemCacheOpcode = Opcode == Store8 ? Load8 : Opcode == Store16 ? Load16 : Load32;
+		MemCacheFromStore = true;
+	}
+	return EmitBiOp(Opcode, Op1, Op2);
+}
+
 InstLoc IRBuilder::FoldDoubleBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2) {
 	if (getOpcode(*Op1) == InsertDoubleInMReg) {
 		return FoldDoubleBiOp(Opcode, getOp1(Op1), Op2);
@@ -1045,18 +1124,90 @@ InstLoc IRBuilder::FoldBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned
 		case ICmpCRUnsigned: return FoldICmpCRUnsigned(Op1, Op2);
 		case InterpreterFallback: return FoldInterpreterFallback(Op1, Op2);
 		case FDMul: case FDAdd: case FDSub: return FoldDoubleBiOp(Opcode, Op1, Op2);
+		case Store8: case Store16: case Store32:
+		case StoreSingle: case StoreDouble:
+			return FoldStore(Opcode, Op1, Op2);
+		case StorePaired:
+			MemCacheAddr = 0;
+			return EmitBiOp(Opcode, Op1, Op2, extra);
 		default: return EmitBiOp(Opcode, Op1, Op2, extra);
 	}
 }
 
 InstLoc IRBuilder::EmitIntConst(unsigned value) {
+	// Equal constants share an instruction, so that the instructions using
+	// them are found by CSE
+	const u64 key = CInt32 | ((u64)value << 8);
+	if (UseCSE) {
+		auto it = CSETable.find(key);
+		if (it != CSETable.end())
+			return it->second;
+	}
+
 	InstLoc curIndex = InstList.data() + InstList.size();
 	InstList.push_back(CInt32 | ((unsigned int)ConstList.size() << 8));
 	MarkUsed.push_back(false);
 	ConstList.push_back(value);
+	if (UseCSE)
+		CSETable[key] = curIndex;
 	return curIndex;
 }
 
+void IRBuilder::ResetPasses() {
+	const SCoreStartupParameter& params = Core::g_CoreStartupParameter;
+	UseCSE = params.bJITILCommonSubexpressions;
+	UseStoreForwarding = params.bJITILStoreForwarding;
+	UseDeadStores = params.bJITILDeadStores;
+	CSETable.clear();
+	MemCacheAddr = 0;
+}
+
+// Dead register store elimination: drops the stores of a value that the
+// register already holds, because it was loaded from there or stored before.
+// Overwritten stores are already dropped while building.
+void IRBuilder::EliminateRedundantStores() {
+	InstLoc gregs[32] = {}, fregs[32] = {}, crs[8] = {};
+	InstLoc carry = 0, ctr = 0;
+
+	StartForwardPass();
+	for (unsigned i = 0; i < getNumInsts(); i++) {
+		InstLoc I = ReadForward();
+		InstLoc* known;
+		switch (getOpcode(*I)) {
+		case LoadGReg: gregs[*I >> 8] = I; continue;
+		case LoadFReg: fregs[*I >> 8] = I; continue;
+		case LoadFRegDENToZero: fregs[*I >> 8] = 0; continue;
+		case LoadCR: crs[*I >> 8] = I; continue;
+		case LoadCarry: carry = I; continue;
+		case LoadCTR: ctr = I; continue;
+		case StoreGReg: known = &gregs[(*I >> 16) & 31]; break;
+		case StoreFReg: known = &fregs[(*I >> 16) & 31]; break;
+		case StoreCR: known = &crs[(*I >> 16) & 7]; break;
+		case StoreCarry: known = &carry; break;
+		case StoreCTR: known = &ctr; break;
+		case InterpreterFallback:
+			std::fill(gregs, gregs + 32, (InstLoc)0);
+			std::fill(fregs, fregs + 32, (InstLoc)0);
+			std::fill(crs, crs + 8, (InstLoc)0);
+			carry = ctr = 0;
+			continue;
+		default:
+			continue;
+		}
+
+		InstLoc value = getOp1(I);
+		if (*known == value)
+			*I = 0; // Nop
+		else
+			*known = value;
+	}
+}
+
+void IRBuilder::RunPasses() {
+	if (UseDeadStores)
+		EliminateRedundantStores();
+}
+
 unsigned IRBuilder::GetImmValue(InstLoc I) const {
 	return ConstList[*I >> 8];
 }
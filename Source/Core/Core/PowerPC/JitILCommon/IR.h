@@ -5,6 +5,7 @@
 #pragma once
 
 #include "x64Emitter.h"
+#include <unordered_map>
 #include <vector>
 
 namespace IREmitter {
@@ -236,6 +237,12 @@ private:
 
 	unsigned ComputeKnownZeroBits(InstLoc I) const;
 
+	u64 GetCSEKey(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned extra) const;
+	InstLoc FoldLoad(unsigned Opcode, InstLoc Op1);
+	InstLoc FoldStore(unsigned Opcode, InstLoc Op1, InstLoc Op2);
+	void EliminateRedundantStores();
+	void ResetPasses();
+
 public:
 	InstLoc EmitIntConst(unsigned value);
 	InstLoc EmitStoreLink(InstLoc val) {
@@ -540,6 +547,9 @@ public:
 	bool IsMarkUsed(InstLoc I) const;
 	void WriteToFile(u64 codeHash);
 
+	// Runs the enabled passes over the whole block, once it is complete
+	void RunPasses();
+
 	void Reset() {
 		InstList.clear();
 		InstList.reserve(100000);
@@ -559,6 +569,7 @@ public:
 		}
 		CTRCache = 0;
 		CTRCacheStore = 0;
+		ResetPasses();
 	}
 
 	IRBuilder() { Reset(); }
@@ -586,6 +597,20 @@ private:
 	InstLoc CTRCacheStore;
 	InstLoc CRCache[8];
 	InstLoc CRCacheStore[8];
+
+	// Common subexpression elimination, keyed by opcode and operands
+	bool UseCSE;
+	std::unordered_map<u64, InstLoc> CSETable;
+
+	// The last memory access, for forwarding its value to a load from the
+	// same address
+	bool UseStoreForwarding;
+	InstLoc MemCacheAddr;
+	InstLoc MemCacheValue;
+	unsigned MemCacheOpcode; // The load of the same size
+	bool MemCacheFromStore;
+
+	bool UseDeadStores;
 };
 
 };
@@ -38,6 +38,8 @@ namespace JitInterface
 {
 	void DoState(PointerWrap &p)
 	{
+		if (p.GetMode() == PointerWrap::MODE_READ)
+			Interpreter::ClearBlockCache();
 		if (jit && p.GetMode() == PointerWrap::MODE_READ)
 			jit->GetBlockCache()->ClearSafe();
 	}
@@ -133,26 +135,19 @@ namespace JitInterface
 		std::vector<BlockStat> stats;
 		stats.reserve(jit->GetBlockCache()->GetNumBlocks());
 		u64 cost_sum = 0;
-	#ifdef _WIN32
 		u64 timecost_sum = 0;
-		u64 countsPerSec;
-		QueryPerformanceFrequency((LARGE_INTEGER *)&countsPerSec);
-	#endif
+		u64 countsPerSec = Profiler::GetTicksPerSecond();
 		for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
 		{
 			const JitBlock *block = jit->GetBlockCache()->GetBlock(i);
 			// Rough heuristic.  Mem instructions should cost more.
 			u64 cost = block->originalSize * (block->runCount / 4);
-	#ifdef _WIN32
 			u64 timecost = block->ticCounter;
-	#endif
 			// Todo: tweak.
 			if (block->runCount >= 1)
 				stats.push_back(BlockStat(i, cost));
 			cost_sum += cost;
-	#ifdef _WIN32
 			timecost_sum += timecost;
-	#endif
 		}
 
 		sort(stats.begin(), stats.end());
@@ -170,16 +165,19 @@ namespace JitInterface
 			{
 				std::string name = g_symbolDB.GetDescription(block->originalAddress);
 				double percent = 100.0 * (double)stat.cost / (double)cost_sum;
-	#ifdef _WIN32
-				double timePercent = 100.0 * (double)block->ticCounter / (double)timecost_sum;
-				fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%.2lf\t%llf\t%lf\t%i\n",
-						block->originalAddress, name.c_str(), stat.cost,
-						block->ticCounter, percent, timePercent,
-						(double)block->ticCounter*1000.0/(double)countsPerSec, block->codeSize);
-	#else
-				fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t???\t%.2lf\t???\t???\t%i\n",
-						block->originalAddress, name.c_str(), stat.cost,  percent, block->codeSize);
-	#endif
+				if (countsPerSec && timecost_sum)
+				{
+					double timePercent = 100.0 * (double)block->ticCounter / (double)timecost_sum;
+					fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%.2lf\t%llf\t%lf\t%i\n",
+							block->originalAddress, name.c_str(), stat.cost,
+							block->ticCounter, percent, timePercent,
+							(double)block->ticCounter*1000.0/(double)countsPerSec, block->codeSize);
+				}
+				else
+				{
+					fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t???\t%.2lf\t???\t???\t%i\n",
+							block->originalAddress, name.c_str(), stat.cost,  percent, block->codeSize);
+				}
 			}
 		}
 		#endif
@@ -200,12 +198,14 @@ namespace JitInterface
 	}
 	void ClearSafe()
 	{
+		Interpreter::ClearBlockCache();
 		if (jit)
 			jit->GetBlockCache()->ClearSafe();
 	}
 
 	void InvalidateICache(u32 address, u32 size)
 	{
+		Interpreter::InvalidateBlockCache(address, size);
 		if (jit)
 			jit->GetBlockCache()->InvalidateICache(address, size);
 	}
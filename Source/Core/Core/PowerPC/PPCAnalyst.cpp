@@ -5,7 +5,12 @@
 #include <string>
 #include <queue>
 
+#include "ChunkFile.h"
+#include "FileUtil.h"
+#include "FlatHashMap.h"
+#include "Hash.h"
 #include "StringUtil.h"
+#include "ThreadPool.h"
 #include "Interpreter/Interpreter.h"
 #include "../HW/Memmap.h"
 #include "JitInterface.h"
@@ -15,6 +20,7 @@
 #include "PPCAnalyst.h"
 #include "../ConfigManager.h"
 #include "../GeckoCode.h"
+#include "../HLE/HLE.h"
 
 // Analyzes PowerPC code in memory to find functions
 // After running, for each function we will know what functions it calls
@@ -34,6 +40,76 @@ using namespace std;
 static const int CODEBUFFER_SIZE = 32000;
 // 0 does not perform block merging
 static const int FUNCTION_FOLLOWING_THRESHOLD = 16;
+// Largest leaf function, in instructions, that is inlined into its callers
+static const u32 INLINE_LEAF_MAX_SIZE = 16;
+
+// Short functions that neither call anything nor branch internally, like
+// getters and setters, are compiled into the caller's block. This saves the
+// register flushes and the block exits at the call and at the return.
+static bool IsInlinableLeaf(u32 address)
+{
+	const SymbolDB::XFuncMap& functions = g_symbolDB.Symbols();
+	SymbolDB::XFuncMap::const_iterator iter = functions.find(address);
+	if (iter == functions.end())
+		return false;
+
+	const Symbol& func = iter->second;
+	return (func.flags & FFLAG_LEAF) && (func.flags & FFLAG_STRAIGHT) &&
+		func.size <= INLINE_LEAF_MAX_SIZE * 4 && HLE::GetFunctionIndex(address) == 0;
+}
+
+// A loop that only loads and computes can't change anything until an event,
+// like an interrupt or a hardware register update, happens, as long as every
+// register it reads was either written earlier in the same iteration or is
+// never written by it. Games poll flags set by interrupt handlers and MMIO
+// registers this way, and these loops can wait for the next event instead.
+static bool IsBusyWaitLoop(const CodeOp *code, int num_inst, u32 blockstart)
+{
+	if (num_inst == 0)
+		return false;
+
+	// The loop must end in a branch to the start which leaves CTR alone
+	const UGeckoInstruction branch = code[num_inst - 1].inst;
+	u32 destination;
+	if (branch.OPCD == 16 && (branch.BO & BO_DONT_DECREMENT_FLAG))
+		destination = (branch.AA ? 0 : code[num_inst - 1].address) + SignExt16(branch.BD << 2);
+	else if (branch.OPCD == 18)
+		destination = (branch.AA ? 0 : code[num_inst - 1].address) + SignExt26(branch.LI << 2);
+	else
+		return false;
+	if (destination != blockstart)
+		return false;
+
+	u32 written = 0;
+	u32 read_first = 0;
+	for (int i = 0; i < num_inst - 1; i++)
+	{
+		const CodeOp &op = code[i];
+		// Branches before the end were merged by Flatten(), they can only
+		// write the same return address to LR on every iteration
+		if (op.opinfo->type != OPTYPE_INTEGER && op.opinfo->type != OPTYPE_LOAD &&
+		    op.opinfo->type != OPTYPE_BRANCH)
+			return false;
+		// The carry would be state kept across iterations
+		if (op.opinfo->flags & (FL_SET_CA | FL_READ_CA | FL_TIMER | FL_EVIL))
+			return false;
+
+		for (s8 reg : op.regsIn)
+		{
+			if (reg >= 0 && !(written & (1 << reg)))
+				read_first |= 1 << reg;
+		}
+		for (s8 reg : op.regsOut)
+		{
+			if (reg < 0)
+				continue;
+			if (read_first & (1 << reg))
+				return false;
+			written |= 1 << reg;
+		}
+	}
+	return true;
+}
 
 CodeBuffer::CodeBuffer(int size)
 {
@@ -268,6 +344,81 @@ bool CanSwapAdjacentOps(const CodeOp &a, const CodeOp &b)
 	return true;
 }
 
+// Tracks the GPRs that are given constant values inside the block (li/lis, lis/ori
+// pairs, addi chains) so that the JITs can fold them into load and store addresses
+// even after the register cache has flushed the immediate. Blocks are straight-line
+// code, so the values hold until something else writes the register. Ops that set a
+// register to the value it already holds are skipped.
+static void PropagateConstants(CodeOp *code, int num_inst)
+{
+	bool known[32] = {};
+	u32 values[32] = {};
+	// A skipped op can't hit a breakpoint
+	const bool allowSkip = !SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableDebugging;
+
+	for (int i = 0; i < num_inst; i++)
+	{
+		CodeOp &op = code[i];
+		UGeckoInstruction inst = op.inst;
+
+		op.hasConstA = known[inst.RA];
+		op.constA = values[inst.RA];
+
+		// lmw and the string ops write registers the flags don't describe, and HLE
+		// functions may change any of them.
+		if ((op.opinfo->flags & FL_EVIL) || op.opinfo->type == OPTYPE_SYSTEM ||
+			HLE::GetFunctionIndex(op.address) != 0)
+		{
+			std::fill_n(known, 32, false);
+			continue;
+		}
+
+		int dest = -1;
+		bool constant = false;
+		u32 value = 0;
+		switch (inst.OPCD)
+		{
+		case 14: // addi
+		case 15: // addis
+		{
+			u32 imm = inst.OPCD == 14 ? (u32)(s32)inst.SIMM_16 : (u32)inst.SIMM_16 << 16;
+			dest = inst.RD;
+			constant = !inst.RA || known[inst.RA];
+			value = (inst.RA ? values[inst.RA] : 0) + imm;
+			break;
+		}
+		case 24: // ori
+		case 25: // oris
+			dest = inst.RA;
+			constant = known[inst.RS];
+			value = values[inst.RS] | (inst.OPCD == 24 ? inst.UIMM : inst.UIMM << 16);
+			break;
+		case 31:
+			if (inst.SUBOP10 == 444 && inst.RS == inst.RB && !inst.Rc) // mr
+			{
+				dest = inst.RA;
+				constant = known[inst.RS];
+				value = values[inst.RS];
+			}
+			break;
+		}
+
+		if (constant && known[dest] && values[dest] == value && allowSkip)
+			op.skip = true;
+
+		for (s8 reg : op.regsOut)
+		{
+			if (reg >= 0)
+				known[reg] = false;
+		}
+		if (constant)
+		{
+			known[dest] = true;
+			values[dest] = value;
+		}
+	}
+}
+
 // Does not yet perform inlining - although there are plans for that.
 // Returns the exit address of the next PC
 u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
@@ -311,6 +462,9 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 	bool foundExit = false;
 
 	u32 returnAddress = 0;
+	// Set while the code of an inlined leaf function is being followed
+	bool inlinedCall = false;
+	const bool inlineLeafs = SConfig::GetInstance().m_LocalCoreStartupParameter.bJITInlineLeafFunctions;
 
 	// Do analysis of the code, look for dependencies etc
 	int numSystemInstructions = 0;
@@ -432,6 +586,9 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 			}
 
 			bool follow = false;
+			// The call and the return of an inlined function are followed
+			// even when block merging is off
+			bool inlineFollow = false;
 			u32 destination = 0;
 			if (inst.OPCD == 18 && blockSize > 1)
 			{
@@ -442,6 +599,13 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 					destination = address + SignExt26(inst.LI << 2);
 				if (destination != blockstart)
 					follow = true;
+
+				if (inst.LK && inlineLeafs && destination != blockstart && IsInlinableLeaf(destination))
+				{
+					returnAddress = address + 4;
+					inlinedCall = true;
+					inlineFollow = true;
+				}
 			}
 			else if (inst.OPCD == 19 && inst.SUBOP10 == 16 &&
 				(inst.BO & (1 << 4)) && (inst.BO & (1 << 2)) &&
@@ -451,6 +615,8 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 				follow = true;
 				destination = returnAddress;
 				returnAddress = 0;
+				inlineFollow = inlinedCall;
+				inlinedCall = false;
 
 				if (inst.LK)
 					returnAddress = address + 4;
@@ -463,6 +629,7 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 					// We give up to follow the return address
 					// because we have to check the register usage.
 					returnAddress = 0;
+					inlinedCall = false;
 				}
 			}
 
@@ -477,7 +644,7 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 			if (numFollows > FUNCTION_FOLLOWING_THRESHOLD)
 				follow = false;
 
-			if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bMergeBlocks) {
+			if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bMergeBlocks && !inlineFollow) {
 				follow = false;
 			}
 
@@ -531,6 +698,8 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 		}
 	}
 
+	PropagateConstants(code, num_inst);
+
 	if (!foundExit && num_inst > 0)
 	{
 		// A broken block is a block that does not end in a branch
@@ -558,44 +727,79 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 		code[i].wantsPS1 = wantsPS1;
 	}
 
+	st->isIdleLoop = SConfig::GetInstance().m_LocalCoreStartupParameter.bSkipIdle &&
+		IsBusyWaitLoop(code, num_inst, blockstart);
+
 	*realsize = num_inst;
 	// ...
 	return address;
 }
 
 
+// Instructions per piece of the range scanned on one worker
+static const u32 SCAN_CHUNK_SIZE = 0x4000;
+
 // Most functions that are relevant to analyze should be
 // called by another function. Therefore, let's scan the
 // entire space for bl operations and find what functions
 // get called.
-void FindFunctionsFromBranches(u32 startAddr, u32 endAddr, SymbolDB *func_db)
+void FindFunctionsFromBranches(u32 startAddr, u32 endAddr, PPCSymbolDB *func_db)
 {
-	for (u32 addr = startAddr; addr < endAddr; addr+=4)
+	// Both the scan for bl targets and the analysis of the new ones run in
+	// parallel. The functions are then added in the order the scan found
+	// them, so that of two with the same hash the same one ends up indexed.
+	const u32 num_chunks = (endAddr - startAddr + SCAN_CHUNK_SIZE * 4 - 1) / (SCAN_CHUNK_SIZE * 4);
+	std::vector<std::vector<u32>> chunk_targets(num_chunks);
+	Common::ThreadPool::ParallelFor((int)num_chunks, [&](int begin, int end)
 	{
-		UGeckoInstruction instr = (UGeckoInstruction)Memory::ReadUnchecked_U32(addr);
-
-		if (PPCTables::IsValidInstruction(instr))
+		for (int chunk = begin; chunk < end; ++chunk)
 		{
-			switch (instr.OPCD)
+			const u32 chunk_start = startAddr + chunk * SCAN_CHUNK_SIZE * 4;
+			const u32 chunk_end = std::min(endAddr, chunk_start + SCAN_CHUNK_SIZE * 4);
+			for (u32 addr = chunk_start; addr < chunk_end; addr+=4)
 			{
-			case 18://branch instruction
+				UGeckoInstruction instr = (UGeckoInstruction)Memory::ReadUnchecked_U32(addr);
+
+				// bl
+				if (instr.OPCD == 18 && instr.LK && PPCTables::IsValidInstruction(instr))
 				{
-					if (instr.LK) //bl
-					{
-						u32 target = SignExt26(instr.LI << 2);
-						if (!instr.AA)
-							target += addr;
-						if (Memory::IsRAMAddress(target))
-						{
-							func_db->AddFunction(target);
-						}
-					}
+					u32 target = SignExt26(instr.LI << 2);
+					if (!instr.AA)
+						target += addr;
+					if (Memory::IsRAMAddress(target))
+						chunk_targets[chunk].push_back(target);
 				}
-				break;
-			default:
-				break;
 			}
 		}
+	});
+
+	// The calls AddFunction would have analyzed
+	std::vector<u32> targets;
+	FlatHashMap<u32, bool> seen;
+	for (const std::vector<u32>& found : chunk_targets)
+	{
+		for (u32 target : found)
+		{
+			bool& was_seen = seen[target];
+			if (was_seen || target < 0x80000010 || func_db->Symbols().count(target))
+				continue;
+			was_seen = true;
+			targets.push_back(target);
+		}
+	}
+
+	std::vector<Symbol> analyzed(targets.size());
+	std::vector<u8> valid(targets.size());
+	Common::ThreadPool::ParallelFor((int)targets.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			valid[i] = AnalyzeFunction(targets[i], analyzed[i]);
+	});
+
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		if (valid[i])
+			func_db->AddAnalyzedFunction(targets[i], analyzed[i]);
 	}
 }
 
@@ -698,4 +902,57 @@ void FindFunctions(u32 startAddr, u32 endAddr, PPCSymbolDB *func_db)
 		leafSize, niceSize, unniceSize);
 }
 
+// Bump when FindFunctions would find something else in the same RAM
+static const u32 SYMBOL_CACHE_REVISION = 1;
+
+struct SymbolCache
+{
+	u64 key;
+	PPCSymbolDB *db;
+
+	void DoState(PointerWrap &p)
+	{
+		p.Do(key);
+		db->DoState(p);
+	}
+};
+
+// The analysis follows branches anywhere in RAM, so all of it goes into the
+// key, except for the time base the boot writes at 0x800030D8
+static u64 HashRAMForSymbols(u32 startAddr, u32 endAddr)
+{
+	StripeHash64 hash(((u64)startAddr << 32) | endAddr);
+	const u8 *ram = Memory::GetPointer(0x80000000);
+	hash.Update(ram, 0x30D8);
+	hash.Update(ram + 0x30E0, Memory::REALRAM_SIZE - 0x30E0);
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
+		hash.Update(Memory::GetPointer(0x90000000), Memory::EXRAM_SIZE);
+	return hash.Finish();
+}
+
+void FindFunctionsCached(u32 startAddr, u32 endAddr, PPCSymbolDB *func_db)
+{
+	const std::string &game_id = SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID;
+	if (game_id.empty() || !func_db->Symbols().empty())
+		return FindFunctions(startAddr, endAddr, func_db);
+
+	const std::string filename = File::GetUserPath(D_CACHE_IDX) + game_id + ".symbols";
+	const u64 key = HashRAMForSymbols(startAddr, endAddr);
+	SymbolCache cache = {0, func_db};
+	if (CChunkFileReader::Load(filename, SYMBOL_CACHE_REVISION, cache) && cache.key == key)
+	{
+		INFO_LOG(OSHLE, "Loaded %lu functions from %s",
+			(unsigned long)func_db->Symbols().size(), filename.c_str());
+		return;
+	}
+
+	func_db->Clear();
+	FindFunctions(startAddr, endAddr, func_db);
+
+	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
+		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
+	cache.key = key;
+	CChunkFileReader::Save(filename, SYMBOL_CACHE_REVISION, cache);
+}
+
 }  // namespace
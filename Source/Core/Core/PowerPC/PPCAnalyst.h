@@ -39,12 +39,16 @@ struct CodeOp //16B
 	bool outputCR1;
 	bool outputPS1;
 	bool skip;  // followed BL-s for example
+	// RA holds a value known from earlier in the block (see PropagateConstants)
+	bool hasConstA;
+	u32 constA;
 };
 
 struct BlockStats
 {
 	bool isFirstBlockOfFunction;
 	bool isLastBlockOfFunction;
+	bool isIdleLoop;  // branches back to its start without side effects
 	int numCycles;
 };
 
@@ -101,6 +105,9 @@ u32 Flatten(u32 address, int *realsize, BlockStats *st, BlockRegStats *gpa,
 			int capacity_of_merged_addresses, int& size_of_merged_addresses);
 void LogFunctionCall(u32 addr);
 void FindFunctions(u32 startAddr, u32 endAddr, PPCSymbolDB *func_db);
+// FindFunctions into an empty database, with what it found kept in the cache
+// directory for the next boot of the game with the same RAM contents
+void FindFunctionsCached(u32 startAddr, u32 endAddr, PPCSymbolDB *func_db);
 bool AnalyzeFunction(u32 startAddr, Symbol &func, int max_size = 0);
 
 }  // namespace
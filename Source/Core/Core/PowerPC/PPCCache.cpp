@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "Common.h"
 #include "PPCCache.h"
 #include "../HW/Memmap.h"
 #include "PowerPC.h"
@@ -9,6 +10,10 @@
 #include "JitCommon/JitCache.h"
 #include "JitInterface.h"
 
+#if !defined(FAST_ICACHE) && _M_SSE >= 0x200
+#include <emmintrin.h>
+#endif
+
 namespace PowerPC
 {
 
@@ -59,6 +64,7 @@ namespace PowerPC
 	{
 		memset(valid, 0, sizeof(valid));
 		memset(plru, 0, sizeof(plru));
+		last_line = ~0u;
 #ifdef FAST_ICACHE
 		memset(lookup_table, 0xff, sizeof(lookup_table));
 		memset(lookup_table_ex, 0xff, sizeof(lookup_table_ex));
@@ -96,6 +102,7 @@ namespace PowerPC
 			}
 #endif
 		valid[set] = 0;
+		last_line = ~0u;
 		JitInterface::InvalidateICache(addr & ~0x1f, 32);
 	}
 
@@ -104,6 +111,9 @@ namespace PowerPC
 		if (!HID0.ICE) // instruction cache is disabled
 			return Memory::ReadUnchecked_U32(addr);
 		u32 set = (addr >> 5) & 0x7f;
+		const u32 line = addr >> 5;
+		if (line == last_line)
+			return Common::swap32(data[set][last_way][(addr>>2)&7]);
 		u32 tag = addr >> 12;
 #ifdef FAST_ICACHE
 		u32 t;
@@ -119,6 +129,20 @@ namespace PowerPC
 		{
 			t = lookup_table[(addr>>5) & 0xfffff];
 		}
+#elif _M_SSE >= 0x200
+		// Compare all eight ways at once
+		const __m128i needle = _mm_set1_epi32(tag);
+		const __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&tags[set][0]), needle);
+		const __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&tags[set][4]), needle);
+		const u32 hits = ((u32)_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4 |
+		                  (u32)_mm_movemask_ps(_mm_castsi128_ps(lo))) & valid[set];
+		u32 t = 0xff;
+		for (u32 i = 0; i < 8; i++)
+			if (hits & (1<<i))
+			{
+				t = i;
+				break;
+			}
 #else
 		u32 t = 0xff;
 		for (u32 i = 0; i < 8; i++)
@@ -161,8 +185,10 @@ namespace PowerPC
 			tags[set][t] = tag;
 			valid[set] |= 1<<t;
 		}
-		// update plru
+		// update plru, fetches from the last line leave it as it is anyway
 		plru[set] = (plru[set] & ~plru_mask[t]) | plru_value[t];
+		last_line = line;
+		last_way = t;
 		u32 res = Common::swap32(data[set][t][(addr>>2)&7]);
 		return res;
 	}
@@ -29,6 +29,11 @@ namespace PowerPC
 		u32 way_from_valid[255];
 		u32 way_from_plru[128];
 
+		// The line and way of the last fetch, straight-line code hits the same
+		// 32 byte line eight times in a row
+		u32 last_line;
+		u32 last_way;
+
 #ifdef FAST_ICACHE
 		u8 lookup_table[1<<20];
 		u8 lookup_table_ex[1<<21];
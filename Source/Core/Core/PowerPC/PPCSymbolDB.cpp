@@ -46,14 +46,19 @@ Symbol *PPCSymbolDB::AddFunction(u32 startAddr)
 		u32 targetEnd = PPCAnalyst::AnalyzeFunction(startAddr, tempFunc);
 		if (targetEnd == 0)
 			return 0;  //found a dud :(
-		//LOG(OSHLE, "Symbol found at %08x", startAddr);
-		functions[startAddr] = tempFunc;
-		tempFunc.type = Symbol::SYMBOL_FUNCTION;
-		checksumToFunction[tempFunc.hash] = &(functions[startAddr]);
-		return &functions[startAddr];
+		return AddAnalyzedFunction(startAddr, tempFunc);
 	}
 }
 
+Symbol *PPCSymbolDB::AddAnalyzedFunction(u32 startAddr, const Symbol &func)
+{
+	//LOG(OSHLE, "Symbol found at %08x", startAddr);
+	Symbol &added = functions[startAddr];
+	added = func;
+	checksumToFunction[func.hash] = &added;
+	return &added;
+}
+
 void PPCSymbolDB::AddKnownSymbol(u32 startAddr, u32 size, const char *name, int type)
 {
 	XFuncMap::iterator iter = functions.find(startAddr);
@@ -193,6 +198,75 @@ void PPCSymbolDB::LogFunctionCall(u32 addr)
 	}
 }
 
+static void DoCalls(PointerWrap &p, std::vector<SCall> &calls)
+{
+	u32 count = (u32)calls.size();
+	p.Do(count);
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		calls.assign(count, SCall(0, 0));
+	for (SCall &call : calls)
+	{
+		p.Do(call.function);
+		p.Do(call.callAddress);
+	}
+}
+
+static void DoSymbol(PointerWrap &p, Symbol &symbol)
+{
+	p.Do(symbol.name);
+	DoCalls(p, symbol.callers);
+	DoCalls(p, symbol.calls);
+	p.Do(symbol.hash);
+	p.Do(symbol.address);
+	p.Do(symbol.flags);
+	p.Do(symbol.size);
+	p.Do(symbol.numCalls);
+	p.Do(symbol.type);
+	p.Do(symbol.index);
+	p.Do(symbol.analyzed);
+}
+
+void PPCSymbolDB::DoState(PointerWrap &p)
+{
+	u32 count = (u32)functions.size();
+	p.Do(count);
+	// The hash index as address of the function, it's the last symbol added
+	// for the hash and can't be rebuilt from the symbols
+	std::vector<std::pair<u32, u32>> hashes;
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		Clear();
+		for (u32 i = 0; i < count; ++i)
+		{
+			u32 address = 0;
+			p.Do(address);
+			DoSymbol(p, functions[address]);
+		}
+		p.Do(hashes);
+		for (const auto &hash : hashes)
+			checksumToFunction[hash.first] = &functions[hash.second];
+	}
+	else
+	{
+		std::map<const Symbol*, u32> addresses;
+		for (auto &entry : functions)
+		{
+			u32 address = entry.first;
+			p.Do(address);
+			DoSymbol(p, entry.second);
+			addresses[&entry.second] = entry.first;
+		}
+		for (const auto &hash : checksumToFunction)
+		{
+			auto it = addresses.find(hash.second);
+			if (it != addresses.end())
+				hashes.push_back(std::make_pair(hash.first, it->second));
+		}
+		p.Do(hashes);
+	}
+	p.DoMarker("PPCSymbolDB");
+}
+
 // This one can load both leftover map files on game discs (like Zelda), and mapfiles
 // produced by SaveSymbolMap below.
 bool PPCSymbolDB::LoadMap(const char *filename)
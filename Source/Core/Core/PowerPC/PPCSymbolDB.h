@@ -11,6 +11,7 @@
 #include <vector>
 #include "../Debugger/PPCDebugInterface.h"
 
+#include "ChunkFile.h"
 #include "SymbolDB.h"
 
 // This has functionality overlapping Debugger_Symbolmap. Should merge that stuff in here later.
@@ -26,6 +27,8 @@ public:
 	~PPCSymbolDB();
 
 	Symbol *AddFunction(u32 startAddr) override;
+	// Adds a function PPCAnalyst::AnalyzeFunction was run on, like AddFunction
+	Symbol *AddAnalyzedFunction(u32 startAddr, const Symbol &func);
 	void AddKnownSymbol(u32 startAddr, u32 size, const char *name, int type = Symbol::SYMBOL_FUNCTION);
 
 	Symbol *GetSymbolFromAddr(u32 addr) override;
@@ -40,6 +43,9 @@ public:
 	void PrintCalls(u32 funcAddr) const;
 	void PrintCallers(u32 funcAddr) const;
 	void LogFunctionCall(u32 addr);
+
+	// Saves and restores the functions, for PPCAnalyst::FindFunctionsCached
+	void DoState(PointerWrap &p);
 };
 
 extern PPCSymbolDB g_symbolDB;
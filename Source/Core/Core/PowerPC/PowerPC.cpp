@@ -66,6 +66,8 @@ void DoState(PointerWrap &p)
 //	*((u64 *)&TL) = SystemTimers::GetFakeTimeBase(); //works since we are little endian and TL comes first :)
 
 	p.DoPOD(ppcState);
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		Memory::InvalidateTranslationCache();
 
 //	SystemTimers::DecrementerSet();
 //	SystemTimers::TimeBaseSet();
@@ -109,6 +111,8 @@ void ResetRegisters()
 	ppcState.msr = 0;
 	rDEC = 0xFFFFFFFF;
 	SystemTimers::DecrementerSet();
+
+	Memory::InvalidateTranslationCache();
 }
 
 void Init(int cpu_core)
@@ -2,7 +2,41 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
+#include <functional>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "Atomic.h"
+#include "FileUtil.h"
+#include "StringUtil.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "ConfigManager.h"
 #include "JitInterface.h"
+#include "PPCSymbolDB.h"
+#include "Profiler.h"
+#include "JitCommon/JitBase.h"
+
+// Windows and OS X can read the context of a suspended thread, elsewhere the
+// thread reports its own context from a signal handler.
+#if defined(_WIN32) || (defined(__APPLE__) && defined(_M_X64))
+#define SAMPLE_SUSPENDED_THREAD
+#elif !defined(__APPLE__) && !defined(ANDROID) && defined(CTX_PC)
+#define SAMPLE_FROM_SIGNAL
+#endif
 
 namespace Profiler
 {
@@ -10,9 +44,390 @@ namespace Profiler
 bool g_ProfileBlocks;
 bool g_ProfileInstructions;
 
+#if defined(_M_X64)
+
+static u64 ReadTSC()
+{
+#ifdef _WIN32
+	return __rdtsc();
+#else
+	u32 lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((u64)hi << 32) | lo;
+#endif
+}
+
+u64 GetTicksPerSecond()
+{
+	// Measured once against the wall clock.
+	static u64 s_ticks_per_second = 0;
+	if (!s_ticks_per_second)
+	{
+		const u64 start_us = Common::Timer::GetTimeUs();
+		const u64 start_ticks = ReadTSC();
+		Common::SleepCurrentThread(50);
+		const u64 elapsed_us = Common::Timer::GetTimeUs() - start_us;
+		s_ticks_per_second = (ReadTSC() - start_ticks) * 1000000 / elapsed_us;
+	}
+	return s_ticks_per_second;
+}
+
+#elif defined(_WIN32) && defined(_M_IX86)
+
+u64 GetTicksPerSecond()
+{
+	u64 counts_per_second;
+	QueryPerformanceFrequency((LARGE_INTEGER *)&counts_per_second);
+	return counts_per_second;
+}
+
+#else
+
+u64 GetTicksPerSecond()
+{
+	return 0;
+}
+
+#endif
+
 void WriteProfileResults(const char *filename)
 {
 	JitInterface::WriteProfileResults(filename);
 }
 
+static std::string JSONString(const std::string& str)
+{
+	std::string out = "\"";
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			out += '\\';
+		if ((u8)c < 0x20)
+			out += StringFromFormat("\\u%04x", c);
+		else
+			out += c;
+	}
+	return out + "\"";
+}
+
+bool ExportBlockStats(const std::string& filename)
+{
+	if (!jit)
+		return false;
+
+	struct Stats
+	{
+		u32 address;
+		const Symbol* symbol;
+		u32 blocks;
+		u32 guest_size;
+		u32 host_size;
+		u64 runs;
+		u64 cycles;
+		u64 ticks;
+		u64 compile_us;
+
+		// Time if the blocks are timed, the usual guess otherwise
+		u64 Cost() const { return ticks ? ticks : guest_size * runs; }
+		bool operator<(const Stats& other) const { return Cost() > other.Cost(); }
+	};
+
+	JitBaseBlockCache* cache = jit->GetBlockCache();
+	std::vector<Stats> blocks;
+	std::map<u32, Stats> functions;
+	u64 host_size = 0;
+	for (int i = 0; i < cache->GetNumBlocks(); i++)
+	{
+		const JitBlock* block = cache->GetBlock(i);
+		if (block->invalid)
+			continue;
+
+		Stats stats;
+		stats.address = block->originalAddress;
+		stats.symbol = g_symbolDB.GetSymbolFromAddr(block->originalAddress);
+		stats.blocks = 1;
+		stats.guest_size = block->originalSize;
+		stats.host_size = block->codeSize;
+		stats.runs = g_ProfileBlocks ? block->runCount : 0;
+		stats.cycles = stats.runs * block->downcountAmount;
+		stats.ticks = g_ProfileBlocks ? block->ticCounter : 0;
+		stats.compile_us = block->compileTimeUs;
+		blocks.push_back(stats);
+		host_size += block->codeSize;
+
+		// Blocks outside of any known function are listed on their own
+		const u32 function_address = stats.symbol ? stats.symbol->address : stats.address;
+		auto it = functions.find(function_address);
+		if (it == functions.end())
+		{
+			stats.address = function_address;
+			functions[function_address] = stats;
+			continue;
+		}
+		Stats& function = it->second;
+		function.blocks++;
+		function.guest_size += stats.guest_size;
+		function.host_size += stats.host_size;
+		function.runs += stats.runs;
+		function.cycles += stats.cycles;
+		function.ticks += stats.ticks;
+		function.compile_us += stats.compile_us;
+	}
+
+	std::vector<Stats> sorted_functions;
+	for (const auto& function : functions)
+		sorted_functions.push_back(function.second);
+	std::stable_sort(blocks.begin(), blocks.end());
+	std::stable_sort(sorted_functions.begin(), sorted_functions.end());
+
+	std::string json = StringFromFormat("{\"game\":%s,\"profile_blocks\":%s,\"ticks_per_second\":%llu,"
+		"\"compiled_blocks\":%u,\"compile_us\":%llu,\"cached_blocks\":%u,\"host_code_size\":%llu,\n",
+		JSONString(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID).c_str(),
+		g_ProfileBlocks ? "true" : "false", (unsigned long long)GetTicksPerSecond(),
+		cache->GetNumCompiledBlocks(), (unsigned long long)cache->GetTotalCompileTimeUs(),
+		(u32)blocks.size(), (unsigned long long)host_size);
+
+	const struct
+	{
+		const char* name;
+		const std::vector<Stats>& list;
+	} lists[] = { { "functions", sorted_functions }, { "blocks", blocks } };
+	for (u32 l = 0; l < ArraySize(lists); ++l)
+	{
+		const auto& list = lists[l];
+		json += StringFromFormat("\"%s\":[", list.name);
+		for (size_t i = 0; i < list.list.size(); ++i)
+		{
+			const Stats& stats = list.list[i];
+			json += StringFromFormat("%s\n{\"address\":%u,\"function\":%s,\"blocks\":%u,\"guest_size\":%u,"
+				"\"host_size\":%u,\"runs\":%llu,\"cycles\":%llu,\"ticks\":%llu,\"compile_us\":%llu}",
+				i ? "," : "", stats.address, stats.symbol ? JSONString(stats.symbol->name).c_str() : "null",
+				stats.blocks, stats.guest_size, stats.host_size, (unsigned long long)stats.runs,
+				(unsigned long long)stats.cycles, (unsigned long long)stats.ticks,
+				(unsigned long long)stats.compile_us);
+		}
+		json += l + 1 < ArraySize(lists) ? "],\n" : "]}\n";
+	}
+
+	const std::string temp_filename = filename + ".tmp";
+	{
+		File::IOFile f(temp_filename, "wb");
+		if (!f || !f.WriteBytes(json.data(), json.size()))
+			return false;
+	}
+	return File::Rename(temp_filename, filename);
+}
+
+static std::mutex s_sampler_lock;
+static std::thread s_sampler;
+static volatile bool s_sampling;
+static int s_interval_ms;
+static bool s_have_cpu_thread;
+
+#if defined(_WIN32)
+static HANDLE s_cpu_thread;
+#elif defined(__APPLE__)
+static mach_port_t s_cpu_thread;
+#else
+static pthread_t s_cpu_thread;
+#endif
+
+static std::mutex s_samples_lock;
+static std::map<u32, u32> s_block_samples; // block start address -> samples
+static u64 s_total_samples;
+static u64 s_jit_samples; // in JIT code outside of blocks
+
+#ifdef SAMPLE_FROM_SIGNAL
+
+static volatile uintptr_t s_signal_pc;
+static volatile u32 s_signal_done;
+
+static void SampleSignalHandler(int, siginfo_t*, void* raw_context)
+{
+	SContext* ctx = (SContext*)&((ucontext_t*)raw_context)->uc_mcontext;
+	s_signal_pc = (uintptr_t)ctx->CTX_PC;
+	Common::AtomicStoreRelease(s_signal_done, 1);
+}
+
+#endif
+
+static bool SampleCPUThread(const u8** pc)
+{
+#if defined(_WIN32)
+	if (SuspendThread(s_cpu_thread) == (DWORD)-1)
+		return false;
+	CONTEXT ctx;
+	ctx.ContextFlags = CONTEXT_CONTROL;
+	const bool got_context = GetThreadContext(s_cpu_thread, &ctx) != 0;
+	ResumeThread(s_cpu_thread);
+	*pc = (const u8*)ctx.CTX_PC;
+	return got_context;
+#elif defined(SAMPLE_SUSPENDED_THREAD)
+	if (thread_suspend(s_cpu_thread) != KERN_SUCCESS)
+		return false;
+	SContext state;
+	mach_msg_type_number_t count = x86_THREAD_STATE64_COUNT;
+	const kern_return_t ret = thread_get_state(s_cpu_thread, x86_THREAD_STATE64, (thread_state_t)&state, &count);
+	thread_resume(s_cpu_thread);
+	*pc = (const u8*)state.CTX_PC;
+	return ret == KERN_SUCCESS;
+#elif defined(SAMPLE_FROM_SIGNAL)
+	Common::AtomicStore(s_signal_done, 0);
+	if (pthread_kill(s_cpu_thread, SIGPROF) != 0)
+		return false;
+	// The handler runs as soon as the thread gets scheduled
+	for (int i = 0; !Common::AtomicLoadAcquire(s_signal_done); ++i)
+	{
+		if (i == 1000)
+			return false;
+		Common::YieldCPU();
+	}
+	*pc = (const u8*)s_signal_pc;
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void SamplerThread()
+{
+	Common::SetCurrentThreadName("Sampling profiler");
+
+	while (s_sampling)
+	{
+		Common::SleepCurrentThread(s_interval_ms);
+
+		const u8* pc;
+		if (!SampleCPUThread(&pc))
+			continue;
+
+		// Looked up right away, before the block can be evicted
+		u32 address = 0;
+		const bool in_block = jit && jit->GetBlockCache()->GetBlockAddressFromCodePointer(pc, &address);
+		const bool in_jit = !in_block && jit && jit->IsInCodeSpace((u8*)pc);
+
+		std::lock_guard<std::mutex> lk(s_samples_lock);
+		s_total_samples++;
+		if (in_block)
+			s_block_samples[address]++;
+		else if (in_jit)
+			s_jit_samples++;
+	}
+}
+
+void InitCPUThread()
+{
+	std::lock_guard<std::mutex> lk(s_sampler_lock);
+#if defined(_WIN32)
+	s_cpu_thread = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT, FALSE, GetCurrentThreadId());
+	s_have_cpu_thread = s_cpu_thread != NULL;
+#elif defined(SAMPLE_SUSPENDED_THREAD)
+	s_cpu_thread = pthread_mach_thread_np(pthread_self());
+	s_have_cpu_thread = true;
+#elif defined(SAMPLE_FROM_SIGNAL)
+	struct sigaction sa;
+	sa.sa_handler = 0;
+	sa.sa_sigaction = &SampleSignalHandler;
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGPROF, &sa, NULL);
+	s_cpu_thread = pthread_self();
+	s_have_cpu_thread = true;
+#endif
+}
+
+static void StopSamplerThread()
+{
+	s_sampling = false;
+	if (s_sampler.joinable())
+		s_sampler.join();
+}
+
+void ShutdownCPUThread()
+{
+	std::lock_guard<std::mutex> lk(s_sampler_lock);
+	StopSamplerThread();
+#ifdef _WIN32
+	if (s_have_cpu_thread)
+		CloseHandle(s_cpu_thread);
+#endif
+	s_have_cpu_thread = false;
+}
+
+bool StartSampling(int interval_ms)
+{
+	std::lock_guard<std::mutex> lk(s_sampler_lock);
+	if (!s_have_cpu_thread)
+		return false;
+	if (s_sampling)
+		return true;
+
+	{
+		std::lock_guard<std::mutex> samples_lk(s_samples_lock);
+		s_block_samples.clear();
+		s_total_samples = 0;
+		s_jit_samples = 0;
+	}
+
+	s_interval_ms = std::max(interval_ms, 1);
+	s_sampling = true;
+	s_sampler = std::thread(SamplerThread);
+	return true;
+}
+
+void StopSampling()
+{
+	std::lock_guard<std::mutex> lk(s_sampler_lock);
+	StopSamplerThread();
+}
+
+bool IsSampling()
+{
+	return s_sampling;
+}
+
+void WriteSampleResults(const char *filename)
+{
+	std::map<u32, u32> block_samples;
+	u64 total_samples, jit_samples;
+	{
+		std::lock_guard<std::mutex> lk(s_samples_lock);
+		block_samples = s_block_samples;
+		total_samples = s_total_samples;
+		jit_samples = s_jit_samples;
+	}
+
+	// Blocks outside of any known function are listed on their own
+	u64 in_blocks = 0;
+	std::map<u32, u64> function_samples;
+	for (const auto& sample : block_samples)
+	{
+		const Symbol* symbol = g_symbolDB.GetSymbolFromAddr(sample.first);
+		function_samples[symbol ? symbol->address : sample.first] += sample.second;
+		in_blocks += sample.second;
+	}
+
+	std::vector<std::pair<u64, u32>> sorted;
+	for (const auto& function : function_samples)
+		sorted.push_back(std::make_pair(function.second, function.first));
+	std::sort(sorted.begin(), sorted.end(), std::greater<std::pair<u64, u32>>());
+
+	File::IOFile f(filename, "w");
+	if (!f)
+	{
+		PanicAlert("Failed to open %s", filename);
+		return;
+	}
+
+	fprintf(f.GetHandle(), "# samples: %" PRIu64 ", %" PRIu64 " in blocks, %" PRIu64 " in other JIT code, %" PRIu64 " in native code\n",
+		total_samples, in_blocks, jit_samples, total_samples - in_blocks - jit_samples);
+	fprintf(f.GetHandle(), "funcAddr\tfuncName\tsamples\tpercent\n");
+	for (const auto& function : sorted)
+	{
+		fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t%.2lf\n", function.second,
+			g_symbolDB.GetDescription(function.second), function.first,
+			100.0 * function.first / total_samples);
+	}
+}
+
 }  // namespace
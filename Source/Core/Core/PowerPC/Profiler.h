@@ -5,13 +5,13 @@
 
 #pragma once
 
-#ifdef _WIN32
+#include <string>
+
+#if defined(_WIN32) && defined(_M_IX86)
 
-#ifdef _M_IX86
 #define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)		\
 					LEA(32, EAX, M(pt)); PUSH(EAX);	\
 					CALL(QueryPerformanceCounter)
-// TODO: r64 way
 // asm write : (u64) dt += t1-t0
 #define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)	\
 					MOV(32, R(EAX), M(pt1));	\
@@ -23,22 +23,42 @@
 					ADC(32, R(EDX), R(ECX));			\
 					MOV(32, M(pdt), R(EAX));	\
 					MOV(32, M(((u8*)pdt) + 4), R(EDX))
+#define PROFILER_INCREMENT(pcount)	ADD(32, M(pcount), Imm8(1))
 
 #define PROFILER_VPUSH	PUSH(EAX);PUSH(ECX);PUSH(EDX)
 #define PROFILER_VPOP	POP(EDX);POP(ECX);POP(EAX)
 
-#else
+#elif defined(_M_X64)
 
-#define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)
-#define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)
-#define PROFILER_VPUSH
-#define PROFILER_VPOP
-#endif
+// The blocks are allocated on the heap, which can be too far away for RIP
+// relative addressing, so go through RCX. The counter is the TSC.
+#define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)		\
+					RDTSC();	\
+					SHL(64, R(RDX), Imm8(32));	\
+					OR(64, R(RAX), R(RDX));	\
+					MOV(64, R(RCX), ImmPtr(pt));	\
+					MOV(64, MatR(RCX), R(RAX))
+// asm write : (u64) dt += t1-t0
+#define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)	\
+					MOV(64, R(RCX), ImmPtr(pt1));	\
+					MOV(64, R(RAX), MatR(RCX));	\
+					MOV(64, R(RCX), ImmPtr(pt0));	\
+					SUB(64, R(RAX), MatR(RCX));	\
+					MOV(64, R(RCX), ImmPtr(pdt));	\
+					ADD(64, MatR(RCX), R(RAX))
+#define PROFILER_INCREMENT(pcount)	\
+					MOV(64, R(RCX), ImmPtr(pcount));	\
+					ADD(32, MatR(RCX), Imm8(1))
+
+// The end of a block can be between a compare and the branch using its result
+#define PROFILER_VPUSH	PUSHF();PUSH(RAX);PUSH(RCX);PUSH(RDX)
+#define PROFILER_VPOP	POP(RDX);POP(RCX);POP(RAX);POPF()
 
 #else
 // TODO
 #define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)
 #define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)
+#define PROFILER_INCREMENT(pcount)	ADD(32, M(pcount), Imm8(1))
 #define PROFILER_VPUSH
 #define PROFILER_VPOP
 #endif
@@ -58,5 +78,37 @@ namespace Profiler
 extern bool g_ProfileBlocks;
 extern bool g_ProfileInstructions;
 
+// Rate of the counter the blocks are timed with, 0 if blocks aren't timed on
+// this platform.
+u64 GetTicksPerSecond();
+
 void WriteProfileResults(const char *filename);
+
+// Writes the blocks in the JIT cache as JSON, hottest first, with their guest
+// function, host code size, run counts and compile time, and the same summed
+// per function. The file is replaced atomically, so it can be rewritten while
+// something else polls it. Without g_ProfileBlocks only the compile side is
+// filled in. Call from the CPU thread or while it is paused.
+bool ExportBlockStats(const std::string& filename);
+
+// Sampling profiler. Instead of instrumenting every block, a thread
+// interrupts the CPU thread every interval_ms milliseconds and looks up the
+// block it is running, which leaves the generated code alone and costs far
+// less than g_ProfileBlocks.
+
+// Called on the CPU thread when it starts and stops running guest code.
+void InitCPUThread();
+void ShutdownCPUThread();
+
+// Returns false if the CPU thread isn't running, or can't be sampled on this
+// platform.
+bool StartSampling(int interval_ms = 1);
+void StopSampling();
+bool IsSampling();
+
+// Writes the samples taken since sampling was started, per guest function.
+// Samples in JIT code outside of blocks, like the dispatcher, and in native
+// code are only counted, so the time spent in functions called by a block
+// isn't attributed to it.
+void WriteSampleResults(const char *filename);
 }
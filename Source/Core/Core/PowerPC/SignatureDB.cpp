@@ -2,6 +2,9 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
+
 #include "Common.h"
 #include "PPCAnalyst.h"
 #include "../HW/Memmap.h"
@@ -56,13 +59,20 @@ bool SignatureDB::Save(const char *filename)
 	}
 	u32 fcount = (u32)database.size();
 	f.WriteArray(&fcount, 1);
+	// Sorted, so saving the same database gives the same file
+	std::vector<u32> hashes;
+	hashes.reserve(database.size());
 	for (const auto& entry : database)
+		hashes.push_back(entry.first);
+	std::sort(hashes.begin(), hashes.end());
+	for (u32 hash : hashes)
 	{
+		const DBFunc& func = database[hash];
 		FuncDesc temp;
 		memset(&temp, 0, sizeof(temp));
-		temp.checkSum = entry.first;
-		temp.size = entry.second.size;
-		strncpy(temp.name, entry.second.name.c_str(), 127);
+		temp.checkSum = hash;
+		temp.size = func.size;
+		strncpy(temp.name, func.name.c_str(), 127);
 		f.WriteArray(&temp, 1);
 	}
 
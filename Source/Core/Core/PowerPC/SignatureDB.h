@@ -6,8 +6,8 @@
 
 #include "CommonTypes.h"
 
-#include <map>
 #include <string>
+#include <unordered_map>
 
 // You're not meant to keep around SignatureDB objects persistently. Use 'em, throw them away.
 
@@ -26,7 +26,7 @@ class SignatureDB
 
 	// Map from signature to function. We store the DB in this map because it optimizes the
 	// most common operation - lookup. We don't care about ordering anyway.
-	typedef std::map<u32, DBFunc> FuncDB;
+	typedef std::unordered_map<u32, DBFunc> FuncDB;
 	FuncDB database;
 
 public:
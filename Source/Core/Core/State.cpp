@@ -9,8 +9,10 @@
 #include "ConfigManager.h"
 #include "StringUtil.h"
 #include "Thread.h"
+#include "ThreadPool.h"
 #include "CoreTiming.h"
 #include "Movie.h"
+#include "NetPlayProto.h"
 #include "HW/Wiimote.h"
 #include "HW/DSP.h"
 #include "HW/HW.h"
@@ -18,6 +20,8 @@
 #include "PowerPC/JitCommon/JitBase.h"
 #include "VideoBackendBase.h"
 
+#include <algorithm>
+#include <deque>
 #include <lzo/lzo1x.h>
 #include "HW/Memmap.h"
 #include "HW/VideoInterface.h"
@@ -36,12 +40,9 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
-
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// Every IN_LEN block of the state is compressed on its own, so blocks can be
+// (de)compressed in parallel without changing the on-disk format.
+static const u32 MAX_COMPRESSION_THREADS = 8;
 
 static std::string g_last_filename;
 
@@ -49,17 +50,49 @@ static CallbackFunc g_onAfterLoadCb = NULL;
 
 // Temporary undo state buffer
 static std::vector<u8> g_undo_load_buffer;
-static std::vector<u8> g_current_buffer;
+// The state SaveAs hands to the save thread, compressed unless compression
+// is off
+static std::vector<std::vector<u8>> g_current_streams;
 static int g_loadDepth = 0;
 
+// The small fields of the state SaveAs writes, the arrays are regions
+static std::vector<u8> g_save_buffer;
+static std::vector<StateRegion> g_save_regions;
+
+// States are written without measuring them first, the buffer is reserved to
+// the size of the last one instead
+static size_t g_last_state_size = 0;
+
 static std::mutex g_cs_undo_load_buffer;
 static std::mutex g_cs_current_buffer;
 static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+// Rewind buffer. Every snapshot is either a keyframe holding the whole state, or
+// a delta holding the XOR of every page that differs from the preceding keyframe.
+struct RewindSnapshot
+{
+	bool keyframe;
+	u32 size; // uncompressed size of the state
+	std::vector<u32> pages; // for deltas, the indices of the pages in data
+	std::vector<u8> data; // LZO stream of the state or of the XORed pages
+};
+
+static const u32 REWIND_PAGE_SIZE = 4096;
+static const u32 REWIND_KEYFRAME_INTERVAL = 60;
+
+static std::deque<RewindSnapshot> g_rewind_snapshots;
+static std::vector<u8> g_rewind_keyframe; // uncompressed copy of the newest keyframe
+static std::vector<u8> g_rewind_buffer;
+static std::vector<u8> g_rewind_delta;
+static u32 g_rewind_deltas_since_keyframe = 0;
+static s64 g_rewind_cycles = 0;
+static std::mutex g_cs_rewind;
+
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 22;
+static const u32 STATE_VERSION = 26;
+static const u32 COOKIE_BASE = 0xBAADBABE;
 
 enum
 {
@@ -75,11 +108,31 @@ void EnableCompression(bool compression)
 	g_use_compression = compression;
 }
 
+static void RunDeferredCopies(const std::vector<StateCopy>& copies)
+{
+	static const size_t CHUNK_SIZE = 1 << 20;
+
+	std::vector<StateCopy> chunks;
+	for (const StateCopy& copy : copies)
+	{
+		for (size_t offset = 0; offset < copy.size; offset += CHUNK_SIZE)
+		{
+			StateCopy chunk = { copy.dest + offset, copy.src + offset, std::min(CHUNK_SIZE, copy.size - offset) };
+			chunks.push_back(chunk);
+		}
+	}
+
+	Common::ThreadPool::ParallelFor((int)chunks.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			memcpy(chunks[i].dest, chunks[i].src, chunks[i].size);
+	});
+}
+
 void DoState(PointerWrap &p)
 {
 	u32 version = STATE_VERSION;
 	{
-		static const u32 COOKIE_BASE = 0xBAADBABE;
 		u32 cookie = version + COOKIE_BASE;
 		p.Do(cookie);
 		version = cookie - COOKIE_BASE;
@@ -96,12 +149,17 @@ void DoState(PointerWrap &p)
 
 	p.DoMarker("Version");
 
+	// RAM and the other large arrays are copied once everything else is read
+	std::vector<StateCopy> copies;
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		p.SetDeferredCopies(&copies);
+
 	// Begin with video backend, so that it gets a chance to clear it's caches and writeback modified things to RAM
 	g_video_backend->DoState(p);
 	p.DoMarker("video_backend");
 
 	if (Core::g_CoreStartupParameter.bWii)
-		Wiimote::DoState(p.GetPPtr(), p.GetMode());
+		Wiimote::DoState(p);
 	p.DoMarker("Wiimote");
 
 	PowerPC::DoState(p);
@@ -112,6 +170,11 @@ void DoState(PointerWrap &p)
 	p.DoMarker("CoreTiming");
 	Movie::DoState(p);
 	p.DoMarker("Movie");
+
+	p.SetDeferredCopies(NULL);
+	// A state which failed to load is left as it is, it'll be undone anyway
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		RunDeferredCopies(copies);
 }
 
 void LoadFromBuffer(std::vector<u8>& buffer)
@@ -125,20 +188,57 @@ void LoadFromBuffer(std::vector<u8>& buffer)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
-void SaveToBuffer(std::vector<u8>& buffer)
+bool IsSnapshotUsable(const std::string& filename)
 {
-	bool wasUnpaused = Core::PauseAndLock(true);
+	File::IOFile f(filename, "rb");
+	u32 cookie = 0;
+	return f.ReadArray(&cookie, 1) && cookie == STATE_VERSION + COOKIE_BASE;
+}
+
+bool SaveSnapshot(const std::string& filename)
+{
+	std::vector<u8> buffer;
+	SaveToBuffer(buffer);
 
-	u8* ptr = NULL;
-	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	// Written under another name first, another instance may be loading it
+	const std::string temp_filename = filename + ".tmp";
+	{
+		File::IOFile f(temp_filename, "wb");
+		if (!f.WriteBytes(buffer.data(), buffer.size()))
+			return false;
+	}
+	return File::Rename(temp_filename, filename);
+}
+
+bool LoadSnapshot(const std::string& filename)
+{
+	std::vector<u8> buffer;
+	{
+		File::IOFile f(filename, "rb");
+		buffer.resize((size_t)f.GetSize());
+		if (buffer.empty() || !f.ReadBytes(buffer.data(), buffer.size()))
+			return false;
+	}
+
+	bool wasUnpaused = Core::PauseAndLock(true);
 
+	u8* ptr = &buffer[0];
+	PointerWrap p(&ptr, PointerWrap::MODE_READ);
 	DoState(p);
-	const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-	buffer.resize(buffer_size);
 
-	ptr = &buffer[0];
-	p.SetMode(PointerWrap::MODE_WRITE);
+	Core::PauseAndLock(false, wasUnpaused);
+	return p.GetMode() == PointerWrap::MODE_READ;
+}
+
+void SaveToBuffer(std::vector<u8>& buffer)
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+
+	buffer.clear();
+	buffer.reserve(g_last_state_size);
+	PointerWrap p(&buffer);
 	DoState(p);
+	g_last_state_size = buffer.size();
 
 	Core::PauseAndLock(false, wasUnpaused);
 }
@@ -196,9 +296,216 @@ std::map<double, int> GetSavedStates()
 	return m;
 }
 
+static size_t GetNumCompressionThreads(size_t num_blocks)
+{
+	size_t num_threads = std::min<size_t>(Common::ThreadPool::GetNumWorkers() + 1, MAX_COMPRESSION_THREADS);
+	return std::max<size_t>(std::min(num_threads, num_blocks), 1);
+}
+
+// Runs func(first_block, last_block, range_index) over contiguous ranges of
+// blocks on the thread pool.
+template <typename Func>
+static void ForEachBlockRange(size_t num_blocks, size_t num_threads, Func func)
+{
+	Common::TaskGroup group;
+	const size_t blocks_per_thread = (num_blocks + num_threads - 1) / num_threads;
+	for (size_t t = 1; t < num_threads; t++)
+	{
+		const size_t first = std::min(t * blocks_per_thread, num_blocks);
+		const size_t last = std::min(first + blocks_per_thread, num_blocks);
+		group.Run([=]{ func(first, last, t); });
+	}
+	func(0, std::min(blocks_per_thread, num_blocks), 0);
+	group.Wait();
+}
+
+// A state as seen by the compressor, in pieces which are read where they are
+class StateView
+{
+public:
+	StateView(const u8* data, size_t size) : m_size(0)
+	{
+		AddPiece(data, size);
+	}
+
+	StateView(const std::vector<u8>& buffer, const std::vector<StateRegion>& regions) : m_size(0)
+	{
+		size_t pos = 0;
+		for (const StateRegion& region : regions)
+		{
+			AddPiece(buffer.data() + pos, region.offset - pos);
+			AddPiece(region.data, region.size);
+			pos = region.offset;
+		}
+		AddPiece(buffer.data() + pos, buffer.size() - pos);
+	}
+
+	size_t GetSize() const { return m_size; }
+
+	// Points into the state if the range is in one piece, else copies it to
+	// scratch, which has to hold size bytes
+	const u8* Get(size_t offset, size_t size, u8* scratch) const
+	{
+		if (size == 0)
+			return scratch;
+
+		std::vector<Piece>::const_iterator it = std::upper_bound(m_pieces.begin(), m_pieces.end(), offset,
+			[](size_t o, const Piece& piece) { return o < piece.offset; }) - 1;
+		if (offset + size <= it->offset + it->size)
+			return it->data + (offset - it->offset);
+
+		for (u8* out = scratch; size; ++it)
+		{
+			const size_t skip = offset - it->offset;
+			const size_t len = std::min(size, it->size - skip);
+			memcpy(out, it->data + skip, len);
+			out += len;
+			offset += len;
+			size -= len;
+		}
+		return scratch;
+	}
+
+	void CopyTo(std::vector<u8>& out) const
+	{
+		out.resize(m_size);
+		for (const Piece& piece : m_pieces)
+			memcpy(&out[piece.offset], piece.data, piece.size);
+	}
+
+private:
+	struct Piece
+	{
+		size_t offset;
+		const u8* data;
+		size_t size;
+	};
+
+	void AddPiece(const u8* data, size_t size)
+	{
+		if (size == 0)
+			return;
+		Piece piece = { m_size, data, size };
+		m_pieces.push_back(piece);
+		m_size += size;
+	}
+
+	std::vector<Piece> m_pieces;
+	size_t m_size;
+};
+
+// Compresses the state into the same stream of (u32 length, LZO block) pairs
+// that the single-threaded version produced.
+static bool CompressBuffer(const StateView& state, std::vector<std::vector<u8>>& ret_streams)
+{
+	const size_t buffer_size = state.GetSize();
+	const size_t num_blocks = buffer_size / IN_LEN + 1;
+	const size_t num_threads = GetNumCompressionThreads(num_blocks);
+	std::vector<std::vector<u8>> streams(num_threads);
+	std::vector<u8> failed(num_threads, 0);
+
+	ForEachBlockRange(num_blocks, num_threads, [&](size_t first, size_t last, size_t t)
+	{
+		std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+		std::vector<u8>& stream = streams[t];
+		stream.resize((last - first) * (sizeof(lzo_uint32) + OUT_LEN));
+		// For the blocks which span the end of a region
+		std::vector<u8> scratch(IN_LEN);
+
+		size_t pos = 0;
+		for (size_t block = first; block < last; block++)
+		{
+			const size_t offset = block * IN_LEN;
+			const lzo_uint cur_len = (lzo_uint)std::min<size_t>(IN_LEN, buffer_size - offset);
+			lzo_uint out_len = 0;
+
+			const u8* block_data = state.Get(offset, cur_len, scratch.data());
+			if (lzo1x_1_compress(block_data, cur_len, &stream[pos + sizeof(lzo_uint32)], &out_len, &wrkmem[0]) != LZO_E_OK)
+			{
+				failed[t] = 1;
+				break;
+			}
+
+			const lzo_uint32 out_len32 = (lzo_uint32)out_len;
+			memcpy(&stream[pos], &out_len32, sizeof(lzo_uint32));
+			pos += sizeof(lzo_uint32) + out_len;
+		}
+		stream.resize(pos);
+	});
+
+	if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+		return false;
+
+	ret_streams.swap(streams);
+	return true;
+}
+
+// Decompresses a stream of (u32 length, LZO block) pairs into buffer, which must
+// already have the uncompressed size. Every block except the last one holds IN_LEN
+// bytes, the last one may be empty. Fails unless the stream fills the whole buffer.
+static bool DecompressBuffer(const std::vector<u8>& stream, std::vector<u8>& buffer)
+{
+	std::vector<size_t> block_offsets;
+	size_t pos = 0;
+	while (pos + sizeof(lzo_uint32) <= stream.size())
+	{
+		lzo_uint32 cur_len;
+		memcpy(&cur_len, &stream[pos], sizeof(lzo_uint32));
+		pos += sizeof(lzo_uint32);
+		if (cur_len > stream.size() - pos)
+			return false;
+
+		block_offsets.push_back(pos);
+		pos += cur_len;
+	}
+	block_offsets.push_back(pos + sizeof(lzo_uint32));
+
+	const size_t num_blocks = block_offsets.size() - 1;
+	// The compressor always writes buffer.size() / IN_LEN + 1 blocks, so a stream
+	// with fewer was cut short
+	if (num_blocks != buffer.size() / IN_LEN + 1)
+		return false;
+
+	const size_t num_threads = GetNumCompressionThreads(num_blocks);
+	std::vector<u8> failed(num_threads, 0);
+
+	ForEachBlockRange(num_blocks, num_threads, [&](size_t first, size_t last, size_t t)
+	{
+		for (size_t block = first; block < last; block++)
+		{
+			const size_t offset = block * IN_LEN;
+			const lzo_uint expected_len = (lzo_uint)std::min<size_t>(IN_LEN, buffer.size() - offset);
+			const lzo_uint cur_len = (lzo_uint)(block_offsets[block + 1] - sizeof(lzo_uint32) - block_offsets[block]);
+			lzo_uint new_len = expected_len;
+
+			const int res = lzo1x_decompress_safe(&stream[block_offsets[block]], cur_len, buffer.data() + offset, &new_len, NULL);
+			if (res != LZO_E_OK || new_len != expected_len)
+			{
+				ERROR_LOG(COMMON, "LZO decompression of block %u failed (%d)", (u32)block, res);
+				failed[t] = 1;
+				break;
+			}
+		}
+	});
+
+	return std::find(failed.begin(), failed.end(), 1) == failed.end();
+}
+
+static void CompressToStream(const u8* data, size_t size, std::vector<u8>& ret_stream)
+{
+	std::vector<std::vector<u8>> streams;
+	if (!CompressBuffer(StateView(data, size), streams))
+		PanicAlertT("Internal LZO Error - compression failed");
+
+	ret_stream.clear();
+	for (auto& stream : streams)
+		ret_stream.insert(ret_stream.end(), stream.begin(), stream.end());
+}
+
 struct CompressAndDumpState_args
 {
-	std::vector<u8>* buffer_vector;
+	std::vector<std::vector<u8>>* streams;
+	u32 state_size; // the uncompressed size if the streams are compressed, else 0
 	std::mutex* buffer_mutex;
 	std::string filename;
 	bool wait;
@@ -210,8 +517,6 @@ void CompressAndDumpState(CompressAndDumpState_args save_args)
 	if (!save_args.wait)
 		g_compressAndDumpStateSyncEvent.Set();
 
-	const u8* const buffer_data = &(*(save_args.buffer_vector))[0];
-	const size_t buffer_size = (save_args.buffer_vector)->size();
 	std::string& filename = save_args.filename;
 
 	// For easy debugging
@@ -247,45 +552,12 @@ void CompressAndDumpState(CompressAndDumpState_args save_args)
 	// Setting up the header
 	StateHeader header;
 	memcpy(header.gameID, SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), 6);
-	header.size = g_use_compression ? (u32)buffer_size : 0;
+	header.size = save_args.state_size; // non-zero header size means the state is compressed
 	header.time = Common::Timer::GetDoubleTime();
 
 	f.WriteArray(&header, 1);
-
-	if (0 != header.size)	// non-zero header size means the state is compressed
-	{
-		lzo_uint i = 0;
-		while (true)
-		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
-
-			if (cur_len != IN_LEN)
-				break;
-
-			i += cur_len;
-		}
-	}
-	else	// uncompressed
-	{
-		f.WriteBytes(buffer_data, buffer_size);
-	}
+	for (auto& stream : *save_args.streams)
+		f.WriteBytes(stream.data(), stream.size());
 
 	Core::DisplayMessage(StringFromFormat("Saved State to %s",
 		filename.c_str()).c_str(), 2000);
@@ -297,27 +569,46 @@ void SaveAs(const std::string& filename, bool wait)
 	// Pause the core while we save the state
 	bool wasUnpaused = Core::PauseAndLock(true);
 
-	// Measure the size of the buffer.
-	u8 *ptr = NULL;
-	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-	DoState(p);
-	const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-
-	// Then actually do the write.
+	bool saved;
+	u32 state_size = 0;
 	{
 		std::lock_guard<std::mutex> lk(g_cs_current_buffer);
-		g_current_buffer.resize(buffer_size);
-		ptr = &g_current_buffer[0];
-		p.SetMode(PointerWrap::MODE_WRITE);
+
+		// RAM and the other large arrays aren't copied, the compressor reads
+		// them in place before the core goes on
+		g_save_buffer.clear();
+		g_save_regions.clear();
+		PointerWrap p(&g_save_buffer, &g_save_regions);
 		DoState(p);
+		saved = p.GetMode() == PointerWrap::MODE_WRITE;
+
+		if (saved)
+		{
+			const StateView state(g_save_buffer, g_save_regions);
+			if (g_use_compression)
+			{
+				state_size = (u32)state.GetSize();
+				if (!CompressBuffer(state, g_current_streams))
+				{
+					PanicAlertT("Internal LZO Error - compression failed");
+					g_current_streams.clear();
+				}
+			}
+			else
+			{
+				g_current_streams.resize(1);
+				state.CopyTo(g_current_streams[0]);
+			}
+		}
 	}
 
-	if (p.GetMode() == PointerWrap::MODE_WRITE)
+	if (saved)
 	{
 		Core::DisplayMessage("Saving State...", 1000);
 
 		CompressAndDumpState_args save_args;
-		save_args.buffer_vector = &g_current_buffer;
+		save_args.streams = &g_current_streams;
+		save_args.state_size = state_size;
 		save_args.buffer_mutex = &g_cs_current_buffer;
 		save_args.filename = filename;
 		save_args.wait = wait;
@@ -380,26 +671,12 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 
 		buffer.resize(header.size);
 
-		lzo_uint i = 0;
-		while (true)
+		std::vector<u8> stream((size_t)(f.GetSize() - sizeof(StateHeader)));
+		if (!f.ReadBytes(stream.data(), stream.size()) || !DecompressBuffer(stream, buffer))
 		{
-			lzo_uint32 cur_len = 0;  // number of bytes to read
-			lzo_uint new_len = 0;  // number of bytes to write
-
-			if (!f.ReadArray(&cur_len, 1))
-				break;
-
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, NULL);
-			if (res != LZO_E_OK)
-			{
-				// This doesn't seem to happen anymore.
-				PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-					"Try loading the state again", res, i, new_len);
-				return;
-			}
-
-			i += new_len;
+			PanicAlertT("Internal LZO Error - decompression failed\n"
+				"Try loading the state again");
+			return;
 		}
 	}
 	else	// uncompressed
@@ -527,11 +804,175 @@ void VerifyAt(const std::string& filename)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+// Called on the CPU thread in between CoreTiming slices, where the scheduler is in
+// a consistent state. Memory is written straight through fastmem, so changed pages
+// are found by comparing against the keyframe instead of tracking writes.
+static void TakeRewindSnapshot()
+{
+	const SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	const size_t max_snapshots = (size_t)std::max(params.iRewindSeconds * params.iRewindSnapshotsPerSecond, 1);
+	const size_t keyframe_interval = std::min<size_t>(REWIND_KEYFRAME_INTERVAL, max_snapshots / 2);
+
+	SaveToBuffer(g_rewind_buffer);
+
+	RewindSnapshot snapshot;
+	snapshot.size = (u32)g_rewind_buffer.size();
+	snapshot.keyframe = g_rewind_keyframe.size() != g_rewind_buffer.size() ||
+		g_rewind_deltas_since_keyframe >= keyframe_interval;
+
+	if (snapshot.keyframe)
+	{
+		CompressToStream(&g_rewind_buffer[0], g_rewind_buffer.size(), snapshot.data);
+		g_rewind_keyframe = g_rewind_buffer;
+		g_rewind_deltas_since_keyframe = 0;
+	}
+	else
+	{
+		g_rewind_delta.clear();
+		for (size_t offset = 0; offset < g_rewind_buffer.size(); offset += REWIND_PAGE_SIZE)
+		{
+			const size_t len = std::min<size_t>(REWIND_PAGE_SIZE, g_rewind_buffer.size() - offset);
+			const u8* cur = &g_rewind_buffer[offset];
+			const u8* key = &g_rewind_keyframe[offset];
+			if (!memcmp(cur, key, len))
+				continue;
+
+			snapshot.pages.push_back((u32)(offset / REWIND_PAGE_SIZE));
+			const size_t pos = g_rewind_delta.size();
+			g_rewind_delta.resize(pos + len);
+			for (size_t i = 0; i < len; i++)
+				g_rewind_delta[pos + i] = cur[i] ^ key[i];
+		}
+
+		CompressToStream(g_rewind_delta.data(), g_rewind_delta.size(), snapshot.data);
+		g_rewind_deltas_since_keyframe++;
+	}
+
+	std::lock_guard<std::mutex> lk(g_cs_rewind);
+	g_rewind_snapshots.push_back(std::move(snapshot));
+
+	// Deltas are useless without their keyframe, so drop them together with it.
+	if (g_rewind_snapshots.size() > max_snapshots)
+	{
+		g_rewind_snapshots.pop_front();
+		while (!g_rewind_snapshots.empty() && !g_rewind_snapshots.front().keyframe)
+			g_rewind_snapshots.pop_front();
+
+		if (g_rewind_snapshots.empty())
+			g_rewind_keyframe.clear();
+	}
+}
+
+static void RewindAdvanceCallback(int cyclesExecuted)
+{
+	const SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	if (params.iRewindSeconds <= 0 || params.iRewindSnapshotsPerSecond <= 0 ||
+	    Movie::IsRecordingInput() || Movie::IsPlayingInput())
+		return;
+
+	g_rewind_cycles += cyclesExecuted;
+	if (g_rewind_cycles >= (s64)(SystemTimers::GetTicksPerSecond() / params.iRewindSnapshotsPerSecond))
+	{
+		g_rewind_cycles = 0;
+		TakeRewindSnapshot();
+	}
+}
+
+static void AdvanceCallback(int cyclesExecuted)
+{
+	// NetPlay keeps its own snapshots for rolling back mispredicted pads
+	if (NetPlay::IsNetPlayRunning())
+		NetPlay::OnAdvance();
+	else
+		RewindAdvanceCallback(cyclesExecuted);
+}
+
+static void ResetRewindBuffer()
+{
+	std::lock_guard<std::mutex> lk(g_cs_rewind);
+	std::deque<RewindSnapshot>().swap(g_rewind_snapshots);
+	std::vector<u8>().swap(g_rewind_keyframe);
+	std::vector<u8>().swap(g_rewind_buffer);
+	std::vector<u8>().swap(g_rewind_delta);
+	g_rewind_deltas_since_keyframe = 0;
+	g_rewind_cycles = 0;
+}
+
+bool Rewind()
+{
+	if (Movie::IsRecordingInput() || Movie::IsPlayingInput())
+	{
+		Core::DisplayMessage("Rewind is not available while a movie is active", 2000);
+		return false;
+	}
+
+	// Pause first, so that the CPU thread can't be in the middle of a snapshot.
+	bool wasUnpaused = Core::PauseAndLock(true);
+
+	std::vector<u8> buffer;
+	{
+		std::lock_guard<std::mutex> lk(g_cs_rewind);
+		if (!g_rewind_snapshots.empty())
+		{
+			auto keyframe = g_rewind_snapshots.end() - 1;
+			while (!keyframe->keyframe)
+				--keyframe;
+
+			const RewindSnapshot& snapshot = g_rewind_snapshots.back();
+			buffer.resize(keyframe->size);
+			bool ok = DecompressBuffer(keyframe->data, buffer);
+			if (ok && !snapshot.keyframe)
+			{
+				size_t delta_size = 0;
+				for (u32 page : snapshot.pages)
+					delta_size += std::min<size_t>(REWIND_PAGE_SIZE, buffer.size() - (size_t)page * REWIND_PAGE_SIZE);
+
+				std::vector<u8> delta(delta_size);
+				if (!delta.empty())
+					ok = DecompressBuffer(snapshot.data, delta);
+				for (size_t i = 0, pos = 0; ok && i < snapshot.pages.size(); i++)
+				{
+					const size_t offset = (size_t)snapshot.pages[i] * REWIND_PAGE_SIZE;
+					const size_t len = std::min<size_t>(REWIND_PAGE_SIZE, buffer.size() - offset);
+					for (size_t j = 0; j < len; j++)
+						buffer[offset + j] ^= delta[pos + j];
+					pos += len;
+				}
+			}
+
+			if (!ok)
+			{
+				Core::DisplayMessage("Unable to Rewind : Corrupted rewind snapshot", 2000);
+				buffer.clear();
+			}
+
+			// The next snapshot starts a new keyframe, the current one may have been dropped.
+			g_rewind_snapshots.pop_back();
+			g_rewind_keyframe.clear();
+			g_rewind_cycles = 0;
+		}
+	}
+
+	if (!buffer.empty())
+		LoadFromBuffer(buffer);
+
+	Core::PauseAndLock(false, wasUnpaused);
+	return !buffer.empty();
+}
+
+void ClearRewindBuffer()
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+	ResetRewindBuffer();
+	Core::PauseAndLock(false, wasUnpaused);
+}
 
 void Init()
 {
 	if (lzo_init() != LZO_E_OK)
 		PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+	CoreTiming::RegisterAdvanceCallback(AdvanceCallback);
 }
 
 void Shutdown()
@@ -542,13 +983,18 @@ void Shutdown()
 	// this gives a better guarantee to free the allocated memory right NOW (as opposed to, actually, never)
 	{
 		std::lock_guard<std::mutex> lk(g_cs_current_buffer);
-		std::vector<u8>().swap(g_current_buffer);
+		std::vector<std::vector<u8>>().swap(g_current_streams);
+		std::vector<u8>().swap(g_save_buffer);
+		std::vector<StateRegion>().swap(g_save_regions);
 	}
 
 	{
 		std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
 		std::vector<u8>().swap(g_undo_load_buffer);
 	}
+
+	CoreTiming::RegisterAdvanceCallback(NULL);
+	ResetRewindBuffer();
 }
 
 static std::string MakeStateFilename(int number)
@@ -44,6 +44,13 @@ void SaveAs(const std::string &filename, bool wait = false);
 void LoadAs(const std::string &filename);
 void VerifyAt(const std::string &filename);
 
+// Uncompressed whole states without undo buffers or messages, for the boot
+// snapshot cache. Loading fails without touching anything if the snapshot is
+// from another state version.
+bool IsSnapshotUsable(const std::string& filename);
+bool SaveSnapshot(const std::string& filename);
+bool LoadSnapshot(const std::string& filename);
+
 void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 void VerifyBuffer(std::vector<u8>& buffer);
@@ -53,6 +60,12 @@ void SaveFirstSaved();
 void UndoSaveState();
 void UndoLoadState();
 
+// Rewind: while Core/RewindSeconds is non-zero, snapshots are taken
+// Core/RewindSnapshotsPerSecond times per emulated second.
+// Rewind() loads the newest snapshot and drops it, returns false if there is none.
+bool Rewind();
+void ClearRewindBuffer();
+
 // wait until previously scheduled savestate event (if any) is done
 void Flush();
 
@@ -0,0 +1,213 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common.h"
+#include "StringUtil.h"
+#include "TraceFile.h"
+
+namespace Tracer
+{
+
+enum
+{
+	TRACE_MAGIC = 0x43525444,  // "DTRC"
+	TRACE_VERSION = 1,
+
+	SAME_PC_FLAG = 0x80,
+};
+
+struct TraceHeader
+{
+	u32 magic;
+	u32 version;
+	u64 first_entry;
+	u32 num_chunks;
+	u32 pad;
+};
+
+struct ChunkHeader
+{
+	u32 num_entries;
+	u32 size;
+};
+
+static bool IsWideSlot(int slot)
+{
+	return slot >= SLOT_PS && slot < SLOT_CR;
+}
+
+std::string GetSlotName(int slot)
+{
+	static const char* const names[] = { "cr", "xer", "lr", "ctr", "msr", "fpscr", "srr0", "srr1" };
+	if (slot < SLOT_PS)
+		return StringFromFormat("r%d", slot - SLOT_GPR);
+	if (slot < SLOT_CR)
+		return StringFromFormat("ps%d_%d", (slot - SLOT_PS) / 2, (slot - SLOT_PS) % 2);
+	if (slot < SLOT_GQR)
+		return names[slot - SLOT_CR];
+	return StringFromFormat("gqr%d", slot - SLOT_GQR);
+}
+
+std::string FormatSlotValue(int slot, u64 value)
+{
+	if (!IsWideSlot(slot))
+		return StringFromFormat("%08x", (u32)value);
+
+	double d;
+	std::memcpy(&d, &value, sizeof(d));
+	return StringFromFormat("%016llx (%g)", (unsigned long long)value, d);
+}
+
+template <typename T>
+static void Put(std::vector<u8>& data, T value)
+{
+	const size_t offset = data.size();
+	data.resize(offset + sizeof(T));
+	std::memcpy(&data[offset], &value, sizeof(T));
+}
+
+void TraceChunk::Append(const State& state)
+{
+	const bool first = m_num_entries == 0;
+	const size_t count_offset = m_data.size();
+	u8 count = 0;
+	m_data.push_back(0);
+
+	const bool same_pc = !first && state.pc == m_last.pc + 4;
+	if (!same_pc)
+		Put<u32>(m_data, state.pc);
+
+	for (int slot = 0; slot < NUM_SLOTS; slot++)
+	{
+		if (!first && state.regs[slot] == m_last.regs[slot])
+			continue;
+
+		m_data.push_back((u8)slot);
+		if (IsWideSlot(slot))
+			Put<u64>(m_data, state.regs[slot]);
+		else
+			Put<u32>(m_data, (u32)state.regs[slot]);
+		count++;
+	}
+
+	m_data[count_offset] = count | (same_pc ? SAME_PC_FLAG : 0);
+	m_last = state;
+	m_num_entries++;
+}
+
+bool WriteTrace(const std::string& filename, u64 first_entry,
+                const TraceChunk* const* chunks, size_t num_chunks)
+{
+	File::IOFile file(filename, "wb");
+	TraceHeader header = { TRACE_MAGIC, TRACE_VERSION, first_entry, (u32)num_chunks, 0 };
+	if (!file.WriteArray(&header, 1))
+		return false;
+
+	for (size_t i = 0; i < num_chunks; i++)
+	{
+		const std::vector<u8>& data = chunks[i]->GetData();
+		ChunkHeader chunk_header = { chunks[i]->GetNumEntries(), (u32)data.size() };
+		if (!file.WriteArray(&chunk_header, 1) || !file.WriteBytes(data.data(), data.size()))
+			return false;
+	}
+	return true;
+}
+
+TraceReader::TraceReader()
+	: m_chunks_left(0), m_offset(0), m_entries_left(0), m_entry_index(0)
+{
+	std::memset(&m_state, 0, sizeof(m_state));
+}
+
+bool TraceReader::Open(const std::string& filename)
+{
+	TraceHeader header;
+	if (!m_file.Open(filename, "rb") || !m_file.ReadArray(&header, 1) ||
+	    header.magic != TRACE_MAGIC || header.version != TRACE_VERSION)
+		return false;
+
+	m_chunks_left = header.num_chunks;
+	m_entries_left = 0;
+	m_entry_index = header.first_entry;
+	return true;
+}
+
+bool TraceReader::ReadChunk()
+{
+	ChunkHeader header;
+	if (m_chunks_left == 0 || !m_file.ReadArray(&header, 1))
+		return false;
+
+	std::vector<u8>& data = m_chunk.GetData();
+	data.resize(header.size);
+	if (header.size && !m_file.ReadBytes(data.data(), header.size))
+		return false;
+
+	m_chunks_left--;
+	m_entries_left = header.num_entries;
+	m_offset = 0;
+	return true;
+}
+
+bool TraceReader::Next(State* state)
+{
+	while (m_entries_left == 0)
+	{
+		if (!ReadChunk())
+			return false;
+	}
+
+	const std::vector<u8>& data = m_chunk.GetData();
+	const size_t size = data.size();
+	if (m_offset >= size)
+		return false;
+
+	const u8 count = data[m_offset] & ~SAME_PC_FLAG;
+	const bool same_pc = (data[m_offset] & SAME_PC_FLAG) != 0;
+	m_offset++;
+
+	if (same_pc)
+	{
+		m_state.pc += 4;
+	}
+	else
+	{
+		if (m_offset + sizeof(u32) > size)
+			return false;
+		std::memcpy(&m_state.pc, &data[m_offset], sizeof(u32));
+		m_offset += sizeof(u32);
+	}
+
+	for (u8 i = 0; i < count; i++)
+	{
+		if (m_offset >= size || data[m_offset] >= NUM_SLOTS)
+			return false;
+		const int slot = data[m_offset++];
+		if (IsWideSlot(slot))
+		{
+			if (m_offset + sizeof(u64) > size)
+				return false;
+			std::memcpy(&m_state.regs[slot], &data[m_offset], sizeof(u64));
+			m_offset += sizeof(u64);
+		}
+		else
+		{
+			u32 value;
+			if (m_offset + sizeof(u32) > size)
+				return false;
+			std::memcpy(&value, &data[m_offset], sizeof(u32));
+			m_state.regs[slot] = value;
+			m_offset += sizeof(u32);
+		}
+	}
+
+	m_entries_left--;
+	m_entry_index++;
+	*state = m_state;
+	return true;
+}
+
+}  // namespace
@@ -0,0 +1,102 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "FileUtil.h"
+
+// The format of the CPU traces Tracer records, kept apart from the emulator
+// so tools like tracediff can read them on their own.
+//
+// Every entry is the register state of the CPU at some PC, stored as the
+// registers that changed since the previous entry:
+//   u8 count, with the top bit set if the PC is the previous one plus 4
+//   u32 pc, unless the top bit was set
+//   count times: u8 slot, then the value as a u32, or a u64 for the FPRs
+// Entries are grouped in chunks which start with every register, so the
+// oldest chunks can be dropped and each one decoded on its own.
+
+namespace Tracer
+{
+
+enum
+{
+	SLOT_GPR = 0,
+	SLOT_PS = SLOT_GPR + 32,  // ps0 and ps1 of each FPR
+	SLOT_CR = SLOT_PS + 64,
+	SLOT_XER,
+	SLOT_LR,
+	SLOT_CTR,
+	SLOT_MSR,
+	SLOT_FPSCR,
+	SLOT_SRR0,
+	SLOT_SRR1,
+	SLOT_GQR,
+	NUM_SLOTS = SLOT_GQR + 8,
+
+	CHUNK_ENTRIES = 0x10000,
+};
+
+struct State
+{
+	u32 pc;
+	u64 regs[NUM_SLOTS];
+};
+
+// "r3", "ps5_1", "lr"...
+std::string GetSlotName(int slot);
+std::string FormatSlotValue(int slot, u64 value);
+
+class TraceChunk
+{
+public:
+	TraceChunk() : m_num_entries(0) {}
+
+	void Append(const State& state);
+
+	u32 GetNumEntries() const { return m_num_entries; }
+	const std::vector<u8>& GetData() const { return m_data; }
+	std::vector<u8>& GetData() { return m_data; }
+
+private:
+	std::vector<u8> m_data;
+	u32 m_num_entries;
+	State m_last;
+};
+
+// Writes the chunks, first_entry is the number of entries that were dropped
+// before the first one.
+bool WriteTrace(const std::string& filename, u64 first_entry,
+                const TraceChunk* const* chunks, size_t num_chunks);
+
+class TraceReader
+{
+public:
+	TraceReader();
+
+	bool Open(const std::string& filename);
+
+	// Decodes the next entry, false at the end of the trace or a broken one
+	bool Next(State* state);
+
+	// Index of the entry Next returned last, counting the dropped ones
+	u64 GetEntryIndex() const { return m_entry_index - 1; }
+
+private:
+	bool ReadChunk();
+
+	File::IOFile m_file;
+	u32 m_chunks_left;
+	TraceChunk m_chunk;
+	size_t m_offset;
+	u32 m_entries_left;
+	u64 m_entry_index;
+	State m_state;
+};
+
+}  // namespace
@@ -2,127 +2,79 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include <stdlib.h>
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include "Common.h"
 #include "Tracer.h"
-#include "FileUtil.h"
-
-#include "Host.h"
+#include "TraceFile.h"
 
 #include "PowerPC/PowerPC.h"
 
-namespace Core {
+namespace Tracer
+{
 
-File::IOFile tracefile;
+bool g_recording = false;
 
-bool bReadTrace = false;
-bool bWriteTrace = false;
+static std::deque<std::unique_ptr<TraceChunk>> s_chunks;
+static size_t s_max_chunks;
+static u64 s_dropped_entries;
 
-void StartTrace(bool write)
+void Start(u32 max_entries)
 {
-	if (write)
-	{
-		tracefile.Open("L:\\trace.dat", "wb");
-		bReadTrace = false;
-		bWriteTrace = true;
-	}
-	else
-	{
-		tracefile.Open("L:\\trace.dat", "rb");
-		bReadTrace = true;
-		bWriteTrace = false;
-	}
+	Stop();
+	s_chunks.clear();
+	s_dropped_entries = 0;
+	// One more, so dropping the oldest still leaves max_entries
+	s_max_chunks = (max_entries + CHUNK_ENTRIES - 1) / CHUNK_ENTRIES + 1;
+	g_recording = true;
 }
 
-void StopTrace()
+void Stop()
 {
-	tracefile.Close();
+	g_recording = false;
 }
 
-static int stateSize = 32*4;// + 32*16 + 6*4;
-
-int SyncTrace()
+void Record()
 {
-	if (bWriteTrace)
+	State state;
+	state.pc = PC;
+	for (int i = 0; i < 32; i++)
 	{
-		tracefile.WriteBytes(&PowerPC::ppcState, stateSize);
-		tracefile.Flush();
-		return 1;
+		state.regs[SLOT_GPR + i] = PowerPC::ppcState.gpr[i];
+		state.regs[SLOT_PS + i * 2] = PowerPC::ppcState.ps[i][0];
+		state.regs[SLOT_PS + i * 2 + 1] = PowerPC::ppcState.ps[i][1];
 	}
-	if (bReadTrace)
-	{
-		PowerPC::PowerPCState state;
-		if (!tracefile.ReadBytes(&state, stateSize))
-			return 1;
+	state.regs[SLOT_CR] = GetCR();
+	state.regs[SLOT_XER] = PowerPC::ppcState.spr[SPR_XER];
+	state.regs[SLOT_LR] = LR;
+	state.regs[SLOT_CTR] = CTR;
+	state.regs[SLOT_MSR] = MSR;
+	state.regs[SLOT_FPSCR] = PowerPC::ppcState.fpscr;
+	state.regs[SLOT_SRR0] = SRR0;
+	state.regs[SLOT_SRR1] = SRR1;
+	for (int i = 0; i < 8; i++)
+		state.regs[SLOT_GQR + i] = GQR(i);
 
-		bool difference = false;
-		for (int i=0; i<32; i++)
-		{
-			if (PowerPC::ppcState.gpr[i] != state.gpr[i])
-			{
-				DEBUG_LOG(POWERPC, "DIFFERENCE - r%i (local %08x, remote %08x)", i, PowerPC::ppcState.gpr[i], state.gpr[i]);
-				difference = true;
-			}
-		}
-/*
-		for (int i=0; i<32; i++)
-		{
-			for (int j=0; j<2; j++)
-			{
-				if (PowerPC::ppcState.ps[i][j] != state.ps[i][j])
-				{
-					LOG(GEKKO, "DIFFERENCE - ps%i_%i (local %f, remote %f)", i, j, PowerPC::ppcState.ps[i][j], state.ps[i][j]);
-					difference = true;
-				}
-			}
-		}*/
-		/*
-		if (GetCR() != state.cr)
-		{
-			LOG(GEKKO, "DIFFERENCE - CR (local %08x, remote %08x)", PowerPC::ppcState.cr, state.cr);
-			difference = true;
-		}
-		if (PowerPC::ppcState.pc != state.pc)
-		{
-			LOG(GEKKO, "DIFFERENCE - PC (local %08x, remote %08x)", PowerPC::ppcState.pc, state.pc);
-			difference = true;
-		}
-		if (PowerPC::ppcState.npc != state.npc)
-		{
-			LOG(GEKKO, "DIFFERENCE - NPC (local %08x, remote %08x)", PowerPC::ppcState.npc, state.npc);
-			difference = true;
-		}
-		if (PowerPC::ppcState.msr != state.msr)
-		{
-			LOG(GEKKO, "DIFFERENCE - MSR (local %08x, remote %08x)", PowerPC::ppcState.msr, state.msr);
-			difference = true;
-		}
-		if (PowerPC::ppcState.fpscr != state.fpscr)
-		{
-			LOG(GEKKO, "DIFFERENCE - FPSCR (local %08x, remote %08x)", PowerPC::ppcState.fpscr, state.fpscr);
-			difference = true;
-		}
-*/
-		if (difference)
-		{
-			Host_UpdateLogDisplay();
-			//Also show drec compare window here
-			//CDynaViewDlg::Show(true);
-			//CDynaViewDlg::ViewAddr(m_BlockStart);
-			//CDynaViewDlg::Show(true);
-			//PanicAlert("Hang on");
-			//Sleep(INFINITE);
-			return 0;
-		}
-		else
+	if (s_chunks.empty() || s_chunks.back()->GetNumEntries() == CHUNK_ENTRIES)
+	{
+		if (s_chunks.size() == s_max_chunks)
 		{
-			return 1;
-			//LOG(GEKKO, "No difference!");
+			s_dropped_entries += s_chunks.front()->GetNumEntries();
+			s_chunks.pop_front();
 		}
+		s_chunks.emplace_back(new TraceChunk);
 	}
-	return 1;
+	s_chunks.back()->Append(state);
+}
 
+bool Save(const std::string& filename)
+{
+	std::vector<const TraceChunk*> chunks;
+	for (const auto& chunk : s_chunks)
+		chunks.push_back(chunk.get());
+	return WriteTrace(filename, s_dropped_entries, chunks.data(), chunks.size());
 }
 
-} // end of namespace Core
+}  // namespace
@@ -3,3 +3,36 @@
 // Refer to the license.txt file included.
 
 #pragma once
+
+#include <string>
+
+#include "CommonTypes.h"
+
+// Ring of the emulated CPU's register states, for finding where two runs part
+// ways, like the JIT and the interpreter on the same game. The interpreter
+// records every instruction, Jit64 every block. Saved traces are compared
+// with tracediff, see TraceFile.h for the format.
+
+namespace Tracer
+{
+
+extern bool g_recording;
+
+inline bool IsRecording()
+{
+	return g_recording;
+}
+
+// Keeps at least the last max_entries entries. Has to be called before the
+// JIT compiles anything, blocks only record if they were compiled while
+// recording.
+void Start(u32 max_entries);
+void Stop();
+
+// Records the state at the current PC. The JIT has to have written back
+// everything it holds in host registers, and PC.
+void Record();
+
+bool Save(const std::string& filename);
+
+}  // namespace
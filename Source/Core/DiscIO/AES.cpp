@@ -0,0 +1,84 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "AES.h"
+#include "CPUDetect.h"
+
+// AES-NI needs compiler support: MSVC always has it, GCC only with -maes.
+#if !defined(_M_GENERIC) && !defined(_M_ARM) && (defined(_MSC_VER) || defined(__AES__))
+#define USE_AESNI 1
+#include <wmmintrin.h>
+#endif
+
+namespace DiscIO
+{
+
+#ifdef USE_AESNI
+// CBC decryption with a 128-bit key, using the decryption key schedule set up by
+// aes_setkey_dec, which is in the form aesdec expects. Four blocks are decrypted
+// at once since CBC decryption doesn't depend on the previous output.
+static void DecryptCBC_AESNI(const aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t length)
+{
+	__m128i keys[11];
+	for (int i = 0; i < 11; i++)
+		keys[i] = _mm_loadu_si128((const __m128i*)ctx->rk + i);
+
+	__m128i prev = _mm_loadu_si128((const __m128i*)iv);
+	size_t i = 0;
+	for (; i + 64 <= length; i += 64)
+	{
+		const __m128i c0 = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i c1 = _mm_loadu_si128((const __m128i*)(src + i + 16));
+		const __m128i c2 = _mm_loadu_si128((const __m128i*)(src + i + 32));
+		const __m128i c3 = _mm_loadu_si128((const __m128i*)(src + i + 48));
+		__m128i b0 = _mm_xor_si128(c0, keys[0]);
+		__m128i b1 = _mm_xor_si128(c1, keys[0]);
+		__m128i b2 = _mm_xor_si128(c2, keys[0]);
+		__m128i b3 = _mm_xor_si128(c3, keys[0]);
+		for (int r = 1; r < 10; r++)
+		{
+			b0 = _mm_aesdec_si128(b0, keys[r]);
+			b1 = _mm_aesdec_si128(b1, keys[r]);
+			b2 = _mm_aesdec_si128(b2, keys[r]);
+			b3 = _mm_aesdec_si128(b3, keys[r]);
+		}
+		b0 = _mm_aesdeclast_si128(b0, keys[10]);
+		b1 = _mm_aesdeclast_si128(b1, keys[10]);
+		b2 = _mm_aesdeclast_si128(b2, keys[10]);
+		b3 = _mm_aesdeclast_si128(b3, keys[10]);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(b0, prev));
+		_mm_storeu_si128((__m128i*)(dst + i + 16), _mm_xor_si128(b1, c0));
+		_mm_storeu_si128((__m128i*)(dst + i + 32), _mm_xor_si128(b2, c1));
+		_mm_storeu_si128((__m128i*)(dst + i + 48), _mm_xor_si128(b3, c2));
+		prev = c3;
+	}
+
+	for (; i < length; i += 16)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i b = _mm_xor_si128(c, keys[0]);
+		for (int r = 1; r < 10; r++)
+			b = _mm_aesdec_si128(b, keys[r]);
+		b = _mm_aesdeclast_si128(b, keys[10]);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(b, prev));
+		prev = c;
+	}
+
+	_mm_storeu_si128((__m128i*)iv, prev);
+}
+#endif
+
+void DecryptCBC(aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t length)
+{
+#ifdef USE_AESNI
+	if (cpu_info.bAES && ctx->nr == 10)
+	{
+		DecryptCBC_AESNI(ctx, iv, src, dst, length);
+		return;
+	}
+#endif
+	aes_crypt_cbc(ctx, AES_DECRYPT, length, iv, src, dst);
+}
+
+}  // namespace
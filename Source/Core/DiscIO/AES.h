@@ -0,0 +1,20 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <polarssl/aes.h>
+
+#include "CommonTypes.h"
+
+namespace DiscIO
+{
+
+// AES-CBC decryption with a key set up by aes_setkey_dec. Uses AES-NI when
+// the host has it and the key is 128 bits, else PolarSSL. Like
+// aes_crypt_cbc, length is a multiple of 16 and iv is updated for the blocks
+// that follow.
+void DecryptCBC(aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t length);
+
+}  // namespace
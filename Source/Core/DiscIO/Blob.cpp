@@ -2,8 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Blob.h"
 #include "CDUtils.h"
+#include "ChunkedBlob.h"
 #include "CISOBlob.h"
 #include "CompressedBlob.h"
 #include "DriveBlob.h"
@@ -17,33 +20,254 @@ namespace DiscIO
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
 
+static const u32 DEFAULT_CACHE_SIZE = 8 * 1024 * 1024;
+static const u32 DEFAULT_READAHEAD_SIZE = 256 * 1024;
+
+SectorReader::SectorReader()
+	: m_blocksize(0), m_cache_blocks(0), m_readahead_blocks(0), m_readahead_batch(1)
+	, m_returned_block((u64)(s64) - 1), m_last_block((u64)(s64) - 1), m_readahead_next(0), m_readahead_end(0)
+	, m_readahead_quit(false), m_shared_cache_checked(false)
+{
+}
+
 void SectorReader::SetSectorSize(int blocksize)
 {
-	for (int i = 0; i < CACHE_SIZE; i++)
+	m_blocksize = blocksize;
+	SetCacheSize(DEFAULT_CACHE_SIZE, DEFAULT_READAHEAD_SIZE);
+}
+
+void SectorReader::SetCacheSize(u32 cache_size, u32 readahead_size)
+{
+	StopReadahead();
+
+	std::lock_guard<std::mutex> lk(m_cache_lock);
+	m_readahead_blocks = readahead_size / m_blocksize;
+	// Blocks read ahead shouldn't evict each other before they are used.
+	m_cache_blocks = std::max(cache_size / m_blocksize, m_readahead_blocks + 2);
+	m_cache_index.reserve(m_cache_blocks);
+
+	while (m_cache.size() > m_cache_blocks)
 	{
-		cache[i] = new u8[blocksize];
-		cache_tags[i] = (u64)(s64) - 1;
+		m_cache_index.erase(m_cache.back().block_num);
+		m_cache.pop_back();
 	}
-	m_blocksize = blocksize;
 }
 
-SectorReader::~SectorReader() {
-	for (int i = 0; i < CACHE_SIZE; i++)
-		delete [] cache[i];
+void SectorReader::SetReadaheadBatch(u32 num_blocks)
+{
+	StopReadahead();
+	m_readahead_batch = std::max(num_blocks, 1u);
 }
 
-const u8 *SectorReader::GetBlockData(u64 block_num)
+void SectorReader::GetBlocks(u64 block_num, u64 num_blocks, u8 *out)
+{
+	for (u64 i = 0; i < num_blocks; i++)
+		GetBlock(block_num + i, out + i * m_blocksize);
+}
+
+SectorReader::~SectorReader()
+{
+	StopReadahead();
+}
+
+void SectorReader::StopReadahead()
+{
+	if (!m_readahead_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		m_readahead_quit = true;
+	}
+	m_readahead_cond.notify_one();
+	m_readahead_thread.join();
+	m_readahead_quit = false;
+}
+
+void SectorReader::OpenSharedCache()
+{
+	std::lock_guard<std::mutex> block_lk(m_block_lock);
+	m_shared_cache_checked = true;
+
+	std::vector<u8> first_block(m_blocksize);
+	GetBlock(0, &first_block[0]);
+	const std::string filename = SharedBlockCache::GetFilename(&first_block[0], m_blocksize, m_blocksize, GetDataSize(), "");
+	if (filename.empty())
+		return;
+
+	const u64 num_blocks = (GetDataSize() + m_blocksize - 1) / m_blocksize;
+	m_shared_cache.reset(SharedBlockCache::Open(filename, m_blocksize, num_blocks));
+	if (m_shared_cache)
+		m_shared_cache->Insert(0, &first_block[0]);
+}
+
+// Must be called with m_cache_lock held.
+bool SectorReader::IsBlockCached(u64 block_num)
+{
+	if (m_shared_cache && m_shared_cache->Find(block_num))
+		return true;
+	return m_cache_index.count(block_num) != 0;
+}
+
+// Must be called with m_cache_lock held.
+const u8* SectorReader::FindCachedBlock(u64 block_num)
 {
-	// TODO : Expand usage of the cache to more than one block :P
-	if (cache_tags[0] == block_num)
+	if (m_shared_cache)
+	{
+		const u8* shared = m_shared_cache->Find(block_num);
+		if (shared)
+			return shared;
+	}
+
+	auto it = m_cache_index.find(block_num);
+	if (it == m_cache_index.end())
+		return NULL;
+
+	m_cache.splice(m_cache.begin(), m_cache, it->second);
+	return it->second->data.data();
+}
+
+// Must be called with m_cache_lock held. data is swapped with the buffer of the evicted block, if any.
+const u8* SectorReader::InsertCachedBlock(u64 block_num, std::vector<u8>& data)
+{
+	const u8* cached = FindCachedBlock(block_num);
+	if (cached)
+		return cached;
+
+	if (m_shared_cache)
+	{
+		const u8* shared = m_shared_cache->Insert(block_num, data.data());
+		if (shared)
+			return shared;
+	}
+
+	std::list<CachedBlock> node;
+	if (m_cache.size() >= m_cache_blocks)
 	{
-		return cache[0];
+		auto victim = --m_cache.end();
+		if (victim->block_num == m_returned_block && victim != m_cache.begin())
+			--victim;
+		node.splice(node.begin(), m_cache, victim);
+		m_cache_index.erase(node.front().block_num);
 	}
 	else
 	{
-		GetBlock(block_num, cache[0]);
-		cache_tags[0] = block_num;
-		return cache[0];
+		node.push_back(CachedBlock());
+	}
+
+	node.front().block_num = block_num;
+	node.front().data.swap(data);
+	m_cache.splice(m_cache.begin(), node);
+	m_cache_index[block_num] = m_cache.begin();
+	return m_cache.front().data.data();
+}
+
+const u8 *SectorReader::GetBlockData(u64 block_num)
+{
+	if (!m_shared_cache_checked)
+		OpenSharedCache();
+
+	const u8* data;
+	{
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		data = FindCachedBlock(block_num);
+		if (data)
+			m_returned_block = block_num;
+	}
+
+	if (!data)
+	{
+		std::lock_guard<std::mutex> block_lk(m_block_lock);
+
+		// The readahead thread might have read it while we were waiting.
+		{
+			std::lock_guard<std::mutex> lk(m_cache_lock);
+			data = FindCachedBlock(block_num);
+			if (data)
+				m_returned_block = block_num;
+		}
+
+		if (!data)
+		{
+			m_block_buffer.resize(m_blocksize);
+			GetBlock(block_num, &m_block_buffer[0]);
+
+			std::lock_guard<std::mutex> lk(m_cache_lock);
+			data = InsertCachedBlock(block_num, m_block_buffer);
+			m_returned_block = block_num;
+		}
+	}
+
+	StartReadahead(block_num);
+	return data;
+}
+
+void SectorReader::StartReadahead(u64 block_num)
+{
+	if (m_readahead_blocks == 0 || block_num == m_last_block)
+		return;
+
+	const bool sequential = block_num == m_last_block + 1;
+	m_last_block = block_num;
+	if (!sequential)
+		return;
+
+	const u64 num_blocks = (GetDataSize() + m_blocksize - 1) / m_blocksize;
+	{
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		m_readahead_next = block_num + 1;
+		m_readahead_end = std::min(block_num + 1 + m_readahead_blocks, num_blocks);
+	}
+
+	if (!m_readahead_thread.joinable())
+		m_readahead_thread = std::thread(&SectorReader::ReadaheadThread, this);
+	m_readahead_cond.notify_one();
+}
+
+void SectorReader::ReadaheadThread()
+{
+	Common::SetCurrentThreadName("Disc readahead");
+
+	std::vector<u8> buffer;
+	std::vector<u8> block;
+	std::unique_lock<std::mutex> lk(m_cache_lock);
+	while (true)
+	{
+		while (!m_readahead_quit && m_readahead_next >= m_readahead_end)
+			m_readahead_cond.wait(lk);
+		if (m_readahead_quit)
+			break;
+
+		u64 block_num = m_readahead_next++;
+		if (IsBlockCached(block_num))
+			continue;
+		lk.unlock();
+
+		std::lock_guard<std::mutex> block_lk(m_block_lock);
+		lk.lock();
+		if (IsBlockCached(block_num))
+			continue;
+
+		// Take the uncached blocks that follow along in the same call. The window
+		// may have moved while the lock wasn't held.
+		u64 num_blocks = 1;
+		while (num_blocks < m_readahead_batch && m_readahead_next == block_num + num_blocks &&
+		       m_readahead_next < m_readahead_end && !IsBlockCached(m_readahead_next))
+		{
+			m_readahead_next++;
+			num_blocks++;
+		}
+		lk.unlock();
+
+		buffer.resize(num_blocks * m_blocksize);
+		GetBlocks(block_num, num_blocks, &buffer[0]);
+
+		lk.lock();
+		for (u64 i = 0; i < num_blocks; i++)
+		{
+			block.assign(buffer.begin() + i * m_blocksize, buffer.begin() + (i + 1) * m_blocksize);
+			InsertCachedBlock(block_num + i, block);
+		}
 	}
 }
 
@@ -121,6 +345,9 @@ IBlobReader* CreateBlobReader(const char* filename)
 	if (IsCompressedBlob(filename))
 		return CompressedBlobReader::Create(filename);
 
+	if (IsChunkedBlob(filename))
+		return ChunkedBlobReader::Create(filename);
+
 	if (IsCISOBlob(filename))
 		return CISOFileReader::Create(filename);
 
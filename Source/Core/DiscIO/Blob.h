@@ -14,7 +14,14 @@
 // detect whether the file is a compressed blob, or just a big hunk of data, or a drive, and
 // automatically do the right thing.
 
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "CommonTypes.h"
+#include "Thread.h"
+#include "SharedBlockCache.h"
 
 namespace DiscIO
 {
@@ -36,26 +43,74 @@ protected:
 
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
-// Currently only uses a single entry cache.
-// Multi-block reads are not cached.
+// Blocks are kept in a hash-indexed LRU cache. When blocks are read sequentially,
+// the following blocks are read ahead into the cache on a background thread.
+// With a shared cache directory set, blocks are kept in a SharedBlockCache for
+// the disc instead, so instances running the same game share them.
+// Subclasses must call StopReadahead() in their destructor.
 class SectorReader : public IBlobReader
 {
 private:
-	enum { CACHE_SIZE = 32 };
+	struct CachedBlock
+	{
+		u64 block_num;
+		std::vector<u8> data;
+	};
+
 	int m_blocksize;
-	u8* cache[CACHE_SIZE];
-	u64 cache_tags[CACHE_SIZE];
-	int cache_age[CACHE_SIZE];
+	u32 m_cache_blocks;
+	u32 m_readahead_blocks;
+	u32 m_readahead_batch;
+
+	// Most recently used block first.
+	std::list<CachedBlock> m_cache;
+	std::unordered_map<u64, std::list<CachedBlock>::iterator> m_cache_index;
+	std::mutex m_cache_lock;
+
+	// Only used while m_block_lock is held.
+	std::vector<u8> m_block_buffer;
+
+	// Never evicted, the caller of GetBlockData may still be copying from it
+	u64 m_returned_block;
+	u64 m_last_block;
+	u64 m_readahead_next;
+	u64 m_readahead_end;
+	bool m_readahead_quit;
+	std::thread m_readahead_thread;
+	std::condition_variable m_readahead_cond;
+
+	// Opened by the first GetBlockData, before readahead can start
+	bool m_shared_cache_checked;
+	std::unique_ptr<SharedBlockCache> m_shared_cache;
+
+	void OpenSharedCache();
+	bool IsBlockCached(u64 block_num);
+	const u8* FindCachedBlock(u64 block_num);
+	const u8* InsertCachedBlock(u64 block_num, std::vector<u8>& data);
+	void StartReadahead(u64 block_num);
+	void ReadaheadThread();
 
 protected:
+	// Held while the underlying file or drive is being read.
+	std::mutex m_block_lock;
+
+	SectorReader();
 	void SetSectorSize(int blocksize);
+	// The readahead thread passes up to num_blocks blocks to each GetBlocks call.
+	void SetReadaheadBatch(u32 num_blocks);
+	void StopReadahead();
 	virtual void GetBlock(u64 block_num, u8 *out) = 0;
-	// This one is uncached. The default implementation is to simply call GetBlockData multiple times and memcpy.
+	// Called with m_block_lock held. The default implementation calls GetBlock for each block.
+	virtual void GetBlocks(u64 block_num, u64 num_blocks, u8 *out);
+	// The default implementation is to simply call GetBlockData multiple times and memcpy.
 	virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *out_ptr);
 
 public:
 	virtual ~SectorReader();
 
+	// cache_size and readahead_size are in bytes, a readahead_size of 0 disables readahead.
+	void SetCacheSize(u32 cache_size, u32 readahead_size);
+
 	// A pointer returned by GetBlockData is invalidated as soon as GetBlockData, Read, or ReadMultipleAlignedBlocks is called again.
 	const u8 *GetBlockData(u64 block_num);
 	virtual bool Read(u64 offset, u64 size, u8 *out_ptr);
@@ -0,0 +1,120 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Thread.h"
+
+namespace DiscIO
+{
+
+// Reads blocks in order on a reader thread, processes them on num_workers threads
+// and hands them to write() in order on the calling thread. Every callback gets the
+// block number and the slot holding it; returning false from any of them aborts.
+template <typename ReadFunc, typename ProcessFunc, typename WriteFunc>
+bool RunBlockPipeline(u32 num_blocks, u32 num_slots, u32 num_workers,
+	ReadFunc read, ProcessFunc process, WriteFunc write)
+{
+	std::mutex lock;
+	std::condition_variable cond;
+	std::vector<bool> processed(num_slots, false);
+	u32 num_read = 0;
+	u32 num_claimed = 0;
+	u32 num_written = 0;
+	bool failed = false;
+
+	std::thread reader([&]
+	{
+		for (u32 i = 0; i < num_blocks; i++)
+		{
+			{
+				std::unique_lock<std::mutex> lk(lock);
+				while (!failed && i - num_written >= num_slots)
+					cond.wait(lk);
+				if (failed)
+					return;
+			}
+
+			const bool ok = read(i, i % num_slots);
+
+			std::lock_guard<std::mutex> lk(lock);
+			if (ok)
+				num_read++;
+			else
+				failed = true;
+			cond.notify_all();
+			if (!ok)
+				return;
+		}
+	});
+
+	std::vector<std::thread> workers;
+	for (u32 t = 0; t < num_workers; t++)
+	{
+		workers.push_back(std::thread([&]
+		{
+			while (true)
+			{
+				u32 i;
+				{
+					std::unique_lock<std::mutex> lk(lock);
+					while (!failed && num_claimed == num_read && num_claimed < num_blocks)
+						cond.wait(lk);
+					if (failed || num_claimed == num_blocks)
+						return;
+					i = num_claimed++;
+				}
+
+				const bool ok = process(i, i % num_slots);
+
+				std::lock_guard<std::mutex> lk(lock);
+				if (ok)
+					processed[i % num_slots] = true;
+				else
+					failed = true;
+				cond.notify_all();
+			}
+		}));
+	}
+
+	for (u32 i = 0; i < num_blocks; i++)
+	{
+		{
+			std::unique_lock<std::mutex> lk(lock);
+			while (!failed && !processed[i % num_slots])
+				cond.wait(lk);
+			if (failed)
+				break;
+		}
+
+		const bool ok = write(i, i % num_slots);
+
+		std::lock_guard<std::mutex> lk(lock);
+		processed[i % num_slots] = false;
+		if (ok)
+			num_written++;
+		else
+			failed = true;
+		cond.notify_all();
+		if (!ok)
+			break;
+	}
+
+	reader.join();
+	for (auto& worker : workers)
+		worker.join();
+
+	return !failed;
+}
+
+inline u32 GetNumPipelineWorkers()
+{
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+}  // namespace
@@ -0,0 +1,492 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+#include "BlobPipeline.h"
+#include "ChunkedBlob.h"
+#include "DiscScrubber.h"
+#include "FileUtil.h"
+#include "Hash.h"
+#include "ThreadPool.h"
+#include "VolumeCreator.h"
+
+#include "zlib.h"
+
+namespace DiscIO
+{
+
+static const u32 CLUSTER_SIZE = 0x8000;
+static const u32 CLUSTER_HASH_SIZE = 0x400;
+
+// Chunks up to this size are compressed with a dictionary
+static const u32 DICTIONARY_MAX_CHUNK_SIZE = 0x20000;
+// zlib only looks back this far
+static const u32 DICTIONARY_SIZE = 0x8000;
+static const u32 DICTIONARY_SAMPLES = 32;
+
+// The hash block of a cluster is encrypted with a zero IV, the data with
+// bytes 0x3d0-0x3e0 of the encrypted hash block.
+static void DecryptCluster(aes_context* ctx, u8* cluster)
+{
+	u8 data_iv[16];
+	memcpy(data_iv, cluster + 0x3d0, 16);
+	u8 hash_iv[16] = {};
+	aes_crypt_cbc(ctx, AES_DECRYPT, CLUSTER_HASH_SIZE, hash_iv, cluster, cluster);
+	aes_crypt_cbc(ctx, AES_DECRYPT, CLUSTER_SIZE - CLUSTER_HASH_SIZE, data_iv,
+		cluster + CLUSTER_HASH_SIZE, cluster + CLUSTER_HASH_SIZE);
+}
+
+static void EncryptCluster(aes_context* ctx, u8* cluster)
+{
+	u8 hash_iv[16] = {};
+	aes_crypt_cbc(ctx, AES_ENCRYPT, CLUSTER_HASH_SIZE, hash_iv, cluster, cluster);
+	u8 data_iv[16];
+	memcpy(data_iv, cluster + 0x3d0, 16);
+	aes_crypt_cbc(ctx, AES_ENCRYPT, CLUSTER_SIZE - CLUSTER_HASH_SIZE, data_iv,
+		cluster + CLUSTER_HASH_SIZE, cluster + CLUSTER_HASH_SIZE);
+}
+
+ChunkedBlobReader::ChunkedBlobReader(const char* filename) : m_file_name(filename)
+{
+	m_file.Open(filename, "rb");
+	m_file_size = File::GetSize(filename);
+	m_file.ReadArray(&m_header, 1);
+
+	m_partitions.resize(m_header.num_partitions);
+	m_file.ReadArray(m_partitions.data(), m_partitions.size());
+	m_dictionary.resize(m_header.dictionary_size);
+	m_file.ReadBytes(m_dictionary.data(), m_dictionary.size());
+	m_chunks.resize(m_header.num_chunks);
+	m_file.ReadArray(m_chunks.data(), m_chunks.size());
+
+	m_data_offset = sizeof(ChunkedBlobHeader)
+		+ sizeof(ChunkedBlobPartition) * m_header.num_partitions
+		+ m_header.dictionary_size
+		+ sizeof(ChunkedBlobChunk) * m_header.num_chunks;
+
+	m_partition_keys.resize(m_partitions.size());
+	for (size_t i = 0; i < m_partitions.size(); i++)
+		aes_setkey_enc(&m_partition_keys[i], m_partitions[i].title_key, 128);
+
+	SetSectorSize(m_header.chunk_size);
+
+	// Read ahead far enough to keep every worker decoding a chunk
+	const u32 batch = Common::ThreadPool::GetNumWorkers() + 1;
+	SetReadaheadBatch(batch);
+	SetCacheSize(4 * batch * m_header.chunk_size, 2 * batch * m_header.chunk_size);
+}
+
+ChunkedBlobReader* ChunkedBlobReader::Create(const char* filename)
+{
+	if (IsChunkedBlob(filename))
+		return new ChunkedBlobReader(filename);
+	else
+		return 0;
+}
+
+ChunkedBlobReader::~ChunkedBlobReader()
+{
+	StopReadahead();
+}
+
+void ChunkedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
+{
+	m_raw_buffer.resize(m_header.chunk_size);
+	if (!ReadRawChunk(block_num, m_raw_buffer.data()) || !DecodeChunk(block_num, m_raw_buffer.data(), out_ptr))
+		memset(out_ptr, 0, m_header.chunk_size);
+}
+
+void ChunkedBlobReader::GetBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+	const u32 chunk_size = m_header.chunk_size;
+	if (block_num + num_blocks > m_header.num_chunks)
+	{
+		SectorReader::GetBlocks(block_num, num_blocks, out_ptr);
+		return;
+	}
+
+	// The chunks are stored one after another
+	const ChunkedBlobChunk& last = m_chunks[block_num + num_blocks - 1];
+	const u64 start = m_chunks[block_num].offset;
+	const u64 end = last.offset + last.stored_size;
+	m_raw_buffer.resize((size_t)(end - start));
+	if (end > start && (!m_file.Seek(m_data_offset + start, SEEK_SET) ||
+	                    !m_file.ReadBytes(m_raw_buffer.data(), m_raw_buffer.size())))
+	{
+		memset(out_ptr, 0, (size_t)(num_blocks * chunk_size));
+		return;
+	}
+
+	Common::ThreadPool::ParallelFor((int)num_blocks, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const u64 chunk_num = block_num + i;
+			u8* out = out_ptr + (u64)i * chunk_size;
+			if (!DecodeChunk(chunk_num, m_raw_buffer.data() + (m_chunks[chunk_num].offset - start), out))
+				memset(out, 0, chunk_size);
+		}
+	});
+}
+
+bool ChunkedBlobReader::ReadRawChunk(u64 chunk_num, u8* out_ptr)
+{
+	if (chunk_num >= m_header.num_chunks)
+		return false;
+
+	const ChunkedBlobChunk& chunk = m_chunks[chunk_num];
+	if (chunk.stored_size > m_header.chunk_size)
+		return false;
+	if (chunk.stored_size == 0)
+		return true;
+	return m_file.Seek(m_data_offset + chunk.offset, SEEK_SET) && m_file.ReadBytes(out_ptr, chunk.stored_size);
+}
+
+bool ChunkedBlobReader::DecodeChunk(u64 chunk_num, const u8* source, u8* out_ptr) const
+{
+	const ChunkedBlobChunk& chunk = m_chunks[chunk_num];
+	const u32 chunk_size = m_header.chunk_size;
+
+	if (chunk.flags & CHUNK_ZERO)
+	{
+		memset(out_ptr, 0, chunk_size);
+		return true;
+	}
+
+	const u32 hash = HashAdler32(source, chunk.stored_size);
+	if (hash != chunk.hash)
+	{
+		PanicAlert("Hash of chunk %" PRIu64 " is %08x instead of %08x.\n"
+		           "Your ISO, %s, is corrupt.",
+		           chunk_num, hash, chunk.hash, m_file_name.c_str());
+		return false;
+	}
+
+	if (chunk.flags & CHUNK_COMPRESSED)
+	{
+		z_stream z;
+		memset(&z, 0, sizeof(z));
+		z.next_in   = const_cast<u8*>(source);
+		z.avail_in  = chunk.stored_size;
+		z.next_out  = out_ptr;
+		z.avail_out = chunk_size;
+		inflateInit(&z);
+		int status = inflate(&z, Z_FINISH);
+		if (status == Z_NEED_DICT && !m_dictionary.empty())
+		{
+			inflateSetDictionary(&z, m_dictionary.data(), (uInt)m_dictionary.size());
+			status = inflate(&z, Z_FINISH);
+		}
+		const bool complete = status == Z_STREAM_END && z.avail_out == 0;
+		inflateEnd(&z);
+		if (!complete)
+		{
+			PanicAlert("Failure reading chunk %" PRIu64 " of %s.", chunk_num, m_file_name.c_str());
+			return false;
+		}
+	}
+	else
+	{
+		if (chunk.stored_size != chunk_size)
+			return false;
+		memcpy(out_ptr, source, chunk_size);
+	}
+
+	if (chunk.flags & CHUNK_DECRYPTED)
+	{
+		if (chunk.partition >= m_partition_keys.size())
+			return false;
+
+		// aes_crypt_cbc only reads the key schedule
+		aes_context* ctx = const_cast<aes_context*>(&m_partition_keys[chunk.partition]);
+		for (u32 i = 0; i < chunk_size; i += CLUSTER_SIZE)
+			EncryptCluster(ctx, out_ptr + i);
+	}
+
+	return true;
+}
+
+// The partitions whose data can be stored decrypted
+static std::vector<ChunkedBlobPartition> FindWiiPartitions(IBlobReader& reader)
+{
+	std::vector<ChunkedBlobPartition> partitions;
+
+	u32 wii_magic = 0, container_magic = 0;
+	reader.Read(0x18, 4, (u8*)&wii_magic);
+	reader.Read(0x60, 4, (u8*)&container_magic);
+	if (Common::swap32(wii_magic) != 0x5D1C9EA3 || container_magic != 0)
+		return partitions;
+
+	for (u64 offset : GetWiiPartitionOffsets(reader))
+	{
+		u32 data_offset = 0, data_size = 0;
+		if (!reader.Read(offset + 0x2b8, 4, (u8*)&data_offset) || !reader.Read(offset + 0x2bc, 4, (u8*)&data_size))
+			continue;
+
+		ChunkedBlobPartition partition;
+		partition.data_offset = offset + ((u64)Common::swap32(data_offset) << 2);
+		partition.data_size = (u64)Common::swap32(data_size) << 2;
+		if (partition.data_size == 0 || partition.data_offset % CLUSTER_SIZE != 0 ||
+		    partition.data_offset + partition.data_size > reader.GetDataSize())
+			continue;
+
+		GetWiiPartitionKey(reader, offset, partition.title_key);
+		partitions.push_back(partition);
+	}
+	return partitions;
+}
+
+// Decrypts the chunk at offset if it is part of a partition and returns its flags
+static u32 PrepareChunk(u8* data, u64 offset, u32 chunk_size,
+	const std::vector<ChunkedBlobPartition>& partitions, const std::vector<aes_context>& keys,
+	const ScrubbedBlobReader* scrubbed, u32* partition)
+{
+	*partition = 0;
+	if (std::all_of(data, data + chunk_size, [](u8 b) { return b == 0; }))
+		return CHUNK_ZERO;
+
+	for (u32 i = 0; i < partitions.size(); i++)
+	{
+		const ChunkedBlobPartition& p = partitions[i];
+		if (offset < p.data_offset || offset + chunk_size > p.data_offset + p.data_size)
+			continue;
+
+		// Unused clusters are stored as zeroes and come back as zeroes encrypted
+		aes_context* ctx = const_cast<aes_context*>(&keys[i]);
+		for (u32 j = 0; j < chunk_size; j += CLUSTER_SIZE)
+		{
+			if (scrubbed && scrubbed->IsClusterFree(offset + j))
+				memset(data + j, 0, CLUSTER_SIZE);
+			else
+				DecryptCluster(ctx, data + j);
+		}
+		*partition = i;
+		return CHUNK_DECRYPTED;
+	}
+	return 0;
+}
+
+bool CompressFileToChunkedBlob(const char* infile, const char* outfile, bool scrub, u32 chunk_size,
+						CompressCB callback, void* arg)
+{
+	if (IsChunkedBlob(infile))
+	{
+		PanicAlertT("%s is already compressed! Cannot compress it further.", infile);
+		return false;
+	}
+
+	// Only Wii discs can be scrubbed, others are compressed as they are
+	ScrubbedBlobReader* scrubbed = scrub ? ScrubbedBlobReader::Create(infile, 0) : NULL;
+	std::unique_ptr<IBlobReader> reader(scrubbed ? scrubbed : CreateBlobReader(infile));
+	File::IOFile f(outfile, "wb");
+
+	if (!f || !reader)
+		return false;
+
+	callback("Files opened, ready to compress.", 0, arg);
+
+	chunk_size = std::max<u32>((chunk_size + CLUSTER_SIZE - 1) / CLUSTER_SIZE, 1) * CLUSTER_SIZE;
+
+	ChunkedBlobHeader header;
+	header.magic_cookie = kChunkedBlobCookie;
+	header.version      = kChunkedBlobVersion;
+	header.data_size    = reader->GetDataSize();
+	header.chunk_size   = chunk_size;
+	header.num_chunks   = (u32)((header.data_size + chunk_size - 1) / chunk_size);
+
+	const std::vector<ChunkedBlobPartition> partitions = FindWiiPartitions(*reader);
+	std::vector<aes_context> keys(partitions.size());
+	for (size_t i = 0; i < partitions.size(); i++)
+		aes_setkey_dec(&keys[i], partitions[i].title_key, 128);
+	header.num_partitions = (u32)partitions.size();
+
+	auto read_chunk = [&](u32 i, u8* buf)
+	{
+		const u64 offset = (u64)i * chunk_size;
+		const u64 size = std::min<u64>(chunk_size, header.data_size - offset);
+		std::fill(buf + size, buf + chunk_size, 0);
+		return reader->Read(offset, size, buf);
+	};
+
+	// Pieces of evenly spread chunks, with their partitions decrypted
+	std::vector<u8> dictionary;
+	if (chunk_size <= DICTIONARY_MAX_CHUNK_SIZE)
+	{
+		const u32 num_samples = std::min(DICTIONARY_SAMPLES, header.num_chunks);
+		const u32 sample_size = DICTIONARY_SIZE / DICTIONARY_SAMPLES;
+		std::vector<u8> buf(chunk_size);
+		for (u32 s = 0; s < num_samples; s++)
+		{
+			const u32 i = (u32)((u64)s * header.num_chunks / num_samples);
+			u32 partition;
+			if (!read_chunk(i, buf.data()) ||
+			    PrepareChunk(buf.data(), (u64)i * chunk_size, chunk_size, partitions, keys, scrubbed, &partition) == CHUNK_ZERO)
+				continue;
+			const u8* sample = buf.data() + (chunk_size - sample_size) / 2;
+			dictionary.insert(dictionary.end(), sample, sample + sample_size);
+		}
+	}
+	header.dictionary_size = (u32)dictionary.size();
+
+	const u32 num_workers = GetNumPipelineWorkers();
+	const u32 num_slots = num_workers * 4;
+	std::vector<ChunkedBlobChunk> chunks(header.num_chunks);
+	std::vector<std::vector<u8>> in_bufs(num_slots, std::vector<u8>(chunk_size));
+	std::vector<std::vector<u8>> out_bufs(num_slots, std::vector<u8>(chunk_size));
+
+	// seek past the header, partitions, dictionary and chunk table (we will write them at the end)
+	f.Seek(sizeof(ChunkedBlobHeader) + sizeof(ChunkedBlobPartition) * partitions.size() +
+		dictionary.size() + sizeof(ChunkedBlobChunk) * chunks.size(), SEEK_SET);
+
+	u64 position = 0;
+	int progress_monitor = std::max<int>(1, header.num_chunks / 1000);
+
+	auto read_block = [&](u32 i, u32 slot)
+	{
+		return read_chunk(i, in_bufs[slot].data());
+	};
+
+	// Blocks that won't compress to less than 97% of the original size are stored as-is.
+	auto compress_block = [&](u32 i, u32 slot)
+	{
+		ChunkedBlobChunk& chunk = chunks[i];
+		u8* in_buf = in_bufs[slot].data();
+		u8* out_buf = out_bufs[slot].data();
+		chunk.flags = PrepareChunk(in_buf, (u64)i * chunk_size, chunk_size, partitions, keys, scrubbed, &chunk.partition);
+		chunk.stored_size = 0;
+		chunk.hash = 0;
+		if (chunk.flags & CHUNK_ZERO)
+			return true;
+
+		z_stream z;
+		memset(&z, 0, sizeof(z));
+		z.next_in   = in_buf;
+		z.avail_in  = chunk_size;
+		z.next_out  = out_buf;
+		z.avail_out = chunk_size;
+		if (deflateInit(&z, 9) != Z_OK ||
+		    (!dictionary.empty() && deflateSetDictionary(&z, dictionary.data(), (uInt)dictionary.size()) != Z_OK))
+		{
+			ERROR_LOG(DISCIO, "Deflate failed");
+			deflateEnd(&z);
+			return false;
+		}
+
+		const int status = deflate(&z, Z_FINISH);
+		const u32 comp_size = chunk_size - z.avail_out;
+		if (status == Z_STREAM_END && comp_size < chunk_size / 100 * 97)
+		{
+			chunk.flags |= CHUNK_COMPRESSED;
+			chunk.stored_size = comp_size;
+			chunk.hash = HashAdler32(out_buf, comp_size);
+		}
+		else
+		{
+			chunk.stored_size = chunk_size;
+			chunk.hash = HashAdler32(in_buf, chunk_size);
+		}
+
+		deflateEnd(&z);
+		return true;
+	};
+
+	auto write_block = [&](u32 i, u32 slot)
+	{
+		if (i % progress_monitor == 0)
+		{
+			const u64 inpos = (u64)i * chunk_size;
+			int ratio = 0;
+			if (inpos != 0)
+				ratio = (int)(100 * position / inpos);
+			char temp[512];
+			sprintf(temp, "%i of %i chunks. Compression ratio %i%%", i, header.num_chunks, ratio);
+			callback(temp, (float)i / (float)header.num_chunks, arg);
+		}
+
+		ChunkedBlobChunk& chunk = chunks[i];
+		chunk.offset = position;
+		const u8* data = (chunk.flags & CHUNK_COMPRESSED) ? out_bufs[slot].data() : in_bufs[slot].data();
+		if (chunk.stored_size && !f.WriteBytes(data, chunk.stored_size))
+			return false;
+		position += chunk.stored_size;
+		return true;
+	};
+
+	const bool success = RunBlockPipeline(header.num_chunks, num_slots, num_workers,
+		read_block, compress_block, write_block);
+
+	if (success)
+	{
+		// Okay, go back and fill in headers
+		f.Seek(0, SEEK_SET);
+		f.WriteArray(&header, 1);
+		f.WriteArray(partitions.data(), partitions.size());
+		f.WriteBytes(dictionary.data(), dictionary.size());
+		f.WriteArray(chunks.data(), chunks.size());
+	}
+
+	callback("Done compressing disc image.", 1.0f, arg);
+	return success && f.IsGood();
+}
+
+bool DecompressChunkedBlobToFile(const char* infile, const char* outfile, CompressCB callback, void* arg)
+{
+	std::unique_ptr<ChunkedBlobReader> reader(ChunkedBlobReader::Create(infile));
+	if (!reader)
+	{
+		PanicAlertT("File not compressed");
+		return false;
+	}
+
+	File::IOFile f(outfile, "wb");
+	if (!f)
+		return false;
+
+	const ChunkedBlobHeader& header = reader->GetHeader();
+	const u32 num_workers = GetNumPipelineWorkers();
+	const u32 num_slots = num_workers * 4;
+	std::vector<std::vector<u8>> raw_bufs(num_slots, std::vector<u8>(header.chunk_size));
+	std::vector<std::vector<u8>> out_bufs(num_slots, std::vector<u8>(header.chunk_size));
+	int progress_monitor = std::max<int>(1, header.num_chunks / 100);
+
+	auto read_block = [&](u32 i, u32 slot)
+	{
+		return reader->ReadRawChunk(i, raw_bufs[slot].data());
+	};
+
+	auto decompress_block = [&](u32 i, u32 slot)
+	{
+		return reader->DecodeChunk(i, raw_bufs[slot].data(), out_bufs[slot].data());
+	};
+
+	auto write_block = [&](u32 i, u32 slot)
+	{
+		if (i % progress_monitor == 0)
+		{
+			callback("Unpacking", (float)i / (float)header.num_chunks, arg);
+		}
+		return f.WriteBytes(out_bufs[slot].data(), header.chunk_size);
+	};
+
+	const bool success = RunBlockPipeline(header.num_chunks, num_slots, num_workers,
+		read_block, decompress_block, write_block);
+
+	f.Resize(header.data_size);
+	return success;
+}
+
+bool IsChunkedBlob(const char* filename)
+{
+	File::IOFile f(filename, "rb");
+
+	ChunkedBlobHeader header;
+	return f.ReadArray(&header, 1) && header.magic_cookie == kChunkedBlobCookie &&
+		header.version == kChunkedBlobVersion;
+}
+
+}  // namespace
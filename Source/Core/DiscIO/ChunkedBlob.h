@@ -0,0 +1,120 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+
+// WARNING Code not big-endian safe.
+
+// To create new chunked BLOBs, use CompressFileToChunkedBlob.
+
+// File format
+// * Header
+// * [Wii partitions]
+// * [Dictionary]
+// * [Chunks]
+// * [Data]
+
+// Unlike GCZ, chunks are large, so they compress better and are decompressed
+// several at a time when reading ahead. Chunks inside the data of a Wii
+// partition are stored decrypted, which lets them compress at all, and are
+// encrypted again when they are read. Small chunks are compressed with a
+// dictionary sampled from the whole image.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <polarssl/aes.h>
+
+#include "Blob.h"
+#include "FileUtil.h"
+
+namespace DiscIO
+{
+
+bool IsChunkedBlob(const char* filename);
+
+const u32 kChunkedBlobCookie = 0xB10BC0DE;
+const u32 kChunkedBlobVersion = 1;
+
+struct ChunkedBlobHeader // 32 bytes
+{
+	u32 magic_cookie; // kChunkedBlobCookie
+	u32 version;
+	u64 data_size;
+	u32 chunk_size; // a multiple of the 0x8000 byte Wii cluster size
+	u32 num_chunks;
+	u32 dictionary_size;
+	u32 num_partitions;
+};
+
+// The data of a Wii partition, which is made of 0x8000 byte encrypted clusters
+struct ChunkedBlobPartition // 32 bytes
+{
+	u64 data_offset;
+	u64 data_size;
+	u8 title_key[16];
+};
+
+enum
+{
+	CHUNK_COMPRESSED = 1,
+	// The clusters of the chunk are stored decrypted with the key of its partition
+	CHUNK_DECRYPTED  = 2,
+	// The chunk is all zeroes and isn't stored
+	CHUNK_ZERO       = 4,
+};
+
+struct ChunkedBlobChunk // 24 bytes
+{
+	u64 offset; // from the start of the data
+	u32 stored_size;
+	u32 hash; // Adler32 of the stored bytes
+	u32 flags;
+	u32 partition;
+};
+
+class ChunkedBlobReader : public SectorReader
+{
+public:
+	static ChunkedBlobReader* Create(const char* filename);
+	~ChunkedBlobReader();
+	const ChunkedBlobHeader& GetHeader() const { return m_header; }
+	u64 GetDataSize() const { return m_header.data_size; }
+	u64 GetRawSize() const { return m_file_size; }
+	void GetBlock(u64 block_num, u8* out_ptr);
+
+	// Reads the stored bytes of a chunk into a buffer of chunk_size bytes. Not thread-safe.
+	bool ReadRawChunk(u64 chunk_num, u8* out_ptr);
+	// Checks, decompresses and encrypts a chunk read by ReadRawChunk. Can be called from any thread.
+	bool DecodeChunk(u64 chunk_num, const u8* source, u8* out_ptr) const;
+
+protected:
+	// Reads the stored chunks in one go and decodes them in parallel
+	void GetBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
+
+private:
+	ChunkedBlobReader(const char* filename);
+
+	ChunkedBlobHeader m_header;
+	std::vector<ChunkedBlobPartition> m_partitions;
+	// Encryption key schedules of m_partitions, only read once set up
+	std::vector<aes_context> m_partition_keys;
+	std::vector<u8> m_dictionary;
+	std::vector<ChunkedBlobChunk> m_chunks;
+	u64 m_data_offset;
+	File::IOFile m_file;
+	u64 m_file_size;
+	std::vector<u8> m_raw_buffer;
+	std::string m_file_name;
+};
+
+// Chunk sizes are rounded up to a multiple of 0x8000 bytes. Scrubbing stores
+// the clusters of a Wii disc that nothing uses as zeroes, without reading them.
+bool CompressFileToChunkedBlob(const char* infile, const char* outfile, bool scrub = false, u32 chunk_size = 0x40000,
+		CompressCB callback = 0, void* arg = 0);
+bool DecompressChunkedBlobToFile(const char* infile, const char* outfile,
+		CompressCB callback = 0, void* arg = 0);
+
+}  // namespace
@@ -9,8 +9,12 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cinttypes>
+#include <vector>
 
+#include "BlobPipeline.h"
+#include "ChunkedBlob.h"
 #include "CompressedBlob.h"
 #include "DiscScrubber.h"
 #include "FileUtil.h"
@@ -56,6 +60,7 @@ CompressedBlobReader* CompressedBlobReader::Create(const char* filename)
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+	StopReadahead();
 	delete [] zlib_buffer;
 	delete [] block_pointers;
 	delete [] hashes;
@@ -76,7 +81,18 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 
 void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 {
-	bool uncompressed = false;
+	bool uncompressed;
+	u32 comp_block_size = ReadRawBlock(block_num, zlib_buffer, &uncompressed);
+
+	// clear unused part of zlib buffer. maybe this can be deleted when it works fully.
+	memset(zlib_buffer + comp_block_size, 0, zlib_buffer_size - comp_block_size);
+
+	DecodeBlock(block_num, zlib_buffer, comp_block_size, uncompressed, out_ptr);
+}
+
+u32 CompressedBlobReader::ReadRawBlock(u64 block_num, u8 *out_ptr, bool *uncompressed)
+{
+	*uncompressed = false;
 	u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
 	u64 offset = block_pointers[block_num] + data_offset;
 
@@ -84,17 +100,18 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	{
 		if (comp_block_size != header.block_size)
 			PanicAlert("Uncompressed block with wrong size");
-		uncompressed = true;
+		*uncompressed = true;
 		offset &= ~(1ULL << 63);
 	}
 
-	// clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-	memset(zlib_buffer + comp_block_size, 0, zlib_buffer_size - comp_block_size);
-
 	m_file.Seek(offset, SEEK_SET);
-	m_file.ReadBytes(zlib_buffer, comp_block_size);
+	if (!m_file.ReadBytes(out_ptr, comp_block_size))
+		return 0;
+	return comp_block_size;
+}
 
-	u8* source = zlib_buffer;
+void CompressedBlobReader::DecodeBlock(u64 block_num, const u8 *source, u32 comp_block_size, bool uncompressed, u8 *out_ptr) const
+{
 	u8* dest = out_ptr;
 
 	// First, check hash.
@@ -113,7 +130,7 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	{
 		z_stream z;
 		memset(&z, 0, sizeof(z));
-		z.next_in  = source;
+		z.next_in  = const_cast<u8*>(source);
 		z.avail_in = comp_block_size;
 		if (z.avail_in > header.block_size)
 		{
@@ -175,10 +192,14 @@ bool CompressFileToBlob(const char* infile, const char* outfile, u32 sub_type,
 	// round upwards!
 	header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
-	u64* offsets = new u64[header.num_blocks];
-	u32* hashes = new u32[header.num_blocks];
-	u8* out_buf = new u8[block_size];
-	u8* in_buf = new u8[block_size];
+	const u32 num_workers = GetNumPipelineWorkers();
+	const u32 num_slots = num_workers * 4;
+	std::vector<u64> offsets(header.num_blocks);
+	std::vector<u32> hashes(header.num_blocks);
+	std::vector<std::vector<u8>> in_bufs(num_slots, std::vector<u8>(block_size));
+	std::vector<std::vector<u8>> out_bufs(num_slots, std::vector<u8>(block_size));
+	std::vector<int> comp_sizes(num_slots);
+	std::vector<u32> slot_hashes(num_slots);
 
 	// seek past the header (we will write it at the end)
 	f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -191,91 +212,112 @@ bool CompressFileToBlob(const char* infile, const char* outfile, u32 sub_type,
 	int num_stored = 0;
 	int progress_monitor = max<int>(1, header.num_blocks / 1000);
 
-	for (u32 i = 0; i < header.num_blocks; i++)
+	// The scrubber has to see the blocks in order, so they are read on a single thread.
+	auto read_block = [&](u32 i, u32 slot)
 	{
-		if (i % progress_monitor == 0)
-		{
-			const u64 inpos = inf.Tell();
-			int ratio = 0;
-			if (inpos != 0)
-				ratio = (int)(100 * position / inpos);
-			char temp[512];
-			sprintf(temp, "%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
-			callback(temp, (float)i / (float)header.num_blocks, arg);
-		}
-
-		offsets[i] = position;
-		// u64 start = i * header.block_size;
-		// u64 size = header.block_size;
+		u8* in_buf = in_bufs[slot].data();
 		std::fill(in_buf, in_buf + header.block_size, 0);
 		if (scrubbing)
 			DiscScrubber::GetNextBlock(inf, in_buf);
 		else
 			inf.ReadBytes(in_buf, header.block_size);
+		return true;
+	};
+
+	// A comp_size of -1 means the block doesn't compress and is stored as-is.
+	auto compress_block = [&](u32 i, u32 slot)
+	{
 		z_stream z;
 		memset(&z, 0, sizeof(z));
 		z.zalloc = Z_NULL;
 		z.zfree  = Z_NULL;
 		z.opaque = Z_NULL;
-		z.next_in   = in_buf;
+		z.next_in   = in_bufs[slot].data();
 		z.avail_in  = header.block_size;
-		z.next_out  = out_buf;
+		z.next_out  = out_bufs[slot].data();
 		z.avail_out = block_size;
 		int retval = deflateInit(&z, 9);
 
 		if (retval != Z_OK)
 		{
 			ERROR_LOG(DISCIO, "Deflate failed");
-			goto cleanup;
+			return false;
 		}
 
 		int status = deflate(&z, Z_FINISH);
 		int comp_size = block_size - z.avail_out;
 		if ((status != Z_STREAM_END) || (z.avail_out < 10))
 		{
-			//PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
+			comp_sizes[slot] = -1;
+			slot_hashes[slot] = HashAdler32(in_bufs[slot].data(), block_size);
+		}
+		else
+		{
+			comp_sizes[slot] = comp_size;
+			slot_hashes[slot] = HashAdler32(out_bufs[slot].data(), comp_size);
+		}
+
+		deflateEnd(&z);
+		return true;
+	};
+
+	auto write_block = [&](u32 i, u32 slot)
+	{
+		if (i % progress_monitor == 0)
+		{
+			const u64 inpos = (u64)i * header.block_size;
+			int ratio = 0;
+			if (inpos != 0)
+				ratio = (int)(100 * position / inpos);
+			char temp[512];
+			sprintf(temp, "%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
+			callback(temp, (float)i / (float)header.num_blocks, arg);
+		}
+
+		offsets[i] = position;
+		hashes[i] = slot_hashes[slot];
+		if (comp_sizes[slot] < 0)
+		{
 			// let's store uncompressed
 			offsets[i] |= 0x8000000000000000ULL;
-			f.WriteBytes(in_buf, block_size);
-			hashes[i] = HashAdler32(in_buf, block_size);
+			f.WriteBytes(in_bufs[slot].data(), block_size);
 			position += block_size;
 			num_stored++;
 		}
 		else
 		{
 			// let's store compressed
-			//PanicAlert("Comp %i to %i", block_size, comp_size);
-			f.WriteBytes(out_buf, comp_size);
-			hashes[i] = HashAdler32(out_buf, comp_size);
-			position += comp_size;
+			f.WriteBytes(out_bufs[slot].data(), comp_sizes[slot]);
+			position += comp_sizes[slot];
 			num_compressed++;
 		}
+		return true;
+	};
 
-		deflateEnd(&z);
-	}
-
-	header.compressed_data_size = position;
+	const bool success = RunBlockPipeline(header.num_blocks, num_slots, num_workers,
+		read_block, compress_block, write_block);
 
-	// Okay, go back and fill in headers
-	f.Seek(0, SEEK_SET);
-	f.WriteArray(&header, 1);
-	f.WriteArray(offsets, header.num_blocks);
-	f.WriteArray(hashes, header.num_blocks);
+	if (success)
+	{
+		header.compressed_data_size = position;
 
-cleanup:
-	// Cleanup
-	delete[] in_buf;
-	delete[] out_buf;
-	delete[] offsets;
-	delete[] hashes;
+		// Okay, go back and fill in headers
+		f.Seek(0, SEEK_SET);
+		f.WriteArray(&header, 1);
+		f.WriteArray(offsets.data(), header.num_blocks);
+		f.WriteArray(hashes.data(), header.num_blocks);
+	}
 
 	DiscScrubber::Cleanup();
 	callback("Done compressing disc image.", 1.0f, arg);
-	return true;
+	return success;
 }
 
 bool DecompressBlobToFile(const char* infile, const char* outfile, CompressCB callback, void* arg)
 {
+	if (IsChunkedBlob(infile))
+		return DecompressChunkedBlobToFile(infile, outfile, callback, arg);
+
 	if (!IsCompressedBlob(infile))
 	{
 		PanicAlertT("File not compressed");
@@ -294,26 +336,50 @@ bool DecompressBlobToFile(const char* infile, const char* outfile, CompressCB ca
 	}
 
 	const CompressedBlobHeader &header = reader->GetHeader();
-	u8* buffer = new u8[header.block_size];
+	const u32 num_workers = GetNumPipelineWorkers();
+	const u32 num_slots = num_workers * 4;
+	std::vector<std::vector<u8>> raw_bufs(num_slots, std::vector<u8>(header.block_size));
+	std::vector<std::vector<u8>> out_bufs(num_slots, std::vector<u8>(header.block_size));
+	std::vector<u32> raw_sizes(num_slots);
+	// Not a vector<bool>, the reader writes one slot while workers read others
+	std::vector<u8> raw_uncompressed(num_slots);
 	int progress_monitor = max<int>(1, header.num_blocks / 100);
 
-	for (u64 i = 0; i < header.num_blocks; i++)
+	auto read_block = [&](u32 i, u32 slot)
+	{
+		bool uncompressed;
+		raw_sizes[slot] = reader->ReadRawBlock(i, raw_bufs[slot].data(), &uncompressed);
+		raw_uncompressed[slot] = uncompressed;
+		return raw_sizes[slot] != 0;
+	};
+
+	auto decompress_block = [&](u32 i, u32 slot)
+	{
+		reader->DecodeBlock(i, raw_bufs[slot].data(), raw_sizes[slot], raw_uncompressed[slot] != 0, out_bufs[slot].data());
+		return true;
+	};
+
+	auto write_block = [&](u32 i, u32 slot)
 	{
 		if (i % progress_monitor == 0)
 		{
 			callback("Unpacking", (float)i / (float)header.num_blocks, arg);
 		}
-		reader->Read(i * header.block_size, header.block_size, buffer);
-		f.WriteBytes(buffer, header.block_size);
-	}
+		return f.WriteBytes(out_bufs[slot].data(), header.block_size);
+	};
 
-	delete[] buffer;
-
-	f.Resize(header.data_size);
+	const bool success = RunBlockPipeline(header.num_blocks, num_slots, num_workers,
+		read_block, decompress_block, write_block) && f.Resize(header.data_size);
 
 	delete reader;
 
-	return true;
+	// Don't leave a truncated image behind
+	if (!success)
+	{
+		f.Close();
+		File::Delete(outfile);
+	}
+	return success;
 }
 
 bool IsCompressedBlob(const char* filename)
@@ -52,6 +52,12 @@ public:
 	u64 GetRawSize() const { return file_size; }
 	u64 GetBlockCompressedSize(u64 block_num) const;
 	void GetBlock(u64 block_num, u8 *out_ptr);
+
+	// Reads the stored bytes of a block and returns their size, or 0 if they
+	// couldn't be read. Not thread-safe.
+	u32 ReadRawBlock(u64 block_num, u8 *out_ptr, bool *uncompressed);
+	// Checks and inflates a block read by ReadRawBlock. Can be called from any thread.
+	void DecodeBlock(u64 block_num, const u8 *source, u32 comp_block_size, bool uncompressed, u8 *out_ptr) const;
 private:
 	CompressedBlobReader(const char *filename);
 
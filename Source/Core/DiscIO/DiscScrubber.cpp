@@ -7,7 +7,9 @@
 #include "FileUtil.h"
 #include "DiscScrubber.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <memory>
 
 namespace DiscIO
 {
@@ -89,6 +91,8 @@ bool SetupScrub(const char* filename, int block_size)
 	m_BlocksPerCluster = CLUSTER_SIZE / m_BlockSize;
 
 	m_Disc = CreateVolumeFromFilename(filename);
+	if (!m_Disc)
+		return false;
 	m_FileSize = m_Disc->GetSize();
 
 	u32 numClusters = (u32)(m_FileSize / CLUSTER_SIZE);
@@ -332,6 +336,22 @@ bool ParsePartitionData(SPartition& _rPartition)
 	return ParsedOK;
 }
 
+bool GetFreeClusters(const char* filename, std::vector<bool>* free_clusters)
+{
+	// The partition table of anything else is garbage
+	std::unique_ptr<IVolume> Volume(CreateVolumeFromFilename(filename));
+	if (!Volume || !IsVolumeWiiDisc(Volume.get()))
+		return false;
+	Volume.reset();
+
+	if (!SetupScrub(filename, CLUSTER_SIZE))
+		return false;
+
+	free_clusters->assign(m_FreeTable, m_FreeTable + m_FileSize / CLUSTER_SIZE);
+	Cleanup();
+	return true;
+}
+
 u32 GetDOLSize(u64 _DOLOffset)
 {
 	u32 offset = 0, size = 0, max = 0;
@@ -359,4 +379,52 @@ u32 GetDOLSize(u64 _DOLOffset)
 
 } // namespace DiscScrubber
 
+ScrubbedBlobReader::ScrubbedBlobReader(IBlobReader* reader, std::vector<bool>& free_clusters, u8 fill)
+	: m_reader(reader), m_fill(fill)
+{
+	m_free_clusters.swap(free_clusters);
+}
+
+ScrubbedBlobReader* ScrubbedBlobReader::Create(const char* filename, u8 fill)
+{
+	std::vector<bool> free_clusters;
+	if (!DiscScrubber::GetFreeClusters(filename, &free_clusters))
+		return NULL;
+
+	IBlobReader* reader = CreateBlobReader(filename);
+	if (!reader)
+		return NULL;
+	return new ScrubbedBlobReader(reader, free_clusters, fill);
+}
+
+bool ScrubbedBlobReader::IsClusterFree(u64 offset) const
+{
+	const u64 cluster = offset / CLUSTER_SIZE;
+	return cluster < m_free_clusters.size() && m_free_clusters[cluster];
+}
+
+bool ScrubbedBlobReader::Read(u64 offset, u64 size, u8* out_ptr)
+{
+	while (size > 0)
+	{
+		// Runs of clusters that are all free or all used
+		const bool free = IsClusterFree(offset);
+		u64 end = offset;
+		do
+			end = (end / CLUSTER_SIZE + 1) * CLUSTER_SIZE;
+		while (end < offset + size && IsClusterFree(end) == free);
+		const u64 length = std::min(end, offset + size) - offset;
+
+		if (free)
+			std::fill(out_ptr, out_ptr + length, m_fill);
+		else if (!m_reader->Read(offset, length, out_ptr))
+			return false;
+
+		offset += length;
+		out_ptr += length;
+		size -= length;
+	}
+	return true;
+}
+
 } // namespace DiscIO
@@ -13,8 +13,12 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "CommonTypes.h"
 #include "Blob.h"
+#include "FileUtil.h"
 
 
 namespace DiscIO
@@ -27,6 +31,32 @@ bool SetupScrub(const char* filename, int block_size);
 void GetNextBlock(File::IOFile& in, u8* buffer);
 void Cleanup();
 
+// Finds the 0x8000 byte clusters of a Wii disc image that nothing uses.
+// Fails for other images.
+bool GetFreeClusters(const char* filename, std::vector<bool>* free_clusters);
+
 } // namespace DiscScrubber
 
+// Reads an image as if it had been scrubbed: the clusters that nothing uses
+// are filled with a fixed byte without reading them.
+class ScrubbedBlobReader : public IBlobReader
+{
+public:
+	// NULL if the image can't be scrubbed
+	static ScrubbedBlobReader* Create(const char* filename, u8 fill);
+
+	u64 GetRawSize() const { return m_reader->GetRawSize(); }
+	u64 GetDataSize() const { return m_reader->GetDataSize(); }
+	bool Read(u64 offset, u64 size, u8* out_ptr);
+
+	bool IsClusterFree(u64 offset) const;
+
+private:
+	ScrubbedBlobReader(IBlobReader* reader, std::vector<bool>& free_clusters, u8 fill);
+
+	std::unique_ptr<IBlobReader> m_reader;
+	std::vector<bool> m_free_clusters;
+	u8 m_fill;
+};
+
 } // namespace DiscIO
@@ -0,0 +1,286 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+#include <polarssl/aes.h>
+#include <polarssl/md5.h>
+#include <polarssl/sha1.h>
+
+#include "BlobPipeline.h"
+#include "DiscVerifier.h"
+#include "StringUtil.h"
+#include "VolumeCreator.h"
+
+#include "zlib.h"
+
+namespace DiscIO
+{
+
+static const u32 CLUSTER_SIZE = 0x8000;
+static const u32 CLUSTER_HASH_SIZE = 0x400;
+static const u32 CLUSTER_DATA_SIZE = CLUSTER_SIZE - CLUSTER_HASH_SIZE;
+static const u32 CLUSTERS_PER_SUBGROUP = 8;
+static const u32 CLUSTERS_PER_GROUP = 64;
+static const u32 GROUP_SIZE = CLUSTER_SIZE * CLUSTERS_PER_GROUP;
+static const u32 H3_TABLE_SIZE = 0x18000;
+
+// Where the hash tables are in the decrypted hash block of a cluster
+static const u32 H0_OFFSET = 0x000;
+static const u32 H0_SIZE = 31 * 20;
+static const u32 H1_OFFSET = 0x280;
+static const u32 H1_SIZE = 8 * 20;
+static const u32 H2_OFFSET = 0x340;
+static const u32 H2_SIZE = 8 * 20;
+
+struct VerifyPartition
+{
+	u64 data_offset;
+	u64 data_size;
+	u8 title_key[16];
+	std::vector<u8> h3_table;
+};
+
+// A piece of the disc that is read and hashed as a whole. Groups of Wii
+// partition data are never split, so each can be checked on its own thread.
+struct VerifyRange
+{
+	u64 offset;
+	u32 size;
+	s32 partition; // -1 outside of the data of any partition
+};
+
+static bool LoadPartition(IBlobReader& reader, u64 offset, VerifyPartition* partition)
+{
+	u32 h3_offset = 0, data_offset = 0, data_size = 0;
+	if (!reader.Read(offset + 0x2b4, 4, (u8*)&h3_offset) || !reader.Read(offset + 0x2b8, 4, (u8*)&data_offset) ||
+	    !reader.Read(offset + 0x2bc, 4, (u8*)&data_size))
+		return false;
+
+	partition->data_offset = offset + ((u64)Common::swap32(data_offset) << 2);
+	partition->data_size = (u64)Common::swap32(data_size) << 2;
+	if (partition->data_size == 0 || partition->data_offset % CLUSTER_SIZE != 0 ||
+	    partition->data_offset + partition->data_size > reader.GetDataSize() ||
+	    partition->data_size > (u64)(H3_TABLE_SIZE / 20) * GROUP_SIZE)
+		return false;
+
+	GetWiiPartitionKey(reader, offset, partition->title_key);
+	partition->h3_table.resize(H3_TABLE_SIZE);
+	return reader.Read(offset + ((u64)Common::swap32(h3_offset) << 2), H3_TABLE_SIZE, partition->h3_table.data());
+}
+
+// The hash of the H3 table is the hash of the first content in the TMD
+static bool CheckH3Table(IBlobReader& reader, u64 offset, const VerifyPartition& partition)
+{
+	u32 tmd_offset = 0;
+	u8 tmd_hash[20];
+	if (!reader.Read(offset + 0x2a8, 4, (u8*)&tmd_offset) ||
+	    !reader.Read(offset + ((u64)Common::swap32(tmd_offset) << 2) + 0x1F4, 20, tmd_hash))
+		return false;
+
+	u8 hash[20];
+	sha1(partition.h3_table.data(), H3_TABLE_SIZE, hash);
+	return memcmp(hash, tmd_hash, 20) == 0;
+}
+
+// Returns how many of the clusters of the group whose hash blocks aren't
+// padded with zeroes fail any level of the hash tree, from their data up to
+// the H3 table. The others aren't meant to be read and have no valid hashes.
+static u32 CheckGroup(const VerifyPartition& partition, const aes_context* key, u64 group, u8* data, u32 size,
+	u32* num_checked)
+{
+	const u8* h3 = &partition.h3_table[(size_t)(group * 20)];
+	u32 num_bad = 0;
+	*num_checked = 0;
+
+	for (u32 c = 0; c < size / CLUSTER_SIZE; c++)
+	{
+		u8* cluster = data + c * CLUSTER_SIZE;
+		u8 data_iv[16];
+		memcpy(data_iv, cluster + 0x3d0, 16);
+		u8 hash_iv[16] = {};
+		// Decrypting only reads the key schedule, so it is shared by the workers
+		aes_crypt_cbc(const_cast<aes_context*>(key), AES_DECRYPT, CLUSTER_HASH_SIZE, hash_iv, cluster, cluster);
+
+		if (std::any_of(cluster + 0x26C, cluster + 0x280, [](u8 b) { return b != 0; }))
+			continue;
+		(*num_checked)++;
+
+		aes_crypt_cbc(const_cast<aes_context*>(key), AES_DECRYPT, CLUSTER_DATA_SIZE, data_iv,
+			cluster + CLUSTER_HASH_SIZE, cluster + CLUSTER_HASH_SIZE);
+
+		bool good = true;
+		u8 hash[20];
+		for (u32 i = 0; i < 31 && good; i++)
+		{
+			sha1(cluster + CLUSTER_HASH_SIZE + i * 0x400, 0x400, hash);
+			good = memcmp(hash, cluster + H0_OFFSET + i * 20, 20) == 0;
+		}
+
+		sha1(cluster + H0_OFFSET, H0_SIZE, hash);
+		good = good && memcmp(hash, cluster + H1_OFFSET + (c % CLUSTERS_PER_SUBGROUP) * 20, 20) == 0;
+		sha1(cluster + H1_OFFSET, H1_SIZE, hash);
+		good = good && memcmp(hash, cluster + H2_OFFSET + (c / CLUSTERS_PER_SUBGROUP) * 20, 20) == 0;
+		sha1(cluster + H2_OFFSET, H2_SIZE, hash);
+		good = good && memcmp(hash, h3, 20) == 0;
+
+		if (!good)
+		{
+			NOTICE_LOG(DISCIO, "Verify: cluster %u of the group at %" PRIx64 " is bad",
+				c, partition.data_offset + group * GROUP_SIZE);
+			num_bad++;
+		}
+	}
+	return num_bad;
+}
+
+static void AddRanges(std::vector<VerifyRange>* ranges, u64 begin, u64 end, u32 size, s32 partition)
+{
+	for (u64 offset = begin; offset < end; offset += size)
+	{
+		VerifyRange range = { offset, (u32)std::min<u64>(size, end - offset), partition };
+		ranges->push_back(range);
+	}
+}
+
+std::string DiscVerifyResult::ToString() const
+{
+	std::string md5_string, sha1_string;
+	for (u8 b : md5)
+		md5_string += StringFromFormat("%02x", b);
+	for (u8 b : sha1)
+		sha1_string += StringFromFormat("%02x", b);
+
+	std::string text = StringFromFormat("CRC32: %08x\nMD5: %s\nSHA-1: %s\n",
+		crc32, md5_string.c_str(), sha1_string.c_str());
+	if (num_partitions)
+	{
+		text += StringFromFormat("Partitions: %u, %u with a bad H3 table\n", num_partitions, num_bad_partitions);
+		text += StringFromFormat("Clusters: %" PRIu64 " checked, %" PRIu64 " bad\n",
+			num_checked_clusters, num_bad_clusters);
+	}
+	if (!read_ok)
+		text += "The image couldn't be read to the end\n";
+	return text;
+}
+
+bool VerifyDisc(const char* filename, DiscVerifyResult* result, CompressCB callback, void* arg)
+{
+	memset(result, 0, sizeof(*result));
+
+	std::unique_ptr<IBlobReader> reader(CreateBlobReader(filename));
+	if (!reader)
+		return false;
+
+	const u64 disc_size = reader->GetDataSize();
+
+	std::vector<VerifyPartition> partitions;
+	u32 wii_magic = 0;
+	reader->Read(0x18, 4, (u8*)&wii_magic);
+	if (Common::swap32(wii_magic) == 0x5D1C9EA3)
+	{
+		for (u64 offset : GetWiiPartitionOffsets(*reader))
+		{
+			VerifyPartition partition;
+			result->num_partitions++;
+			if (!LoadPartition(*reader, offset, &partition) || !CheckH3Table(*reader, offset, partition))
+			{
+				NOTICE_LOG(DISCIO, "Verify: the partition at %" PRIx64 " doesn't match its TMD", offset);
+				result->num_bad_partitions++;
+				continue;
+			}
+			partitions.push_back(std::move(partition));
+		}
+		std::sort(partitions.begin(), partitions.end(),
+			[](const VerifyPartition& a, const VerifyPartition& b) { return a.data_offset < b.data_offset; });
+	}
+
+	// Set up in place, aes_context points into itself
+	std::vector<aes_context> keys(partitions.size());
+	for (size_t i = 0; i < partitions.size(); i++)
+		aes_setkey_dec(&keys[i], partitions[i].title_key, 128);
+
+	std::vector<VerifyRange> ranges;
+	u64 position = 0;
+	for (size_t i = 0; i < partitions.size(); i++)
+	{
+		const VerifyPartition& p = partitions[i];
+		if (p.data_offset < position)
+			continue;
+		AddRanges(&ranges, position, p.data_offset, GROUP_SIZE, -1);
+		AddRanges(&ranges, p.data_offset, p.data_offset + p.data_size, GROUP_SIZE, (s32)i);
+		position = p.data_offset + p.data_size;
+	}
+	AddRanges(&ranges, position, disc_size, GROUP_SIZE, -1);
+
+	const u32 num_workers = GetNumPipelineWorkers();
+	const u32 num_slots = num_workers * 4;
+	std::vector<std::vector<u8>> bufs(num_slots, std::vector<u8>(GROUP_SIZE));
+	std::vector<u32> crcs(num_slots), checked(num_slots), bad(num_slots);
+	const u32 progress_monitor = std::max<u32>(1, (u32)ranges.size() / 100);
+
+	md5_context md5_ctx;
+	sha1_context sha1_ctx;
+	md5_starts(&md5_ctx);
+	sha1_starts(&sha1_ctx);
+	uLong crc = crc32(0, Z_NULL, 0);
+
+	auto read_range = [&](u32 i, u32 slot)
+	{
+		return reader->Read(ranges[i].offset, ranges[i].size, bufs[slot].data());
+	};
+
+	// The CRC is taken before the clusters are decrypted in place
+	auto check_range = [&](u32 i, u32 slot)
+	{
+		const VerifyRange& range = ranges[i];
+		u8* data = bufs[slot].data();
+		crcs[slot] = crc32(0, data, range.size);
+		checked[slot] = bad[slot] = 0;
+		if (range.partition >= 0)
+		{
+			const VerifyPartition& p = partitions[range.partition];
+			bad[slot] = CheckGroup(p, &keys[range.partition], (range.offset - p.data_offset) / GROUP_SIZE, data, range.size, &checked[slot]);
+		}
+		return true;
+	};
+
+	auto hash_range = [&](u32 i, u32 slot)
+	{
+		if (callback && i % progress_monitor == 0)
+			callback("Verifying", (float)i / (float)ranges.size(), arg);
+
+		crc = crc32_combine(crc, crcs[slot], ranges[i].size);
+		result->num_checked_clusters += checked[slot];
+		result->num_bad_clusters += bad[slot];
+		return true;
+	};
+
+	// MD5 and SHA-1 can't be split, and the workers decrypt the ranges in
+	// place, so the reader takes them in order. Only the CRC is spread out.
+	auto read_and_hash_range = [&](u32 i, u32 slot)
+	{
+		if (!read_range(i, slot))
+			return false;
+		md5_update(&md5_ctx, bufs[slot].data(), ranges[i].size);
+		sha1_update(&sha1_ctx, bufs[slot].data(), ranges[i].size);
+		return true;
+	};
+
+	result->read_ok = RunBlockPipeline((u32)ranges.size(), num_slots, num_workers,
+		read_and_hash_range, check_range, hash_range);
+
+	result->crc32 = (u32)crc;
+	md5_finish(&md5_ctx, result->md5);
+	sha1_finish(&sha1_ctx, result->sha1);
+
+	if (callback)
+		callback("Done verifying disc image.", 1.0f, arg);
+	return result->read_ok;
+}
+
+}  // namespace
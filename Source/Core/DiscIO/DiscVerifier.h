@@ -0,0 +1,44 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Hashes a whole disc image the way dump databases list it, and checks the
+// hash tree of every Wii partition on the way. The image is read once, in
+// order, while the hashing and decryption are spread over several threads.
+
+#pragma once
+
+#include <string>
+
+#include "Blob.h"
+#include "CommonTypes.h"
+
+namespace DiscIO
+{
+
+struct DiscVerifyResult
+{
+	// False if the image couldn't be read to the end, the rest is then incomplete
+	bool read_ok;
+
+	// Of the data as it is on the disc, also for compressed images
+	u32 crc32;
+	u8 md5[16];
+	u8 sha1[20];
+
+	u32 num_partitions;
+	// Partitions whose H3 table doesn't match the hash in their TMD
+	u32 num_bad_partitions;
+	// Clusters that are in use, unused ones don't have valid hashes
+	u64 num_checked_clusters;
+	// Clusters whose data doesn't match their H0 hashes, or whose H0-H2
+	// tables don't match the level above
+	u64 num_bad_clusters;
+
+	bool IsGood() const { return read_ok && num_bad_partitions == 0 && num_bad_clusters == 0; }
+	std::string ToString() const;
+};
+
+bool VerifyDisc(const char* filename, DiscVerifyResult* result, CompressCB callback = 0, void* arg = 0);
+
+}  // namespace
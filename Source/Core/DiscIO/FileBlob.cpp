@@ -2,15 +2,35 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
 #include "FileBlob.h"
 
 namespace DiscIO
 {
 
 PlainFileReader::PlainFileReader(std::FILE* file)
-	: m_file(file)
+	: m_file(file), m_mapped_data(NULL)
+#ifdef _WIN32
+	, m_mapping_handle(NULL)
+#endif
 {
 	m_size = m_file.GetSize();
+	if (!MapFile())
+		INFO_LOG(DISCIO, "Could not map the disc image, falling back to buffered reads");
+}
+
+PlainFileReader::~PlainFileReader()
+{
+	UnmapFile();
 }
 
 PlainFileReader* PlainFileReader::Create(const char* filename)
@@ -22,8 +42,61 @@ PlainFileReader* PlainFileReader::Create(const char* filename)
 		return NULL;
 }
 
+bool PlainFileReader::MapFile()
+{
+	// A 32-bit address space can't fit a DVD image next to the emulated memory.
+	if (sizeof(void*) < 8 || m_size <= 0)
+		return false;
+
+#ifdef _WIN32
+	HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(m_file.GetHandle()));
+	m_mapping_handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping_handle)
+		return false;
+
+	m_mapped_data = (u8*)MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (!m_mapped_data)
+	{
+		CloseHandle(m_mapping_handle);
+		m_mapping_handle = NULL;
+		return false;
+	}
+#else
+	void* data = mmap(NULL, (size_t)m_size, PROT_READ, MAP_SHARED, fileno(m_file.GetHandle()), 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_mapped_data = (u8*)data;
+#endif
+	return true;
+}
+
+void PlainFileReader::UnmapFile()
+{
+	if (!m_mapped_data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_mapped_data);
+	CloseHandle(m_mapping_handle);
+	m_mapping_handle = NULL;
+#else
+	munmap(m_mapped_data, (size_t)m_size);
+#endif
+	m_mapped_data = NULL;
+}
+
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
+	if (m_mapped_data)
+	{
+		// Like a short fread, copy whatever is left before the end of the image.
+		const u64 available = offset < (u64)m_size ? (u64)m_size - offset : 0;
+		if (available)
+			memcpy(out_ptr, m_mapped_data + offset, (size_t)std::min(nbytes, available));
+		return nbytes <= available;
+	}
+
 	m_file.Seek(offset, SEEK_SET);
 	return m_file.ReadBytes(out_ptr, nbytes);
 }
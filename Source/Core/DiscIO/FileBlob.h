@@ -14,11 +14,21 @@ class PlainFileReader : public IBlobReader
 {
 	PlainFileReader(std::FILE* file);
 
+	// On 64-bit hosts the whole image is mapped, so reads are a single memcpy
+	// from the page cache into the destination. Falls back to m_file otherwise.
+	bool MapFile();
+	void UnmapFile();
+
 	File::IOFile m_file;
 	s64 m_size;
+	u8* m_mapped_data;
+#ifdef _WIN32
+	void* m_mapping_handle;
+#endif
 
 public:
 	static PlainFileReader* Create(const char* filename);
+	~PlainFileReader();
 
 	u64 GetDataSize() const { return m_size; }
 	u64 GetRawSize() const { return m_size; }
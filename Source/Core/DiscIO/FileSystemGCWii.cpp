@@ -47,14 +47,15 @@ const char* CFileSystemGCWii::GetFileName(u64 _Address)
 	if (!m_Initialized)
 		InitFileSystem();
 
-	for (auto& fileInfo : m_FileInfoVector)
-	{
-		if ((fileInfo.m_Offset <= _Address) &&
-		    ((fileInfo.m_Offset + fileInfo.m_FileSize) > _Address))
-		{
-			return fileInfo.m_FullPath;
-		}
-	}
+	// The last file starting at or before the address
+	auto it = std::upper_bound(m_FilesByOffset.begin(), m_FilesByOffset.end(), _Address,
+		[this](u64 address, size_t index) { return address < m_FileInfoVector[index].m_Offset; });
+	if (it == m_FilesByOffset.begin())
+		return 0;
+
+	const SFileInfo& fileInfo = m_FileInfoVector[*(it - 1)];
+	if (fileInfo.m_Offset + fileInfo.m_FileSize > _Address)
+		return fileInfo.m_FullPath;
 
 	return 0;
 }
@@ -202,16 +203,11 @@ u32 CFileSystemGCWii::Read32(u64 _Offset) const
 	return Common::swap32(Temp);
 }
 
-std::string CFileSystemGCWii::GetStringFromOffset(u64 _Offset) const
+static std::string GetLowerCasePath(const char* _rFullPath)
 {
-	std::string data;
-	data.resize(255);
-	m_rVolume->Read(_Offset, data.size(), (u8*)&data[0]);
-	data.erase(std::find(data.begin(), data.end(), 0x00), data.end());
-
-	// TODO: Should we really always use SHIFT-JIS?
-	// It makes some filenames in Pikmin (NTSC-U) sane, but is it correct?
-	return SHIFTJISToUTF8(data);
+	std::string path(_rFullPath);
+	std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+	return path;
 }
 
 size_t CFileSystemGCWii::GetFileList(std::vector<const SFileInfo *> &_rFilenames)
@@ -233,13 +229,11 @@ const SFileInfo* CFileSystemGCWii::FindFileInfo(const char* _rFullPath)
 	if (!m_Initialized)
 		InitFileSystem();
 
-	for (auto& fileInfo : m_FileInfoVector)
-	{
-		if (!strcasecmp(fileInfo.m_FullPath, _rFullPath))
-			return &fileInfo;
-	}
+	auto it = m_PathIndex.find(GetLowerCasePath(_rFullPath));
+	if (it == m_PathIndex.end())
+		return NULL;
 
-	return NULL;
+	return &m_FileInfoVector[it->second];
 }
 
 bool CFileSystemGCWii::DetectFileSystem()
@@ -264,7 +258,7 @@ void CFileSystemGCWii::InitFileSystem()
 
 	// read the whole FST
 	u64 FSTOffset = (u64)Read32(0x424) << m_OffsetShift;
-	// u32 FSTSize     = Read32(0x428);
+	u64 FSTSize   = (u64)Read32(0x428) << m_OffsetShift;
 	// u32 FSTMaxSize  = Read32(0x42C);
 
 
@@ -274,40 +268,66 @@ void CFileSystemGCWii::InitFileSystem()
 	Root.m_Offset     = (u64)Read32(FSTOffset + 0x4) << m_OffsetShift;
 	Root.m_FileSize   = Read32(FSTOffset + 0x8);
 
-	if (Root.IsDirectory())
+	// The entries are followed by the names, they are read in one go instead
+	// of a few bytes at a time, which for Wii discs means decrypting a whole
+	// cluster for each
+	const u64 EntriesSize = Root.m_FileSize * 0xC;
+	if (!Root.IsDirectory() || EntriesSize > FSTSize || FSTSize > 0x4000000)
+		return;
+
+	std::vector<u8> FST((size_t)FSTSize);
+	if (!m_rVolume->Read(FSTOffset, FST.size(), &FST[0]))
+		return;
+
+	if (m_FileInfoVector.size())
+		PanicAlert("Wtf?");
+
+	m_FileInfoVector.reserve((unsigned int)Root.m_FileSize);
+	for (u32 i = 0; i < Root.m_FileSize; i++)
 	{
-		if (m_FileInfoVector.size())
-			PanicAlert("Wtf?");
-		u64 NameTableOffset = FSTOffset;
+		const u32* Entry = (const u32*)&FST[i * 0xC];
+		SFileInfo sfi;
+		sfi.m_NameOffset = Common::swap32(Entry[0]);
+		sfi.m_Offset     = (u64)Common::swap32(Entry[1]) << m_OffsetShift;
+		sfi.m_FileSize   = Common::swap32(Entry[2]);
 
-		m_FileInfoVector.reserve((unsigned int)Root.m_FileSize);
-		for (u32 i = 0; i < Root.m_FileSize; i++)
-		{
-			SFileInfo sfi;
-			u64 Offset = FSTOffset + (i * 0xC);
-			sfi.m_NameOffset = Read32(Offset + 0x0);
-			sfi.m_Offset     = (u64)Read32(Offset + 0x4) << m_OffsetShift;
-			sfi.m_FileSize   = Read32(Offset + 0x8);
-
-			m_FileInfoVector.push_back(sfi);
-			NameTableOffset += 0xC;
-		}
+		m_FileInfoVector.push_back(sfi);
+	}
+
+	const std::vector<u8> NameTable(FST.begin() + (size_t)EntriesSize, FST.end());
+	BuildFilenames(1, m_FileInfoVector.size(), NULL, NameTable);
 
-		BuildFilenames(1, m_FileInfoVector.size(), NULL, NameTableOffset);
+	m_PathIndex.reserve(m_FileInfoVector.size());
+	for (size_t i = 0; i < m_FileInfoVector.size(); i++)
+	{
+		// Like the linear search this replaces, the first of several equal paths is found
+		m_PathIndex.insert(std::make_pair(GetLowerCasePath(m_FileInfoVector[i].m_FullPath), i));
+		if (!m_FileInfoVector[i].IsDirectory())
+			m_FilesByOffset.push_back(i);
 	}
+	std::stable_sort(m_FilesByOffset.begin(), m_FilesByOffset.end(), [this](size_t a, size_t b)
+	{
+		return m_FileInfoVector[a].m_Offset < m_FileInfoVector[b].m_Offset;
+	});
 }
 
 // Changed this stuff from C++ string to C strings for speed in debug mode. Doesn't matter in release, but
 // std::string is SLOW in debug mode.
-size_t CFileSystemGCWii::BuildFilenames(const size_t _FirstIndex, const size_t _LastIndex, const char* _szDirectory, u64 _NameTableOffset)
+size_t CFileSystemGCWii::BuildFilenames(const size_t _FirstIndex, const size_t _LastIndex, const char* _szDirectory,
+	const std::vector<u8>& _rNameTable)
 {
 	size_t CurrentIndex = _FirstIndex;
 
 	while (CurrentIndex < _LastIndex)
 	{
 		SFileInfo *rFileInfo = &m_FileInfoVector[CurrentIndex];
-		u64 uOffset = _NameTableOffset + (rFileInfo->m_NameOffset & 0xFFFFFF);
-		std::string filename = GetStringFromOffset(uOffset);
+		size_t uOffset = std::min<size_t>(rFileInfo->m_NameOffset & 0xFFFFFF, _rNameTable.size());
+		size_t uLength = std::min<size_t>(255, _rNameTable.size() - uOffset);
+		const char* pName = (const char*)_rNameTable.data() + uOffset;
+
+		// TODO: Should we really always use SHIFT-JIS?
+		// It makes some filenames in Pikmin (NTSC-U) sane, but is it correct?
+		std::string filename = SHIFTJISToUTF8(std::string(pName, std::find(pName, pName + uLength, 0x00)));
 
 		// check next index
 		if (rFileInfo->IsDirectory())
@@ -318,7 +338,7 @@ size_t CFileSystemGCWii::BuildFilenames(const size_t _FirstIndex, const size_t _
 			else
 				CharArrayFromFormat(rFileInfo->m_FullPath, "%s/", filename.c_str());
 
-			CurrentIndex = BuildFilenames(CurrentIndex + 1, (size_t) rFileInfo->m_FileSize, rFileInfo->m_FullPath, _NameTableOffset);
+			CurrentIndex = BuildFilenames(CurrentIndex + 1, (size_t) rFileInfo->m_FileSize, rFileInfo->m_FullPath, _rNameTable);
 		}
 		else
 		{
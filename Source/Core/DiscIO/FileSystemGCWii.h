@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Filesystem.h"
@@ -33,12 +35,17 @@ private:
 	u32 m_OffsetShift; // WII offsets are all shifted
 
 	std::vector <SFileInfo> m_FileInfoVector;
+	// Indices into m_FileInfoVector by lower case full path, and of the files
+	// (not directories) sorted by offset, both built once by InitFileSystem
+	std::unordered_map<std::string, size_t> m_PathIndex;
+	std::vector<size_t> m_FilesByOffset;
+
 	u32 Read32(u64 _Offset) const;
-	std::string GetStringFromOffset(u64 _Offset) const;
 	const SFileInfo* FindFileInfo(const char* _rFullPath);
 	bool DetectFileSystem();
 	void InitFileSystem();
-	size_t BuildFilenames(const size_t _FirstIndex, const size_t _LastIndex, const char* _szDirectory, u64 _NameTableOffset);
+	size_t BuildFilenames(const size_t _FirstIndex, const size_t _LastIndex, const char* _szDirectory,
+		const std::vector<u8>& _rNameTable);
 };
 
 } // namespace
@@ -6,18 +6,142 @@
 
 #include <algorithm>
 #include <cctype>
+#include <memory>
 #include <polarssl/aes.h>
+#include <polarssl/sha1.h>
+#include "AES.h"
 #include "MathUtil.h"
 #include "FileUtil.h"
 #include "Log.h"
 #include "WiiWad.h"
 #include "StringUtil.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 namespace DiscIO
 {
 CSharedContent CSharedContent::m_Instance;
 cUIDsys cUIDsys::m_Instance;
 
+static void AESDecode(const u8* _pKey, u8* _IV, const u8* _pSrc, u32 _Size, u8* _pDest)
+{
+	aes_context AES_ctx;
+
+	aes_setkey_dec(&AES_ctx, _pKey, 128);
+	DecryptCBC(&AES_ctx, _IV, _pSrc, _pDest, _Size);
+}
+
+// A content of a WAD, decrypted the first time it's read. The result is
+// written to the cache directory, so booting the same title again only
+// maps that file.
+class CNANDContentData
+{
+public:
+	CNANDContentData(const std::string& _rWADName, u64 _Offset, u32 _Size, const u8* _pKey, u16 _Index,
+	                 const std::string& _rCacheName)
+		: m_WADName(_rWADName)
+		, m_Offset(_Offset)
+		, m_Size(_Size)
+		, m_Index(_Index)
+		, m_CacheName(_rCacheName)
+		, m_pData(NULL)
+		, m_Mapped(false)
+		, m_Failed(false)
+	{
+		memcpy(m_Key, _pKey, sizeof(m_Key));
+	}
+
+	~CNANDContentData()
+	{
+#ifndef _WIN32
+		if (m_Mapped)
+		{
+			munmap(m_pData, m_Size);
+			return;
+		}
+#endif
+		delete[] m_pData;
+	}
+
+	const u8* Get()
+	{
+		if (!m_pData && !m_Failed && !MapCache() && !Decrypt())
+			m_Failed = true;
+		return m_pData;
+	}
+
+private:
+	bool MapCache()
+	{
+#ifdef _WIN32
+		return false;
+#else
+		if (m_CacheName.empty() || m_Size == 0)
+			return false;
+
+		File::IOFile CacheFile(m_CacheName, "rb");
+		if (!CacheFile || CacheFile.GetSize() != m_Size)
+			return false;
+
+		void* pData = mmap(NULL, m_Size, PROT_READ, MAP_PRIVATE, fileno(CacheFile.GetHandle()), 0);
+		if (pData == MAP_FAILED)
+			return false;
+
+		m_pData = (u8*)pData;
+		m_Mapped = true;
+		return true;
+#endif
+	}
+
+	bool Decrypt()
+	{
+		std::unique_ptr<IBlobReader> pReader(CreateBlobReader(m_WADName.c_str()));
+		const u32 EncryptedSize = ROUND_UP(m_Size, 0x10);
+		std::vector<u8> Encrypted(EncryptedSize);
+		if (!pReader || !pReader->Read(m_Offset, EncryptedSize, Encrypted.data()))
+		{
+			ERROR_LOG(DISCIO, "Can't read content %04x of %s", m_Index, m_WADName.c_str());
+			return false;
+		}
+
+		u8 IV[16] = {};
+		IV[0] = m_Index >> 8;
+		IV[1] = m_Index & 0xFF;
+		m_pData = new u8[ROUND_UP(m_Size, 0x40)]();
+		AESDecode(m_Key, IV, Encrypted.data(), EncryptedSize, m_pData);
+
+		// Written under another name first, so a cache file always is complete
+		if (!m_CacheName.empty() && File::CreateFullPath(m_CacheName))
+		{
+			const std::string TempName = m_CacheName + ".tmp";
+			File::IOFile CacheFile(TempName, "wb");
+			if (CacheFile.WriteBytes(m_pData, m_Size) && CacheFile.Close())
+				File::Rename(TempName, m_CacheName);
+			else
+				File::Delete(TempName);
+		}
+		return true;
+	}
+
+	std::string m_WADName;
+	u64 m_Offset;
+	u32 m_Size;
+	u8 m_Key[16];
+	u16 m_Index;
+	std::string m_CacheName;
+
+	u8* m_pData;
+	bool m_Mapped;
+	bool m_Failed;
+};
+
+const u8* SNANDContent::GetData() const
+{
+	return m_pData ? m_pData->Get() : NULL;
+}
+
 
 CSharedContent::CSharedContent()
 {
@@ -132,8 +256,6 @@ private:
 
 	bool Initialize(const std::string& _rName);
 
-	void AESDecode(u8* _pKey, u8* _IV, u8* _pSrc, u32 _Size, u8* _pDest);
-
 	void GetKeyFromTicket(u8* pTicket, u8* pTicketKey);
 };
 
@@ -154,10 +276,6 @@ CNANDContentLoader::CNANDContentLoader(const std::string& _rName)
 
 CNANDContentLoader::~CNANDContentLoader()
 {
-	for (auto& content : m_Content)
-	{
-		delete [] content.m_pData;
-	}
 	m_Content.clear();
 	if (m_TIK)
 	{
@@ -184,10 +302,10 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 		return false;
 	m_Path = _rName;
 	WiiWAD Wad(_rName);
-	u8* pDataApp = NULL;
+	u64 DataAppOffset = 0;
 	u8* pTMD = NULL;
+	u32 pTMDSize = 0;
 	u8 DecryptTitleKey[16];
-	u8 IV[16];
 	if (Wad.IsValid())
 	{
 		m_isWAD = true;
@@ -195,10 +313,10 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 		m_TIK = new u8[m_TIKSize];
 		memcpy(m_TIK, Wad.GetTicket(), m_TIKSize);
 		GetKeyFromTicket(m_TIK, DecryptTitleKey);
-		u32 pTMDSize = Wad.GetTMDSize();
+		pTMDSize = Wad.GetTMDSize();
 		pTMD = new u8[pTMDSize];
 		memcpy(pTMD, Wad.GetTMD(), pTMDSize);
-		pDataApp = Wad.GetDataApp();
+		DataAppOffset = Wad.GetDataAppOffset();
 	}
 	else
 	{
@@ -216,7 +334,7 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 					 TMDFileName.c_str());
 			return false;
 		}
-		u32 pTMDSize = (u32)File::GetSize(TMDFileName);
+		pTMDSize = (u32)File::GetSize(TMDFileName);
 		pTMD = new u8[pTMDSize];
 		pTMDFile.ReadBytes(pTMD, (size_t)pTMDSize);
 		pTMDFile.Close();
@@ -237,6 +355,18 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 
 	m_Content.resize(m_numEntries);
 
+	// Decrypted contents are cached per TMD, another version of the title
+	// has another one
+	std::string CachePath;
+	if (m_isWAD)
+	{
+		u8 TMDHash[20];
+		sha1(pTMD, pTMDSize, TMDHash);
+		CachePath = File::GetUserPath(D_CACHE_IDX) + "NAND/";
+		for (u8 Byte : TMDHash)
+			CachePath += StringFromFormat("%02x", Byte);
+		CachePath += "/";
+	}
 
 	for (u32 i=0; i<m_numEntries; i++)
 	{
@@ -251,19 +381,13 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 
 		if (m_isWAD)
 		{
-			u32 RoundedSize = ROUND_UP(rContent.m_Size, 0x40);
-			rContent.m_pData = new u8[RoundedSize];
-
-			memset(IV, 0, sizeof IV);
-			memcpy(IV, pTMD + 0x01e8 + 0x24*i, 2);
-			AESDecode(DecryptTitleKey, IV, pDataApp, RoundedSize, rContent.m_pData);
+			rContent.m_pData = std::make_shared<CNANDContentData>(_rName, DataAppOffset, rContent.m_Size,
+				DecryptTitleKey, rContent.m_Index, StringFromFormat("%s%08x.app", CachePath.c_str(), rContent.m_ContentID));
 
-			pDataApp += RoundedSize;
+			DataAppOffset += ROUND_UP(rContent.m_Size, 0x40);
 			continue;
 		}
 
-		rContent.m_pData = NULL;
-
 		if (rContent.m_Type & 0x8000)  // shared app
 		{
 			rContent.m_Filename = CSharedContent::AccessInstance().GetFilenameFromSHA1(rContent.m_SHA1Hash);
@@ -283,14 +407,6 @@ bool CNANDContentLoader::Initialize(const std::string& _rName)
 	delete [] pTMD;
 	return true;
 }
-void CNANDContentLoader::AESDecode(u8* _pKey, u8* _IV, u8* _pSrc, u32 _Size, u8* _pDest)
-{
-	aes_context AES_ctx;
-
-	aes_setkey_dec(&AES_ctx, _pKey, 128);
-	aes_crypt_cbc(&AES_ctx, AES_DECRYPT, _Size, _IV, _pSrc, _pDest);
-}
-
 void CNANDContentLoader::GetKeyFromTicket(u8* pTicket, u8* pTicketKey)
 {
 	u8 CommonKey[16] = {0xeb,0xe4,0x2a,0x22,0x5e,0x85,0x93,0xe4,0x48,0xd9,0xc5,0x45,0x73,0x81,0xaa,0xf7};
@@ -504,7 +620,13 @@ u64 CNANDContentManager::Install_WiiWAD(std::string &fileName)
 				return 0;
 			}
 
-			pAPPFile.WriteBytes(Content.m_pData, Content.m_Size);
+			const u8* pData = Content.GetData();
+			if (!pData)
+			{
+				PanicAlertT("WAD installation failed: error reading content %08x", Content.m_ContentID);
+				return 0;
+			}
+			pAPPFile.WriteBytes(pData, Content.m_Size);
 		}
 		else
 		{
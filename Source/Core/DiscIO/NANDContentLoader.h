@@ -4,9 +4,10 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
-#include <map>
 
 #include "Common.h"
 #include "Blob.h"
@@ -17,6 +18,8 @@
 namespace DiscIO
 {
 	bool Add_Ticket(u64 TitleID, const u8 *p_tik, u32 tikSize);
+class CNANDContentData;
+
 struct SNANDContent
 {
 	u32 m_ContentID;
@@ -27,7 +30,13 @@ struct SNANDContent
 	u8 m_Header[36]; //all of the above
 
 	std::string m_Filename;
-	u8* m_pData;
+
+	// Contents of a WAD are only decrypted the first time they're read, the
+	// others are read from m_Filename and have no data here.
+	const u8* GetData() const;
+	bool IsInMemory() const { return m_pData != NULL; }
+
+	std::shared_ptr<CNANDContentData> m_pData;
 };
 
 // pure virtual interface so just the NANDContentManager can create these files only
@@ -0,0 +1,161 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "Atomic.h"
+#include "Common.h"
+#include "FileUtil.h"
+#include "Hash.h"
+#include "SharedBlockCache.h"
+#include "StringUtil.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DiscIO
+{
+
+static const u32 CACHE_MAGIC = 0x43425344; // "DSBC"
+static const u32 CACHE_VERSION = 1;
+static const size_t CACHE_ALIGNMENT = 0x1000;
+
+struct CacheHeader
+{
+	u32 magic;
+	u32 version;
+	u32 block_size;
+	u32 reserved;
+	u64 num_blocks;
+};
+
+static std::string s_directory;
+
+void SharedBlockCache::SetDirectory(const std::string& directory)
+{
+	s_directory = directory;
+}
+
+std::string SharedBlockCache::GetFilename(const u8* header, u32 header_size, u32 block_size, u64 data_size,
+                                          const std::string& suffix)
+{
+	if (s_directory.empty() || header_size < 8)
+		return "";
+
+	for (int i = 0; i < 6; ++i)
+	{
+		if (!isalnum(header[i]))
+			return "";
+	}
+
+	// The disc number and revision follow the ID, the hash of the rest
+	// tells different dumps of them apart
+	return StringFromFormat("%s%.6s_%02x%02x_%08x_%llx_%x%s.bin", s_directory.c_str(), header,
+		header[6], header[7], HashAdler32(header, header_size),
+		(unsigned long long)data_size, block_size, suffix.c_str());
+}
+
+SharedBlockCache* SharedBlockCache::Open(const std::string& filename, u32 block_size, u64 num_blocks)
+{
+#ifdef _WIN32
+	// The file is only sparse with FSCTL_SET_SPARSE on NTFS, which isn't
+	// worth it for the setups this is for
+	return NULL;
+#else
+	const u64 valid_size = (num_blocks * sizeof(u32) + CACHE_ALIGNMENT - 1) & ~(u64)(CACHE_ALIGNMENT - 1);
+	const u64 total_size = CACHE_ALIGNMENT + valid_size + num_blocks * block_size;
+	if (filename.empty() || !block_size || total_size != (size_t)total_size)
+		return NULL;
+
+	File::CreateFullPath(filename);
+	const int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		WARN_LOG(DISCIO, "Can't open the shared disc cache %s", filename.c_str());
+		return NULL;
+	}
+
+	// Every process creating the file truncates it to the same size
+	struct stat st;
+	if (fstat(fd, &st) < 0 || ((u64)st.st_size != total_size &&
+	    (st.st_size != 0 || ftruncate(fd, (off_t)total_size) < 0)))
+	{
+		WARN_LOG(DISCIO, "The shared disc cache %s doesn't match the disc", filename.c_str());
+		close(fd);
+		return NULL;
+	}
+
+	void* base = mmap(NULL, (size_t)total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+	{
+		WARN_LOG(DISCIO, "Can't map the shared disc cache %s", filename.c_str());
+		return NULL;
+	}
+
+	CacheHeader* header = (CacheHeader*)base;
+	if (header->magic == 0)
+	{
+		header->version = CACHE_VERSION;
+		header->block_size = block_size;
+		header->num_blocks = num_blocks;
+		Common::AtomicStoreRelease(*(volatile u32*)&header->magic, CACHE_MAGIC);
+	}
+	if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION ||
+	    header->block_size != block_size || header->num_blocks != num_blocks)
+	{
+		WARN_LOG(DISCIO, "The shared disc cache %s doesn't match the disc", filename.c_str());
+		munmap(base, (size_t)total_size);
+		return NULL;
+	}
+
+	SharedBlockCache* cache = new SharedBlockCache();
+	cache->m_base = (u8*)base;
+	cache->m_size = (size_t)total_size;
+	cache->m_valid = (volatile u32*)(cache->m_base + CACHE_ALIGNMENT);
+	cache->m_data = cache->m_base + CACHE_ALIGNMENT + valid_size;
+	cache->m_block_size = block_size;
+	cache->m_num_blocks = num_blocks;
+	INFO_LOG(DISCIO, "Using the shared disc cache %s", filename.c_str());
+	return cache;
+#endif
+}
+
+SharedBlockCache::~SharedBlockCache()
+{
+#ifndef _WIN32
+	munmap(m_base, m_size);
+#endif
+}
+
+const u8* SharedBlockCache::Find(u64 block_num) const
+{
+	if (block_num >= m_num_blocks || !Common::AtomicLoadAcquire(m_valid[block_num]))
+		return NULL;
+	return m_data + block_num * m_block_size;
+}
+
+const u8* SharedBlockCache::Insert(u64 block_num, const u8* data)
+{
+	if (block_num >= m_num_blocks)
+		return NULL;
+
+	u8* block = m_data + block_num * m_block_size;
+	if (!Common::AtomicLoadAcquire(m_valid[block_num]))
+	{
+		// Another process storing the same block at the same time writes
+		// the same bytes
+		memcpy(block, data, m_block_size);
+		Common::AtomicStoreRelease(m_valid[block_num], 1);
+	}
+	return block;
+}
+
+}  // namespace
@@ -0,0 +1,51 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "CommonTypes.h"
+
+namespace DiscIO
+{
+
+// A cache of fixed size blocks in a memory mapped file, which every process
+// that opens the same file shares through the OS page cache. Blocks are
+// never evicted, the file is sparse so only the blocks that were stored
+// take up space. Writers of the same block have to store the same data.
+class SharedBlockCache
+{
+public:
+	// Returns NULL if the file can't be mapped or was made for other blocks
+	static SharedBlockCache* Open(const std::string& filename, u32 block_size, u64 num_blocks);
+
+	// Builds the file name of the cache for a disc from the start of its
+	// header. Empty if no directory is set or there is no usable ID.
+	static std::string GetFilename(const u8* header, u32 header_size, u32 block_size, u64 data_size,
+	                               const std::string& suffix);
+	// Shared caches are only used once a directory is set
+	static void SetDirectory(const std::string& directory);
+
+	~SharedBlockCache();
+
+	// NULL if the block hasn't been stored yet, the pointer stays valid for
+	// the lifetime of the cache
+	const u8* Find(u64 block_num) const;
+	const u8* Insert(u64 block_num, const u8* data);
+
+	u32 GetBlockSize() const { return m_block_size; }
+
+private:
+	SharedBlockCache() {}
+
+	u8* m_base;
+	size_t m_size;
+	volatile u32* m_valid;
+	u8* m_data;
+	u32 m_block_size;
+	u64 m_num_blocks;
+};
+
+}  // namespace
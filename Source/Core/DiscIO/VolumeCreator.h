@@ -8,8 +8,14 @@
 
 namespace DiscIO
 {
+class IBlobReader;
+
 IVolume* CreateVolumeFromFilename(const std::string& _rFilename, u32 _PartitionGroup = 0, u32 _VolumeNum = -1);
 IVolume* CreateVolumeFromDirectory(const std::string& _rDirectory, bool _bIsWii, const std::string& _rApploader = "", const std::string& _rDOL = "");
 bool IsVolumeWiiDisc(const IVolume *_rVolume);
 bool IsVolumeWadFile(const IVolume *_rVolume);
+// The offsets of all partitions listed in the partition table of a Wii disc image
+std::vector<u64> GetWiiPartitionOffsets(IBlobReader& _rReader);
+// Decrypts the title key that the data of the partition at _PartitionOffset is encrypted with
+void GetWiiPartitionKey(IBlobReader& _rReader, u64 _PartitionOffset, u8* _pKey);
 } // namespace
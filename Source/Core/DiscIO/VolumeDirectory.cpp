@@ -12,7 +12,8 @@ namespace DiscIO
 
 CVolumeDirectory::CVolumeDirectory(const std::string& _rDirectory, bool _bIsWii,
 								   const std::string& _rApploader, const std::string& _rDOL)
-	: m_totalNameSize(0)
+	: m_openFileOffset(0)
+	, m_totalNameSize(0)
 	, m_dataStartAddress(-1)
 	, m_fstSize(0)
 	, m_FSTData(NULL)
@@ -109,6 +110,8 @@ bool CVolumeDirectory::Read(u64 _Offset, u64 _Length, u8* _pBuffer) const
 	if(m_virtualDisk.empty())
 		return true;
 
+	std::lock_guard<std::mutex> lk(m_openFileLock);
+
 	// Determine which file the offset refers to
 	std::map<u64, std::string>::const_iterator fileIter = m_virtualDisk.lower_bound(_Offset);
 	if(fileIter->first > _Offset && fileIter != m_virtualDisk.begin())
@@ -122,7 +125,12 @@ bool CVolumeDirectory::Read(u64 _Offset, u64 _Length, u8* _pBuffer) const
 		_dbg_assert_(DVDINTERFACE, fileIter->first <= _Offset);
 		u64 fileOffset = _Offset - fileIter->first;
 
-		PlainFileReader* reader = PlainFileReader::Create(fileIter->second.c_str());
+		if(!m_openFile || m_openFileOffset != fileIter->first)
+		{
+			m_openFile.reset(PlainFileReader::Create(fileIter->second.c_str()));
+			m_openFileOffset = fileIter->first;
+		}
+		PlainFileReader* reader = m_openFile.get();
 		if(reader == NULL)
 			return false;
 
@@ -149,8 +157,6 @@ bool CVolumeDirectory::Read(u64 _Offset, u64 _Length, u8* _pBuffer) const
 			_dbg_assert_(DVDINTERFACE, fileIter->first >= _Offset);
 			PadToAddress(fileIter->first, _Offset, _Length, _pBuffer);
 		}
-
-		delete reader;
 	}
 
 	return true;
@@ -497,7 +503,7 @@ static u32 ComputeNameSize(const File::FSTEntry& parentEntry)
 
 u32 CVolumeDirectory::AddDirectoryEntries(const std::string& _Directory, File::FSTEntry& parentEntry)
 {
-	u32 foundEntries = ScanDirectoryTree(_Directory, parentEntry);
+	u32 foundEntries = ScanDirectoryTreeParallel(_Directory, parentEntry);
 	m_totalNameSize += ComputeNameSize(parentEntry);
 	return foundEntries;
 }
@@ -5,9 +5,11 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "FileUtil.h"
+#include "Thread.h"
 #include "Volume.h"
 
 //
@@ -17,6 +19,8 @@
 namespace DiscIO
 {
 
+class PlainFileReader;
+
 class CVolumeDirectory : public IVolume
 {
 public:
@@ -80,6 +84,11 @@ private:
 
 	std::map<u64, std::string> m_virtualDisk;
 
+	// The file read last, games mostly stream through one file at a time
+	mutable std::mutex m_openFileLock;
+	mutable std::unique_ptr<PlainFileReader> m_openFile;
+	mutable u64 m_openFileOffset;
+
 	u32 m_totalNameSize;
 
 	// gc has no shift, wii has 2 bit shift
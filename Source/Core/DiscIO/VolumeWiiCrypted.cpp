@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "AES.h"
 #include "VolumeWiiCrypted.h"
 #include "VolumeGC.h"
 #include "StringUtil.h"
@@ -10,17 +11,28 @@
 namespace DiscIO
 {
 
+static const u64 CLUSTER_SIZE = 0x8000;
+static const u64 CLUSTER_DATA_SIZE = 0x7C00;
+
 CVolumeWiiCrypted::CVolumeWiiCrypted(IBlobReader* _pReader, u64 _VolumeOffset,
 									 const unsigned char* _pVolumeKey)
 	: m_pReader(_pReader),
 	m_pBuffer(0),
 	m_VolumeOffset(_VolumeOffset),
 	dataOffset(0x20000),
-	m_LastDecryptedBlockOffset(-1)
+	m_ClusterCacheCounter(0),
+	m_SharedCacheChecked(false)
 {
 	m_AES_ctx = new aes_context;
 	aes_setkey_dec(m_AES_ctx, _pVolumeKey, 128);
-	m_pBuffer = new u8[0x8000];
+	m_pBuffer = new u8[CLUSTER_SIZE];
+
+	m_ClusterCache = new u8[CLUSTER_CACHE_SIZE * CLUSTER_DATA_SIZE];
+	for (int i = 0; i < CLUSTER_CACHE_SIZE; i++)
+	{
+		m_ClusterCacheTags[i] = (u64)(s64) - 1;
+		m_ClusterCacheAge[i] = 0;
+	}
 }
 
 
@@ -30,6 +42,9 @@ CVolumeWiiCrypted::~CVolumeWiiCrypted()
 	m_pReader = NULL;
 	delete[] m_pBuffer;
 	m_pBuffer = NULL;
+	m_SharedCache.reset();
+	delete[] m_ClusterCache;
+	m_ClusterCache = NULL;
 	delete m_AES_ctx;
 	m_AES_ctx = NULL;
 }
@@ -55,30 +70,20 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 
 	while (_Length > 0)
 	{
-		static unsigned char IV[16];
-
 		// math block offset
-		u64 Block  = _ReadOffset / 0x7C00;
-		u64 Offset = _ReadOffset % 0x7C00;
+		u64 Block  = _ReadOffset / CLUSTER_DATA_SIZE;
+		u64 Offset = _ReadOffset % CLUSTER_DATA_SIZE;
 
-		// read current block
-		if (!m_pReader->Read(m_VolumeOffset + dataOffset + Block * 0x8000, 0x8000, m_pBuffer))
+		const u8* Cluster = GetDecryptedCluster(Block);
+		if (!Cluster)
 		{
 			return(false);
 		}
 
-		if (m_LastDecryptedBlockOffset != Block)
-		{
-			memcpy(IV, m_pBuffer + 0x3d0, 16);
-			aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x7C00, IV, m_pBuffer + 0x400, m_LastDecryptedBlock);
-
-			m_LastDecryptedBlockOffset = Block;
-		}
-
 		// copy the encrypted data
-		u64 MaxSizeToCopy = 0x7C00 - Offset;
+		u64 MaxSizeToCopy = CLUSTER_DATA_SIZE - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, &Cluster[Offset], (size_t)CopySize);
 
 		// increase buffers
 		_Length -= CopySize;
@@ -89,6 +94,68 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 	return(true);
 }
 
+void CVolumeWiiCrypted::OpenSharedCache() const
+{
+	m_SharedCacheChecked = true;
+
+	u8 Header[0x400];
+	if (!m_pReader->Read(0, sizeof(Header), Header) ||
+	    m_pReader->GetDataSize() <= m_VolumeOffset + dataOffset)
+		return;
+
+	const std::string Filename = SharedBlockCache::GetFilename(Header, sizeof(Header), (u32)CLUSTER_DATA_SIZE,
+		m_pReader->GetDataSize(), StringFromFormat("_p%llx", (unsigned long long)m_VolumeOffset));
+	const u64 NumClusters = (m_pReader->GetDataSize() - m_VolumeOffset - dataOffset) / CLUSTER_SIZE;
+	m_SharedCache.reset(SharedBlockCache::Open(Filename, (u32)CLUSTER_DATA_SIZE, NumClusters));
+}
+
+const u8* CVolumeWiiCrypted::GetDecryptedCluster(u64 _Block) const
+{
+	if (!m_SharedCacheChecked)
+		OpenSharedCache();
+
+	int Slot = 0;
+	for (int i = 0; i < CLUSTER_CACHE_SIZE; i++)
+	{
+		if (m_ClusterCacheTags[i] == _Block)
+		{
+			m_ClusterCacheAge[i] = ++m_ClusterCacheCounter;
+			return &m_ClusterCache[i * CLUSTER_DATA_SIZE];
+		}
+		if (m_ClusterCacheAge[i] < m_ClusterCacheAge[Slot])
+			Slot = i;
+	}
+
+	if (m_SharedCache)
+	{
+		const u8* Shared = m_SharedCache->Find(_Block);
+		if (Shared)
+			return Shared;
+	}
+
+	// read current block
+	if (!m_pReader->Read(m_VolumeOffset + dataOffset + _Block * CLUSTER_SIZE, CLUSTER_SIZE, m_pBuffer))
+	{
+		return NULL;
+	}
+
+	u8 IV[16];
+	memcpy(IV, m_pBuffer + 0x3d0, 16);
+	u8* Cluster = &m_ClusterCache[Slot * CLUSTER_DATA_SIZE];
+	DecryptCBC(m_AES_ctx, IV, m_pBuffer + 0x400, Cluster, CLUSTER_DATA_SIZE);
+
+	if (m_SharedCache)
+	{
+		const u8* Shared = m_SharedCache->Insert(_Block, Cluster);
+		if (Shared)
+			return Shared;
+	}
+
+	m_ClusterCacheTags[Slot] = _Block;
+	m_ClusterCacheAge[Slot] = ++m_ClusterCacheCounter;
+	return Cluster;
+}
+
 bool CVolumeWiiCrypted::GetTitleID(u8* _pBuffer) const
 {
 	// Tik is at m_VolumeOffset size 0x2A4
@@ -253,7 +320,7 @@ bool CVolumeWiiCrypted::CheckIntegrity() const
 			NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", clusterID);
 			return false;
 		}
-		aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x400, IV, clusterMDCrypted, clusterMD);
+		DecryptCBC(m_AES_ctx, IV, clusterMDCrypted, clusterMD, 0x400);
 
 
 		// Some clusters have invalid data and metadata because they aren't
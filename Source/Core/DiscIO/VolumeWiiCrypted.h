@@ -42,8 +42,19 @@ private:
 	u64 m_VolumeOffset;
 	u64 dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[0x8000];
+	// Decrypted clusters, reused when neighbouring reads hit the same cluster.
+	enum { CLUSTER_CACHE_SIZE = 16 };
+	mutable u64 m_ClusterCacheTags[CLUSTER_CACHE_SIZE];
+	mutable u32 m_ClusterCacheAge[CLUSTER_CACHE_SIZE];
+	mutable u32 m_ClusterCacheCounter;
+	u8* m_ClusterCache;
+
+	// Decrypted clusters shared with other instances running the disc
+	mutable bool m_SharedCacheChecked;
+	mutable std::unique_ptr<SharedBlockCache> m_SharedCache;
+
+	void OpenSharedCache() const;
+	const u8* GetDecryptedCluster(u64 _Block) const;
 };
 
 } // namespace
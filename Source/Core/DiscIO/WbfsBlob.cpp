@@ -2,6 +2,9 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+
 #include "WbfsBlob.h"
 #include "FileUtil.h"
 
@@ -18,7 +21,7 @@ static inline u64 align(u64 value, u64 bounds)
 }
 
 WbfsFileReader::WbfsFileReader(const char* filename)
-	: m_total_files(0), m_size(0), m_wlba_table(0), m_good(true)
+	: m_total_files(0), m_size(0), m_good(true)
 {
 	if(!filename || (strlen(filename) < 4) || !OpenFiles(filename) || !ReadHeader())
 	{
@@ -27,19 +30,25 @@ WbfsFileReader::WbfsFileReader(const char* filename)
 	}
 
 	// Grab disc info (assume slot 0, checked in ReadHeader())
-	m_wlba_table = new u16[m_blocks_per_disc];
+	std::vector<u16> wlba_table(m_blocks_per_disc);
 	m_files[0]->file.Seek(hd_sector_size + wii_disc_header_size /*+ i * m_disc_info_size*/, SEEK_SET);
-	m_files[0]->file.ReadBytes(m_wlba_table, m_blocks_per_disc * sizeof(u16));
+	m_files[0]->file.ReadBytes(wlba_table.data(), m_blocks_per_disc * sizeof(u16));
+
+	m_wbfs_sector_addresses.resize(m_blocks_per_disc);
+	for (u64 i = 0; i != m_blocks_per_disc; ++i)
+		m_wbfs_sector_addresses[i] = wbfs_sector_size * Common::swap16(wlba_table[i]);
+
+	SetSectorSize((int)wii_sector_size);
 }
 
 WbfsFileReader::~WbfsFileReader()
 {
+	StopReadahead();
+
 	for(u32 i = 0; i != m_files.size(); ++ i)
 	{
 		delete m_files[i];
 	}
-
-	delete[] m_wlba_table;
 }
 
 bool WbfsFileReader::OpenFiles(const char* filename)
@@ -116,53 +125,82 @@ bool WbfsFileReader::ReadHeader()
 	return true;
 }
 
-bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
+u64 WbfsFileReader::GetSectorAddress(u64 sector) const
+{
+	const u64 offset = sector << wii_sector_log2;
+	const u64 wbfs_sector = offset >> wbfs_sector_shift;
+	if (wbfs_sector >= m_blocks_per_disc || m_wbfs_sector_addresses[wbfs_sector] == 0)
+		return 0;
+
+	return m_wbfs_sector_addresses[wbfs_sector] + (offset & (wbfs_sector_size - 1));
+}
+
+bool WbfsFileReader::ReadSectors(u64 sector, u64 num_sectors, u8* out_ptr)
 {
-	while(nbytes)
+	while (num_sectors)
 	{
-		u64 read_size = 0;
-		File::IOFile& data_file = SeekToCluster(offset, &read_size);
-		read_size = (read_size > nbytes) ? nbytes : read_size;
+		const u64 address = GetSectorAddress(sector);
+		u64 run = 1;
+
+		if (address == 0)
+		{
+			// Not stored, like the unused parts of the disc
+			memset(out_ptr, 0, wii_sector_size);
+		}
+		else
+		{
+			while (run < num_sectors && GetSectorAddress(sector + run) == address + (run << wii_sector_log2))
+				++run;
 
-		data_file.ReadBytes(out_ptr, read_size);
+			if (!ReadFiles(address, run << wii_sector_log2, out_ptr))
+				return false;
+		}
 
-		out_ptr += read_size;
-		nbytes -= read_size;
-		offset += read_size;
+		sector += run;
+		num_sectors -= run;
+		out_ptr += run << wii_sector_log2;
 	}
 
 	return true;
 }
 
-File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
+bool WbfsFileReader::ReadFiles(u64 address, u64 nbytes, u8* out_ptr)
 {
-	u64 base_cluster = offset >> wbfs_sector_shift;
-	if(base_cluster < m_blocks_per_disc)
+	for (u32 i = 0; i != m_total_files && nbytes; i++)
 	{
-		u64 cluster_address = wbfs_sector_size * Common::swap16(m_wlba_table[base_cluster]);
-		u64 cluster_offset = offset & (wbfs_sector_size - 1);
-		u64 final_address = cluster_address + cluster_offset;
+		file_entry& entry = *m_files[i];
+		if (address >= entry.base_address + entry.size)
+			continue;
 
-		for(u32 i = 0; i != m_total_files; i ++)
-		{
-			if(final_address < (m_files[i]->base_address + m_files[i]->size))
-			{
-				m_files[i]->file.Seek(final_address - m_files[i]->base_address, SEEK_SET);
-				if(available)
-				{
-					u64 till_end_of_file = m_files[i]->size - (final_address - m_files[i]->base_address);
-					u64 till_end_of_sector = wbfs_sector_size - cluster_offset;
-					*available = std::min(till_end_of_file, till_end_of_sector);
-				}
-
-				return m_files[i]->file;
-			}
-		}
+		const u64 file_offset = address - entry.base_address;
+		const u64 read_size = std::min(nbytes, entry.size - file_offset);
+		if (!entry.file.Seek(file_offset, SEEK_SET) || !entry.file.ReadBytes(out_ptr, read_size))
+			return false;
+
+		address += read_size;
+		nbytes -= read_size;
+		out_ptr += read_size;
+	}
+
+	if (nbytes)
+	{
+		PanicAlert("Read beyond end of disc");
+		return false;
 	}
 
-	PanicAlert("Read beyond end of disc");
-	m_files[0]->file.Seek(0, SEEK_SET);
-	return m_files[0]->file;
+	return true;
+}
+
+void WbfsFileReader::GetBlock(u64 block_num, u8* out_ptr)
+{
+	if (!ReadSectors(block_num, 1, out_ptr))
+		memset(out_ptr, 0, wii_sector_size);
+}
+
+bool WbfsFileReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+	std::lock_guard<std::mutex> lk(m_block_lock);
+	return ReadSectors(block_num, num_blocks, out_ptr);
 }
 
 WbfsFileReader* WbfsFileReader::Create(const char* filename)
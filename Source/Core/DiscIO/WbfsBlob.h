@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Blob.h"
 #include "FileUtil.h"
 
@@ -12,7 +14,7 @@ namespace DiscIO
 
 struct wbfs_head_t;
 
-class WbfsFileReader : public IBlobReader
+class WbfsFileReader : public SectorReader
 {
 	WbfsFileReader(const char* filename);
 	~WbfsFileReader();
@@ -20,9 +22,17 @@ class WbfsFileReader : public IBlobReader
 	bool OpenFiles(const char* filename);
 	bool ReadHeader();
 
-	File::IOFile& SeekToCluster(u64 offset, u64* available);
 	bool IsGood() {return m_good;}
 
+	// Where the data of a Wii sector is in the files, or 0 if it isn't stored
+	u64 GetSectorAddress(u64 sector) const;
+	// Reads Wii sectors that follow each other on the disc, the ones that also
+	// follow each other in the files with a single read
+	bool ReadSectors(u64 sector, u64 num_sectors, u8* out_ptr);
+	bool ReadFiles(u64 address, u64 nbytes, u8* out_ptr);
+
+	void GetBlock(u64 block_num, u8* out_ptr);
+	bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
 
 	struct file_entry
 	{
@@ -47,7 +57,8 @@ class WbfsFileReader : public IBlobReader
 
 	u8 disc_table[500];
 
-	u16* m_wlba_table;
+	// The address of every WBFS sector of the disc, 0 for the ones that aren't stored
+	std::vector<u64> m_wbfs_sector_addresses;
 	u64 m_blocks_per_disc;
 
 	bool m_good;
@@ -57,7 +68,6 @@ public:
 
 	u64 GetDataSize() const { return m_size; }
 	u64 GetRawSize() const { return m_size; }
-	bool Read(u64 offset, u64 nbytes, u8* out_ptr);
 };
 
 bool IsWbfsBlob(const char* filename);
@@ -51,7 +51,6 @@ WiiWAD::~WiiWAD()
 		delete m_pCertificateChain;
 		delete m_pTicket;
 		delete m_pTMD;
-		delete m_pDataApp;
 		delete m_pFooter;
 	}
 }
@@ -110,7 +109,7 @@ bool WiiWAD::ParseWAD(DiscIO::IBlobReader& _rReader)
 	m_pCertificateChain   = CreateWADEntry(_rReader, m_CertificateChainSize, Offset);  Offset += ROUND_UP(m_CertificateChainSize, 0x40);
 	m_pTicket             = CreateWADEntry(_rReader, m_TicketSize, Offset);            Offset += ROUND_UP(m_TicketSize, 0x40);
 	m_pTMD                = CreateWADEntry(_rReader, m_TMDSize, Offset);               Offset += ROUND_UP(m_TMDSize, 0x40);
-	m_pDataApp            = CreateWADEntry(_rReader, m_DataAppSize, Offset);           Offset += ROUND_UP(m_DataAppSize, 0x40);
+	m_DataAppOffset       = Offset;                                                    Offset += ROUND_UP(m_DataAppSize, 0x40);
 	m_pFooter             = CreateWADEntry(_rReader, m_FooterSize, Offset);            Offset += ROUND_UP(m_FooterSize, 0x40);
 
 	return true;
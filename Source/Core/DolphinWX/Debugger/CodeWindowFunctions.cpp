@@ -159,11 +159,31 @@ void CCodeWindow::CreateMenuSymbols(wxMenuBar *pMenuBar)
 
 	wxMenu *pProfilerMenu = new wxMenu;
 	pProfilerMenu->Append(IDM_PROFILEBLOCKS, _("&Profile blocks"), wxEmptyString, wxITEM_CHECK);
+	pProfilerMenu->Append(IDM_SAMPLEBLOCKS, _("&Sample blocks"), wxEmptyString, wxITEM_CHECK);
 	pProfilerMenu->AppendSeparator();
 	pProfilerMenu->Append(IDM_WRITEPROFILE, _("&Write to profile.txt, show"));
+	pProfilerMenu->Append(IDM_WRITESAMPLES, _("Write samples to samples.txt, show"));
+	pProfilerMenu->Append(IDM_EXPORTBLOCKSTATS, _("Export block stats to blockstats.json"));
 	pMenuBar->Append(pProfilerMenu, _("&Profiler"));
 }
 
+// Opens the file in the default text viewer
+static void ShowTextFile(const std::string& filename)
+{
+	wxFileType* filetype = NULL;
+	if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromExtension(_T("txt"))))
+	{
+		// From extension failed, trying with MIME type now
+		if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromMimeType(_T("text/plain"))))
+			// MIME type failed, aborting mission
+			return;
+	}
+	wxString OpenCommand;
+	OpenCommand = filetype->GetOpenCommand(StrToWxStr(filename));
+	if(!OpenCommand.IsEmpty())
+		wxExecute(OpenCommand, wxEXEC_SYNC);
+}
+
 void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 {
 	switch (event.GetId())
@@ -175,6 +195,32 @@ void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 		Profiler::g_ProfileBlocks = GetMenuBar()->IsChecked(IDM_PROFILEBLOCKS);
 		Core::SetState(Core::CORE_RUN);
 		break;
+	case IDM_SAMPLEBLOCKS:
+		if (!GetMenuBar()->IsChecked(IDM_SAMPLEBLOCKS))
+			Profiler::StopSampling();
+		else if (!Profiler::StartSampling())
+			GetMenuBar()->Check(IDM_SAMPLEBLOCKS, false);
+		break;
+	case IDM_WRITESAMPLES:
+		{
+			std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/samples.txt";
+			File::CreateFullPath(filename);
+			Profiler::WriteSampleResults(filename.c_str());
+			ShowTextFile(filename);
+		}
+		break;
+	case IDM_EXPORTBLOCKSTATS:
+		if (Core::GetState() == Core::CORE_RUN)
+			Core::SetState(Core::CORE_PAUSE);
+
+		if (Core::GetState() == Core::CORE_PAUSE && PowerPC::GetMode() == PowerPC::MODE_JIT)
+		{
+			std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/blockstats.json";
+			File::CreateFullPath(filename);
+			if (!Profiler::ExportBlockStats(filename))
+				PanicAlert("Failed to write %s", filename.c_str());
+		}
+		break;
 	case IDM_WRITEPROFILE:
 		if (Core::GetState() == Core::CORE_RUN)
 			Core::SetState(Core::CORE_PAUSE);
@@ -186,19 +232,7 @@ void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 				std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.txt";
 				File::CreateFullPath(filename);
 				Profiler::WriteProfileResults(filename.c_str());
-
-				wxFileType* filetype = NULL;
-				if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromExtension(_T("txt"))))
-				{
-					// From extension failed, trying with MIME type now
-					if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromMimeType(_T("text/plain"))))
-						// MIME type failed, aborting mission
-						break;
-				}
-				wxString OpenCommand;
-				OpenCommand = filetype->GetOpenCommand(StrToWxStr(filename));
-				if(!OpenCommand.IsEmpty())
-					wxExecute(OpenCommand, wxEXEC_SYNC);
+				ShowTextFile(filename);
 			}
 		}
 		break;
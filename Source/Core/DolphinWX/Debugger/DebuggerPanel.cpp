@@ -25,6 +25,7 @@ BEGIN_EVENT_TABLE(GFXDebuggerPanel, wxPanel)
 	EVT_BUTTON(ID_CLEAR_TEXTURE_CACHE,GFXDebuggerPanel::OnClearTextureCacheButton)
 	EVT_BUTTON(ID_CLEAR_VERTEX_SHADER_CACHE,GFXDebuggerPanel::OnClearVertexShaderCacheButton)
 	EVT_BUTTON(ID_CLEAR_PIXEL_SHADER_CACHE,GFXDebuggerPanel::OnClearPixelShaderCacheButton)
+	EVT_BUTTON(ID_CAPTURE_DRAWS,GFXDebuggerPanel::OnCaptureDrawsButton)
 END_EVENT_TABLE()
 
 // From VideoCommon
@@ -151,6 +152,7 @@ void GFXDebuggerPanel::CreateGUIControls()
 	m_pButtonClearTextureCache = new wxButton(this, ID_CLEAR_TEXTURE_CACHE, _("Clear Textures"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _("Clear Textures"));
 	m_pButtonClearVertexShaderCache = new wxButton(this, ID_CLEAR_VERTEX_SHADER_CACHE, _("Clear V Shaders"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _("Clear V Shaders"));
 	m_pButtonClearPixelShaderCache = new wxButton(this, ID_CLEAR_PIXEL_SHADER_CACHE, _("Clear P Shaders"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _("Clear P Shaders"));
+	m_pButtonCaptureDraws = new wxButton(this, ID_CAPTURE_DRAWS, _("Time Draws"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _("Time Draws"));
 
 	m_pDumpList = new wxChoice(this, ID_DUMP_LIST, wxDefaultPosition, wxSize(120,25), 0, NULL, 0 ,wxDefaultValidator, _("DumpList"));
 	m_pDumpList->Insert(_("Pixel Shader"),0);
@@ -190,6 +192,7 @@ void GFXDebuggerPanel::CreateGUIControls()
 	pDbgGrid->Add(m_pButtonClearVertexShaderCache);
 	pDbgGrid->Add(m_pButtonClearPixelShaderCache);
 	pDebugBox->Add(pDbgGrid);
+	pDebugBox->Add(m_pButtonCaptureDraws);
 
 	sMain->Add(pFlowCtrlBox, 0, 0, 5);
 	sMain->Add(pDebugBox, 0, 0, 5);
@@ -310,6 +313,17 @@ void GFXDebuggerPanel::OnDumpButton(wxCommandEvent& event)
 	}
 }
 
+void GFXDebuggerPanel::OnCaptureDrawsButton(wxCommandEvent& event)
+{
+	long frames;
+	if (!m_pCount->GetValue().ToLong(&frames) || frames <= 0)
+		frames = 1;
+
+	std::string dump_path = File::GetUserPath(D_DUMP_IDX) + "Debug/" +
+		SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID + "/";
+	GFXDebuggerCaptureDraws((u32)frames, dump_path + "draw_timings.txt");
+}
+
 void GFXDebuggerPanel::OnContButton(wxCommandEvent& event)
 {
 	GFXDebuggerToPauseAtNext = NOT_PAUSE;
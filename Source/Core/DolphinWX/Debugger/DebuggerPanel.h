@@ -51,6 +51,7 @@ private:
 	wxButton	*m_pButtonClearTextureCache;
 	wxButton	*m_pButtonClearVertexShaderCache;
 	wxButton	*m_pButtonClearPixelShaderCache;
+	wxButton	*m_pButtonCaptureDraws;
 	wxTextCtrl	*m_pCount;
 
 
@@ -70,6 +71,7 @@ private:
 		ID_CLEAR_TEXTURE_CACHE,
 		ID_CLEAR_VERTEX_SHADER_CACHE,
 		ID_CLEAR_PIXEL_SHADER_CACHE,
+		ID_CAPTURE_DRAWS,
 		ID_COUNT
 	};
 
@@ -94,4 +96,7 @@ private:
 	void OnClearVertexShaderCacheButton(wxCommandEvent& event);
 	void OnClearPixelShaderCacheButton(wxCommandEvent& event);
 	void OnCountEnter(wxCommandEvent& event);
+
+	// Times the draws of the next Count frames, doesn't need a pause
+	void OnCaptureDrawsButton(wxCommandEvent& event);
 };
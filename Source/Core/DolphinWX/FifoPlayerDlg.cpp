@@ -15,6 +15,7 @@
 #include <wx/clipbrd.h>
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 DECLARE_EVENT_TYPE(RECORDING_FINISHED_EVENT, -1)
@@ -28,6 +29,21 @@ using namespace std;
 std::recursive_mutex sMutex;
 wxEvtHandler *volatile FifoPlayerDlg::m_EvtHandler = NULL;
 
+// The data of a frame of a streamed log is only in memory while it's pinned
+class PinnedFrame
+{
+public:
+	PinnedFrame(FifoDataFile* file, int frame) : m_file(file), m_frame(frame), m_ok(file->PinFrame(frame)) {}
+	~PinnedFrame() { m_file->UnpinFrame(m_frame); }
+
+	bool IsOk() const { return m_ok; }
+
+private:
+	FifoDataFile* m_file;
+	int m_frame;
+	bool m_ok;
+};
+
 FifoPlayerDlg::FifoPlayerDlg(wxWindow * const parent) :
 	wxDialog(parent, wxID_ANY, _("FIFO Player"), wxDefaultPosition, wxDefaultSize),
 	m_search_result_idx(0), m_FramesToRecord(1)
@@ -462,6 +478,9 @@ void FifoPlayerDlg::OnBeginSearch(wxCommandEvent& event)
 	FifoPlayer& player = FifoPlayer::GetInstance();
 	const AnalyzedFrameInfo& frame = player.GetAnalyzedFrameInfo(frame_idx);
 	const FifoFrameInfo& fifo_frame = player.GetFile()->GetFrame(frame_idx);
+	PinnedFrame pin(player.GetFile(), frame_idx);
+	if (!pin.IsOk())
+		return;
 
 	// TODO: Support searching through the last object... How do we know were the cmd data ends?
 	// TODO: Support searching for bit patterns
@@ -620,7 +639,10 @@ void FifoPlayerDlg::OnObjectListSelectionChanged(wxCommandEvent& event)
 
 	m_objectCmdList->Clear();
 	m_objectCmdOffsets.clear();
+	std::unique_ptr<PinnedFrame> pin;
 	if (frame_idx != -1 && object_idx != -1)
+		pin.reset(new PinnedFrame(player.GetFile(), frame_idx));
+	if (pin && pin->IsOk())
 	{
 		const AnalyzedFrameInfo& frame = player.GetAnalyzedFrameInfo(frame_idx);
 		const FifoFrameInfo& fifo_frame = player.GetFile()->GetFrame(frame_idx);
@@ -732,6 +754,7 @@ void FifoPlayerDlg::OnObjectListSelectionChanged(wxCommandEvent& event)
 			}
 		}
 	}
+	pin.reset();
 	// Update command list
 	wxCommandEvent ev = wxCommandEvent(wxEVT_COMMAND_LISTBOX_SELECTED);
 	ev.SetInt(-1);
@@ -754,6 +777,12 @@ void FifoPlayerDlg::OnObjectCmdListSelectionChanged(wxCommandEvent& event)
 	FifoPlayer& player = FifoPlayer::GetInstance();
 	const AnalyzedFrameInfo& frame = player.GetAnalyzedFrameInfo(frame_idx);
 	const FifoFrameInfo& fifo_frame = player.GetFile()->GetFrame(frame_idx);
+	PinnedFrame pin(player.GetFile(), frame_idx);
+	if (!pin.IsOk())
+	{
+		m_objectCmdInfo->SetLabel(wxEmptyString);
+		return;
+	}
 	const u8* cmddata = &fifo_frame.fifoData[frame.objectStarts[object_idx]] + m_objectCmdOffsets[event.GetInt()];
 
 	// TODO: Not sure whether we should bother translating the descriptions
@@ -193,6 +193,9 @@ bool cInterfaceEGL::Create(void *&window_handle)
 		INFO_LOG(VIDEO, "Error: eglCreateContext failed\n");
 		exit(1);
 	}
+	GLWin.egl_config = config;
+	GLWin.egl_shared_ctx = EGL_NO_CONTEXT;
+	GLWin.egl_shared_surf = EGL_NO_SURFACE;
 
 	GLWin.native_window = Platform.CreateWindow();
 
@@ -213,6 +216,46 @@ bool cInterfaceEGL::MakeCurrent()
 {
 	return eglMakeCurrent(GLWin.egl_dpy, GLWin.egl_surf, GLWin.egl_surf, GLWin.egl_ctx);
 }
+bool cInterfaceEGL::CreateSharedContext()
+{
+	EGLint ctx_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, s_opengl_mode == MODE_OPENGLES3 ? 3 : 2,
+		EGL_NONE
+	};
+	if (s_opengl_mode == MODE_OPENGL)
+		ctx_attribs[0] = EGL_NONE;
+
+	GLWin.egl_shared_ctx = eglCreateContext(GLWin.egl_dpy, GLWin.egl_config, GLWin.egl_ctx, ctx_attribs);
+	if (GLWin.egl_shared_ctx == EGL_NO_CONTEXT)
+		return false;
+
+	// The worker never draws, a 1x1 pbuffer is all it needs. Drivers with
+	// EGL_KHR_surfaceless_context will also accept no surface at all.
+	const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	GLWin.egl_shared_surf = eglCreatePbufferSurface(GLWin.egl_dpy, GLWin.egl_config, pbuffer_attribs);
+	return true;
+}
+
+bool cInterfaceEGL::MakeSharedContextCurrent()
+{
+	return eglMakeCurrent(GLWin.egl_dpy, GLWin.egl_shared_surf, GLWin.egl_shared_surf, GLWin.egl_shared_ctx);
+}
+
+bool cInterfaceEGL::ClearSharedContextCurrent()
+{
+	return eglMakeCurrent(GLWin.egl_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void cInterfaceEGL::DestroySharedContext()
+{
+	if (GLWin.egl_shared_surf != EGL_NO_SURFACE)
+		eglDestroySurface(GLWin.egl_dpy, GLWin.egl_shared_surf);
+	if (GLWin.egl_shared_ctx != EGL_NO_CONTEXT)
+		eglDestroyContext(GLWin.egl_dpy, GLWin.egl_shared_ctx);
+	GLWin.egl_shared_surf = EGL_NO_SURFACE;
+	GLWin.egl_shared_ctx = EGL_NO_CONTEXT;
+}
+
 // Close backend
 void cInterfaceEGL::Shutdown()
 {
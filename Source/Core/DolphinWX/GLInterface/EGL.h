@@ -45,4 +45,9 @@ public:
 	bool Create(void *&window_handle);
 	bool MakeCurrent();
 	void Shutdown();
+
+	bool CreateSharedContext();
+	bool MakeSharedContextCurrent();
+	bool ClearSharedContextCurrent();
+	void DestroySharedContext();
 };
@@ -85,10 +85,14 @@ typedef struct {
 	EGLSurface egl_surf;
 	EGLContext egl_ctx;
 	EGLDisplay egl_dpy;
+	EGLConfig egl_config;
+	EGLSurface egl_shared_surf;
+	EGLContext egl_shared_ctx;
 	enum egl_platform platform;
 	EGLNativeWindowType native_window;
 #elif HAVE_X11
 	GLXContext ctx;
+	GLXContext shared_ctx;
 #endif
 #if defined(__APPLE__)
 	NSView *cocoaWin;
@@ -105,6 +105,7 @@ bool cInterfaceGLX::Create(void *&window_handle)
 
 	// Create a GLX context.
 	GLWin.ctx = glXCreateContext(GLWin.dpy, GLWin.vi, 0, GL_TRUE);
+	GLWin.shared_ctx = NULL;
 	if (!GLWin.ctx)
 	{
 		PanicAlert("Unable to create GLX context.");
@@ -140,6 +141,32 @@ bool cInterfaceGLX::ClearCurrent()
 }
 
 
+bool cInterfaceGLX::CreateSharedContext()
+{
+	GLWin.shared_ctx = glXCreateContext(GLWin.dpy, GLWin.vi, GLWin.ctx, GL_TRUE);
+	return GLWin.shared_ctx != NULL;
+}
+
+// The worker never draws, so it's fine to bind it to the render window as well.
+bool cInterfaceGLX::MakeSharedContextCurrent()
+{
+	return glXMakeCurrent(GLWin.dpy, GLWin.win, GLWin.shared_ctx);
+}
+
+bool cInterfaceGLX::ClearSharedContextCurrent()
+{
+	return glXMakeCurrent(GLWin.dpy, None, NULL);
+}
+
+void cInterfaceGLX::DestroySharedContext()
+{
+	if (GLWin.shared_ctx)
+	{
+		glXDestroyContext(GLWin.dpy, GLWin.shared_ctx);
+		GLWin.shared_ctx = NULL;
+	}
+}
+
 // Close backend
 void cInterfaceGLX::Shutdown()
 {
@@ -21,4 +21,9 @@ public:
 	bool MakeCurrent();
 	bool ClearCurrent();
 	void Shutdown();
+
+	bool CreateSharedContext();
+	bool MakeSharedContextCurrent();
+	bool ClearSharedContextCurrent();
+	void DestroySharedContext();
 };
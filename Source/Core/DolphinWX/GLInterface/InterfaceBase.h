@@ -30,6 +30,13 @@ public:
 	virtual bool ClearCurrent() { return true; }
 	virtual void Shutdown() {}
 
+	// Secondary context sharing its objects with the main one, so that worker
+	// threads can create GL objects. Interfaces which can't do this return false.
+	virtual bool CreateSharedContext() { return false; }
+	virtual bool MakeSharedContextCurrent() { return false; }
+	virtual bool ClearSharedContextCurrent() { return false; }
+	virtual void DestroySharedContext() {}
+
 	virtual void SwapInterval(int Interval) { }
 	virtual u32 GetBackBufferWidth() { return s_backbuffer_width; }
 	virtual u32 GetBackBufferHeight() { return s_backbuffer_height; }
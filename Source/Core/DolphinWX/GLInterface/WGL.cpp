@@ -13,6 +13,7 @@
 #include "EmuWindow.h"
 static HDC hDC = NULL;       // Private GDI Device Context
 static HGLRC hRC = NULL;     // Permanent Rendering Context
+static HGLRC hSharedRC = NULL; // Worker thread context, shares objects with hRC
 static HINSTANCE dllHandle = NULL; // Handle to OpenGL32.dll 
 
 // typedef from wglext.h
@@ -144,6 +145,40 @@ bool cInterfaceWGL::ClearCurrent()
 	return wglMakeCurrent(hDC, NULL) ? true : false;
 }
 
+bool cInterfaceWGL::CreateSharedContext()
+{
+	if (!(hSharedRC = wglCreateContext(hDC)))
+		return false;
+
+	// Sharing has to be set up before the new context owns any objects.
+	if (!wglShareLists(hRC, hSharedRC))
+	{
+		wglDeleteContext(hSharedRC);
+		hSharedRC = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool cInterfaceWGL::MakeSharedContextCurrent()
+{
+	return wglMakeCurrent(hDC, hSharedRC) ? true : false;
+}
+
+bool cInterfaceWGL::ClearSharedContextCurrent()
+{
+	return wglMakeCurrent(NULL, NULL) ? true : false;
+}
+
+void cInterfaceWGL::DestroySharedContext()
+{
+	if (hSharedRC)
+	{
+		wglDeleteContext(hSharedRC);
+		hSharedRC = NULL;
+	}
+}
+
 // Update window width, size and etc. Called from Render.cpp
 void cInterfaceWGL::Update()
 {
@@ -18,6 +18,11 @@ public:
 	bool ClearCurrent();
 	void Shutdown();
 
+	bool CreateSharedContext();
+	bool MakeSharedContextCurrent();
+	bool ClearSharedContextCurrent();
+	void DestroySharedContext();
+
 	void Update();
 	bool PeekMessages();
 };
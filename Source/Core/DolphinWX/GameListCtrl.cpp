@@ -9,6 +9,7 @@
 #include <wx/filename.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <memory>
 
@@ -17,6 +18,7 @@
 #include "ConfigManager.h"
 #include "GameListCtrl.h"
 #include "Blob.h"
+#include "ChunkedBlob.h"
 #include "Core.h"
 #include "ISOProperties.h"
 #include "FileUtil.h"
@@ -24,6 +26,7 @@
 #include "WxUtils.h"
 #include "Main.h"
 #include "MathUtil.h"
+#include "ThreadPool.h"
 #include "HW/DVDInterface.h"
 
 #include "resources/Flag_Europe.xpm"
@@ -469,35 +472,6 @@ void CGameListCtrl::ScanForISOs()
 	ClearIsoFiles();
 
 	CFileSearch::XStringVector Directories(SConfig::GetInstance().m_ISOFolder);
-
-	if (SConfig::GetInstance().m_RecursiveISOFolder)
-	{
-		for (u32 i = 0; i < Directories.size(); i++)
-		{
-			File::FSTEntry FST_Temp;
-			File::ScanDirectoryTree(Directories[i], FST_Temp);
-			for (auto& Entry : FST_Temp.children)
-			{
-				if (Entry.isDirectory)
-				{
-					bool duplicate = false;
-					for (auto& Directory : Directories)
-					{
-						if (strcmp(Directory.c_str(),
-									Entry.physicalName.c_str()) == 0)
-						{
-							duplicate = true;
-							break;
-						}
-					}
-					if (!duplicate)
-						Directories.push_back(
-								Entry.physicalName.c_str());
-				}
-			}
-		}
-	}
-
 	CFileSearch::XStringVector Extensions;
 
 	if (SConfig::GetInstance().m_ListGC)
@@ -507,12 +481,13 @@ void CGameListCtrl::ScanForISOs()
 		Extensions.push_back("*.iso");
 		Extensions.push_back("*.ciso");
 		Extensions.push_back("*.gcz");
+		Extensions.push_back("*.dcz");
 		Extensions.push_back("*.wbfs");
 	}
 	if (SConfig::GetInstance().m_ListWad)
 		Extensions.push_back("*.wad");
 
-	CFileSearch FileSearch(Extensions, Directories);
+	CFileSearch FileSearch(Extensions, Directories, SConfig::GetInstance().m_RecursiveISOFolder);
 	const CFileSearch::XStringVector& rFilenames = FileSearch.GetFileNames();
 
 	if (rFilenames.size() > 0)
@@ -529,18 +504,70 @@ void CGameListCtrl::ScanForISOs()
 			wxPD_SMOOTH // - makes updates as small as possible (down to 1px)
 			);
 
-		for (u32 i = 0; i < rFilenames.size(); i++)
+		GameListItem::LoadCache();
+
+		// The images are read on the thread pool, the ones that are in the
+		// cache are done almost right away. Only the bitmaps have to be made
+		// here.
+		std::vector<std::unique_ptr<GameListItem>> items(rFilenames.size());
+		std::mutex done_lock;
+		Common::Event item_done;
+		std::vector<u32> done;
+		std::atomic<bool> cancelled(false);
+
+		auto scan = [&](u32 i)
+		{
+			if (!cancelled)
+				items[i].reset(new GameListItem(rFilenames[i], false));
+			{
+				std::lock_guard<std::mutex> lk(done_lock);
+				done.push_back(i);
+			}
+			item_done.Set();
+		};
+
+		Common::TaskGroup group;
+		const bool threaded = Common::ThreadPool::GetNumWorkers() > 0;
+		if (threaded)
 		{
+			for (u32 i = 0; i < rFilenames.size(); i++)
+				group.Run([=, &scan]{ scan(i); });
+		}
+
+		for (u32 num_done = 0; num_done < rFilenames.size(); )
+		{
+			if (threaded)
+				item_done.Wait();
+			else
+				scan(num_done);
+
+			u32 last = 0;
+			{
+				std::lock_guard<std::mutex> lk(done_lock);
+				if (done.size() == num_done)
+					continue;
+				num_done = (u32)done.size();
+				last = done.back();
+			}
+
 			std::string FileName;
-			SplitPath(rFilenames[i], NULL, &FileName, NULL);
+			SplitPath(rFilenames[last], NULL, &FileName, NULL);
 
-			// Update with the progress (i) and the message
-			dialog.Update(i, wxString::Format(_("Scanning %s"),
+			// Update with the progress and the last image that was done
+			dialog.Update(num_done - 1, wxString::Format(_("Scanning %s"),
 				StrToWxStr(FileName)));
 			if (dialog.WasCancelled())
-				break;
+				cancelled = true;
+		}
+		group.Wait();
 
-			std::unique_ptr<GameListItem> iso_file(new GameListItem(rFilenames[i]));
+		GameListItem::SaveCache();
+
+		for (u32 i = 0; i < rFilenames.size(); i++)
+		{
+			std::unique_ptr<GameListItem> iso_file(std::move(items[i]));
+			if (!iso_file)
+				continue;
 			const GameListItem& ISOFile = *iso_file;
 
 			if (ISOFile.IsValid())
@@ -595,7 +622,10 @@ void CGameListCtrl::ScanForISOs()
 				}
 
 				if (list)
+				{
+					iso_file->CreateBitmap();
 					m_ISOFiles.push_back(iso_file.release());
+				}
 			}
 		}
 	}
@@ -1195,8 +1225,9 @@ void CGameListCtrl::OnCompressGCM(wxCommandEvent& WXUNUSED (event))
 					StrToWxStr(FilePath),
 					StrToWxStr(FileName) + _T(".gcz"),
 					wxEmptyString,
-					_("All compressed GC/Wii ISO files (gcz)") +
-						wxString::Format(wxT("|*.gcz|%s"), wxGetTranslation(wxALL_FILES)),
+					_("All compressed GC/Wii ISO files (gcz)") + wxString(wxT("|*.gcz|")) +
+						_("Chunked compressed GC/Wii ISO files (dcz)") +
+						wxString::Format(wxT("|*.dcz|%s"), wxGetTranslation(wxALL_FILES)),
 					wxFD_SAVE,
 					this);
 		}
@@ -1225,6 +1256,10 @@ void CGameListCtrl::OnCompressGCM(wxCommandEvent& WXUNUSED (event))
 	if (iso->IsCompressed())
 		all_good = DiscIO::DecompressBlobToFile(iso->GetFileName().c_str(),
 				path.char_str(), &CompressCB, &dialog);
+	else if (path.Lower().EndsWith(wxT(".dcz")))
+		all_good = DiscIO::CompressFileToChunkedBlob(iso->GetFileName().c_str(),
+				path.char_str(), iso->GetPlatform() == GameListItem::WII_DISC,
+				0x40000, &CompressCB, &dialog);
 	else
 		all_good = DiscIO::CompressFileToBlob(iso->GetFileName().c_str(),
 				path.char_str(),
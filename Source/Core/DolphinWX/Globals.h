@@ -193,6 +193,9 @@ enum
 
 	// Profiler
 	IDM_PROFILEBLOCKS,
+	IDM_SAMPLEBLOCKS,
+	IDM_WRITESAMPLES,
+	IDM_EXPORTBLOCKSTATS,
 	IDM_WRITEPROFILE,
 	// --------------------------------------------------------------
 
@@ -2,10 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <wx/mstream.h>
-#include <cinttypes>
 
 #include "Common.h"
 #include "CommonPaths.h"
@@ -14,23 +15,50 @@
 #include "FileUtil.h"
 #include "ISOFile.h"
 #include "StringUtil.h"
-#include "Hash.h"
 #include "IniFile.h"
 #include "WxUtils.h"
 
 #include "Filesystem.h"
 #include "BannerLoader.h"
 #include "FileSearch.h"
+#include "ChunkedBlob.h"
 #include "CompressedBlob.h"
 #include "ChunkFile.h"
+#include "Thread.h"
 #include "ConfigManager.h"
 
-static const u32 CACHE_REVISION = 0x115;
+static const u32 CACHE_REVISION = 0x116;
 
 #define DVD_BANNER_WIDTH 96
 #define DVD_BANNER_HEIGHT 32
 
-GameListItem::GameListItem(const std::string& _rFileName)
+// The saved state of every item by file name, with the size and
+// modification time of the file
+typedef std::map<std::string, std::pair<std::pair<u64, u64>, std::vector<u8>>> CacheIndex;
+
+static struct GameListCache
+{
+	std::mutex lock;
+	CacheIndex entries;
+	bool loaded;
+	bool dirty;
+
+	void DoState(PointerWrap &p)
+	{
+		// PointerWrap can't write maps with strings as keys
+		std::vector<std::pair<std::string, CacheIndex::mapped_type>> list(entries.begin(), entries.end());
+		p.Do(list);
+		if (p.GetMode() == PointerWrap::MODE_READ)
+			entries = CacheIndex(list.begin(), list.end());
+	}
+} s_cache;
+
+static std::string GetCacheFilename()
+{
+	return File::GetUserPath(D_CACHE_IDX) + "gamelist.cache";
+}
+
+GameListItem::GameListItem(const std::string& _rFileName, bool create_bitmap)
 	: m_FileName(_rFileName)
 	, m_emu_state(0)
 	, m_FileSize(0)
@@ -64,7 +92,8 @@ GameListItem::GameListItem(const std::string& _rFileName)
 			m_VolumeSize = pVolume->GetSize();
 
 			m_UniqueID = pVolume->GetUniqueID();
-			m_BlobCompressed = DiscIO::IsCompressedBlob(_rFileName.c_str());
+			m_BlobCompressed = DiscIO::IsCompressedBlob(_rFileName.c_str()) ||
+				DiscIO::IsChunkedBlob(_rFileName.c_str());
 			m_IsDiscTwo = pVolume->IsDiscTwo();
 			m_Revision = pVolume->GetRevision();
 
@@ -122,6 +151,16 @@ GameListItem::GameListItem(const std::string& _rFileName)
 		ini.Get("EmuState", "EmulationIssues", &m_issues);
 	}
 
+	if (create_bitmap)
+		CreateBitmap();
+}
+
+GameListItem::~GameListItem()
+{
+}
+
+void GameListItem::CreateBitmap()
+{
 	if (!m_pImage.empty())
 	{
 		wxImage Image(m_ImageWidth, m_ImageHeight, &m_pImage[0], true);
@@ -142,23 +181,78 @@ GameListItem::GameListItem(const std::string& _rFileName)
 	}
 }
 
-GameListItem::~GameListItem()
+void GameListItem::LoadCache()
 {
+	std::lock_guard<std::mutex> lk(s_cache.lock);
+	if (s_cache.loaded)
+		return;
+
+	if (!CChunkFileReader::Load<GameListCache>(GetCacheFilename(), CACHE_REVISION, s_cache))
+		s_cache.entries.clear();
+	s_cache.loaded = true;
+	s_cache.dirty = false;
 }
 
-bool GameListItem::LoadFromCache()
+void GameListItem::SaveCache()
 {
-	return CChunkFileReader::Load<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
+	std::lock_guard<std::mutex> lk(s_cache.lock);
+	if (!s_cache.dirty)
+		return;
+
+	// Forget the images that are gone
+	for (auto it = s_cache.entries.begin(); it != s_cache.entries.end(); )
+	{
+		if (File::Exists(it->first))
+			++it;
+		else
+			s_cache.entries.erase(it++);
+	}
 
-void GameListItem::SaveToCache()
-{
 	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
 	{
 		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
 	}
 
-	CChunkFileReader::Save<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
+	CChunkFileReader::Save<GameListCache>(GetCacheFilename(), CACHE_REVISION, s_cache);
+	s_cache.dirty = false;
+}
+
+bool GameListItem::LoadFromCache()
+{
+	u64 size, mtime;
+	if (!File::GetSizeAndModificationTime(m_FileName, &size, &mtime))
+		return false; // Disc Drive
+
+	std::vector<u8> state;
+	{
+		std::lock_guard<std::mutex> lk(s_cache.lock);
+		auto it = s_cache.entries.find(m_FileName);
+		if (it == s_cache.entries.end() || it->second.first != std::make_pair(size, mtime))
+			return false;
+		state = it->second.second;
+	}
+
+	u8* ptr = state.data();
+	PointerWrap p(&ptr, PointerWrap::MODE_READ);
+	DoState(p);
+	return true;
+}
+
+void GameListItem::SaveToCache()
+{
+	u64 size, mtime;
+	if (!File::GetSizeAndModificationTime(m_FileName, &size, &mtime))
+		return;
+
+	std::vector<u8> state;
+	PointerWrap p(&state);
+	DoState(p);
+
+	std::lock_guard<std::mutex> lk(s_cache.lock);
+	auto& entry = s_cache.entries[m_FileName];
+	entry.first = std::make_pair(size, mtime);
+	entry.second.swap(state);
+	s_cache.dirty = true;
 }
 
 void GameListItem::DoState(PointerWrap &p)
@@ -180,24 +274,6 @@ void GameListItem::DoState(PointerWrap &p)
 	p.Do(m_Revision);
 }
 
-std::string GameListItem::CreateCacheFilename()
-{
-	std::string Filename, LegalPathname, extension;
-	SplitPath(m_FileName, &LegalPathname, &Filename, &extension);
-
-	if (Filename.empty()) return Filename; // Disc Drive
-
-	// Filename.extension_HashOfFolderPath_Size.cache
-	// Append hash to prevent ISO name-clashing in different folders.
-	Filename.append(StringFromFormat("%s_%x_%" PRIx64 ".cache",
-		extension.c_str(), HashFletcher((const u8 *)LegalPathname.c_str(), LegalPathname.size()),
-		File::GetSize(m_FileName)));
-
-	std::string fullname(File::GetUserPath(D_CACHE_IDX));
-	fullname += Filename;
-	return fullname;
-}
-
 std::string GameListItem::GetCompany() const
 {
 	if (m_company.empty())
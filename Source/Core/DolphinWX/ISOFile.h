@@ -18,9 +18,19 @@ class PointerWrap;
 class GameListItem : NonCopyable
 {
 public:
-	GameListItem(const std::string& _rFileName);
+	// Without create_bitmap the item can be made on any thread, and
+	// CreateBitmap has to be called on the GUI thread after
+	GameListItem(const std::string& _rFileName, bool create_bitmap = true);
 	~GameListItem();
 
+	void CreateBitmap();
+
+	// What was read from the images is kept in a single file, by file name
+	// with the size and modification time the file had. Items made in
+	// between use and add to it.
+	static void LoadCache();
+	static void SaveCache();
+
 	bool IsValid() const {return m_Valid;}
 	const std::string& GetFileName() const {return m_FileName;}
 	std::string GetBannerName(int index) const;
@@ -87,6 +97,4 @@ private:
 
 	bool LoadFromCache();
 	void SaveToCache();
-
-	std::string CreateCacheFilename();
 };
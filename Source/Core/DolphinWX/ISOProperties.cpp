@@ -6,6 +6,7 @@
 #import <Cocoa/Cocoa.h>
 #endif
 
+#include <atomic>
 #include <type_traits>
 #include <cinttypes>
 
@@ -15,6 +16,8 @@
 
 #include "WxUtils.h"
 #include "VolumeCreator.h"
+#include "BlobPipeline.h"
+#include "DiscVerifier.h"
 #include "Filesystem.h"
 #include "ISOProperties.h"
 #include "PHackSettings.h"
@@ -68,6 +71,7 @@ BEGIN_EVENT_TABLE(CISOProperties, wxDialog)
 	EVT_MENU(IDM_EXTRACTAPPLOADER, CISOProperties::OnExtractDataFromHeader)
 	EVT_MENU(IDM_EXTRACTDOL, CISOProperties::OnExtractDataFromHeader)
 	EVT_MENU(IDM_CHECKINTEGRITY, CISOProperties::CheckPartitionIntegrity)
+	EVT_MENU(IDM_VERIFYDISC, CISOProperties::OnVerifyDisc)
 	EVT_CHOICE(ID_LANG, CISOProperties::OnChangeBannerLang)
 END_EVENT_TABLE()
 
@@ -680,6 +684,9 @@ void CISOProperties::OnRightClickOnTree(wxTreeEvent& event)
 		popupMenu->Append(IDM_CHECKINTEGRITY, _("Check Partition Integrity"));
 	}
 
+	popupMenu->AppendSeparator();
+	popupMenu->Append(IDM_VERIFYDISC, _("Verify Disc..."));
+
 	PopupMenu(popupMenu);
 
 	event.Skip();
@@ -769,57 +776,108 @@ void CISOProperties::ExportDir(const char* _rFullPath, const char* _rExportFolde
 	wxProgressDialog dialog(
 		dialogTitle,
 		_("Extracting..."),
-		index[1] - 1,
+		std::max<int>(1, index[1] - index[0]),
 		this,
 		wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT |
 		wxPD_ELAPSED_TIME | wxPD_ESTIMATED_TIME | wxPD_REMAINING_TIME |
 		wxPD_SMOOTH
 		);
 
-	// Extraction
-	for (u32 i = index[0]; i < index[1]; i++)
+	u32 done = 0;
+	auto update_dialog = [&](const DiscIO::SFileInfo* file)
 	{
 		dialog.SetTitle(wxString::Format(wxT("%s : %d%%"), dialogTitle.c_str(),
-			(u32)(((float)(i - index[0]) / (float)(index[1] - index[0])) * 100)));
+			(u32)(((float)done / (float)(index[1] - index[0])) * 100)));
 
-		dialog.Update(i, wxString::Format(_("Extracting %s"),
-			StrToWxStr(fst[i]->m_FullPath)));
+		dialog.Update(done, wxString::Format(_("Extracting %s"),
+			StrToWxStr(file->m_FullPath)));
 
-		if (dialog.WasCancelled())
-			break;
+		done++;
+		return !dialog.WasCancelled();
+	};
 
-		if (fst[i]->IsDirectory())
+	// The directories first, so the files can be written in any order
+	std::vector<u32> files;
+	for (u32 i = index[0]; i < index[1]; i++)
+	{
+		if (!fst[i]->IsDirectory())
 		{
-			snprintf(exportName, sizeof(exportName), "%s/%s/", _rExportFolder, fst[i]->m_FullPath);
-			DEBUG_LOG(DISCIO, "%s", exportName);
-
-			if (!File::Exists(exportName) && !File::CreateFullPath(exportName))
-			{
-				ERROR_LOG(DISCIO, "Could not create the path %s", exportName);
-			}
+			snprintf(exportName, sizeof(exportName), "%s/%s", _rExportFolder, fst[i]->m_FullPath);
+			if (File::Exists(exportName))
+				DEBUG_LOG(DISCIO, "%s already exists", exportName);
 			else
-			{
-				if (!File::IsDirectory(exportName))
-					ERROR_LOG(DISCIO, "%s already exists and is not a directory", exportName);
+				files.push_back(i);
+			continue;
+		}
 
-				DEBUG_LOG(DISCIO, "Folder %s already exists", exportName);
-			}
+		if (!update_dialog(fst[i]))
+			return;
+
+		snprintf(exportName, sizeof(exportName), "%s/%s/", _rExportFolder, fst[i]->m_FullPath);
+		DEBUG_LOG(DISCIO, "%s", exportName);
+
+		if (!File::Exists(exportName) && !File::CreateFullPath(exportName))
+		{
+			ERROR_LOG(DISCIO, "Could not create the path %s", exportName);
 		}
 		else
 		{
-			snprintf(exportName, sizeof(exportName), "%s/%s", _rExportFolder, fst[i]->m_FullPath);
-			DEBUG_LOG(DISCIO, "%s", exportName);
+			if (!File::IsDirectory(exportName))
+				ERROR_LOG(DISCIO, "%s already exists and is not a directory", exportName);
 
-			if (!File::Exists(exportName) && !FS->ExportFile(fst[i]->m_FullPath, exportName))
-			{
-				ERROR_LOG(DISCIO, "Could not export %s", exportName);
-			}
-			else
-			{
-				DEBUG_LOG(DISCIO, "%s already exists", exportName);
-			}
+			DEBUG_LOG(DISCIO, "Folder %s already exists", exportName);
 		}
 	}
+
+	// The files are read in the order they are on the disc, by a single thread
+	// since volumes can't be read from several, and written out by the others.
+	// Files too large to buffer are exported by the reader as they are.
+	static const u64 MAX_BUFFERED_FILE_SIZE = 16 * 1024 * 1024;
+	std::sort(files.begin(), files.end(), [&](u32 a, u32 b) { return fst[a]->m_Offset < fst[b]->m_Offset; });
+
+	const u32 num_workers = DiscIO::GetNumPipelineWorkers();
+	const u32 num_slots = num_workers + 2;
+	std::vector<std::vector<u8>> buffers(num_slots);
+	std::vector<bool> exported(num_slots);
+
+	auto export_name = [&](u32 i)
+	{
+		return StringFromFormat("%s/%s", _rExportFolder, fst[files[i]]->m_FullPath);
+	};
+
+	auto read_file = [&](u32 i, u32 slot)
+	{
+		const DiscIO::SFileInfo* file = fst[files[i]];
+		exported[slot] = file->m_FileSize > MAX_BUFFERED_FILE_SIZE;
+		if (exported[slot])
+		{
+			if (!FS->ExportFile(file->m_FullPath, export_name(i).c_str()))
+				ERROR_LOG(DISCIO, "Could not export %s", export_name(i).c_str());
+			return true;
+		}
+
+		buffers[slot].resize((size_t)file->m_FileSize);
+		FS->ReadFile(file->m_FullPath, buffers[slot].data(), buffers[slot].size());
+		return true;
+	};
+
+	auto write_file = [&](u32 i, u32 slot)
+	{
+		if (exported[slot])
+			return true;
+
+		File::IOFile f(export_name(i), "wb");
+		if (!f || !f.WriteBytes(buffers[slot].data(), buffers[slot].size()))
+			ERROR_LOG(DISCIO, "Could not export %s", export_name(i).c_str());
+		return true;
+	};
+
+	auto file_done = [&](u32 i, u32 slot)
+	{
+		return update_dialog(fst[files[i]]);
+	};
+
+	DiscIO::RunBlockPipeline((u32)files.size(), num_slots, num_workers, read_file, write_file, file_done);
 }
 
 void CISOProperties::OnExtractDir(wxCommandEvent& event)
@@ -972,6 +1030,66 @@ void CISOProperties::CheckPartitionIntegrity(wxCommandEvent& event)
 	}
 }
 
+class VerifyDiscThread : public wxThread
+{
+public:
+	VerifyDiscThread(const std::string& filename)
+		: wxThread(wxTHREAD_JOINABLE), m_filename(filename), m_progress(0)
+	{
+		Create();
+	}
+
+	virtual ExitCode Entry() override
+	{
+		return (ExitCode)DiscIO::VerifyDisc(m_filename.c_str(), &m_result, &VerifyDiscThread::OnProgress, this);
+	}
+
+	int GetProgress() const { return m_progress; }
+	const DiscIO::DiscVerifyResult& GetResult() const { return m_result; }
+
+private:
+	static void OnProgress(const char* text, float percent, void* arg)
+	{
+		((VerifyDiscThread*)arg)->m_progress = (int)(percent * 1000);
+	}
+
+	std::string m_filename;
+	DiscIO::DiscVerifyResult m_result;
+	std::atomic<int> m_progress;
+};
+
+void CISOProperties::OnVerifyDisc(wxCommandEvent& WXUNUSED (event))
+{
+	wxProgressDialog dialog(
+		_("Verifying disc..."), _("Working..."), 1000, this,
+		wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME | wxPD_SMOOTH
+	);
+
+	VerifyDiscThread thread(OpenGameListItem->GetFileName());
+	thread.Run();
+
+	while (thread.IsAlive())
+	{
+		dialog.Update(std::min(thread.GetProgress(), 999));
+		wxThread::Sleep(50);
+	}
+	thread.Wait();
+	dialog.Hide();
+
+	const DiscIO::DiscVerifyResult& result = thread.GetResult();
+	if (result.IsGood())
+	{
+		wxMessageBox(StrToWxStr(result.ToString()), _("Verification completed"),
+					 wxOK | wxICON_INFORMATION, this);
+	}
+	else
+	{
+		wxMessageBox(_("The disc doesn't match its own hashes. Your dump is most likely "
+					   "corrupted or has been patched incorrectly.\n\n") + StrToWxStr(result.ToString()),
+					 _("Verification Error"), wxOK | wxICON_ERROR, this);
+	}
+}
+
 void CISOProperties::SetRefresh(wxCommandEvent& event)
 {
 	bRefreshList = true;
@@ -159,6 +159,7 @@ private:
 		IDM_EXTRACTAPPLOADER,
 		IDM_EXTRACTDOL,
 		IDM_CHECKINTEGRITY,
+		IDM_VERIFYDISC,
 		IDM_BNRSAVEAS
 	};
 
@@ -179,6 +180,7 @@ private:
 	void OnExtractDir(wxCommandEvent& event);
 	void OnExtractDataFromHeader(wxCommandEvent& event);
 	void CheckPartitionIntegrity(wxCommandEvent& event);
+	void OnVerifyDisc(wxCommandEvent& event);
 	void SetRefresh(wxCommandEvent& event);
 	void OnChangeBannerLang(wxCommandEvent& event);
 	void PHackButtonClicked(wxCommandEvent& event);
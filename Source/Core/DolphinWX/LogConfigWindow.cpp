@@ -44,6 +44,12 @@ void LogConfigWindow::CreateGUIControls()
 	m_writeFileCB->Bind(wxEVT_COMMAND_CHECKBOX_CLICKED, &LogConfigWindow::OnWriteFileChecked, this);
 	m_writeWindowCB = new wxCheckBox(this, wxID_ANY, _("Write to Window"));
 	m_writeWindowCB->Bind(wxEVT_COMMAND_CHECKBOX_CLICKED, &LogConfigWindow::OnWriteWindowChecked, this);
+	m_binaryLogCB = new wxCheckBox(this, wxID_ANY, _("Write Binary Log"));
+	m_binaryLogCB->Bind(wxEVT_COMMAND_CHECKBOX_CLICKED, &LogConfigWindow::OnBinaryLogChecked, this);
+	m_binaryLogCB->SetToolTip(_("Writes the enabled log types to dolphin.binlog in the logs folder, in a compact form that takes little time even with verbose logging.\nDolphinNoGUI --decode-log turns it into text."));
+	m_asyncCB = new wxCheckBox(this, wxID_ANY, _("Asynchronous"));
+	m_asyncCB->Bind(wxEVT_COMMAND_CHECKBOX_CLICKED, &LogConfigWindow::OnAsyncChecked, this);
+	m_asyncCB->SetToolTip(_("Formats and writes the messages on a thread of their own, so logging slows down emulation less.\nMessages may be dropped when a lot is logged at once."));
 
 	wxButton *btn_toggle_all = new wxButton(this, wxID_ANY, _("Toggle All Log Types"),
 			wxDefaultPosition, wxDefaultSize, wxBU_EXACTFIT);
@@ -56,7 +62,9 @@ void LogConfigWindow::CreateGUIControls()
 	// Sizers
 	wxStaticBoxSizer* sbOutputs = new wxStaticBoxSizer(wxVERTICAL, this, _("Logger Outputs"));
 	sbOutputs->Add(m_writeFileCB, 0, wxDOWN, 1);
-	sbOutputs->Add(m_writeWindowCB, 0);
+	sbOutputs->Add(m_writeWindowCB, 0, wxDOWN, 1);
+	sbOutputs->Add(m_binaryLogCB, 0, wxDOWN, 1);
+	sbOutputs->Add(m_asyncCB, 0);
 
 	wxStaticBoxSizer* sbLogTypes = new wxStaticBoxSizer(wxVERTICAL, this, _("Log Types"));
 	sbLogTypes->Add(m_checks, 1, wxEXPAND);
@@ -94,6 +102,8 @@ void LogConfigWindow::LoadSettings()
 	m_writeFileCB->SetValue(m_writeFile);
 	ini.Get("Options", "WriteToWindow", &m_writeWindow, true);
 	m_writeWindowCB->SetValue(m_writeWindow);
+	m_binaryLogCB->SetValue(m_LogManager->IsBinaryLogEnabled());
+	m_asyncCB->SetValue(m_LogManager->IsAsync());
 
 	// Run through all of the log types and check each checkbox for each logging type
 	// depending on its set value within the config ini.
@@ -120,6 +130,8 @@ void LogConfigWindow::SaveSettings()
 	// Save the enabled/disabled states of the logger outputs to the config ini.
 	ini.Set("Options", "WriteToFile", m_writeFile);
 	ini.Set("Options", "WriteToWindow", m_writeWindow);
+	ini.Set("Options", "WriteToBinaryFile", m_binaryLogCB->IsChecked());
+	ini.Set("Options", "Asynchronous", m_asyncCB->IsChecked());
 
 	// Save all enabled/disabled states of the log types to the config ini.
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
@@ -160,6 +172,19 @@ void LogConfigWindow::OnWriteFileChecked(wxCommandEvent& event)
 	}
 }
 
+void LogConfigWindow::OnAsyncChecked(wxCommandEvent& event)
+{
+	m_LogManager->SetAsync(event.IsChecked());
+	// The binary log needs the log thread
+	m_binaryLogCB->SetValue(m_LogManager->IsBinaryLogEnabled());
+}
+
+void LogConfigWindow::OnBinaryLogChecked(wxCommandEvent& event)
+{
+	m_LogManager->SetBinaryLog(event.IsChecked());
+	m_asyncCB->SetValue(m_LogManager->IsAsync());
+}
+
 void LogConfigWindow::OnWriteWindowChecked(wxCommandEvent& event)
 {
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
@@ -27,7 +27,7 @@ private:
 	bool enableAll;
 
 	// Controls
-	wxCheckBox *m_writeFileCB, *m_writeWindowCB;
+	wxCheckBox *m_writeFileCB, *m_writeWindowCB, *m_asyncCB, *m_binaryLogCB;
 	wxCheckListBox* m_checks;
 	wxRadioBox *m_verbosity;
 
@@ -35,6 +35,8 @@ private:
 	void OnVerbosityChange(wxCommandEvent& event);
 	void OnWriteFileChecked(wxCommandEvent& event);
 	void OnWriteWindowChecked(wxCommandEvent& event);
+	void OnAsyncChecked(wxCommandEvent& event);
+	void OnBinaryLogChecked(wxCommandEvent& event);
 	void OnToggleAll(wxCommandEvent& event);
 	void ToggleLog(int _logType, bool enable);
 	void OnLogCheck(wxCommandEvent& event);
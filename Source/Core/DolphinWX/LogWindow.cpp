@@ -58,6 +58,11 @@ void CLogWindow::CreateGUIControls()
 	// Get the logger output settings from the config ini file.
 	ini.Get("Options", "WriteToFile", &m_writeFile, false);
 	ini.Get("Options", "WriteToWindow", &m_writeWindow, true);
+	bool async, binary_log;
+	ini.Get("Options", "Asynchronous", &async, false);
+	ini.Get("Options", "WriteToBinaryFile", &binary_log, false);
+	m_LogManager->SetAsync(async || binary_log);
+	m_LogManager->SetBinaryLog(binary_log);
 
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
 	{
@@ -175,6 +175,11 @@ bool DolphinApp::OnInit()
 			"Play a movie file",
 			wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL
 		},
+		{
+			wxCMD_LINE_OPTION, "H", "hash_log",
+			"Verify the movie as fast as possible, logging RAM hashes to a file",
+			wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL
+		},
 		{
 			wxCMD_LINE_OPTION, "U", "user",
 			"User folder path",
@@ -201,6 +206,7 @@ bool DolphinApp::OnInit()
 	selectAudioEmulation = parser.Found(wxT("audio_emulation"),
 		&audioEmulationName);
 	playMovie = parser.Found(wxT("movie"), &movieFile);
+	verifyMovie = parser.Found(wxT("hash_log"), &hashLogFile);
 
 	if (parser.Found(wxT("user"), &userPath))
 	{
@@ -363,7 +369,9 @@ void DolphinApp::AfterInit(wxTimerEvent& WXUNUSED(event))
 
 	if (playMovie && movieFile != wxEmptyString)
 	{
-		if (Movie::PlayInput(movieFile.char_str()))
+		if (Movie::PlayInput(movieFile.char_str()) && (!verifyMovie ||
+		    Movie::BeginVerification(WxStrToStr(hashLogFile), SConfig::GetInstance().m_MovieVerifyInterval,
+		                             SConfig::GetInstance().m_MovieVerifySkipEFB)))
 		{
 			if (LoadFile && FileToLoad != wxEmptyString)
 			{
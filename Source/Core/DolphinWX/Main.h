@@ -27,8 +27,10 @@ private:
 	bool BatchMode;
 	bool LoadFile;
 	bool playMovie;
+	bool verifyMovie;
 	wxString FileToLoad;
 	wxString movieFile;
+	wxString hashLogFile;
 	wxLocale *m_locale;
 
 	void AfterInit(wxTimerEvent& WXUNUSED(event));
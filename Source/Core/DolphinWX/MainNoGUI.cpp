@@ -5,14 +5,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <errno.h>
 #include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "Common.h"
 #include "FileUtil.h"
 
 #if HAVE_X11
 #include <X11/keysym.h>
-#include "State.h"
 #include "X11Utils.h"
 #endif
 
@@ -28,14 +32,21 @@
 #include "Core.h"
 #include "Host.h"
 #include "CPUDetect.h"
+#include "Movie.h"
+#include "State.h"
+#include "StringUtil.h"
 #include "Thread.h"
+#include "ThreadPool.h"
+#include "FifoPlayer/FifoBenchmark.h"
 #include "PowerPC/PowerPC.h"
 #include "HW/Wiimote.h"
 
 #include "VideoBackendBase.h"
 #include "ConfigManager.h"
+#include "BinaryLog.h"
 #include "LogManager.h"
 #include "BootManager.h"
+#include "DiscVerifier.h"
 
 bool rendererHasFocus = true;
 bool running = true;
@@ -52,6 +63,7 @@ void Host_Message(int Id)
 	{
 		case WM_USER_STOP:
 			running = false;
+			updateMainFrameEvent.Set();
 			break;
 	}
 }
@@ -278,6 +290,215 @@ void Wayland_MainLoop()
 }
 #endif
 
+// Replays each FIFO log to the end and writes the frame timings of all of them
+// to the report.
+static int RunFifoBenchmark(const std::string& report, int num_files, char** files)
+{
+#if HAVE_X11
+	XInitThreads();
+#endif
+
+	int result = 0;
+	for (int i = 0; i < num_files; ++i)
+	{
+		std::string extension;
+		SplitPath(files[i], NULL, NULL, &extension);
+		if (strcasecmp(extension.c_str(), ".dff"))
+		{
+			fprintf(stderr, "%s is not a FIFO log\n", files[i]);
+			result = 1;
+			continue;
+		}
+
+		fprintf(stderr, "Replaying %s\n", files[i]);
+		running = true;
+		FifoBenchmark::Start();
+		if (BootManager::BootCore(files[i]))
+		{
+			while (running)
+				updateMainFrameEvent.Wait();
+			Core::Stop();
+		}
+		else
+		{
+			result = 1;
+		}
+		FifoBenchmark::Stop(files[i]);
+	}
+
+	if (!FifoBenchmark::WriteReport(report))
+	{
+		fprintf(stderr, "Could not write %s\n", report.c_str());
+		result = 1;
+	}
+	return result;
+}
+
+// Prints the hashes of each disc image, returns 1 if any of them doesn't
+// match its own hash tree or can't be read
+static int RunVerify(int num_files, char** files)
+{
+	int result = 0;
+	for (int i = 0; i < num_files; ++i)
+	{
+		if (!File::Exists(files[i]))
+		{
+			fprintf(stderr, "Could not open %s\n", files[i]);
+			result = 1;
+			continue;
+		}
+
+		DiscIO::DiscVerifyResult verify_result;
+		DiscIO::VerifyDisc(files[i], &verify_result);
+		printf("%s\n%s%s\n\n", files[i], verify_result.ToString().c_str(),
+			verify_result.IsGood() ? "OK" : "BAD");
+		if (!verify_result.IsGood())
+			result = 1;
+	}
+	return result;
+}
+
+// Prints the messages of each binary log as text, returns 1 if any of them
+// can't be read to the end
+static int RunDecodeLog(int num_files, char** files)
+{
+	int result = 0;
+	File::IOFile out(stdout);
+	for (int i = 0; i < num_files; ++i)
+	{
+		if (!BinaryLog::DecodeBinaryLog(files[i], out))
+		{
+			fprintf(stderr, "%s is not a binary log or is damaged\n", files[i]);
+			result = 1;
+		}
+	}
+	out.Flush();
+	out.ReleaseHandle();
+	return result;
+}
+
+// Runs one control socket command, returns the reply line
+static std::string RunServerCommand(const std::string& line, bool* quit)
+{
+	const size_t space = line.find(' ');
+	const std::string command = line.substr(0, space);
+	const std::string argument = (space == std::string::npos) ? "" : StripSpaces(line.substr(space + 1));
+
+	// The game asked to stop by itself, which only cleared running
+	if (!running && Core::GetState() != Core::CORE_UNINITIALIZED)
+		Core::Stop();
+	const bool booted = Core::GetState() != Core::CORE_UNINITIALIZED;
+
+	if (command == "boot")
+	{
+		if (booted)
+			return "error already running";
+		if (argument.empty())
+			return "error no file";
+		running = true;
+		return BootManager::BootCore(argument) ? "ok" : "error boot failed";
+	}
+	else if (command == "status")
+	{
+		if (!booted)
+			return "ok stopped";
+		return (Core::GetState() == Core::CORE_PAUSE) ? "ok paused" : "ok running";
+	}
+	else if (command == "quit")
+	{
+		*quit = true;
+		return "ok";
+	}
+
+	if (!booted)
+		return "error not running";
+
+	if (command == "stop")
+		Core::Stop();
+	else if (command == "pause")
+		Core::SetState(Core::CORE_PAUSE);
+	else if (command == "play")
+		Core::SetState(Core::CORE_RUN);
+	else if (command == "framestep")
+		Movie::DoFrameStep();
+	else if (command == "savestate" && !argument.empty())
+		State::SaveAs(argument, true);
+	else if (command == "loadstate" && !argument.empty())
+		State::LoadAs(argument);
+	else
+		return "error unknown command";
+	return "ok";
+}
+
+// Headless server for automated runs: takes one client at a time on a Unix
+// socket, which sends one command per line and gets "ok" or "error <reason>"
+// back for each. Commands: boot <file>, stop, pause, play, framestep,
+// savestate <file>, loadstate <file>, status and quit.
+static int RunServer(const std::string& socket_path)
+{
+#if HAVE_X11
+	XInitThreads();
+#endif
+
+	// A client which hangs up before its reply is written must not kill us
+	signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "Socket path %s is too long\n", socket_path.c_str());
+		return 1;
+	}
+	strcpy(addr.sun_path, socket_path.c_str());
+
+	const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path.c_str());
+	if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 1) < 0)
+	{
+		fprintf(stderr, "Could not listen on %s: %s\n", socket_path.c_str(), strerror(errno));
+		if (listen_fd >= 0)
+			close(listen_fd);
+		return 1;
+	}
+
+	bool quit = false;
+	while (!quit)
+	{
+		const int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		// Separate streams, a socket can't be seeked when switching directions
+		FILE* in = fdopen(fd, "r");
+		FILE* out = fdopen(dup(fd), "w");
+		char line[1024];
+		while (!quit && in && out && fgets(line, sizeof(line), in))
+		{
+			const std::string reply = RunServerCommand(StripSpaces(line), &quit);
+			fprintf(out, "%s\n", reply.c_str());
+			fflush(out);
+		}
+		if (in)
+			fclose(in);
+		else
+			close(fd);
+		if (out)
+			fclose(out);
+	}
+
+	if (Core::GetState() != Core::CORE_UNINITIALIZED)
+		Core::Stop();
+	close(listen_fd);
+	unlink(socket_path.c_str());
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 #ifdef __APPLE__
@@ -287,18 +508,55 @@ int main(int argc, char* argv[])
 	[NSApp activateIgnoringOtherApps: YES];
 	[NSApp finishLaunching];
 #endif
-	int ch, help = 0;
+	int ch, help = 0, verify = 0, decode_log = 0, binary_log = 0, read_only_caches = 0, threads = 0;
+	std::string benchmark_report, command_report, video_backend, server_socket;
 	struct option longopts[] = {
 		{ "exec",	no_argument,	NULL,	'e' },
+		{ "benchmark",	required_argument,	NULL,	'b' },
+		{ "gx-stats",	required_argument,	NULL,	'g' },
+		{ "video_backend",	required_argument,	NULL,	'V' },
+		{ "verify",	no_argument,	NULL,	'c' },
+		{ "decode-log",	no_argument,	NULL,	'd' },
+		{ "binary-log",	no_argument,	NULL,	'l' },
+		{ "server",	required_argument,	NULL,	's' },
+		{ "read-only-caches",	no_argument,	NULL,	'r' },
+		{ "threads",	required_argument,	NULL,	't' },
 		{ "help",	no_argument,	NULL,	'h' },
 		{ "version",	no_argument,	NULL,	'v' },
 		{ NULL,		0,		NULL,	0 }
 	};
 
-	while ((ch = getopt_long(argc, argv, "eh?v", longopts, 0)) != -1) {
+	while ((ch = getopt_long(argc, argv, "eb:g:V:cdls:rt:h?v", longopts, 0)) != -1) {
 		switch (ch) {
 		case 'e':
 			break;
+		case 'b':
+			benchmark_report = optarg;
+			break;
+		case 'g':
+			command_report = optarg;
+			break;
+		case 'V':
+			video_backend = optarg;
+			break;
+		case 'c':
+			verify = 1;
+			break;
+		case 'd':
+			decode_log = 1;
+			break;
+		case 'l':
+			binary_log = 1;
+			break;
+		case 's':
+			server_socket = optarg;
+			break;
+		case 'r':
+			read_only_caches = 1;
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
 		case 'h':
 		case '?':
 			help = 1;
@@ -309,21 +567,77 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	if (help == 1 || argc == optind) {
+	if (help == 1 || (argc == optind && server_socket.empty())) {
 		fprintf(stderr, "%s\n\n", scm_rev_str);
 		fprintf(stderr, "A multi-platform Gamecube/Wii emulator\n\n");
-		fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v]\n", argv[0]);
+		fprintf(stderr, "Usage: %s [-e <file>] [-b <report> <fifo logs>] [-g <report> <fifo logs>] [-V <backend>] [-c <disc images>] [-d <binary logs>] [-l] [-s <socket>] [-r] [-t <threads>] [-h] [-v]\n", argv[0]);
 		fprintf(stderr, "  -e, --exec	Load the specified file\n");
+		fprintf(stderr, "  -b, --benchmark	Replay the FIFO logs unthrottled and write their frame times to the report\n");
+		fprintf(stderr, "  -g, --gx-stats	Write the GX command counts of each frame of the FIFO logs to the report\n");
+		fprintf(stderr, "  -V, --video_backend	Use the specified video backend\n");
+		fprintf(stderr, "  -c, --verify	Print the hashes of the disc images and check their Wii partitions\n");
+		fprintf(stderr, "  -d, --decode-log	Print the binary logs as text\n");
+		fprintf(stderr, "  -l, --binary-log	Write the log to dolphin.binlog in the logs directory\n");
+		fprintf(stderr, "  -s, --server	Take boot, stop, pause, play, framestep, savestate, loadstate, status and quit commands on the socket\n");
+		fprintf(stderr, "  -r, --read-only-caches	Don't write the shader and JIT caches, so that instances can share them\n");
+		fprintf(stderr, "  -t, --threads	Limit the worker thread pool to this many threads\n");
 		fprintf(stderr, "  -h, --help	Show this help message\n");
 		fprintf(stderr, "  -v, --help	Print version and exit\n");
 		return 1;
 	}
 
+	// Before anything queues a task, which would start the default number of workers
+	if (threads > 0)
+		Common::ThreadPool::Init(threads);
+
 	LogManager::Init();
 	SConfig::Init();
+
+	if (verify)
+	{
+		const int result = RunVerify(argc - optind, argv + optind);
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
+	if (!command_report.empty())
+	{
+		const std::vector<std::string> logs(argv + optind, argv + argc);
+		int result = 0;
+		if (!FifoBenchmark::WriteCommandReport(command_report, logs))
+		{
+			fprintf(stderr, "Could not write %s for all of the FIFO logs\n", command_report.c_str());
+			result = 1;
+		}
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
+	if (decode_log)
+	{
+		const int result = RunDecodeLog(argc - optind, argv + optind);
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
+	if (binary_log)
+		LogManager::GetInstance()->SetBinaryLog(true);
+
 	VideoBackend::PopulateList();
-	VideoBackend::ActivateBackend(SConfig::GetInstance().
-		m_LocalCoreStartupParameter.m_strVideoBackend);
+
+	// Not saved, the backend given on the command line is only for this run
+	std::string& backend_setting = SConfig::GetInstance().m_LocalCoreStartupParameter.m_strVideoBackend;
+	const std::string saved_backend = backend_setting;
+	if (!video_backend.empty())
+		backend_setting = video_backend;
+	bool& read_only_setting = SConfig::GetInstance().m_LocalCoreStartupParameter.bReadOnlyCaches;
+	const bool saved_read_only = read_only_setting;
+	if (read_only_caches)
+		read_only_setting = true;
+	VideoBackend::ActivateBackend(backend_setting);
 	WiimoteReal::LoadSettings();
 
 #if USE_EGL
@@ -333,8 +647,17 @@ int main(int argc, char* argv[])
 	GLWin.wl_display = NULL;
 #endif
 
+	int result = 0;
+	if (!benchmark_report.empty())
+	{
+		result = RunFifoBenchmark(benchmark_report, argc - optind, argv + optind);
+	}
+	else if (!server_socket.empty())
+	{
+		result = RunServer(server_socket);
+	}
 	// No use running the loop when booting fails
-	if (BootManager::BootCore(argv[optind]))
+	else if (BootManager::BootCore(argv[optind]))
 	{
 #if USE_EGL
 		while (GLWin.platform == EGL_PLATFORM_NONE)
@@ -381,10 +704,13 @@ int main(int argc, char* argv[])
 #endif
 	}
 
+	backend_setting = saved_backend;
+	read_only_setting = saved_read_only;
+
 	WiimoteReal::Shutdown();
 	VideoBackend::ClearList();
 	SConfig::Shutdown();
 	LogManager::Shutdown();
 
-	return 0;
+	return result;
 }
@@ -286,6 +286,7 @@ NetPlayDiag::NetPlayDiag(wxWindow* const parent, const CGameListCtrl* const game
 	: wxFrame(parent, wxID_ANY, wxT(NETPLAY_TITLEBAR), wxDefaultPosition, wxDefaultSize)
 	, m_selected_game(game)
 	, m_start_btn(NULL)
+	, m_padbuf_spin(NULL)
 	, m_game_list(game_list)
 {
 	wxPanel* const panel = new wxPanel(this);
@@ -349,10 +350,15 @@ NetPlayDiag::NetPlayDiag(wxWindow* const parent, const CGameListCtrl* const game
 		bottom_szr->Add(m_start_btn);
 
 		bottom_szr->Add(new wxStaticText(panel, wxID_ANY, _("Buffer:")), 0, wxLEFT | wxCENTER, 5 );
-		wxSpinCtrl* const padbuf_spin = new wxSpinCtrl(panel, wxID_ANY, wxT("20")
+		m_padbuf_spin = new wxSpinCtrl(panel, wxID_ANY, wxT("20")
 			, wxDefaultPosition, wxSize(64, -1), wxSP_ARROW_KEYS, 0, 200, INITIAL_PAD_BUFFER_SIZE);
-		padbuf_spin->Bind(wxEVT_COMMAND_SPINCTRL_UPDATED, &NetPlayDiag::OnAdjustBuffer, this);
-		bottom_szr->Add(padbuf_spin, 0, wxCENTER);
+		m_padbuf_spin->Bind(wxEVT_COMMAND_SPINCTRL_UPDATED, &NetPlayDiag::OnAdjustBuffer, this);
+		bottom_szr->Add(m_padbuf_spin, 0, wxCENTER);
+
+		wxCheckBox* const auto_padbuf_chk = new wxCheckBox(panel, wxID_ANY, _("Auto"));
+		auto_padbuf_chk->SetToolTip(_("Size the buffer from the pings of the players"));
+		auto_padbuf_chk->Bind(wxEVT_COMMAND_CHECKBOX_CLICKED, &NetPlayDiag::OnAutoBuffer, this);
+		bottom_szr->Add(auto_padbuf_chk, 0, wxCENTER);
 
 		m_memcard_write = new wxCheckBox(panel, wxID_ANY, _("Write memcards (GC)"));
 		bottom_szr->Add(m_memcard_write, 0, wxCENTER);
@@ -497,6 +503,16 @@ void NetPlayDiag::OnAdjustBuffer(wxCommandEvent& event)
 	m_chat_text->AppendText(StrToWxStr(ss.str()).Append(wxT('\n')));
 }
 
+void NetPlayDiag::OnAutoBuffer(wxCommandEvent& event)
+{
+	netplay_server->SetAutoPadBuffer(event.IsChecked());
+	m_padbuf_spin->Enable(!event.IsChecked());
+
+	// back to the value the spin control shows
+	if (!event.IsChecked())
+		netplay_server->AdjustPadBufferSize(m_padbuf_spin->GetValue());
+}
+
 void NetPlayDiag::OnQuit(wxCommandEvent&)
 {
 	Destroy();
@@ -90,6 +90,7 @@ private:
 	void OnThread(wxCommandEvent& event);
 	void OnChangeGame(wxCommandEvent& event);
 	void OnAdjustBuffer(wxCommandEvent& event);
+	void OnAutoBuffer(wxCommandEvent& event);
 	void OnConfigPads(wxCommandEvent& event);
 	void GetNetSettings(NetSettings &settings);
 	std::string FindGame();
@@ -99,6 +100,7 @@ private:
 	wxTextCtrl*		m_chat_msg_text;
 	wxCheckBox*		m_memcard_write;
 	wxCheckBox*		m_record_chkbox;
+	wxSpinCtrl*		m_padbuf_spin;
 
 	std::string		m_selected_game;
 	wxButton*		m_game_btn;
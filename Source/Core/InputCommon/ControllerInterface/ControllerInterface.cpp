@@ -80,6 +80,9 @@ if (GLWin.platform == EGL_PLATFORM_X11) {
 #endif
 
 	m_is_init = true;
+
+	if (m_poll_interval)
+		StartPolling();
 }
 
 //
@@ -92,6 +95,8 @@ void ControllerInterface::Shutdown()
 	if (!m_is_init)
 		return;
 
+	StopPolling();
+
 	for (Device* d : m_devices)
 	{
 		// Set outputs to ZERO before destroying device
@@ -140,6 +145,47 @@ void ControllerInterface::SetHwnd( void* const hwnd )
 	m_hwnd = hwnd;
 }
 
+//
+// SetPollInterval
+//
+// Moves the polling to or from the poll thread, takes effect right away if the devices are initialized
+//
+void ControllerInterface::SetPollInterval(u32 interval_ms)
+{
+	StopPolling();
+	m_poll_interval = interval_ms;
+	if (m_is_init && m_poll_interval)
+		StartPolling();
+}
+
+void ControllerInterface::StartPolling()
+{
+	m_polling = true;
+	m_poll_thread = std::thread(&ControllerInterface::PollThreadFunc, this);
+}
+
+void ControllerInterface::StopPolling()
+{
+	if (!m_poll_thread.joinable())
+		return;
+
+	m_polling = false;
+	m_poll_thread.join();
+}
+
+void ControllerInterface::PollThreadFunc()
+{
+	Common::SetCurrentThreadName("Input polling");
+
+	while (m_polling)
+	{
+		// The inputs are read while this updates them, like with the GUI
+		// polling, but nobody waits for a slow device anymore
+		UpdateInput(true);
+		Common::SleepCurrentThread(m_poll_interval);
+	}
+}
+
 //
 // UpdateInput
 //
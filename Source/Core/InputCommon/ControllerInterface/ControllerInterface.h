@@ -113,13 +113,19 @@ public:
 		Device::Control* Detect(const unsigned int ms, Device* const device);
 	};
 
-	ControllerInterface() : m_is_init(false), m_hwnd(NULL) {}
+	ControllerInterface() : m_is_init(false), m_hwnd(NULL), m_poll_interval(0), m_polling(false) {}
 
 	void SetHwnd(void* const hwnd);
 	void Initialize();
 	void Shutdown();
 	bool IsInit() const { return m_is_init; }
 
+	// With an interval the devices are polled from a thread of their own,
+	// so a slow device doesn't hold up whoever reads the inputs. 0 leaves
+	// the polling to the callers of UpdateInput.
+	void SetPollInterval(u32 interval_ms);
+	bool IsPolling() const { return m_poll_interval != 0; }
+
 	void UpdateReference(ControlReference* control, const DeviceQualifier& default_device) const;
 	bool UpdateInput(const bool force = false);
 	bool UpdateOutput(const bool force = false);
@@ -127,8 +133,16 @@ public:
 	std::recursive_mutex update_lock;
 
 private:
+	void StartPolling();
+	void StopPolling();
+	void PollThreadFunc();
+
 	bool   m_is_init;
 	void*  m_hwnd;
+
+	u32 m_poll_interval;
+	volatile bool m_polling;
+	std::thread m_poll_thread;
 };
 
 extern ControllerInterface g_controller_interface;
@@ -4,6 +4,7 @@
 
 #include "ExpressionParser.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <string>
@@ -214,6 +215,8 @@ public:
 	virtual ControlState GetValue() { return 0; }
 	virtual void SetValue(ControlState state) {}
 	virtual int CountNumControls() { return 0; }
+	// Appends the node in postfix order, false if it can't be read as an input
+	virtual bool Flatten(std::vector<ExpressionOp> &program) { return false; }
 	virtual operator std::string() { return ""; }
 };
 
@@ -240,6 +243,13 @@ public:
 		return 1;
 	}
 
+	virtual bool Flatten(std::vector<ExpressionOp> &program) override
+	{
+		ExpressionOp op = { ExpressionOp::OP_INPUT, control->ToInput() };
+		program.push_back(op);
+		return op.input != NULL;
+	}
+
 	virtual operator std::string() override
 	{
 		return "`" + (std::string)qualifier + "`";
@@ -291,6 +301,31 @@ public:
 		return lhs->CountNumControls() + rhs->CountNumControls();
 	}
 
+	virtual bool Flatten(std::vector<ExpressionOp> &program) override
+	{
+		if (!lhs->Flatten(program) || !rhs->Flatten(program))
+			return false;
+
+		ExpressionOp::Type type;
+		switch (op)
+		{
+		case TOK_AND:
+			type = ExpressionOp::OP_AND;
+			break;
+		case TOK_OR:
+			type = ExpressionOp::OP_OR;
+			break;
+		case TOK_ADD:
+			type = ExpressionOp::OP_ADD;
+			break;
+		default:
+			return false;
+		}
+		ExpressionOp binary_op = { type, NULL };
+		program.push_back(binary_op);
+		return true;
+	}
+
 	virtual operator std::string() override
 	{
 		return OpName(op) + "(" + (std::string)(*lhs) + ", " + (std::string)(*rhs) + ")";
@@ -338,6 +373,16 @@ public:
 		return inner->CountNumControls();
 	}
 
+	virtual bool Flatten(std::vector<ExpressionOp> &program) override
+	{
+		if (op != TOK_NOT || !inner->Flatten(program))
+			return false;
+
+		ExpressionOp unary_op = { ExpressionOp::OP_NOT, NULL };
+		program.push_back(unary_op);
+		return true;
+	}
+
 	virtual operator std::string() override
 	{
 		return OpName(op) + "(" + (std::string)(*inner) + ")";
@@ -513,9 +558,43 @@ private:
 	}
 };
 
+// Deeper programs, which need a lot of parentheses, walk the tree instead
+static const size_t MAX_PROGRAM_DEPTH = 16;
+
 ControlState Expression::GetValue()
 {
-	return node->GetValue();
+	if (single_input)
+		return single_input->GetState();
+	if (program.empty())
+		return node->GetValue();
+
+	ControlState stack[MAX_PROGRAM_DEPTH];
+	size_t depth = 0;
+	for (const ExpressionOp &op : program)
+	{
+		switch (op.type)
+		{
+		case ExpressionOp::OP_INPUT:
+			stack[depth++] = op.input->GetState();
+			break;
+		case ExpressionOp::OP_AND:
+			--depth;
+			stack[depth - 1] = std::min(stack[depth - 1], stack[depth]);
+			break;
+		case ExpressionOp::OP_OR:
+			--depth;
+			stack[depth - 1] = std::max(stack[depth - 1], stack[depth]);
+			break;
+		case ExpressionOp::OP_ADD:
+			--depth;
+			stack[depth - 1] = std::min(stack[depth - 1] + stack[depth], 1.0f);
+			break;
+		case ExpressionOp::OP_NOT:
+			stack[depth - 1] = 1.0f - stack[depth - 1];
+			break;
+		}
+	}
+	return stack[0];
 }
 
 void Expression::SetValue(ControlState value)
@@ -524,9 +603,31 @@ void Expression::SetValue(ControlState value)
 }
 
 Expression::Expression(ExpressionNode *node_)
+	: single_input(NULL)
 {
 	node = node_;
 	num_controls = node->CountNumControls();
+
+	// Only input expressions flatten, outputs are set through the tree
+	if (!node->Flatten(program))
+	{
+		program.clear();
+		return;
+	}
+
+	size_t depth = 0, max_depth = 0;
+	for (const ExpressionOp &op : program)
+	{
+		if (op.type == ExpressionOp::OP_INPUT)
+			max_depth = std::max(max_depth, ++depth);
+		else if (op.type != ExpressionOp::OP_NOT)
+			--depth;
+	}
+
+	if (program.size() == 1)
+		single_input = program[0].input;
+	if (program.size() == 1 || max_depth > MAX_PROGRAM_DEPTH)
+		program.clear();
 }
 
 Expression::~Expression()
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "Device.h"
 
 namespace ciface
@@ -43,17 +44,39 @@ private:
 	bool is_input;
 };
 
+// One step of an input expression flattened into postfix order
+struct ExpressionOp
+{
+	enum Type
+	{
+		OP_INPUT,
+		OP_AND,
+		OP_OR,
+		OP_ADD,
+		OP_NOT,
+	};
+
+	Type type;
+	Core::Device::Input *input;
+};
+
 class ExpressionNode;
 class Expression
 {
 public:
-	Expression() : node(NULL) {}
+	Expression() : node(NULL), single_input(NULL) {}
 	Expression(ExpressionNode *node);
 	~Expression();
 	ControlState GetValue();
 	void SetValue (ControlState state);
 	int num_controls;
 	ExpressionNode *node;
+
+private:
+	// Inputs are read without walking the tree, a plain binding straight
+	// from its input and anything else from the flattened program
+	Core::Device::Input *single_input;
+	std::vector<ExpressionOp> program;
 };
 
 enum ExpressionParseStatus
@@ -0,0 +1,76 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "VideoConfig.h"
+
+#include "BoundingBox.h"
+
+static ID3D11Buffer* s_bbox_buffer;
+static ID3D11Buffer* s_bbox_staging_buffer;
+static ID3D11UnorderedAccessView* s_bbox_uav;
+
+namespace DX11
+{
+
+ID3D11UnorderedAccessView* BoundingBox::GetUAV()
+{
+	return s_bbox_uav;
+}
+
+void BoundingBox::Init()
+{
+	if (!g_ActiveConfig.backend_info.bSupportsBBox)
+		return;
+
+	int initial_values[4] = { 0, 0, 0, 0 };
+	D3D11_SUBRESOURCE_DATA data = { initial_values, 0, 0 };
+
+	D3D11_BUFFER_DESC desc = CD3D11_BUFFER_DESC(sizeof(initial_values), D3D11_BIND_UNORDERED_ACCESS);
+	HRESULT hr = D3D::device->CreateBuffer(&desc, &data, &s_bbox_buffer);
+	CHECK(SUCCEEDED(hr), "create bounding box buffer");
+	D3D::SetDebugObjectName(s_bbox_buffer, "bounding box buffer");
+
+	// The atomics need a typed view, structured buffers don't support them here
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = CD3D11_UNORDERED_ACCESS_VIEW_DESC(s_bbox_buffer,
+		DXGI_FORMAT_R32_SINT, 0, 4);
+	hr = D3D::device->CreateUnorderedAccessView(s_bbox_buffer, &uav_desc, &s_bbox_uav);
+	CHECK(SUCCEEDED(hr), "create bounding box unordered access view");
+	D3D::SetDebugObjectName(s_bbox_uav, "bounding box uav");
+
+	desc = CD3D11_BUFFER_DESC(sizeof(initial_values), 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+	hr = D3D::device->CreateBuffer(&desc, NULL, &s_bbox_staging_buffer);
+	CHECK(SUCCEEDED(hr), "create bounding box staging buffer");
+	D3D::SetDebugObjectName(s_bbox_staging_buffer, "bounding box staging buffer");
+}
+
+void BoundingBox::Shutdown()
+{
+	SAFE_RELEASE(s_bbox_uav);
+	SAFE_RELEASE(s_bbox_staging_buffer);
+	SAFE_RELEASE(s_bbox_buffer);
+}
+
+void BoundingBox::Set(int index, int value)
+{
+	D3D11_BOX box = { index * sizeof(int), 0, 0, (index + 1) * sizeof(int), 1, 1 };
+	D3D::context->UpdateSubresource(s_bbox_buffer, 0, &box, &value, 0, 0);
+}
+
+int BoundingBox::Get(int index)
+{
+	int data = 0;
+	D3D::context->CopyResource(s_bbox_staging_buffer, s_bbox_buffer);
+
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
+	D3D11_MAPPED_SUBRESOURCE map;
+	HRESULT hr = readback_context->Map(s_bbox_staging_buffer, 0, D3D11_MAP_READ, 0, &map);
+	if (SUCCEEDED(hr))
+	{
+		data = ((int*)map.pData)[index];
+		readback_context->Unmap(s_bbox_staging_buffer, 0);
+	}
+	return data;
+}
+
+}  // namespace DX11
@@ -0,0 +1,29 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "D3DBase.h"
+
+namespace DX11
+{
+
+// The bounding box, extended by the pixel shaders with atomics on an
+// unordered access view. The values are in render target coordinates, see
+// Renderer::BBoxRead for the conversion to EFB coordinates.
+class BoundingBox
+{
+public:
+	static void Init();
+	static void Shutdown();
+
+	// Bound to the pixel shaders next to the render targets,
+	// NULL if the bounding box isn't supported
+	static ID3D11UnorderedAccessView* GetUAV();
+
+	static void Set(int index, int value);
+	static int Get(int index);
+};
+
+}  // namespace DX11
@@ -2,7 +2,10 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <deque>
+
 #include "StringUtil.h"
+#include "Thread.h"
 #include "VideoConfig.h"
 
 #include "D3DBase.h"
@@ -52,6 +55,161 @@ unsigned int xres, yres;
 
 bool bFrameInProgress = false;
 
+// Deferred contexts: the video thread records on context, the submit thread
+// executes the command lists on immediate_context
+static bool deferred = false;
+static ID3D11DeviceContext* immediate_context = NULL;
+static u32 command_list_count = 0;
+
+struct SubmitJob
+{
+	ID3D11CommandList* commands;
+	bool present;
+	bool vsync;
+};
+
+// Frames the recording may run ahead of the submit thread
+static const u32 MAX_QUEUED_FRAMES = 2;
+
+static std::thread submit_thread;
+static std::mutex submit_lock;
+// Held while the submit thread uses the immediate context
+static std::mutex immediate_lock;
+static std::condition_variable submit_changed;
+static std::deque<SubmitJob> submit_queue;
+static u32 queued_frames;
+static bool submit_busy;
+static bool stop_submit;
+
+static void SubmitThread()
+{
+	Common::SetCurrentThreadName("D3D submit thread");
+
+	std::unique_lock<std::mutex> lk(submit_lock);
+	while (true)
+	{
+		submit_changed.wait(lk, [] { return stop_submit || !submit_queue.empty(); });
+		// Stopping only after everything queued is executed
+		if (submit_queue.empty())
+			break;
+
+		SubmitJob job = submit_queue.front();
+		submit_queue.pop_front();
+		submit_busy = true;
+		lk.unlock();
+
+		{
+		std::lock_guard<std::mutex> immediate_lk(immediate_lock);
+		immediate_context->ExecuteCommandList(job.commands, FALSE);
+		job.commands->Release();
+		if (job.present)
+			swapchain->Present((UINT)job.vsync, 0);
+		}
+
+		lk.lock();
+		submit_busy = false;
+		if (job.present)
+			queued_frames--;
+		submit_changed.notify_all();
+	}
+}
+
+static void QueueCommands(bool present)
+{
+	// Keeps the state of the deferred context, the next command list goes on from it
+	ID3D11CommandList* commands = NULL;
+	HRESULT hr = context->FinishCommandList(TRUE, &commands);
+	CHECK(SUCCEEDED(hr), "finish command list (0x%x)", hr);
+	command_list_count++;
+	if (FAILED(hr))
+		return;
+
+	SubmitJob job = { commands, present, g_ActiveConfig.IsVSync() };
+
+	std::unique_lock<std::mutex> lk(submit_lock);
+	if (present)
+	{
+		submit_changed.wait(lk, [] { return queued_frames < MAX_QUEUED_FRAMES; });
+		queued_frames++;
+	}
+	submit_queue.push_back(job);
+	submit_changed.notify_all();
+}
+
+static void StartSubmitThread()
+{
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+	// The command lists emulated by the runtime wouldn't take work off the driver
+	if (!threading.DriverCommandLists)
+	{
+		NOTICE_LOG(VIDEO, "The driver doesn't support command lists, not using deferred contexts.");
+		return;
+	}
+
+	ID3D11DeviceContext* deferred_context;
+	HRESULT hr = device->CreateDeferredContext(0, &deferred_context);
+	if (FAILED(hr))
+	{
+		ERROR_LOG(VIDEO, "Failed to create a deferred context (0x%x).", hr);
+		return;
+	}
+	SetDebugObjectName((ID3D11DeviceChild*)deferred_context, "deferred device context");
+
+	deferred = true;
+	immediate_context = context;
+	context = deferred_context;
+
+	queued_frames = 0;
+	submit_busy = false;
+	stop_submit = false;
+	submit_thread = std::thread(SubmitThread);
+}
+
+static void StopSubmitThread()
+{
+	SyncContext();
+
+	{
+	std::lock_guard<std::mutex> lk(submit_lock);
+	stop_submit = true;
+	}
+	submit_changed.notify_all();
+	submit_thread.join();
+
+	context->ClearState();
+	SAFE_RELEASE(context);
+	context = immediate_context;
+	immediate_context = NULL;
+	deferred = false;
+}
+
+ID3D11DeviceContext* SyncContext()
+{
+	if (!deferred)
+		return context;
+
+	QueueCommands(false);
+
+	std::unique_lock<std::mutex> lk(submit_lock);
+	submit_changed.wait(lk, [] { return submit_queue.empty() && !submit_busy; });
+	return immediate_context;
+}
+
+HRESULT GetDataNoFlush(ID3D11Asynchronous* async, void* data, UINT size)
+{
+	if (!deferred)
+		return context->GetData(async, data, size, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+
+	std::lock_guard<std::mutex> lk(immediate_lock);
+	return immediate_context->GetData(async, data, size, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+}
+
+u32 GetCommandListCount()
+{
+	return command_list_count;
+}
+
 HRESULT LoadDXGI()
 {
 	if (dxgi_dll_ref++ > 0) return S_OK;
@@ -277,12 +435,15 @@ HRESULT Create(HWND wnd)
 	swap_chain_desc.BufferDesc.Width = xres;
 	swap_chain_desc.BufferDesc.Height = yres;
 
+	// The submit thread uses the immediate context while the device creates resources
+	const UINT create_flags = g_ActiveConfig.bDeferredContexts ? 0 : D3D11_CREATE_DEVICE_SINGLETHREADED;
+
 #if defined(_DEBUG) || defined(DEBUGFAST)
 	// Creating debug devices can sometimes fail if the user doesn't have the correct
 	// version of the DirectX SDK. If it does, simply fallback to a non-debug device.
 	{
 		hr = PD3D11CreateDeviceAndSwapChain(adapter, D3D_DRIVER_TYPE_UNKNOWN, NULL,
-											D3D11_CREATE_DEVICE_SINGLETHREADED | D3D11_CREATE_DEVICE_DEBUG,
+											create_flags | D3D11_CREATE_DEVICE_DEBUG,
 											supported_feature_levels, NUM_SUPPORTED_FEATURE_LEVELS,
 											D3D11_SDK_VERSION, &swap_chain_desc, &swapchain, &device,
 											&featlevel, &context);
@@ -292,7 +453,7 @@ HRESULT Create(HWND wnd)
 #endif
 	{
 		hr = PD3D11CreateDeviceAndSwapChain(adapter, D3D_DRIVER_TYPE_UNKNOWN, NULL,
-											D3D11_CREATE_DEVICE_SINGLETHREADED,
+											create_flags,
 											supported_feature_levels, NUM_SUPPORTED_FEATURE_LEVELS,
 											D3D11_SDK_VERSION, &swap_chain_desc, &swapchain, &device,
 											&featlevel, &context);
@@ -307,6 +468,17 @@ HRESULT Create(HWND wnd)
 		return E_FAIL;
 	}
 	SetDebugObjectName((ID3D11DeviceChild*)context, "device context");
+
+	// Every frame DXGI queues up is another frame between input and display
+	if (g_ActiveConfig.iMaxPrerenderedFrames > 0)
+	{
+		IDXGIDevice1* dxgi_device;
+		if (SUCCEEDED(device->QueryInterface(__uuidof(IDXGIDevice1), (void**)&dxgi_device)))
+		{
+			dxgi_device->SetMaximumFrameLatency(g_ActiveConfig.iMaxPrerenderedFrames);
+			dxgi_device->Release();
+		}
+	}
 	SAFE_RELEASE(factory);
 	SAFE_RELEASE(output);
 	SAFE_RELEASE(adapter);
@@ -334,12 +506,18 @@ HRESULT Create(HWND wnd)
 	device->CheckFormatSupport(DXGI_FORMAT_B8G8R8A8_UNORM, &format_support);
 	bgra_textures_supported = (format_support & D3D11_FORMAT_SUPPORT_TEXTURE2D) != 0;
 
+	if (g_ActiveConfig.bDeferredContexts)
+		StartSubmitThread();
+
 	stateman = new StateManager;
 	return S_OK;
 }
 
 void Close()
 {
+	if (deferred)
+		StopSubmitThread();
+
 	// release all bound resources
 	context->ClearState();
 	SAFE_RELEASE(backbuf);
@@ -417,6 +595,13 @@ unsigned int GetMaxTextureSize()
 
 void Reset()
 {
+	// The bound state and the queued command lists hold references, too
+	if (deferred)
+	{
+		context->OMSetRenderTargets(0, NULL, NULL);
+		SyncContext();
+	}
+
 	// release all back buffer references
 	SAFE_RELEASE(backbuf);
 
@@ -468,6 +653,12 @@ void EndFrame()
 
 void Present()
 {
+	if (deferred)
+	{
+		QueueCommands(true);
+		return;
+	}
+
 	// TODO: Is 1 the correct value for vsyncing?
 	swapchain->Present((UINT)g_ActiveConfig.IsVSync(), 0);
 }
@@ -47,6 +47,23 @@ bool BeginFrame();
 void EndFrame();
 void Present();
 
+// With Hacks/DeferredContexts, context is a deferred context. Its commands are
+// handed to a submit thread on every Present, which executes them on the
+// immediate context and presents the frame, while the next one gets recorded.
+
+// Hands the commands recorded so far to the submit thread and waits until
+// they are executed. Returns the immediate context, which may then map staging
+// resources for reading. Without deferred contexts, this simply returns context.
+ID3D11DeviceContext* SyncContext();
+
+// GetData with D3D11_ASYNC_GETDATA_DONOTFLUSH on the immediate context
+HRESULT GetDataNoFlush(ID3D11Asynchronous* async, void* data, UINT size);
+
+// Increased with every command list. A deferred context has to map a dynamic
+// buffer with D3D11_MAP_WRITE_DISCARD before it may use D3D11_MAP_WRITE_NO_OVERWRITE
+// in the same command list.
+u32 GetCommandListCount();
+
 unsigned int GetBackBufferWidth();
 unsigned int GetBackBufferHeight();
 D3DTexture2D* &GetBackBuffer();
@@ -4,6 +4,7 @@
 
 #include <string>
 
+#include "PerfTrace.h"
 #include "VideoConfig.h"
 
 #include "D3DBase.h"
@@ -29,6 +30,8 @@ ID3D11VertexShader* CreateVertexShaderFromByteCode(const void* bytecode, unsigne
 // code->bytecode
 bool CompileVertexShader(const char* code, unsigned int len, D3DBlob** blob)
 {
+	PERF_SCOPE(CAT_SHADER_COMPILE);
+
 	ID3D10Blob* shaderBuffer = NULL;
 	ID3D10Blob* errorBuffer = NULL;
 
@@ -86,6 +89,8 @@ ID3D11GeometryShader* CreateGeometryShaderFromByteCode(const void* bytecode, uns
 bool CompileGeometryShader(const char* code, unsigned int len, D3DBlob** blob,
 	const D3D_SHADER_MACRO* pDefines)
 {
+	PERF_SCOPE(CAT_SHADER_COMPILE);
+
 	ID3D10Blob* shaderBuffer = NULL;
 	ID3D10Blob* errorBuffer = NULL;
 
@@ -146,6 +151,8 @@ ID3D11PixelShader* CreatePixelShaderFromByteCode(const void* bytecode, unsigned
 bool CompilePixelShader(const char* code, unsigned int len, D3DBlob** blob,
 	const D3D_SHADER_MACRO* pDefines)
 {
+	PERF_SCOPE(CAT_SHADER_COMPILE);
+
 	ID3D10Blob* shaderBuffer = NULL;
 	ID3D10Blob* errorBuffer = NULL;
 
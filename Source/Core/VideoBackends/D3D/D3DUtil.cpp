@@ -21,7 +21,7 @@ namespace D3D
 class UtilVertexBuffer
 {
 public:
-	UtilVertexBuffer(int size) : buf(NULL), offset(0), max_size(size)
+	UtilVertexBuffer(int size) : buf(NULL), offset(0), max_size(size), command_list(GetCommandListCount())
 	{
 		D3D11_BUFFER_DESC desc = CD3D11_BUFFER_DESC(max_size, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
 		device->CreateBuffer(&desc, NULL, &buf);
@@ -35,10 +35,12 @@ public:
 	int AppendData(void* data, int size, int vertex_size)
 	{
 		D3D11_MAPPED_SUBRESOURCE map;
-		if(offset + size >= max_size)
+		// A deferred context has to discard the buffer in each command list
+		if(offset + size >= max_size || command_list != GetCommandListCount())
 		{
 			// wrap buffer around and notify observers
 			offset = 0;
+			command_list = GetCommandListCount();
 			context->Map(buf, 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
 
 			for(bool* observer : observers)
@@ -67,6 +69,7 @@ private:
 	ID3D11Buffer* buf;
 	int offset;
 	int max_size;
+	u32 command_list;
 
 	std::list<bool*> observers;
 };
@@ -493,12 +496,12 @@ void ShutdownUtils()
 
 void SetPointCopySampler()
 {
-	D3D::context->PSSetSamplers(0, 1, &point_copy_sampler);
+	D3D::stateman->SetSampler(0, point_copy_sampler);
 }
 
 void SetLinearCopySampler()
 {
-	D3D::context->PSSetSamplers(0, 1, &linear_copy_sampler);
+	D3D::stateman->SetSampler(0, linear_copy_sampler);
 }
 
 void drawShadedTexQuad(ID3D11ShaderResourceView* texture,
@@ -7,6 +7,7 @@
 #include "d3d11.h"
 
 #include "FramebufferManagerBase.h"
+#include "RenderTargetPool.h"
 
 #include "D3DTexture.h"
 
@@ -44,10 +45,33 @@ namespace DX11 {
 // There may be multiple XFBs in GameCube RAM. This is the maximum number to
 // virtualize.
 
+class RenderTargetPool : public ::RenderTargetPool<D3DTexture2D*>
+{
+public:
+	enum TargetKind
+	{
+		TARGET_COLOR, // also the virtual XFBs
+		TARGET_DEPTH,
+		TARGET_RESOLVED_COLOR,
+		TARGET_RESOLVED_DEPTH,
+	};
+
+	~RenderTargetPool() { Clear(); }
+
+	static RenderTargetKey MakeKey(u32 width, u32 height, TargetKind kind, const DXGI_SAMPLE_DESC& sample_desc);
+
+private:
+	D3DTexture2D* CreateTarget(const RenderTargetKey& key);
+	void DestroyTarget(const RenderTargetKey& key, D3DTexture2D* target);
+	u64 GetTargetSize(const RenderTargetKey& key) const;
+};
+
+extern RenderTargetPool* g_render_target_pool;
+
 struct XFBSource : public XFBSourceBase
 {
-	XFBSource(D3DTexture2D *_tex) : tex(_tex) {}
-	~XFBSource() { tex->Release(); }
+	XFBSource(D3DTexture2D *_tex, const RenderTargetKey& key) : tex(_tex), pool_key(key) {}
+	~XFBSource() { g_render_target_pool->Release(pool_key, tex); }
 
 	void Draw(const MathUtil::Rectangle<int> &sourcerc,
 		const MathUtil::Rectangle<float> &drawrc) const;
@@ -55,8 +79,12 @@ struct XFBSource : public XFBSourceBase
 	void CopyEFB(float Gamma);
 
 	D3DTexture2D* const tex;
+	const RenderTargetKey pool_key;
 };
 
+// EFB peeks read and cache blocks of this many pixels squared
+static const u32 EFB_CACHE_RECT_SIZE = 64;
+
 class FramebufferManager : public FramebufferManagerBase
 {
 public:
@@ -64,6 +92,7 @@ public:
 	~FramebufferManager();
 
 	static D3DTexture2D* &GetEFBColorTexture();
+	static D3DTexture2D* &GetEFBColorReadTexture();
 	static ID3D11Texture2D* &GetEFBColorStagingBuffer();
 
 	static D3DTexture2D* &GetEFBDepthTexture();
@@ -87,10 +116,17 @@ private:
 
 	void CopyToRealXFB(u32 xfbAddr, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc,float Gamma);
 
+	// The keys the EFB targets were taken from the pool with
+	RenderTargetKey m_color_key;
+	RenderTargetKey m_depth_key;
+	RenderTargetKey m_resolved_color_key;
+	RenderTargetKey m_resolved_depth_key;
+
 	static struct Efb
 	{
 		D3DTexture2D* color_tex;
 		ID3D11Texture2D* color_staging_buf;
+		D3DTexture2D* color_read_texture;
 
 		D3DTexture2D* depth_tex;
 		ID3D11Texture2D* depth_staging_buf;
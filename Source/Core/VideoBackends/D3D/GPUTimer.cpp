@@ -0,0 +1,165 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "DynamicResolution.h"
+#include "Thread.h"
+
+#include "GPUTimer.h"
+
+namespace DX11
+{
+
+GPUTimer::GPUTimer()
+	: m_read_pos(0), m_count(0), m_in_frame(false)
+{
+	const D3D11_QUERY_DESC disjoint_desc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP_DISJOINT, 0);
+	const D3D11_QUERY_DESC timestamp_desc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP, 0);
+	for (FrameQueries& frame : m_frames)
+	{
+		D3D::device->CreateQuery(&disjoint_desc, &frame.disjoint);
+		D3D::device->CreateQuery(&timestamp_desc, &frame.begin);
+		D3D::device->CreateQuery(&timestamp_desc, &frame.end);
+	}
+}
+
+GPUTimer::~GPUTimer()
+{
+	for (FrameQueries& frame : m_frames)
+	{
+		SAFE_RELEASE(frame.disjoint);
+		SAFE_RELEASE(frame.begin);
+		SAFE_RELEASE(frame.end);
+	}
+}
+
+void GPUTimer::BeginFrame()
+{
+	m_in_frame = m_count < NUM_FRAMES;
+	if (m_in_frame)
+	{
+		FrameQueries& frame = m_frames[(m_read_pos + m_count) % NUM_FRAMES];
+		D3D::context->Begin(frame.disjoint);
+		D3D::context->End(frame.begin);
+	}
+}
+
+void GPUTimer::EndFrame()
+{
+	if (m_in_frame)
+	{
+		FrameQueries& frame = m_frames[(m_read_pos + m_count) % NUM_FRAMES];
+		D3D::context->End(frame.end);
+		D3D::context->End(frame.disjoint);
+		m_count++;
+		m_in_frame = false;
+	}
+
+	while (m_count)
+	{
+		FrameQueries& frame = m_frames[m_read_pos];
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+		UINT64 begin, end;
+		if (D3D::GetDataNoFlush(frame.disjoint, &disjoint, sizeof(disjoint)) != S_OK ||
+		    D3D::GetDataNoFlush(frame.begin, &begin, sizeof(begin)) != S_OK ||
+		    D3D::GetDataNoFlush(frame.end, &end, sizeof(end)) != S_OK)
+			break;
+
+		if (!disjoint.Disjoint && disjoint.Frequency)
+			DynamicResolution::AddFrameTime((float)((double)(end - begin) * 1000.0 / (double)disjoint.Frequency));
+
+		m_read_pos = (m_read_pos + 1) % NUM_FRAMES;
+		m_count--;
+	}
+}
+
+DrawTimer::DrawTimer()
+	: m_frame(0), m_in_frame(false)
+{
+}
+
+DrawTimer::~DrawTimer()
+{
+	if (m_in_frame)
+		D3D::context->End(m_disjoint[m_frame]);
+	for (ID3D11Query* query : m_queries)
+		SAFE_RELEASE(query);
+	for (ID3D11Query* query : m_disjoint)
+		SAFE_RELEASE(query);
+}
+
+void DrawTimer::Reset()
+{
+	if (m_in_frame)
+		D3D::context->End(m_disjoint[m_frame]);
+	m_frame = 0;
+	m_in_frame = false;
+}
+
+void DrawTimer::Timestamp(u32 index)
+{
+	if (!m_in_frame)
+	{
+		if (m_frame == m_disjoint.size())
+		{
+			const D3D11_QUERY_DESC disjoint_desc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP_DISJOINT, 0);
+			m_disjoint.push_back(NULL);
+			D3D::device->CreateQuery(&disjoint_desc, &m_disjoint.back());
+		}
+		D3D::context->Begin(m_disjoint[m_frame]);
+		m_in_frame = true;
+	}
+
+	if (index >= m_queries.size())
+	{
+		const D3D11_QUERY_DESC timestamp_desc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP, 0);
+		size_t old_size = m_queries.size();
+		m_queries.resize(std::max<size_t>(old_size * 2, 1024));
+		m_query_frames.resize(m_queries.size());
+		for (size_t i = old_size; i < m_queries.size(); ++i)
+			D3D::device->CreateQuery(&timestamp_desc, &m_queries[i]);
+	}
+	D3D::context->End(m_queries[index]);
+	m_query_frames[index] = m_frame;
+}
+
+void DrawTimer::EndFrame()
+{
+	if (m_in_frame)
+	{
+		D3D::context->End(m_disjoint[m_frame]);
+		m_frame++;
+		m_in_frame = false;
+	}
+}
+
+// Waits for the query, GetData without the DONOTFLUSH flag also submits it
+template <typename T>
+static bool GetQueryData(ID3D11Query* query, T* data)
+{
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
+	HRESULT hr;
+	while ((hr = readback_context->GetData(query, data, sizeof(T), 0)) == S_FALSE)
+		Common::YieldCPU();
+	return hr == S_OK;
+}
+
+u64 DrawTimer::GetElapsed(u32 begin, u32 end)
+{
+	if (end >= m_queries.size() || m_query_frames[end] >= m_frame)
+		return 0;
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	UINT64 begin_time, end_time;
+	if (!GetQueryData(m_disjoint[m_query_frames[end]], &disjoint) ||
+	    !GetQueryData(m_queries[begin], &begin_time) ||
+	    !GetQueryData(m_queries[end], &end_time) ||
+	    disjoint.Disjoint || !disjoint.Frequency || end_time < begin_time)
+		return 0;
+
+	return (u64)((double)(end_time - begin_time) * 1000000000.0 / (double)disjoint.Frequency);
+}
+
+}  // namespace DX11
@@ -0,0 +1,71 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "D3DBase.h"
+#include "Debugger.h"
+
+namespace DX11
+{
+
+// Times the frames on the GPU with timestamp queries, for the dynamic
+// resolution. The results are read a few frames later, when they are ready,
+// so measuring never waits for the GPU.
+class GPUTimer
+{
+public:
+	GPUTimer();
+	~GPUTimer();
+
+	// Called after a frame was presented and before the next one is drawn
+	void BeginFrame();
+	// Called once the frame was drawn, passes the ready results to DynamicResolution
+	void EndFrame();
+
+private:
+	// Frames in flight. A frame isn't timed if all of them are still pending.
+	static const u32 NUM_FRAMES = 4;
+
+	struct FrameQueries
+	{
+		// The timestamps are only usable if the frequency didn't change in between
+		ID3D11Query* disjoint;
+		ID3D11Query* begin;
+		ID3D11Query* end;
+	};
+
+	FrameQueries m_frames[NUM_FRAMES];
+	u32 m_read_pos;
+	u32 m_count;
+	bool m_in_frame;
+};
+
+// The timestamps of the GFX debugger's draw capture. The queries are only
+// read once the capture is over.
+class DrawTimer : public GFXDebuggerDrawTimer
+{
+public:
+	DrawTimer();
+	~DrawTimer();
+
+	void Reset() override;
+	void Timestamp(u32 index) override;
+	void EndFrame() override;
+	u64 GetElapsed(u32 begin, u32 end) override;
+
+private:
+	// Kept between captures
+	std::vector<ID3D11Query*> m_queries;
+	std::vector<ID3D11Query*> m_disjoint;
+
+	// The frame of each timestamp, for the frequency in its disjoint query
+	std::vector<u32> m_query_frames;
+	u32 m_frame;
+	bool m_in_frame;
+};
+
+}  // namespace DX11
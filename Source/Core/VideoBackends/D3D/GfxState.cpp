@@ -2,8 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cstring>
+
 #include "Log.h"
 
+#include "VideoConfig.h"
+
 #include "D3DBase.h"
 #include "GfxState.h"
 
@@ -33,7 +37,11 @@ template<typename T> AutoState<T>::~AutoState()
 	state = NULL;
 }
 
-StateManager::StateManager() : cur_blendstate(NULL), cur_depthstate(NULL), cur_raststate(NULL) {}
+StateManager::StateManager() : cur_blendstate(NULL), cur_depthstate(NULL), cur_raststate(NULL)
+{
+	for (ID3D11SamplerState*& sampler : cur_samplers)
+		sampler = NULL;
+}
 
 void StateManager::PushBlendState(const ID3D11BlendState* state) { blendstates.push(AutoBlendState(state)); }
 void StateManager::PushDepthState(const ID3D11DepthStencilState* state) { depthstates.push(AutoDepthStencilState(state)); }
@@ -75,6 +83,170 @@ void StateManager::Apply()
 	else ERROR_LOG(VIDEO, "Tried to apply without rasterizer state!");
 }
 
+void StateManager::SetSampler(unsigned int stage, ID3D11SamplerState* sampler)
+{
+	// The context holds a reference to bound samplers, so a pointer can't be
+	// reused by another sampler while it's still in the array
+	if (cur_samplers[stage] == sampler)
+		return;
+
+	cur_samplers[stage] = sampler;
+	D3D::context->PSSetSamplers(stage, 1, &sampler);
+}
+
+// Packs the fields of the descriptions which the GX pipeline changes
+static u64 GetPipelineKey(const D3D11_BLEND_DESC& blend, const D3D11_DEPTH_STENCIL_DESC& depth,
+	const D3D11_RASTERIZER_DESC& raster)
+{
+	const D3D11_RENDER_TARGET_BLEND_DESC& target = blend.RenderTarget[0];
+	u64 key = target.BlendEnable ? 1 : 0;
+	key |= (u64)target.SrcBlend << 1;        // 5 bits
+	key |= (u64)target.DestBlend << 6;       // 5 bits
+	key |= (u64)target.BlendOp << 11;        // 3 bits
+	key |= (u64)target.SrcBlendAlpha << 14;  // 5 bits
+	key |= (u64)target.DestBlendAlpha << 19; // 5 bits
+	key |= (u64)target.BlendOpAlpha << 24;   // 3 bits
+	key |= (u64)target.RenderTargetWriteMask << 27; // 4 bits
+	key |= (u64)(depth.DepthEnable ? 1 : 0) << 31;
+	key |= (u64)depth.DepthWriteMask << 32;  // 1 bit
+	key |= (u64)depth.DepthFunc << 33;       // 4 bits
+	key |= (u64)raster.FillMode << 37;       // 2 bits
+	key |= (u64)raster.CullMode << 39;       // 2 bits
+	return key;
+}
+
+const PipelineState& StateCache::Get(const D3D11_BLEND_DESC& blend, const D3D11_DEPTH_STENCIL_DESC& depth,
+	const D3D11_RASTERIZER_DESC& raster)
+{
+	const u64 key = GetPipelineKey(blend, depth, raster);
+	auto it = m_pipeline_states.find(key);
+	if (it != m_pipeline_states.end())
+		return it->second;
+
+	PipelineState state = {};
+	HRESULT hr = D3D::device->CreateBlendState(&blend, &state.blend);
+	if (FAILED(hr)) PanicAlert("Failed to create blend state at %s %d\n", __FILE__, __LINE__);
+	else D3D::SetDebugObjectName((ID3D11DeviceChild*)state.blend, "blend state used to emulate the GX pipeline");
+
+	hr = D3D::device->CreateDepthStencilState(&depth, &state.depth);
+	if (FAILED(hr)) PanicAlert("Failed to create depth state at %s %d\n", __FILE__, __LINE__);
+	else D3D::SetDebugObjectName((ID3D11DeviceChild*)state.depth, "depth-stencil state used to emulate the GX pipeline");
+
+	hr = D3D::device->CreateRasterizerState(&raster, &state.raster);
+	if (FAILED(hr)) PanicAlert("Failed to create rasterizer state at %s %d\n", __FILE__, __LINE__);
+	else D3D::SetDebugObjectName((ID3D11DeviceChild*)state.raster, "rasterizer state used to emulate the GX pipeline");
+
+	return m_pipeline_states.insert(std::make_pair(key, state)).first->second;
+}
+
+static D3D11_SAMPLER_DESC GetSamplerDesc(SamplerState state)
+{
+	enum { TEXF_NONE, TEXF_POINT, TEXF_LINEAR };
+	static const unsigned int d3dMipFilters[4] =
+	{
+		TEXF_NONE,
+		TEXF_POINT,
+		TEXF_LINEAR,
+		TEXF_NONE, //reserved
+	};
+	static const D3D11_TEXTURE_ADDRESS_MODE d3dClamps[4] =
+	{
+		D3D11_TEXTURE_ADDRESS_CLAMP,
+		D3D11_TEXTURE_ADDRESS_WRAP,
+		D3D11_TEXTURE_ADDRESS_MIRROR,
+		D3D11_TEXTURE_ADDRESS_WRAP //reserved
+	};
+	// Indexed by linear min filter, linear mag filter and mip filter
+	static const D3D11_FILTER d3dFilters[2][2][3] =
+	{
+		{
+			{ D3D11_FILTER_MIN_MAG_MIP_POINT, D3D11_FILTER_MIN_MAG_MIP_POINT, D3D11_FILTER_MIN_MAG_POINT_MIP_LINEAR },
+			{ D3D11_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT, D3D11_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT, D3D11_FILTER_MIN_POINT_MAG_MIP_LINEAR },
+		},
+		{
+			{ D3D11_FILTER_MIN_LINEAR_MAG_MIP_POINT, D3D11_FILTER_MIN_LINEAR_MAG_MIP_POINT, D3D11_FILTER_MIN_LINEAR_MAG_POINT_MIP_LINEAR },
+			{ D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT, D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT, D3D11_FILTER_MIN_MAG_MIP_LINEAR },
+		},
+	};
+
+	const TexMode0& tm0 = state.tm0;
+	const TexMode1& tm1 = state.tm1;
+	const unsigned int mip = d3dMipFilters[tm0.min_filter & 3];
+
+	const float border[4] = {0.f, 0.f, 0.f, 0.f};
+	D3D11_SAMPLER_DESC desc = CD3D11_SAMPLER_DESC(D3D11_FILTER_MIN_MAG_MIP_LINEAR,
+		d3dClamps[tm0.wrap_s], d3dClamps[tm0.wrap_t], D3D11_TEXTURE_ADDRESS_CLAMP,
+		(s32)tm0.lod_bias/32.0f, 1 << g_ActiveConfig.iMaxAnisotropy,
+		D3D11_COMPARISON_ALWAYS, border,
+		(float)tm1.min_lod/16.f,
+		// When mipfilter is set to "none", just disable mipmapping altogether
+		(mip == TEXF_NONE) ? 0.0f : (float)tm1.max_lod/16.f);
+
+	if (g_ActiveConfig.iMaxAnisotropy > 0)
+		desc.Filter = D3D11_FILTER_ANISOTROPIC;
+	else if (!g_ActiveConfig.bForceFiltering)
+		desc.Filter = d3dFilters[(tm0.min_filter & 4) ? 1 : 0][tm0.mag_filter][mip];
+
+	return desc;
+}
+
+ID3D11SamplerState* StateCache::Get(SamplerState state)
+{
+	// The registers only hold 24 bits, the top byte is left for the settings
+	// which change the description
+	const u64 key = state.hex | ((u64)g_ActiveConfig.iMaxAnisotropy << 56) |
+		((u64)g_ActiveConfig.bForceFiltering << 63);
+
+	ID3D11SamplerState*& entry = m_samplers[key];
+	if (entry)
+		return entry;
+
+	const D3D11_SAMPLER_DESC desc = GetSamplerDesc(state);
+	HRESULT hr = D3D::device->CreateSamplerState(&desc, &entry);
+	if (FAILED(hr)) PanicAlert("Failed to create sampler state at %s %d\n", __FILE__, __LINE__);
+	else D3D::SetDebugObjectName((ID3D11DeviceChild*)entry, "sampler state used to emulate the GX pipeline");
+
+	return entry;
+}
+
+void StateCache::CreateCommonSamplers()
+{
+	// Point, linear and trilinear minification, with either magnification
+	// filter and every wrap mode, and all mip levels.
+	static const u32 min_filters[] = { 0, 4, 6 };
+	for (u32 min_filter : min_filters)
+	{
+		for (u32 mag_filter = 0; mag_filter < 2; ++mag_filter)
+		{
+			for (u32 wrap = 0; wrap < 9; ++wrap)
+			{
+				SamplerState state;
+				state.hex = 0;
+				state.tm0.wrap_s = wrap % 3;
+				state.tm0.wrap_t = wrap / 3;
+				state.tm0.mag_filter = mag_filter;
+				state.tm0.min_filter = min_filter;
+				state.tm1.max_lod = 0xFF;
+				Get(state);
+			}
+		}
+	}
+}
+
+void StateCache::Clear()
+{
+	for (auto& it : m_pipeline_states)
+	{
+		SAFE_RELEASE(it.second.blend);
+		SAFE_RELEASE(it.second.depth);
+		SAFE_RELEASE(it.second.raster);
+	}
+	m_pipeline_states.clear();
+
+	m_samplers.ForEach([](u64, ID3D11SamplerState*& sampler) { SAFE_RELEASE(sampler); });
+	m_samplers.Clear();
+}
+
 }  // namespace
 
 }  // namespace DX11
\ No newline at end of file
@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <d3d11.h>
 #include <stack>
+#include <unordered_map>
 
-struct ID3D11BlendState;
-struct ID3D11DepthStencilState;
-struct ID3D11RasterizerState;
+#include "CommonTypes.h"
+#include "FlatHashMap.h"
+
+#include "BPMemory.h"
 
 namespace DX11
 {
@@ -51,6 +54,9 @@ public:
 	// call this before any drawing operation if states could have changed meanwhile
 	void Apply();
 
+	// Binds the sampler right away unless it's already bound to the stage
+	void SetSampler(unsigned int stage, ID3D11SamplerState* sampler);
+
 private:
 	std::stack<AutoBlendState> blendstates;
 	std::stack<AutoDepthStencilState> depthstates;
@@ -58,10 +64,54 @@ private:
 	ID3D11BlendState* cur_blendstate;
 	ID3D11DepthStencilState* cur_depthstate;
 	ID3D11RasterizerState* cur_raststate;
+	ID3D11SamplerState* cur_samplers[8];
 };
 
 extern StateManager* stateman;
 
+// The texture mode registers of a stage, which is all a sampler state is built from
+union SamplerState
+{
+	struct
+	{
+		TexMode0 tm0;
+		TexMode1 tm1;
+	};
+	u64 hex;
+};
+
+struct PipelineState
+{
+	ID3D11BlendState* blend;
+	ID3D11DepthStencilState* depth;
+	ID3D11RasterizerState* raster;
+};
+
+// Creates the state objects for every combination of GX pipeline states only once,
+// so that applying the state of a draw is a single lookup.
+class StateCache
+{
+public:
+	// Only the fields which are changed to emulate the GX pipeline are compared,
+	// the others are expected to stay the same for every call.
+	// The returned objects are owned by the cache.
+	const PipelineState& Get(const D3D11_BLEND_DESC& blend, const D3D11_DEPTH_STENCIL_DESC& depth,
+		const D3D11_RASTERIZER_DESC& raster);
+	ID3D11SamplerState* Get(SamplerState state);
+
+	// Creates the samplers of the common filter and wrap mode combinations, so that
+	// games don't create them while drawing their first frames.
+	void CreateCommonSamplers();
+
+	// Releases all cached objects.
+	void Clear();
+
+private:
+	std::unordered_map<u64, PipelineState> m_pipeline_states;
+	// Keyed by the texture modes and the filtering settings
+	FlatHashMap<u64, ID3D11SamplerState*> m_samplers;
+};
+
 }  // namespace
 
 }  // namespace DX11
\ No newline at end of file
@@ -6,7 +6,8 @@
 namespace DX11 {
 
 PerfQuery::PerfQuery()
-	: m_query_read_pos()
+	: m_query_buffer(PERF_QUERY_BUFFER_SIZE)
+	, m_query_read_pos()
 	, m_query_count()
 {
 	for (ActiveQuery& entry : m_query_buffer)
@@ -35,9 +36,16 @@ void PerfQuery::EnableQuery(PerfQueryGroup type)
 
 	if (m_query_buffer.size() == m_query_count)
 	{
-		// TODO
-		FlushOne();
-		ERROR_LOG(VIDEO, "Flushed query buffer early!");
+		if (m_query_buffer.size() < PERF_QUERY_BUFFER_MAX_SIZE)
+		{
+			GrowBuffer();
+		}
+		else
+		{
+			// TODO
+			FlushOne();
+			ERROR_LOG(VIDEO, "Flushed query buffer early!");
+		}
 	}
 
 	// start query
@@ -92,16 +100,32 @@ u32 PerfQuery::GetQueryResult(PerfQueryType type)
 	return result / 4;
 }
 
+void PerfQuery::GrowBuffer()
+{
+	std::vector<ActiveQuery> buffer(m_query_buffer.size() * 2);
+	for (int i = 0; i != m_query_buffer.size(); ++i)
+		buffer[i] = m_query_buffer[(m_query_read_pos + i) % m_query_buffer.size()];
+	for (int i = m_query_buffer.size(); i != buffer.size(); ++i)
+	{
+		D3D11_QUERY_DESC qdesc = CD3D11_QUERY_DESC(D3D11_QUERY_OCCLUSION, 0);
+		D3D::device->CreateQuery(&qdesc, &buffer[i].query);
+	}
+
+	m_query_buffer.swap(buffer);
+	m_query_read_pos = 0;
+}
+
 void PerfQuery::FlushOne()
 {
 	auto& entry = m_query_buffer[m_query_read_pos];
 
 	UINT64 result = 0;
 	HRESULT hr = S_FALSE;
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
 	while (hr != S_OK)
 	{
 		// TODO: Might cause us to be stuck in an infinite loop!
-		hr = D3D::context->GetData(entry.query, &result, sizeof(result), 0);
+		hr = readback_context->GetData(entry.query, &result, sizeof(result), 0);
 	}
 
 	// NOTE: Reported pixel metrics should be referenced to native resolution
@@ -125,7 +149,7 @@ void PerfQuery::WeakFlush()
 		auto& entry = m_query_buffer[m_query_read_pos];
 
 		UINT64 result = 0;
-		HRESULT hr = D3D::context->GetData(entry.query, &result, sizeof(result), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		HRESULT hr = D3D::GetDataNoFlush(entry.query, &result, sizeof(result));
 
 		if (hr == S_OK)
 		{
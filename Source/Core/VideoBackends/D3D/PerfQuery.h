@@ -1,6 +1,7 @@
 #pragma once
 
-#include <array>
+#include <vector>
+
 #include "PerfQueryBase.h"
 
 namespace DX11 {
@@ -16,6 +17,7 @@ public:
 	void ResetQuery();
 	u32 GetQueryResult(PerfQueryType type);
 	void FlushResults();
+	void WeakFlush();
 	bool IsFlushed() const;
 
 private:
@@ -25,15 +27,17 @@ private:
 		PerfQueryGroup query_type;
 	};
 
-	void WeakFlush();
-
+	// Doubles the buffer, keeping the pending queries in order.
+	void GrowBuffer();
 	// Only use when non-empty
 	void FlushOne();
 
 	// when testing in SMS: 64 was too small, 128 was ok
 	static const int PERF_QUERY_BUFFER_SIZE = 512;
+	// The buffer grows instead of waiting for the GPU, up to this size.
+	static const int PERF_QUERY_BUFFER_MAX_SIZE = PERF_QUERY_BUFFER_SIZE * 32;
 
-	std::array<ActiveQuery, PERF_QUERY_BUFFER_SIZE> m_query_buffer;
+	std::vector<ActiveQuery> m_query_buffer;
 	int m_query_read_pos;
 
 	// TODO: sloppy
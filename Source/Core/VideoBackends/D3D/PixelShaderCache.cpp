@@ -4,6 +4,8 @@
 
 #include "FileUtil.h"
 #include "LinearDiskCache.h"
+#include "ThreadPool.h"
+#include "Timer.h"
 
 #include "Debugger.h"
 #include "Statistics.h"
@@ -349,14 +351,16 @@ ID3D11Buffer* &PixelShaderCache::GetConstantBuffer()
 	return pscbuf;
 }
 
-// this class will load the precompiled shaders into our cache
+// this class will collect the precompiled shaders, they are created in parallel afterwards
 class PixelShaderCacheInserter : public LinearDiskCacheReader<PixelShaderUid, u8>
 {
 public:
 	void Read(const PixelShaderUid &key, const u8 *value, u32 value_size)
 	{
-		PixelShaderCache::InsertByteCode(key, value, value_size);
+		entries.push_back(std::make_pair(key, new D3DBlob(value_size, value)));
 	}
+
+	std::vector<std::pair<PixelShaderUid, D3DBlob*> > entries;
 };
 
 void PixelShaderCache::Init()
@@ -399,7 +403,26 @@ void PixelShaderCache::Init()
 	sprintf(cache_filename, "%sdx11-%s-ps.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 			SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
 	PixelShaderCacheInserter inserter;
-	g_ps_disk_cache.OpenAndRead(cache_filename, inserter);
+	g_ps_disk_cache.OpenAndRead(cache_filename, inserter,
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bReadOnlyCaches);
+
+	u32 start_time = Common::Timer::GetTimeMs();
+	std::vector<ID3D11PixelShader*> shaders(inserter.entries.size());
+	// ID3D11Device is free-threaded, so the cached shaders are created on the pool
+	Common::ThreadPool::ParallelFor((int)shaders.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			shaders[i] = D3D::CreatePixelShaderFromByteCode(inserter.entries[i].second);
+	});
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		if (shaders[i])
+			InsertShader(inserter.entries[i].first, shaders[i]);
+		inserter.entries[i].second->Release();
+	}
+	if (!shaders.empty())
+		INFO_LOG(VIDEO, "Created %u cached pixel shaders in %u ms",
+			(u32)PixelShaders.size(), Common::Timer::GetTimeMs() - start_time);
 
 	if (g_Config.bEnableShaderDebugging)
 		Clear();
@@ -514,6 +537,11 @@ bool PixelShaderCache::InsertByteCode(const PixelShaderUid &uid, const void* byt
 	if (shader == NULL)
 		return false;
 
+	return InsertShader(uid, shader);
+}
+
+bool PixelShaderCache::InsertShader(const PixelShaderUid &uid, ID3D11PixelShader* shader)
+{
 	// TODO: Somehow make the debug name a bit more specific
 	D3D::SetDebugObjectName((ID3D11DeviceChild*)shader, "a pixel shader of PixelShaderCache");
 
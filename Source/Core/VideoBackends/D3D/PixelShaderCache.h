@@ -8,7 +8,7 @@
 
 #include <d3d11.h>
 
-#include <map>
+#include <unordered_map>
 
 enum DSTALPHA_MODE;
 
@@ -23,6 +23,7 @@ public:
 	static void Shutdown();
 	static bool SetShader(DSTALPHA_MODE dstAlphaMode, u32 components); // TODO: Should be renamed to LoadShader
 	static bool InsertByteCode(const PixelShaderUid &uid, const void* bytecode, unsigned int bytecodelen);
+	static bool InsertShader(const PixelShaderUid &uid, ID3D11PixelShader* shader);
 
 	static ID3D11PixelShader* GetActiveShader() { return last_entry->shader; }
 	static ID3D11Buffer* &GetConstantBuffer();
@@ -47,7 +48,7 @@ private:
 		void Destroy() { SAFE_RELEASE(shader); }
 	};
 
-	typedef std::map<PixelShaderUid, PSCacheEntry> PSCache;
+	typedef std::unordered_map<PixelShaderUid, PSCacheEntry, PixelShaderUid::Hasher> PSCache;
 
 	static PSCache PixelShaders;
 	static const PSCacheEntry* last_entry;
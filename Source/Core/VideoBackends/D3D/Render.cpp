@@ -4,6 +4,7 @@
 
 #include <cinttypes>
 #include <cmath>
+#include <vector>
 
 #include "Timer.h"
 
@@ -15,6 +16,7 @@
 #include "VertexShaderManager.h"
 #include "VideoConfig.h"
 
+#include "BoundingBox.h"
 #include "D3DBase.h"
 #include "D3DUtil.h"
 #include "FramebufferManager.h"
@@ -30,6 +32,8 @@
 #include "BPFunctions.h"
 #include "AVIDump.h"
 #include "FPSCounter.h"
+#include "DynamicResolution.h"
+#include "GPUTimer.h"
 #include "ConfigManager.h"
 #include <strsafe.h>
 #include "ImageWrite.h"
@@ -43,6 +47,9 @@ static u32 s_LastAA = 0;
 
 static Television s_television;
 
+// Only with SCALE_DYNAMIC
+static GPUTimer* s_gpu_timer = NULL;
+
 ID3D11Buffer* access_efb_cbuf = NULL;
 ID3D11BlendState* clearblendstates[4] = {NULL};
 ID3D11DepthStencilState* cleardepthstates[3] = {NULL};
@@ -52,22 +59,41 @@ ID3D11RasterizerState* resetraststate = NULL;
 
 static ID3D11Texture2D* s_screenshot_texture = NULL;
 
+// Dumped frames are copied into a ring of staging textures. A frame is only
+// mapped FRAME_DUMP_BUFFERS - 1 frames after its copy, by when the GPU has
+// long finished with it, so dumping doesn't stall the pipeline every frame.
+static const int FRAME_DUMP_BUFFERS = 3;
+static ID3D11Texture2D* s_frame_dump_textures[FRAME_DUMP_BUFFERS];
+static bool s_frame_dump_queued[FRAME_DUMP_BUFFERS];
+static int s_frame_dump_index;
+
+static const u32 EFB_CACHE_WIDTH = (EFB_WIDTH + EFB_CACHE_RECT_SIZE - 1) / EFB_CACHE_RECT_SIZE; // round up
+static const u32 EFB_CACHE_HEIGHT = (EFB_HEIGHT + EFB_CACHE_RECT_SIZE - 1) / EFB_CACHE_RECT_SIZE;
+static bool s_efbCacheValid[2][EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT];
+static std::vector<u32> s_efbCache[2][EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT]; // 2 for PEEK_Z and PEEK_COLOR
+
 
 // GX pipeline state
 struct
 {
-	D3D11_SAMPLER_DESC sampdc[8];
+	D3D::SamplerState samplers[8];
 	D3D11_BLEND_DESC blenddc;
 	D3D11_DEPTH_STENCIL_DESC depthdc;
 	D3D11_RASTERIZER_DESC rastdc;
 } gx_state;
 
+static D3D::StateCache gx_state_cache;
+
 
 void SetupDeviceObjects()
 {
 	s_television.Init();
 
+	g_render_target_pool = new RenderTargetPool;
 	g_framebuffer_manager = new FramebufferManager;
+	s_gpu_timer = new GPUTimer;
+	g_draw_timer = new DrawTimer;
+	BoundingBox::Init();
 
 	HRESULT hr;
 	float colmat[20]= {0.0f};
@@ -151,6 +177,14 @@ void SetupDeviceObjects()
 void TeardownDeviceObjects()
 {
 	delete g_framebuffer_manager;
+	// The device may be going away, so the targets aren't kept around
+	delete g_render_target_pool;
+	g_render_target_pool = NULL;
+	delete s_gpu_timer;
+	s_gpu_timer = NULL;
+	delete g_draw_timer;
+	g_draw_timer = NULL;
+	BoundingBox::Shutdown();
 
 	SAFE_RELEASE(access_efb_cbuf);
 	SAFE_RELEASE(clearblendstates[0]);
@@ -164,6 +198,13 @@ void TeardownDeviceObjects()
 	SAFE_RELEASE(resetdepthstate);
 	SAFE_RELEASE(resetraststate);
 	SAFE_RELEASE(s_screenshot_texture);
+	for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+	{
+		SAFE_RELEASE(s_frame_dump_textures[i]);
+		s_frame_dump_queued[i] = false;
+	}
+	s_frame_dump_index = 0;
+	gx_state_cache.Clear();
 
 	s_television.Shutdown();
 }
@@ -225,15 +266,9 @@ Renderer::Renderer()
 	// TODO: Do we need to enable multisampling here?
 	gx_state.rastdc = CD3D11_RASTERIZER_DESC(D3D11_FILL_SOLID, D3D11_CULL_NONE, false, 0, 0.f, 0, false, true, false, false);
 
-	for (unsigned int k = 0;k < 8;k++)
-	{
-		float border[4] = {0.f, 0.f, 0.f, 0.f};
-		gx_state.sampdc[k] = CD3D11_SAMPLER_DESC(D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_TEXTURE_ADDRESS_CLAMP, D3D11_TEXTURE_ADDRESS_CLAMP, D3D11_TEXTURE_ADDRESS_CLAMP,
-											0.f, 1 << g_ActiveConfig.iMaxAnisotropy,
-											D3D11_COMPARISON_ALWAYS, border,
-											-D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX);
-		if(g_ActiveConfig.iMaxAnisotropy != 0) gx_state.sampdc[k].Filter = D3D11_FILTER_ANISOTROPIC;
-	}
+	for (D3D::SamplerState& sampler : gx_state.samplers)
+		sampler.hex = 0;
+	gx_state_cache.CreateCommonSamplers();
 
 	// Clear EFB textures
 	float ClearColor[4] = { 0.f, 0.f, 0.f, 1.f };
@@ -336,105 +371,148 @@ void Renderer::SetColorMask()
 //  - GX_PokeDither (TODO)
 //  - GX_PokeDstAlpha (TODO)
 //  - GX_PokeZMode (TODO)
-u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
+void ClearEFBCache()
 {
-	// TODO: This function currently is broken if anti-aliasing is enabled
-	D3D11_MAPPED_SUBRESOURCE map;
-	ID3D11Texture2D* read_tex;
+	for (u32 i = 0; i < EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT; ++i)
+		s_efbCacheValid[0][i] = false;
 
-	if (type == POKE_Z)
-	{
-		static bool alert_only_once = true;
-		if (!alert_only_once) return 0;
-		PanicAlert("EFB: Poke Z not implemented (tried to poke z value %#x at (%d,%d))", poke_data, x, y);
-		alert_only_once = false;
-		return 0;
-	}
+	for (u32 i = 0; i < EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT; ++i)
+		s_efbCacheValid[1][i] = false;
+}
 
-	// Convert EFB dimensions to the ones of our render target
-	EFBRectangle efbPixelRc;
-	efbPixelRc.left = x;
-	efbPixelRc.top = y;
-	efbPixelRc.right = x + 1;
-	efbPixelRc.bottom = y + 1;
-	TargetRectangle targetPixelRc = Renderer::ConvertEFBRectangle(efbPixelRc);
-
-	// Take the mean of the resulting dimensions; TODO: Don't use the center pixel, compute the average color instead
-	D3D11_RECT RectToLock;
-	if(type == PEEK_COLOR || type == PEEK_Z)
-	{
-		RectToLock.left = (targetPixelRc.left + targetPixelRc.right) / 2;
-		RectToLock.top = (targetPixelRc.top + targetPixelRc.bottom) / 2;
-		RectToLock.right = RectToLock.left + 1;
-		RectToLock.bottom = RectToLock.top + 1;
-	}
-	else
-	{
-		RectToLock.left = targetPixelRc.left;
-		RectToLock.right = targetPixelRc.right;
-		RectToLock.top = targetPixelRc.top;
-		RectToLock.bottom = targetPixelRc.bottom;
-	}
+// Reads a whole block of the EFB at native resolution, so that further peeks
+// into it don't each have to wait for the GPU.
+void Renderer::UpdateEFBCache(EFBAccessType type, u32 cacheRectIdx, const EFBRectangle& efbPixelRc)
+{
+	const u32 width = efbPixelRc.right - efbPixelRc.left;
+	const u32 height = efbPixelRc.bottom - efbPixelRc.top;
+	const TargetRectangle targetPixelRc = ConvertEFBRectangle(efbPixelRc);
+
+	ResetAPIState(); // Reset any game specific settings
 
+	D3D11_VIEWPORT vp = CD3D11_VIEWPORT(0.f, 0.f, (float)width, (float)height);
+	D3D::context->RSSetViewports(1, &vp);
+	D3D::SetPointCopySampler();
+
+	D3DTexture2D* read_texture;
+	ID3D11Texture2D* staging_buf;
 	if (type == PEEK_Z)
 	{
-		ResetAPIState(); // Reset any game specific settings
-
 		// depth buffers can only be completely CopySubresourceRegion'ed, so we're using drawShadedTexQuad instead
-		D3D11_VIEWPORT vp = CD3D11_VIEWPORT(0.f, 0.f, 1.f, 1.f);
-		D3D::context->RSSetViewports(1, &vp);
+		read_texture = FramebufferManager::GetEFBDepthReadTexture();
+		staging_buf = FramebufferManager::GetEFBDepthStagingBuffer();
 		D3D::context->PSSetConstantBuffers(0, 1, &access_efb_cbuf);
-		D3D::context->OMSetRenderTargets(1, &FramebufferManager::GetEFBDepthReadTexture()->GetRTV(), NULL);
-		D3D::SetPointCopySampler();
+		D3D::context->OMSetRenderTargets(1, &read_texture->GetRTV(), NULL);
 		D3D::drawShadedTexQuad(FramebufferManager::GetEFBDepthTexture()->GetSRV(),
-								&RectToLock,
+								targetPixelRc.AsRECT(),
 								Renderer::GetTargetWidth(),
 								Renderer::GetTargetHeight(),
 								PixelShaderCache::GetDepthMatrixProgram(true),
 								VertexShaderCache::GetSimpleVertexShader(),
 								VertexShaderCache::GetSimpleInputLayout());
+	}
+	else
+	{
+		// scaled down to native resolution as well
+		read_texture = FramebufferManager::GetEFBColorReadTexture();
+		staging_buf = FramebufferManager::GetEFBColorStagingBuffer();
+		D3D::context->OMSetRenderTargets(1, &read_texture->GetRTV(), NULL);
+		D3D::drawShadedTexQuad(FramebufferManager::GetResolvedEFBColorTexture()->GetSRV(),
+								targetPixelRc.AsRECT(),
+								Renderer::GetTargetWidth(),
+								Renderer::GetTargetHeight(),
+								PixelShaderCache::GetColorCopyProgram(false),
+								VertexShaderCache::GetSimpleVertexShader(),
+								VertexShaderCache::GetSimpleInputLayout());
+	}
 
-		D3D::context->OMSetRenderTargets(1, &FramebufferManager::GetEFBColorTexture()->GetRTV(), FramebufferManager::GetEFBDepthTexture()->GetDSV());
+	D3D::context->OMSetRenderTargets(1, &FramebufferManager::GetEFBColorTexture()->GetRTV(), FramebufferManager::GetEFBDepthTexture()->GetDSV());
 
-		// copy to system memory
-		D3D11_BOX box = CD3D11_BOX(0, 0, 0, 1, 1, 1);
-		read_tex = FramebufferManager::GetEFBDepthStagingBuffer();
-		D3D::context->CopySubresourceRegion(read_tex, 0, 0, 0, 0, FramebufferManager::GetEFBDepthReadTexture()->GetTex(), 0, &box);
+	// copy to system memory
+	D3D11_BOX box = CD3D11_BOX(0, 0, 0, width, height, 1);
+	D3D::context->CopySubresourceRegion(staging_buf, 0, 0, 0, 0, read_texture->GetTex(), 0, &box);
 
-		RestoreAPIState(); // restore game state
+	RestoreAPIState(); // restore game state
 
-		// read the data from system memory
-		D3D::context->Map(read_tex, 0, D3D11_MAP_READ, 0, &map);
+	// read the data from system memory
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
+	D3D11_MAPPED_SUBRESOURCE map;
+	if (FAILED(readback_context->Map(staging_buf, 0, D3D11_MAP_READ, 0, &map)))
+		return;
 
-		float val = *(float*)map.pData;
-		u32 ret = 0;
-		if(bpmem.zcontrol.pixel_format == PIXELFMT_RGB565_Z16)
+	const int cacheType = (type == PEEK_Z) ? 0 : 1;
+	std::vector<u32>& cache = s_efbCache[cacheType][cacheRectIdx];
+	cache.resize(EFB_CACHE_RECT_SIZE * EFB_CACHE_RECT_SIZE);
+
+	for (u32 yCache = 0; yCache < height; ++yCache)
+	{
+		const u8* row = (const u8*)map.pData + yCache * map.RowPitch;
+		for (u32 xCache = 0; xCache < width; ++xCache)
 		{
-			// if Z is in 16 bit format you must return a 16 bit integer
-			ret = ((u32)(val * 0xffff));
+			u32 value;
+			if (type == PEEK_Z)
+				value = (u32)(((const float*)row)[xCache] * 0xffffff);
+			else
+				value = ((const u32*)row)[xCache];
+			cache[yCache * EFB_CACHE_RECT_SIZE + xCache] = value;
 		}
-		else
+	}
+
+	readback_context->Unmap(staging_buf, 0);
+
+	s_efbCacheValid[cacheType][cacheRectIdx] = true;
+}
+
+u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
+{
+	// TODO: This function currently is broken if anti-aliasing is enabled
+
+	if (type == POKE_Z)
+	{
+		static bool alert_only_once = true;
+		if (!alert_only_once) return 0;
+		PanicAlert("EFB: Poke Z not implemented (tried to poke z value %#x at (%d,%d))", poke_data, x, y);
+		alert_only_once = false;
+		return 0;
+	}
+
+	u32 cacheRectIdx = (y / EFB_CACHE_RECT_SIZE) * EFB_CACHE_WIDTH
+	                 + (x / EFB_CACHE_RECT_SIZE);
+	u32 cacheOffset = (y % EFB_CACHE_RECT_SIZE) * EFB_CACHE_RECT_SIZE
+	                + (x % EFB_CACHE_RECT_SIZE);
+
+	// Get the rectangular target region containing the EFB pixel
+	EFBRectangle efbCacheRc;
+	efbCacheRc.left = (x / EFB_CACHE_RECT_SIZE) * EFB_CACHE_RECT_SIZE;
+	efbCacheRc.top = (y / EFB_CACHE_RECT_SIZE) * EFB_CACHE_RECT_SIZE;
+	efbCacheRc.right = std::min(efbCacheRc.left + EFB_CACHE_RECT_SIZE, (u32)EFB_WIDTH);
+	efbCacheRc.bottom = std::min(efbCacheRc.top + EFB_CACHE_RECT_SIZE, (u32)EFB_HEIGHT);
+
+	if (type == PEEK_Z)
+	{
+		if (!s_efbCacheValid[0][cacheRectIdx])
+			UpdateEFBCache(type, cacheRectIdx, efbCacheRc);
+		if (!s_efbCacheValid[0][cacheRectIdx])
+			return 0;
+
+		u32 ret = s_efbCache[0][cacheRectIdx][cacheOffset];
+		if(bpmem.zcontrol.pixel_format == PIXELFMT_RGB565_Z16)
 		{
-			ret = ((u32)(val * 0xffffff));
+			// if Z is in 16 bit format you must return a 16 bit integer
+			ret = ret >> 8;
 		}
-		D3D::context->Unmap(read_tex, 0);
 
 		// TODO: in RE0 this value is often off by one in Video_DX9 (where this code is derived from), which causes lighting to disappear
 		return ret;
 	}
 	else if (type == PEEK_COLOR)
 	{
-		// we can directly copy to system memory here
-		read_tex = FramebufferManager::GetEFBColorStagingBuffer();
-		D3D11_BOX box = CD3D11_BOX(RectToLock.left, RectToLock.top, 0, RectToLock.right, RectToLock.bottom, 1);
-		D3D::context->CopySubresourceRegion(read_tex, 0, 0, 0, 0, FramebufferManager::GetEFBColorTexture()->GetTex(), 0, &box);
-
-		// read the data from system memory
-		D3D::context->Map(read_tex, 0, D3D11_MAP_READ, 0, &map);
-		u32 ret = 0;
-		if(map.pData)
-			ret = *(u32*)map.pData;
-		D3D::context->Unmap(read_tex, 0);
+		if (!s_efbCacheValid[1][cacheRectIdx])
+			UpdateEFBCache(type, cacheRectIdx, efbCacheRc);
+		if (!s_efbCacheValid[1][cacheRectIdx])
+			return 0;
+
+		u32 ret = s_efbCache[1][cacheRectIdx][cacheOffset];
 
 		// check what to do with the alpha channel (GX_PokeAlphaRead)
 		PixelEngine::UPEAlphaReadReg alpha_read_mode = PixelEngine::GetAlphaReadMode();
@@ -458,6 +536,14 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 	}
 	else //if(type == POKE_COLOR)
 	{
+		// Convert EFB dimensions to the ones of our render target
+		EFBRectangle efbPixelRc;
+		efbPixelRc.left = x;
+		efbPixelRc.top = y;
+		efbPixelRc.right = x + 1;
+		efbPixelRc.bottom = y + 1;
+		TargetRectangle RectToLock = Renderer::ConvertEFBRectangle(efbPixelRc);
+
 		u32 rgbaColor = (poke_data & 0xFF00FF00) | ((poke_data >> 16) & 0xFF) | ((poke_data << 16) & 0xFF0000);
 
 		// TODO: The first five PE registers may change behavior of EFB pokes, this isn't implemented, yet.
@@ -470,10 +556,42 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 									- (float)RectToLock.bottom * 2.f / (float)Renderer::GetTargetHeight() + 1.f);
 
 		RestoreAPIState();
+		ClearEFBCache();
 		return 0;
 	}
 }
 
+u16 Renderer::BBoxRead(int index)
+{
+	int value = BoundingBox::Get(index);
+
+	// The shaders store the min/max of the truncated positions in the upscaled target,
+	// scale them back to EFB pixels. The right/bottom values describe the outer border.
+	if (index < 2)
+		value = value * EFB_WIDTH / s_target_width;
+	else
+		value = value * EFB_HEIGHT / s_target_height;
+	if (index & 1)
+		value++;
+
+	MathUtil::Clamp(&value, 0, 0x3ff);
+	return (u16)value;
+}
+
+void Renderer::BBoxWrite(int index, u16 value)
+{
+	int scaled = value; // u16 isn't enough to multiply by the target size
+	if (index & 1)
+		scaled--;
+
+	if (index < 2)
+		scaled = scaled * s_target_width / EFB_WIDTH;
+	else
+		scaled = scaled * s_target_height / EFB_HEIGHT;
+
+	BoundingBox::Set(index, scaled);
+}
+
 
 void Renderer::SetViewport()
 {
@@ -548,6 +666,8 @@ void Renderer::ClearScreen(const EFBRectangle& rc, bool colorEnable, bool alphaE
 	D3D::stateman->PopBlendState();
 
 	RestoreAPIState();
+
+	ClearEFBCache();
 }
 
 void Renderer::ReinterpretPixelData(unsigned int convtype)
@@ -578,6 +698,8 @@ void Renderer::ReinterpretPixelData(unsigned int convtype)
 
 	FramebufferManager::SwapReinterpretTexture();
 	D3D::context->OMSetRenderTargets(1, &FramebufferManager::GetEFBColorTexture()->GetRTV(), FramebufferManager::GetEFBDepthTexture()->GetDSV());
+
+	ClearEFBCache();
 }
 
 void SetSrcBlend(D3D11_BLEND val)
@@ -689,12 +811,13 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 	D3D11_BOX box = CD3D11_BOX(rc.left, rc.top, 0, rc.right, rc.bottom, 1);
 	D3D::context->CopySubresourceRegion(s_screenshot_texture, 0, 0, 0, 0, (ID3D11Resource*)D3D::GetBackBuffer()->GetTex(), 0, &box);
 
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
 	D3D11_MAPPED_SUBRESOURCE map;
-	D3D::context->Map(s_screenshot_texture, 0, D3D11_MAP_READ_WRITE, 0, &map);
+	readback_context->Map(s_screenshot_texture, 0, D3D11_MAP_READ_WRITE, 0, &map);
 
-	bool saved_png = TextureToPng((u8*)map.pData, map.RowPitch, filename, rc.GetWidth(), rc.GetHeight(), false);
+	bool saved_png = TextureToPngAsync((u8*)map.pData, map.RowPitch, filename, rc.GetWidth(), rc.GetHeight(), false);
 
-	D3D::context->Unmap(s_screenshot_texture, 0);
+	readback_context->Unmap(s_screenshot_texture, 0);
 
 
 	if (saved_png)
@@ -710,6 +833,49 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 	return saved_png;
 }
 
+static void CreateFrameDumpTextures(int width, int height)
+{
+	D3D11_TEXTURE2D_DESC desc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+	for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+	{
+		HRESULT hr = D3D::device->CreateTexture2D(&desc, NULL, &s_frame_dump_textures[i]);
+		CHECK(hr==S_OK, "Create frame dump staging texture");
+		D3D::SetDebugObjectName((ID3D11DeviceChild*)s_frame_dump_textures[i], "staging frame dump texture");
+		s_frame_dump_queued[i] = false;
+	}
+	s_frame_dump_index = 0;
+}
+
+static void DestroyFrameDumpTextures()
+{
+	for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+	{
+		SAFE_RELEASE(s_frame_dump_textures[i]);
+		s_frame_dump_queued[i] = false;
+	}
+	s_frame_dump_index = 0;
+}
+
+void formatBufferDump(const u8* in, u8* out, int w, int h, int p);
+
+// Hands the frame in a staging texture of the ring to the AVI dump, if it holds one
+static void DumpQueuedFrame(int index, std::vector<u8>& frame_data, int width, int height)
+{
+	if (!s_frame_dump_queued[index])
+		return;
+	s_frame_dump_queued[index] = false;
+
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
+	D3D11_MAPPED_SUBRESOURCE map;
+	if (FAILED(readback_context->Map(s_frame_dump_textures[index], 0, D3D11_MAP_READ, 0, &map)))
+		return;
+
+	frame_data.resize(3 * width * height);
+	formatBufferDump((u8*)map.pData, &frame_data[0], width, height, map.RowPitch);
+	readback_context->Unmap(s_frame_dump_textures[index], 0);
+	AVIDump::AddFrame(&frame_data[0], width, height);
+}
+
 void formatBufferDump(const u8* in, u8* out, int w, int h, int p)
 {
 	for (int y = 0; y < h; ++y)
@@ -729,7 +895,11 @@ void formatBufferDump(const u8* in, u8* out, int w, int h, int p)
 // This function has the final picture. We adjust the aspect ratio here.
 void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangle& rc,float Gamma)
 {
-	if (g_bSkipCurrentFrame || (!XFBWrited && !g_ActiveConfig.RealXFBEnabled()) || !fbWidth || !fbHeight)
+	const bool timing = g_ActiveConfig.iEFBScale == SCALE_DYNAMIC;
+	if (timing)
+		s_gpu_timer->EndFrame();
+
+	if (g_bSkipCurrentFrame || g_bSkipCurrentPresent || (!XFBWrited && !g_ActiveConfig.RealXFBEnabled()) || !fbWidth || !fbHeight)
 	{
 		if (g_ActiveConfig.bDumpFrames && !frame_data.empty())
 			AVIDump::AddFrame(&frame_data[0], fbWidth, fbHeight);
@@ -856,15 +1026,11 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 		static int s_recordWidth;
 		static int s_recordHeight;
 
-		if (!s_screenshot_texture)
-			CreateScreenshotTexture(GetTargetRectangle());
-
-		D3D11_BOX box = CD3D11_BOX(GetTargetRectangle().left, GetTargetRectangle().top, 0, GetTargetRectangle().right, GetTargetRectangle().bottom, 1);
-		D3D::context->CopySubresourceRegion(s_screenshot_texture, 0, 0, 0, 0, (ID3D11Resource*)D3D::GetBackBuffer()->GetTex(), 0, &box);
 		if (!bLastFrameDumped)
 		{
 			s_recordWidth = GetTargetRectangle().GetWidth();
 			s_recordHeight = GetTargetRectangle().GetHeight();
+			CreateFrameDumpTextures(s_recordWidth, s_recordHeight);
 			bAVIDumping = AVIDump::Start(EmuWindow::GetParentWnd(), s_recordWidth, s_recordHeight);
 			if (!bAVIDumping)
 			{
@@ -880,18 +1046,19 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 		}
 		if (bAVIDumping)
 		{
-			D3D11_MAPPED_SUBRESOURCE map;
-			D3D::context->Map(s_screenshot_texture, 0, D3D11_MAP_READ, 0, &map);
-
-			if (frame_data.empty() || w != s_recordWidth || h != s_recordHeight)
-			{
-				frame_data.resize(3 * s_recordWidth * s_recordHeight);
-				w = s_recordWidth;
-				h = s_recordHeight;
-			}
-			formatBufferDump((u8*)map.pData, &frame_data[0], s_recordWidth, s_recordHeight, map.RowPitch);
-			AVIDump::AddFrame(&frame_data[0], GetTargetRectangle().GetWidth(), GetTargetRectangle().GetHeight());
-			D3D::context->Unmap(s_screenshot_texture, 0);
+			// The frames keep the size the dump was started with
+			const TargetRectangle& trc = GetTargetRectangle();
+			D3D11_BOX box = CD3D11_BOX(trc.left, trc.top, 0, trc.left + std::min(trc.GetWidth(), s_recordWidth),
+				trc.top + std::min(trc.GetHeight(), s_recordHeight), 1);
+			D3D::context->CopySubresourceRegion(s_frame_dump_textures[s_frame_dump_index], 0, 0, 0, 0,
+				(ID3D11Resource*)D3D::GetBackBuffer()->GetTex(), 0, &box);
+			s_frame_dump_queued[s_frame_dump_index] = true;
+			s_frame_dump_index = (s_frame_dump_index + 1) % FRAME_DUMP_BUFFERS;
+
+			// The texture that is used next holds the oldest frame
+			DumpQueuedFrame(s_frame_dump_index, frame_data, s_recordWidth, s_recordHeight);
+			w = s_recordWidth;
+			h = s_recordHeight;
 		}
 		bLastFrameDumped = true;
 	}
@@ -899,6 +1066,9 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 	{
 		if (bLastFrameDumped && bAVIDumping)
 		{
+			// The frames still in the ring make it into the dump as well
+			for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+				DumpQueuedFrame((s_frame_dump_index + i) % FRAME_DUMP_BUFFERS, frame_data, w, h);
 			std::vector<u8>().swap(frame_data);
 			w = h = 0;
 
@@ -906,6 +1076,8 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 			bAVIDumping = false;
 			OSD::AddMessage("Stop dumping frames to AVI", 2000);
 		}
+		if (bLastFrameDumped)
+			DestroyFrameDumpTextures();
 		bLastFrameDumped = false;
 	}
 
@@ -980,6 +1152,7 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 	if (xfbchanged ||
 		windowResized ||
 		s_LastEFBScale != g_ActiveConfig.iEFBScale ||
+		(s_LastEFBScale == SCALE_DYNAMIC && DynamicResolution::HasScaleChanged()) ||
 		s_LastAA != g_ActiveConfig.iMultisampleMode)
 	{
 		s_LastAA = g_ActiveConfig.iMultisampleMode;
@@ -1003,6 +1176,7 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 
 		delete g_framebuffer_manager;
 		g_framebuffer_manager = new FramebufferManager;
+		ClearEFBCache();
 		float clear_col[4] = { 0.f, 0.f, 0.f, 1.f };
 		D3D::context->ClearRenderTargetView(FramebufferManager::GetEFBColorTexture()->GetRTV(), clear_col);
 		D3D::context->ClearDepthStencilView(FramebufferManager::GetEFBDepthTexture()->GetDSV(), D3D11_CLEAR_DEPTH, 1.f, 0);
@@ -1013,6 +1187,9 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 	D3D::BeginFrame();
 	D3D::context->OMSetRenderTargets(1, &FramebufferManager::GetEFBColorTexture()->GetRTV(), FramebufferManager::GetEFBDepthTexture()->GetDSV());
 	SetViewport();
+
+	if (timing)
+		s_gpu_timer->BeginFrame();
 }
 
 // ALWAYS call RestoreAPIState for each ResetAPIState call you're doing
@@ -1035,75 +1212,38 @@ void Renderer::RestoreAPIState()
 
 void Renderer::ApplyState(bool bUseDstAlpha)
 {
-	HRESULT hr;
-
+	D3D11_BLEND_DESC blenddc = gx_state.blenddc;
 	if (bUseDstAlpha)
 	{
 		// Colors should blend against SRC1_ALPHA
-		if (gx_state.blenddc.RenderTarget[0].SrcBlend == D3D11_BLEND_SRC_ALPHA)
-			gx_state.blenddc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC1_ALPHA;
-		else if (gx_state.blenddc.RenderTarget[0].SrcBlend == D3D11_BLEND_INV_SRC_ALPHA)
-			gx_state.blenddc.RenderTarget[0].SrcBlend = D3D11_BLEND_INV_SRC1_ALPHA;
+		if (blenddc.RenderTarget[0].SrcBlend == D3D11_BLEND_SRC_ALPHA)
+			blenddc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC1_ALPHA;
+		else if (blenddc.RenderTarget[0].SrcBlend == D3D11_BLEND_INV_SRC_ALPHA)
+			blenddc.RenderTarget[0].SrcBlend = D3D11_BLEND_INV_SRC1_ALPHA;
 
 		// Colors should blend against SRC1_ALPHA
-		if (gx_state.blenddc.RenderTarget[0].DestBlend == D3D11_BLEND_SRC_ALPHA)
-			gx_state.blenddc.RenderTarget[0].DestBlend = D3D11_BLEND_SRC1_ALPHA;
-		else if (gx_state.blenddc.RenderTarget[0].DestBlend == D3D11_BLEND_INV_SRC_ALPHA)
-			gx_state.blenddc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC1_ALPHA;
-
-		gx_state.blenddc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-		gx_state.blenddc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
-		gx_state.blenddc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		if (blenddc.RenderTarget[0].DestBlend == D3D11_BLEND_SRC_ALPHA)
+			blenddc.RenderTarget[0].DestBlend = D3D11_BLEND_SRC1_ALPHA;
+		else if (blenddc.RenderTarget[0].DestBlend == D3D11_BLEND_INV_SRC_ALPHA)
+			blenddc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC1_ALPHA;
+
+		blenddc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blenddc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+		blenddc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
 	}
 
-	ID3D11BlendState* blstate;
-	hr = D3D::device->CreateBlendState(&gx_state.blenddc, &blstate);
-	if (FAILED(hr)) PanicAlert("Failed to create blend state at %s %d\n", __FILE__, __LINE__);
-	D3D::stateman->PushBlendState(blstate);
-	D3D::SetDebugObjectName((ID3D11DeviceChild*)blstate, "blend state used to emulate the GX pipeline");
-	SAFE_RELEASE(blstate);
+	gx_state.rastdc.FillMode = (g_ActiveConfig.bWireFrame) ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
 
-	ID3D11DepthStencilState* depth_state;
-	hr = D3D::device->CreateDepthStencilState(&gx_state.depthdc, &depth_state);
-	if (SUCCEEDED(hr)) D3D::SetDebugObjectName((ID3D11DeviceChild*)depth_state, "depth-stencil state used to emulate the GX pipeline");
-	else PanicAlert("Failed to create depth state at %s %d\n", __FILE__, __LINE__);
-	D3D::stateman->PushDepthState(depth_state);
-	SAFE_RELEASE(depth_state);
+	const D3D::PipelineState& state = gx_state_cache.Get(blenddc, gx_state.depthdc, gx_state.rastdc);
+	D3D::stateman->PushBlendState(state.blend);
+	D3D::stateman->PushDepthState(state.depth);
+	D3D::stateman->PushRasterizerState(state.raster);
 
-	gx_state.rastdc.FillMode = (g_ActiveConfig.bWireFrame) ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
-	ID3D11RasterizerState* raststate;
-	hr = D3D::device->CreateRasterizerState(&gx_state.rastdc, &raststate);
-	if (FAILED(hr)) PanicAlert("Failed to create rasterizer state at %s %d\n", __FILE__, __LINE__);
-	D3D::SetDebugObjectName((ID3D11DeviceChild*)raststate, "rasterizer state used to emulate the GX pipeline");
-	D3D::stateman->PushRasterizerState(raststate);
-	SAFE_RELEASE(raststate);
-
-	ID3D11SamplerState* samplerstate[8];
-	for (unsigned int stage = 0; stage < 8; stage++)
-	{
-		// TODO: unnecessary state changes, we should store a list of shader resources
-		//if (shader_resources[stage])
-		{
-			if(g_ActiveConfig.iMaxAnisotropy > 0) gx_state.sampdc[stage].Filter = D3D11_FILTER_ANISOTROPIC;
-			hr = D3D::device->CreateSamplerState(&gx_state.sampdc[stage], &samplerstate[stage]);
-			if (FAILED(hr)) PanicAlert("Fail %s %d, stage=%d\n", __FILE__, __LINE__, stage);
-			else D3D::SetDebugObjectName((ID3D11DeviceChild*)samplerstate[stage], "sampler state used to emulate the GX pipeline");
-		}
-		// else samplerstate[stage] = NULL;
-	}
-	D3D::context->PSSetSamplers(0, 8, samplerstate);
 	for (unsigned int stage = 0; stage < 8; stage++)
-		SAFE_RELEASE(samplerstate[stage]);
+		D3D::stateman->SetSampler(stage, gx_state_cache.Get(gx_state.samplers[stage]));
 
 	D3D::stateman->Apply();
 
-	if (bUseDstAlpha)
-	{
-		// restore actual state
-		SetBlendMode(false);
-		SetLogicOpMode();
-	}
-
 	D3D::context->PSSetConstantBuffers(0, 1, &PixelShaderCache::GetConstantBuffer());
 	D3D::context->VSSetConstantBuffers(0, 1, &VertexShaderCache::GetConstantBuffer());
 
@@ -1126,13 +1266,7 @@ void Renderer::ApplyCullDisable()
 	D3D11_RASTERIZER_DESC rastDesc = gx_state.rastdc;
 	rastDesc.CullMode = D3D11_CULL_NONE;
 
-	ID3D11RasterizerState* raststate;
-	HRESULT hr = D3D::device->CreateRasterizerState(&rastDesc, &raststate);
-	if (FAILED(hr)) PanicAlert("Failed to create culling-disabled rasterizer state at %s %d\n", __FILE__, __LINE__);
-	D3D::SetDebugObjectName((ID3D11DeviceChild*)raststate, "rasterizer state (culling disabled) used to emulate the GX pipeline");
-
-	D3D::stateman->PushRasterizerState(raststate);
-	SAFE_RELEASE(raststate);
+	D3D::stateman->PushRasterizerState(gx_state_cache.Get(gx_state.blenddc, gx_state.depthdc, rastDesc).raster);
 
 	D3D::stateman->Apply();
 }
@@ -1289,75 +1423,10 @@ void Renderer::SetLineWidth()
 
 void Renderer::SetSamplerState(int stage, int texindex)
 {
-#define TEXF_NONE   0
-#define TEXF_POINT  1
-#define TEXF_LINEAR 2
-	const unsigned int d3dMipFilters[4] =
-	{
-		TEXF_NONE,
-		TEXF_POINT,
-		TEXF_LINEAR,
-		TEXF_NONE, //reserved
-	};
-	const D3D11_TEXTURE_ADDRESS_MODE d3dClamps[4] =
-	{
-		D3D11_TEXTURE_ADDRESS_CLAMP,
-		D3D11_TEXTURE_ADDRESS_WRAP,
-		D3D11_TEXTURE_ADDRESS_MIRROR,
-		D3D11_TEXTURE_ADDRESS_WRAP //reserved
-	};
-
 	const FourTexUnits &tex = bpmem.tex[texindex];
-	const TexMode0 &tm0 = tex.texMode0[stage];
-	const TexMode1 &tm1 = tex.texMode1[stage];
-
-	unsigned int mip = d3dMipFilters[tm0.min_filter & 3];
-
-	if (texindex)
-		stage += 4;
-
-	if (g_ActiveConfig.bForceFiltering)
-	{
-		gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	}
-	else if (tm0.min_filter & 4) // linear min filter
-	{
-		if (tm0.mag_filter) // linear mag filter
-		{
-			if (mip == TEXF_NONE) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT;
-			else if (mip == TEXF_POINT) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT;
-			else if (mip == TEXF_LINEAR) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-		}
-		else // point mag filter
-		{
-			if (mip == TEXF_NONE) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_LINEAR_MAG_MIP_POINT;
-			else if (mip == TEXF_POINT) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_LINEAR_MAG_MIP_POINT;
-			else if (mip == TEXF_LINEAR) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_LINEAR_MAG_POINT_MIP_LINEAR;
-		}
-	}
-	else // point min filter
-	{
-		if (tm0.mag_filter) // linear mag filter
-		{
-			if (mip == TEXF_NONE) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT;
-			else if (mip == TEXF_POINT) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT;
-			else if (mip == TEXF_LINEAR) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_POINT_MAG_MIP_LINEAR;
-		}
-		else // point mag filter
-		{
-			if (mip == TEXF_NONE) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
-			else if (mip == TEXF_POINT) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
-			else if (mip == TEXF_LINEAR) gx_state.sampdc[stage].Filter = D3D11_FILTER_MIN_MAG_POINT_MIP_LINEAR;
-		}
-	}
-
-	gx_state.sampdc[stage].AddressU = d3dClamps[tm0.wrap_s];
-	gx_state.sampdc[stage].AddressV = d3dClamps[tm0.wrap_t];
-
-	// When mipfilter is set to "none", just disable mipmapping altogether
-	gx_state.sampdc[stage].MaxLOD = (mip == TEXF_NONE) ? 0.0f : (float)tm1.max_lod/16.f;
-	gx_state.sampdc[stage].MinLOD = (float)tm1.min_lod/16.f;
-	gx_state.sampdc[stage].MipLODBias = (s32)tm0.lod_bias/32.0f;
+	D3D::SamplerState& sampler = gx_state.samplers[texindex ? stage + 4 : stage];
+	sampler.tm0 = tex.texMode0[stage];
+	sampler.tm1 = tex.texMode1[stage];
 }
 
 void Renderer::SetInterlacingMode()
@@ -5,6 +5,8 @@
 namespace DX11
 {
 
+void ClearEFBCache();
+
 class Renderer : public ::Renderer
 {
 public:
@@ -34,6 +36,9 @@ public:
 
 	u32 AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data);
 
+	u16 BBoxRead(int index);
+	void BBoxWrite(int index, u16 value);
+
 	void ResetAPIState();
 	void RestoreAPIState();
 
@@ -48,6 +53,9 @@ public:
 	bool SaveScreenshot(const std::string &filename, const TargetRectangle &rc);
 
 	static bool CheckForResize();
+
+private:
+	void UpdateEFBCache(EFBAccessType type, u32 cacheRectIdx, const EFBRectangle& efbPixelRc);
 };
 
 }
@@ -8,6 +8,7 @@
 #include "D3DBase.h"
 #include "D3DShader.h"
 #include "D3DUtil.h"
+#include "GfxState.h"
 #include "VertexShaderCache.h"
 #include "HW/Memmap.h"
 #include <vector>
@@ -66,6 +67,8 @@ void Television::Init()
 {
 	HRESULT hr;
 
+	m_tracker.Reset();
+
 	// Create YUYV texture for real XFB mode
 
 
@@ -132,6 +135,9 @@ void Television::Submit(u32 xfbAddr, u32 width, u32 height)
 	m_curWidth = width;
 	m_curHeight = height;
 
+	if (!m_tracker.Update(xfbAddr, width, height))
+		return;
+
 	// Load data from GameCube RAM to YUYV texture
 	u8* yuyvSrc = Memory::GetPointer(xfbAddr);
 	D3D11_BOX box = CD3D11_BOX(0, 0, 0, width, height, 1);
@@ -150,7 +156,7 @@ void Television::Render()
 		MathUtil::Rectangle<int> sourceRc(0, 0, int(m_curWidth), int(m_curHeight));
 		MathUtil::Rectangle<float> destRc(-1.f, 1.f, 1.f, -1.f);
 
-		D3D::context->PSSetSamplers(0, 1, &m_samplerState);
+		D3D::stateman->SetSampler(0, m_samplerState);
 
 		D3D::drawShadedTexSubQuad(
 			m_yuyvTextureSRV, &sourceRc,
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "FramebufferManagerBase.h"
 #include "VideoCommon.h"
 
 struct ID3D11Texture2D;
@@ -46,6 +47,9 @@ private:
 	ID3D11PixelShader* m_pShader;
 	ID3D11SamplerState* m_samplerState;
 
+	// Skips the upload when the XFB in RAM didn't change
+	RealXFBTracker m_tracker;
+
 };
 
 }
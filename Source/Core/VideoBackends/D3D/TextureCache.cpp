@@ -61,12 +61,13 @@ bool TextureCache::TCacheEntry::Save(const std::string filename, unsigned int le
 	{
 		D3D::context->CopyResource(pNewTexture, pSurface);
 
+		ID3D11DeviceContext* const readback_context = D3D::SyncContext();
 		D3D11_MAPPED_SUBRESOURCE map;
-		HRESULT hr = D3D::context->Map(pNewTexture, 0, D3D11_MAP_READ_WRITE, 0, &map);
+		HRESULT hr = readback_context->Map(pNewTexture, 0, D3D11_MAP_READ_WRITE, 0, &map);
 		if (SUCCEEDED(hr))
 		{
-			saved_png = TextureToPng((u8*)map.pData, map.RowPitch, filename, desc.Width, desc.Height);
-			D3D::context->Unmap(pNewTexture, 0);
+			saved_png = TextureToPngAsync((u8*)map.pData, map.RowPitch, filename, desc.Width, desc.Height);
+			readback_context->Unmap(pNewTexture, 0);
 		}
 		SAFE_RELEASE(pNewTexture);
 	}
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "BoundingBox.h"
 #include "D3DBase.h"
 #include "PixelShaderCache.h"
 #include "VertexManager.h"
@@ -11,6 +12,7 @@
 #include "Debugger.h"
 #include "IndexGenerator.h"
 #include "MainBase.h"
+#include "PixelEngine.h"
 #include "PixelShaderManager.h"
 #include "RenderBase.h"
 #include "Render.h"
@@ -59,6 +61,7 @@ void VertexManager::CreateDeviceObjects()
 	m_current_index_buffer = 0;
 	m_index_buffer_cursor = IBUFFER_SIZE;
 	m_vertex_buffer_cursor = VBUFFER_SIZE;
+	m_command_list = D3D::GetCommandListCount();
 	m_lineShader.Init();
 	m_pointShader.Init();
 }
@@ -95,9 +98,18 @@ void VertexManager::PrepareDrawBuffers()
 {
 	D3D11_MAPPED_SUBRESOURCE map;
 
+	// A new command list of the deferred context starts with discarded buffers
+	const bool new_command_list = m_command_list != D3D::GetCommandListCount();
+	m_command_list = D3D::GetCommandListCount();
+
 	UINT vSize = UINT(s_pCurBufferPointer - s_pBaseBufferPointer);
 	D3D11_MAP MapType = D3D11_MAP_WRITE_NO_OVERWRITE;
-	if (m_vertex_buffer_cursor + vSize >= VBUFFER_SIZE)
+	if (new_command_list)
+	{
+		m_vertex_buffer_cursor = 0;
+		MapType = D3D11_MAP_WRITE_DISCARD;
+	}
+	else if (m_vertex_buffer_cursor + vSize >= VBUFFER_SIZE)
 	{
 		// Wrap around
 		m_current_vertex_buffer = (m_current_vertex_buffer + 1) % MAX_VBUFFER_COUNT;
@@ -114,7 +126,12 @@ void VertexManager::PrepareDrawBuffers()
 
 	UINT iCount = IndexGenerator::GetIndexLen();
 	MapType = D3D11_MAP_WRITE_NO_OVERWRITE;
-	if (m_index_buffer_cursor + iCount >= (IBUFFER_SIZE / sizeof(u16)))
+	if (new_command_list)
+	{
+		m_index_buffer_cursor = 0;
+		MapType = D3D11_MAP_WRITE_DISCARD;
+	}
+	else if (m_index_buffer_cursor + iCount >= (IBUFFER_SIZE / sizeof(u16)))
 	{
 		// Wrap around
 		m_current_index_buffer = (m_current_index_buffer + 1) % MAX_VBUFFER_COUNT;
@@ -216,9 +233,20 @@ void VertexManager::vFlush(bool useDstAlpha)
 	g_nativeVertexFmt->SetupVertexPointers();
 	g_renderer->ApplyState(useDstAlpha);
 
+	// Setting the render targets unbinds the UAVs, so bind it for every draw.
+	// The slot follows the render targets, see PixelShaderGen.
+	if (g_ActiveConfig.GPUBBoxEnabled() && PixelEngine::bbox_active)
+	{
+		ID3D11UnorderedAccessView* uav = BoundingBox::GetUAV();
+		D3D::context->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL,
+			NULL, NULL, 2, 1, &uav, NULL);
+	}
+
 	Draw(stride);
 
 	g_renderer->RestoreState();
+
+	ClearEFBCache();
 }
 
 void VertexManager::ResetBuffer(u32 stride)
@@ -38,6 +38,7 @@ private:
 	u32 m_index_draw_offset;
 	u32 m_current_vertex_buffer;
 	u32 m_current_index_buffer;
+	u32 m_command_list;
 	typedef ID3D11Buffer* PID3D11Buffer;
 	PID3D11Buffer* m_index_buffers;
 	PID3D11Buffer* m_vertex_buffers;
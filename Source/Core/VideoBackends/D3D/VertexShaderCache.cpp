@@ -4,6 +4,8 @@
 
 #include "FileUtil.h"
 #include "LinearDiskCache.h"
+#include "ThreadPool.h"
+#include "Timer.h"
 
 #include "Debugger.h"
 #include "Statistics.h"
@@ -53,17 +55,16 @@ ID3D11Buffer* &VertexShaderCache::GetConstantBuffer()
 	return vscbuf;
 }
 
-// this class will load the precompiled shaders into our cache
+// this class will collect the precompiled shaders, they are created in parallel afterwards
 class VertexShaderCacheInserter : public LinearDiskCacheReader<VertexShaderUid, u8>
 {
 public:
 	void Read(const VertexShaderUid &key, const u8 *value, u32 value_size)
 	{
-		D3DBlob* blob = new D3DBlob(value_size, value);
-		VertexShaderCache::InsertByteCode(key, blob);
-		blob->Release();
-
+		entries.push_back(std::make_pair(key, new D3DBlob(value_size, value)));
 	}
+
+	std::vector<std::pair<VertexShaderUid, D3DBlob*> > entries;
 };
 
 const char simple_shader_code[] = {
@@ -147,7 +148,26 @@ void VertexShaderCache::Init()
 	sprintf(cache_filename, "%sdx11-%s-vs.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 			SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
 	VertexShaderCacheInserter inserter;
-	g_vs_disk_cache.OpenAndRead(cache_filename, inserter);
+	g_vs_disk_cache.OpenAndRead(cache_filename, inserter,
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bReadOnlyCaches);
+
+	u32 start_time = Common::Timer::GetTimeMs();
+	std::vector<ID3D11VertexShader*> shaders(inserter.entries.size());
+	// ID3D11Device is free-threaded, so the cached shaders are created on the pool
+	Common::ThreadPool::ParallelFor((int)shaders.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			shaders[i] = D3D::CreateVertexShaderFromByteCode(inserter.entries[i].second);
+	});
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		if (shaders[i])
+			InsertShader(inserter.entries[i].first, shaders[i], inserter.entries[i].second);
+		inserter.entries[i].second->Release();
+	}
+	if (!shaders.empty())
+		INFO_LOG(VIDEO, "Created %u cached vertex shaders in %u ms",
+			(u32)vshaders.size(), Common::Timer::GetTimeMs() - start_time);
 
 	if (g_Config.bEnableShaderDebugging)
 		Clear();
@@ -243,6 +263,11 @@ bool VertexShaderCache::InsertByteCode(const VertexShaderUid &uid, D3DBlob* bcod
 	if (shader == NULL)
 		return false;
 
+	return InsertShader(uid, shader, bcodeblob);
+}
+
+bool VertexShaderCache::InsertShader(const VertexShaderUid &uid, ID3D11VertexShader* shader, D3DBlob* bcodeblob)
+{
 	// TODO: Somehow make the debug name a bit more specific
 	D3D::SetDebugObjectName((ID3D11DeviceChild*)shader, "a vertex shader of VertexShaderCache");
 
@@ -9,7 +9,7 @@
 #include "D3DBase.h"
 #include "D3DBlob.h"
 
-#include <map>
+#include <unordered_map>
 
 namespace DX11 {
 
@@ -31,6 +31,7 @@ public:
 	static ID3D11InputLayout* GetClearInputLayout();
 
 	static bool VertexShaderCache::InsertByteCode(const VertexShaderUid &uid, D3DBlob* bcodeblob);
+	static bool InsertShader(const VertexShaderUid &uid, ID3D11VertexShader* shader, D3DBlob* bcodeblob);
 
 private:
 	struct VSCacheEntry
@@ -53,7 +54,7 @@ private:
 			SAFE_RELEASE(bytecode);
 		}
 	};
-	typedef std::map<VertexShaderUid, VSCacheEntry> VSCache;
+	typedef std::unordered_map<VertexShaderUid, VSCacheEntry, VertexShaderUid::Hasher> VSCache;
 
 	static VSCache vshaders;
 	static const VSCacheEntry* last_entry;
@@ -317,7 +317,7 @@ void XFBEncoder::Encode(u8* dst, u32 width, u32 height, const EFBRectangle& srcR
 
 	D3D::context->PSSetConstantBuffers(0, 1, &m_encodeParams);
 	D3D::context->PSSetShaderResources(0, 1, &pEFB);
-	D3D::context->PSSetSamplers(0, 1, &m_efbSampler);
+	D3D::stateman->SetSampler(0, m_efbSampler);
 
 	// Encode!
 
@@ -332,7 +332,7 @@ void XFBEncoder::Encode(u8* dst, u32 width, u32 height, const EFBRectangle& srcR
 
 	IUnknown* nullDummy = NULL;
 
-	D3D::context->PSSetSamplers(0, 1, (ID3D11SamplerState**)&nullDummy);
+	D3D::stateman->SetSampler(0, NULL);
 	D3D::context->PSSetShaderResources(0, 1, (ID3D11ShaderResourceView**)&nullDummy);
 	D3D::context->PSSetConstantBuffers(0, 1, (ID3D11Buffer**)&nullDummy);
 
@@ -349,8 +349,9 @@ void XFBEncoder::Encode(u8* dst, u32 width, u32 height, const EFBRectangle& srcR
 
 	// Transfer staging buffer to GameCube/Wii RAM
 
+	ID3D11DeviceContext* const readback_context = D3D::SyncContext();
 	D3D11_MAPPED_SUBRESOURCE map = { 0 };
-	hr = D3D::context->Map(m_outStage, 0, D3D11_MAP_READ, 0, &map);
+	hr = readback_context->Map(m_outStage, 0, D3D11_MAP_READ, 0, &map);
 	CHECK(SUCCEEDED(hr), "map staging buffer");
 
 	u8* src = (u8*)map.pData;
@@ -361,7 +362,7 @@ void XFBEncoder::Encode(u8* dst, u32 width, u32 height, const EFBRectangle& srcR
 		src += map.RowPitch;
 	}
 
-	D3D::context->Unmap(m_outStage, 0);
+	readback_context->Unmap(m_outStage, 0);
 
 	// Restore API
 
@@ -90,6 +90,7 @@ void InitBackendInfo()
 	g_Config.backend_info.bSupportsPixelLighting = true;
 	g_Config.backend_info.bSupportsPrimitiveRestart = true;
 	g_Config.backend_info.bSupportsOversizedViewports = false;
+	g_Config.backend_info.bSupportsMultiDraw = false;
 
 	IDXGIFactory* factory;
 	IDXGIAdapter* ad;
@@ -123,6 +124,9 @@ void InitBackendInfo()
 
 			// Requires the earlydepthstencil attribute (only available in shader model 5)
 			g_Config.backend_info.bSupportsEarlyZ = (DX11::D3D::GetFeatureLevel(ad) == D3D_FEATURE_LEVEL_11_0);
+
+			// Pixel shader UAVs need shader model 5 as well
+			g_Config.backend_info.bSupportsBBox = g_Config.backend_info.bSupportsEarlyZ;
 		}
 
 		g_Config.backend_info.Adapters.push_back(UTF16ToUTF8(desc.Description));
@@ -0,0 +1,55 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "BoundingBox.h"
+#include "GLUtil.h"
+#include "VideoConfig.h"
+
+// The binding point of the BBox block in the pixel shaders
+static const GLuint BBOX_BINDING = 3;
+
+static GLuint s_bbox_buffer_id;
+
+namespace OGL
+{
+
+void BoundingBox::Init()
+{
+	if (!g_ActiveConfig.backend_info.bSupportsBBox)
+		return;
+
+	int initial_values[4] = { 0, 0, 0, 0 };
+	glGenBuffers(1, &s_bbox_buffer_id);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_bbox_buffer_id);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(initial_values), initial_values, GL_DYNAMIC_READ);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BBOX_BINDING, s_bbox_buffer_id);
+}
+
+void BoundingBox::Shutdown()
+{
+	if (!s_bbox_buffer_id)
+		return;
+
+	glDeleteBuffers(1, &s_bbox_buffer_id);
+	s_bbox_buffer_id = 0;
+}
+
+void BoundingBox::Set(int index, int value)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_bbox_buffer_id);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, index * sizeof(int), sizeof(int), &value);
+}
+
+int BoundingBox::Get(int index)
+{
+	// Make the atomics of the previous draws visible to the read back
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	int data = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_bbox_buffer_id);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, index * sizeof(int), sizeof(int), &data);
+	return data;
+}
+
+}  // namespace OGL
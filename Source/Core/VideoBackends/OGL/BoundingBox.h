@@ -0,0 +1,25 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "CommonTypes.h"
+
+namespace OGL
+{
+
+// The bounding box, extended by the pixel shaders with atomics on a shader
+// storage buffer. The values are in framebuffer coordinates, see
+// Renderer::BBoxRead for the conversion to EFB coordinates.
+class BoundingBox
+{
+public:
+	static void Init();
+	static void Shutdown();
+
+	static void Set(int index, int value);
+	static int Get(int index);
+};
+
+}  // namespace OGL
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Globals.h"
 #include "FramebufferManager.h"
 #include "VertexShaderGen.h"
@@ -34,6 +36,61 @@ GLuint FramebufferManager::m_xfbFramebuffer;
 // reinterpret pixel format
 SHADER FramebufferManager::m_pixel_format_shaders[2];
 
+RenderTargetPool* g_render_target_pool;
+
+RenderTargetKey RenderTargetPool::MakeKey(u32 width, u32 height, GLenum internal_format, u32 samples, u32 coverage_samples)
+{
+	RenderTargetKey key = { width, height, internal_format | (coverage_samples << 16), samples };
+	return key;
+}
+
+GLuint RenderTargetPool::CreateTarget(const RenderTargetKey& key)
+{
+	const GLenum internal_format = key.format & 0xFFFF;
+	const u32 coverage_samples = key.format >> 16;
+	GLuint target;
+
+	if (key.samples <= 1)
+	{
+		const bool depth = internal_format == GL_DEPTH_COMPONENT24;
+
+		glGenTextures(1, &target);
+		glActiveTexture(GL_TEXTURE0 + 9);
+		glBindTexture(GL_TEXTURE_2D, target);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, key.width, key.height, 0,
+			depth ? GL_DEPTH_COMPONENT : GL_RGBA, depth ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE, NULL);
+	}
+	else
+	{
+		glGenRenderbuffers(1, &target);
+		glBindRenderbuffer(GL_RENDERBUFFER, target);
+		if (coverage_samples)
+			glRenderbufferStorageMultisampleCoverageNV(GL_RENDERBUFFER, coverage_samples, key.samples, internal_format, key.width, key.height);
+		else
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, key.samples, internal_format, key.width, key.height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+
+	return target;
+}
+
+void RenderTargetPool::DestroyTarget(const RenderTargetKey& key, GLuint target)
+{
+	if (key.samples <= 1)
+		glDeleteTextures(1, &target);
+	else
+		glDeleteRenderbuffers(1, &target);
+}
+
+u64 RenderTargetPool::GetTargetSize(const RenderTargetKey& key) const
+{
+	// GL_RGBA and GL_DEPTH_COMPONENT24 both take 4 bytes, the coverage samples are left out
+	return (u64)key.width * key.height * std::max<u32>(key.samples, 1) * 4;
+}
+
 
 FramebufferManager::FramebufferManager(int targetWidth, int targetHeight, int msaaSamples, int msaaCoverageSamples)
 {
@@ -62,37 +119,18 @@ FramebufferManager::FramebufferManager(int targetWidth, int targetHeight, int ms
 	// The distinction becomes important for certain operations, i.e. the
 	// alpha channel should be ignored if the EFB does not have one.
 
-	// Create EFB target.
+	// Create EFB target. The textures and renderbuffers come from the pool.
 	glGenFramebuffers(1, &m_efbFramebuffer);
-	glActiveTexture(GL_TEXTURE0 + 9);
+	const RenderTargetKey color_key = RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_RGBA);
+	const RenderTargetKey depth_key = RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_DEPTH_COMPONENT24);
 
 	if (m_msaaSamples <= 1)
 	{
 		// EFB targets will be textures in non-MSAA mode.
 
-		GLuint glObj[3];
-		glGenTextures(3, glObj);
-		m_efbColor = glObj[0];
-		m_efbDepth = glObj[1];
-		m_resolvedColorTexture = glObj[2]; // needed for pixel format convertion
-
-		glBindTexture(GL_TEXTURE_2D, m_efbColor);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_targetWidth, m_targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-
-		glBindTexture(GL_TEXTURE_2D, m_efbDepth);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
-
-		glBindTexture(GL_TEXTURE_2D, m_resolvedColorTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_targetWidth, m_targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		m_efbColor = g_render_target_pool->Acquire(color_key);
+		m_efbDepth = g_render_target_pool->Acquire(depth_key);
+		m_resolvedColorTexture = g_render_target_pool->Acquire(color_key); // needed for pixel format convertion
 
 		// Bind target textures to the EFB framebuffer.
 
@@ -111,24 +149,10 @@ FramebufferManager::FramebufferManager(int targetWidth, int targetHeight, int ms
 
 		// Create EFB target renderbuffers.
 
-		GLuint glObj[2];
-		glGenRenderbuffers(2, glObj);
-		m_efbColor = glObj[0];
-		m_efbDepth = glObj[1];
-
-		glBindRenderbuffer(GL_RENDERBUFFER, m_efbColor);
-		if (m_msaaCoverageSamples)
-			glRenderbufferStorageMultisampleCoverageNV(GL_RENDERBUFFER, m_msaaCoverageSamples, m_msaaSamples, GL_RGBA, m_targetWidth, m_targetHeight);
-		else
-			glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_msaaSamples, GL_RGBA, m_targetWidth, m_targetHeight);
-
-		glBindRenderbuffer(GL_RENDERBUFFER, m_efbDepth);
-		if (m_msaaCoverageSamples)
-			glRenderbufferStorageMultisampleCoverageNV(GL_RENDERBUFFER, m_msaaCoverageSamples, m_msaaSamples, GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight);
-		else
-			glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_msaaSamples, GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight);
-
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		m_efbColor = g_render_target_pool->Acquire(RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_RGBA,
+			m_msaaSamples, m_msaaCoverageSamples));
+		m_efbDepth = g_render_target_pool->Acquire(RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_DEPTH_COMPONENT24,
+			m_msaaSamples, m_msaaCoverageSamples));
 
 		// Bind target renderbuffers to EFB framebuffer.
 
@@ -143,21 +167,8 @@ FramebufferManager::FramebufferManager(int targetWidth, int targetHeight, int ms
 
 		glGenFramebuffers(1, &m_resolvedFramebuffer);
 
-		glGenTextures(2, glObj);
-		m_resolvedColorTexture = glObj[0];
-		m_resolvedDepthTexture = glObj[1];
-
-		glBindTexture(GL_TEXTURE_2D, m_resolvedColorTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_targetWidth, m_targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-
-		glBindTexture(GL_TEXTURE_2D, m_resolvedDepthTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+		m_resolvedColorTexture = g_render_target_pool->Acquire(color_key);
+		m_resolvedDepthTexture = g_render_target_pool->Acquire(depth_key);
 
 		// Bind resolved textures to resolved framebuffer.
 
@@ -237,18 +248,28 @@ FramebufferManager::~FramebufferManager()
 	m_efbFramebuffer = 0;
 	m_xfbFramebuffer = 0;
 
-	glObj[0] = m_resolvedColorTexture;
-	glObj[1] = m_resolvedDepthTexture;
-	glDeleteTextures(2, glObj);
+	// The targets go back to the pool
+	const RenderTargetKey color_key = RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_RGBA);
+	const RenderTargetKey depth_key = RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_DEPTH_COMPONENT24);
+
+	g_render_target_pool->Release(color_key, m_resolvedColorTexture);
+	if (m_resolvedDepthTexture)
+		g_render_target_pool->Release(depth_key, m_resolvedDepthTexture);
 	m_resolvedColorTexture = 0;
 	m_resolvedDepthTexture = 0;
 
-	glObj[0] = m_efbColor;
-	glObj[1] = m_efbDepth;
 	if (m_msaaSamples <= 1)
-		glDeleteTextures(2, glObj);
+	{
+		g_render_target_pool->Release(color_key, m_efbColor);
+		g_render_target_pool->Release(depth_key, m_efbDepth);
+	}
 	else
-		glDeleteRenderbuffers(2, glObj);
+	{
+		g_render_target_pool->Release(RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_RGBA,
+			m_msaaSamples, m_msaaCoverageSamples), m_efbColor);
+		g_render_target_pool->Release(RenderTargetPool::MakeKey(m_targetWidth, m_targetHeight, GL_DEPTH_COMPONENT24,
+			m_msaaSamples, m_msaaCoverageSamples), m_efbDepth);
+	}
 	m_efbColor = 0;
 	m_efbDepth = 0;
 
@@ -327,7 +348,7 @@ void FramebufferManager::CopyToRealXFB(u32 xfbAddr, u32 fbWidth, u32 fbHeight, c
 	}
 
 	TargetRectangle targetRc = g_renderer->ConvertEFBRectangle(sourceRc);
-	TextureConverter::EncodeToRamYUYV(ResolveAndGetRenderTarget(sourceRc), targetRc, xfb_in_ram, fbWidth, fbHeight);
+	TextureConverter::EncodeToRamYUYV(ResolveAndGetRenderTarget(sourceRc), targetRc, xfbAddr, fbWidth, fbHeight);
 }
 
 void FramebufferManager::SetFramebuffer(GLuint fb)
@@ -390,7 +411,7 @@ void FramebufferManager::ReinterpretPixelData(unsigned int convtype)
 
 XFBSource::~XFBSource()
 {
-	glDeleteTextures(1, &texture);
+	g_render_target_pool->Release(pool_key, texture);
 }
 
 
@@ -408,7 +429,9 @@ void XFBSource::Draw(const MathUtil::Rectangle<int> &sourcerc,
 
 void XFBSource::DecodeToTexture(u32 xfbAddr, u32 fbWidth, u32 fbHeight)
 {
-	TextureConverter::DecodeToTexture(xfbAddr, fbWidth, fbHeight, texture);
+	// The texture still holds the last decode if the XFB didn't change
+	if (m_tracker.Update(xfbAddr, fbWidth, fbHeight))
+		TextureConverter::DecodeToTexture(xfbAddr, fbWidth, fbHeight, texture);
 }
 
 void XFBSource::CopyEFB(float Gamma)
@@ -438,16 +461,9 @@ void XFBSource::CopyEFB(float Gamma)
 
 XFBSourceBase* FramebufferManager::CreateXFBSource(unsigned int target_width, unsigned int target_height)
 {
-	GLuint texture;
-
-	glGenTextures(1, &texture);
-
-	glActiveTexture(GL_TEXTURE0 + 9);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target_width, target_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-
-	return new XFBSource(texture);
+	// Same as the EFB color texture, so they can take each other's place in the pool
+	const RenderTargetKey key = RenderTargetPool::MakeKey(target_width, target_height, GL_RGBA);
+	return new XFBSource(g_render_target_pool->Acquire(key), key);
 }
 
 void FramebufferManager::GetTargetSize(unsigned int *width, unsigned int *height, const EFBRectangle& sourceRc)
@@ -8,6 +8,7 @@
 #include "FramebufferManagerBase.h"
 #include "ProgramShaderCache.h"
 #include "Render.h"
+#include "RenderTargetPool.h"
 
 // On the GameCube, the game sends a request for the graphics processor to
 // transfer its internal EFB (Embedded Framebuffer) to an area in GameCube RAM
@@ -43,9 +44,29 @@
 
 namespace OGL {
 
+// Targets are textures when they aren't multisampled and renderbuffers
+// otherwise. The format of the key is the internal format, with the number
+// of coverage samples in the upper half for CSAA.
+class RenderTargetPool : public ::RenderTargetPool<GLuint>
+{
+public:
+	~RenderTargetPool() { Clear(); }
+
+	static RenderTargetKey MakeKey(u32 width, u32 height, GLenum internal_format,
+		u32 samples = 1, u32 coverage_samples = 0);
+
+private:
+	GLuint CreateTarget(const RenderTargetKey& key) override;
+	void DestroyTarget(const RenderTargetKey& key, GLuint target) override;
+	u64 GetTargetSize(const RenderTargetKey& key) const override;
+};
+
+// Outlives the framebuffer managers, which are recreated on resolution changes
+extern RenderTargetPool* g_render_target_pool;
+
 struct XFBSource : public XFBSourceBase
 {
-	XFBSource(GLuint tex) : texture(tex) {}
+	XFBSource(GLuint tex, const RenderTargetKey& key) : texture(tex), pool_key(key) {}
 	~XFBSource();
 
 	void CopyEFB(float Gamma) override;
@@ -54,6 +75,10 @@ struct XFBSource : public XFBSourceBase
 		const MathUtil::Rectangle<float> &drawrc) const override;
 
 	const GLuint texture;
+	const RenderTargetKey pool_key;
+
+private:
+	RealXFBTracker m_tracker;
 };
 
 class FramebufferManager : public FramebufferManagerBase
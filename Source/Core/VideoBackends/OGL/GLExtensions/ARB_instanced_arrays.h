@@ -0,0 +1,8 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "gl_common.h"
+
+extern PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+
@@ -749,6 +749,20 @@ PFNGLRENDERBUFFERSTORAGEMULTISAMPLECOVERAGENVPROC glRenderbufferStorageMultisamp
 // ARB_sample_shading
 PFNGLMINSAMPLESHADINGARBPROC glMinSampleShadingARB;
 
+// ARB_timer_query
+PFNGLQUERYCOUNTERPROC glQueryCounter;
+PFNGLGETQUERYOBJECTI64VPROC glGetQueryObjecti64v;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+
+// ARB_shader_image_load_store
+PFNGLMEMORYBARRIERPROC glMemoryBarrier;
+
+// ARB_instanced_arrays
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+
+// ARB_multi_draw_indirect
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
+
 // ARB_debug_output
 PFNGLDEBUGMESSAGECALLBACKARBPROC glDebugMessageCallbackARB;
 PFNGLDEBUGMESSAGECONTROLARBPROC glDebugMessageControlARB;
@@ -1525,12 +1539,35 @@ const GLFunc gl_function_array[] =
 	GLFUNC_REQUIRES(glDrawRangeElementsBaseVertex,     "GL_ARB_draw_elements_base_vertex"),
 	GLFUNC_REQUIRES(glMultiDrawElementsBaseVertex,     "GL_ARB_draw_elements_base_vertex"),
 
+	// EXT_draw_elements_base_vertex / OES_draw_elements_base_vertex, the GLES3 versions of the above
+	// Multi draws aren't used on GLES3, so glMultiDrawElementsBaseVertex stays unloaded
+	GLFUNC_SUFFIX(glDrawElementsBaseVertex,          EXT, "GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+	GLFUNC_SUFFIX(glDrawElementsInstancedBaseVertex, EXT, "GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+	GLFUNC_SUFFIX(glDrawRangeElementsBaseVertex,     EXT, "GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+	GLFUNC_SUFFIX(glDrawElementsBaseVertex,          OES, "GL_OES_draw_elements_base_vertex !GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+	GLFUNC_SUFFIX(glDrawElementsInstancedBaseVertex, OES, "GL_OES_draw_elements_base_vertex !GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+	GLFUNC_SUFFIX(glDrawRangeElementsBaseVertex,     OES, "GL_OES_draw_elements_base_vertex !GL_EXT_draw_elements_base_vertex !GL_ARB_draw_elements_base_vertex"),
+
 	// NV_framebuffer_multisample_coverage
 	GLFUNC_REQUIRES(glRenderbufferStorageMultisampleCoverageNV, "GL_NV_framebuffer_multisample_coverage"),
 
 	// ARB_sample_shading
 	GLFUNC_REQUIRES(glMinSampleShadingARB, "GL_ARB_sample_shading"),
 
+	// ARB_timer_query
+	GLFUNC_REQUIRES(glQueryCounter,        "GL_ARB_timer_query"),
+	GLFUNC_REQUIRES(glGetQueryObjecti64v,  "GL_ARB_timer_query"),
+	GLFUNC_REQUIRES(glGetQueryObjectui64v, "GL_ARB_timer_query"),
+
+	// ARB_shader_image_load_store
+	GLFUNC_REQUIRES(glMemoryBarrier, "GL_ARB_shader_image_load_store"),
+
+	// ARB_instanced_arrays, only the core 3.3 name
+	GLFUNC_REQUIRES(glVertexAttribDivisor, "VERSION_3_3"),
+
+	// ARB_multi_draw_indirect
+	GLFUNC_REQUIRES(glMultiDrawElementsIndirect, "GL_ARB_multi_draw_indirect"),
+
 	// ARB_debug_output
 	GLFUNC_REQUIRES(glDebugMessageCallbackARB, "GL_ARB_debug_output"),
 	GLFUNC_REQUIRES(glDebugMessageControlARB,  "GL_ARB_debug_output"),
@@ -1562,6 +1599,9 @@ const GLFunc gl_function_array[] =
 	// ARB_buffer_storage
 	GLFUNC_REQUIRES(glBufferStorage,         "GL_ARB_buffer_storage"),
 	GLFUNC_REQUIRES(glNamedBufferStorageEXT, "GL_ARB_buffer_storage GL_EXT_direct_state_access"),
+
+	// EXT_buffer_storage, the GLES3 version of the above
+	GLFUNC_SUFFIX(glBufferStorage, EXT, "GL_EXT_buffer_storage !GL_ARB_buffer_storage"),
 };
 
 namespace GLExtensions
@@ -1793,7 +1833,7 @@ namespace GLExtensions
 		while (buffer >> tmp)
 		{
 			if (tmp[0] == '!')
-				result &= !m_extension_list[tmp.erase(0)];
+				result &= !m_extension_list[tmp.erase(0, 1)];
 			else
 				result &= m_extension_list[tmp];
 		}
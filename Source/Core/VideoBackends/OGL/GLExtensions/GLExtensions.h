@@ -29,9 +29,13 @@
 #include "ARB_draw_elements_base_vertex.h"
 #include "NV_framebuffer_multisample_coverage.h"
 #include "ARB_sample_shading.h"
+#include "ARB_timer_query.h"
+#include "ARB_shader_image_load_store.h"
 #include "ARB_debug_output.h"
 #include "KHR_debug.h"
 #include "ARB_buffer_storage.h"
+#include "ARB_instanced_arrays.h"
+#include "ARB_multi_draw_indirect.h"
 
 namespace GLExtensions
 {
@@ -0,0 +1,88 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "DynamicResolution.h"
+
+#include "GPUTimer.h"
+
+namespace OGL
+{
+
+GPUTimer::GPUTimer()
+	: m_read_pos(0), m_count(0), m_in_frame(false)
+{
+	glGenQueries(NUM_FRAMES, m_begin_queries);
+	glGenQueries(NUM_FRAMES, m_end_queries);
+}
+
+GPUTimer::~GPUTimer()
+{
+	glDeleteQueries(NUM_FRAMES, m_begin_queries);
+	glDeleteQueries(NUM_FRAMES, m_end_queries);
+}
+
+void GPUTimer::BeginFrame()
+{
+	m_in_frame = m_count < NUM_FRAMES;
+	if (m_in_frame)
+		glQueryCounter(m_begin_queries[(m_read_pos + m_count) % NUM_FRAMES], GL_TIMESTAMP);
+}
+
+void GPUTimer::EndFrame()
+{
+	if (m_in_frame)
+	{
+		glQueryCounter(m_end_queries[(m_read_pos + m_count) % NUM_FRAMES], GL_TIMESTAMP);
+		m_count++;
+		m_in_frame = false;
+	}
+
+	while (m_count)
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(m_end_queries[m_read_pos], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 begin, end;
+		glGetQueryObjectui64v(m_begin_queries[m_read_pos], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(m_end_queries[m_read_pos], GL_QUERY_RESULT, &end);
+		DynamicResolution::AddFrameTime((float)(end - begin) / 1000000.f);
+
+		m_read_pos = (m_read_pos + 1) % NUM_FRAMES;
+		m_count--;
+	}
+}
+
+DrawTimer::~DrawTimer()
+{
+	if (!m_queries.empty())
+		glDeleteQueries((GLsizei)m_queries.size(), &m_queries[0]);
+}
+
+void DrawTimer::Timestamp(u32 index)
+{
+	if (index >= m_queries.size())
+	{
+		size_t old_size = m_queries.size();
+		m_queries.resize(std::max<size_t>(old_size * 2, 1024));
+		glGenQueries((GLsizei)(m_queries.size() - old_size), &m_queries[old_size]);
+	}
+	glQueryCounter(m_queries[index], GL_TIMESTAMP);
+}
+
+u64 DrawTimer::GetElapsed(u32 begin, u32 end)
+{
+	if (end >= m_queries.size())
+		return 0;
+
+	GLuint64 begin_time, end_time;
+	glGetQueryObjectui64v(m_queries[begin], GL_QUERY_RESULT, &begin_time);
+	glGetQueryObjectui64v(m_queries[end], GL_QUERY_RESULT, &end_time);
+	return end_time > begin_time ? end_time - begin_time : 0;
+}
+
+}  // namespace OGL
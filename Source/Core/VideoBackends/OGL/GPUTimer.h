@@ -0,0 +1,56 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Debugger.h"
+#include "GLUtil.h"
+
+namespace OGL
+{
+
+// Times the frames on the GPU with timestamp queries, for the dynamic
+// resolution. The results are read a few frames later, when they are ready,
+// so measuring never waits for the GPU.
+class GPUTimer
+{
+public:
+	GPUTimer();
+	~GPUTimer();
+
+	// Called after a frame was presented and before the next one is drawn
+	void BeginFrame();
+	// Called once the frame was drawn, passes the ready results to DynamicResolution
+	void EndFrame();
+
+private:
+	// Frames in flight. A frame isn't timed if all of them are still pending.
+	static const u32 NUM_FRAMES = 4;
+
+	GLuint m_begin_queries[NUM_FRAMES];
+	GLuint m_end_queries[NUM_FRAMES];
+	u32 m_read_pos;
+	u32 m_count;
+	bool m_in_frame;
+};
+
+// The timestamps of the GFX debugger's draw capture. The queries are only
+// read once the capture is over.
+class DrawTimer : public GFXDebuggerDrawTimer
+{
+public:
+	~DrawTimer();
+
+	void Reset() override {}
+	void Timestamp(u32 index) override;
+	u64 GetElapsed(u32 begin, u32 end) override;
+
+private:
+	// Kept between captures
+	std::vector<GLuint> m_queries;
+};
+
+}  // namespace OGL
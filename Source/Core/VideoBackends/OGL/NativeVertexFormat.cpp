@@ -70,6 +70,16 @@ void GLVertexFormat::Initialize(const PortableVertexDeclaration &_vtx_decl)
 
 	// the element buffer is bound directly to the vao, so we must it set for every vao
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vm->m_index_buffers);
+
+	// The index of the draw in a multi-draw batch, picked by the base instance
+	if (g_ActiveConfig.backend_info.bSupportsMultiDraw)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vm->m_draw_index_buffer);
+		glEnableVertexAttribArray(SHADER_DRAWID_ATTRIB);
+		glVertexAttribIPointer(SHADER_DRAWID_ATTRIB, 1, GL_UNSIGNED_INT, 0, NULL);
+		glVertexAttribDivisor(SHADER_DRAWID_ATTRIB, 1);
+	}
+
 	glBindBuffer(GL_ARRAY_BUFFER, vm->m_vertex_buffers);
 
 	SetPointer(SHADER_POSITION_ATTRIB, vertex_stride, vtx_decl.position);
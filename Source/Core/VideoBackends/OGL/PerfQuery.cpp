@@ -11,7 +11,8 @@ namespace OGL
 {
 
 PerfQuery::PerfQuery()
-	: m_query_read_pos()
+	: m_query_buffer(PERF_QUERY_BUFFER_SIZE)
+	, m_query_read_pos()
 	, m_query_count()
 {
 	for (ActiveQuery& query : m_query_buffer)
@@ -34,8 +35,15 @@ void PerfQuery::EnableQuery(PerfQueryGroup type)
 
 	if (m_query_buffer.size() == m_query_count)
 	{
-		FlushOne();
-		//ERROR_LOG(VIDEO, "Flushed query buffer early!");
+		if (m_query_buffer.size() < PERF_QUERY_BUFFER_MAX_SIZE)
+		{
+			GrowBuffer();
+		}
+		else
+		{
+			FlushOne();
+			//ERROR_LOG(VIDEO, "Flushed query buffer early!");
+		}
 	}
 
 	// start query
@@ -59,6 +67,18 @@ void PerfQuery::DisableQuery(PerfQueryGroup type)
 	}
 }
 
+void PerfQuery::GrowBuffer()
+{
+	std::vector<ActiveQuery> buffer(m_query_buffer.size() * 2);
+	for (u32 i = 0; i != m_query_buffer.size(); ++i)
+		buffer[i] = m_query_buffer[(m_query_read_pos + i) % m_query_buffer.size()];
+	for (u32 i = m_query_buffer.size(); i != buffer.size(); ++i)
+		glGenQueries(1, &buffer[i].query_id);
+
+	m_query_buffer.swap(buffer);
+	m_query_read_pos = 0;
+}
+
 bool PerfQuery::IsFlushed() const
 {
 	return 0 == m_query_count;
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <array>
+#include <vector>
+
 #include "PerfQueryBase.h"
 
 namespace OGL {
@@ -16,7 +17,8 @@ public:
 	void ResetQuery() override;
 	u32 GetQueryResult(PerfQueryType type) override;
 	void FlushResults() override;
-	bool IsFlushed() const;
+	void WeakFlush() override;
+	bool IsFlushed() const override;
 
 private:
 	struct ActiveQuery
@@ -27,13 +29,16 @@ private:
 
 	// when testing in SMS: 64 was too small, 128 was ok
 	static const u32 PERF_QUERY_BUFFER_SIZE = 512;
+	// The buffer grows instead of waiting for the GPU, up to this size.
+	static const u32 PERF_QUERY_BUFFER_MAX_SIZE = PERF_QUERY_BUFFER_SIZE * 32;
 
-	void WeakFlush();
+	// Doubles the buffer, keeping the pending queries in order.
+	void GrowBuffer();
 	// Only use when non-empty
 	void FlushOne();
 
 	// This contains gl query objects with unretrieved results.
-	std::array<ActiveQuery, PERF_QUERY_BUFFER_SIZE> m_query_buffer;
+	std::vector<ActiveQuery> m_query_buffer;
 	u32 m_query_read_pos;
 
 	// TODO: sloppy
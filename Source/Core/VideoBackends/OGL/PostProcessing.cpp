@@ -4,6 +4,7 @@
 
 #include "CommonPaths.h"
 #include "FileUtil.h"
+#include "Timer.h"
 #include "VideoCommon.h"
 #include "VideoConfig.h"
 #include "GLUtil.h"
@@ -28,6 +29,17 @@ static GLuint s_texture;
 
 static GLuint s_uniform_resolution;
 
+// The file of the current shader, which is reloaded when it changes
+static std::string s_shader_path;
+static u64 s_shader_size;
+static u64 s_shader_mtime;
+static u32 s_last_poll_time;
+static const u32 RELOAD_POLL_INTERVAL = 500; // ms
+
+// The shaders are compiled in the background while the current one stays in
+// use. Only the last compile that was started is used once it's linked.
+static u32 s_compile_generation;
+
 static char s_vertex_shader[] =
 	"out vec2 uv0;\n"
 	"void main(void) {\n"
@@ -57,6 +69,7 @@ void Init()
 
 void Shutdown()
 {
+	s_compile_generation++;
 	s_shader.Destroy();
 
 	glDeleteFramebuffers(1, &s_fbo);
@@ -110,43 +123,89 @@ void Update ( u32 width, u32 height )
 	}
 }
 
-void ApplyShader()
+static void ShaderCompiled(u32 generation, const std::string& name, SHADER& shader, bool success)
 {
-	// shader didn't changed
-	if (s_currentShader == g_ActiveConfig.sPostProcessingShader) return;
-	s_currentShader = g_ActiveConfig.sPostProcessingShader;
-	s_enable = false;
+	// A newer version was started in the meantime
+	if (generation != s_compile_generation)
+	{
+		shader.Destroy();
+		return;
+	}
+
+	if (!success) {
+		ERROR_LOG(VIDEO, "Failed to compile post-processing shader %s", name.c_str());
+		return;
+	}
+
 	s_shader.Destroy();
+	s_shader = shader;
 
-	// shader disabled
-	if (g_ActiveConfig.sPostProcessingShader == "") return;
+	// read uniform locations
+	s_uniform_resolution = glGetUniformLocation(s_shader.glprogid, "resolution");
+
+	// successful
+	s_enable = true;
+}
 
-	// so need to compile shader
+static void LoadShader()
+{
+	s_shader_size = s_shader_mtime = 0;
+	File::GetSizeAndModificationTime(s_shader_path, &s_shader_size, &s_shader_mtime);
 
 	// loading shader code
 	std::string code;
-	std::string path = File::GetUserPath(D_SHADERS_IDX) + g_ActiveConfig.sPostProcessingShader + ".glsl";
-	if (!File::Exists(path))
-	{
-		// Fallback to shared user dir
-		path = File::GetSysDirectory() + SHADERS_DIR DIR_SEP + g_ActiveConfig.sPostProcessingShader + ".glsl";
-	}
-	if(!File::ReadFileToString(path.c_str(), code)) {
-		ERROR_LOG(VIDEO, "Post-processing shader not found: %s", path.c_str());
+	if(!File::ReadFileToString(s_shader_path.c_str(), code)) {
+		ERROR_LOG(VIDEO, "Post-processing shader not found: %s", s_shader_path.c_str());
 		return;
 	}
 
 	// and compile it
-	if (!ProgramShaderCache::CompileShader(s_shader, s_vertex_shader, code.c_str())) {
-		ERROR_LOG(VIDEO, "Failed to compile post-processing shader %s", s_currentShader.c_str());
+	const u32 generation = ++s_compile_generation;
+	const std::string name = s_currentShader;
+	ProgramShaderCache::CompileShaderAsync(s_vertex_shader, code.c_str(),
+		[generation, name](SHADER& shader, bool success) { ShaderCompiled(generation, name, shader, success); });
+}
+
+void ApplyShader()
+{
+	ProgramShaderCache::PollCompiledShaders();
+
+	// shader didn't changed, but its file may have
+	if (s_currentShader == g_ActiveConfig.sPostProcessingShader)
+	{
+		if (s_shader_path.empty() || Common::Timer::GetTimeMs() - s_last_poll_time < RELOAD_POLL_INTERVAL)
+			return;
+		s_last_poll_time = Common::Timer::GetTimeMs();
+
+		u64 size, mtime;
+		if (File::GetSizeAndModificationTime(s_shader_path, &size, &mtime) &&
+		    (size != s_shader_size || mtime != s_shader_mtime))
+		{
+			NOTICE_LOG(VIDEO, "Reloading post-processing shader %s", s_currentShader.c_str());
+			LoadShader();
+		}
 		return;
 	}
+	s_currentShader = g_ActiveConfig.sPostProcessingShader;
+	s_shader_path.clear();
 
-	// read uniform locations
-	s_uniform_resolution = glGetUniformLocation(s_shader.glprogid, "resolution");
+	// shader disabled
+	if (g_ActiveConfig.sPostProcessingShader == "")
+	{
+		s_compile_generation++;
+		s_enable = false;
+		s_shader.Destroy();
+		return;
+	}
 
-	// successful
-	s_enable = true;
+	// so need to compile shader, the current one is kept until it's done
+	s_shader_path = File::GetUserPath(D_SHADERS_IDX) + g_ActiveConfig.sPostProcessingShader + ".glsl";
+	if (!File::Exists(s_shader_path))
+	{
+		// Fallback to shared user dir
+		s_shader_path = File::GetSysDirectory() + SHADERS_DIR DIR_SEP + g_ActiveConfig.sPostProcessingShader + ".glsl";
+	}
+	LoadShader();
 }
 
 }  // namespace
@@ -3,9 +3,13 @@
 // Refer to the license.txt file included.
 
 #include "ProgramShaderCache.h"
+#include "Atomic.h"
 #include "DriverDetails.h"
+#include "GLInterface/GLInterface.h"
 #include "MathUtil.h"
+#include "PerfTrace.h"
 #include "StreamBuffer.h"
+#include "Timer.h"
 #include "Debugger.h"
 #include "Statistics.h"
 #include "ImageWrite.h"
@@ -22,6 +26,7 @@ u32 ProgramShaderCache::s_ubo_buffer_size;
 s32 ProgramShaderCache::s_ubo_align;
 
 static StreamBuffer *s_buffer;
+static u32 s_buffer_wrap_count;
 static int num_failures = 0;
 
 LinearDiskCache<SHADERUID, u8> g_program_disk_cache;
@@ -32,6 +37,19 @@ SHADERUID ProgramShaderCache::last_uid;
 UidChecker<PixelShaderUid,PixelShaderCode> ProgramShaderCache::pixel_uid_checker;
 UidChecker<VertexShaderUid,VertexShaderCode> ProgramShaderCache::vertex_uid_checker;
 
+bool ProgramShaderCache::s_async_compile;
+volatile bool ProgramShaderCache::s_compile_thread_running;
+std::thread ProgramShaderCache::s_compile_thread;
+std::mutex ProgramShaderCache::s_compile_lock;
+Common::Event ProgramShaderCache::s_compile_event;
+Common::Event ProgramShaderCache::s_compile_thread_started;
+bool ProgramShaderCache::s_compile_context_current;
+std::deque<ProgramShaderCache::CompileJob*> ProgramShaderCache::s_compile_queue;
+std::deque<ProgramShaderCache::CompileJob*> ProgramShaderCache::s_compiled_queue;
+volatile u32 ProgramShaderCache::s_num_compiled;
+u32 ProgramShaderCache::s_num_preloading;
+u32 ProgramShaderCache::s_preload_start_time;
+
 static char s_glsl_header[1024] = "";
 
 void SHADER::SetProgramVariables()
@@ -63,6 +81,16 @@ void SHADER::SetProgramVariables()
 			glUniform1i(loc, a);
 	}
 
+	// Only in shaders expanding lines and points
+	const char* expand_samplers[] = { "vexpand_float", "vexpand_uint", "vexpand_index" };
+	for (int a = 0; a < 3; ++a)
+	{
+		int loc = glGetUniformLocation(glprogid, expand_samplers[a]);
+		if (loc != -1)
+			glUniform1i(loc, EXPAND_TEXTURE_UNIT + a);
+	}
+	expand_layout_loc = glGetUniformLocation(glprogid, I_EXPANDLAYOUT);
+	expand_params_loc = glGetUniformLocation(glprogid, I_EXPANDPARAMS);
 }
 
 void SHADER::SetProgramBindings()
@@ -92,6 +120,8 @@ void SHADER::SetProgramBindings()
 		snprintf(attrib_name, 8, "tex%d", i);
 		glBindAttribLocation(glprogid, SHADER_TEXTURE0_ATTRIB+i, attrib_name);
 	}
+
+	glBindAttribLocation(glprogid, SHADER_DRAWID_ATTRIB, "draw_index");
 }
 
 void SHADER::Bind()
@@ -109,40 +139,92 @@ void ProgramShaderCache::UploadConstants()
 	{
 		auto buffer = s_buffer->Map(s_ubo_buffer_size, s_ubo_align);
 
-		memcpy(buffer.first,
-			&PixelShaderManager::constants, sizeof(PixelShaderConstants));
+		// The block which didn't change stays bound to its old range, unless the buffer
+		// wrapped around since then and it may have been overwritten.
+		if (s_buffer->GetWrapCount() != s_buffer_wrap_count)
+		{
+			s_buffer_wrap_count = s_buffer->GetWrapCount();
+			PixelShaderManager::dirty = true;
+			VertexShaderManager::dirty = true;
+		}
+
+		size_t used_size = 0;
+		size_t pixel_offset = 0;
+		if (PixelShaderManager::dirty)
+		{
+			memcpy(buffer.first, &PixelShaderManager::constants, sizeof(PixelShaderConstants));
+			pixel_offset = buffer.second;
+			used_size += ROUND_UP(sizeof(PixelShaderConstants), s_ubo_align);
+		}
 
-		memcpy(buffer.first + ROUND_UP(sizeof(PixelShaderConstants), s_ubo_align),
-			&VertexShaderManager::constants, sizeof(VertexShaderConstants));
+		size_t vertex_offset = 0;
+		if (VertexShaderManager::dirty)
+		{
+			memcpy(buffer.first + used_size, &VertexShaderManager::constants, sizeof(VertexShaderConstants));
+			vertex_offset = buffer.second + used_size;
+			used_size += ROUND_UP(sizeof(VertexShaderConstants), s_ubo_align);
+		}
 
-		s_buffer->Unmap(s_ubo_buffer_size);
-		glBindBufferRange(GL_UNIFORM_BUFFER, 1, s_buffer->m_buffer, buffer.second,
+		s_buffer->Unmap(used_size);
+		if (PixelShaderManager::dirty)
+			glBindBufferRange(GL_UNIFORM_BUFFER, 1, s_buffer->m_buffer, pixel_offset,
 					sizeof(PixelShaderConstants));
-		glBindBufferRange(GL_UNIFORM_BUFFER, 2, s_buffer->m_buffer, buffer.second + ROUND_UP(sizeof(PixelShaderConstants), s_ubo_align),
+		if (VertexShaderManager::dirty)
+			glBindBufferRange(GL_UNIFORM_BUFFER, 2, s_buffer->m_buffer, vertex_offset,
 					sizeof(VertexShaderConstants));
 
 		PixelShaderManager::dirty = false;
 		VertexShaderManager::dirty = false;
 
-		ADDSTAT(stats.thisFrame.bytesUniformStreamed, s_ubo_buffer_size);
+		ADDSTAT(stats.thisFrame.bytesUniformStreamed, used_size);
 	}
 }
 
+void ProgramShaderCache::UploadMultiDrawConstants(const PixelShaderConstants* pixel_constants,
+	const VertexShaderConstants* vertex_constants, u32 count)
+{
+	// The blocks are declared with all MULTIDRAW_BATCH_SIZE elements, so the whole
+	// range is bound even if the batch is shorter
+	const size_t pixel_size = ROUND_UP(MULTIDRAW_BATCH_SIZE * sizeof(PixelShaderConstants), s_ubo_align);
+	const size_t vertex_size = ROUND_UP(MULTIDRAW_BATCH_SIZE * sizeof(VertexShaderConstants), s_ubo_align);
+
+	auto buffer = s_buffer->Map(pixel_size + vertex_size, s_ubo_align);
+	memcpy(buffer.first, pixel_constants, count * sizeof(PixelShaderConstants));
+	memcpy(buffer.first + pixel_size, vertex_constants, count * sizeof(VertexShaderConstants));
+	s_buffer->Unmap(pixel_size + vertex_size);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, s_buffer->m_buffer, buffer.second,
+			MULTIDRAW_BATCH_SIZE * sizeof(PixelShaderConstants));
+	glBindBufferRange(GL_UNIFORM_BUFFER, 2, s_buffer->m_buffer, buffer.second + pixel_size,
+			MULTIDRAW_BATCH_SIZE * sizeof(VertexShaderConstants));
+
+	// Draws outside of a batch have to bind their own ranges again
+	PixelShaderManager::dirty = true;
+	VertexShaderManager::dirty = true;
+
+	ADDSTAT(stats.thisFrame.bytesUniformStreamed, pixel_size + vertex_size);
+}
+
 GLuint ProgramShaderCache::GetCurrentProgram(void)
 {
 	return CurrentProgram;
 }
 
-SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 components )
+SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 components, VS_EXPAND expand )
 {
+	PollCompiledShaders();
+
 	SHADERUID uid;
-	GetShaderId(&uid, dstAlphaMode, components);
+	GetShaderId(&uid, dstAlphaMode, components, expand);
 
 	// Check if the shader is already set
 	if (last_entry)
 	{
 		if (uid == last_uid)
 		{
+			if (last_entry->pending)
+				return NULL;
+
 			GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
 			last_entry->shader.Bind();
 			return &last_entry->shader;
@@ -158,6 +240,9 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 		PCacheEntry *entry = &iter->second;
 		last_entry = entry;
 
+		if (entry->pending)
+			return NULL;
+
 		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
 		last_entry->shader.Bind();
 		return &last_entry->shader;
@@ -170,7 +255,7 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 
 	VertexShaderCode vcode;
 	PixelShaderCode pcode;
-	GenerateVertexShaderCode(vcode, components, API_OPENGL);
+	GenerateVertexShaderCode(vcode, components, API_OPENGL, expand);
 	GeneratePixelShaderCode(pcode, dstAlphaMode, API_OPENGL, components);
 
 	if (g_ActiveConfig.bEnableShaderDebugging)
@@ -190,6 +275,13 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 	}
 #endif
 
+	if (s_async_compile)
+	{
+		newentry.pending = true;
+		QueueCompileJob(uid, vcode.GetBuffer(), pcode.GetBuffer());
+		return NULL;
+	}
+
 	if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer())) {
 		GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
 		return NULL;
@@ -205,6 +297,48 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 
 bool ProgramShaderCache::CompileShader ( SHADER& shader, const char* vcode, const char* pcode )
 {
+	if (!CompileProgram(shader, vcode, pcode))
+		return false;
+
+	shader.SetProgramVariables();
+
+	return true;
+}
+
+void ProgramShaderCache::CompileShaderAsync(const char* vcode, const char* pcode, const CompileCallback& callback)
+{
+	if (!s_async_compile)
+	{
+		SHADER shader;
+		bool success = CompileShader(shader, vcode, pcode);
+		callback(shader, success);
+		return;
+	}
+
+	CompileJob* job = new CompileJob;
+	job->vcode = vcode;
+	job->pcode = pcode;
+	job->success = false;
+	job->callback = callback;
+
+	{
+		std::lock_guard<std::mutex> lk(s_compile_lock);
+		s_compile_queue.push_back(job);
+	}
+	s_compile_event.Set();
+}
+
+void ProgramShaderCache::PollCompiledShaders()
+{
+	if (s_async_compile && Common::AtomicLoad(s_num_compiled))
+		RetrieveCompiledShaders();
+}
+
+// Only touches the program object itself, so this is safe to call from the compiler thread.
+bool ProgramShaderCache::CompileProgram ( SHADER& shader, const char* vcode, const char* pcode )
+{
+	PERF_SCOPE(CAT_SHADER_COMPILE);
+
 	GLuint vsid = CompileSingleShader(GL_VERTEX_SHADER, vcode);
 	GLuint psid = CompileSingleShader(GL_FRAGMENT_SHADER, pcode);
 
@@ -265,14 +399,208 @@ bool ProgramShaderCache::CompileShader ( SHADER& shader, const char* vcode, cons
 
 		// Don't try to use this shader
 		glDeleteProgram(pid);
+		shader.glprogid = 0;
 		return false;
 	}
 
-	shader.SetProgramVariables();
-
 	return true;
 }
 
+void ProgramShaderCache::StartCompileThread()
+{
+	s_async_compile = false;
+	s_num_compiled = 0;
+
+	if (!g_ActiveConfig.bBackgroundShaderCompiling || g_ActiveConfig.bEnableShaderDebugging)
+		return;
+
+	if (!GLInterface->CreateSharedContext())
+	{
+		WARN_LOG(VIDEO, "Could not create a shared GL context, compiling shaders on the video thread.");
+		return;
+	}
+
+	s_compile_thread_running = true;
+	s_compile_thread = std::thread(CompileThreadFunc);
+
+	// Wait for the context to be made current, so that nothing is queued to
+	// a thread which can't compile it.
+	s_compile_thread_started.Wait();
+	if (!s_compile_context_current)
+	{
+		s_compile_thread.join();
+		GLInterface->DestroySharedContext();
+		WARN_LOG(VIDEO, "Could not use the shared GL context, compiling shaders on the video thread.");
+		return;
+	}
+
+	s_async_compile = true;
+}
+
+void ProgramShaderCache::StopCompileThread()
+{
+	if (!s_async_compile)
+		return;
+
+	s_compile_thread_running = false;
+	s_compile_event.Set();
+	s_compile_thread.join();
+	s_async_compile = false;
+
+	GLInterface->DestroySharedContext();
+
+	// Anything that didn't make it back to the video thread is thrown away.
+	// The programs are shared, so they can be deleted from this context.
+	for (CompileJob* job : s_compile_queue)
+		delete job;
+	for (CompileJob* job : s_compiled_queue)
+	{
+		job->shader.Destroy();
+		delete job;
+	}
+	s_compile_queue.clear();
+	s_compiled_queue.clear();
+	s_num_compiled = 0;
+}
+
+void ProgramShaderCache::CompileThreadFunc()
+{
+	Common::SetCurrentThreadName("Shader compiler");
+
+	s_compile_context_current = GLInterface->MakeSharedContextCurrent();
+	if (!s_compile_context_current)
+	{
+		ERROR_LOG(VIDEO, "Could not make the shared GL context current on the shader compiler thread.");
+		s_compile_thread_running = false;
+		s_compile_thread_started.Set();
+		return;
+	}
+	s_compile_thread_started.Set();
+
+	while (s_compile_thread_running)
+	{
+		CompileJob* job = NULL;
+		{
+			std::lock_guard<std::mutex> lk(s_compile_lock);
+			if (!s_compile_queue.empty())
+			{
+				job = s_compile_queue.front();
+				s_compile_queue.pop_front();
+			}
+		}
+
+		if (!job)
+		{
+			s_compile_event.Wait();
+			continue;
+		}
+
+		if (!job->binary.empty())
+			job->success = LoadProgramBinary(job->shader, job->binary_format, &job->binary[0], (GLint)job->binary.size());
+		else
+			job->success = CompileProgram(job->shader, job->vcode.c_str(), job->pcode.c_str());
+
+		// Linking has to be complete before the program is used from the other context.
+		glFinish();
+
+		std::lock_guard<std::mutex> lk(s_compile_lock);
+		s_compiled_queue.push_back(job);
+		Common::AtomicIncrement(s_num_compiled);
+	}
+
+	GLInterface->ClearSharedContextCurrent();
+}
+
+void ProgramShaderCache::QueueCompileJob(const SHADERUID& uid, const char* vcode, const char* pcode)
+{
+	CompileJob* job = new CompileJob;
+	job->uid = uid;
+	job->vcode = vcode;
+	job->pcode = pcode;
+	job->success = false;
+
+	{
+		std::lock_guard<std::mutex> lk(s_compile_lock);
+		s_compile_queue.push_back(job);
+	}
+	s_compile_event.Set();
+}
+
+void ProgramShaderCache::QueueBinaryJob(const SHADERUID& uid, GLenum format, const u8* binary, u32 size)
+{
+	CompileJob* job = new CompileJob;
+	job->uid = uid;
+	job->binary.assign(binary, binary + size);
+	job->binary_format = format;
+	job->success = false;
+
+	{
+		std::lock_guard<std::mutex> lk(s_compile_lock);
+		s_compile_queue.push_back(job);
+	}
+	s_compile_event.Set();
+}
+
+void ProgramShaderCache::RetrieveCompiledShaders()
+{
+	std::deque<CompileJob*> compiled;
+	{
+		std::lock_guard<std::mutex> lk(s_compile_lock);
+		compiled.swap(s_compiled_queue);
+		s_num_compiled = 0;
+	}
+
+	for (CompileJob* job : compiled)
+	{
+		if (job->callback)
+		{
+			if (job->success)
+				job->shader.SetProgramVariables();
+			job->callback(job->shader, job->success);
+			delete job;
+			continue;
+		}
+
+		PCache::iterator iter = pshaders.find(job->uid);
+		if (iter == pshaders.end())
+		{
+			job->shader.Destroy();
+			delete job;
+			continue;
+		}
+
+		PCacheEntry& entry = iter->second;
+		entry.pending = false;
+		if (job->success)
+		{
+			entry.shader.glprogid = job->shader.glprogid;
+			entry.shader.SetProgramVariables();
+			INCSTAT(stats.numPixelShadersCreated);
+		}
+		else if (entry.in_cache)
+		{
+			// The driver rejected the cached binary. Drop the entry so that
+			// the program gets generated from source the next time it is used.
+			if (last_entry == &entry)
+				last_entry = NULL;
+			pshaders.erase(iter);
+		}
+		else
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+		}
+
+		if (!job->binary.empty() && --s_num_preloading == 0)
+		{
+			NOTICE_LOG(VIDEO, "Finished loading cached shaders in %u ms",
+				Common::Timer::GetTimeMs() - s_preload_start_time);
+		}
+		delete job;
+	}
+
+	SETSTAT(stats.numPixelShadersAlive, pshaders.size());
+}
+
 GLuint ProgramShaderCache::CompileSingleShader (GLuint type, const char* code )
 {
 	GLuint result = glCreateShader(type);
@@ -330,10 +658,10 @@ GLuint ProgramShaderCache::CompileSingleShader (GLuint type, const char* code )
 	return result;
 }
 
-void ProgramShaderCache::GetShaderId(SHADERUID* uid, DSTALPHA_MODE dstAlphaMode, u32 components)
+void ProgramShaderCache::GetShaderId(SHADERUID* uid, DSTALPHA_MODE dstAlphaMode, u32 components, VS_EXPAND expand)
 {
 	GetPixelShaderUid(uid->puid, dstAlphaMode, API_OPENGL, components);
-	GetVertexShaderUid(uid->vuid, components, API_OPENGL);
+	GetVertexShaderUid(uid->vuid, components, API_OPENGL, expand);
 
 	if (g_ActiveConfig.bEnableShaderDebugging)
 	{
@@ -342,7 +670,7 @@ void ProgramShaderCache::GetShaderId(SHADERUID* uid, DSTALPHA_MODE dstAlphaMode,
 		pixel_uid_checker.AddToIndexAndCheck(pcode, uid->puid, "Pixel", "p");
 
 		VertexShaderCode vcode;
-		GenerateVertexShaderCode(vcode, components, API_OPENGL);
+		GenerateVertexShaderCode(vcode, components, API_OPENGL, expand);
 		vertex_uid_checker.AddToIndexAndCheck(vcode, uid->vuid, "Vertex", "v");
 	}
 }
@@ -365,6 +693,14 @@ void ProgramShaderCache::Init(void)
 	// So multiply by four to get how many floats we have from vec4s
 	// Then once more to get bytes
 	s_buffer = StreamBuffer::Create(GL_UNIFORM_BUFFER, UBO_LENGTH);
+	// nothing is bound yet
+	s_buffer_wrap_count = s_buffer->GetWrapCount() - 1;
+
+	CreateHeader();
+
+	// Started before reading the disk cache, so the cached binaries can be
+	// handed to the compiler thread instead of blocking the boot.
+	StartCompileThread();
 
 	// Read our shader cache, only if supported
 	if (g_ogl_config.bSupportsGLSLCache && !g_Config.bEnableShaderDebugging)
@@ -385,27 +721,34 @@ void ProgramShaderCache::Init(void)
 			sprintf(cache_filename, "%sogl-%s-shaders.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 				SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
 
+			s_num_preloading = 0;
+			s_preload_start_time = Common::Timer::GetTimeMs();
+
 			ProgramShaderCacheInserter inserter;
-			g_program_disk_cache.OpenAndRead(cache_filename, inserter);
+			g_program_disk_cache.OpenAndRead(cache_filename, inserter,
+				SConfig::GetInstance().m_LocalCoreStartupParameter.bReadOnlyCaches);
+
+			if (s_num_preloading)
+				NOTICE_LOG(VIDEO, "Loading %u cached shaders in the background", s_num_preloading);
 		}
 		SETSTAT(stats.numPixelShadersAlive, pshaders.size());
 	}
 
-	CreateHeader();
-
 	CurrentProgram = 0;
 	last_entry = NULL;
 }
 
 void ProgramShaderCache::Shutdown(void)
 {
+	StopCompileThread();
+
 	// store all shaders in cache on disk
 	if (g_ogl_config.bSupportsGLSLCache && !g_Config.bEnableShaderDebugging)
 	{
 		PCache::iterator iter = pshaders.begin();
 		for (; iter != pshaders.end(); ++iter)
 		{
-			if(iter->second.in_cache) continue;
+			if(iter->second.in_cache || iter->second.pending) continue;
 
 			GLint binary_size;
 			glGetProgramiv(iter->second.shader.glprogid, GL_PROGRAM_BINARY_LENGTH, &binary_size);
@@ -446,6 +789,7 @@ void ProgramShaderCache::CreateHeader ( void )
 		"%s\n" // ubo
 		"%s\n" // early-z
 		"%s\n" // 420pack
+		"%s\n" // bounding box
 
 		// Precision defines for GLSLES3
 		"%s\n"
@@ -475,6 +819,7 @@ void ProgramShaderCache::CreateHeader ( void )
 		, v<GLSL_140 ? "#extension GL_ARB_uniform_buffer_object : enable" : ""
 		, g_ActiveConfig.backend_info.bSupportsEarlyZ ? "#extension GL_ARB_shader_image_load_store : enable" : ""
 		, g_ActiveConfig.backend_info.bSupportShadingLanguage420pack ? "#extension GL_ARB_shading_language_420pack : enable" : ""
+		, g_ActiveConfig.backend_info.bSupportsBBox ? "#extension GL_ARB_shader_storage_buffer_object : enable" : ""
 
 		, v==GLSLES3 ? "precision highp float;" : ""
 
@@ -485,6 +830,23 @@ void ProgramShaderCache::CreateHeader ( void )
 }
 
 
+bool ProgramShaderCache::LoadProgramBinary(SHADER &shader, GLenum format, const u8* binary, GLint size)
+{
+	shader.glprogid = glCreateProgram();
+	glProgramBinary(shader.glprogid, format, binary, size);
+
+	GLint success;
+	glGetProgramiv(shader.glprogid, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		glDeleteProgram(shader.glprogid);
+		shader.glprogid = 0;
+		return false;
+	}
+	return true;
+}
+
 void ProgramShaderCache::ProgramShaderCacheInserter::Read ( const SHADERUID& key, const u8* value, u32 value_size )
 {
 	const u8 *binary = value+sizeof(GLenum);
@@ -493,19 +855,21 @@ void ProgramShaderCache::ProgramShaderCacheInserter::Read ( const SHADERUID& key
 
 	PCacheEntry entry;
 	entry.in_cache = 1;
-	entry.shader.glprogid = glCreateProgram();
-	glProgramBinary(entry.shader.glprogid, *prog_format, binary, binary_size);
 
-	GLint success;
-	glGetProgramiv(entry.shader.glprogid, GL_LINK_STATUS, &success);
+	if (s_async_compile)
+	{
+		entry.pending = true;
+		pshaders[key] = entry;
+		QueueBinaryJob(key, *prog_format, binary, binary_size);
+		++s_num_preloading;
+		return;
+	}
 
-	if (success)
+	if (LoadProgramBinary(entry.shader, *prog_format, binary, binary_size))
 	{
 		pshaders[key] = entry;
 		entry.shader.SetProgramVariables();
 	}
-	else
-		glDeleteProgram(entry.shader.glprogid);
 }
 
 
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
 #include "GLUtil.h"
 
 #include "PixelShaderGen.h"
@@ -11,6 +16,7 @@
 
 #include "LinearDiskCache.h"
 #include "ConfigManager.h"
+#include "Thread.h"
 
 namespace OGL
 {
@@ -37,15 +43,27 @@ public:
 	{
 		return puid == r.puid && vuid == r.vuid;
 	}
+
+	struct Hasher
+	{
+		size_t operator()(const SHADERUID& uid) const
+		{
+			return (size_t)(uid.puid.GetHash() ^ (uid.vuid.GetHash() * 0x9E3779B97F4A7C15ULL));
+		}
+	};
 };
 
 
 const int NUM_UNIFORMS = 19;
 extern const char *UniformNames[NUM_UNIFORMS];
 
+// The first of the three texture units vertex shaders expanding lines and
+// points read the vertex data, the vertex words as integers and the indices from
+const int EXPAND_TEXTURE_UNIT = 10;
+
 struct SHADER
 {
-	SHADER() : glprogid(0) { }
+	SHADER() : glprogid(0), expand_layout_loc(-1), expand_params_loc(-1) { }
 	void Destroy()
 	{
 		glDeleteProgram(glprogid);
@@ -56,6 +74,7 @@ struct SHADER
 	std::string strvprog, strpprog;
 	GLint UniformLocations[NUM_UNIFORMS];
 	u32 UniformSize[NUM_UNIFORMS];
+	GLint expand_layout_loc, expand_params_loc;
 
 	void SetProgramVariables();
 	void SetProgramBindings();
@@ -70,6 +89,9 @@ public:
 	{
 		SHADER shader;
 		bool in_cache;
+		bool pending; // still being compiled on the shader compiler thread
+
+		PCacheEntry() : in_cache(false), pending(false) {}
 
 		void Destroy()
 		{
@@ -77,22 +99,72 @@ public:
 		}
 	};
 
-	typedef std::map<SHADERUID, PCacheEntry> PCache;
+	typedef std::unordered_map<SHADERUID, PCacheEntry, SHADERUID::Hasher> PCache;
 
 	static PCacheEntry GetShaderProgram(void);
 	static GLuint GetCurrentProgram(void);
-	static SHADER* SetShader(DSTALPHA_MODE dstAlphaMode, u32 components);
-	static void GetShaderId(SHADERUID *uid, DSTALPHA_MODE dstAlphaMode, u32 components);
+	static SHADER* SetShader(DSTALPHA_MODE dstAlphaMode, u32 components, VS_EXPAND expand = VSEXPAND_NONE);
+	static void GetShaderId(SHADERUID *uid, DSTALPHA_MODE dstAlphaMode, u32 components, VS_EXPAND expand = VSEXPAND_NONE);
 
 	static bool CompileShader(SHADER &shader, const char* vcode, const char* pcode);
+	// Compiles a program which isn't part of the cache, on the compiler thread
+	// if there is one. The callback gets it on the video thread once it is linked.
+	typedef std::function<void(SHADER& shader, bool success)> CompileCallback;
+	static void CompileShaderAsync(const char* vcode, const char* pcode, const CompileCallback& callback);
+	// Hands the programs finished by the compiler thread to their users
+	static void PollCompiledShaders();
+	static bool CompileProgram(SHADER &shader, const char* vcode, const char* pcode);
 	static GLuint CompileSingleShader(GLuint type, const char *code);
 	static void UploadConstants();
+	// Uploads the constants of a multi-draw batch, indexed by the draw index
+	static void UploadMultiDrawConstants(const PixelShaderConstants* pixel_constants,
+		const VertexShaderConstants* vertex_constants, u32 count);
 
 	static void Init(void);
 	static void Shutdown(void);
 	static void CreateHeader(void);
 
 private:
+	// Background compilation. Programs are compiled and linked with a shared
+	// context on their own thread, then handed back to the video thread which
+	// sets up the uniforms and starts using them. Draws which would need a
+	// pending program are skipped in the meantime.
+	// Programs read from the disk cache are queued as well, with the binary
+	// instead of the source code.
+	struct CompileJob
+	{
+		SHADERUID uid;
+		std::string vcode, pcode;
+		std::vector<u8> binary;
+		GLenum binary_format;
+		SHADER shader;
+		bool success;
+		// Only for programs from CompileShaderAsync
+		CompileCallback callback;
+	};
+
+	static void StartCompileThread();
+	static void StopCompileThread();
+	static void CompileThreadFunc();
+	static void QueueCompileJob(const SHADERUID& uid, const char* vcode, const char* pcode);
+	static void QueueBinaryJob(const SHADERUID& uid, GLenum format, const u8* binary, u32 size);
+	static void RetrieveCompiledShaders();
+	static bool LoadProgramBinary(SHADER &shader, GLenum format, const u8* binary, GLint size);
+
+	static bool s_async_compile;
+	static volatile bool s_compile_thread_running;
+	static std::thread s_compile_thread;
+	static std::mutex s_compile_lock;
+	static Common::Event s_compile_event;
+	// Set by the compile thread once it knows whether the shared context is usable
+	static Common::Event s_compile_thread_started;
+	static bool s_compile_context_current;
+	static std::deque<CompileJob*> s_compile_queue;
+	static std::deque<CompileJob*> s_compiled_queue;
+	static volatile u32 s_num_compiled;
+	static u32 s_num_preloading;
+	static u32 s_preload_start_time;
+
 	class ProgramShaderCacheInserter : public LinearDiskCacheReader<SHADERUID, u8>
 	{
 	public:
@@ -6,6 +6,7 @@
 #include "Thread.h"
 #include "Atomic.h"
 
+#include <deque>
 #include <vector>
 #include <cmath>
 #include <cstdio>
@@ -47,7 +48,10 @@
 #include "Core.h"
 #include "Movie.h"
 #include "BPFunctions.h"
+#include "BoundingBox.h"
 #include "FPSCounter.h"
+#include "DynamicResolution.h"
+#include "GPUTimer.h"
 #include "ConfigManager.h"
 #include "VertexManager.h"
 #include "SamplerCache.h"
@@ -95,6 +99,8 @@ static GLuint s_ShowEFBCopyRegions_VAO = 0;
 static SHADER s_ShowEFBCopyRegions;
 
 static RasterFont* s_pfont = NULL;
+// Only with SCALE_DYNAMIC
+static GPUTimer* s_gpu_timer = NULL;
 
 // 1 for no MSAA. Use s_MSAASamples > 1 to check for MSAA.
 static int s_MSAASamples = 1;
@@ -105,6 +111,9 @@ static u32 s_blendMode;
 
 static bool s_vsync;
 
+// One fence per presented frame that the GPU may not have finished yet
+static std::deque<GLsync> s_frame_fences;
+
 #if defined(HAVE_WX) && HAVE_WX
 static std::thread scrshotThread;
 #endif
@@ -115,6 +124,7 @@ static const u32 EFB_CACHE_WIDTH = (EFB_WIDTH + EFB_CACHE_RECT_SIZE - 1) / EFB_C
 static const u32 EFB_CACHE_HEIGHT = (EFB_HEIGHT + EFB_CACHE_RECT_SIZE - 1) / EFB_CACHE_RECT_SIZE;
 static bool s_efbCacheValid[2][EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT];
 static std::vector<u32> s_efbCache[2][EFB_CACHE_WIDTH * EFB_CACHE_HEIGHT]; // 2 for PEEK_Z and PEEK_COLOR
+static std::vector<u32> s_efbReadBuffer; // glReadPixels target, reused between cache misses
 
 int GetNumMSAASamples(int MSAAMode)
 {
@@ -458,16 +468,22 @@ Renderer::Renderer()
 				((GLExtensions::Version() >= 310) || GLExtensions::Supports("GL_NV_primitive_restart"));
 	g_Config.backend_info.bSupportsEarlyZ = GLExtensions::Supports("GL_ARB_shader_image_load_store");
 	g_Config.backend_info.bSupportShadingLanguage420pack = GLExtensions::Supports("GL_ARB_shading_language_420pack");
+	g_Config.backend_info.bSupportsBBox = GLExtensions::Supports("GL_ARB_shader_storage_buffer_object") &&
+				GLExtensions::Supports("GL_ARB_shader_image_load_store");
 
 	g_ogl_config.bSupportsGLSLCache = GLExtensions::Supports("GL_ARB_get_program_binary");
 	g_ogl_config.bSupportsGLPinnedMemory = GLExtensions::Supports("GL_AMD_pinned_memory");
 	g_ogl_config.bSupportsGLSync = GLExtensions::Supports("GL_ARB_sync");
-	g_ogl_config.bSupportsGLBaseVertex = GLExtensions::Supports("GL_ARB_draw_elements_base_vertex");
-	g_ogl_config.bSupportsGLBufferStorage = GLExtensions::Supports("GL_ARB_buffer_storage");
+	g_ogl_config.bSupportsGLBaseVertex = GLExtensions::Supports("GL_ARB_draw_elements_base_vertex") ||
+				GLExtensions::Supports("GL_EXT_draw_elements_base_vertex") ||
+				GLExtensions::Supports("GL_OES_draw_elements_base_vertex");
+	g_ogl_config.bSupportsGLBufferStorage = GLExtensions::Supports("GL_ARB_buffer_storage") ||
+				GLExtensions::Supports("GL_EXT_buffer_storage");
 	g_ogl_config.bSupportCoverageMSAA = GLExtensions::Supports("GL_NV_framebuffer_multisample_coverage");
 	g_ogl_config.bSupportSampleShading = GLExtensions::Supports("GL_ARB_sample_shading");
 	g_ogl_config.bSupportOGL31 = GLExtensions::Version() >= 310;
 	g_ogl_config.bSupportViewportFloat = GLExtensions::Supports("GL_ARB_viewport_array");
+	g_ogl_config.bSupportsTimerQuery = GLExtensions::Supports("GL_ARB_timer_query");
 
 	if (GLInterface->GetMode() == GLInterfaceMode::MODE_OPENGLES3)
 		g_ogl_config.eSupportedGLSLVersion = GLSLES3;
@@ -484,17 +500,36 @@ Renderer::Renderer()
 		{
 			g_ogl_config.eSupportedGLSLVersion = GLSL_130;
 			g_Config.backend_info.bSupportsEarlyZ = false; // layout keyword is only supported on glsl150+
+			g_Config.backend_info.bSupportsBBox = false;
 		}
 		else if(strstr(g_ogl_config.glsl_version, "1.40"))
 		{
 			g_ogl_config.eSupportedGLSLVersion = GLSL_140;
 			g_Config.backend_info.bSupportsEarlyZ = false; // layout keyword is only supported on glsl150+
+			g_Config.backend_info.bSupportsBBox = false;
 		}
 		else
 		{
 			g_ogl_config.eSupportedGLSLVersion = GLSL_150;
 		}
 	}
+
+	// Lines and points are expanded to quads by the vertex shader, which reads
+	// the vertices through buffer textures and is drawn instanced
+	g_ogl_config.bSupportsVertexExpansion = g_ogl_config.bSupportOGL31 &&
+		(g_ogl_config.eSupportedGLSLVersion == GLSL_140 || g_ogl_config.eSupportedGLSLVersion == GLSL_150);
+
+	// Draws which only differ in their constants are batched into one indirect
+	// multi-draw. The constant blocks become arrays indexed by a per draw vertex
+	// attribute, and the held back vertices need the synced stream buffers.
+	GLint max_block_size = 0;
+	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_block_size);
+	g_Config.backend_info.bSupportsMultiDraw = GLInterface->GetMode() == GLInterfaceMode::MODE_OPENGL &&
+		GLExtensions::Version() >= 330 &&
+		GLExtensions::Supports("GL_ARB_multi_draw_indirect") &&
+		GLExtensions::Supports("GL_ARB_base_instance") &&
+		g_ogl_config.bSupportsGLBaseVertex && g_ogl_config.bSupportsGLSync &&
+		(u32)max_block_size >= MULTIDRAW_BATCH_SIZE * sizeof(VertexShaderConstants);
 #if defined(_DEBUG) || defined(DEBUGFAST)
 	if (GLExtensions::Supports("GL_KHR_debug"))
 	{
@@ -540,17 +575,20 @@ Renderer::Renderer()
 				g_ogl_config.gl_renderer,
 				g_ogl_config.gl_version), 5000);
 
-	WARN_LOG(VIDEO,"Missing OGL Extensions: %s%s%s%s%s%s%s%s%s%s",
+	WARN_LOG(VIDEO,"Missing OGL Extensions: %s%s%s%s%s%s%s%s%s%s%s%s%s",
 			g_ActiveConfig.backend_info.bSupportsDualSourceBlend ? "" : "DualSourceBlend ",
 			g_ActiveConfig.backend_info.bSupportsPrimitiveRestart ? "" : "PrimitiveRestart ",
 			g_ActiveConfig.backend_info.bSupportsEarlyZ ? "" : "EarlyZ ",
+			g_ActiveConfig.backend_info.bSupportsBBox ? "" : "BBox ",
 			g_ogl_config.bSupportsGLPinnedMemory ? "" : "PinnedMemory ",
 			g_ogl_config.bSupportsGLSLCache ? "" : "ShaderCache ",
 			g_ogl_config.bSupportsGLBaseVertex ? "" : "BaseVertex ",
 			g_ogl_config.bSupportsGLBufferStorage ? "" : "BufferStorage ",
 			g_ogl_config.bSupportsGLSync ? "" : "Sync ",
 			g_ogl_config.bSupportCoverageMSAA ? "" : "CSAA ",
-			g_ogl_config.bSupportSampleShading ? "" : "SSAA "
+			g_ogl_config.bSupportSampleShading ? "" : "SSAA ",
+			g_ogl_config.bSupportsVertexExpansion ? "" : "VertexExpansion ",
+			g_ActiveConfig.backend_info.bSupportsMultiDraw ? "" : "MultiDraw "
 			);
 
 	s_LastMultisampleMode = g_ActiveConfig.iMultisampleMode;
@@ -629,6 +667,8 @@ Renderer::~Renderer()
 void Renderer::Shutdown()
 {
 	delete g_framebuffer_manager;
+	delete g_render_target_pool;
+	g_render_target_pool = NULL;
 
 	g_Config.bRunning = false;
 	UpdateActiveConfig();
@@ -636,19 +676,37 @@ void Renderer::Shutdown()
 	glDeleteBuffers(1, &s_ShowEFBCopyRegions_VBO);
 	glDeleteVertexArrays(1, &s_ShowEFBCopyRegions_VAO);
 	s_ShowEFBCopyRegions_VBO = 0;
+	for (GLsync fence : s_frame_fences)
+		glDeleteSync(fence);
+	s_frame_fences.clear();
+#if defined(HAVE_LIBAV) || defined(_WIN32)
+	DestroyFrameDumpBuffers();
+#endif
 
 	delete s_pfont;
 	s_pfont = 0;
+	delete s_gpu_timer;
+	s_gpu_timer = NULL;
+	delete g_draw_timer;
+	g_draw_timer = NULL;
+	BoundingBox::Shutdown();
 	s_ShowEFBCopyRegions.Destroy();
 }
 
 void Renderer::Init()
 {
 	// Initialize the FramebufferManager
+	g_render_target_pool = new RenderTargetPool();
 	g_framebuffer_manager = new FramebufferManager(s_target_width, s_target_height,
 			s_MSAASamples, s_MSAACoverageSamples);
 
 	s_pfont = new RasterFont();
+	if (g_ogl_config.bSupportsTimerQuery)
+	{
+		s_gpu_timer = new GPUTimer();
+		g_draw_timer = new DrawTimer();
+	}
+	BoundingBox::Init();
 
 	ProgramShaderCache::CompileShader(s_ShowEFBCopyRegions,
 		"ATTRIN vec2 rawpos;\n"
@@ -935,6 +993,8 @@ void Renderer::UpdateEFBCache(EFBAccessType type, u32 cacheRectIdx, const EFBRec
 //	- GX_PokeZMode (TODO)
 u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 {
+	g_vertex_manager->EndBatch();
+
 	u32 cacheRectIdx = (y / EFB_CACHE_RECT_SIZE) * EFB_CACHE_WIDTH
 	                 + (x / EFB_CACHE_RECT_SIZE);
 
@@ -969,15 +1029,14 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 					g_renderer->RestoreAPIState();
 				}
 
-				u32* depthMap = new u32[targetPixelRcWidth * targetPixelRcHeight];
+				s_efbReadBuffer.resize(targetPixelRcWidth * targetPixelRcHeight);
+				u32* depthMap = s_efbReadBuffer.data();
 
 				glReadPixels(targetPixelRc.left, targetPixelRc.bottom, targetPixelRcWidth, targetPixelRcHeight,
 				             GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, depthMap);
 				GL_REPORT_ERRORD();
 
 				UpdateEFBCache(type, cacheRectIdx, efbPixelRc, targetPixelRc, depthMap);
-
-				delete[] depthMap;
 			}
 
 			u32 xRect = x % EFB_CACHE_RECT_SIZE;
@@ -1022,7 +1081,8 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 					g_renderer->RestoreAPIState();
 				}
 
-				u32* colorMap = new u32[targetPixelRcWidth * targetPixelRcHeight];
+				s_efbReadBuffer.resize(targetPixelRcWidth * targetPixelRcHeight);
+				u32* colorMap = s_efbReadBuffer.data();
 
 				if (GLInterface->GetMode() == GLInterfaceMode::MODE_OPENGLES3)
 				// XXX: Swap colours
@@ -1034,8 +1094,6 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 				GL_REPORT_ERRORD();
 
 				UpdateEFBCache(type, cacheRectIdx, efbPixelRc, targetPixelRc, colorMap);
-
-				delete[] colorMap;
 			}
 
 			u32 xRect = x % EFB_CACHE_RECT_SIZE;
@@ -1077,6 +1135,38 @@ u32 Renderer::AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data)
 	return 0;
 }
 
+u16 Renderer::BBoxRead(int index)
+{
+	// The framebuffer is y-flipped, so its bottom holds the EFB top
+	int value = BoundingBox::Get(index < 2 ? index : index ^ 1);
+
+	// The shaders store the min/max of the truncated positions in the upscaled framebuffer,
+	// scale them back to EFB pixels. The right/bottom values describe the outer border.
+	if (index < 2)
+		value = value * EFB_WIDTH / s_target_width;
+	else
+		value = EFB_HEIGHT - 1 - value * EFB_HEIGHT / s_target_height;
+	if (index & 1)
+		value++;
+
+	MathUtil::Clamp(&value, 0, 0x3ff);
+	return (u16)value;
+}
+
+void Renderer::BBoxWrite(int index, u16 value)
+{
+	int scaled = value; // u16 isn't enough to multiply by the target size
+	if (index & 1)
+		scaled--;
+
+	if (index < 2)
+		scaled = scaled * s_target_width / EFB_WIDTH;
+	else
+		scaled = (EFB_HEIGHT - 1 - scaled) * s_target_height / EFB_HEIGHT;
+
+	BoundingBox::Set(index < 2 ? index : index ^ 1, scaled);
+}
+
 void Renderer::SetViewport()
 {
 	// reversed gxsetviewport(xorig, yorig, width, height, nearz, farz)
@@ -1160,6 +1250,7 @@ void Renderer::ReinterpretPixelData(unsigned int convtype)
 	if (convtype == 0 || convtype == 2)
 	{
 		FramebufferManager::ReinterpretPixelData(convtype);
+		ClearEFBCache();
 	}
 	else
 	{
@@ -1274,11 +1365,92 @@ void DumpFrame(const std::vector<u8>& data, int w, int h)
 #endif
 }
 
+#if defined(HAVE_LIBAV) || defined(_WIN32)
+// Dumped frames are read back through a ring of PBOs. A frame is only mapped
+// FRAME_DUMP_BUFFERS - 1 frames after its glReadPixels, by when the GPU has
+// long finished with it, so dumping doesn't stall the pipeline every frame.
+static const int FRAME_DUMP_BUFFERS = 3;
+static GLuint s_frame_dump_pbos[FRAME_DUMP_BUFFERS];
+// 0 while the PBO holds no frame
+static int s_frame_dump_width[FRAME_DUMP_BUFFERS];
+static int s_frame_dump_height[FRAME_DUMP_BUFFERS];
+static int s_frame_dump_index;
+
+static void QueueFrameDumpReadback(const TargetRectangle& rc)
+{
+	const int w = rc.GetWidth();
+	const int h = rc.GetHeight();
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (!s_frame_dump_pbos[0])
+		glGenBuffers(FRAME_DUMP_BUFFERS, s_frame_dump_pbos);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s_frame_dump_pbos[s_frame_dump_index]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, 3 * w * h, NULL, GL_STREAM_READ);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(rc.left, rc.bottom, w, h, GL_BGR, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	s_frame_dump_width[s_frame_dump_index] = w;
+	s_frame_dump_height[s_frame_dump_index] = h;
+	s_frame_dump_index = (s_frame_dump_index + 1) % FRAME_DUMP_BUFFERS;
+}
+
+// Copies the frame in a PBO of the ring out, if it holds one
+static bool ReadFrameDumpBuffer(int index, std::vector<u8>& data, int& w, int& h)
+{
+	if (!s_frame_dump_width[index])
+		return false;
+
+	w = s_frame_dump_width[index];
+	h = s_frame_dump_height[index];
+	s_frame_dump_width[index] = 0;
+	data.resize(3 * w * h);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s_frame_dump_pbos[index]);
+	const u8* pbo = (const u8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 3 * w * h, GL_MAP_READ_BIT);
+	if (pbo)
+	{
+#ifdef _WIN32
+		memcpy(&data[0], pbo, data.size());
+#else
+		// Flipped on the way, only AVIs on Windows are stored bottom-up
+		for (int y = 0; y < h; ++y)
+			memcpy(&data[3 * w * y], pbo + 3 * w * (h - 1 - y), 3 * w);
+#endif
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return pbo != NULL;
+}
+
+static void DestroyFrameDumpBuffers()
+{
+	if (!s_frame_dump_pbos[0])
+		return;
+
+	glDeleteBuffers(FRAME_DUMP_BUFFERS, s_frame_dump_pbos);
+	for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+	{
+		s_frame_dump_pbos[i] = 0;
+		s_frame_dump_width[i] = 0;
+	}
+	s_frame_dump_index = 0;
+}
+#endif
+
 // This function has the final picture. We adjust the aspect ratio here.
 void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangle& rc,float Gamma)
 {
 	static int w = 0, h = 0;
-	if (g_bSkipCurrentFrame || (!XFBWrited && !g_ActiveConfig.RealXFBEnabled()) || !fbWidth || !fbHeight)
+
+	// Don't let EFB copies to RAM wait for longer than a frame
+	TextureConverter::FlushReadbacks();
+	const bool timing = s_gpu_timer && g_ActiveConfig.iEFBScale == SCALE_DYNAMIC;
+	if (timing)
+		s_gpu_timer->EndFrame();
+	if (g_bSkipCurrentFrame || g_bSkipCurrentPresent || (!XFBWrited && !g_ActiveConfig.RealXFBEnabled()) || !fbWidth || !fbHeight)
 	{
 		DumpFrame(frame_data, w, h);
 		Core::Callback_VideoCopiedToXFB(false);
@@ -1411,16 +1583,13 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 		if (g_ActiveConfig.bDumpFrames)
 		{
 			std::lock_guard<std::mutex> lk(s_criticalScreenshot);
-			if (frame_data.empty() || w != flipped_trc.GetWidth() ||
-				     h != flipped_trc.GetHeight())
+			QueueFrameDumpReadback(flipped_trc);
+			if (GL_REPORT_ERROR() != GL_NO_ERROR)
 			{
-				w = flipped_trc.GetWidth();
-				h = flipped_trc.GetHeight();
-				frame_data.resize(3 * w * h);
+				NOTICE_LOG(VIDEO, "Error reading framebuffer");
 			}
-			glPixelStorei(GL_PACK_ALIGNMENT, 1);
-			glReadPixels(flipped_trc.left, flipped_trc.bottom, w, h, GL_BGR, GL_UNSIGNED_BYTE, &frame_data[0]);
-			if (GL_REPORT_ERROR() == GL_NO_ERROR && w > 0 && h > 0)
+			// The PBO that is used next holds the oldest frame
+			else if (ReadFrameDumpBuffer(s_frame_dump_index, frame_data, w, h))
 			{
 				if (!bLastFrameDumped)
 				{
@@ -1439,29 +1608,28 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 					}
 				}
 				if (bAVIDumping)
-				{
-					#ifndef _WIN32
-						FlipImageData(&frame_data[0], w, h);
-					#endif
-
-						AVIDump::AddFrame(&frame_data[0], w, h);
-				}
+					AVIDump::AddFrame(&frame_data[0], w, h);
 
 				bLastFrameDumped = true;
 			}
-			else
-				NOTICE_LOG(VIDEO, "Error reading framebuffer");
 		}
 		else
 		{
 			if (bLastFrameDumped && bAVIDumping)
 			{
+				// The frames still in the ring make it into the dump as well
+				for (int i = 0; i < FRAME_DUMP_BUFFERS; ++i)
+				{
+					if (ReadFrameDumpBuffer((s_frame_dump_index + i) % FRAME_DUMP_BUFFERS, frame_data, w, h))
+						AVIDump::AddFrame(&frame_data[0], w, h);
+				}
 				std::vector<u8>().swap(frame_data);
 				w = h = 0;
 				AVIDump::Stop();
 				bAVIDumping = false;
 				OSD::AddMessage("Stop dumping frames", 2000);
 			}
+			DestroyFrameDumpBuffers();
 			bLastFrameDumped = false;
 		}
 #else
@@ -1524,7 +1692,8 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 	bool WindowResized = false;
 	int W = (int)GLInterface->GetBackBufferWidth();
 	int H = (int)GLInterface->GetBackBufferHeight();
-	if (W != s_backbuffer_width || H != s_backbuffer_height || s_LastEFBScale != g_ActiveConfig.iEFBScale)
+	if (W != s_backbuffer_width || H != s_backbuffer_height || s_LastEFBScale != g_ActiveConfig.iEFBScale ||
+		(s_LastEFBScale == SCALE_DYNAMIC && DynamicResolution::HasScaleChanged()))
 	{
 		WindowResized = true;
 		s_backbuffer_width = W;
@@ -1574,6 +1743,19 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 
 	GL_REPORT_ERRORD();
 
+	// Every frame the driver queues up is another frame between input and display,
+	// so don't run further ahead of the GPU than configured.
+	if (g_ActiveConfig.iMaxPrerenderedFrames > 0 && g_ogl_config.bSupportsGLSync)
+	{
+		s_frame_fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		while ((int)s_frame_fences.size() > g_ActiveConfig.iMaxPrerenderedFrames)
+		{
+			glClientWaitSync(s_frame_fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(s_frame_fences.front());
+			s_frame_fences.pop_front();
+		}
+	}
+
 	// Clear framebuffer
 	if (!DriverDetails::HasBug(DriverDetails::BUG_BROKENSWAP))
 	{
@@ -1611,11 +1793,16 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 
 	// Invalidate EFB cache
 	ClearEFBCache();
+
+	if (timing)
+		s_gpu_timer->BeginFrame();
 }
 
 // ALWAYS call RestoreAPIState for each ResetAPIState call you're doing
 void Renderer::ResetAPIState()
 {
+	g_vertex_manager->EndBatch();
+
 	// Gets us to a reasonably sane state where it's possible to do things like
 	// image copies with textured quads, etc.
 	glDisable(GL_SCISSOR_TEST);
@@ -1798,7 +1985,7 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 
 	// Turn image upside down
 	FlipImageData(data, W, H, 4);
-	bool success = TextureToPng(data, W*4, filename, W, H, false);
+	bool success = TextureToPngAsync(data, W*4, filename, W, H, false);
 	delete[] data;
 
 	return success;
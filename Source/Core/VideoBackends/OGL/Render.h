@@ -26,6 +26,8 @@ extern struct VideoConfig {
 	GLSL_VERSION eSupportedGLSLVersion;
 	bool bSupportOGL31;
 	bool bSupportViewportFloat;
+	bool bSupportsVertexExpansion;
+	bool bSupportsTimerQuery;
 
 	const char *gl_vendor;
 	const char *gl_renderer;
@@ -66,6 +68,9 @@ public:
 
 	u32 AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data) override;
 
+	u16 BBoxRead(int index) override;
+	void BBoxWrite(int index, u16 value) override;
+
 	void ResetAPIState() override;
 	void RestoreAPIState() override;
 
@@ -51,7 +51,7 @@ void SamplerCache::SetSamplerState(int stage, const TexMode0& tm0, const TexMode
 
 auto SamplerCache::GetEntry(const Params& params) -> Value&
 {
-	auto& val = m_cache[params];
+	auto& val = m_cache[params.hex];
 	if (!val.sampler_id)
 	{
 		// Sampler not found in cache, create it.
@@ -110,11 +110,14 @@ void SamplerCache::SetParameters(GLuint sampler_id, const Params& params)
 
 void SamplerCache::Clear()
 {
-	for (auto& p : m_cache)
-	{
-		glDeleteSamplers(1, &p.second.sampler_id);
-	}
-	m_cache.clear();
+	m_cache.ForEach([](u64, Value& val) {
+		glDeleteSamplers(1, &val.sampler_id);
+	});
+	m_cache.Clear();
+
+	// The deleted samplers were unbound, so bind again on the next use
+	for (auto& active_sampler : m_active_samplers)
+		active_sampler.second = Value();
 }
 
 }
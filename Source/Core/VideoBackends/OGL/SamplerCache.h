@@ -1,7 +1,6 @@
 #pragma once
 
-#include <map>
-
+#include "FlatHashMap.h"
 #include "Render.h"
 #include "GLUtil.h"
 
@@ -42,11 +41,6 @@ private:
 			static_assert(sizeof(Params) == 8, "Assuming I can treat this as a 64bit int.");
 		}
 
-		bool operator<(const Params& other) const
-		{
-			return hex < other.hex;
-		}
-
 		bool operator!=(const Params& other) const
 		{
 			return hex != other.hex;
@@ -65,7 +59,7 @@ private:
 	void SetParameters(GLuint sampler_id, const Params& params);
 	Value& GetEntry(const Params& params);
 
-	std::map<Params, Value> m_cache;
+	FlatHashMap<u64, Value> m_cache;
 	std::pair<Params, Value> m_active_samplers[8];
 
 	int m_last_max_anisotropy;
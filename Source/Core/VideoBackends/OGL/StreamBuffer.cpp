@@ -27,6 +27,7 @@ StreamBuffer::StreamBuffer(u32 type, size_t size)
 	m_iterator = 0;
 	m_used_iterator = 0;
 	m_free_iterator = 0;
+	m_wrap_count = 0;
 	fences = nullptr;
 }
 
@@ -107,6 +108,7 @@ void StreamBuffer::AllocMemory(size_t size)
 
 		// move to the start
 		m_used_iterator = m_iterator = 0; // offset 0 is always aligned
+		m_wrap_count++;
 
 		// wait for space at the start
 		for (u32 i = 0; i <= SLOT(m_iterator + size); i++)
@@ -117,6 +119,13 @@ void StreamBuffer::AllocMemory(size_t size)
 		m_free_iterator = m_iterator + size;
 	}
 }
+
+bool StreamBuffer::MayFence(size_t offset, size_t size, u32 stride) const
+{
+	// Align may move the iterator up to one stride
+	size_t iterator = m_iterator + stride;
+	return SLOT(iterator) != SLOT(offset) || iterator + size >= m_size;
+}
 #undef SLOT
 
 void StreamBuffer::Align(u32 stride)
@@ -150,6 +159,7 @@ public:
 		if(m_iterator + size >= m_size) {
 			glBufferData(m_buffertype, m_size, NULL, GL_STREAM_DRAW);
 			m_iterator = 0;
+			m_wrap_count++;
 		}
 		u8* pointer = (u8*)glMapBufferRange(m_buffertype, m_iterator, size,
 			GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
@@ -199,7 +209,8 @@ public:
 };
 
 /* Streaming fifo without mapping ovearhead.
- * This one usually requires ARB_buffer_storage (OpenGL 4.4).
+ * This one usually requires ARB_buffer_storage (OpenGL 4.4),
+ * or EXT_buffer_storage on GLES3.1 drivers.
  * And is usually not available on OpenGL3 gpus.
  * 
  * ARB_buffer_storage allows us to render from a mapped buffer.
@@ -305,6 +316,7 @@ public:
 	}
 
 	std::pair<u8*, size_t> Map(size_t size, u32 stride) {
+		m_wrap_count++;
 		return std::make_pair(m_pointer, 0);
 	}
 
@@ -333,6 +345,7 @@ public:
 	}
 
 	std::pair<u8*, size_t> Map(size_t size, u32 stride) {
+		m_wrap_count++;
 		return std::make_pair(m_pointer, 0);
 	}
 
@@ -343,6 +356,15 @@ public:
 	u8* m_pointer;
 };
 
+// One line per buffer type in the log, so it's easy to tell whether the vertex loader
+// writes straight into gpu visible memory or if the data is copied by the driver.
+static StreamBuffer* LogChoice(StreamBuffer* buffer, u32 type, const char* name)
+{
+	INFO_LOG(VIDEO, "Streaming %s data with %s", type == GL_ARRAY_BUFFER ? "vertex" :
+		type == GL_ELEMENT_ARRAY_BUFFER ? "index" : "uniform", name);
+	return buffer;
+}
+
 // choose best streaming library based on the supported extensions and known issues
 StreamBuffer* StreamBuffer::Create(u32 type, size_t size)
 {
@@ -350,36 +372,44 @@ StreamBuffer* StreamBuffer::Create(u32 type, size_t size)
 	if(!g_ogl_config.bSupportsGLBaseVertex)
 	{
 		if(!DriverDetails::HasBug(DriverDetails::BUG_BROKENBUFFERSTREAM))
-			return new BufferSubData(type, size);
+			return LogChoice(new BufferSubData(type, size), type, "BufferSubData");
 
 		// BufferData is by far the worst way, only use it if needed
-		return new BufferData(type, size);
+		return LogChoice(new BufferData(type, size), type, "BufferData");
 	}
 
 	// Prefer the syncing buffers over the orphaning one
 	if(g_ogl_config.bSupportsGLSync)
 	{
 		// try to use buffer storage whenever possible
+		// the buffer stays persistently mapped, so the vertex loader writes straight into it
 		if (g_ogl_config.bSupportsGLBufferStorage &&
 			!(DriverDetails::HasBug(DriverDetails::BUG_BROKENBUFFERSTORAGE) && type == GL_ARRAY_BUFFER))
-			return new BufferStorage(type, size);
+			return LogChoice(new BufferStorage(type, size), type, "BufferStorage (persistent mapping)");
 
 		// pinned memory is almost as fine
 		if(g_ogl_config.bSupportsGLPinnedMemory &&
 			!(DriverDetails::HasBug(DriverDetails::BUG_BROKENPINNEDMEMORY) && type == GL_ELEMENT_ARRAY_BUFFER))
-			return new PinnedMemory(type, size);
+			return LogChoice(new PinnedMemory(type, size), type, "PinnedMemory");
+	}
+
+	// Adreno and Mali stall on every glBufferSubData and glMapBufferRange,
+	// so only the persistent mapping above avoids glBufferData for them
+	if(DriverDetails::HasBug(DriverDetails::BUG_BROKENBUFFERSTREAM))
+		return LogChoice(new BufferData(type, size), type, "BufferData");
 
+	if(g_ogl_config.bSupportsGLSync)
+	{
 		// don't fall back to MapAnd* for nvidia drivers
 		if(DriverDetails::HasBug(DriverDetails::BUG_BROKENUNSYNCMAPPING))
-			return new BufferSubData(type, size);
+			return LogChoice(new BufferSubData(type, size), type, "BufferSubData");
 
 		// mapping fallback
-		if(g_ogl_config.bSupportsGLSync)
-			return new MapAndSync(type, size);
+		return LogChoice(new MapAndSync(type, size), type, "MapAndSync");
 	}
 
 	// default fallback, should work everywhere, but isn't the best way to do this job
-	return new MapAndOrphan(type, size);
+	return LogChoice(new MapAndOrphan(type, size), type, "MapAndOrphan");
 }
 
 }
@@ -29,6 +29,19 @@ public:
 	virtual std::pair<u8*, size_t> Map(size_t size, u32 stride = 0) = 0;
 	virtual void Unmap(size_t used_size) = 0;
 
+	/* Data written by earlier mappings stays valid until the buffer wraps around,
+	 * so ranges can stay bound across several mappings.
+	 * This counter is increased on every wraparound (which is every mapping for
+	 * the fifos always writing to the start), it must be checked after Map.
+	 */
+	u32 GetWrapCount() const { return m_wrap_count; }
+
+	/* The fences are placed on Map and only guard the draws issued before it.
+	 * Returns true if the next mapping of size bytes may place a fence over
+	 * the data written since offset, so draws using it must be issued first.
+	 */
+	bool MayFence(size_t offset, size_t size, u32 stride = 0) const;
+
 	const u32 m_buffer;
 
 protected:
@@ -44,6 +57,7 @@ protected:
 	size_t m_iterator;
 	size_t m_used_iterator;
 	size_t m_free_iterator;
+	u32 m_wrap_count;
 
 private:
 	GLsync *fences;
@@ -36,6 +36,7 @@
 #include "TextureCache.h"
 #include "TextureConverter.h"
 #include "TextureDecoder.h"
+#include "VertexManager.h"
 #include "VideoConfig.h"
 
 namespace OGL
@@ -73,7 +74,7 @@ bool SaveTexture(const std::string filename, u32 textarget, u32 tex, int virtual
 		delete[] data;
 		return false;
 	}
-	bool success = TextureToPng(data, width * 4, filename, width, height, true);
+	bool success = TextureToPngAsync(data, width * 4, filename, width, height, true);
 	delete[] data;
 	return success;
 }
@@ -202,6 +203,9 @@ TextureCache::TCacheEntryBase* TextureCache::CreateTexture(unsigned int width,
 void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
 	unsigned int expanded_width, unsigned int level)
 {
+	// The held back draws may sample the old contents
+	g_vertex_manager->EndBatch();
+
 	if (pcfmt != PC_TEX_FMT_DXT1)
 	{
 		glActiveTexture(GL_TEXTURE0+9);
@@ -225,6 +229,29 @@ void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
 	GL_REPORT_ERRORD();
 }
 
+void TextureCache::TCacheEntry::LoadFromGX(unsigned int width, unsigned int height,
+	unsigned int expanded_width, unsigned int expanded_height, unsigned int level,
+	const u8* src, u64 src_hash, int texformat, const u8* tlut, int tlutfmt)
+{
+	g_vertex_manager->EndBatch();
+
+	// Only allocate the level, the decoding shader renders into it
+	glActiveTexture(GL_TEXTURE0+9);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, level, gl_iformat, width, height, 0, gl_format, gl_type, NULL);
+
+	TextureConverter::DecodeTextureFromGX(texture, level, width, height, expanded_width, expanded_height,
+		src, src_hash, texformat, tlut, tlutfmt);
+
+	TextureCache::SetStage();
+	GL_REPORT_ERRORD();
+}
+
+bool TextureCache::CanDecodeOnGPU(int texformat, int tlutfmt) const
+{
+	return TextureConverter::IsDecodingSupported(texformat, tlutfmt);
+}
+
 TextureCache::TCacheEntryBase* TextureCache::CreateRenderTargetTexture(
 	unsigned int scaled_tex_w, unsigned int scaled_tex_h)
 {
@@ -255,6 +282,11 @@ TextureCache::TCacheEntryBase* TextureCache::CreateRenderTargetTexture(
 	return entry;
 }
 
+void TextureCache::FlushPendingEFBCopies(u32 start_address, u32 size)
+{
+	TextureConverter::FlushReadbacks(start_address, size);
+}
+
 void TextureCache::TCacheEntry::FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
 	unsigned int srcFormat, const EFBRectangle& srcRect,
 	bool isIntensity, bool scaleByHalf, unsigned int cbufid,
@@ -304,7 +336,8 @@ void TextureCache::TCacheEntry::FromRenderTarget(u32 dstAddr, unsigned int dstFo
 
 	if (false == g_ActiveConfig.bCopyEFBToTexture)
 	{
-		int encoded_size = TextureConverter::EncodeToRamFromTexture(
+		// The cache gets updated once the data is in RAM
+		TextureConverter::EncodeToRamFromTexture(
 			addr,
 			read_texture,
 			srcFormat == PIXELFMT_Z24,
@@ -312,17 +345,6 @@ void TextureCache::TCacheEntry::FromRenderTarget(u32 dstAddr, unsigned int dstFo
 			dstFormat,
 			scaleByHalf,
 			srcRect);
-
-		u8* dst = Memory::GetPointer(addr);
-		u64 const new_hash = GetHash64(dst,encoded_size,g_ActiveConfig.iSafeTextureCache_ColorSamples);
-
-		// Mark texture entries in destination address range dynamic unless caching is enabled and the texture entry is up to date
-		if (!g_ActiveConfig.bEFBCopyCacheEnable)
-			TextureCache::MakeRangeDynamic(addr,encoded_size);
-		else if (!TextureCache::Find(addr, new_hash))
-			TextureCache::MakeRangeDynamic(addr,encoded_size);
-
-		hash = new_hash;
 	}
 
 	FramebufferManager::SetFramebuffer(0);
@@ -42,6 +42,9 @@ private:
 
 		void Load(unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) override;
+		void LoadFromGX(unsigned int width, unsigned int height,
+			unsigned int expanded_width, unsigned int expanded_height, unsigned int level,
+			const u8* src, u64 src_hash, int texformat, const u8* tlut, int tlutfmt) override;
 
 		void FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
 			unsigned int srcFormat, const EFBRectangle& srcRect,
@@ -58,6 +61,10 @@ private:
 		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt) override;
 
 	TCacheEntryBase* CreateRenderTargetTexture(unsigned int scaled_tex_w, unsigned int scaled_tex_h) override;
+
+	void FlushPendingEFBCopies(u32 start_address, u32 size) override;
+
+	bool CanDecodeOnGPU(int texformat, int tlutfmt) const override;
 };
 
 bool SaveTexture(const std::string filename, u32 textarget, u32 tex, int virtual_width, int virtual_height, unsigned int level);
@@ -4,6 +4,8 @@
 
 // Fast image conversion using OpenGL shaders.
 
+#include <algorithm>
+
 #include "TextureConverter.h"
 #include "TextureConversionShader.h"
 #include "TextureCache.h"
@@ -42,7 +44,39 @@ const u32 NUM_ENCODING_PROGRAMS = 64;
 static SHADER s_encodingPrograms[NUM_ENCODING_PROGRAMS];
 static int s_encodingUniforms[NUM_ENCODING_PROGRAMS];
 
-static GLuint s_PBO = 0; // for readback with different strides
+// Indexed by texture format and TLUT format
+const u32 NUM_DECODING_FORMATS = 16;
+const u32 NUM_DECODING_TLUT_FORMATS = 3;
+static SHADER s_decodingPrograms[NUM_DECODING_FORMATS][NUM_DECODING_TLUT_FORMATS];
+
+// The raw data of the last decoded texture stays uploaded, so decoding
+// it again with another TLUT only uploads the TLUT
+static GLuint s_decodingSrcTexture = 0;
+static GLuint s_decodingTlutTexture = 0;
+static u64 s_decodingSrcHash = TEXHASH_INVALID;
+static u32 s_decodingSrcWidth = 0;
+static u32 s_decodingSrcHeight = 0;
+
+// The encoded data is read back through a ring of pixel buffers. Each one
+// is only mapped and copied to RAM once the data is needed there, which is
+// right away unless EFB copies are read back asynchronously.
+enum { NUM_READBACK_BUFFERS = 4 };
+
+struct Readback
+{
+	u32 address;
+	u32 size;        // bytes covered in RAM
+	u32 cacheSize;   // bytes to hash for the texture cache, 0 for XFB copies
+	int dstSize;
+	int readStride;
+	int writeStride;
+	int readLoops;
+};
+
+static GLuint s_readbackBuffers[NUM_READBACK_BUFFERS] = {};
+static Readback s_readbacks[NUM_READBACK_BUFFERS];
+static int s_firstReadback = 0;
+static int s_numReadbacks = 0;
 
 void CreatePrograms()
 {
@@ -163,6 +197,38 @@ SHADER &GetOrCreateEncodingShader(u32 format)
 	return s_encodingPrograms[format];
 }
 
+static SHADER &GetOrCreateDecodingShader(u32 format, u32 tlutfmt)
+{
+	// CMPR doesn't use a TLUT
+	SHADER& program = s_decodingPrograms[format][format == GX_TF_CMPR ? 0 : tlutfmt];
+	if (program.glprogid == 0)
+	{
+		const char* shader = TextureConversionShader::GenerateDecodingShader(format, tlutfmt, API_OPENGL);
+
+		const char *VProgram =
+			"void main()\n"
+			"{\n"
+			"	vec2 rawpos = vec2(gl_VertexID&1, gl_VertexID&2);\n"
+			"	gl_Position = vec4(rawpos*2.0-1.0, 0.0, 1.0);\n"
+			"}\n";
+
+		ProgramShaderCache::CompileShader(program, VProgram, shader);
+	}
+	return program;
+}
+
+static GLuint CreateIntegerTexture()
+{
+	// Integer textures are incomplete with filtering
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return texture;
+}
+
 void Init()
 {
 	glGenFramebuffers(2, s_texConvFrameBuffer);
@@ -176,13 +242,18 @@ void Init()
 	glBindTexture(GL_TEXTURE_2D, s_dstTexture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, renderBufferWidth, renderBufferHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	
+
+	s_decodingSrcTexture = CreateIntegerTexture();
+	s_decodingTlutTexture = CreateIntegerTexture();
+	s_decodingSrcHash = TEXHASH_INVALID;
 	
 	FramebufferManager::SetFramebuffer(s_texConvFrameBuffer[0]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, s_dstTexture, 0);
 	FramebufferManager::SetFramebuffer(0);
 
-	glGenBuffers(1, &s_PBO);
+	glGenBuffers(NUM_READBACK_BUFFERS, s_readbackBuffers);
+	s_firstReadback = 0;
+	s_numReadbacks = 0;
 
 	CreatePrograms();
 }
@@ -191,7 +262,10 @@ void Shutdown()
 {
 	glDeleteTextures(1, &s_srcTexture);
 	glDeleteTextures(1, &s_dstTexture);
-	glDeleteBuffers(1, &s_PBO);
+	glDeleteTextures(1, &s_decodingSrcTexture);
+	glDeleteTextures(1, &s_decodingTlutTexture);
+	// whatever is still pending is lost with the emulated RAM
+	glDeleteBuffers(NUM_READBACK_BUFFERS, s_readbackBuffers);
 	glDeleteFramebuffers(2, s_texConvFrameBuffer);
 
 	s_rgbToYuyvProgram.Destroy();
@@ -199,16 +273,78 @@ void Shutdown()
 
 	for (auto& program : s_encodingPrograms)
 		program.Destroy();
+	for (auto& programs : s_decodingPrograms)
+		for (auto& program : programs)
+			program.Destroy();
 
 	s_srcTexture = 0;
 	s_dstTexture = 0;
-	s_PBO = 0;
+	s_decodingSrcTexture = 0;
+	s_decodingTlutTexture = 0;
+	for (GLuint& buffer : s_readbackBuffers)
+		buffer = 0;
+	s_numReadbacks = 0;
 	s_texConvFrameBuffer[0] = 0;
 	s_texConvFrameBuffer[1] = 0;
 }
 
-void EncodeToRamUsingShader(GLuint srcTexture, const TargetRectangle& sourceRc,
-						u8* destAddr, int dstWidth, int dstHeight, int readStride,
+// Copies the oldest pending readback to RAM
+static void FinishReadback()
+{
+	const Readback& readback = s_readbacks[s_firstReadback];
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s_readbackBuffers[s_firstReadback]);
+	const u8* pbo = (const u8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.dstSize, GL_MAP_READ_BIT);
+	u8* destAddr = Memory::GetPointer(readback.address);
+
+	if (pbo && destAddr)
+	{
+		if (readback.writeStride != readback.readStride && readback.readLoops > 1)
+		{
+			// writing to a texture of a different size
+			// also copy more then one block line, so the different strides matters
+			for (int i = 0; i < readback.readLoops; i++)
+			{
+				memcpy(destAddr, pbo, readback.readStride);
+				pbo += readback.readStride;
+				destAddr += readback.writeStride;
+			}
+		}
+		else
+		{
+			memcpy(destAddr, pbo, readback.dstSize);
+		}
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	GL_REPORT_ERRORD();
+
+	s_firstReadback = (s_firstReadback + 1) % NUM_READBACK_BUFFERS;
+	s_numReadbacks--;
+
+	if (readback.cacheSize)
+		TextureCache::EFBCopyArrived(readback.address, readback.cacheSize);
+}
+
+void FlushReadbacks(u32 address, u32 size)
+{
+	// The readbacks arrive in order, so that later copies to the same
+	// memory win
+	int count = 0;
+	for (int i = 0; i < s_numReadbacks; i++)
+	{
+		const Readback& readback = s_readbacks[(s_firstReadback + i) % NUM_READBACK_BUFFERS];
+		if ((u64)readback.address < (u64)address + size && (u64)address < (u64)readback.address + readback.size)
+			count = i + 1;
+	}
+
+	while (count--)
+		FinishReadback();
+}
+
+static void EncodeToRamUsingShader(GLuint srcTexture, const TargetRectangle& sourceRc,
+						u32 address, u32 cacheSize, int dstWidth, int dstHeight, int readStride,
 						bool linearFilter)
 {
 
@@ -241,43 +377,34 @@ void EncodeToRamUsingShader(GLuint srcTexture, const TargetRectangle& sourceRc,
 
 	GL_REPORT_ERRORD();
 
-	// .. and then read back the results.
-	// TODO: make this less slow.
-
-	int writeStride = bpmem.copyMipMapStrideChannels * 32;
-	int dstSize = dstWidth*dstHeight*4;
-	int readHeight = readStride / dstWidth / 4; // 4 bytes per pixel
-	int readLoops = dstHeight / readHeight;
-
-	if (writeStride != readStride && readLoops > 1)
-	{
-		// writing to a texture of a different size
-		// also copy more then one block line, so the different strides matters
-		// copy into one pbo first, map this buffer, and then memcpy into gc memory
-		// in this way, we only have one vram->ram transfer, but maybe a bigger
-		// cpu overhead because of the pbo
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, s_PBO);
-		glBufferData(GL_PIXEL_PACK_BUFFER, dstSize, NULL, GL_STREAM_READ);
-		glReadPixels(0, 0, (GLsizei)dstWidth, (GLsizei)dstHeight, GL_BGRA, GL_UNSIGNED_BYTE, 0);
-		u8* pbo = (u8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, dstSize, GL_MAP_READ_BIT);
-
-		for (int i = 0; i < readLoops; i++)
-		{
-			memcpy(destAddr, pbo, readStride);
-			pbo += readStride;
-			destAddr += writeStride;
-		}
-
-		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-	}
+	// .. and then read back the results into the next pixel buffer, the
+	// oldest readback has to make room if they are all taken
+	if (s_numReadbacks == NUM_READBACK_BUFFERS)
+		FinishReadback();
+
+	const int index = (s_firstReadback + s_numReadbacks) % NUM_READBACK_BUFFERS;
+	Readback& readback = s_readbacks[index];
+	readback.address = address;
+	readback.cacheSize = cacheSize;
+	readback.dstSize = dstWidth*dstHeight*4;
+	readback.readStride = readStride;
+	readback.writeStride = bpmem.copyMipMapStrideChannels * 32;
+	readback.readLoops = dstHeight / (readStride / dstWidth / 4); // 4 bytes per pixel
+	if (readback.writeStride != readback.readStride && readback.readLoops > 1)
+		readback.size = (readback.readLoops - 1) * readback.writeStride + readback.readStride;
 	else
-	{
-		glReadPixels(0, 0, (GLsizei)dstWidth, (GLsizei)dstHeight, GL_BGRA, GL_UNSIGNED_BYTE, destAddr);
-	}
+		readback.size = readback.dstSize;
+	s_numReadbacks++;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s_readbackBuffers[index]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, readback.dstSize, NULL, GL_STREAM_READ);
+	glReadPixels(0, 0, (GLsizei)dstWidth, (GLsizei)dstHeight, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
 	GL_REPORT_ERRORD();
 
+	if (!g_ActiveConfig.bEFBCopyReadbackAsync)
+		FlushReadbacks();
 }
 
 int EncodeToRamFromTexture(u32 address,GLuint source_texture, bool bFromZBuffer, bool bIsIntensityFmt, u32 copyfmt, int bScaleByHalf, const EFBRectangle& source)
@@ -298,8 +425,6 @@ int EncodeToRamFromTexture(u32 address,GLuint source_texture, bool bFromZBuffer,
 
 	SHADER& texconv_shader = GetOrCreateEncodingShader(format);
 
-	u8 *dest_ptr = Memory::GetPointer(address);
-
 	int width = (source.right - source.left) >> bScaleByHalf;
 	int height = (source.bottom - source.top) >> bScaleByHalf;
 
@@ -331,13 +456,13 @@ int EncodeToRamFromTexture(u32 address,GLuint source_texture, bool bFromZBuffer,
 	int readStride = (expandedWidth * cacheBytes) /
 		TexDecoder_GetBlockWidthInTexels(format);
 	EncodeToRamUsingShader(source_texture, scaledSource,
-		dest_ptr, expandedWidth / samples, expandedHeight, readStride,
+		address, size_in_bytes, expandedWidth / samples, expandedHeight, readStride,
 		bScaleByHalf > 0 && !bFromZBuffer);
 	return size_in_bytes; // TODO: D3D11 is calculating this value differently!
 
 }
 
-void EncodeToRamYUYV(GLuint srcTexture, const TargetRectangle& sourceRc, u8* destAddr, int dstWidth, int dstHeight)
+void EncodeToRamYUYV(GLuint srcTexture, const TargetRectangle& sourceRc, u32 address, int dstWidth, int dstHeight)
 {
 	g_renderer->ResetAPIState();
 
@@ -348,7 +473,7 @@ void EncodeToRamYUYV(GLuint srcTexture, const TargetRectangle& sourceRc, u8* des
 	// We enable linear filtering, because the gamecube does filtering in the vertical direction when
 	// yscale is enabled.
 	// Otherwise we get jaggies when a game uses yscaling (most PAL games)
-	EncodeToRamUsingShader(srcTexture, sourceRc, destAddr, dstWidth / 2, dstHeight, dstWidth*dstHeight*2, true);
+	EncodeToRamUsingShader(srcTexture, sourceRc, address, 0, dstWidth / 2, dstHeight, dstWidth*dstHeight*2, true);
 	FramebufferManager::SetFramebuffer(0);
 	TextureCache::DisableStage(0);
 	g_renderer->RestoreAPIState();
@@ -359,6 +484,8 @@ void EncodeToRamYUYV(GLuint srcTexture, const TargetRectangle& sourceRc, u8* des
 // Should be scale free.
 void DecodeToTexture(u32 xfbAddr, int srcWidth, int srcHeight, GLuint destTexture)
 {
+	FlushReadbacks(xfbAddr, srcWidth * srcHeight * 2);
+
 	u8* srcAddr = Memory::GetPointer(xfbAddr);
 	if (!srcAddr)
 	{
@@ -392,6 +519,60 @@ void DecodeToTexture(u32 xfbAddr, int srcWidth, int srcHeight, GLuint destTextur
 	GL_REPORT_ERRORD();
 }
 
+bool IsDecodingSupported(int format, int tlutfmt)
+{
+	return TextureConversionShader::IsDecodingSupported(format, tlutfmt);
+}
+
+void DecodeTextureFromGX(GLuint destTexture, u32 level, u32 width, u32 height,
+	u32 expandedWidth, u32 expandedHeight, const u8* src, u64 srcHash,
+	int format, const u8* tlut, int tlutfmt)
+{
+	SHADER& program = GetOrCreateDecodingShader(format, tlutfmt);
+
+	g_renderer->ResetAPIState(); // reset any game specific settings
+
+	FramebufferManager::SetFramebuffer(s_texConvFrameBuffer[1]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, destTexture, level);
+
+	GL_REPORT_FBO_ERROR();
+
+	// One row of 32 byte blocks per line
+	const u32 srcWidth = expandedWidth / TexDecoder_GetBlockWidthInTexels(format) * 32;
+	const u32 srcHeight = expandedHeight / TexDecoder_GetBlockHeightInTexels(format);
+
+	glActiveTexture(GL_TEXTURE0+9);
+	glBindTexture(GL_TEXTURE_2D, s_decodingSrcTexture);
+	if (srcHash == TEXHASH_INVALID || srcHash != s_decodingSrcHash ||
+		srcWidth != s_decodingSrcWidth || srcHeight != s_decodingSrcHeight)
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, srcWidth, srcHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, src);
+		s_decodingSrcHash = srcHash;
+		s_decodingSrcWidth = srcWidth;
+		s_decodingSrcHeight = srcHeight;
+	}
+
+	if (format != GX_TF_CMPR)
+	{
+		// The big endian entries are kept as two bytes, 256 entries per line
+		const u32 entries = TexDecoder_GetPaletteSize(format) / 2;
+		glActiveTexture(GL_TEXTURE0+8);
+		glBindTexture(GL_TEXTURE_2D, s_decodingTlutTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, std::min(entries, 256u), std::max(entries / 256, 1u), 0,
+			GL_RG_INTEGER, GL_UNSIGNED_BYTE, tlut);
+	}
+
+	glViewport(0, 0, width, height);
+	program.Bind();
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	FramebufferManager::SetFramebuffer(0);
+
+	g_renderer->RestoreAPIState();
+	GL_REPORT_ERRORD();
+}
+
 }  // namespace
 
 }  // namespace OGL
@@ -19,13 +19,24 @@ void Init();
 void Shutdown();
 
 void EncodeToRamYUYV(GLuint srcTexture, const TargetRectangle& sourceRc,
-					 u8* destAddr, int dstWidth, int dstHeight);
+					 u32 address, int dstWidth, int dstHeight);
 
 void DecodeToTexture(u32 xfbAddr, int srcWidth, int srcHeight, GLuint destTexture);
 
+// Decodes raw GX texture data into a level of destTexture, which must
+// already have RGBA storage. See TextureCache::CanDecodeOnGPU.
+bool IsDecodingSupported(int format, int tlutfmt);
+void DecodeTextureFromGX(GLuint destTexture, u32 level, u32 width, u32 height,
+	u32 expandedWidth, u32 expandedHeight, const u8* src, u64 srcHash,
+	int format, const u8* tlut, int tlutfmt);
+
 // returns size of the encoded data (in bytes)
 int EncodeToRamFromTexture(u32 address, GLuint source_texture, bool bFromZBuffer, bool bIsIntensityFmt, u32 copyfmt, int bScaleByHalf, const EFBRectangle& source);
 
+// Copies the encoded data which overlaps the range to RAM, if it was
+// read back asynchronously and hasn't arrived there yet
+void FlushReadbacks(u32 address = 0, u32 size = 0xFFFFFFFF);
+
 }
 
 }  // namespace OGL
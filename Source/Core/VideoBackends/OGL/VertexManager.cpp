@@ -16,6 +16,7 @@
 #include "Render.h"
 #include "ImageWrite.h"
 #include "BPMemory.h"
+#include "XFMemory.h"
 #include "TextureCache.h"
 #include "PixelShaderManager.h"
 #include "VertexShaderManager.h"
@@ -44,6 +45,46 @@ static StreamBuffer *s_indexBuffer;
 static size_t s_baseVertex;
 static size_t s_index_offset;
 
+// Buffer textures over the streams for the vertex shaders expanding lines and
+// points: the vertex data as floats and as integers, and the indices
+static bool s_expand_lines_points;
+static GLuint s_expand_textures[3];
+
+// Consecutive draws which only differ in their shader constants are held back
+// and issued with one glMultiDrawElementsIndirect. The base instance of each
+// command selects its constants through the draw index attribute.
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+const u32 MAX_INDIRECT_BUFFER_SIZE = 256*1024;
+
+static StreamBuffer *s_indirect_buffer;
+static DrawElementsIndirectCommand s_batch_draws[MULTIDRAW_BATCH_SIZE];
+static PixelShaderConstants s_batch_pixel_constants[MULTIDRAW_BATCH_SIZE];
+static VertexShaderConstants s_batch_vertex_constants[MULTIDRAW_BATCH_SIZE];
+static u32 s_batch_size;
+static SHADER* s_batch_shader;
+static GLuint s_batch_vao;
+static GLenum s_batch_primitive_mode;
+// Where the data of the first held back draw starts in the streams
+static size_t s_batch_vertex_offset;
+static size_t s_batch_index_offset;
+static u32 s_batch_vertex_wrap;
+static u32 s_batch_index_wrap;
+// The commands of the last issued batch, drawn again by the alpha pass
+static size_t s_batch_commands_offset;
+static u32 s_batch_commands_count;
+
+static const float LINE_PT_TEX_OFFSETS[8] = {
+	0.f, 0.0625f, 0.125f, 0.25f, 0.5f, 1.f, 1.f, 1.f
+};
+
 VertexManager::VertexManager()
 {
 	CreateDeviceObjects();
@@ -64,6 +105,42 @@ void VertexManager::CreateDeviceObjects()
 
 	m_CurrentVertexFmt = NULL;
 	m_last_vao = 0;
+
+	// The buffer textures have to cover the whole vertex stream
+	GLint max_texels = 0;
+	if (g_ogl_config.bSupportsVertexExpansion)
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	s_expand_lines_points = (u32)max_texels >= MAX_VBUFFER_SIZE / sizeof(float);
+	if (s_expand_lines_points)
+	{
+		const GLenum formats[3] = { GL_R32F, GL_R32UI, GL_R16UI };
+		const GLuint buffers[3] = { s_vertexBuffer->m_buffer, s_vertexBuffer->m_buffer, s_indexBuffer->m_buffer };
+		glGenTextures(3, s_expand_textures);
+		for (int i = 0; i < 3; ++i)
+		{
+			glBindTexture(GL_TEXTURE_BUFFER, s_expand_textures[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// The draw index attribute reads this with a divisor of one, so each
+	// command's base instance is its index into the constant arrays
+	m_draw_index_buffer = 0;
+	s_indirect_buffer = NULL;
+	s_batch_size = 0;
+	if (g_ActiveConfig.backend_info.bSupportsMultiDraw)
+	{
+		u32 draw_indices[MULTIDRAW_BATCH_SIZE];
+		for (u32 i = 0; i < MULTIDRAW_BATCH_SIZE; ++i)
+			draw_indices[i] = i;
+		glGenBuffers(1, &m_draw_index_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_draw_index_buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(draw_indices), draw_indices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffers);
+
+		s_indirect_buffer = StreamBuffer::Create(GL_DRAW_INDIRECT_BUFFER, MAX_INDIRECT_BUFFER_SIZE);
+	}
 }
 
 void VertexManager::DestroyDeviceObjects()
@@ -73,6 +150,22 @@ void VertexManager::DestroyDeviceObjects()
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0 );
 	GL_REPORT_ERROR();
 
+	if (s_expand_lines_points)
+	{
+		glDeleteTextures(3, s_expand_textures);
+		s_expand_lines_points = false;
+	}
+
+	if (s_indirect_buffer)
+	{
+		delete s_indirect_buffer;
+		s_indirect_buffer = NULL;
+		glDeleteBuffers(1, &m_draw_index_buffer);
+		m_draw_index_buffer = 0;
+	}
+	s_batch_size = 0;
+	s_batch_open = false;
+
 	delete s_vertexBuffer;
 	delete s_indexBuffer;
 	GL_REPORT_ERROR();
@@ -92,6 +185,12 @@ void VertexManager::PrepareDrawBuffers(u32 stride)
 
 void VertexManager::ResetBuffer(u32 stride)
 {
+	// The held back draws have to be issued before the streams place fences
+	// over their data, which would only guard the draws issued so far
+	if (s_batch_size && (s_vertexBuffer->MayFence(s_batch_vertex_offset, MAXVBUFFERSIZE, stride) ||
+		s_indexBuffer->MayFence(s_batch_index_offset, MAXIBUFFERSIZE * sizeof(u16))))
+		EndBatch();
+
 	auto buffer = s_vertexBuffer->Map(MAXVBUFFERSIZE, stride);
 	s_pCurBufferPointer = s_pBaseBufferPointer = buffer.first;
 	s_pEndBufferPointer = buffer.first + MAXVBUFFERSIZE;
@@ -100,27 +199,117 @@ void VertexManager::ResetBuffer(u32 stride)
 	buffer = s_indexBuffer->Map(MAXIBUFFERSIZE * sizeof(u16));
 	IndexGenerator::Start((u16*)buffer.first);
 	s_index_offset = buffer.second;
+
+	// or before their data gets overwritten
+	if (s_batch_size && (s_vertexBuffer->GetWrapCount() != s_batch_vertex_wrap ||
+		s_indexBuffer->GetWrapCount() != s_batch_index_wrap))
+		EndBatch();
 }
 
-void VertexManager::Draw(u32 stride)
+static VS_EXPAND GetVertexExpansion(PrimitiveType primitive_type)
 {
-	u32 index_size = IndexGenerator::GetIndexLen();
-	u32 max_index = IndexGenerator::GetNumVerts();
-	GLenum primitive_mode = 0;
+	if (!s_expand_lines_points)
+		return VSEXPAND_NONE;
 
-	switch(current_primitive_type)
+	switch (primitive_type)
+	{
+	case PRIMITIVE_LINES:
+		return VSEXPAND_LINE;
+	case PRIMITIVE_POINTS:
+		return VSEXPAND_POINT;
+	default:
+		return VSEXPAND_NONE;
+	}
+}
+
+// Tells the bound program where the vertices are and how big the lines or points are
+static void SetExpansionUniforms(const SHADER* shader, VS_EXPAND expand, const PortableVertexDeclaration& vtx_decl)
+{
+	GLint layout[7][4];
+	memset(layout, 0, sizeof(layout));
+	layout[0][0] = vtx_decl.stride / sizeof(u32);
+	layout[0][1] = (GLint)(s_baseVertex * vtx_decl.stride / sizeof(u32));
+	layout[0][2] = (GLint)(s_index_offset / sizeof(u16));
+
+	const AttributeFormat* attribs[16] = {};
+	attribs[SHADER_POSITION_ATTRIB] = &vtx_decl.position;
+	attribs[SHADER_POSMTX_ATTRIB] = &vtx_decl.posmtx;
+	for (int i = 0; i < 3; ++i)
+		attribs[SHADER_NORM0_ATTRIB + i] = &vtx_decl.normals[i];
+	for (int i = 0; i < 2; ++i)
+		attribs[SHADER_COLOR0_ATTRIB + i] = &vtx_decl.colors[i];
+	for (int i = 0; i < 8; ++i)
+	{
+		attribs[SHADER_TEXTURE0_ATTRIB + i] = &vtx_decl.texcoords[i];
+		layout[5 + i / 4][i % 4] = vtx_decl.texcoords[i].components;
+	}
+	for (int i = 0; i < 16; ++i)
+	{
+		if (attribs[i])
+			layout[1 + i / 4][i % 4] = attribs[i]->offset / sizeof(u32);
+	}
+
+	GLfloat params[3][4];
+	if (expand == VSEXPAND_LINE)
+	{
+		params[0][0] = float(bpmem.lineptwidth.linesize) / 6.f;
+		params[0][1] = LINE_PT_TEX_OFFSETS[bpmem.lineptwidth.lineoff];
+		for (int i = 0; i < 8; ++i)
+			params[1 + i / 4][i % 4] = bpmem.texcoords[i].s.line_offset;
+	}
+	else
+	{
+		params[0][0] = float(bpmem.lineptwidth.pointsize) / 6.f;
+		params[0][1] = LINE_PT_TEX_OFFSETS[bpmem.lineptwidth.pointoff];
+		for (int i = 0; i < 8; ++i)
+			params[1 + i / 4][i % 4] = bpmem.texcoords[i].s.point_offset;
+	}
+	params[0][2] = 2.0f * xfregs.viewport.wd;
+	params[0][3] = -2.0f * xfregs.viewport.ht;
+
+	glUniform4iv(shader->expand_layout_loc, 7, &layout[0][0]);
+	glUniform4fv(shader->expand_params_loc, 3, &params[0][0]);
+}
+
+static GLenum GetPrimitiveMode(PrimitiveType primitive_type)
+{
+	switch(primitive_type)
 	{
 		case PRIMITIVE_POINTS:
-			primitive_mode = GL_POINTS;
-			break;
+			return GL_POINTS;
 		case PRIMITIVE_LINES:
-			primitive_mode = GL_LINES;
-			break;
+			return GL_LINES;
 		case PRIMITIVE_TRIANGLES:
-			primitive_mode = g_ActiveConfig.backend_info.bSupportsPrimitiveRestart ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
-			break;
+			return g_ActiveConfig.backend_info.bSupportsPrimitiveRestart ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+	}
+	return 0;
+}
+
+void VertexManager::Draw(u32 stride, VS_EXPAND expand)
+{
+	u32 index_size = IndexGenerator::GetIndexLen();
+	u32 max_index = IndexGenerator::GetNumVerts();
+
+	// One quad per line or point, built by the vertex shader. Unlike lines and
+	// points, the quads could be culled.
+	if (expand != VSEXPAND_NONE)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + EXPAND_TEXTURE_UNIT + i);
+			glBindTexture(GL_TEXTURE_BUFFER, s_expand_textures[i]);
+		}
+		glActiveTexture(GL_TEXTURE0);
+
+		glDisable(GL_CULL_FACE);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, expand == VSEXPAND_LINE ? index_size / 2 : index_size);
+		g_renderer->SetGenerationMode();
+		INCSTAT(stats.thisFrame.numDrawCalls);
+		return;
 	}
 
+	const GLenum primitive_mode = GetPrimitiveMode(current_primitive_type);
+
 	if(g_ogl_config.bSupportsGLBaseVertex) {
 		glDrawRangeElementsBaseVertex(primitive_mode, 0, max_index, index_size, GL_UNSIGNED_SHORT, (u8*)NULL+s_index_offset, (GLint)s_baseVertex);
 	} else {
@@ -129,6 +318,67 @@ void VertexManager::Draw(u32 stride)
 	INCSTAT(stats.thisFrame.numIndexedDrawCalls);
 }
 
+void VertexManager::QueueDraw(SHADER* shader, GLuint vao, u32 stride)
+{
+	if (!s_batch_size)
+	{
+		s_batch_shader = shader;
+		s_batch_vao = vao;
+		s_batch_primitive_mode = GetPrimitiveMode(current_primitive_type);
+		s_batch_vertex_offset = s_baseVertex * stride;
+		s_batch_index_offset = s_index_offset;
+		s_batch_vertex_wrap = s_vertexBuffer->GetWrapCount();
+		s_batch_index_wrap = s_indexBuffer->GetWrapCount();
+	}
+
+	DrawElementsIndirectCommand& draw = s_batch_draws[s_batch_size];
+	draw.count = IndexGenerator::GetIndexLen();
+	draw.instance_count = 1;
+	draw.first_index = (GLuint)(s_index_offset / sizeof(u16));
+	draw.base_vertex = (GLint)s_baseVertex;
+	draw.base_instance = s_batch_size;
+
+	s_batch_pixel_constants[s_batch_size] = PixelShaderManager::constants;
+	s_batch_vertex_constants[s_batch_size] = VertexShaderManager::constants;
+	s_batch_size++;
+	s_batch_open = true;
+}
+
+void VertexManager::DrawBatch()
+{
+	glMultiDrawElementsIndirect(s_batch_primitive_mode, GL_UNSIGNED_SHORT,
+		(u8*)NULL + s_batch_commands_offset, s_batch_commands_count, 0);
+	INCSTAT(stats.thisFrame.numIndexedDrawCalls);
+}
+
+void VertexManager::EndBatch()
+{
+	if (!s_batch_size)
+		return;
+
+	ProgramShaderCache::UploadMultiDrawConstants(s_batch_pixel_constants, s_batch_vertex_constants, s_batch_size);
+
+	const size_t commands_size = s_batch_size * sizeof(DrawElementsIndirectCommand);
+	auto buffer = s_indirect_buffer->Map(commands_size, sizeof(DrawElementsIndirectCommand));
+	memcpy(buffer.first, s_batch_draws, commands_size);
+	s_indirect_buffer->Unmap(commands_size);
+	s_batch_commands_offset = buffer.second;
+	s_batch_commands_count = s_batch_size;
+
+	s_batch_size = 0;
+	s_batch_open = false;
+
+	s_batch_shader->Bind();
+	if (m_last_vao != s_batch_vao)
+	{
+		glBindVertexArray(s_batch_vao);
+		m_last_vao = s_batch_vao;
+	}
+
+	DrawBatch();
+	GL_REPORT_ERRORD();
+}
+
 void VertexManager::vFlush(bool useDstAlpha)
 {
 	GLVertexFormat *nativeVertexFmt = (GLVertexFormat*)g_nativeVertexFmt;
@@ -145,46 +395,94 @@ void VertexManager::vFlush(bool useDstAlpha)
 	// Makes sure we can actually do Dual source blending
 	bool dualSourcePossible = g_ActiveConfig.backend_info.bSupportsDualSourceBlend;
 
+	const VS_EXPAND expand = GetVertexExpansion(current_primitive_type);
+
 	// finally bind
+	SHADER* shader;
 	if (dualSourcePossible)
 	{
 		if (useDstAlpha)
 		{
 			// If host supports GL_ARB_blend_func_extended, we can do dst alpha in
 			// the same pass as regular rendering.
-			ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, g_nativeVertexFmt->m_components);
+			shader = ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, g_nativeVertexFmt->m_components, expand);
 		}
 		else
 		{
-			ProgramShaderCache::SetShader(DSTALPHA_NONE,g_nativeVertexFmt->m_components);
+			shader = ProgramShaderCache::SetShader(DSTALPHA_NONE,g_nativeVertexFmt->m_components, expand);
 		}
 	}
 	else
 	{
-		ProgramShaderCache::SetShader(DSTALPHA_NONE,g_nativeVertexFmt->m_components);
+		shader = ProgramShaderCache::SetShader(DSTALPHA_NONE,g_nativeVertexFmt->m_components, expand);
+	}
+
+	const bool multi_draw = g_ActiveConfig.MultiDrawEnabled();
+
+	// No usable program, e.g. because it's still being compiled in the background.
+	// Skip the draw rather than rendering it with whatever program was bound last.
+	if (!shader)
+	{
+		if (multi_draw && !s_may_batch)
+			EndBatch();
+		ClearEFBCache();
+		return;
 	}
 
-	// upload global constants
-	ProgramShaderCache::UploadConstants();
+	// Only draws with the same program, vertex array and primitive go in one batch.
+	// Expanded lines and points are instanced already, they are drawn on their own.
+	if (s_batch_size && (shader != s_batch_shader || nativeVertexFmt->VAO != s_batch_vao ||
+		GetPrimitiveMode(current_primitive_type) != s_batch_primitive_mode || expand != VSEXPAND_NONE))
+	{
+		EndBatch();
+		shader->Bind();
+		glBindVertexArray(nativeVertexFmt->VAO);
+		m_last_vao = nativeVertexFmt->VAO;
+	}
 
 	// setup the pointers
 	if (g_nativeVertexFmt)
 		g_nativeVertexFmt->SetupVertexPointers();
 	GL_REPORT_ERRORD();
 
-	Draw(stride);
+	if (multi_draw && expand == VSEXPAND_NONE)
+	{
+		QueueDraw(shader, nativeVertexFmt->VAO, stride);
 
-	// run through vertex groups again to set alpha
-	if (useDstAlpha && !dualSourcePossible)
+		// The next draw may change more than the constants
+		if (!s_may_batch || s_batch_size == MULTIDRAW_BATCH_SIZE || (useDstAlpha && !dualSourcePossible))
+			EndBatch();
+	}
+	else
 	{
-		ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS,g_nativeVertexFmt->m_components);
+		// upload global constants
+		if (multi_draw)
+			ProgramShaderCache::UploadMultiDrawConstants(&PixelShaderManager::constants, &VertexShaderManager::constants, 1);
+		else
+			ProgramShaderCache::UploadConstants();
+
+		if (expand != VSEXPAND_NONE)
+			SetExpansionUniforms(shader, expand, nativeVertexFmt->GetVertexDeclaration());
 
+		Draw(stride, expand);
+	}
+
+	// run through vertex groups again to set alpha
+	if (useDstAlpha && !dualSourcePossible &&
+		(shader = ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS,g_nativeVertexFmt->m_components, expand)))
+	{
 		// only update alpha
 		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
 
 		glDisable(GL_BLEND);
 
-		Draw(stride);
+		if (expand != VSEXPAND_NONE)
+			SetExpansionUniforms(shader, expand, nativeVertexFmt->GetVertexDeclaration());
+
+		if (multi_draw && expand == VSEXPAND_NONE)
+			DrawBatch();
+		else
+			Draw(stride, expand);
 
 		// restore color mask
 		g_renderer->SetColorMask();
@@ -7,9 +7,12 @@
 #include "CPMemory.h"
 
 #include "VertexManagerBase.h"
+#include "VertexShaderGen.h"
 
 namespace OGL
 {
+	struct SHADER;
+
 	class GLVertexFormat : public NativeVertexFormat
 	{
 		PortableVertexDeclaration vtx_decl;
@@ -21,6 +24,8 @@ namespace OGL
 		virtual void Initialize(const PortableVertexDeclaration &_vtx_decl) override;
 		virtual void SetupVertexPointers() override;
 
+		const PortableVertexDeclaration& GetVertexDeclaration() const { return vtx_decl; }
+
 		GLuint VAO;
 	};
 
@@ -34,15 +39,19 @@ public:
 	NativeVertexFormat* CreateNativeVertexFormat() override;
 	void CreateDeviceObjects() override;
 	void DestroyDeviceObjects() override;
+	void EndBatch() override;
 
 	// NativeVertexFormat use this
 	GLuint m_vertex_buffers;
 	GLuint m_index_buffers;
+	GLuint m_draw_index_buffer;
 	GLuint m_last_vao;
 protected:
 	virtual void ResetBuffer(u32 stride);
 private:
-	void Draw(u32 stride);
+	void Draw(u32 stride, VS_EXPAND expand);
+	void QueueDraw(SHADER* shader, GLuint vao, u32 stride);
+	void DrawBatch();
 	void vFlush(bool useDstAlpha) override;
 	void PrepareDrawBuffers(u32 stride);
 	NativeVertexFormat *m_CurrentVertexFmt;
@@ -20,6 +20,26 @@ void InitBPMemory()
 	bpmem.bpMask = 0xFFFFFF;
 }
 
+// Writes that do something even when they don't change the register
+static bool IsTriggerRegister(int address)
+{
+	switch (address)
+	{
+	case BPMEM_SETDRAWDONE:
+	case BPMEM_PE_TOKEN_ID:
+	case BPMEM_PE_TOKEN_INT_ID:
+	case BPMEM_TRIGGER_EFB_COPY:
+	case BPMEM_CLEARBBOX1:
+	case BPMEM_CLEARBBOX2:
+	case BPMEM_CLEAR_PIXEL_PERF:
+	case BPMEM_LOADTLUT1:
+	case BPMEM_PRELOAD_MODE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void SWLoadBPReg(u32 value)
 {
 	//handle the mask register
@@ -27,6 +47,10 @@ void SWLoadBPReg(u32 value)
 	int oldval = ((u32*)&bpmem)[address];
 	int newval = (oldval & ~bpmem.bpMask) | (value & bpmem.bpMask);
 
+	// queued triangles have to be drawn with the state they were set up with
+	if (address != BPMEM_BP_MASK && (newval != oldval || IsTriggerRegister(address)))
+		Rasterizer::Flush();
+
 	((u32*)&bpmem)[address] = newval;
 
 	//reset the mask register
@@ -11,6 +11,7 @@
 #include "EfbInterface.h"
 #include "SWStatistics.h"
 #include "HwRasterizer.h"
+#include "Rasterizer.h"
 #include "StringUtil.h"
 #include "SWCommandProcessor.h"
 #include "ImageWrite.h"
@@ -123,6 +124,8 @@ void DumpActiveTextures()
 
 void DumpEfb(const std::string filename)
 {
+	Rasterizer::Flush();
+
 	u8 *data = new u8[EFB_WIDTH * EFB_HEIGHT * 4];
 	u8 *writePtr = data;
 	u8 sample[4];
@@ -146,6 +149,8 @@ void DumpEfb(const std::string filename)
 
 void DumpDepth(const std::string filename)
 {
+	Rasterizer::Flush();
+
 	u8 *data = new u8[EFB_WIDTH * EFB_HEIGHT * 4];
 	u8 *writePtr = data;
 
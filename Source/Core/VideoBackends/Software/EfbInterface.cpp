@@ -2,12 +2,13 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common.h"
 
 #include "EfbInterface.h"
 #include "BPMemLoader.h"
 #include "LookUpTables.h"
-#include "SWPixelEngine.h"
 #include "HW/Memmap.h"
 
 
@@ -15,6 +16,22 @@ u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
 
 namespace EfbInterface
 {
+	static const int DEPTH_TILES_X = EFB_WIDTH / DEPTH_TILE_SIZE;
+	static const int DEPTH_TILES_Y = EFB_HEIGHT / DEPTH_TILE_SIZE;
+
+	// Every depth of a tile lies within its bounds. Overwriting the smallest
+	// or largest depth only marks the bounds as loose, they are tightened
+	// once they keep a triangle from being rejected.
+	struct DepthTile
+	{
+		u32 minDepth;
+		u32 maxDepth;
+		bool loose;
+	};
+
+	// the EFB starts out cleared to zero
+	static DepthTile depthTiles[DEPTH_TILES_X * DEPTH_TILES_Y];
+
 	inline u32 GetColorOffset(u16 x, u16 y)
 	{
 		return (x + y * EFB_WIDTH) * 3;
@@ -28,6 +45,36 @@ namespace EfbInterface
 	void DoState(PointerWrap &p)
 	{
 		p.DoArray(efb, EFB_WIDTH*EFB_HEIGHT*6);
+
+		if (p.GetMode() == PointerWrap::MODE_READ)
+		{
+			for (DepthTile& tile : depthTiles)
+			{
+				tile.minDepth = 0;
+				tile.maxDepth = 0x00ffffff;
+				tile.loose = true;
+			}
+		}
+	}
+
+	inline DepthTile& GetDepthTile(u16 x, u16 y)
+	{
+		return depthTiles[(y / DEPTH_TILE_SIZE) * DEPTH_TILES_X + x / DEPTH_TILE_SIZE];
+	}
+
+	void UpdateDepthTile(u16 x, u16 y, u32 oldDepth, u32 newDepth)
+	{
+		newDepth &= 0x00ffffff;
+		if (newDepth == oldDepth || x >= EFB_WIDTH || y >= EFB_HEIGHT)
+			return;
+
+		DepthTile& tile = GetDepthTile(x, y);
+		if (oldDepth == tile.minDepth || oldDepth == tile.maxDepth)
+			tile.loose = true;
+		if (newDepth < tile.minDepth)
+			tile.minDepth = newDepth;
+		if (newDepth > tile.maxDepth)
+			tile.maxDepth = newDepth;
 	}
 
 	void SetPixelAlphaOnly(u32 offset, u8 a)
@@ -429,12 +476,6 @@ namespace EfbInterface
 		{
 			SetPixelAlphaOnly(offset, dstClrPtr[ALP_C]);
 		}
-
-		// branchless bounding box update
-		SWPixelEngine::pereg.boxLeft = SWPixelEngine::pereg.boxLeft>x?x:SWPixelEngine::pereg.boxLeft;
-		SWPixelEngine::pereg.boxRight = SWPixelEngine::pereg.boxRight<x?x:SWPixelEngine::pereg.boxRight;
-		SWPixelEngine::pereg.boxTop = SWPixelEngine::pereg.boxTop>y?y:SWPixelEngine::pereg.boxTop;
-		SWPixelEngine::pereg.boxBottom = SWPixelEngine::pereg.boxBottom<y?y:SWPixelEngine::pereg.boxBottom;
 	}
 
 	void SetColor(u16 x, u16 y, u8 *color)
@@ -456,7 +497,11 @@ namespace EfbInterface
 	void SetDepth(u16 x, u16 y, u32 depth)
 	{
 		if (bpmem.zmode.updateenable)
-			SetPixelDepth(GetDepthOffset(x, y), depth);
+		{
+			u32 offset = GetDepthOffset(x, y);
+			UpdateDepthTile(x, y, GetPixelDepth(offset), depth);
+			SetPixelDepth(offset, depth);
+		}
 	}
 
 	void GetColor(u16 x, u16 y, u8 *color)
@@ -614,9 +659,63 @@ namespace EfbInterface
 
 		if (pass && bpmem.zmode.updateenable)
 		{
+			UpdateDepthTile(x, y, depth, z);
 			SetPixelDepth(offset, z);
 		}
 
 		return pass;
 	}
+
+	bool ZCompareTile(u16 x, u16 y, u32 zMin, u32 zMax)
+	{
+		DepthTile& tile = GetDepthTile(x, y);
+
+		for (;;)
+		{
+			bool pass;
+
+			switch (bpmem.zmode.func)
+			{
+				case COMPARE_NEVER:
+					pass = false;
+					break;
+				case COMPARE_LESS:
+					pass = zMin < tile.maxDepth;
+					break;
+				case COMPARE_EQUAL:
+					pass = zMin <= tile.maxDepth && zMax >= tile.minDepth;
+					break;
+				case COMPARE_LEQUAL:
+					pass = zMin <= tile.maxDepth;
+					break;
+				case COMPARE_GREATER:
+					pass = zMax > tile.minDepth;
+					break;
+				case COMPARE_GEQUAL:
+					pass = zMax >= tile.minDepth;
+					break;
+				default:
+					pass = true;
+			}
+
+			if (!pass || !tile.loose)
+				return pass;
+
+			// all pixel formats keep 24 bits of depth
+			const u16 left = x - x % DEPTH_TILE_SIZE;
+			const u16 top = y - y % DEPTH_TILE_SIZE;
+			tile.minDepth = 0x00ffffff;
+			tile.maxDepth = 0;
+			for (u16 ty = top; ty < top + DEPTH_TILE_SIZE; ty++)
+			{
+				for (u16 tx = left; tx < left + DEPTH_TILE_SIZE; tx++)
+				{
+					u32 depth = (*(u32*)&efb[GetDepthOffset(tx, ty)]) & 0x00ffffff;
+					tile.minDepth = std::min(tile.minDepth, depth);
+					tile.maxDepth = std::max(tile.maxDepth, depth);
+				}
+			}
+			tile.loose = false;
+		}
+	}
 }
@@ -10,6 +10,10 @@ namespace EfbInterface
 {
 	const int DEPTH_BUFFER_START = EFB_WIDTH * EFB_HEIGHT * 3;
 
+	// The depth buffer is split into tiles that keep bounds of the depths
+	// they hold, so that whole parts of a triangle can fail the depth test
+	const int DEPTH_TILE_SIZE = 8;
+
 	// xfb color format - packed so the compiler doesn't mess with alignment
 #pragma pack(push,1)
 	typedef struct {
@@ -37,6 +41,10 @@ namespace EfbInterface
 	// returns result of compare.
 	bool ZCompare(u16 x, u16 y, u32 z);
 
+	// returns false if no depth between zMin and zMax can pass the depth
+	// compare anywhere in the depth tile holding x,y
+	bool ZCompareTile(u16 x, u16 y, u32 zMin, u32 zMax);
+
 	// sets the color and alpha
 	void SetColor(u16 x, u16 y, u8 *color);
 	void SetDepth(u16 x, u16 y, u32 depth);
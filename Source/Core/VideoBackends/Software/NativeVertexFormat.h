@@ -14,6 +14,9 @@
 #endif
 
 typedef void (LOADERDECL *TPipelineFunction)();
+// Unused here, but the shared attribute loaders expose them
+typedef void (LOADERDECL *TBatchFunction)(const u8* src, int src_stride, u8* dst, int dst_stride,
+	int count, int array, float scale);
 
 struct Vec4
 {
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common.h"
 
 #include "DataReader.h"
@@ -16,6 +18,7 @@
 #include "SWCommandProcessor.h"
 #include "CPMemLoader.h"
 #include "SWVideoConfig.h"
+#include "TextureSampler.h"
 #include "HW/Memmap.h"
 
 typedef void (*DecodingFunction)(u32);
@@ -65,12 +68,10 @@ void DecodePrimitiveStream(u32 iBufferSize)
 	}
 	else
 	{
-		while (streamSize > 0 && iBufferSize >= vertexSize)
-		{
-			vertexLoader.LoadVertex();
-			iBufferSize -= vertexSize;
-			streamSize--;
-		}
+		const u32 count = vertexSize ? std::min<u32>(streamSize, iBufferSize / vertexSize) : streamSize;
+		vertexLoader.LoadVertices(count);
+		iBufferSize -= count * vertexSize;
+		streamSize -= count;
 	}
 
 	if (streamSize == 0)
@@ -125,6 +126,11 @@ void DecodeStandard(u32 bufferSize)
 
 	if (Cmd == GX_NOP)
 		return;
+
+	// the textures may have changed since the last primitives
+	if (Cmd & 0x80 && !inObjectStream)
+		TextureSampler::InvalidateCache();
+
 	// Causes a SIGBUS error on Android
 	// XXX: Investigate
 #ifndef ANDROID
@@ -2,7 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cmath>
+#include <vector>
+
 #include "Common.h"
+#include "ThreadPool.h"
 
 #include "Rasterizer.h"
 #include "HwRasterizer.h"
@@ -17,6 +21,15 @@
 
 #define BLOCK_SIZE 2
 
+// The threaded rasterizer bins triangles into tiles of the EFB. The tiles are
+// drawn in parallel and every tile draws its triangles in submission order.
+#define TILE_SIZE 32
+static const int TILES_X = (EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
+static const int TILES_Y = (EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+
+// Bounds the memory and the latency of one batch of queued triangles
+static const size_t MAX_QUEUED_TRIANGLES = 4096;
+
 #define CLAMP(x, a, b) (x>b)?b:(x<a)?a:x
 
 // returns approximation of log2(f) in s28.4
@@ -32,54 +45,91 @@ static inline s32 FixedLog2(float f)
 
 namespace Rasterizer
 {
-Slope ZSlope;
-Slope WSlope;
-Slope ColorSlopes[2][4];
-Slope TexSlopes[8][3];
+// Everything the pixel loop needs to know about a triangle, so that it can
+// still be drawn after the next ones have been set up
+struct Triangle
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// half-edge constants and deltas in 28.4 fixed point
+	s32 C1, C2, C3;
+	s32 DX12, DX23, DX31;
+	s32 DY12, DY23, DY31;
+
+	// bounding rectangle, clipped to the scissor rectangle
+	s32 minx, maxx, miny, maxy;
+};
+
+// Every thread that draws pixels needs its own TEV and LOD block
+struct DrawContext
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+};
 
-s32 vertex0X;
-s32 vertex0Y;
-float vertexOffsetX;
-float vertexOffsetY;
+// the triangle being set up, its z slope is kept for zfreeze
+Triangle triangle;
 
 s32 scissorLeft = 0;
 s32 scissorTop = 0;
 s32 scissorRight = 0;
 s32 scissorBottom = 0;
 
-Tev tev;
-RasterBlock rasterBlock;
+// Holds the TEV registers as the BP writes set them, and draws the triangles
+// when the rasterizer isn't threaded
+DrawContext mainContext;
+
+static std::vector<Triangle> queuedTriangles;
+static std::vector<u16> tileTriangles[TILES_X * TILES_Y];
+static std::vector<int> activeTiles;
+static std::vector<DrawContext> threadContexts;
 
 void DoState(PointerWrap &p)
 {
-	ZSlope.DoState(p);
-	WSlope.DoState(p);
-	for (auto& ColorSlope : ColorSlopes)
+	Flush();
+
+	triangle.ZSlope.DoState(p);
+	triangle.WSlope.DoState(p);
+	for (auto& ColorSlope : triangle.ColorSlopes)
 		for (int n=0; n<4; ++n)
 			ColorSlope[n].DoState(p);
-	for (auto& TexSlope : TexSlopes)
+	for (auto& TexSlope : triangle.TexSlopes)
 		for (int n=0; n<3; ++n)
 			TexSlope[n].DoState(p);
-	p.Do(vertex0X);
-	p.Do(vertex0Y);
-	p.Do(vertexOffsetX);
-	p.Do(vertexOffsetY);
+	p.Do(triangle.vertex0X);
+	p.Do(triangle.vertex0Y);
+	p.Do(triangle.vertexOffsetX);
+	p.Do(triangle.vertexOffsetY);
 	p.Do(scissorLeft);
 	p.Do(scissorTop);
 	p.Do(scissorRight);
 	p.Do(scissorBottom);
-	tev.DoState(p);
-	p.Do(rasterBlock);
+	mainContext.tev.DoState(p);
+	p.Do(mainContext.rasterBlock);
 }
 
 void Init()
 {
-	tev.Init();
+	mainContext.tev.Init();
 
 	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
 	// TODO: This is just a guess!
-	ZSlope.dfdx = ZSlope.dfdy = 0.f;
-	ZSlope.f0 = 1.f;
+	triangle.ZSlope.dfdx = triangle.ZSlope.dfdy = 0.f;
+	triangle.ZSlope.f0 = 1.f;
+
+	queuedTriangles.clear();
+	for (auto& tile : tileTriangles)
+		tile.clear();
+	activeTiles.clear();
+	threadContexts.clear();
 }
 
 inline int iround(float x)
@@ -121,61 +171,84 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	mainContext.tev.SetRegColor(reg, comp, konst, color);
 }
 
-inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
+// Draws the pixels of the block at x, y whose bits are set in the mask, bit
+// xi + yi * BLOCK_SIZE stands for the pixel at x + xi, y + yi
+inline void Draw(const Triangle& tri, DrawContext& context, s32 x, s32 y, u32 pixelMask)
 {
-	INCSTAT(swstats.thisFrame.rasterizedPixels);
+	Tev& tev = context.tev;
+	RasterBlock& rasterBlock = context.rasterBlock;
+
+	for (int i = 0; i < Tev::QUAD_SIZE; i++)
+	{
+		if (!(pixelMask & (1 << i)))
+			continue;
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+		const s32 xi = i % BLOCK_SIZE;
+		const s32 yi = i / BLOCK_SIZE;
 
-	s32 z = (s32)ZSlope.GetValue(dx, dy);
-	if (z < 0 || z > 0x00ffffff)
-		return;
+		tev.Counts.rasterizedPixels++;
 
-	if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
-	{
-		// TODO: Test if perf regs are incremented even if test is disabled
-		SWPixelEngine::pereg.IncZInputQuadCount(true);
-		if (bpmem.zmode.testenable)
+		float dx = tri.vertexOffsetX + (float)(x + xi - tri.vertex0X);
+		float dy = tri.vertexOffsetY + (float)(y + yi - tri.vertex0Y);
+
+		s32 z = (s32)tri.ZSlope.GetValue(dx, dy);
+		if (z < 0 || z > 0x00ffffff)
 		{
-			// early z
-			if (!EfbInterface::ZCompare(x, y, z))
-				return;
+			pixelMask &= ~(1 << i);
+			continue;
 		}
-		SWPixelEngine::pereg.IncZOutputQuadCount(true);
-	}
 
-	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+		if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
+		{
+			// TODO: Test if perf regs are incremented even if test is disabled
+			tev.Counts.zInputEarly++;
+			if (bpmem.zmode.testenable)
+			{
+				// early z
+				if (!EfbInterface::ZCompare(x + xi, y + yi, z))
+				{
+					pixelMask &= ~(1 << i);
+					continue;
+				}
+			}
+			tev.Counts.zOutputEarly++;
+		}
 
-	tev.Position[0] = x;
-	tev.Position[1] = y;
-	tev.Position[2] = z;
+		RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-	//  colors
-	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
-	{
-		for(int comp = 0; comp < 4; comp++)
+		tev.Position[i][0] = x + xi;
+		tev.Position[i][1] = y + yi;
+		tev.Position[i][2] = z;
+
+		//  colors
+		for (unsigned int j = 0; j < bpmem.genMode.numcolchans; j++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			for(int comp = 0; comp < 4; comp++)
+			{
+				u16 color = (u16)tri.ColorSlopes[j][comp].GetValue(dx, dy);
 
-			// clamp color value to 0
-			u16 mask = ~(color >> 8);
+				// clamp color value to 0
+				u16 mask = ~(color >> 8);
 
-			tev.Color[i][comp] = color & mask;
+				tev.Color[i][j][comp] = color & mask;
+			}
 		}
-	}
 
-	// tex coords
-	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
-	{
-		// multiply by 128 because TEV stores UVs as s17.7
-		tev.Uv[i].s = (s32)(pixel.Uv[i][0] * 128);
-		tev.Uv[i].t = (s32)(pixel.Uv[i][1] * 128);
+		// tex coords
+		for (unsigned int j = 0; j < bpmem.genMode.numtexgens; j++)
+		{
+			// multiply by 128 because TEV stores UVs as s17.7
+			tev.Uv[i][j].s = (s32)(pixel.Uv[j][0] * 128);
+			tev.Uv[i][j].t = (s32)(pixel.Uv[j][1] * 128);
+		}
 	}
 
+	if (!pixelMask)
+		return;
+
 	for (unsigned int i = 0; i < bpmem.genMode.numindstages; i++)
 	{
 		tev.IndirectLod[i] = rasterBlock.IndirectLod[i];
@@ -188,19 +261,31 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 		tev.TextureLinear[i] = rasterBlock.TextureLinear[i];
 	}
 
-	tev.Draw();
+	if (g_SWVideoConfig.bDumpTevStages || g_SWVideoConfig.bDumpTevTextureFetches)
+	{
+		// the TEV dumps only have room for one pixel at a time
+		for (int i = 0; i < Tev::QUAD_SIZE; i++)
+		{
+			if (pixelMask & (1 << i))
+				tev.Draw(1 << i);
+		}
+	}
+	else
+	{
+		tev.Draw(pixelMask);
+	}
 }
 
 void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	triangle.vertex0X = xi;
+	triangle.vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	triangle.vertexOffsetX = ((float)xi - X1) + adjust;
+	triangle.vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -215,7 +300,7 @@ void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX1
 	slope->f0 = f1;
 }
 
-inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
+inline void CalculateLOD(RasterBlock& rasterBlock, s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	u8 subTexmap = texmap & 3;
@@ -225,14 +310,18 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	TexMode0& tm0 = texUnit.texMode0[subTexmap];
 	TexMode1& tm1 = texUnit.texMode1[subTexmap];
 
-	float sDelta, tDelta;
+	// The LOD comes from the texture coordinate derivatives of the block,
+	// using the longer of the derivative vectors along x and y so that it
+	// doesn't change when a texture gets rotated on screen
+	float rho;
 	if (tm0.diag_lod)
 	{
 		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
 		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
-		sDelta = fabsf(uv0[0] - uv1[0]);
-		tDelta = fabsf(uv0[1] - uv1[1]);
+		float sDelta = uv1[0] - uv0[0];
+		float tDelta = uv1[1] - uv0[1];
+		rho = sDelta * sDelta + tDelta * tDelta;
 	}
 	else
 	{
@@ -240,12 +329,15 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
 		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
-		sDelta = max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
-		tDelta = max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
+		float dsdx = uv1[0] - uv0[0];
+		float dtdx = uv1[1] - uv0[1];
+		float dsdy = uv2[0] - uv0[0];
+		float dtdy = uv2[1] - uv0[1];
+		rho = max(dsdx * dsdx + dtdx * dtdx, dsdy * dsdy + dtdy * dtdy);
 	}
 
 	// get LOD in s28.4
-	lod = FixedLog2(max(sDelta, tDelta));
+	lod = FixedLog2(sqrtf(rho));
 
 	// bias is s2.5
 	int bias = tm0.lod_bias;
@@ -261,7 +353,7 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	lod = CLAMP(lod, (s32)tm1.min_lod, (s32)tm1.max_lod);
 }
 
-void BuildBlock(s32 blockX, s32 blockY)
+void BuildBlock(const Triangle& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
@@ -269,10 +361,10 @@ void BuildBlock(s32 blockX, s32 blockY)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -281,13 +373,13 @@ void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (swxfregs.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
@@ -300,7 +392,7 @@ void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -312,41 +404,46 @@ void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
 		}
 	}
 }
 
-void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+// Returns false if no pixel of the triangle between x0,y0 and x1,y1 can
+// pass the depth test, the rectangle has to lie within one depth tile
+static bool ZCompareTile(const Triangle& tri, s32 x0, s32 y0, s32 x1, s32 y1)
 {
-	INCSTAT(swstats.thisFrame.numTrianglesDrawn);
-
-	if (g_SWVideoConfig.bHwRasterizer)
-	{
-		HwRasterizer::DrawTriangleFrontFace(v0, v1, v2);
-		return;
-	}
-
-	// adapted from http://www.devmaster.net/forums/showthread.php?t=1884
-
-	// 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
-	// could also take floor and adjust -8
-	const s32 Y1 = iround(16.0f * v0->screenPosition[1]) - 9;
-	const s32 Y2 = iround(16.0f * v1->screenPosition[1]) - 9;
-	const s32 Y3 = iround(16.0f * v2->screenPosition[1]) - 9;
-
-	const s32 X1 = iround(16.0f * v0->screenPosition[0]) - 9;
-	const s32 X2 = iround(16.0f * v1->screenPosition[0]) - 9;
-	const s32 X3 = iround(16.0f * v2->screenPosition[0]) - 9;
+	const Slope& slope = tri.ZSlope;
+	const float zx0 = slope.dfdx * (tri.vertexOffsetX + (float)(x0 - tri.vertex0X));
+	const float zx1 = slope.dfdx * (tri.vertexOffsetX + (float)(x1 - tri.vertex0X));
+	const float zy0 = slope.dfdy * (tri.vertexOffsetY + (float)(y0 - tri.vertex0Y));
+	const float zy1 = slope.dfdy * (tri.vertexOffsetY + (float)(y1 - tri.vertex0Y));
+
+	// z is linear, so it is bounded by the corners, give or take the rounding
+	// of the evaluation at every pixel
+	const float error = 1.0f + (fabsf(slope.f0) + max(fabsf(zx0), fabsf(zx1)) + max(fabsf(zy0), fabsf(zy1))) / (1 << 20);
+	const float zMin = slope.f0 + min(zx0, zx1) + min(zy0, zy1) - error;
+	const float zMax = slope.f0 + max(zx0, zx1) + max(zy0, zy1) + error;
+
+	// pixels outside of the depth range are dropped anyway
+	const u32 depthMin = zMin > 0.0f ? (u32)min(zMin, (float)0x00ffffff) : 0;
+	const u32 depthMax = zMax < (float)0x00ffffff ? (u32)max(zMax, 0.0f) : 0x00ffffff;
+
+	return EfbInterface::ZCompareTile(x0, y0, depthMin, depthMax);
+}
 
-	// Deltas
-	const s32 DX12 = X1 - X2;
-	const s32 DX23 = X2 - X3;
-	const s32 DX31 = X3 - X1;
+// Draws the part of a triangle that lies within the given rectangle, which
+// has to start on a block boundary
+static void RasterizeTriangle(const Triangle& tri, DrawContext& context, s32 left, s32 top, s32 right, s32 bottom)
+{
+	const s32 minx = max(tri.minx, left);
+	const s32 maxx = min(tri.maxx, right);
+	const s32 miny = max(tri.miny, top);
+	const s32 maxy = min(tri.maxy, bottom);
 
-	const s32 DY12 = Y1 - Y2;
-	const s32 DY23 = Y2 - Y3;
-	const s32 DY31 = Y3 - Y1;
+	const s32 C1 = tri.C1, C2 = tri.C2, C3 = tri.C3;
+	const s32 DX12 = tri.DX12, DX23 = tri.DX23, DX31 = tri.DX31;
+	const s32 DY12 = tri.DY12, DY23 = tri.DY23, DY31 = tri.DY31;
 
 	// Fixed-pos32 deltas
 	const s32 FDX12 = DX12 << 4;
@@ -357,72 +454,27 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	const s32 FDY23 = DY23 << 4;
 	const s32 FDY31 = DY31 << 4;
 
-	// Bounding rectangle
-	s32 minx = (min(min(X1, X2), X3) + 0xF) >> 4;
-	s32 maxx = (max(max(X1, X2), X3) + 0xF) >> 4;
-	s32 miny = (min(min(Y1, Y2), Y3) + 0xF) >> 4;
-	s32 maxy = (max(max(Y1, Y2), Y3) + 0xF) >> 4;
-
-	// scissor
-	minx = max(minx, scissorLeft);
-	maxx = min(maxx, scissorRight);
-	miny = max(miny, scissorTop);
-	maxy = min(maxy, scissorBottom);
-
-	if (minx >= maxx || miny >= maxy)
-		return;
-
-	// Setup slopes
-	float fltx1 = v0->screenPosition.x;
-	float flty1 = v0->screenPosition.y;
-	float fltdx31 = v2->screenPosition.x - fltx1;
-	float fltdx12 = fltx1 - v1->screenPosition.x;
-	float fltdy12 = flty1 - v1->screenPosition.y;
-	float fltdy31 = v2->screenPosition.y - flty1;
-
-	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
-
-	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
-
-	// TODO: The zfreeze emulation is not quite correct, yet!
-	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
-	// However, the zslope is always guaranteed to be calculated unless all vertices are trivially rejected during clipping!
-	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
-	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
-		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
-
-	for(unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
-	{
-		for(int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
-	}
-
-	for(unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
-	{
-		for(int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
-	}
-
-	// Start in corner of 8x8 block
-	minx &= ~(BLOCK_SIZE - 1);
-	miny &= ~(BLOCK_SIZE - 1);
-
-	// Half-edge constants
-	s32 C1 = DY12 * X1 - DX12 * Y1;
-	s32 C2 = DY23 * X2 - DX23 * Y2;
-	s32 C3 = DY31 * X3 - DX31 * Y3;
-
-	// Correct for fill convention
-	if(DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
-	if(DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
-	if(DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
+	// Rejecting pixels before they get to the depth test only leaves the
+	// performance counters short of them
+	const bool depthTiles = g_SWVideoConfig.bHierarchicalZ && bpmem.zmode.testenable;
 
 	// Loop through blocks
 	for(s32 y = miny; y < maxy; y += BLOCK_SIZE)
 	{
 		for(s32 x = minx; x < maxx; x += BLOCK_SIZE)
 		{
+			// The blocks never cross a depth tile, so the ones of a row that
+			// lie in the same tile are tested together
+			if (depthTiles && (x == minx || x % EfbInterface::DEPTH_TILE_SIZE == 0))
+			{
+				const s32 tileEnd = x | (EfbInterface::DEPTH_TILE_SIZE - 1);
+				if (!ZCompareTile(tri, x, y, min(tileEnd, maxx), y + BLOCK_SIZE - 1))
+				{
+					x = tileEnd + 1 - BLOCK_SIZE;
+					continue;
+				}
+			}
+
 			// Corners of block
 			s32 x0 = x << 4;
 			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
@@ -452,18 +504,12 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 			if(a == 0x0 || b == 0x0 || c == 0x0)
 				continue;
 
-			BuildBlock(x, y);
+			BuildBlock(tri, context.rasterBlock, x, y);
 
 			// Accept whole block when totally covered
 			if(a == 0xF && b == 0xF && c == 0xF)
 			{
-				for(s32 iy = 0; iy < BLOCK_SIZE; iy++)
-				{
-					for(s32 ix = 0; ix < BLOCK_SIZE; ix++)
-					{
-						Draw(x + ix, y + iy, ix, iy);
-					}
-				}
+				Draw(tri, context, x, y, 0xF);
 			}
 			else // Partially covered block
 			{
@@ -471,6 +517,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
 				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
 
+				u32 pixelMask = 0;
 				for(s32 iy = 0; iy < BLOCK_SIZE; iy++)
 				{
 					s32 CX1 = CY1;
@@ -481,7 +528,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 					{
 						if(CX1 > 0 && CX2 > 0 && CX3 > 0)
 						{
-							Draw(x + ix, y + iy, ix, iy);
+							pixelMask |= 1 << (ix + iy * BLOCK_SIZE);
 						}
 
 						CX1 -= FDY12;
@@ -493,10 +540,202 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 					CY2 += FDX23;
 					CY3 += FDX31;
 				}
+
+				Draw(tri, context, x, y, pixelMask);
 			}
 		}
 	}
 }
 
+static bool UseThreads()
+{
+	// the TEV dumps go through buffers that all pixels share
+	return g_SWVideoConfig.bThreadedRasterizer && Common::ThreadPool::GetNumWorkers() > 0 &&
+		!g_SWVideoConfig.bDumpTevStages && !g_SWVideoConfig.bDumpTevTextureFetches;
+}
+
+static void QueueTriangle(const Triangle& tri)
+{
+	const u16 index = (u16)queuedTriangles.size();
+	queuedTriangles.push_back(tri);
+
+	// The last block of a row ends at maxx or one pixel after, which is
+	// still in the same tile because the blocks are aligned
+	for (s32 ty = tri.miny / TILE_SIZE; ty <= (tri.maxy - 1) / TILE_SIZE; ty++)
+	{
+		for (s32 tx = tri.minx / TILE_SIZE; tx <= (tri.maxx - 1) / TILE_SIZE; tx++)
+		{
+			std::vector<u16>& tile = tileTriangles[ty * TILES_X + tx];
+			if (tile.empty())
+				activeTiles.push_back(ty * TILES_X + tx);
+			tile.push_back(index);
+		}
+	}
+
+	if (queuedTriangles.size() == MAX_QUEUED_TRIANGLES)
+		Flush();
+}
+
+static void DrawTile(DrawContext& context, int tile)
+{
+	const s32 left = (tile % TILES_X) * TILE_SIZE;
+	const s32 top = (tile / TILES_X) * TILE_SIZE;
+	const s32 right = min(left + TILE_SIZE, (s32)EFB_WIDTH);
+	const s32 bottom = min(top + TILE_SIZE, (s32)EFB_HEIGHT);
+
+	// Every tile starts out with the TEV registers as the BP writes set them
+	context.tev.CopyRegisters(mainContext.tev);
+
+	for (u16 index : tileTriangles[tile])
+		RasterizeTriangle(queuedTriangles[index], context, left, top, right, bottom);
+}
+
+void Flush()
+{
+	if (queuedTriangles.empty())
+		return;
+
+	const int numContexts = min(Common::ThreadPool::GetNumWorkers() + 1, (int)activeTiles.size());
+	if ((int)threadContexts.size() < numContexts)
+	{
+		// the TEV has pointers into itself, so it can only be set up in place
+		threadContexts.resize(numContexts);
+		for (auto& context : threadContexts)
+			context.tev.Init();
+	}
+
+	// Neighbouring tiles usually cost about the same, so dealing them out
+	// in turns spreads the work evenly enough
+	Common::ThreadPool::ParallelFor(numContexts, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			for (size_t t = i; t < activeTiles.size(); t += numContexts)
+				DrawTile(threadContexts[i], activeTiles[t]);
+		}
+	});
+
+	for (int i = 0; i < numContexts; i++)
+		threadContexts[i].tev.FlushCounters();
+
+	for (int tile : activeTiles)
+		tileTriangles[tile].clear();
+	activeTiles.clear();
+	queuedTriangles.clear();
+}
+
+void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+{
+	INCSTAT(swstats.thisFrame.numTrianglesDrawn);
+
+	if (g_SWVideoConfig.bHwRasterizer)
+	{
+		HwRasterizer::DrawTriangleFrontFace(v0, v1, v2);
+		return;
+	}
+
+	// adapted from http://www.devmaster.net/forums/showthread.php?t=1884
+
+	// 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
+	// could also take floor and adjust -8
+	const s32 Y1 = iround(16.0f * v0->screenPosition[1]) - 9;
+	const s32 Y2 = iround(16.0f * v1->screenPosition[1]) - 9;
+	const s32 Y3 = iround(16.0f * v2->screenPosition[1]) - 9;
+
+	const s32 X1 = iround(16.0f * v0->screenPosition[0]) - 9;
+	const s32 X2 = iround(16.0f * v1->screenPosition[0]) - 9;
+	const s32 X3 = iround(16.0f * v2->screenPosition[0]) - 9;
+
+	// Deltas
+	const s32 DX12 = X1 - X2;
+	const s32 DX23 = X2 - X3;
+	const s32 DX31 = X3 - X1;
+
+	const s32 DY12 = Y1 - Y2;
+	const s32 DY23 = Y2 - Y3;
+	const s32 DY31 = Y3 - Y1;
+
+	// Bounding rectangle
+	s32 minx = (min(min(X1, X2), X3) + 0xF) >> 4;
+	s32 maxx = (max(max(X1, X2), X3) + 0xF) >> 4;
+	s32 miny = (min(min(Y1, Y2), Y3) + 0xF) >> 4;
+	s32 maxy = (max(max(Y1, Y2), Y3) + 0xF) >> 4;
+
+	// scissor
+	minx = max(minx, scissorLeft);
+	maxx = min(maxx, scissorRight);
+	miny = max(miny, scissorTop);
+	maxy = min(maxy, scissorBottom);
+
+	if (minx >= maxx || miny >= maxy)
+		return;
+
+	// Setup slopes
+	float fltx1 = v0->screenPosition.x;
+	float flty1 = v0->screenPosition.y;
+	float fltdx31 = v2->screenPosition.x - fltx1;
+	float fltdx12 = fltx1 - v1->screenPosition.x;
+	float fltdy12 = flty1 - v1->screenPosition.y;
+	float fltdy31 = v2->screenPosition.y - flty1;
+
+	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+
+	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
+	InitSlope(&triangle.WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+
+	// TODO: The zfreeze emulation is not quite correct, yet!
+	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
+	// However, the zslope is always guaranteed to be calculated unless all vertices are trivially rejected during clipping!
+	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
+	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
+		InitSlope(&triangle.ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+
+	for(unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
+	{
+		for(int comp = 0; comp < 4; comp++)
+			InitSlope(&triangle.ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+	}
+
+	for(unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
+	{
+		for(int comp = 0; comp < 3; comp++)
+			InitSlope(&triangle.TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	}
+
+	// Start in corner of 8x8 block
+	triangle.minx = minx & ~(BLOCK_SIZE - 1);
+	triangle.miny = miny & ~(BLOCK_SIZE - 1);
+	triangle.maxx = maxx;
+	triangle.maxy = maxy;
+
+	triangle.DX12 = DX12;
+	triangle.DX23 = DX23;
+	triangle.DX31 = DX31;
+	triangle.DY12 = DY12;
+	triangle.DY23 = DY23;
+	triangle.DY31 = DY31;
+
+	// Half-edge constants
+	triangle.C1 = DY12 * X1 - DX12 * Y1;
+	triangle.C2 = DY23 * X2 - DX23 * Y2;
+	triangle.C3 = DY31 * X3 - DX31 * Y3;
+
+	// Correct for fill convention
+	if(DY12 < 0 || (DY12 == 0 && DX12 > 0)) triangle.C1++;
+	if(DY23 < 0 || (DY23 == 0 && DX23 > 0)) triangle.C2++;
+	if(DY31 < 0 || (DY31 == 0 && DX31 > 0)) triangle.C3++;
+
+	if (UseThreads())
+	{
+		QueueTriangle(triangle);
+	}
+	else
+	{
+		Flush();
+		RasterizeTriangle(triangle, mainContext, 0, 0, EFB_WIDTH, EFB_HEIGHT);
+		mainContext.tev.FlushCounters();
+	}
+}
+
 
 }
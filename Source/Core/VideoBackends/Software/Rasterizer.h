@@ -13,6 +13,11 @@ namespace Rasterizer
 
 	void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2);
 
+	// Draws the triangles that the threaded rasterizer has queued up. Has to
+	// be called before the BP or XF state they are drawn with changes, and
+	// before anything reads the EFB.
+	void Flush();
+
 	void SetScissor();
 
 	void SetTevReg(int reg, int comp, bool konst, s16 color);
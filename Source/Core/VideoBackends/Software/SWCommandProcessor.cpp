@@ -17,6 +17,7 @@
 #include "ChunkFile.h"
 #include "MathUtil.h"
 #include "OpcodeDecoder.h"
+#include "Rasterizer.h"
 
 
 namespace SWCommandProcessor
@@ -121,6 +122,9 @@ void RunGpu()
 			RunBuffer();
 		} while (cpreg.ctrl.GPReadEnable && !AtBreakpoint() && cpreg.readptr != cpreg.writeptr);
 
+		// the CPU may look at the EFB before the GPU runs again
+		Rasterizer::Flush();
+
 		FPURoundMode::LoadSIMDState();
 	}
 }
@@ -148,51 +148,44 @@ namespace SWPixelEngine
 		u16 perfEfbCopyClocksHi;
 
 		// NOTE: hardware doesn't process individual pixels but quads instead. Current software renderer architecture works on pixels though, so we have this "quad" hack here to only increment the registers on every fourth rendered pixel
-		void IncZInputQuadCount(bool early_ztest)
+		void AddZInputQuadCount(u32 pixels, bool early_ztest)
 		{
-			static int quad = 0;
-			if (++quad != 3)
-				return;
-			quad = 0;
+			static u32 quad = 0;
+			u32 quads = CountQuads(quad, pixels);
 
 			if (early_ztest)
-			{
-				if (++perfZcompInputZcomplocLo == 0)
-					perfZcompInputZcomplocHi++;
-			}
+				AddToCounter(perfZcompInputZcomplocLo, perfZcompInputZcomplocHi, quads);
 			else
-			{
-				if (++perfZcompInputLo == 0)
-					perfZcompInputHi++;
-			}
+				AddToCounter(perfZcompInputLo, perfZcompInputHi, quads);
 		}
-		void IncZOutputQuadCount(bool early_ztest)
+		void AddZOutputQuadCount(u32 pixels, bool early_ztest)
 		{
-			static int quad = 0;
-			if (++quad != 3)
-				return;
-			quad = 0;
+			static u32 quad = 0;
+			u32 quads = CountQuads(quad, pixels);
 
 			if (early_ztest)
-			{
-				if (++perfZcompOutputZcomplocLo == 0)
-					perfZcompOutputZcomplocHi++;
-			}
+				AddToCounter(perfZcompOutputZcomplocLo, perfZcompOutputZcomplocHi, quads);
 			else
-			{
-				if (++perfZcompOutputLo == 0)
-					perfZcompOutputHi++;
-			}
+				AddToCounter(perfZcompOutputLo, perfZcompOutputHi, quads);
 		}
-		void IncBlendInputQuadCount()
+		void AddBlendInputQuadCount(u32 pixels)
 		{
-			static int quad = 0;
-			if (++quad != 3)
-				return;
-			quad = 0;
+			static u32 quad = 0;
+			AddToCounter(perfBlendInputLo, perfBlendInputHi, CountQuads(quad, pixels));
+		}
 
-			if (++perfBlendInputLo == 0)
-				perfBlendInputHi++;
+		static u32 CountQuads(u32& quad, u32 pixels)
+		{
+			quad += pixels;
+			u32 quads = quad / 3;
+			quad %= 3;
+			return quads;
+		}
+		static void AddToCounter(u16& lo, u16& hi, u32 value)
+		{
+			u32 counter = ((hi << 16) | lo) + value;
+			lo = (u16)counter;
+			hi = (u16)(counter >> 16);
 		}
 	};
 
@@ -39,6 +39,7 @@ void SWRenderer::Init()
 
 void SWRenderer::Shutdown()
 {
+	FlushImageWrites();
 	delete [] s_xfbColorTexture[0];
 	delete [] s_xfbColorTexture[1];
 	glDeleteProgram(program);
@@ -217,7 +218,7 @@ void SWRenderer::DrawTexture(u8 *texture, int width, int height)
 	if (s_bScreenshot)
 	{
 		std::lock_guard<std::mutex> lk(s_criticalScreenshot);
-		TextureToPng(texture, width*4, s_sScreenshotName, width, height, false);
+		TextureToPngAsync(texture, width*4, s_sScreenshotName, width, height, false);
 		// Reset settings
 		s_sScreenshotName.clear();
 		s_bScreenshot = false;
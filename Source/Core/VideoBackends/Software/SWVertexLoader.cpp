@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common.h"
 
 #include "SWVertexLoader.h"
@@ -249,28 +251,54 @@ void SWVertexLoader::SetFormat(u8 attributeIndex, u8 primitiveType)
 }
 
 
-void SWVertexLoader::LoadVertex()
+void SWVertexLoader::LoadVertices(u32 count)
 {
-	for (int i = 0; i < m_NumAttributeLoaders; i++)
-		m_AttributeLoaders[i].loader(this, &m_Vertex, m_AttributeLoaders[i].index);
+	while (count)
+	{
+		const int batchSize = (int)std::min<u32>(count, TransformUnit::BATCH_SIZE);
+
+		// attributes that aren't in the vertex keep the previous vertex's values
+		for (int i = 0; i < batchSize; i++)
+		{
+			for (int j = 0; j < m_NumAttributeLoaders; j++)
+				m_AttributeLoaders[j].loader(this, &m_Vertex, m_AttributeLoaders[j].index);
+			m_Batch[i] = m_Vertex;
+		}
 
-	OutputVertexData* outVertex = m_SetupUnit->GetVertex();
+		TransformUnit::TransformPositions(m_Batch, batchSize, m_BatchMvPosition, m_BatchProjectedPosition);
 
-	// transform input data
-	TransformUnit::TransformPosition(&m_Vertex, outVertex);
+		const bool hasNormal = g_VtxDesc.Normal != NOT_PRESENT;
+		if (hasNormal)
+			TransformUnit::TransformNormals(m_Batch, batchSize, m_CurrentVat->g0.NormalElements, m_BatchNormal);
 
-	if (g_VtxDesc.Normal != NOT_PRESENT)
-	{
-		TransformUnit::TransformNormal(&m_Vertex, m_CurrentVat->g0.NormalElements, outVertex);
-	}
+		for (int i = 0; i < batchSize; i++)
+		{
+			OutputVertexData* outVertex = m_SetupUnit->GetVertex();
+
+			outVertex->mvPosition = m_BatchMvPosition[i];
+			outVertex->projectedPosition = m_BatchProjectedPosition[i];
+
+			if (hasNormal)
+			{
+				outVertex->normal[0] = m_BatchNormal[i][0];
+				if (m_CurrentVat->g0.NormalElements)
+				{
+					outVertex->normal[1] = m_BatchNormal[i][1];
+					outVertex->normal[2] = m_BatchNormal[i][2];
+				}
+			}
+
+			TransformUnit::TransformColor(&m_Batch[i], outVertex);
 
-	TransformUnit::TransformColor(&m_Vertex, outVertex);
+			TransformUnit::TransformTexCoord(&m_Batch[i], outVertex, m_TexGenSpecialCase);
 
-	TransformUnit::TransformTexCoord(&m_Vertex, outVertex, m_TexGenSpecialCase);
+			m_SetupUnit->SetupVertex();
 
-	m_SetupUnit->SetupVertex();
+			INCSTAT(swstats.thisFrame.numVerticesLoaded)
+		}
 
-	INCSTAT(swstats.thisFrame.numVerticesLoaded)
+		count -= batchSize;
+	}
 }
 
 void SWVertexLoader::AddAttributeLoader(AttributeLoader loader, u8 index)
@@ -9,6 +9,7 @@
 #include "NativeVertexFormat.h"
 #include "CPMemLoader.h"
 #include "ChunkFile.h"
+#include "TransformUnit.h"
 
 class SetupUnit;
 
@@ -25,6 +26,12 @@ class SWVertexLoader
 
 	InputVertexData m_Vertex;
 
+	// the vertices of LoadVertices' current batch
+	InputVertexData m_Batch[TransformUnit::BATCH_SIZE];
+	Vec3 m_BatchMvPosition[TransformUnit::BATCH_SIZE];
+	Vec4 m_BatchProjectedPosition[TransformUnit::BATCH_SIZE];
+	Vec3 m_BatchNormal[TransformUnit::BATCH_SIZE][3];
+
 	typedef void (*AttributeLoader)(SWVertexLoader*, InputVertexData*, u8);
 	struct AttrLoaderCall
 	{
@@ -55,6 +62,8 @@ public:
 
 	u32 GetVertexSize() { return m_VertexSize; }
 
-	void LoadVertex();
+	// Loads count vertices, the transform unit works on several of them
+	// at once
+	void LoadVertices(u32 count);
 	void DoState(PointerWrap &p);
 };
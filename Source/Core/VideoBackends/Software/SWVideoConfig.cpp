@@ -15,6 +15,8 @@ SWVideoConfig::SWVideoConfig()
 	renderToMainframe = false;
 
 	bHwRasterizer = false;
+	bThreadedRasterizer = false;
+	bHierarchicalZ = false;
 	bBypassXFB = false;
 
 	bShowStats = false;
@@ -42,6 +44,8 @@ void SWVideoConfig::Load(const char* ini_file)
 	iniFile.Get("Hardware", "RenderToMainframe", &renderToMainframe, false);
 
 	iniFile.Get("Rendering", "HwRasterizer", &bHwRasterizer, false);
+	iniFile.Get("Rendering", "ThreadedRasterizer", &bThreadedRasterizer, false);
+	iniFile.Get("Rendering", "HierarchicalZ", &bHierarchicalZ, false);
 	iniFile.Get("Rendering", "BypassXFB", &bBypassXFB, false);
 	iniFile.Get("Rendering", "ZComploc", &bZComploc, true);
 	iniFile.Get("Rendering", "ZFreeze", &bZFreeze, true);
@@ -67,6 +71,8 @@ void SWVideoConfig::Save(const char* ini_file)
 	iniFile.Set("Hardware", "RenderToMainframe", renderToMainframe);
 
 	iniFile.Set("Rendering", "HwRasterizer", bHwRasterizer);
+	iniFile.Set("Rendering", "ThreadedRasterizer", bThreadedRasterizer);
+	iniFile.Set("Rendering", "HierarchicalZ", bHierarchicalZ);
 	iniFile.Set("Rendering", "BypassXFB", bBypassXFB);
 	iniFile.Set("Rendering", "ZComploc", bZComploc);
 	iniFile.Set("Rendering", "ZFreeze", bZFreeze);
@@ -21,6 +21,8 @@ struct SWVideoConfig : NonCopyable
 	bool renderToMainframe;
 
 	bool bHwRasterizer;
+	bool bThreadedRasterizer;
+	bool bHierarchicalZ;
 	bool bBypassXFB;
 
 	// Emulation features
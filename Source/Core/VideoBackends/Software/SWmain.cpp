@@ -51,6 +51,7 @@ namespace SW
 
 static volatile bool fifoStateRun = false;
 static volatile bool emuRunningState = false;
+static volatile bool s_presenting = true;
 static std::mutex m_csSWVidOccupied;
 
 std::string VideoSoftware::GetName()
@@ -105,6 +106,8 @@ void VideoSoftware::DoState(PointerWrap& p)
 		// change mode to abort load of incompatible save state.
 		p.SetMode(PointerWrap::MODE_VERIFY);
 
+	Rasterizer::Flush();
+
 	// TODO: incomplete?
 	SWCommandProcessor::DoState(p);
 	SWPixelEngine::DoState(p);
@@ -213,7 +216,7 @@ void VideoSoftware::Video_EndField()
 	// BeginField and EndFeild, We could possibly get away with copying out the whole thing
 	// at BeginField for less lag, but for the safest emulation we run it here.
 
-	if (g_bSkipCurrentFrame || s_beginFieldArgs.xfbAddr == 0 ) {
+	if (g_bSkipCurrentFrame || !s_presenting || s_beginFieldArgs.xfbAddr == 0 ) {
 		swstats.frameCount++;
 		swstats.ResetFrame();
 		Core::Callback_VideoCopiedToXFB(false);
@@ -307,11 +310,14 @@ void VideoSoftware::Video_EnterLoop()
 
 		if (!SWCommandProcessor::RunBuffer())
 		{
+			// the fifo is empty, so don't keep the CPU waiting on queued triangles
+			Rasterizer::Flush();
 			Common::YieldCPU();
 		}
 
 		while (!emuRunningState && fifoStateRun)
 		{
+			Rasterizer::Flush();
 			g_video_backend->PeekMessages();
 			VideoFifo_CheckSwapRequest();
 			m_csSWVidOccupied.unlock();
@@ -340,6 +346,11 @@ void VideoSoftware::Video_SetRendering(bool bEnabled)
 	SWCommandProcessor::SetRendering(bEnabled);
 }
 
+void VideoSoftware::Video_SetPresenting(bool bEnabled)
+{
+	s_presenting = bEnabled;
+}
+
 void VideoSoftware::Video_GatherPipeBursted()
 {
 	SWCommandProcessor::GatherPipeBursted();
@@ -13,8 +13,17 @@
 #include "SWVideoConfig.h"
 #include "DebugUtil.h"
 
+#include <algorithm>
 #include <cmath>
 
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#include <emmintrin.h>
+#define TEV_SIMD_SSE2
+#elif defined(_M_ARM) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TEV_SIMD_NEON
+#endif
+
 #ifdef _DEBUG
 #define ALLOW_TEV_DUMPS 1
 #else
@@ -23,35 +32,43 @@
 
 void Tev::Init()
 {
-	FixedConstants[0] = 0;
-	FixedConstants[1] = 31;
-	FixedConstants[2] = 63;
-	FixedConstants[3] = 95;
-	FixedConstants[4] = 127;
-	FixedConstants[5] = 159;
-	FixedConstants[6] = 191;
-	FixedConstants[7] = 223;
-	FixedConstants[8] = 255;
-
-	for (int i = 0; i < 4; i++)
-		Zero16[i] = 0;
-
-	m_ColorInputLUT[0][RED_INP] = &Reg[0][RED_C]; m_ColorInputLUT[0][GRN_INP] = &Reg[0][GRN_C]; m_ColorInputLUT[0][BLU_INP] = &Reg[0][BLU_C]; // prev.rgb
-	m_ColorInputLUT[1][RED_INP] = &Reg[0][ALP_C]; m_ColorInputLUT[1][GRN_INP] = &Reg[0][ALP_C]; m_ColorInputLUT[1][BLU_INP] = &Reg[0][ALP_C]; // prev.aaa
-	m_ColorInputLUT[2][RED_INP] = &Reg[1][RED_C]; m_ColorInputLUT[2][GRN_INP] = &Reg[1][GRN_C]; m_ColorInputLUT[2][BLU_INP] = &Reg[1][BLU_C]; // c0.rgb
-	m_ColorInputLUT[3][RED_INP] = &Reg[1][ALP_C]; m_ColorInputLUT[3][GRN_INP] = &Reg[1][ALP_C]; m_ColorInputLUT[3][BLU_INP] = &Reg[1][ALP_C]; // c0.aaa
-	m_ColorInputLUT[4][RED_INP] = &Reg[2][RED_C]; m_ColorInputLUT[4][GRN_INP] = &Reg[2][GRN_C]; m_ColorInputLUT[4][BLU_INP] = &Reg[2][BLU_C]; // c1.rgb
-	m_ColorInputLUT[5][RED_INP] = &Reg[2][ALP_C]; m_ColorInputLUT[5][GRN_INP] = &Reg[2][ALP_C]; m_ColorInputLUT[5][BLU_INP] = &Reg[2][ALP_C]; // c1.aaa
-	m_ColorInputLUT[6][RED_INP] = &Reg[3][RED_C]; m_ColorInputLUT[6][GRN_INP] = &Reg[3][GRN_C]; m_ColorInputLUT[6][BLU_INP] = &Reg[3][BLU_C]; // c2.rgb
-	m_ColorInputLUT[7][RED_INP] = &Reg[3][ALP_C]; m_ColorInputLUT[7][GRN_INP] = &Reg[3][ALP_C]; m_ColorInputLUT[7][BLU_INP] = &Reg[3][ALP_C]; // c2.aaa
-	m_ColorInputLUT[8][RED_INP] = &TexColor[RED_C]; m_ColorInputLUT[8][GRN_INP] = &TexColor[GRN_C]; m_ColorInputLUT[8][BLU_INP] = &TexColor[BLU_C]; // tex.rgb
-	m_ColorInputLUT[9][RED_INP] = &TexColor[ALP_C]; m_ColorInputLUT[9][GRN_INP] = &TexColor[ALP_C]; m_ColorInputLUT[9][BLU_INP] = &TexColor[ALP_C]; // tex.aaa
-	m_ColorInputLUT[10][RED_INP] = &RasColor[RED_C]; m_ColorInputLUT[10][GRN_INP] = &RasColor[GRN_C]; m_ColorInputLUT[10][BLU_INP] = &RasColor[BLU_C]; // ras.rgb
-	m_ColorInputLUT[11][RED_INP] = &RasColor[ALP_C]; m_ColorInputLUT[11][GRN_INP] = &RasColor[ALP_C]; m_ColorInputLUT[11][BLU_INP] = &RasColor[ALP_C]; // ras.rgb
-	m_ColorInputLUT[12][RED_INP] = &FixedConstants[8]; m_ColorInputLUT[12][GRN_INP] = &FixedConstants[8]; m_ColorInputLUT[12][BLU_INP] = &FixedConstants[8]; // one
-	m_ColorInputLUT[13][RED_INP] = &FixedConstants[4]; m_ColorInputLUT[13][GRN_INP] = &FixedConstants[4]; m_ColorInputLUT[13][BLU_INP] = &FixedConstants[4]; // half
-	m_ColorInputLUT[14][RED_INP] = &StageKonst[RED_C]; m_ColorInputLUT[14][GRN_INP] = &StageKonst[GRN_C]; m_ColorInputLUT[14][BLU_INP] = &StageKonst[BLU_C]; // konst
-	m_ColorInputLUT[15][RED_INP] = &FixedConstants[0]; m_ColorInputLUT[15][GRN_INP] = &FixedConstants[0]; m_ColorInputLUT[15][BLU_INP] = &FixedConstants[0]; // zero
+	memset(TexColor, 0, sizeof(TexColor));
+	memset(RasColor, 0, sizeof(RasColor));
+	memset(StageKonst, 0, sizeof(StageKonst));
+	memset(Zero16, 0, sizeof(Zero16));
+	memset(AlphaBump, 0, sizeof(AlphaBump));
+	memset(IndirectTex, 0, sizeof(IndirectTex));
+	memset(TexCoord, 0, sizeof(TexCoord));
+
+	for (int i = 0; i < QUAD_SIZE; i++)
+	{
+		FixedConstants[0][i] = 0;
+		FixedConstants[1][i] = 31;
+		FixedConstants[2][i] = 63;
+		FixedConstants[3][i] = 95;
+		FixedConstants[4][i] = 127;
+		FixedConstants[5][i] = 159;
+		FixedConstants[6][i] = 191;
+		FixedConstants[7][i] = 223;
+		FixedConstants[8][i] = 255;
+	}
+
+	m_ColorInputLUT[0][RED_INP] = Reg[0][RED_C]; m_ColorInputLUT[0][GRN_INP] = Reg[0][GRN_C]; m_ColorInputLUT[0][BLU_INP] = Reg[0][BLU_C]; // prev.rgb
+	m_ColorInputLUT[1][RED_INP] = Reg[0][ALP_C]; m_ColorInputLUT[1][GRN_INP] = Reg[0][ALP_C]; m_ColorInputLUT[1][BLU_INP] = Reg[0][ALP_C]; // prev.aaa
+	m_ColorInputLUT[2][RED_INP] = Reg[1][RED_C]; m_ColorInputLUT[2][GRN_INP] = Reg[1][GRN_C]; m_ColorInputLUT[2][BLU_INP] = Reg[1][BLU_C]; // c0.rgb
+	m_ColorInputLUT[3][RED_INP] = Reg[1][ALP_C]; m_ColorInputLUT[3][GRN_INP] = Reg[1][ALP_C]; m_ColorInputLUT[3][BLU_INP] = Reg[1][ALP_C]; // c0.aaa
+	m_ColorInputLUT[4][RED_INP] = Reg[2][RED_C]; m_ColorInputLUT[4][GRN_INP] = Reg[2][GRN_C]; m_ColorInputLUT[4][BLU_INP] = Reg[2][BLU_C]; // c1.rgb
+	m_ColorInputLUT[5][RED_INP] = Reg[2][ALP_C]; m_ColorInputLUT[5][GRN_INP] = Reg[2][ALP_C]; m_ColorInputLUT[5][BLU_INP] = Reg[2][ALP_C]; // c1.aaa
+	m_ColorInputLUT[6][RED_INP] = Reg[3][RED_C]; m_ColorInputLUT[6][GRN_INP] = Reg[3][GRN_C]; m_ColorInputLUT[6][BLU_INP] = Reg[3][BLU_C]; // c2.rgb
+	m_ColorInputLUT[7][RED_INP] = Reg[3][ALP_C]; m_ColorInputLUT[7][GRN_INP] = Reg[3][ALP_C]; m_ColorInputLUT[7][BLU_INP] = Reg[3][ALP_C]; // c2.aaa
+	m_ColorInputLUT[8][RED_INP] = TexColor[RED_C]; m_ColorInputLUT[8][GRN_INP] = TexColor[GRN_C]; m_ColorInputLUT[8][BLU_INP] = TexColor[BLU_C]; // tex.rgb
+	m_ColorInputLUT[9][RED_INP] = TexColor[ALP_C]; m_ColorInputLUT[9][GRN_INP] = TexColor[ALP_C]; m_ColorInputLUT[9][BLU_INP] = TexColor[ALP_C]; // tex.aaa
+	m_ColorInputLUT[10][RED_INP] = RasColor[RED_C]; m_ColorInputLUT[10][GRN_INP] = RasColor[GRN_C]; m_ColorInputLUT[10][BLU_INP] = RasColor[BLU_C]; // ras.rgb
+	m_ColorInputLUT[11][RED_INP] = RasColor[ALP_C]; m_ColorInputLUT[11][GRN_INP] = RasColor[ALP_C]; m_ColorInputLUT[11][BLU_INP] = RasColor[ALP_C]; // ras.rgb
+	m_ColorInputLUT[12][RED_INP] = FixedConstants[8]; m_ColorInputLUT[12][GRN_INP] = FixedConstants[8]; m_ColorInputLUT[12][BLU_INP] = FixedConstants[8]; // one
+	m_ColorInputLUT[13][RED_INP] = FixedConstants[4]; m_ColorInputLUT[13][GRN_INP] = FixedConstants[4]; m_ColorInputLUT[13][BLU_INP] = FixedConstants[4]; // half
+	m_ColorInputLUT[14][RED_INP] = StageKonst[RED_C]; m_ColorInputLUT[14][GRN_INP] = StageKonst[GRN_C]; m_ColorInputLUT[14][BLU_INP] = StageKonst[BLU_C]; // konst
+	m_ColorInputLUT[15][RED_INP] = FixedConstants[0]; m_ColorInputLUT[15][GRN_INP] = FixedConstants[0]; m_ColorInputLUT[15][BLU_INP] = FixedConstants[0]; // zero
 
 	m_AlphaInputLUT[0] = Reg[0]; // prev
 	m_AlphaInputLUT[1] = Reg[1]; // c0
@@ -64,14 +81,14 @@ void Tev::Init()
 
 	for (int comp = 0; comp < 4; comp++)
 	{
-		m_KonstLUT[0][comp] = &FixedConstants[8];
-		m_KonstLUT[1][comp] = &FixedConstants[7];
-		m_KonstLUT[2][comp] = &FixedConstants[6];
-		m_KonstLUT[3][comp] = &FixedConstants[5];
-		m_KonstLUT[4][comp] = &FixedConstants[4];
-		m_KonstLUT[5][comp] = &FixedConstants[3];
-		m_KonstLUT[6][comp] = &FixedConstants[2];
-		m_KonstLUT[7][comp] = &FixedConstants[1];
+		m_KonstLUT[0][comp] = FixedConstants[8];
+		m_KonstLUT[1][comp] = FixedConstants[7];
+		m_KonstLUT[2][comp] = FixedConstants[6];
+		m_KonstLUT[3][comp] = FixedConstants[5];
+		m_KonstLUT[4][comp] = FixedConstants[4];
+		m_KonstLUT[5][comp] = FixedConstants[3];
+		m_KonstLUT[6][comp] = FixedConstants[2];
+		m_KonstLUT[7][comp] = FixedConstants[1];
 
 		m_KonstLUT[12][comp] = &KonstantColors[0][comp];
 		m_KonstLUT[13][comp] = &KonstantColors[1][comp];
@@ -110,16 +127,91 @@ void Tev::Init()
 	m_ScaleRShiftLUT[1] = 0;
 	m_ScaleRShiftLUT[2] = 0;
 	m_ScaleRShiftLUT[3] = 1;
+
+	memset(&Counts, 0, sizeof(Counts));
+	Counts.boxLeft = Counts.boxTop = 0xFFFF;
 }
 
-inline s16 Clamp255(s16 in)
+// The regular combiner, d + lerp(a, b, c) with bias and scale, for the four
+// pixels of a quad. The products fit unsigned 16 bits and the results
+// signed 16 bits, so all of it can be done in 16 bit lanes.
+static inline void CombineRegular(s16 *dest, const s16 *a, const s16 *b, const s16 *c, const s16 *d,
+	bool op, s16 bias, int lshift, int rshift)
 {
-	return in>255?255:(in<0?0:in);
+#if defined(TEV_SIMD_SSE2)
+	const __m128i mask8 = _mm_set1_epi16(0xff);
+	__m128i va = _mm_and_si128(_mm_loadl_epi64((const __m128i*)a), mask8);
+	__m128i vb = _mm_and_si128(_mm_loadl_epi64((const __m128i*)b), mask8);
+	__m128i vc = _mm_and_si128(_mm_loadl_epi64((const __m128i*)c), mask8);
+	// d is a signed 11 bit input
+	__m128i vd = _mm_srai_epi16(_mm_slli_epi16(_mm_loadl_epi64((const __m128i*)d), 5), 5);
+
+	vc = _mm_add_epi16(vc, _mm_srli_epi16(vc, 7));
+	__m128i temp = _mm_add_epi16(_mm_mullo_epi16(va, _mm_sub_epi16(_mm_set1_epi16(256), vc)), _mm_mullo_epi16(vb, vc));
+	// -temp >> 8 rounds towards minus infinity, which is -((temp + 255) >> 8)
+	if (op)
+		temp = _mm_sub_epi16(_mm_setzero_si128(), _mm_srli_epi16(_mm_add_epi16(temp, _mm_set1_epi16(255)), 8));
+	else
+		temp = _mm_srli_epi16(temp, 8);
+
+	__m128i result = _mm_add_epi16(_mm_add_epi16(vd, temp), _mm_set1_epi16(bias));
+	result = _mm_sll_epi16(result, _mm_cvtsi32_si128(lshift));
+	result = _mm_sra_epi16(result, _mm_cvtsi32_si128(rshift));
+	_mm_storel_epi64((__m128i*)dest, result);
+#elif defined(TEV_SIMD_NEON)
+	const int16x4_t mask8 = vdup_n_s16(0xff);
+	uint16x4_t va = vreinterpret_u16_s16(vand_s16(vld1_s16(a), mask8));
+	uint16x4_t vb = vreinterpret_u16_s16(vand_s16(vld1_s16(b), mask8));
+	uint16x4_t vc = vreinterpret_u16_s16(vand_s16(vld1_s16(c), mask8));
+	int16x4_t vd = vshr_n_s16(vshl_n_s16(vld1_s16(d), 5), 5);
+
+	vc = vadd_u16(vc, vshr_n_u16(vc, 7));
+	uint16x4_t utemp = vmla_u16(vmul_u16(va, vsub_u16(vdup_n_u16(256), vc)), vb, vc);
+	int16x4_t temp;
+	if (op)
+		temp = vneg_s16(vreinterpret_s16_u16(vshr_n_u16(vadd_u16(utemp, vdup_n_u16(255)), 8)));
+	else
+		temp = vreinterpret_s16_u16(vshr_n_u16(utemp, 8));
+
+	int16x4_t result = vadd_s16(vadd_s16(vd, temp), vdup_n_s16(bias));
+	result = vshl_s16(result, vdup_n_s16(lshift));
+	result = vshl_s16(result, vdup_n_s16(-rshift));
+	vst1_s16(dest, result);
+#else
+	for (int i = 0; i < Tev::QUAD_SIZE; i++)
+	{
+		unsigned int ia = a[i] & 0xff, ib = b[i] & 0xff, ic = c[i] & 0xff;
+		s32 id = (s16)(d[i] << 5) >> 5;
+
+		u16 cc = ic + (ic >> 7);
+
+		s32 temp = ia * (256 - cc) + (ib * cc);
+		temp = op?(-temp >> 8):(temp >> 8);
+
+		s32 result = id + temp + bias;
+		result = result << lshift;
+		result = result >> rshift;
+
+		dest[i] = result;
+	}
+#endif
 }
 
-inline s16 Clamp1024(s16 in)
+// Clamps the four pixels of a component to 0..255 or -1024..1023
+static inline void ClampComponent(s16 *comp, bool clamp)
 {
-	return in>1023?1023:(in<-1024?-1024:in);
+	const s16 low = clamp ? 0 : -1024;
+	const s16 high = clamp ? 255 : 1023;
+#if defined(TEV_SIMD_SSE2)
+	__m128i value = _mm_loadl_epi64((const __m128i*)comp);
+	value = _mm_min_epi16(_mm_max_epi16(value, _mm_set1_epi16(low)), _mm_set1_epi16(high));
+	_mm_storel_epi64((__m128i*)comp, value);
+#elif defined(TEV_SIMD_NEON)
+	vst1_s16(comp, vmin_s16(vmax_s16(vld1_s16(comp), vdup_n_s16(low)), vdup_n_s16(high)));
+#else
+	for (int i = 0; i < Tev::QUAD_SIZE; i++)
+		comp[i] = comp[i]>high?high:(comp[i]<low?low:comp[i]);
+#endif
 }
 
 void Tev::SetRasColor(int colorChan, int swaptable)
@@ -127,42 +219,42 @@ void Tev::SetRasColor(int colorChan, int swaptable)
 	switch(colorChan)
 	{
 	case 0: // Color0
-		{
-			u8 *color = Color[0];
-			RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-			RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
-			swaptable++;
-			RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-			RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
-		}
-		break;
 	case 1: // Color1
 		{
-			u8 *color = Color[1];
-			RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-			RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
-			swaptable++;
-			RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-			RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+			const int swapRed = bpmem.tevksel[swaptable].swap1;
+			const int swapGreen = bpmem.tevksel[swaptable].swap2;
+			const int swapBlue = bpmem.tevksel[swaptable + 1].swap1;
+			const int swapAlpha = bpmem.tevksel[swaptable + 1].swap2;
+			for (int i = 0; i < QUAD_SIZE; i++)
+			{
+				u8 *color = Color[i][colorChan];
+				RasColor[RED_C][i] = color[swapRed];
+				RasColor[GRN_C][i] = color[swapGreen];
+				RasColor[BLU_C][i] = color[swapBlue];
+				RasColor[ALP_C][i] = color[swapAlpha];
+			}
 		}
 		break;
 		case 5: // alpha bump
 		{
-			for(int i = 0; i < 4; i++)
-				RasColor[i] = AlphaBump;
+			for(int comp = 0; comp < 4; comp++)
+				for(int i = 0; i < QUAD_SIZE; i++)
+					RasColor[comp][i] = AlphaBump[i];
 		}
 		break;
 	case 6: // alpha bump normalized
 		{
-			u8 normalized = AlphaBump | AlphaBump >> 5;
-			for(int i = 0; i < 4; i++)
-				RasColor[i] = normalized;
+			for(int i = 0; i < QUAD_SIZE; i++)
+			{
+				u8 normalized = AlphaBump[i] | AlphaBump[i] >> 5;
+				for(int comp = 0; comp < 4; comp++)
+					RasColor[comp][i] = normalized;
+			}
 		}
 		break;
 	default: // zero
 		{
-			for(int i = 0; i < 4; i++)
-				RasColor[i] = 0;
+			memset(RasColor, 0, sizeof(RasColor));
 		}
 		break;
 	}
@@ -170,25 +262,11 @@ void Tev::SetRasColor(int colorChan, int swaptable)
 
 void Tev::DrawColorRegular(TevStageCombiner::ColorCombiner &cc)
 {
-	InputRegType InputReg;
-
 	for (int i = 0; i < 3; i++)
 	{
-		InputReg.a = *m_ColorInputLUT[cc.a][i];
-		InputReg.b = *m_ColorInputLUT[cc.b][i];
-		InputReg.c = *m_ColorInputLUT[cc.c][i];
-		InputReg.d = *m_ColorInputLUT[cc.d][i];
-
-		u16 c = InputReg.c + (InputReg.c >> 7);
-
-		s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-		temp = cc.op?(-temp >> 8):(temp >> 8);
-
-		s32 result = InputReg.d + temp + m_BiasLUT[cc.bias];
-		result = result << m_ScaleLShiftLUT[cc.shift];
-		result = result >> m_ScaleRShiftLUT[cc.shift];
-
-		Reg[cc.dest][BLU_C + i] = result;
+		CombineRegular(Reg[cc.dest][BLU_C + i], m_ColorInputLUT[cc.a][i], m_ColorInputLUT[cc.b][i],
+			m_ColorInputLUT[cc.c][i], m_ColorInputLUT[cc.d][i],
+			cc.op, m_BiasLUT[cc.bias], m_ScaleLShiftLUT[cc.shift], m_ScaleRShiftLUT[cc.shift]);
 	}
 }
 
@@ -201,122 +279,111 @@ void Tev::DrawColorCompare(TevStageCombiner::ColorCombiner &cc)
 
 	InputRegType InputReg;
 
-	switch(cmp) {
-	case TEVCMP_R8_GT:
-		{
-			a = *m_ColorInputLUT[cc.a][RED_INP] & 0xff;
-			b = *m_ColorInputLUT[cc.b][RED_INP] & 0xff;
-			for (int i = 0; i < 3; i++)
+	for (int pixel = 0; pixel < QUAD_SIZE; pixel++)
+	{
+		switch(cmp) {
+		case TEVCMP_R8_GT:
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				a = m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff;
+				b = m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff;
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				}
 			}
-		}
-		break;
+			break;
 
-	case TEVCMP_R8_EQ:
-		{
-			a = *m_ColorInputLUT[cc.a][RED_INP] & 0xff;
-			b = *m_ColorInputLUT[cc.b][RED_INP] & 0xff;
-			for (int i = 0; i < 3; i++)
+		case TEVCMP_R8_EQ:
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				a = m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff;
+				b = m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff;
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				}
 			}
-		}
-		break;
-	case TEVCMP_GR16_GT:
-		{
-			a = ((*m_ColorInputLUT[cc.a][GRN_INP] & 0xff) << 8) | (*m_ColorInputLUT[cc.a][RED_INP] & 0xff);
-			b = ((*m_ColorInputLUT[cc.b][GRN_INP] & 0xff) << 8) | (*m_ColorInputLUT[cc.b][RED_INP] & 0xff);
-			for (int i = 0; i < 3; i++)
+			break;
+		case TEVCMP_GR16_GT:
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				a = ((m_ColorInputLUT[cc.a][GRN_INP][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff);
+				b = ((m_ColorInputLUT[cc.b][GRN_INP][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff);
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				}
 			}
-		}
-		break;
-	case TEVCMP_GR16_EQ:
-		{
-			a = ((*m_ColorInputLUT[cc.a][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.a][RED_INP] & 0xff);
-			b = ((*m_ColorInputLUT[cc.b][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.b][RED_INP] & 0xff);
-			for (int i = 0; i < 3; i++)
+			break;
+		case TEVCMP_GR16_EQ:
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				a = ((m_ColorInputLUT[cc.a][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff);
+				b = ((m_ColorInputLUT[cc.b][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff);
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				}
 			}
-		}
-		break;
-	case TEVCMP_BGR24_GT:
-		{
-			a = ((*m_ColorInputLUT[cc.a][BLU_C] & 0xff) << 16) | ((*m_ColorInputLUT[cc.a][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.a][RED_INP] & 0xff);
-			b = ((*m_ColorInputLUT[cc.b][BLU_C] & 0xff) << 16) | ((*m_ColorInputLUT[cc.b][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.b][RED_INP] & 0xff);
+			break;
+		case TEVCMP_BGR24_GT:
+			{
+				a = ((m_ColorInputLUT[cc.a][BLU_C][pixel] & 0xff) << 16) | ((m_ColorInputLUT[cc.a][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff);
+				b = ((m_ColorInputLUT[cc.b][BLU_C][pixel] & 0xff) << 16) | ((m_ColorInputLUT[cc.b][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff);
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				}
+			}
+			break;
+		case TEVCMP_BGR24_EQ:
+			{
+				a = ((m_ColorInputLUT[cc.a][BLU_C][pixel] & 0xff) << 16) | ((m_ColorInputLUT[cc.a][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.a][RED_INP][pixel] & 0xff);
+				b = ((m_ColorInputLUT[cc.b][BLU_C][pixel] & 0xff) << 16) | ((m_ColorInputLUT[cc.b][GRN_C][pixel] & 0xff) << 8) | (m_ColorInputLUT[cc.b][RED_INP][pixel] & 0xff);
+				for (int i = 0; i < 3; i++)
+				{
+					InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+					InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+					Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				}
+			}
+			break;
+		case TEVCMP_RGB8_GT:
 			for (int i = 0; i < 3; i++)
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a > b) ? InputReg.c : 0);
+				InputReg.a = m_ColorInputLUT[cc.a][i][pixel];
+				InputReg.b = m_ColorInputLUT[cc.b][i][pixel];
+				InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+				InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+				Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((InputReg.a > InputReg.b) ? InputReg.c : 0);
 			}
-		}
-		break;
-	case TEVCMP_BGR24_EQ:
-		{
-			a = ((*m_ColorInputLUT[cc.a][BLU_C] & 0xff) << 16) | ((*m_ColorInputLUT[cc.a][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.a][RED_INP] & 0xff);
-			b = ((*m_ColorInputLUT[cc.b][BLU_C] & 0xff) << 16) | ((*m_ColorInputLUT[cc.b][GRN_C] & 0xff) << 8) | (*m_ColorInputLUT[cc.b][RED_INP] & 0xff);
+			break;
+		case TEVCMP_RGB8_EQ:
 			for (int i = 0; i < 3; i++)
 			{
-				InputReg.c = *m_ColorInputLUT[cc.c][i];
-				InputReg.d = *m_ColorInputLUT[cc.d][i];
-				Reg[cc.dest][BLU_C + i] = InputReg.d + ((a == b) ? InputReg.c : 0);
+				InputReg.a = m_ColorInputLUT[cc.a][i][pixel];
+				InputReg.b = m_ColorInputLUT[cc.b][i][pixel];
+				InputReg.c = m_ColorInputLUT[cc.c][i][pixel];
+				InputReg.d = m_ColorInputLUT[cc.d][i][pixel];
+				Reg[cc.dest][BLU_C + i][pixel] = InputReg.d + ((InputReg.a == InputReg.b) ? InputReg.c : 0);
 			}
+			break;
 		}
-		break;
-	case TEVCMP_RGB8_GT:
-		for (int i = 0; i < 3; i++)
-		{
-			InputReg.a = *m_ColorInputLUT[cc.a][i];
-			InputReg.b = *m_ColorInputLUT[cc.b][i];
-			InputReg.c = *m_ColorInputLUT[cc.c][i];
-			InputReg.d = *m_ColorInputLUT[cc.d][i];
-			Reg[cc.dest][BLU_C + i] = InputReg.d + ((InputReg.a > InputReg.b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_RGB8_EQ:
-		for (int i = 0; i < 3; i++)
-		{
-			InputReg.a = *m_ColorInputLUT[cc.a][i];
-			InputReg.b = *m_ColorInputLUT[cc.b][i];
-			InputReg.c = *m_ColorInputLUT[cc.c][i];
-			InputReg.d = *m_ColorInputLUT[cc.d][i];
-			Reg[cc.dest][BLU_C + i] = InputReg.d + ((InputReg.a == InputReg.b) ? InputReg.c : 0);
-		}
-		break;
 	}
 }
 
 void Tev::DrawAlphaRegular(TevStageCombiner::AlphaCombiner &ac)
 {
-	InputRegType InputReg;
-
-	InputReg.a = m_AlphaInputLUT[ac.a][ALP_C];
-	InputReg.b = m_AlphaInputLUT[ac.b][ALP_C];
-	InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-	InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-
-	u16 c = InputReg.c + (InputReg.c >> 7);
-
-	s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-	temp = ac.op?(-temp >> 8):(temp >> 8);
-
-	s32 result = InputReg.d + temp + m_BiasLUT[ac.bias];
-	result = result << m_ScaleLShiftLUT[ac.shift];
-	result = result >> m_ScaleRShiftLUT[ac.shift];
-
-	Reg[ac.dest][ALP_C] = result;
+	CombineRegular(Reg[ac.dest][ALP_C], m_AlphaInputLUT[ac.a][ALP_C], m_AlphaInputLUT[ac.b][ALP_C],
+		m_AlphaInputLUT[ac.c][ALP_C], m_AlphaInputLUT[ac.d][ALP_C],
+		ac.op, m_BiasLUT[ac.bias], m_ScaleLShiftLUT[ac.shift], m_ScaleRShiftLUT[ac.shift]);
 }
 
 void Tev::DrawAlphaCompare(TevStageCombiner::AlphaCombiner &ac)
@@ -328,80 +395,83 @@ void Tev::DrawAlphaCompare(TevStageCombiner::AlphaCombiner &ac)
 
 	InputRegType InputReg;
 
-	switch(cmp) {
-	case TEVCMP_R8_GT:
-		{
-			a = m_AlphaInputLUT[ac.a][RED_C] & 0xff;
-			b = m_AlphaInputLUT[ac.b][RED_C] & 0xff;
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a > b) ? InputReg.c : 0);
-		}
-		break;
+	for (int pixel = 0; pixel < QUAD_SIZE; pixel++)
+	{
+		switch(cmp) {
+		case TEVCMP_R8_GT:
+			{
+				a = m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff;
+				b = m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff;
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+			}
+			break;
 
-	case TEVCMP_R8_EQ:
-		{
-			a = m_AlphaInputLUT[ac.a][RED_C] & 0xff;
-			b = m_AlphaInputLUT[ac.b][RED_C] & 0xff;
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a == b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_GR16_GT:
-		{
-			a = ((m_AlphaInputLUT[ac.a][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C] & 0xff);
-			b = ((m_AlphaInputLUT[ac.b][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C] & 0xff);
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a > b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_GR16_EQ:
-		{
-			a = ((m_AlphaInputLUT[ac.a][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C] & 0xff);
-			b = ((m_AlphaInputLUT[ac.b][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C] & 0xff);
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a == b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_BGR24_GT:
-		{
-			a = ((m_AlphaInputLUT[ac.a][BLU_C] & 0xff) << 16) | ((m_AlphaInputLUT[ac.a][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C] & 0xff);
-			b = ((m_AlphaInputLUT[ac.b][BLU_C] & 0xff) << 16) | ((m_AlphaInputLUT[ac.b][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C] & 0xff);
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a > b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_BGR24_EQ:
-		{
-			a = ((m_AlphaInputLUT[ac.a][BLU_C] & 0xff) << 16) | ((m_AlphaInputLUT[ac.a][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C] & 0xff);
-			b = ((m_AlphaInputLUT[ac.b][BLU_C] & 0xff) << 16) | ((m_AlphaInputLUT[ac.b][GRN_C] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C] & 0xff);
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((a == b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_A8_GT:
-		{
-			InputReg.a = m_AlphaInputLUT[ac.a][ALP_C];
-			InputReg.b = m_AlphaInputLUT[ac.b][ALP_C];
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((InputReg.a > InputReg.b) ? InputReg.c : 0);
-		}
-		break;
-	case TEVCMP_A8_EQ:
-		{
-			InputReg.a = m_AlphaInputLUT[ac.a][ALP_C];
-			InputReg.b = m_AlphaInputLUT[ac.b][ALP_C];
-			InputReg.c = m_AlphaInputLUT[ac.c][ALP_C];
-			InputReg.d = m_AlphaInputLUT[ac.d][ALP_C];
-			Reg[ac.dest][ALP_C] = InputReg.d + ((InputReg.a == InputReg.b) ? InputReg.c : 0);
+		case TEVCMP_R8_EQ:
+			{
+				a = m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff;
+				b = m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff;
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_GR16_GT:
+			{
+				a = ((m_AlphaInputLUT[ac.a][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff);
+				b = ((m_AlphaInputLUT[ac.b][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff);
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_GR16_EQ:
+			{
+				a = ((m_AlphaInputLUT[ac.a][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff);
+				b = ((m_AlphaInputLUT[ac.b][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff);
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_BGR24_GT:
+			{
+				a = ((m_AlphaInputLUT[ac.a][BLU_C][pixel] & 0xff) << 16) | ((m_AlphaInputLUT[ac.a][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff);
+				b = ((m_AlphaInputLUT[ac.b][BLU_C][pixel] & 0xff) << 16) | ((m_AlphaInputLUT[ac.b][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff);
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a > b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_BGR24_EQ:
+			{
+				a = ((m_AlphaInputLUT[ac.a][BLU_C][pixel] & 0xff) << 16) | ((m_AlphaInputLUT[ac.a][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.a][RED_C][pixel] & 0xff);
+				b = ((m_AlphaInputLUT[ac.b][BLU_C][pixel] & 0xff) << 16) | ((m_AlphaInputLUT[ac.b][GRN_C][pixel] & 0xff) << 8) | (m_AlphaInputLUT[ac.b][RED_C][pixel] & 0xff);
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((a == b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_A8_GT:
+			{
+				InputReg.a = m_AlphaInputLUT[ac.a][ALP_C][pixel];
+				InputReg.b = m_AlphaInputLUT[ac.b][ALP_C][pixel];
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((InputReg.a > InputReg.b) ? InputReg.c : 0);
+			}
+			break;
+		case TEVCMP_A8_EQ:
+			{
+				InputReg.a = m_AlphaInputLUT[ac.a][ALP_C][pixel];
+				InputReg.b = m_AlphaInputLUT[ac.b][ALP_C][pixel];
+				InputReg.c = m_AlphaInputLUT[ac.c][ALP_C][pixel];
+				InputReg.d = m_AlphaInputLUT[ac.d][ALP_C][pixel];
+				Reg[ac.dest][ALP_C][pixel] = InputReg.d + ((InputReg.a == InputReg.b) ? InputReg.c : 0);
+			}
+			break;
 		}
-		break;
 	}
 }
 
@@ -457,10 +527,10 @@ inline s32 WrapIndirectCoord(s32 coord, int wrapMode)
 	return 0;
 }
 
-void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
+void Tev::Indirect(unsigned int stageNum, int pixel, s32 s, s32 t)
 {
 	TevStageIndirect &indirect = bpmem.tevind[stageNum];
-	u8 *indmap = IndirectTex[indirect.bt];
+	u8 *indmap = IndirectTex[indirect.bt][pixel];
 
 	s32 indcoord[3];
 
@@ -468,16 +538,16 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 	switch (indirect.bs)
 	{
 		case ITBA_OFF:
-			AlphaBump = 0;
+			AlphaBump[pixel] = 0;
 			break;
 			case ITBA_S:
-			AlphaBump = indmap[TextureSampler::ALP_SMP];
+			AlphaBump[pixel] = indmap[TextureSampler::ALP_SMP];
 			break;
 		case ITBA_T:
-			AlphaBump = indmap[TextureSampler::BLU_SMP];
+			AlphaBump[pixel] = indmap[TextureSampler::BLU_SMP];
 			break;
 		case ITBA_U:
-			AlphaBump = indmap[TextureSampler::GRN_SMP];
+			AlphaBump[pixel] = indmap[TextureSampler::GRN_SMP];
 			break;
 	}
 
@@ -495,25 +565,25 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 			indcoord[0] = indmap[TextureSampler::ALP_SMP] + bias[0];
 			indcoord[1] = indmap[TextureSampler::BLU_SMP] + bias[1];
 			indcoord[2] = indmap[TextureSampler::GRN_SMP] + bias[2];
-			AlphaBump = AlphaBump & 0xf8;
+			AlphaBump[pixel] = AlphaBump[pixel] & 0xf8;
 			break;
 		case ITF_5:
 			indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x1f) + bias[0];
 			indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x1f) + bias[1];
 			indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x1f) + bias[2];
-			AlphaBump = AlphaBump & 0xe0;
+			AlphaBump[pixel] = AlphaBump[pixel] & 0xe0;
 			break;
 		case ITF_4:
 			indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x0f) + bias[0];
 			indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x0f) + bias[1];
 			indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x0f) + bias[2];
-			AlphaBump = AlphaBump & 0xf0;
+			AlphaBump[pixel] = AlphaBump[pixel] & 0xf0;
 			break;
 		case ITF_3:
 			indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x07) + bias[0];
 			indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x07) + bias[1];
 			indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x07) + bias[2];
-			AlphaBump = AlphaBump & 0xf8;
+			AlphaBump[pixel] = AlphaBump[pixel] & 0xf8;
 			break;
 		default:
 			PanicAlert("Tev::Indirect");
@@ -560,22 +630,35 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 
 	if (indirect.fb_addprev)
 	{
-		TexCoord.s += (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
-		TexCoord.t += (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
+		TexCoord[pixel].s += (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
+		TexCoord[pixel].t += (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
 	}
 	else
 	{
-		TexCoord.s = (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
-		TexCoord.t = (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
+		TexCoord[pixel].s = (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
+		TexCoord[pixel].t = (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
 	}
 }
 
-void Tev::Draw()
+void Tev::Draw(u32 pixelMask)
 {
-	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
-	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
+	for (int i = 0; i < QUAD_SIZE; i++)
+	{
+		if (!(pixelMask & (1 << i)))
+			continue;
+
+		_assert_(Position[i][0] >= 0 && Position[i][0] < EFB_WIDTH);
+		_assert_(Position[i][1] >= 0 && Position[i][1] < EFB_HEIGHT);
 
-	INCSTAT(swstats.thisFrame.tevPixelsIn);
+		Counts.tevPixelsIn++;
+	}
+
+	// Like in the pixel shaders of the hardware backends, every pixel
+	// starts out with the color registers that were set through BP
+	for (int reg = 0; reg < 4; reg++)
+		for (int comp = 0; comp < 4; comp++)
+			for (int i = 0; i < QUAD_SIZE; i++)
+				Reg[reg][comp][i] = RegisterColors[reg][comp];
 
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
 	{
@@ -589,21 +672,27 @@ void Tev::Draw()
 		s32 scaleS = stageOdd ? texscale.ss1:texscale.ss0;
 		s32 scaleT = stageOdd ? texscale.ts1:texscale.ts0;
 
-		TextureSampler::Sample(Uv[texcoordSel].s >> scaleS, Uv[texcoordSel].t >> scaleT,
-			IndirectLod[stageNum], IndirectLinear[stageNum], texmap, IndirectTex[stageNum]);
+		for (int i = 0; i < QUAD_SIZE; i++)
+		{
+			if (!(pixelMask & (1 << i)))
+				continue;
+
+			TextureSampler::Sample(Uv[i][texcoordSel].s >> scaleS, Uv[i][texcoordSel].t >> scaleT,
+				IndirectLod[stageNum], IndirectLinear[stageNum], texmap, IndirectTex[stageNum][i]);
 
 #if ALLOW_TEV_DUMPS
-		if (g_SWVideoConfig.bDumpTevStages)
-		{
-			u8 stage[4] = { 
-				IndirectTex[stageNum][TextureSampler::ALP_SMP],
-				IndirectTex[stageNum][TextureSampler::BLU_SMP],
-				IndirectTex[stageNum][TextureSampler::GRN_SMP],
-				255
-			};
-			DebugUtil::DrawTempBuffer(stage, INDIRECT + stageNum);
-		}
+			if (g_SWVideoConfig.bDumpTevStages)
+			{
+				u8 stage[4] = {
+					IndirectTex[stageNum][i][TextureSampler::ALP_SMP],
+					IndirectTex[stageNum][i][TextureSampler::BLU_SMP],
+					IndirectTex[stageNum][i][TextureSampler::GRN_SMP],
+					255
+				};
+				DebugUtil::DrawTempBuffer(stage, INDIRECT + stageNum);
+			}
 #endif
+		}
 	}
 
 	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
@@ -620,85 +709,100 @@ void Tev::Draw()
 		int texcoordSel = order.getTexCoord(stageOdd);
 		int texmap = order.getTexMap(stageOdd);
 
-		Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
-
-		// sample texture
-		if (order.getEnable(stageOdd))
+		for (int i = 0; i < QUAD_SIZE; i++)
 		{
-			// RGBA
-			u8 texel[4];
+			if (!(pixelMask & (1 << i)))
+				continue;
+
+			Indirect(stageNum, i, Uv[i][texcoordSel].s, Uv[i][texcoordSel].t);
+
+			// sample texture
+			if (order.getEnable(stageOdd))
+			{
+				// RGBA
+				u8 texel[4];
 
-			TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum], texmap, texel);
+				TextureSampler::Sample(TexCoord[i].s, TexCoord[i].t, TextureLod[stageNum], TextureLinear[stageNum], texmap, texel);
 
 #if ALLOW_TEV_DUMPS
-			if (g_SWVideoConfig.bDumpTevTextureFetches)
-				DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
+				if (g_SWVideoConfig.bDumpTevTextureFetches)
+					DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
 #endif
 
-			int swaptable = ac.tswap * 2;
+				int swaptable = ac.tswap * 2;
 
-			TexColor[RED_C] = texel[bpmem.tevksel[swaptable].swap1];
-			TexColor[GRN_C] = texel[bpmem.tevksel[swaptable].swap2];
-			swaptable++;
-			TexColor[BLU_C] = texel[bpmem.tevksel[swaptable].swap1];
-			TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
+				TexColor[RED_C][i] = texel[bpmem.tevksel[swaptable].swap1];
+				TexColor[GRN_C][i] = texel[bpmem.tevksel[swaptable].swap2];
+				swaptable++;
+				TexColor[BLU_C][i] = texel[bpmem.tevksel[swaptable].swap1];
+				TexColor[ALP_C][i] = texel[bpmem.tevksel[swaptable].swap2];
+			}
 		}
 
 		// set konst for this stage
 		int kc = kSel.getKC(stageOdd);
 		int ka = kSel.getKA(stageOdd);
-		StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
-		StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
-		StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
-		StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
+		for (int i = 0; i < QUAD_SIZE; i++)
+		{
+			StageKonst[RED_C][i] = *(m_KonstLUT[kc][RED_C]);
+			StageKonst[GRN_C][i] = *(m_KonstLUT[kc][GRN_C]);
+			StageKonst[BLU_C][i] = *(m_KonstLUT[kc][BLU_C]);
+			StageKonst[ALP_C][i] = *(m_KonstLUT[ka][ALP_C]);
+		}
 
 		// set color
 		SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
 
-		// combine inputs
+		// combine inputs, for all pixels of the quad even if some of them
+		// aren't drawn
 		if (cc.bias != 3)
 			DrawColorRegular(cc);
 		else
 			DrawColorCompare(cc);
 
-		if (cc.clamp)
-		{
-			Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
-		}
-		else
-		{
-			Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
-		}
+		ClampComponent(Reg[cc.dest][RED_C], cc.clamp);
+		ClampComponent(Reg[cc.dest][GRN_C], cc.clamp);
+		ClampComponent(Reg[cc.dest][BLU_C], cc.clamp);
 
 		if (ac.bias != 3)
 			DrawAlphaRegular(ac);
 		else
 			DrawAlphaCompare(ac);
 
-		if (ac.clamp)
-			Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
-		else
-			Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+		ClampComponent(Reg[ac.dest][ALP_C], ac.clamp);
 
 #if ALLOW_TEV_DUMPS
 		if (g_SWVideoConfig.bDumpTevStages)
 		{
-			u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
-			DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+			for (int i = 0; i < QUAD_SIZE; i++)
+			{
+				if (pixelMask & (1 << i))
+				{
+					u8 stage[4] = {(u8)Reg[0][RED_C][i], (u8)Reg[0][GRN_C][i], (u8)Reg[0][BLU_C][i], (u8)Reg[0][ALP_C][i]};
+					DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+				}
+			}
 		}
 #endif
 	}
 
+	for (int i = 0; i < QUAD_SIZE; i++)
+	{
+		if (pixelMask & (1 << i))
+			DrawPixel(i);
+	}
+}
+
+void Tev::DrawPixel(int pixel)
+{
+	s32 *position = Position[pixel];
+
 	// convert to 8 bits per component
 	// the results of the last tev stage are put onto the screen,
 	// regardless of the used destination register - TODO: Verify!
 	u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
 	u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
-	u8 output[4] = {(u8)Reg[alpha_index][ALP_C], (u8)Reg[color_index][BLU_C], (u8)Reg[color_index][GRN_C], (u8)Reg[color_index][RED_C]};
+	u8 output[4] = {(u8)Reg[alpha_index][ALP_C][pixel], (u8)Reg[color_index][BLU_C][pixel], (u8)Reg[color_index][GRN_C][pixel], (u8)Reg[color_index][RED_C][pixel]};
 
 	if (!TevAlphaTest(output[ALP_C]))
 		return;
@@ -710,20 +814,20 @@ void Tev::Draw()
 		switch (bpmem.ztex2.type)
 		{
 			case 0: // 8 bit
-				ztex += TexColor[ALP_C];
+				ztex += TexColor[ALP_C][pixel];
 				break;
 			case 1: // 16 bit
-				ztex += TexColor[ALP_C] << 8 | TexColor[RED_C];
+				ztex += TexColor[ALP_C][pixel] << 8 | TexColor[RED_C][pixel];
 				break;
 			case 2: // 24 bit
-				ztex += TexColor[RED_C] << 16 | TexColor[GRN_C] << 8 | TexColor[BLU_C];
+				ztex += TexColor[RED_C][pixel] << 16 | TexColor[GRN_C][pixel] << 8 | TexColor[BLU_C][pixel];
 				break;
 		}
 
 		if (bpmem.ztex2.op == ZTEXTURE_ADD)
-			ztex += Position[2];
+			ztex += position[2];
 
-		Position[2] = ztex & 0x00ffffff;
+		position[2] = ztex & 0x00ffffff;
 	}
 
 	// fog
@@ -735,7 +839,7 @@ void Tev::Draw()
 		{
 			// perspective
 			// ze = A/(B - (Zs >> B_SHF))
-			s32 denom = bpmem.fog.b_magnitude - (Position[2] >> bpmem.fog.b_shift);
+			s32 denom = bpmem.fog.b_magnitude - (position[2] >> bpmem.fog.b_shift);
 			//in addition downscale magnitude and zs to 0.24 bits
 			ze = (bpmem.fog.a.GetA() * 16777215.0f) / (float)denom;
 		}
@@ -744,7 +848,7 @@ void Tev::Draw()
 			// orthographic
 			// ze = a*Zs
 			//in addition downscale zs to 0.24 bits
-			ze = bpmem.fog.a.GetA() * ((float)Position[2] / 16777215.0f);
+			ze = bpmem.fog.a.GetA() * ((float)position[2] / 16777215.0f);
 
 		}
 
@@ -755,7 +859,7 @@ void Tev::Draw()
 			// - scaling of the "k" coefficient isn't clear either.
 
 			// First, calculate the offset from the viewport center (normalized to 0..1)
-			float offset = (Position[0] - (bpmem.fogRange.Base.Center - 342)) / (float)swxfregs.viewport.wd;
+			float offset = (position[0] - (bpmem.fogRange.Base.Center - 342)) / (float)swxfregs.viewport.wd;
 
 			// Based on that, choose the index such that points which are far away from the z-axis use the 10th "k" value and such that central points use the first value.
 			float floatindex = 9.f - std::abs(offset) * 9.f;
@@ -811,21 +915,21 @@ void Tev::Draw()
 	if (late_ztest && bpmem.zmode.testenable)
 	{
 		// TODO: Check against hw if these values get incremented even if depth testing is disabled
-		SWPixelEngine::pereg.IncZInputQuadCount(false);
+		Counts.zInputLate++;
 
-		if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
+		if (!EfbInterface::ZCompare(position[0], position[1], position[2]))
 			return;
 
-		SWPixelEngine::pereg.IncZOutputQuadCount(false);
+		Counts.zOutputLate++;
 	}
 
 #if ALLOW_TEV_DUMPS
 	if (g_SWVideoConfig.bDumpTevStages)
 	{
 		for (u32 i = 0; i < bpmem.genMode.numindstages; ++i)
-			DebugUtil::CopyTempBuffer(Position[0], Position[1], INDIRECT, i, "Indirect");
+			DebugUtil::CopyTempBuffer(position[0], position[1], INDIRECT, i, "Indirect");
 		for (u32 i = 0; i <= bpmem.genMode.numtevstages; ++i)
-			DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT, i, "Stage");
+			DebugUtil::CopyTempBuffer(position[0], position[1], DIRECT, i, "Stage");
 	}
 
 	if (g_SWVideoConfig.bDumpTevTextureFetches)
@@ -834,15 +938,19 @@ void Tev::Draw()
 		{
 			TwoTevStageOrders &order = bpmem.tevorders[i >> 1];
 			if (order.getEnable(i & 1))
-				DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT_TFETCH, i, "TFetch");
+				DebugUtil::CopyTempBuffer(position[0], position[1], DIRECT_TFETCH, i, "TFetch");
 		}
 	}
 #endif
 
-	INCSTAT(swstats.thisFrame.tevPixelsOut);
-	SWPixelEngine::pereg.IncBlendInputQuadCount();
+	Counts.tevPixelsOut++;
 
-	EfbInterface::BlendTev(Position[0], Position[1], output);
+	EfbInterface::BlendTev(position[0], position[1], output);
+
+	Counts.boxLeft = std::min<u16>(Counts.boxLeft, position[0]);
+	Counts.boxRight = std::max<u16>(Counts.boxRight, position[0]);
+	Counts.boxTop = std::min<u16>(Counts.boxTop, position[1]);
+	Counts.boxBottom = std::max<u16>(Counts.boxBottom, position[1]);
 }
 
 void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
@@ -853,32 +961,62 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 	else
 	{
-		Reg[reg][comp] = color;
+		RegisterColors[reg][comp] = color;
 	}
 }
 
+void Tev::CopyRegisters(const Tev& other)
+{
+	memcpy(RegisterColors, other.RegisterColors, sizeof(RegisterColors));
+	memcpy(KonstantColors, other.KonstantColors, sizeof(KonstantColors));
+}
+
+void Tev::FlushCounters()
+{
+	ADDSTAT(swstats.thisFrame.rasterizedPixels, Counts.rasterizedPixels);
+	ADDSTAT(swstats.thisFrame.tevPixelsIn, Counts.tevPixelsIn);
+	ADDSTAT(swstats.thisFrame.tevPixelsOut, Counts.tevPixelsOut);
+
+	SWPixelEngine::PEReg& pereg = SWPixelEngine::pereg;
+	pereg.AddZInputQuadCount(Counts.zInputEarly, true);
+	pereg.AddZOutputQuadCount(Counts.zOutputEarly, true);
+	pereg.AddZInputQuadCount(Counts.zInputLate, false);
+	pereg.AddZOutputQuadCount(Counts.zOutputLate, false);
+	pereg.AddBlendInputQuadCount(Counts.tevPixelsOut);
+
+	// branchless bounding box update
+	pereg.boxLeft = std::min(pereg.boxLeft, Counts.boxLeft);
+	pereg.boxRight = std::max(pereg.boxRight, Counts.boxRight);
+	pereg.boxTop = std::min(pereg.boxTop, Counts.boxTop);
+	pereg.boxBottom = std::max(pereg.boxBottom, Counts.boxBottom);
+
+	memset(&Counts, 0, sizeof(Counts));
+	Counts.boxLeft = Counts.boxTop = 0xFFFF;
+}
+
 void Tev::DoState(PointerWrap &p)
 {
-	p.DoArray(Reg, sizeof(Reg));
+	p.Do(Reg);
+	p.Do(RegisterColors);
 
-	p.DoArray(KonstantColors, sizeof(KonstantColors));
-	p.DoArray(TexColor,4);
-	p.DoArray(RasColor,4);
-	p.DoArray(StageKonst,4);
-	p.DoArray(Zero16,4);
+	p.Do(KonstantColors);
+	p.Do(TexColor);
+	p.Do(RasColor);
+	p.Do(StageKonst);
+	p.Do(Zero16);
 
-	p.DoArray(FixedConstants,9);
+	p.Do(FixedConstants);
 	p.Do(AlphaBump);
-	p.DoArray(IndirectTex, sizeof(IndirectTex));
+	p.Do(IndirectTex);
 	p.Do(TexCoord);
 
 	p.DoArray(m_BiasLUT,4);
 	p.DoArray(m_ScaleLShiftLUT,4);
 	p.DoArray(m_ScaleRShiftLUT,4);
 
-	p.DoArray(Position,3);
-	p.DoArray(Color, sizeof(Color));
-	p.DoArray(Uv, 8);
+	p.Do(Position);
+	p.Do(Color);
+	p.Do(Uv);
 	p.DoArray(IndirectLod,4);
 	p.DoArray(IndirectLinear,4);
 	p.DoArray(TextureLod,16);
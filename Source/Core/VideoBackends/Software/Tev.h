@@ -9,6 +9,11 @@
 
 class Tev
 {
+public:
+	// The pixels of a 2x2 block, which are shaded together
+	enum { QUAD_SIZE = 4 };
+
+private:
 	struct InputRegType
 	{
 		unsigned a : 8;
@@ -24,20 +29,23 @@ class Tev
 	};
 
 	// color order: ABGR
-	s16 Reg[4][4];
+	// Every per pixel component holds the values for the QUAD_SIZE pixels
+	// of a quad, so that the combiners can work on all of them at once
+	s16 Reg[4][4][QUAD_SIZE];
+	s16 RegisterColors[4][4]; // what every pixel starts out with in Reg
 	s16 KonstantColors[4][4];
-	s16 TexColor[4];
-	s16 RasColor[4];
-	s16 StageKonst[4];
-	s16 Zero16[4];
-
-	s16 FixedConstants[9];
-	u8 AlphaBump;
-	u8 IndirectTex[4][4];
-	TextureCoordinateType TexCoord;
-
-	s16 *m_ColorInputLUT[16][3];
-	s16 *m_AlphaInputLUT[8];        // values must point to ABGR color
+	s16 TexColor[4][QUAD_SIZE];
+	s16 RasColor[4][QUAD_SIZE];
+	s16 StageKonst[4][QUAD_SIZE];
+	s16 Zero16[4][QUAD_SIZE];
+
+	s16 FixedConstants[9][QUAD_SIZE];
+	u8 AlphaBump[QUAD_SIZE];
+	u8 IndirectTex[4][QUAD_SIZE][4];
+	TextureCoordinateType TexCoord[QUAD_SIZE];
+
+	s16 *m_ColorInputLUT[16][3];    // values point to the pixels of a component
+	s16 (*m_AlphaInputLUT[8])[QUAD_SIZE]; // values must point to ABGR color
 	s16 *m_KonstLUT[32][4];
 	s16 m_BiasLUT[4];
 	u8 m_ScaleLShiftLUT[4];
@@ -65,22 +73,51 @@ class Tev
 	void DrawAlphaRegular(TevStageCombiner::AlphaCombiner &ac);
 	void DrawAlphaCompare(TevStageCombiner::AlphaCombiner &ac);
 
-	void Indirect(unsigned int stageNum, s32 s, s32 t);
+	void Indirect(unsigned int stageNum, int pixel, s32 s, s32 t);
+
+	// Alpha test, z texture, fog, late z and blending for one pixel
+	void DrawPixel(int pixel);
 
 public:
-	s32 Position[3];
-	u8 Color[2][4]; // must be RGBA for correct swap table ordering
-	TextureCoordinateType Uv[8];
+	// pixel i of a quad is at x + (i & 1), y + (i >> 1)
+	s32 Position[QUAD_SIZE][3];
+	u8 Color[QUAD_SIZE][2][4]; // must be RGBA for correct swap table ordering
+	TextureCoordinateType Uv[QUAD_SIZE][8];
 	s32 IndirectLod[4];
 	bool IndirectLinear[4];
 	s32 TextureLod[16];
 	bool TextureLinear[16];
 
+	// Pixels counted since the last FlushCounters(), kept per TEV so that
+	// the rasterizer threads don't share any counters
+	struct PixelCounts
+	{
+		u32 rasterizedPixels;
+		u32 tevPixelsIn;
+		u32 tevPixelsOut;
+		u32 zInputEarly;
+		u32 zOutputEarly;
+		u32 zInputLate;
+		u32 zOutputLate;
+		u16 boxLeft;
+		u16 boxRight;
+		u16 boxTop;
+		u16 boxBottom;
+	};
+	PixelCounts Counts;
+
 	void Init();
 
-	void Draw();
+	// Shades the pixels of the quad whose bits are set in the mask, the LODs
+	// are shared by all of them
+	void Draw(u32 pixelMask);
 
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
+	// Takes over the color and konst registers of another TEV
+	void CopyRegisters(const Tev& other);
+
+	// Adds the counts to the statistics and the pixel engine registers
+	void FlushCounters();
 
 	enum { ALP_C, BLU_C, GRN_C, RED_C };
 
@@ -4,17 +4,145 @@
 
 #include "TextureSampler.h"
 
+#include "Atomic.h"
 #include "BPMemLoader.h"
+#include "Hash.h"
+#include "StdMutex.h"
 #include "TextureDecoder.h"
 #include "HW/Memmap.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #define ALLOW_MIPMAP 1
 
 namespace TextureSampler
 {
 
+// the LOD can go up to 15, and linear mip filtering reads one level more
+static const int MAX_MIP_LEVELS = 17;
+
+// One mip level of a texmap, decoded to four bytes per texel in the order
+// TexDecoder_DecodeTexel writes them
+struct DecodedLevel
+{
+	// what the texels were decoded from
+	const u8 *src;
+	const u8 *srcOdd;
+	int width;
+	int height;
+	int format;
+	int tlutAddress;
+	int tlutFormat;
+	u64 hash;
+
+	std::vector<u8> texels;
+
+	// set once the level has been compared to its source since the last
+	// InvalidateCache()
+	volatile u32 checked;
+};
+
+struct DecodedTexmap
+{
+	DecodedLevel levels[MAX_MIP_LEVELS];
+	std::mutex lock;
+};
+
+static DecodedTexmap decodedTexmaps[8];
+
+void InvalidateCache()
+{
+	for (DecodedTexmap& texmap : decodedTexmaps)
+	{
+		for (DecodedLevel& level : texmap.levels)
+			level.checked = 0;
+	}
+}
+
+static u64 HashSource(const u8 *src, const u8 *srcOdd, int width, int height, int format, int tlutAddress)
+{
+	// the textures in TMEM mustn't be hashed past its end
+	u32 size = TexDecoder_GetTextureSizeInBytes(width + 1, height + 1, format);
+	const u8 *texMemEnd = texMem + TMEM_SIZE;
+	if (src >= texMem && src < texMemEnd)
+		size = std::min<u32>(size, (u32)(texMemEnd - src));
+
+	u64 hash = GetHash64(src, size, 0);
+	if (srcOdd)
+		hash ^= GetHash64(srcOdd, std::min<u32>(size, (u32)(texMemEnd - srcOdd)), 0) * 31;
+
+	u32 tlutSize = 0;
+	switch (format)
+	{
+	case GX_TF_C4: tlutSize = 16 * 2; break;
+	case GX_TF_C8: tlutSize = 256 * 2; break;
+	case GX_TF_C14X2: tlutSize = 16384 * 2; break;
+	}
+	if (tlutSize)
+		hash ^= GetHash64(texMem + tlutAddress, std::min<u32>(tlutSize, TMEM_SIZE - tlutAddress), 0) * 17;
+
+	return hash;
+}
+
+// Returns the decoded texels of a mip level, decoding it again if its
+// source changed since it was last used. Like the hardware backends'
+// texture cache this compares hashes of the texture and TLUT data, so
+// writes by the CPU and EFB copies are picked up as well.
+static const u8 *GetDecodedLevel(u8 texmap, s32 mip, const u8 *src, const u8 *srcOdd,
+	int width, int height, int format, int tlutAddress, int tlutFormat)
+{
+	DecodedLevel& level = decodedTexmaps[texmap].levels[mip];
+
+	if (!Common::AtomicLoadAcquire(level.checked))
+	{
+		// sampling happens on the rasterizer threads as well
+		std::lock_guard<std::mutex> lk(decodedTexmaps[texmap].lock);
+
+		if (!level.checked)
+		{
+			u64 hash = HashSource(src, srcOdd, width, height, format, tlutAddress);
+
+			if (level.src != src || level.srcOdd != srcOdd || level.width != width || level.height != height ||
+			    level.format != format || level.tlutAddress != tlutAddress || level.tlutFormat != tlutFormat ||
+			    level.hash != hash || level.texels.empty())
+			{
+				level.src = src;
+				level.srcOdd = srcOdd;
+				level.width = width;
+				level.height = height;
+				level.format = format;
+				level.tlutAddress = tlutAddress;
+				level.tlutFormat = tlutFormat;
+				level.hash = hash;
+
+				level.texels.resize((width + 1) * (height + 1) * 4);
+				u8 *dst = &level.texels[0];
+				for (int t = 0; t <= height; t++)
+				{
+					for (int s = 0; s <= width; s++, dst += 4)
+					{
+						if (srcOdd)
+							TexDecoder_DecodeTexelRGBA8FromTmem(dst, src, srcOdd, s, t, width);
+						else
+							TexDecoder_DecodeTexel(dst, src, s, t, width, format, tlutAddress, tlutFormat);
+					}
+				}
+			}
+
+			Common::AtomicStoreRelease(level.checked, 1);
+		}
+	}
+
+	return &level.texels[0];
+}
+
+inline const u8 *GetTexel(const u8 *texels, int s, int t, int width)
+{
+	return texels + (t * (width + 1) + s) * 4;
+}
+
 inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 {
 	switch (wrapMode)
@@ -38,7 +166,7 @@ inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 	}
 }
 
-inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void SetTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] = inTexel[0] * fract;
 	outTexel[1] = inTexel[1] * fract;
@@ -46,7 +174,7 @@ inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
 	outTexel[3] = inTexel[3] * fract;
 }
 
-inline void AddTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void AddTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] += inTexel[0] * fract;
 	outTexel[1] += inTexel[1] * fract;
@@ -125,6 +253,8 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 
 	int tlutAddress = texTlut.tmem_offset << 9;
 
+	const s32 level = mip;
+
 	// reduce sample location and texture size to mip level
 	// move texture pointer to mip location
 	if (mip)
@@ -154,6 +284,9 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		}
 	}
 
+	const u8 *texels = GetDecodedLevel(texmap, level, imageSrc, imageSrcOdd, imageWidth, imageHeight,
+		ti0.format, tlutAddress, texTlut.tlut_format);
+
 	if (linear)
 	{
 		// offset linear sampling
@@ -171,7 +304,6 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		int imageTPlus1 = imageT + 1;
 		int fractT = t & 0x7f;
 
-		u8 sampledTex[4];
 		u32 texel[4];
 
 		WrapCoord(imageS, tm0.wrap_s, imageWidth);
@@ -179,34 +311,10 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageSPlus1, tm0.wrap_s, imageWidth);
 		WrapCoord(imageTPlus1, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-		{
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
-		else
-		{
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageT, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
+		SetTexel(GetTexel(texels, imageS, imageT, imageWidth), texel, (128 - fractS) * (128 - fractT));
+		AddTexel(GetTexel(texels, imageSPlus1, imageT, imageWidth), texel, (fractS) * (128 - fractT));
+		AddTexel(GetTexel(texels, imageS, imageTPlus1, imageWidth), texel, (128 - fractS) * (fractT));
+		AddTexel(GetTexel(texels, imageSPlus1, imageTPlus1, imageWidth), texel, (fractS) * (fractT));
 
 		sample[0] = (u8)(texel[0] >> 14);
 		sample[1] = (u8)(texel[1] >> 14);
@@ -223,10 +331,7 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageS, tm0.wrap_s, imageWidth);
 		WrapCoord(imageT, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-			TexDecoder_DecodeTexel(sample, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-		else
-			TexDecoder_DecodeTexelRGBA8FromTmem(sample, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
+		memcpy(sample, GetTexel(texels, imageS, imageT, imageWidth), 4);
 	}
 }
 
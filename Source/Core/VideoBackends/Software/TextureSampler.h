@@ -12,5 +12,9 @@ namespace TextureSampler
 
 	void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample);
 
+	// Makes the next sample from every texture level check whether the
+	// texture data changed, has to be called before each object is drawn
+	void InvalidateCache();
+
 	enum { RED_SMP, GRN_SMP, BLU_SMP, ALP_SMP };
 }
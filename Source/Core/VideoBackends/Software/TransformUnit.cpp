@@ -4,6 +4,7 @@
 
 #include "Common.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include "TransformUnit.h"
@@ -14,6 +15,10 @@
 
 #include "Vec3.h"
 
+#if !defined(_M_GENERIC) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define TRANSFORM_SIMD_SSE
+#endif
 
 namespace TransformUnit
 {
@@ -103,6 +108,147 @@ void TransformNormal(const InputVertexData *src, bool nbt, OutputVertexData *dst
 	}
 }
 
+#if defined(TRANSFORM_SIMD_SSE)
+// Vertex i of src in lane i. The lanes past count repeat the last vertex.
+#define GATHER_LANES(expr) _mm_setr_ps(src[0].expr, src[std::min(1, count - 1)].expr, \
+	src[std::min(2, count - 1)].expr, src[std::min(3, count - 1)].expr)
+
+// Element k of every lane's matrix, which usually is the same one for all
+static inline __m128 GatherMatrix(const float *const *mat, bool sameMatrix, int k)
+{
+	if (sameMatrix)
+		return _mm_set1_ps(mat[0][k]);
+	return _mm_setr_ps(mat[0][k], mat[1][k], mat[2][k], mat[3][k]);
+}
+
+// The lanes of a vector, in the same order of operations as the scalar code
+static inline void MultiplyVec3Mat34(const __m128 *vec, const float *const *mat, bool sameMatrix, __m128 *result)
+{
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 sum = _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 4), vec[0]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 4 + 1), vec[1]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 4 + 2), vec[2]));
+		result[row] = _mm_add_ps(sum, GatherMatrix(mat, sameMatrix, row * 4 + 3));
+	}
+}
+
+static inline void MultiplyVec3Mat33(const __m128 *vec, const float *const *mat, bool sameMatrix, __m128 *result)
+{
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 sum = _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 3), vec[0]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 3 + 1), vec[1]));
+		result[row] = _mm_add_ps(sum, _mm_mul_ps(GatherMatrix(mat, sameMatrix, row * 3 + 2), vec[2]));
+	}
+}
+#endif
+
+void TransformPositions(const InputVertexData *src, int count, Vec3 *mvPosition, Vec4 *projectedPosition)
+{
+#if defined(TRANSFORM_SIMD_SSE)
+	const float *mat[BATCH_SIZE];
+	bool sameMatrix = true;
+	for (int i = 0; i < BATCH_SIZE; i++)
+	{
+		const InputVertexData &vertex = src[std::min(i, count - 1)];
+		mat[i] = (const float*)&swxfregs.posMatrices[vertex.posMtx * 4];
+		sameMatrix &= mat[i] == mat[0];
+	}
+
+	__m128 pos[3] = { GATHER_LANES(position.x), GATHER_LANES(position.y), GATHER_LANES(position.z) };
+	__m128 mv[3];
+	MultiplyVec3Mat34(pos, mat, sameMatrix, mv);
+
+	const float *proj = swxfregs.projection.rawProjection;
+	__m128 projected[4];
+	if (swxfregs.projection.type == GX_PERSPECTIVE)
+	{
+		projected[0] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv[0]), _mm_mul_ps(_mm_set1_ps(proj[1]), mv[2]));
+		projected[1] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv[1]), _mm_mul_ps(_mm_set1_ps(proj[3]), mv[2]));
+		projected[2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv[2]), _mm_set1_ps(proj[5])),
+			_mm_set1_ps(1.0f - (float)1e-7));
+		projected[3] = _mm_xor_ps(mv[2], _mm_set1_ps(-0.0f));
+	}
+	else
+	{
+		projected[0] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv[0]), _mm_set1_ps(proj[1]));
+		projected[1] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv[1]), _mm_set1_ps(proj[3]));
+		projected[2] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv[2]), _mm_set1_ps(proj[5]));
+		projected[3] = _mm_set1_ps(1.0f);
+	}
+
+	// back to one vertex per element
+	_MM_TRANSPOSE4_PS(projected[0], projected[1], projected[2], projected[3]);
+	GC_ALIGNED16(float mvLanes[3][4]);
+	for (int i = 0; i < 3; i++)
+		_mm_store_ps(mvLanes[i], mv[i]);
+
+	for (int i = 0; i < count; i++)
+	{
+		mvPosition[i].set(mvLanes[0][i], mvLanes[1][i], mvLanes[2][i]);
+		_mm_storeu_ps(&projectedPosition[i].x, projected[i]);
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		OutputVertexData dst;
+		TransformPosition(&src[i], &dst);
+		mvPosition[i] = dst.mvPosition;
+		projectedPosition[i] = dst.projectedPosition;
+	}
+#endif
+}
+
+void TransformNormals(const InputVertexData *src, int count, bool nbt, Vec3 (*normal)[3])
+{
+#if defined(TRANSFORM_SIMD_SSE)
+	const float *mat[BATCH_SIZE];
+	bool sameMatrix = true;
+	for (int i = 0; i < BATCH_SIZE; i++)
+	{
+		const InputVertexData &vertex = src[std::min(i, count - 1)];
+		mat[i] = (const float*)&swxfregs.normalMatrices[(vertex.posMtx & 31) * 3];
+		sameMatrix &= mat[i] == mat[0];
+	}
+
+	GC_ALIGNED16(float lanes[3][3][4]);
+	for (int n = 0; n < (nbt ? 3 : 1); n++)
+	{
+		__m128 in[3] = { GATHER_LANES(normal[n].x), GATHER_LANES(normal[n].y), GATHER_LANES(normal[n].z) };
+		__m128 out[3];
+		MultiplyVec3Mat33(in, mat, sameMatrix, out);
+
+		if (n == 0)
+		{
+			// normalize() multiplies by the reciprocal of the length
+			__m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(out[0], out[0]), _mm_mul_ps(out[1], out[1])),
+				_mm_mul_ps(out[2], out[2]));
+			__m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length2));
+			for (int c = 0; c < 3; c++)
+				out[c] = _mm_mul_ps(out[c], invLength);
+		}
+
+		for (int c = 0; c < 3; c++)
+			_mm_store_ps(lanes[n][c], out[c]);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int n = 0; n < (nbt ? 3 : 1); n++)
+			normal[i][n].set(lanes[n][0][i], lanes[n][1][i], lanes[n][2][i]);
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		OutputVertexData dst;
+		TransformNormal(&src[i], nbt, &dst);
+		for (int n = 0; n < (nbt ? 3 : 1); n++)
+			normal[i][n] = dst.normal[n];
+	}
+#endif
+}
+
 void TransformTexCoordRegular(const TexMtxInfo &texinfo, int coordNum, bool specialCase, const InputVertexData *srcVertex, OutputVertexData *dstVertex)
 {
 	const Vec3 *src;
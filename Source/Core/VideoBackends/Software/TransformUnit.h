@@ -6,9 +6,15 @@
 
 struct InputVertexData;
 struct OutputVertexData;
+class Vec3;
+struct Vec4;
 
 namespace TransformUnit
 {
+	// The vertex loader transforms the positions and normals of up to this
+	// many vertices at once
+	enum { BATCH_SIZE = 4 };
+
 	void MultiplyVec2Mat24(const float *vec, const float *mat, float *result);
 	void MultiplyVec2Mat34(const float *vec, const float *mat, float *result);
 	void MultiplyVec3Mat33(const float *vec, const float *mat, float *result);
@@ -18,4 +24,10 @@ namespace TransformUnit
 	void TransformNormal(const InputVertexData *src, bool nbt, OutputVertexData *dst);
 	void TransformColor(const InputVertexData *src, OutputVertexData *dst);
 	void TransformTexCoord(const InputVertexData *src, OutputVertexData *dst, bool specialCase);
+
+	// Same results as TransformPosition and TransformNormal for count <= BATCH_SIZE
+	// vertices, written to separate arrays so that the setup unit can be
+	// filled one vertex at a time
+	void TransformPositions(const InputVertexData *src, int count, Vec3 *mvPosition, Vec4 *projectedPosition);
+	void TransformNormals(const InputVertexData *src, int count, bool nbt, Vec3 (*normal)[3]);
 }
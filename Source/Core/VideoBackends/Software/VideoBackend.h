@@ -40,6 +40,7 @@ class VideoSoftware : public VideoBackend
 	void Video_DrawTexture(int texID, float *coords);
 
 	void Video_SetRendering(bool bEnabled) override;
+	void Video_SetPresenting(bool bEnabled) override;
 
 	void Video_GatherPipeBursted() override;
 	bool Video_IsHiWatermarkActive() override;
@@ -68,6 +68,8 @@ VideoConfigDialog::VideoConfigDialog(wxWindow* parent, const std::string& title,
 
 	// rasterizer
 	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Hardware rasterization"), wxT(""), vconfig.bHwRasterizer));
+	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Threaded rasterization"), wxT(""), vconfig.bThreadedRasterizer));
+	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Hierarchical Z"), wxT(""), vconfig.bHierarchicalZ));
 
 	// xfb
 	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Bypass XFB"), wxT(""), vconfig.bBypassXFB));
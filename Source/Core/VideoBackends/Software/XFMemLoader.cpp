@@ -7,6 +7,7 @@
 #include "XFMemLoader.h"
 #include "CPMemLoader.h"
 #include "Clipper.h"
+#include "Rasterizer.h"
 #include "HW/Memmap.h"
 
 XFRegisters swxfregs;
@@ -65,6 +66,12 @@ void SWLoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 
 	if (size > 0)
 	{
+		// the rasterizer reads the viewport and the texture projection flags,
+		// so queued triangles have to be drawn with the old ones
+		u32 topAddress = baseAddress + size;
+		if ((baseAddress < 0x1020 && topAddress > 0x101a) || (baseAddress < 0x1048 && topAddress > 0x1040))
+			Rasterizer::Flush();
+
 		memcpy_gc( &((u32*)&swxfregs)[baseAddress], pData, size * 4);
 		XFWritten(transferSize, baseAddress);
 	}
@@ -6,8 +6,12 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
+#include <deque>
+#include <vector>
+
 #include "AVIDump.h"
 #include "HW/VideoInterface.h" //for TargetRefreshRate
+#include "Thread.h"
 #include "VideoConfig.h"
 
 #ifdef _WIN32
@@ -46,7 +50,10 @@ bool AVIDump::Start(HWND hWnd, int w, int h)
 	m_width = w;
 	m_height = h;
 
-	return CreateFile();
+	if (!CreateFile())
+		return false;
+	StartEncoder();
+	return true;
 }
 
 bool AVIDump::CreateFile()
@@ -141,12 +148,13 @@ void AVIDump::CloseFile()
 
 void AVIDump::Stop()
 {
+	StopEncoder();
 	CloseFile();
 	m_fileCount = 0;
 	NOTICE_LOG(VIDEO, "Stop");
 }
 
-void AVIDump::AddFrame(const u8* data, int w, int h)
+void AVIDump::EncodeFrame(const u8* data, int w, int h)
 {
 	static bool shown_error = false;
 	if ((w != m_bitmap.biWidth || h != m_bitmap.biHeight) && !shown_error)
@@ -240,7 +248,10 @@ bool AVIDump::Start(int w, int h)
 	s_height = h;
 
 	InitAVCodec();
-	return CreateFile();
+	if (!CreateFile())
+		return false;
+	StartEncoder();
+	return true;
 }
 
 bool AVIDump::CreateFile()
@@ -299,7 +310,7 @@ bool AVIDump::CreateFile()
 	return true;
 }
 
-void AVIDump::AddFrame(const u8* data, int width, int height)
+void AVIDump::EncodeFrame(const u8* data, int width, int height)
 {
 	avpicture_fill((AVPicture *)s_BGRFrame, const_cast<u8*>(data), PIX_FMT_BGR24, width, height);
 
@@ -340,6 +351,7 @@ void AVIDump::AddFrame(const u8* data, int width, int height)
 
 void AVIDump::Stop()
 {
+	StopEncoder();
 	av_write_trailer(s_FormatContext);
 	CloseFile();
 	NOTICE_LOG(VIDEO, "Stopping frame dump");
@@ -381,3 +393,102 @@ void AVIDump::CloseFile()
 }
 
 #endif
+
+// Enough to ride out a slow frame of the encoder, and little enough that a
+// few 1080p frames don't add up to much.
+static const size_t MAX_QUEUED_FRAMES = 8;
+
+struct QueuedFrame
+{
+	std::vector<u8> data;
+	int width, height;
+};
+
+static std::thread s_encoder_thread;
+static std::mutex s_queue_lock;
+static std::condition_variable s_queue_changed;
+static std::deque<QueuedFrame> s_queue;
+static std::vector<std::vector<u8>> s_free_buffers;
+static bool s_stop_encoder;
+
+void AVIDump::StartEncoder()
+{
+	s_stop_encoder = false;
+	s_encoder_thread = std::thread(EncoderThread);
+}
+
+void AVIDump::StopEncoder()
+{
+	// Stop is also reached from the encoder thread, when starting the next
+	// file fails. The thread then keeps going until the next Stop.
+	if (!s_encoder_thread.joinable() || std::this_thread::get_id() == s_encoder_thread.get_id())
+		return;
+
+	{
+	std::lock_guard<std::mutex> lk(s_queue_lock);
+	s_stop_encoder = true;
+	}
+	s_queue_changed.notify_all();
+	s_encoder_thread.join();
+	s_free_buffers.clear();
+}
+
+void AVIDump::EncoderThread()
+{
+	Common::SetCurrentThreadName("Frame dump encoder");
+#ifdef _WIN32
+	// The AVI streams are COM objects
+	AVIFileInit();
+#endif
+
+	std::unique_lock<std::mutex> lk(s_queue_lock);
+	while (true)
+	{
+		s_queue_changed.wait(lk, [] { return !s_queue.empty() || s_stop_encoder; });
+		// All frames queued before Stop still make it into the file
+		if (s_queue.empty())
+			break;
+
+		QueuedFrame frame = std::move(s_queue.front());
+		s_queue.pop_front();
+		lk.unlock();
+		s_queue_changed.notify_all();
+
+		EncodeFrame(frame.data.data(), frame.width, frame.height);
+
+		lk.lock();
+		s_free_buffers.push_back(std::move(frame.data));
+	}
+	lk.unlock();
+
+#ifdef _WIN32
+	AVIFileExit();
+#endif
+}
+
+void AVIDump::AddFrame(const u8* data, int width, int height)
+{
+	if (!s_encoder_thread.joinable())
+		return;
+
+	QueuedFrame frame;
+	frame.width = width;
+	frame.height = height;
+	{
+	std::unique_lock<std::mutex> lk(s_queue_lock);
+	s_queue_changed.wait(lk, [] { return s_queue.size() < MAX_QUEUED_FRAMES; });
+	if (!s_free_buffers.empty())
+	{
+		frame.data.swap(s_free_buffers.back());
+		s_free_buffers.pop_back();
+	}
+	}
+
+	frame.data.assign(data, data + 3 * width * height);
+
+	{
+	std::lock_guard<std::mutex> lk(s_queue_lock);
+	s_queue.push_back(std::move(frame));
+	}
+	s_queue_changed.notify_all();
+}
@@ -12,6 +12,9 @@
 
 #include "CommonTypes.h"
 
+// Frames are encoded on a thread of their own. AddFrame only copies the
+// frame into a bounded queue, and waits only when the encoder falls more
+// than the queue behind.
 class AVIDump
 {
 	private:
@@ -21,6 +24,11 @@ class AVIDump
 		static bool SetCompressionOptions();
 		static bool SetVideoFormat();
 
+		static void EncodeFrame(const u8* data, int width, int height);
+		static void StartEncoder();
+		static void StopEncoder();
+		static void EncoderThread();
+
 	public:
 #ifdef _WIN32
 		static bool Start(HWND hWnd, int w, int h);
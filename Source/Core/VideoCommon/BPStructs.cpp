@@ -12,12 +12,15 @@
 #include "PixelEngine.h"
 #include "BPFunctions.h"
 #include "BPStructs.h"
+#include "TextureCacheBase.h"
 #include "TextureDecoder.h"
 #include "VertexLoader.h"
 #include "VertexShaderManager.h"
+#include "VertexManagerBase.h"
 #include "Thread.h"
 #include "HW/Memmap.h"
 #include "PerfQueryBase.h"
+#include "ShaderGenCommon.h"
 
 using namespace BPFunctions;
 
@@ -35,12 +38,90 @@ void BPInit()
 {
 	memset(&bpmem, 0, sizeof(bpmem));
 	bpmem.bpMask = 0xFFFFFF;
+	InvalidateShaderUids();
 }
 
 void RenderToXFB(const BPCmd &bp, const EFBRectangle &rc, float yScale, float xfbLines, u32 xfbAddr, const u32 dstWidth, const u32 dstHeight, float gamma)
 {
 	Renderer::RenderToXFB(xfbAddr, dstWidth, dstHeight, rc, gamma);
 }
+// Registers which only hold the parameters of a later EFB copy, TMEM preload or TLUT load.
+// Pending primitives don't depend on them, and the command which uses them flushes anyway.
+static bool IsCommandParameter(u32 address)
+{
+	switch (address)
+	{
+	case BPMEM_DISPLAYCOPYFILER:
+	case BPMEM_DISPLAYCOPYFILER+1:
+	case BPMEM_DISPLAYCOPYFILER+2:
+	case BPMEM_DISPLAYCOPYFILER+3:
+	case BPMEM_EFB_TL:
+	case BPMEM_EFB_BR:
+	case BPMEM_EFB_ADDR:
+	case BPMEM_MIPMAP_STRIDE:
+	case BPMEM_COPYYSCALE:
+	case BPMEM_CLEAR_AR:
+	case BPMEM_CLEAR_GB:
+	case BPMEM_CLEAR_Z:
+	case BPMEM_COPYFILTER0:
+	case BPMEM_COPYFILTER1:
+	case BPMEM_PRELOAD_ADDR:
+	case BPMEM_PRELOAD_TMEMEVEN:
+	case BPMEM_PRELOAD_TMEMODD:
+	case BPMEM_LOADTLUT0:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Texture registers of a texture map the pending primitives don't sample.
+// Games often set up the next texture before the TEV stages which use it, and
+// the TEV changes flush anyway, so consecutive draws which only differ in
+// textures they don't use end up in the same batch.
+static bool IsUnusedTextureReg(u32 address)
+{
+	u32 texmap;
+	if (address >= BPMEM_TX_SETMODE0 && address < BPMEM_TX_SETTLUT + 4)
+		texmap = address & 3;
+	else if (address >= BPMEM_TX_SETMODE0_4 && address < BPMEM_TX_SETLUT_4 + 4)
+		texmap = (address & 3) + 4;
+	else
+		return false;
+
+	return !(VertexManager::GetUsedTextures() & (1 << texmap));
+}
+
+// Registers which only end up in the pixel shader constants
+static bool IsShaderConstantReg(u32 address)
+{
+	switch (address)
+	{
+	case BPMEM_IND_MTXA:
+	case BPMEM_IND_MTXB:
+	case BPMEM_IND_MTXC:
+	case BPMEM_IND_MTXA+3:
+	case BPMEM_IND_MTXB+3:
+	case BPMEM_IND_MTXC+3:
+	case BPMEM_IND_MTXA+6:
+	case BPMEM_IND_MTXB+6:
+	case BPMEM_IND_MTXC+6:
+	case BPMEM_RAS1_SS0:
+	case BPMEM_RAS1_SS1:
+	case BPMEM_TEV_REGISTER_L:
+	case BPMEM_TEV_REGISTER_H:
+	case BPMEM_TEV_REGISTER_L+2:
+	case BPMEM_TEV_REGISTER_H+2:
+	case BPMEM_TEV_REGISTER_L+4:
+	case BPMEM_TEV_REGISTER_H+4:
+	case BPMEM_TEV_REGISTER_L+6:
+	case BPMEM_TEV_REGISTER_H+6:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void BPWritten(const BPCmd& bp)
 {
 	/*
@@ -81,9 +162,14 @@ void BPWritten(const BPCmd& bp)
 		}
 	}
 
-	FlushPipeline();
+	if (IsShaderConstantReg(bp.address))
+		VertexManager::Flush(true);
+	else if (!IsCommandParameter(bp.address) && !IsUnusedTextureReg(bp.address))
+		FlushPipeline();
 
 	((u32*)&bpmem)[bp.address] = bp.newvalue;
+	if (bp.changes && IsShaderUidBPReg(bp.address))
+		InvalidateShaderUids();
 
 	switch (bp.address)
 	{
@@ -178,6 +264,9 @@ void BPWritten(const BPCmd& bp)
 		switch (bp.newvalue & 0xFF)
 		{
 		case 0x02:
+			// The CPU may read back EFB copies once it hears about this
+			TextureCache::FlushEFBCopies();
+			TextureCache::ExpireHashes();
 			PixelEngine::SetFinish(); // may generate interrupt
 			DEBUG_LOG(VIDEO, "GXSetDrawDone SetPEFinish (value: 0x%02X)", (bp.newvalue & 0xFFFF));
 			break;
@@ -188,10 +277,14 @@ void BPWritten(const BPCmd& bp)
 		}
 		break;
 	case BPMEM_PE_TOKEN_ID: // Pixel Engine Token ID
+		TextureCache::FlushEFBCopies();
+		TextureCache::ExpireHashes();
 		PixelEngine::SetToken(static_cast<u16>(bp.newvalue & 0xFFFF), false);
 		DEBUG_LOG(VIDEO, "SetPEToken 0x%04x", (bp.newvalue & 0xFFFF));
 		break;
 	case BPMEM_PE_TOKEN_INT_ID: // Pixel Engine Interrupt Token ID
+		TextureCache::FlushEFBCopies();
+		TextureCache::ExpireHashes();
 		PixelEngine::SetToken(static_cast<u16>(bp.newvalue & 0xFFFF), true);
 		DEBUG_LOG(VIDEO, "SetPEToken + INT 0x%04x", (bp.newvalue & 0xFFFF));
 		break;
@@ -214,6 +307,9 @@ void BPWritten(const BPCmd& bp)
 
 			UPE_Copy PE_copy = bpmem.triggerEFBCopy;
 
+			// Both kinds of copies write RAM that may hold textures
+			TextureCache::ExpireHashes();
+
 			// Check if we are to copy from the EFB or draw to the XFB
 			if (PE_copy.copy_to_xfb == 0)
 			{
@@ -230,6 +326,8 @@ void BPWritten(const BPCmd& bp)
 				// here. Not sure if there's a better spot to put this.
 				// the number of lines copied is determined by the y scale * source efb height
 
+				if (PixelEngine::bbox_active && g_ActiveConfig.GPUBBoxEnabled())
+					InvalidateShaderUids();
 				PixelEngine::bbox_active = false;
 
 				float yScale;
@@ -267,16 +365,20 @@ void BPWritten(const BPCmd& bp)
 			u32 tlutTMemAddr = (bp.newvalue & 0x3FF) << 9;
 			u32 tlutXferCount = (bp.newvalue & 0x1FFC00) >> 5;
 
-			u8 *ptr = 0;
+			u32 tlutSrcAddr;
 
 			// TODO - figure out a cleaner way.
 			if (GetConfig(CONFIG_ISWII))
-				ptr = GetPointer(bpmem.tmem_config.tlut_src << 5);
+				tlutSrcAddr = bpmem.tmem_config.tlut_src << 5;
 			else
-				ptr = GetPointer((bpmem.tmem_config.tlut_src & 0xFFFFF) << 5);
+				tlutSrcAddr = (bpmem.tmem_config.tlut_src & 0xFFFFF) << 5;
+			u8 *ptr = GetPointer(tlutSrcAddr);
 
 			if (ptr)
+			{
+				TextureCache::FlushEFBCopies(tlutSrcAddr, tlutXferCount);
 				memcpy_gc(texMem + tlutTMemAddr, ptr, tlutXferCount);
+			}
 			else
 				PanicAlert("Invalid palette pointer %08x %08x %08x", bpmem.tmem_config.tlut_src, bpmem.tmem_config.tlut_src << 5, (bpmem.tmem_config.tlut_src & 0xFFFFF)<< 5);
 
@@ -380,11 +482,21 @@ void BPWritten(const BPCmd& bp)
 
 			PixelEngine::bbox[offset]     = bp.newvalue & 0x3ff;
 			PixelEngine::bbox[offset | 1] = bp.newvalue >> 10;
+
+			if (g_ActiveConfig.GPUBBoxEnabled())
+			{
+				g_renderer->BBoxWrite(offset, PixelEngine::bbox[offset]);
+				g_renderer->BBoxWrite(offset | 1, PixelEngine::bbox[offset | 1]);
+				if (!PixelEngine::bbox_active)
+					InvalidateShaderUids();
+			}
 			PixelEngine::bbox_active = true;
 		}
 		break;
 	case BPMEM_TEXINVALIDATE:
 		// TODO: Needs some restructuring in TextureCacheBase.
+		// Games invalidate the texture cache after changing textures in RAM
+		TextureCache::ExpireHashes();
 		break;
 
 	case BPMEM_ZCOMPARE:      // Set the Z-Compare and EFB pixel format
@@ -442,6 +554,8 @@ void BPWritten(const BPCmd& bp)
 			BPS_TmemConfig& tmem_cfg = bpmem.tmem_config;
 			u8* src_ptr = Memory::GetPointer(tmem_cfg.preload_addr << 5); // TODO: Should we add mask here on GC?
 			u32 size = tmem_cfg.preload_tile_info.count * TMEM_LINE_SIZE;
+			TextureCache::FlushEFBCopies(tmem_cfg.preload_addr << 5, size);
+			TextureCache::ExpireHashes();
 			u32 tmem_addr_even = tmem_cfg.preload_tmem_even * TMEM_LINE_SIZE;
 
 			if (tmem_cfg.preload_tile_info.type != 3)
@@ -2,10 +2,15 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
 #include "Common.h"
 #include "VideoCommon.h"
 #include "VideoConfig.h"
 #include "MathUtil.h"
+#include "PerfTrace.h"
 #include "Thread.h"
 #include "Atomic.h"
 #include "Fifo.h"
@@ -53,6 +58,18 @@ volatile bool interruptFinishWaiting = false;
 
 volatile u32 VITicks = CommandProcessor::m_cpClockOrigin;
 
+struct DeterministicEvent
+{
+	int type;
+	u64 userdata;
+};
+
+static bool s_deterministic = false;
+static std::mutex s_deterministic_lock;
+static std::vector<DeterministicEvent> s_deterministic_events;
+// Bytes the CPU wrote since the GPU last ran dry at a sync point
+static u32 s_written_since_sync = 0;
+
 bool IsOnThread()
 {
 	return SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread;
@@ -84,6 +101,10 @@ void DoState(PointerWrap &p)
 	p.Do(interruptWaiting);
 	p.Do(interruptTokenWaiting);
 	p.Do(interruptFinishWaiting);
+
+	std::lock_guard<std::mutex> lk(s_deterministic_lock);
+	p.Do(s_deterministic_events);
+	p.Do(s_written_since_sync);
 }
 
 inline void WriteLow (volatile u32& _reg, u16 lowbits)  {Common::AtomicStore(_reg,(_reg & 0xFFFF0000) | lowbits);}
@@ -127,6 +148,10 @@ void Init()
 	bProcessFifoAllDistance = false;
 	isPossibleWaitingSetDrawDone = false;
 	isHiWatermarkActive = false;
+
+	s_deterministic = IsOnThread() && SConfig::GetInstance().m_LocalCoreStartupParameter.bDeterministicDualCore;
+	s_deterministic_events.clear();
+	s_written_since_sync = 0;
 	isLoWatermarkActive = false;
 
 	et_UpdateInterrupts = CoreTiming::RegisterEvent("CPInterrupt", UpdateInterrupts_Wrapper);
@@ -208,6 +233,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 
 	mmio->Register(base | STATUS_REGISTER,
 		MMIO::ComplexRead<u16>([](u32) {
+			SyncGPU();
 			SetCpStatusRegister();
 			return m_CPStatusReg.Hex;
 		}),
@@ -245,6 +271,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 	mmio->Register(base | FIFO_RW_DISTANCE_LO,
 		IsOnThread()
 			? MMIO::ComplexRead<u16>([](u32) {
+				SyncGPU();
 				if (fifo.CPWritePointer >= fifo.SafeCPReadPointer)
 					return ReadLow(fifo.CPWritePointer - fifo.SafeCPReadPointer);
 				else
@@ -256,6 +283,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 	mmio->Register(base | FIFO_RW_DISTANCE_HI,
 		IsOnThread()
 			? MMIO::ComplexRead<u16>([](u32) {
+				SyncGPU();
 				if (fifo.CPWritePointer >= fifo.SafeCPReadPointer)
 					return ReadHigh(fifo.CPWritePointer - fifo.SafeCPReadPointer);
 				else
@@ -279,13 +307,19 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 	);
 	mmio->Register(base | FIFO_READ_POINTER_LO,
 		IsOnThread()
-			? MMIO::DirectRead<u16>(MMIO::Utils::LowPart(&fifo.SafeCPReadPointer))
+			? MMIO::ComplexRead<u16>([](u32) {
+				SyncGPU();
+				return ReadLow(fifo.SafeCPReadPointer);
+			  })
 			: MMIO::DirectRead<u16>(MMIO::Utils::LowPart(&fifo.CPReadPointer)),
 		MMIO::DirectWrite<u16>(MMIO::Utils::LowPart(&fifo.CPReadPointer), 0xFFE0)
 	);
 	mmio->Register(base | FIFO_READ_POINTER_HI,
 		IsOnThread()
-			? MMIO::DirectRead<u16>(MMIO::Utils::HighPart(&fifo.SafeCPReadPointer))
+			? MMIO::ComplexRead<u16>([](u32) {
+				SyncGPU();
+				return ReadHigh(fifo.SafeCPReadPointer);
+			  })
 			: MMIO::DirectRead<u16>(MMIO::Utils::HighPart(&fifo.CPReadPointer)),
 		IsOnThread()
 			? MMIO::ComplexWrite<u16>([](u32, u16 val) {
@@ -319,8 +353,19 @@ void STACKALIGN GatherPipeBursted()
 		return;
 	}
 
-	if (IsOnThread())
+	// The distance the GPU left is different every run, the deterministic
+	// mode only raises the watermark interrupts at its sync points and syncs
+	// before the GPU could fall behind as far as the high watermark
+	if (s_deterministic)
+	{
+		s_written_since_sync += GATHER_PIPE_SIZE;
+		if (s_written_since_sync >= fifo.CPHiWatermark)
+			SyncGPU();
+	}
+	else if (IsOnThread())
+	{
 		SetCpStatus(true);
+	}
 
 	// update the fifo pointer
 	if (fifo.CPWritePointer >= fifo.CPEnd)
@@ -332,6 +377,8 @@ void STACKALIGN GatherPipeBursted()
 
 	if (!IsOnThread())
 		RunGpu();
+	else
+		Fifo_WakeGpuThread();
 
 	_assert_msg_(COMMANDPROCESSOR, fifo.CPReadWriteDistance <= fifo.CPEnd - fifo.CPBase,
 	"FIFO is overflowed by GatherPipe !\nCPU thread is too fast!");
@@ -357,6 +404,7 @@ void UpdateInterrupts(u64 userdata)
 		ProcessorInterface::SetInterrupt(INT_CAUSE_CP, false);
 	}
 	interruptWaiting = false;
+	Fifo_WakeGpuThread();
 }
 
 void UpdateInterruptsFromVideoBackend(u64 userdata)
@@ -423,6 +471,9 @@ void SetCpStatus(bool isCPUThread)
 				if (!isCPUThread)
 				{
 					// GPU thread:
+					// The deterministic mode raises it at the next sync point
+					if (s_deterministic)
+						return;
 					interruptWaiting = true;
 					CommandProcessor::UpdateInterruptsFromVideoBackend(userdata);
 				}
@@ -446,6 +497,7 @@ void ProcessFifoToLoWatermark()
 {
 	if (IsOnThread())
 	{
+		PERF_SCOPE(CAT_FIFO_WAIT);
 		while (!CommandProcessor::interruptWaiting && fifo.bFF_GPReadEnable &&
 			fifo.CPReadWriteDistance > fifo.CPLoWatermark && !AtBreakpoint())
 			Common::YieldCPU();
@@ -457,6 +509,7 @@ void ProcessFifoAllDistance()
 {
 	if (IsOnThread())
 	{
+		PERF_SCOPE(CAT_FIFO_WAIT);
 		while (!CommandProcessor::interruptWaiting && fifo.bFF_GPReadEnable &&
 			fifo.CPReadWriteDistance && !AtBreakpoint())
 			Common::YieldCPU();
@@ -535,6 +588,7 @@ void SetCpControlRegister()
 		, m_CPCtrlReg.GPLinkEnable           ? "ON" : "OFF"
 		);
 
+	Fifo_WakeGpuThread();
 }
 
 // NOTE: The implementation of this function should be correct, but we intentionally aren't using it at the moment.
@@ -550,10 +604,80 @@ void SetCpClearRegister()
 
 void Update()
 {
-	while (VITicks > m_cpClockOrigin && fifo.isGpuReadingData && IsOnThread())
+	if (s_deterministic)
+	{
+		SyncGPU();
+		return;
+	}
+
+	// With a sync distance the CPU only waits once the GPU is that many
+	// cycles behind, reads of GPU state catch up in SyncGPU instead
+	const u32 max_distance = (u32)std::max(SConfig::GetInstance().m_LocalCoreStartupParameter.iSyncGpuMaxDistance, 0);
+	while (VITicks > m_cpClockOrigin + max_distance && fifo.isGpuReadingData && IsOnThread())
 		Common::YieldCPU();
 
 	if (fifo.isGpuReadingData)
 		Common::AtomicAdd(VITicks, SystemTimers::GetTicksPerSecond() / 10000);
 }
+
+static void SyncDeterministic()
+{
+	PERF_SCOPE(CAT_FIFO_WAIT);
+
+	// Wait until the GPU ran dry or stopped at a breakpoint, which only
+	// depends on what the CPU wrote
+	Fifo_WakeGpuThread();
+	while (Fifo_IsGpuLoopRunning() && (Common::AtomicLoad(fifo.isGpuReadingData) ||
+	       (fifo.bFF_GPReadEnable && Common::AtomicLoad(fifo.CPReadWriteDistance) && !AtBreakpoint())))
+		Common::YieldCPU();
+	s_written_since_sync = 0;
+
+	std::vector<DeterministicEvent> events;
+	{
+		std::lock_guard<std::mutex> lk(s_deterministic_lock);
+		events.swap(s_deterministic_events);
+	}
+	for (const DeterministicEvent& event : events)
+		CoreTiming::ScheduleEvent_Threadsafe_Immediate(event.type, event.userdata);
+
+	SetCpStatus(true);
+}
+
+bool IsDeterministic()
+{
+	return s_deterministic;
+}
+
+void QueueDeterministicEvent(int event_type, u64 userdata)
+{
+	DeterministicEvent event = { event_type, userdata };
+	std::lock_guard<std::mutex> lk(s_deterministic_lock);
+	s_deterministic_events.push_back(event);
+}
+
+void RemoveDeterministicEvents(int event_type)
+{
+	std::lock_guard<std::mutex> lk(s_deterministic_lock);
+	s_deterministic_events.erase(std::remove_if(s_deterministic_events.begin(), s_deterministic_events.end(),
+		[event_type](const DeterministicEvent& event) { return event.type == event_type; }),
+		s_deterministic_events.end());
+}
+
+void SyncGPU()
+{
+	if (s_deterministic)
+	{
+		SyncDeterministic();
+		return;
+	}
+
+	const SCoreStartupParameter& param = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	if (!param.bCPUThread || !param.bSyncGPU || param.iSyncGpuMaxDistance <= 0)
+		return;
+
+	// Let the GPU use up the budget the CPU gave it so far, which means it
+	// has processed everything queued up to the last CP_PERIOD
+	while (Common::AtomicLoad(VITicks) > m_cpClockOrigin && fifo.isGpuReadingData)
+		Common::YieldCPU();
+}
 } // end of namespace CommandProcessor
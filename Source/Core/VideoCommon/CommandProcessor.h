@@ -153,6 +153,15 @@ void ProcessFifoEvents();
 void AbortFrame();
 
 void Update();
+// Called by the CPU thread before it reads state the GPU produces, like the
+// PE token, the bounding box or the EFB, when the CPU may run ahead
+void SyncGPU();
+
+// With bDeterministicDualCore the GPU thread's events only reach the CPU at
+// the sync points, once the GPU has processed everything written before them
+bool IsDeterministic();
+void QueueDeterministicEvent(int event_type, u64 userdata);
+void RemoveDeterministicEvents(int event_type);
 extern volatile u32 VITicks;
 
 } // namespace CommandProcessor
@@ -9,6 +9,10 @@ typedef float float4[4];
 typedef u32 uint4[4];
 typedef s32 int4[4];
 
+// With multi-draw, the constant blocks are arrays with one element per draw
+// of a batch, see VertexManager::Flush
+#define MULTIDRAW_BATCH_SIZE 16
+
 struct PixelShaderConstants
 {
 	float4 colors[4];
@@ -2,11 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "IniFile.h"
 #include "Debugger.h"
 #include "FileUtil.h"
+#include "StringUtil.h"
 
 #include "VideoConfig.h"
+#include "BPMemory.h"
+#include "OnScreenDisplay.h"
 #include "TextureCacheBase.h"
 #include "PixelShaderGen.h"
 #include "VertexShaderGen.h"
@@ -79,6 +87,207 @@ void ContinueGFXDebugger()
 }
 
 
+GFXDebuggerDrawTimer *g_draw_timer = NULL;
+bool GFXDebuggerCapturing = false;
+
+namespace
+{
+
+struct CapturedTexture
+{
+	u32 address;
+	u16 width;
+	u16 height;
+	u32 format;
+};
+
+struct CapturedDraw
+{
+	u32 frame;
+	u32 index;  // in the frame
+	u64 pixel_shader;
+	u64 vertex_shader;
+	u32 num_vertices;
+	u32 num_indices;
+	u32 num_textures;
+	CapturedTexture textures[8];
+	u64 gpu_time;  // ns
+};
+
+std::mutex s_capture_lock;
+u32 s_requested_frames = 0;
+std::string s_requested_filename;
+
+std::vector<CapturedDraw> s_draws;
+std::string s_capture_filename;
+u32 s_capture_frame;
+u32 s_capture_frames;
+u32 s_frame_draws;
+
+void WriteCaptureReport()
+{
+	bool timed = g_draw_timer != NULL;
+	u64 total = 0;
+	for (u32 i = 0; i < s_draws.size(); ++i)
+	{
+		if (timed)
+			s_draws[i].gpu_time = g_draw_timer->GetElapsed(2 * i, 2 * i + 1);
+		total += s_draws[i].gpu_time;
+	}
+
+	struct ShaderCost
+	{
+		u32 draws;
+		u32 vertices;
+		u64 gpu_time;
+	};
+	std::map<std::pair<u64, u64>, ShaderCost> shaders;
+	for (const CapturedDraw& draw : s_draws)
+	{
+		ShaderCost& cost = shaders[std::make_pair(draw.pixel_shader, draw.vertex_shader)];
+		cost.draws++;
+		cost.vertices += draw.num_vertices;
+		cost.gpu_time += draw.gpu_time;
+	}
+
+	std::vector<std::pair<std::pair<u64, u64>, ShaderCost>> sorted_shaders(shaders.begin(), shaders.end());
+	std::stable_sort(sorted_shaders.begin(), sorted_shaders.end(),
+		[](const std::pair<std::pair<u64, u64>, ShaderCost>& a, const std::pair<std::pair<u64, u64>, ShaderCost>& b) {
+			return a.second.gpu_time > b.second.gpu_time;
+		});
+
+	std::vector<const CapturedDraw*> sorted_draws;
+	for (const CapturedDraw& draw : s_draws)
+		sorted_draws.push_back(&draw);
+	std::stable_sort(sorted_draws.begin(), sorted_draws.end(),
+		[](const CapturedDraw* a, const CapturedDraw* b) { return a->gpu_time > b->gpu_time; });
+
+	const double total_ms = total / 1000000.0;
+	std::string report = StringFromFormat("%u draws in %u frames, %.3f ms of GPU time\n",
+		(u32)s_draws.size(), s_capture_frames, total_ms);
+	if (!timed)
+		report += "The video backend has no timestamp queries, only the draws were recorded\n";
+
+	report += "\nBy shader:\n"
+		"     ms      %  draws  vertices  pixel shader      vertex shader\n";
+	for (const auto& entry : sorted_shaders)
+	{
+		const ShaderCost& cost = entry.second;
+		report += StringFromFormat("%7.3f %6.2f %6u %9u  %016llx  %016llx\n",
+			cost.gpu_time / 1000000.0, total ? cost.gpu_time * 100.0 / total : 0.0,
+			cost.draws, cost.vertices,
+			(unsigned long long)entry.first.first, (unsigned long long)entry.first.second);
+	}
+
+	report += "\nBy draw:\n"
+		"     ms      %  frame   draw  vertices  indices  pixel shader      vertex shader     textures (address format width x height)\n";
+	for (const CapturedDraw* draw : sorted_draws)
+	{
+		report += StringFromFormat("%7.3f %6.2f %6u %6u %9u %8u  %016llx  %016llx ",
+			draw->gpu_time / 1000000.0, total ? draw->gpu_time * 100.0 / total : 0.0,
+			draw->frame, draw->index, draw->num_vertices, draw->num_indices,
+			(unsigned long long)draw->pixel_shader, (unsigned long long)draw->vertex_shader);
+		for (u32 t = 0; t < draw->num_textures; ++t)
+		{
+			const CapturedTexture& tex = draw->textures[t];
+			report += StringFromFormat(" %08x %x %ux%u", tex.address, tex.format, tex.width, tex.height);
+		}
+		report += "\n";
+	}
+
+	if (File::CreateFullPath(s_capture_filename) && File::WriteStringToFile(report, s_capture_filename.c_str()))
+		OSD::AddMessage(StringFromFormat("Draw timings written to %s", s_capture_filename.c_str()));
+	else
+		OSD::AddMessage(StringFromFormat("Failed to write %s", s_capture_filename.c_str()));
+}
+
+}  // namespace
+
+void GFXDebuggerCaptureDraws(u32 frames, const std::string& filename)
+{
+	std::lock_guard<std::mutex> lk(s_capture_lock);
+	s_requested_frames = frames;
+	s_requested_filename = filename;
+}
+
+void GFXDebuggerBeginDraw(u32 num_vertices, u32 num_indices, u32 used_textures)
+{
+	CapturedDraw draw;
+	draw.frame = s_capture_frame;
+	draw.index = s_frame_draws++;
+	draw.num_vertices = num_vertices;
+	draw.num_indices = num_indices;
+	draw.gpu_time = 0;
+
+	// The same UIDs the shader caches look up, so the hashes match the ones in their dumps
+	const u32 components = g_nativeVertexFmt ? g_nativeVertexFmt->m_components : 0;
+	const API_TYPE api = g_ActiveConfig.backend_info.APIType;
+	bool useDstAlpha = !g_ActiveConfig.bDstAlphaPass && bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate
+		&& bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24;
+	PixelShaderUid puid;
+	GetPixelShaderUid(puid, useDstAlpha && g_ActiveConfig.backend_info.bSupportsDualSourceBlend ?
+		DSTALPHA_DUAL_SOURCE_BLEND : DSTALPHA_NONE, api, components);
+	VertexShaderUid vuid;
+	GetVertexShaderUid(vuid, components, api);
+	draw.pixel_shader = puid.GetHash();
+	draw.vertex_shader = vuid.GetHash();
+
+	draw.num_textures = 0;
+	for (u32 i = 0; i < 8; ++i)
+	{
+		if (!(used_textures & (1 << i)))
+			continue;
+		const FourTexUnits &tex = bpmem.tex[i >> 2];
+		CapturedTexture& captured = draw.textures[draw.num_textures++];
+		captured.address = tex.texImage3[i&3].image_base << 5;
+		captured.width = tex.texImage0[i&3].width + 1;
+		captured.height = tex.texImage0[i&3].height + 1;
+		captured.format = tex.texImage0[i&3].format;
+	}
+
+	if (g_draw_timer)
+		g_draw_timer->Timestamp(2 * (u32)s_draws.size());
+	s_draws.push_back(draw);
+}
+
+void GFXDebuggerEndDraw()
+{
+	if (g_draw_timer)
+		g_draw_timer->Timestamp(2 * (u32)s_draws.size() - 1);
+}
+
+void GFXDebuggerCaptureFrame()
+{
+	if (GFXDebuggerCapturing)
+	{
+		if (g_draw_timer)
+			g_draw_timer->EndFrame();
+		s_frame_draws = 0;
+		if (++s_capture_frame == s_capture_frames)
+		{
+			GFXDebuggerCapturing = false;
+			WriteCaptureReport();
+			s_draws.clear();
+			s_draws.shrink_to_fit();
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk(s_capture_lock);
+	if (s_requested_frames)
+	{
+		s_capture_frames = s_requested_frames;
+		s_capture_filename = s_requested_filename;
+		s_requested_frames = 0;
+		s_capture_frame = 0;
+		s_frame_draws = 0;
+		s_draws.clear();
+		if (g_draw_timer)
+			g_draw_timer->Reset();
+		GFXDebuggerCapturing = true;
+	}
+}
+
 void GFXDebuggerBase::DumpPixelShader(const char* path)
 {
 	char filename[MAX_PATH];
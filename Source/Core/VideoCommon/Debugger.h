@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <string>
+
+#include "CommonTypes.h"
+
 class GFXDebuggerBase
 {
 public:
@@ -58,6 +62,40 @@ void GFXDebuggerCheckAndPause(bool update);
 void GFXDebuggerToPause(bool update);
 void GFXDebuggerUpdateScreen();
 
+// Draw capture: times every VertexManager::Flush on the GPU for a few frames,
+// without pausing, and writes a per-draw cost breakdown once they are done.
+// The backends that have timestamp queries provide the timer, the others only
+// record what was drawn.
+class GFXDebuggerDrawTimer
+{
+public:
+	virtual ~GFXDebuggerDrawTimer() {}
+
+	// Drops the queries of the previous capture
+	virtual void Reset() = 0;
+	// Writes a timestamp query to the command stream
+	virtual void Timestamp(u32 index) = 0;
+	// Called after each captured frame was presented
+	virtual void EndFrame() {}
+	// Waits for both queries and returns the GPU time between them in
+	// nanoseconds, 0 if it isn't known
+	virtual u64 GetElapsed(u32 begin, u32 end) = 0;
+};
+
+extern GFXDebuggerDrawTimer *g_draw_timer;
+extern bool GFXDebuggerCapturing;
+
+// Starts a capture of the given number of frames at the next frame. The report
+// is written to filename. Called from any thread.
+void GFXDebuggerCaptureDraws(u32 frames, const std::string& filename);
+
+// GPU thread, around vFlush while GFXDebuggerCapturing is set
+void GFXDebuggerBeginDraw(u32 num_vertices, u32 num_indices, u32 used_textures);
+void GFXDebuggerEndDraw();
+
+// GPU thread, once a frame was presented
+void GFXDebuggerCaptureFrame();
+
 #define GFX_DEBUGGER_PAUSE_AT(event,update) {if (((GFXDebuggerToPauseAtNext & event) && --GFXDebuggerEventToPauseCount<=0) || GFXDebuggerPauseFlag) GFXDebuggerToPause(update);}
 #define GFX_DEBUGGER_PAUSE_LOG_AT(event,update,dumpfunc) {if (((GFXDebuggerToPauseAtNext & event) && --GFXDebuggerEventToPauseCount<=0) || GFXDebuggerPauseFlag) {{dumpfunc};GFXDebuggerToPause(update);}}
 #define GFX_DEBUGGER_LOG_AT(event,dumpfunc) {if (( GFXDebuggerToPauseAtNext & event ) ) {{dumpfunc};}}
@@ -0,0 +1,83 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "DynamicResolution.h"
+#include "VideoConfig.h"
+#include "HW/VideoInterface.h"
+
+namespace DynamicResolution
+{
+
+// Frames to wait after a change, so the average catches up with the new scale
+static const u32 SETTLE_FRAMES = 30;
+// Parts of the frame budget. Above the first the scale goes down, it only
+// goes up if the next step is expected to stay under the second.
+static const float DECREASE_THRESHOLD = 0.9f;
+static const float INCREASE_THRESHOLD = 0.75f;
+
+static u32 s_numerator;
+static float s_average_ms;
+static u32 s_frames_since_change;
+static bool s_changed;
+
+// The limits are in percent of the native resolution
+static u32 GetLimit(int percent)
+{
+	return std::min(std::max((u32)std::max(percent, 0) * SCALE_DENOMINATOR / 100, SCALE_DENOMINATOR), 4 * SCALE_DENOMINATOR);
+}
+
+void Init()
+{
+	s_numerator = GetLimit(g_ActiveConfig.iDynamicResolutionMin);
+	s_average_ms = 0.f;
+	s_frames_since_change = 0;
+	s_changed = false;
+}
+
+static void SetNumerator(u32 numerator)
+{
+	// The GPU time mostly grows with the number of pixels
+	const float ratio = (float)numerator / (float)s_numerator;
+	s_average_ms *= ratio * ratio;
+	s_numerator = numerator;
+	s_frames_since_change = 0;
+	s_changed = true;
+}
+
+void AddFrameTime(float ms)
+{
+	s_average_ms = s_average_ms ? s_average_ms * 0.9f + ms * 0.1f : ms;
+	if (++s_frames_since_change < SETTLE_FRAMES || !VideoInterface::TargetRefreshRate)
+		return;
+
+	const u32 min_numerator = GetLimit(g_ActiveConfig.iDynamicResolutionMin);
+	const u32 max_numerator = std::max(GetLimit(g_ActiveConfig.iDynamicResolutionMax), min_numerator);
+	const float budget_ms = 1000.f / VideoInterface::TargetRefreshRate;
+	const float next_ratio = (float)(s_numerator + 1) / (float)s_numerator;
+
+	if (s_numerator > max_numerator)
+		SetNumerator(max_numerator);
+	else if (s_numerator < min_numerator)
+		SetNumerator(min_numerator);
+	else if (s_average_ms > budget_ms * DECREASE_THRESHOLD && s_numerator > min_numerator)
+		SetNumerator(s_numerator - 1);
+	else if (s_average_ms * next_ratio * next_ratio < budget_ms * INCREASE_THRESHOLD && s_numerator < max_numerator)
+		SetNumerator(s_numerator + 1);
+}
+
+u32 GetScaleNumerator()
+{
+	return s_numerator;
+}
+
+bool HasScaleChanged()
+{
+	const bool changed = s_changed;
+	s_changed = false;
+	return changed;
+}
+
+}
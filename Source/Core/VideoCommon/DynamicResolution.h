@@ -0,0 +1,31 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// The internal resolution of SCALE_DYNAMIC. The backends time each frame on
+// the GPU, and the EFB scale moves in steps of a quarter of the native
+// resolution, between the configured limits, to keep that time within the
+// emulated refresh rate.
+
+#pragma once
+
+#include "CommonTypes.h"
+
+namespace DynamicResolution
+{
+
+// The EFB scale is GetScaleNumerator() / SCALE_DENOMINATOR
+const u32 SCALE_DENOMINATOR = 4;
+
+// Starts over from the lowest scale
+void Init();
+
+// Takes how long the GPU took to render a frame, in milliseconds
+void AddFrameTime(float ms);
+
+u32 GetScaleNumerator();
+
+// True once after the scale changed, the EFB then has to be recreated
+bool HasScaleChanged();
+
+}
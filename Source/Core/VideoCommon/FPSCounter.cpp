@@ -2,8 +2,10 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "ConfigManager.h"
 #include "FPSCounter.h"
 #include "FileUtil.h"
+#include "PerfTrace.h"
 #include "Timer.h"
 #include "VideoConfig.h"
 
@@ -46,6 +48,10 @@ int UpdateFPSCounter()
 			LogFPSToFile(s_fps);
 	}
 
+	PerfTrace::SetEnabled(g_ActiveConfig.bShowFrameTimes ||
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bDumpPerfTrace);
+	PerfTrace::EndFrame();
+
 	s_counter++;
 	return s_fps;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "VideoConfig.h"
 #include "MemoryUtil.h"
 #include "Thread.h"
@@ -11,11 +13,13 @@
 #include "PixelEngine.h"
 #include "ChunkFile.h"
 #include "Fifo.h"
+#include "TextureCacheBase.h"
 #include "HW/Memmap.h"
 #include "Core.h"
 #include "CoreTiming.h"
 
 volatile bool g_bSkipCurrentFrame = false;
+volatile bool g_bSkipCurrentPresent = false;
 extern u8* g_pVideoData;
 
 namespace
@@ -23,14 +27,35 @@ namespace
 static volatile bool GpuRunningState = false;
 static volatile bool EmuRunningState = false;
 static std::mutex m_csHWVidOccupied;
+
+// Idle strategy of the GPU loop: spin for a while, then yield, then park on
+// s_gpu_wakeup until another thread calls Fifo_WakeGpuThread().
+// Every wakeup bumps s_gpu_wakeup_seq with a full barrier, and so does the GPU
+// thread when it announces it is about to park, so a wakeup racing with the
+// park is always noticed by one of the two sides.
+enum
+{
+	GPU_IDLE_SPIN_ITERATIONS = 512,
+	GPU_IDLE_YIELD_ITERATIONS = 64,
+};
+
+// The fifo is decoded in runs of up to this many 32 byte chunks, which keeps
+// the bookkeeping and the peeking at incomplete commands off every chunk
+// while a token or finish interrupt still stops the decoding soon enough
+static const u32 GPU_READAHEAD_CHUNKS = 16;
+static Common::Event s_gpu_wakeup;
+static volatile u32 s_gpu_wakeup_seq = 0;
+static volatile u32 s_gpu_parked = 0;
 // STATE_TO_SAVE
 static u8 *videoBuffer;
 static int size = 0;
+// End of the fifo data in guest memory while it is decoded in place
+static u8 *s_direct_end = NULL;
 }  // namespace
 
 void Fifo_DoState(PointerWrap &p)
 {
-	p.DoArray(videoBuffer, FIFO_SIZE);
+	p.DoRegion(videoBuffer, FIFO_SIZE);
 	p.Do(size);
 	p.DoPointer(g_pVideoData, videoBuffer);
 	p.Do(g_bSkipCurrentFrame);
@@ -76,7 +101,7 @@ u8* GetVideoBufferStartPtr()
 
 u8* GetVideoBufferEndPtr()
 {
-	return &videoBuffer[size];
+	return s_direct_end ? s_direct_end : &videoBuffer[size];
 }
 
 void Fifo_SetRendering(bool enabled)
@@ -84,6 +109,11 @@ void Fifo_SetRendering(bool enabled)
 	g_bSkipCurrentFrame = !enabled;
 }
 
+void Fifo_SetPresenting(bool enabled)
+{
+	g_bSkipCurrentPresent = !enabled;
+}
+
 // May be executed from any thread, even the graphics thread.
 // Created to allow for self shutdown.
 void ExitGpuLoop()
@@ -95,11 +125,22 @@ void ExitGpuLoop()
 	// Terminate GPU thread loop
 	GpuRunningState = false;
 	EmuRunningState = true;
+	Fifo_WakeGpuThread();
 }
 
 void EmulatorState(bool running)
 {
 	EmuRunningState = running;
+	Fifo_WakeGpuThread();
+}
+
+// May be executed from any thread. Has to be called after anything the GPU loop
+// waits for has changed: new fifo data, fifo registers, async requests.
+void Fifo_WakeGpuThread()
+{
+	Common::AtomicIncrement(s_gpu_wakeup_seq);
+	if (Common::AtomicLoad(s_gpu_parked))
+		s_gpu_wakeup.Set();
 }
 
 
@@ -128,6 +169,42 @@ void ResetVideoBuffer()
 	size = 0;
 }
 
+// Decodes len bytes of fifo data that lie in one piece of guest memory.
+// Commands that are left over from the last call get completed in videoBuffer,
+// the rest is decoded where it is, and only an incomplete command at the end
+// is copied over. The data stays in place until the read pointer moves past
+// it, which is only done after this returns.
+static u32 RunFifoData(u8* _uData, u32 len)
+{
+	u32 cyclesExecuted = 0;
+	u32 copied = 0;
+	while (copied < len)
+	{
+		// The bytes left over in videoBuffer are a copy of the end of
+		// the data copied so far as soon as the older ones are decoded
+		const u32 left = (u32)(GetVideoBufferEndPtr() - g_pVideoData);
+		if (left > copied)
+		{
+			const u32 chunk = std::min<u32>(len - copied, 32);
+			ReadDataFromFifo(_uData + copied, chunk);
+			copied += chunk;
+			cyclesExecuted += OpcodeDecoder_Run(g_bSkipCurrentFrame);
+			continue;
+		}
+
+		g_pVideoData = _uData + copied - left;
+		s_direct_end = _uData + len;
+		cyclesExecuted += OpcodeDecoder_Run(g_bSkipCurrentFrame);
+		s_direct_end = NULL;
+
+		u8* const rest = g_pVideoData;
+		ResetVideoBuffer();
+		ReadDataFromFifo(rest, (u32)(_uData + len - rest));
+		break;
+	}
+	return cyclesExecuted;
+}
+
 
 // Description: Main FIFO update loop
 // Purpose: Keep the Core HW updated about the CPU-GPU distance
@@ -137,9 +214,12 @@ void RunGpuLoop()
 	GpuRunningState = true;
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
 	u32 cyclesExecuted = 0;
+	u32 idle_iterations = 0;
 
 	while (GpuRunningState)
 	{
+		const u32 wakeup_seq = Common::AtomicLoad(s_gpu_wakeup_seq);
+
 		g_video_backend->PeekMessages();
 
 		VideoFifo_CheckAsyncRequest();
@@ -151,6 +231,7 @@ void RunGpuLoop()
 		// check if we are able to run this buffer
 		while (GpuRunningState && !CommandProcessor::interruptWaiting && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint())
 		{
+			idle_iterations = 0;
 			fifo.isGpuReadingData = true;
 			CommandProcessor::isPossibleWaitingSetDrawDone = fifo.bFF_GPLinkEnable ? true : false;
 
@@ -159,23 +240,34 @@ void RunGpuLoop()
 				u32 readPtr = fifo.CPReadPointer;
 				u8 *uData = Memory::GetPointer(readPtr);
 
-				if (readPtr == fifo.CPEnd)
-					readPtr = fifo.CPBase;
-				else
-					readPtr += 32;
-
 				_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0 ,
 					"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - 32);
 
-				ReadDataFromFifo(uData, 32);
+				// Take as much of the written fifo data as lies in one piece
+				// of memory before the breakpoint, the sync GPU mode has to
+				// check its cycle budget between the chunks though
+				const u32 maxChunks = Core::g_CoreStartupParameter.bSyncGPU ? 1 : GPU_READAHEAD_CHUNKS;
+				const u32 distance = Common::AtomicLoad(fifo.CPReadWriteDistance);
+				u32 readSize = 0;
+				do
+				{
+					readSize += 32;
+					if (readPtr == fifo.CPEnd)
+					{
+						readPtr = fifo.CPBase;
+						break;
+					}
+					readPtr += 32;
+				} while (readSize < maxChunks * 32 && readSize < distance &&
+				         !(fifo.bFF_BPEnable && readPtr == fifo.CPBreakpoint));
 
-				cyclesExecuted = OpcodeDecoder_Run(g_bSkipCurrentFrame);
+				cyclesExecuted = RunFifoData(uData, readSize);
 
 				if (Core::g_CoreStartupParameter.bSyncGPU && Common::AtomicLoad(CommandProcessor::VITicks) > cyclesExecuted)
 					Common::AtomicAdd(CommandProcessor::VITicks, -(s32)cyclesExecuted);
 
 				Common::AtomicStore(fifo.CPReadPointer, readPtr);
-				Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
+				Common::AtomicAdd(fifo.CPReadWriteDistance, -(s32)readSize);
 				if((GetVideoBufferEndPtr() - g_pVideoData) == 0)
 					Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
 			}
@@ -191,14 +283,27 @@ void RunGpuLoop()
 
 		fifo.isGpuReadingData = false;
 
+		// The CPU may wait for the fifo to run dry before reusing texture memory
+		TextureCache::ExpireHashes();
+
 		if (EmuRunningState)
 		{
 			// NOTE(jsd): Calling SwitchToThread() on Windows 7 x64 is a hot spot, according to profiler.
 			// See https://docs.google.com/spreadsheet/ccc?key=0Ah4nh0yGtjrgdFpDeF9pS3V6RUotRVE3S3J4TGM1NlE#gid=0
 			// for benchmark details.
-#if 0
-			Common::YieldCPU();
-#endif
+			// So only yield and park once the fifo has been empty for a while.
+			++idle_iterations;
+			if (idle_iterations > GPU_IDLE_SPIN_ITERATIONS + GPU_IDLE_YIELD_ITERATIONS)
+			{
+				Common::AtomicIncrement(s_gpu_parked);
+				if (Common::AtomicLoad(s_gpu_wakeup_seq) == wakeup_seq)
+					s_gpu_wakeup.Wait();
+				Common::AtomicDecrement(s_gpu_parked);
+			}
+			else if (idle_iterations > GPU_IDLE_SPIN_ITERATIONS)
+			{
+				Common::YieldCPU();
+			}
 		}
 		else
 		{
@@ -215,6 +320,11 @@ void RunGpuLoop()
 }
 
 
+bool Fifo_IsGpuLoopRunning()
+{
+	return GpuRunningState;
+}
+
 bool AtBreakpoint()
 {
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
@@ -230,8 +340,7 @@ void RunGpu()
 
 		FPURoundMode::SaveSIMDState();
 		FPURoundMode::LoadDefaultSIMDState();
-		ReadDataFromFifo(uData, 32);
-		OpcodeDecoder_Run(g_bSkipCurrentFrame);
+		RunFifoData(uData, 32);
 		FPURoundMode::LoadSIMDState();
 
 		//DEBUG_LOG(COMMANDPROCESSOR, "Fifo wraps to base");
@@ -243,5 +352,6 @@ void RunGpu()
 
 		fifo.CPReadWriteDistance -= 32;
 	}
+	TextureCache::ExpireHashes();
 	CommandProcessor::SetCpStatus();
 }
@@ -12,6 +12,7 @@ class PointerWrap;
 #define FIFO_SIZE (2*1024*1024)
 
 extern volatile bool g_bSkipCurrentFrame;
+extern volatile bool g_bSkipCurrentPresent;
 
 
 void Fifo_Init();
@@ -26,9 +27,12 @@ void RunGpu();
 void RunGpuLoop();
 void ExitGpuLoop();
 void EmulatorState(bool running);
+void Fifo_WakeGpuThread();
 bool AtBreakpoint();
+bool Fifo_IsGpuLoopRunning();
 void ResetVideoBuffer();
 void Fifo_SetRendering(bool bEnabled);
+void Fifo_SetPresenting(bool bEnabled);
 
 
 // Implemented by the Video Backend
@@ -1,8 +1,11 @@
 
 #include "FramebufferManagerBase.h"
 
+#include "Hash.h"
 #include "RenderBase.h"
+#include "TextureCacheBase.h"
 #include "VideoConfig.h"
+#include "HW/Memmap.h"
 
 FramebufferManagerBase *g_framebuffer_manager;
 
@@ -13,6 +16,33 @@ const XFBSourceBase* FramebufferManagerBase::m_overlappingXFBArray[MAX_VIRTUAL_X
 unsigned int FramebufferManagerBase::s_last_xfb_width = 1;
 unsigned int FramebufferManagerBase::s_last_xfb_height = 1;
 
+bool RealXFBTracker::Update(u32 xfbAddr, u32 fbWidth, u32 fbHeight)
+{
+	const u32 size = fbWidth * fbHeight * 2;
+
+	// XFB copies may still be on their way back to RAM
+	TextureCache::FlushEFBCopies(xfbAddr, size);
+
+	const u8* src = Memory::GetPointer(xfbAddr);
+	if (!src)
+	{
+		m_valid = false;
+		return true;
+	}
+
+	// Everything is hashed: the CPU may have drawn anywhere in it, e.g. for movies
+	const u64 hash = GetHash64(src, size, 0);
+	if (m_valid && m_addr == xfbAddr && m_width == fbWidth && m_height == fbHeight && m_hash == hash)
+		return false;
+
+	m_valid = true;
+	m_addr = xfbAddr;
+	m_width = fbWidth;
+	m_height = fbHeight;
+	m_hash = hash;
+	return true;
+}
+
 FramebufferManagerBase::FramebufferManagerBase()
 {
 	m_realXFBSource = NULL;
@@ -9,6 +9,26 @@ inline bool addrRangesOverlap(u32 aLower, u32 aUpper, u32 bLower, u32 bUpper)
 	return !((aLower >= bUpper) || (bLower >= aUpper));
 }
 
+// Real XFB mode converts the YUYV XFB in RAM for every frame shown, even though
+// games often show the same XFB for several fields. This remembers what was
+// converted last so an unchanged XFB can skip the upload and conversion.
+class RealXFBTracker
+{
+public:
+	RealXFBTracker() : m_valid(false) {}
+
+	// Returns true if the XFB differs from the one seen by the last call
+	bool Update(u32 xfbAddr, u32 fbWidth, u32 fbHeight);
+	void Reset() { m_valid = false; }
+
+private:
+	bool m_valid;
+	u32 m_addr;
+	u32 m_width;
+	u32 m_height;
+	u64 m_hash;
+};
+
 struct XFBSourceBase
 {
 	virtual ~XFBSourceBase() {}
@@ -7,104 +7,310 @@
 #include <cstring>
 #include <utility>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <SOIL/SOIL.h>
 #include "CommonPaths.h"
 #include "FileUtil.h"
-#include "FileSearch.h"
+#include "Hash.h"
+#include "MappedFile.h"
 #include "StringUtil.h"
+#include "ThreadPool.h"
 
 namespace HiresTextures
 {
 
-std::map<std::string, std::string> textureMap;
+// Decoded textures are kept around for textures that get recreated, up to
+// this many bytes. The least recently used ones go first.
+static const size_t DECODED_CACHE_SIZE = 128 * 1024 * 1024;
 
-void Init(const char *gameCode)
+struct DecodedLevel
 {
-	textureMap.clear();
+	std::vector<u8> data;
+	unsigned int width, height;
+	PC_TexFormat format;
+};
+
+struct DecodedTexture
+{
+	bool ready;
+	std::vector<DecodedLevel> levels; // empty if level 0 couldn't be decoded
+	size_t size;
+	u32 last_used;
+};
+
+// The cache file is a header, the data of the levels, each aligned to 16
+// bytes, and a table of the levels at table_offset
+static const u32 CACHE_MAGIC = 0x43544844; // "DHTC"
+static const u32 CACHE_VERSION = 1;
+
+struct CacheHeader
+{
+	u32 magic;
+	u32 version;
+	u64 pack_hash; // of the names and sizes of the files in the pack
+	u64 table_offset;
+	u32 num_levels;
+	u32 padding;
+};
+
+struct CacheLevel
+{
+	u64 key;
+	u64 offset;
+	u32 size;
+	u32 width;
+	u32 height;
+	u32 format;
+};
 
-	CFileSearch::XStringVector Directories;
-	//Directories.push_back(File::GetUserPath(D_HIRESTEXTURES_IDX));
-	char szDir[MAX_PATH];
-	sprintf(szDir, "%s%s", File::GetUserPath(D_HIRESTEXTURES_IDX).c_str(), gameCode);
-	Directories.push_back(std::string(szDir));
+// Only changed by Init, so it is read without a lock
+static std::unordered_map<u64, std::string> textureMap;
 
+static std::mutex s_decoded_lock;
+static std::unordered_map<u64, DecodedTexture> s_decoded;
+static size_t s_decoded_size;
+static u32 s_use_counter;
+static Common::TaskGroup* s_decode_tasks;
+
+// Guarded by s_decoded_lock as well, the cache may show up while a game runs
+static File::MappedFile s_cache_file;
+static std::unordered_map<u64, const CacheLevel*> s_cache;
+static std::atomic<bool> s_cancel_build;
+
+static u64 TextureKey(u32 hash, int texformat, unsigned int level)
+{
+	return ((u64)hash << 32) | ((u64)(texformat & 0xFFFFFF) << 8) | (level & 0xFF);
+}
+
+static Common::TaskGroup& DecodeTasks()
+{
+	if (!s_decode_tasks)
+		s_decode_tasks = new Common::TaskGroup;
+	return *s_decode_tasks;
+}
 
-	for (u32 i = 0; i < Directories.size(); i++)
+static void AddTexture(const std::string& code, const std::string& filename)
+{
+	std::string name;
+	SplitPath(filename, NULL, &name, NULL);
+	if (name.compare(0, code.size(), code) != 0)
+		return;
+
+	u32 hash;
+	int texformat;
+	unsigned int level = 0;
+	int length = 0;
+	const char* rest = name.c_str() + code.size();
+	if (sscanf(rest, "%8x_%d%n", &hash, &texformat, &length) < 2)
+		return;
+	rest += length;
+	if (*rest && (sscanf(rest, "_mip%u%n", &level, &length) < 1 || rest[length]))
+		return;
+
+	// The first one found wins, like with the old string map
+	textureMap.emplace(TextureKey(hash, texformat, level), filename);
+}
+
+static void AddTextures(const std::string& code, const File::FSTEntry& dir, std::vector<std::string>* listing)
+{
+	for (const auto& entry : dir.children)
 	{
-		File::FSTEntry FST_Temp;
-		File::ScanDirectoryTree(Directories[i], FST_Temp);
-		for (auto& entry : FST_Temp.children)
+		if (entry.isDirectory)
 		{
-			if (entry.isDirectory)
-			{
-				bool duplicate = false;
-				for (auto& Directory : Directories)
-				{
-					if (strcmp(Directory.c_str(), entry.physicalName.c_str()) == 0)
-					{
-						duplicate = true;
-						break;
-					}
-				}
-				if (!duplicate)
-					Directories.push_back(entry.physicalName.c_str());
-			}
+			AddTextures(code, entry, listing);
+			continue;
+		}
+
+		std::string extension;
+		SplitPath(entry.physicalName, NULL, NULL, &extension);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		// .jpg could be useful for large photo-like textures
+		if (extension == ".png" || extension == ".bmp" || extension == ".tga" || extension == ".dds" ||
+		    extension == ".jpg")
+		{
+			AddTexture(code, entry.physicalName);
+			listing->push_back(StringFromFormat("%s %llu", entry.physicalName.c_str(), (unsigned long long)entry.size));
 		}
 	}
+}
 
-	CFileSearch::XStringVector Extensions;
-	Extensions.push_back("*.png");
-	Extensions.push_back("*.bmp");
-	Extensions.push_back("*.tga");
-	Extensions.push_back("*.dds");
-	Extensions.push_back("*.jpg"); // Why not? Could be useful for large photo-like textures
+static bool OpenCache(const std::string& path, u64 pack_hash)
+{
+	std::lock_guard<std::mutex> lk(s_decoded_lock);
+	s_cache.clear();
+	s_cache_file.Close();
+	if (!s_cache_file.Open(path))
+		return false;
 
-	CFileSearch FileSearch(Extensions, Directories);
-	const CFileSearch::XStringVector& rFilenames = FileSearch.GetFileNames();
-	char code[MAX_PATH];
-	sprintf(code, "%s_", gameCode);
+	const u8* data = s_cache_file.GetData();
+	const u64 size = s_cache_file.GetSize();
+	CacheHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.pack_hash != pack_hash ||
+	    header.table_offset > size || (size - header.table_offset) / sizeof(CacheLevel) < header.num_levels)
+	{
+		s_cache_file.Close();
+		return false;
+	}
+
+	const CacheLevel* table = (const CacheLevel*)(data + header.table_offset);
+	for (u32 i = 0; i < header.num_levels; ++i)
+	{
+		if (table[i].offset > size || size - table[i].offset < table[i].size)
+		{
+			s_cache.clear();
+			s_cache_file.Close();
+			return false;
+		}
+		s_cache[table[i].key] = &table[i];
+	}
+	return true;
+}
+
+static void DecodeLevels(u32 hash, int texformat, std::vector<DecodedLevel>* levels);
+
+static void BuildCache(const std::string& path, u64 pack_hash)
+{
+	std::vector<u64> textures;
+	for (const auto& entry : textureMap)
+	{
+		if ((entry.first & 0xFF) == 0)
+			textures.push_back(entry.first);
+	}
+	std::sort(textures.begin(), textures.end());
+
+	const std::string temp_path = path + ".tmp";
+	File::CreateFullPath(path);
+	File::IOFile file(temp_path, "wb");
+	CacheHeader header = {};
+	if (!file.WriteBytes(&header, sizeof(header)))
+		return;
+
+	NOTICE_LOG(VIDEO, "Building the custom texture cache %s", path.c_str());
 
-	if (rFilenames.size() > 0)
+	std::mutex write_lock;
+	std::vector<CacheLevel> table;
+	u64 offset = sizeof(header);
+	bool write_ok = true;
+	Common::ThreadPool::ParallelFor((int)textures.size(), [&](int begin, int end)
 	{
-		for (auto& rFilename : rFilenames)
+		for (int i = begin; i < end && !s_cancel_build; ++i)
 		{
-			std::string FileName;
-			SplitPath(rFilename, NULL, &FileName, NULL);
+			const u32 hash = (u32)(textures[i] >> 32);
+			const int texformat = (int)((textures[i] >> 8) & 0xFFFFFF);
+			std::vector<DecodedLevel> levels;
+			DecodeLevels(hash, texformat, &levels);
 
-			if (FileName.substr(0, strlen(code)).compare(code) == 0 && textureMap.find(FileName) == textureMap.end())
-				textureMap.insert(std::map<std::string, std::string>::value_type(FileName, rFilename));
+			std::lock_guard<std::mutex> lk(write_lock);
+			for (u32 level = 0; level < levels.size(); ++level)
+			{
+				const DecodedLevel& decoded = levels[level];
+				if (decoded.format == PC_TEX_FMT_NONE)
+					continue;
+
+				static const u8 zeroes[16] = {};
+				const u32 padding = (u32)(-(s64)offset & 15);
+				write_ok &= file.WriteBytes(zeroes, padding) && file.WriteBytes(decoded.data.data(), decoded.data.size());
+				offset += padding;
+
+				CacheLevel entry = { textures[i] | level, offset, (u32)decoded.data.size(), decoded.width,
+					decoded.height, (u32)decoded.format };
+				table.push_back(entry);
+				offset += decoded.data.size();
+			}
 		}
+	});
+
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.pack_hash = pack_hash;
+	header.table_offset = offset;
+	header.num_levels = (u32)table.size();
+	if (!table.empty())
+		write_ok &= file.WriteArray(table.data(), table.size());
+	write_ok &= file.Seek(0, SEEK_SET) && file.WriteBytes(&header, sizeof(header));
+	file.Close();
+
+	if (s_cancel_build || !write_ok)
+	{
+		File::Delete(temp_path);
+		return;
+	}
+
+	File::Delete(path);
+	if (File::Rename(temp_path, path) && OpenCache(path, pack_hash))
+		NOTICE_LOG(VIDEO, "Built the custom texture cache with %u levels", header.num_levels);
+}
+
+void Init(const char *gameCode, bool use_cache)
+{
+	Shutdown();
+	textureMap.clear();
+
+	File::FSTEntry root;
+	std::vector<std::string> listing;
+	File::ScanDirectoryTreeParallel(File::GetUserPath(D_HIRESTEXTURES_IDX) + gameCode, root);
+	AddTextures(std::string(gameCode) + "_", root, &listing);
+
+	INFO_LOG(VIDEO, "Found %u custom textures", (u32)textureMap.size());
+
+	if (use_cache && !textureMap.empty())
+	{
+		std::sort(listing.begin(), listing.end());
+		std::string pack;
+		for (const auto& file : listing)
+			pack += file + '\n';
+		const u64 pack_hash = GetHash64((const u8*)pack.data(), (u32)pack.size(), 0);
+
+		const std::string path = File::GetUserPath(D_CACHE_IDX) + "HiresTextures" DIR_SEP + gameCode + ".cache";
+		if (!OpenCache(path, pack_hash))
+			DecodeTasks().Run([=]{ BuildCache(path, pack_hash); });
 	}
 }
 
-bool HiresTexExists(const char* filename)
+void Shutdown()
 {
-	std::string key(filename);
-	return textureMap.find(key) != textureMap.end();
+	if (s_decode_tasks)
+	{
+		s_cancel_build = true;
+		s_decode_tasks->Wait();
+		s_cancel_build = false;
+		delete s_decode_tasks;
+		s_decode_tasks = NULL;
+	}
+
+	std::lock_guard<std::mutex> lk(s_decoded_lock);
+	s_decoded.clear();
+	s_decoded_size = 0;
+	s_cache.clear();
+	s_cache_file.Close();
 }
 
-PC_TexFormat GetHiresTex(const char *fileName, unsigned int *pWidth, unsigned int *pHeight, unsigned int *required_size, int texformat, unsigned int data_size, u8 *data)
+bool HiresTexExists(u32 hash, int texformat, unsigned int level)
 {
-	std::string key(fileName);
-	if (textureMap.find(key) == textureMap.end())
-		return PC_TEX_FMT_NONE;
+	return textureMap.find(TextureKey(hash, texformat, level)) != textureMap.end();
+}
 
+static bool DecodeLevel(const std::string& filename, int texformat, DecodedLevel* level)
+{
 	int width;
 	int height;
 	int channels;
 
-	u8 *temp = SOIL_load_image(textureMap[key].c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	u8 *temp = SOIL_load_image(filename.c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
 	if (temp == NULL)
 	{
-		ERROR_LOG(VIDEO, "Custom texture %s failed to load", textureMap[key].c_str());
-		return PC_TEX_FMT_NONE;
+		ERROR_LOG(VIDEO, "Custom texture %s failed to load", filename.c_str());
+		return false;
 	}
 
-	*pWidth = width;
-	*pHeight = height;
-
-	int offset = 0;
-	PC_TexFormat returnTex = PC_TEX_FMT_NONE;
+	level->width = width;
+	level->height = height;
 
 	switch (texformat)
 	{
@@ -112,33 +318,140 @@ PC_TexFormat GetHiresTex(const char *fileName, unsigned int *pWidth, unsigned in
 	case GX_TF_I8:
 	case GX_TF_IA4:
 	case GX_TF_IA8:
-		*required_size = width * height * 8;
-		if (data_size < *required_size)
-			goto cleanup;
-
-		for (int i = 0; i < width * height * 4; i += 4)
+		level->data.resize(width * height * 2);
+		for (int i = 0, offset = 0; i < width * height * 4; i += 4)
 		{
 			// Rather than use a luminosity function, just use the most intense color for luminance
 			// TODO(neobrain): Isn't this kind of.. stupid?
-			data[offset++] = *std::max_element(temp+i, temp+i+3);
-			data[offset++] = temp[i+3];
+			level->data[offset++] = *std::max_element(temp+i, temp+i+3);
+			level->data[offset++] = temp[i+3];
 		}
-		returnTex = PC_TEX_FMT_IA8;
+		level->format = PC_TEX_FMT_IA8;
 		break;
 	default:
-		*required_size = width * height * 4;
-		if (data_size < *required_size)
-			goto cleanup;
-
-		memcpy(data, temp, width * height * 4);
-		returnTex = PC_TEX_FMT_RGBA32;
+		level->data.assign(temp, temp + width * height * 4);
+		level->format = PC_TEX_FMT_RGBA32;
 		break;
 	}
 
-	INFO_LOG(VIDEO, "Loading custom texture from %s", textureMap[key].c_str());
-cleanup:
+	INFO_LOG(VIDEO, "Loading custom texture from %s", filename.c_str());
 	SOIL_free_image_data(temp);
-	return returnTex;
+	return true;
+}
+
+static void DecodeLevels(u32 hash, int texformat, std::vector<DecodedLevel>* levels)
+{
+	for (unsigned int level = 0; ; ++level)
+	{
+		auto iter = textureMap.find(TextureKey(hash, texformat, level));
+		if (iter == textureMap.end())
+			break;
+
+		DecodedLevel decoded;
+		if (!DecodeLevel(iter->second, texformat, &decoded))
+		{
+			if (level == 0)
+				break;
+			// Leave the level to the LOD checks of the texture cache
+			decoded.width = decoded.height = 0;
+			decoded.format = PC_TEX_FMT_NONE;
+		}
+		levels->push_back(std::move(decoded));
+	}
+}
+
+static void DecodeTexture(u32 hash, int texformat)
+{
+	std::vector<DecodedLevel> levels;
+	DecodeLevels(hash, texformat, &levels);
+	size_t size = 0;
+	for (const auto& level : levels)
+		size += level.data.size();
+
+	std::lock_guard<std::mutex> lk(s_decoded_lock);
+	DecodedTexture& texture = s_decoded[TextureKey(hash, texformat, 0)];
+	texture.levels = std::move(levels);
+	texture.size = size;
+	texture.ready = true;
+	s_decoded_size += size;
+
+	// Drop the least recently used textures past the budget, but never keep
+	// one that was only just decoded from being picked up
+	while (s_decoded_size > DECODED_CACHE_SIZE)
+	{
+		auto oldest = s_decoded.end();
+		for (auto it = s_decoded.begin(); it != s_decoded.end(); ++it)
+		{
+			if (it->second.ready && &it->second != &texture &&
+			    (oldest == s_decoded.end() || it->second.last_used < oldest->second.last_used))
+				oldest = it;
+		}
+		if (oldest == s_decoded.end())
+			break;
+		s_decoded_size -= oldest->second.size;
+		s_decoded.erase(oldest);
+	}
+}
+
+bool RequestHiresTex(u32 hash, int texformat)
+{
+	const u64 key = TextureKey(hash, texformat, 0);
+	{
+	std::lock_guard<std::mutex> lk(s_decoded_lock);
+	if (s_cache.count(key))
+		return true;
+	auto iter = s_decoded.find(key);
+	if (iter != s_decoded.end())
+	{
+		iter->second.last_used = ++s_use_counter;
+		return iter->second.ready;
+	}
+
+	DecodedTexture& texture = s_decoded[key];
+	texture.ready = false;
+	texture.size = 0;
+	texture.last_used = ++s_use_counter;
+	}
+
+	DecodeTasks().Run([=]{ DecodeTexture(hash, texformat); });
+	return false;
+}
+
+PC_TexFormat GetHiresTex(u32 hash, int texformat, unsigned int level, unsigned int *pWidth, unsigned int *pHeight, unsigned int *required_size, unsigned int data_size, u8 *data)
+{
+	std::lock_guard<std::mutex> lk(s_decoded_lock);
+
+	// Straight from the mapping, there's nothing left to decode
+	auto cached = s_cache.find(TextureKey(hash, texformat, level));
+	if (cached != s_cache.end())
+	{
+		const CacheLevel& entry = *cached->second;
+		*pWidth = entry.width;
+		*pHeight = entry.height;
+		*required_size = entry.size;
+		if (data_size < *required_size)
+			return PC_TEX_FMT_NONE;
+
+		memcpy(data, s_cache_file.GetData() + entry.offset, entry.size);
+		return (PC_TexFormat)entry.format;
+	}
+
+	auto iter = s_decoded.find(TextureKey(hash, texformat, 0));
+	if (iter == s_decoded.end() || !iter->second.ready || level >= iter->second.levels.size())
+		return PC_TEX_FMT_NONE;
+
+	const DecodedLevel& decoded = iter->second.levels[level];
+	if (decoded.format == PC_TEX_FMT_NONE)
+		return PC_TEX_FMT_NONE;
+
+	*pWidth = decoded.width;
+	*pHeight = decoded.height;
+	*required_size = (unsigned int)decoded.data.size();
+	if (data_size < *required_size)
+		return PC_TEX_FMT_NONE;
+
+	memcpy(data, decoded.data.data(), decoded.data.size());
+	return decoded.format;
 }
 
 }
@@ -4,14 +4,29 @@
 
 #pragma once
 
-#include <map>
 #include "VideoCommon.h"
 #include "TextureDecoder.h"
 
+// Custom textures are named <game ID>_<hash>_<format>[_mip<level>] and are
+// indexed by hash, format and level when the game starts. Decoding the image
+// files happens on the thread pool, the native texture is used until then.
+//
+// With the cache, the whole pack is converted once into a file of decoded
+// levels ready for upload. It is mapped on later starts, and rebuilt in the
+// background whenever the files of the pack change.
 namespace HiresTextures
 {
-void Init(const char *gameCode);
-bool HiresTexExists(const char *filename);
-PC_TexFormat GetHiresTex(const char *fileName, unsigned int *pWidth, unsigned int *pHeight, unsigned int *required_size, int texformat, unsigned int data_size, u8 *data);
+void Init(const char *gameCode, bool use_cache);
+// Waits for the decodes in flight and frees every decoded texture
+void Shutdown();
+
+bool HiresTexExists(u32 hash, int texformat, unsigned int level);
+
+// Returns true once the custom texture and its LODs are decoded. The first
+// call starts decoding them in the background.
+bool RequestHiresTex(u32 hash, int texformat);
+
+// Copies a level of a decoded custom texture to data
+PC_TexFormat GetHiresTex(u32 hash, int texformat, unsigned int level, unsigned int *pWidth, unsigned int *pHeight, unsigned int *required_size, unsigned int data_size, u8 *data);
 
 };
@@ -2,12 +2,27 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <vector>
 
 #include "png.h"
 #include "ImageWrite.h"
 #include "FileUtil.h"
+#include "ThreadPool.h"
+#include "VideoConfig.h"
+
+// Images waiting to be written hold a copy of their data. Past this much,
+// queuing an image waits for the ones before it.
+static const size_t MAX_PENDING_BYTES = 128 * 1024 * 1024;
+
+static Common::TaskGroup* s_write_tasks;
+static std::mutex s_pending_lock;
+static std::set<std::string> s_pending_files;
+static size_t s_pending_bytes;
 
 bool SaveData(const char* filename, const char* data)
 {
@@ -26,7 +41,8 @@ Inputs:
 data      : This is an array of RGBA with 8 bits per channel. 4 bytes for each pixel.
 row_stride: Determines the amount of bytes per row of pixels.
 */
-bool TextureToPng(u8* data, int row_stride, const std::string filename, int width, int height, bool saveAlpha)
+bool TextureToPng(u8* data, int row_stride, const std::string filename, int width, int height, bool saveAlpha,
+	int compression_level)
 {
 	bool success = false;
 
@@ -68,6 +84,10 @@ bool TextureToPng(u8* data, int row_stride, const std::string filename, int widt
 
 	png_init_io(png_ptr, fp.GetHandle());
 
+	if (compression_level < 0)
+		compression_level = g_ActiveConfig.iPNGCompressionLevel;
+	png_set_compression_level(png_ptr, std::min(std::max(compression_level, 0), 9));
+
 	// Write header (8 bit colour depth)
 	png_set_IHDR(png_ptr, info_ptr, width, height,
 		8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
@@ -106,3 +126,49 @@ finalise:
 
 	return success;
 }
+
+bool TextureToPngAsync(const u8* data, int row_stride, const std::string& filename, int width, int height,
+	bool saveAlpha, int compression_level)
+{
+	if (!data)
+		return false;
+
+	const size_t size = (size_t)width * height * 4;
+	bool wait;
+	{
+		std::lock_guard<std::mutex> lk(s_pending_lock);
+		if (!s_pending_files.insert(filename).second)
+			return false;
+		if (!s_write_tasks)
+			s_write_tasks = new Common::TaskGroup;
+		wait = s_pending_bytes + size > MAX_PENDING_BYTES;
+		s_pending_bytes += size;
+	}
+	if (wait)
+		s_write_tasks->Wait();
+
+	// The copy is tightly packed, the source rows may be padded
+	std::shared_ptr<std::vector<u8>> image = std::make_shared<std::vector<u8>>(size);
+	for (int y = 0; y < height; ++y)
+		memcpy(&(*image)[(size_t)y * width * 4], data + (size_t)y * row_stride, width * 4);
+
+	s_write_tasks->Run([=]
+	{
+		TextureToPng(image->data(), width * 4, filename, width, height, saveAlpha, compression_level);
+
+		std::lock_guard<std::mutex> lk(s_pending_lock);
+		s_pending_files.erase(filename);
+		s_pending_bytes -= size;
+	});
+	return true;
+}
+
+void FlushImageWrites()
+{
+	if (!s_write_tasks)
+		return;
+
+	s_write_tasks->Wait();
+	delete s_write_tasks;
+	s_write_tasks = NULL;
+}
@@ -7,4 +7,13 @@
 #include "Common.h"
 
 bool SaveData(const char* filename, const char* pdata);
-bool TextureToPng(u8* data, int row_stride, const std::string filename, int width, int height, bool saveAlpha = true);
+// compression_level is a zlib level from 0 (none) to 9 (smallest), or -1 for the PNGCompressionLevel setting
+bool TextureToPng(u8* data, int row_stride, const std::string filename, int width, int height, bool saveAlpha = true,
+	int compression_level = -1);
+
+// Copies the image and writes it on the thread pool, so the caller doesn't
+// wait for the compression. Returns false if the file is already queued.
+bool TextureToPngAsync(const u8* data, int row_stride, const std::string& filename, int width, int height,
+	bool saveAlpha = true, int compression_level = -1);
+// Waits until every image queued by TextureToPngAsync has been written
+void FlushImageWrites();
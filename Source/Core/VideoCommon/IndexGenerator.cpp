@@ -8,6 +8,11 @@
 #include "VideoConfig.h"
 #include "IndexGenerator.h"
 
+#if _M_SSE >= 0x200 || defined __SSE2__
+#include <emmintrin.h>
+#define INDEX_SIMD
+#endif
+
 //Init
 u16 *IndexGenerator::index_buffer_current;
 u16 *IndexGenerator::BASEIptr;
@@ -15,6 +20,45 @@ u32 IndexGenerator::base_index;
 
 static const u16 s_primitive_restart = -1;
 
+#ifdef INDEX_SIMD
+// Most primitive types produce the same indices for every group of a few
+// primitives, just offset by the number of vertices the group uses. So whole
+// groups are written a vector at a time, from a pattern of indices relative to
+// the first vertex of the group with restart indices left as they are. The
+// callers write the primitives that don't fill a group with the scalar code.
+static const u16 R = 0xFFFF;
+static const u16 s_sequential_pattern[24] = { 0,1,2,3,4,5,6,7, 8,9,10,11,12,13,14,15, 16,17,18,19,20,21,22,23 };
+static const u16 s_list_restart_pattern[8] = { 0,1,2,R, 3,4,5,R };
+static const u16 s_strip_pattern[24] = { 0,1,2, 1,3,2, 2,3,4, 3,5,4, 4,5,6, 5,7,6, 6,7,8, 7,9,8 };
+static const u16 s_quads_pattern[24] = { 0,1,2, 0,2,3, 4,5,6, 4,6,7, 8,9,10, 8,10,11, 12,13,14, 12,14,15 };
+static const u16 s_quads_restart_pattern[40] = { 1,2,0,3,R, 5,6,4,7,R, 9,10,8,11,R, 13,14,12,15,R,
+	17,18,16,19,R, 21,22,20,23,R, 25,26,24,27,R, 29,30,28,31,R };
+static const u16 s_line_strip_pattern[8] = { 0,1, 1,2, 2,3, 3,4 };
+
+template <int num_vectors>
+static u16* WriteIndexPattern(u16* Iptr, const u16* pattern, u32 num_groups, u32 index, u32 stride)
+{
+	__m128i offsets[num_vectors], restart[num_vectors];
+	for (int i = 0; i < num_vectors; ++i)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*)(pattern + i * 8));
+		restart[i] = _mm_cmpeq_epi16(p, _mm_set1_epi16(-1));
+		offsets[i] = _mm_andnot_si128(restart[i], p);
+	}
+
+	__m128i base = _mm_set1_epi16((s16)index);
+	const __m128i step = _mm_set1_epi16((s16)stride);
+	for (u32 g = 0; g < num_groups; ++g)
+	{
+		for (int i = 0; i < num_vectors; ++i)
+			_mm_storeu_si128((__m128i*)(Iptr + i * 8), _mm_or_si128(_mm_add_epi16(offsets[i], base), restart[i]));
+		Iptr += num_vectors * 8;
+		base = _mm_add_epi16(base, step);
+	}
+	return Iptr;
+}
+#endif
+
 static u16* (*primitive_table[8])(u16*, u32, u32);
 
 void IndexGenerator::Init()
@@ -65,7 +109,23 @@ template <bool pr> __forceinline u16* IndexGenerator::WriteTriangle(u16 *Iptr, u
 
 template <bool pr> u16* IndexGenerator::AddList(u16 *Iptr, u32 const numVerts, u32 index)
 {
-	for (u32 i = 2; i < numVerts; i+=3)
+	u32 i = 2;
+#ifdef INDEX_SIMD
+	if (pr)
+	{
+		// two triangles per vector
+		const u32 groups = numVerts / 6;
+		Iptr = WriteIndexPattern<1>(Iptr, s_list_restart_pattern, groups, index, 6);
+		i += groups * 6;
+	}
+	else
+	{
+		const u32 groups = numVerts / 24;
+		Iptr = WriteIndexPattern<3>(Iptr, s_sequential_pattern, groups, index, 24);
+		i += groups * 24;
+	}
+#endif
+	for (; i < numVerts; i+=3)
 	{
 		Iptr = WriteTriangle<pr>(Iptr, index + i - 2, index + i - 1, index + i);
 	}
@@ -76,7 +136,13 @@ template <bool pr> u16* IndexGenerator::AddStrip(u16 *Iptr, u32 const numVerts,
 {
 	if(pr)
 	{
-		for (u32 i = 0; i < numVerts; ++i)
+		u32 i = 0;
+#ifdef INDEX_SIMD
+		const u32 groups = numVerts / 8;
+		Iptr = WriteIndexPattern<1>(Iptr, s_sequential_pattern, groups, index, 8);
+		i = groups * 8;
+#endif
+		for (; i < numVerts; ++i)
 		{
 			*Iptr++ = index + i;
 		}
@@ -85,8 +151,15 @@ template <bool pr> u16* IndexGenerator::AddStrip(u16 *Iptr, u32 const numVerts,
 	}
 	else
 	{
+		u32 i = 2;
+#ifdef INDEX_SIMD
+		// eight triangles per group, so the winding starts over with each
+		const u32 groups = numVerts >= 2 ? (numVerts - 2) / 8 : 0;
+		Iptr = WriteIndexPattern<3>(Iptr, s_strip_pattern, groups, index, 8);
+		i += groups * 8;
+#endif
 		bool wind = false;
-		for (u32 i = 2; i < numVerts; ++i)
+		for (; i < numVerts; ++i)
 		{
 			Iptr = WriteTriangle<pr>(Iptr,
 				index + i - 2,
@@ -171,6 +244,20 @@ template <bool pr> u16* IndexGenerator::AddFan(u16 *Iptr, u32 numVerts, u32 inde
 template <bool pr> u16* IndexGenerator::AddQuads(u16 *Iptr, u32 numVerts, u32 index)
 {
 	u32 i = 3;
+#ifdef INDEX_SIMD
+	if (pr)
+	{
+		const u32 groups = numVerts / 32;
+		Iptr = WriteIndexPattern<5>(Iptr, s_quads_restart_pattern, groups, index, 32);
+		i += groups * 32;
+	}
+	else
+	{
+		const u32 groups = numVerts / 16;
+		Iptr = WriteIndexPattern<3>(Iptr, s_quads_pattern, groups, index, 16);
+		i += groups * 16;
+	}
+#endif
 	for (; i < numVerts; i+=4)
 	{
 		if(pr)
@@ -199,7 +286,13 @@ template <bool pr> u16* IndexGenerator::AddQuads(u16 *Iptr, u32 numVerts, u32 in
 // Lines
 u16* IndexGenerator::AddLineList(u16 *Iptr, u32 numVerts, u32 index)
 {
-	for (u32 i = 1; i < numVerts; i+=2)
+	u32 i = 1;
+#ifdef INDEX_SIMD
+	const u32 groups = numVerts / 8;
+	Iptr = WriteIndexPattern<1>(Iptr, s_sequential_pattern, groups, index, 8);
+	i += groups * 8;
+#endif
+	for (; i < numVerts; i+=2)
 	{
 		*Iptr++ = index + i - 1;
 		*Iptr++ = index + i;
@@ -212,7 +305,13 @@ u16* IndexGenerator::AddLineList(u16 *Iptr, u32 numVerts, u32 index)
 // so converting them to lists
 u16* IndexGenerator::AddLineStrip(u16 *Iptr, u32 numVerts, u32 index)
 {
-	for (u32 i = 1; i < numVerts; ++i)
+	u32 i = 1;
+#ifdef INDEX_SIMD
+	const u32 groups = numVerts >= 1 ? (numVerts - 1) / 4 : 0;
+	Iptr = WriteIndexPattern<1>(Iptr, s_line_strip_pattern, groups, index, 4);
+	i += groups * 4;
+#endif
+	for (; i < numVerts; ++i)
 	{
 		*Iptr++ = index + i - 1;
 		*Iptr++ = index + i;
@@ -223,7 +322,13 @@ u16* IndexGenerator::AddLineStrip(u16 *Iptr, u32 numVerts, u32 index)
 // Points
 u16* IndexGenerator::AddPoints(u16 *Iptr, u32 numVerts, u32 index)
 {
-	for (u32 i = 0; i != numVerts; ++i)
+	u32 i = 0;
+#ifdef INDEX_SIMD
+	const u32 groups = numVerts / 8;
+	Iptr = WriteIndexPattern<1>(Iptr, s_sequential_pattern, groups, index, 8);
+	i = groups * 8;
+#endif
+	for (; i != numVerts; ++i)
 	{
 		*Iptr++ = index + i;
 	}
@@ -38,22 +38,18 @@ struct LightingUidData
 };
 
 
-template<class T>
-static void GenerateLightShader(T& object, LightingUidData& uid_data, int index, int litchan_index, const char* lightsName, int coloralpha)
+static void WriteLightShader(ShaderCode& object, int index, u32 attnfunc, u32 diffusefunc, const char* lightsName, int coloralpha)
 {
-	const LitChannel& chan = (litchan_index > 1) ? xfregs.alpha[litchan_index-2] : xfregs.color[litchan_index];
 	const char* swizzle = "xyzw";
 	if (coloralpha == 1)
 		swizzle = "xyz";
 	else if (coloralpha == 2)
 		swizzle = "w";
 
-	uid_data.attnfunc |= chan.attnfunc << (2*litchan_index);
-	uid_data.diffusefunc |= chan.diffusefunc << (2*litchan_index);
-	if (!(chan.attnfunc & 1))
+	if (!(attnfunc & 1))
 	{
 		// atten disabled
-		switch (chan.diffusefunc)
+		switch (diffusefunc)
 		{
 			case LIGHTDIF_NONE:
 				object.Write("lacc.%s += " LIGHT_COL";\n", swizzle, LIGHT_COL_PARAMS(lightsName, index, swizzle));
@@ -62,14 +58,14 @@ static void GenerateLightShader(T& object, LightingUidData& uid_data, int index,
 			case LIGHTDIF_CLAMP:
 				object.Write("ldir = normalize(" LIGHT_POS".xyz - pos.xyz);\n", LIGHT_POS_PARAMS(lightsName, index));
 				object.Write("lacc.%s += %sdot(ldir, _norm0)) * " LIGHT_COL";\n",
-					swizzle, chan.diffusefunc != LIGHTDIF_SIGN ? "max(0.0," :"(", LIGHT_COL_PARAMS(lightsName, index, swizzle));
+					swizzle, diffusefunc != LIGHTDIF_SIGN ? "max(0.0," :"(", LIGHT_COL_PARAMS(lightsName, index, swizzle));
 				break;
 			default: _assert_(0);
 		}
 	}
 	else // spec and spot
 	{
-		if (chan.attnfunc == 3)
+		if (attnfunc == 3)
 		{ // spot
 			object.Write("ldir = " LIGHT_POS".xyz - pos.xyz;\n", LIGHT_POS_PARAMS(lightsName, index));
 			object.Write("dist2 = dot(ldir, ldir);\n"
@@ -81,7 +77,7 @@ static void GenerateLightShader(T& object, LightingUidData& uid_data, int index,
 			object.Write("attn = max(0.0, " LIGHT_COSATT".x + " LIGHT_COSATT".y*attn + " LIGHT_COSATT".z*attn*attn) / dot(" LIGHT_DISTATT".xyz, float3(1.0,dist,dist2));\n",
 						LIGHT_COSATT_PARAMS(lightsName, index), LIGHT_COSATT_PARAMS(lightsName, index), LIGHT_COSATT_PARAMS(lightsName, index), LIGHT_DISTATT_PARAMS(lightsName, index));
 		}
-		else if (chan.attnfunc == 1)
+		else if (attnfunc == 1)
 		{ // specular
 			object.Write("ldir = normalize(" LIGHT_POS".xyz);\n", LIGHT_POS_PARAMS(lightsName, index));
 			object.Write("attn = (dot(_norm0,ldir) >= 0.0) ? max(0.0, dot(_norm0, " LIGHT_DIR".xyz)) : 0.0;\n", LIGHT_DIR_PARAMS(lightsName, index));
@@ -91,7 +87,7 @@ static void GenerateLightShader(T& object, LightingUidData& uid_data, int index,
 						LIGHT_DISTATT_PARAMS(lightsName, index), LIGHT_DISTATT_PARAMS(lightsName, index), LIGHT_DISTATT_PARAMS(lightsName, index));
 		}
 
-		switch (chan.diffusefunc)
+		switch (diffusefunc)
 		{
 			case LIGHTDIF_NONE:
 				object.Write("lacc.%s += attn * " LIGHT_COL";\n", swizzle, LIGHT_COL_PARAMS(lightsName, index, swizzle));
@@ -100,7 +96,7 @@ static void GenerateLightShader(T& object, LightingUidData& uid_data, int index,
 			case LIGHTDIF_CLAMP:
 				object.Write("lacc.%s += attn * %sdot(ldir, _norm0)) * " LIGHT_COL";\n",
 					swizzle,
-					chan.diffusefunc != LIGHTDIF_SIGN ? "max(0.0," :"(",
+					diffusefunc != LIGHTDIF_SIGN ? "max(0.0," :"(",
 					LIGHT_COL_PARAMS(lightsName, index, swizzle));
 				break;
 			default: _assert_(0);
@@ -109,6 +105,27 @@ static void GenerateLightShader(T& object, LightingUidData& uid_data, int index,
 	object.Write("\n");
 }
 
+template<class T>
+static void GenerateLightShader(T& object, LightingUidData& uid_data, int index, int litchan_index, const char* lightsName, int coloralpha)
+{
+	const LitChannel& chan = (litchan_index > 1) ? xfregs.alpha[litchan_index-2] : xfregs.color[litchan_index];
+	const u32 attnfunc = chan.attnfunc;
+	const u32 diffusefunc = chan.diffusefunc;
+
+	uid_data.attnfunc |= attnfunc << (2*litchan_index);
+	uid_data.diffusefunc |= diffusefunc << (2*litchan_index);
+
+	if (!object.GetBuffer())
+		return;
+
+	// The code of a light doesn't depend on anything else
+	static ShaderSnippetCache snippets;
+	const u32 key = index | (attnfunc << 3) | (diffusefunc << 5) | (coloralpha << 7);
+	object.Append(snippets.Get(lightsName, key, [&](ShaderCode& code) {
+		WriteLightShader(code, index, attnfunc, diffusefunc, lightsName, coloralpha);
+	}));
+}
+
 // vertex shader
 // lights/colors
 // materials name is I_MATERIALS in vs and I_PMATERIALS in ps
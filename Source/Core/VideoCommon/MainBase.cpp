@@ -6,12 +6,15 @@
 #include "FramebufferManagerBase.h"
 #include "TextureCacheBase.h"
 #include "VertexLoaderManager.h"
+#include "VertexManagerBase.h"
 #include "CommandProcessor.h"
 #include "PixelEngine.h"
 #include "Atomic.h"
 #include "Fifo.h"
 #include "BPStructs.h"
 #include "OnScreenDisplay.h"
+#include "PerfTrace.h"
+#include "ShaderGenCommon.h"
 #include "VideoBackendBase.h"
 #include "ConfigManager.h"
 
@@ -19,11 +22,13 @@ bool s_BackendInitialized = false;
 
 volatile u32 s_swapRequested = false;
 u32 s_efbAccessRequested = false;
+static u32 s_bboxReadRequested = false;
 volatile u32 s_FifoShuttingDown = false;
 
 std::condition_variable s_perf_query_cond;
 std::mutex s_perf_query_lock;
 static volatile bool s_perf_query_requested;
+static volatile bool s_perf_query_poll_requested;
 
 static volatile struct
 {
@@ -42,6 +47,9 @@ static struct
 
 static u32 s_AccessEFBResult = 0;
 
+static int s_bboxReadIndex = 0;
+static u16 s_bboxReadResult = 0;
+
 void VideoBackendHardware::EmuStateChange(EMUSTATE_CHANGE newState)
 {
 	EmulatorState((newState == EMUSTATE_CHANGE_PLAY) ? true : false);
@@ -64,6 +72,11 @@ void VideoBackendHardware::Video_SetRendering(bool bEnabled)
 	Fifo_SetRendering(bEnabled);
 }
 
+void VideoBackendHardware::Video_SetPresenting(bool bEnabled)
+{
+	Fifo_SetPresenting(bEnabled);
+}
+
 // Run from the graphics thread (from Fifo.cpp)
 void VideoFifo_CheckSwapRequest()
 {
@@ -115,6 +128,7 @@ void VideoBackendHardware::Video_EndField()
 	if (s_BackendInitialized)
 	{
 		Common::AtomicStoreRelease(s_swapRequested, true);
+		Fifo_WakeGpuThread();
 	}
 }
 
@@ -149,6 +163,10 @@ u32 VideoBackendHardware::Video_AccessEFB(EFBAccessType type, u32 x, u32 y, u32
 {
 	if (s_BackendInitialized && g_ActiveConfig.bEFBAccessEnable)
 	{
+		PERF_SCOPE(CAT_EFB_ACCESS);
+
+		CommandProcessor::SyncGPU();
+
 		s_accessEFBArgs.type = type;
 		s_accessEFBArgs.x = x;
 		s_accessEFBArgs.y = y;
@@ -158,6 +176,7 @@ u32 VideoBackendHardware::Video_AccessEFB(EFBAccessType type, u32 x, u32 y, u32
 
 		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread)
 		{
+			Fifo_WakeGpuThread();
 			while (Common::AtomicLoadAcquire(s_efbAccessRequested) && !s_FifoShuttingDown)
 				//Common::SleepCurrentThread(1);
 				Common::YieldCPU();
@@ -171,6 +190,48 @@ u32 VideoBackendHardware::Video_AccessEFB(EFBAccessType type, u32 x, u32 y, u32
 	return 0;
 }
 
+static void VideoFifo_CheckBBoxRead()
+{
+	if (Common::AtomicLoadAcquire(s_bboxReadRequested))
+	{
+		// The pixels of the pending draws extend the box as well
+		VertexManager::Flush();
+
+		s_bboxReadResult = g_renderer->BBoxRead(s_bboxReadIndex);
+		PixelEngine::bbox[s_bboxReadIndex] = s_bboxReadResult;
+		if (PixelEngine::bbox_active)
+		{
+			PixelEngine::bbox_active = false;
+			InvalidateShaderUids();
+		}
+
+		Common::AtomicStoreRelease(s_bboxReadRequested, false);
+	}
+}
+
+u16 Video_GetBoundingBox(int index)
+{
+	if (!g_ActiveConfig.GPUBBoxEnabled())
+	{
+		PixelEngine::bbox_active = false;
+		return PixelEngine::bbox[index];
+	}
+
+	s_bboxReadIndex = index;
+	Common::AtomicStoreRelease(s_bboxReadRequested, true);
+
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread)
+	{
+		Fifo_WakeGpuThread();
+		while (Common::AtomicLoadAcquire(s_bboxReadRequested) && !s_FifoShuttingDown)
+			Common::YieldCPU();
+	}
+	else
+		VideoFifo_CheckBBoxRead();
+
+	return s_bboxReadResult;
+}
+
 static bool QueryResultIsReady()
 {
 	return !s_perf_query_requested || s_FifoShuttingDown;
@@ -189,6 +250,12 @@ void VideoFifo_CheckPerfQueryRequest()
 
 		s_perf_query_cond.notify_one();
 	}
+
+	if (s_perf_query_poll_requested)
+	{
+		s_perf_query_poll_requested = false;
+		g_perf_query->WeakFlush();
+	}
 }
 
 u32 VideoBackendHardware::Video_GetQueryResult(PerfQueryType type)
@@ -198,12 +265,26 @@ u32 VideoBackendHardware::Video_GetQueryResult(PerfQueryType type)
 		return 0;
 	}
 
+	CommandProcessor::SyncGPU();
+
 	// TODO: Is this check sane?
 	if (!g_perf_query->IsFlushed())
 	{
-		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread)
+		const bool cpu_thread = SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread;
+		// A partial count would depend on how far the GPU thread got
+		if (!PerfQueryBase::ShouldWaitForResults() && !CommandProcessor::IsDeterministic())
+		{
+			// Report what has been counted so far instead of stalling on the GPU,
+			// the queries still pending are added to a later read.
+			if (cpu_thread)
+				s_perf_query_poll_requested = true;
+			else
+				g_perf_query->WeakFlush();
+		}
+		else if (cpu_thread)
 		{
 			s_perf_query_requested = true;
+			Fifo_WakeGpuThread();
 			std::unique_lock<std::mutex> lk(s_perf_query_lock);
 			s_perf_query_cond.wait(lk, QueryResultIsReady);
 		}
@@ -220,7 +301,9 @@ void VideoBackendHardware::InitializeShared()
 
 	s_swapRequested = 0;
 	s_efbAccessRequested = 0;
+	s_bboxReadRequested = false;
 	s_perf_query_requested = false;
+	s_perf_query_poll_requested = false;
 	s_FifoShuttingDown = 0;
 	memset((void*)&s_beginFieldArgs, 0, sizeof(s_beginFieldArgs));
 	memset(&s_accessEFBArgs, 0, sizeof(s_accessEFBArgs));
@@ -270,6 +353,13 @@ void VideoBackendHardware::CheckInvalidState()
 
 		BPReload();
 		TextureCache::Invalidate();
+
+		// The GPU copy of the bounding box isn't part of the state
+		if (g_ActiveConfig.GPUBBoxEnabled())
+		{
+			for (int i = 0; i < 4; ++i)
+				g_renderer->BBoxWrite(i, PixelEngine::bbox[i]);
+		}
 	}
 }
 
@@ -288,6 +378,7 @@ void VideoFifo_CheckAsyncRequest()
 {
 	VideoFifo_CheckSwapRequest();
 	VideoFifo_CheckEFBAccess();
+	VideoFifo_CheckBBoxRead();
 	VideoFifo_CheckPerfQueryRequest();
 }
 
@@ -8,4 +8,7 @@ extern volatile u32 s_FifoShuttingDown;
 extern volatile u32 s_swapRequested;
 
 void VideoFifo_CheckEFBAccess();
+
+// Reads a PE bounding box register, from the GPU when it computes the box
+u16 Video_GetBoundingBox(int index);
 void VideoFifo_CheckSwapRequestAt(u32 xfbAddr, u32 fbWidth, u32 fbHeight);
@@ -49,6 +49,12 @@ enum
 
 typedef void (LOADERDECL *TPipelineFunction)();
 
+// Converts one attribute of count vertices in a single pass. src and dst point
+// at the attribute of the first vertex, the strides are the raw and native
+// vertex sizes. array is the ARRAY_* slot indexed formats gather from.
+typedef void (LOADERDECL *TBatchFunction)(const u8* src, int src_stride, u8* dst, int dst_stride,
+	int count, int array, float scale);
+
 enum VarType
 {
 	VAR_UNSIGNED_BYTE,  // GX_U8  = 0
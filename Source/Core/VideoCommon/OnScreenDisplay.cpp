@@ -2,14 +2,18 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <list>
 
 #include "Common.h"
 
 #include "ConfigManager.h"
 #include "OnScreenDisplay.h"
+#include "PerfTrace.h"
 #include "RenderBase.h"
+#include "StringUtil.h"
 #include "Timer.h"
+#include "VideoConfig.h"
 
 #include <map>
 #include <string>
@@ -34,8 +38,59 @@ void AddMessage(const std::string& str, u32 ms)
 	s_msgList.push_back(Message(str, Common::Timer::GetTimeMs() + ms));
 }
 
+// Frame time graph in the bottom left corner, one dash per frame at a height
+// proportional to its frame time, with the per-category averages above it.
+static void DrawFrameTimes()
+{
+	enum
+	{
+		GRAPH_HEIGHT = 100,
+		GRAPH_RANGE_US = 50000,
+	};
+
+	PerfTrace::FrameTimes frames[PerfTrace::FRAME_HISTORY_SIZE];
+	const int count = PerfTrace::GetFrameHistory(frames, PerfTrace::FRAME_HISTORY_SIZE);
+	if (count == 0)
+		return;
+
+	u64 totals[PerfTrace::NUM_CATEGORIES] = {};
+	u32 worst = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		for (int c = 0; c < PerfTrace::NUM_CATEGORIES; ++c)
+			totals[c] += frames[i].us[c];
+		worst = std::max(worst, frames[i].us[PerfTrace::CAT_FRAME]);
+	}
+
+	std::string text = StringFromFormat("Frame: %.1f ms (worst %.1f ms)\n",
+		totals[PerfTrace::CAT_FRAME] / 1000.0 / count, worst / 1000.0);
+	for (int c = PerfTrace::CAT_FRAME + 1; c < PerfTrace::NUM_CATEGORIES; ++c)
+	{
+		text += StringFromFormat("%s: %.2f ms  ", PerfTrace::GetCategoryName((PerfTrace::Category)c),
+			totals[c] / 1000.0 / count);
+	}
+
+	const int left = 25;
+	const int bottom = Renderer::GetBackbufferHeight() - 30;
+	const int text_top = bottom - GRAPH_HEIGHT - 45;
+	g_renderer->RenderText(text.c_str(), left + 1, text_top + 1, 0xFF000000);
+	g_renderer->RenderText(text.c_str(), left, text_top, 0xFF00FFFF);
+
+	for (int i = 0; i < count; ++i)
+	{
+		const u32 us = frames[i].us[PerfTrace::CAT_FRAME];
+		const int height = (int)(std::min<u32>(us, GRAPH_RANGE_US) * GRAPH_HEIGHT / GRAPH_RANGE_US);
+		// green up to 60 fps, yellow up to 30 fps, red below
+		const u32 color = us <= 17000 ? 0xFF30FF30 : (us <= 34000 ? 0xFFFFFF30 : 0xFFFF3030);
+		g_renderer->RenderText("-", left + i * 3, bottom - height, color);
+	}
+}
+
 void DrawMessages()
 {
+	if (g_ActiveConfig.bShowFrameTimes)
+		DrawFrameTimes();
+
 	if(!SConfig::GetInstance().m_LocalCoreStartupParameter.bOnScreenDisplayMessages)
 		return;
 
@@ -12,7 +12,11 @@
 // while interpreting them, and hope that the vertex format doesn't change, though, if you do it right
 // when they are called. The reason is that the vertex format affects the sizes of the vertices.
 
+#include <unordered_map>
+#include <vector>
+
 #include "Common.h"
+#include "Hash.h"
 #include "VideoCommon.h"
 #include "OpcodeDecoding.h"
 #include "CommandProcessor.h"
@@ -38,6 +42,50 @@
 u8* g_pVideoData = 0;
 bool g_bRecordFifoData = false;
 
+// Start of the display list being interpreted, if any, so that primitives in
+// it can be identified by their address
+static u8* s_display_list_start = NULL;
+static u32 s_display_list_address;
+
+extern int frameCount;
+
+enum
+{
+	DISPLAY_LIST_KILL_THRESHOLD = 60,
+};
+
+// A display list decoded into the register writes and primitives it contains,
+// so that calling it again only has to check that its contents didn't change.
+struct DisplayListCommand
+{
+	u8 cmd;
+	u8 sub;      // CP register, indexed XF array
+	u16 count;   // vertices, XF transfer size
+	u32 value;   // register value, XF address, display list address, vertex size
+	u32 data;    // offset of a primitive, XF data, display list size
+};
+
+struct DecodedDisplayList
+{
+	u32 size;
+	u64 hash;
+	// Set once the commands were recorded from the list with this hash
+	bool decoded;
+	bool cacheable;
+	int frame;
+	std::vector<DisplayListCommand> commands;
+	std::vector<u32> xf_data;
+};
+
+static std::unordered_map<u32, DecodedDisplayList> s_display_lists;
+static DecodedDisplayList* s_recording = NULL;
+
+static void RecordCommand(u8 cmd, u8 sub, u16 count, u32 value, u32 data)
+{
+	DisplayListCommand command = { cmd, sub, count, value, data };
+	s_recording->commands.push_back(command);
+}
+
 #if _M_SSE >= 0x301
 DataReadU32xNfunc DataReadU32xFuncs_SSSE3[16] = {
 	DataReadU32xN_SSSE3<1>,
@@ -83,23 +131,128 @@ extern u8* GetVideoBufferEndPtr();
 
 static void Decode();
 
+// Returns false if the vertex format changed since the list was decoded. The
+// rest of it is interpreted in that case.
+static bool ReplayDisplayList(const DecodedDisplayList& dl, u8* start, u8* end)
+{
+	for (const DisplayListCommand& command : dl.commands)
+	{
+		switch (command.cmd)
+		{
+		case GX_LOAD_CP_REG:
+			LoadCPReg(command.sub, command.value);
+			INCSTAT(stats.thisFrame.numCPLoads);
+			break;
+
+		case GX_LOAD_XF_REG:
+			LoadXFReg(command.count, command.value, const_cast<u32*>(&dl.xf_data[command.data]));
+			INCSTAT(stats.thisFrame.numXFLoads);
+			break;
+
+		case GX_LOAD_INDX_A:
+			LoadIndexedXF(command.value, command.sub);
+			break;
+
+		case GX_CMD_CALL_DL:
+			InterpretDisplayList(command.value, command.data);
+			break;
+
+		case GX_LOAD_BP_REG:
+			LoadBPReg(command.value);
+			INCSTAT(stats.thisFrame.numBPLoads);
+			break;
+
+		default:
+			// The size of the vertices decides where the following commands start
+			if ((u32)VertexLoaderManager::GetVertexSize(command.cmd & GX_VAT_MASK) != command.value)
+			{
+				g_pVideoData = start + command.data;
+				while (g_pVideoData < end)
+					Decode();
+				return false;
+			}
+
+			g_pVideoData = start + command.data + 3;
+			VertexLoaderManager::RunDisplayListVertices(
+				command.cmd & GX_VAT_MASK,
+				(command.cmd & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+				command.count,
+				s_display_list_address + command.data);
+			break;
+		}
+	}
+	return true;
+}
+
+static void RunCachedDisplayList(u32 address, u32 size)
+{
+	u8* const start = g_pVideoData;
+	u8* const end = start + size;
+	// CRC32 hashing skips the last bytes of a range that isn't a multiple of 8
+	const u64 hash = GetHash64(start, (size + 7) & ~7, 0);
+
+	DecodedDisplayList& dl = s_display_lists[address];
+	dl.frame = frameCount;
+
+	if (dl.size == size && dl.hash == hash)
+	{
+		if (dl.decoded)
+		{
+			dl.decoded = ReplayDisplayList(dl, start, end);
+			return;
+		}
+
+		// Called a second time without changes, worth decoding
+		dl.commands.clear();
+		dl.xf_data.clear();
+		dl.cacheable = true;
+		s_recording = &dl;
+		while (g_pVideoData < end)
+			Decode();
+		s_recording = NULL;
+		dl.decoded = dl.cacheable;
+		return;
+	}
+
+	dl.size = size;
+	dl.hash = hash;
+	dl.decoded = false;
+	dl.commands.clear();
+	dl.xf_data.clear();
+	while (g_pVideoData < end)
+		Decode();
+}
+
 void InterpretDisplayList(u32 address, u32 size)
 {
 	u8* old_pVideoData = g_pVideoData;
+	u8* old_display_list_start = s_display_list_start;
+	u32 old_display_list_address = s_display_list_address;
+	DecodedDisplayList* old_recording = s_recording;
 	u8* startAddress = Memory::GetPointer(address);
 
 	// Avoid the crash if Memory::GetPointer failed ..
 	if (startAddress != 0)
 	{
 		g_pVideoData = startAddress;
+		s_display_list_start = startAddress;
+		s_display_list_address = address;
+		s_recording = NULL;
 
 		// temporarily swap dl and non-dl (small "hack" for the stats)
 		Statistics::SwapDL();
 
-		u8 *end = g_pVideoData + size;
-		while (g_pVideoData < end)
+		if (g_ActiveConfig.bCacheDisplayLists && !g_bRecordFifoData)
 		{
-			Decode();
+			RunCachedDisplayList(address, size);
+		}
+		else
+		{
+			u8 *end = g_pVideoData + size;
+			while (g_pVideoData < end)
+			{
+				Decode();
+			}
 		}
 		INCSTAT(stats.numDListsCalled);
 		INCSTAT(stats.thisFrame.numDListsCalled);
@@ -110,6 +263,9 @@ void InterpretDisplayList(u32 address, u32 size)
 
 	// reset to the old pointer
 	g_pVideoData = old_pVideoData;
+	s_display_list_start = old_display_list_start;
+	s_display_list_address = old_display_list_address;
+	s_recording = old_recording;
 }
 
 u32 FifoCommandRunnable(u32 &command_size)
@@ -295,6 +451,8 @@ static void Decode()
 			u32 value = DataReadU32();
 			LoadCPReg(sub_cmd, value);
 			INCSTAT(stats.thisFrame.numCPLoads);
+			if (s_recording)
+				RecordCommand(GX_LOAD_CP_REG, sub_cmd, 0, value, 0);
 		}
 		break;
 
@@ -308,20 +466,25 @@ static void Decode()
 			LoadXFReg(transfer_size, xf_address, data_buffer);
 
 			INCSTAT(stats.thisFrame.numXFLoads);
+			if (s_recording)
+			{
+				RecordCommand(GX_LOAD_XF_REG, 0, transfer_size, xf_address, (u32)s_recording->xf_data.size());
+				s_recording->xf_data.insert(s_recording->xf_data.end(), data_buffer, data_buffer + transfer_size);
+			}
 		}
 		break;
 
 	case GX_LOAD_INDX_A: //used for position matrices
-		LoadIndexedXF(DataReadU32(), 0xC);
-		break;
 	case GX_LOAD_INDX_B: //used for normal matrices
-		LoadIndexedXF(DataReadU32(), 0xD);
-		break;
 	case GX_LOAD_INDX_C: //used for postmatrices
-		LoadIndexedXF(DataReadU32(), 0xE);
-		break;
 	case GX_LOAD_INDX_D: //used for lights
-		LoadIndexedXF(DataReadU32(), 0xF);
+		{
+			const int ref_array = 0xC + ((cmd_byte - GX_LOAD_INDX_A) >> 3);
+			u32 value = DataReadU32();
+			LoadIndexedXF(value, ref_array);
+			if (s_recording)
+				RecordCommand(GX_LOAD_INDX_A, ref_array, 0, value, 0);
+		}
 		break;
 
 	case GX_CMD_CALL_DL:
@@ -329,6 +492,8 @@ static void Decode()
 			u32 address = DataReadU32();
 			u32 count = DataReadU32();
 			InterpretDisplayList(address, count);
+			if (s_recording)
+				RecordCommand(GX_CMD_CALL_DL, 0, 0, address, count);
 		}
 		break;
 
@@ -345,6 +510,8 @@ static void Decode()
 			u32 bp_cmd = DataReadU32();
 			LoadBPReg(bp_cmd);
 			INCSTAT(stats.thisFrame.numBPLoads);
+			if (s_recording)
+				RecordCommand(GX_LOAD_BP_REG, 0, 0, bp_cmd, 0);
 		}
 		break;
 
@@ -355,14 +522,33 @@ static void Decode()
 			// load vertices (use computed vertex size from FifoCommandRunnable above)
 			u16 numVertices = DataReadU16();
 
-			VertexLoaderManager::RunVertices(
-				cmd_byte & GX_VAT_MASK,   // Vertex loader index (0 - 7)
-				(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
-				numVertices);
+			if (s_recording)
+			{
+				RecordCommand(cmd_byte, 0, numVertices, VertexLoaderManager::GetVertexSize(cmd_byte & GX_VAT_MASK),
+					(u32)(opcodeStart - s_display_list_start));
+			}
+
+			if (s_display_list_start)
+			{
+				VertexLoaderManager::RunDisplayListVertices(
+					cmd_byte & GX_VAT_MASK,
+					(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+					numVertices,
+					s_display_list_address + (u32)(opcodeStart - s_display_list_start));
+			}
+			else
+			{
+				VertexLoaderManager::RunVertices(
+					cmd_byte & GX_VAT_MASK,   // Vertex loader index (0 - 7)
+					(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+					numVertices);
+			}
 		}
 		else
 		{
 			ERROR_LOG(VIDEO, "OpcodeDecoding::Decode: Illegal command %02x", cmd_byte);
+			if (s_recording)
+				s_recording->cacheable = false;
 			break;
 		}
 		break;
@@ -472,6 +658,19 @@ void OpcodeDecoder_Init()
 
 void OpcodeDecoder_Shutdown()
 {
+	s_display_lists.clear();
+}
+
+void OpcodeDecoder_Cleanup()
+{
+	auto iter = s_display_lists.begin();
+	while (iter != s_display_lists.end())
+	{
+		if (frameCount > DISPLAY_LIST_KILL_THRESHOLD + iter->second.frame)
+			iter = s_display_lists.erase(iter);
+		else
+			++iter;
+	}
 }
 
 u32 OpcodeDecoder_Run(bool skipped_frame)
@@ -36,5 +36,7 @@ extern bool g_bRecordFifoData;
 
 void OpcodeDecoder_Init();
 void OpcodeDecoder_Shutdown();
+// Drops the decoded display lists that weren't called for a while
+void OpcodeDecoder_Cleanup();
 u32 OpcodeDecoder_Run(bool skipped_frame);
 void InterpretDisplayList(u32 address, u32 size);
@@ -1,3 +1,5 @@
+#include "Movie.h"
+#include "NetPlayProto.h"
 #include "PerfQueryBase.h"
 #include "VideoConfig.h"
 
@@ -7,3 +9,9 @@ bool PerfQueryBase::ShouldEmulate()
 {
 	return g_ActiveConfig.bPerfQueriesEnable;
 }
+
+bool PerfQueryBase::ShouldWaitForResults()
+{
+	return !g_ActiveConfig.bPerfQueriesAsync || NetPlay::IsNetPlayRunning() ||
+		Movie::IsRecordingInput() || Movie::IsPlayingInput();
+}
@@ -31,6 +31,11 @@ public:
 	// NOTE: Called from CPU+GPU thread
 	static bool ShouldEmulate();
 
+	// Checks if reading a result has to wait for all pending queries, so that
+	// runs that must be reproducible (netplay, movies) see the same values.
+	// NOTE: Called from CPU thread
+	static bool ShouldWaitForResults();
+
 	// Begin querying the specified value for the following host GPU commands
 	virtual void EnableQuery(PerfQueryGroup type) {}
 
@@ -47,6 +52,9 @@ public:
 	// Request the value of any pending queries - causes a pipeline flush and thus should be used carefully!
 	virtual void FlushResults() {}
 
+	// Retrieve the results of pending queries which are already available, without waiting for the GPU
+	virtual void WeakFlush() {}
+
 	// True if there are no further pending query results
 	// NOTE: Called from CPU thread
 	virtual bool IsFlushed() const { return true; }
@@ -16,6 +16,7 @@
 #include "PixelEngine.h"
 #include "RenderBase.h"
 #include "CommandProcessor.h"
+#include "MainBase.h"
 #include "HW/MMIO.h"
 #include "HW/ProcessorInterface.h"
 #include "State.h"
@@ -236,7 +237,10 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 
 	// Token register, readonly.
 	mmio->Register(base | PE_TOKEN_REG,
-		MMIO::DirectRead<u16>(&CommandProcessor::fifo.PEToken),
+		MMIO::ComplexRead<u16>([](u32) {
+			CommandProcessor::SyncGPU();
+			return CommandProcessor::fifo.PEToken;
+		}),
 		MMIO::InvalidWrite<u16>()
 	);
 
@@ -245,8 +249,8 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 	{
 		mmio->Register(base | (PE_BBOX_LEFT + 2 * i),
 			MMIO::ComplexRead<u16>([i](u32) {
-				bbox_active = false;
-				return bbox[i];
+				CommandProcessor::SyncGPU();
+				return Video_GetBoundingBox(i);
 			}),
 			MMIO::InvalidWrite<u16>()
 		);
@@ -311,6 +315,13 @@ void SetFinish_OnMainThread(u64 userdata, int cyclesLate)
 // THIS IS EXECUTED FROM VIDEO THREAD
 void SetToken(const u16 _token, const int _bSetTokenAcknowledge)
 {
+	// The token and its interrupt are set on the CPU thread at a sync point
+	if (CommandProcessor::IsDeterministic())
+	{
+		CommandProcessor::QueueDeterministicEvent(et_SetTokenOnMainThread, _token | (_bSetTokenAcknowledge << 16));
+		return;
+	}
+
 	if (_bSetTokenAcknowledge) // set token INT
 	{
 		Common::AtomicStore(*(volatile u32*)&g_bSignalTokenInterrupt, 1);
@@ -324,6 +335,13 @@ void SetToken(const u16 _token, const int _bSetTokenAcknowledge)
 // THIS IS EXECUTED FROM VIDEO THREAD (BPStructs.cpp) when a new frame has been drawn
 void SetFinish()
 {
+	if (CommandProcessor::IsDeterministic())
+	{
+		CommandProcessor::QueueDeterministicEvent(et_SetFinishOnMainThread, 0);
+		INFO_LOG(PIXELENGINE, "VIDEO Set Finish");
+		return;
+	}
+
 	CommandProcessor::interruptFinishWaiting = true;
 	CoreTiming::ScheduleEvent_Threadsafe(0, et_SetFinishOnMainThread, 0);
 	INFO_LOG(PIXELENGINE, "VIDEO Set Finish");
@@ -342,6 +360,7 @@ void ResetSetFinish()
 	else
 	{
 		CoreTiming::RemoveEvent(et_SetFinishOnMainThread);
+		CommandProcessor::RemoveDeterministicEvents(et_SetFinishOnMainThread);
 	}
 	CommandProcessor::interruptFinishWaiting = false;
 }
@@ -356,6 +375,7 @@ void ResetSetToken()
 	else
 	{
 		CoreTiming::RemoveEvent(et_SetTokenOnMainThread);
+		CommandProcessor::RemoveDeterministicEvents(et_SetTokenOnMainThread);
 	}
 	CommandProcessor::interruptTokenWaiting = false;
 }
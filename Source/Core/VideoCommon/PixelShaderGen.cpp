@@ -16,6 +16,7 @@
 #include "BPMemory.h"
 #include "VideoConfig.h"
 #include "NativeVertexFormat.h"
+#include "PixelEngine.h"
 
 
 //   old tev->pixelshader notes
@@ -219,44 +220,8 @@ template<class T> static inline void SampleTexture(T& out, const char *texcoords
 template<class T> static inline void WriteAlphaTest(T& out, pixel_shader_uid_data& uid_data, API_TYPE ApiType,DSTALPHA_MODE dstAlphaMode, bool per_pixel_depth);
 template<class T> static inline void WriteFog(T& out, pixel_shader_uid_data& uid_data);
 
-template<class T>
-static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
+static void WriteDeclarations(ShaderCode& out, API_TYPE ApiType, bool multi_draw)
 {
-	// Non-uid template parameters will write to the dummy data (=> gets optimized out)
-	pixel_shader_uid_data dummy_data;
-	pixel_shader_uid_data& uid_data = (&out.template GetUidData<pixel_shader_uid_data>() != NULL)
-										? out.template GetUidData<pixel_shader_uid_data>() : dummy_data;
-
-	out.SetBuffer(text);
-	const bool is_writing_shadercode = (out.GetBuffer() != NULL);
-#ifndef ANDROID
-	locale_t locale;
-	locale_t old_locale;
-	if (is_writing_shadercode)
-	{
-		locale = newlocale(LC_NUMERIC_MASK, "C", NULL); // New locale for compilation
-		old_locale = uselocale(locale); // Apply the locale for this thread
-	}
-#endif
-
-	if (is_writing_shadercode)
-		text[sizeof(text) - 1] = 0x7C;  // canary
-
-	unsigned int numStages = bpmem.genMode.numtevstages + 1;
-	unsigned int numTexgen = bpmem.genMode.numtexgens;
-
-	const bool forced_early_z = g_ActiveConfig.backend_info.bSupportsEarlyZ && bpmem.UseEarlyDepthTest() && (g_ActiveConfig.bFastDepthCalc || bpmem.alpha_test.TestResult() == AlphaTest::UNDETERMINED);
-	const bool per_pixel_depth = (bpmem.ztex2.op != ZTEXTURE_DISABLE && bpmem.UseLateDepthTest()) || (!g_ActiveConfig.bFastDepthCalc && bpmem.zmode.testenable && !forced_early_z);
-
-	out.Write("//Pixel Shader for TEV stages\n");
-	out.Write("//%i TEV stages, %i texgens, %i IND stages\n",
-		numStages, numTexgen, bpmem.genMode.numindstages);
-
-	uid_data.dstAlphaMode = dstAlphaMode;
-	uid_data.genMode_numindstages = bpmem.genMode.numindstages;
-	uid_data.genMode_numtevstages = bpmem.genMode.numtevstages;
-	uid_data.genMode_numtexgens = bpmem.genMode.numtexgens;
-
 	if (ApiType == API_OPENGL)
 	{
 		// Fmod implementation gleaned from Nvidia
@@ -283,7 +248,9 @@ static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_T
 	}
 	out.Write("\n");
 
-	if (ApiType == API_OPENGL)
+	if (ApiType == API_OPENGL && multi_draw)
+		out.Write("struct PSConstants {\n");
+	else if (ApiType == API_OPENGL)
 		out.Write("layout(std140%s) uniform PSBlock {\n", g_ActiveConfig.backend_info.bSupportShadingLanguage420pack ? ", binding = 1" : "");
 
 	DeclareUniform(out, ApiType, C_COLORS, "float4", I_COLORS"[4]");
@@ -302,6 +269,80 @@ static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_T
 	if (ApiType == API_OPENGL)
 		out.Write("};\n");
 
+	if (multi_draw)
+	{
+		static const char* const members[] = {
+			I_COLORS, I_KCOLORS, I_ALPHA, I_TEXDIMS, I_ZBIAS, I_INDTEXSCALE,
+			I_INDTEXMTX, I_FOG, I_PLIGHTS, I_PMATERIALS,
+		};
+		DeclareMultiDrawBlock(out, "PSBlock", "PSConstants", "ps_draws", 1, members, ArraySize(members));
+		out.Write("flat in uint draw_index_2;\n"
+			"#define DRAW_INDEX draw_index_2\n");
+	}
+}
+
+template<class T>
+static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
+{
+	// Non-uid template parameters will write to the dummy data (=> gets optimized out)
+	pixel_shader_uid_data dummy_data;
+	pixel_shader_uid_data& uid_data = (&out.template GetUidData<pixel_shader_uid_data>() != NULL)
+										? out.template GetUidData<pixel_shader_uid_data>() : dummy_data;
+
+	out.SetBuffer(text);
+	const bool is_writing_shadercode = (out.GetBuffer() != NULL);
+#ifndef ANDROID
+	// Created once, making a locale for every shader is surprisingly slow
+	static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", NULL);
+	locale_t old_locale;
+	if (is_writing_shadercode)
+	{
+		old_locale = uselocale(locale); // Apply the locale for this thread
+	}
+#endif
+
+	if (is_writing_shadercode)
+		text[sizeof(text) - 1] = 0x7C;  // canary
+
+	unsigned int numStages = bpmem.genMode.numtevstages + 1;
+	unsigned int numTexgen = bpmem.genMode.numtexgens;
+
+	const bool forced_early_z = g_ActiveConfig.backend_info.bSupportsEarlyZ && bpmem.UseEarlyDepthTest() && (g_ActiveConfig.bFastDepthCalc || bpmem.alpha_test.TestResult() == AlphaTest::UNDETERMINED);
+	const bool per_pixel_depth = (bpmem.ztex2.op != ZTEXTURE_DISABLE && bpmem.UseLateDepthTest()) || (!g_ActiveConfig.bFastDepthCalc && bpmem.zmode.testenable && !forced_early_z);
+
+	out.Write("//Pixel Shader for TEV stages\n");
+	out.Write("//%i TEV stages, %i texgens, %i IND stages\n",
+		numStages, numTexgen, bpmem.genMode.numindstages);
+
+	uid_data.dstAlphaMode = dstAlphaMode;
+	uid_data.genMode_numindstages = bpmem.genMode.numindstages;
+	uid_data.genMode_numtevstages = bpmem.genMode.numtevstages;
+	uid_data.genMode_numtexgens = bpmem.genMode.numtexgens;
+	uid_data.bounding_box = g_ActiveConfig.GPUBBoxEnabled() && PixelEngine::bbox_active;
+
+	uid_data.multi_draw = ApiType == API_OPENGL && g_ActiveConfig.MultiDrawEnabled();
+
+	// The declarations only depend on the API and a couple of backend features
+	if (is_writing_shadercode)
+	{
+		static ShaderSnippetCache snippets;
+		const bool multi_draw = uid_data.multi_draw;
+		const u32 key = ApiType | (multi_draw << 8) | (g_ActiveConfig.backend_info.bSupportShadingLanguage420pack << 9);
+		out.Append(snippets.Get("declarations", key, [&](ShaderCode& code) {
+			WriteDeclarations(code, ApiType, multi_draw);
+		}));
+	}
+
+	// Bounding box as {left, right, bottom/top, top/bottom} in host window coordinates,
+	// the backend converts it to EFB coordinates when the registers are read
+	if (uid_data.bounding_box)
+	{
+		if (ApiType == API_OPENGL)
+			out.Write("layout(std430, binding = 3) buffer BBox {\n\tint bbox_data[4];\n};\n");
+		else
+			out.Write("globallycoherent RWBuffer<int> bbox_data : register(u2);\n");
+	}
+
 	if (ApiType == API_OPENGL)
 	{
 		out.Write("out vec4 ocol0;\n");
@@ -540,6 +581,17 @@ static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_T
 	if (Pretest == AlphaTest::UNDETERMINED || (Pretest == AlphaTest::FAIL && bpmem.UseLateDepthTest()))
 		WriteAlphaTest<T>(out, uid_data, ApiType, dstAlphaMode, per_pixel_depth);
 
+	// Only pixels which survived the alpha test extend the bounding box
+	if (uid_data.bounding_box)
+	{
+		const char* atomic_op = (ApiType == API_OPENGL) ? "atomic" : "Interlocked";
+		out.Write("\tint2 bbox_pos = int2(rawpos.xy);\n");
+		out.Write("\tif (bbox_data[0] > bbox_pos.x) %sMin(bbox_data[0], bbox_pos.x);\n", atomic_op);
+		out.Write("\tif (bbox_data[1] < bbox_pos.x) %sMax(bbox_data[1], bbox_pos.x);\n", atomic_op);
+		out.Write("\tif (bbox_data[2] > bbox_pos.y) %sMin(bbox_data[2], bbox_pos.y);\n", atomic_op);
+		out.Write("\tif (bbox_data[3] < bbox_pos.y) %sMax(bbox_data[3], bbox_pos.y);\n", atomic_op);
+	}
+
 	// FastDepth means to trust the depth generated in perspective division.
 	// It should be correct, but it seems not to be as accurate as required. TODO: Find out why!
 	// For disabled FastDepth we just calculate the depth value again.
@@ -617,7 +669,6 @@ static inline void GeneratePixelShader(T& out, DSTALPHA_MODE dstAlphaMode, API_T
 
 #ifndef ANDROID
 		uselocale(old_locale); // restore locale
-		freelocale(locale);
 #endif
 	}
 }
@@ -1186,7 +1237,18 @@ static inline void WriteFog(T& out, pixel_shader_uid_data& uid_data)
 
 void GetPixelShaderUid(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
 {
+	// The alpha pass alternates between two modes for the same state
+	static LastShaderUid<PixelShaderUid> s_last_uids[DSTALPHA_DUAL_SOURCE_BLEND + 1];
+	LastShaderUid<PixelShaderUid>& last = s_last_uids[dstAlphaMode];
+	if (last.Matches(components, ApiType))
+	{
+		object = last.uid;
+		return;
+	}
+
 	GeneratePixelShader<PixelShaderUid>(object, dstAlphaMode, ApiType, components);
+	object.CalculateHash();
+	last.Set(object, components, ApiType);
 }
 
 void GeneratePixelShaderCode(PixelShaderCode& object, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
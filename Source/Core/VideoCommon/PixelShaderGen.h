@@ -55,7 +55,7 @@ struct pixel_shader_uid_data
 	u32 dstAlphaMode : 2;
 	u32 Pretest : 2;
 	u32 nIndirectStagesUsed : 4;
-	u32 pad0 : 1;
+	u32 bounding_box : 1;
 
 	u32 genMode_numtexgens : 4;
 	u32 genMode_numtevstages : 4;
@@ -72,7 +72,7 @@ struct pixel_shader_uid_data
 	u32 per_pixel_depth : 1;
 	u32 forced_early_z : 1;
 	u32 early_ztest : 1;
-	u32 pad1 : 1;
+	u32 multi_draw : 1;
 
 	u32 texMtxInfo_n_projection : 8; // 8x1 bit
 	u32 tevindref_bi0 : 3;
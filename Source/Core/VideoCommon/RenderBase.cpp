@@ -22,6 +22,7 @@
 #include "VideoConfig.h"
 #include "FramebufferManagerBase.h"
 #include "TextureCacheBase.h"
+#include "VertexLoaderManager.h"
 #include "Fifo.h"
 #include "OpcodeDecoding.h"
 #include "Timer.h"
@@ -30,7 +31,9 @@
 #include "XFMemory.h"
 #include "FifoPlayer/FifoRecorder.h"
 #include "AVIDump.h"
+#include "ImageWrite.h"
 #include "Debugger.h"
+#include "DynamicResolution.h"
 #include "Statistics.h"
 #include "Core.h"
 
@@ -83,6 +86,8 @@ Renderer::Renderer()
 
 	OSDChoice = 0;
 	OSDTime = 0;
+
+	DynamicResolution::Init();
 }
 
 Renderer::~Renderer()
@@ -99,6 +104,9 @@ Renderer::~Renderer()
 	if (pFrameDump.IsOpen())
 		pFrameDump.Close();
 #endif
+
+	// Screenshots may still be being written
+	FlushImageWrites();
 }
 
 void Renderer::RenderToXFB(u32 xfbAddr, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma)
@@ -201,6 +209,11 @@ bool Renderer::CalculateTargetSize(unsigned int framebuffer_width, unsigned int
 			efb_scale_denominatorX = efb_scale_denominatorY = 1;
 			break;
 
+		case SCALE_DYNAMIC:
+			efb_scale_numeratorX = efb_scale_numeratorY = DynamicResolution::GetScaleNumerator();
+			efb_scale_denominatorX = efb_scale_denominatorY = DynamicResolution::SCALE_DENOMINATOR;
+			break;
+
 		default: // fractional & integral handled later
 			break;
 	}
@@ -284,6 +297,9 @@ void Renderer::DrawDebugText()
 	case SCALE_4X:
 		res_text = "4x";
 		break;
+	case SCALE_DYNAMIC:
+		res_text = "Dynamic";
+		break;
 	}
 
 	const char* ar_text = "";
@@ -518,6 +534,9 @@ void Renderer::Swap(u32 xfbAddr, u32 fbWidth, u32 fbHeight, const EFBRectangle&
 	g_renderer->SwapImpl(xfbAddr, fbWidth, fbHeight, rc, Gamma);
 
 	frameCount++;
+	VertexLoaderManager::CleanupCache();
+	OpcodeDecoder_Cleanup();
+	GFXDebuggerCaptureFrame();
 	GFX_DEBUGGER_PAUSE_AT(NEXT_FRAME, true);
 
 	// Begin new frame
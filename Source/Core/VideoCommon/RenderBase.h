@@ -101,6 +101,11 @@ public:
 
 	virtual u32 AccessEFB(EFBAccessType type, u32 x, u32 y, u32 poke_data) = 0;
 
+	// The PE bounding box in EFB coordinates, for VideoConfig::GPUBBoxEnabled().
+	// Index 0 to 3 is left, right, top, bottom like the PE registers.
+	virtual u16 BBoxRead(int index) = 0;
+	virtual void BBoxWrite(int index, u16 value) = 0;
+
 	// What's the real difference between these? Too similar names.
 	virtual void ResetAPIState() = 0;
 	virtual void RestoreAPIState() = 0;
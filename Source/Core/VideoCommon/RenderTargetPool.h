@@ -0,0 +1,130 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// The EFB, its resolve targets and the virtual XFBs take their render targets
+// from a pool. Targets which are given back are kept around for a while, so
+// switching the internal resolution or MSAA mode back and forth doesn't have
+// to allocate video memory each time, and targets of the same size and
+// format move between the EFB and the XFBs.
+
+#pragma once
+
+#include <list>
+
+#include "CommonTypes.h"
+#include "Statistics.h"
+
+struct RenderTargetKey
+{
+	u32 width;
+	u32 height;
+	u32 format; // chosen by the backend, one for each kind of target it creates
+	u32 samples;
+
+	bool operator==(const RenderTargetKey& other) const
+	{
+		return width == other.width && height == other.height &&
+			format == other.format && samples == other.samples;
+	}
+};
+
+template <typename Target>
+class RenderTargetPool
+{
+public:
+	// Unused targets are freed, the oldest first, once they take more than this
+	RenderTargetPool(u64 max_unused_size = 256 << 20)
+		: m_max_unused_size(max_unused_size), m_used_size(0), m_unused_size(0) {}
+
+	// The backend must call Clear from its destructor
+	virtual ~RenderTargetPool() {}
+
+	Target Acquire(const RenderTargetKey& key)
+	{
+		for (typename std::list<Entry>::iterator it = m_unused.begin(); it != m_unused.end(); ++it)
+		{
+			if (it->key == key)
+			{
+				m_unused_size -= it->size;
+				m_used_size += it->size;
+				m_used.splice(m_used.begin(), m_unused, it);
+				UpdateStats();
+				return m_used.front().target;
+			}
+		}
+
+		Entry entry;
+		entry.key = key;
+		entry.size = GetTargetSize(key);
+		entry.target = CreateTarget(key);
+		m_used.push_front(entry);
+		m_used_size += entry.size;
+
+		INCSTAT(stats.numRenderTargetsCreated);
+		UpdateStats();
+		return entry.target;
+	}
+
+	// The contents of a target are undefined when it's acquired again
+	void Release(const RenderTargetKey& key, Target target)
+	{
+		for (typename std::list<Entry>::iterator it = m_used.begin(); it != m_used.end(); ++it)
+		{
+			if (it->target == target && it->key == key)
+			{
+				m_used_size -= it->size;
+				m_unused_size += it->size;
+				m_unused.splice(m_unused.begin(), m_used, it);
+				break;
+			}
+		}
+
+		while (m_unused_size > m_max_unused_size)
+		{
+			DestroyTarget(m_unused.back().key, m_unused.back().target);
+			m_unused_size -= m_unused.back().size;
+			m_unused.pop_back();
+		}
+		UpdateStats();
+	}
+
+	// Frees the targets which aren't in use
+	void Clear()
+	{
+		for (const Entry& entry : m_unused)
+			DestroyTarget(entry.key, entry.target);
+		m_unused.clear();
+		m_unused_size = 0;
+		UpdateStats();
+	}
+
+protected:
+	virtual Target CreateTarget(const RenderTargetKey& key) = 0;
+	virtual void DestroyTarget(const RenderTargetKey& key, Target target) = 0;
+	// In bytes, for the statistics and the limit on unused targets
+	virtual u64 GetTargetSize(const RenderTargetKey& key) const = 0;
+
+private:
+	struct Entry
+	{
+		RenderTargetKey key;
+		Target target;
+		u64 size;
+	};
+
+	void UpdateStats()
+	{
+		SETSTAT(stats.numRenderTargetsAlive, m_used.size() + m_unused.size());
+		SETSTAT(stats.renderTargetMemory, m_used_size >> 10);
+		SETSTAT(stats.renderTargetPoolMemory, m_unused_size >> 10);
+	}
+
+	// Most recently moved to the front
+	std::list<Entry> m_used;
+	std::list<Entry> m_unused;
+
+	u64 m_max_unused_size;
+	u64 m_used_size;
+	u64 m_unused_size;
+};
@@ -0,0 +1,62 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstddef>
+
+#include "BPMemory.h"
+#include "ShaderGenCommon.h"
+#include "XFMemory.h"
+
+u32 g_shader_uid_version = 1;
+
+// The registers the pixel and vertex shader UIDs are built from. Keep these
+// in sync with the fields GeneratePixelShader and GenerateVertexShader read.
+static bool s_bp_uid_regs[256];
+static bool s_xf_uid_regs[sizeof(XFRegisters) / 4];
+
+static void MarkRegs(bool* regs, size_t offset, size_t size)
+{
+	for (size_t i = offset / 4; i < (offset + size + 3) / 4; ++i)
+		regs[i] = true;
+}
+
+#define MARK_BP_FIELD(field) MarkRegs(s_bp_uid_regs, offsetof(BPMemory, field), sizeof(bpmem.field))
+#define MARK_XF_FIELD(field) MarkRegs(s_xf_uid_regs, offsetof(XFRegisters, field), sizeof(xfregs.field))
+
+static struct ShaderUidRegs
+{
+	ShaderUidRegs()
+	{
+		MARK_BP_FIELD(genMode);
+		MARK_BP_FIELD(tevind);
+		MARK_BP_FIELD(tevindref);
+		MARK_BP_FIELD(tevorders);
+		MARK_BP_FIELD(zmode);
+		MARK_BP_FIELD(zcontrol);
+		MARK_BP_FIELD(combiners);
+		MARK_BP_FIELD(fogRange.Base);
+		MARK_BP_FIELD(fog.c_proj_fsel);
+		MARK_BP_FIELD(alpha_test);
+		MARK_BP_FIELD(ztex2);
+		MARK_BP_FIELD(tevksel);
+
+		MARK_XF_FIELD(numChan);
+		MARK_XF_FIELD(color);
+		MARK_XF_FIELD(alpha);
+		MARK_XF_FIELD(dualTexTrans);
+		MARK_XF_FIELD(numTexGen);
+		MARK_XF_FIELD(texMtxInfo);
+		MARK_XF_FIELD(postMtxInfo);
+	}
+} s_shader_uid_regs;
+
+bool IsShaderUidBPReg(u32 address)
+{
+	return address < 256 && s_bp_uid_regs[address];
+}
+
+bool IsShaderUidXFReg(u32 index)
+{
+	return index < sizeof(XFRegisters) / 4 && s_xf_uid_regs[index];
+}
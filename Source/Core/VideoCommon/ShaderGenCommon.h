@@ -6,12 +6,17 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
 #include "CommonTypes.h"
 #include "VideoCommon.h"
+#include "VideoConfig.h"
+#include "ConstantManager.h"
 
 /**
  * Common interface for classes that need to go through the shader generation path (GenerateVertexShader, GeneratePixelShader)
@@ -30,6 +35,11 @@ public:
 	 */
 	void Write(const char* fmt, ...) {}
 
+	/*
+	 * Used to write a piece of already generated code, e.g. from a ShaderSnippetCache.
+	 */
+	void Append(const std::string& code) {}
+
 	/*
 	 * Returns a read pointer to the internal buffer.
 	 * @note When implementing this method in a child class, you likely want to return the argument of the last SetBuffer call here
@@ -66,20 +76,21 @@ template<class uid_data>
 class ShaderUid : public ShaderGeneratorInterface
 {
 public:
-	ShaderUid()
+	ShaderUid() : hash(0)
 	{
 		// TODO: Move to Shadergen => can be optimized out
 		memset(values, 0, sizeof(values));
 	}
 
+	// The hashes differ for almost all UIDs that do, so they are compared first
 	bool operator == (const ShaderUid& obj) const
 	{
-		return memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) == 0;
+		return hash == obj.hash && memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) == 0;
 	}
 
 	bool operator != (const ShaderUid& obj) const
 	{
-		return memcmp(this->values, obj.values, data.NumValues() * sizeof(*values)) != 0;
+		return !(*this == obj);
 	}
 
 	// determines the storage order inside STL containers
@@ -94,12 +105,76 @@ public:
 	const uid_data& GetUidData() const { return data; }
 	size_t GetUidDataSize() const { return sizeof(values); }
 
+	// Called by the UID generators once the UID data is complete. The hash is
+	// stored in the disk caches along with the data, so it doesn't use
+	// GetHash64, which depends on the texture hashing setting.
+	void CalculateHash()
+	{
+		// FNV-1a
+		u64 h = 0xcbf29ce484222325ULL;
+		for (u32 i = 0; i < data.NumValues(); ++i)
+			h = (h ^ values[i]) * 0x100000001b3ULL;
+		hash = h;
+	}
+
+	u64 GetHash() const { return hash; }
+
+	// For hash-based containers
+	struct Hasher
+	{
+		size_t operator()(const ShaderUid& uid) const { return (size_t)uid.hash; }
+	};
+
 private:
 	union
 	{
 		uid_data data;
 		u8 values[sizeof(uid_data)];
 	};
+	u64 hash;
+};
+
+/**
+ * The UID generators only read a few of the BP and XF registers besides the
+ * config and their arguments. Writes that change one of those registers, and
+ * config changes, bump the UID state version, so the last UIDs can be reused
+ * as long as it stays the same.
+ */
+extern u32 g_shader_uid_version;
+
+inline void InvalidateShaderUids() { ++g_shader_uid_version; }
+
+// Whether the UIDs depend on the BP register at address / the XF register at 0x1000 + index
+bool IsShaderUidBPReg(u32 address);
+bool IsShaderUidXFReg(u32 index);
+
+/**
+ * The last UID a generator returned for one combination of arguments.
+ */
+template<class UidT>
+struct LastShaderUid
+{
+	LastShaderUid() : version(0), components(0), api_type(API_NONE), valid(false) {}
+
+	bool Matches(u32 _components, API_TYPE _api_type) const
+	{
+		return valid && version == g_shader_uid_version && components == _components && api_type == _api_type;
+	}
+
+	void Set(const UidT& _uid, u32 _components, API_TYPE _api_type)
+	{
+		uid = _uid;
+		version = g_shader_uid_version;
+		components = _components;
+		api_type = _api_type;
+		valid = true;
+	}
+
+	UidT uid;
+	u32 version;
+	u32 components;
+	API_TYPE api_type;
+	bool valid;
 };
 
 class ShaderCode : public ShaderGeneratorInterface
@@ -112,12 +187,27 @@ public:
 
 	void Write(const char* fmt, ...)
 	{
+		// Most of the lines don't format anything
+		if (!strchr(fmt, '%'))
+		{
+			const size_t length = strlen(fmt);
+			memcpy(write_ptr, fmt, length + 1);
+			write_ptr += length;
+			return;
+		}
+
 		va_list arglist;
 		va_start(arglist, fmt);
 		write_ptr += vsprintf(write_ptr, fmt, arglist);
 		va_end(arglist);
 	}
 
+	void Append(const std::string& code)
+	{
+		memcpy(write_ptr, code.c_str(), code.size() + 1);
+		write_ptr += code.size();
+	}
+
 	const char* GetBuffer() { return buf; }
 	void SetBuffer(char* buffer) { buf = buffer; write_ptr = buffer; }
 
@@ -126,6 +216,36 @@ private:
 	char* write_ptr;
 };
 
+/**
+ * Pieces of shader code which only depend on a few parameters, like the
+ * declarations or the code of one light, are generated once for each
+ * combination of them and then copied into every new shader instead of being
+ * formatted again. Only for generators writing code (GetBuffer() != NULL).
+ */
+class ShaderSnippetCache
+{
+public:
+	// Returns the snippet for name and key, generate(ShaderCode&) writes it the first time
+	template<class F>
+	const std::string& Get(const char* name, u32 key, F generate)
+	{
+		const std::pair<std::string, u32> id(name, key);
+		auto it = m_snippets.find(id);
+		if (it != m_snippets.end())
+			return it->second;
+
+		static char buffer[8192];
+		buffer[0] = '\0';
+		ShaderCode code;
+		code.SetBuffer(buffer);
+		generate(code);
+		return m_snippets[id] = buffer;
+	}
+
+private:
+	std::map<std::pair<std::string, u32>, std::string> m_snippets;
+};
+
 /**
  * Generates a shader constant profile which can be used to query which constants are used in a shader
  */
@@ -177,6 +297,23 @@ static inline void DeclareUniform(T& object, API_TYPE api_type, const u32 num, c
 	object.Write(";\n");
 }
 
+// With multi-draw, the constants are declared as the members of struct_name
+// instead of a block, and this declares the block as an array of them with one
+// element per draw of the batch. The member names are mapped to the element
+// of the current draw, DRAW_INDEX, so the shader code doesn't change.
+template<class T>
+static inline void DeclareMultiDrawBlock(T& object, const char* block_name, const char* struct_name,
+	const char* array_name, int binding, const char* const* members, size_t num_members)
+{
+	object.Write("layout(std140");
+	if (g_ActiveConfig.backend_info.bSupportShadingLanguage420pack)
+		object.Write(", binding = %d", binding);
+	object.Write(") uniform %s {\n\t%s %s[%d];\n};\n", block_name, struct_name, array_name, MULTIDRAW_BATCH_SIZE);
+
+	for (size_t i = 0; i < num_members; ++i)
+		object.Write("#define %s %s[DRAW_INDEX].%s\n", members[i], array_name, members[i]);
+}
+
 /**
  * Checks if there has been
  */
@@ -28,6 +28,12 @@ char *Statistics::ToString(char *ptr)
 	char *p = ptr;
 	ptr+=sprintf(ptr,"Textures created: %i\n",stats.numTexturesCreated);
 	ptr+=sprintf(ptr,"Textures alive: %i\n",stats.numTexturesAlive);
+	ptr+=sprintf(ptr,"Textures reused: %i\n",stats.numTexturesReused);
+	ptr+=sprintf(ptr,"Textures evicted: %i\n",stats.numTexturesEvicted);
+	ptr+=sprintf(ptr,"Texture memory: %i KiB cached, %i KiB pooled\n",stats.textureMemory,stats.texturePoolMemory);
+	ptr+=sprintf(ptr,"Render targets created: %i\n",stats.numRenderTargetsCreated);
+	ptr+=sprintf(ptr,"Render targets alive: %i\n",stats.numRenderTargetsAlive);
+	ptr+=sprintf(ptr,"Render target memory: %i KiB in use, %i KiB pooled\n",stats.renderTargetMemory,stats.renderTargetPoolMemory);
 	ptr+=sprintf(ptr,"pshaders created: %i\n",stats.numPixelShadersCreated);
 	ptr+=sprintf(ptr,"pshaders alive: %i\n",stats.numPixelShadersAlive);
 	ptr+=sprintf(ptr,"pshaders (unique, delete cache first): %i\n",stats.numUniquePixelShaders);
@@ -17,9 +17,15 @@ struct Statistics
 
 	int numTexturesCreated;
 	int numTexturesAlive;
+	int numTexturesReused; // taken from the pool of deleted textures
+	int numTexturesEvicted; // deleted to stay under the texture cache budget
+	int textureMemory; // KiB, of the textures in the cache
+	int texturePoolMemory; // KiB, of the pooled textures
 
 	int numRenderTargetsCreated;
 	int numRenderTargetsAlive;
+	int renderTargetMemory; // KiB, of the targets in use
+	int renderTargetPoolMemory; // KiB, of the unused targets kept for later
 
 	int numDListsCalled;
 	int numDListsCreated;
@@ -2,11 +2,15 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
+
 #include "MemoryUtil.h"
 
 #include "VideoConfig.h"
 #include "Statistics.h"
 #include "HiresTextures.h"
+#include "ImageWrite.h"
 #include "RenderBase.h"
 #include "FileUtil.h"
 
@@ -14,6 +18,8 @@
 #include "Debugger.h"
 #include "ConfigManager.h"
 #include "HW/Memmap.h"
+#include "PerfTrace.h"
+#include "ThreadPool.h"
 
 // ugly
 extern int frameCount;
@@ -21,6 +27,7 @@ extern int frameCount;
 enum
 {
 	TEXTURE_KILL_THRESHOLD = 200,
+	TEXTURE_DECODE_THREAD_THRESHOLD = 256 * 256, // texels, smaller textures are decoded in one go
 };
 
 TextureCache *g_texture_cache;
@@ -29,6 +36,12 @@ GC_ALIGNED16(u8 *TextureCache::temp) = NULL;
 unsigned int TextureCache::temp_size;
 
 TextureCache::TexCache TextureCache::textures;
+TextureCache::TexPageIndex TextureCache::texture_pages;
+std::vector<TextureCache::TCacheEntryBase*> TextureCache::texture_pool;
+u64 TextureCache::texture_memory;
+u64 TextureCache::pool_memory;
+std::vector<TextureCache::TCacheEntryBase*> TextureCache::range_entries;
+u32 TextureCache::hash_epoch = 1;
 
 TextureCache::BackupConfig TextureCache::backup_config;
 
@@ -38,6 +51,108 @@ TextureCache::TCacheEntryBase::~TCacheEntryBase()
 {
 }
 
+// In bytes, what the backends allocate for a texture of the given format
+static u64 EstimateTextureSize(unsigned int width, unsigned int height, unsigned int levels, PC_TexFormat pcfmt)
+{
+	u64 size = 0;
+	for (unsigned int level = 0; level < levels; ++level)
+	{
+		const u64 mip_width = std::max(width >> level, 1u);
+		const u64 mip_height = std::max(height >> level, 1u);
+		switch (pcfmt)
+		{
+		case PC_TEX_FMT_I4_AS_I8:
+		case PC_TEX_FMT_I8:
+			size += mip_width * mip_height;
+			break;
+		case PC_TEX_FMT_IA4_AS_IA8:
+		case PC_TEX_FMT_IA8:
+		case PC_TEX_FMT_RGB565:
+			size += mip_width * mip_height * 2;
+			break;
+		case PC_TEX_FMT_DXT1:
+			size += ((mip_width + 3) / 4) * ((mip_height + 3) / 4) * 8;
+			break;
+		default:
+			size += mip_width * mip_height * 4;
+			break;
+		}
+	}
+	return size;
+}
+
+// Threaded texture decoding.
+// GC textures are stored as rows of blocks, so a band of block rows is
+// contiguous in both the source and the decoded texture. Large textures are
+// split into bands that are decoded on the common thread pool, the video
+// thread taking one of them.
+
+// Size of a decoded texel as written by TexDecoder_Decode, or 0 if unknown.
+static int GetDecodedTexelSize(int texformat, int tlutfmt, bool rgba)
+{
+	if (rgba)
+		return 4;
+
+	switch (texformat)
+	{
+	case GX_TF_I4:
+	case GX_TF_I8:
+		return 1;
+	case GX_TF_IA4:
+	case GX_TF_IA8:
+	case GX_TF_RGB565:
+		return 2;
+	case GX_TF_C4:
+	case GX_TF_C8:
+	case GX_TF_C14X2:
+		return (tlutfmt == 2) ? 4 : 2;
+	case GX_TF_RGB5A3:
+	case GX_TF_RGBA8:
+	case GX_TF_CMPR:
+		return 4;
+	}
+	return 0;
+}
+
+static PC_TexFormat DecodeTexture(u8* dst, const u8* src, int width, int height, int texformat, int tlutaddr, int tlutfmt)
+{
+	PERF_SCOPE(CAT_TEXTURE_DECODE);
+
+	const bool rgba = g_ActiveConfig.backend_info.bUseRGBATextures;
+	const int texel_size = GetDecodedTexelSize(texformat, tlutfmt, rgba);
+
+	bool threaded = g_ActiveConfig.bThreadedTextureDecoding && Common::ThreadPool::GetNumWorkers() > 0 &&
+		texel_size && !g_ActiveConfig.bTexFmtOverlayEnable &&
+		width * height >= TEXTURE_DECODE_THREAD_THRESHOLD;
+#ifdef _OPENMP
+	// the OpenMP decoder already spreads the work
+	threaded &= !g_ActiveConfig.bOMPDecoder;
+#endif
+
+	if (!threaded)
+		return TexDecoder_Decode(dst, src, width, height, texformat, tlutaddr, tlutfmt, rgba);
+
+	const int block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+	const int block_rows = height / block_height;
+	const int src_row_size = TexDecoder_GetTextureSizeInBytes(width, block_height, texformat);
+	const int dst_row_size = width * block_height * texel_size;
+
+	// Every band returns the same format, so keep the one of the first band.
+	PC_TexFormat pcfmt = PC_TEX_FMT_NONE;
+	Common::ThreadPool::ParallelFor(block_rows, [&](int first_row, int last_row)
+	{
+		// the last band also takes any partial block row at the bottom
+		const int band_height = (last_row == block_rows) ? height - first_row * block_height :
+			(last_row - first_row) * block_height;
+		const PC_TexFormat band_fmt = TexDecoder_Decode(dst + first_row * dst_row_size,
+			src + first_row * src_row_size, width, band_height, texformat, tlutaddr, tlutfmt, rgba);
+		if (first_row == 0)
+			pcfmt = band_fmt;
+	});
+
+	return pcfmt;
+}
+
 TextureCache::TextureCache()
 {
 	temp_size = 2048 * 2048 * 4;
@@ -47,7 +162,7 @@ TextureCache::TextureCache()
 	TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
 
 	if(g_ActiveConfig.bHiresTextures && !g_ActiveConfig.bDumpTextures)
-		HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
+		HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), g_ActiveConfig.bCacheHiresTextures);
 
 	SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
 
@@ -68,10 +183,15 @@ void TextureCache::Invalidate()
 		delete iter->second;
 
 	textures.clear();
+	texture_pages.clear();
+	texture_memory = 0;
+	ClearPool();
 }
 
 TextureCache::~TextureCache()
 {
+	HiresTextures::Shutdown();
+	FlushImageWrites();
 	Invalidate();
 	if (temp)
 	{
@@ -89,12 +209,14 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 			config.bTexFmtOverlayEnable != backup_config.s_texfmt_overlay ||
 			config.bTexFmtOverlayCenter != backup_config.s_texfmt_overlay_center ||
 			config.bHiresTextures != backup_config.s_hires_textures ||
+			config.bCacheHiresTextures != backup_config.s_cache_hires_textures ||
+			config.bGPUTextureDecoding != backup_config.s_gpu_texture_decoding ||
 			invalidate_texture_cache_requested)
 		{
 			g_texture_cache->Invalidate();
 
 			if(g_ActiveConfig.bHiresTextures)
-				HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
+				HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), g_ActiveConfig.bCacheHiresTextures);
 
 			SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
 			TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
@@ -121,79 +243,284 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 	backup_config.s_texfmt_overlay = config.bTexFmtOverlayEnable;
 	backup_config.s_texfmt_overlay_center = config.bTexFmtOverlayCenter;
 	backup_config.s_hires_textures = config.bHiresTextures;
+	backup_config.s_cache_hires_textures = config.bCacheHiresTextures;
 	backup_config.s_copy_cache_enable = config.bEFBCopyCacheEnable;
+	backup_config.s_gpu_texture_decoding = config.bGPUTextureDecoding;
 }
 
-void TextureCache::Cleanup()
+void TextureCache::IndexEntry(u32 texID, TCacheEntryBase* entry)
 {
-	TexCache::iterator iter = textures.begin();
-	TexCache::iterator tcend = textures.end();
-	while (iter != tcend)
+	// An entry covers [addr, addr + size_in_bytes], see IntersectsMemoryRange
+	const u32 first_page = entry->addr >> TEXCACHE_PAGE_SHIFT;
+	const u32 last_page = (entry->addr + entry->size_in_bytes) >> TEXCACHE_PAGE_SHIFT;
+
+	if (entry->indexed && entry->tex_id == texID &&
+	    entry->first_page == first_page && entry->last_page == last_page)
+		return;
+
+	UnindexEntry(entry);
+
+	entry->tex_id = texID;
+	entry->first_page = first_page;
+	entry->last_page = last_page;
+	entry->indexed = true;
+
+	for (u32 page = first_page; page <= last_page; ++page)
+		texture_pages[page].push_back(entry);
+
+	textures[texID] = entry;
+}
+
+void TextureCache::UnindexEntry(TCacheEntryBase* entry)
+{
+	if (!entry->indexed)
+		return;
+
+	for (u32 page = entry->first_page; page <= entry->last_page; ++page)
 	{
-		if (	frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount
+		TexPageIndex::iterator bucket = texture_pages.find(page);
+		if (bucket == texture_pages.end())
+			continue;
 
-			// EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
-			&& ! iter->second->IsEfbCopy() )
+		std::vector<TCacheEntryBase*>& page_entries = bucket->second;
+		std::vector<TCacheEntryBase*>::iterator it = std::find(page_entries.begin(), page_entries.end(), entry);
+		if (it != page_entries.end())
 		{
-			delete iter->second;
-			textures.erase(iter++);
+			*it = page_entries.back();
+			page_entries.pop_back();
 		}
-		else
+		if (page_entries.empty())
+			texture_pages.erase(bucket);
+	}
+
+	TexCache::iterator iter = textures.find(entry->tex_id);
+	if (iter != textures.end() && iter->second == entry)
+		textures.erase(iter);
+
+	entry->indexed = false;
+}
+
+// Creating a texture costs a lot more than loading new data into one, so the
+// textures of deleted entries are kept for a while in case another texture of
+// the same size and format comes along, which it usually does
+void TextureCache::DeleteEntry(TCacheEntryBase* entry)
+{
+	UnindexEntry(entry);
+
+	if (entry->pool_pcfmt == PC_TEX_FMT_NONE)
+	{
+		FreeEntry(entry);
+		return;
+	}
+
+	if (texture_pool.size() >= TEXCACHE_POOL_SIZE)
+	{
+		pool_memory -= texture_pool.front()->memory_size;
+		delete texture_pool.front();
+		texture_pool.erase(texture_pool.begin());
+	}
+	texture_memory -= entry->memory_size;
+	pool_memory += entry->memory_size;
+	entry->frameCount = frameCount;
+	texture_pool.push_back(entry);
+}
+
+// For entries which are neither in the pool nor indexed any more
+void TextureCache::FreeEntry(TCacheEntryBase* entry)
+{
+	texture_memory -= entry->memory_size;
+	delete entry;
+}
+
+TextureCache::TCacheEntryBase* TextureCache::TakePooledEntry(unsigned int width, unsigned int height,
+	unsigned int tex_levels, PC_TexFormat pcfmt)
+{
+	for (size_t i = texture_pool.size(); i-- > 0;)
+	{
+		TCacheEntryBase* entry = texture_pool[i];
+		if (entry->pool_width == width && entry->pool_height == height &&
+		    entry->pool_levels == tex_levels && entry->pool_pcfmt == pcfmt)
 		{
-			++iter;
+			texture_pool.erase(texture_pool.begin() + i);
+			pool_memory -= entry->memory_size;
+			texture_memory += entry->memory_size;
+			return entry;
 		}
 	}
+	return NULL;
 }
 
-void TextureCache::InvalidateRange(u32 start_address, u32 size)
+void TextureCache::ClearPool()
 {
-	TexCache::iterator
-		iter = textures.begin(),
-		tcend = textures.end();
-	while (iter != tcend)
+	for (TCacheEntryBase* entry : texture_pool)
+		delete entry;
+	texture_pool.clear();
+	pool_memory = 0;
+}
+
+void TextureCache::GetEntriesInRange(u32 start_address, u32 size, std::vector<TCacheEntryBase*>& result)
+{
+	result.clear();
+
+	const u32 first_page = start_address >> TEXCACHE_PAGE_SHIFT;
+	const u32 last_page = (start_address + std::max(size, 1u) - 1) >> TEXCACHE_PAGE_SHIFT;
+
+	if (last_page - first_page >= texture_pages.size())
 	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
+		// Huge range, cheaper to check every entry once
+		for (const auto& tex : textures)
 		{
-			delete iter->second;
-			textures.erase(iter++);
+			if (0 == tex.second->IntersectsMemoryRange(start_address, size))
+				result.push_back(tex.second);
 		}
-		else
+		return;
+	}
+
+	for (u32 page = first_page; page <= last_page; ++page)
+	{
+		TexPageIndex::const_iterator bucket = texture_pages.find(page);
+		if (bucket == texture_pages.end())
+			continue;
+
+		for (TCacheEntryBase* entry : bucket->second)
 		{
-			++iter;
+			if (0 == entry->IntersectsMemoryRange(start_address, size))
+				result.push_back(entry);
 		}
 	}
+
+	// Entries spanning multiple pages were picked up once per page
+	if (first_page != last_page)
+	{
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+	}
 }
 
-void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+void TextureCache::Cleanup()
 {
-	TexCache::iterator
-		iter = textures.lower_bound(start_address),
-		tcend = textures.upper_bound(start_address + size);
+	TexCache::iterator iter = textures.begin();
+	TexCache::iterator tcend = textures.end();
+	while (iter != tcend)
+	{
+		TCacheEntryBase* entry = iter->second;
+		++iter;
 
-	if (iter != textures.begin())
-		--iter;
+		if (	frameCount > TEXTURE_KILL_THRESHOLD + entry->frameCount
 
-	for (; iter != tcend; ++iter)
-	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
+			// EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
+			&& ! entry->IsEfbCopy() )
 		{
-			iter->second->SetHashes(TEXHASH_INVALID);
+			DeleteEntry(entry);
 		}
 	}
+
+	// The pool is in the order the entries were deleted in
+	size_t num_expired = 0;
+	while (num_expired < texture_pool.size() &&
+	       frameCount > TEXTURE_KILL_THRESHOLD + texture_pool[num_expired]->frameCount)
+	{
+		pool_memory -= texture_pool[num_expired]->memory_size;
+		delete texture_pool[num_expired++];
+	}
+	texture_pool.erase(texture_pool.begin(), texture_pool.begin() + num_expired);
+
+	if (g_ActiveConfig.iTextureCacheBudget > 0)
+		EvictToBudget((u64)g_ActiveConfig.iTextureCacheBudget << 20);
+
+	UpdateMemoryStats();
+}
+
+// Frees the pooled textures first, the oldest first, and then the entries
+// which cost the most to keep: those which have gone unused the longest,
+// weighted by their size, so a single big texture goes before many small ones
+// of the same age. Entries used during the last frame are left alone, as they
+// would just have to be loaded again.
+void TextureCache::EvictToBudget(u64 budget)
+{
+	size_t num_freed = 0;
+	while (texture_memory + pool_memory > budget && num_freed < texture_pool.size())
+	{
+		pool_memory -= texture_pool[num_freed]->memory_size;
+		delete texture_pool[num_freed++];
+	}
+	texture_pool.erase(texture_pool.begin(), texture_pool.begin() + num_freed);
+
+	if (texture_memory + pool_memory <= budget)
+		return;
+
+	std::vector<std::pair<u64, TCacheEntryBase*>> candidates;
+	for (const auto& tex : textures)
+	{
+		TCacheEntryBase* entry = tex.second;
+		// EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
+		if (entry->IsEfbCopy() || frameCount <= entry->frameCount + 1)
+			continue;
+		candidates.push_back(std::make_pair((u64)(frameCount - entry->frameCount) * entry->memory_size, entry));
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[](const std::pair<u64, TCacheEntryBase*>& a, const std::pair<u64, TCacheEntryBase*>& b) { return a.first > b.first; });
+
+	for (size_t i = 0; i < candidates.size() && texture_memory + pool_memory > budget; ++i)
+	{
+		UnindexEntry(candidates[i].second);
+		FreeEntry(candidates[i].second);
+		INCSTAT(stats.numTexturesEvicted);
+	}
+}
+
+void TextureCache::UpdateMemoryStats()
+{
+	SETSTAT(stats.textureMemory, texture_memory >> 10);
+	SETSTAT(stats.texturePoolMemory, pool_memory >> 10);
+}
+
+void TextureCache::InvalidateRange(u32 start_address, u32 size)
+{
+	GetEntriesInRange(start_address, size, range_entries);
+
+	for (TCacheEntryBase* entry : range_entries)
+		DeleteEntry(entry);
+}
+
+void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+{
+	GetEntriesInRange(start_address, size, range_entries);
+
+	for (TCacheEntryBase* entry : range_entries)
+		entry->SetHashes(TEXHASH_INVALID);
 }
 
 bool TextureCache::Find(u32 start_address, u64 hash)
 {
-	TexCache::iterator iter = textures.lower_bound(start_address);
+	TexCache::iterator iter = textures.find(start_address);
 
-	if (iter->second->hash == hash)
+	if (iter != textures.end() && iter->second->hash == hash)
 		return true;
 
 	return false;
 }
 
+void TextureCache::FlushEFBCopies(u32 start_address, u32 size)
+{
+	if (g_texture_cache)
+		g_texture_cache->FlushPendingEFBCopies(start_address, size);
+}
+
+void TextureCache::EFBCopyArrived(u32 dstAddr, u32 size)
+{
+	u64 const new_hash = GetHash64(Memory::GetPointer(dstAddr), size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+
+	// Mark texture entries in destination address range dynamic unless caching is enabled and the texture entry is up to date
+	if (!g_ActiveConfig.bEFBCopyCacheEnable || !Find(dstAddr, new_hash))
+		MakeRangeDynamic(dstAddr, size);
+
+	// The entry of the copy might have been replaced in the meantime
+	TexCache::iterator iter = textures.find(dstAddr);
+	if (iter != textures.end() && iter->second->IsEfbCopy())
+		iter->second->hash = new_hash;
+}
+
 int TextureCache::TCacheEntryBase::IntersectsMemoryRange(u32 range_address, u32 range_size) const
 {
 	if (addr + size_in_bytes < range_address)
@@ -213,15 +540,11 @@ void TextureCache::ClearRenderTargets()
 
 	while (iter != tcend)
 	{
-		if (iter->second->type == TCET_EC_VRAM)
-		{
-			delete iter->second;
-			textures.erase(iter++);
-		}
-		else
-		{
-			++iter;
-		}
+		TCacheEntryBase* entry = iter->second;
+		++iter;
+
+		if (entry->type == TCET_EC_VRAM)
+			DeleteEntry(entry);
 	}
 }
 
@@ -231,18 +554,13 @@ bool TextureCache::CheckForCustomTextureLODs(u64 tex_hash, int texformat, unsign
 		return false;
 
 	// Just checking if the necessary files exist, if they can't be loaded or have incorrect dimensions LODs will be black
-	char texBasePathTemp[MAX_PATH];
-	char texPathTemp[MAX_PATH];
-
-	sprintf(texBasePathTemp, "%s_%08x_%i", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), (u32) (tex_hash & 0x00000000FFFFFFFFLL), texformat);
-
 	for (unsigned int level = 1; level < levels; ++level)
 	{
-		sprintf(texPathTemp, "%s_mip%i", texBasePathTemp, level);
-		if (!HiresTextures::HiresTexExists(texPathTemp))
+		if (!HiresTextures::HiresTexExists((u32)tex_hash, texformat, level))
 		{
 			if (level > 1)
-				WARN_LOG(VIDEO, "Couldn't find custom texture LOD with index %i (filename: %s), disabling custom LODs for this texture", level, texPathTemp);
+				WARN_LOG(VIDEO, "Couldn't find custom texture LOD with index %i (filename: %s_%08x_%i_mip%i), disabling custom LODs for this texture",
+					level, SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), (u32)tex_hash, texformat, level);
 
 			return false;
 		}
@@ -252,18 +570,12 @@ bool TextureCache::CheckForCustomTextureLODs(u64 tex_hash, int texformat, unsign
 
 PC_TexFormat TextureCache::LoadCustomTexture(u64 tex_hash, int texformat, unsigned int level, unsigned int& width, unsigned int& height)
 {
-	char texPathTemp[MAX_PATH];
 	unsigned int newWidth = 0;
 	unsigned int newHeight = 0;
 	u32 tex_hash_u32 = tex_hash & 0x00000000FFFFFFFFLL;
 
-	if (level == 0)
-		sprintf(texPathTemp, "%s_%08x_%i", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), tex_hash_u32, texformat);
-	else
-		sprintf(texPathTemp, "%s_%08x_%i_mip%i", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), tex_hash_u32, texformat, level);
-
 	unsigned int required_size = 0;
-	PC_TexFormat ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, temp_size, temp);
+	PC_TexFormat ret = HiresTextures::GetHiresTex(tex_hash_u32, texformat, level, &newWidth, &newHeight, &required_size, temp_size, temp);
 	if (ret == PC_TEX_FMT_NONE && temp_size < required_size)
 	{
 		// Allocate more memory and try again
@@ -271,11 +583,17 @@ PC_TexFormat TextureCache::LoadCustomTexture(u64 tex_hash, int texformat, unsign
 		temp_size = required_size;
 		FreeAlignedMemory(temp);
 		temp = (u8*)AllocateAlignedMemory(temp_size, 16);
-		ret = HiresTextures::GetHiresTex(texPathTemp, &newWidth, &newHeight, &required_size, texformat, temp_size, temp);
+		ret = HiresTextures::GetHiresTex(tex_hash_u32, texformat, level, &newWidth, &newHeight, &required_size, temp_size, temp);
 	}
 
 	if (ret != PC_TEX_FMT_NONE)
 	{
+		char texPathTemp[MAX_PATH];
+		if (level == 0)
+			sprintf(texPathTemp, "%s_%08x_%i", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), tex_hash_u32, texformat);
+		else
+			sprintf(texPathTemp, "%s_%08x_%i_mip%i", SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str(), tex_hash_u32, texformat, level);
+
 		if (level > 0 && (newWidth != width || newHeight != height))
 			ERROR_LOG(VIDEO, "Invalid custom texture size %dx%d for texture %s. This mipmap layer _must_ be %dx%d.", newWidth, newHeight, texPathTemp, width, height);
 		if (newWidth * height != newHeight * width)
@@ -364,14 +682,6 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 
 	const u32 texture_size = TexDecoder_GetTextureSizeInBytes(expandedWidth, expandedHeight, texformat);
 
-	const u8* src_data;
-	if (from_tmem)
-		src_data = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE];
-	else
-		src_data = Memory::GetPointer(address);
-
-	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
-	tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	if (isPaletteTexture)
 	{
 		const u32 palette_size = TexDecoder_GetPaletteSize(texformat);
@@ -387,15 +697,60 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		//
 		// TODO: Because texID isn't always the same as the address now, CopyRenderTargetToTexture might be broken now
 		texID ^= ((u32)tlut_hash) ^(u32)(tlut_hash >> 32);
-		tex_hash ^= tlut_hash;
 	}
 
+	TexCache::iterator iter = textures.find(texID);
+	TCacheEntryBase *entry = (iter != textures.end()) ? iter->second : NULL;
+
+	// EFB copies that are kept in VRAM only never get compared to the RAM
+	// data, so it doesn't have to be hashed for them
+	if (entry && g_ActiveConfig.bCopyEFBToTexture && entry->IsEfbCopy() &&
+		entry->hash == TEXHASH_INVALID && address == entry->addr)
+	{
+		entry->type = TCET_EC_VRAM;
+		return ReturnEntry(stage, entry);
+	}
+
+	const u8* src_data;
+	if (from_tmem)
+	{
+		src_data = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE];
+	}
+	else
+	{
+		// Like the hash, this only looks at the first level
+		FlushEFBCopies(address, texture_size);
+		src_data = Memory::GetPointer(address);
+	}
+
+	// Games have to sync with the GPU before they change a texture it still
+	// uses, so a texture which was hashed since the last sync point is only
+	// checked with a cheap fingerprint of its first bytes. That still catches
+	// most updates from games which don't bother, unless the safe texture
+	// cache is asked to look at everything anyway.
+	const u64 fingerprint = GetHash64(src_data, std::min(texture_size, 64u), 0);
+	u64 data_hash;
+	if (entry && g_ActiveConfig.iSafeTextureCache_ColorSamples != 0 && !entry->IsEfbCopy() &&
+		entry->hash_epoch == hash_epoch && entry->fingerprint == fingerprint &&
+		address == entry->addr && texture_size == entry->size_in_bytes)
+	{
+		data_hash = entry->data_hash;
+	}
+	else
+	{
+		// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
+		data_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+	}
+
+	tex_hash = data_hash;
+	if (isPaletteTexture)
+		tex_hash ^= tlut_hash;
+
 	// D3D doesn't like when the specified mipmap count would require more than one 1x1-sized LOD in the mipmap chain
 	// e.g. 64x64 with 7 LODs would have the mipmap chain 64x64,32x32,16x16,8x8,4x4,2x2,1x1,1x1, so we limit the mipmap count to 6 there
 	while (g_ActiveConfig.backend_info.bUseMinimalMipCount && max(expandedWidth, expandedHeight) >> maxlevel == 0)
 		--maxlevel;
 
-	TCacheEntryBase *entry = textures[texID];
 	if (entry)
 	{
 		// 1. Calculate reference hash:
@@ -414,10 +769,15 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 			return ReturnEntry(stage, entry);
 		}
 
-		// 2. b) For normal textures, all texture parameters need to match
+		// 2. b) For normal textures, all texture parameters need to match. A stand-in for
+		//       a custom texture is replaced once that has been decoded.
 		if (address == entry->addr && tex_hash == entry->hash && full_format == entry->format &&
-			entry->num_mipmaps > maxlevel && entry->native_width == nativeW && entry->native_height == nativeH)
+			entry->num_mipmaps > maxlevel && entry->native_width == nativeW && entry->native_height == nativeH &&
+			!(entry->custom_pending && HiresTextures::RequestHiresTex((u32)tex_hash, texformat)))
 		{
+			entry->data_hash = data_hash;
+			entry->fingerprint = fingerprint;
+			entry->hash_epoch = hash_epoch;
 			return ReturnEntry(stage, entry);
 		}
 
@@ -435,17 +795,22 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		else
 		{
 			// delete the texture and make a new one
-			delete entry;
+			DeleteEntry(entry);
 			entry = NULL;
 		}
 	}
 
 	bool using_custom_texture = false;
+	bool custom_pending = false;
 
-	if (g_ActiveConfig.bHiresTextures)
+	if (g_ActiveConfig.bHiresTextures && HiresTextures::HiresTexExists((u32)tex_hash, texformat, 0))
 	{
+		// Until it is decoded the native texture is used
+		custom_pending = !HiresTextures::RequestHiresTex((u32)tex_hash, texformat);
+
 		// This function may modify width/height.
-		pcfmt = LoadCustomTexture(tex_hash, texformat, 0, width, height);
+		if (!custom_pending)
+			pcfmt = LoadCustomTexture(tex_hash, texformat, 0, width, height);
 		if (pcfmt != PC_TEX_FMT_NONE)
 		{
 			if (expandedWidth != width || expandedHeight != height)
@@ -456,7 +821,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				// If we thought we could reuse the texture before, make sure to pool it now!
 				if(entry)
 				{
-					delete entry;
+					DeleteEntry(entry);
 					entry = NULL;
 				}
 			}
@@ -464,12 +829,22 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		}
 	}
 
-	if (!using_custom_texture)
+	// The GPU decodes the raw data itself, which skips the CPU decoding and makes
+	// switching the TLUT of a paletted texture cheap
+	const bool decode_on_gpu = !using_custom_texture && g_ActiveConfig.bGPUTextureDecoding &&
+		!g_ActiveConfig.bTexFmtOverlayEnable && g_texture_cache->CanDecodeOnGPU(texformat, tlutfmt);
+	const u8* const tlut = &texMem[tlutaddr];
+
+	if (decode_on_gpu)
+	{
+		pcfmt = PC_TEX_FMT_RGBA32;
+	}
+	else if (!using_custom_texture)
 	{
 		if (!(texformat == GX_TF_RGBA8 && from_tmem))
 		{
-			pcfmt = TexDecoder_Decode(temp, src_data, expandedWidth,
-						expandedHeight, texformat, tlutaddr, tlutfmt, g_ActiveConfig.backend_info.bUseRGBATextures);
+			pcfmt = DecodeTexture(temp, src_data, expandedWidth,
+						expandedHeight, texformat, tlutaddr, tlutfmt);
 		}
 		else
 		{
@@ -487,7 +862,27 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	// create the entry/texture
 	if (NULL == entry)
 	{
-		textures[texID] = entry = g_texture_cache->CreateTexture(width, height, expandedWidth, texLevels, pcfmt);
+		entry = TakePooledEntry(width, height, texLevels, pcfmt);
+		if (entry)
+		{
+			if (decode_on_gpu)
+				entry->LoadFromGX(width, height, expandedWidth, expandedHeight, 0, src_data, data_hash, texformat, tlut, tlutfmt);
+			else
+				entry->Load(width, height, expandedWidth, 0);
+			INCSTAT(stats.numTexturesReused);
+		}
+		else
+		{
+			entry = g_texture_cache->CreateTexture(width, height, expandedWidth, texLevels, pcfmt);
+			entry->pool_width = width;
+			entry->pool_height = height;
+			entry->pool_levels = texLevels;
+			entry->pool_pcfmt = pcfmt;
+			entry->memory_size = EstimateTextureSize(width, height, texLevels, pcfmt);
+			texture_memory += entry->memory_size;
+			if (decode_on_gpu)
+				entry->LoadFromGX(width, height, expandedWidth, expandedHeight, 0, src_data, data_hash, texformat, tlut, tlutfmt);
+		}
 
 		// Sometimes, we can get around recreating a texture if only the number of mip levels changes
 		// e.g. if our texture cache entry got too many mipmap levels we can limit the number of used levels by setting the appropriate render states
@@ -501,6 +896,10 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 
 		GFX_DEBUGGER_PAUSE_AT(NEXT_NEW_TEXTURE, true);
 	}
+	else if (decode_on_gpu)
+	{
+		entry->LoadFromGX(width, height, expandedWidth, expandedHeight, 0, src_data, data_hash, texformat, tlut, tlutfmt);
+	}
 	else
 	{
 		// load texture (CreateTexture also loads level 0)
@@ -508,8 +907,13 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	}
 
 	entry->SetGeneralParameters(address, texture_size, full_format, entry->num_mipmaps);
+	IndexEntry(texID, entry);
 	entry->SetDimensions(nativeW, nativeH, width, height);
 	entry->hash = tex_hash;
+	entry->data_hash = data_hash;
+	entry->fingerprint = fingerprint;
+	entry->hash_epoch = hash_epoch;
+	entry->custom_pending = custom_pending;
 
 	if (entry->IsEfbCopy() && !g_ActiveConfig.bCopyEFBToTexture)
 		entry->type = TCET_EC_DYNAMIC;
@@ -545,11 +949,18 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				const u8*& mip_src_data = from_tmem
 					? ((level % 2) ? ptr_odd : ptr_even)
 					: src_data;
-				TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlutaddr, tlutfmt, g_ActiveConfig.backend_info.bUseRGBATextures);
+				if (decode_on_gpu)
+				{
+					entry->LoadFromGX(mip_width, mip_height, expanded_mip_width, expanded_mip_height, level,
+						mip_src_data, TEXHASH_INVALID, texformat, tlut, tlutfmt);
+				}
+				else
+				{
+					DecodeTexture(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlutaddr, tlutfmt);
+					entry->Load(mip_width, mip_height, expanded_mip_width, level);
+				}
 				mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
 
-				entry->Load(mip_width, mip_height, expanded_mip_width, level);
-
 				if (g_ActiveConfig.bDumpTextures)
 					DumpTexture(entry, level);
 			}
@@ -569,6 +980,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 
 	INCSTAT(stats.numTexturesCreated);
 	SETSTAT(stats.numTexturesAlive, textures.size());
+	UpdateMemoryStats();
 
 	return ReturnEntry(stage, entry);
 }
@@ -855,7 +1267,8 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	unsigned int scaled_tex_h = g_ActiveConfig.bCopyEFBScaled ? Renderer::EFBToScaledY(tex_h) : tex_h;
 
 
-	TCacheEntryBase *entry = textures[dstAddr];
+	TexCache::iterator iter = textures.find(dstAddr);
+	TCacheEntryBase *entry = (iter != textures.end()) ? iter->second : NULL;
 	if (entry)
 	{
 		if (entry->type == TCET_EC_DYNAMIC && entry->native_width == tex_w && entry->native_height == tex_h)
@@ -866,7 +1279,7 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 		else if (!(entry->type == TCET_EC_VRAM && entry->virtual_width == scaled_tex_w && entry->virtual_height == scaled_tex_h))
 		{
 			// remove it and recreate it as a render target
-			delete entry;
+			DeleteEntry(entry);
 			entry = NULL;
 		}
 	}
@@ -874,10 +1287,14 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	if (NULL == entry)
 	{
 		// create the texture
-		textures[dstAddr] = entry = g_texture_cache->CreateRenderTargetTexture(scaled_tex_w, scaled_tex_h);
+		entry = g_texture_cache->CreateRenderTargetTexture(scaled_tex_w, scaled_tex_h);
+		entry->memory_size = EstimateTextureSize(scaled_tex_w, scaled_tex_h, 1, PC_TEX_FMT_RGBA32);
+		texture_memory += entry->memory_size;
+		UpdateMemoryStats();
 
 		// TODO: Using the wrong dstFormat, dumb...
 		entry->SetGeneralParameters(dstAddr, 0, dstFormat, 1);
+		IndexEntry(dstAddr, entry);
 		entry->SetDimensions(tex_w, tex_h, scaled_tex_w, scaled_tex_h);
 		entry->SetHashes(TEXHASH_INVALID);
 		entry->type = TCET_EC_VRAM;
@@ -4,7 +4,8 @@
 
 #pragma once
 
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "VideoCommon.h"
 #include "TextureDecoder.h"
@@ -45,6 +46,30 @@ public:
 		// used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
 		int frameCount;
 
+		// guest memory pages this entry is registered in (see TextureCache::IndexEntry)
+		u32 tex_id;
+		u32 first_page, last_page;
+		bool indexed;
+
+		// RAM data hash (without the tlut) and a fingerprint of its first
+		// bytes, valid for Load() while hash_epoch is still current
+		u64 data_hash;
+		u64 fingerprint;
+		u32 hash_epoch;
+
+		// the native texture stands in for a custom texture that is still being decoded
+		bool custom_pending;
+
+		// what CreateTexture made the texture for, so it can be taken from the
+		// pool for another texture of the same kind. PC_TEX_FMT_NONE for render
+		// targets, which aren't pooled.
+		unsigned int pool_width, pool_height, pool_levels;
+		PC_TexFormat pool_pcfmt;
+
+		// video memory taken by the texture, estimated from the above
+		u64 memory_size;
+
+		TCacheEntryBase() : indexed(false), hash_epoch(0), custom_pending(false), pool_pcfmt(PC_TEX_FMT_NONE), memory_size(0) {}
 
 		void SetGeneralParameters(u32 _addr, u32 _size, u32 _format, unsigned int _num_mipmaps)
 		{
@@ -76,6 +101,13 @@ public:
 
 		virtual void Load(unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) = 0;
+		// Decodes the level from the raw GX data on the GPU instead of uploading temp,
+		// only called for the formats TextureCache::CanDecodeOnGPU accepted.
+		// src_hash identifies the data so it isn't uploaded again when only the TLUT
+		// changed, TEXHASH_INVALID if it isn't known.
+		virtual void LoadFromGX(unsigned int width, unsigned int height,
+			unsigned int expanded_width, unsigned int expanded_height, unsigned int level,
+			const u8* src, u64 src_hash, int texformat, const u8* tlut, int tlutfmt) {}
 		virtual void FromRenderTarget(u32 dstAddr, unsigned int dstFormat,
 			unsigned int srcFormat, const EFBRectangle& srcRect,
 			bool isIntensity, bool scaleByHalf, unsigned int cbufid,
@@ -97,6 +129,15 @@ public:
 	static void ClearRenderTargets();	// currently only used by OGL
 	static bool Find(u32 start_address, u64 hash);
 
+	// Makes sure that the EFB copies to RAM which overlap the range have
+	// arrived there, for the backends which read those back asynchronously
+	static void FlushEFBCopies(u32 start_address = 0, u32 size = 0xFFFFFFFF);
+	// Brings the cache up to date with an EFB copy whose data just arrived in RAM
+	static void EFBCopyArrived(u32 dstAddr, u32 size);
+	// Called at the points where the CPU or the GPU may have written texture
+	// memory, the textures used after that get fully hashed again
+	static void ExpireHashes() { ++hash_epoch; }
+
 	virtual TCacheEntryBase* CreateTexture(unsigned int width, unsigned int height,
 		unsigned int expanded_width, unsigned int tex_levels, PC_TexFormat pcfmt) = 0;
 	virtual TCacheEntryBase* CreateRenderTargetTexture(unsigned int scaled_tex_w, unsigned int scaled_tex_h) = 0;
@@ -111,6 +152,11 @@ public:
 protected:
 	TextureCache();
 
+	virtual void FlushPendingEFBCopies(u32 start_address, u32 size) {}
+
+	// Whether LoadFromGX can decode textures of the format, the decoded textures are RGBA32
+	virtual bool CanDecodeOnGPU(int texformat, int tlutfmt) const { return false; }
+
 	static  GC_ALIGNED16(u8 *temp);
 	static unsigned int temp_size;
 
@@ -119,9 +165,41 @@ private:
 	static PC_TexFormat LoadCustomTexture(u64 tex_hash, int texformat, unsigned int level, unsigned int& width, unsigned int& height);
 	static void DumpTexture(TCacheEntryBase* entry, unsigned int level);
 
-	typedef std::map<u32, TCacheEntryBase*> TexCache;
+	// Entries are looked up by texID, and additionally bucketed by the guest
+	// memory pages they cover so that range operations (EFB copies, memory
+	// writes) only have to visit the entries which might intersect the range.
+	typedef std::unordered_map<u32, TCacheEntryBase*> TexCache;
+	typedef std::unordered_map<u32, std::vector<TCacheEntryBase*>> TexPageIndex;
+
+	enum
+	{
+		TEXCACHE_PAGE_SHIFT = 12,
+		TEXCACHE_POOL_SIZE = 64, // deleted entries kept around for reuse
+	};
+
+	static void IndexEntry(u32 texID, TCacheEntryBase* entry);
+	static void UnindexEntry(TCacheEntryBase* entry);
+	static void DeleteEntry(TCacheEntryBase* entry);
+	static TCacheEntryBase* TakePooledEntry(unsigned int width, unsigned int height,
+		unsigned int tex_levels, PC_TexFormat pcfmt);
+	static void ClearPool();
+	static void FreeEntry(TCacheEntryBase* entry);
+	static void EvictToBudget(u64 budget);
+	static void UpdateMemoryStats();
+	static void GetEntriesInRange(u32 start_address, u32 size, std::vector<TCacheEntryBase*>& result);
 
 	static TexCache textures;
+	static TexPageIndex texture_pages;
+	// Entries which were deleted but whose textures can still be loaded with
+	// new data, the most recently deleted last
+	static std::vector<TCacheEntryBase*> texture_pool;
+	// Estimated video memory of the textures of the entries in the cache and
+	// in the pool, kept under the configured budget by Cleanup
+	static u64 texture_memory;
+	static u64 pool_memory;
+	// Reused by the range operations, which run on every EFB copy
+	static std::vector<TCacheEntryBase*> range_entries;
+	static u32 hash_epoch;
 
 	// Backup configuration values
 	static struct BackupConfig
@@ -134,7 +212,9 @@ private:
 		bool s_texfmt_overlay;
 		bool s_texfmt_overlay_center;
 		bool s_hires_textures;
+		bool s_cache_hires_textures;
 		bool s_copy_cache_enable;
+		bool s_gpu_texture_decoding;
 	} backup_config;
 };
 
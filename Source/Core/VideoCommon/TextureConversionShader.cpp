@@ -698,4 +698,125 @@ const char *GenerateEncodingShader(u32 format,API_TYPE ApiType)
 	return text;
 }
 
+bool IsDecodingSupported(u32 format, u32 tlutfmt)
+{
+	switch (format)
+	{
+	case GX_TF_C4:
+	case GX_TF_C8:
+	case GX_TF_C14X2:
+		return tlutfmt <= GX_TL_RGB5A3;
+	case GX_TF_CMPR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void WriteTLUTDecoder(char*& p, u32 tlutfmt)
+{
+	WRITE(p, "int4 DecodeTLUT(int index)\n{\n");
+	WRITE(p, "  uvec4 entry = texelFetch(samp8, int2(index & 255, index >> 8), 0);\n");
+	WRITE(p, "  int value = (int(entry.r) << 8) | int(entry.g);\n");
+	switch (tlutfmt)
+	{
+	case GX_TL_IA8:
+		WRITE(p, "  return int4(value & 0xFF, value & 0xFF, value & 0xFF, value >> 8);\n");
+		break;
+	case GX_TL_RGB565:
+		WRITE(p, "  return int4(Convert5To8((value >> 11) & 0x1F), Convert6To8((value >> 5) & 0x3F), Convert5To8(value & 0x1F), 255);\n");
+		break;
+	case GX_TL_RGB5A3:
+		WRITE(p, "  if ((value & 0x8000) != 0)\n");
+		WRITE(p, "    return int4(Convert5To8((value >> 10) & 0x1F), Convert5To8((value >> 5) & 0x1F), Convert5To8(value & 0x1F), 255);\n");
+		WRITE(p, "  return int4(Convert4To8((value >> 8) & 0xF), Convert4To8((value >> 4) & 0xF), Convert4To8(value & 0xF), Convert3To8((value >> 12) & 0x7));\n");
+		break;
+	}
+	WRITE(p, "}\n");
+}
+
+const char *GenerateDecodingShader(u32 format, u32 tlutfmt, API_TYPE ApiType)
+{
+	// Needs integer textures
+	if (ApiType != API_OPENGL || !IsDecodingSupported(format, tlutfmt))
+		return NULL;
+
+	text[sizeof(text) - 1] = 0x7C;  // canary
+
+	char *p = text;
+	const bool is_paletted = format != GX_TF_CMPR;
+
+	WRITE(p, "uniform usampler2D samp9;\n");
+	if (is_paletted)
+		WRITE(p, "uniform usampler2D samp8;\n");
+	WRITE(p, "out vec4 ocol0;\n");
+
+	WRITE(p, "int Convert3To8(int v) { return (v << 5) | (v << 2) | (v >> 1); }\n"
+		"int Convert4To8(int v) { return (v << 4) | v; }\n"
+		"int Convert5To8(int v) { return (v << 3) | (v >> 2); }\n"
+		"int Convert6To8(int v) { return (v << 2) | (v >> 4); }\n");
+
+	// All of the supported formats have 32 byte blocks
+	WRITE(p, "int ReadByte(int2 block, int offset)\n{\n"
+		"  return int(texelFetch(samp9, int2(block.x * 32 + offset, block.y), 0).r);\n"
+		"}\n");
+	WRITE(p, "int ReadU16(int2 block, int offset)\n{\n"
+		"  return (ReadByte(block, offset) << 8) | ReadByte(block, offset + 1);\n"
+		"}\n");
+
+	if (is_paletted)
+		WriteTLUTDecoder(p, tlutfmt);
+
+	const int blkW = TexDecoder_GetBlockWidthInTexels(format);
+	const int blkH = TexDecoder_GetBlockHeightInTexels(format);
+	WRITE(p, "void main()\n{\n");
+	WRITE(p, "  int2 uv = int2(gl_FragCoord.xy);\n");
+	WRITE(p, "  int2 block = uv / int2(%d, %d);\n", blkW, blkH);
+	WRITE(p, "  int2 texel = uv - block * int2(%d, %d);\n", blkW, blkH);
+	WRITE(p, "  int4 color;\n");
+
+	switch (format)
+	{
+	case GX_TF_C4:
+		WRITE(p, "  int value = ReadByte(block, texel.y * 4 + texel.x / 2);\n");
+		WRITE(p, "  color = DecodeTLUT((texel.x & 1) == 0 ? value >> 4 : value & 0xF);\n");
+		break;
+	case GX_TF_C8:
+		WRITE(p, "  color = DecodeTLUT(ReadByte(block, texel.y * 8 + texel.x));\n");
+		break;
+	case GX_TF_C14X2:
+		WRITE(p, "  color = DecodeTLUT(ReadU16(block, texel.y * 8 + texel.x * 2) & 0x3FFF);\n");
+		break;
+	case GX_TF_CMPR:
+		// Four DXT1 like sub-blocks, with the GC's interpolation
+		WRITE(p, "  int2 sub = texel / 4;\n");
+		WRITE(p, "  int base = (sub.y * 2 + sub.x) * 8;\n");
+		WRITE(p, "  int c1 = ReadU16(block, base);\n");
+		WRITE(p, "  int c2 = ReadU16(block, base + 2);\n");
+		WRITE(p, "  int lines = ReadByte(block, base + 4 + (texel.y & 3));\n");
+		WRITE(p, "  int sel = (lines >> (6 - 2 * (texel.x & 3))) & 3;\n");
+		WRITE(p, "  int3 color1 = int3(Convert5To8((c1 >> 11) & 0x1F), Convert6To8((c1 >> 5) & 0x3F), Convert5To8(c1 & 0x1F));\n");
+		WRITE(p, "  int3 color2 = int3(Convert5To8((c2 >> 11) & 0x1F), Convert6To8((c2 >> 5) & 0x3F), Convert5To8(c2 & 0x1F));\n");
+		WRITE(p, "  if (sel == 0)\n");
+		WRITE(p, "    color = int4(color1, 255);\n");
+		WRITE(p, "  else if (sel == 1)\n");
+		WRITE(p, "    color = int4(color2, 255);\n");
+		WRITE(p, "  else if (c1 > c2)\n  {\n");
+		WRITE(p, "    int3 diff = ((color2 - color1) >> 1) - ((color2 - color1) >> 3);\n");
+		WRITE(p, "    color = (sel == 2) ? int4(color1 + diff, 255) : int4(color2 - diff, 255);\n");
+		WRITE(p, "  }\n");
+		WRITE(p, "  else\n");
+		WRITE(p, "    color = (sel == 2) ? int4((color1 + color2 + 1) / 2, 255) : int4(color2, 0);\n");
+		break;
+	}
+
+	WRITE(p, "  ocol0 = float4(color) / 255.0;\n");
+	WRITE(p, "}\n");
+
+	if (text[sizeof(text) - 1] != 0x7C)
+		PanicAlert("TextureConversionShader generator - buffer too small, canary has been eaten!");
+
+	return text;
+}
+
 }  // namespace
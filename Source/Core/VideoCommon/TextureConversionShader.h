@@ -14,4 +14,12 @@ u16 GetEncodedSampleCount(u32 format);
 
 const char *GenerateEncodingShader(u32 format, API_TYPE ApiType = API_OPENGL);
 
+// Whether GenerateDecodingShader can decode textures of the format
+bool IsDecodingSupported(u32 format, u32 tlutfmt);
+
+// Decodes the raw texture data, uploaded with one row of blocks per line to samp9,
+// to RGBA. The TLUT of paletted textures is looked up in samp8, 256 entries per line.
+// Returns NULL if the format or the API isn't supported.
+const char *GenerateDecodingShader(u32 format, u32 tlutfmt, API_TYPE ApiType = API_OPENGL);
+
 }
@@ -52,6 +52,13 @@ enum TextureFormat
 	GX_CTF_Z16L  = 0xC | _GX_TF_ZTF | _GX_TF_CTF,
 };
 
+enum TlutFormat
+{
+	GX_TL_IA8    = 0x0,
+	GX_TL_RGB565 = 0x1,
+	GX_TL_RGB5A3 = 0x2,
+};
+
 int TexDecoder_GetTexelSizeInNibbles(int format);
 int TexDecoder_GetTextureSizeInBytes(int width, int height, int format);
 int TexDecoder_GetBlockWidthInTexels(u32 format);
@@ -432,27 +432,88 @@ inline void decodebytesC14X2rgb565_To_RGBA(u32* dst, const u16* src, int tlutadd
 	}
 }
 
-// Needs more speed.
+static const __m128i kMask_x0f8 = _mm_set1_epi32(0x0f0f0f0fL);
+
+// Splits 8 IA4 texels into their intensity and alpha bytes, expanded to 8 bits
+// each by Convert4To8(). 16-bit shifts are fine here since the masked nibbles
+// never carry over into the neighbouring byte.
+inline void decodeIA4x8(const u8 *src, __m128i &l8, __m128i &a8)
+{
+	const __m128i val = _mm_loadl_epi64((const __m128i *)src);
+	const __m128i l = _mm_and_si128(val, kMask_x0f8);
+	const __m128i a = _mm_andnot_si128(kMask_x0f8, val);
+	l8 = _mm_or_si128(l, _mm_slli_epi16(l, 4));
+	a8 = _mm_or_si128(a, _mm_srli_epi16(a, 4));
+}
+
 inline void decodebytesIA4(u16 *dst, const u8 *src)
 {
+	__m128i l8, a8;
+	decodeIA4x8(src, l8, a8);
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(l8, a8));
+
+#ifdef CHECK
 	for (int x = 0; x < 8; x++)
 	{
 		const u8 val = src[x];
 		u8 a = Convert4To8(val >> 4);
 		u8 l = Convert4To8(val & 0xF);
-		dst[x] = (a << 8) | l;
+		assert(dst[x] == ((a << 8) | l));
 	}
+#endif
 }
 
 inline void decodebytesIA4RGBA(u32 *dst, const u8 *src)
 {
+	__m128i l8, a8;
+	decodeIA4x8(src, l8, a8);
+	const __m128i ll = _mm_unpacklo_epi8(l8, l8);
+	const __m128i la = _mm_unpacklo_epi8(l8, a8);
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(ll, la));
+	_mm_storeu_si128((__m128i *)dst + 1, _mm_unpackhi_epi16(ll, la));
+
+#ifdef CHECK
 	for (int x = 0; x < 8; x++)
 	{
 		const u8 val = src[x];
 		u8 a = Convert4To8(val >> 4);
 		u8 l = Convert4To8(val & 0xF);
-		dst[x] = (a << 24) | l << 16 | l << 8 | l;
+		assert(dst[x] == ((a << 24) | l << 16 | l << 8 | l));
 	}
+#endif
+}
+
+// Expands a row of 8 I4 texels (4 bytes) to I8.
+inline void decodebytesI4_To_I8(u8 *dst, const u8 *src)
+{
+	const __m128i val = _mm_cvtsi32_si128(*(const s32 *)src);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(val, 4), kMask_x0f8);
+	const __m128i lo = _mm_and_si128(val, kMask_x0f8);
+	const __m128i i4 = _mm_unpacklo_epi8(hi, lo);
+	_mm_storel_epi64((__m128i *)dst, _mm_or_si128(i4, _mm_slli_epi16(i4, 4)));
+
+#ifdef CHECK
+	for (int ix = 0; ix < 4; ix++)
+	{
+		assert(dst[ix * 2] == Convert4To8(src[ix] >> 4));
+		assert(dst[ix * 2 + 1] == Convert4To8(src[ix] & 0xF));
+	}
+#endif
+}
+
+// Applies Common::swap16() to 4 texels, used for IA8 and RGB565.
+inline void decodebytesSwap16_4(u16 *dst, const u8 *src)
+{
+	const __m128i val = _mm_loadl_epi64((const __m128i *)src);
+	_mm_storel_epi64((__m128i *)dst, _mm_or_si128(_mm_slli_epi16(val, 8), _mm_srli_epi16(val, 8)));
+}
+
+// SSE2 replacement for the pshufb in the SSSE3 RGBA8 path: Common::swap32()
+// on all four 32-bit lanes.
+inline __m128i swap32_SSE2(__m128i val)
+{
+	const __m128i swapped16 = _mm_or_si128(_mm_slli_epi16(val, 8), _mm_srli_epi16(val, 8));
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(swapped16, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
 }
 
 inline void decodebytesRGB5A3(u32 *dst, const u16 *src)
@@ -730,12 +791,7 @@ PC_TexFormat TexDecoder_Decode_real(u8 *dst, const u8 *src, int width, int heigh
 			for (int y = 0; y < height; y += 8)
 				for (int x = 0, yStep = (y / 8) * Wsteps8; x < width; x += 8, yStep++)
 					for (int iy = 0, xStep = yStep * 8 ; iy < 8; iy++,xStep++)
-						for (int ix = 0; ix < 4; ix++)
-						{
-							int val = src[4 * xStep + ix];
-							dst[(y + iy) * width + x + ix * 2] = Convert4To8(val >> 4);
-							dst[(y + iy) * width + x + ix * 2 + 1] = Convert4To8(val & 0xF);
-						}
+						decodebytesI4_To_I8(dst + (y + iy) * width + x, src + 4 * xStep);
 		}
 	   return PC_TEX_FMT_I4_AS_I8;
 	case GX_TF_I8:  // speed critical
@@ -796,13 +852,7 @@ PC_TexFormat TexDecoder_Decode_real(u8 *dst, const u8 *src, int width, int heigh
 			for (int y = 0; y < height; y += 4)
 				for (int x = 0, yStep = (y / 4) * Wsteps4; x < width; x += 4, yStep++)
 					for (int iy = 0, xStep = yStep * 4; iy < 4; iy++, xStep++)
-					{
-						u16 *ptr = (u16 *)dst + (y + iy) * width + x;
-						u16 *s = (u16 *)(src + 8 * xStep);
-						for(int j = 0; j < 4; j++)
-							*ptr++ = Common::swap16(*s++);
-					}
-
+						decodebytesSwap16_4((u16 *)dst + (y + iy) * width + x, src + 8 * xStep);
 		}
 		return PC_TEX_FMT_IA8;
 	case GX_TF_C14X2:
@@ -830,12 +880,7 @@ PC_TexFormat TexDecoder_Decode_real(u8 *dst, const u8 *src, int width, int heigh
 			for (int y = 0; y < height; y += 4)
 				for (int x = 0, yStep = (y / 4) * Wsteps4; x < width; x += 4, yStep++)
 					for (int iy = 0, xStep = 4 * yStep; iy < 4; iy++, xStep++)
-					{
-						u16 *ptr = (u16 *)dst + (y + iy) * width + x;
-						u16 *s = (u16 *)(src + 8 * xStep);
-						for(int j = 0; j < 4; j++)
-							*ptr++ = Common::swap16(*s++);
-					}
+						decodebytesSwap16_4((u16 *)dst + (y + iy) * width + x, src + 8 * xStep);
 		}
 		return PC_TEX_FMT_RGB565;
 	case GX_TF_RGB5A3:
@@ -896,14 +941,31 @@ PC_TexFormat TexDecoder_Decode_real(u8 *dst, const u8 *src, int width, int heigh
 #endif
 
 			{
+				// Same as above, with the byte swap done in SSE2.
 				#pragma omp parallel for
-				for (int y = 0; y < height; y += 4)
-					for (int x = 0, yStep = (y / 4) * Wsteps4; x < width; x += 4, yStep++)
-					{
-						const u8* src2 = src + 64 * yStep;
+				for (int y = 0; y < height; y += 4) {
+					__m128i* p = (__m128i*)(src + y * width * 4);
+					for (int x = 0; x < width; x += 4) {
+						const __m128i a0 = _mm_loadu_si128(p++);
+						const __m128i a1 = _mm_loadu_si128(p++);
+						const __m128i a2 = _mm_loadu_si128(p++);
+						const __m128i a3 = _mm_loadu_si128(p++);
+
+						_mm_storeu_si128((__m128i*)((u32*)dst + (y + 0) * width + x), swap32_SSE2(_mm_unpacklo_epi16(a0, a2)));
+						_mm_storeu_si128((__m128i*)((u32*)dst + (y + 1) * width + x), swap32_SSE2(_mm_unpackhi_epi16(a0, a2)));
+						_mm_storeu_si128((__m128i*)((u32*)dst + (y + 2) * width + x), swap32_SSE2(_mm_unpacklo_epi16(a1, a3)));
+						_mm_storeu_si128((__m128i*)((u32*)dst + (y + 3) * width + x), swap32_SSE2(_mm_unpackhi_epi16(a1, a3)));
+#ifdef CHECK
+						const u8* src2 = (const u8*)(p - 4);
 						for (int iy = 0; iy < 4; iy++)
-							decodebytesARGB8_4((u32*)dst + (y+iy)*width + x, (u16*)src2 + 4 * iy, (u16*)src2 + 4 * iy + 16);
+						{
+							u32 tmp[4];
+							decodebytesARGB8_4(tmp, (u16*)src2 + 4 * iy, (u16*)src2 + 4 * iy + 16);
+							assert(memcmp(tmp, (u32*)dst + (y + iy) * width + x, 16) == 0);
+						}
+#endif
 					}
+				}
 			}
 		}
 		return PC_TEX_FMT_BGRA32;
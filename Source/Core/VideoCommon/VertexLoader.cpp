@@ -5,10 +5,14 @@
 #include "Common.h"
 #include "VideoCommon.h"
 #include "VideoConfig.h"
+#include "JitRegister.h"
 #include "MemoryUtil.h"
 #include "StringUtil.h"
 #include "x64Emitter.h"
 #include "x64ABI.h"
+#ifdef _M_ARM
+#include "ArmEmitter.h"
+#endif
 #include "PixelEngine.h"
 #include "Host.h"
 
@@ -32,6 +36,10 @@
 #ifndef __APPLE__
 #define USE_JIT
 #endif
+#elif defined(_M_ARM)
+// The compiled loop only calls the same pipeline functions, so the
+// emitter doesn't need NEON or VFP.
+#define USE_JIT
 #endif
 
 #define COMPILED_CODE_SIZE 4096
@@ -76,6 +84,8 @@ static u8 s_bbox_currPoint;
 static u8 s_bbox_loadedPoints;
 static const u8 s_bbox_primitivePoints[8] = { 3, 0, 3, 3, 3, 2, 2, 1 };
 
+static const int colorElementSizes[8] = { 2, 3, 4, 2, 3, 4, 0, 0 };
+
 static const float fractionTable[32] = {
 	1.0f / (1U << 0), 1.0f / (1U << 1), 1.0f / (1U << 2), 1.0f / (1U << 3),
 	1.0f / (1U << 4), 1.0f / (1U << 5), 1.0f / (1U << 6), 1.0f / (1U << 7),
@@ -87,7 +97,11 @@ static const float fractionTable[32] = {
 	1.0f / (1U << 28), 1.0f / (1U << 29), 1.0f / (1U << 30), 1.0f / (1U << 31),
 };
 
+#ifdef _M_ARM
+using namespace ArmGen;
+#else
 using namespace Gen;
+#endif
 
 void LOADERDECL PosMtx_ReadDirect_UByte()
 {
@@ -473,6 +487,9 @@ VertexLoader::VertexLoader(const TVtxDesc &vtx_desc, const VAT &vtx_attr)
 	m_numLoadedVertices = 0;
 	m_VertexSize = 0;
 	m_numPipelineStages = 0;
+	m_numBatchStages = 0;
+	m_batchable = false;
+	m_numIndexedAttributes = 0;
 	m_NativeFmt = 0;
 	loop_counter = 0;
 	VertexLoader_Normal::Init();
@@ -485,6 +502,11 @@ VertexLoader::VertexLoader(const TVtxDesc &vtx_desc, const VAT &vtx_attr)
 	#ifdef USE_JIT
 	AllocCodeSpace(COMPILED_CODE_SIZE);
 	CompileVertexTranslator();
+#ifdef _M_ARM
+	FlushIcache();
+#endif
+	JitRegister::Register(m_compiledCode, GetCodePtr() - m_compiledCode, "JIT_VertexLoader_%08x%08x_%08x_%08x_%08x",
+		m_VtxDesc.Hex1, m_VtxDesc.Hex0, vtx_attr.g0.Hex, vtx_attr.g1.Hex, vtx_attr.g2.Hex);
 	WriteProtect();
 	#else
 	CompileVertexTranslator();
@@ -510,7 +532,14 @@ void VertexLoader::CompileVertexTranslator()
 		PanicAlert("Trying to recompile a vertex translator");
 
 	m_compiledCode = GetCodePtr();
+#ifdef _M_ARM
+	// R4 counts the vertices, the pipeline functions preserve it.
+	PUSH(2, R4, _LR);
+	MOVI2R(R0, (u32)&loop_counter);
+	LDR(R4, R0);
+#else
 	ABI_PushAllCalleeSavedRegsAndAdjustStack();
+#endif
 
 	// Start loop here
 	const u8 *loop_start = GetCodePtr();
@@ -519,17 +548,17 @@ void VertexLoader::CompileVertexTranslator()
 	if (m_VtxDesc.Tex0Coord || m_VtxDesc.Tex1Coord || m_VtxDesc.Tex2Coord || m_VtxDesc.Tex3Coord ||
 		m_VtxDesc.Tex4Coord || m_VtxDesc.Tex5Coord || m_VtxDesc.Tex6Coord || m_VtxDesc.Tex7Coord)
 	{
-		WriteSetVariable(32, &tcIndex, Imm32(0));
+		WriteResetVariable(&tcIndex);
 	}
 	if (m_VtxDesc.Color0 || m_VtxDesc.Color1)
 	{
-		WriteSetVariable(32, &colIndex, Imm32(0));
+		WriteResetVariable(&colIndex);
 	}
 	if (m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
 		m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx)
 	{
-		WriteSetVariable(32, &s_texmtxwrite, Imm32(0));
-		WriteSetVariable(32, &s_texmtxread, Imm32(0));
+		WriteResetVariable(&s_texmtxwrite);
+		WriteResetVariable(&s_texmtxread);
 	}
 #endif
 
@@ -546,6 +575,14 @@ void VertexLoader::CompileVertexTranslator()
 
 	// Reset pipeline
 	m_numPipelineStages = 0;
+	m_numBatchStages = 0;
+	m_numIndexedAttributes = 0;
+
+	// The attributes can be converted one at a time for all vertices, unless
+	// a stage depends on state left by another one of the same vertex.
+	m_batchable = !g_ActiveConfig.CPUBBoxEnabled() && !m_VtxDesc.PosMatIdx &&
+		!(m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
+		m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx);
 	u32 components = 0;
 
 	// Position in pc vertex format.
@@ -571,7 +608,7 @@ void VertexLoader::CompileVertexTranslator()
 	if (m_VtxDesc.Tex7MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX7; WriteCall(TexMtx_ReadDirect_UByte); }
 
 	// Write vertex position loader
-	if(g_ActiveConfig.bUseBBox)
+	if (g_ActiveConfig.CPUBBoxEnabled())
 	{
 		WriteCall(UpdateBoundingBoxPrepare);
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
@@ -580,7 +617,12 @@ void VertexLoader::CompileVertexTranslator()
 	else
 	{
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
+		AddBatchStage(VertexLoader_Position::GetBatchFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements),
+			VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements),
+			m_VertexSize, 0, ARRAY_POSITION, 0, &posScale);
 	}
+	AddIndexedAttribute(m_VtxDesc.Position, m_VertexSize, 1, ARRAY_POSITION,
+		VertexLoader_Position::GetSize(DIRECT, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
 	m_VertexSize += VertexLoader_Position::GetSize(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements);
 	nat_offset += 12;
 	vtx_decl.position.components = 3;
@@ -592,6 +634,7 @@ void VertexLoader::CompileVertexTranslator()
 	// Normals
 	if (m_VtxDesc.Normal != NOT_PRESENT)
 	{
+		const int src_offset = m_VertexSize;
 		m_VertexSize += VertexLoader_Normal::GetSize(m_VtxDesc.Normal,
 			m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3);
 
@@ -606,6 +649,11 @@ void VertexLoader::CompileVertexTranslator()
 				m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3).c_str());
 		}
 		WriteCall(pFunc);
+		AddBatchStage(VertexLoader_Normal::GetBatchFunction(m_VtxDesc.Normal,
+			m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3),
+			pFunc, src_offset, nat_offset, ARRAY_NORMAL, 0, NULL);
+		AddIndexedAttribute(m_VtxDesc.Normal, src_offset, (m_VtxAttr.NormalIndex3 && m_VtxAttr.NormalElements) ? 3 : 1,
+			ARRAY_NORMAL, VertexLoader_Normal::GetSize(DIRECT, m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, 0));
 
 		for (int i = 0; i < (vtx_attr.NormalElements ? 3 : 1); i++)
 		{
@@ -629,6 +677,8 @@ void VertexLoader::CompileVertexTranslator()
 		vtx_decl.colors[i].components = 4;
 		vtx_decl.colors[i].type = VAR_UNSIGNED_BYTE;
 		vtx_decl.colors[i].integer = false;
+		const int src_offset = m_VertexSize;
+		TPipelineFunction pFunc = NULL;
 		switch (col[i])
 		{
 		case NOT_PRESENT:
@@ -636,12 +686,12 @@ void VertexLoader::CompileVertexTranslator()
 		case DIRECT:
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:	m_VertexSize += 2; WriteCall(Color_ReadDirect_16b_565); break;
-			case FORMAT_24B_888:	m_VertexSize += 3; WriteCall(Color_ReadDirect_24b_888); break;
-			case FORMAT_32B_888x:	m_VertexSize += 4; WriteCall(Color_ReadDirect_32b_888x); break;
-			case FORMAT_16B_4444:	m_VertexSize += 2; WriteCall(Color_ReadDirect_16b_4444); break;
-			case FORMAT_24B_6666:	m_VertexSize += 3; WriteCall(Color_ReadDirect_24b_6666); break;
-			case FORMAT_32B_8888:	m_VertexSize += 4; WriteCall(Color_ReadDirect_32b_8888); break;
+			case FORMAT_16B_565:	m_VertexSize += 2; pFunc = Color_ReadDirect_16b_565; break;
+			case FORMAT_24B_888:	m_VertexSize += 3; pFunc = Color_ReadDirect_24b_888; break;
+			case FORMAT_32B_888x:	m_VertexSize += 4; pFunc = Color_ReadDirect_32b_888x; break;
+			case FORMAT_16B_4444:	m_VertexSize += 2; pFunc = Color_ReadDirect_16b_4444; break;
+			case FORMAT_24B_6666:	m_VertexSize += 3; pFunc = Color_ReadDirect_24b_6666; break;
+			case FORMAT_32B_8888:	m_VertexSize += 4; pFunc = Color_ReadDirect_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
@@ -649,12 +699,12 @@ void VertexLoader::CompileVertexTranslator()
 			m_VertexSize += 1;
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:	WriteCall(Color_ReadIndex8_16b_565); break;
-			case FORMAT_24B_888:	WriteCall(Color_ReadIndex8_24b_888); break;
-			case FORMAT_32B_888x:	WriteCall(Color_ReadIndex8_32b_888x); break;
-			case FORMAT_16B_4444:	WriteCall(Color_ReadIndex8_16b_4444); break;
-			case FORMAT_24B_6666:	WriteCall(Color_ReadIndex8_24b_6666); break;
-			case FORMAT_32B_8888:	WriteCall(Color_ReadIndex8_32b_8888); break;
+			case FORMAT_16B_565:	pFunc = Color_ReadIndex8_16b_565; break;
+			case FORMAT_24B_888:	pFunc = Color_ReadIndex8_24b_888; break;
+			case FORMAT_32B_888x:	pFunc = Color_ReadIndex8_32b_888x; break;
+			case FORMAT_16B_4444:	pFunc = Color_ReadIndex8_16b_4444; break;
+			case FORMAT_24B_6666:	pFunc = Color_ReadIndex8_24b_6666; break;
+			case FORMAT_32B_8888:	pFunc = Color_ReadIndex8_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
@@ -662,12 +712,12 @@ void VertexLoader::CompileVertexTranslator()
 			m_VertexSize += 2;
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:	WriteCall(Color_ReadIndex16_16b_565); break;
-			case FORMAT_24B_888:	WriteCall(Color_ReadIndex16_24b_888); break;
-			case FORMAT_32B_888x:	WriteCall(Color_ReadIndex16_32b_888x); break;
-			case FORMAT_16B_4444:	WriteCall(Color_ReadIndex16_16b_4444); break;
-			case FORMAT_24B_6666:	WriteCall(Color_ReadIndex16_24b_6666); break;
-			case FORMAT_32B_8888:	WriteCall(Color_ReadIndex16_32b_8888); break;
+			case FORMAT_16B_565:	pFunc = Color_ReadIndex16_16b_565; break;
+			case FORMAT_24B_888:	pFunc = Color_ReadIndex16_24b_888; break;
+			case FORMAT_32B_888x:	pFunc = Color_ReadIndex16_32b_888x; break;
+			case FORMAT_16B_4444:	pFunc = Color_ReadIndex16_16b_4444; break;
+			case FORMAT_24B_6666:	pFunc = Color_ReadIndex16_24b_6666; break;
+			case FORMAT_32B_8888:	pFunc = Color_ReadIndex16_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
@@ -675,6 +725,12 @@ void VertexLoader::CompileVertexTranslator()
 		// Common for the three bottom cases
 		if (col[i] != NOT_PRESENT)
 		{
+			if (pFunc)
+			{
+				WriteCall(pFunc);
+				AddBatchStage(NULL, pFunc, src_offset, nat_offset, ARRAY_COLOR + i, i, NULL);
+				AddIndexedAttribute(col[i], src_offset, 1, ARRAY_COLOR + i, colorElementSizes[m_VtxAttr.color[i].Comp]);
+			}
 			components |= VB_HAS_COL0 << i;
 			vtx_decl.colors[i].offset = nat_offset;
 			vtx_decl.colors[i].enable = true;
@@ -704,6 +760,11 @@ void VertexLoader::CompileVertexTranslator()
 
 			components |= VB_HAS_UV0 << i;
 			WriteCall(VertexLoader_TextCoord::GetFunction(tc[i], format, elements));
+			AddBatchStage(VertexLoader_TextCoord::GetBatchFunction(tc[i], format, elements),
+				VertexLoader_TextCoord::GetFunction(tc[i], format, elements),
+				m_VertexSize, nat_offset, ARRAY_TEXCOORD0 + i, i, &tcScale[i]);
+			AddIndexedAttribute(tc[i], m_VertexSize, 1, ARRAY_TEXCOORD0 + i,
+				VertexLoader_TextCoord::GetSize(DIRECT, format, elements));
 			m_VertexSize += VertexLoader_TextCoord::GetSize(tc[i], format, elements);
 		}
 
@@ -770,8 +831,21 @@ void VertexLoader::CompileVertexTranslator()
 	native_stride = nat_offset;
 	vtx_decl.stride = native_stride;
 
+	// Only worth it if at least one attribute has a batched converter
+	bool has_batch_function = false;
+	for (int i = 0; i < m_numBatchStages; i++)
+		has_batch_function |= m_BatchStages[i].batch != NULL;
+	if (!has_batch_function)
+		m_numBatchStages = 0;
+
 #ifdef USE_JIT
 	// End loop here
+#if defined(_M_ARM)
+	SUBS(R4, R4, 1);
+	B_CC(CC_NEQ, loop_start);
+	POP(2, R4, _PC);
+	FlushLitPool();
+#else
 #ifdef _M_X64
 	MOV(64, R(RAX), Imm64((u64)&loop_counter));
 	SUB(32, MatR(RAX), Imm8(1));
@@ -782,6 +856,7 @@ void VertexLoader::CompileVertexTranslator()
 	J_CC(CC_NZ, loop_start, true);
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
+#endif
 #endif
 	m_NativeFmt = g_vertex_manager->CreateNativeVertexFormat();
 	m_NativeFmt->m_components = components;
@@ -791,7 +866,9 @@ void VertexLoader::CompileVertexTranslator()
 void VertexLoader::WriteCall(TPipelineFunction func)
 {
 #ifdef USE_JIT
-#ifdef _M_X64
+#if defined(_M_ARM)
+	QuickCallFunction(_IP, (void*)func);
+#elif defined(_M_X64)
 	MOV(64, R(RAX), Imm64((u64)func));
 	CALLptr(R(RAX));
 #else
@@ -801,6 +878,60 @@ void VertexLoader::WriteCall(TPipelineFunction func)
 	m_PipelineStages[m_numPipelineStages++] = func;
 #endif
 }
+void VertexLoader::AddBatchStage(TBatchFunction batch, TPipelineFunction function, int src_offset, int dst_offset,
+	int array, int index, const float* scale)
+{
+	if (!m_batchable)
+		return;
+
+	BatchStage& stage = m_BatchStages[m_numBatchStages++];
+	stage.batch = batch;
+	stage.function = function;
+	stage.src_offset = src_offset;
+	stage.dst_offset = dst_offset;
+	stage.array = array;
+	stage.index = index;
+	stage.scale = scale;
+}
+
+void VertexLoader::AddIndexedAttribute(int type, int src_offset, int num_indices, int array, int element_size)
+{
+	if (type != INDEX8 && type != INDEX16)
+		return;
+
+	IndexedAttribute& attr = m_IndexedAttributes[m_numIndexedAttributes++];
+	attr.src_offset = src_offset;
+	attr.index_size = type == INDEX8 ? 1 : 2;
+	attr.num_indices = num_indices;
+	attr.array = array;
+	attr.element_size = element_size;
+}
+
+int VertexLoader::GetArrayRanges(const u8* src, int count, VertexArrayRange* ranges) const
+{
+	for (int i = 0; i < m_numIndexedAttributes; i++)
+	{
+		const IndexedAttribute& attr = m_IndexedAttributes[i];
+		u32 min_index = 0xFFFF, max_index = 0;
+		const u8* data = src + attr.src_offset;
+		for (int s = 0; s < count; s++, data += m_VertexSize)
+		{
+			for (int k = 0; k < attr.num_indices; k++)
+			{
+				const u32 index = attr.index_size == 1 ? data[k] : Common::swap16(data + k * 2);
+				min_index = std::min(min_index, index);
+				max_index = std::max(max_index, index);
+			}
+		}
+
+		const u32 stride = arraystrides[attr.array];
+		ranges[i].array = attr.array;
+		ranges[i].offset = min_index * stride;
+		ranges[i].size = (max_index - min_index) * stride + attr.element_size;
+	}
+	return m_numIndexedAttributes;
+}
+
 // ARMTODO: This should be done in a better way
 #ifndef _M_GENERIC
 void VertexLoader::WriteGetVariable(int bits, OpArg dest, void *address)
@@ -828,6 +959,19 @@ void VertexLoader::WriteSetVariable(int bits, void *address, OpArg value)
 }
 #endif
 
+void VertexLoader::WriteResetVariable(int *address)
+{
+#ifdef USE_JIT
+#ifdef _M_ARM
+	MOVI2R(R0, (u32)address);
+	MOVI2R(R1, 0);
+	STR(R1, R0);
+#else
+	WriteSetVariable(32, address, Imm32(0));
+#endif
+#endif
+}
+
 void VertexLoader::SetupRunVertices(int vtx_attr_group, int primitive, int const count)
 {
 	m_numLoadedVertices += count;
@@ -868,8 +1012,44 @@ void VertexLoader::SetupRunVertices(int vtx_attr_group, int primitive, int const
 	s_bbox_loadedPoints = 0;
 }
 
+void VertexLoader::ConvertVerticesBatched(int count)
+{
+	u8* const src = g_pVideoData;
+	u8* const dst = VertexManager::s_pCurBufferPointer;
+
+	// In order, as the SSE converters may write past their attribute
+	for (int i = 0; i < m_numBatchStages; i++)
+	{
+		const BatchStage& stage = m_BatchStages[i];
+		if (stage.batch)
+		{
+			stage.batch(src + stage.src_offset, m_VertexSize, dst + stage.dst_offset, native_stride,
+				count, stage.array, stage.scale ? *stage.scale : 1.f);
+			continue;
+		}
+
+		// No batched converter for this format, run the vertex one over every vertex
+		for (int s = 0; s < count; s++)
+		{
+			g_pVideoData = src + s * m_VertexSize + stage.src_offset;
+			VertexManager::s_pCurBufferPointer = dst + s * native_stride + stage.dst_offset;
+			tcIndex = colIndex = stage.index;
+			stage.function();
+		}
+	}
+
+	g_pVideoData = src + count * m_VertexSize;
+	VertexManager::s_pCurBufferPointer = dst + count * native_stride;
+}
+
 void VertexLoader::ConvertVertices ( int count )
 {
+	if (m_numBatchStages)
+	{
+		ConvertVerticesBatched(count);
+		return;
+	}
+
 #ifdef USE_JIT
 	if (count > 0)
 	{
@@ -906,6 +1086,40 @@ void VertexLoader::RunVertices(int vtx_attr_group, int primitive, int const coun
 	INCSTAT(stats.thisFrame.numPrimitiveJoins);
 }
 
+bool VertexLoader::RunVertices(int vtx_attr_group, int primitive, int const count, std::vector<u8>& cache, bool valid)
+{
+	if (bpmem.genMode.cullmode == 3 && primitive < 5)
+	{
+		DataSkip(count * m_VertexSize);
+		return false;
+	}
+	SetupRunVertices(vtx_attr_group, primitive, count);
+	VertexManager::PrepareForAdditionalData(primitive, count, native_stride);
+
+	const u32 size = count * native_stride;
+	if (valid)
+	{
+		DataSkip(count * m_VertexSize);
+	}
+	else
+	{
+		// Convert to system memory, the vertex buffer may be write combined.
+		// Some loaders write a few bytes past the vertex.
+		cache.resize(size + 16);
+		u8* const dst = VertexManager::s_pCurBufferPointer;
+		VertexManager::s_pCurBufferPointer = &cache[0];
+		ConvertVertices(count);
+		VertexManager::s_pCurBufferPointer = dst;
+	}
+	memcpy(VertexManager::s_pCurBufferPointer, &cache[0], size);
+	VertexManager::s_pCurBufferPointer += size;
+	IndexGenerator::AddIndices(primitive, count);
+
+	ADDSTAT(stats.thisFrame.numPrims, count);
+	INCSTAT(stats.thisFrame.numPrimitiveJoins);
+	return true;
+}
+
 void VertexLoader::SetVAT(u32 _group0, u32 _group1, u32 _group2)
 {
 	VAT vat;
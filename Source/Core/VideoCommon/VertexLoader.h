@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "Common.h"
 
@@ -17,6 +18,9 @@
 #include "NativeVertexFormat.h"
 
 #include "x64Emitter.h"
+#ifdef _M_ARM
+#include "ArmEmitter.h"
+#endif
 
 class VertexLoaderUID
 {
@@ -81,9 +85,19 @@ private:
 	}
 };
 
+// Part of a vertex array read by indexed attributes, relative to the array base
+struct VertexArrayRange
+{
+	int array;
+	u32 offset;
+	u32 size;
+};
+
 // ARMTODO: This should be done in a better way
 #ifndef _M_GENERIC
 class VertexLoader : public Gen::XCodeBlock, NonCopyable
+#elif defined(_M_ARM)
+class VertexLoader : public ArmGen::ARMXCodeBlock, NonCopyable
 #else
 class VertexLoader
 #endif
@@ -97,6 +111,14 @@ public:
 	void SetupRunVertices(int vtx_attr_group, int primitive, int const count);
 	void RunVertices(int vtx_attr_group, int primitive, int count);
 
+	// Like RunVertices, but copies the converted vertices from cache if valid,
+	// or converts them into cache first. Returns false if they were culled.
+	bool RunVertices(int vtx_attr_group, int primitive, int count, std::vector<u8>& cache, bool valid);
+
+	// Fills in the array ranges the count vertices at src index into and returns
+	// the number of ranges, one per indexed attribute.
+	int GetArrayRanges(const u8* src, int count, VertexArrayRange* ranges) const;
+
 	// For debugging / profiling
 	void AppendToString(std::string *dest) const;
 	int GetNumLoadedVerts() const { return m_numLoadedVertices; }
@@ -123,6 +145,33 @@ private:
 	TPipelineFunction m_PipelineStages[64];  // TODO - figure out real max. it's lower.
 	int m_numPipelineStages;
 
+	// One pass per attribute over all vertices of a run, used instead of the
+	// pipeline when the vertex format allows it.
+	struct BatchStage
+	{
+		TBatchFunction batch;        // NULL if the format has no batched converter
+		TPipelineFunction function;  // run per vertex otherwise
+		int src_offset;
+		int dst_offset;
+		int array;
+		int index;                   // tcIndex/colIndex for function
+		const float* scale;
+	};
+	BatchStage m_BatchStages[16];
+	int m_numBatchStages;
+	bool m_batchable;
+
+	struct IndexedAttribute
+	{
+		int src_offset;
+		int index_size;
+		int num_indices;
+		int array;
+		int element_size;
+	};
+	IndexedAttribute m_IndexedAttributes[12];
+	int m_numIndexedAttributes;
+
 	const u8 *m_compiledCode;
 
 	int m_numLoadedVertices;
@@ -131,11 +180,16 @@ private:
 
 	void CompileVertexTranslator();
 	void ConvertVertices(int count);
+	void ConvertVerticesBatched(int count);
 
 	void WriteCall(TPipelineFunction);
+	void AddIndexedAttribute(int type, int src_offset, int num_indices, int array, int element_size);
+	void AddBatchStage(TBatchFunction batch, TPipelineFunction function, int src_offset, int dst_offset,
+		int array, int index, const float* scale);
 
 #ifndef _M_GENERIC
 	void WriteGetVariable(int bits, Gen::OpArg dest, void *address);
 	void WriteSetVariable(int bits, void *address, Gen::OpArg dest);
 #endif
+	void WriteResetVariable(int *address);
 };
@@ -6,7 +6,9 @@
 #include <unordered_map>
 #include <vector>
 
+#include "Hash.h"
 #include "VideoCommon.h"
+#include "VideoConfig.h"
 #include "Statistics.h"
 
 #include "VertexShaderManager.h"
@@ -14,6 +16,8 @@
 #include "VertexLoaderManager.h"
 #include "HW/Memmap.h"
 
+extern int frameCount;
+
 static int s_attr_dirty;  // bitfield
 
 static VertexLoader *g_VertexLoaders[8];
@@ -40,6 +44,47 @@ namespace VertexLoaderManager
 static VertexLoaderMap g_VertexLoaderMap;
 // TODO - change into array of pointers. Keep a map of all seen so far.
 
+enum
+{
+	VERTEX_CACHE_MIN_VERTICES = 8,
+	VERTEX_CACHE_KILL_THRESHOLD = 60,
+	// Primitives that keep changing, like CPU skinned meshes, aren't cached
+	// for a while.
+	VERTEX_CACHE_MAX_MISSES = 3,
+	VERTEX_CACHE_RETRY_FRAMES = 64,
+	// Don't hash arrays that are much bigger than what is drawn from them
+	VERTEX_CACHE_MAX_ARRAY_SCALE = 4,
+};
+
+struct CachedArray
+{
+	VertexArrayRange range;
+	u32 base;
+	u32 stride;
+	u64 hash;
+};
+
+// Converted vertices of a primitive in a display list, by the address of the
+// primitive. Like textures, they are checked against the memory they were
+// read from on every use.
+struct CachedVertices
+{
+	VertexLoader* loader;
+	u32 vat[3];
+	int primitive;
+	int count;
+	u64 hash;
+	CachedArray arrays[12];
+	int num_arrays;
+	std::vector<u8> data;
+
+	int frame;
+	int misses;
+	int retry_frame;
+};
+
+static std::unordered_map<u32, CachedVertices> s_vertex_cache;
+
 void Init()
 {
 	MarkAllDirty();
@@ -55,6 +100,19 @@ void Shutdown()
 		delete p.second;
 	}
 	g_VertexLoaderMap.clear();
+	s_vertex_cache.clear();
+}
+
+void CleanupCache()
+{
+	auto iter = s_vertex_cache.begin();
+	while (iter != s_vertex_cache.end())
+	{
+		if (frameCount > VERTEX_CACHE_KILL_THRESHOLD + iter->second.frame)
+			iter = s_vertex_cache.erase(iter);
+		else
+			++iter;
+	}
 }
 
 namespace
@@ -126,6 +184,117 @@ void RunVertices(int vtx_attr_group, int primitive, int count)
 	RefreshLoader(vtx_attr_group)->RunVertices(vtx_attr_group, primitive, count);
 }
 
+// CRC32 hashing skips the last bytes of a range that isn't a multiple of 8
+static u64 HashRange(const u8* data, u32 size)
+{
+	return GetHash64(data, (size + 7) & ~7, 0);
+}
+
+static bool ArraysMatch(const CachedVertices& entry)
+{
+	for (int i = 0; i < entry.num_arrays; i++)
+	{
+		const CachedArray& cached = entry.arrays[i];
+		const int array = cached.range.array;
+		if (arraybases[array] != cached.base || arraystrides[array] != cached.stride ||
+			HashRange(cached_arraybases[array] + cached.range.offset, cached.range.size) != cached.hash)
+			return false;
+	}
+	return true;
+}
+
+// Fills in the arrays of a new entry, returns false if it isn't worth caching.
+static bool CacheArrays(CachedVertices& entry, const VertexLoader* loader, int count, u32 raw_size)
+{
+	VertexArrayRange ranges[12];
+	entry.num_arrays = loader->GetArrayRanges(g_pVideoData, count, ranges);
+
+	u32 total_size = 0;
+	for (int i = 0; i < entry.num_arrays; i++)
+	{
+		const int array = ranges[i].array;
+		if (!cached_arraybases[array])
+			return false;
+		total_size += ranges[i].size;
+	}
+	if (total_size > raw_size * VERTEX_CACHE_MAX_ARRAY_SCALE + count * 16)
+		return false;
+
+	for (int i = 0; i < entry.num_arrays; i++)
+	{
+		CachedArray& cached = entry.arrays[i];
+		const int array = ranges[i].array;
+		cached.range = ranges[i];
+		cached.base = arraybases[array];
+		cached.stride = arraystrides[array];
+		cached.hash = HashRange(cached_arraybases[array] + ranges[i].offset, ranges[i].size);
+	}
+	return true;
+}
+
+void RunDisplayListVertices(int vtx_attr_group, int primitive, int count, u32 address)
+{
+	if (!count)
+		return;
+	VertexLoader* loader = RefreshLoader(vtx_attr_group);
+
+	if (!g_ActiveConfig.bCacheDisplayListVertices || g_ActiveConfig.CPUBBoxEnabled() || count < VERTEX_CACHE_MIN_VERTICES)
+	{
+		loader->RunVertices(vtx_attr_group, primitive, count);
+		return;
+	}
+
+	CachedVertices& entry = s_vertex_cache[address];
+	entry.frame = frameCount;
+	if (frameCount < entry.retry_frame)
+	{
+		loader->RunVertices(vtx_attr_group, primitive, count);
+		return;
+	}
+
+	const VAT& vat = g_VtxAttr[vtx_attr_group];
+	const u32 raw_size = count * loader->GetVertexSize();
+	const u64 hash = HashRange(g_pVideoData, raw_size);
+
+	const bool valid = entry.loader == loader && entry.primitive == primitive && entry.count == count &&
+		entry.vat[0] == vat.g0.Hex && entry.vat[1] == vat.g1.Hex && entry.vat[2] == vat.g2.Hex &&
+		entry.hash == hash && ArraysMatch(entry);
+
+	if (valid)
+	{
+		entry.misses = 0;
+	}
+	else
+	{
+		if (entry.loader && ++entry.misses >= VERTEX_CACHE_MAX_MISSES)
+			entry.retry_frame = frameCount + VERTEX_CACHE_RETRY_FRAMES;
+
+		entry.loader = NULL;
+		entry.data.clear();
+		if (frameCount < entry.retry_frame || !CacheArrays(entry, loader, count, raw_size))
+		{
+			entry.misses = 0;
+			entry.retry_frame = std::max(entry.retry_frame, frameCount + VERTEX_CACHE_RETRY_FRAMES);
+			loader->RunVertices(vtx_attr_group, primitive, count);
+			return;
+		}
+	}
+
+	if (!loader->RunVertices(vtx_attr_group, primitive, count, entry.data, valid))
+		return;
+
+	if (!valid)
+	{
+		entry.loader = loader;
+		entry.primitive = primitive;
+		entry.count = count;
+		entry.vat[0] = vat.g0.Hex;
+		entry.vat[1] = vat.g1.Hex;
+		entry.vat[2] = vat.g2.Hex;
+		entry.hash = hash;
+	}
+}
+
 void SkipVertices(int vtx_attr_group, int count)
 {
 	if (!count)
@@ -17,6 +17,13 @@ namespace VertexLoaderManager
 	int GetVertexSize(int vtx_attr_group);
 	void RunVertices(int vtx_attr_group, int primitive, int count);
 
+	// For primitives in display lists, reuses the vertices converted the last
+	// time the primitive at that address was drawn if its data didn't change.
+	void RunDisplayListVertices(int vtx_attr_group, int primitive, int count, u32 address);
+
+	// Drops the cached vertices of primitives that weren't drawn for a while
+	void CleanupCache();
+
 	// For debugging
 	void AppendListToString(std::string *dest);
 };
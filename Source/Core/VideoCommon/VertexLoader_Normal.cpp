@@ -58,6 +58,13 @@ __forceinline void ReadIndirect(const T* data)
 	LOG_NORM();
 }
 
+template <typename T, int N>
+__forceinline void ReadIndirect(const T* data, float* out)
+{
+	for (int i = 0; i != N; ++i)
+		out[i] = FracAdjust(Common::FromBigEndian(data[i]));
+}
+
 template <typename T, int N>
 struct Normal_Direct
 {
@@ -68,6 +75,12 @@ struct Normal_Direct
 		DataSkip<N * 3 * sizeof(T)>();
 	}
 
+	static void LOADERDECL batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+	{
+		for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+			ReadIndirect<T, N * 3>(reinterpret_cast<const T*>(src), reinterpret_cast<float*>(dst));
+	}
+
 	static const int size = sizeof(T) * N * 3;
 };
 
@@ -82,6 +95,14 @@ __forceinline void Normal_Index_Offset()
 	ReadIndirect<T, N * 3>(data);
 }
 
+template <typename I, typename T, int N, int Offset>
+__forceinline void Normal_Index_Offset(const u8* src, float* out, const u8* base, u32 stride)
+{
+	auto const index = Common::FromBigEndian(*reinterpret_cast<const I*>(src));
+	auto const data = reinterpret_cast<const T*>(base + index * stride + sizeof(T) * 3 * Offset);
+	ReadIndirect<T, N * 3>(data, out);
+}
+
 template <typename I, typename T, int N>
 struct Normal_Index
 {
@@ -90,6 +111,15 @@ struct Normal_Index
 		Normal_Index_Offset<I, T, N, 0>();
 	}
 
+	static void LOADERDECL batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+	{
+		const u8* const base = cached_arraybases[array];
+		const u32 stride = arraystrides[array];
+
+		for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+			Normal_Index_Offset<I, T, N, 0>(src, reinterpret_cast<float*>(dst), base, stride);
+	}
+
 	static const int size = sizeof(I);
 };
 
@@ -103,6 +133,20 @@ struct Normal_Index_Indices3
 		Normal_Index_Offset<I, T, 1, 2>();
 	}
 
+	static void LOADERDECL batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+	{
+		const u8* const base = cached_arraybases[array];
+		const u32 stride = arraystrides[array];
+
+		for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+		{
+			float* const out = reinterpret_cast<float*>(dst);
+			Normal_Index_Offset<I, T, 1, 0>(src, out, base, stride);
+			Normal_Index_Offset<I, T, 1, 1>(src + sizeof(I), out + 3, base, stride);
+			Normal_Index_Offset<I, T, 1, 2>(src + sizeof(I) * 2, out + 6, base, stride);
+		}
+	}
+
 	static const int size = sizeof(I) * 3;
 };
 
@@ -192,3 +236,9 @@ TPipelineFunction VertexLoader_Normal::GetFunction(unsigned int _type,
 	TPipelineFunction pFunc = m_Table[_type][_index3][_elements][_format].function;
 	return pFunc;
 }
+
+TBatchFunction VertexLoader_Normal::GetBatchFunction(unsigned int _type,
+	unsigned int _format, unsigned int _elements, unsigned int _index3)
+{
+	return m_Table[_type][_index3][_elements][_format].batch;
+}
@@ -22,6 +22,10 @@ public:
 	static TPipelineFunction GetFunction(unsigned int _type,
 		unsigned int _format, unsigned int _elements, unsigned int _index3);
 
+	// GetBatchFunction
+	static TBatchFunction GetBatchFunction(unsigned int _type,
+		unsigned int _format, unsigned int _elements, unsigned int _index3);
+
 private:
 	enum ENormalType
 	{
@@ -63,10 +67,12 @@ private:
 		{
 			gc_size = T::size;
 			function = T::function;
+			batch = T::batch;
 		}
 
 		int gc_size;
 		TPipelineFunction function;
+		TBatchFunction batch;
 	};
 
 	static Set m_Table[NUM_NRM_TYPE][NUM_NRM_INDICES][NUM_NRM_ELEMENTS][NUM_NRM_FORMAT];
@@ -11,6 +11,10 @@
 #include "VertexManagerBase.h"
 #include "CPUDetect.h"
 
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 extern float posScale;
 extern TVtxAttr *pVtxAttr;
 
@@ -120,6 +124,94 @@ void LOADERDECL Pos_ReadIndex_Float_SSSE3()
 }
 #endif
 
+template <typename T, int N>
+void LOADERDECL Pos_ReadDirect_Batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	static_assert(N <= 3, "N > 3 is not sane!");
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		auto const data = reinterpret_cast<const T*>(src);
+		float* const out = reinterpret_cast<float*>(dst);
+		for (int i = 0; i < 3; ++i)
+			out[i] = i<N ? PosScale(Common::FromBigEndian(data[i]), scale) : 0.f;
+	}
+}
+
+template <typename I, typename T, int N>
+void LOADERDECL Pos_ReadIndex_Batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	static_assert(!std::numeric_limits<I>::is_signed, "Only unsigned I is sane!");
+	static_assert(N <= 3, "N > 3 is not sane!");
+
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		auto const index = Common::FromBigEndian(*reinterpret_cast<const I*>(src));
+		auto const data = reinterpret_cast<const T*>(base + index * stride);
+		float* const out = reinterpret_cast<float*>(dst);
+		for (int i = 0; i < 3; ++i)
+			out[i] = i<N ? PosScale(Common::FromBigEndian(data[i]), scale) : 0.f;
+	}
+}
+
+// The batched versions store exactly 12 bytes, as the following attributes
+// of the vertex may already have been written by an earlier pass.
+#if _M_SSE >= 0x301
+__forceinline void Pos_Float_SSSE3(const u8* data, u8* dst, bool three)
+{
+	const __m128i a = _mm_loadl_epi64((const __m128i*)data);
+	const __m128i b = three ? _mm_cvtsi32_si128(*(const s32*)(data + 8)) : _mm_setzero_si128();
+	const __m128i c = _mm_shuffle_epi8(_mm_unpacklo_epi64(a, b), kMaskSwap32_3);
+	_mm_storel_epi64((__m128i*)dst, c);
+	*(s32*)(dst + 8) = _mm_cvtsi128_si32(_mm_srli_si128(c, 8));
+}
+
+template <bool three>
+void LOADERDECL Pos_ReadDirect_Float_Batch_SSSE3(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+		Pos_Float_SSSE3(src, dst, three);
+}
+
+template <typename I, bool three>
+void LOADERDECL Pos_ReadIndex_Float_Batch_SSSE3(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+		Pos_Float_SSSE3(base + Common::FromBigEndian(*(const I*)src) * stride, dst, three);
+}
+#endif
+
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+__forceinline void Pos_Float_NEON(const u8* data, u8* dst, bool three)
+{
+	vst1_u8(dst, vrev32_u8(vld1_u8(data)));
+	*(u32*)(dst + 8) = three ? Common::swap32(data + 8) : 0;
+}
+
+template <bool three>
+void LOADERDECL Pos_ReadDirect_Float_Batch_NEON(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+		Pos_Float_NEON(src, dst, three);
+}
+
+template <typename I, bool three>
+void LOADERDECL Pos_ReadIndex_Float_Batch_NEON(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+		Pos_Float_NEON(base + Common::FromBigEndian(*(const I*)src) * stride, dst, three);
+}
+#endif
+
 static TPipelineFunction tableReadPosition[4][8][2] = {
 	{
 		{NULL, NULL,},
@@ -151,6 +243,37 @@ static TPipelineFunction tableReadPosition[4][8][2] = {
 	},
 };
 
+static TBatchFunction tableReadPositionBatch[4][8][2] = {
+	{
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+	},
+	{
+		{Pos_ReadDirect_Batch<u8, 2>, Pos_ReadDirect_Batch<u8, 3>,},
+		{Pos_ReadDirect_Batch<s8, 2>, Pos_ReadDirect_Batch<s8, 3>,},
+		{Pos_ReadDirect_Batch<u16, 2>, Pos_ReadDirect_Batch<u16, 3>,},
+		{Pos_ReadDirect_Batch<s16, 2>, Pos_ReadDirect_Batch<s16, 3>,},
+		{Pos_ReadDirect_Batch<float, 2>, Pos_ReadDirect_Batch<float, 3>,},
+	},
+	{
+		{Pos_ReadIndex_Batch<u8, u8, 2>, Pos_ReadIndex_Batch<u8, u8, 3>,},
+		{Pos_ReadIndex_Batch<u8, s8, 2>, Pos_ReadIndex_Batch<u8, s8, 3>,},
+		{Pos_ReadIndex_Batch<u8, u16, 2>, Pos_ReadIndex_Batch<u8, u16, 3>,},
+		{Pos_ReadIndex_Batch<u8, s16, 2>, Pos_ReadIndex_Batch<u8, s16, 3>,},
+		{Pos_ReadIndex_Batch<u8, float, 2>, Pos_ReadIndex_Batch<u8, float, 3>,},
+	},
+	{
+		{Pos_ReadIndex_Batch<u16, u8, 2>, Pos_ReadIndex_Batch<u16, u8, 3>,},
+		{Pos_ReadIndex_Batch<u16, s8, 2>, Pos_ReadIndex_Batch<u16, s8, 3>,},
+		{Pos_ReadIndex_Batch<u16, u16, 2>, Pos_ReadIndex_Batch<u16, u16, 3>,},
+		{Pos_ReadIndex_Batch<u16, s16, 2>, Pos_ReadIndex_Batch<u16, s16, 3>,},
+		{Pos_ReadIndex_Batch<u16, float, 2>, Pos_ReadIndex_Batch<u16, float, 3>,},
+	},
+};
+
 static int tableReadPositionVertexSize[4][8][2] = {
 	{
 		{0, 0,}, {0, 0,}, {0, 0,}, {0, 0,}, {0, 0,},
@@ -178,10 +301,28 @@ void VertexLoader_Position::Init(void)
 		tableReadPosition[2][4][1] = Pos_ReadIndex_Float_SSSE3<u8, true>;
 		tableReadPosition[3][4][0] = Pos_ReadIndex_Float_SSSE3<u16, false>;
 		tableReadPosition[3][4][1] = Pos_ReadIndex_Float_SSSE3<u16, true>;
+
+		tableReadPositionBatch[1][4][0] = Pos_ReadDirect_Float_Batch_SSSE3<false>;
+		tableReadPositionBatch[1][4][1] = Pos_ReadDirect_Float_Batch_SSSE3<true>;
+		tableReadPositionBatch[2][4][0] = Pos_ReadIndex_Float_Batch_SSSE3<u8, false>;
+		tableReadPositionBatch[2][4][1] = Pos_ReadIndex_Float_Batch_SSSE3<u8, true>;
+		tableReadPositionBatch[3][4][0] = Pos_ReadIndex_Float_Batch_SSSE3<u16, false>;
+		tableReadPositionBatch[3][4][1] = Pos_ReadIndex_Float_Batch_SSSE3<u16, true>;
 	}
 
 #endif
 
+#if defined(_M_ARM) && defined(__ARM_NEON__)
+
+	tableReadPositionBatch[1][4][0] = Pos_ReadDirect_Float_Batch_NEON<false>;
+	tableReadPositionBatch[1][4][1] = Pos_ReadDirect_Float_Batch_NEON<true>;
+	tableReadPositionBatch[2][4][0] = Pos_ReadIndex_Float_Batch_NEON<u8, false>;
+	tableReadPositionBatch[2][4][1] = Pos_ReadIndex_Float_Batch_NEON<u8, true>;
+	tableReadPositionBatch[3][4][0] = Pos_ReadIndex_Float_Batch_NEON<u16, false>;
+	tableReadPositionBatch[3][4][1] = Pos_ReadIndex_Float_Batch_NEON<u16, true>;
+
+#endif
+
 }
 
 unsigned int VertexLoader_Position::GetSize(unsigned int _type, unsigned int _format, unsigned int _elements)
@@ -193,3 +334,8 @@ TPipelineFunction VertexLoader_Position::GetFunction(unsigned int _type, unsigne
 {
 	return tableReadPosition[_type][_format][_elements];
 }
+
+TBatchFunction VertexLoader_Position::GetBatchFunction(unsigned int _type, unsigned int _format, unsigned int _elements)
+{
+	return tableReadPositionBatch[_type][_format][_elements];
+}
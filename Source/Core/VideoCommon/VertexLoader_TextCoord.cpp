@@ -128,6 +128,72 @@ void LOADERDECL TexCoord_ReadIndex_Float2_SSSE3()
 }
 #endif
 
+template <typename T, int N>
+void LOADERDECL TexCoord_ReadDirect_Batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		auto const data = reinterpret_cast<const T*>(src);
+		float* const out = reinterpret_cast<float*>(dst);
+		for (int i = 0; i != N; ++i)
+			out[i] = TCScale(Common::FromBigEndian(data[i]), scale);
+	}
+}
+
+template <typename I, typename T, int N>
+void LOADERDECL TexCoord_ReadIndex_Batch(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	static_assert(!std::numeric_limits<I>::is_signed, "Only unsigned I is sane!");
+
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		auto const index = Common::FromBigEndian(*reinterpret_cast<const I*>(src));
+		auto const data = reinterpret_cast<const T*>(base + index * stride);
+		float* const out = reinterpret_cast<float*>(dst);
+		for (int i = 0; i != N; ++i)
+			out[i] = TCScale(Common::FromBigEndian(data[i]), scale);
+	}
+}
+
+#if _M_SSE >= 0x401
+template <typename I>
+void LOADERDECL TexCoord_ReadIndex_Short2_Batch_SSE4(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+	const __m128 e = _mm_set1_ps(scale);
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		const s32* pData = (const s32*)(base + Common::FromBigEndian(*(const I*)src) * stride);
+		const __m128i a = _mm_cvtsi32_si128(*pData);
+		const __m128i b = _mm_shuffle_epi8(a, kMaskSwap16_2);
+		const __m128 d = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(b));
+		// Only the two coordinates, the rest of the vertex may already be written
+		_mm_storel_pi((__m64*)dst, _mm_mul_ps(d, e));
+	}
+}
+#endif
+
+#if _M_SSE >= 0x301
+template <typename I>
+void LOADERDECL TexCoord_ReadIndex_Float2_Batch_SSSE3(const u8* src, int src_stride, u8* dst, int dst_stride, int count, int array, float scale)
+{
+	const u8* const base = cached_arraybases[array];
+	const u32 stride = arraystrides[array];
+
+	for (int v = 0; v < count; ++v, src += src_stride, dst += dst_stride)
+	{
+		const u8* pData = base + Common::FromBigEndian(*(const I*)src) * stride;
+		const __m128i a = _mm_loadl_epi64((const __m128i*)pData);
+		_mm_storel_epi64((__m128i*)dst, _mm_shuffle_epi8(a, kMaskSwap32));
+	}
+}
+#endif
+
 static TPipelineFunction tableReadTexCoord[4][8][2] = {
 	{
 		{NULL, NULL,},
@@ -159,6 +225,37 @@ static TPipelineFunction tableReadTexCoord[4][8][2] = {
 	},
 };
 
+static TBatchFunction tableReadTexCoordBatch[4][8][2] = {
+	{
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+		{NULL, NULL,},
+	},
+	{
+		{TexCoord_ReadDirect_Batch<u8, 1>,  TexCoord_ReadDirect_Batch<u8, 2>,},
+		{TexCoord_ReadDirect_Batch<s8, 1>,   TexCoord_ReadDirect_Batch<s8, 2>,},
+		{TexCoord_ReadDirect_Batch<u16, 1>, TexCoord_ReadDirect_Batch<u16, 2>,},
+		{TexCoord_ReadDirect_Batch<s16, 1>,  TexCoord_ReadDirect_Batch<s16, 2>,},
+		{TexCoord_ReadDirect_Batch<float, 1>,  TexCoord_ReadDirect_Batch<float, 2>,},
+	},
+	{
+		{TexCoord_ReadIndex_Batch<u8, u8, 1>,  TexCoord_ReadIndex_Batch<u8, u8, 2>,},
+		{TexCoord_ReadIndex_Batch<u8, s8, 1>,   TexCoord_ReadIndex_Batch<u8, s8, 2>,},
+		{TexCoord_ReadIndex_Batch<u8, u16, 1>, TexCoord_ReadIndex_Batch<u8, u16, 2>,},
+		{TexCoord_ReadIndex_Batch<u8, s16, 1>,  TexCoord_ReadIndex_Batch<u8, s16, 2>,},
+		{TexCoord_ReadIndex_Batch<u8, float, 1>,  TexCoord_ReadIndex_Batch<u8, float, 2>,},
+	},
+	{
+		{TexCoord_ReadIndex_Batch<u16, u8, 1>,  TexCoord_ReadIndex_Batch<u16, u8, 2>,},
+		{TexCoord_ReadIndex_Batch<u16, s8, 1>,   TexCoord_ReadIndex_Batch<u16, s8, 2>,},
+		{TexCoord_ReadIndex_Batch<u16, u16, 1>, TexCoord_ReadIndex_Batch<u16, u16, 2>,},
+		{TexCoord_ReadIndex_Batch<u16, s16, 1>,  TexCoord_ReadIndex_Batch<u16, s16, 2>,},
+		{TexCoord_ReadIndex_Batch<u16, float, 1>,  TexCoord_ReadIndex_Batch<u16, float, 2>,},
+	},
+};
+
 static int tableReadTexCoordVertexSize[4][8][2] = {
 	{
 		{0, 0,}, {0, 0,}, {0, 0,}, {0, 0,}, {0, 0,},
@@ -183,6 +280,8 @@ void VertexLoader_TextCoord::Init(void)
 	{
 		tableReadTexCoord[2][4][1] = TexCoord_ReadIndex_Float2_SSSE3<u8>;
 		tableReadTexCoord[3][4][1] = TexCoord_ReadIndex_Float2_SSSE3<u16>;
+		tableReadTexCoordBatch[2][4][1] = TexCoord_ReadIndex_Float2_Batch_SSSE3<u8>;
+		tableReadTexCoordBatch[3][4][1] = TexCoord_ReadIndex_Float2_Batch_SSSE3<u16>;
 	}
 
 #endif
@@ -193,6 +292,8 @@ void VertexLoader_TextCoord::Init(void)
 	{
 		tableReadTexCoord[2][3][1] = TexCoord_ReadIndex_Short2_SSE4<u8>;
 		tableReadTexCoord[3][3][1] = TexCoord_ReadIndex_Short2_SSE4<u16>;
+		tableReadTexCoordBatch[2][3][1] = TexCoord_ReadIndex_Short2_Batch_SSE4<u8>;
+		tableReadTexCoordBatch[3][3][1] = TexCoord_ReadIndex_Short2_Batch_SSE4<u16>;
 	}
 
 #endif
@@ -209,6 +310,11 @@ TPipelineFunction VertexLoader_TextCoord::GetFunction(unsigned int _type, unsign
 	return tableReadTexCoord[_type][_format][_elements];
 }
 
+TBatchFunction VertexLoader_TextCoord::GetBatchFunction(unsigned int _type, unsigned int _format, unsigned int _elements)
+{
+	return tableReadTexCoordBatch[_type][_format][_elements];
+}
+
 TPipelineFunction VertexLoader_TextCoord::GetDummyFunction()
 {
 	return TexCoord_Read_Dummy;
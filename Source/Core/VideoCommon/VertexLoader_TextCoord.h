@@ -19,6 +19,9 @@ public:
 	// GetFunction
 	static TPipelineFunction GetFunction(unsigned int _type, unsigned int _format, unsigned int _elements);
 
+	// GetBatchFunction
+	static TBatchFunction GetBatchFunction(unsigned int _type, unsigned int _format, unsigned int _elements);
+
 	// GetDummyFunction
 	// It is important to synchronize tcIndex.
 	static TPipelineFunction GetDummyFunction();
@@ -27,6 +27,8 @@ u8 *VertexManager::s_pEndBufferPointer;
 PrimitiveType VertexManager::current_primitive_type;
 
 bool VertexManager::IsFlushed;
+bool VertexManager::s_batch_open;
+bool VertexManager::s_may_batch;
 
 static const PrimitiveType primitive_from_gx[8] = {
 	PRIMITIVE_TRIANGLES, // GX_DRAW_QUADS
@@ -142,9 +144,30 @@ u32 VertexManager::GetRemainingIndices(int primitive)
 	}
 }
 
-void VertexManager::Flush()
+u32 VertexManager::GetUsedTextures()
 {
-	if (IsFlushed) return;
+	u32 usedtextures = 0;
+	for (u32 i = 0; i < bpmem.genMode.numtevstages + 1u; ++i)
+		if (bpmem.tevorders[i / 2].getEnable(i & 1))
+			usedtextures |= 1 << bpmem.tevorders[i/2].getTexMap(i & 1);
+
+	if (bpmem.genMode.numindstages > 0)
+		for (unsigned int i = 0; i < bpmem.genMode.numtevstages + 1u; ++i)
+			if (bpmem.tevind[i].IsActive() && bpmem.tevind[i].bt < bpmem.genMode.numindstages)
+				usedtextures |= 1 << bpmem.tevindref.getTexMap(bpmem.tevind[i].bt);
+
+	return usedtextures;
+}
+
+void VertexManager::Flush(bool constants_only)
+{
+	if (IsFlushed)
+	{
+		// Whatever the caller changes now could affect the batched draws
+		if (s_batch_open && !constants_only)
+			g_vertex_manager->EndBatch();
+		return;
+	}
 
 	// loading a state will invalidate BP, so check for it
 	g_video_backend->CheckInvalidState();
@@ -179,15 +202,7 @@ void VertexManager::Flush()
 		bpmem.genMode.numtexgens, (u32)bpmem.dstalpha.enable, (bpmem.alpha_test.hex>>16)&0xff);
 #endif
 
-	u32 usedtextures = 0;
-	for (u32 i = 0; i < bpmem.genMode.numtevstages + 1u; ++i)
-		if (bpmem.tevorders[i / 2].getEnable(i & 1))
-			usedtextures |= 1 << bpmem.tevorders[i/2].getTexMap(i & 1);
-
-	if (bpmem.genMode.numindstages > 0)
-		for (unsigned int i = 0; i < bpmem.genMode.numtevstages + 1u; ++i)
-			if (bpmem.tevind[i].IsActive() && bpmem.tevind[i].bt < bpmem.genMode.numindstages)
-				usedtextures |= 1 << bpmem.tevindref.getTexMap(bpmem.tevind[i].bt);
+	const u32 usedtextures = GetUsedTextures();
 
 	for (unsigned int i = 0; i < 8; i++)
 	{
@@ -218,12 +233,21 @@ void VertexManager::Flush()
 	VertexShaderManager::SetConstants();
 	PixelShaderManager::SetConstants();
 
+	// Queries and the debugger need to see each draw on its own
+	s_may_batch = constants_only && !PerfQueryBase::ShouldEmulate() && !GFXDebuggerCapturing;
+	if (s_batch_open && (PerfQueryBase::ShouldEmulate() || GFXDebuggerCapturing))
+		g_vertex_manager->EndBatch();
+
 	bool useDstAlpha = !g_ActiveConfig.bDstAlphaPass && bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate
 		&& bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24;
 
 	if(PerfQueryBase::ShouldEmulate())
 		g_perf_query->EnableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
+	if (GFXDebuggerCapturing)
+		GFXDebuggerBeginDraw(IndexGenerator::GetNumVerts(), IndexGenerator::GetIndexLen(), usedtextures);
 	g_vertex_manager->vFlush(useDstAlpha);
+	if (GFXDebuggerCapturing)
+		GFXDebuggerEndDraw();
 	if(PerfQueryBase::ShouldEmulate())
 		g_perf_query->DisableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
 
@@ -234,5 +258,6 @@ void VertexManager::Flush()
 
 void VertexManager::DoState(PointerWrap& p)
 {
+	g_vertex_manager->EndBatch();
 	g_vertex_manager->vDoState(p);
 }
@@ -38,7 +38,15 @@ public:
 	static void PrepareForAdditionalData(int primitive, u32 count, u32 stride);
 	static u32 GetRemainingIndices(int primitive);
 
-	static void Flush();
+	// With constants_only, the caller changes nothing but shader constants
+	// before the next draw, so the backend may batch this draw with that one
+	static void Flush(bool constants_only = false);
+
+	// Issues the draws the backend held back
+	virtual void EndBatch() {}
+
+	// Bit i is set if the current TEV setup samples texture map i
+	static u32 GetUsedTextures();
 
 	virtual ::NativeVertexFormat* CreateNativeVertexFormat() = 0;
 
@@ -51,6 +59,10 @@ protected:
 
 	static PrimitiveType current_primitive_type;
 
+	// The backend holds back draws, and whether vFlush may add to them
+	static bool s_batch_open;
+	static bool s_may_batch;
+
 	virtual void ResetBuffer(u32 stride) = 0;
 
 private:
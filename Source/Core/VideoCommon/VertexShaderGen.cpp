@@ -17,7 +17,7 @@
 #include "VertexShaderGen.h"
 #include "VideoConfig.h"
 
-static char text[16768];
+static char text[32768];
 
 template<class T>
 static void DefineVSOutputStructMember(T& object, API_TYPE api_type, const char* type, const char* name, int var_index, const char* semantic, int semantic_index = -1)
@@ -56,8 +56,160 @@ static inline void GenerateVSOutputStruct(T& object, API_TYPE api_type)
 	object.Write("};\n");
 }
 
+// Declares the inputs of a shader which expands lines or points as globals,
+// and LoadVertex which fills them from the buffer textures.
 template<class T>
-static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_type)
+static void GenerateExpandedVertexLoader(T& out, u32 components, VS_EXPAND expand)
+{
+	out.Write("uniform samplerBuffer vexpand_float;\n"
+		"uniform usamplerBuffer vexpand_uint;\n"
+		"uniform usamplerBuffer vexpand_index;\n"
+		"uniform int4 " I_EXPANDLAYOUT"[7];\n"
+		"uniform float4 " I_EXPANDPARAMS"[3];\n");
+
+	out.Write("float4 rawpos;\n");
+	if (components & VB_HAS_POSMTXIDX)
+		out.Write("float fposmtx;\n");
+	for (int i = 0; i < 3; ++i)
+		if (components & (VB_HAS_NRM0 << i))
+			out.Write("float3 rawnorm%d;\n", i);
+	for (int i = 0; i < 2; ++i)
+		if (components & (VB_HAS_COL0 << i))
+			out.Write("float4 color%d;\n", i);
+	for (int i = 0; i < 8; ++i)
+	{
+		u32 hastexmtx = (components & (VB_HAS_TEXMTXIDX0<<i));
+		if ((components & (VB_HAS_UV0<<i)) || hastexmtx)
+			out.Write("float%d tex%d;\n", hastexmtx ? 3 : 2, i);
+	}
+
+	out.Write("float FetchFloat(int offset) { return texelFetch(vexpand_float, offset).r; }\n"
+		"float4 FetchColor(int offset) { uint c = texelFetch(vexpand_uint, offset).r; return float4(uvec4(c, c >> 8, c >> 16, c >> 24) & 0xFFu) / 255.0; }\n");
+
+	// Offsets are in words, the native vertex format only has 4 byte aligned attributes
+	out.Write("void LoadVertex(int index)\n{\n");
+	out.Write("int v = " I_EXPANDLAYOUT"[0].y + int(texelFetch(vexpand_index, " I_EXPANDLAYOUT"[0].z + index).r) * " I_EXPANDLAYOUT"[0].x;\n");
+	out.Write("rawpos = float4(FetchFloat(v), FetchFloat(v + 1), FetchFloat(v + 2), 1.0);\n");
+	// Rounded up, as the attribute is read as a normalized byte
+	if (components & VB_HAS_POSMTXIDX)
+		out.Write("fposmtx = (float(texelFetch(vexpand_uint, v + " I_EXPANDLAYOUT"[%d].%c).r & 0xFFu) + 0.5) / 255.0;\n",
+			1 + SHADER_POSMTX_ATTRIB / 4, "xyzw"[SHADER_POSMTX_ATTRIB % 4]);
+	for (int i = 0; i < 3; ++i)
+	{
+		const int attrib = SHADER_NORM0_ATTRIB + i;
+		if (components & (VB_HAS_NRM0 << i))
+			out.Write("{ int o = v + " I_EXPANDLAYOUT"[%d].%c; rawnorm%d = float3(FetchFloat(o), FetchFloat(o + 1), FetchFloat(o + 2)); }\n",
+				1 + attrib / 4, "xyzw"[attrib % 4], i);
+	}
+	for (int i = 0; i < 2; ++i)
+	{
+		const int attrib = SHADER_COLOR0_ATTRIB + i;
+		if (components & (VB_HAS_COL0 << i))
+			out.Write("color%d = FetchColor(v + " I_EXPANDLAYOUT"[%d].%c);\n", i, 1 + attrib / 4, "xyzw"[attrib % 4]);
+	}
+	for (int i = 0; i < 8; ++i)
+	{
+		const int attrib = SHADER_TEXTURE0_ATTRIB + i;
+		u32 hastexmtx = (components & (VB_HAS_TEXMTXIDX0<<i));
+		if (!(components & (VB_HAS_UV0<<i)) && !hastexmtx)
+			continue;
+
+		// Coordinates may have only one component, the attribute would fill in zero
+		out.Write("{ int o = v + " I_EXPANDLAYOUT"[%d].%c; ", 1 + attrib / 4, "xyzw"[attrib % 4]);
+		if (hastexmtx)
+			out.Write("tex%d = float3(FetchFloat(o), FetchFloat(o + 1), FetchFloat(o + 2)); }\n", i);
+		else
+			out.Write("tex%d = float2(FetchFloat(o), " I_EXPANDLAYOUT"[%d].%c > 1 ? FetchFloat(o + 1) : 0.0); }\n",
+				i, 5 + i / 4, "xyzw"[i % 4]);
+	}
+	out.Write("}\n");
+
+	// The direction of a line is given by the other end of it
+	if (expand == VSEXPAND_LINE)
+	{
+		out.Write("float4 ProjectPosition()\n{\n");
+		if (components & VB_HAS_POSMTXIDX)
+		{
+			out.Write("int posmtx = int(fposmtx * 255.0);\n");
+			out.Write("float4 pos = float4(dot(" I_TRANSFORMMATRICES"[posmtx], rawpos), dot(" I_TRANSFORMMATRICES"[posmtx+1], rawpos), dot(" I_TRANSFORMMATRICES"[posmtx+2], rawpos), 1);\n");
+		}
+		else
+		{
+			out.Write("float4 pos = float4(dot(" I_POSNORMALMATRIX"[0], rawpos), dot(" I_POSNORMALMATRIX"[1], rawpos), dot(" I_POSNORMALMATRIX"[2], rawpos), 1.0);\n");
+		}
+		out.Write("return float4(dot(" I_PROJECTION"[0], pos), dot(" I_PROJECTION"[1], pos), dot(" I_PROJECTION"[2], pos), dot(" I_PROJECTION"[3], pos));\n}\n");
+	}
+}
+
+// Moves the corner of the quad drawn for a line or point away from its
+// vertex, the same way as the D3D line and point geometry shaders.
+// The corners are drawn as a triangle strip.
+template<class T>
+static void GenerateExpansion(T& out, VS_EXPAND expand)
+{
+	out.Write("float4 expand = " I_EXPANDPARAMS"[0];\n");
+	if (expand == VSEXPAND_LINE)
+	{
+		// Lines are extended left and right or up and down, whichever is
+		// closer to their normal. The corners on the right get the tex offset.
+		out.Write("float2 to = abs(other_pos.xy - o.pos.xy);\n"
+			"float2 offset = (expand.w * to.y > expand.z * to.x) ? float2(expand.x / expand.z, 0.0) : float2(0.0, -expand.x / expand.w);\n"
+			"bool right = (gl_VertexID & 1) != 0;\n"
+			"o.pos.xy += (right ? 1.0 : -1.0) * offset * o.pos.w;\n");
+		for (unsigned int i = 0; i < xfregs.numTexGen.numTexGens; ++i)
+			out.Write("if (right) o.tex%d.x += expand.y * " I_EXPANDPARAMS"[%d].%c;\n", i, 1 + i / 4, "xyzw"[i % 4]);
+	}
+	else
+	{
+		out.Write("float2 corner = float2((gl_VertexID & 1) != 0 ? 1.0 : -1.0, (gl_VertexID & 2) != 0 ? 1.0 : -1.0);\n"
+			"o.pos.xy += corner * float2(expand.x / expand.z, -expand.x / expand.w) * o.pos.w;\n"
+			"float2 tex_corner = float2((gl_VertexID & 1) != 0 ? 1.0 : 0.0, (gl_VertexID & 2) != 0 ? 0.0 : 1.0);\n");
+		for (unsigned int i = 0; i < xfregs.numTexGen.numTexGens; ++i)
+			out.Write("o.tex%d.xy += tex_corner * expand.y * " I_EXPANDPARAMS"[%d].%c;\n", i, 1 + i / 4, "xyzw"[i % 4]);
+	}
+}
+
+static void WriteDeclarations(ShaderCode& out, API_TYPE api_type, bool multi_draw, bool expanded)
+{
+	// uniforms
+	if (api_type == API_OPENGL && multi_draw)
+		out.Write("struct VSConstants {\n");
+	else if (api_type == API_OPENGL)
+		out.Write("layout(std140%s) uniform VSBlock {\n", g_ActiveConfig.backend_info.bSupportShadingLanguage420pack ? ", binding = 2" : "");
+
+	DeclareUniform(out, api_type, C_POSNORMALMATRIX, "float4", I_POSNORMALMATRIX"[6]");
+	DeclareUniform(out, api_type, C_PROJECTION, "float4", I_PROJECTION"[4]");
+	DeclareUniform(out, api_type, C_MATERIALS, "float4", I_MATERIALS"[4]");
+	DeclareUniform(out, api_type, C_LIGHTS,  "float4", I_LIGHTS"[40]");
+	DeclareUniform(out, api_type, C_TEXMATRICES, "float4", I_TEXMATRICES"[24]");
+	DeclareUniform(out, api_type, C_TRANSFORMMATRICES, "float4", I_TRANSFORMMATRICES"[64]");
+	DeclareUniform(out, api_type, C_NORMALMATRICES, "float4", I_NORMALMATRICES"[32]");
+	DeclareUniform(out, api_type, C_POSTTRANSFORMMATRICES, "float4", I_POSTTRANSFORMMATRICES"[64]");
+	DeclareUniform(out, api_type, C_DEPTHPARAMS, "float4", I_DEPTHPARAMS);
+
+	if (api_type == API_OPENGL)
+		out.Write("};\n");
+
+	if (multi_draw)
+	{
+		static const char* const members[] = {
+			I_POSNORMALMATRIX, I_PROJECTION, I_MATERIALS, I_LIGHTS, I_TEXMATRICES,
+			I_TRANSFORMMATRICES, I_NORMALMATRICES, I_POSTTRANSFORMMATRICES, I_DEPTHPARAMS,
+		};
+		DeclareMultiDrawBlock(out, "VSBlock", "VSConstants", "vs_draws", 2, members, ArraySize(members));
+
+		// The expanded lines and points are drawn on their own
+		if (!expanded)
+			out.Write("ATTRIN uint draw_index; // ATTR%d,\n"
+				"#define DRAW_INDEX draw_index\n", SHADER_DRAWID_ATTRIB);
+		else
+			out.Write("#define DRAW_INDEX 0u\n");
+		out.Write("flat out uint draw_index_2;\n");
+	}
+}
+
+template<class T>
+static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_type, VS_EXPAND expand)
 {
 	// Non-uid template parameters will write to the dummy data (=> gets optimized out)
 	vertex_shader_uid_data dummy_data;
@@ -67,11 +219,11 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 	out.SetBuffer(text);
 	const bool is_writing_shadercode = (out.GetBuffer() != NULL);
 #ifndef ANDROID
-	locale_t locale;
+	// Created once, making a locale for every shader is surprisingly slow
+	static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", NULL);
 	locale_t old_locale;
 	if (is_writing_shadercode)
 	{
-		locale = newlocale(LC_NUMERIC_MASK, "C", NULL); // New locale for compilation
 		old_locale = uselocale(locale); // Apply the locale for this thread
 	}
 #endif
@@ -82,30 +234,32 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 	_assert_(bpmem.genMode.numtexgens == xfregs.numTexGen.numTexGens);
 	_assert_(bpmem.genMode.numcolchans == xfregs.numChan.numColorChans);
 
-	// uniforms
-	if (api_type == API_OPENGL)
-		out.Write("layout(std140%s) uniform VSBlock {\n", g_ActiveConfig.backend_info.bSupportShadingLanguage420pack ? ", binding = 2" : "");
+	uid_data.multi_draw = api_type == API_OPENGL && g_ActiveConfig.MultiDrawEnabled();
 
-	DeclareUniform(out, api_type, C_POSNORMALMATRIX, "float4", I_POSNORMALMATRIX"[6]");
-	DeclareUniform(out, api_type, C_PROJECTION, "float4", I_PROJECTION"[4]");
-	DeclareUniform(out, api_type, C_MATERIALS, "float4", I_MATERIALS"[4]");
-	DeclareUniform(out, api_type, C_LIGHTS,  "float4", I_LIGHTS"[40]");
-	DeclareUniform(out, api_type, C_TEXMATRICES, "float4", I_TEXMATRICES"[24]");
-	DeclareUniform(out, api_type, C_TRANSFORMMATRICES, "float4", I_TRANSFORMMATRICES"[64]");
-	DeclareUniform(out, api_type, C_NORMALMATRICES, "float4", I_NORMALMATRICES"[32]");
-	DeclareUniform(out, api_type, C_POSTTRANSFORMMATRICES, "float4", I_POSTTRANSFORMMATRICES"[64]");
-	DeclareUniform(out, api_type, C_DEPTHPARAMS, "float4", I_DEPTHPARAMS);
-
-	if (api_type == API_OPENGL)
-		out.Write("};\n");
+	// The declarations only depend on the API and a couple of backend features
+	if (is_writing_shadercode)
+	{
+		static ShaderSnippetCache snippets;
+		const bool multi_draw = uid_data.multi_draw;
+		const bool expanded = expand != VSEXPAND_NONE;
+		const u32 key = api_type | (multi_draw << 8) | (expanded << 9) | (g_ActiveConfig.backend_info.bSupportShadingLanguage420pack << 10);
+		out.Append(snippets.Get("declarations", key, [&](ShaderCode& code) {
+			WriteDeclarations(code, api_type, multi_draw, expanded);
+		}));
+	}
 
 	GenerateVSOutputStruct(out, api_type);
 
 	uid_data.numTexGens = xfregs.numTexGen.numTexGens;
 	uid_data.components = components;
 	uid_data.pixel_lighting = (g_ActiveConfig.bEnablePixelLighting && g_ActiveConfig.backend_info.bSupportsPixelLighting);
+	uid_data.expand = expand;
 
-	if(api_type == API_OPENGL)
+	if(api_type == API_OPENGL && expand != VSEXPAND_NONE)
+	{
+		GenerateExpandedVertexLoader(out, components, expand);
+	}
+	else if(api_type == API_OPENGL)
 	{
 		out.Write("ATTRIN float4 rawpos; // ATTR%d,\n", SHADER_POSITION_ATTRIB);
 		if (components & VB_HAS_POSMTXIDX)
@@ -128,7 +282,10 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 			if ((components & (VB_HAS_UV0<<i)) || hastexmtx)
 				out.Write("ATTRIN float%d tex%d; // ATTR%d,\n", hastexmtx ? 3 : 2, i, SHADER_TEXTURE0_ATTRIB + i);
 		}
+	}
 
+	if(api_type == API_OPENGL)
+	{
 		// Let's set up attributes
 		for (size_t i = 0; i < 8; ++i)
 		{
@@ -145,6 +302,20 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 		out.Write("VARYOUT   float4 colors_12;\n");
 
 		out.Write("void main()\n{\n");
+
+		if (uid_data.multi_draw)
+			out.Write("draw_index_2 = DRAW_INDEX;\n");
+
+		if (expand == VSEXPAND_LINE)
+		{
+			out.Write("LoadVertex(gl_InstanceID * 2 + 1 - gl_VertexID / 2);\n"
+				"float4 other_pos = ProjectPosition();\n"
+				"LoadVertex(gl_InstanceID * 2 + gl_VertexID / 2);\n");
+		}
+		else if (expand == VSEXPAND_POINT)
+		{
+			out.Write("LoadVertex(gl_InstanceID);\n");
+		}
 	}
 	else // D3D
 	{
@@ -419,6 +590,9 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 		//seems to get rather complicated
 	}
 
+	if (expand != VSEXPAND_NONE)
+		GenerateExpansion(out, expand);
+
 	if(api_type == API_OPENGL)
 	{
 		// Bit ugly here
@@ -449,19 +623,28 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 
 #ifndef ANDROID
 		uselocale(old_locale); // restore locale
-		freelocale(locale);
 #endif
 	}
 }
 
-void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type)
+void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type, VS_EXPAND expand)
 {
-	GenerateVertexShader<VertexShaderUid>(object, components, api_type);
+	static LastShaderUid<VertexShaderUid> s_last_uids[VSEXPAND_POINT + 1];
+	LastShaderUid<VertexShaderUid>& last_uid = s_last_uids[expand];
+	if (last_uid.Matches(components, api_type))
+	{
+		object = last_uid.uid;
+		return;
+	}
+
+	GenerateVertexShader<VertexShaderUid>(object, components, api_type, expand);
+	object.CalculateHash();
+	last_uid.Set(object, components, api_type);
 }
 
-void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type)
+void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type, VS_EXPAND expand)
 {
-	GenerateVertexShader<VertexShaderCode>(object, components, api_type);
+	GenerateVertexShader<VertexShaderCode>(object, components, api_type, expand);
 }
 
 void GenerateVSOutputStructForGS(ShaderCode& object, API_TYPE api_type)
@@ -17,6 +17,7 @@
 #define SHADER_NORM2_ATTRIB     4
 #define SHADER_COLOR0_ATTRIB    5
 #define SHADER_COLOR1_ATTRIB    6
+#define SHADER_DRAWID_ATTRIB    7 // index of the draw in a multi-draw batch
 
 #define SHADER_TEXTURE0_ATTRIB  8
 #define SHADER_TEXTURE1_ATTRIB  9
@@ -40,6 +41,10 @@
 #define I_POSTTRANSFORMMATRICES "cpostmtx"
 #define I_DEPTHPARAMS           "cDepth" // farZ, zRange
 
+// Uniforms of vertex shaders which expand lines and points, outside of the block
+#define I_EXPANDLAYOUT          "cexpandlayout" // vertex stride, first vertex, first index; attribute offsets; tex coord sizes
+#define I_EXPANDPARAMS          "cexpandparams" // size, tex offset, viewport width and height; tex offset enables
+
 //TODO: get rid of them, they aren't used at all
 #define C_POSNORMALMATRIX        0
 #define C_PROJECTION            (C_POSNORMALMATRIX + 6)
@@ -52,6 +57,17 @@
 #define C_DEPTHPARAMS           (C_POSTTRANSFORMMATRICES + 64)
 #define C_VENVCONST_END			(C_DEPTHPARAMS + 1)
 
+// Lines and points can be drawn as quads built by the vertex shader, one
+// instance per primitive. The shader then reads the vertices from buffer
+// textures over the vertex and index streams instead of from attributes.
+// Only supported by the OpenGL backend, D3D does it in a geometry shader.
+enum VS_EXPAND
+{
+	VSEXPAND_NONE = 0,
+	VSEXPAND_LINE,
+	VSEXPAND_POINT,
+};
+
 #pragma pack(1)
 
 struct vertex_shader_uid_data
@@ -63,9 +79,11 @@ struct vertex_shader_uid_data
 	u32 numColorChans        : 2;
 	u32 dualTexTrans_enabled : 1;
 	u32 pixel_lighting       : 1;
-	u32 pad0                 : 1;
+	u32 multi_draw           : 1;
 
 	u32 texMtxInfo_n_projection : 16; // Stored separately to guarantee that the texMtxInfo struct is 8 bits wide
+	u32 expand                  : 2;
+	u32 pad1                    : 14;
 	struct {
 		u32 inputform         : 2;
 		u32 texgentype        : 3;
@@ -87,6 +105,6 @@ struct vertex_shader_uid_data
 typedef ShaderUid<vertex_shader_uid_data> VertexShaderUid;
 typedef ShaderCode VertexShaderCode; // TODO: Obsolete..
 
-void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type);
-void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type);
+void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type, VS_EXPAND expand = VSEXPAND_NONE);
+void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type, VS_EXPAND expand = VSEXPAND_NONE);
 void GenerateVSOutputStructForGS(ShaderCode& object, API_TYPE api_type);
@@ -180,6 +180,7 @@ void VertexShaderManager::Init()
 
 	memset(&xfregs, 0, sizeof(xfregs));
 	memset(xfmem, 0, sizeof(xfmem));
+	InvalidateShaderUids();
 	memset(&constants, 0 , sizeof(constants));
 	ResetView();
 
@@ -101,6 +101,9 @@ public:
 	virtual bool Video_Screenshot(const char* filename) = 0;
 
 	virtual void Video_SetRendering(bool bEnabled) = 0;
+	// Unlike Video_SetRendering, this keeps the EFB emulated and only skips
+	// putting the frames on screen
+	virtual void Video_SetPresenting(bool bEnabled) = 0;
 
 	virtual void Video_GatherPipeBursted() = 0;
 
@@ -151,6 +154,7 @@ class VideoBackendHardware : public VideoBackend
 	bool Video_Screenshot(const char* filename);
 
 	void Video_SetRendering(bool bEnabled);
+	void Video_SetPresenting(bool bEnabled);
 
 	void Video_GatherPipeBursted();
 
@@ -13,6 +13,7 @@
 #include "Movie.h"
 #include "OnScreenDisplay.h"
 #include "ConfigManager.h"
+#include "ShaderGenCommon.h"
 
 VideoConfig g_Config;
 VideoConfig g_ActiveConfig;
@@ -22,6 +23,7 @@ void UpdateActiveConfig()
 	if (Movie::IsPlayingInput() && Movie::IsConfigSaved())
 		Movie::SetGraphicsConfig();
 	g_ActiveConfig = g_Config;
+	InvalidateShaderUids();
 }
 
 VideoConfig::VideoConfig()
@@ -45,6 +47,7 @@ void VideoConfig::Load(const char *ini_file)
 	iniFile.Load(ini_file);
 
 	iniFile.Get("Hardware", "VSync", &bVSync, 0); // Hardware
+	iniFile.Get("Hardware", "MaxPrerenderedFrames", &iMaxPrerenderedFrames, 0);
 	iniFile.Get("Settings", "wideScreenHack", &bWidescreenHack, false);
 	iniFile.Get("Settings", "AspectRatio", &iAspectRatio, (int)ASPECT_AUTO);
 	iniFile.Get("Settings", "Crop", &bCrop, false);
@@ -53,6 +56,7 @@ void VideoConfig::Load(const char *ini_file)
 	iniFile.Get("Settings", "SafeTextureCacheColorSamples", &iSafeTextureCache_ColorSamples,128);
 	iniFile.Get("Settings", "ShowFPS", &bShowFPS, false); // Settings
 	iniFile.Get("Settings", "LogFPSToFile", &bLogFPSToFile, false);
+	iniFile.Get("Settings", "ShowFrameTimes", &bShowFrameTimes, false);
 	iniFile.Get("Settings", "ShowInputDisplay", &bShowInputDisplay, false);
 	iniFile.Get("Settings", "OverlayStats", &bOverlayStats, false);
 	iniFile.Get("Settings", "OverlayProjStats", &bOverlayProjStats, false);
@@ -60,6 +64,8 @@ void VideoConfig::Load(const char *ini_file)
 	iniFile.Get("Settings", "DLOptimize", &iCompileDLsLevel, 0);
 	iniFile.Get("Settings", "DumpTextures", &bDumpTextures, 0);
 	iniFile.Get("Settings", "HiresTextures", &bHiresTextures, 0);
+	iniFile.Get("Settings", "CacheHiresTextures", &bCacheHiresTextures, 0);
+	iniFile.Get("Settings", "PNGCompressionLevel", &iPNGCompressionLevel, 6);
 	iniFile.Get("Settings", "DumpEFBTarget", &bDumpEFBTarget, 0);
 	iniFile.Get("Settings", "DumpFrames", &bDumpFrames, 0);
 	iniFile.Get("Settings", "FreeLook", &bFreeLook, 0);
@@ -72,6 +78,8 @@ void VideoConfig::Load(const char *ini_file)
 
 	iniFile.Get("Settings", "MSAA", &iMultisampleMode, 0);
 	iniFile.Get("Settings", "EFBScale", &iEFBScale, (int) SCALE_1X); // native
+	iniFile.Get("Settings", "DynamicResolutionMin", &iDynamicResolutionMin, 100);
+	iniFile.Get("Settings", "DynamicResolutionMax", &iDynamicResolutionMax, 300);
 
 	iniFile.Get("Settings", "DstAlphaPass", &bDstAlphaPass, false);
 
@@ -81,8 +89,10 @@ void VideoConfig::Load(const char *ini_file)
 	iniFile.Get("Settings", "DisableFog", &bDisableFog, 0);
 
 	iniFile.Get("Settings", "OMPDecoder", &bOMPDecoder, false);
+	iniFile.Get("Settings", "ThreadedTextureDecoding", &bThreadedTextureDecoding, false);
 
 	iniFile.Get("Settings", "EnableShaderDebugging", &bEnableShaderDebugging, false);
+	iniFile.Get("Settings", "BackgroundShaderCompiling", &bBackgroundShaderCompiling, false);
 
 	iniFile.Get("Enhancements", "ForceFiltering", &bForceFiltering, 0);
 	iniFile.Get("Enhancements", "MaxAnisotropy", &iMaxAnisotropy, 0);  // NOTE - this is x in (1 << x)
@@ -94,7 +104,15 @@ void VideoConfig::Load(const char *ini_file)
 	iniFile.Get("Hacks", "EFBToTextureEnable", &bCopyEFBToTexture, true);
 	iniFile.Get("Hacks", "EFBScaledCopy", &bCopyEFBScaled, true);
 	iniFile.Get("Hacks", "EFBCopyCacheEnable", &bEFBCopyCacheEnable, false);
+	iniFile.Get("Hacks", "EFBCopyReadbackAsync", &bEFBCopyReadbackAsync, false);
 	iniFile.Get("Hacks", "EFBEmulateFormatChanges", &bEFBEmulateFormatChanges, false);
+	iniFile.Get("Hacks", "PerfQueriesAsync", &bPerfQueriesAsync, true);
+	iniFile.Get("Hacks", "CacheDisplayListVertices", &bCacheDisplayListVertices, true);
+	iniFile.Get("Hacks", "CacheDisplayLists", &bCacheDisplayLists, true);
+	iniFile.Get("Hacks", "GPUTextureDecoding", &bGPUTextureDecoding, false);
+	iniFile.Get("Hacks", "TextureCacheBudget", &iTextureCacheBudget, 0);
+	iniFile.Get("Hacks", "MultiDraw", &bMultiDraw, false);
+	iniFile.Get("Hacks", "DeferredContexts", &bDeferredContexts, false);
 
 	iniFile.Get("Hardware", "Adapter", &iAdapter, 0);
 
@@ -136,6 +154,7 @@ void VideoConfig::GameIniLoad()
 	IniFile iniFile = SConfig::GetInstance().m_LocalCoreStartupParameter.LoadGameIni();
 
 	CHECK_SETTING("Video_Hardware", "VSync", bVSync);
+	CHECK_SETTING("Video_Hardware", "MaxPrerenderedFrames", iMaxPrerenderedFrames);
 
 	CHECK_SETTING("Video_Settings", "wideScreenHack", bWidescreenHack);
 	CHECK_SETTING("Video_Settings", "AspectRatio", iAspectRatio);
@@ -181,6 +200,8 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Settings", "DstAlphaPass", bDstAlphaPass);
 	CHECK_SETTING("Video_Settings", "DisableFog", bDisableFog);
 	CHECK_SETTING("Video_Settings", "OMPDecoder", bOMPDecoder);
+	CHECK_SETTING("Video_Settings", "ThreadedTextureDecoding", bThreadedTextureDecoding);
+	CHECK_SETTING("Video_Settings", "BackgroundShaderCompiling", bBackgroundShaderCompiling);
 
 	CHECK_SETTING("Video_Enhancements", "ForceFiltering", bForceFiltering);
 	CHECK_SETTING("Video_Enhancements", "MaxAnisotropy", iMaxAnisotropy);  // NOTE - this is x in (1 << x)
@@ -192,6 +213,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Hacks", "EFBToTextureEnable", bCopyEFBToTexture);
 	CHECK_SETTING("Video_Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	CHECK_SETTING("Video_Hacks", "EFBCopyCacheEnable", bEFBCopyCacheEnable);
+	CHECK_SETTING("Video_Hacks", "EFBCopyReadbackAsync", bEFBCopyReadbackAsync);
 	CHECK_SETTING("Video_Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
 
 	CHECK_SETTING("Video", "ProjectionHack", iPhackvalue[0]);
@@ -202,6 +224,13 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video", "PH_ZFar", sPhackvalue[1]);
 	CHECK_SETTING("Video", "UseBBox", bUseBBox);
 	CHECK_SETTING("Video", "PerfQueriesEnable", bPerfQueriesEnable);
+	CHECK_SETTING("Video_Hacks", "PerfQueriesAsync", bPerfQueriesAsync);
+	CHECK_SETTING("Video_Hacks", "CacheDisplayListVertices", bCacheDisplayListVertices);
+	CHECK_SETTING("Video_Hacks", "CacheDisplayLists", bCacheDisplayLists);
+	CHECK_SETTING("Video_Hacks", "GPUTextureDecoding", bGPUTextureDecoding);
+	CHECK_SETTING("Video_Hacks", "TextureCacheBudget", iTextureCacheBudget);
+	CHECK_SETTING("Video_Hacks", "MultiDraw", bMultiDraw);
+	CHECK_SETTING("Video_Hacks", "DeferredContexts", bDeferredContexts);
 
 	if (gfx_override_exists)
 		OSD::AddMessage("Warning: Opening the graphics configuration will reset settings and might cause issues!", 10000);
@@ -212,6 +241,7 @@ void VideoConfig::VerifyValidity()
 	// TODO: Check iMaxAnisotropy value
 	if (iAdapter < 0 || iAdapter > ((int)backend_info.Adapters.size() - 1)) iAdapter = 0;
 	if (iMultisampleMode < 0 || iMultisampleMode >= (int)backend_info.AAModes.size()) iMultisampleMode = 0;
+	if (iMaxPrerenderedFrames < 0) iMaxPrerenderedFrames = 0;
 	if (!backend_info.bSupports3DVision) b3DVision = false;
 	if (!backend_info.bSupportsFormatReinterpretation) bEFBEmulateFormatChanges = false;
 	if (!backend_info.bSupportsPixelLighting) bEnablePixelLighting = false;
@@ -222,6 +252,7 @@ void VideoConfig::Save(const char *ini_file)
 	IniFile iniFile;
 	iniFile.Load(ini_file);
 	iniFile.Set("Hardware", "VSync", bVSync);
+	iniFile.Set("Hardware", "MaxPrerenderedFrames", iMaxPrerenderedFrames);
 	iniFile.Set("Settings", "AspectRatio", iAspectRatio);
 	iniFile.Set("Settings", "Crop", bCrop);
 	iniFile.Set("Settings", "wideScreenHack", bWidescreenHack);
@@ -230,6 +261,7 @@ void VideoConfig::Save(const char *ini_file)
 	iniFile.Set("Settings", "SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
 	iniFile.Set("Settings", "ShowFPS", bShowFPS);
 	iniFile.Set("Settings", "LogFPSToFile", bLogFPSToFile);
+	iniFile.Set("Settings", "ShowFrameTimes", bShowFrameTimes);
 	iniFile.Set("Settings", "ShowInputDisplay", bShowInputDisplay);
 	iniFile.Set("Settings", "OverlayStats", bOverlayStats);
 	iniFile.Set("Settings", "OverlayProjStats", bOverlayProjStats);
@@ -237,6 +269,8 @@ void VideoConfig::Save(const char *ini_file)
 	iniFile.Set("Settings", "Show", iCompileDLsLevel);
 	iniFile.Set("Settings", "DumpTextures", bDumpTextures);
 	iniFile.Set("Settings", "HiresTextures", bHiresTextures);
+	iniFile.Set("Settings", "CacheHiresTextures", bCacheHiresTextures);
+	iniFile.Set("Settings", "PNGCompressionLevel", iPNGCompressionLevel);
 	iniFile.Set("Settings", "DumpEFBTarget", bDumpEFBTarget);
 	iniFile.Set("Settings", "DumpFrames", bDumpFrames);
 	iniFile.Set("Settings", "FreeLook", bFreeLook);
@@ -250,6 +284,8 @@ void VideoConfig::Save(const char *ini_file)
 	iniFile.Set("Settings", "ShowEFBCopyRegions", bShowEFBCopyRegions);
 	iniFile.Set("Settings", "MSAA", iMultisampleMode);
 	iniFile.Set("Settings", "EFBScale", iEFBScale);
+	iniFile.Set("Settings", "DynamicResolutionMin", iDynamicResolutionMin);
+	iniFile.Set("Settings", "DynamicResolutionMax", iDynamicResolutionMax);
 	iniFile.Set("Settings", "TexFmtOverlayEnable", bTexFmtOverlayEnable);
 	iniFile.Set("Settings", "TexFmtOverlayCenter", bTexFmtOverlayCenter);
 	iniFile.Set("Settings", "Wireframe", bWireFrame);
@@ -257,8 +293,10 @@ void VideoConfig::Save(const char *ini_file)
 	iniFile.Set("Settings", "DisableFog", bDisableFog);
 
 	iniFile.Set("Settings", "OMPDecoder", bOMPDecoder);
+	iniFile.Set("Settings", "ThreadedTextureDecoding", bThreadedTextureDecoding);
 
 	iniFile.Set("Settings", "EnableShaderDebugging", bEnableShaderDebugging);
+	iniFile.Set("Settings", "BackgroundShaderCompiling", bBackgroundShaderCompiling);
 
 	iniFile.Set("Enhancements", "ForceFiltering", bForceFiltering);
 	iniFile.Set("Enhancements", "MaxAnisotropy", iMaxAnisotropy);
@@ -270,7 +308,15 @@ void VideoConfig::Save(const char *ini_file)
 	iniFile.Set("Hacks", "EFBToTextureEnable", bCopyEFBToTexture);
 	iniFile.Set("Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	iniFile.Set("Hacks", "EFBCopyCacheEnable", bEFBCopyCacheEnable);
+	iniFile.Set("Hacks", "EFBCopyReadbackAsync", bEFBCopyReadbackAsync);
 	iniFile.Set("Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
+	iniFile.Set("Hacks", "PerfQueriesAsync", bPerfQueriesAsync);
+	iniFile.Set("Hacks", "CacheDisplayListVertices", bCacheDisplayListVertices);
+	iniFile.Set("Hacks", "CacheDisplayLists", bCacheDisplayLists);
+	iniFile.Set("Hacks", "GPUTextureDecoding", bGPUTextureDecoding);
+	iniFile.Set("Hacks", "TextureCacheBudget", iTextureCacheBudget);
+	iniFile.Set("Hacks", "MultiDraw", bMultiDraw);
+	iniFile.Set("Hacks", "DeferredContexts", bDeferredContexts);
 
 	iniFile.Set("Hardware", "Adapter", iAdapter);
 
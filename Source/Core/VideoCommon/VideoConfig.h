@@ -42,6 +42,7 @@ enum EFBScale
 	SCALE_2_5X,
 	SCALE_3X,
 	SCALE_4X,
+	SCALE_DYNAMIC, // follows the GPU frame time, see DynamicResolution.h
 };
 
 class IniFile;
@@ -59,6 +60,7 @@ struct VideoConfig
 
 	// General
 	bool bVSync;
+	int iMaxPrerenderedFrames; // 0 leaves it to the driver
 
 	bool bRunning;
 	bool bWidescreenHack;
@@ -69,10 +71,13 @@ struct VideoConfig
 
 	// OpenMP
 	bool bOMPDecoder;
+	bool bThreadedTextureDecoding; // split large textures over a few decoder threads
 
 	// Enhancements
 	int iMultisampleMode;
 	int iEFBScale;
+	int iDynamicResolutionMin; // percent of the native resolution, for SCALE_DYNAMIC
+	int iDynamicResolutionMax;
 	bool bForceFiltering;
 	int iMaxAnisotropy;
 	std::string sPostProcessingShader;
@@ -86,6 +91,7 @@ struct VideoConfig
 	bool bTexFmtOverlayCenter;
 	bool bShowEFBCopyRegions;
 	bool bLogFPSToFile;
+	bool bShowFrameTimes;
 
 	// Render
 	bool bWireFrame;
@@ -95,6 +101,8 @@ struct VideoConfig
 	// Utility
 	bool bDumpTextures;
 	bool bHiresTextures;
+	bool bCacheHiresTextures;
+	int iPNGCompressionLevel;
 	bool bDumpEFBTarget;
 	bool bDumpFrames;
 	bool bUseFFV1;
@@ -107,9 +115,17 @@ struct VideoConfig
 	// Hacks
 	bool bEFBAccessEnable;
 	bool bPerfQueriesEnable;
+	bool bPerfQueriesAsync;
+	bool bCacheDisplayListVertices;
+	bool bCacheDisplayLists;
+	bool bGPUTextureDecoding;
+	int iTextureCacheBudget; // MiB of video memory for cached textures, 0 for no limit
+	bool bMultiDraw;
+	bool bDeferredContexts; // D3D only, read when the device is created
 
 	bool bEFBCopyEnable;
 	bool bEFBCopyCacheEnable;
+	bool bEFBCopyReadbackAsync;
 	bool bEFBEmulateFormatChanges;
 	bool bCopyEFBToTexture;
 	bool bCopyEFBScaled;
@@ -132,6 +148,9 @@ struct VideoConfig
 	// Debugging
 	bool bEnableShaderDebugging;
 
+	// Compile shaders on a worker thread, skipping draws until they're ready
+	bool bBackgroundShaderCompiling;
+
 	// Static config per API
 	// TODO: Move this out of VideoConfig
 	struct
@@ -153,6 +172,8 @@ struct VideoConfig
 		bool bSupportsOversizedViewports;
 		bool bSupportsEarlyZ; // needed by PixelShaderGen, so must stay in VideoCommon
 		bool bSupportShadingLanguage420pack; // needed by ShaderGen, so must stay in VideoCommon
+		bool bSupportsBBox; // needed by PixelShaderGen and the vertex loaders, so must stay in VideoCommon
+		bool bSupportsMultiDraw; // needed by ShaderGen and VertexManager, so must stay in VideoCommon
 	} backend_info;
 
 	// Utility
@@ -160,6 +181,9 @@ struct VideoConfig
 	bool VirtualXFBEnabled() const { return bUseXFB && !bUseRealXFB; }
 	bool EFBCopiesToTextureEnabled() const { return bEFBCopyEnable && bCopyEFBToTexture; }
 	bool EFBCopiesToRamEnabled() const { return bEFBCopyEnable && !bCopyEFBToTexture; }
+	bool CPUBBoxEnabled() const { return bUseBBox && !backend_info.bSupportsBBox; }
+	bool GPUBBoxEnabled() const { return bUseBBox && backend_info.bSupportsBBox; }
+	bool MultiDrawEnabled() const { return bMultiDraw && backend_info.bSupportsMultiDraw; }
 };
 
 extern VideoConfig g_Config;
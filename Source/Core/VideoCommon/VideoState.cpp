@@ -12,6 +12,7 @@
 #include "CommandProcessor.h"
 #include "PixelEngine.h"
 #include "PixelShaderManager.h"
+#include "ShaderGenCommon.h"
 #include "VertexShaderManager.h"
 #include "VertexManagerBase.h"
 
@@ -35,8 +36,10 @@ static void DoState(PointerWrap &p)
 	p.DoArray(xfmem, XFMEM_SIZE);
 	p.DoMarker("XF Memory");
 
+	InvalidateShaderUids();
+
 	// Texture decoder
-	p.DoArray(texMem, TMEM_SIZE);
+	p.DoRegion(texMem, TMEM_SIZE);
 	p.DoMarker("texMem");
 
 	// FIFO
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common.h"
 #include "VideoCommon.h"
 #include "XFMemory.h"
@@ -9,11 +11,20 @@
 #include "VertexManagerBase.h"
 #include "VertexShaderManager.h"
 #include "PixelShaderManager.h"
+#include "ShaderGenCommon.h"
 #include "HW/Memmap.h"
 
+// True if the values differ from the registers starting at address, so that a
+// rewrite of the same viewport or matrix info doesn't break the current batch.
+static bool XFRegsChanged(u32 address, const u32* pData, int count)
+{
+	return memcmp((u32*)&xfregs + (address - 0x1000), pData, count * sizeof(u32)) != 0;
+}
+
+// XF memory only holds matrices and lights, which end up in the shader constants
 void XFMemWritten(u32 transferSize, u32 baseAddress)
 {
-	VertexManager::Flush();
+	VertexManager::Flush(true);
 	VertexShaderManager::InvalidateXFRange(baseAddress, baseAddress + transferSize);
 	PixelShaderManager::InvalidateXFRange(baseAddress, baseAddress + transferSize);
 }
@@ -108,9 +119,12 @@ void XFRegWritten(int transferSize, u32 baseAddress, u32 *pData)
 		case XFMEM_SETVIEWPORT+3:
 		case XFMEM_SETVIEWPORT+4:
 		case XFMEM_SETVIEWPORT+5:
-			VertexManager::Flush();
-			VertexShaderManager::SetViewportChanged();
-			PixelShaderManager::SetViewportChanged();
+			if (XFRegsChanged(address, &pData[dataIndex], std::min(XFMEM_SETVIEWPORT + 6 - (int)address, transferSize)))
+			{
+				VertexManager::Flush();
+				VertexShaderManager::SetViewportChanged();
+				PixelShaderManager::SetViewportChanged();
+			}
 
 			nextAddress = XFMEM_SETVIEWPORT + 6;
 			break;
@@ -122,8 +136,11 @@ void XFRegWritten(int transferSize, u32 baseAddress, u32 *pData)
 		case XFMEM_SETPROJECTION+4:
 		case XFMEM_SETPROJECTION+5:
 		case XFMEM_SETPROJECTION+6:
-			VertexManager::Flush();
-			VertexShaderManager::SetProjectionChanged();
+			if (XFRegsChanged(address, &pData[dataIndex], std::min(XFMEM_SETPROJECTION + 7 - (int)address, transferSize)))
+			{
+				VertexManager::Flush();
+				VertexShaderManager::SetProjectionChanged();
+			}
 
 			nextAddress = XFMEM_SETPROJECTION + 7;
 			break;
@@ -141,7 +158,8 @@ void XFRegWritten(int transferSize, u32 baseAddress, u32 *pData)
 		case XFMEM_SETTEXMTXINFO+5:
 		case XFMEM_SETTEXMTXINFO+6:
 		case XFMEM_SETTEXMTXINFO+7:
-			VertexManager::Flush();
+			if (XFRegsChanged(address, &pData[dataIndex], std::min(XFMEM_SETTEXMTXINFO + 8 - (int)address, transferSize)))
+				VertexManager::Flush();
 
 			nextAddress = XFMEM_SETTEXMTXINFO + 8;
 			break;
@@ -154,7 +172,8 @@ void XFRegWritten(int transferSize, u32 baseAddress, u32 *pData)
 		case XFMEM_SETPOSMTXINFO+5:
 		case XFMEM_SETPOSMTXINFO+6:
 		case XFMEM_SETPOSMTXINFO+7:
-			VertexManager::Flush();
+			if (XFRegsChanged(address, &pData[dataIndex], std::min(XFMEM_SETPOSMTXINFO + 8 - (int)address, transferSize)))
+				VertexManager::Flush();
 
 			nextAddress = XFMEM_SETPOSMTXINFO + 8;
 			break;
@@ -227,8 +246,12 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 			transferSize = 0;
 		}
 
-		XFMemWritten(xfMemTransferSize, xfMemBase);
-		memcpy_gc(&xfmem[xfMemBase], pData, xfMemTransferSize * 4);
+		// Games reload the same matrices all the time
+		if (memcmp(&xfmem[xfMemBase], pData, xfMemTransferSize * 4))
+		{
+			XFMemWritten(xfMemTransferSize, xfMemBase);
+			memcpy_gc(&xfmem[xfMemBase], pData, xfMemTransferSize * 4);
+		}
 
 		pData += xfMemTransferSize;
 	}
@@ -236,6 +259,15 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 	// write to XF regs
 	if (transferSize > 0)
 	{
+		for (u32 i = 0; i < transferSize; ++i)
+		{
+			const u32 index = baseAddress - 0x1000 + i;
+			if (IsShaderUidXFReg(index) && ((u32*)&xfregs)[index] != pData[i])
+			{
+				InvalidateShaderUids();
+				break;
+			}
+		}
 		XFRegWritten(transferSize, baseAddress, pData);
 		memcpy_gc((u32*)(&xfregs) + (baseAddress - 0x1000), pData, transferSize * 4);
 	}
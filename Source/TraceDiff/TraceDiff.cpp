@@ -0,0 +1,231 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Compares two CPU traces from Tracer, like one of the JIT and one of the
+// interpreter, and shows where they first differ.
+//
+// The traces don't have to record at the same points: the interpreter's has
+// every instruction, the JIT's only the blocks it ran. Entries are lined up
+// on their PC, skipping the ones only the other trace has, and the states
+// compared wherever both have one. Both runs have to see the same input and
+// interrupt timing, or they part ways at the first interrupt.
+//
+// As the oldest entries are dropped from a full trace, the two usually don't
+// start at the same point. They start from the first state both have, with
+// all the registers the same.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include "Common.h"
+#include "FlatHashMap.h"
+#include "Hash.h"
+#include "TraceFile.h"
+
+using namespace Tracer;
+
+// How far ahead to look for the other trace's next PC
+static size_t s_window = 0x4000;
+
+static bool SameState(const State& a, const State& b)
+{
+	return a.pc == b.pc && !memcmp(a.regs, b.regs, sizeof(a.regs));
+}
+
+static u64 HashState(const State& state)
+{
+	StripeHash64 hash(state.pc);
+	hash.Update(state.regs, sizeof(state.regs));
+	return hash.Finish();
+}
+
+class TraceStream
+{
+public:
+	// Can be called again to start over
+	bool Open(const char* filename)
+	{
+		m_states.clear();
+		m_indices.clear();
+		return m_reader.Open(filename);
+	}
+
+	// Makes sure there are at least count states buffered, unless the trace
+	// ends before
+	bool Fill(size_t count)
+	{
+		while (m_states.size() < count)
+		{
+			State state;
+			if (!m_reader.Next(&state))
+				return false;
+			m_states.push_back(state);
+			m_indices.push_back(m_reader.GetEntryIndex());
+		}
+		return true;
+	}
+
+	// Position of the first state with the PC, or -1
+	ptrdiff_t Find(u32 pc)
+	{
+		for (size_t i = 0; i < s_window; i++)
+		{
+			if (!Fill(i + 1))
+				break;
+			if (m_states[i].pc == pc)
+				return i;
+		}
+		return -1;
+	}
+
+	void Drop(size_t count)
+	{
+		m_states.erase(m_states.begin(), m_states.begin() + count);
+		m_indices.erase(m_indices.begin(), m_indices.begin() + count);
+	}
+
+	// Drops states until the front one is one of the first window states of
+	// the other trace. Returns the position in the other trace, or -1 if it
+	// isn't found, with all of this trace read.
+	ptrdiff_t SyncTo(TraceStream& other)
+	{
+		other.Fill(s_window);
+		FlatHashMap<u64, u32> positions;
+		for (size_t i = other.m_states.size(); i-- > 0;)
+			positions[HashState(other.m_states[i])] = (u32)i + 1;
+
+		while (Fill(1))
+		{
+			const u32* position = positions.Find(HashState(Front()));
+			if (position && SameState(Front(), other.m_states[*position - 1]))
+				return *position - 1;
+			Drop(1);
+		}
+		return -1;
+	}
+
+	const State& Front() const { return m_states.front(); }
+	u64 FrontIndex() const { return m_indices.front(); }
+
+	void PrintNext(const char* name, size_t count)
+	{
+		Fill(count);
+		printf("Next PCs in %s:", name);
+		for (size_t i = 0; i < count && i < m_states.size(); i++)
+			printf(" %08x", m_states[i].pc);
+		printf("\n");
+	}
+
+private:
+	TraceReader m_reader;
+	std::deque<State> m_states;
+	std::deque<u64> m_indices;
+};
+
+int main(int argc, char** argv)
+{
+	int arg = 1;
+	if (arg + 1 < argc && !strcmp(argv[arg], "-w"))
+	{
+		s_window = strtoul(argv[arg + 1], NULL, 0);
+		arg += 2;
+	}
+	if (argc - arg != 2 || s_window == 0)
+	{
+		printf("Usage: %s [-w window] a.trace b.trace\n", argv[0]);
+		return 2;
+	}
+
+	const char* names[2] = { argv[arg], argv[arg + 1] };
+	TraceStream traces[2];
+	for (int i = 0; i < 2; i++)
+	{
+		if (!traces[i].Open(names[i]))
+		{
+			printf("Can't read %s\n", names[i]);
+			return 2;
+		}
+	}
+
+	// The trace that started later has its start in the other one, unless one
+	// ended before the other started
+	const ptrdiff_t start_a = traces[1].SyncTo(traces[0]);
+	if (start_a >= 0)
+	{
+		traces[0].Drop(start_a);
+	}
+	else
+	{
+		traces[1].Open(names[1]);
+		const ptrdiff_t start_b = traces[0].SyncTo(traces[1]);
+		if (start_b < 0)
+		{
+			printf("The traces have no state in common to start from\n");
+			return 1;
+		}
+		traces[1].Drop(start_b);
+	}
+
+	u64 matched = 0;
+	bool have_last = false;
+	u32 last_pc = 0;
+	while (traces[0].Fill(1) && traces[1].Fill(1))
+	{
+		const State& a = traces[0].Front();
+		const State& b = traces[1].Front();
+		if (a.pc != b.pc)
+		{
+			// Skip whatever the closer match is in
+			const ptrdiff_t skip_b = traces[1].Find(a.pc);
+			const ptrdiff_t skip_a = traces[0].Find(b.pc);
+			if (skip_a < 0 && skip_b < 0)
+			{
+				printf("Control flow differs after %llu matching states", (unsigned long long)matched);
+				if (have_last)
+					printf(", last common PC %08x", last_pc);
+				printf("\n");
+				traces[0].PrintNext(names[0], 8);
+				traces[1].PrintNext(names[1], 8);
+				return 1;
+			}
+			if (skip_b >= 0 && (skip_a < 0 || skip_b <= skip_a))
+				traces[1].Drop(skip_b);
+			else
+				traces[0].Drop(skip_a);
+			continue;
+		}
+
+		bool differs = false;
+		for (int slot = 0; slot < NUM_SLOTS; slot++)
+		{
+			if (a.regs[slot] == b.regs[slot])
+				continue;
+			if (!differs)
+			{
+				printf("States differ at PC %08x (entry %llu of %s, %llu of %s)",
+					a.pc, (unsigned long long)traces[0].FrontIndex(), names[0],
+					(unsigned long long)traces[1].FrontIndex(), names[1]);
+				if (have_last)
+					printf(", code since %08x", last_pc);
+				printf(":\n");
+				differs = true;
+			}
+			printf("  %-6s %s  %s\n", GetSlotName(slot).c_str(),
+				FormatSlotValue(slot, a.regs[slot]).c_str(), FormatSlotValue(slot, b.regs[slot]).c_str());
+		}
+		if (differs)
+			return 1;
+
+		have_last = true;
+		last_pc = a.pc;
+		matched++;
+		traces[0].Drop(1);
+		traces[1].Drop(1);
+	}
+
+	printf("No differences in %llu matching states\n", (unsigned long long)matched);
+	return 0;
+}
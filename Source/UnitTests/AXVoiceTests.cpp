@@ -0,0 +1,180 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks that the vectorized AX voice kernels give the same results as the
+// sample by sample code they replaced.
+
+#include <cstdio>
+
+#include "HW/DSPHLE/UCodes/UCode_AX.h"
+
+#define AX_GC
+#include "HW/DSPHLE/UCodes/UCode_AX_Voice.h"
+
+extern int fail_count;
+
+static u32 s_seed = 0x12345678;
+
+static s16 RandomSample()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	const u32 r = s_seed >> 8;
+	// Make the extremes likely, that's where rounding goes wrong
+	switch (r & 7)
+	{
+	case 0: return 0x7FFF;
+	case 1: return -0x8000;
+	default: return (s16)(r >> 3);
+	}
+}
+
+static void Check(bool ok, const char* what, u32 param)
+{
+	if (!ok)
+	{
+		printf("FAIL (AXVoiceTests): %s differs from the scalar code (%08x)\n", what, param);
+		fail_count++;
+	}
+}
+
+static void RefMixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	u16 volume_delta = ramp ? pvol[1] : 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		s64 sample = input[i];
+		sample *= volume;
+		sample >>= 15;
+
+		out[i] += (s16)sample;
+		volume += volume_delta;
+
+		*dpop = (s16)sample;
+	}
+}
+
+static u32 RefResampleLinear(const s16* in, s16* output, u32 count, s16* last_samples, u32 curr_pos, u32 ratio)
+{
+	int read_samples_count = 0;
+	s16 temp[4];
+	u32 idx = 0;
+
+	temp[idx++ & 3] = last_samples[0];
+	temp[idx++ & 3] = last_samples[1];
+	temp[idx++ & 3] = last_samples[2];
+	temp[idx++ & 3] = last_samples[3];
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		curr_pos += ratio;
+		while (curr_pos >= 0x10000)
+		{
+			temp[idx++ & 3] = in[read_samples_count++];
+			curr_pos -= 0x10000;
+		}
+
+		u16 curr_frac = curr_pos & 0xFFFF;
+		u16 inv_curr_frac = -curr_frac;
+
+		s16 sample;
+		if (curr_frac)
+		{
+			s32 s0 = temp[idx++ & 3];
+			s32 s1 = temp[idx++ & 3];
+
+			sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
+			idx += 2;
+		}
+		else
+		{
+			sample = temp[idx++ & 3];
+			idx += 3;
+		}
+
+		output[i] = sample;
+	}
+
+	last_samples[3] = temp[--idx & 3];
+	last_samples[2] = temp[--idx & 3];
+	last_samples[1] = temp[--idx & 3];
+	last_samples[0] = temp[--idx & 3];
+
+	return curr_pos;
+}
+
+static void MixAddTests()
+{
+	static const u16 volumes[] = { 0x0000, 0x0001, 0x7FFF, 0x8000, 0xFFFF, 0x4321 };
+	static const u16 deltas[] = { 0x0000, 0x0001, 0xFFFF, 0x0123, 0xFEDC };
+	static const u32 counts[] = { 32, 18, 6, 13 };
+
+	for (u32 count : counts)
+	for (u16 volume : volumes)
+	for (u16 delta : deltas)
+	{
+		s16 input[MAX_SAMPLES_PER_FRAME];
+		int out[MAX_SAMPLES_PER_FRAME], ref_out[MAX_SAMPLES_PER_FRAME];
+		for (u32 i = 0; i < count; ++i)
+		{
+			input[i] = RandomSample();
+			out[i] = ref_out[i] = RandomSample() * 4;
+		}
+
+		u16 vol[2] = { volume, delta }, ref_vol[2] = { volume, delta };
+		s16 dpop = 0, ref_dpop = 0;
+		MixAdd(out, input, count, vol, &dpop, true);
+		RefMixAdd(ref_out, input, count, ref_vol, &ref_dpop, true);
+
+		Check(!memcmp(out, ref_out, count * sizeof (int)), "MixAdd output", volume << 16 | delta);
+		Check(vol[0] == ref_vol[0] && dpop == ref_dpop, "MixAdd state", volume << 16 | delta);
+
+		// Volume envelope, done in place
+		s16 env[MAX_SAMPLES_PER_FRAME], ref_env[MAX_SAMPLES_PER_FRAME];
+		u16 env_volume = volume, ref_env_volume = volume;
+		memcpy(env, input, sizeof (env));
+		ApplyVolumeRamp(env, env, count, env_volume, delta);
+		for (u32 i = 0; i < count; ++i)
+		{
+			ref_env[i] = ((s32)input[i] * ref_env_volume) >> 15;
+			ref_env_volume += (s16)delta;
+		}
+		Check(!memcmp(env, ref_env, count * sizeof (s16)) && env_volume == ref_env_volume,
+		      "volume envelope", volume << 16 | delta);
+	}
+}
+
+static void ResampleTests()
+{
+	static const u32 ratios[] = { 0x10000, 0x8000, 0x12345, 0x55555, 0x40000, 0x0001, 0xFFFF, 0x2F1A3 };
+	static const u32 counts[] = { 32, 18, 6, 5 };
+
+	for (u32 count : counts)
+	for (u32 ratio : ratios)
+	for (u32 start = 0; start < 0x10000; start += 0x3F01)
+	{
+		s16 input[MAX_SAMPLES_PER_FRAME * 8];
+		for (s16& sample : input)
+			sample = RandomSample();
+
+		s16 last[4], ref_last[4];
+		for (int i = 0; i < 4; ++i)
+			last[i] = ref_last[i] = RandomSample();
+
+		s16 out[MAX_SAMPLES_PER_FRAME], ref_out[MAX_SAMPLES_PER_FRAME];
+		u32 read = 0;
+		u32 pos = ResampleAudio([&](s16* samples, u32 n) { memcpy(samples, input + read, n * sizeof (s16)); read += n; },
+		                        out, count, last, start, ratio, SRCTYPE_LINEAR, nullptr);
+		u32 ref_pos = RefResampleLinear(input, ref_out, count, ref_last, start, ratio);
+
+		Check(!memcmp(out, ref_out, count * sizeof (s16)), "resampled output", ratio);
+		Check(pos == ref_pos && !memcmp(last, ref_last, sizeof (last)), "resampler state", ratio);
+	}
+}
+
+void AXVoiceTests()
+{
+	MixAddTests();
+	ResampleTests();
+}
@@ -1,4 +1,10 @@
+#include <vector>
+
 #include "DSPJitTester.h"
+#include "DSP/DSPAnalyzer.h"
+#include "DSP/DSPCachedInterpreter.h"
+
+extern int fail_count;
 
 void nx_dr()
 {
@@ -307,6 +313,57 @@ void nx_ld()
 	tester2.Report();
 }
 
+// A little ucode with loops, branches and a call, run through the interpreter
+// and the cached interpreter
+void cached_program()
+{
+	static const u16 program[] = {
+		0x009c, 0x0010, // LRI    $AC0.L, #0x0010
+		0x1005,         // LOOPI  #5
+		0x7700,         // INC    $AC1
+		0x1103, 0x0006, // BLOOPI #3, 0x0006
+		0x7600,         // INC    $AC0
+		0x7a00,         // DEC    $AC0
+		0x0294, 0x0007, // JNZ    0x0007
+		0x02bf, 0x000d, // CALL   0x000d
+		0x0021,         // HALT
+		0x7700,         // INC    $AC1
+		0x02df,         // RET
+	};
+
+	std::vector<u16> iram(DSP_IRAM_SIZE, 0x0021);
+	std::vector<u16> irom(DSP_IROM_SIZE, 0);
+	std::vector<u16> dram(DSP_DRAM_SIZE, 0);
+	std::copy(program, program + sizeof(program) / sizeof(program[0]), iram.begin());
+
+	SDSP start;
+	memset(&start, 0, sizeof(SDSP));
+	start.iram = iram.data();
+	start.irom = irom.data();
+	start.dram = dram.data();
+	g_dsp = start;
+	DSPAnalyzer::Analyze();
+
+	for (int i = 0; i < 1000 && !(g_dsp.cr & CR_HALT); i++)
+		DSPInterpreter::Step();
+	const SDSP int_dsp = g_dsp;
+
+	g_dsp = start;
+	DSPCachedInterpreter::ClearCache();
+	DSPCachedInterpreter::RunCycles(1000);
+	const SDSP cached_dsp = g_dsp;
+
+	memset(DSPAnalyzer::code_flags, 0, sizeof(DSPAnalyzer::code_flags));
+
+	const bool ok = int_dsp.pc == 0x000c && cached_dsp.pc == int_dsp.pc &&
+		cached_dsp.step_counter == int_dsp.step_counter &&
+		!memcmp(&cached_dsp.r, &int_dsp.r, sizeof(int_dsp.r)) &&
+		int_dsp.r.ac[1].l == 6 && int_dsp.r.ac[0].l == 0;
+	printf("cached interpreter program: %s, ran %d instructions\n", ok ? "passed" : "failed", (int)int_dsp.step_counter);
+	if (!ok)
+		fail_count++;
+}
+
 void AudioJitTests()
 {
 	DSPJitTester::Initialize();
@@ -337,6 +394,8 @@ void AudioJitTests()
 	nx_slm();
 	nx_slnm();
 	nx_ld();
+
+	cached_program();
 }
 
 //required to be able to link against DSPCore
@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include "DSPJitTester.h"
+#include "DSP/DSPCachedInterpreter.h"
 
 DSPJitTester::DSPJitTester(u16 opcode, u16 opcode_ext, bool verbose, bool only_failed)
 	: be_verbose(verbose), failed_only(only_failed), run_count(0), fail_count(0)
@@ -18,12 +21,24 @@ bool DSPJitTester::Test(SDSP dsp_settings)
 		DumpRegs(dsp_settings);
 	}
 
+	// The runs share the memory, every one has to start from what the
+	// interpreter got
+	std::vector<u16> dram;
+	if (dsp_settings.dram)
+		dram.assign(dsp_settings.dram, dsp_settings.dram + DSP_DRAM_SIZE);
+
 	last_input_dsp = dsp_settings;
 	last_int_dsp = RunInterpreter(dsp_settings);
+	if (!dram.empty())
+		std::copy(dram.begin(), dram.end(), dsp_settings.dram);
 	last_jit_dsp = RunJit(dsp_settings);
+	if (!dram.empty())
+		std::copy(dram.begin(), dram.end(), dsp_settings.dram);
+	last_cached_dsp = RunCached(dsp_settings);
 
 	run_count++;
-	bool success = AreEqual(last_int_dsp, last_jit_dsp);
+	bool success = AreEqual(last_int_dsp, last_jit_dsp, "jit");
+	success &= AreEqual(last_int_dsp, last_cached_dsp, "cached");
 	if (!success)
 		fail_count++;
 	return success;
@@ -49,6 +64,21 @@ SDSP DSPJitTester::RunJit(SDSP dsp_settings)
 
 	return g_dsp;
 }
+SDSP DSPJitTester::RunCached(SDSP dsp_settings)
+{
+	ResetInterpreter();
+	memcpy(&g_dsp, &dsp_settings, sizeof(SDSP));
+	// Run the instruction from IRAM like a ucode would
+	const u16 pc = g_dsp.pc &= DSP_IRAM_MASK;
+	const u16 old = g_dsp.iram[pc];
+	g_dsp.iram[pc] = instruction;
+	DSPCachedInterpreter::ClearIRAM();
+	DSPCachedInterpreter::RunCycles(1);
+	SDSP result = g_dsp;
+	result.iram[pc] = old;
+
+	return result;
+}
 void DSPJitTester::ResetInterpreter()
 {
 	for (int i=0; i < WRITEBACKLOGSIZE; i++)
@@ -156,7 +186,7 @@ static void SetRegister(SDSP &dsp, int reg, u16 val) {
 	}
 }
 
-bool DSPJitTester::AreEqual(SDSP& int_dsp, SDSP& jit_dsp)
+bool DSPJitTester::AreEqual(SDSP& int_dsp, SDSP& jit_dsp, const char* jit_name)
 {
 	bool equal = true;
 	for (int i = 0; i < DSP_REG_NUM; i++)
@@ -175,7 +205,7 @@ bool DSPJitTester::AreEqual(SDSP& int_dsp, SDSP& jit_dsp)
 			}
 			equal = false;
 			if (be_verbose || failed_only)
-				printf("\t%s: int = 0x%04x, jit = 0x%04x\n", regnames[i].name, GetRegister(int_dsp,i), GetRegister(jit_dsp, i));
+				printf("\t%s: int = 0x%04x, %s = 0x%04x\n", regnames[i].name, GetRegister(int_dsp,i), jit_name, GetRegister(jit_dsp, i));
 		}
 	}
 
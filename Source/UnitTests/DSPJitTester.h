@@ -42,6 +42,7 @@
 //
 // SDSP result = tester.RunInterpreter(dsp); //run int alone
 // SDSP result = tester.RunJit(dsp); //run jit alone
+// SDSP result = tester.RunCached(dsp); //run the cached interpreter alone, it is checked against int too
 //
 // == Examining results ==
 // When either verbose or only_failed is set to true, the tester will automatically report
@@ -79,6 +80,7 @@ class DSPJitTester
 	DSPEmitter jit;
 	SDSP last_int_dsp;
 	SDSP last_jit_dsp;
+	SDSP last_cached_dsp;
 	SDSP last_input_dsp;
 	bool be_verbose;
 	bool failed_only;
@@ -87,7 +89,7 @@ class DSPJitTester
 	char instruction_name[16];
 	TestDataList test_values;
 
-	bool AreEqual(SDSP&, SDSP&);
+	bool AreEqual(SDSP&, SDSP&, const char*);
 	int TestOne(TestDataIterator, SDSP&);
 	void DumpRegs(SDSP&);
 public:
@@ -99,10 +101,12 @@ public:
 	void AddTestData(u8 reg, u16 value);
 	SDSP RunInterpreter(SDSP);
 	SDSP RunJit(SDSP);
+	SDSP RunCached(SDSP);
 	void ResetInterpreter();
 	void ResetJit();
 	inline SDSP GetLastInterpreterDSP() { return last_int_dsp; }
 	inline SDSP GetLastJitDSP() { return last_jit_dsp; }
+	inline SDSP GetLastCachedDSP() { return last_cached_dsp; }
 	inline int GetRunCount() { return run_count; }
 	inline int GetFailCount() { return fail_count; }
 	inline const char* GetInstructionName() { return instruction_name; }
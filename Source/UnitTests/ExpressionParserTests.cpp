@@ -0,0 +1,115 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks the values read through control expressions, plain bindings,
+// flattened programs and the trees too deep to flatten.
+
+#include <cstdio>
+#include <string>
+
+#include "ControllerInterface/ExpressionParser.h"
+
+using namespace ciface::Core;
+using namespace ciface::ExpressionParser;
+
+extern int fail_count;
+
+namespace
+{
+
+class TestDevice : public Device
+{
+public:
+	class TestInput : public Input
+	{
+	public:
+		TestInput(const std::string& name) : state(0), m_name(name) {}
+		std::string GetName() const override { return m_name; }
+		ControlState GetState() const override { return state; }
+
+		ControlState state;
+
+	private:
+		std::string m_name;
+	};
+
+	TestDevice()
+	{
+		AddInput(a = new TestInput("A"));
+		AddInput(b = new TestInput("B"));
+		AddInput(c = new TestInput("C"));
+	}
+
+	std::string GetName() const override { return "Test"; }
+	int GetId() const override { return 0; }
+	std::string GetSource() const override { return "Test"; }
+	bool UpdateInput() override { return true; }
+	bool UpdateOutput() override { return true; }
+
+	TestInput* a;
+	TestInput* b;
+	TestInput* c;
+};
+
+class TestContainer : public DeviceContainer
+{
+public:
+	TestContainer() { m_devices.push_back(&device); }
+
+	TestDevice device;
+};
+
+}
+
+static void Check(Expression* expr, ControlState expected, const char* expression)
+{
+	const ControlState value = expr->GetValue();
+	if (value != expected)
+	{
+		printf("FAIL (ExpressionParserTests): %s gave %f, expected %f\n", expression, value, expected);
+		fail_count++;
+	}
+}
+
+void ExpressionParserTests()
+{
+	TestContainer container;
+	DeviceQualifier default_device;
+	default_device.FromDevice(&container.device);
+	ControlFinder finder(container, default_device, true);
+
+	container.device.a->state = 0.75f;
+	container.device.b->state = 0.5f;
+	container.device.c->state = 1.0f;
+
+	struct
+	{
+		const char* expression;
+		ControlState expected;
+	} const cases[] = {
+		{ "A", 0.75f },
+		{ "`B`", 0.5f },
+		{ "!`A`", 0.25f },
+		{ "`A` & `B`", 0.5f },
+		{ "`A` | `B`", 0.75f },
+		{ "`A` + `B`", 1.0f },
+		{ "`A` & !`C` | `B`", 0.5f },
+		{ "(`A` | `B`) & !(`A` & `B`)", 0.5f },
+		{ "`A` & (`B` | (`C` & (!`A` | (`B` & (`C` | (`A` & (`B` | (`C` & (`A` | (`B` &"
+		  " (`C` | (`A` & (`B` | (`C` & (`A` | (`B` & (`C` | `A`)))))))))))))))))", 0.5f },
+	};
+
+	for (const auto& test : cases)
+	{
+		Expression* expr;
+		if (ParseExpression(test.expression, finder, &expr) != EXPRESSION_PARSE_SUCCESS || !expr)
+		{
+			printf("FAIL (ExpressionParserTests): %s didn't parse\n", test.expression);
+			fail_count++;
+			continue;
+		}
+		Check(expr, test.expected, test.expression);
+		delete expr;
+	}
+}
@@ -0,0 +1,160 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks that every implementation of the stripe hash gives the same results,
+// whole and in pieces, and benchmarks the texture hashes on texture sizes.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Hash.h"
+#include "Timer.h"
+
+extern int fail_count;
+
+static u32 s_seed = 0x13572468;
+
+static u32 Random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void Check(bool ok, const char* what, u32 size)
+{
+	if (!ok)
+	{
+		printf("FAIL (HashTests): %s, size %u\n", what, size);
+		fail_count++;
+	}
+}
+
+static const StripeHashImpl s_impls[] = { STRIPE_HASH_SSE2, STRIPE_HASH_AVX2, STRIPE_HASH_NEON };
+static const char* const s_impl_names[] = { "SSE2", "AVX2", "NEON" };
+
+static void ImplTests(const std::vector<u8>& data)
+{
+	std::vector<u32> sizes;
+	for (u32 size = 0; size <= 300; size++)
+		sizes.push_back(size);
+	sizes.push_back(1024);
+	sizes.push_back(1025);
+	sizes.push_back(64 * 1024 + 17);
+
+	for (u32 size : sizes)
+	{
+		// Unaligned, and sampled
+		const u8* src = data.data() + 1;
+		SetStripeHashImpl(STRIPE_HASH_GENERIC);
+		const u64 reference = GetStripeHash64(src, size, 0);
+		const u64 sampled = GetStripeHash64(src, size, 3);
+		for (size_t i = 0; i < sizeof(s_impls) / sizeof(s_impls[0]); i++)
+		{
+			if (!SetStripeHashImpl(s_impls[i]))
+				continue;
+			Check(GetStripeHash64(src, size, 0) == reference, s_impl_names[i], size);
+			Check(GetStripeHash64(src, size, 3) == sampled, s_impl_names[i], size);
+		}
+	}
+	SetStripeHashImpl(STRIPE_HASH_BEST);
+}
+
+static void StreamTests(const std::vector<u8>& data)
+{
+	for (u32 size : { 0u, 5u, 64u, 100u, 1024u, 1088u, 5000u })
+	{
+		const u64 whole = GetStripeHash64(data.data(), size, 0);
+		StripeHash64 stream;
+		u32 pos = 0;
+		while (pos < size)
+		{
+			const u32 piece = std::min(size - pos, Random() % 150);
+			stream.Update(data.data() + pos, piece);
+			pos += piece;
+		}
+		Check(stream.Finish() == whole, "stream", size);
+
+		// Seeds and lengths give different hashes
+		Check(StripeHash64(1).Finish() != StripeHash64(2).Finish(), "seed", size);
+		if (size)
+			Check(GetStripeHash64(data.data(), size - 1, 0) != whole, "length", size);
+	}
+
+	// A changed bit in the zero padding of the last stripe would go unseen
+	// without the length
+	std::vector<u8> zeroes(128);
+	Check(GetStripeHash64(zeroes.data(), 65, 0) != GetStripeHash64(zeroes.data(), 66, 0), "padding", 65);
+	std::vector<u8> flipped(data.begin(), data.begin() + 4096);
+	flipped[2000] ^= 0x10;
+	Check(GetStripeHash64(flipped.data(), 4096, 0) != GetStripeHash64(data.data(), 4096, 0), "bit flip", 4096);
+}
+
+void HashTests()
+{
+	std::vector<u8> data(128 * 1024);
+	for (u8& byte : data)
+		byte = (u8)Random();
+
+	ImplTests(data);
+	StreamTests(data);
+}
+
+void HashBenchmark()
+{
+	// Texture sizes in bytes and how many of every 100 textures a game
+	// usually hashes at that size: lots of small UI and font textures, a
+	// few big ones
+	struct TextureSize { u32 size; u32 count; };
+	static const TextureSize sizes[] = {
+		{ 32, 10 }, { 512, 15 }, { 2048, 20 }, { 8192, 20 }, { 32768, 20 },
+		{ 131072, 10 }, { 524288, 4 }, { 2097152, 1 },
+	};
+
+	std::vector<u8> data(4 * 1024 * 1024);
+	for (u8& byte : data)
+		byte = (u8)Random();
+
+	struct HashFunc { const char* name; u64 (*func)(const u8*, int, u32); StripeHashImpl impl; };
+	static const HashFunc funcs[] = {
+#if _M_SSE >= 0x402
+		{ "CRC32", &GetCRC32, STRIPE_HASH_BEST },
+#endif
+		{ "Murmur3", &GetMurmurHash3, STRIPE_HASH_BEST },
+		{ "HiresTexture", &GetHashHiresTexture, STRIPE_HASH_BEST },
+		{ "Stripe generic", &GetStripeHash64, STRIPE_HASH_GENERIC },
+		{ "Stripe SSE2", &GetStripeHash64, STRIPE_HASH_SSE2 },
+		{ "Stripe AVX2", &GetStripeHash64, STRIPE_HASH_AVX2 },
+		{ "Stripe NEON", &GetStripeHash64, STRIPE_HASH_NEON },
+	};
+	const int rounds = 20;
+
+	for (const HashFunc& f : funcs)
+	{
+		if (!SetStripeHashImpl(f.impl))
+			continue;
+
+		u64 bytes = 0, sum = 0;
+		const u64 start = Common::Timer::GetTimeUs();
+		for (int round = 0; round < rounds; round++)
+		{
+			for (const TextureSize& s : sizes)
+			{
+				u32 offset = 0;
+				for (u32 i = 0; i < s.count; i++)
+				{
+					if (offset + s.size > data.size())
+						offset = 0;
+					sum += f.func(data.data() + offset, s.size, 0);
+					offset += s.size;
+					bytes += s.size;
+				}
+			}
+		}
+		const u64 time = std::max<u64>(Common::Timer::GetTimeUs() - start, 1);
+		printf("%-16s %8llu us, %6.0f MB/s (%016llx)\n", f.name, (unsigned long long)time,
+		       (double)bytes / time, (unsigned long long)sum);
+	}
+	SetStripeHashImpl(STRIPE_HASH_BEST);
+}
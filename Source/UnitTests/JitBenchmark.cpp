@@ -0,0 +1,355 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Boots a game, DOL or ELF (optionally loading a savestate), runs a fixed
+// number of emulated cycles on Jit64 with the frame limiter off and the GPU
+// stubbed out, and reports how many host cycles every block took per
+// emulated cycle, so changes to the code generation can be compared.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "CPUDetect.h"
+#include "FileUtil.h"
+#include "LogManager.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "BootManager.h"
+#include "ConfigManager.h"
+#include "Core.h"
+#include "CoreTiming.h"
+#include "Host.h"
+#include "HW/SystemTimers.h"
+#include "HW/Wiimote.h"
+#include "PowerPC/JitCommon/JitBase.h"
+#include "PowerPC/PowerPC.h"
+#include "PowerPC/PPCSymbolDB.h"
+#include "PowerPC/Profiler.h"
+
+#include "CommandProcessor.h"
+#include "Fifo.h"
+#include "PixelEngine.h"
+#include "VideoBackendBase.h"
+
+// Keeps the state of the emulated GPU so that savestates load, but never
+// executes the FIFO, so that only the CPU is measured. Games waiting on the
+// GPU will spin in their wait loops.
+class NullVideoBackend : public VideoBackendHardware
+{
+	void Shutdown() override {}
+
+	std::string GetName() override { return "Null"; }
+
+	void Video_Prepare() override
+	{
+		CommandProcessor::Init();
+		PixelEngine::Init();
+		Fifo_Init();
+	}
+
+	void Video_Cleanup() override
+	{
+		Fifo_Shutdown();
+	}
+
+	void UpdateFPSDisplay(const char*) override {}
+	unsigned int PeekMessages() override { return 0; }
+
+	void Video_BeginField(u32, u32, u32) override {}
+	void Video_EndField() override {}
+	u32 Video_AccessEFB(EFBAccessType, u32, u32, u32) override { return 0; }
+	u32 Video_GetQueryResult(PerfQueryType) override { return 0; }
+	bool Video_Screenshot(const char*) override { return false; }
+	void Video_GatherPipeBursted() override {}
+};
+
+static NullVideoBackend s_null_backend;
+
+static Common::Event s_done_event;
+static volatile bool s_stopped;
+static u64 s_end_ticks;
+
+void Host_NotifyMapLoaded() {}
+void Host_RefreshDSPDebuggerWindow() {}
+void Host_ShowJitResults(unsigned int address) {}
+
+void Host_Message(int Id)
+{
+	// Boot failures are reported this way
+	if (Id == WM_USER_STOP)
+	{
+		s_stopped = true;
+		s_done_event.Set();
+	}
+}
+
+void* Host_GetRenderHandle() { return NULL; }
+void* Host_GetInstance() { return NULL; }
+void Host_UpdateTitle(const char* title) {}
+void Host_UpdateLogDisplay() {}
+void Host_UpdateDisasmDialog() {}
+void Host_UpdateMainFrame() {}
+void Host_UpdateBreakPointView() {}
+bool Host_GetKeyState(int keycode) { return false; }
+
+void Host_GetRenderWindowSize(int& x, int& y, int& width, int& height)
+{
+	x = y = 0;
+	width = 640;
+	height = 480;
+}
+
+void Host_RequestRenderWindowSize(int width, int height) {}
+
+void Host_SetStartupDebuggingParameters()
+{
+	SCoreStartupParameter& StartUp = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	StartUp.bEnableDebugging = false;
+	StartUp.bBootToPause = false;
+}
+
+bool Host_RendererHasFocus() { return false; }
+void Host_ConnectWiimote(int wm_idx, bool connect) {}
+void Host_SetWaitCursor(bool enable) {}
+void Host_UpdateStatusBar(const char* _pText, int Filed) {}
+void Host_SetWiiMoteConnectionState(int _State) {}
+
+void Host_SysMessage(const char *fmt, ...)
+{
+	va_list list;
+	va_start(list, fmt);
+	vfprintf(stderr, fmt, list);
+	va_end(list);
+	fprintf(stderr, "\n");
+}
+
+// Runs on the CPU thread. Events can only be scheduled INT_MAX cycles ahead,
+// so keep rescheduling until the end is reached.
+static void EndOfRunCallback(u64 userdata, int cyclesLate)
+{
+	const u64 now = CoreTiming::GetTicks();
+	if (now < s_end_ticks)
+	{
+		CoreTiming::ScheduleEvent((int)std::min<u64>(s_end_ticks - now, 0x7FFFFFFF), (int)userdata);
+		return;
+	}
+
+	PowerPC::Pause();
+	s_done_event.Set();
+}
+
+struct BlockResult
+{
+	u32 address;
+	u32 run_count;
+	u64 emulated_cycles;
+	u64 host_ticks;
+
+	bool operator<(const BlockResult& other) const
+	{
+		return host_ticks > other.host_ticks;
+	}
+};
+
+static void ResetBlockProfiles()
+{
+	JitBlockCache* blocks = jit->GetBlockCache();
+	for (int i = 0; i < blocks->GetNumBlocks(); ++i)
+	{
+		JitBlock* block = blocks->GetBlock(i);
+		block->runCount = 0;
+		block->ticCounter = 0;
+	}
+}
+
+static std::vector<BlockResult> GetBlockResults()
+{
+	std::vector<BlockResult> results;
+	JitBlockCache* blocks = jit->GetBlockCache();
+	for (int i = 0; i < blocks->GetNumBlocks(); ++i)
+	{
+		const JitBlock* block = blocks->GetBlock(i);
+		if (block->invalid || block->runCount <= 0)
+			continue;
+
+		BlockResult result;
+		result.address = block->originalAddress;
+		result.run_count = block->runCount;
+		result.emulated_cycles = (u64)block->runCount * block->downcountAmount;
+		result.host_ticks = block->ticCounter;
+		results.push_back(result);
+	}
+	std::sort(results.begin(), results.end());
+	return results;
+}
+
+static bool WriteReport(FILE* out, const std::vector<BlockResult>& results, u64 emulated_cycles, u64 elapsed_us)
+{
+	const u64 ticks_per_second = Profiler::GetTicksPerSecond();
+	const double host_ticks = (double)elapsed_us * ticks_per_second / 1000000.0;
+
+	u64 block_ticks = 0, block_cycles = 0;
+	for (const BlockResult& result : results)
+	{
+		block_ticks += result.host_ticks;
+		block_cycles += result.emulated_cycles;
+	}
+
+	fprintf(out, "# cpu: %s\n", cpu_info.brand_string);
+	fprintf(out, "# emulated cycles: %" PRIu64 "\n", emulated_cycles);
+	fprintf(out, "# host time: %.3f ms, %.2f%% of real time\n", elapsed_us / 1000.0,
+		100.0 * emulated_cycles / SystemTimers::GetTicksPerSecond() / (elapsed_us / 1000000.0));
+	fprintf(out, "# host ticks per emulated cycle: %.3f overall, %.3f in blocks\n",
+		host_ticks / emulated_cycles, block_cycles ? (double)block_ticks / block_cycles : 0.0);
+	fprintf(out, "origAddr\tblkName\trunCount\temuCycles\thostTicks\tticksPerCycle\ttimePercent\n");
+
+	for (const BlockResult& result : results)
+	{
+		const char* name = g_symbolDB.GetDescription(result.address);
+		fprintf(out, "%08x\t%s\t%u\t%" PRIu64 "\t%" PRIu64 "\t%.3f\t%.2f\n",
+			result.address, name, result.run_count, result.emulated_cycles, result.host_ticks,
+			result.emulated_cycles ? (double)result.host_ticks / result.emulated_cycles : 0.0,
+			block_ticks ? 100.0 * result.host_ticks / block_ticks : 0.0);
+	}
+	return !ferror(out);
+}
+
+static int Run(const std::string& filename, const std::string& state, u64 cycles, const std::string& report)
+{
+	if (!Profiler::GetTicksPerSecond())
+	{
+		fprintf(stderr, "Blocks can't be timed on this platform\n");
+		return 1;
+	}
+
+	SConfig& config = SConfig::GetInstance();
+	SCoreStartupParameter& StartUp = config.m_LocalCoreStartupParameter;
+	StartUp.iCPUCore = 1; // Jit64, the only one that times its blocks
+	StartUp.bCPUThread = false;
+	StartUp.bDSPHLE = true;
+	StartUp.bDSPThread = false;
+	StartUp.m_strVideoBackend = "Null";
+	config.sBackend = BACKEND_NULLSOUND;
+	config.m_Framelimit = 0;
+	VideoBackend::ActivateBackend(StartUp.m_strVideoBackend);
+
+	Profiler::g_ProfileBlocks = true;
+	Core::SetStateFileName(state);
+
+	if (!BootManager::BootCore(filename))
+	{
+		fprintf(stderr, "Could not boot %s\n", filename.c_str());
+		return 1;
+	}
+
+	// Wait for the savestate to be loaded
+	while (!Core::IsRunningAndStarted())
+	{
+		if (s_stopped)
+		{
+			Core::Stop();
+			return 1;
+		}
+		Common::SleepCurrentThread(1);
+	}
+
+	Core::PauseAndLock(true);
+	ResetBlockProfiles();
+	const u64 start_ticks = CoreTiming::GetTicks();
+	s_end_ticks = start_ticks + cycles;
+	const int event = CoreTiming::RegisterEvent("JitBenchmarkEnd", EndOfRunCallback);
+	CoreTiming::ScheduleEvent((int)std::min<u64>(cycles, 0x7FFFFFFF), event, event);
+	s_done_event.Reset();
+	const u64 start_us = Common::Timer::GetTimeUs();
+	Core::PauseAndLock(false);
+
+	s_done_event.Wait();
+	const u64 elapsed_us = Common::Timer::GetTimeUs() - start_us;
+	const u64 emulated_cycles = CoreTiming::GetTicks() - start_ticks;
+	const std::vector<BlockResult> results = GetBlockResults();
+
+	Core::Stop();
+
+	if (emulated_cycles < cycles)
+	{
+		fprintf(stderr, "Emulation stopped after %" PRIu64 " cycles\n", emulated_cycles);
+		return 1;
+	}
+
+	if (report.empty())
+		return WriteReport(stdout, results, emulated_cycles, elapsed_us) ? 0 : 1;
+
+	File::IOFile file(report, "w");
+	if (!file || !WriteReport(file.GetHandle(), results, emulated_cycles, elapsed_us))
+	{
+		fprintf(stderr, "Could not write %s\n", report.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string filename, state, report;
+	u64 cycles = 486000000ull * 5;
+	bool help = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		if (!strcmp(arg, "-s") && i + 1 < argc)
+			state = argv[++i];
+		else if (!strcmp(arg, "-c") && i + 1 < argc)
+			cycles = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(arg, "-o") && i + 1 < argc)
+			report = argv[++i];
+		else if (arg[0] == '-' || !filename.empty())
+			help = true;
+		else
+			filename = arg;
+	}
+
+	if (help || filename.empty() || !cycles)
+	{
+		fprintf(stderr, "Usage: %s [-s <savestate>] [-c <cycles>] [-o <report>] <file>\n", argv[0]);
+		fprintf(stderr, "  -s	Load the savestate after booting the file\n");
+		fprintf(stderr, "  -c	Number of emulated cycles to run, five seconds by default\n");
+		fprintf(stderr, "  -o	Write the report to a file instead of stdout\n");
+		return 1;
+	}
+
+	LogManager::Init();
+	SConfig::Init();
+	VideoBackend::PopulateList();
+	g_available_video_backends.push_back(&s_null_backend);
+	WiimoteReal::LoadSettings();
+
+	// Nothing changed for the run is saved
+	SConfig& config = SConfig::GetInstance();
+	const SCoreStartupParameter saved_startup = config.m_LocalCoreStartupParameter;
+	const std::string saved_audio_backend = config.sBackend;
+	const unsigned int saved_framelimit = config.m_Framelimit;
+
+	const int result = Run(filename, state, cycles, report);
+
+	config.m_LocalCoreStartupParameter = saved_startup;
+	config.sBackend = saved_audio_backend;
+	config.m_Framelimit = saved_framelimit;
+
+	WiimoteReal::Shutdown();
+	g_available_video_backends.pop_back();
+	VideoBackend::ClearList();
+	SConfig::Shutdown();
+	LogManager::Shutdown();
+
+	return result;
+}
@@ -16,14 +16,24 @@
 // http://code.google.com/p/dolphin-emu/
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
+#include "BinaryLog.h"
+#include "BreakPoints.h"
 #include "StringUtil.h"
 #include "MathUtil.h"
 #include "PowerPC/PowerPC.h"
 #include "HW/SI_DeviceGCController.h"
 
 void AudioJitTests();
+void AXVoiceTests();
+void ExpressionParserTests();
+void HashTests();
+void HashBenchmark();
+void VideoBenchmark();
+void ZeldaVoiceTests();
+void ZeldaVoiceBenchmark(const char* pb_file);
 
 using namespace std;
 int fail_count = 0;
@@ -129,14 +139,125 @@ void StringTests()
 	EXPECT_EQ(".jpg", ext);
 }
 
+// Formats the arguments the way the log thread does
+static std::string CaptureAndFormat(u32 max_size, const char* format, ...)
+{
+	u8 args[BinaryLog::MAX_ARGS_SIZE];
+	va_list list;
+	va_start(list, format);
+	const u32 size = BinaryLog::CaptureArgs(format, list, args, max_size);
+	va_end(list);
+	return BinaryLog::FormatArgs(format, args, size);
+}
+
+void BinaryLogTests()
+{
+	const u32 max = BinaryLog::MAX_ARGS_SIZE;
+	EXPECT_EQ(CaptureAndFormat(max, "no arguments, 100%%"), "no arguments, 100%");
+	EXPECT_EQ(CaptureAndFormat(max, "%d %u %08x %hhx", -5, 7u, 0xBEEFu, 0x1FF), "-5 7 0000beef ff");
+	EXPECT_EQ(CaptureAndFormat(max, "%lld %llx", -(1LL << 40), 0xFEDCBA9876543210ULL), "-1099511627776 fedcba9876543210");
+	EXPECT_EQ(CaptureAndFormat(max, "%s=%-4s|%.3s", "key", "v", "abcdef"), "key=v   |abc");
+	EXPECT_EQ(CaptureAndFormat(max, "%.*s %*d", 2, "xyz", 4, 9), "xy    9");
+	EXPECT_EQ(CaptureAndFormat(max, "%.2f %c", 2.5, 'q'), "2.50 q");
+
+	// What doesn't fit is cut off, strings first
+	EXPECT_EQ(CaptureAndFormat(8, "%s", "abcdefghij"), "abcdef");
+	EXPECT_EQ(CaptureAndFormat(12, "%d %d", 1, 2), "1 %d");
+}
+
+void BreakPointTests()
+{
+	BreakPoints bps;
+	bps.Add(0x80003100);
+	bps.Add(0x80003104, true);
+	bps.Add(0x80003100, true);
+
+	EXPECT_TRUE(bps.IsAddressBreakPoint(0x80003100));
+	EXPECT_FALSE(bps.IsTempBreakPoint(0x80003100));
+	EXPECT_TRUE(bps.IsTempBreakPoint(0x80003104));
+	EXPECT_FALSE(bps.IsAddressBreakPoint(0x80003108));
+	EXPECT_EQ(bps.GetBreakPoints().size(), 2);
+
+	bps.Remove(0x80003100);
+	EXPECT_FALSE(bps.IsAddressBreakPoint(0x80003100));
+	EXPECT_TRUE(bps.IsAddressBreakPoint(0x80003104));
+	bps.Remove(0x80003100);
+	EXPECT_EQ(bps.GetBreakPoints().size(), 1);
+
+	bps.Clear();
+	EXPECT_FALSE(bps.IsAddressBreakPoint(0x80003104));
+	EXPECT_TRUE(bps.GetBreakPoints().empty());
+}
+
+static TMemCheck MakeMemCheck(u32 start, u32 end)
+{
+	TMemCheck mc;
+	mc.StartAddress = start;
+	mc.EndAddress = end;
+	mc.bRange = start != end;
+	mc.OnWrite = true;
+	return mc;
+}
+
+void MemCheckTests()
+{
+	MemChecks checks;
+	checks.Add(MakeMemCheck(0x80001800, 0x80001900));
+	checks.Add(MakeMemCheck(0x80002000, 0x80002000));
+	checks.Add(MakeMemCheck(0x80000100, 0x80000100));
+	// Overlaps the ones before, a check can't start inside another one
+	checks.Add(MakeMemCheck(0x80001000, 0x80003000));
+	checks.Add(MakeMemCheck(0x80002800, 0x80002900));
+
+	EXPECT_TRUE(checks.GetMemCheck(0x80000100));
+	EXPECT_FALSE(checks.GetMemCheck(0x80000104));
+	EXPECT_FALSE(checks.GetMemCheck(0x80000fff));
+	// The short ranges starting after the long one don't hide it
+	EXPECT_EQ(checks.GetMemCheck(0x80002800)->StartAddress, 0x80001000);
+	EXPECT_EQ(checks.GetMemCheck(0x80002100)->StartAddress, 0x80001000);
+	EXPECT_EQ(checks.GetMemCheck(0x80003000)->StartAddress, 0x80001000);
+	EXPECT_FALSE(checks.GetMemCheck(0x80003001));
+	EXPECT_TRUE(checks.GetMemCheck(0x80001850));
+
+	checks.Remove(0x80001000);
+	EXPECT_FALSE(checks.GetMemCheck(0x80002800));
+	EXPECT_EQ(checks.GetMemCheck(0x80002000)->StartAddress, 0x80002000);
+	EXPECT_EQ(checks.GetMemCheck(0x80001900)->StartAddress, 0x80001800);
+
+	checks.Clear();
+	EXPECT_FALSE(checks.GetMemCheck(0x80000100));
+}
 
 int main(int argc, char* argv[])
 {
+	if (argc >= 2 && !strcmp(argv[1], "--bench-zelda"))
+	{
+		ZeldaVoiceBenchmark(argc >= 3 ? argv[2] : "");
+		return fail_count != 0;
+	}
+	if (argc >= 2 && !strcmp(argv[1], "--bench-hash"))
+	{
+		HashBenchmark();
+		return 0;
+	}
+	if (argc >= 2 && !strcmp(argv[1], "--bench-video"))
+	{
+		VideoBenchmark();
+		return 0;
+	}
+
 	AudioJitTests();
+	AXVoiceTests();
+	ZeldaVoiceTests();
 
 	CoreTests();
+	ExpressionParserTests();
+	HashTests();
 	MathTests();
 	StringTests();
+	BinaryLogTests();
+	BreakPointTests();
+	MemCheckTests();
 	if (fail_count == 0)
 	{
 		printf("All tests passed.\n");
@@ -0,0 +1,134 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Timings of the video code that runs for every texture and draw call, to
+// compare changes against. Run with tester --bench-video.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Common.h"
+#include "Timer.h"
+
+#include "IndexGenerator.h"
+#include "OpcodeDecoding.h"
+#include "TextureDecoder.h"
+#include "VideoConfig.h"
+
+void HashBenchmark();
+
+static u32 s_seed = 0x2468ace0;
+
+static u32 Random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void TextureDecoderBenchmark()
+{
+	struct Format { const char* name; int format; int tlut_format; };
+	static const Format formats[] = {
+		{ "I4", GX_TF_I4, 0 },
+		{ "I8", GX_TF_I8, 0 },
+		{ "IA4", GX_TF_IA4, 0 },
+		{ "IA8", GX_TF_IA8, 0 },
+		{ "RGB565", GX_TF_RGB565, 0 },
+		{ "RGB5A3", GX_TF_RGB5A3, 0 },
+		{ "RGBA8", GX_TF_RGBA8, 0 },
+		{ "C4 IA8", GX_TF_C4, GX_TL_IA8 },
+		{ "C4 RGB565", GX_TF_C4, GX_TL_RGB565 },
+		{ "C4 RGB5A3", GX_TF_C4, GX_TL_RGB5A3 },
+		{ "C8 IA8", GX_TF_C8, GX_TL_IA8 },
+		{ "C8 RGB565", GX_TF_C8, GX_TL_RGB565 },
+		{ "C8 RGB5A3", GX_TF_C8, GX_TL_RGB5A3 },
+		{ "C14X2 RGB5A3", GX_TF_C14X2, GX_TL_RGB5A3 },
+		{ "CMPR", GX_TF_CMPR, 0 },
+	};
+	// A small UI texture and a big one
+	static const int sizes[] = { 64, 512 };
+	const int rounds = 20;
+
+	// The palettes live in TMEM, after the texture data a game would put there
+	const int tlut_address = 0x80000;
+	for (int i = 0; i < 0x10000; ++i)
+		texMem[tlut_address + i] = (u8)Random();
+
+	std::vector<u8> src(1024 * 1024 * 4);
+	for (u8& byte : src)
+		byte = (u8)Random();
+	std::vector<u8> dst(1024 * 1024 * 4);
+
+	for (const Format& f : formats)
+	{
+		for (int size : sizes)
+		{
+			const int bytes = TexDecoder_GetTextureSizeInBytes(size, size, f.format);
+			const int count = std::max((int)src.size() / bytes, 1);
+
+			u64 total = 0;
+			const u64 start = Common::Timer::GetTimeUs();
+			for (int round = 0; round < rounds; ++round)
+			{
+				for (int i = 0; i < count; ++i)
+				{
+					TexDecoder_Decode(dst.data(), src.data() + i * bytes, size, size, f.format, tlut_address, f.tlut_format);
+					total += bytes;
+				}
+			}
+			const u64 time = std::max<u64>(Common::Timer::GetTimeUs() - start, 1);
+			printf("Decode %-12s %4dx%-4d %8llu us, %6.0f MB/s, %6.1f Mtexels/s\n", f.name, size, size,
+			       (unsigned long long)time, (double)total / time,
+			       (double)size * size * count * rounds / time);
+		}
+	}
+}
+
+static void IndexGeneratorBenchmark()
+{
+	struct Primitive { const char* name; int primitive; u32 verts; };
+	static const Primitive primitives[] = {
+		{ "quads", GX_DRAW_QUADS, 4 * 24 },
+		{ "triangles", GX_DRAW_TRIANGLES, 3 * 32 },
+		{ "strips", GX_DRAW_TRIANGLE_STRIP, 34 },
+		{ "fans", GX_DRAW_TRIANGLE_FAN, 34 },
+		{ "lines", GX_DRAW_LINES, 2 * 32 },
+		{ "line strips", GX_DRAW_LINE_STRIP, 33 },
+		{ "points", GX_DRAW_POINTS, 64 },
+	};
+	// About as many draws as fill a backend's index buffer before it flushes
+	const int draws = 256;
+	const int rounds = 2000;
+	std::vector<u16> indices(draws * 4 * 24 * 2);
+
+	for (int restart = 0; restart < 2; ++restart)
+	{
+		g_Config.backend_info.bSupportsPrimitiveRestart = restart != 0;
+		IndexGenerator::Init();
+
+		for (const Primitive& p : primitives)
+		{
+			u64 verts = 0;
+			const u64 start = Common::Timer::GetTimeUs();
+			for (int round = 0; round < rounds; ++round)
+			{
+				IndexGenerator::Start(indices.data());
+				for (int i = 0; i < draws; ++i)
+					IndexGenerator::AddIndices(p.primitive, p.verts);
+				verts += IndexGenerator::GetNumVerts();
+			}
+			const u64 time = std::max<u64>(Common::Timer::GetTimeUs() - start, 1);
+			printf("Indices %-11s %-10s %8llu us, %6.1f Mverts/s\n", p.name, restart ? "restart" : "no restart",
+			       (unsigned long long)time, (double)verts / time);
+		}
+	}
+}
+
+void VideoBenchmark()
+{
+	TextureDecoderBenchmark();
+	IndexGeneratorBenchmark();
+	HashBenchmark();
+}
@@ -0,0 +1,371 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks that the vectorized Zelda ucode kernels give the same results as the
+// sample by sample code they replaced, and benchmarks both on voice PBs.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "FileUtil.h"
+#include "Timer.h"
+
+#include "HW/DSPHLE/UCodes/UCode_Zelda.h"
+
+extern int fail_count;
+
+static u32 s_seed = 0x87654321;
+
+static u32 Random()
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static s16 RandomSample()
+{
+	const u32 r = Random();
+	// Make the extremes likely, that's where rounding goes wrong
+	switch (r & 7)
+	{
+	case 0: return 0x7FFF;
+	case 1: return -0x8000;
+	default: return (s16)(r >> 3);
+	}
+}
+
+static void Check(bool ok, const char* what, u32 param)
+{
+	if (!ok)
+	{
+		printf("FAIL (ZeldaVoiceTests): %s differs from the scalar code (%08x)\n", what, param);
+		fail_count++;
+	}
+}
+
+static void RefAFCdecodebuffer(const s16* coef, const char* src, s16* out, short* histp, short* hist2p, int type)
+{
+	short delta = 1 << (((*src) >> 4) & 0xf);
+	short idx = (*src) & 0xf;
+	src++;
+
+	short nibbles[16];
+	for (int i = 0; i < 16; i++)
+	{
+		if (type == 9)
+		{
+			nibbles[i] = (i & 1) ? (*src & 15) : (*src >> 4);
+			if (nibbles[i] >= 8)
+				nibbles[i] -= 16;
+			nibbles[i] <<= 11;
+			src += i & 1;
+		}
+		else
+		{
+			nibbles[i] = (*src >> (6 - (i & 3) * 2)) & 3;
+			if (nibbles[i] >= 2)
+				nibbles[i] -= 4;
+			nibbles[i] <<= 13;
+			src += (i & 3) == 3;
+		}
+	}
+
+	short hist = *histp;
+	short hist2 = *hist2p;
+	for (int i = 0; i < 16; i++)
+	{
+		int sample = delta * nibbles[i] + ((int)hist * coef[idx * 2]) + ((int)hist2 * coef[idx * 2 + 1]);
+		sample >>= 11;
+		sample = std::min(std::max(sample, -32768), 32767);
+		out[i] = sample;
+		hist2 = hist;
+		hist = (short)sample;
+	}
+	*histp = hist;
+	*hist2p = hist2;
+}
+
+static int RefResampleLinear(const s16* in, s32* out, int size, int position, int ratio)
+{
+	for (int i = 0; i < size; i++)
+	{
+		int int_pos = (position >> 16);
+		int frac = ((position & 0xFFFF) >> 1);
+		out[i] = (in[int_pos - 3] * (frac ^ 0x7FFF) + in[int_pos - 2] * frac) >> 15;
+		position += ratio;
+	}
+	return position;
+}
+
+// Volume mode 0, 0ca9_RampedMultiplyAddBuffer
+static u32 RefMixAddRamped(s32* out, const s32* in, int size, u32 ramp, int delta)
+{
+	for (int i = 0; i < size; i++)
+	{
+		out[i] += (u64)in[i] * ramp >> 29;
+		if (((i & 1) == 0) && i < 64)
+			ramp += delta;
+	}
+	return ramp;
+}
+
+// The complex volume mode, with a signed ramp
+static void RefMixAddVolume(s32* out, const s32* in, int size, int ramp)
+{
+	for (int i = 0; i < size; i++)
+		out[i] += (u64)in[i] * ramp >> 29;
+}
+
+static void RefMixToOutput(short* buffer, const s32* left, const s32* right, int size)
+{
+	for (int i = 0; i < size; i++)
+	{
+		s32 l = (s32)buffer[0] + left[i];
+		s32 r = (s32)buffer[1] + right[i];
+		buffer[0] = (short)std::min(std::max(l, -32768), 32767);
+		buffer[1] = (short)std::min(std::max(r, -32768), 32767);
+		buffer += 2;
+	}
+}
+
+static const int MAX_SIZE = 0x200;
+
+static void AFCTests()
+{
+	s16 coefs[32];
+	for (s16& coef : coefs)
+		coef = RandomSample();
+
+	for (int type : { 9, 5 })
+	{
+		short hist = 0, hist2 = 0, ref_hist = 0, ref_hist2 = 0;
+		for (int block = 0; block < 4096; block++)
+		{
+			char data[9];
+			for (char& byte : data)
+				byte = (char)Random();
+
+			s16 out[16], ref_out[16];
+			CUCode_Zelda::AFCdecodebuffer(coefs, data, out, &hist, &hist2, type);
+			RefAFCdecodebuffer(coefs, data, ref_out, &ref_hist, &ref_hist2, type);
+			Check(!memcmp(out, ref_out, sizeof(out)) && hist == ref_hist && hist2 == ref_hist2, "AFC block", block);
+		}
+	}
+}
+
+static void ResampleTests()
+{
+	static const int ratios[] = { 0x10000, 0x8000, 0x12345, 0x55555, 0x40000, 0x0001, 0xFFFF, 0x2F1A3 };
+	static const int sizes[] = { 80, 33, 6, 3 };
+
+	for (int size : sizes)
+	for (int ratio : ratios)
+	for (int start = 0; start < 0x10000; start += 0x3F01)
+	{
+		s16 input[MAX_SIZE * 6];
+		for (s16& sample : input)
+			sample = RandomSample();
+
+		s32 out[MAX_SIZE], ref_out[MAX_SIZE];
+		const int pos = CUCode_Zelda::ResampleLinear(input + 4, out, size, start, ratio);
+		const int ref_pos = RefResampleLinear(input + 4, ref_out, size, start, ratio);
+
+		Check(!memcmp(out, ref_out, size * sizeof(s32)), "resampled output", ratio);
+		Check(pos == ref_pos, "resampler position", ratio);
+	}
+}
+
+static void MixTests()
+{
+	static const u32 ramps[] = { 0x00000000, 0x00010000, 0x7FFF0000, 0x80000000, 0xFFFF0000, 0xFFFFFFFF, 0x12345678 };
+	static const int deltas[] = { 0, 1 << 11, -(1 << 11), 0x7FFF << 11, -0x8000 << 11, 0x1234567 };
+	static const int sizes[] = { 80, 64, 66, 31, 3 };
+
+	for (int size : sizes)
+	for (u32 ramp : ramps)
+	{
+		s32 input[MAX_SIZE];
+		for (int i = 0; i < size; i++)
+		{
+			// Synthesized voices go up to 0xFFFF
+			input[i] = (Random() & 15) ? RandomSample() : (s32)(Random() & 0x1FFFF) - 0x10000;
+		}
+
+		for (int delta : deltas)
+		{
+			s32 out[MAX_SIZE], ref_out[MAX_SIZE];
+			for (int i = 0; i < size; i++)
+				out[i] = ref_out[i] = RandomSample() * 4;
+
+			const u32 end = CUCode_Zelda::MixAddRamped(out, input, size, ramp, delta);
+			const u32 ref_end = RefMixAddRamped(ref_out, input, size, ramp, delta);
+			Check(!memcmp(out, ref_out, size * sizeof(s32)), "ramped mix", ramp ^ delta);
+			Check(end == ref_end, "ramp", ramp ^ delta);
+		}
+
+		s32 out[MAX_SIZE], ref_out[MAX_SIZE];
+		for (int i = 0; i < size; i++)
+			out[i] = ref_out[i] = RandomSample() * 4;
+		CUCode_Zelda::MixAddRamped(out, input, size, (s32)ramp, 0);
+		RefMixAddVolume(ref_out, input, size, (s32)ramp);
+		Check(!memcmp(out, ref_out, size * sizeof(s32)), "signed volume mix", ramp);
+
+		short buffer[MAX_SIZE * 2], ref_buffer[MAX_SIZE * 2];
+		for (int i = 0; i < size * 2; i++)
+			buffer[i] = ref_buffer[i] = RandomSample();
+		CUCode_Zelda::MixToOutput(buffer, out, input, size);
+		RefMixToOutput(ref_buffer, out, input, size);
+		Check(!memcmp(buffer, ref_buffer, size * 2 * sizeof(short)), "output conversion", ramp);
+	}
+}
+
+// Voice settings for the benchmark, taken from a file of PBs as they are in
+// RAM (0x180 bytes each, big endian) or made up if there is none
+struct BenchVoice
+{
+	u16 format;
+	u16 ratio;
+	u16 volume_mode;
+	u16 volumes[2][2];
+};
+
+static std::vector<BenchVoice> LoadVoices(const char* pb_file)
+{
+	std::vector<BenchVoice> voices;
+
+	File::IOFile file(pb_file, "rb");
+	u16 raw[0xc0];
+	while (file && file.ReadArray(raw, 0xc0))
+	{
+		ZeldaVoicePB pb;
+		for (int i = 0; i < 0xc0; i++)
+			pb.raw[i] = Common::swap16(raw[i]);
+		if (pb.Status == 0 || pb.KeyOff != 0)
+			continue;
+
+		BenchVoice voice = { pb.Format, pb.RatioInt, pb.VolumeMode,
+		                     { { pb.volumeLeft1, pb.volumeLeft2 }, { pb.volumeRight1, pb.volumeRight2 } } };
+		voices.push_back(voice);
+	}
+
+	if (voices.empty())
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			BenchVoice voice = { (u16)((i & 3) ? 9 : 5), (u16)(0x0800 + (Random() & 0x1FFF)), (u16)(i & 1),
+			                     { { (u16)Random(), (u16)Random() }, { (u16)Random(), (u16)Random() } } };
+			voices.push_back(voice);
+		}
+	}
+
+	return voices;
+}
+
+template <bool reference>
+static void RenderVoices(const std::vector<BenchVoice>& voices, const u8* afc_data, const s16* coefs,
+                         s32* left, s32* right, short* output, int size)
+{
+	s16 decoded[MAX_SIZE * 4 + 16 + 4] = {};
+	s32 voice[MAX_SIZE];
+
+	memset(left, 0, size * sizeof(s32));
+	memset(right, 0, size * sizeof(s32));
+
+	u32 addr = 0;
+	for (const BenchVoice& v : voices)
+	{
+		// At 32 kHz, like ConvertRatio()
+		const int ratio = v.ratio << 4;
+		const int in_size = ((size * ratio) >> 16) + 1;
+
+		short hist = 0, hist2 = 0;
+		for (int i = 0; i < in_size; i += 16)
+		{
+			const char* block = (const char*)&afc_data[addr & 0xFFFF];
+			if (reference)
+				RefAFCdecodebuffer(coefs, block, &decoded[4 + i], &hist, &hist2, v.format);
+			else
+				CUCode_Zelda::AFCdecodebuffer(coefs, block, &decoded[4 + i], &hist, &hist2, v.format);
+			addr += v.format;
+		}
+
+		if (reference)
+			RefResampleLinear(decoded + 4, voice, size, 0, ratio);
+		else
+			CUCode_Zelda::ResampleLinear(decoded + 4, voice, size, 0, ratio);
+
+		for (int c = 0; c < 2; c++)
+		{
+			s32* dst = c ? right : left;
+			const u16 vol1 = v.volumes[c][0];
+			const int delta = (v.volumes[c][1] - vol1) << 11;
+			if (v.volume_mode)
+			{
+				if (reference)
+					RefMixAddVolume(dst, voice, size, (s16)vol1 << 16);
+				else
+					CUCode_Zelda::MixAddRamped(dst, voice, size, (s32)((s16)vol1 << 16), 0);
+			}
+			else
+			{
+				if (reference)
+					RefMixAddRamped(dst, voice, size, vol1 << 16, delta);
+				else
+					CUCode_Zelda::MixAddRamped(dst, voice, size, (u32)(vol1 << 16), delta);
+			}
+		}
+	}
+
+	if (reference)
+		RefMixToOutput(output, left, right, size);
+	else
+		CUCode_Zelda::MixToOutput(output, left, right, size);
+}
+
+// Run with --bench-zelda [PB dump]
+void ZeldaVoiceBenchmark(const char* pb_file)
+{
+	const std::vector<BenchVoice> voices = LoadVoices(pb_file);
+
+	std::vector<u8> afc_data(0x10000 + 16);
+	for (u8& byte : afc_data)
+		byte = (u8)Random();
+	s16 coefs[32];
+	for (s16& coef : coefs)
+		coef = (s16)((Random() & 0xFFF) - 0x400);
+
+	// One 5 ms frame at 32 kHz
+	const int size = 160;
+	s32 left[MAX_SIZE], right[MAX_SIZE];
+	short output[2][MAX_SIZE * 2] = {};
+	const int frames = 2000;
+
+	u64 times[2];
+	for (int reference = 1; reference >= 0; reference--)
+	{
+		const u64 start = Common::Timer::GetTimeUs();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			memset(output[reference], 0, sizeof(output[reference]));
+			if (reference)
+				RenderVoices<true>(voices, afc_data.data(), coefs, left, right, output[1], size);
+			else
+				RenderVoices<false>(voices, afc_data.data(), coefs, left, right, output[0], size);
+		}
+		times[reference] = Common::Timer::GetTimeUs() - start;
+	}
+
+	Check(!memcmp(output[0], output[1], sizeof(output[0])), "benchmark mix", 0);
+	printf("Zelda voices: %u voices, %d frames: scalar %llu us, vectorized %llu us\n",
+	       (u32)voices.size(), frames, (unsigned long long)times[1], (unsigned long long)times[0]);
+}
+
+void ZeldaVoiceTests()
+{
+	AFCTests();
+	ResampleTests();
+	MixTests();
+}